@@ -0,0 +1,203 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * mmcli -- Control modem status & access information from the command line
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+/*
+ * Batch operations: when the modem is given as "all" or as a comma-separated
+ * list, the action is run on every matching modem at the same time, all of
+ * them found through a single manager.
+ *
+ * Each modem gets one JSON object per line, printed as soon as its action
+ * finishes:
+ *   {"modem":"/org/freedesktop/ModemManager1/Modem/0","result":"ok"}
+ *   {"modem":"/org/freedesktop/ModemManager1/Modem/1","result":"ok","output":"..."}
+ *   {"modem":"7","result":"error","error":"..."}
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#define _LIBMM_INSIDE_MMCLI
+#include <libmm-glib.h>
+
+#include "mmcli.h"
+#include "mmcli-common.h"
+
+/* Context */
+typedef struct {
+    GCancellable *cancellable;
+    MMManager *manager;
+    gboolean simple;
+    guint n_pending;
+    guint n_failed;
+} Context;
+static Context *ctx;
+
+gboolean
+mmcli_batch_options_enabled (void)
+{
+    return mmcli_is_multiple_modem_string (mmcli_get_common_modem_string ());
+}
+
+static void
+context_free (Context *ctx)
+{
+    if (!ctx)
+        return;
+
+    if (ctx->cancellable)
+        g_object_unref (ctx->cancellable);
+    if (ctx->manager)
+        g_object_unref (ctx->manager);
+    g_free (ctx);
+}
+
+gboolean
+mmcli_batch_shutdown (void)
+{
+    gboolean success;
+
+    success = (ctx && !ctx->n_failed);
+    context_free (ctx);
+    ctx = NULL;
+    return success;
+}
+
+static void
+print_result (const gchar  *modem,
+              const gchar  *output,
+              const GError *error)
+{
+    GString *str;
+
+    str = g_string_new ("{\"modem\":");
+    mmcli_append_json_string (str, modem);
+    if (error) {
+        g_string_append (str, ",\"result\":\"error\",\"error\":");
+        mmcli_append_json_string (str, error->message);
+    } else {
+        g_string_append (str, ",\"result\":\"ok\"");
+        if (output) {
+            g_string_append (str, ",\"output\":");
+            mmcli_append_json_string (str, output);
+        }
+    }
+    g_string_append (str, "}\n");
+
+    /* Results of different modems are never interleaved */
+    fputs (str->str, stdout);
+    fflush (stdout);
+    g_string_free (str, TRUE);
+}
+
+static void
+batch_ready (MMObject     *object,
+             GAsyncResult *res)
+{
+    GError *error = NULL;
+    gchar *output = NULL;
+    gboolean success;
+
+    if (ctx->simple)
+        success = mmcli_modem_simple_batch_finish (res, &output, &error);
+    else
+        success = mmcli_modem_batch_finish (res, &output, &error);
+
+    print_result (mm_object_get_path (object), output, error);
+    if (!success) {
+        ctx->n_failed++;
+        g_error_free (error);
+    }
+    g_free (output);
+
+    g_assert (ctx->n_pending > 0);
+    if (--ctx->n_pending == 0)
+        mmcli_async_operation_done ();
+}
+
+static void
+get_manager_ready (GDBusConnection *connection,
+                   GAsyncResult    *res)
+{
+    GList *modems;
+    GList *l;
+    gchar **missing = NULL;
+    guint i;
+
+    ctx->manager = mmcli_get_manager_finish (res);
+    modems = mmcli_find_modems (ctx->manager, mmcli_get_common_modem_string (), &missing);
+
+    for (i = 0; missing[i]; i++) {
+        GError *error;
+
+        error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_NOT_FOUND, "couldn't find modem");
+        print_result (missing[i], NULL, error);
+        g_error_free (error);
+        ctx->n_failed++;
+    }
+    g_strfreev (missing);
+
+    if (!modems) {
+        mmcli_async_operation_done ();
+        return;
+    }
+
+    /* Account all modems before any of them may complete */
+    ctx->n_pending = g_list_length (modems);
+    for (l = modems; l; l = g_list_next (l)) {
+        if (ctx->simple)
+            mmcli_modem_simple_batch_run (MM_OBJECT (l->data),
+                                          ctx->cancellable,
+                                          (GAsyncReadyCallback)batch_ready,
+                                          NULL);
+        else
+            mmcli_modem_batch_run (MM_OBJECT (l->data),
+                                   ctx->cancellable,
+                                   (GAsyncReadyCallback)batch_ready,
+                                   NULL);
+    }
+    g_list_free_full (modems, (GDestroyNotify) g_object_unref);
+}
+
+void
+mmcli_batch_run_asynchronous (GDBusConnection *connection,
+                              GCancellable    *cancellable)
+{
+    /* Initialize context */
+    ctx = g_new0 (Context, 1);
+    if (cancellable)
+        ctx->cancellable = g_object_ref (cancellable);
+    ctx->simple = mmcli_modem_simple_options_enabled ();
+
+    if (ctx->simple ? !mmcli_modem_simple_batch_supported () : !mmcli_modem_batch_supported ()) {
+        g_printerr ("error: action not supported on several modems at once\n");
+        exit (EXIT_FAILURE);
+    }
+
+    mmcli_get_manager (connection,
+                       cancellable,
+                       (GAsyncReadyCallback)get_manager_ready,
+                       NULL);
+}
@@ -20,6 +20,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #define _LIBMM_INSIDE_MMCLI
 #include <libmm-glib.h>
@@ -113,9 +114,9 @@ mmcli_get_manager_sync (GDBusConnection *connection)
 }
 
 static MMObject *
-find_modem (MMManager *manager,
-            const gchar *modem_path,
-            const gchar *modem_uid)
+lookup_modem (MMManager *manager,
+              const gchar *modem_path,
+              const gchar *modem_uid)
 {
     GList *modems;
     GList *l;
@@ -144,6 +145,17 @@ find_modem (MMManager *manager,
     }
     g_list_free_full (modems, (GDestroyNotify) g_object_unref);
 
+    return found;
+}
+
+static MMObject *
+find_modem (MMManager *manager,
+            const gchar *modem_path,
+            const gchar *modem_uid)
+{
+    MMObject *found;
+
+    found = lookup_modem (manager, modem_path, modem_uid);
     if (!found) {
         if (modem_path)
             g_printerr ("error: couldn't find modem at '%s'\n", modem_path);
@@ -318,6 +330,64 @@ mmcli_get_modem_sync (GDBusConnection *connection,
     return found;
 }
 
+gboolean
+mmcli_is_multiple_modem_string (const gchar *modem_str)
+{
+    return (modem_str &&
+            (g_str_equal (modem_str, "all") || strchr (modem_str, ',')));
+}
+
+GList *
+mmcli_find_modems (MMManager    *manager,
+                   const gchar  *modem_str,
+                   gchar      ***o_missing)
+{
+    GPtrArray *missing;
+    GList *found = NULL;
+    gchar **selectors;
+    guint i;
+
+    missing = g_ptr_array_new ();
+
+    if (g_str_equal (modem_str, "all")) {
+        found = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+        goto out;
+    }
+
+    selectors = g_strsplit (modem_str, ",", -1);
+    for (i = 0; selectors[i]; i++) {
+        MMObject *object;
+        gchar *modem_path = NULL;
+        gchar *modem_uid = NULL;
+
+        g_strstrip (selectors[i]);
+        if (!selectors[i][0])
+            continue;
+
+        get_modem_path_or_uid (selectors[i], &modem_path, &modem_uid);
+        object = lookup_modem (manager, modem_path, modem_uid);
+        if (!object)
+            g_ptr_array_add (missing, g_strdup (selectors[i]));
+        else if (g_list_find (found, object))
+            /* Same modem given more than once */
+            g_object_unref (object);
+        else
+            found = g_list_append (found, object);
+
+        g_free (modem_path);
+        g_free (modem_uid);
+    }
+    g_strfreev (selectors);
+
+out:
+    g_ptr_array_add (missing, NULL);
+    if (o_missing)
+        *o_missing = (gchar **) g_ptr_array_free (missing, FALSE);
+    else
+        g_strfreev ((gchar **) g_ptr_array_free (missing, FALSE));
+    return found;
+}
+
 typedef struct {
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
@@ -1393,8 +1463,8 @@ static gchar *call_str;
 
 static GOptionEntry entries[] = {
     { "modem", 'm', 0, G_OPTION_ARG_STRING, &modem_str,
-      "Specify modem by path or index. Shows modem information if no action specified.",
-      "[PATH|INDEX]"
+      "Specify modem by path or index, or several as 'all' or a comma-separated list. Shows modem information if no action specified.",
+      "[PATH|INDEX|all|LIST]"
     },
     { "bearer", 'b', 0, G_OPTION_ARG_STRING, &bearer_str,
       "Specify bearer by path or index. Shows bearer information if no action specified.",
@@ -1502,3 +1572,159 @@ mmcli_prefix_newlines (const gchar *prefix,
             g_string_free (prefixed_string, FALSE) :
             g_strdup (str));
 }
+
+/*****************************************************************************/
+/* JSON output */
+
+static void
+append_json_string (GString     *str,
+                    const gchar *value)
+{
+    const gchar *p;
+
+    g_string_append_c (str, '"');
+    for (p = value; *p; p++) {
+        switch (*p) {
+        case '"':
+            g_string_append (str, "\\\"");
+            break;
+        case '\\':
+            g_string_append (str, "\\\\");
+            break;
+        case '\n':
+            g_string_append (str, "\\n");
+            break;
+        case '\r':
+            g_string_append (str, "\\r");
+            break;
+        case '\t':
+            g_string_append (str, "\\t");
+            break;
+        default:
+            if ((guchar) *p < 0x20)
+                g_string_append_printf (str, "\\u%04x", (guint) *p);
+            else
+                g_string_append_c (str, *p);
+            break;
+        }
+    }
+    g_string_append_c (str, '"');
+}
+
+void
+mmcli_append_json_string (GString     *str,
+                          const gchar *value)
+{
+    append_json_string (str, value ? value : "");
+}
+
+void
+mmcli_append_json_variant (GString  *str,
+                           GVariant *value)
+{
+    GVariantIter iter;
+    GVariant *child;
+    gboolean first = TRUE;
+
+    switch (g_variant_classify (value)) {
+    case G_VARIANT_CLASS_BOOLEAN:
+        g_string_append (str, g_variant_get_boolean (value) ? "true" : "false");
+        return;
+    case G_VARIANT_CLASS_BYTE:
+        g_string_append_printf (str, "%u", (guint) g_variant_get_byte (value));
+        return;
+    case G_VARIANT_CLASS_INT16:
+        g_string_append_printf (str, "%d", (gint) g_variant_get_int16 (value));
+        return;
+    case G_VARIANT_CLASS_UINT16:
+        g_string_append_printf (str, "%u", (guint) g_variant_get_uint16 (value));
+        return;
+    case G_VARIANT_CLASS_INT32:
+        g_string_append_printf (str, "%d", g_variant_get_int32 (value));
+        return;
+    case G_VARIANT_CLASS_UINT32:
+        g_string_append_printf (str, "%u", g_variant_get_uint32 (value));
+        return;
+    case G_VARIANT_CLASS_INT64:
+        g_string_append_printf (str, "%" G_GINT64_FORMAT, g_variant_get_int64 (value));
+        return;
+    case G_VARIANT_CLASS_UINT64:
+        g_string_append_printf (str, "%" G_GUINT64_FORMAT, g_variant_get_uint64 (value));
+        return;
+    case G_VARIANT_CLASS_HANDLE:
+        g_string_append_printf (str, "%d", g_variant_get_handle (value));
+        return;
+    case G_VARIANT_CLASS_DOUBLE: {
+        gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+        gdouble d;
+
+        /* NaN and infinite values aren't valid JSON */
+        d = g_variant_get_double (value);
+        if (isnan (d) || isinf (d))
+            g_string_append (str, "null");
+        else
+            g_string_append (str, g_ascii_dtostr (buffer, sizeof (buffer), d));
+        return;
+    }
+    case G_VARIANT_CLASS_STRING:
+    case G_VARIANT_CLASS_OBJECT_PATH:
+    case G_VARIANT_CLASS_SIGNATURE:
+        append_json_string (str, g_variant_get_string (value, NULL));
+        return;
+    case G_VARIANT_CLASS_VARIANT:
+        child = g_variant_get_variant (value);
+        mmcli_append_json_variant (str, child);
+        g_variant_unref (child);
+        return;
+    case G_VARIANT_CLASS_MAYBE:
+        child = g_variant_get_maybe (value);
+        if (child) {
+            mmcli_append_json_variant (str, child);
+            g_variant_unref (child);
+        } else
+            g_string_append (str, "null");
+        return;
+    case G_VARIANT_CLASS_ARRAY:
+        /* Dictionaries with string keys are given as objects */
+        if (g_variant_type_is_dict_entry (g_variant_type_element (g_variant_get_type (value))) &&
+            g_variant_type_is_subtype_of (g_variant_type_key (g_variant_type_element (g_variant_get_type (value))),
+                                          G_VARIANT_TYPE_STRING)) {
+            g_string_append_c (str, '{');
+            g_variant_iter_init (&iter, value);
+            while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+                GVariant *key;
+                GVariant *item;
+
+                key = g_variant_get_child_value (child, 0);
+                item = g_variant_get_child_value (child, 1);
+                if (!first)
+                    g_string_append_c (str, ',');
+                append_json_string (str, g_variant_get_string (key, NULL));
+                g_string_append_c (str, ':');
+                mmcli_append_json_variant (str, item);
+                g_variant_unref (item);
+                g_variant_unref (key);
+                g_variant_unref (child);
+                first = FALSE;
+            }
+            g_string_append_c (str, '}');
+            return;
+        }
+        /* Fall through, as any other container */
+    case G_VARIANT_CLASS_TUPLE:
+    case G_VARIANT_CLASS_DICT_ENTRY:
+        g_string_append_c (str, '[');
+        g_variant_iter_init (&iter, value);
+        while ((child = g_variant_iter_next_value (&iter)) != NULL) {
+            if (!first)
+                g_string_append_c (str, ',');
+            mmcli_append_json_variant (str, child);
+            g_variant_unref (child);
+            first = FALSE;
+        }
+        g_string_append_c (str, ']');
+        return;
+    }
+
+    g_assert_not_reached ();
+}
@@ -45,6 +45,14 @@ MMObject *mmcli_get_modem_sync   (GDBusConnection *connection,
                                   const gchar *modem_str,
                                   MMManager **o_manager);
 
+/* Several modems may be given as "all" or as a comma-separated list of
+ * paths, indices or uids; selectors not matching any modem are returned in
+ * 'o_missing' */
+gboolean  mmcli_is_multiple_modem_string (const gchar *modem_str);
+GList    *mmcli_find_modems              (MMManager    *manager,
+                                          const gchar  *modem_str,
+                                          gchar      ***o_missing);
+
 void      mmcli_get_bearer        (GDBusConnection *connection,
                                    const gchar *path_or_index,
                                    GCancellable *cancellable,
@@ -110,4 +118,11 @@ const gchar  *mmcli_get_common_call_string (void);
 gchar *mmcli_prefix_newlines (const gchar *prefix,
                               const gchar *str);
 
+/* Append a value in JSON format; dictionaries with string keys are
+ * given as JSON objects, any other container as JSON arrays */
+void mmcli_append_json_string  (GString     *str,
+                                const gchar *value);
+void mmcli_append_json_variant (GString     *str,
+                                GVariant    *value);
+
 #endif /* _MMCLI_COMMON_H_ */
@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <locale.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <glib.h>
 #include <gio/gio.h>
@@ -52,9 +53,20 @@ static Context *ctx;
 /* Options */
 static gboolean list_modems_flag;
 static gboolean monitor_modems_flag;
+static gboolean monitor_flag;
 static gboolean scan_modems_flag;
 static gchar *set_logging_str;
+static gboolean port_stats_flag;
+static gboolean loop_stats_flag;
+static gboolean profile_flag;
+static gchar *profile_trace_str;
+static gboolean telemetry_flag;
+static gboolean metrics_flag;
+static gboolean census_flag;
+static gchar *capture_traffic_str;
+static gboolean capture_traffic_stop_flag;
 static gchar *report_kernel_event_str;
+static gboolean report_kernel_events_stdin_flag;
 
 #if WITH_UDEV
 static gboolean report_kernel_event_auto_scan;
@@ -65,6 +77,42 @@ static GOptionEntry entries[] = {
       "Set logging level in the ModemManager daemon",
       "[ERR,WARN,INFO,DEBUG]",
     },
+    { "port-stats", 0, 0, G_OPTION_ARG_NONE, &port_stats_flag,
+      "Show command statistics of the serial ports in the ModemManager daemon",
+      NULL
+    },
+    { "loop-stats", 0, 0, G_OPTION_ARG_NONE, &loop_stats_flag,
+      "Show main loop statistics of the ModemManager daemon",
+      NULL
+    },
+    { "profile", 0, 0, G_OPTION_ARG_NONE, &profile_flag,
+      "Show the timeline of probing, initialization and enabling steps in the ModemManager daemon",
+      NULL
+    },
+    { "profile-trace", 0, 0, G_OPTION_ARG_FILENAME, &profile_trace_str,
+      "Write the timeline of probing, initialization and enabling steps as a Chrome trace file",
+      "[PATH]"
+    },
+    { "telemetry", 0, 0, G_OPTION_ARG_NONE, &telemetry_flag,
+      "Show a snapshot of the status of all modems",
+      NULL
+    },
+    { "census", 0, 0, G_OPTION_ARG_NONE, &census_flag,
+      "Show the objects and buffers held by each modem in the ModemManager daemon",
+      NULL
+    },
+    { "metrics", 0, 0, G_OPTION_ARG_NONE, &metrics_flag,
+      "Show metrics of the ModemManager daemon internals, in the OpenMetrics text format",
+      NULL
+    },
+    { "capture-traffic", 0, 0, G_OPTION_ARG_FILENAME, &capture_traffic_str,
+      "Capture the control traffic of all ports in a pcapng file written by the ModemManager daemon",
+      "[PATH]"
+    },
+    { "capture-traffic-stop", 0, 0, G_OPTION_ARG_NONE, &capture_traffic_stop_flag,
+      "Stop capturing the control traffic of all ports",
+      NULL
+    },
     { "list-modems", 'L', 0, G_OPTION_ARG_NONE, &list_modems_flag,
       "List available modems",
       NULL
@@ -73,6 +121,10 @@ static GOptionEntry entries[] = {
       "List available modems and monitor additions and removals",
       NULL
     },
+    { "monitor", 0, 0, G_OPTION_ARG_NONE, &monitor_flag,
+      "Monitor all modems, printing one JSON object per line for every change",
+      NULL
+    },
     { "scan-modems", 'S', 0, G_OPTION_ARG_NONE, &scan_modems_flag,
       "Request to re-scan looking for modems",
       NULL
@@ -81,6 +133,10 @@ static GOptionEntry entries[] = {
       "Report kernel event",
       "[\"key=value,...\"]"
     },
+    { "report-kernel-events-stdin", 0, 0, G_OPTION_ARG_NONE, &report_kernel_events_stdin_flag,
+      "Report the kernel events read from stdin, one \"key=value,...\" per line, at once",
+      NULL
+    },
 #if WITH_UDEV
     { "report-kernel-event-auto-scan", 0, 0, G_OPTION_ARG_NONE, &report_kernel_event_auto_scan,
       "Automatically report kernel events based on udev notifications",
@@ -117,9 +173,20 @@ mmcli_manager_options_enabled (void)
 
     n_actions = (list_modems_flag +
                  monitor_modems_flag +
+                 monitor_flag +
                  scan_modems_flag +
                  !!set_logging_str +
-                 !!report_kernel_event_str);
+                 port_stats_flag +
+                 loop_stats_flag +
+                 profile_flag +
+                 !!profile_trace_str +
+                 telemetry_flag +
+                 metrics_flag +
+                 census_flag +
+                 !!capture_traffic_str +
+                 capture_traffic_stop_flag +
+                 !!report_kernel_event_str +
+                 report_kernel_events_stdin_flag);
 
 #if WITH_UDEV
     n_actions += report_kernel_event_auto_scan;
@@ -130,7 +197,7 @@ mmcli_manager_options_enabled (void)
         exit (EXIT_FAILURE);
     }
 
-    if (monitor_modems_flag)
+    if (monitor_modems_flag || monitor_flag)
         mmcli_force_async_operation ();
 
 #if WITH_UDEV
@@ -192,6 +259,73 @@ report_kernel_event_ready (MMManager    *manager,
     mmcli_async_operation_done ();
 }
 
+static void
+report_kernel_events_process_reply (gboolean      result,
+                                    const GError *error,
+                                    guint         n_events)
+{
+    if (!result) {
+        g_printerr ("error: couldn't report kernel events: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_print ("successfully reported %u kernel events\n", n_events);
+}
+
+static void
+report_kernel_events_ready (MMManager    *manager,
+                            GAsyncResult *result,
+                            gpointer      n_events)
+{
+    gboolean operation_result;
+    GError *error = NULL;
+
+    operation_result = mm_manager_report_kernel_events_finish (manager, result, &error);
+    report_kernel_events_process_reply (operation_result, error, GPOINTER_TO_UINT (n_events));
+
+    mmcli_async_operation_done ();
+}
+
+/* Empty lines and lines starting with '#' are skipped */
+static GList *
+build_kernel_events_from_stdin (void)
+{
+    GIOChannel *channel;
+    GList *list = NULL;
+    gchar *line = NULL;
+    guint n_line = 0;
+    GError *error = NULL;
+
+    channel = g_io_channel_unix_new (STDIN_FILENO);
+    while (g_io_channel_read_line (channel, &line, NULL, NULL, &error) == G_IO_STATUS_NORMAL) {
+        MMKernelEventProperties *properties;
+
+        n_line++;
+        g_strstrip (line);
+        if (line[0] == '\0' || line[0] == '#') {
+            g_free (line);
+            continue;
+        }
+
+        properties = mm_kernel_event_properties_new_from_string (line, &error);
+        if (!properties) {
+            g_printerr ("error: cannot parse properties string at line %u: '%s'\n", n_line, error->message);
+            exit (EXIT_FAILURE);
+        }
+        list = g_list_prepend (list, properties);
+        g_free (line);
+    }
+    g_io_channel_unref (channel);
+
+    if (error) {
+        g_printerr ("error: couldn't read kernel events: '%s'\n", error->message);
+        exit (EXIT_FAILURE);
+    }
+
+    return g_list_reverse (list);
+}
+
 static MMKernelEventProperties *
 build_kernel_event_properties_from_input (const gchar *properties_string)
 {
@@ -236,6 +370,636 @@ set_logging_ready (MMManager    *manager,
     mmcli_async_operation_done ();
 }
 
+static void
+print_port_stats_histogram (const gchar *name,
+                            GVariant    *limits,
+                            GVariant    *histogram)
+{
+    const guint32 *limits_array;
+    const guint32 *histogram_array;
+    gsize n_limits = 0;
+    gsize n_buckets = 0;
+    GString *str;
+    guint i;
+
+    limits_array = g_variant_get_fixed_array (limits, &n_limits, sizeof (guint32));
+    histogram_array = g_variant_get_fixed_array (histogram, &n_buckets, sizeof (guint32));
+
+    str = g_string_new ("");
+    for (i = 0; i < n_buckets; i++) {
+        if (!histogram_array[i])
+            continue;
+        if (str->len)
+            g_string_append (str, ", ");
+        if (i < n_limits)
+            g_string_append_printf (str, "<=%ums: %u", limits_array[i], histogram_array[i]);
+        else
+            g_string_append_printf (str, ">%ums: %u", n_limits ? limits_array[n_limits - 1] : 0, histogram_array[i]);
+    }
+
+    g_print ("    %s: %s\n", name, str->len ? str->str : "none");
+    g_string_free (str, TRUE);
+}
+
+static void
+port_stats_process_reply (GVariant     *stats,
+                          const GError *error)
+{
+    GVariantIter iter;
+    GVariant *item;
+
+    if (!stats) {
+        g_printerr ("error: couldn't get port stats: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    if (!g_variant_n_children (stats)) {
+        g_print ("No port stats available\n");
+        g_variant_unref (stats);
+        return;
+    }
+
+    g_variant_iter_init (&iter, stats);
+    while ((item = g_variant_iter_next_value (&iter)) != NULL) {
+        const gchar *port = NULL;
+        const gchar *prefix = NULL;
+        guint32 count = 0;
+        guint32 timeouts = 0;
+        GVariant *limits;
+        GVariant *histogram;
+
+        g_variant_lookup (item, "port", "&s", &port);
+        g_variant_lookup (item, "prefix", "&s", &prefix);
+        g_variant_lookup (item, "count", "u", &count);
+        g_variant_lookup (item, "timeouts", "u", &timeouts);
+        g_print ("%s: '%s': %u commands, %u timeouts\n",
+                 port ? port : "unknown",
+                 prefix ? prefix : "",
+                 count,
+                 timeouts);
+
+        limits = g_variant_lookup_value (item, "bucket-limits", G_VARIANT_TYPE ("au"));
+        if (limits) {
+            histogram = g_variant_lookup_value (item, "queue-wait", G_VARIANT_TYPE ("au"));
+            if (histogram) {
+                print_port_stats_histogram ("queue wait", limits, histogram);
+                g_variant_unref (histogram);
+            }
+            histogram = g_variant_lookup_value (item, "first-byte", G_VARIANT_TYPE ("au"));
+            if (histogram) {
+                print_port_stats_histogram ("first byte", limits, histogram);
+                g_variant_unref (histogram);
+            }
+            histogram = g_variant_lookup_value (item, "response", G_VARIANT_TYPE ("au"));
+            if (histogram) {
+                print_port_stats_histogram ("response  ", limits, histogram);
+                g_variant_unref (histogram);
+            }
+            g_variant_unref (limits);
+        }
+        g_variant_unref (item);
+    }
+    g_variant_unref (stats);
+}
+
+static void
+port_stats_ready (MMManager    *manager,
+                  GAsyncResult *result,
+                  gpointer      nothing)
+{
+    GVariant *stats;
+    GError *error = NULL;
+
+    stats = mm_manager_get_port_stats_finish (manager, result, &error);
+    port_stats_process_reply (stats, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+loop_stats_process_reply (GVariant     *stats,
+                          const GError *error)
+{
+    guint32 threshold = 0;
+    guint64 iterations = 0;
+    guint32 iteration_max = 0;
+    guint32 stalls = 0;
+    guint32 lag_samples = 0;
+    GVariant *sections;
+
+    if (!stats) {
+        g_printerr ("error: couldn't get loop stats: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_lookup (stats, "threshold", "u", &threshold);
+    g_variant_lookup (stats, "iterations", "t", &iterations);
+    g_variant_lookup (stats, "iteration-max", "u", &iteration_max);
+    g_variant_lookup (stats, "stalls", "u", &stalls);
+    g_variant_lookup (stats, "lag-samples", "u", &lag_samples);
+
+    g_print ("iterations: %" G_GUINT64_FORMAT " (longest: %.1fms)\n",
+             iterations, iteration_max / 1000.0);
+    g_print ("stalls over %ums: %u\n", threshold, stalls);
+    if (lag_samples) {
+        guint32 p50 = 0, p90 = 0, p99 = 0, max = 0;
+
+        g_variant_lookup (stats, "lag-p50", "u", &p50);
+        g_variant_lookup (stats, "lag-p90", "u", &p90);
+        g_variant_lookup (stats, "lag-p99", "u", &p99);
+        g_variant_lookup (stats, "lag-max", "u", &max);
+        g_print ("lag: p50 %.1fms, p90 %.1fms, p99 %.1fms, max %.1fms (%u samples)\n",
+                 p50 / 1000.0, p90 / 1000.0, p99 / 1000.0, max / 1000.0, lag_samples);
+    }
+
+    sections = g_variant_lookup_value (stats, "sections", G_VARIANT_TYPE ("aa{sv}"));
+    if (sections) {
+        GVariantIter iter;
+        GVariant *item;
+
+        g_variant_iter_init (&iter, sections);
+        while ((item = g_variant_iter_next_value (&iter)) != NULL) {
+            const gchar *name = NULL;
+            guint64 count = 0;
+            guint64 total = 0;
+            guint32 section_max = 0;
+
+            g_variant_lookup (item, "name", "&s", &name);
+            g_variant_lookup (item, "count", "t", &count);
+            g_variant_lookup (item, "total", "t", &total);
+            g_variant_lookup (item, "max", "u", &section_max);
+            g_print ("  '%s': %" G_GUINT64_FORMAT " runs, %.1fms total, %.1fms longest\n",
+                     name ? name : "unknown",
+                     count,
+                     total / 1000.0,
+                     section_max / 1000.0);
+            g_variant_unref (item);
+        }
+        g_variant_unref (sections);
+    }
+    g_variant_unref (stats);
+}
+
+static void
+loop_stats_ready (MMManager    *manager,
+                  GAsyncResult *result,
+                  gpointer      nothing)
+{
+    GVariant *stats;
+    GError *error = NULL;
+
+    stats = mm_manager_get_loop_stats_finish (manager, result, &error);
+    loop_stats_process_reply (stats, error);
+
+    mmcli_async_operation_done ();
+}
+
+static gint
+span_cmp (GVariant **a,
+          GVariant **b)
+{
+    guint64 start_a = 0;
+    guint64 start_b = 0;
+
+    g_variant_lookup (*a, "start", "t", &start_a);
+    g_variant_lookup (*b, "start", "t", &start_b);
+    return (start_a > start_b) - (start_a < start_b);
+}
+
+static GPtrArray *
+build_sorted_spans (GVariant *profile)
+{
+    GPtrArray *spans;
+    GVariant *array;
+
+    spans = g_ptr_array_new_with_free_func ((GDestroyNotify) g_variant_unref);
+    array = g_variant_lookup_value (profile, "spans", G_VARIANT_TYPE ("aa{sv}"));
+    if (array) {
+        GVariantIter iter;
+        GVariant *item;
+
+        g_variant_iter_init (&iter, array);
+        while ((item = g_variant_iter_next_value (&iter)) != NULL)
+            g_ptr_array_add (spans, item);
+        g_variant_unref (array);
+    }
+    g_ptr_array_sort (spans, (GCompareFunc) span_cmp);
+    return spans;
+}
+
+static void
+print_profile (GPtrArray *spans)
+{
+    guint i;
+
+    for (i = 0; i < spans->len; i++) {
+        GVariant *span = g_ptr_array_index (spans, i);
+        const gchar *track = NULL;
+        const gchar *category = NULL;
+        const gchar *name = NULL;
+        guint64 start = 0;
+        guint64 duration;
+        gchar *duration_str;
+
+        g_variant_lookup (span, "track", "&s", &track);
+        g_variant_lookup (span, "category", "&s", &category);
+        g_variant_lookup (span, "name", "&s", &name);
+        g_variant_lookup (span, "start", "t", &start);
+        if (g_variant_lookup (span, "duration", "t", &duration))
+            duration_str = g_strdup_printf ("%.3fs", duration / 1000000.0);
+        else
+            duration_str = g_strdup ("running");
+
+        g_print ("%10.3fs %9s  %s: %s: %s\n",
+                 start / 1000000.0,
+                 duration_str,
+                 track ? track : "unknown",
+                 category ? category : "unknown",
+                 name ? name : "unknown");
+        g_free (duration_str);
+    }
+}
+
+/* Chrome trace event format: one process per device, with one thread per
+ * category of each of its tracks, as spans in different categories overlap */
+static void
+write_profile_trace (GPtrArray   *spans,
+                     const gchar *path)
+{
+    GHashTable *pids;
+    GHashTable *tids;
+    GString *str;
+    GError *error = NULL;
+    guint i;
+
+    pids = g_hash_table_new (g_str_hash, g_str_equal);
+    tids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    str = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+
+    for (i = 0; i < spans->len; i++) {
+        GVariant *span = g_ptr_array_index (spans, i);
+        const gchar *track = "unknown";
+        const gchar *group = NULL;
+        const gchar *category = "unknown";
+        const gchar *name = "unknown";
+        guint64 start = 0;
+        guint64 duration;
+        gchar *thread;
+        gchar *key;
+        guint pid;
+        guint tid;
+
+        g_variant_lookup (span, "track", "&s", &track);
+        g_variant_lookup (span, "group", "&s", &group);
+        g_variant_lookup (span, "category", "&s", &category);
+        g_variant_lookup (span, "name", "&s", &name);
+        g_variant_lookup (span, "start", "t", &start);
+        if (!group)
+            group = track;
+
+        pid = GPOINTER_TO_UINT (g_hash_table_lookup (pids, group));
+        if (!pid) {
+            pid = g_hash_table_size (pids) + 1;
+            g_hash_table_insert (pids, (gpointer) group, GUINT_TO_POINTER (pid));
+            g_string_append_printf (str, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%u,\"args\":{\"name\":", pid);
+            mmcli_append_json_string (str, group);
+            g_string_append (str, "}},");
+        }
+
+        thread = (group != track ?
+                  g_strdup_printf ("%s: %s", track, category) :
+                  g_strdup (category));
+        key = g_strdup_printf ("%u/%s", pid, thread);
+        tid = GPOINTER_TO_UINT (g_hash_table_lookup (tids, key));
+        if (!tid) {
+            tid = g_hash_table_size (tids) + 1;
+            g_string_append_printf (str, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":", pid, tid);
+            mmcli_append_json_string (str, thread);
+            g_string_append (str, "}},");
+            g_hash_table_insert (tids, key, GUINT_TO_POINTER (tid));
+        } else
+            g_free (key);
+        g_free (thread);
+
+        g_string_append (str, "{\"name\":");
+        mmcli_append_json_string (str, name);
+        g_string_append (str, ",\"cat\":");
+        mmcli_append_json_string (str, category);
+        /* Running spans are shown until the end of the trace */
+        if (g_variant_lookup (span, "duration", "t", &duration))
+            g_string_append_printf (str, ",\"ph\":\"X\",\"dur\":%" G_GUINT64_FORMAT, duration);
+        else
+            g_string_append (str, ",\"ph\":\"B\"");
+        g_string_append_printf (str, ",\"ts\":%" G_GUINT64_FORMAT ",\"pid\":%u,\"tid\":%u},",
+                                start, pid, tid);
+    }
+
+    /* Remove the trailing comma */
+    if (str->str[str->len - 1] == ',')
+        g_string_truncate (str, str->len - 1);
+    g_string_append (str, "]}\n");
+
+    if (!g_file_set_contents (path, str->str, str->len, &error)) {
+        g_printerr ("error: couldn't write profile trace: '%s'\n", error->message);
+        exit (EXIT_FAILURE);
+    }
+    g_print ("successfully written %u spans to '%s'\n", spans->len, path);
+
+    g_string_free (str, TRUE);
+    g_hash_table_unref (tids);
+    g_hash_table_unref (pids);
+}
+
+static void
+profile_process_reply (GVariant     *profile,
+                       const GError *error)
+{
+    GPtrArray *spans;
+    guint64 dropped = 0;
+
+    if (!profile) {
+        g_printerr ("error: couldn't get profile: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_lookup (profile, "dropped", "t", &dropped);
+    if (dropped)
+        g_printerr ("warning: %" G_GUINT64_FORMAT " older spans are no longer available\n", dropped);
+
+    spans = build_sorted_spans (profile);
+    if (profile_trace_str)
+        write_profile_trace (spans, profile_trace_str);
+    else
+        print_profile (spans);
+
+    g_ptr_array_unref (spans);
+    g_variant_unref (profile);
+}
+
+static void
+profile_ready (MMManager    *manager,
+               GAsyncResult *result,
+               gpointer      nothing)
+{
+    GVariant *profile;
+    GError *error = NULL;
+
+    profile = mm_manager_get_profile_finish (manager, result, &error);
+    profile_process_reply (profile, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+telemetry_process_reply (GVariant     *telemetry,
+                         const GError *error)
+{
+    GVariantIter iter;
+    const gchar *path;
+    GVariant *values;
+
+    if (!telemetry) {
+        g_printerr ("error: couldn't get telemetry: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_variant_iter_init (&iter, telemetry);
+    while (g_variant_iter_next (&iter, "{&o@a{sv}}", &path, &values)) {
+        gint32 state = MM_MODEM_STATE_UNKNOWN;
+        guint32 access_technologies = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
+        guint32 registration_state;
+        guint32 quality = 0;
+        gboolean recent = FALSE;
+        const gchar *operator_code = NULL;
+        const gchar *operator_name = NULL;
+        gchar *access_technologies_str;
+        GVariant *bearers;
+
+        g_variant_lookup (values, "state", "i", &state);
+        g_variant_lookup (values, "access-technologies", "u", &access_technologies);
+        g_variant_lookup (values, "signal-quality", "(ub)", &quality, &recent);
+
+        access_technologies_str = mm_modem_access_technology_build_string_from_mask (access_technologies);
+        g_print ("%s\n"
+                 "  state: %s, access tech: %s, signal quality: %u%%%s\n",
+                 path,
+                 mm_modem_state_get_string (state),
+                 access_technologies_str,
+                 quality,
+                 recent ? " (recent)" : "");
+        g_free (access_technologies_str);
+
+        if (g_variant_lookup (values, "registration-state", "u", &registration_state)) {
+            g_variant_lookup (values, "operator-code", "&s", &operator_code);
+            g_variant_lookup (values, "operator-name", "&s", &operator_name);
+            g_print ("  registration: %s, operator: %s (%s)\n",
+                     mm_modem_3gpp_registration_state_get_string (registration_state),
+                     operator_name ? operator_name : "unknown",
+                     operator_code ? operator_code : "unknown");
+        }
+
+        bearers = g_variant_lookup_value (values, "bearers", G_VARIANT_TYPE ("aa{sv}"));
+        if (bearers) {
+            GVariantIter bearer_iter;
+            GVariant *bearer;
+
+            g_variant_iter_init (&bearer_iter, bearers);
+            while ((bearer = g_variant_iter_next_value (&bearer_iter)) != NULL) {
+                const gchar *bearer_path = NULL;
+                gboolean connected = FALSE;
+                GVariant *stats;
+                guint64 rx_bytes = 0;
+                guint64 tx_bytes = 0;
+
+                g_variant_lookup (bearer, "path", "&o", &bearer_path);
+                g_variant_lookup (bearer, "connected", "b", &connected);
+                stats = g_variant_lookup_value (bearer, "stats", G_VARIANT_TYPE ("a{sv}"));
+                if (stats) {
+                    g_variant_lookup (stats, "rx-bytes", "t", &rx_bytes);
+                    g_variant_lookup (stats, "tx-bytes", "t", &tx_bytes);
+                    g_variant_unref (stats);
+                }
+                g_print ("  bearer %s: %s, rx %" G_GUINT64_FORMAT " bytes, tx %" G_GUINT64_FORMAT " bytes\n",
+                         bearer_path ? bearer_path : "unknown",
+                         connected ? "connected" : "disconnected",
+                         rx_bytes,
+                         tx_bytes);
+                g_variant_unref (bearer);
+            }
+            g_variant_unref (bearers);
+        }
+
+        g_variant_unref (values);
+    }
+    g_variant_unref (telemetry);
+}
+
+static void
+telemetry_ready (MMManager    *manager,
+                 GAsyncResult *result,
+                 gpointer      nothing)
+{
+    GVariant *telemetry;
+    GError *error = NULL;
+
+    telemetry = mm_manager_get_telemetry_finish (manager, result, &error);
+    telemetry_process_reply (telemetry, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+census_process_reply (GVariant     *census,
+                      const GError *error)
+{
+    GVariant *modems;
+    GVariant *types;
+
+    if (!census) {
+        g_printerr ("error: couldn't get census: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    modems = g_variant_lookup_value (census, "modems", G_VARIANT_TYPE ("a{oa{sv}}"));
+    if (modems) {
+        GVariantIter iter;
+        const gchar *path;
+        GVariant *dict;
+
+        g_variant_iter_init (&iter, modems);
+        while (g_variant_iter_next (&iter, "{&o@a{sv}}", &path, &dict)) {
+            GVariantIter dict_iter;
+            const gchar *key;
+            GVariant *value;
+
+            g_print ("%s\n", path);
+            g_variant_iter_init (&dict_iter, dict);
+            while (g_variant_iter_next (&dict_iter, "{&sv}", &key, &value)) {
+                gchar *str;
+
+                str = g_variant_print (value, FALSE);
+                g_print ("  %s: %s\n", key, str);
+                g_free (str);
+                g_variant_unref (value);
+            }
+            g_variant_unref (dict);
+        }
+        g_variant_unref (modems);
+    }
+
+    types = g_variant_lookup_value (census, "types", G_VARIANT_TYPE ("a{su}"));
+    if (types) {
+        GVariantIter iter;
+        const gchar *name;
+        guint32 count;
+
+        g_print ("live objects:\n");
+        g_variant_iter_init (&iter, types);
+        while (g_variant_iter_next (&iter, "{&su}", &name, &count))
+            g_print ("  %s: %u\n", name, count);
+        g_variant_unref (types);
+    } else
+        g_print ("live objects: unknown, run the daemon with GOBJECT_DEBUG=instance-count\n");
+
+    g_variant_unref (census);
+}
+
+static void
+census_ready (MMManager    *manager,
+              GAsyncResult *result,
+              gpointer      nothing)
+{
+    GVariant *census;
+    GError *error = NULL;
+
+    census = mm_manager_get_census_finish (manager, result, &error);
+    census_process_reply (census, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+metrics_process_reply (gchar        *metrics,
+                       const GError *error)
+{
+    if (!metrics) {
+        g_printerr ("error: couldn't get metrics: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_print ("%s", metrics);
+    g_free (metrics);
+}
+
+static void
+metrics_ready (MMManager    *manager,
+               GAsyncResult *result,
+               gpointer      nothing)
+{
+    gchar *metrics;
+    GError *error = NULL;
+
+    metrics = mm_manager_get_metrics_finish (manager, result, &error);
+    metrics_process_reply (metrics, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+capture_traffic_process_reply (gboolean      result,
+                               const GError *error)
+{
+    if (!result) {
+        g_printerr ("error: couldn't %s traffic capture: '%s'\n",
+                    capture_traffic_str ? "start" : "stop",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    if (capture_traffic_str)
+        g_print ("Successfully started traffic capture\n");
+    else
+        g_print ("Successfully stopped traffic capture\n");
+}
+
+static void
+capture_traffic_ready (MMManager    *manager,
+                       GAsyncResult *result,
+                       gpointer      nothing)
+{
+    gboolean operation_result;
+    GError *error = NULL;
+
+    operation_result = mm_manager_capture_traffic_finish (manager, result, &error);
+    capture_traffic_process_reply (operation_result, error);
+
+    mmcli_async_operation_done ();
+}
+
+/* The file is created by the daemon, which runs in a different directory */
+static gchar *
+capture_traffic_build_path (void)
+{
+    gchar *cwd;
+    gchar *path;
+
+    if (!capture_traffic_str)
+        return g_strdup ("");
+    if (g_path_is_absolute (capture_traffic_str))
+        return g_strdup (capture_traffic_str);
+
+    cwd = g_get_current_dir ();
+    path = g_build_filename (cwd, capture_traffic_str, NULL);
+    g_free (cwd);
+    return path;
+}
+
 static void
 scan_devices_process_reply (gboolean      result,
                             const GError *error)
@@ -319,6 +1083,162 @@ list_current_modems (MMManager *manager)
     g_print ("\n");
 }
 
+/* Every event starts a new JSON object, completed and printed by monitor_event_print() */
+static GString *
+monitor_event_new (const gchar *event,
+                   GDBusObject *object)
+{
+    GString *str;
+
+    str = g_string_new ("{");
+    g_string_append_printf (str, "\"timestamp\":%" G_GINT64_FORMAT ",\"event\":", g_get_real_time () / 1000);
+    mmcli_append_json_string (str, event);
+    g_string_append (str, ",\"modem\":");
+    mmcli_append_json_string (str, g_dbus_object_get_object_path (object));
+    return str;
+}
+
+static void
+monitor_event_print (GString *str)
+{
+    g_string_append (str, "}\n");
+    fputs (str->str, stdout);
+    fflush (stdout);
+    g_string_free (str, TRUE);
+}
+
+static void
+monitor_append_properties (GString    *str,
+                           GDBusProxy *proxy)
+{
+    gchar **names;
+    guint i;
+    gboolean first = TRUE;
+
+    g_string_append_c (str, '{');
+    names = g_dbus_proxy_get_cached_property_names (proxy);
+    for (i = 0; names && names[i]; i++) {
+        GVariant *value;
+
+        value = g_dbus_proxy_get_cached_property (proxy, names[i]);
+        if (!value)
+            continue;
+        if (!first)
+            g_string_append_c (str, ',');
+        mmcli_append_json_string (str, names[i]);
+        g_string_append_c (str, ':');
+        mmcli_append_json_variant (str, value);
+        g_variant_unref (value);
+        first = FALSE;
+    }
+    g_strfreev (names);
+    g_string_append_c (str, '}');
+}
+
+static void
+monitor_object_added (GDBusObjectManager *manager,
+                      GDBusObject        *object)
+{
+    GString *str;
+    GList *interfaces, *l;
+
+    str = monitor_event_new ("added", object);
+    g_string_append (str, ",\"interfaces\":{");
+    interfaces = g_dbus_object_get_interfaces (object);
+    for (l = interfaces; l; l = g_list_next (l)) {
+        if (l != interfaces)
+            g_string_append_c (str, ',');
+        mmcli_append_json_string (str, g_dbus_proxy_get_interface_name (G_DBUS_PROXY (l->data)));
+        g_string_append_c (str, ':');
+        monitor_append_properties (str, G_DBUS_PROXY (l->data));
+    }
+    g_list_free_full (interfaces, g_object_unref);
+    g_string_append_c (str, '}');
+    monitor_event_print (str);
+}
+
+static void
+monitor_object_removed (GDBusObjectManager *manager,
+                        GDBusObject        *object)
+{
+    monitor_event_print (monitor_event_new ("removed", object));
+}
+
+static void
+monitor_interface_added (GDBusObjectManager *manager,
+                         GDBusObject        *object,
+                         GDBusInterface     *interface)
+{
+    GString *str;
+
+    str = monitor_event_new ("interface-added", object);
+    g_string_append (str, ",\"interface\":");
+    mmcli_append_json_string (str, g_dbus_proxy_get_interface_name (G_DBUS_PROXY (interface)));
+    g_string_append (str, ",\"properties\":");
+    monitor_append_properties (str, G_DBUS_PROXY (interface));
+    monitor_event_print (str);
+}
+
+static void
+monitor_interface_removed (GDBusObjectManager *manager,
+                           GDBusObject        *object,
+                           GDBusInterface     *interface)
+{
+    GString *str;
+
+    str = monitor_event_new ("interface-removed", object);
+    g_string_append (str, ",\"interface\":");
+    mmcli_append_json_string (str, g_dbus_proxy_get_interface_name (G_DBUS_PROXY (interface)));
+    monitor_event_print (str);
+}
+
+static void
+monitor_properties_changed (GDBusObjectManagerClient *manager,
+                            GDBusObjectProxy         *object,
+                            GDBusProxy               *interface,
+                            GVariant                 *changed_properties,
+                            const gchar * const      *invalidated_properties)
+{
+    GString *str;
+    guint i;
+
+    str = monitor_event_new ("properties-changed", G_DBUS_OBJECT (object));
+    g_string_append (str, ",\"interface\":");
+    mmcli_append_json_string (str, g_dbus_proxy_get_interface_name (interface));
+    g_string_append (str, ",\"properties\":");
+    mmcli_append_json_variant (str, changed_properties);
+    if (invalidated_properties && invalidated_properties[0]) {
+        g_string_append (str, ",\"invalidated\":[");
+        for (i = 0; invalidated_properties[i]; i++) {
+            if (i > 0)
+                g_string_append_c (str, ',');
+            mmcli_append_json_string (str, invalidated_properties[i]);
+        }
+        g_string_append_c (str, ']');
+    }
+    monitor_event_print (str);
+}
+
+static void
+monitor_signal (GDBusObjectManagerClient *manager,
+                GDBusObjectProxy         *object,
+                GDBusProxy               *interface,
+                const gchar              *sender_name,
+                const gchar              *signal_name,
+                GVariant                 *parameters)
+{
+    GString *str;
+
+    str = monitor_event_new ("signal", G_DBUS_OBJECT (object));
+    g_string_append (str, ",\"interface\":");
+    mmcli_append_json_string (str, g_dbus_proxy_get_interface_name (interface));
+    g_string_append (str, ",\"signal\":");
+    mmcli_append_json_string (str, signal_name);
+    g_string_append (str, ",\"args\":");
+    mmcli_append_json_variant (str, parameters);
+    monitor_event_print (str);
+}
+
 static void
 cancelled (GCancellable *cancellable)
 {
@@ -365,6 +1285,74 @@ get_manager_ready (GObject      *source,
         return;
     }
 
+    /* Request to get port stats? */
+    if (port_stats_flag) {
+        mm_manager_get_port_stats (ctx->manager,
+                                   ctx->cancellable,
+                                   (GAsyncReadyCallback)port_stats_ready,
+                                   NULL);
+        return;
+    }
+
+    /* Request to get loop stats? */
+    if (loop_stats_flag) {
+        mm_manager_get_loop_stats (ctx->manager,
+                                   ctx->cancellable,
+                                   (GAsyncReadyCallback)loop_stats_ready,
+                                   NULL);
+        return;
+    }
+
+    /* Request to get profile? */
+    if (profile_flag || profile_trace_str) {
+        mm_manager_get_profile (ctx->manager,
+                                ctx->cancellable,
+                                (GAsyncReadyCallback)profile_ready,
+                                NULL);
+        return;
+    }
+
+    /* Request to get telemetry? */
+    if (telemetry_flag) {
+        mm_manager_get_telemetry (ctx->manager,
+                                  ctx->cancellable,
+                                  (GAsyncReadyCallback)telemetry_ready,
+                                  NULL);
+        return;
+    }
+
+    /* Request to get census? */
+    if (census_flag) {
+        mm_manager_get_census (ctx->manager,
+                               ctx->cancellable,
+                               (GAsyncReadyCallback)census_ready,
+                               NULL);
+        return;
+    }
+
+    /* Request to get metrics? */
+    if (metrics_flag) {
+        mm_manager_get_metrics (ctx->manager,
+                                ctx->cancellable,
+                                (GAsyncReadyCallback)metrics_ready,
+                                NULL);
+        return;
+    }
+
+    /* Request to start or stop capturing traffic? */
+    if (capture_traffic_str || capture_traffic_stop_flag) {
+        gchar *path;
+
+        path = capture_traffic_build_path ();
+        mm_manager_capture_traffic (ctx->manager,
+                                    path,
+                                    ctx->cancellable,
+                                    (GAsyncReadyCallback)capture_traffic_ready,
+                                    NULL);
+        g_free (path);
+        return;
+    }
+
     /* Request to scan modems? */
     if (scan_modems_flag) {
         mm_manager_scan_devices (ctx->manager,
@@ -388,14 +1376,30 @@ get_manager_ready (GObject      *source,
         return;
     }
 
+    /* Request to report kernel events from stdin? */
+    if (report_kernel_events_stdin_flag) {
+        GList *list;
+
+        list = build_kernel_events_from_stdin ();
+        mm_manager_report_kernel_events (ctx->manager,
+                                         list,
+                                         ctx->cancellable,
+                                         (GAsyncReadyCallback)report_kernel_events_ready,
+                                         GUINT_TO_POINTER (g_list_length (list)));
+        g_list_free_full (list, g_object_unref);
+        return;
+    }
+
 #if WITH_UDEV
     if (report_kernel_event_auto_scan) {
         const gchar *subsys[] = { "tty", "usbmisc", "net", NULL };
+        GList *events = NULL;
         guint i;
 
         ctx->udev = g_udev_client_new (subsys);
         g_signal_connect (ctx->udev, "uevent", G_CALLBACK (handle_uevent), NULL);
 
+        /* Devices already there are all reported at once */
         for (i = 0; subsys[i]; i++) {
             GList *list, *iter;
 
@@ -409,11 +1413,14 @@ get_manager_ready (GObject      *source,
                 mm_kernel_event_properties_set_action (properties, "add");
                 mm_kernel_event_properties_set_subsystem (properties, subsys[i]);
                 mm_kernel_event_properties_set_name (properties, g_udev_device_get_name (device));
-                mm_manager_report_kernel_event (ctx->manager, properties, NULL, NULL, NULL);
-                g_object_unref (properties);
+                events = g_list_prepend (events, properties);
             }
             g_list_free_full (list, (GDestroyNotify) g_object_unref);
         }
+        events = g_list_reverse (events);
+        if (events)
+            mm_manager_report_kernel_events (ctx->manager, events, NULL, NULL, NULL);
+        g_list_free_full (events, g_object_unref);
 
         /* If we get cancelled, operation done */
         g_cancellable_connect (ctx->cancellable,
@@ -444,6 +1451,49 @@ get_manager_ready (GObject      *source,
         return;
     }
 
+    /* Request to monitor modems in JSON format? */
+    if (monitor_flag) {
+        GList *modems, *l;
+
+        g_signal_connect (ctx->manager,
+                          "object-added",
+                          G_CALLBACK (monitor_object_added),
+                          NULL);
+        g_signal_connect (ctx->manager,
+                          "object-removed",
+                          G_CALLBACK (monitor_object_removed),
+                          NULL);
+        g_signal_connect (ctx->manager,
+                          "interface-added",
+                          G_CALLBACK (monitor_interface_added),
+                          NULL);
+        g_signal_connect (ctx->manager,
+                          "interface-removed",
+                          G_CALLBACK (monitor_interface_removed),
+                          NULL);
+        g_signal_connect (ctx->manager,
+                          "interface-proxy-properties-changed",
+                          G_CALLBACK (monitor_properties_changed),
+                          NULL);
+        g_signal_connect (ctx->manager,
+                          "interface-proxy-signal",
+                          G_CALLBACK (monitor_signal),
+                          NULL);
+
+        /* Start with a full snapshot of the modems already available */
+        modems = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (ctx->manager));
+        for (l = modems; l; l = g_list_next (l))
+            monitor_object_added (G_DBUS_OBJECT_MANAGER (ctx->manager), G_DBUS_OBJECT (l->data));
+        g_list_free_full (modems, g_object_unref);
+
+        /* If we get cancelled, operation done */
+        g_cancellable_connect (ctx->cancellable,
+                               G_CALLBACK (cancelled),
+                               NULL,
+                               NULL);
+        return;
+    }
+
     /* Request to list modems? */
     if (list_modems_flag) {
         list_current_modems (ctx->manager);
@@ -475,7 +1525,7 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
 {
     GError *error = NULL;
 
-    if (monitor_modems_flag) {
+    if (monitor_modems_flag || monitor_flag) {
         g_printerr ("error: monitoring modems cannot be done synchronously\n");
         exit (EXIT_FAILURE);
     }
@@ -506,6 +1556,72 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to get port stats? */
+    if (port_stats_flag) {
+        GVariant *stats;
+
+        stats = mm_manager_get_port_stats_sync (ctx->manager, NULL, &error);
+        port_stats_process_reply (stats, error);
+        return;
+    }
+
+    /* Request to get loop stats? */
+    if (loop_stats_flag) {
+        GVariant *stats;
+
+        stats = mm_manager_get_loop_stats_sync (ctx->manager, NULL, &error);
+        loop_stats_process_reply (stats, error);
+        return;
+    }
+
+    /* Request to get profile? */
+    if (profile_flag || profile_trace_str) {
+        GVariant *profile;
+
+        profile = mm_manager_get_profile_sync (ctx->manager, NULL, &error);
+        profile_process_reply (profile, error);
+        return;
+    }
+
+    /* Request to get telemetry? */
+    if (telemetry_flag) {
+        GVariant *telemetry;
+
+        telemetry = mm_manager_get_telemetry_sync (ctx->manager, NULL, &error);
+        telemetry_process_reply (telemetry, error);
+        return;
+    }
+
+    /* Request to get census? */
+    if (census_flag) {
+        GVariant *census;
+
+        census = mm_manager_get_census_sync (ctx->manager, NULL, &error);
+        census_process_reply (census, error);
+        return;
+    }
+
+    /* Request to get metrics? */
+    if (metrics_flag) {
+        gchar *metrics;
+
+        metrics = mm_manager_get_metrics_sync (ctx->manager, NULL, &error);
+        metrics_process_reply (metrics, error);
+        return;
+    }
+
+    /* Request to start or stop capturing traffic? */
+    if (capture_traffic_str || capture_traffic_stop_flag) {
+        gboolean result;
+        gchar *path;
+
+        path = capture_traffic_build_path ();
+        result = mm_manager_capture_traffic_sync (ctx->manager, path, NULL, &error);
+        capture_traffic_process_reply (result, error);
+        g_free (path);
+        return;
+    }
+
     /* Request to scan modems? */
     if (scan_modems_flag) {
         gboolean result;
@@ -531,6 +1647,21 @@ mmcli_manager_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to report kernel events from stdin? */
+    if (report_kernel_events_stdin_flag) {
+        GList *list;
+        gboolean result;
+
+        list = build_kernel_events_from_stdin ();
+        result = mm_manager_report_kernel_events_sync (ctx->manager,
+                                                       list,
+                                                       NULL,
+                                                       &error);
+        report_kernel_events_process_reply (result, error, g_list_length (list));
+        g_list_free_full (list, g_object_unref);
+        return;
+    }
+
     /* Request to list modems? */
     if (list_modems_flag) {
         list_current_modems (ctx->manager);
@@ -25,6 +25,8 @@
 #include <stdlib.h>
 #include <locale.h>
 #include <string.h>
+#include <unistd.h>
+#include <errno.h>
 
 #include <glib.h>
 #include <gio/gio.h>
@@ -65,8 +67,11 @@ static gboolean disable_gps_unmanaged_flag;
 static gboolean set_enable_signal_flag;
 static gboolean set_disable_signal_flag;
 static gboolean get_all_flag;
+static gboolean stream_gps_nmea_flag;
 static gchar *set_supl_server_str;
 static gchar *set_gps_refresh_rate_str;
+static gchar *inject_assistance_data_str;
+static gchar *get_history_str;
 
 static GOptionEntry entries[] = {
     { "location-status", 0, 0, G_OPTION_ARG_NONE, &status_flag,
@@ -109,6 +114,10 @@ static GOptionEntry entries[] = {
       "Get NMEA GPS traces.",
       NULL
     },
+    { "location-stream-gps-nmea", 0, 0, G_OPTION_ARG_NONE, &stream_gps_nmea_flag,
+      "Print NMEA GPS traces as they are received, until interrupted.",
+      NULL
+    },
     { "location-enable-gps-raw", 0, 0, G_OPTION_ARG_NONE, &enable_gps_raw_flag,
       "Enable raw GPS location gathering.",
       NULL
@@ -149,6 +158,14 @@ static GOptionEntry entries[] = {
       "Set GPS refresh rate in seconds, or 0 disable the explicit rate.",
       "[RATE]"
     },
+    { "location-inject-assistance-data", 0, 0, G_OPTION_ARG_FILENAME, &inject_assistance_data_str,
+      "Inject assistance data in the GNSS module",
+      "[PATH]"
+    },
+    { "location-get-history", 0, 0, G_OPTION_ARG_STRING, &get_history_str,
+      "Get the location history of the last given seconds, or 0 for all of it.",
+      "[SECONDS]"
+    },
     { "location-set-enable-signal", 0, 0, G_OPTION_ARG_NONE, &set_enable_signal_flag,
       "Enable location update signaling in DBus property.",
       NULL
@@ -226,14 +243,17 @@ mmcli_modem_location_options_enabled (void)
                     get_gps_raw_flag +
                     get_cdma_bs_flag) +
                  !!set_supl_server_str +
-                 !!set_gps_refresh_rate_str);
+                 !!set_gps_refresh_rate_str +
+                 !!inject_assistance_data_str +
+                 !!get_history_str +
+                 stream_gps_nmea_flag);
 
     if (n_actions > 1) {
         g_printerr ("error: too many Location actions requested\n");
         exit (EXIT_FAILURE);
     }
 
-    if (status_flag)
+    if (status_flag || stream_gps_nmea_flag)
         mmcli_force_sync_operation ();
 
     checked = TRUE;
@@ -323,6 +343,24 @@ print_location_status (void)
             g_print ("  GPS      |  refresh rate: disabled\n");
     }
 
+    /* If assistance data supported, show its types and the last TTFF */
+    if (mm_modem_location_get_supported_assistance_data (ctx->modem_location) != MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_NONE) {
+        gchar *assistance_str;
+        guint  ttff;
+
+        assistance_str = (mm_modem_location_assistance_data_type_build_string_from_mask (
+                              mm_modem_location_get_supported_assistance_data (ctx->modem_location)));
+        ttff = mm_modem_location_get_time_to_first_fix (ctx->modem_location);
+        g_print ("  ----------------------------\n"
+                 "  GPS      |     assistance: '%s'\n",
+                 assistance_str);
+        if (ttff > 0)
+            g_print ("           | time to 1st fix: '%u.%03us'\n", ttff / 1000, ttff % 1000);
+        else
+            g_print ("           | time to 1st fix: unknown\n");
+        g_free (assistance_str);
+    }
+
     g_free (capabilities_str);
     g_free (enabled_str);
 }
@@ -405,6 +443,167 @@ set_gps_refresh_rate_ready (MMModemLocation *modem_location,
     mmcli_async_operation_done ();
 }
 
+static void
+inject_assistance_data_process_reply (gboolean result,
+                                      const GError *error)
+{
+    if (!result) {
+        g_printerr ("error: couldn't inject assistance data: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_print ("successfully injected assistance data\n");
+}
+
+static void
+inject_assistance_data_ready (MMModemLocation *modem_location,
+                              GAsyncResult    *result,
+                              gchar           *data)
+{
+    gboolean operation_result;
+    GError *error = NULL;
+
+    operation_result = mm_modem_location_inject_assistance_data_finish (modem_location, result, &error);
+    g_free (data);
+    inject_assistance_data_process_reply (operation_result, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+inject_assistance_data_load (gchar **data,
+                             gsize  *data_size)
+{
+    GError *error = NULL;
+
+    if (!g_file_get_contents (inject_assistance_data_str, data, data_size, &error)) {
+        g_printerr ("error: couldn't read assistance data file: '%s'\n",
+                    error->message);
+        exit (EXIT_FAILURE);
+    }
+}
+
+static gboolean
+get_history_range_from_str (guint64 *from)
+{
+    guint seconds;
+    gint64 now;
+
+    if (!mm_get_uint_from_str (get_history_str, &seconds))
+        return FALSE;
+
+    now = g_get_real_time () / G_USEC_PER_SEC;
+    *from = (seconds && seconds < now) ? (guint64) (now - seconds) : 0;
+    return TRUE;
+}
+
+static void
+get_history_process_reply (GVariant *history,
+                           const GError *error)
+{
+    GVariantIter iter;
+    GVariant *record;
+
+    if (!history) {
+        g_printerr ("error: couldn't get location history: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_print ("\n"
+             "%s\n"
+             "  -------------------------\n"
+             "  History         | %" G_GSIZE_FORMAT " records\n",
+             mm_modem_location_get_path (ctx->modem_location),
+             g_variant_n_children (history));
+
+    g_variant_iter_init (&iter, history);
+    while ((record = g_variant_iter_next_value (&iter))) {
+        GDateTime *time;
+        gchar *time_str;
+        guint64 timestamp = 0;
+        gdouble latitude;
+        gdouble longitude;
+        gdouble altitude;
+        guint mcc;
+        guint mnc;
+        guint lac;
+        guint ci;
+
+        g_variant_lookup (record, "timestamp", "t", &timestamp);
+        time = g_date_time_new_from_unix_utc ((gint64) timestamp);
+        time_str = g_date_time_format (time, "%Y-%m-%dT%H:%M:%SZ");
+        g_print ("  -------------------------\n"
+                 "  %s |\n", time_str);
+        g_free (time_str);
+        g_date_time_unref (time);
+
+        if (g_variant_lookup (record, "latitude", "d", &latitude) &&
+            g_variant_lookup (record, "longitude", "d", &longitude)) {
+            g_print ("                       |  Latitude: '%lf'\n"
+                     "                       | Longitude: '%lf'\n",
+                     latitude, longitude);
+            if (g_variant_lookup (record, "altitude", "d", &altitude))
+                g_print ("                       |  Altitude: '%lf'\n", altitude);
+        }
+
+        if (g_variant_lookup (record, "mcc", "u", &mcc) &&
+            g_variant_lookup (record, "mnc", "u", &mnc) &&
+            g_variant_lookup (record, "lac", "u", &lac) &&
+            g_variant_lookup (record, "ci", "u", &ci))
+            g_print ("                       |       MCC: '%u'\n"
+                     "                       |       MNC: '%u'\n"
+                     "                       |       LAC: '%u'\n"
+                     "                       |   Cell ID: '%u'\n",
+                     mcc, mnc, lac, ci);
+
+        g_variant_unref (record);
+    }
+
+    g_variant_unref (history);
+}
+
+static void
+get_history_ready (MMModemLocation *modem_location,
+                   GAsyncResult    *result)
+{
+    GVariant *history;
+    GError *error = NULL;
+
+    history = mm_modem_location_get_history_finish (modem_location, result, &error);
+    get_history_process_reply (history, error);
+
+    mmcli_async_operation_done ();
+}
+
+static void
+stream_gps_nmea (gint fd)
+{
+    gchar buffer[4096];
+
+    /* Just copy the stream to stdout until closed by the modem */
+    for (;;) {
+        gssize n_read;
+
+        n_read = read (fd, buffer, sizeof (buffer));
+        if (n_read < 0 && errno == EINTR)
+            continue;
+        if (n_read < 0) {
+            g_printerr ("error: couldn't read NMEA stream: '%s'\n", g_strerror (errno));
+            close (fd);
+            exit (EXIT_FAILURE);
+        }
+        if (n_read == 0)
+            break;
+        fwrite (buffer, 1, n_read, stdout);
+        fflush (stdout);
+    }
+
+    close (fd);
+    g_print ("NMEA stream closed\n");
+}
+
 static MMModemLocationSource
 build_sources_from_flags (void)
 {
@@ -613,7 +812,7 @@ get_modem_ready (GObject      *source,
 
     ensure_modem_location ();
 
-    if (status_flag)
+    if (status_flag || stream_gps_nmea_flag)
         g_assert_not_reached ();
 
     /* Request to setup location gathering? */
@@ -683,6 +882,41 @@ get_modem_ready (GObject      *source,
         return;
     }
 
+    /* Request to inject assistance data? */
+    if (inject_assistance_data_str) {
+        gchar *data;
+        gsize data_size;
+
+        inject_assistance_data_load (&data, &data_size);
+        g_debug ("Asynchronously injecting assistance data...");
+        mm_modem_location_inject_assistance_data (ctx->modem_location,
+                                                  (const guint8 *) data,
+                                                  data_size,
+                                                  ctx->cancellable,
+                                                  (GAsyncReadyCallback)inject_assistance_data_ready,
+                                                  data);
+        return;
+    }
+
+    /* Request to get location history? */
+    if (get_history_str) {
+        guint64 from;
+
+        if (!get_history_range_from_str (&from)) {
+            g_printerr ("error: couldn't get location history: invalid number of seconds given: '%s'\n",
+                        get_history_str);
+            exit (EXIT_FAILURE);
+        }
+        g_debug ("Asynchronously getting location history...");
+        mm_modem_location_get_history (ctx->modem_location,
+                                       from,
+                                       0,
+                                       ctx->cancellable,
+                                       (GAsyncReadyCallback)get_history_ready,
+                                       NULL);
+        return;
+    }
+
     g_warn_if_reached ();
 }
 
@@ -728,6 +962,21 @@ mmcli_modem_location_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to stream NMEA traces? */
+    if (stream_gps_nmea_flag) {
+        gint fd;
+
+        g_debug ("Synchronously opening NMEA stream...");
+        fd = mm_modem_location_open_nmea_stream_sync (ctx->modem_location, NULL, &error);
+        if (fd < 0) {
+            g_printerr ("error: couldn't open NMEA stream: '%s'\n",
+                        error ? error->message : "unknown error");
+            exit (EXIT_FAILURE);
+        }
+        stream_gps_nmea (fd);
+        return;
+    }
+
     /* Request to setup location gathering? */
     if (enable_3gpp_flag ||
         disable_3gpp_flag ||
@@ -810,5 +1059,44 @@ mmcli_modem_location_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to inject assistance data? */
+    if (inject_assistance_data_str) {
+        gboolean result;
+        gchar *data;
+        gsize data_size;
+
+        inject_assistance_data_load (&data, &data_size);
+        g_debug ("Synchronously injecting assistance data...");
+        result = mm_modem_location_inject_assistance_data_sync (ctx->modem_location,
+                                                                (const guint8 *) data,
+                                                                data_size,
+                                                                NULL,
+                                                                &error);
+        g_free (data);
+        inject_assistance_data_process_reply (result, error);
+        return;
+    }
+
+    /* Request to get location history? */
+    if (get_history_str) {
+        GVariant *history;
+        guint64 from;
+
+        if (!get_history_range_from_str (&from)) {
+            g_printerr ("error: couldn't get location history: invalid number of seconds given: '%s'\n",
+                        get_history_str);
+            exit (EXIT_FAILURE);
+        }
+
+        g_debug ("Synchronously getting location history...");
+        history = mm_modem_location_get_history_sync (ctx->modem_location,
+                                                      from,
+                                                      0,
+                                                      NULL,
+                                                      &error);
+        get_history_process_reply (history, error);
+        return;
+    }
+
     g_warn_if_reached ();
 }
@@ -46,12 +46,17 @@ static Context *ctx;
 /* Options */
 static gboolean get_flag;
 static gchar *setup_str;
+static gchar *setup_thresholds_str;
 
 static GOptionEntry entries[] = {
     { "signal-setup", 0, 0, G_OPTION_ARG_STRING, &setup_str,
       "Setup extended signal information retrieval",
       "[Rate]"
     },
+    { "signal-setup-thresholds", 0, 0, G_OPTION_ARG_STRING, &setup_thresholds_str,
+      "Setup hysteresis thresholds of the extended signal information",
+      "[\"key=value,...\"]"
+    },
     { "signal-get", 0, 0, G_OPTION_ARG_NONE, &get_flag,
       "Get all extended signal quality information",
       NULL
@@ -84,6 +89,7 @@ mmcli_modem_signal_options_enabled (void)
         return !!n_actions;
 
     n_actions = (!!setup_str +
+                 !!setup_thresholds_str +
                  get_flag);
 
     if (n_actions > 1) {
@@ -222,6 +228,67 @@ setup_ready (MMModemSignal *modem,
     mmcli_async_operation_done ();
 }
 
+static gboolean
+thresholds_parse_foreach (const gchar     *key,
+                          const gchar     *value,
+                          GVariantBuilder *builder)
+{
+    gdouble threshold;
+
+    if (!mm_get_double_from_str (value, &threshold)) {
+        g_printerr ("error: invalid threshold value '%s' for '%s'\n", value, key);
+        return FALSE;
+    }
+
+    g_variant_builder_add (builder, "{sv}", key, g_variant_new_double (threshold));
+    return TRUE;
+}
+
+static GVariant *
+build_thresholds (void)
+{
+    GVariantBuilder builder;
+    GError *error = NULL;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    if (!mm_common_parse_key_value_string (setup_thresholds_str,
+                                           &error,
+                                           (MMParseKeyValueForeachFn)thresholds_parse_foreach,
+                                           &builder)) {
+        if (error)
+            g_printerr ("error: couldn't parse thresholds: '%s'\n", error->message);
+        exit (EXIT_FAILURE);
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
+static void
+setup_thresholds_process_reply (gboolean      result,
+                                const GError *error)
+{
+    if (!result) {
+        g_printerr ("error: couldn't setup extended signal information thresholds: '%s'\n",
+                    error ? error->message : "unknown error");
+        exit (EXIT_FAILURE);
+    }
+
+    g_print ("Successfully setup extended signal information thresholds\n");
+}
+
+static void
+setup_thresholds_ready (MMModemSignal *modem,
+                        GAsyncResult  *result)
+{
+    gboolean res;
+    GError *error = NULL;
+
+    res = mm_modem_signal_setup_thresholds_finish (modem, result, &error);
+    setup_thresholds_process_reply (res, error);
+
+    mmcli_async_operation_done ();
+}
+
 static void
 get_modem_ready (GObject      *source,
                  GAsyncResult *result)
@@ -256,6 +323,17 @@ get_modem_ready (GObject      *source,
         return;
     }
 
+    /* Request to setup thresholds? */
+    if (setup_thresholds_str) {
+        g_debug ("Asynchronously setting up extended signal quality information thresholds...");
+        mm_modem_signal_setup_thresholds (ctx->modem_signal,
+                                          build_thresholds (),
+                                          ctx->cancellable,
+                                          (GAsyncReadyCallback)setup_thresholds_ready,
+                                          NULL);
+        return;
+    }
+
     g_warn_if_reached ();
 }
 
@@ -319,6 +397,19 @@ mmcli_modem_signal_run_synchronous (GDBusConnection *connection)
         return;
     }
 
+    /* Request to setup thresholds? */
+    if (setup_thresholds_str) {
+        gboolean result;
+
+        g_debug ("Synchronously setting up extended signal quality information thresholds...");
+        result = mm_modem_signal_setup_thresholds_sync (ctx->modem_signal,
+                                                        build_thresholds (),
+                                                        NULL,
+                                                        &error);
+        setup_thresholds_process_reply (result, error);
+        return;
+    }
+
 
     g_warn_if_reached ();
 }
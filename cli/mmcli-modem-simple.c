@@ -454,3 +454,115 @@ mmcli_modem_simple_run_synchronous (GDBusConnection *connection)
 
     g_warn_if_reached ();
 }
+
+/*****************************************************************************/
+/* Batch operations */
+
+gboolean
+mmcli_modem_simple_batch_supported (void)
+{
+    /* Validate the connection settings once, before touching any modem */
+    if (connect_str) {
+        GError *error = NULL;
+        MMSimpleConnectProperties *properties;
+
+        properties = mm_simple_connect_properties_new_from_string (connect_str, &error);
+        if (!properties) {
+            g_printerr ("Error parsing connect string: '%s'\n", error->message);
+            exit (EXIT_FAILURE);
+        }
+        g_object_unref (properties);
+    }
+
+    return (!!connect_str || disconnect_flag);
+}
+
+static void
+batch_ready (MMModemSimple      *modem_simple,
+             GAsyncResult       *res,
+             GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (connect_str) {
+        MMBearer *bearer;
+
+        bearer = mm_modem_simple_connect_finish (modem_simple, res, &error);
+        if (bearer) {
+            /* The bearer path is the output */
+            g_simple_async_result_set_op_res_gpointer (simple,
+                                                       g_strdup (mm_bearer_get_path (bearer)),
+                                                       g_free);
+            g_object_unref (bearer);
+        }
+    } else
+        mm_modem_simple_disconnect_finish (modem_simple, res, &error);
+
+    if (error)
+        g_simple_async_result_take_error (simple, error);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+void
+mmcli_modem_simple_batch_run (MMObject            *object,
+                              GCancellable        *cancellable,
+                              GAsyncReadyCallback  callback,
+                              gpointer             user_data)
+{
+    GSimpleAsyncResult *simple;
+    MMModemSimple *modem_simple;
+
+    simple = g_simple_async_result_new (G_OBJECT (object),
+                                        callback,
+                                        user_data,
+                                        mmcli_modem_simple_batch_run);
+
+    modem_simple = mm_object_peek_modem_simple (object);
+    if (!modem_simple) {
+        g_simple_async_result_set_error (simple,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_UNSUPPORTED,
+                                         "Simple interface not available");
+        g_simple_async_result_complete_in_idle (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    mmcli_force_operation_timeout (G_DBUS_PROXY (modem_simple));
+
+    if (connect_str) {
+        GError *error = NULL;
+        MMSimpleConnectProperties *properties;
+
+        /* Already validated in mmcli_modem_simple_batch_supported() */
+        properties = mm_simple_connect_properties_new_from_string (connect_str, &error);
+        g_assert_no_error (error);
+        mm_modem_simple_connect (modem_simple,
+                                 properties,
+                                 cancellable,
+                                 (GAsyncReadyCallback)batch_ready,
+                                 simple);
+        g_object_unref (properties);
+        return;
+    }
+
+    mm_modem_simple_disconnect (modem_simple,
+                                NULL,
+                                cancellable,
+                                (GAsyncReadyCallback)batch_ready,
+                                simple);
+}
+
+gboolean
+mmcli_modem_simple_batch_finish (GAsyncResult  *res,
+                                 gchar        **output,
+                                 GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return FALSE;
+
+    if (output)
+        *output = g_strdup (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+    return TRUE;
+}
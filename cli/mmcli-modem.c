@@ -1469,3 +1469,122 @@ mmcli_modem_run_synchronous (GDBusConnection *connection)
 
     g_warn_if_reached ();
 }
+
+/*****************************************************************************/
+/* Batch operations */
+
+gboolean
+mmcli_modem_batch_supported (void)
+{
+    return (info_flag ||
+            enable_flag ||
+            disable_flag ||
+            set_power_state_on_flag ||
+            set_power_state_low_flag ||
+            set_power_state_off_flag ||
+            reset_flag ||
+            !!factory_reset_str ||
+            !!command_str);
+}
+
+static void
+batch_ready (MMModem            *modem,
+             GAsyncResult       *res,
+             GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+    gchar *output = NULL;
+    gboolean success;
+
+    if (enable_flag)
+        success = mm_modem_enable_finish (modem, res, &error);
+    else if (disable_flag)
+        success = mm_modem_disable_finish (modem, res, &error);
+    else if (reset_flag)
+        success = mm_modem_reset_finish (modem, res, &error);
+    else if (factory_reset_str)
+        success = mm_modem_factory_reset_finish (modem, res, &error);
+    else if (command_str) {
+        output = mm_modem_command_finish (modem, res, &error);
+        success = !!output;
+    } else
+        success = mm_modem_set_power_state_finish (modem, res, &error);
+
+    if (!success)
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple, output, g_free);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+void
+mmcli_modem_batch_run (MMObject            *object,
+                       GCancellable        *cancellable,
+                       GAsyncReadyCallback  callback,
+                       gpointer             user_data)
+{
+    GSimpleAsyncResult *simple;
+    MMModem *modem;
+
+    simple = g_simple_async_result_new (G_OBJECT (object),
+                                        callback,
+                                        user_data,
+                                        mmcli_modem_batch_run);
+
+    modem = mm_object_peek_modem (object);
+    if (!modem) {
+        g_simple_async_result_set_error (simple,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_UNSUPPORTED,
+                                         "modem interface not available");
+        g_simple_async_result_complete_in_idle (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    mmcli_force_operation_timeout (G_DBUS_PROXY (modem));
+
+    /* Only the state is given for each modem, the full info isn't
+     * machine-parsable */
+    if (info_flag) {
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   g_strdup (mm_modem_state_get_string (mm_modem_get_state (modem))),
+                                                   g_free);
+        g_simple_async_result_complete_in_idle (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    if (enable_flag)
+        mm_modem_enable (modem, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (disable_flag)
+        mm_modem_disable (modem, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (set_power_state_on_flag)
+        mm_modem_set_power_state (modem, MM_MODEM_POWER_STATE_ON, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (set_power_state_low_flag)
+        mm_modem_set_power_state (modem, MM_MODEM_POWER_STATE_LOW, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (set_power_state_off_flag)
+        mm_modem_set_power_state (modem, MM_MODEM_POWER_STATE_OFF, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (reset_flag)
+        mm_modem_reset (modem, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (factory_reset_str)
+        mm_modem_factory_reset (modem, factory_reset_str, cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else if (command_str)
+        mm_modem_command (modem, command_str, command_get_timeout (modem), cancellable, (GAsyncReadyCallback)batch_ready, simple);
+    else
+        g_assert_not_reached ();
+}
+
+gboolean
+mmcli_modem_batch_finish (GAsyncResult  *res,
+                          gchar        **output,
+                          GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return FALSE;
+
+    if (output)
+        *output = g_strdup (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+    return TRUE;
+}
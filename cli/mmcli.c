@@ -181,6 +181,7 @@ main (gint argc, gchar **argv)
     GDBusConnection *connection;
     GOptionContext *context;
     GError *error = NULL;
+    gint status = EXIT_SUCCESS;
 
     setlocale (LC_ALL, "");
 
@@ -249,8 +250,34 @@ main (gint argc, gchar **argv)
     cancellable = g_cancellable_new ();
     loop = g_main_loop_new (NULL, FALSE);
 
+    /* Action on several modems? */
+    if (mmcli_batch_options_enabled ()) {
+        if (mmcli_manager_options_enabled () ||
+            mmcli_sim_options_enabled () ||
+            mmcli_bearer_options_enabled () ||
+            mmcli_sms_options_enabled () ||
+            mmcli_call_options_enabled () ||
+            mmcli_modem_3gpp_options_enabled () ||
+            mmcli_modem_cdma_options_enabled () ||
+            mmcli_modem_location_options_enabled () ||
+            mmcli_modem_messaging_options_enabled () ||
+            mmcli_modem_voice_options_enabled () ||
+            mmcli_modem_time_options_enabled () ||
+            mmcli_modem_firmware_options_enabled () ||
+            mmcli_modem_signal_options_enabled () ||
+            mmcli_modem_oma_options_enabled ()) {
+            g_printerr ("error: action not supported on several modems at once\n");
+            exit (EXIT_FAILURE);
+        }
+
+        /* Checked before forcing async, as some modem actions force sync */
+        mmcli_modem_simple_options_enabled ();
+        mmcli_modem_options_enabled ();
+        mmcli_force_async_operation ();
+        mmcli_batch_run_asynchronous (connection, cancellable);
+    }
     /* Manager options? */
-    if (mmcli_manager_options_enabled ()) {
+    else if (mmcli_manager_options_enabled ()) {
         /* Ensure options from different groups are not enabled */
         if (mmcli_modem_options_enabled ()) {
             g_printerr ("error: cannot use manager and modem options "
@@ -381,7 +408,10 @@ main (gint argc, gchar **argv)
     if (async_flag)
         g_main_loop_run (loop);
 
-    if (mmcli_manager_options_enabled ()) {
+    if (mmcli_batch_options_enabled ()) {
+        if (!mmcli_batch_shutdown ())
+            status = EXIT_FAILURE;
+    } else if (mmcli_manager_options_enabled ()) {
         mmcli_manager_shutdown ();
     } else if (mmcli_modem_3gpp_options_enabled ()) {
         mmcli_modem_3gpp_shutdown ();
@@ -420,5 +450,5 @@ main (gint argc, gchar **argv)
     g_main_loop_unref (loop);
     g_object_unref (connection);
 
-    return EXIT_SUCCESS;
+    return status;
 }
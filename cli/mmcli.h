@@ -44,6 +44,20 @@ void          mmcli_modem_run_asynchronous   (GDBusConnection *connection,
                                               GCancellable    *cancellable);
 void          mmcli_modem_run_synchronous    (GDBusConnection *connection);
 void          mmcli_modem_shutdown           (void);
+gboolean      mmcli_modem_batch_supported    (void);
+void          mmcli_modem_batch_run          (MMObject            *object,
+                                              GCancellable        *cancellable,
+                                              GAsyncReadyCallback  callback,
+                                              gpointer             user_data);
+gboolean      mmcli_modem_batch_finish       (GAsyncResult  *res,
+                                              gchar        **output,
+                                              GError       **error);
+
+/* Batch of modems */
+gboolean      mmcli_batch_options_enabled    (void);
+void          mmcli_batch_run_asynchronous   (GDBusConnection *connection,
+                                              GCancellable    *cancellable);
+gboolean      mmcli_batch_shutdown           (void);
 
 /* 3GPP group */
 GOptionGroup *mmcli_modem_3gpp_get_option_group   (void);
@@ -68,6 +82,14 @@ void          mmcli_modem_simple_run_asynchronous   (GDBusConnection *connection
                                                      GCancellable    *cancellable);
 void          mmcli_modem_simple_run_synchronous    (GDBusConnection *connection);
 void          mmcli_modem_simple_shutdown           (void);
+gboolean      mmcli_modem_simple_batch_supported    (void);
+void          mmcli_modem_simple_batch_run          (MMObject            *object,
+                                                     GCancellable        *cancellable,
+                                                     GAsyncReadyCallback  callback,
+                                                     gpointer             user_data);
+gboolean      mmcli_modem_simple_batch_finish       (GAsyncResult  *res,
+                                                     gchar        **output,
+                                                     GError       **error);
 
 /* Location group */
 GOptionGroup *mmcli_modem_location_get_option_group   (void);
@@ -0,0 +1,126 @@
+/*
+ * ModemManager Interface Specification
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef _MODEM_MANAGER_STATUS_H_
+#define _MODEM_MANAGER_STATUS_H_
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Layout of the status segment, a file published by the daemon when started
+ * with --status-segment=PATH, to be mapped read-only by clients that poll the
+ * latest state of the modems at high rates without any IPC.
+ *
+ * The file is a MMStatusSegmentHeader followed by n_records MMStatusRecord
+ * entries, one per modem, in host byte order. Each record is protected by
+ * its own sequence counter (a seqlock): the daemon makes it odd while
+ * updating the record and even again once done, so readers must retry if
+ * the counter is odd or changes while they copy the record, as
+ * mm_status_record_read() does.
+ *
+ * Records not in use have in_use set to 0. A record is reused for a new
+ * modem once the previous one is gone, so modem_index must be checked
+ * after every read.
+ *
+ * The file is never truncated in place. When more records are needed the
+ * daemon writes a larger file next to it and renames it over the path,
+ * keeping every modem in the same record; then it sets replaced to 1 in the
+ * header of the previous file. Readers must check replaced and, once set,
+ * map the path again. Readers that keep the previous mapping just see
+ * stale values, never a truncated file.
+ */
+
+#define MM_STATUS_SEGMENT_MAGIC        0x5453454dU /* "MEST" */
+#define MM_STATUS_SEGMENT_VERSION      2
+/* Records in a new segment; the segment grows as more modems show up */
+#define MM_STATUS_SEGMENT_MIN_RECORDS  16
+#define MM_STATUS_RECORD_MAX_BEARERS   4
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_records;
+    uint32_t record_size;
+    /* 1 once a new file has been published at the same path */
+    uint32_t replaced;
+    uint32_t reserved;
+} MMStatusSegmentHeader;
+
+typedef struct {
+    /* Number at the end of the bearer object path */
+    uint32_t bearer_index;
+    /* 1 if connected, 0 otherwise */
+    uint32_t connected;
+} MMStatusBearer;
+
+typedef struct {
+    /* Odd while being updated */
+    uint32_t sequence;
+    uint32_t in_use;
+    /* Number at the end of the modem object path */
+    uint32_t modem_index;
+    /* MMModemState */
+    int32_t  state;
+    /* MMModemAccessTechnology mask */
+    uint32_t access_technologies;
+    /* Signal quality percentage, and whether it is recent */
+    uint32_t signal_quality;
+    uint32_t signal_quality_recent;
+    /* MMModem3gppRegistrationState, 0 (idle) for non-3GPP modems */
+    uint32_t registration_state;
+    /* NUL-terminated, empty if unknown */
+    char     operator_code[8];
+    char     operator_name[64];
+    uint32_t n_bearers;
+    MMStatusBearer bearers[MM_STATUS_RECORD_MAX_BEARERS];
+    /* Incremented on every update */
+    uint64_t updates;
+} MMStatusRecord;
+
+/* Copies a consistent snapshot of 'shared' into 'copy' */
+static __inline__ void
+mm_status_record_read (const MMStatusRecord *shared,
+                       MMStatusRecord       *copy)
+{
+    uint32_t before;
+    uint32_t after;
+
+    do {
+        before = __atomic_load_n (&shared->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1)
+            continue;
+        memcpy (copy, (const void *) shared, sizeof (*copy));
+        __atomic_thread_fence (__ATOMIC_ACQUIRE);
+        after = __atomic_load_n (&shared->sequence, __ATOMIC_RELAXED);
+        if (before == after)
+            break;
+    } while (1);
+}
+
+/* Non-zero if the mapped segment is no longer the one published at the path */
+static __inline__ int
+mm_status_segment_is_replaced (const MMStatusSegmentHeader *header)
+{
+    return __atomic_load_n (&header->replaced, __ATOMIC_ACQUIRE) != 0;
+}
+
+#endif /* _MODEM_MANAGER_STATUS_H_ */
@@ -676,6 +676,43 @@ mm_bearer_properties_cmp (MMBearerProperties *a,
 
 /*****************************************************************************/
 
+/* Strings are length-prefixed so that no value can be mistaken for the next
+ * one, and NULL is kept different from the empty string */
+static void
+key_append_string (GString     *key,
+                   const gchar *str)
+{
+    if (!str)
+        g_string_append_c (key, '-');
+    else
+        g_string_append_printf (key, "%" G_GSIZE_FORMAT ":%s", strlen (str), str);
+}
+
+/* Two keys are equal if and only if mm_bearer_properties_cmp() says the
+ * properties are, so they may be used to index bearers by properties */
+gchar *
+mm_bearer_properties_build_key (MMBearerProperties *self)
+{
+    GString *key;
+
+    g_return_val_if_fail (MM_IS_BEARER_PROPERTIES (self), NULL);
+
+    key = g_string_new (NULL);
+    g_string_append_printf (key, "%u,%u,%d,%d,%u,",
+                            (guint) self->priv->ip_type,
+                            (guint) self->priv->allowed_auth,
+                            self->priv->allow_roaming,
+                            self->priv->allow_roaming_set,
+                            (guint) self->priv->rm_protocol);
+    key_append_string (key, self->priv->apn);
+    key_append_string (key, self->priv->number);
+    key_append_string (key, self->priv->user);
+    key_append_string (key, self->priv->password);
+    return g_string_free (key, FALSE);
+}
+
+/*****************************************************************************/
+
 /**
  * mm_bearer_properties_new:
  *
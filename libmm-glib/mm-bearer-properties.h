@@ -112,6 +112,8 @@ GVariant *mm_bearer_properties_get_dictionary (MMBearerProperties *self);
 gboolean mm_bearer_properties_cmp (MMBearerProperties *a,
                                    MMBearerProperties *b);
 
+gchar *mm_bearer_properties_build_key (MMBearerProperties *self);
+
 #endif
 
 G_END_DECLS
@@ -1567,42 +1567,114 @@ mm_sms_delivery_state_get_string_extended (guint delivery_state)
 
 /*****************************************************************************/
 
-/* From hostap, Copyright (c) 2002-2005, Jouni Malinen <jkmaline@cc.hut.fi> */
-
-static gint
-hex2num (gchar c)
-{
-    if (c >= '0' && c <= '9')
-        return c - '0';
-    if (c >= 'a' && c <= 'f')
-        return c - 'a' + 10;
-    if (c >= 'A' && c <= 'F')
-        return c - 'A' + 10;
-    return -1;
-}
+/* Value of each hex digit, 0xFF for any other character */
+static const guint8 hex_values[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+/* Uppercase hex representation of each byte value */
+static const gchar hex_pairs[] =
+    "000102030405060708090A0B0C0D0E0F"
+    "101112131415161718191A1B1C1D1E1F"
+    "202122232425262728292A2B2C2D2E2F"
+    "303132333435363738393A3B3C3D3E3F"
+    "404142434445464748494A4B4C4D4E4F"
+    "505152535455565758595A5B5C5D5E5F"
+    "606162636465666768696A6B6C6D6E6F"
+    "707172737475767778797A7B7C7D7E7F"
+    "808182838485868788898A8B8C8D8E8F"
+    "909192939495969798999A9B9C9D9E9F"
+    "A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+    "B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+    "C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+    "D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+    "E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+    "F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
 
 gint
 mm_utils_hex2byte (const gchar *hex)
 {
-    gint a, b;
+    guint8 a, b;
 
-    a = hex2num (*hex++);
-    if (a < 0)
+    a = hex_values[(guint8) hex[0]];
+    if (a == 0xFF)
         return -1;
-    b = hex2num (*hex++);
-    if (b < 0)
+    b = hex_values[(guint8) hex[1]];
+    if (b == 0xFF)
         return -1;
     return (a << 4) | b;
 }
 
+/* Invalid digits have the upper bits set in the table, so the digits of a
+ * whole block are accumulated and checked once */
+#define HEX_DECODE(k)                                    \
+    do {                                                 \
+        guint8 h = hex_values[in[2 * (k)]];              \
+        guint8 l = hex_values[in[2 * (k) + 1]];          \
+                                                         \
+        invalid |= h | l;                                \
+        bin[i + (k)] = (guint8) ((h << 4) | (l & 0x0F)); \
+    } while (0)
+
+gssize
+mm_utils_hexstr2bin_into (const gchar *hex,
+                          gsize        hex_len,
+                          guint8      *bin,
+                          gsize        bin_size)
+{
+    const guint8 *in = (const guint8 *) hex;
+    guint8 invalid = 0;
+    gsize n;
+    gsize i = 0;
+
+    /* Length must be a multiple of 2 */
+    if (hex_len % 2 != 0)
+        return -1;
+    n = hex_len / 2;
+    if (n > bin_size)
+        return -1;
+
+    /* 8 bytes per iteration */
+    for (; i + 8 <= n; i += 8, in += 16) {
+        HEX_DECODE (0);
+        HEX_DECODE (1);
+        HEX_DECODE (2);
+        HEX_DECODE (3);
+        HEX_DECODE (4);
+        HEX_DECODE (5);
+        HEX_DECODE (6);
+        HEX_DECODE (7);
+        if (invalid & 0xF0)
+            return -1;
+    }
+
+    for (; i < n; i++, in += 2)
+        HEX_DECODE (0);
+
+    return (invalid & 0xF0) ? -1 : (gssize) n;
+}
+
+#undef HEX_DECODE
+
 gchar *
 mm_utils_hexstr2bin (const gchar *hex, gsize *out_len)
 {
-    const gchar *ipos = hex;
-    gchar *buf = NULL;
-    gsize i;
-    gint a;
-    gchar *opos;
+    gchar *buf;
     gsize len;
 
     len = strlen (hex);
@@ -1610,22 +1682,16 @@ mm_utils_hexstr2bin (const gchar *hex, gsize *out_len)
     /* Length must be a multiple of 2 */
     g_return_val_if_fail ((len % 2) == 0, NULL);
 
-    opos = buf = g_malloc0 ((len / 2) + 1);
-    for (i = 0; i < len; i += 2) {
-        a = mm_utils_hex2byte (ipos);
-        if (a < 0) {
-            g_free (buf);
-            return NULL;
-        }
-        *opos++ = a;
-        ipos += 2;
+    buf = g_malloc ((len / 2) + 1);
+    if (mm_utils_hexstr2bin_into (hex, len, (guint8 *) buf, len / 2) < 0) {
+        g_free (buf);
+        return NULL;
     }
+    buf[len / 2] = '\0';
     *out_len = len / 2;
     return buf;
 }
 
-/* End from hostap */
-
 gboolean
 mm_utils_ishexstr (const gchar *hex)
 {
@@ -1639,30 +1705,52 @@ mm_utils_ishexstr (const gchar *hex)
 
     for (i = 0; i < len; i++) {
         /* Non-hex char? */
-        if (hex[i] >= '0' && hex[i] <= '9')
-            continue;
-        if (hex[i] >= 'a' && hex[i] <= 'f')
-            continue;
-        if (hex[i] >= 'A' && hex[i] <= 'F')
-            continue;
-        return FALSE;
+        if (hex_values[(guint8) hex[i]] == 0xFF)
+            return FALSE;
     }
 
     return TRUE;
 }
 
+#define HEX_ENCODE(k) memcpy (hex + 2 * (i + (k)), hex_pairs + 2 * bin[i + (k)], 2)
+
+void
+mm_utils_bin2hexstr_into (const guint8 *bin,
+                          gsize         len,
+                          gchar        *hex)
+{
+    gsize i = 0;
+
+    /* 8 bytes per iteration */
+    for (; i + 8 <= len; i += 8) {
+        HEX_ENCODE (0);
+        HEX_ENCODE (1);
+        HEX_ENCODE (2);
+        HEX_ENCODE (3);
+        HEX_ENCODE (4);
+        HEX_ENCODE (5);
+        HEX_ENCODE (6);
+        HEX_ENCODE (7);
+    }
+
+    for (; i < len; i++)
+        HEX_ENCODE (0);
+
+    hex[2 * len] = '\0';
+}
+
+#undef HEX_ENCODE
+
 gchar *
 mm_utils_bin2hexstr (const guint8 *bin, gsize len)
 {
-    GString *ret;
-    gsize i;
+    gchar *ret;
 
     g_return_val_if_fail (bin != NULL, NULL);
 
-    ret = g_string_sized_new (len * 2 + 1);
-    for (i = 0; i < len; i++)
-        g_string_append_printf (ret, "%.2X", bin[i]);
-    return g_string_free (ret, FALSE);
+    ret = g_malloc (len * 2 + 1);
+    mm_utils_bin2hexstr_into (bin, len, ret);
+    return ret;
 }
 
 gboolean
@@ -163,6 +163,18 @@ gchar    *mm_utils_hexstr2bin (const gchar *hex, gsize *out_len);
 gchar    *mm_utils_bin2hexstr (const guint8 *bin, gsize len);
 gboolean  mm_utils_ishexstr   (const gchar *hex);
 
+/* Same conversions into caller-provided buffers. hexstr2bin_into() returns the
+ * number of bytes written, or -1 if the string isn't valid hex or doesn't fit
+ * in bin_size bytes; the output is not NUL-terminated. bin2hexstr_into() writes
+ * 2 * len uppercase characters plus a NUL terminator. */
+gssize    mm_utils_hexstr2bin_into (const gchar  *hex,
+                                    gsize         hex_len,
+                                    guint8       *bin,
+                                    gsize         bin_size);
+void      mm_utils_bin2hexstr_into (const guint8 *bin,
+                                    gsize         len,
+                                    gchar        *hex);
+
 gboolean  mm_utils_check_for_single_value (guint32 value);
 
 #endif /* MM_COMMON_HELPERS_H */
@@ -45,4 +45,20 @@
  */
 #define MM_LOCATION_ALTITUDE_UNKNOWN  G_MINDOUBLE
 
+/**
+ * MM_LOCATION_SPEED_UNKNOWN:
+ *
+ * Identifier for an unknown speed value.
+ */
+#define MM_LOCATION_SPEED_UNKNOWN     G_MINDOUBLE
+
+/**
+ * MM_LOCATION_COURSE_UNKNOWN:
+ *
+ * Identifier for an unknown course value.
+ *
+ * Proper course values fall in the [0,360) range.
+ */
+#define MM_LOCATION_COURSE_UNKNOWN    G_MINDOUBLE
+
 #endif /* MM_LOCATION_COMMON_H */
@@ -17,7 +17,6 @@
 #include <ctype.h>
 #include <stdlib.h>
 
-#include "mm-common-helpers.h"
 #include "mm-errors-types.h"
 #include "mm-location-gps-nmea.h"
 
@@ -36,89 +35,140 @@
 
 G_DEFINE_TYPE (MMLocationGpsNmea, mm_location_gps_nmea, G_TYPE_OBJECT);
 
+/* Each trace type has a slot in the full string, which is patched in place
+ * when the trace changes, so that building the full string doesn't require
+ * joining all the traces again */
+typedef struct {
+    gchar    *trace_type;
+    GString  *trace;
+    /* Position and length of the trace in the full string */
+    gsize     offset;
+    gsize     len;
+    gboolean  dirty;
+} Slot;
+
 struct _MMLocationGpsNmeaPrivate {
+    /* Trace type -> Slot */
     GHashTable *traces;
-    GRegex *sequence_regex;
+    /* Slots, in the order they are found in the full string */
+    GPtrArray *slots;
+    GString *full;
+    gboolean dirty;
+    /* 0 if unbounded */
+    guint max_traces;
+    gsize max_trace_size;
 };
 
 /*****************************************************************************/
 
+static void
+slot_free (Slot *slot)
+{
+    g_free (slot->trace_type);
+    g_string_free (slot->trace, TRUE);
+    g_slice_free (Slot, slot);
+}
+
+/* Traces that are part of a sequence (e.g. "$GPGSV,<total>,<index>,...")
+ * are appended to the previous ones, unless they are the first one */
 static gboolean
-check_append_or_replace (MMLocationGpsNmea *self,
-                         const gchar *trace)
+is_sequence_continuation (const gchar *trace)
 {
-    /* By default, replace */
-    gboolean append_or_replace = FALSE;
-    GMatchInfo *match_info = NULL;
-
-    if (G_UNLIKELY (!self->priv->sequence_regex))
-        self->priv->sequence_regex = g_regex_new ("\\$GPGSV,(\\d),(\\d).*",
-                                                  G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                                                  0,
-                                                  NULL);
-
-    if (g_regex_match (self->priv->sequence_regex, trace, 0, &match_info)) {
-        guint index;
-
-        /* If we don't have the first element of a sequence, append */
-        if (mm_get_uint_from_match_info (match_info, 2, &index) && index != 1)
-            append_or_replace = TRUE;
-    }
-    g_match_info_free (match_info);
+    if (!g_str_has_prefix (trace, "$GPGSV,"))
+        return FALSE;
 
-    return append_or_replace;
+    trace += strlen ("$GPGSV,");
+    return (g_ascii_isdigit (trace[0]) &&
+            trace[1] == ',' &&
+            g_ascii_isdigit (trace[2]) &&
+            trace[2] != '1');
 }
 
 static gboolean
-location_gps_nmea_take_trace (MMLocationGpsNmea *self,
-                              gchar *trace)
+location_gps_nmea_add_trace (MMLocationGpsNmea *self,
+                             const gchar *trace)
 {
-    gchar *i;
+    const gchar *i;
+    gchar trace_type_buffer[16];
     gchar *trace_type;
+    Slot *slot;
+    gboolean updated = TRUE;
 
     i = strchr (trace, ',');
     if (!i || i == trace)
         return FALSE;
 
-    trace_type = g_malloc (i - trace + 1);
-    memcpy (trace_type, trace, i - trace);
-    trace_type[i - trace] = '\0';
-
-    /* Some traces are part of a SEQUENCE; so we need to decide whether we
-     * completely replace the previous trace, or we append the new one to
-     * the already existing list */
-    if (check_append_or_replace (self, trace)) {
-        /* Append */
-        const gchar *previous;
-
-        previous = g_hash_table_lookup (self->priv->traces, trace_type);
-        if (previous) {
-            gchar *sequence;
-
-            /* Skip the trace if we already have it there */
-            if (strstr (previous, trace))
-                return TRUE;
-
-            sequence = g_strdup_printf ("%s%s%s",
-                                        previous,
-                                        g_str_has_suffix (previous, "\r\n") ? "" : "\r\n",
-                                        trace);
-            g_free (trace);
-            trace = sequence;
-        }
+    if (self->priv->max_trace_size && strlen (trace) > self->priv->max_trace_size)
+        return FALSE;
+
+    /* Usual trace types (e.g. "$GPGGA") fit in the buffer */
+    if ((gsize) (i - trace) < sizeof (trace_type_buffer)) {
+        memcpy (trace_type_buffer, trace, i - trace);
+        trace_type_buffer[i - trace] = '\0';
+        trace_type = trace_type_buffer;
+    } else
+        trace_type = g_strndup (trace, i - trace);
+
+    slot = g_hash_table_lookup (self->priv->traces, trace_type);
+    if (!slot && self->priv->max_traces && self->priv->slots->len >= self->priv->max_traces) {
+        /* No room for more trace types */
+        updated = FALSE;
+        goto out;
     }
 
-    g_hash_table_replace (self->priv->traces,
-                          trace_type,
-                          trace);
-    return TRUE;
+    if (!slot) {
+        /* New slots go at the end of the full string */
+        slot = g_slice_new0 (Slot);
+        slot->trace_type = (trace_type == trace_type_buffer ? g_strdup (trace_type) : trace_type);
+        slot->trace = g_string_new (trace);
+        slot->offset = self->priv->full->len;
+        g_ptr_array_add (self->priv->slots, slot);
+        g_hash_table_insert (self->priv->traces, slot->trace_type, slot);
+        trace_type = NULL;
+    } else if (is_sequence_continuation (trace)) {
+        /* Skip the trace if we already have it there */
+        if (strstr (slot->trace->str, trace))
+            goto out;
+
+        /* Or if the sequence got too long */
+        if (self->priv->max_trace_size &&
+            slot->trace->len + 2 + strlen (trace) > self->priv->max_trace_size) {
+            updated = FALSE;
+            goto out;
+        }
+
+        if (!g_str_has_suffix (slot->trace->str, "\r\n"))
+            g_string_append (slot->trace, "\r\n");
+        g_string_append (slot->trace, trace);
+    } else
+        g_string_assign (slot->trace, trace);
+
+    slot->dirty = TRUE;
+    self->priv->dirty = TRUE;
+
+out:
+    if (trace_type != trace_type_buffer)
+        g_free (trace_type);
+    return updated;
 }
 
 gboolean
 mm_location_gps_nmea_add_trace (MMLocationGpsNmea *self,
                                 const gchar *trace)
 {
-    return location_gps_nmea_take_trace (self, g_strdup (trace));
+    return location_gps_nmea_add_trace (self, trace);
+}
+
+void
+mm_location_gps_nmea_set_limits (MMLocationGpsNmea *self,
+                                 guint max_traces,
+                                 gsize max_trace_size)
+{
+    g_return_if_fail (MM_IS_LOCATION_GPS_NMEA (self));
+
+    /* Only applies to the traces added afterwards */
+    self->priv->max_traces = max_traces;
+    self->priv->max_trace_size = max_trace_size;
 }
 
 /*****************************************************************************/
@@ -136,20 +186,56 @@ const gchar *
 mm_location_gps_nmea_get_trace (MMLocationGpsNmea *self,
                                 const gchar *trace_type)
 {
-    return (const gchar *)g_hash_table_lookup (self->priv->traces, trace_type);
+    Slot *slot;
+
+    slot = g_hash_table_lookup (self->priv->traces, trace_type);
+    return (slot ? slot->trace->str : NULL);
 }
 
 /*****************************************************************************/
 
 static void
-build_full_foreach (const gchar *trace_type,
-                    const gchar *trace,
-                    GString **built)
+full_update (MMLocationGpsNmea *self)
 {
-    if ((*built)->len == 0 || g_str_has_suffix ((*built)->str, "\r\n"))
-        g_string_append (*built, trace);
-    else
-        g_string_append_printf (*built, "\r\n%s", trace);
+    gssize shift = 0;
+    guint i;
+
+    if (!self->priv->dirty)
+        return;
+
+    for (i = 0; i < self->priv->slots->len; i++) {
+        Slot *slot;
+        gsize len;
+
+        slot = g_ptr_array_index (self->priv->slots, i);
+        slot->offset += shift;
+        if (!slot->dirty)
+            continue;
+
+        /* Every trace in the full string is terminated with <CR><LF> */
+        len = slot->trace->len;
+        if (!g_str_has_suffix (slot->trace->str, "\r\n"))
+            len += 2;
+
+        /* Traces of the same type usually keep the same length, so most of
+         * the time there's no need to move the rest of the string */
+        if (len == slot->len) {
+            g_string_overwrite_len (self->priv->full, slot->offset, slot->trace->str, slot->trace->len);
+            if (len > slot->trace->len)
+                g_string_overwrite_len (self->priv->full, slot->offset + slot->trace->len, "\r\n", 2);
+        } else {
+            g_string_erase (self->priv->full, slot->offset, slot->len);
+            g_string_insert_len (self->priv->full, slot->offset, slot->trace->str, slot->trace->len);
+            if (len > slot->trace->len)
+                g_string_insert_len (self->priv->full, slot->offset + slot->trace->len, "\r\n", 2);
+        }
+
+        shift += (gssize) len - (gssize) slot->len;
+        slot->len = len;
+        slot->dirty = FALSE;
+    }
+
+    self->priv->dirty = FALSE;
 }
 
 /**
@@ -163,13 +249,8 @@ build_full_foreach (const gchar *trace_type,
 gchar *
 mm_location_gps_nmea_build_full (MMLocationGpsNmea *self)
 {
-    GString *built;
-
-    built = g_string_new ("");
-    g_hash_table_foreach (self->priv->traces,
-                          (GHFunc)build_full_foreach,
-                          &built);
-    return g_string_free (built, FALSE);
+    full_update (self);
+    return g_strndup (self->priv->full->str, self->priv->full->len);
 }
 
 /*****************************************************************************/
@@ -178,13 +259,11 @@ GVariant *
 mm_location_gps_nmea_get_string_variant (MMLocationGpsNmea *self)
 {
     GVariant *variant = NULL;
-    gchar *built;
 
     g_return_val_if_fail (MM_IS_LOCATION_GPS_NMEA (self), NULL);
 
-    built = mm_location_gps_nmea_build_full (self);
-    variant = g_variant_new_string (built);
-    g_free (built);
+    full_update (self);
+    variant = g_variant_new_string (self->priv->full->str);
 
     return variant;
 }
@@ -221,14 +300,9 @@ mm_location_gps_nmea_new_from_string_variant (GVariant *string,
     /* Create new location object */
     self = mm_location_gps_nmea_new ();
 
-    for (i = 0; split[i]; i++) {
-        if (!location_gps_nmea_take_trace (self, split[i]))
-            g_free (split[i]);
-    }
-
-    /* Note that the strings in the array of strings were already taken
-     * or freed */
-    g_free (split);
+    for (i = 0; split[i]; i++)
+        location_gps_nmea_add_trace (self, split[i]);
+    g_strfreev (split);
 
     return self;
 }
@@ -249,10 +323,10 @@ mm_location_gps_nmea_init (MMLocationGpsNmea *self)
                                               MM_TYPE_LOCATION_GPS_NMEA,
                                               MMLocationGpsNmeaPrivate);
 
-    self->priv->traces = g_hash_table_new_full (g_str_hash,
-                                                g_str_equal,
-                                                g_free,
-                                                g_free);
+    /* Keys and values owned by the slots */
+    self->priv->traces = g_hash_table_new (g_str_hash, g_str_equal);
+    self->priv->slots = g_ptr_array_new_with_free_func ((GDestroyNotify) slot_free);
+    self->priv->full = g_string_new ("");
 }
 
 static void
@@ -261,8 +335,8 @@ finalize (GObject *object)
     MMLocationGpsNmea *self = MM_LOCATION_GPS_NMEA (object);
 
     g_hash_table_destroy (self->priv->traces);
-    if (self->priv->sequence_regex)
-        g_regex_unref (self->priv->sequence_regex);
+    g_ptr_array_unref (self->priv->slots);
+    g_string_free (self->priv->full, TRUE);
 
     G_OBJECT_CLASS (mm_location_gps_nmea_parent_class)->finalize (object);
 }
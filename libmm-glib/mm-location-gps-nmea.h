@@ -73,6 +73,12 @@ MMLocationGpsNmea *mm_location_gps_nmea_new_from_string_variant (GVariant *strin
 gboolean mm_location_gps_nmea_add_trace (MMLocationGpsNmea *self,
                                          const gchar *trace);
 
+/* Traces of new types beyond max_traces, and traces (or sequences of traces)
+ * longer than max_trace_size, are not stored; 0 for no limit */
+void mm_location_gps_nmea_set_limits (MMLocationGpsNmea *self,
+                                      guint max_traces,
+                                      gsize max_trace_size);
+
 GVariant *mm_location_gps_nmea_get_string_variant (MMLocationGpsNmea *self);
 
 #endif
@@ -40,14 +40,16 @@ G_DEFINE_TYPE (MMLocationGpsRaw, mm_location_gps_raw, G_TYPE_OBJECT);
 #define PROPERTY_LATITUDE  "latitude"
 #define PROPERTY_LONGITUDE "longitude"
 #define PROPERTY_ALTITUDE  "altitude"
+#define PROPERTY_SPEED     "speed"
+#define PROPERTY_COURSE    "course"
 
 struct _MMLocationGpsRawPrivate {
-    GRegex *gpgga_regex;
-
     gchar   *utc_time;
     gdouble  latitude;
     gdouble  longitude;
     gdouble  altitude;
+    gdouble  speed;
+    gdouble  course;
 };
 
 /*****************************************************************************/
@@ -127,118 +129,288 @@ mm_location_gps_raw_get_altitude (MMLocationGpsRaw *self)
 
 /*****************************************************************************/
 
+/**
+ * mm_location_gps_raw_get_speed:
+ * @self: a #MMLocationGpsRaw.
+ *
+ * Gets the speed over ground, in meters per second.
+ *
+ * Returns: the speed, or %MM_LOCATION_SPEED_UNKNOWN if unknown.
+ */
+gdouble
+mm_location_gps_raw_get_speed (MMLocationGpsRaw *self)
+{
+    g_return_val_if_fail (MM_IS_LOCATION_GPS_RAW (self),
+                          MM_LOCATION_SPEED_UNKNOWN);
+
+    return self->priv->speed;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_location_gps_raw_get_course:
+ * @self: a #MMLocationGpsRaw.
+ *
+ * Gets the course over ground, in degrees from true north, in the [0,360)
+ * range.
+ *
+ * Returns: the course, or %MM_LOCATION_COURSE_UNKNOWN if unknown.
+ */
+gdouble
+mm_location_gps_raw_get_course (MMLocationGpsRaw *self)
+{
+    g_return_val_if_fail (MM_IS_LOCATION_GPS_RAW (self),
+                          MM_LOCATION_COURSE_UNKNOWN);
+
+    return self->priv->course;
+}
+
+/*****************************************************************************/
+
+/* NMEA sentences are split in place, without copying any field */
+#define NMEA_MAX_FIELDS 20
+
+typedef struct {
+    const gchar *str;
+    gsize        len;
+} NmeaField;
+
+/* Values are parsed in fixed point, in units of 1e-9 */
+#define NMEA_FIXED_ONE G_GINT64_CONSTANT (1000000000)
+
+/* Meters per second in a knot */
+#define KNOT_MPS (1852.0 / 3600.0)
+
+/* Splits "$ttSSS,f1,f2,...*hh" at the commas, with the address "ttSSS" as
+ * field 0 and without the checksum; returns the number of fields */
+static guint
+nmea_split (const gchar *trace,
+            NmeaField   *fields)
+{
+    const gchar *p;
+    guint n = 0;
+
+    fields[0].str = trace + 1;
+    for (p = fields[0].str; ; p++) {
+        if (*p != ',' && *p != '*' && *p != '\0' && *p != '\r' && *p != '\n')
+            continue;
+
+        fields[n].len = p - fields[n].str;
+        if (++n == NMEA_MAX_FIELDS || *p != ',')
+            break;
+        fields[n].str = p + 1;
+    }
+    return n;
+}
+
+/* Decimal number without exponent, e.g. "-12.345"; decimals beyond the
+ * fixed point precision are ignored */
 static gboolean
-get_longitude_or_latitude_from_match_info (GMatchInfo *match_info,
-                                           guint32 match_index,
-                                           gdouble *out)
+nmea_parse_fixed (const NmeaField *field,
+                  gint64          *out)
 {
-    gchar *aux;
-    gchar *s;
-    gboolean ret = FALSE;
-    gdouble minutes;
-    gdouble degrees;
+    gint64 whole = 0;
+    gint64 fraction = 0;
+    gint64 unit = NMEA_FIXED_ONE;
+    gboolean negative = FALSE;
+    gboolean digits = FALSE;
+    gsize i = 0;
+
+    if (i < field->len && (field->str[i] == '-' || field->str[i] == '+'))
+        negative = (field->str[i++] == '-');
+
+    for (; i < field->len && g_ascii_isdigit (field->str[i]); i++) {
+        if (whole >= G_MAXINT64 / NMEA_FIXED_ONE / 10)
+            return FALSE;
+        whole = (whole * 10) + (field->str[i] - '0');
+        digits = TRUE;
+    }
 
-    s = g_match_info_fetch (match_info, match_index);
-    if (!s)
-        goto out;
+    if (i < field->len && field->str[i] == '.') {
+        for (i++; i < field->len && g_ascii_isdigit (field->str[i]); i++) {
+            if (unit > 1) {
+                unit /= 10;
+                fraction += (field->str[i] - '0') * unit;
+            }
+            digits = TRUE;
+        }
+    }
 
-    /* 4533.35 is 45 degrees and 33.35 minutes */
+    if (!digits || i != field->len)
+        return FALSE;
 
-    aux = strchr (s, '.');
-    if (!aux || ((aux - s) < 3))
-        goto out;
+    *out = (whole * NMEA_FIXED_ONE) + fraction;
+    if (negative)
+        *out = -*out;
+    return TRUE;
+}
 
-    aux -= 2;
-    if (!mm_get_double_from_str (aux, &minutes))
-        goto out;
+static gboolean
+nmea_parse_double (const NmeaField *field,
+                   gdouble         *out)
+{
+    gint64 fixed;
 
-    aux[0] = '\0';
-    if (!mm_get_double_from_str (s, &degrees))
-        goto out;
+    if (!nmea_parse_fixed (field, &fixed))
+        return FALSE;
+    *out = (gdouble) fixed / NMEA_FIXED_ONE;
+    return TRUE;
+}
+
+/* Latitude "ddmm.mm" or longitude "dddmm.mm", e.g. 4533.35 is 45 degrees
+ * and 33.35 minutes, followed by the hemisphere field */
+static gboolean
+nmea_parse_coordinate (const NmeaField *value,
+                       const NmeaField *hemisphere,
+                       gchar            negative_hemisphere,
+                       gint64           max_degrees,
+                       gdouble         *out)
+{
+    gint64 fixed;
+    gint64 degrees;
+    gint64 minutes;
+
+    if (!nmea_parse_fixed (value, &fixed) || fixed < 0)
+        return FALSE;
+
+    degrees = fixed / (100 * NMEA_FIXED_ONE);
+    minutes = fixed % (100 * NMEA_FIXED_ONE);
+    if (degrees > max_degrees || minutes >= 60 * NMEA_FIXED_ONE)
+        return FALSE;
 
     /* Include the minutes as part of the degrees */
-    *out = degrees + (minutes / 60.0);
-    ret = TRUE;
+    *out = (gdouble) degrees + ((gdouble) minutes / (60.0 * NMEA_FIXED_ONE));
+    if (hemisphere->len == 1 && hemisphere->str[0] == negative_hemisphere)
+        *out = -*out;
+    return TRUE;
+}
 
-out:
-    g_free (s);
+static void
+set_utc_time (MMLocationGpsRaw *self,
+              const NmeaField  *field)
+{
+    /* Times have always the same length, so the string is usually reused */
+    if (self->priv->utc_time && strlen (self->priv->utc_time) >= field->len) {
+        memcpy (self->priv->utc_time, field->str, field->len);
+        self->priv->utc_time[field->len] = '\0';
+        return;
+    }
 
-    return ret;
+    g_free (self->priv->utc_time);
+    self->priv->utc_time = g_strndup (field->str, field->len);
+}
+
+/*
+ * $--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,x,xx,x.x,x.x,M,x.x,M,x.x,xxxx*hh
+ * 1    = UTC of Position
+ * 2    = Latitude
+ * 3    = N or S
+ * 4    = Longitude
+ * 5    = E or W
+ * 6    = GPS quality indicator (0=invalid; 1=GPS fix; 2=Diff. GPS fix)
+ * 7    = Number of satellites in use [not those in view]
+ * 8    = Horizontal dilution of position
+ * 9    = Antenna altitude above/below mean sea level (geoid)
+ * 10   = Meters  (Antenna height unit)
+ * 11   = Geoidal separation (Diff. between WGS-84 earth ellipsoid and
+ *        mean sea level.  -=geoid is below WGS-84 ellipsoid)
+ * 12   = Meters  (Units of geoidal separation)
+ * 13   = Age in seconds since last update from diff. reference station
+ * 14   = Diff. reference station ID#
+ */
+static void
+add_gga (MMLocationGpsRaw *self,
+         const NmeaField  *fields,
+         guint             n_fields)
+{
+    if (n_fields < 15)
+        return;
+
+    set_utc_time (self, &fields[1]);
+
+    if (!nmea_parse_coordinate (&fields[2], &fields[3], 'S', 90, &self->priv->latitude))
+        self->priv->latitude = MM_LOCATION_LATITUDE_UNKNOWN;
+    if (!nmea_parse_coordinate (&fields[4], &fields[5], 'W', 180, &self->priv->longitude))
+        self->priv->longitude = MM_LOCATION_LONGITUDE_UNKNOWN;
+    if (!nmea_parse_double (&fields[9], &self->priv->altitude))
+        self->priv->altitude = MM_LOCATION_ALTITUDE_UNKNOWN;
+}
+
+/*
+ * $--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,ddmmyy,x.x,a*hh
+ * 1    = UTC of position fix
+ * 2    = Status (A=valid; V=warning)
+ * 3-6  = Latitude, N or S, Longitude, E or W
+ * 7    = Speed over ground, in knots
+ * 8    = Course over ground, in degrees true
+ * 9    = Date
+ *
+ * Position and time are taken from GGA, which also has the altitude; RMC
+ * only provides the speed and course.
+ */
+static void
+add_rmc (MMLocationGpsRaw *self,
+         const NmeaField  *fields,
+         guint             n_fields)
+{
+    if (n_fields < 10)
+        return;
+
+    self->priv->speed = MM_LOCATION_SPEED_UNKNOWN;
+    self->priv->course = MM_LOCATION_COURSE_UNKNOWN;
+    if (fields[2].len != 1 || fields[2].str[0] != 'A')
+        return;
+
+    if (nmea_parse_double (&fields[7], &self->priv->speed))
+        self->priv->speed *= KNOT_MPS;
+    else
+        self->priv->speed = MM_LOCATION_SPEED_UNKNOWN;
+    if (!nmea_parse_double (&fields[8], &self->priv->course))
+        self->priv->course = MM_LOCATION_COURSE_UNKNOWN;
 }
 
 gboolean
 mm_location_gps_raw_add_trace (MMLocationGpsRaw *self,
                                const gchar *trace)
 {
-    GMatchInfo *match_info = NULL;
+    NmeaField fields[NMEA_MAX_FIELDS];
 
-    /* Current implementation works only with $GPGGA traces */
-    if (!g_str_has_prefix (trace, "$GPGGA"))
+    /* Any talker ($GP, $GN, $GL, $GA, $BD...), but not proprietary ($P...)
+     * sentences */
+    if (trace[0] != '$' ||
+        !g_ascii_isupper (trace[1]) || trace[1] == 'P' ||
+        !g_ascii_isupper (trace[2]))
         return FALSE;
 
-    /*
-     * $GPGGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,x,xx,x.x,x.x,M,x.x,M,x.x,xxxx*hh
-     * 1    = UTC of Position
-     * 2    = Latitude
-     * 3    = N or S
-     * 4    = Longitude
-     * 5    = E or W
-     * 6    = GPS quality indicator (0=invalid; 1=GPS fix; 2=Diff. GPS fix)
-     * 7    = Number of satellites in use [not those in view]
-     * 8    = Horizontal dilution of position
-     * 9    = Antenna altitude above/below mean sea level (geoid)
-     * 10   = Meters  (Antenna height unit)
-     * 11   = Geoidal separation (Diff. between WGS-84 earth ellipsoid and
-     *        mean sea level.  -=geoid is below WGS-84 ellipsoid)
-     * 12   = Meters  (Units of geoidal separation)
-     * 13   = Age in seconds since last update from diff. reference station
-     * 14   = Diff. reference station ID#
-     * 15   = Checksum
-     */
-    if (G_UNLIKELY (!self->priv->gpgga_regex))
-        self->priv->gpgga_regex = g_regex_new ("\\$GPGGA,(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*),(.*)\\*(.*).*",
-                                               G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                                               0,
-                                               NULL);
-
-    if (g_regex_match (self->priv->gpgga_regex, trace, 0, &match_info)) {
-        /* UTC time */
-        if (self->priv->utc_time)
-            g_free (self->priv->utc_time);
-        self->priv->utc_time = g_match_info_fetch (match_info, 1);
-
-        /* Latitude */
-        self->priv->latitude = MM_LOCATION_LATITUDE_UNKNOWN;
-        if (get_longitude_or_latitude_from_match_info (match_info, 2, &self->priv->latitude)) {
-            gchar *str;
-
-            /* N/S */
-            str = g_match_info_fetch (match_info, 3);
-            if (str && str[0] == 'S')
-                self->priv->latitude *= -1;
-            g_free (str);
-        }
-
-        /* Longitude */
-        self->priv->longitude = MM_LOCATION_LONGITUDE_UNKNOWN;
-        if (get_longitude_or_latitude_from_match_info (match_info, 4, &self->priv->longitude)) {
-            gchar *str;
-
-            /* N/S */
-            str = g_match_info_fetch (match_info, 5);
-            if (str && str[0] == 'W')
-                self->priv->longitude *= -1;
-            g_free (str);
-        }
+    if (strncmp (&trace[3], "GGA,", 4) == 0) {
+        add_gga (self, fields, nmea_split (trace, fields));
+        return TRUE;
+    }
 
-        /* Altitude */
-        self->priv->altitude = MM_LOCATION_ALTITUDE_UNKNOWN;
-        mm_get_double_from_match_info (match_info, 9, &self->priv->altitude);
+    if (strncmp (&trace[3], "RMC,", 4) == 0) {
+        add_rmc (self, fields, nmea_split (trace, fields));
+        return TRUE;
     }
 
-    g_match_info_free (match_info);
+    return FALSE;
+}
 
-    return TRUE;
+/* Fixes reported by other means than NMEA traces, e.g. binary protocols */
+void
+mm_location_gps_raw_set_fix (MMLocationGpsRaw *self,
+                             const gchar *utc_time,
+                             gdouble latitude,
+                             gdouble longitude,
+                             gdouble altitude)
+{
+    g_return_if_fail (MM_IS_LOCATION_GPS_RAW (self));
+
+    g_free (self->priv->utc_time);
+    self->priv->utc_time = g_strdup (utc_time);
+    self->priv->latitude = latitude;
+    self->priv->longitude = longitude;
+    self->priv->altitude = altitude;
 }
 
 /*****************************************************************************/
@@ -274,12 +446,22 @@ mm_location_gps_raw_get_dictionary (MMLocationGpsRaw *self)
                            PROPERTY_LATITUDE,
                            g_variant_new_double (self->priv->latitude));
 
-    /* Altitude is optional */
+    /* Altitude, speed and course are optional */
     if (self->priv->altitude != MM_LOCATION_ALTITUDE_UNKNOWN)
         g_variant_builder_add (&builder,
                                "{sv}",
                                PROPERTY_ALTITUDE,
                                g_variant_new_double (self->priv->altitude));
+    if (self->priv->speed != MM_LOCATION_SPEED_UNKNOWN)
+        g_variant_builder_add (&builder,
+                               "{sv}",
+                               PROPERTY_SPEED,
+                               g_variant_new_double (self->priv->speed));
+    if (self->priv->course != MM_LOCATION_COURSE_UNKNOWN)
+        g_variant_builder_add (&builder,
+                               "{sv}",
+                               PROPERTY_COURSE,
+                               g_variant_new_double (self->priv->course));
 
     return g_variant_ref_sink (g_variant_builder_end (&builder));
 }
@@ -321,6 +503,10 @@ mm_location_gps_raw_new_from_dictionary (GVariant *dictionary,
             self->priv->latitude = g_variant_get_double (value);
         else if (g_str_equal (key, PROPERTY_ALTITUDE))
             self->priv->altitude = g_variant_get_double (value);
+        else if (g_str_equal (key, PROPERTY_SPEED))
+            self->priv->speed = g_variant_get_double (value);
+        else if (g_str_equal (key, PROPERTY_COURSE))
+            self->priv->course = g_variant_get_double (value);
         g_free (key);
         g_variant_unref (value);
     }
@@ -364,6 +550,8 @@ mm_location_gps_raw_init (MMLocationGpsRaw *self)
     self->priv->latitude = MM_LOCATION_LATITUDE_UNKNOWN;
     self->priv->longitude = MM_LOCATION_LONGITUDE_UNKNOWN;
     self->priv->altitude = MM_LOCATION_ALTITUDE_UNKNOWN;
+    self->priv->speed = MM_LOCATION_SPEED_UNKNOWN;
+    self->priv->course = MM_LOCATION_COURSE_UNKNOWN;
 }
 
 static void
@@ -371,8 +559,7 @@ finalize (GObject *object)
 {
     MMLocationGpsRaw *self = MM_LOCATION_GPS_RAW (object);
 
-    if (self->priv->gpgga_regex)
-        g_regex_unref (self->priv->gpgga_regex);
+    g_free (self->priv->utc_time);
 
     G_OBJECT_CLASS (mm_location_gps_raw_parent_class)->finalize (object);
 }
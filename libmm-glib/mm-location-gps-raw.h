@@ -61,6 +61,8 @@ const gchar *mm_location_gps_raw_get_utc_time  (MMLocationGpsRaw *self);
 gdouble      mm_location_gps_raw_get_longitude (MMLocationGpsRaw *self);
 gdouble      mm_location_gps_raw_get_latitude  (MMLocationGpsRaw *self);
 gdouble      mm_location_gps_raw_get_altitude  (MMLocationGpsRaw *self);
+gdouble      mm_location_gps_raw_get_speed     (MMLocationGpsRaw *self);
+gdouble      mm_location_gps_raw_get_course    (MMLocationGpsRaw *self);
 
 /*****************************************************************************/
 /* ModemManager/libmm-glib/mmcli specific methods */
@@ -75,6 +77,11 @@ MMLocationGpsRaw *mm_location_gps_raw_new_from_dictionary (GVariant *string,
 
 gboolean mm_location_gps_raw_add_trace (MMLocationGpsRaw *self,
                                         const gchar *trace);
+void     mm_location_gps_raw_set_fix   (MMLocationGpsRaw *self,
+                                        const gchar *utc_time,
+                                        gdouble latitude,
+                                        gdouble longitude,
+                                        gdouble altitude);
 
 GVariant *mm_location_gps_raw_get_dictionary (MMLocationGpsRaw *self);
 
@@ -126,6 +126,14 @@ ensure_modem_manager1_proxy (MMManager  *self,
 
 /*****************************************************************************/
 
+/* Peer-to-peer connections to the daemon's private socket have no bus, and
+ * so no bus name to talk to */
+static const gchar *
+get_bus_name (GDBusConnection *connection)
+{
+    return (g_dbus_connection_get_unique_name (connection) ? MM_DBUS_SERVICE : NULL);
+}
+
 /**
  * mm_manager_new_finish:
  * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_new().
@@ -155,6 +163,14 @@ mm_manager_new_finish (GAsyncResult  *res,
  *
  * Asynchronously creates a #MMManager.
  *
+ * @connection may be either a message bus connection or a peer-to-peer
+ * connection to the private socket of the daemon, if it was started with
+ * <literal>--peer-socket</literal>, e.g. created with
+ * g_dbus_connection_new_for_address() and
+ * %G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT. Only modem objects are
+ * available through peer-to-peer connections; bearers, SIMs, SMS and calls
+ * are only exported on the bus.
+ *
  * When the operation is finished, @callback will be invoked in the
  * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
  * of the thread you are calling this method from.
@@ -175,7 +191,7 @@ mm_manager_new (GDBusConnection               *connection,
                                 cancellable,
                                 callback,
                                 user_data,
-                                "name", MM_DBUS_SERVICE,
+                                "name", get_bus_name (connection),
                                 "object-path", MM_DBUS_PATH,
                                 "flags", flags,
                                 "connection", connection,
@@ -209,7 +225,7 @@ mm_manager_new_sync (GDBusConnection                *connection,
     ret = g_initable_new (MM_TYPE_MANAGER,
                           cancellable,
                           error,
-                          "name", MM_DBUS_SERVICE,
+                          "name", get_bus_name (connection),
                           "object-path", MM_DBUS_PATH,
                           "flags", flags,
                           "connection", connection,
@@ -383,63 +399,203 @@ mm_manager_set_logging_sync (MMManager     *manager,
 /*****************************************************************************/
 
 /**
- * mm_manager_scan_devices_finish:
+ * mm_manager_get_port_stats_finish:
  * @manager: A #MMManager.
- * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_scan_devices().
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_port_stats().
  * @error: Return location for error or %NULL.
  *
- * Finishes an operation started with mm_manager_scan_devices().
+ * Finishes an operation started with mm_manager_get_port_stats().
  *
- * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ * Returns: (transfer full): a #GVariant of type "aa{sv}" with the port
+ * statistics, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
  */
-gboolean
-mm_manager_scan_devices_finish (MMManager     *manager,
-                                GAsyncResult  *res,
+GVariant *
+mm_manager_get_port_stats_finish (MMManager     *manager,
+                                  GAsyncResult  *res,
+                                  GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_variant_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+get_port_stats_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                      GAsyncResult                       *res,
+                      GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+    GVariant *stats = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_port_stats_finish (
+            manager_iface_proxy,
+            &stats,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple, stats, (GDestroyNotify)g_variant_unref);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_get_port_stats:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests the command statistics of the serial ports of all
+ * the modems, for debugging purposes.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_get_port_stats_finish() to get the result of the operation.
+ *
+ * See mm_manager_get_port_stats_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_get_port_stats (MMManager           *manager,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_get_port_stats);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_port_stats (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)get_port_stats_ready,
+        result);
+}
+
+/**
+ * mm_manager_get_port_stats_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests the command statistics of the serial ports of all
+ * the modems, for debugging purposes.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_get_port_stats() for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): a #GVariant of type "aa{sv}" with the port
+ * statistics, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_port_stats_sync (MMManager     *manager,
+                                GCancellable  *cancellable,
                                 GError       **error)
 {
-    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+    GVariant *stats = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_port_stats_sync (
+            manager->priv->manager_iface_proxy,
+            &stats,
+            cancellable,
+            error))
+        return NULL;
+
+    return stats;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_get_loop_stats_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_loop_stats().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_get_loop_stats().
+ *
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the main loop
+ * statistics, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_loop_stats_finish (MMManager     *manager,
+                                  GAsyncResult  *res,
+                                  GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_variant_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
 }
 
 static void
-scan_devices_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
-                    GAsyncResult                       *res,
-                    GSimpleAsyncResult                 *simple)
+get_loop_stats_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                      GAsyncResult                       *res,
+                      GSimpleAsyncResult                 *simple)
 {
     GError *error = NULL;
+    GVariant *stats = NULL;
 
-    if (mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices_finish (
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_loop_stats_finish (
             manager_iface_proxy,
+            &stats,
             res,
             &error))
         g_simple_async_result_take_error (simple, error);
     else
-        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+        g_simple_async_result_set_op_res_gpointer (simple, stats, (GDestroyNotify)g_variant_unref);
 
     g_simple_async_result_complete (simple);
     g_object_unref (simple);
 }
 
 /**
- * mm_manager_scan_devices:
+ * mm_manager_get_loop_stats:
  * @manager: A #MMManager.
  * @cancellable: (allow-none): A #GCancellable or %NULL.
  * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
  * @user_data: User data to pass to @callback.
  *
- * Asynchronously requests to scan looking for devices.
+ * Asynchronously requests the statistics of the main loop of the daemon,
+ * for debugging purposes.
  *
  * When the operation is finished, @callback will be invoked in the
  * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
  * of the thread you are calling this method from. You can then call
- * mm_manager_scan_devices_finish() to get the result of the operation.
+ * mm_manager_get_loop_stats_finish() to get the result of the operation.
  *
- * See mm_manager_scan_devices_sync() for the synchronous, blocking version of this method.
+ * See mm_manager_get_loop_stats_sync() for the synchronous, blocking version of this method.
  */
 void
-mm_manager_scan_devices (MMManager           *manager,
-                         GCancellable        *cancellable,
-                         GAsyncReadyCallback  callback,
-                         gpointer             user_data)
+mm_manager_get_loop_stats (MMManager           *manager,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
 {
     GSimpleAsyncResult *result;
     GError *inner_error = NULL;
@@ -449,7 +605,7 @@ mm_manager_scan_devices (MMManager           *manager,
     result = g_simple_async_result_new (G_OBJECT (manager),
                                         callback,
                                         user_data,
-                                        mm_manager_scan_devices);
+                                        mm_manager_get_loop_stats);
 
     if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
         g_simple_async_result_take_error (result, inner_error);
@@ -458,165 +614,1074 @@ mm_manager_scan_devices (MMManager           *manager,
         return;
     }
 
-    mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices (
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_loop_stats (
         manager->priv->manager_iface_proxy,
         cancellable,
-        (GAsyncReadyCallback)scan_devices_ready,
+        (GAsyncReadyCallback)get_loop_stats_ready,
         result);
 }
 
 /**
- * mm_manager_scan_devices_sync:
+ * mm_manager_get_loop_stats_sync:
  * @manager: A #MMManager.
  * @cancellable: (allow-none): A #GCancellable or %NULL.
  * @error: Return location for error or %NULL.
  *
- * Synchronously requests to scan looking for devices.
+ * Synchronously requests the statistics of the main loop of the daemon,
+ * for debugging purposes.
  *
  * The calling thread is blocked until a reply is received.
  *
- * See mm_manager_scan_devices() for the asynchronous version of this method.
+ * See mm_manager_get_loop_stats() for the asynchronous version of this method.
  *
- * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the main loop
+ * statistics, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
  */
-gboolean
-mm_manager_scan_devices_sync (MMManager     *manager,
-                              GCancellable  *cancellable,
-                              GError       **error)
+GVariant *
+mm_manager_get_loop_stats_sync (MMManager     *manager,
+                                GCancellable  *cancellable,
+                                GError       **error)
 {
-    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+    GVariant *stats = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
 
     if (!ensure_modem_manager1_proxy (manager, error))
-        return FALSE;
+        return NULL;
 
-    return (mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices_sync (
-                manager->priv->manager_iface_proxy,
-                cancellable,
-                error));
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_loop_stats_sync (
+            manager->priv->manager_iface_proxy,
+            &stats,
+            cancellable,
+            error))
+        return NULL;
+
+    return stats;
 }
 
 /*****************************************************************************/
 
 /**
- * mm_manager_report_kernel_event_finish:
+ * mm_manager_get_profile_finish:
  * @manager: A #MMManager.
- * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_report_kernel_event().
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_profile().
  * @error: Return location for error or %NULL.
  *
- * Finishes an operation started with mm_manager_report_kernel_event().
+ * Finishes an operation started with mm_manager_get_profile().
  *
- * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the timeline
+ * of the operations run on each device, or %NULL if @error is set. The
+ * returned value should be freed with g_variant_unref().
  */
-gboolean
-mm_manager_report_kernel_event_finish (MMManager     *manager,
-                                       GAsyncResult  *res,
-                                       GError       **error)
+GVariant *
+mm_manager_get_profile_finish (MMManager     *manager,
+                               GAsyncResult  *res,
+                               GError       **error)
 {
-    return g_task_propagate_boolean (G_TASK (res), error);
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_variant_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
 }
 
 static void
-report_kernel_event_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
-                           GAsyncResult                       *res,
-                           GTask                              *task)
+get_profile_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                   GAsyncResult                       *res,
+                   GSimpleAsyncResult                 *simple)
 {
     GError *error = NULL;
+    GVariant *profile = NULL;
 
-    if (!mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event_finish (
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_profile_finish (
             manager_iface_proxy,
+            &profile,
             res,
             &error))
-        g_task_return_error (task, error);
+        g_simple_async_result_take_error (simple, error);
     else
-        g_task_return_boolean (task, TRUE);
-    g_object_unref (task);
+        g_simple_async_result_set_op_res_gpointer (simple, profile, (GDestroyNotify)g_variant_unref);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
 }
 
 /**
- * mm_manager_report_kernel_event:
+ * mm_manager_get_profile:
  * @manager: A #MMManager.
- * @properties: the properties of the kernel event.
  * @cancellable: (allow-none): A #GCancellable or %NULL.
  * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
  * @user_data: User data to pass to @callback.
  *
- * Asynchronously report kernel event.
+ * Asynchronously requests the timeline of the probing,
+ * initialization and enabling steps run on each device, for debugging purposes.
  *
  * When the operation is finished, @callback will be invoked in the
  * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
  * of the thread you are calling this method from. You can then call
- * mm_manager_report_kernel_event_finish() to get the result of the operation.
+ * mm_manager_get_profile_finish() to get the result of the operation.
  *
- * See mm_manager_report_kernel_event_sync() for the synchronous, blocking version of this method.
+ * See mm_manager_get_profile_sync() for the synchronous, blocking version of this method.
  */
 void
-mm_manager_report_kernel_event (MMManager                *manager,
-                                MMKernelEventProperties  *properties,
-                                GCancellable             *cancellable,
-                                GAsyncReadyCallback       callback,
-                                gpointer                  user_data)
+mm_manager_get_profile (MMManager           *manager,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
 {
-    GTask    *task;
-    GError   *inner_error = NULL;
-    GVariant *dictionary;
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
 
     g_return_if_fail (MM_IS_MANAGER (manager));
 
-    task = g_task_new (manager, cancellable, callback, user_data);
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_get_profile);
 
     if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
-        g_task_return_error (task, inner_error);
-        g_object_unref (task);
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
         return;
     }
 
-    dictionary = mm_kernel_event_properties_get_dictionary (properties);
-    mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event (
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_profile (
         manager->priv->manager_iface_proxy,
-        dictionary,
         cancellable,
-        (GAsyncReadyCallback)report_kernel_event_ready,
-        task);
-    g_variant_unref (dictionary);
+        (GAsyncReadyCallback)get_profile_ready,
+        result);
 }
 
 /**
- * mm_manager_report_kernel_event_sync:
+ * mm_manager_get_profile_sync:
  * @manager: A #MMManager.
- * @properties: the properties of the kernel event.
  * @cancellable: (allow-none): A #GCancellable or %NULL.
  * @error: Return location for error or %NULL.
  *
- * Synchronously report kernel event.
+ * Synchronously requests the timeline of the probing,
+ * initialization and enabling steps run on each device, for debugging purposes.
  *
  * The calling thread is blocked until a reply is received.
  *
- * See mm_manager_report_kernel_event() for the asynchronous version of this method.
+ * See mm_manager_get_profile() for the asynchronous version of this method.
  *
- * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the timeline
+ * of the operations run on each device, or %NULL if @error is set. The
+ * returned value should be freed with g_variant_unref().
  */
-gboolean
-mm_manager_report_kernel_event_sync (MMManager                *manager,
-                                     MMKernelEventProperties  *properties,
-                                     GCancellable             *cancellable,
-                                     GError                  **error)
+GVariant *
+mm_manager_get_profile_sync (MMManager     *manager,
+                             GCancellable  *cancellable,
+                             GError       **error)
 {
-    GVariant *dictionary;
-    gboolean  result;
+    GVariant *profile = NULL;
 
-    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
 
     if (!ensure_modem_manager1_proxy (manager, error))
-        return FALSE;
+        return NULL;
 
-    dictionary = mm_kernel_event_properties_get_dictionary (properties);
-    result = (mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event_sync (
-                  manager->priv->manager_iface_proxy,
-                  dictionary,
-                  cancellable,
-                  error));
-    g_variant_unref (dictionary);
-    return result;
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_profile_sync (
+            manager->priv->manager_iface_proxy,
+            &profile,
+            cancellable,
+            error))
+        return NULL;
+
+    return profile;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_get_telemetry_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_telemetry().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_get_telemetry().
+ *
+ * Returns: (transfer full): a #GVariant of type "a{oa{sv}}" with the
+ * snapshot, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_telemetry_finish (MMManager     *manager,
+                                 GAsyncResult  *res,
+                                 GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_variant_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+get_telemetry_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                     GAsyncResult                       *res,
+                     GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+    GVariant *telemetry = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_telemetry_finish (
+            manager_iface_proxy,
+            &telemetry,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple, telemetry, (GDestroyNotify)g_variant_unref);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_get_telemetry:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests a snapshot of the state, signal quality, access
+ * technologies, registration, operator and bearer statistics of all the
+ * modems, in a single call.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_get_telemetry_finish() to get the result of the operation.
+ *
+ * See mm_manager_get_telemetry_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_get_telemetry (MMManager           *manager,
+                          GCancellable        *cancellable,
+                          GAsyncReadyCallback  callback,
+                          gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_get_telemetry);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_telemetry (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)get_telemetry_ready,
+        result);
+}
+
+/**
+ * mm_manager_get_telemetry_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests a snapshot of the state, signal quality, access
+ * technologies, registration, operator and bearer statistics of all the
+ * modems, in a single call.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_get_telemetry() for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): a #GVariant of type "a{oa{sv}}" with the
+ * snapshot, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_telemetry_sync (MMManager     *manager,
+                               GCancellable  *cancellable,
+                               GError       **error)
+{
+    GVariant *telemetry = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_telemetry_sync (
+            manager->priv->manager_iface_proxy,
+            &telemetry,
+            cancellable,
+            error))
+        return NULL;
+
+    return telemetry;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_get_census_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_census().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_get_census().
+ *
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the
+ * census, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_census_finish (MMManager     *manager,
+                              GAsyncResult  *res,
+                              GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_variant_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+get_census_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                  GAsyncResult                       *res,
+                  GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+    GVariant *census = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_census_finish (
+            manager_iface_proxy,
+            &census,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple, census, (GDestroyNotify)g_variant_unref);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_get_census:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests a census of the objects and buffers held by each
+ * modem, and of the live objects of the daemon, for debugging purposes.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_get_census_finish() to get the result of the operation.
+ *
+ * See mm_manager_get_census_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_get_census (MMManager           *manager,
+                       GCancellable        *cancellable,
+                       GAsyncReadyCallback  callback,
+                       gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_get_census);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_census (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)get_census_ready,
+        result);
+}
+
+/**
+ * mm_manager_get_census_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests a census of the objects and buffers held by each
+ * modem, and of the live objects of the daemon, for debugging purposes.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_get_census() for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): a #GVariant of type "a{sv}" with the
+ * census, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_manager_get_census_sync (MMManager     *manager,
+                            GCancellable  *cancellable,
+                            GError       **error)
+{
+    GVariant *census = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_census_sync (
+            manager->priv->manager_iface_proxy,
+            &census,
+            cancellable,
+            error))
+        return NULL;
+
+    return census;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_get_metrics_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_get_metrics().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_get_metrics().
+ *
+ * Returns: (transfer full): the metrics in the OpenMetrics text format, or
+ * %NULL if @error is set. The returned value should be freed with g_free().
+ */
+gchar *
+mm_manager_get_metrics_finish (MMManager     *manager,
+                               GAsyncResult  *res,
+                               GError       **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return g_strdup (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+get_metrics_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                   GAsyncResult                       *res,
+                   GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+    gchar *metrics = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_metrics_finish (
+            manager_iface_proxy,
+            &metrics,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple, metrics, g_free);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_get_metrics:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests the counters and histograms about the internals of
+ * the daemon, in the OpenMetrics text format.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_get_metrics_finish() to get the result of the operation.
+ *
+ * See mm_manager_get_metrics_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_get_metrics (MMManager           *manager,
+                        GCancellable        *cancellable,
+                        GAsyncReadyCallback  callback,
+                        gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_get_metrics);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_get_metrics (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)get_metrics_ready,
+        result);
+}
+
+/**
+ * mm_manager_get_metrics_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests the counters and histograms about the internals of
+ * the daemon, in the OpenMetrics text format.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_get_metrics() for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): the metrics in the OpenMetrics text format, or
+ * %NULL if @error is set. The returned value should be freed with g_free().
+ */
+gchar *
+mm_manager_get_metrics_sync (MMManager     *manager,
+                             GCancellable  *cancellable,
+                             GError       **error)
+{
+    gchar *metrics = NULL;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), NULL);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_get_metrics_sync (
+            manager->priv->manager_iface_proxy,
+            &metrics,
+            cancellable,
+            error))
+        return NULL;
+
+    return metrics;
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_capture_traffic_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_capture_traffic().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_capture_traffic().
+ *
+ * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_capture_traffic_finish (MMManager     *manager,
+                                   GAsyncResult  *res,
+                                   GError       **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+capture_traffic_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                       GAsyncResult                       *res,
+                       GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_capture_traffic_finish (
+            manager_iface_proxy,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_capture_traffic:
+ * @manager: A #MMManager.
+ * @path: path of the pcapng file to create in the daemon's filesystem, or an empty string to stop capturing.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests the daemon to start or stop capturing the control
+ * traffic of all the ports.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_capture_traffic_finish() to get the result of the operation.
+ *
+ * See mm_manager_capture_traffic_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_capture_traffic (MMManager           *manager,
+                            const gchar         *path,
+                            GCancellable        *cancellable,
+                            GAsyncReadyCallback  callback,
+                            gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_capture_traffic);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_capture_traffic (
+        manager->priv->manager_iface_proxy,
+        path ? path : "",
+        cancellable,
+        (GAsyncReadyCallback)capture_traffic_ready,
+        result);
+}
+
+/**
+ * mm_manager_capture_traffic_sync:
+ * @manager: A #MMManager.
+ * @path: path of the pcapng file to create in the daemon's filesystem, or an empty string to stop capturing.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests the daemon to start or stop capturing the control
+ * traffic of all the ports.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_capture_traffic() for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_capture_traffic_sync (MMManager     *manager,
+                                 const gchar   *path,
+                                 GCancellable  *cancellable,
+                                 GError       **error)
+{
+    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return FALSE;
+
+    return (mm_gdbus_org_freedesktop_modem_manager1_call_capture_traffic_sync (
+                manager->priv->manager_iface_proxy,
+                path ? path : "",
+                cancellable,
+                error));
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_scan_devices_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_scan_devices().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_scan_devices().
+ *
+ * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_scan_devices_finish (MMManager     *manager,
+                                GAsyncResult  *res,
+                                GError       **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+scan_devices_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                    GAsyncResult                       *res,
+                    GSimpleAsyncResult                 *simple)
+{
+    GError *error = NULL;
+
+    if (mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices_finish (
+            manager_iface_proxy,
+            res,
+            &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_manager_scan_devices:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously requests to scan looking for devices.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_scan_devices_finish() to get the result of the operation.
+ *
+ * See mm_manager_scan_devices_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_scan_devices (MMManager           *manager,
+                         GCancellable        *cancellable,
+                         GAsyncReadyCallback  callback,
+                         gpointer             user_data)
+{
+    GSimpleAsyncResult *result;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    result = g_simple_async_result_new (G_OBJECT (manager),
+                                        callback,
+                                        user_data,
+                                        mm_manager_scan_devices);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_simple_async_result_take_error (result, inner_error);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices (
+        manager->priv->manager_iface_proxy,
+        cancellable,
+        (GAsyncReadyCallback)scan_devices_ready,
+        result);
+}
+
+/**
+ * mm_manager_scan_devices_sync:
+ * @manager: A #MMManager.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously requests to scan looking for devices.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_scan_devices() for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the call succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_scan_devices_sync (MMManager     *manager,
+                              GCancellable  *cancellable,
+                              GError       **error)
+{
+    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return FALSE;
+
+    return (mm_gdbus_org_freedesktop_modem_manager1_call_scan_devices_sync (
+                manager->priv->manager_iface_proxy,
+                cancellable,
+                error));
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_manager_report_kernel_event_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_report_kernel_event().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_report_kernel_event().
+ *
+ * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_report_kernel_event_finish (MMManager     *manager,
+                                       GAsyncResult  *res,
+                                       GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+report_kernel_event_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                           GAsyncResult                       *res,
+                           GTask                              *task)
+{
+    GError *error = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event_finish (
+            manager_iface_proxy,
+            res,
+            &error))
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+/**
+ * mm_manager_report_kernel_event:
+ * @manager: A #MMManager.
+ * @properties: the properties of the kernel event.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously report kernel event.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_report_kernel_event_finish() to get the result of the operation.
+ *
+ * See mm_manager_report_kernel_event_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_report_kernel_event (MMManager                *manager,
+                                MMKernelEventProperties  *properties,
+                                GCancellable             *cancellable,
+                                GAsyncReadyCallback       callback,
+                                gpointer                  user_data)
+{
+    GTask    *task;
+    GError   *inner_error = NULL;
+    GVariant *dictionary;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    task = g_task_new (manager, cancellable, callback, user_data);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_task_return_error (task, inner_error);
+        g_object_unref (task);
+        return;
+    }
+
+    dictionary = mm_kernel_event_properties_get_dictionary (properties);
+    mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event (
+        manager->priv->manager_iface_proxy,
+        dictionary,
+        cancellable,
+        (GAsyncReadyCallback)report_kernel_event_ready,
+        task);
+    g_variant_unref (dictionary);
+}
+
+/**
+ * mm_manager_report_kernel_event_sync:
+ * @manager: A #MMManager.
+ * @properties: the properties of the kernel event.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously report kernel event.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_report_kernel_event() for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_report_kernel_event_sync (MMManager                *manager,
+                                     MMKernelEventProperties  *properties,
+                                     GCancellable             *cancellable,
+                                     GError                  **error)
+{
+    GVariant *dictionary;
+    gboolean  result;
+
+    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return FALSE;
+
+    dictionary = mm_kernel_event_properties_get_dictionary (properties);
+    result = (mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_event_sync (
+                  manager->priv->manager_iface_proxy,
+                  dictionary,
+                  cancellable,
+                  error));
+    g_variant_unref (dictionary);
+    return result;
+}
+
+/*****************************************************************************/
+
+static GVariant *
+build_kernel_events (GList *properties_list)
+{
+    GVariantBuilder builder;
+    GList *l;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (l = properties_list; l; l = g_list_next (l)) {
+        GVariant *dictionary;
+
+        dictionary = mm_kernel_event_properties_get_dictionary (MM_KERNEL_EVENT_PROPERTIES (l->data));
+        g_variant_builder_add_value (&builder, dictionary);
+        g_variant_unref (dictionary);
+    }
+    return g_variant_builder_end (&builder);
+}
+
+/**
+ * mm_manager_report_kernel_events_finish:
+ * @manager: A #MMManager.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_manager_report_kernel_events().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_manager_report_kernel_events().
+ *
+ * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_report_kernel_events_finish (MMManager     *manager,
+                                        GAsyncResult  *res,
+                                        GError       **error)
+{
+    return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+static void
+report_kernel_events_ready (MmGdbusOrgFreedesktopModemManager1 *manager_iface_proxy,
+                            GAsyncResult                       *res,
+                            GTask                              *task)
+{
+    GError *error = NULL;
+
+    if (!mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_events_finish (
+            manager_iface_proxy,
+            res,
+            &error))
+        g_task_return_error (task, error);
+    else
+        g_task_return_boolean (task, TRUE);
+    g_object_unref (task);
+}
+
+/**
+ * mm_manager_report_kernel_events:
+ * @manager: A #MMManager.
+ * @properties_list: (element-type ModemManager.KernelEventProperties): the properties of each kernel event.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously report several kernel events at once. None of them is
+ * processed if any is invalid.
+ *
+ * When the operation is finished, @callback will be invoked in the
+ * <link linkend="g-main-context-push-thread-default">thread-default main loop</link>
+ * of the thread you are calling this method from. You can then call
+ * mm_manager_report_kernel_events_finish() to get the result of the operation.
+ *
+ * See mm_manager_report_kernel_events_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_manager_report_kernel_events (MMManager           *manager,
+                                 GList               *properties_list,
+                                 GCancellable        *cancellable,
+                                 GAsyncReadyCallback  callback,
+                                 gpointer             user_data)
+{
+    GTask  *task;
+    GError *inner_error = NULL;
+
+    g_return_if_fail (MM_IS_MANAGER (manager));
+
+    task = g_task_new (manager, cancellable, callback, user_data);
+
+    if (!ensure_modem_manager1_proxy (manager, &inner_error)) {
+        g_task_return_error (task, inner_error);
+        g_object_unref (task);
+        return;
+    }
+
+    mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_events (
+        manager->priv->manager_iface_proxy,
+        build_kernel_events (properties_list),
+        cancellable,
+        (GAsyncReadyCallback)report_kernel_events_ready,
+        task);
+}
+
+/**
+ * mm_manager_report_kernel_events_sync:
+ * @manager: A #MMManager.
+ * @properties_list: (element-type ModemManager.KernelEventProperties): the properties of each kernel event.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously report several kernel events at once. None of them is
+ * processed if any is invalid.
+ *
+ * The calling thread is blocked until a reply is received.
+ *
+ * See mm_manager_report_kernel_events() for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the operation succeded, %FALSE if @error is set.
+ */
+gboolean
+mm_manager_report_kernel_events_sync (MMManager     *manager,
+                                      GList         *properties_list,
+                                      GCancellable  *cancellable,
+                                      GError       **error)
+{
+    g_return_val_if_fail (MM_IS_MANAGER (manager), FALSE);
+
+    if (!ensure_modem_manager1_proxy (manager, error))
+        return FALSE;
+
+    return (mm_gdbus_org_freedesktop_modem_manager1_call_report_kernel_events_sync (
+                manager->priv->manager_iface_proxy,
+                build_kernel_events (properties_list),
+                cancellable,
+                error));
 }
 
 /*****************************************************************************/
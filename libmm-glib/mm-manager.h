@@ -98,6 +98,85 @@ gboolean mm_manager_set_logging_sync (MMManager     *manager,
                                       GCancellable  *cancellable,
                                       GError       **error);
 
+void      mm_manager_get_port_stats        (MMManager           *manager,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
+GVariant *mm_manager_get_port_stats_finish (MMManager     *manager,
+                                            GAsyncResult  *res,
+                                            GError       **error);
+GVariant *mm_manager_get_port_stats_sync   (MMManager     *manager,
+                                            GCancellable  *cancellable,
+                                            GError       **error);
+
+void      mm_manager_get_loop_stats        (MMManager           *manager,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
+GVariant *mm_manager_get_loop_stats_finish (MMManager     *manager,
+                                            GAsyncResult  *res,
+                                            GError       **error);
+GVariant *mm_manager_get_loop_stats_sync   (MMManager     *manager,
+                                            GCancellable  *cancellable,
+                                            GError       **error);
+
+void      mm_manager_get_profile        (MMManager           *manager,
+                                         GCancellable        *cancellable,
+                                         GAsyncReadyCallback  callback,
+                                         gpointer             user_data);
+GVariant *mm_manager_get_profile_finish (MMManager     *manager,
+                                         GAsyncResult  *res,
+                                         GError       **error);
+GVariant *mm_manager_get_profile_sync   (MMManager     *manager,
+                                         GCancellable  *cancellable,
+                                         GError       **error);
+
+void      mm_manager_get_telemetry        (MMManager           *manager,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data);
+GVariant *mm_manager_get_telemetry_finish (MMManager     *manager,
+                                           GAsyncResult  *res,
+                                           GError       **error);
+GVariant *mm_manager_get_telemetry_sync   (MMManager     *manager,
+                                           GCancellable  *cancellable,
+                                           GError       **error);
+
+void      mm_manager_get_census        (MMManager           *manager,
+                                        GCancellable        *cancellable,
+                                        GAsyncReadyCallback  callback,
+                                        gpointer             user_data);
+GVariant *mm_manager_get_census_finish (MMManager     *manager,
+                                        GAsyncResult  *res,
+                                        GError       **error);
+GVariant *mm_manager_get_census_sync   (MMManager     *manager,
+                                        GCancellable  *cancellable,
+                                        GError       **error);
+
+void   mm_manager_get_metrics        (MMManager           *manager,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data);
+gchar *mm_manager_get_metrics_finish (MMManager     *manager,
+                                      GAsyncResult  *res,
+                                      GError       **error);
+gchar *mm_manager_get_metrics_sync   (MMManager     *manager,
+                                      GCancellable  *cancellable,
+                                      GError       **error);
+
+void     mm_manager_capture_traffic        (MMManager           *manager,
+                                            const gchar         *path,
+                                            GCancellable        *cancellable,
+                                            GAsyncReadyCallback  callback,
+                                            gpointer             user_data);
+gboolean mm_manager_capture_traffic_finish (MMManager     *manager,
+                                            GAsyncResult  *res,
+                                            GError       **error);
+gboolean mm_manager_capture_traffic_sync   (MMManager     *manager,
+                                            const gchar   *path,
+                                            GCancellable  *cancellable,
+                                            GError       **error);
+
 void mm_manager_scan_devices (MMManager           *manager,
                               GCancellable        *cancellable,
                               GAsyncReadyCallback  callback,
@@ -122,6 +201,19 @@ gboolean mm_manager_report_kernel_event_sync   (MMManager                *manage
                                                 GCancellable             *cancellable,
                                                 GError                  **error);
 
+void     mm_manager_report_kernel_events        (MMManager            *manager,
+                                                 GList                *properties_list,
+                                                 GCancellable         *cancellable,
+                                                 GAsyncReadyCallback   callback,
+                                                 gpointer              user_data);
+gboolean mm_manager_report_kernel_events_finish (MMManager            *manager,
+                                                 GAsyncResult         *res,
+                                                 GError              **error);
+gboolean mm_manager_report_kernel_events_sync   (MMManager            *manager,
+                                                 GList                *properties_list,
+                                                 GCancellable         *cancellable,
+                                                 GError              **error);
+
 G_END_DECLS
 
 #endif /* _MM_MANAGER_H_ */
@@ -272,6 +272,92 @@ mm_modem_3gpp_ussd_initiate_sync (MMModem3gppUssd *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_3gpp_ussd_initiate_session_finish:
+ * @self: A #MMModem3gppUssd.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_3gpp_ussd_initiate_session().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_3gpp_ussd_initiate_session().
+ *
+ * Returns: The network reply to the last command of the session. The returned value should be freed with g_free().
+ */
+gchar *
+mm_modem_3gpp_ussd_initiate_session_finish (MMModem3gppUssd *self,
+                                            GAsyncResult *res,
+                                            GError **error)
+{
+    gchar *reply = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_3GPP_USSD (self), NULL);
+
+    mm_gdbus_modem3gpp_ussd_call_initiate_session_finish (MM_GDBUS_MODEM3GPP_USSD (self), &reply, res, error);
+
+    return reply;
+}
+
+/**
+ * mm_modem_3gpp_ussd_initiate_session:
+ * @self: A #MMModem3gppUssd.
+ * @commands: (array zero-terminated=1): The command to start the USSD session with, followed by the responses to each of the network replies.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously runs a whole menu-driven USSD session: the first command
+ * initiates the session and each of the following ones is sent as soon as
+ * the network replies to the previous one.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_3gpp_ussd_initiate_session_finish() to get the result of the operation.
+ *
+ * See mm_modem_3gpp_ussd_initiate_session_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_3gpp_ussd_initiate_session (MMModem3gppUssd *self,
+                                     const gchar *const *commands,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_3GPP_USSD (self));
+
+    mm_gdbus_modem3gpp_ussd_call_initiate_session (MM_GDBUS_MODEM3GPP_USSD (self), commands, cancellable, callback, user_data);
+}
+
+/**
+ * mm_modem_3gpp_ussd_initiate_session_sync:
+ * @self: A #MMModem3gppUssd.
+ * @commands: (array zero-terminated=1): The command to start the USSD session with, followed by the responses to each of the network replies.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously runs a whole menu-driven USSD session: the first command
+ * initiates the session and each of the following ones is sent as soon as
+ * the network replies to the previous one.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_3gpp_ussd_initiate_session()
+ * for the asynchronous version of this method.
+ *
+ * Returns: The network reply to the last command of the session. The returned value should be freed with g_free().
+ */
+gchar *
+mm_modem_3gpp_ussd_initiate_session_sync (MMModem3gppUssd *self,
+                                          const gchar *const *commands,
+                                          GCancellable *cancellable,
+                                          GError **error)
+{
+    gchar *reply = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_3GPP_USSD (self), NULL);
+
+    mm_gdbus_modem3gpp_ussd_call_initiate_session_sync (MM_GDBUS_MODEM3GPP_USSD (self), commands, &reply, cancellable, error);
+
+    return reply;
+}
+
+/*****************************************************************************/
+
 /**
  * mm_modem_3gpp_ussd_respond_finish:
  * @self: A #MMModem3gppUssd.
@@ -87,6 +87,19 @@ gchar *mm_modem_3gpp_ussd_initiate_sync   (MMModem3gppUssd *self,
                                            GCancellable *cancellable,
                                            GError **error);
 
+void   mm_modem_3gpp_ussd_initiate_session        (MMModem3gppUssd *self,
+                                                   const gchar *const *commands,
+                                                   GCancellable *cancellable,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer user_data);
+gchar *mm_modem_3gpp_ussd_initiate_session_finish (MMModem3gppUssd *self,
+                                                   GAsyncResult *res,
+                                                   GError **error);
+gchar *mm_modem_3gpp_ussd_initiate_session_sync   (MMModem3gppUssd *self,
+                                                   const gchar *const *commands,
+                                                   GCancellable *cancellable,
+                                                   GError **error);
+
 void   mm_modem_3gpp_ussd_respond        (MMModem3gppUssd *self,
                                           const gchar *response,
                                           GCancellable *cancellable,
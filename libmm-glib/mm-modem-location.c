@@ -22,6 +22,7 @@
  */
 
 #include <gio/gio.h>
+#include <gio/gunixfdlist.h>
 
 #include "mm-helpers.h"
 #include "mm-errors-types.h"
@@ -391,6 +392,312 @@ mm_modem_location_set_gps_refresh_rate_sync (MMModemLocation *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_location_inject_assistance_data_finish:
+ * @self: A #MMModemLocation.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_location_inject_assistance_data().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_location_inject_assistance_data().
+ *
+ * Returns: %TRUE if the injection was successful, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_location_inject_assistance_data_finish (MMModemLocation *self,
+                                                 GAsyncResult *res,
+                                                 GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), FALSE);
+
+    return mm_gdbus_modem_location_call_inject_assistance_data_finish (MM_GDBUS_MODEM_LOCATION (self), res, error);
+}
+
+/**
+ * mm_modem_location_inject_assistance_data:
+ * @self: A #MMModemLocation.
+ * @data: (array length=data_size): Data to inject.
+ * @data_size: size of @data.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously injects assistance data to the GNSS module, of any of the
+ * types given in mm_modem_location_get_supported_assistance_data().
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_location_inject_assistance_data_finish() to get the result of the operation.
+ *
+ * See mm_modem_location_inject_assistance_data_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_location_inject_assistance_data (MMModemLocation *self,
+                                          const guint8 *data,
+                                          gsize data_size,
+                                          GCancellable *cancellable,
+                                          GAsyncReadyCallback callback,
+                                          gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_LOCATION (self));
+
+    mm_gdbus_modem_location_call_inject_assistance_data (MM_GDBUS_MODEM_LOCATION (self),
+                                                         g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, data, data_size, sizeof (guint8)),
+                                                         cancellable,
+                                                         callback,
+                                                         user_data);
+}
+
+/**
+ * mm_modem_location_inject_assistance_data_sync:
+ * @self: A #MMModemLocation.
+ * @data: (array length=data_size): Data to inject.
+ * @data_size: size of @data.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously injects assistance data to the GNSS module, of any of the
+ * types given in mm_modem_location_get_supported_assistance_data().
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_location_inject_assistance_data()
+ * for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the injection was successful, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_location_inject_assistance_data_sync (MMModemLocation *self,
+                                               const guint8 *data,
+                                               gsize data_size,
+                                               GCancellable *cancellable,
+                                               GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), FALSE);
+
+    return mm_gdbus_modem_location_call_inject_assistance_data_sync (MM_GDBUS_MODEM_LOCATION (self),
+                                                                     g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, data, data_size, sizeof (guint8)),
+                                                                     cancellable,
+                                                                     error);
+}
+
+/*****************************************************************************/
+
+static gint
+open_nmea_stream_get_fd (gint index,
+                         GUnixFDList *fd_list,
+                         GError **error)
+{
+    gint fd;
+
+    if (!fd_list) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_FAILED,
+                     "No stream file descriptor received");
+        return -1;
+    }
+
+    fd = g_unix_fd_list_get (fd_list, index, error);
+    g_object_unref (fd_list);
+    return fd;
+}
+
+/**
+ * mm_modem_location_open_nmea_stream_finish:
+ * @self: A #MMModemLocation.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_location_open_nmea_stream().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_location_open_nmea_stream().
+ *
+ * Returns: a file descriptor to read the NMEA stream from, or -1 if @error is set. The returned value should be closed with close().
+ */
+gint
+mm_modem_location_open_nmea_stream_finish (MMModemLocation *self,
+                                           GAsyncResult *res,
+                                           GError **error)
+{
+    GUnixFDList *fd_list = NULL;
+    gint index = -1;
+
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), -1);
+
+    if (!mm_gdbus_modem_location_call_open_nmea_stream_finish (MM_GDBUS_MODEM_LOCATION (self), &index, &fd_list, res, error))
+        return -1;
+
+    return open_nmea_stream_get_fd (index, fd_list, error);
+}
+
+/**
+ * mm_modem_location_open_nmea_stream:
+ * @self: A #MMModemLocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously opens a stream with the raw NMEA traces reported by the GPS,
+ * each one terminated with &lt;CR&gt;&lt;LF&gt;. The traces are written as soon
+ * as they are received, regardless of the GPS refresh rate.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_location_open_nmea_stream_finish() to get the result of the operation.
+ *
+ * See mm_modem_location_open_nmea_stream_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_location_open_nmea_stream (MMModemLocation *self,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_LOCATION (self));
+
+    mm_gdbus_modem_location_call_open_nmea_stream (MM_GDBUS_MODEM_LOCATION (self),
+                                                   NULL,
+                                                   cancellable,
+                                                   callback,
+                                                   user_data);
+}
+
+/**
+ * mm_modem_location_open_nmea_stream_sync:
+ * @self: A #MMModemLocation.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously opens a stream with the raw NMEA traces reported by the GPS,
+ * each one terminated with &lt;CR&gt;&lt;LF&gt;. The traces are written as soon
+ * as they are received, regardless of the GPS refresh rate.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_location_open_nmea_stream()
+ * for the asynchronous version of this method.
+ *
+ * Returns: a file descriptor to read the NMEA stream from, or -1 if @error is set. The returned value should be closed with close().
+ */
+gint
+mm_modem_location_open_nmea_stream_sync (MMModemLocation *self,
+                                         GCancellable *cancellable,
+                                         GError **error)
+{
+    GUnixFDList *fd_list = NULL;
+    gint index = -1;
+
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), -1);
+
+    if (!mm_gdbus_modem_location_call_open_nmea_stream_sync (MM_GDBUS_MODEM_LOCATION (self),
+                                                             NULL,
+                                                             &index,
+                                                             &fd_list,
+                                                             cancellable,
+                                                             error))
+        return -1;
+
+    return open_nmea_stream_get_fd (index, fd_list, error);
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_modem_location_get_history_finish:
+ * @self: A #MMModemLocation.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_location_get_history().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_location_get_history().
+ *
+ * Returns: (transfer full): a #GVariant of type "aa{sv}" with the location
+ * records, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_modem_location_get_history_finish (MMModemLocation *self,
+                                      GAsyncResult *res,
+                                      GError **error)
+{
+    GVariant *history = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), NULL);
+
+    if (!mm_gdbus_modem_location_call_get_location_history_finish (MM_GDBUS_MODEM_LOCATION (self), &history, res, error))
+        return NULL;
+
+    return history;
+}
+
+/**
+ * mm_modem_location_get_history:
+ * @self: A #MMModemLocation.
+ * @from: Start of the range, as a UNIX timestamp in seconds.
+ * @to: End of the range, as a UNIX timestamp in seconds, or 0 for no end.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously gets the location records kept by the daemon between @from
+ * and @to.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_location_get_history_finish() to get the result of the operation.
+ *
+ * See mm_modem_location_get_history_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_location_get_history (MMModemLocation *self,
+                               guint64 from,
+                               guint64 to,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_LOCATION (self));
+
+    mm_gdbus_modem_location_call_get_location_history (MM_GDBUS_MODEM_LOCATION (self),
+                                                       from,
+                                                       to,
+                                                       cancellable,
+                                                       callback,
+                                                       user_data);
+}
+
+/**
+ * mm_modem_location_get_history_sync:
+ * @self: A #MMModemLocation.
+ * @from: Start of the range, as a UNIX timestamp in seconds.
+ * @to: End of the range, as a UNIX timestamp in seconds, or 0 for no end.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously gets the location records kept by the daemon between @from
+ * and @to.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_location_get_history()
+ * for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): a #GVariant of type "aa{sv}" with the location
+ * records, or %NULL if @error is set. The returned value should be freed
+ * with g_variant_unref().
+ */
+GVariant *
+mm_modem_location_get_history_sync (MMModemLocation *self,
+                                    guint64 from,
+                                    guint64 to,
+                                    GCancellable *cancellable,
+                                    GError **error)
+{
+    GVariant *history = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), NULL);
+
+    if (!mm_gdbus_modem_location_call_get_location_history_sync (MM_GDBUS_MODEM_LOCATION (self),
+                                                                 from,
+                                                                 to,
+                                                                 &history,
+                                                                 cancellable,
+                                                                 error))
+        return NULL;
+
+    return history;
+}
+
+/*****************************************************************************/
+
 static gboolean
 build_locations (GVariant *dictionary,
                  MMLocation3gpp **location_3gpp,
@@ -894,6 +1201,44 @@ mm_modem_location_get_gps_refresh_rate (MMModemLocation *self)
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_location_get_supported_assistance_data:
+ * @self: A #MMModemLocation.
+ *
+ * Gets the types of assistance data that may be injected with
+ * mm_modem_location_inject_assistance_data().
+ *
+ * Returns: A bitmask of #MMModemLocationAssistanceDataType values.
+ */
+MMModemLocationAssistanceDataType
+mm_modem_location_get_supported_assistance_data (MMModemLocation *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_NONE);
+
+    return (MMModemLocationAssistanceDataType) mm_gdbus_modem_location_get_supported_assistance_data (MM_GDBUS_MODEM_LOCATION (self));
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_modem_location_get_time_to_first_fix:
+ * @self: A #MMModemLocation.
+ *
+ * Gets the time between enabling the raw GPS location source and getting the
+ * first fix, the last time the source was enabled.
+ *
+ * Returns: The time to first fix, in milliseconds, or 0 if there was no fix yet.
+ */
+guint
+mm_modem_location_get_time_to_first_fix (MMModemLocation *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_LOCATION (self), 0);
+
+    return mm_gdbus_modem_location_get_time_to_first_fix (MM_GDBUS_MODEM_LOCATION (self));
+}
+
+/*****************************************************************************/
+
 static void
 mm_modem_location_init (MMModemLocation *self)
 {
@@ -81,6 +81,10 @@ gchar       *mm_modem_location_dup_supl_server (MMModemLocation *self);
 
 guint mm_modem_location_get_gps_refresh_rate (MMModemLocation *self);
 
+MMModemLocationAssistanceDataType mm_modem_location_get_supported_assistance_data (MMModemLocation *self);
+
+guint mm_modem_location_get_time_to_first_fix (MMModemLocation *self);
+
 void     mm_modem_location_setup        (MMModemLocation *self,
                                          MMModemLocationSource sources,
                                          gboolean signal_location,
@@ -122,6 +126,47 @@ gboolean mm_modem_location_set_gps_refresh_rate_sync   (MMModemLocation *self,
                                                         GCancellable *cancellable,
                                                         GError **error);
 
+void     mm_modem_location_inject_assistance_data        (MMModemLocation *self,
+                                                          const guint8 *data,
+                                                          gsize data_size,
+                                                          GCancellable *cancellable,
+                                                          GAsyncReadyCallback callback,
+                                                          gpointer user_data);
+gboolean mm_modem_location_inject_assistance_data_finish (MMModemLocation *self,
+                                                          GAsyncResult *res,
+                                                          GError **error);
+gboolean mm_modem_location_inject_assistance_data_sync   (MMModemLocation *self,
+                                                          const guint8 *data,
+                                                          gsize data_size,
+                                                          GCancellable *cancellable,
+                                                          GError **error);
+
+void     mm_modem_location_open_nmea_stream        (MMModemLocation *self,
+                                                    GCancellable *cancellable,
+                                                    GAsyncReadyCallback callback,
+                                                    gpointer user_data);
+gint     mm_modem_location_open_nmea_stream_finish (MMModemLocation *self,
+                                                    GAsyncResult *res,
+                                                    GError **error);
+gint     mm_modem_location_open_nmea_stream_sync   (MMModemLocation *self,
+                                                    GCancellable *cancellable,
+                                                    GError **error);
+
+void      mm_modem_location_get_history        (MMModemLocation *self,
+                                                guint64 from,
+                                                guint64 to,
+                                                GCancellable *cancellable,
+                                                GAsyncReadyCallback callback,
+                                                gpointer user_data);
+GVariant *mm_modem_location_get_history_finish (MMModemLocation *self,
+                                                GAsyncResult *res,
+                                                GError **error);
+GVariant *mm_modem_location_get_history_sync   (MMModemLocation *self,
+                                                guint64 from,
+                                                guint64 to,
+                                                GCancellable *cancellable,
+                                                GError **error);
+
 void            mm_modem_location_get_3gpp        (MMModemLocation *self,
                                                    GCancellable *cancellable,
                                                    GAsyncReadyCallback callback,
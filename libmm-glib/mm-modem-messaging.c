@@ -218,6 +218,49 @@ mm_modem_messaging_get_default_storage (MMModemMessaging *self)
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_messaging_get_message_paths:
+ * @self: A #MMModemMessaging.
+ *
+ * Gets the DBus paths of the #MMSms objects available in the modem.
+ *
+ * Unlike mm_modem_messaging_list(), no #MMSms object is created, so this is
+ * the cheapest way to know which messages exist when there are lots of them.
+ * A single #MMSms may then be created on demand with mm_modem_messaging_get_sms().
+ *
+ * <warning>The returned value is only valid until the property changes so
+ * it is only safe to use this function on the thread where
+ * @self was constructed. Use mm_modem_messaging_dup_message_paths() if on another
+ * thread.</warning>
+ *
+ * Returns: (transfer none): The DBus paths of the #MMSms objects, or %NULL if none available. Do not free the returned value, it belongs to @self.
+ */
+const gchar * const *
+mm_modem_messaging_get_message_paths (MMModemMessaging *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+
+    return mm_gdbus_modem_messaging_get_messages (MM_GDBUS_MODEM_MESSAGING (self));
+}
+
+/**
+ * mm_modem_messaging_dup_message_paths:
+ * @self: A #MMModemMessaging.
+ *
+ * Gets a copy of the DBus paths of the #MMSms objects available in the modem.
+ *
+ * Returns: (transfer full): The DBus paths of the #MMSms objects, or %NULL if none available. The returned value should be freed with g_strfreev().
+ */
+gchar **
+mm_modem_messaging_dup_message_paths (MMModemMessaging *self)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+
+    return mm_gdbus_modem_messaging_dup_messages (MM_GDBUS_MODEM_MESSAGING (self));
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MMModemMessaging *self;
     GSimpleAsyncResult *result;
@@ -436,6 +479,292 @@ mm_modem_messaging_list_sync (MMModemMessaging *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_messaging_get_sms_finish:
+ * @self: A #MMModemMessaging.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_messaging_get_sms().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_messaging_get_sms().
+ *
+ * Returns: (transfer full): a #MMSms or #NULL if @error is set. The returned value should be freed with g_object_unref().
+ */
+MMSms *
+mm_modem_messaging_get_sms_finish (MMModemMessaging *self,
+                                   GAsyncResult *res,
+                                   GError **error)
+{
+    MMSms *sms;
+
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    sms = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+    g_return_val_if_fail (sms != NULL, NULL);
+
+    return MM_SMS (g_object_ref (sms));
+}
+
+static void
+get_sms_ready (GDBusConnection *connection,
+               GAsyncResult *res,
+               GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+    GObject *sms;
+    GObject *source_object;
+
+    source_object = g_async_result_get_source_object (res);
+    sms = g_async_initable_new_finish (G_ASYNC_INITABLE (source_object), res, &error);
+    g_object_unref (source_object);
+
+    if (error)
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   sms,
+                                                   (GDestroyNotify)g_object_unref);
+
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+/**
+ * mm_modem_messaging_get_sms:
+ * @self: A #MMModemMessaging.
+ * @sms_path: Path of the SMS, as given by mm_modem_messaging_get_message_paths().
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously creates the #MMSms object for a single message in the modem.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_messaging_get_sms_finish() to get the result of the operation.
+ *
+ * See mm_modem_messaging_get_sms_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_messaging_get_sms (MMModemMessaging *self,
+                            const gchar *sms_path,
+                            GCancellable *cancellable,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    g_return_if_fail (MM_IS_MODEM_MESSAGING (self));
+    g_return_if_fail (sms_path != NULL);
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        mm_modem_messaging_get_sms);
+
+    g_async_initable_new_async (MM_TYPE_SMS,
+                                G_PRIORITY_DEFAULT,
+                                cancellable,
+                                (GAsyncReadyCallback)get_sms_ready,
+                                result,
+                                "g-flags",          G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                                "g-name",           MM_DBUS_SERVICE,
+                                "g-connection",     g_dbus_proxy_get_connection (G_DBUS_PROXY (self)),
+                                "g-object-path",    sms_path,
+                                "g-interface-name", "org.freedesktop.ModemManager1.Sms",
+                                NULL);
+}
+
+/**
+ * mm_modem_messaging_get_sms_sync:
+ * @self: A #MMModemMessaging.
+ * @sms_path: Path of the SMS, as given by mm_modem_messaging_get_message_paths().
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously creates the #MMSms object for a single message in the modem.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_messaging_get_sms()
+ * for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): a #MMSms or #NULL if @error is set. The returned value should be freed with g_object_unref().
+ */
+MMSms *
+mm_modem_messaging_get_sms_sync (MMModemMessaging *self,
+                                 const gchar *sms_path,
+                                 GCancellable *cancellable,
+                                 GError **error)
+{
+    GObject *sms;
+
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+    g_return_val_if_fail (sms_path != NULL, NULL);
+
+    sms = g_initable_new (MM_TYPE_SMS,
+                          cancellable,
+                          error,
+                          "g-flags",          G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                          "g-name",           MM_DBUS_SERVICE,
+                          "g-connection",     g_dbus_proxy_get_connection (G_DBUS_PROXY (self)),
+                          "g-object-path",    sms_path,
+                          "g-interface-name", "org.freedesktop.ModemManager1.Sms",
+                          NULL);
+
+    return (sms ? MM_SMS (sms) : NULL);
+}
+
+/*****************************************************************************/
+
+static GVariant *
+build_list_filter (MMSmsState state,
+                   MMSmsStorage storage,
+                   guint64 timestamp_from,
+                   guint64 timestamp_to)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    if (state != MM_SMS_STATE_UNKNOWN)
+        g_variant_builder_add (&builder, "{sv}", "state", g_variant_new_uint32 (state));
+    if (storage != MM_SMS_STORAGE_UNKNOWN)
+        g_variant_builder_add (&builder, "{sv}", "storage", g_variant_new_uint32 (storage));
+    if (timestamp_from)
+        g_variant_builder_add (&builder, "{sv}", "timestamp-from", g_variant_new_uint64 (timestamp_from));
+    if (timestamp_to)
+        g_variant_builder_add (&builder, "{sv}", "timestamp-to", g_variant_new_uint64 (timestamp_to));
+    return g_variant_builder_end (&builder);
+}
+
+/**
+ * mm_modem_messaging_list_paged_finish:
+ * @self: A #MMModemMessaging.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_messaging_list_paged().
+ * @total: (out) (allow-none): Return location for the number of messages matching the filters, or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_messaging_list_paged().
+ *
+ * Returns: (transfer full): The DBus paths of the #MMSms objects in the page, or %NULL if @error is set. The returned value should be freed with g_strfreev().
+ */
+gchar **
+mm_modem_messaging_list_paged_finish (MMModemMessaging *self,
+                                      GAsyncResult *res,
+                                      guint *total,
+                                      GError **error)
+{
+    gchar **paths = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+
+    if (!mm_gdbus_modem_messaging_call_list_paged_finish (MM_GDBUS_MODEM_MESSAGING (self),
+                                                          &paths,
+                                                          total,
+                                                          res,
+                                                          error))
+        return NULL;
+
+    return paths;
+}
+
+/**
+ * mm_modem_messaging_list_paged:
+ * @self: A #MMModemMessaging.
+ * @offset: Number of matching messages to skip.
+ * @limit: Maximum number of messages to list, or 0 for no limit.
+ * @state: A #MMSmsState to filter the messages with, or %MM_SMS_STATE_UNKNOWN to list messages in any state.
+ * @storage: A #MMSmsStorage to filter the messages with, or %MM_SMS_STORAGE_UNKNOWN to list messages in any storage.
+ * @timestamp_from: The earliest timestamp of the messages, in seconds since the epoch, or 0.
+ * @timestamp_to: The latest timestamp of the messages, in seconds since the epoch, or 0.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously lists the DBus paths of a subset of the #MMSms objects in
+ * the modem, oldest first. Only the messages in the requested page are
+ * transferred, and a single #MMSms may then be created on demand with
+ * mm_modem_messaging_get_sms().
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_messaging_list_paged_finish() to get the result of the operation.
+ *
+ * See mm_modem_messaging_list_paged_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_messaging_list_paged (MMModemMessaging *self,
+                               guint offset,
+                               guint limit,
+                               MMSmsState state,
+                               MMSmsStorage storage,
+                               guint64 timestamp_from,
+                               guint64 timestamp_to,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_MESSAGING (self));
+
+    mm_gdbus_modem_messaging_call_list_paged (MM_GDBUS_MODEM_MESSAGING (self),
+                                              offset,
+                                              limit,
+                                              build_list_filter (state, storage, timestamp_from, timestamp_to),
+                                              cancellable,
+                                              callback,
+                                              user_data);
+}
+
+/**
+ * mm_modem_messaging_list_paged_sync:
+ * @self: A #MMModemMessaging.
+ * @offset: Number of matching messages to skip.
+ * @limit: Maximum number of messages to list, or 0 for no limit.
+ * @state: A #MMSmsState to filter the messages with, or %MM_SMS_STATE_UNKNOWN to list messages in any state.
+ * @storage: A #MMSmsStorage to filter the messages with, or %MM_SMS_STORAGE_UNKNOWN to list messages in any storage.
+ * @timestamp_from: The earliest timestamp of the messages, in seconds since the epoch, or 0.
+ * @timestamp_to: The latest timestamp of the messages, in seconds since the epoch, or 0.
+ * @total: (out) (allow-none): Return location for the number of messages matching the filters, or %NULL.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously lists the DBus paths of a subset of the #MMSms objects in
+ * the modem, oldest first.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_messaging_list_paged()
+ * for the asynchronous version of this method.
+ *
+ * Returns: (transfer full): The DBus paths of the #MMSms objects in the page, or %NULL if @error is set. The returned value should be freed with g_strfreev().
+ */
+gchar **
+mm_modem_messaging_list_paged_sync (MMModemMessaging *self,
+                                    guint offset,
+                                    guint limit,
+                                    MMSmsState state,
+                                    MMSmsStorage storage,
+                                    guint64 timestamp_from,
+                                    guint64 timestamp_to,
+                                    guint *total,
+                                    GCancellable *cancellable,
+                                    GError **error)
+{
+    gchar **paths = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), NULL);
+
+    if (!mm_gdbus_modem_messaging_call_list_paged_sync (MM_GDBUS_MODEM_MESSAGING (self),
+                                                        offset,
+                                                        limit,
+                                                        build_list_filter (state, storage, timestamp_from, timestamp_to),
+                                                        &paths,
+                                                        total,
+                                                        cancellable,
+                                                        error))
+        return NULL;
+
+    return paths;
+}
+
+/*****************************************************************************/
+
 typedef struct {
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
@@ -708,6 +1037,92 @@ mm_modem_messaging_delete_sync (MMModemMessaging *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_messaging_delete_all_finish:
+ * @self: A #MMModemMessaging.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_messaging_delete_all().
+ * @deleted: (out) (allow-none): Return location for the number of messages deleted, or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_messaging_delete_all().
+ *
+ * Returns: %TRUE if the messages were deleted, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_messaging_delete_all_finish (MMModemMessaging *self,
+                                      GAsyncResult *res,
+                                      guint *deleted,
+                                      GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), FALSE);
+
+    return mm_gdbus_modem_messaging_call_delete_all_finish (MM_GDBUS_MODEM_MESSAGING (self), deleted, res, error);
+}
+
+/**
+ * mm_modem_messaging_delete_all:
+ * @self: A #MMModemMessaging.
+ * @storage: The #MMSmsStorage to clear, or %MM_SMS_STORAGE_UNKNOWN for all storages.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously deletes all the #MMSms in the given storage of the modem.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_messaging_delete_all_finish() to get the result of the operation.
+ *
+ * See mm_modem_messaging_delete_all_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_messaging_delete_all (MMModemMessaging *self,
+                               MMSmsStorage storage,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_MESSAGING (self));
+
+    mm_gdbus_modem_messaging_call_delete_all (MM_GDBUS_MODEM_MESSAGING (self),
+                                              (guint)storage,
+                                              cancellable,
+                                              callback,
+                                              user_data);
+}
+
+/**
+ * mm_modem_messaging_delete_all_sync:
+ * @self: A #MMModemMessaging.
+ * @storage: The #MMSmsStorage to clear, or %MM_SMS_STORAGE_UNKNOWN for all storages.
+ * @deleted: (out) (allow-none): Return location for the number of messages deleted, or %NULL.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously deletes all the #MMSms in the given storage of the modem.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_messaging_delete_all()
+ * for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the messages were deleted, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_messaging_delete_all_sync (MMModemMessaging *self,
+                                    MMSmsStorage storage,
+                                    guint *deleted,
+                                    GCancellable *cancellable,
+                                    GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_MESSAGING (self), FALSE);
+
+    return mm_gdbus_modem_messaging_call_delete_all_sync (MM_GDBUS_MODEM_MESSAGING (self),
+                                                          (guint)storage,
+                                                          deleted,
+                                                          cancellable,
+                                                          error);
+}
+
+/*****************************************************************************/
+
 static void
 mm_modem_messaging_init (MMModemMessaging *self)
 {
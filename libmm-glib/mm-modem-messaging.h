@@ -78,6 +78,9 @@ gboolean     mm_modem_messaging_peek_supported_storages (MMModemMessaging *self,
 
 MMSmsStorage mm_modem_messaging_get_default_storage    (MMModemMessaging *self);
 
+const gchar * const *mm_modem_messaging_get_message_paths (MMModemMessaging *self);
+gchar              **mm_modem_messaging_dup_message_paths (MMModemMessaging *self);
+
 void   mm_modem_messaging_create        (MMModemMessaging *self,
                                          MMSmsProperties *properties,
                                          GCancellable *cancellable,
@@ -102,6 +105,44 @@ GList *mm_modem_messaging_list_sync   (MMModemMessaging *self,
                                        GCancellable *cancellable,
                                        GError **error);
 
+void   mm_modem_messaging_get_sms        (MMModemMessaging *self,
+                                          const gchar *sms_path,
+                                          GCancellable *cancellable,
+                                          GAsyncReadyCallback callback,
+                                          gpointer user_data);
+MMSms *mm_modem_messaging_get_sms_finish (MMModemMessaging *self,
+                                          GAsyncResult *res,
+                                          GError **error);
+MMSms *mm_modem_messaging_get_sms_sync   (MMModemMessaging *self,
+                                          const gchar *sms_path,
+                                          GCancellable *cancellable,
+                                          GError **error);
+
+void    mm_modem_messaging_list_paged        (MMModemMessaging *self,
+                                              guint offset,
+                                              guint limit,
+                                              MMSmsState state,
+                                              MMSmsStorage storage,
+                                              guint64 timestamp_from,
+                                              guint64 timestamp_to,
+                                              GCancellable *cancellable,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data);
+gchar **mm_modem_messaging_list_paged_finish (MMModemMessaging *self,
+                                              GAsyncResult *res,
+                                              guint *total,
+                                              GError **error);
+gchar **mm_modem_messaging_list_paged_sync   (MMModemMessaging *self,
+                                              guint offset,
+                                              guint limit,
+                                              MMSmsState state,
+                                              MMSmsStorage storage,
+                                              guint64 timestamp_from,
+                                              guint64 timestamp_to,
+                                              guint *total,
+                                              GCancellable *cancellable,
+                                              GError **error);
+
 void     mm_modem_messaging_delete        (MMModemMessaging *self,
                                            const gchar *sms,
                                            GCancellable *cancellable,
@@ -115,6 +156,21 @@ gboolean mm_modem_messaging_delete_sync   (MMModemMessaging *self,
                                            GCancellable *cancellable,
                                            GError **error);
 
+void     mm_modem_messaging_delete_all        (MMModemMessaging *self,
+                                               MMSmsStorage storage,
+                                               GCancellable *cancellable,
+                                               GAsyncReadyCallback callback,
+                                               gpointer user_data);
+gboolean mm_modem_messaging_delete_all_finish (MMModemMessaging *self,
+                                               GAsyncResult *res,
+                                               guint *deleted,
+                                               GError **error);
+gboolean mm_modem_messaging_delete_all_sync   (MMModemMessaging *self,
+                                               MMSmsStorage storage,
+                                               guint *deleted,
+                                               GCancellable *cancellable,
+                                               GError **error);
+
 G_END_DECLS
 
 #endif /* _MM_MODEM_MESSAGING_H_ */
@@ -176,6 +176,198 @@ mm_modem_signal_setup_sync (MMModemSignal *self,
 
 /*****************************************************************************/
 
+/**
+ * mm_modem_signal_setup_thresholds_finish:
+ * @self: A #MMModemSignal.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_signal_setup_thresholds().
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_signal_setup_thresholds().
+ *
+ * Returns: %TRUE if the setup was successful, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_signal_setup_thresholds_finish (MMModemSignal *self,
+                                         GAsyncResult *res,
+                                         GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_SIGNAL (self), FALSE);
+
+    return mm_gdbus_modem_signal_call_setup_thresholds_finish (MM_GDBUS_MODEM_SIGNAL (self), res, error);
+}
+
+/**
+ * mm_modem_signal_setup_thresholds:
+ * @self: A #MMModemSignal.
+ * @settings: A #GVariant of type "a{sv}" with the threshold of each signal metric, e.g. <literal>"rsrp"</literal>.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously setups the minimum change required in the extended signal
+ * quality values before they are updated.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_signal_setup_thresholds_finish() to get the result of the operation.
+ *
+ * See mm_modem_signal_setup_thresholds_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_signal_setup_thresholds (MMModemSignal *self,
+                                  GVariant *settings,
+                                  GCancellable *cancellable,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_SIGNAL (self));
+
+    mm_gdbus_modem_signal_call_setup_thresholds (MM_GDBUS_MODEM_SIGNAL (self), settings, cancellable, callback, user_data);
+}
+
+/**
+ * mm_modem_signal_setup_thresholds_sync:
+ * @self: A #MMModemSignal.
+ * @settings: A #GVariant of type "a{sv}" with the threshold of each signal metric, e.g. <literal>"rsrp"</literal>.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously setups the minimum change required in the extended signal
+ * quality values before they are updated.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_signal_setup_thresholds()
+ * for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the setup was successful, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_signal_setup_thresholds_sync (MMModemSignal *self,
+                                       GVariant *settings,
+                                       GCancellable *cancellable,
+                                       GError **error)
+{
+    g_return_val_if_fail (MM_IS_MODEM_SIGNAL (self), FALSE);
+
+    return mm_gdbus_modem_signal_call_setup_thresholds_sync (MM_GDBUS_MODEM_SIGNAL (self), settings, cancellable, error);
+}
+
+/*****************************************************************************/
+
+/**
+ * mm_modem_signal_get_history_finish:
+ * @self: A #MMModemSignal.
+ * @res: The #GAsyncResult obtained from the #GAsyncReadyCallback passed to mm_modem_signal_get_history().
+ * @out_aggregates: (out) (allow-none) (transfer full): Return location for a #GVariant of type "a(usudddddd)" with the statistics of each metric, or %NULL.
+ * @out_samples: (out) (allow-none) (transfer full): Return location for a #GVariant of type "a(uxddddddd)" with the raw samples, or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Finishes an operation started with mm_modem_signal_get_history().
+ *
+ * Returns: %TRUE if the history was retrieved, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_signal_get_history_finish (MMModemSignal *self,
+                                    GAsyncResult *res,
+                                    GVariant **out_aggregates,
+                                    GVariant **out_samples,
+                                    GError **error)
+{
+    GVariant *aggregates = NULL;
+    GVariant *samples = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_SIGNAL (self), FALSE);
+
+    if (!mm_gdbus_modem_signal_call_get_history_finish (MM_GDBUS_MODEM_SIGNAL (self), &aggregates, &samples, res, error))
+        return FALSE;
+
+    if (out_aggregates)
+        *out_aggregates = aggregates;
+    else
+        g_variant_unref (aggregates);
+    if (out_samples)
+        *out_samples = samples;
+    else
+        g_variant_unref (samples);
+    return TRUE;
+}
+
+/**
+ * mm_modem_signal_get_history:
+ * @self: A #MMModemSignal.
+ * @window: Length of the window to report, in seconds, or 0 for all the stored samples.
+ * @include_samples: Whether the raw samples should also be reported.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @callback: A #GAsyncReadyCallback to call when the request is satisfied or %NULL.
+ * @user_data: User data to pass to @callback.
+ *
+ * Asynchronously gets statistics of the extended signal quality values
+ * retrieved over the last @window seconds.
+ *
+ * When the operation is finished, @callback will be invoked in the <link linkend="g-main-context-push-thread-default">thread-default main loop</link> of the thread you are calling this method from.
+ * You can then call mm_modem_signal_get_history_finish() to get the result of the operation.
+ *
+ * See mm_modem_signal_get_history_sync() for the synchronous, blocking version of this method.
+ */
+void
+mm_modem_signal_get_history (MMModemSignal *self,
+                             guint window,
+                             gboolean include_samples,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
+{
+    g_return_if_fail (MM_IS_MODEM_SIGNAL (self));
+
+    mm_gdbus_modem_signal_call_get_history (MM_GDBUS_MODEM_SIGNAL (self), window, include_samples, cancellable, callback, user_data);
+}
+
+/**
+ * mm_modem_signal_get_history_sync:
+ * @self: A #MMModemSignal.
+ * @window: Length of the window to report, in seconds, or 0 for all the stored samples.
+ * @include_samples: Whether the raw samples should also be reported.
+ * @out_aggregates: (out) (allow-none) (transfer full): Return location for a #GVariant of type "a(usudddddd)" with the statistics of each metric, or %NULL.
+ * @out_samples: (out) (allow-none) (transfer full): Return location for a #GVariant of type "a(uxddddddd)" with the raw samples, or %NULL.
+ * @cancellable: (allow-none): A #GCancellable or %NULL.
+ * @error: Return location for error or %NULL.
+ *
+ * Synchronously gets statistics of the extended signal quality values
+ * retrieved over the last @window seconds.
+ *
+ * The calling thread is blocked until a reply is received. See mm_modem_signal_get_history()
+ * for the asynchronous version of this method.
+ *
+ * Returns: %TRUE if the history was retrieved, %FALSE if @error is set.
+ */
+gboolean
+mm_modem_signal_get_history_sync (MMModemSignal *self,
+                                  guint window,
+                                  gboolean include_samples,
+                                  GVariant **out_aggregates,
+                                  GVariant **out_samples,
+                                  GCancellable *cancellable,
+                                  GError **error)
+{
+    GVariant *aggregates = NULL;
+    GVariant *samples = NULL;
+
+    g_return_val_if_fail (MM_IS_MODEM_SIGNAL (self), FALSE);
+
+    if (!mm_gdbus_modem_signal_call_get_history_sync (MM_GDBUS_MODEM_SIGNAL (self), window, include_samples, &aggregates, &samples, cancellable, error))
+        return FALSE;
+
+    if (out_aggregates)
+        *out_aggregates = aggregates;
+    else
+        g_variant_unref (aggregates);
+    if (out_samples)
+        *out_samples = samples;
+    else
+        g_variant_unref (samples);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 /**
  * mm_modem_signal_get_rate:
  * @self: A #MMModemSignal.
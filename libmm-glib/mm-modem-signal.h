@@ -81,6 +81,38 @@ gboolean mm_modem_signal_setup_sync   (MMModemSignal *self,
                                        GCancellable *cancellable,
                                        GError **error);
 
+void     mm_modem_signal_setup_thresholds        (MMModemSignal *self,
+                                                  GVariant *settings,
+                                                  GCancellable *cancellable,
+                                                  GAsyncReadyCallback callback,
+                                                  gpointer user_data);
+gboolean mm_modem_signal_setup_thresholds_finish (MMModemSignal *self,
+                                                  GAsyncResult *res,
+                                                  GError **error);
+gboolean mm_modem_signal_setup_thresholds_sync   (MMModemSignal *self,
+                                                  GVariant *settings,
+                                                  GCancellable *cancellable,
+                                                  GError **error);
+
+void     mm_modem_signal_get_history        (MMModemSignal *self,
+                                             guint window,
+                                             gboolean include_samples,
+                                             GCancellable *cancellable,
+                                             GAsyncReadyCallback callback,
+                                             gpointer user_data);
+gboolean mm_modem_signal_get_history_finish (MMModemSignal *self,
+                                             GAsyncResult *res,
+                                             GVariant **out_aggregates,
+                                             GVariant **out_samples,
+                                             GError **error);
+gboolean mm_modem_signal_get_history_sync   (MMModemSignal *self,
+                                             guint window,
+                                             gboolean include_samples,
+                                             GVariant **out_aggregates,
+                                             GVariant **out_samples,
+                                             GCancellable *cancellable,
+                                             GError **error);
+
 MMSignal *mm_modem_signal_get_cdma (MMModemSignal *self);
 MMSignal *mm_modem_signal_peek_cdma (MMModemSignal *self);
 
@@ -59,6 +59,19 @@ struct _MMModemPrivate {
     guint supported_modes_id;
     GArray *supported_modes;
 
+    /* Signal Quality */
+    GMutex signal_quality_mutex;
+    guint signal_quality_id;
+    guint signal_quality;
+    gboolean signal_quality_recent;
+
+    /* Current Modes */
+    GMutex current_modes_mutex;
+    guint current_modes_id;
+    gboolean current_modes_valid;
+    MMModemMode current_modes_allowed;
+    MMModemMode current_modes_preferred;
+
     /* Supported Capabilities */
     GMutex supported_capabilities_mutex;
     guint supported_capabilities_id;
@@ -1147,6 +1160,28 @@ mm_modem_get_access_technologies (MMModem *self)
 
 /*****************************************************************************/
 
+static void
+signal_quality_update (MMModem *self,
+                       GVariant *variant)
+{
+    self->priv->signal_quality = 0;
+    self->priv->signal_quality_recent = FALSE;
+    if (variant)
+        g_variant_get (variant,
+                       "(ub)",
+                       &self->priv->signal_quality,
+                       &self->priv->signal_quality_recent);
+}
+
+static void
+signal_quality_updated (MMModem *self,
+                        GParamSpec *pspec)
+{
+    g_mutex_lock (&self->priv->signal_quality_mutex);
+    signal_quality_update (self, mm_gdbus_modem_get_signal_quality (MM_GDBUS_MODEM (self)));
+    g_mutex_unlock (&self->priv->signal_quality_mutex);
+}
+
 /**
  * mm_modem_get_signal_quality:
  * @self: A #MMModem.
@@ -1163,23 +1198,36 @@ guint
 mm_modem_get_signal_quality (MMModem *self,
                              gboolean *recent)
 {
-    GVariant *variant;
-    gboolean is_recent = FALSE;
-    guint quality = 0;
+    guint quality;
 
     g_return_val_if_fail (MM_IS_MODEM (self), 0);
 
-    variant = mm_gdbus_modem_dup_signal_quality (MM_GDBUS_MODEM (self));
-    if (variant) {
-        g_variant_get (variant,
-                       "(ub)",
-                       &quality,
-                       &is_recent);
-        g_variant_unref (variant);
+    g_mutex_lock (&self->priv->signal_quality_mutex);
+    {
+        /* If this is the first time ever asking for the value, setup the
+         * update listener and the initial value, if any. */
+        if (!self->priv->signal_quality_id) {
+            GVariant *variant;
+
+            variant = mm_gdbus_modem_dup_signal_quality (MM_GDBUS_MODEM (self));
+            signal_quality_update (self, variant);
+            if (variant)
+                g_variant_unref (variant);
+
+            /* No need to clear this signal connection when freeing self */
+            self->priv->signal_quality_id =
+                g_signal_connect (self,
+                                  "notify::signal-quality",
+                                  G_CALLBACK (signal_quality_updated),
+                                  NULL);
+        }
+
+        quality = self->priv->signal_quality;
+        if (recent)
+            *recent = self->priv->signal_quality_recent;
     }
+    g_mutex_unlock (&self->priv->signal_quality_mutex);
 
-    if (recent)
-        *recent = is_recent;
     return quality;
 }
 
@@ -1303,6 +1351,27 @@ mm_modem_peek_supported_modes (MMModem *self,
 
 /*****************************************************************************/
 
+static void
+current_modes_update (MMModem *self,
+                      GVariant *variant)
+{
+    self->priv->current_modes_valid = !!variant;
+    if (variant)
+        g_variant_get (variant,
+                       "(uu)",
+                       &self->priv->current_modes_allowed,
+                       &self->priv->current_modes_preferred);
+}
+
+static void
+current_modes_updated (MMModem *self,
+                       GParamSpec *pspec)
+{
+    g_mutex_lock (&self->priv->current_modes_mutex);
+    current_modes_update (self, mm_gdbus_modem_get_current_modes (MM_GDBUS_MODEM (self)));
+    g_mutex_unlock (&self->priv->current_modes_mutex);
+}
+
 /**
  * mm_modem_get_current_modes:
  * @self: A #MMModem.
@@ -1320,23 +1389,41 @@ mm_modem_get_current_modes (MMModem *self,
                             MMModemMode *allowed,
                             MMModemMode *preferred)
 {
-    GVariant *variant;
+    gboolean ret;
 
     g_return_val_if_fail (MM_IS_MODEM (self), FALSE);
     g_return_val_if_fail (allowed != NULL, FALSE);
     g_return_val_if_fail (preferred != NULL, FALSE);
 
-    variant = mm_gdbus_modem_dup_current_modes (MM_GDBUS_MODEM (self));
-    if (variant) {
-        g_variant_get (variant,
-                       "(uu)",
-                       allowed,
-                       preferred);
-        g_variant_unref (variant);
-        return TRUE;
+    g_mutex_lock (&self->priv->current_modes_mutex);
+    {
+        /* If this is the first time ever asking for the value, setup the
+         * update listener and the initial value, if any. */
+        if (!self->priv->current_modes_id) {
+            GVariant *variant;
+
+            variant = mm_gdbus_modem_dup_current_modes (MM_GDBUS_MODEM (self));
+            current_modes_update (self, variant);
+            if (variant)
+                g_variant_unref (variant);
+
+            /* No need to clear this signal connection when freeing self */
+            self->priv->current_modes_id =
+                g_signal_connect (self,
+                                  "notify::current-modes",
+                                  G_CALLBACK (current_modes_updated),
+                                  NULL);
+        }
+
+        ret = self->priv->current_modes_valid;
+        if (ret) {
+            *allowed = self->priv->current_modes_allowed;
+            *preferred = self->priv->current_modes_preferred;
+        }
     }
+    g_mutex_unlock (&self->priv->current_modes_mutex);
 
-    return FALSE;
+    return ret;
 }
 
 /*****************************************************************************/
@@ -2984,6 +3071,8 @@ mm_modem_init (MMModem *self)
                                               MMModemPrivate);
     g_mutex_init (&self->priv->unlock_retries_mutex);
     g_mutex_init (&self->priv->supported_modes_mutex);
+    g_mutex_init (&self->priv->signal_quality_mutex);
+    g_mutex_init (&self->priv->current_modes_mutex);
     g_mutex_init (&self->priv->supported_capabilities_mutex);
     g_mutex_init (&self->priv->supported_bands_mutex);
     g_mutex_init (&self->priv->current_bands_mutex);
@@ -2996,6 +3085,8 @@ finalize (GObject *object)
 
     g_mutex_clear (&self->priv->unlock_retries_mutex);
     g_mutex_clear (&self->priv->supported_modes_mutex);
+    g_mutex_clear (&self->priv->signal_quality_mutex);
+    g_mutex_clear (&self->priv->current_modes_mutex);
     g_mutex_clear (&self->priv->supported_capabilities_mutex);
     g_mutex_clear (&self->priv->supported_bands_mutex);
     g_mutex_clear (&self->priv->current_bands_mutex);
@@ -85,6 +85,9 @@ struct _MMSimpleStatusPrivate {
     guint modem_cdma_sid;
     /* NID, signature 'u' */
     guint modem_cdma_nid;
+
+    /* Dictionary built from the current values, dropped on any change */
+    GVariant *dictionary;
 };
 
 /*****************************************************************************/
@@ -326,17 +329,11 @@ mm_simple_status_get_cdma_nid (MMSimpleStatus *self)
 
 /*****************************************************************************/
 
-GVariant *
-mm_simple_status_get_dictionary (MMSimpleStatus *self)
+static GVariant *
+build_dictionary (MMSimpleStatus *self)
 {
     GVariantBuilder builder;
 
-    /* Allow NULL */
-    if (!self)
-        return NULL;
-
-    g_return_val_if_fail (MM_IS_SIMPLE_STATUS (self), NULL);
-
     g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
     g_variant_builder_add (&builder,
                            "{sv}",
@@ -406,6 +403,23 @@ mm_simple_status_get_dictionary (MMSimpleStatus *self)
     return g_variant_ref_sink (g_variant_builder_end (&builder));
 }
 
+/* The dictionary is only rebuilt after one of the properties changes, so
+ * repeated calls just return a new reference to the same variant */
+GVariant *
+mm_simple_status_get_dictionary (MMSimpleStatus *self)
+{
+    /* Allow NULL */
+    if (!self)
+        return NULL;
+
+    g_return_val_if_fail (MM_IS_SIMPLE_STATUS (self), NULL);
+
+    if (!self->priv->dictionary)
+        self->priv->dictionary = build_dictionary (self);
+
+    return g_variant_ref (self->priv->dictionary);
+}
+
 /*****************************************************************************/
 
 MMSimpleStatus *
@@ -502,6 +516,11 @@ set_property (GObject *object,
 {
     MMSimpleStatus *self = MM_SIMPLE_STATUS (object);
 
+    if (self->priv->dictionary) {
+        g_variant_unref (self->priv->dictionary);
+        self->priv->dictionary = NULL;
+    }
+
     switch (prop_id) {
     case PROP_STATE:
         self->priv->state = g_value_get_enum (value);
@@ -637,6 +656,8 @@ finalize (GObject *object)
         g_array_unref (self->priv->current_bands_array);
     g_free (self->priv->modem_3gpp_operator_code);
     g_free (self->priv->modem_3gpp_operator_name);
+    if (self->priv->dictionary)
+        g_variant_unref (self->priv->dictionary);
 
     G_OBJECT_CLASS (mm_simple_status_parent_class)->finalize (object);
 }
@@ -13,6 +13,7 @@
  * Copyright (C) 2012 Google, Inc.
  */
 
+#include <string.h>
 #include <glib-object.h>
 
 #include <libmm-glib.h>
@@ -486,8 +487,257 @@ field_parser_double (void)
     g_free (str);
 }
 
+/********************* HEX CONVERSION TESTS *********************/
+
+/* Plain one-nibble-at-a-time implementations to compare against */
+
+static gint
+reference_hex2num (gchar c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static gboolean
+reference_hexstr2bin (const gchar *hex,
+                      gsize        len,
+                      guint8      *bin)
+{
+    gsize i;
+
+    for (i = 0; i < len; i += 2) {
+        gint a, b;
+
+        a = reference_hex2num (hex[i]);
+        b = reference_hex2num (hex[i + 1]);
+        if (a < 0 || b < 0)
+            return FALSE;
+        bin[i / 2] = (a << 4) | b;
+    }
+    return TRUE;
+}
+
+static gchar *
+reference_bin2hexstr (const guint8 *bin,
+                      gsize         len)
+{
+    GString *ret;
+    gsize i;
+
+    ret = g_string_sized_new (len * 2 + 1);
+    for (i = 0; i < len; i++)
+        g_string_append_printf (ret, "%.2X", bin[i]);
+    return g_string_free (ret, FALSE);
+}
+
+/* Lengths around the 8-byte blocks */
+#define HEX_TEST_MAX_LEN 67
+
+static void
+hex_test_bin2hexstr (void)
+{
+    guint8 bin[HEX_TEST_MAX_LEN + 1];
+    gchar hex[2 * HEX_TEST_MAX_LEN + 3];
+    gsize len;
+    gsize offset;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (bin); i++)
+        bin[i] = (guint8) g_test_rand_int ();
+
+    /* All byte values */
+    for (i = 0; i < 256; i++) {
+        guint8 byte = (guint8) i;
+        gchar *expected;
+        gchar *str;
+
+        expected = reference_bin2hexstr (&byte, 1);
+        str = mm_utils_bin2hexstr (&byte, 1);
+        g_assert_cmpstr (str, ==, expected);
+        g_free (str);
+        g_free (expected);
+    }
+
+    /* Every length, from aligned and unaligned buffers */
+    for (offset = 0; offset < 2; offset++) {
+        for (len = 0; len + offset <= HEX_TEST_MAX_LEN + 1; len++) {
+            gchar *expected;
+            gchar *str;
+
+            expected = reference_bin2hexstr (bin + offset, len);
+
+            str = mm_utils_bin2hexstr (bin + offset, len);
+            g_assert_cmpstr (str, ==, expected);
+            g_free (str);
+
+            mm_utils_bin2hexstr_into (bin + offset, len, hex + offset);
+            g_assert_cmpstr (hex + offset, ==, expected);
+
+            g_free (expected);
+        }
+    }
+}
+
+static void
+hex_test_hexstr2bin (void)
+{
+    static const gchar digits[] = "0123456789abcdefABCDEF";
+    gchar hex[2 * HEX_TEST_MAX_LEN + 2];
+    guint8 expected[HEX_TEST_MAX_LEN];
+    guint8 bin[HEX_TEST_MAX_LEN + 1];
+    gsize len;
+    gsize offset;
+    guint i;
+
+    /* Mixed case digits */
+    for (i = 0; i < G_N_ELEMENTS (hex) - 1; i++)
+        hex[i] = digits[g_test_rand_int_range (0, sizeof (digits) - 1)];
+    hex[i] = '\0';
+
+    for (offset = 0; offset < 2; offset++) {
+        for (len = 0; len <= HEX_TEST_MAX_LEN; len++) {
+            gchar *str;
+            gchar *out;
+            gsize out_len = 0;
+
+            g_assert (reference_hexstr2bin (hex + offset, 2 * len, expected));
+
+            g_assert_cmpint (mm_utils_hexstr2bin_into (hex + offset, 2 * len, bin + offset, len), ==, (gssize) len);
+            g_assert (memcmp (bin + offset, expected, len) == 0);
+
+            str = g_strndup (hex + offset, 2 * len);
+            out = mm_utils_hexstr2bin (str, &out_len);
+            g_assert (out != NULL);
+            g_assert_cmpuint (out_len, ==, len);
+            g_assert (memcmp (out, expected, len) == 0);
+            g_assert_cmpint (out[len], ==, '\0');
+            g_free (out);
+            g_free (str);
+        }
+    }
+
+    /* Odd length and not enough room */
+    g_assert_cmpint (mm_utils_hexstr2bin_into ("ABC", 3, bin, sizeof (bin)), ==, -1);
+    g_assert_cmpint (mm_utils_hexstr2bin_into ("ABCD", 4, bin, 1), ==, -1);
+}
+
+static void
+hex_test_hexstr2bin_invalid (void)
+{
+    static const gchar invalid[] = { 'g', 'G', 'x', ' ', '/', ':', '@', '`', '\xff' };
+    gchar hex[2 * HEX_TEST_MAX_LEN + 1];
+    guint8 bin[HEX_TEST_MAX_LEN];
+    gsize len;
+    gsize pos;
+    guint i;
+
+    for (len = 1; len <= HEX_TEST_MAX_LEN; len++) {
+        for (pos = 0; pos < 2 * len; pos++) {
+            for (i = 0; i < G_N_ELEMENTS (invalid); i++) {
+                gsize out_len = 0;
+
+                memset (hex, 'a', 2 * len);
+                hex[2 * len] = '\0';
+                hex[pos] = invalid[i];
+
+                g_assert (!reference_hexstr2bin (hex, 2 * len, bin));
+                g_assert_cmpint (mm_utils_hexstr2bin_into (hex, 2 * len, bin, sizeof (bin)), ==, -1);
+                g_assert (mm_utils_hexstr2bin (hex, &out_len) == NULL);
+                g_assert (!mm_utils_ishexstr (hex));
+            }
+        }
+    }
+}
+
 /**************************************************************/
 
+/********************* GPS RAW LOCATION TESTS *********************/
+
+static void
+gps_raw_test_gga (void)
+{
+    MMLocationGpsRaw *raw;
+
+    raw = mm_location_gps_raw_new ();
+
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"));
+    g_assert_cmpstr (mm_location_gps_raw_get_utc_time (raw), ==, "092750.000");
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_latitude (raw) - (53.0 + 21.6802 / 60.0)), <, 1e-9);
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_longitude (raw) + (6.0 + 30.3372 / 60.0)), <, 1e-9);
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_altitude (raw) - 61.7), <, 1e-9);
+
+    /* Other talkers, southern and eastern hemispheres, no altitude */
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GNGGA,120000.00,3352.1200,S,15112.6000,E,1,12,0.8,,M,,M,,*5A"));
+    g_assert_cmpstr (mm_location_gps_raw_get_utc_time (raw), ==, "120000.00");
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_latitude (raw) + (33.0 + 52.12 / 60.0)), <, 1e-9);
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_longitude (raw) - (151.0 + 12.6 / 60.0)), <, 1e-9);
+    g_assert_cmpfloat (mm_location_gps_raw_get_altitude (raw), ==, MM_LOCATION_ALTITUDE_UNKNOWN);
+
+    /* No fix */
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GLGGA,120001.00,,,,,0,0,,,M,,M,,*66"));
+    g_assert_cmpfloat (mm_location_gps_raw_get_latitude (raw), ==, MM_LOCATION_LATITUDE_UNKNOWN);
+    g_assert_cmpfloat (mm_location_gps_raw_get_longitude (raw), ==, MM_LOCATION_LONGITUDE_UNKNOWN);
+    g_assert (mm_location_gps_raw_get_dictionary (raw) == NULL);
+
+    /* Out of range minutes */
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GPGGA,120002.00,5361.0000,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*00"));
+    g_assert_cmpfloat (mm_location_gps_raw_get_latitude (raw), ==, MM_LOCATION_LATITUDE_UNKNOWN);
+
+    g_object_unref (raw);
+}
+
+static void
+gps_raw_test_rmc (void)
+{
+    MMLocationGpsRaw *raw;
+    GVariant *dictionary;
+    MMLocationGpsRaw *copy;
+
+    raw = mm_location_gps_raw_new ();
+    g_assert_cmpfloat (mm_location_gps_raw_get_speed (raw), ==, MM_LOCATION_SPEED_UNKNOWN);
+    g_assert_cmpfloat (mm_location_gps_raw_get_course (raw), ==, MM_LOCATION_COURSE_UNKNOWN);
+
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GNRMC,092751.000,A,5321.6802,N,00630.3372,W,10.0,54.7,191194,020.3,E*68"));
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_speed (raw) - (10.0 * 1852.0 / 3600.0)), <, 1e-9);
+    g_assert_cmpfloat (ABS (mm_location_gps_raw_get_course (raw) - 54.7), <, 1e-9);
+
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GPGGA,092751.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*77"));
+    dictionary = mm_location_gps_raw_get_dictionary (raw);
+    g_assert (dictionary != NULL);
+    copy = mm_location_gps_raw_new_from_dictionary (dictionary, NULL);
+    g_assert (copy != NULL);
+    g_assert_cmpfloat (mm_location_gps_raw_get_speed (copy), ==, mm_location_gps_raw_get_speed (raw));
+    g_assert_cmpfloat (mm_location_gps_raw_get_course (copy), ==, mm_location_gps_raw_get_course (raw));
+    g_object_unref (copy);
+    g_variant_unref (dictionary);
+
+    /* Invalid fix */
+    g_assert (mm_location_gps_raw_add_trace (raw, "$GPRMC,092752.000,V,,,,,,,191194,,*00"));
+    g_assert_cmpfloat (mm_location_gps_raw_get_speed (raw), ==, MM_LOCATION_SPEED_UNKNOWN);
+    g_assert_cmpfloat (mm_location_gps_raw_get_course (raw), ==, MM_LOCATION_COURSE_UNKNOWN);
+
+    g_object_unref (raw);
+}
+
+static void
+gps_raw_test_ignored (void)
+{
+    MMLocationGpsRaw *raw;
+
+    raw = mm_location_gps_raw_new ();
+    g_assert (!mm_location_gps_raw_add_trace (raw, "$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00*74"));
+    g_assert (!mm_location_gps_raw_add_trace (raw, "$PGRMT,GPS 15x-W software ver. 2.80,,,,,,,,*6C"));
+    g_assert (!mm_location_gps_raw_add_trace (raw, "GPGGA,092750.000"));
+    g_assert (!mm_location_gps_raw_add_trace (raw, "$"));
+    g_assert (mm_location_gps_raw_get_utc_time (raw) == NULL);
+    g_object_unref (raw);
+}
+
 int main (int argc, char **argv)
 {
     g_type_init ();
@@ -525,5 +775,13 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/Common/FieldParsers/Uint", field_parser_uint);
     g_test_add_func ("/MM/Common/FieldParsers/Double", field_parser_double);
 
+    g_test_add_func ("/MM/Common/Hex/bin2hexstr", hex_test_bin2hexstr);
+    g_test_add_func ("/MM/Common/Hex/hexstr2bin", hex_test_hexstr2bin);
+    g_test_add_func ("/MM/Common/Hex/hexstr2bin-invalid", hex_test_hexstr2bin_invalid);
+
+    g_test_add_func ("/MM/Common/GpsRaw/gga", gps_raw_test_gga);
+    g_test_add_func ("/MM/Common/GpsRaw/rmc", gps_raw_test_rmc);
+    g_test_add_func ("/MM/Common/GpsRaw/ignored", gps_raw_test_ignored);
+
     return g_test_run ();
 }
@@ -63,3 +63,35 @@ test_crc16_1 (void *f, void *data)
     g_assert (crc == expected);
 }
 
+
+static guint16
+reference_crc16 (const char *buf, gsize len)
+{
+    guint16 crc = 0xffff;
+    guint i;
+
+    /* Bitwise CRC with the 0x8408 polynomial */
+    while (len--) {
+        crc ^= (guint8) *buf++;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 1) ? ((crc >> 1) ^ 0x8408) : (crc >> 1);
+    }
+    return ~crc;
+}
+
+void
+test_crc16_lengths (void *f, void *data)
+{
+    char buf[64];
+    gsize len;
+    gsize offset;
+
+    for (len = 0; len < sizeof (buf); len++)
+        buf[len] = (char) g_test_rand_int_range (0, 256);
+
+    /* Cover all the lengths left over after 8 byte blocks, at any offset */
+    for (offset = 0; offset < 8; offset++) {
+        for (len = 0; len <= sizeof (buf) - offset; len++)
+            g_assert_cmpuint (dm_crc16 (buf + offset, len), ==, reference_crc16 (buf + offset, len));
+    }
+}
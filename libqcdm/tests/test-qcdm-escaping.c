@@ -122,3 +122,27 @@ test_escape_unescape (void *f, void *data)
     g_assert (memcmp (unescaped, data1, unlen) == 0);
 }
 
+
+void
+test_unescape_split (void *f, void *data)
+{
+    char escaped[512];
+    char unescaped[512];
+    gsize len, split;
+
+    len = dm_escape (data1, sizeof (data1), escaped, sizeof (escaped));
+
+    /* Unescaping in two chunks must give the same result wherever the input
+     * is split, even right after an escape character */
+    for (split = 1; split < len; split++) {
+        qcdmbool escaping = FALSE;
+        gsize unlen1, unlen2;
+
+        unlen1 = dm_unescape (escaped, split, unescaped, sizeof (unescaped), &escaping);
+        g_assert (unlen1 > 0 || escaping);
+        unlen2 = dm_unescape (escaped + split, len - split, unescaped + unlen1, sizeof (unescaped) - unlen1, &escaping);
+        g_assert (!escaping);
+        g_assert_cmpuint (unlen1 + unlen2, ==, sizeof (data1));
+        g_assert (memcmp (unescaped, data1, sizeof (data1)) == 0);
+    }
+}
@@ -33,9 +33,6 @@
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 
-#define CONNECTION_CHECK_TIMEOUT_SEC 5
-#define STATCM_TAG "%STATCM:"
-
 G_DEFINE_TYPE (MMBroadbandBearerAltairLte, mm_broadband_bearer_altair_lte, MM_TYPE_BROADBAND_BEARER);
 
 /*****************************************************************************/
@@ -119,6 +116,7 @@ connect_3gpp_connect_ready (MMBaseModem *modem,
     }
 
     mm_dbg ("Connected");
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
 
     config = mm_bearer_ip_config_new ();
 
@@ -154,6 +152,7 @@ connect_3gpp_apnsettings_ready (MMBaseModem *modem,
     }
 
     mm_dbg ("APN set - connecting bearer");
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_CONTEXT_SELECTION);
     mm_base_modem_at_command_full (ctx->modem,
                                    ctx->primary,
                                    "%DPDNACT=1",
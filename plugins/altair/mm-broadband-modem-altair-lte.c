@@ -55,10 +55,14 @@ G_DEFINE_TYPE_EXTENDED (MMBroadbandModemAltairLte, mm_broadband_modem_altair_lte
 struct _MMBroadbandModemAltairLtePrivate {
     /* Regex for SIM refresh notifications */
     GRegex *sim_refresh_regex;
-    /* Timer that goes off 10s after the last SIM refresh notification.
-     * This indicates that there are no more SIM refreshes and we should
-     * reregister the device.*/
+    /* Timer that goes off shortly after the last SIM refresh notification,
+     * when we start waiting for the SIM to be ready again before reregistering
+     * the device.*/
     guint sim_refresh_timer_id;
+    /* Waiting for the SIM to be ready after a refresh */
+    gboolean sim_refresh_waiting;
+    /* SIM refresh notified while waiting for the SIM to be ready */
+    gboolean sim_refresh_again;
     /* Flag indicating that we are detaching from the network to process SIM
      * refresh.  This is used to prevent connect requests while we're in this
      * state.*/
@@ -71,6 +75,11 @@ struct _MMBroadbandModemAltairLtePrivate {
 
 static MMIfaceModem3gpp *iface_modem_3gpp_parent;
 
+/* SIM refreshes come in bursts; once no more arrive for this long, the SIM is
+ * polled until ready, up to the max wait */
+#define SIM_REFRESH_QUIET_MS    500
+#define SIM_REFRESH_MAX_WAIT_MS 10000
+
 
 /*****************************************************************************/
 /* Modem power down (Modem interface) */
@@ -671,9 +680,35 @@ altair_load_own_numbers_ready (MMIfaceModem *iface_modem,
         NULL);
 }
 
-static gboolean
-altair_sim_refresh_timer_expired (MMBroadbandModemAltairLte *self)
+static gboolean altair_sim_refresh_timer_expired (MMBroadbandModemAltairLte *self);
+
+static void
+altair_sim_refresh_schedule (MMBroadbandModemAltairLte *self)
 {
+    if (self->priv->sim_refresh_timer_id)
+        g_source_remove (self->priv->sim_refresh_timer_id);
+    self->priv->sim_refresh_timer_id =
+        g_timeout_add (SIM_REFRESH_QUIET_MS,
+                       (GSourceFunc)altair_sim_refresh_timer_expired,
+                       self);
+}
+
+static void
+altair_sim_ready_after_refresh (MMBroadbandModem *modem,
+                                GAsyncResult *res,
+                                MMBroadbandModemAltairLte *self)
+{
+    mm_broadband_modem_wait_sim_ready_finish (modem, res, NULL);
+    self->priv->sim_refresh_waiting = FALSE;
+
+    /* Another refresh came in meanwhile, wait for that one as well */
+    if (self->priv->sim_refresh_again) {
+        self->priv->sim_refresh_again = FALSE;
+        altair_sim_refresh_schedule (self);
+        g_object_unref (self);
+        return;
+    }
+
     mm_dbg ("No more SIM refreshes, reloading Own Numbers and reregistering modem");
 
     g_assert (MM_IFACE_MODEM_GET_INTERFACE (self)->load_own_numbers);
@@ -682,8 +717,24 @@ altair_sim_refresh_timer_expired (MMBroadbandModemAltairLte *self)
         MM_IFACE_MODEM (self),
         (GAsyncReadyCallback)altair_load_own_numbers_ready,
         self);
+    g_object_unref (self);
+}
+
+static gboolean
+altair_sim_refresh_timer_expired (MMBroadbandModemAltairLte *self)
+{
     self->priv->sim_refresh_timer_id = 0;
 
+    /* The SIM is polled until it is ready again, instead of assuming it is
+     * after a fixed time */
+    mm_dbg ("Waiting for the SIM to be ready after refresh");
+    self->priv->sim_refresh_waiting = TRUE;
+    mm_broadband_modem_wait_sim_ready (MM_BROADBAND_MODEM (self),
+                                       MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPMS,
+                                       SIM_REFRESH_MAX_WAIT_MS,
+                                       (GAsyncReadyCallback)altair_sim_ready_after_refresh,
+                                       g_object_ref (self));
+
     return G_SOURCE_REMOVE;
 }
 
@@ -693,13 +744,11 @@ altair_sim_refresh_changed (MMPortSerialAt *port,
                             MMBroadbandModemAltairLte *self)
 {
     mm_dbg ("Received SIM refresh notification");
-    if (self->priv->sim_refresh_timer_id) {
-        g_source_remove (self->priv->sim_refresh_timer_id);
+    if (self->priv->sim_refresh_waiting) {
+        self->priv->sim_refresh_again = TRUE;
+        return;
     }
-    self->priv->sim_refresh_timer_id =
-        g_timeout_add_seconds(10,
-                              (GSourceFunc)altair_sim_refresh_timer_expired,
-                              self);
+    altair_sim_refresh_schedule (self);
 }
 
 typedef enum {
@@ -1367,6 +1416,8 @@ mm_broadband_modem_altair_lte_init (MMBroadbandModemAltairLte *self)
                                                  G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     self->priv->sim_refresh_detach_in_progress = FALSE;
     self->priv->sim_refresh_timer_id = 0;
+    self->priv->sim_refresh_waiting = FALSE;
+    self->priv->sim_refresh_again = FALSE;
     self->priv->statcm_regex = g_regex_new ("\\r\\n\\%STATCM:\\s*(\\d*),?(\\d*)\\r+\\n",
                                             G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     self->priv->pcoinfo_regex = g_regex_new ("\\r\\n\\%PCOINFO:\\s*(\\d*),([^,\\s]*),([^,\\s]*)\\r+\\n",
@@ -22,6 +22,7 @@
 #include <libmm-glib.h>
 
 #include "mm-modem-helpers-altair-lte.h"
+#include "mm-regex-registry.h"
 
 #define MM_ALTAIR_IMS_PDN_CID           1
 #define MM_ALTAIR_INTERNET_PDN_CID      3
@@ -86,9 +87,8 @@ mm_altair_parse_ceer_response (const gchar *response,
     /* The response we are interested in looks so:
      * +CEER: EPS_AND_NON_EPS_SERVICES_NOT_ALLOWED
      */
-    r = g_regex_new ("\\+CEER:\\s*(\\w*)?",
-                     G_REGEX_RAW,
-                     0, NULL);
+    r = mm_regex_registry_get ("\\+CEER:\\s*(\\w*)?",
+                               G_REGEX_RAW);
     g_assert (r != NULL);
 
     if (!g_regex_match (r, response, 0, &match_info)) {
@@ -119,7 +119,7 @@ mm_altair_parse_cid (const gchar *response, GError **error)
     GMatchInfo *match_info;
     guint cid = -1;
 
-    regex = g_regex_new ("\\%CGINFO:\\s*(\\d+)", G_REGEX_RAW, 0, NULL);
+    regex = mm_regex_registry_get ("\\%CGINFO:\\s*(\\d+)", G_REGEX_RAW);
     g_assert (regex);
     if (!g_regex_match_full (regex, response, strlen (response), 0, 0, &match_info, error)) {
         g_match_info_free (match_info);
@@ -158,7 +158,7 @@ altair_extract_vzw_pco_value (const gchar *pco_payload, GError **error)
     /* Extract PCO value from PCO payload.
      * The PCO value in the VZW network is after the VZW PLMN (MCC+MNC 311-480).
      */
-    regex = g_regex_new ("130184(\\d+)", G_REGEX_RAW, 0, NULL);
+    regex = mm_regex_registry_get ("130184(\\d+)", G_REGEX_RAW);
     g_assert (regex);
     if (!g_regex_match_full (regex,
                              pco_payload,
@@ -203,9 +203,8 @@ mm_altair_parse_vendor_pco_info (const gchar *pco_info, GError **error)
      *     Solicited response: %PCOINFO:<mode>,<cid>[,<pcoid>[,<payload>]]
      *     Unsolicited response: %PCOINFO:<cid>,<pcoid>[,<payload>]
      */
-    regex = g_regex_new ("\\%PCOINFO:(?:\\s*\\d+\\s*,)?(\\d+)\\s*(,([^,\\)]*),([0-9A-Fa-f]*))?",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+    regex = mm_regex_registry_get ("\\%PCOINFO:(?:\\s*\\d+\\s*,)?(\\d+)\\s*(,([^,\\)]*),([0-9A-Fa-f]*))?",
+                                   G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
     g_assert (regex);
     if (!g_regex_match_full (regex, pco_info, strlen (pco_info), 0, 0, &match_info, error)) {
         g_match_info_free (match_info);
@@ -33,6 +33,7 @@
 #include "mm-iface-modem-messaging.h"
 #include "mm-iface-modem-location.h"
 #include "mm-base-modem-at.h"
+#include "mm-regex-registry.h"
 #include "mm-broadband-modem-cinterion.h"
 #include "mm-modem-helpers-cinterion.h"
 #include "mm-common-cinterion.h"
@@ -69,6 +70,12 @@ struct _MMBroadbandModemCinterionPrivate {
     GArray *cnmi_supported_bm;
     GArray *cnmi_supported_ds;
     GArray *cnmi_supported_bfr;
+
+    /* Last ^SIND "service" indicator value reported */
+    guint sind_service;
+
+    /* Ongoing after SIM unlock operation, waiting for "simstatus" */
+    gpointer after_sim_unlock_ctx;
 };
 
 /*****************************************************************************/
@@ -79,24 +86,59 @@ enable_unsolicited_events_finish (MMIfaceModem3gpp *self,
                                   GAsyncResult *res,
                                   GError **error)
 {
-    return !!mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, error);
+    GError *inner_error = NULL;
+
+    mm_base_modem_at_sequence_finish (MM_BASE_MODEM (self), res, NULL, &inner_error);
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return FALSE;
+    }
+    return TRUE;
 }
 
+static gboolean
+sind_enable_processor (MMBaseModem *self,
+                       gpointer none,
+                       const gchar *command,
+                       const gchar *response,
+                       gboolean last_command,
+                       const GError *error,
+                       GVariant **result,
+                       GError **result_error)
+{
+    /* Not all indicators are available in all models, just go on */
+    if (error)
+        mm_dbg ("Couldn't enable indicator with '%s': '%s'", command, error->message);
+
+    /* Return FALSE so that we keep on with the next steps in the sequence */
+    return FALSE;
+}
+
+static const MMBaseModemAtCommand unsolicited_events_enable_sequence[] = {
+    /* AT=CMER=[<mode>[,<keyp>[,<disp>[,<ind>[,<bfr>]]]]]
+     *  but <ind> should be either not set, or equal to 0 or 2.
+     * Enabled with 2.
+     */
+    { "+CMER=3,0,0,2",         3, FALSE, mm_base_modem_response_processor_no_result_continue },
+    /* Indicators reported as +CIEV URCs, which let signal quality and access
+     * technology polling back off to the watchdog intervals */
+    { "^SIND=\"rssi\",1",    3, FALSE, sind_enable_processor },
+    { "^SIND=\"psinfo\",1",  3, FALSE, sind_enable_processor },
+    { "^SIND=\"service\",1", 3, FALSE, sind_enable_processor },
+    { NULL }
+};
+
 static void
 enable_unsolicited_events (MMIfaceModem3gpp *self,
                            GAsyncReadyCallback callback,
                            gpointer user_data)
 {
-    /* AT=CMER=[<mode>[,<keyp>[,<disp>[,<ind>[,<bfr>]]]]]
-     *  but <ind> should be either not set, or equal to 0 or 2.
-     * Enabled with 2.
-     */
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              "+CMER=3,0,0,2",
-                              3,
-                              FALSE,
-                              callback,
-                              user_data);
+    mm_base_modem_at_sequence (MM_BASE_MODEM (self),
+                               unsolicited_events_enable_sequence,
+                               NULL, /* response_processor_context */
+                               NULL, /* response_processor_context_free */
+                               callback,
+                               user_data);
 }
 
 /*****************************************************************************/
@@ -1524,7 +1566,10 @@ load_unlock_retries (MMIfaceModem *self,
 /*****************************************************************************/
 /* After SIM unlock (Modem interface) */
 
-#define MAX_AFTER_SIM_UNLOCK_RETRIES 15
+/* The "simstatus" indicator is reported as soon as the SIM is ready; the
+ * query is only repeated in case the URC gets lost */
+#define MAX_AFTER_SIM_UNLOCK_RETRIES      3
+#define SIMSTATUS_FALLBACK_INTERVAL_SEC   5
 
 typedef enum {
     CINTERION_SIM_STATUS_REMOVED        = 0,
@@ -1537,12 +1582,17 @@ typedef struct {
     GSimpleAsyncResult *result;
     guint retries;
     guint timeout_id;
+    gboolean query_running;
+    gboolean sim_ready;
 } AfterSimUnlockContext;
 
 static void
 after_sim_unlock_context_complete_and_free (AfterSimUnlockContext *ctx)
 {
     g_assert (ctx->timeout_id == 0);
+    g_assert (!ctx->query_running);
+    ctx->self->priv->after_sim_unlock_ctx = NULL;
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
     g_simple_async_result_complete (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
@@ -1557,6 +1607,30 @@ after_sim_unlock_finish (MMIfaceModem *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+static void
+after_sim_unlock_simstatus_reported (MMBroadbandModemCinterion *self,
+                                     guint simstatus)
+{
+    AfterSimUnlockContext *ctx;
+
+    ctx = self->priv->after_sim_unlock_ctx;
+    if (!ctx || simstatus != CINTERION_SIM_STATUS_INIT_COMPLETED)
+        return;
+
+    mm_dbg ("SIM ready, as reported by the 'simstatus' indicator");
+    ctx->sim_ready = TRUE;
+
+    /* If a query is ongoing, let its reply complete the operation */
+    if (ctx->query_running)
+        return;
+
+    if (ctx->timeout_id) {
+        g_source_remove (ctx->timeout_id);
+        ctx->timeout_id = 0;
+    }
+    after_sim_unlock_context_complete_and_free (ctx);
+}
+
 static void after_sim_unlock_context_step (AfterSimUnlockContext *ctx);
 
 static gboolean
@@ -1574,6 +1648,8 @@ simstatus_check_ready (MMBaseModem *self,
 {
     const gchar *response;
 
+    ctx->query_running = FALSE;
+
     response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, NULL);
     if (response) {
         gchar *descr = NULL;
@@ -1581,20 +1657,23 @@ simstatus_check_ready (MMBaseModem *self,
 
         if (mm_cinterion_parse_sind_response (response, &descr, NULL, &val, NULL) &&
             g_str_equal (descr, "simstatus") &&
-            val == CINTERION_SIM_STATUS_INIT_COMPLETED) {
-            /* SIM ready! */
-            g_free (descr);
-            g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-            after_sim_unlock_context_complete_and_free (ctx);
-            return;
-        }
+            val == CINTERION_SIM_STATUS_INIT_COMPLETED)
+            ctx->sim_ready = TRUE;
 
         g_free (descr);
     }
 
-    /* Need to retry after 1 sec */
+    if (ctx->sim_ready) {
+        after_sim_unlock_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* The query also enabled the indicator, so wait for it to be reported,
+     * and recheck only if it doesn't arrive */
     g_assert (ctx->timeout_id == 0);
-    ctx->timeout_id = g_timeout_add_seconds (1, (GSourceFunc)simstatus_timeout_cb, ctx);
+    ctx->timeout_id = g_timeout_add_seconds (SIMSTATUS_FALLBACK_INTERVAL_SEC,
+                                             (GSourceFunc)simstatus_timeout_cb,
+                                             ctx);
 }
 
 static void
@@ -1602,13 +1681,13 @@ after_sim_unlock_context_step (AfterSimUnlockContext *ctx)
 {
     if (ctx->retries == 0) {
         /* Too much wait, go on anyway */
-        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         after_sim_unlock_context_complete_and_free (ctx);
         return;
     }
 
     /* Recheck */
     ctx->retries--;
+    ctx->query_running = TRUE;
     mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
                               "^SIND=\"simstatus\",1",
                               3,
@@ -1631,17 +1710,95 @@ after_sim_unlock (MMIfaceModem *self,
                                              user_data,
                                              after_sim_unlock);
     ctx->retries = MAX_AFTER_SIM_UNLOCK_RETRIES;
+    ctx->self->priv->after_sim_unlock_ctx = ctx;
 
     after_sim_unlock_context_step (ctx);
 }
 
+/*****************************************************************************/
+/* ^SIND indicators reported as +CIEV URCs */
+
+static void
+sind_indicator_received (MMPortSerialAt *port,
+                         GMatchInfo *match_info,
+                         MMBroadbandModemCinterion *self)
+{
+    gchar *indicator;
+    guint value;
+
+    if (!mm_get_uint_from_match_info (match_info, 2, &value))
+        return;
+
+    indicator = g_match_info_fetch (match_info, 1);
+
+    if (g_str_equal (indicator, "rssi")) {
+        /* 0-5, or 99 if unknown. Note that the "signal" indicator is
+         * the bit error rate in these modems. */
+        mm_iface_modem_update_signal_quality (MM_IFACE_MODEM (self),
+                                              value <= 5 ? (value * 100 / 5) : 0);
+    } else if (g_str_equal (indicator, "psinfo")) {
+        MMModemAccessTechnology act;
+        gchar *str;
+        GError *error = NULL;
+
+        str = g_match_info_fetch (match_info, 2);
+        act = get_access_technology_from_psinfo (str, &error);
+        g_free (str);
+        if (error) {
+            mm_dbg ("%s", error->message);
+            g_error_free (error);
+        } else
+            mm_iface_modem_update_access_technologies_unsolicited (MM_IFACE_MODEM (self),
+                                                                   act,
+                                                                   MM_IFACE_MODEM_3GPP_ALL_ACCESS_TECHNOLOGIES_MASK);
+    } else if (g_str_equal (indicator, "service")) {
+        MMModemState state = MM_MODEM_STATE_UNKNOWN;
+
+        if (value != self->priv->sind_service) {
+            self->priv->sind_service = value;
+            g_object_get (self, MM_IFACE_MODEM_STATE, &state, NULL);
+            if (state >= MM_MODEM_STATE_ENABLED &&
+                mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self))) {
+                mm_dbg ("Service indicator changed (%u), checking registration", value);
+                mm_iface_modem_3gpp_run_registration_checks (MM_IFACE_MODEM_3GPP (self), NULL, NULL);
+            }
+        }
+    } else if (g_str_equal (indicator, "simstatus"))
+        after_sim_unlock_simstatus_reported (self, value);
+
+    g_free (indicator);
+}
+
 /*****************************************************************************/
 /* Setup ports (Broadband modem class) */
 
 static void
 setup_ports (MMBroadbandModem *self)
 {
-    /* Call parent's setup ports first always */
+    MMPortSerialAt *ports[2];
+    GRegex *regex;
+    guint i;
+
+    /* The ^SIND indicators are handled before the parent's generic +CIEV
+     * handler gets a chance to see them, so set them up first */
+    ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+
+    regex = mm_regex_registry_get ("\\r\\n\\+CIEV:\\s*(rssi|psinfo|service|simstatus),\\s*(\\d+)\\r\\n",
+                                   G_REGEX_RAW);
+    for (i = 0; i < G_N_ELEMENTS (ports); i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            regex,
+            (MMPortSerialAtUnsolicitedMsgFn)sind_indicator_received,
+            self,
+            NULL);
+    }
+    g_regex_unref (regex);
+
     MM_BROADBAND_MODEM_CLASS (mm_broadband_modem_cinterion_parent_class)->setup_ports (self);
 
     mm_common_cinterion_setup_gps_port (self);
@@ -1675,6 +1832,7 @@ mm_broadband_modem_cinterion_init (MMBroadbandModemCinterion *self)
 
     /* Set defaults */
     self->priv->sind_psinfo = TRUE; /* Initially, always try to get psinfo */
+    self->priv->sind_service = G_MAXUINT;
 }
 
 static void
@@ -0,0 +1,686 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+/*
+ * Scale test: many simulated modems handled by a single daemon.
+ *
+ * Each modem gets its own fake AT port, answering with one of several
+ * latency profiles and sending a stream of unsolicited messages (registration
+ * churn, signal quality, NMEA sentences and bursts of SMS indications). Once
+ * all modems are enabled, the daemon is left running for a while, and its
+ * CPU usage, resident memory, main loop lag and D-Bus method latencies are
+ * reported.
+ *
+ * By default two modems run for a few seconds, as a smoke test. With
+ * '-m perf' (or 'make perf-report') the full load runs; the number of modems
+ * and the duration may be changed in the environment:
+ *   $ MM_TEST_SCALE_MODEMS=100 MM_TEST_SCALE_SECONDS=120 ./test-scale-generic -m perf
+ *
+ * The virtual clock test instead replays hours of timer driven behavior
+ * (registration and signal polling, timeouts...) in the daemon's virtual
+ * clock, reporting how long it took in real time:
+ *   $ MM_TEST_SCALE_MODEMS=100 MM_TEST_SCALE_VIRTUAL_HOURS=24 ./test-scale-generic -m perf
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include <libmm-glib.h>
+
+#include "test-port-context.h"
+#include "test-fixture.h"
+
+#define SMOKE_MODEMS   2
+#define SMOKE_SECONDS  5
+#define PERF_MODEMS    40
+#define PERF_SECONDS   60
+#define MAX_MODEMS     200
+
+#define SMOKE_VIRTUAL_MINUTES 10
+#define PERF_VIRTUAL_HOURS    24
+#define PERF_VIRTUAL_MODEMS   100
+/* Virtual time advanced per step while setting up the modems, and real time
+ * let pass between timers for the replies of the fake ports to arrive */
+#define VIRTUAL_PUMP_MS       100
+#define VIRTUAL_SETTLE_MS     10
+
+/* Interval between D-Bus method latency samples */
+#define SAMPLE_INTERVAL_MS 100
+
+/*****************************************************************************/
+
+typedef struct {
+    const gchar *name;
+    guint        min_ms;
+    guint        max_ms;
+} LatencyProfile;
+
+static const LatencyProfile latency_profiles[] = {
+    { "fast",      0,   5   },
+    { "usb",       10,  40  },
+    { "slow-uart", 50,  200 },
+};
+
+typedef struct {
+    const gchar *message;
+    guint        interval_ms;
+    guint        burst;
+} UnsolicitedScript;
+
+static const UnsolicitedScript unsolicited_scripts[] = {
+    /* Registration churn between home and roaming */
+    { "\\r\\n+CREG: 2,5,\"1234\",\"001122BB\"\\r\\n",                               7000,  1  },
+    { "\\r\\n+CREG: 2,1,\"1234\",\"001122BB\"\\r\\n",                               11000, 1  },
+    /* Signal quality reports */
+    { "\\r\\n+CSQ: 17,99\\r\\n",                                                    3000,  1  },
+    /* NMEA sentences leaking into the AT port */
+    { "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\\r\\n", 1000,  1  },
+    /* SMS indication bursts */
+    { "\\r\\n+CMTI: \"SM\",1\\r\\n",                                                30000, 10 },
+};
+
+/*****************************************************************************/
+
+static guint
+wait_modems (TestFixture *fixture,
+             guint        n_expected,
+             guint        timeout_s)
+{
+    guint wait_time = 0;
+
+    while (TRUE) {
+        GError    *error = NULL;
+        MMManager *manager;
+        GList     *modems;
+        guint      n_modems;
+
+        manager = mm_manager_new_sync (fixture->connection,
+                                       G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                                       NULL, /* cancellable */
+                                       &error);
+        if (!manager)
+            g_error ("Couldn't create manager: %s", error->message);
+        modems = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+        n_modems = g_list_length (modems);
+        g_list_free_full (modems, (GDestroyNotify) g_object_unref);
+        g_object_unref (manager);
+
+        if (n_modems >= n_expected || wait_time >= timeout_s)
+            return n_modems;
+
+        wait_time++;
+        sleep (1);
+    }
+}
+
+/*****************************************************************************/
+/* Enabling all modems at once */
+
+typedef struct {
+    GMainLoop *loop;
+    guint      pending;
+    guint      failed;
+} EnableContext;
+
+static void
+enable_ready (MMModem       *modem,
+              GAsyncResult  *res,
+              EnableContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_modem_enable_finish (modem, res, &error)) {
+        g_warning ("Couldn't enable modem '%s': %s", mm_modem_get_path (modem), error->message);
+        g_error_free (error);
+        ctx->failed++;
+    }
+    if (--ctx->pending == 0)
+        g_main_loop_quit (ctx->loop);
+}
+
+static GList *
+enable_all (TestFixture *fixture,
+            guint       *n_failed)
+{
+    GError        *error = NULL;
+    MMManager     *manager;
+    GList         *objects;
+    GList         *modems = NULL;
+    GList         *l;
+    EnableContext  ctx;
+
+    manager = mm_manager_new_sync (fixture->connection,
+                                   G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                                   NULL, /* cancellable */
+                                   &error);
+    if (!manager)
+        g_error ("Couldn't create manager: %s", error->message);
+    objects = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    ctx.pending = 0;
+    ctx.failed = 0;
+    for (l = objects; l; l = g_list_next (l)) {
+        MMModem *modem;
+
+        modem = mm_object_get_modem (MM_OBJECT (l->data));
+        g_assert (modem != NULL);
+        /* Don't let the default proxy timeout hit the slow ports */
+        g_dbus_proxy_set_default_timeout (G_DBUS_PROXY (modem), 300000);
+        mm_modem_enable (modem, NULL, (GAsyncReadyCallback)enable_ready, &ctx);
+        modems = g_list_prepend (modems, modem);
+        ctx.pending++;
+    }
+    if (ctx.pending > 0)
+        g_main_loop_run (ctx.loop);
+    g_main_loop_unref (ctx.loop);
+
+    g_list_free_full (objects, (GDestroyNotify) g_object_unref);
+    g_object_unref (manager);
+
+    *n_failed = ctx.failed;
+    return modems;
+}
+
+/*****************************************************************************/
+/* Daemon process statistics */
+
+static guint
+get_daemon_pid (TestFixture *fixture)
+{
+    GError   *error = NULL;
+    GVariant *result;
+    guint     pid;
+
+    result = g_dbus_connection_call_sync (fixture->connection,
+                                          "org.freedesktop.DBus",
+                                          "/org/freedesktop/DBus",
+                                          "org.freedesktop.DBus",
+                                          "GetConnectionUnixProcessID",
+                                          g_variant_new ("(s)", "org.freedesktop.ModemManager1"),
+                                          G_VARIANT_TYPE ("(u)"),
+                                          G_DBUS_CALL_FLAGS_NONE,
+                                          -1,
+                                          NULL,
+                                          &error);
+    if (!result)
+        g_error ("Couldn't get daemon PID: %s", error->message);
+    g_variant_get (result, "(u)", &pid);
+    g_variant_unref (result);
+    return pid;
+}
+
+/* User plus system time, in clock ticks */
+static guint64
+get_daemon_cpu_ticks (guint pid)
+{
+    gchar   *path;
+    gchar   *contents = NULL;
+    gchar  **fields = NULL;
+    gchar   *after_comm;
+    guint64  ticks = 0;
+
+    path = g_strdup_printf ("/proc/%u/stat", pid);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        goto out;
+
+    /* The command name may have spaces, so skip it; utime and stime are
+     * then the 12th and 13th fields */
+    after_comm = strrchr (contents, ')');
+    if (!after_comm)
+        goto out;
+    fields = g_strsplit (after_comm + 2, " ", 14);
+    if (g_strv_length (fields) < 14)
+        goto out;
+    ticks = g_ascii_strtoull (fields[11], NULL, 10) + g_ascii_strtoull (fields[12], NULL, 10);
+
+out:
+    g_strfreev (fields);
+    g_free (contents);
+    g_free (path);
+    return ticks;
+}
+
+static guint64
+get_daemon_rss_kb (guint pid)
+{
+    gchar   *path;
+    gchar   *contents = NULL;
+    gchar   *line;
+    guint64  rss = 0;
+
+    path = g_strdup_printf ("/proc/%u/status", pid);
+    if (g_file_get_contents (path, &contents, NULL, NULL) &&
+        (line = strstr (contents, "VmRSS:")) != NULL)
+        rss = g_ascii_strtoull (line + strlen ("VmRSS:"), NULL, 10);
+    g_free (contents);
+    g_free (path);
+    return rss;
+}
+
+/* Requires the daemon to run with --loop-monitor */
+static GVariant *
+get_loop_stats (TestFixture *fixture)
+{
+    GError   *error = NULL;
+    GVariant *result;
+    GVariant *stats;
+
+    result = g_dbus_connection_call_sync (fixture->connection,
+                                          "org.freedesktop.ModemManager1",
+                                          "/org/freedesktop/ModemManager1",
+                                          "org.freedesktop.ModemManager1",
+                                          "GetLoopStats",
+                                          NULL,
+                                          G_VARIANT_TYPE ("(a{sv})"),
+                                          G_DBUS_CALL_FLAGS_NONE,
+                                          -1,
+                                          NULL,
+                                          &error);
+    if (!result) {
+        g_message ("Main loop statistics unavailable: %s", error->message);
+        g_error_free (error);
+        return NULL;
+    }
+    g_variant_get (result, "(@a{sv})", &stats);
+    g_variant_unref (result);
+    return stats;
+}
+
+/*****************************************************************************/
+/* D-Bus method latency */
+
+static gint64
+timed_call (TestFixture *fixture,
+            const gchar *path,
+            const gchar *interface,
+            const gchar *method,
+            GVariant    *parameters)
+{
+    GError   *error = NULL;
+    GVariant *result;
+    gint64    start;
+    gint64    elapsed;
+
+    start = g_get_monotonic_time ();
+    result = g_dbus_connection_call_sync (fixture->connection,
+                                          "org.freedesktop.ModemManager1",
+                                          path,
+                                          interface,
+                                          method,
+                                          parameters,
+                                          NULL,
+                                          G_DBUS_CALL_FLAGS_NONE,
+                                          -1,
+                                          NULL,
+                                          &error);
+    elapsed = g_get_monotonic_time () - start;
+    if (!result) {
+        g_warning ("%s.%s failed: %s", interface, method, error->message);
+        g_error_free (error);
+        return -1;
+    }
+    g_variant_unref (result);
+    return elapsed;
+}
+
+static gint
+compare_latency (gconstpointer a,
+                 gconstpointer b)
+{
+    gint64 la = *(const gint64 *)a;
+    gint64 lb = *(const gint64 *)b;
+
+    return (la > lb) - (la < lb);
+}
+
+static void
+report_latencies (const gchar *name,
+                  GArray      *samples)
+{
+    gint64 p50, p99, max;
+
+    if (samples->len == 0) {
+        g_message ("%s: no samples", name);
+        return;
+    }
+
+    g_array_sort (samples, compare_latency);
+    p50 = g_array_index (samples, gint64, (samples->len - 1) * 50 / 100);
+    p99 = g_array_index (samples, gint64, (samples->len - 1) * 99 / 100);
+    max = g_array_index (samples, gint64, samples->len - 1);
+
+    g_test_minimized_result ((gdouble) p99 / 1000.0,
+                             "%s latency (%u calls): p50 %.1f ms, p99 %.1f ms, max %.1f ms",
+                             name, samples->len,
+                             (gdouble) p50 / 1000.0, (gdouble) p99 / 1000.0, (gdouble) max / 1000.0);
+}
+
+/*****************************************************************************/
+
+static void
+test_scale (TestFixture *fixture)
+{
+    TestPortContext **ports;
+    GList            *modems;
+    GList            *l;
+    GArray           *get_all_samples;
+    GArray           *managed_samples;
+    GVariant         *loop_stats;
+    gchar           **paths;
+    guint             n_modems;
+    guint             seconds;
+    guint             n_found;
+    guint             n_failed;
+    guint             n_paths;
+    guint             pid;
+    guint64           ticks_start;
+    guint64           ticks_end;
+    guint64           rss_start;
+    guint64           rss_end;
+    gint64            start;
+    gint64            end;
+    gint64            elapsed;
+    guint             i;
+
+    if (g_test_perf ()) {
+        n_modems = MIN (test_fixture_get_env_uint ("MM_TEST_SCALE_MODEMS", PERF_MODEMS), MAX_MODEMS);
+        seconds = test_fixture_get_env_uint ("MM_TEST_SCALE_SECONDS", PERF_SECONDS);
+    } else {
+        n_modems = SMOKE_MODEMS;
+        seconds = SMOKE_SECONDS;
+    }
+
+    pid = get_daemon_pid (fixture);
+    rss_start = get_daemon_rss_kb (pid);
+
+    /* Setup one port context per modem */
+    ports = g_new0 (TestPortContext *, n_modems);
+    for (i = 0; i < n_modems; i++) {
+        const LatencyProfile *profile;
+        gchar                *port_name;
+        guint                 j;
+
+        port_name = g_strdup_printf ("abstract:scale-port%u", i);
+        ports[i] = test_port_context_new (port_name);
+        g_free (port_name);
+
+        profile = &latency_profiles[i % G_N_ELEMENTS (latency_profiles)];
+        test_port_context_load_commands (ports[i], COMMON_GSM_PORT_CONF);
+        test_port_context_set_latency (ports[i], profile->min_ms, profile->max_ms);
+        for (j = 0; j < G_N_ELEMENTS (unsolicited_scripts); j++)
+            test_port_context_add_unsolicited (ports[i],
+                                               unsolicited_scripts[j].message,
+                                               unsolicited_scripts[j].interval_ms,
+                                               unsolicited_scripts[j].burst);
+        test_port_context_start (ports[i]);
+    }
+
+    /* Each profile creates a new virtual device */
+    for (i = 0; i < n_modems; i++) {
+        gchar       *profile_name;
+        gchar       *port_name;
+        const gchar *profile_ports[2];
+
+        profile_name = g_strdup_printf ("scale-%u", i);
+        port_name = g_strdup_printf ("abstract:scale-port%u", i);
+        profile_ports[0] = port_name;
+        profile_ports[1] = NULL;
+        test_fixture_set_profile (fixture, profile_name, "Generic", profile_ports);
+        g_free (port_name);
+        g_free (profile_name);
+    }
+
+    start = g_get_monotonic_time ();
+    n_found = wait_modems (fixture, n_modems, 20 + n_modems);
+    g_assert_cmpuint (n_found, ==, n_modems);
+    modems = enable_all (fixture, &n_failed);
+    g_assert_cmpuint (n_failed, ==, 0);
+    elapsed = g_get_monotonic_time () - start;
+
+    g_test_minimized_result ((gdouble) elapsed / 1e6,
+                             "%u modems exported and enabled in %.1f s",
+                             n_modems, (gdouble) elapsed / 1e6);
+
+    n_paths = g_list_length (modems);
+    paths = g_new0 (gchar *, n_paths + 1);
+    for (l = modems, i = 0; l; l = g_list_next (l), i++)
+        paths[i] = g_strdup (mm_modem_get_path (MM_MODEM (l->data)));
+
+    /* Steady state: sample method latencies while the URCs keep coming */
+    get_all_samples = g_array_new (FALSE, FALSE, sizeof (gint64));
+    managed_samples = g_array_new (FALSE, FALSE, sizeof (gint64));
+    ticks_start = get_daemon_cpu_ticks (pid);
+    start = g_get_monotonic_time ();
+    end = start + (gint64) seconds * G_USEC_PER_SEC;
+    for (i = 0; g_get_monotonic_time () < end; i++) {
+        gint64 latency;
+
+        latency = timed_call (fixture,
+                              paths[i % n_paths],
+                              "org.freedesktop.DBus.Properties",
+                              "GetAll",
+                              g_variant_new ("(s)", "org.freedesktop.ModemManager1.Modem"));
+        if (latency >= 0)
+            g_array_append_val (get_all_samples, latency);
+
+        if (i % 10 == 0) {
+            latency = timed_call (fixture,
+                                  "/org/freedesktop/ModemManager1",
+                                  "org.freedesktop.DBus.ObjectManager",
+                                  "GetManagedObjects",
+                                  NULL);
+            if (latency >= 0)
+                g_array_append_val (managed_samples, latency);
+        }
+
+        g_usleep (SAMPLE_INTERVAL_MS * 1000);
+    }
+    elapsed = g_get_monotonic_time () - start;
+    ticks_end = get_daemon_cpu_ticks (pid);
+    rss_end = get_daemon_rss_kb (pid);
+
+    /* Report */
+    g_test_minimized_result (100.0 * (ticks_end - ticks_start) / sysconf (_SC_CLK_TCK) / ((gdouble) elapsed / 1e6),
+                             "daemon CPU with %u modems over %.0f s: %.1f%%",
+                             n_modems, (gdouble) elapsed / 1e6,
+                             100.0 * (ticks_end - ticks_start) / sysconf (_SC_CLK_TCK) / ((gdouble) elapsed / 1e6));
+    g_test_minimized_result ((gdouble) rss_end,
+                             "daemon RSS: %" G_GUINT64_FORMAT " kB (%" G_GUINT64_FORMAT " kB before adding modems)",
+                             rss_end, rss_start);
+    report_latencies ("Properties.GetAll", get_all_samples);
+    report_latencies ("GetManagedObjects", managed_samples);
+
+    loop_stats = get_loop_stats (fixture);
+    if (loop_stats) {
+        guint32 lag_p50 = 0;
+        guint32 lag_p99 = 0;
+        guint32 lag_max = 0;
+        guint32 stalls = 0;
+
+        g_variant_lookup (loop_stats, "lag-p50", "u", &lag_p50);
+        g_variant_lookup (loop_stats, "lag-p99", "u", &lag_p99);
+        g_variant_lookup (loop_stats, "lag-max", "u", &lag_max);
+        g_variant_lookup (loop_stats, "stalls", "u", &stalls);
+        g_test_minimized_result ((gdouble) lag_p99 / 1000.0,
+                                 "main loop lag: p50 %.1f ms, p99 %.1f ms, max %.1f ms, %u stalls",
+                                 (gdouble) lag_p50 / 1000.0, (gdouble) lag_p99 / 1000.0,
+                                 (gdouble) lag_max / 1000.0, stalls);
+        g_variant_unref (loop_stats);
+    }
+
+    g_array_unref (get_all_samples);
+    g_array_unref (managed_samples);
+    g_strfreev (paths);
+    g_list_free_full (modems, (GDestroyNotify) g_object_unref);
+
+    /* Stop port contexts */
+    for (i = 0; i < n_modems; i++) {
+        test_port_context_stop (ports[i]);
+        test_port_context_free (ports[i]);
+    }
+    g_free (ports);
+}
+
+/*****************************************************************************/
+/* Virtual clock */
+
+typedef struct {
+    TestFixture *fixture;
+    gint         stop;
+} ClockPump;
+
+/* While the modems are being set up, keep the virtual clock moving roughly
+ * along with the real one */
+static gpointer
+clock_pump_thread (ClockPump *pump)
+{
+    while (!g_atomic_int_get (&pump->stop))
+        test_fixture_advance_clock (pump->fixture, VIRTUAL_PUMP_MS, VIRTUAL_SETTLE_MS);
+    return NULL;
+}
+
+static guint
+count_enabled_modems (TestFixture *fixture)
+{
+    GError    *error = NULL;
+    MMManager *manager;
+    GList     *objects;
+    GList     *l;
+    guint      n_enabled = 0;
+
+    manager = mm_manager_new_sync (fixture->connection,
+                                   G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                                   NULL, /* cancellable */
+                                   &error);
+    if (!manager)
+        g_error ("Couldn't create manager: %s", error->message);
+    objects = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+    for (l = objects; l; l = g_list_next (l)) {
+        MMModem *modem;
+
+        modem = mm_object_peek_modem (MM_OBJECT (l->data));
+        if (modem && mm_modem_get_state (modem) >= MM_MODEM_STATE_ENABLED)
+            n_enabled++;
+    }
+    g_list_free_full (objects, (GDestroyNotify) g_object_unref);
+    g_object_unref (manager);
+    return n_enabled;
+}
+
+static void
+test_scale_virtual_clock (TestFixture *fixture)
+{
+    TestPortContext **ports;
+    GList            *modems;
+    ClockPump         pump;
+    GThread          *pump_thread;
+    guint64           virtual_ms;
+    guint             n_modems;
+    guint             n_found;
+    guint             n_failed;
+    guint             pid;
+    guint64           ticks_start;
+    guint64           ticks_end;
+    gint64            start;
+    gint64            elapsed;
+    guint             i;
+
+    if (g_test_perf ()) {
+        n_modems = MIN (test_fixture_get_env_uint ("MM_TEST_SCALE_MODEMS", PERF_VIRTUAL_MODEMS), MAX_MODEMS);
+        virtual_ms = (guint64) test_fixture_get_env_uint ("MM_TEST_SCALE_VIRTUAL_HOURS", PERF_VIRTUAL_HOURS) * 3600 * 1000;
+    } else {
+        n_modems = SMOKE_MODEMS;
+        virtual_ms = (guint64) SMOKE_VIRTUAL_MINUTES * 60 * 1000;
+    }
+
+    pid = get_daemon_pid (fixture);
+
+    /* Before any modem is created, so that all their timers are virtual */
+    test_fixture_enable_virtual_clock (fixture);
+    pump.fixture = fixture;
+    pump.stop = FALSE;
+    pump_thread = g_thread_new ("clock-pump", (GThreadFunc) clock_pump_thread, &pump);
+
+    /* Fast ports only, and no unsolicited messages, which would come in real
+     * time */
+    ports = g_new0 (TestPortContext *, n_modems);
+    for (i = 0; i < n_modems; i++) {
+        gchar       *port_name;
+        gchar       *profile_name;
+        const gchar *profile_ports[2];
+
+        port_name = g_strdup_printf ("abstract:scale-virtual-port%u", i);
+        ports[i] = test_port_context_new (port_name);
+        test_port_context_load_commands (ports[i], COMMON_GSM_PORT_CONF);
+        test_port_context_set_latency (ports[i], latency_profiles[0].min_ms, latency_profiles[0].max_ms);
+        test_port_context_start (ports[i]);
+
+        profile_name = g_strdup_printf ("scale-virtual-%u", i);
+        profile_ports[0] = port_name;
+        profile_ports[1] = NULL;
+        test_fixture_set_profile (fixture, profile_name, "Generic", profile_ports);
+        g_free (profile_name);
+        g_free (port_name);
+    }
+
+    n_found = wait_modems (fixture, n_modems, 20 + n_modems);
+    g_assert_cmpuint (n_found, ==, n_modems);
+    modems = enable_all (fixture, &n_failed);
+    g_assert_cmpuint (n_failed, ==, 0);
+
+    g_atomic_int_set (&pump.stop, TRUE);
+    g_thread_join (pump_thread);
+
+    /* Replay */
+    ticks_start = get_daemon_cpu_ticks (pid);
+    start = g_get_monotonic_time ();
+    test_fixture_advance_clock (fixture, virtual_ms, VIRTUAL_SETTLE_MS);
+    elapsed = g_get_monotonic_time () - start;
+    ticks_end = get_daemon_cpu_ticks (pid);
+
+    g_test_minimized_result ((gdouble) elapsed / 1e6,
+                             "%.1f virtual hours with %u modems replayed in %.1f s (%.0fx), daemon CPU %.1f s",
+                             (gdouble) virtual_ms / 3600000.0,
+                             n_modems,
+                             (gdouble) elapsed / 1e6,
+                             (gdouble) virtual_ms * 1000.0 / MAX (elapsed, 1),
+                             (gdouble) (ticks_end - ticks_start) / sysconf (_SC_CLK_TCK));
+
+    /* Nothing should have timed out along the way */
+    g_assert_cmpuint (count_enabled_modems (fixture), ==, n_modems);
+
+    g_list_free_full (modems, (GDestroyNotify) g_object_unref);
+    for (i = 0; i < n_modems; i++) {
+        test_port_context_stop (ports[i]);
+        test_port_context_free (ports[i]);
+    }
+    g_free (ports);
+}
+
+/*****************************************************************************/
+
+int main (int   argc,
+          char *argv[])
+{
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    TEST_ADD ("/MM/Service/Generic/scale", test_scale);
+    TEST_ADD ("/MM/Service/Generic/scale-virtual-clock", test_scale_virtual_clock);
+
+    return g_test_run ();
+}
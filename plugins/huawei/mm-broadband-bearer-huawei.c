@@ -41,6 +41,11 @@ struct _MMBroadbandBearerHuaweiPrivate {
     guint network_disconnect_pending_id;
 };
 
+/* Connection progress is tracked through ^NDISSTAT unsolicited messages;
+ * ^NDISSTATQRY? is only polled as a fallback, in case they're missed */
+#define NDISSTATQRY_FALLBACK_INTERVAL_SEC 5
+#define NDISSTAT_TIMEOUT_SEC              60
+
 /*****************************************************************************/
 
 static MMPortSerialAt *
@@ -81,6 +86,9 @@ typedef struct {
     Connect3gppContextStep step;
     guint check_count;
     guint failed_ndisstatqry_count;
+    guint retry_id;
+    gboolean ndisstatqry_running;
+    gboolean ndisstat_connected;
     MMBearerIpConfig *ipv4_config;
 } Connect3gppContext;
 
@@ -192,6 +200,7 @@ connect_dhcp_check_ready (MMBaseModem *modem,
     }
 
     g_clear_error (&error);
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_IP_CONFIG);
     ctx->step++;
     connect_3gpp_context_step (ctx);
 }
@@ -204,9 +213,7 @@ connect_retry_ndisstatqry_check_cb (MMBroadbandBearerHuawei *self)
     /* Recover context */
     ctx = self->priv->connect_pending;
     g_assert (ctx != NULL);
-
-    /* Balance refcount */
-    g_object_unref (self);
+    ctx->retry_id = 0;
 
     /* Retry same step */
     connect_3gpp_context_step (ctx);
@@ -214,6 +221,26 @@ connect_retry_ndisstatqry_check_cb (MMBroadbandBearerHuawei *self)
     return G_SOURCE_REMOVE;
 }
 
+static void
+connect_ndisstat_connected (Connect3gppContext *ctx)
+{
+    mm_dbg ("Connection reported by ^NDISSTAT");
+
+    /* The ongoing query, if any, will go on with the next step */
+    if (ctx->ndisstatqry_running) {
+        ctx->ndisstat_connected = TRUE;
+        return;
+    }
+
+    if (ctx->retry_id) {
+        g_source_remove (ctx->retry_id);
+        ctx->retry_id = 0;
+    }
+
+    ctx->step++;
+    connect_3gpp_context_step (ctx);
+}
+
 static void
 connect_ndisstatqry_check_ready (MMBaseModem *modem,
                                  GAsyncResult *res,
@@ -229,6 +256,7 @@ connect_ndisstatqry_check_ready (MMBaseModem *modem,
 
     ctx = self->priv->connect_pending;
     g_assert (ctx != NULL);
+    ctx->ndisstatqry_running = FALSE;
 
     /* Balance refcount */
     g_object_unref (self);
@@ -248,17 +276,19 @@ connect_ndisstatqry_check_ready (MMBaseModem *modem,
     }
 
     /* Connected in IPv4? */
-    if (ipv4_available && ipv4_connected) {
+    if ((ipv4_available && ipv4_connected) || ctx->ndisstat_connected) {
         /* Success! */
         ctx->step++;
         connect_3gpp_context_step (ctx);
         return;
     }
 
-    /* Setup timeout to retry the same step */
-    g_timeout_add_seconds (1,
-                           (GSourceFunc)connect_retry_ndisstatqry_check_cb,
-                           g_object_ref (self));
+    /* Setup timeout to retry the same step, unless ^NDISSTAT comes first */
+    ctx->retry_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT,
+                                                NDISSTATQRY_FALLBACK_INTERVAL_SEC,
+                                                (GSourceFunc)connect_retry_ndisstatqry_check_cb,
+                                                g_object_ref (self),
+                                                g_object_unref);
 }
 
 static void
@@ -425,11 +455,10 @@ connect_3gpp_context_step (Connect3gppContext *ctx)
     }
 
     case CONNECT_3GPP_CONTEXT_STEP_NDISSTATQRY:
-        /* Wait for dial up timeout, retries for 60 times
-         * (1s between the retries, so it means 1 minute).
+        /* Wait for ^NDISSTAT up to the dial up timeout, polling in between.
          * If too many retries, failed
          */
-        if (ctx->check_count > 60) {
+        if (ctx->check_count > NDISSTAT_TIMEOUT_SEC / NDISSTATQRY_FALLBACK_INTERVAL_SEC) {
             /* Clear context */
             ctx->self->priv->connect_pending = NULL;
             g_simple_async_result_set_error (ctx->result,
@@ -454,6 +483,7 @@ connect_3gpp_context_step (Connect3gppContext *ctx)
 
         /* Check if connected */
         ctx->check_count++;
+        ctx->ndisstatqry_running = TRUE;
         mm_base_modem_at_command_full (ctx->modem,
                                        ctx->primary,
                                        "^NDISSTATQRY?",
@@ -466,6 +496,8 @@ connect_3gpp_context_step (Connect3gppContext *ctx)
         return;
 
     case CONNECT_3GPP_CONTEXT_STEP_IP_CONFIG:
+        /* ^NDISSTAT or ^NDISSTATQRY reported the connection */
+        mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
         mm_base_modem_at_command_full (ctx->modem,
                                        ctx->primary,
                                        "^DHCP?",
@@ -562,6 +594,9 @@ typedef struct {
     Disconnect3gppContextStep step;
     guint check_count;
     guint failed_ndisstatqry_count;
+    guint retry_id;
+    gboolean ndisstatqry_running;
+    gboolean ndisstat_disconnected;
 } Disconnect3gppContext;
 
 static void
@@ -593,15 +628,37 @@ disconnect_retry_ndisstatqry_check_cb (MMBroadbandBearerHuawei *self)
     /* Recover context */
     ctx = self->priv->disconnect_pending;
     g_assert (ctx != NULL);
-
-    /* Balance refcount */
-    g_object_unref (self);
+    ctx->retry_id = 0;
 
     /* Retry same step */
     disconnect_3gpp_context_step (ctx);
     return G_SOURCE_REMOVE;
 }
 
+static void
+disconnect_ndisstat_disconnected (Disconnect3gppContext *ctx)
+{
+    /* Only once the disconnection has been requested */
+    if (ctx->step != DISCONNECT_3GPP_CONTEXT_STEP_NDISSTATQRY)
+        return;
+
+    mm_dbg ("Disconnection reported by ^NDISSTAT");
+
+    /* The ongoing query, if any, will go on with the next step */
+    if (ctx->ndisstatqry_running) {
+        ctx->ndisstat_disconnected = TRUE;
+        return;
+    }
+
+    if (ctx->retry_id) {
+        g_source_remove (ctx->retry_id);
+        ctx->retry_id = 0;
+    }
+
+    ctx->step++;
+    disconnect_3gpp_context_step (ctx);
+}
+
 static void
 disconnect_ndisstatqry_check_ready (MMBaseModem *modem,
                                     GAsyncResult *res,
@@ -617,6 +674,7 @@ disconnect_ndisstatqry_check_ready (MMBaseModem *modem,
 
     ctx = self->priv->disconnect_pending;
     g_assert (ctx != NULL);
+    ctx->ndisstatqry_running = FALSE;
 
     /* Balance refcount */
     g_object_unref (self);
@@ -636,17 +694,19 @@ disconnect_ndisstatqry_check_ready (MMBaseModem *modem,
     }
 
     /* Disconnected IPv4? */
-    if (ipv4_available && !ipv4_connected) {
+    if ((ipv4_available && !ipv4_connected) || ctx->ndisstat_disconnected) {
         /* Success! */
         ctx->step++;
         disconnect_3gpp_context_step (ctx);
         return;
     }
 
-    /* Setup timeout to retry the same step */
-    g_timeout_add_seconds (1,
-                           (GSourceFunc)disconnect_retry_ndisstatqry_check_cb,
-                           g_object_ref (self));
+    /* Setup timeout to retry the same step, unless ^NDISSTAT comes first */
+    ctx->retry_id = g_timeout_add_seconds_full (G_PRIORITY_DEFAULT,
+                                                NDISSTATQRY_FALLBACK_INTERVAL_SEC,
+                                                (GSourceFunc)disconnect_retry_ndisstatqry_check_cb,
+                                                g_object_ref (self),
+                                                g_object_unref);
 }
 
 static void
@@ -708,8 +768,8 @@ disconnect_3gpp_context_step (Disconnect3gppContext *ctx)
         return;
 
     case DISCONNECT_3GPP_CONTEXT_STEP_NDISSTATQRY:
-        /* If too many retries (1s of wait between the retries), failed */
-        if (ctx->check_count > 60) {
+        /* Wait for ^NDISSTAT, polling in between; if too many retries, failed */
+        if (ctx->check_count > NDISSTAT_TIMEOUT_SEC / NDISSTATQRY_FALLBACK_INTERVAL_SEC) {
             /* Clear context */
             ctx->self->priv->disconnect_pending = NULL;
             g_simple_async_result_set_error (ctx->result,
@@ -734,6 +794,7 @@ disconnect_3gpp_context_step (Disconnect3gppContext *ctx)
 
         /* Check if disconnected */
         ctx->check_count++;
+        ctx->ndisstatqry_running = TRUE;
         mm_base_modem_at_command_full (ctx->modem,
                                        ctx->primary,
                                        "^NDISSTATQRY?",
@@ -812,11 +873,21 @@ report_connection_status (MMBaseBearer *bearer,
               status == MM_BEARER_CONNECTION_STATUS_DISCONNECTING ||
               status == MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
 
-    /* When a pending connection / disconnection attempt is in progress, we use
-     * ^NDISSTATQRY? to check the connection status and thus temporarily ignore
-     * ^NDISSTAT unsolicited messages */
-    if (self->priv->connect_pending || self->priv->disconnect_pending)
+    /* When a pending connection / disconnection attempt is in progress,
+     * ^NDISSTAT unsolicited messages just let it go on right away */
+    if (self->priv->connect_pending) {
+        Connect3gppContext *ctx = self->priv->connect_pending;
+
+        if (status == MM_BEARER_CONNECTION_STATUS_CONNECTED &&
+            ctx->step == CONNECT_3GPP_CONTEXT_STEP_NDISSTATQRY)
+            connect_ndisstat_connected (ctx);
+        return;
+    }
+    if (self->priv->disconnect_pending) {
+        if (status != MM_BEARER_CONNECTION_STATUS_CONNECTED)
+            disconnect_ndisstat_disconnected (self->priv->disconnect_pending);
         return;
+    }
 
     mm_dbg ("Received spontaneous ^NDISSTAT (%s)",
             mm_bearer_connection_status_get_string (status));
@@ -825,8 +896,7 @@ report_connection_status (MMBaseBearer *bearer,
     if (status == MM_BEARER_CONNECTION_STATUS_CONNECTED)
         return;
 
-    /* We already use ^NDISSTATQRY? to poll the connection status, so only
-     * handle network-initiated disconnection here. */
+    /* Only handle network-initiated disconnection here. */
     if (status == MM_BEARER_CONNECTION_STATUS_DISCONNECTING) {
         /* MM_BEARER_CONNECTION_STATUS_DISCONNECTING is used to indicate that the
          * reporting of disconnection should be delayed. See MMBroadbandModemHuawei's
@@ -146,6 +146,9 @@ struct _MMBroadbandModemHuaweiPrivate {
     GArray *prefmode_supported_modes;
 
     DetailedSignal detailed_signal;
+
+    /* Last service state reported in ^SRVST */
+    guint srvst;
 };
 
 /*****************************************************************************/
@@ -718,15 +721,7 @@ modem_after_sim_unlock_finish (MMIfaceModem *self,
                                GAsyncResult *res,
                                GError **error)
 {
-    return TRUE;
-}
-
-static gboolean
-after_sim_unlock_wait_cb (GSimpleAsyncResult *result)
-{
-    g_simple_async_result_complete (result);
-    g_object_unref (result);
-    return G_SOURCE_REMOVE;
+    return mm_broadband_modem_wait_sim_ready_finish (MM_BROADBAND_MODEM (self), res, error);
 }
 
 static void
@@ -734,16 +729,14 @@ modem_after_sim_unlock (MMIfaceModem *self,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
 {
-    GSimpleAsyncResult *result;
-
-    result = g_simple_async_result_new (G_OBJECT (self),
-                                        callback,
-                                        user_data,
-                                        modem_after_sim_unlock);
-
-    /* A 3-second wait is necessary for SIM to become ready, or the firmware may
-     * fail miserably and reboot itself */
-    g_timeout_add_seconds (3, (GSourceFunc)after_sim_unlock_wait_cb, result);
+    /* Wait (up to 3 seconds) for SIM to become ready, or the firmware may
+     * fail miserably and reboot itself; so don't poll it, ^SIMST tells when
+     * it is */
+    mm_broadband_modem_wait_sim_ready (MM_BROADBAND_MODEM (self),
+                                       MM_BROADBAND_MODEM_SIM_READY_INDICATOR_URC,
+                                       3000,
+                                       callback,
+                                       user_data);
 }
 
 /*****************************************************************************/
@@ -1663,7 +1656,30 @@ huawei_mode_changed (MMPortSerialAt *port,
     mm_dbg ("Access Technology: '%s'", str);
     g_free (str);
 
-    mm_iface_modem_update_access_technologies (MM_IFACE_MODEM (self), act, mask);
+    mm_iface_modem_update_access_technologies_unsolicited (MM_IFACE_MODEM (self), act, mask);
+}
+
+static void
+huawei_srvst_changed (MMPortSerialAt *port,
+                      GMatchInfo *match_info,
+                      MMBroadbandModemHuawei *self)
+{
+    guint srvst;
+
+    if (!mm_get_uint_from_match_info (match_info, 1, &srvst))
+        return;
+
+    /* 0: no service, 1: restricted, 2: valid, 3: restricted regional,
+     * 4: power saving */
+    if (srvst == self->priv->srvst)
+        return;
+
+    mm_dbg ("Service state changed (%u -> %u), checking registration", self->priv->srvst, srvst);
+    self->priv->srvst = srvst;
+
+    /* Registration checks get coalesced if several are requested in a row */
+    if (mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self)))
+        mm_iface_modem_3gpp_run_registration_checks (MM_IFACE_MODEM_3GPP (self), NULL, NULL);
 }
 
 static void
@@ -1840,6 +1856,18 @@ huawei_hcsq_changed (MMPortSerialAt *port,
         g_free (str);
         return;
     }
+    g_free (str);
+
+    /* value1 is the RSSI in all 3GPP modes; normalized like ^RSSI, so that
+     * the signal quality doesn't need to be polled */
+    if ((act & (MM_MODEM_ACCESS_TECHNOLOGY_GSM | MM_MODEM_ACCESS_TECHNOLOGY_UMTS | MM_MODEM_ACCESS_TECHNOLOGY_LTE)) &&
+        get_rssi_dbm (value1, &v)) {
+        guint quality;
+
+        quality = CLAMP (((gint) v + 113) / 2, 0, 31) * 100 / 31;
+        mm_dbg ("3GPP signal quality: %u", quality);
+        mm_iface_modem_update_signal_quality (MM_IFACE_MODEM (self), quality);
+    }
 
     detailed_signal_clear (&self->priv->detailed_signal);
 
@@ -1909,6 +1937,14 @@ set_3gpp_unsolicited_events_handlers (MMBroadbandModemHuawei *self,
             enable ? self : NULL,
             NULL);
 
+        /* Service state related */
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            port,
+            self->priv->srvst_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn)huawei_srvst_changed : NULL,
+            enable ? self : NULL,
+            NULL);
+
         /* Connection status related */
         mm_port_serial_at_add_unsolicited_msg_handler (
             port,
@@ -3013,8 +3049,8 @@ huawei_voice_origination (MMPortSerialAt *port,
 
     mm_dbg ("[^ORIG] Origination call id '%u' of type '%u'", call_x, call_type);
 
-    /* TODO: Handle multiple calls
-     * mm_iface_modem_voice_set_call_id (MM_IFACE_MODEM_VOICE (self)); */
+    /* Let the call get its index */
+    mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -3029,7 +3065,8 @@ huawei_voice_ringback_tone (MMPortSerialAt *port,
 
     mm_dbg ("[^CONF] Ringback tone from call id '%u'", call_x);
 
-    mm_iface_modem_voice_call_dialing_to_ringing (MM_IFACE_MODEM_VOICE (self));
+    if (!mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self)))
+        mm_iface_modem_voice_call_dialing_to_ringing (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -3048,7 +3085,8 @@ huawei_voice_call_connection (MMPortSerialAt *port,
 
     mm_dbg ("[^CONN] Call id '%u' of type '%u' connected", call_x, call_type);
 
-    mm_iface_modem_voice_call_ringing_to_active (MM_IFACE_MODEM_VOICE (self));
+    if (!mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self)))
+        mm_iface_modem_voice_call_ringing_to_active (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -3075,7 +3113,8 @@ huawei_voice_call_end (MMPortSerialAt *port,
 
     mm_dbg ("[^CEND] Call '%u' terminated with status '%u' and cause '%u'. Duration of call '%d'", call_x, end_status, cc_cause, duration);
 
-    mm_iface_modem_voice_network_hangup (MM_IFACE_MODEM_VOICE (self));
+    if (!mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self)))
+        mm_iface_modem_voice_network_hangup (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -4238,6 +4277,28 @@ signal_load_values (MMIfaceModemSignal *_self,
                               task);
 }
 
+/*****************************************************************************/
+/* SIM state indications */
+
+static void
+huawei_simst_received (MMPortSerialAt *port,
+                       GMatchInfo *match_info,
+                       MMBroadbandModemHuawei *self)
+{
+    gchar *str;
+    const gchar *p;
+    guint sim_state;
+
+    /* ^SIMST:<sim_state>[,<lock_state>]; 1 is a valid SIM */
+    str = g_match_info_fetch (match_info, 0);
+    p = strstr (str, "^SIMST:");
+    if (p &&
+        sscanf (p + strlen ("^SIMST:"), "%u", &sim_state) == 1 &&
+        sim_state == 1)
+        mm_broadband_modem_notify_sim_ready (MM_BROADBAND_MODEM (self));
+    g_free (str);
+}
+
 /*****************************************************************************/
 /* Setup ports (Broadband modem class) */
 
@@ -4279,7 +4340,9 @@ set_ignored_unsolicited_events_handlers (MMBroadbandModemHuawei *self)
         mm_port_serial_at_add_unsolicited_msg_handler (
             port,
             self->priv->simst_regex,
-            NULL, NULL, NULL);
+            (MMPortSerialAtUnsolicitedMsgFn)huawei_simst_received,
+            self,
+            NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (
             port,
             self->priv->srvst_regex,
@@ -4416,7 +4479,7 @@ mm_broadband_modem_huawei_init (MMBroadbandModemHuawei *self)
                                                G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     self->priv->simst_regex = g_regex_new ("\\r\\n\\^SIMST:.+\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    self->priv->srvst_regex = g_regex_new ("\\r\\n\\^SRVST:.+\\r\\n",
+    self->priv->srvst_regex = g_regex_new ("\\r\\n\\^SRVST:\\s*(\\d+)\\r\\n",
                                            G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
     self->priv->stin_regex = g_regex_new ("\\r\\n\\^STIN:.+\\r\\n",
                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
@@ -4475,6 +4538,7 @@ mm_broadband_modem_huawei_init (MMBroadbandModemHuawei *self)
     self->priv->prefmode_support = FEATURE_SUPPORT_UNKNOWN;
     self->priv->nwtime_support = FEATURE_SUPPORT_UNKNOWN;
     self->priv->time_support = FEATURE_SUPPORT_UNKNOWN;
+    self->priv->srvst = G_MAXUINT;
 }
 
 static void
@@ -24,6 +24,7 @@
 
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
 #include "mm-modem-helpers-huawei.h"
 
 /*****************************************************************************/
@@ -69,10 +70,9 @@ mm_huawei_parse_ndisstatqry_response (const gchar *response,
 
     /* If multiple fields available, try first parsing method */
     if (strchr (response, ',')) {
-        r = g_regex_new ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d),([^,]*),([^,]*),([^,\\r\\n]*)(?:\\r\\n)?"
-                         "(?:\\^NDISSTAT:|\\^NDISSTATQRY:)?\\s*,?(\\d)?,?([^,]*)?,?([^,]*)?,?([^,\\r\\n]*)?(?:\\r\\n)?",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+        r = mm_regex_registry_get ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d),([^,]*),([^,]*),([^,\\r\\n]*)(?:\\r\\n)?"
+                                   "(?:\\^NDISSTAT:|\\^NDISSTATQRY:)?\\s*,?(\\d)?,?([^,]*)?,?([^,]*)?,?([^,\\r\\n]*)?(?:\\r\\n)?",
+                                   G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
         g_assert (r != NULL);
 
         g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -112,9 +112,8 @@ mm_huawei_parse_ndisstatqry_response (const gchar *response,
     }
     /* No separate IPv4/IPv6 info given just connected/not connected */
     else {
-        r = g_regex_new ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d)(?:\\r\\n)?",
-                         G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                         0, NULL);
+        r = mm_regex_registry_get ("\\^NDISSTAT(?:QRY)?(?:Qry)?:\\s*(\\d)(?:\\r\\n)?",
+                                   G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
         g_assert (r != NULL);
 
         g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -230,7 +229,7 @@ mm_huawei_parse_dhcp_response (const char *reply,
      * actually 10.10.1.1.
      */
 
-    r = g_regex_new ("\\^DHCP:\\s*([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),.*$", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\^DHCP:\\s*([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),([0-9a-fA-F]+),.*$", 0);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -296,7 +295,7 @@ mm_huawei_parse_sysinfo_response (const char *reply,
      */
 
     /* Can't just use \d here since sometimes you get "^SYSINFO:2,1,0,3,1,,3" */
-    r = g_regex_new ("\\^SYSINFO:\\s*(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\^SYSINFO:\\s*(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),?(\\d+)?,?(\\d+)?$", 0);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -364,7 +363,7 @@ mm_huawei_parse_sysinfoex_response (const char *reply,
 
     /* ^SYSINFOEX:2,3,0,1,,3,"WCDMA",41,"HSPA+" */
 
-    r = g_regex_new ("\\^SYSINFOEX:\\s*(\\d+),(\\d+),(\\d+),(\\d+),?(\\d*),(\\d+),\"?([^\"]*)\"?,(\\d+),\"?([^\"]*)\"?$", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\^SYSINFOEX:\\s*(\\d+),(\\d+),(\\d+),(\\d+),?(\\d*),(\\d+),\"?([^\"]*)\"?,(\\d+),\"?([^\"]*)\"?$", 0);
     g_assert (r != NULL);
 
     matched = g_regex_match_full (r, reply, -1, 0, 0, &match_info, &match_error);
@@ -1203,7 +1202,7 @@ gboolean mm_huawei_parse_nwtime_response (const gchar *response,
 
     g_assert (iso8601p || tzp); /* at least one */
 
-    r = g_regex_new ("\\^NWTIME:\\s*(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d*)([\\-\\+\\d]+),(\\d+)$", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\^NWTIME:\\s*(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d*)([\\-\\+\\d]+),(\\d+)$", 0);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -1290,7 +1289,7 @@ gboolean mm_huawei_parse_time_response (const gchar *response,
     }
 
     /* Already in ISO-8601 format, but verify just to be sure */
-    r = g_regex_new ("\\^TIME:\\s*(\\d+)/(\\d+)/(\\d+)\\s*(\\d+):(\\d+):(\\d*)$", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\^TIME:\\s*(\\d+)/(\\d+)/(\\d+)\\s*(\\d+):(\\d+):(\\d*)$", 0);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
@@ -1349,60 +1348,86 @@ mm_huawei_parse_hcsq_response (const gchar *response,
                                guint *out_value5,
                                GError **error)
 {
-    GRegex *r;
-    GMatchInfo *match_info = NULL;
-    GError *match_error = NULL;
-    gboolean ret = FALSE;
-    char *s;
+    const gchar *p;
+    const gchar *sysmode;
+    gsize sysmode_len;
+    guint values[5] = { 0 };
+    guint n_values = 0;
 
-    r = g_regex_new ("\\^HCSQ:\\s*\"([a-zA-Z]*)\",(\\d+),?(\\d+)?,?(\\d+)?,?(\\d+)?,?(\\d+)?$", 0, 0, NULL);
-    g_assert (r != NULL);
+    /* ^HCSQ: "<sysmode>",<value1>[,<value2>[,<value3>[,<value4>[,<value5>]]]]
+     *
+     * Tokenized instead of matched with a regex, as this is parsed for each
+     * unsolicited message, which some modems send every few seconds. */
+    p = strstr (response, "^HCSQ:");
+    if (!p)
+        goto invalid;
+    p += 6;
+    while (*p == ' ')
+        p++;
 
-    if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
-        if (match_error) {
-            g_propagate_error (error, match_error);
-            g_prefix_error (error, "Could not parse ^HCSQ results: ");
-        } else {
-            g_set_error_literal (error,
-                                 MM_CORE_ERROR,
-                                 MM_CORE_ERROR_FAILED,
-                                 "Couldn't match ^HCSQ reply");
-        }
-        goto done;
+    if (*p++ != '"')
+        goto invalid;
+    sysmode = p;
+    while (g_ascii_isalpha (*p))
+        p++;
+    if (*p++ != '"')
+        goto invalid;
+    sysmode_len = p - sysmode - 1;
+
+    while (*p == ',' && n_values < G_N_ELEMENTS (values)) {
+        gchar *end;
+        guint64 num;
+
+        p++;
+        if (!g_ascii_isdigit (*p))
+            goto invalid;
+        num = g_ascii_strtoull (p, &end, 10);
+        if (num > G_MAXUINT)
+            goto invalid;
+        values[n_values++] = (guint) num;
+        p = end;
     }
 
-    /* Remember that g_match_info_get_match_count() includes match #0 */
-    if (g_match_info_get_match_count (match_info) < 3) {
+    /* Only the line terminator may follow */
+    while (*p == '\r' || *p == '\n')
+        p++;
+    if (*p)
+        goto invalid;
+
+    if (!n_values) {
         g_set_error_literal (error,
                              MM_CORE_ERROR,
                              MM_CORE_ERROR_FAILED,
                              "Not enough elements in ^HCSQ reply");
-        goto done;
+        return FALSE;
     }
 
     if (out_act) {
-        s = g_match_info_fetch (match_info, 1);
-        *out_act = mm_string_to_access_tech (s);
-        g_free (s);
-    }
+        gchar *str;
 
-    if (out_value1)
-        mm_get_uint_from_match_info (match_info, 2, out_value1);
-    if (out_value2)
-        mm_get_uint_from_match_info (match_info, 3, out_value2);
-    if (out_value3)
-        mm_get_uint_from_match_info (match_info, 4, out_value3);
-    if (out_value4)
-        mm_get_uint_from_match_info (match_info, 5, out_value4);
-    if (out_value5)
-        mm_get_uint_from_match_info (match_info, 6, out_value5);
+        str = g_strndup (sysmode, sysmode_len);
+        *out_act = mm_string_to_access_tech (str);
+        g_free (str);
+    }
 
-    ret = TRUE;
+    /* Values not given are left untouched */
+    if (out_value1 && n_values > 0)
+        *out_value1 = values[0];
+    if (out_value2 && n_values > 1)
+        *out_value2 = values[1];
+    if (out_value3 && n_values > 2)
+        *out_value3 = values[2];
+    if (out_value4 && n_values > 3)
+        *out_value4 = values[3];
+    if (out_value5 && n_values > 4)
+        *out_value5 = values[4];
 
-done:
-    if (match_info)
-        g_match_info_free (match_info);
-    g_regex_unref (r);
+    return TRUE;
 
-    return ret;
+invalid:
+    g_set_error_literal (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_FAILED,
+                         "Couldn't match ^HCSQ reply");
+    return FALSE;
 }
@@ -55,11 +55,15 @@ typedef struct {
     guint first_usbif;
     guint timeout_id;
     gboolean custom_init_run;
+    /* Custom init contexts of the other interfaces, waiting for the first one */
+    GList *waiting;
 } FirstInterfaceContext;
 
 static void
 first_interface_context_free (FirstInterfaceContext *ctx)
 {
+    /* Waiting contexts hold a reference to a probe, which holds the device */
+    g_assert (ctx->waiting == NULL);
     if (ctx->timeout_id)
         g_source_remove (ctx->timeout_id);
     g_slice_free (FirstInterfaceContext, ctx);
@@ -106,6 +110,53 @@ huawei_custom_init_finish (MMPortProbe *probe,
 
 static void huawei_custom_init_step (HuaweiCustomInitContext *ctx);
 
+/* Called whenever the first interface changes or gets its custom init run, so
+ * that the interfaces waiting for it go on right away instead of being
+ * deferred */
+static void
+first_interface_release_waiting (FirstInterfaceContext *fi_ctx,
+                                 gboolean abort)
+{
+    GList *waiting;
+    GList *l;
+
+    waiting = fi_ctx->waiting;
+    fi_ctx->waiting = NULL;
+
+    for (l = waiting; l; l = g_list_next (l)) {
+        HuaweiCustomInitContext *ctx = l->data;
+
+        if (fi_ctx->custom_init_run || g_cancellable_is_cancelled (ctx->cancellable))
+            /* If custom init was run already, we can consider this as successfully run */
+            g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        else if (abort)
+            /* First interface gone without running custom init; fall back to
+             * deferring the probing */
+            g_simple_async_result_set_error (ctx->result,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_RETRY,
+                                             "Defer needed");
+        else if (mm_kernel_device_get_property_as_int (mm_port_probe_peek_port (ctx->probe),
+                                                       "ID_USB_INTERFACE_NUM") == fi_ctx->first_usbif) {
+            /* This one is now the first interface */
+            if (fi_ctx->timeout_id) {
+                g_source_remove (fi_ctx->timeout_id);
+                fi_ctx->timeout_id = 0;
+            }
+            huawei_custom_init_step (ctx);
+            continue;
+        } else {
+            /* Keep on waiting */
+            fi_ctx->waiting = g_list_append (fi_ctx->waiting, ctx);
+            continue;
+        }
+
+        huawei_custom_init_context_complete_and_free (ctx);
+    }
+
+    g_list_free (waiting);
+}
+
 static void
 cache_port_mode (MMDevice *device,
                  const gchar *reply,
@@ -248,6 +299,7 @@ try_next_usbif (MMDevice *device)
     }
 
     fi_ctx->first_usbif = closest;
+    first_interface_release_waiting (fi_ctx, closest == 0);
 }
 
 static void
@@ -260,6 +312,9 @@ huawei_custom_init_step (HuaweiCustomInitContext *ctx)
     if (g_cancellable_is_cancelled (ctx->cancellable)) {
         mm_dbg ("(Huawei) no need to keep on running custom init in (%s)",
                 mm_port_get_device (MM_PORT (ctx->port)));
+        fi_ctx = g_object_get_data (G_OBJECT (mm_port_probe_peek_device (ctx->probe)), TAG_FIRST_INTERFACE_CONTEXT);
+        if (fi_ctx && !fi_ctx->custom_init_run)
+            first_interface_release_waiting (fi_ctx, TRUE);
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         huawei_custom_init_context_complete_and_free (ctx);
         return;
@@ -317,6 +372,9 @@ huawei_custom_init_step (HuaweiCustomInitContext *ctx)
     g_assert (fi_ctx != NULL);
     fi_ctx->custom_init_run = TRUE;
 
+    /* The port layout is in the device already, let the others go on */
+    first_interface_release_waiting (fi_ctx, FALSE);
+
     g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
     huawei_custom_init_context_complete_and_free (ctx);
 }
@@ -331,6 +389,26 @@ first_interface_missing_timeout_cb (MMDevice *device)
     return G_SOURCE_CONTINUE;
 }
 
+/* The udev rules flag the PCUI port when the interface layout is known; that
+ * one is then the best first interface, and we don't need to wait for
+ * interface 0 to show up */
+static gint
+find_udev_tagged_at_usbif (MMDevice *device)
+{
+    GList *l;
+
+    for (l = mm_device_peek_port_probe_list (device); l; l = g_list_next (l)) {
+        MMKernelDevice *port;
+
+        port = mm_port_probe_peek_port (MM_PORT_PROBE (l->data));
+        if (g_str_equal (mm_port_probe_get_port_subsys (MM_PORT_PROBE (l->data)), "tty") &&
+            mm_kernel_device_get_property_as_boolean (port, "ID_MM_HUAWEI_AT_PORT"))
+            return mm_kernel_device_get_property_as_int (port, "ID_USB_INTERFACE_NUM");
+    }
+
+    return -1;
+}
+
 static void
 huawei_custom_init (MMPortProbe *probe,
                     MMPortSerialAt *port,
@@ -341,6 +419,7 @@ huawei_custom_init (MMPortProbe *probe,
     MMDevice *device;
     FirstInterfaceContext *fi_ctx;
     HuaweiCustomInitContext *ctx;
+    gint usbif;
 
     device = mm_port_probe_peek_device (probe);
 
@@ -368,8 +447,14 @@ huawei_custom_init (MMPortProbe *probe,
                                                     (GSourceFunc)first_interface_missing_timeout_cb,
                                                     device);
 
-        /* By default, we'll ask the Huawei plugin to start probing usbif 0 */
-        fi_ctx->first_usbif = 0;
+        /* By default, we'll ask the Huawei plugin to start probing usbif 0,
+         * unless udev already told us which one is the AT port */
+        usbif = find_udev_tagged_at_usbif (device);
+        if (usbif >= 0) {
+            mm_dbg ("(Huawei) Will run initial probing in udev tagged AT interface '%d'", usbif);
+            fi_ctx->first_usbif = usbif;
+        } else
+            fi_ctx->first_usbif = 0;
 
         /* Custom init of the Huawei plugin is to be run only in the first
          * interface. We'll control here whether we did run it already or not. */
@@ -389,21 +474,29 @@ huawei_custom_init (MMPortProbe *probe,
     ctx->getportmode_done = FALSE;
     ctx->getportmode_retries = 3;
 
-    /* Custom init only to be run in the first interface */
-    if (mm_kernel_device_get_property_as_int (mm_port_probe_peek_port (probe),
-                                              "ID_USB_INTERFACE_NUM") != fi_ctx->first_usbif) {
+    usbif = mm_kernel_device_get_property_as_int (mm_port_probe_peek_port (probe), "ID_USB_INTERFACE_NUM");
 
-        if (fi_ctx->custom_init_run)
+    /* A udev tagged AT port showing up while still waiting for the first
+     * interface to appear becomes the first one */
+    if (usbif != fi_ctx->first_usbif &&
+        fi_ctx->timeout_id &&
+        g_str_equal (mm_port_probe_get_port_subsys (probe), "tty") &&
+        mm_kernel_device_get_property_as_boolean (mm_port_probe_peek_port (probe), "ID_MM_HUAWEI_AT_PORT")) {
+        mm_dbg ("(Huawei) Will run initial probing in udev tagged AT interface '%d' instead", usbif);
+        fi_ctx->first_usbif = usbif;
+    }
+
+    /* Custom init only to be run in the first interface */
+    if (usbif != fi_ctx->first_usbif) {
+        if (fi_ctx->custom_init_run) {
             /* If custom init was run already, we can consider this as successfully run */
             g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-        else
-            /* Otherwise, we'll need to defer the probing a bit more */
-            g_simple_async_result_set_error (ctx->result,
-                                             MM_CORE_ERROR,
-                                             MM_CORE_ERROR_RETRY,
-                                             "Defer needed");
+            huawei_custom_init_context_complete_and_free (ctx);
+            return;
+        }
 
-        huawei_custom_init_context_complete_and_free (ctx);
+        /* Otherwise, wait until it is */
+        fi_ctx->waiting = g_list_append (fi_ctx->waiting, ctx);
         return;
     }
 
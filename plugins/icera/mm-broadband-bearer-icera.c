@@ -35,6 +35,22 @@
 #include "mm-daemon-enums-types.h"
 #include "mm-modem-helpers-icera.h"
 
+/* Connection and disconnection are completed by %IPDPACT; the timeouts are
+ * only a safety net, sized from the slowest attempt seen so far and never
+ * longer than the maximum */
+#define CONNECT_TIMEOUT_MIN_SECS    20
+#define DISCONNECT_TIMEOUT_MIN_SECS 10
+#define PENDING_TIMEOUT_MAX_SECS    60
+#define PENDING_TIMEOUT_FACTOR      4
+
+/* Time to wait for %IPDPACT to report the context down before configuring
+ * it again, if it doesn't come */
+#define DEACTIVATION_TIMEOUT_SECS 5
+
+/* Time to wait before configuring the context again after a failure, when no
+ * %IPDPACT report is expected */
+#define AUTHENTICATION_RETRY_DELAY_SECS 1
+
 G_DEFINE_TYPE (MMBroadbandBearerIcera, mm_broadband_bearer_icera, MM_TYPE_BROADBAND_BEARER);
 
 enum {
@@ -53,12 +69,50 @@ struct _MMBroadbandBearerIceraPrivate {
     guint connect_pending_id;
     gulong connect_cancellable_id;
     gulong connect_port_closed_id;
+    gint64 connect_started;
+    gint64 connect_time_max;
+
+    /* Context deactivation before connecting */
+    gpointer deactivation_pending;
+    guint deactivation_pending_id;
 
     /* Disconnection related */
     gpointer disconnect_pending;
     guint disconnect_pending_id;
+    gint64 disconnect_started;
+    gint64 disconnect_time_max;
 };
 
+/*****************************************************************************/
+
+static guint
+pending_timeout_secs (gint64 time_max,
+                      guint min_secs)
+{
+    guint64 secs;
+
+    /* Nothing seen yet */
+    if (!time_max)
+        return PENDING_TIMEOUT_MAX_SECS;
+
+    secs = (PENDING_TIMEOUT_FACTOR * time_max + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC;
+    return (guint) CLAMP (secs, min_secs, PENDING_TIMEOUT_MAX_SECS);
+}
+
+static void
+update_time_max (gint64 started,
+                 gint64 *time_max,
+                 const gchar *operation)
+{
+    gint64 elapsed;
+
+    elapsed = g_get_monotonic_time () - started;
+    if (elapsed > *time_max) {
+        *time_max = elapsed;
+        mm_dbg ("Slowest %s so far: %.1fs", operation, (gdouble) elapsed / G_USEC_PER_SEC);
+    }
+}
+
 /*****************************************************************************/
 /* 3GPP IP config retrieval (sub-step of the 3GPP Connection sequence) */
 
@@ -321,6 +375,7 @@ report_disconnect_status (MMBroadbandBearerIcera *self,
     /* Received 'DISCONNECTED' during a disconnection attempt? */
     if (status == MM_BEARER_CONNECTION_STATUS_DISCONNECTED ||
         status == MM_BEARER_CONNECTION_STATUS_CONNECTION_FAILED) {
+        update_time_max (self->priv->disconnect_started, &self->priv->disconnect_time_max, "disconnection");
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         disconnect_3gpp_context_complete_and_free (ctx);
         return;
@@ -362,8 +417,9 @@ disconnect_ipdpact_ready (MMBaseModem *modem,
         return;
     }
 
-    /* Set a 60-second disconnection-failure timeout */
-    self->priv->disconnect_pending_id = g_timeout_add_seconds (60,
+    /* Set a disconnection-failure timeout */
+    self->priv->disconnect_pending_id = g_timeout_add_seconds (pending_timeout_secs (self->priv->disconnect_time_max,
+                                                                                     DISCONNECT_TIMEOUT_MIN_SECS),
                                                                (GSourceFunc)disconnect_3gpp_timed_out_cb,
                                                                self);
 }
@@ -397,6 +453,7 @@ disconnect_3gpp (MMBroadbandBearer *bearer,
      * already completed in the unsolicited handling) */
     g_assert (ctx->self->priv->disconnect_pending == NULL);
     ctx->self->priv->disconnect_pending = ctx;
+    ctx->self->priv->disconnect_started = g_get_monotonic_time ();
 
     command = g_strdup_printf ("%%IPDPACT=%d,0", cid);
     mm_base_modem_at_command_full (
@@ -658,6 +715,7 @@ report_connect_status (MMBroadbandBearerIcera *self,
             return;
         }
 
+        update_time_max (self->priv->connect_started, &self->priv->connect_time_max, "connection");
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_object_ref (ctx->data),
                                                    (GDestroyNotify)g_object_unref);
@@ -734,7 +792,8 @@ activate_ready (MMBaseModem *modem,
      * Reports of modem being connected will arrive via unsolicited messages.
      * This timeout should be long enough. Actually... ideally should never get
      * reached. */
-    self->priv->connect_pending_id = g_timeout_add_seconds (60,
+    self->priv->connect_pending_id = g_timeout_add_seconds (pending_timeout_secs (self->priv->connect_time_max,
+                                                                                  CONNECT_TIMEOUT_MIN_SECS),
                                                             (GSourceFunc)connect_timed_out_cb,
                                                             self);
 
@@ -754,13 +813,50 @@ activate_ready (MMBaseModem *modem,
 
 static void authenticate (Dial3gppContext *ctx);
 
-static gboolean
-retry_authentication_cb (Dial3gppContext *ctx)
+static void
+deactivation_complete (MMBroadbandBearerIcera *self)
 {
+    Dial3gppContext *ctx;
+
+    /* Recover context and remove it from the private info */
+    ctx = self->priv->deactivation_pending;
+    self->priv->deactivation_pending = NULL;
+    g_assert (ctx != NULL);
+
+    if (self->priv->deactivation_pending_id) {
+        g_source_remove (self->priv->deactivation_pending_id);
+        self->priv->deactivation_pending_id = 0;
+    }
+
+    /* If cancelled, complete */
+    if (dial_3gpp_context_complete_and_free_if_cancelled (ctx))
+        return;
+
     authenticate (ctx);
+}
+
+static gboolean
+deactivation_timed_out_cb (MMBroadbandBearerIcera *self)
+{
+    mm_dbg ("Context deactivation not reported, configuring it anyway");
+    self->priv->deactivation_pending_id = 0;
+    deactivation_complete (self);
     return G_SOURCE_REMOVE;
 }
 
+static void
+wait_deactivation (Dial3gppContext *ctx,
+                   guint timeout_secs)
+{
+    /* The context is configured once %IPDPACT reports it down, or once the
+     * timeout expires */
+    g_assert (ctx->self->priv->deactivation_pending == NULL);
+    ctx->self->priv->deactivation_pending = ctx;
+    ctx->self->priv->deactivation_pending_id = g_timeout_add_seconds (timeout_secs,
+                                                                      (GSourceFunc)deactivation_timed_out_cb,
+                                                                      ctx->self);
+}
+
 static void
 authenticate_ready (MMBaseModem *modem,
                     GAsyncResult *res,
@@ -776,11 +872,15 @@ authenticate_ready (MMBaseModem *modem,
     if (!mm_base_modem_at_command_full_finish (modem, res, &error)) {
         /* Retry configuring the context. It sometimes fails with a 583
          * error ["a profile (CID) is currently active"] if a connect
-         * is attempted too soon after a disconnect. */
-        if (++ctx->authentication_retries < 3) {
+         * is attempted too soon after a disconnect; that one isn't a known
+         * error code, any other error is final. */
+        if (g_error_matches (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN) &&
+            ++ctx->authentication_retries < 3) {
             mm_dbg ("Authentication failed: '%s'; retrying...", error->message);
             g_error_free (error);
-            g_timeout_add_seconds (1, (GSourceFunc)retry_authentication_cb, ctx);
+            /* No %IPDPACT report is expected here, so just retry after
+             * a short delay, or earlier if the context is reported down */
+            wait_deactivation (ctx, AUTHENTICATION_RETRY_DELAY_SECS);
             return;
         }
 
@@ -798,6 +898,7 @@ authenticate_ready (MMBaseModem *modem,
      * already completed in the unsolicited handling) */
     g_assert (ctx->self->priv->connect_pending == NULL);
     ctx->self->priv->connect_pending = ctx;
+    ctx->self->priv->connect_started = g_get_monotonic_time ();
 
     command = g_strdup_printf ("%%IPDPACT=%d,1", ctx->cid);
     mm_base_modem_at_command_full (
@@ -888,9 +989,13 @@ deactivate_ready (MMBaseModem *modem,
      * if the context is not, in fact, connected. This is annoying but
      * harmless.
      */
-    mm_base_modem_at_command_full_finish (modem, res, NULL);
+    if (!mm_base_modem_at_command_full_finish (modem, res, NULL)) {
+        authenticate (ctx);
+        return;
+    }
 
-    authenticate (ctx);
+    /* The context was active; configuring it before it is down fails */
+    wait_deactivation (ctx, DEACTIVATION_TIMEOUT_SECS);
 }
 
 static void
@@ -964,6 +1069,14 @@ report_connection_status (MMBaseBearer *bearer,
 {
     MMBroadbandBearerIcera *self = MM_BROADBAND_BEARER_ICERA (bearer);
 
+    /* Process pending context deactivation before connecting */
+    if (self->priv->deactivation_pending) {
+        if (status == MM_BEARER_CONNECTION_STATUS_DISCONNECTED ||
+            status == MM_BEARER_CONNECTION_STATUS_CONNECTION_FAILED)
+            deactivation_complete (self);
+        return;
+    }
+
     /* Process pending connection attempt */
     if (self->priv->connect_pending) {
         report_connect_status (self, status);
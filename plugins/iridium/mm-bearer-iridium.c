@@ -134,6 +134,8 @@ dial_ready (MMBaseModem *modem,
         return;
     }
 
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
+
     /* Port is connected; update the state */
     mm_port_set_connected (MM_PORT (ctx->primary), TRUE);
 
@@ -42,6 +42,12 @@
 #include "mm-modem-helpers-mbm.h"
 #include "mm-daemon-enums-types.h"
 
+/* Connection state changes are reported with *E2NAP; *ENAP? is only polled
+ * as a fallback for firmware that doesn't send them, so do it sparsely */
+#define ENAP_POLL_INTERVAL_SECS 5
+#define CONNECT_POLL_MAX        (50 / ENAP_POLL_INTERVAL_SECS)
+#define DISCONNECT_POLL_MAX     (20 / ENAP_POLL_INTERVAL_SECS)
+
 G_DEFINE_TYPE (MMBroadbandBearerMbm, mm_broadband_bearer_mbm, MM_TYPE_BROADBAND_BEARER);
 
 struct _MMBroadbandBearerMbmPrivate {
@@ -129,6 +135,8 @@ dial_3gpp_finish (MMBroadbandBearer *self,
     return MM_PORT (g_object_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res))));
 }
 
+static gboolean handle_e2nap_connect_status (Dial3gppContext *ctx);
+
 static void
 dial_3gpp_report_connection_status (gpointer data,
                                     MMBearerConnectionStatus status)
@@ -137,6 +145,13 @@ dial_3gpp_report_connection_status (gpointer data,
 
     g_assert (ctx);
     ctx->e2nap_status = status;
+
+    /* If waiting for the next poll and the status is final, complete right
+     * away (which also removes the poll); for any other status keep the poll
+     * armed. If a command is in flight, it will process the status once it's
+     * done */
+    if (ctx->poll_id)
+        handle_e2nap_connect_status (ctx);
 }
 
 static void
@@ -229,9 +244,9 @@ connect_poll_ready (MMBaseModem *modem,
     if (handle_e2nap_connect_status (ctx))
         return;
 
-    /* Check again in one second */
+    /* Check again later */
     g_assert (ctx->poll_id == 0);
-    ctx->poll_id = g_timeout_add_seconds (1,
+    ctx->poll_id = g_timeout_add_seconds (ENAP_POLL_INTERVAL_SECS,
                                           (GSourceFunc)connect_poll_cb,
                                           ctx);
 }
@@ -256,7 +271,7 @@ connect_poll_cb (Dial3gppContext *ctx)
         return G_SOURCE_REMOVE;
 
     /* Too many retries... */
-    if (ctx->poll_count > 50) {
+    if (ctx->poll_count > CONNECT_POLL_MAX) {
         g_simple_async_result_set_error (ctx->result,
                                          MM_MOBILE_EQUIPMENT_ERROR,
                                          MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,
@@ -300,7 +315,7 @@ activate_ready (MMBaseModem *modem,
 
     /* No unsolicited E2NAP status yet; wait for it and periodically poll
      * to handle very old F3507g/MD300 firmware that may not send E2NAP. */
-    ctx->poll_id = g_timeout_add_seconds (1,
+    ctx->poll_id = g_timeout_add_seconds (ENAP_POLL_INTERVAL_SECS,
                                           (GSourceFunc)connect_poll_cb,
                                           ctx);
 }
@@ -626,6 +641,8 @@ disconnect_3gpp_finish (MMBroadbandBearer *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+static gboolean handle_e2nap_disconnect_status (DisconnectContext *ctx);
+
 static void
 disconnect_report_connection_status (gpointer data,
                                      MMBearerConnectionStatus status)
@@ -634,6 +651,13 @@ disconnect_report_connection_status (gpointer data,
 
     g_assert (ctx);
     ctx->e2nap_status = status;
+
+    /* If waiting for the next poll and the status is final, complete right
+     * away (which also removes the poll); for any other status keep the poll
+     * armed. If a command is in flight, it will process the status once it's
+     * done */
+    if (ctx->poll_id)
+        handle_e2nap_disconnect_status (ctx);
 }
 
 static gboolean
@@ -676,9 +700,13 @@ disconnect_poll_ready (MMBaseModem *modem,
         return;
     }
 
-    /* Check again in one second */
+    /* Process any unsolicited E2NAP status received while polling */
+    if (handle_e2nap_disconnect_status (ctx))
+        return;
+
+    /* Check again later */
     g_assert (ctx->poll_id == 0);
-    ctx->poll_id = g_timeout_add_seconds (1,
+    ctx->poll_id = g_timeout_add_seconds (ENAP_POLL_INTERVAL_SECS,
                                           (GSourceFunc)disconnect_poll_cb,
                                           ctx);
 }
@@ -693,7 +721,7 @@ disconnect_poll_cb (DisconnectContext *ctx)
         return G_SOURCE_REMOVE;
 
     /* Too many retries... */
-    if (ctx->poll_count > 20) {
+    if (ctx->poll_count > DISCONNECT_POLL_MAX) {
         g_simple_async_result_set_error (ctx->result,
                                          MM_MOBILE_EQUIPMENT_ERROR,
                                          MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,
@@ -735,7 +763,7 @@ disconnect_enap_ready (MMBaseModem *modem,
 
     /* No unsolicited E2NAP status yet; wait for it and periodically poll
      * to handle very old F3507g/MD300 firmware that may not send E2NAP. */
-    ctx->poll_id = g_timeout_add_seconds (1,
+    ctx->poll_id = g_timeout_add_seconds (ENAP_POLL_INTERVAL_SECS,
                                           (GSourceFunc)disconnect_poll_cb,
                                           ctx);
 }
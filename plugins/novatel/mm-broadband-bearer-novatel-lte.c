@@ -31,10 +31,24 @@
 #include "mm-broadband-bearer-novatel-lte.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-netlink-monitor.h"
+#include "mm-poll-scheduler.h"
 
-#define CONNECTION_CHECK_TIMEOUT_SEC 5
+/* Losing the connection is detected by the generic bearer through the carrier
+ * of the net port; this is just a watchdog in case the modem doesn't drop it */
+#define CONNECTION_CHECK_TIMEOUT_SEC 60
 #define QMISTATUS_TAG "$NWQMISTATUS:"
 
+/* The connection status is checked soon after the connect request, backing
+ * off to once per second */
+#define CONNECT_STATUS_INITIAL_MS 250
+#define CONNECT_STATUS_MAX_MS     1000
+
+/* The disconnection is detected when the net port loses carrier; the status
+ * is only checked as a fallback, sparsely */
+#define DISCONNECT_STATUS_INTERVAL_SEC 5
+#define DISCONNECT_STATUS_RETRIES      12
+
 G_DEFINE_TYPE (MMBroadbandBearerNovatelLte, mm_broadband_bearer_novatel_lte, MM_TYPE_BROADBAND_BEARER);
 
 struct _MMBroadbandBearerNovatelLtePrivate {
@@ -69,6 +83,7 @@ typedef struct {
     GCancellable *cancellable;
     GSimpleAsyncResult *result;
     gint retries;
+    guint status_delay_ms;
 } DetailedConnectContext;
 
 static void
@@ -134,14 +149,18 @@ poll_connection_ready (MMBaseModem *modem,
     if (!result) {
         mm_warn ("QMI connection status failed: %s", error->message);
         g_error_free (error);
+        g_object_unref (bearer);
         return;
     }
 
     if (is_qmistatus_disconnected (result)) {
+        if (bearer->priv->connection_poller) {
+            mm_poll_scheduler_remove (bearer->priv->connection_poller);
+            bearer->priv->connection_poller = 0;
+        }
         mm_base_bearer_report_connection_status (MM_BASE_BEARER (bearer), MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
-        g_source_remove (bearer->priv->connection_poller);
-        bearer->priv->connection_poller = 0;
     }
+    g_object_unref (bearer);
 }
 
 static gboolean
@@ -158,7 +177,7 @@ poll_connection (MMBroadbandBearerNovatelLte *bearer)
         3,
         FALSE,
         (GAsyncReadyCallback)poll_connection_ready,
-        bearer);
+        g_object_ref (bearer));
     g_object_unref (modem);
 
     return G_SOURCE_CONTINUE;
@@ -187,9 +206,14 @@ connect_3gpp_qmistatus_ready (MMBaseModem *modem,
         MMBearerIpConfig *config;
 
         mm_dbg("Connected");
-        ctx->self->priv->connection_poller = g_timeout_add_seconds (CONNECTION_CHECK_TIMEOUT_SEC,
-                                                                    (GSourceFunc)poll_connection,
-                                                                    ctx->self);
+        mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
+        g_assert (!ctx->self->priv->connection_poller);
+        ctx->self->priv->connection_poller = mm_poll_scheduler_add_full ("novatel-lte-connection",
+                                                                         MM_POLL_SCHEDULER_STAGE_BEARER,
+                                                                         CONNECTION_CHECK_TIMEOUT_SEC,
+                                                                         MM_POLL_SCHEDULER_DEFAULT_SLACK (CONNECTION_CHECK_TIMEOUT_SEC),
+                                                                         (GSourceFunc)poll_connection,
+                                                                         ctx->self);
         config = mm_bearer_ip_config_new ();
         mm_bearer_ip_config_set_method (config, MM_BEARER_IP_METHOD_DHCP);
         g_simple_async_result_set_op_res_gpointer (
@@ -217,9 +241,10 @@ connect_3gpp_qmistatus_ready (MMBaseModem *modem,
 
     if (ctx->retries > 0) {
         ctx->retries--;
-        mm_dbg ("Retrying status check in a second. %d retries left.",
-                ctx->retries);
-        g_timeout_add_seconds (1, (GSourceFunc)connect_3gpp_qmistatus, ctx);
+        mm_dbg ("Retrying status check in %u ms. %d retries left.",
+                ctx->status_delay_ms, ctx->retries);
+        g_timeout_add (ctx->status_delay_ms, (GSourceFunc)connect_3gpp_qmistatus, ctx);
+        ctx->status_delay_ms = MIN (ctx->status_delay_ms * 2, CONNECT_STATUS_MAX_MS);
         return;
     }
 
@@ -271,9 +296,11 @@ connect_3gpp_qmiconnect_ready (MMBaseModem *modem,
      * The connection takes a bit of time to set up, but there's no
      * asynchronous notification from the modem when this has
      * happened. Instead, we need to poll the modem to see if it's
-     * ready.
+     * ready; it usually is very soon, so start checking early.
      */
-    g_timeout_add_seconds (1, (GSourceFunc)connect_3gpp_qmistatus, ctx);
+    ctx->status_delay_ms = CONNECT_STATUS_INITIAL_MS;
+    g_timeout_add (ctx->status_delay_ms, (GSourceFunc)connect_3gpp_qmistatus, ctx);
+    ctx->status_delay_ms *= 2;
 }
 
 static void
@@ -351,6 +378,10 @@ typedef struct {
     MMPort *data;
     GSimpleAsyncResult *result;
     gint retries;
+    guint link_watch_id;
+    guint status_id;
+    gboolean status_running;
+    gboolean link_lost;
 } DetailedDisconnectContext;
 
 static DetailedDisconnectContext *
@@ -372,13 +403,17 @@ detailed_disconnect_context_new (MMBroadbandBearer *self,
                                              callback,
                                              user_data,
                                              detailed_disconnect_context_new);
-    ctx->retries = 60;
+    ctx->retries = DISCONNECT_STATUS_RETRIES;
     return ctx;
 }
 
 static void
 detailed_disconnect_context_complete_and_free (DetailedDisconnectContext *ctx)
 {
+    if (ctx->link_watch_id)
+        mm_netlink_monitor_unwatch (ctx->link_watch_id);
+    if (ctx->status_id)
+        g_source_remove (ctx->status_id);
     g_simple_async_result_complete_in_idle (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->data);
@@ -407,7 +442,17 @@ disconnect_3gpp_status_ready (MMBaseModem *modem,
     GError *error = NULL;
     gboolean is_connected = FALSE;
 
+    ctx->status_running = FALSE;
     result = mm_base_modem_at_command_full_finish (modem, res, &error);
+
+    /* Carrier lost while the status was being checked */
+    if (ctx->link_lost) {
+        g_clear_error (&error);
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        detailed_disconnect_context_complete_and_free (ctx);
+        return;
+    }
+
     if (result) {
         mm_dbg ("QMI connection status: %s", result);
         if (is_qmistatus_disconnected (result)) {
@@ -425,9 +470,11 @@ disconnect_3gpp_status_ready (MMBaseModem *modem,
 
     if (ctx->retries > 0) {
         ctx->retries--;
-        mm_dbg ("Retrying status check in a second. %d retries left.",
-                ctx->retries);
-        g_timeout_add_seconds (1, (GSourceFunc)disconnect_3gpp_qmistatus, ctx);
+        mm_dbg ("Retrying status check in %d seconds. %d retries left.",
+                DISCONNECT_STATUS_INTERVAL_SEC, ctx->retries);
+        ctx->status_id = g_timeout_add_seconds (DISCONNECT_STATUS_INTERVAL_SEC,
+                                                (GSourceFunc)disconnect_3gpp_qmistatus,
+                                                ctx);
         return;
     }
 
@@ -453,6 +500,8 @@ disconnect_3gpp_status_ready (MMBaseModem *modem,
 static gboolean
 disconnect_3gpp_qmistatus (DetailedDisconnectContext *ctx)
 {
+    ctx->status_id = 0;
+    ctx->status_running = TRUE;
     mm_base_modem_at_command_full (
         ctx->modem,
         ctx->primary,
@@ -466,6 +515,26 @@ disconnect_3gpp_qmistatus (DetailedDisconnectContext *ctx)
     return G_SOURCE_REMOVE;
 }
 
+static void
+disconnect_3gpp_link_lost (const gchar               *ifname,
+                           MMNetlinkMonitorEvent      event,
+                           DetailedDisconnectContext *ctx)
+{
+    mm_dbg ("Net port '%s' %s: disconnected",
+            ifname,
+            event == MM_NETLINK_MONITOR_EVENT_REMOVED ? "removed" : "lost carrier");
+
+    mm_netlink_monitor_unwatch (ctx->link_watch_id);
+    ctx->link_watch_id = 0;
+    ctx->link_lost = TRUE;
+
+    /* If a command is in flight, complete once it's done */
+    if (ctx->status_running)
+        return;
+
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    detailed_disconnect_context_complete_and_free (ctx);
+}
 
 static void
 disconnect_3gpp_check_status (MMBaseModem *modem,
@@ -480,6 +549,15 @@ disconnect_3gpp_check_status (MMBaseModem *modem,
         g_error_free (error);
     }
 
+    ctx->status_running = FALSE;
+
+    /* Carrier already lost */
+    if (ctx->link_lost) {
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        detailed_disconnect_context_complete_and_free (ctx);
+        return;
+    }
+
     disconnect_3gpp_qmistatus (ctx);
 }
 
@@ -497,12 +575,18 @@ disconnect_3gpp (MMBroadbandBearer *self,
     MMBroadbandBearerNovatelLte *bearer = MM_BROADBAND_BEARER_NOVATEL_LTE (self);
 
     if (bearer->priv->connection_poller) {
-        g_source_remove (bearer->priv->connection_poller);
+        mm_poll_scheduler_remove (bearer->priv->connection_poller);
         bearer->priv->connection_poller = 0;
     }
 
     ctx = detailed_disconnect_context_new (self, modem, primary, data, callback, user_data);
 
+    /* Complete as soon as the net port loses carrier */
+    ctx->link_watch_id = mm_netlink_monitor_watch (mm_port_get_device (data),
+                                                   (MMNetlinkMonitorFunc)disconnect_3gpp_link_lost,
+                                                   ctx);
+    ctx->status_running = TRUE;
+
     mm_base_modem_at_command_full (
         ctx->modem,
         ctx->primary,
@@ -571,7 +655,7 @@ finalize (GObject *object)
     MMBroadbandBearerNovatelLte *self = MM_BROADBAND_BEARER_NOVATEL_LTE (object);
 
     if (self->priv->connection_poller)
-        g_source_remove (self->priv->connection_poller);
+        mm_poll_scheduler_remove (self->priv->connection_poller);
 
     G_OBJECT_CLASS (mm_broadband_bearer_novatel_lte_parent_class)->finalize (object);
 }
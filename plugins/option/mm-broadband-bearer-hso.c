@@ -36,12 +36,18 @@
 
 G_DEFINE_TYPE (MMBroadbandBearerHso, mm_broadband_bearer_hso, MM_TYPE_BROADBAND_BEARER);
 
+typedef struct _OwandataPrefetch OwandataPrefetch;
+
 struct _MMBroadbandBearerHsoPrivate {
     guint auth_idx;
     gpointer connect_pending;
     guint connect_pending_id;
     gulong connect_cancellable_id;
     gulong connect_port_closed_id;
+    gint64 connect_started;
+
+    /* IP config requested as soon as connected */
+    OwandataPrefetch *owandata_prefetch;
 };
 
 /*****************************************************************************/
@@ -87,20 +93,18 @@ get_ip_config_3gpp_finish (MMBroadbandBearer *self,
 
 #define OWANDATA_TAG "_OWANDATA: "
 
+/* Takes ownership of 'error' */
 static void
-ip_config_ready (MMBaseModem *modem,
-                 GAsyncResult *res,
-                 GetIpConfig3gppContext *ctx)
+ip_config_process (GetIpConfig3gppContext *ctx,
+                   const gchar *response,
+                   GError *error)
 {
     MMBearerIpConfig *ip_config = NULL;
-    const gchar *response;
-    GError *error = NULL;
     gchar **items;
     gchar *dns[3] = { 0 };
     guint i;
     guint dns_i;
 
-    response = mm_base_modem_at_command_full_finish (modem, res, &error);
     if (error) {
         g_simple_async_result_take_error (ctx->result, error);
         get_ip_config_context_complete_and_free (ctx);
@@ -180,6 +184,120 @@ ip_config_ready (MMBaseModem *modem,
     g_strfreev (items);
 }
 
+static void
+ip_config_ready (MMBaseModem *modem,
+                 GAsyncResult *res,
+                 GetIpConfig3gppContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    ip_config_process (ctx, response, error);
+}
+
+/*
+ * _OWANDATA is requested right when _OWANCALL reports the connection, so that
+ * the IP config is usually ready by the time it is asked for, while the
+ * connection is being set up in the core and the net port brought up.
+ */
+struct _OwandataPrefetch {
+    MMBroadbandBearerHso *self;
+    gboolean done;
+    gchar *response;
+    GError *error;
+    /* IP config request waiting for the response */
+    GetIpConfig3gppContext *waiting;
+};
+
+static void
+owandata_prefetch_free (OwandataPrefetch *prefetch)
+{
+    g_free (prefetch->response);
+    g_clear_error (&prefetch->error);
+    g_slice_free (OwandataPrefetch, prefetch);
+}
+
+static void
+owandata_prefetch_ready (MMBaseModem *modem,
+                         GAsyncResult *res,
+                         OwandataPrefetch *prefetch)
+{
+    MMBroadbandBearerHso *self = prefetch->self;
+    const gchar *response;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &prefetch->error);
+    prefetch->response = g_strdup (response);
+    prefetch->done = TRUE;
+    prefetch->self = NULL;
+
+    if (self->priv->owandata_prefetch != prefetch) {
+        /* Flushed while running */
+        owandata_prefetch_free (prefetch);
+    } else if (prefetch->waiting) {
+        self->priv->owandata_prefetch = NULL;
+        ip_config_process (prefetch->waiting, prefetch->response, prefetch->error);
+        prefetch->error = NULL;
+        owandata_prefetch_free (prefetch);
+    }
+
+    g_object_unref (self);
+}
+
+/* Drops the prefetched IP config, failing any request waiting for it */
+static void
+owandata_prefetch_flush (MMBroadbandBearerHso *self)
+{
+    OwandataPrefetch *prefetch;
+
+    prefetch = self->priv->owandata_prefetch;
+    if (!prefetch)
+        return;
+    self->priv->owandata_prefetch = NULL;
+
+    if (prefetch->waiting) {
+        g_simple_async_result_set_error (prefetch->waiting->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Couldn't get IP config: connection lost");
+        get_ip_config_context_complete_and_free (prefetch->waiting);
+        prefetch->waiting = NULL;
+    }
+
+    /* If still running, freed once done */
+    if (prefetch->done)
+        owandata_prefetch_free (prefetch);
+}
+
+static void
+owandata_prefetch_start (MMBroadbandBearerHso *self,
+                         MMBaseModem *modem,
+                         MMPortSerialAt *primary,
+                         guint cid)
+{
+    OwandataPrefetch *prefetch;
+    gchar *command;
+
+    owandata_prefetch_flush (self);
+
+    prefetch = g_slice_new0 (OwandataPrefetch);
+    prefetch->self = g_object_ref (self);
+    self->priv->owandata_prefetch = prefetch;
+
+    command = g_strdup_printf ("AT_OWANDATA=%d", cid);
+    mm_base_modem_at_command_full (
+        modem,
+        primary,
+        command,
+        3,
+        FALSE,
+        FALSE, /* raw */
+        NULL, /* cancellable */
+        (GAsyncReadyCallback)owandata_prefetch_ready,
+        prefetch);
+    g_free (command);
+}
+
 static void
 get_ip_config_3gpp (MMBroadbandBearer *self,
                     MMBroadbandModem *modem,
@@ -204,6 +322,24 @@ get_ip_config_3gpp (MMBroadbandBearer *self,
                                              user_data,
                                              get_ip_config_3gpp);
 
+    /* Use the prefetched response if any, or wait for it */
+    if (ctx->self->priv->owandata_prefetch) {
+        OwandataPrefetch *prefetch;
+
+        prefetch = ctx->self->priv->owandata_prefetch;
+        if (!prefetch->done) {
+            g_assert (!prefetch->waiting);
+            prefetch->waiting = ctx;
+            return;
+        }
+
+        ctx->self->priv->owandata_prefetch = NULL;
+        ip_config_process (ctx, prefetch->response, prefetch->error);
+        prefetch->error = NULL;
+        owandata_prefetch_free (prefetch);
+        return;
+    }
+
     command = g_strdup_printf ("AT_OWANDATA=%d", cid);
     mm_base_modem_at_command_full (
         MM_BASE_MODEM (modem),
@@ -338,6 +474,10 @@ report_connection_status (MMBaseBearer *bearer,
         mm_dbg ("Received spontaneous _OWANCALL (%s)",
                 mm_bearer_connection_status_get_string (status));
 
+        /* Whatever was fetched for the connection is no longer valid */
+        if (status != MM_BEARER_CONNECTION_STATUS_CONNECTED)
+            owandata_prefetch_flush (self);
+
         if (status == MM_BEARER_CONNECTION_STATUS_DISCONNECTED) {
             /* If no connection attempt on-going, make sure we mark ourselves as
              * disconnected */
@@ -376,6 +516,10 @@ report_connection_status (MMBaseBearer *bearer,
             return;
         }
 
+        mm_broadband_modem_hso_report_connect_time (MM_BROADBAND_MODEM_HSO (ctx->modem),
+                                                    g_get_monotonic_time () - self->priv->connect_started);
+        owandata_prefetch_start (self, ctx->modem, ctx->primary, ctx->cid);
+
         g_simple_async_result_set_op_res_gpointer (ctx->result,
                                                    g_object_ref (ctx->data),
                                                    (GDestroyNotify)g_object_unref);
@@ -505,8 +649,9 @@ activate_ready (MMBaseModem *modem,
     }
 
     /* We will now setup a timeout so that we don't wait forever to get the
-     * connection on */
-    self->priv->connect_pending_id = g_timeout_add_seconds (30,
+     * connection on; as long as the previous connections took, with some
+     * margin */
+    self->priv->connect_pending_id = g_timeout_add_seconds (mm_broadband_modem_hso_get_connect_timeout (MM_BROADBAND_MODEM_HSO (ctx->modem)),
                                                             (GSourceFunc)connect_timed_out_cb,
                                                             self);
     self->priv->connect_cancellable_id = g_cancellable_connect (ctx->cancellable,
@@ -552,6 +697,7 @@ authenticate_ready (MMBaseModem *modem,
      * already completed in the unsolicited handling) */
     g_assert (ctx->self->priv->connect_pending == NULL);
     ctx->self->priv->connect_pending = ctx;
+    ctx->self->priv->connect_started = g_get_monotonic_time ();
 
     /* Success, activate the PDP context and start the data session */
     command = g_strdup_printf ("AT_OWANCALL=%d,1,1",
@@ -681,6 +827,8 @@ dial_3gpp (MMBroadbandBearer *self,
                                              dial_3gpp);
     ctx->cancellable = g_object_ref (cancellable);
 
+    owandata_prefetch_flush (MM_BROADBAND_BEARER_HSO (self));
+
     /* Always start with the index that worked last time
      * (will be 0 the first time)*/
     ctx->auth_idx = ctx->self->priv->auth_idx;
@@ -762,6 +910,8 @@ disconnect_3gpp (MMBroadbandBearer *self,
 
     g_assert (primary != NULL);
 
+    owandata_prefetch_flush (MM_BROADBAND_BEARER_HSO (self));
+
     ctx = g_new0 (DisconnectContext, 1);
     ctx->self = g_object_ref (self);
     ctx->modem = MM_BASE_MODEM (g_object_ref (modem));
@@ -834,6 +984,18 @@ mm_broadband_bearer_hso_init (MMBroadbandBearerHso *self)
                                               MMBroadbandBearerHsoPrivate);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMBroadbandBearerHso *self = MM_BROADBAND_BEARER_HSO (object);
+
+    /* A running prefetch keeps a reference, so this one is done */
+    if (self->priv->owandata_prefetch)
+        owandata_prefetch_free (self->priv->owandata_prefetch);
+
+    G_OBJECT_CLASS (mm_broadband_bearer_hso_parent_class)->finalize (object);
+}
+
 static void
 mm_broadband_bearer_hso_class_init (MMBroadbandBearerHsoClass *klass)
 {
@@ -843,6 +1005,7 @@ mm_broadband_bearer_hso_class_init (MMBroadbandBearerHsoClass *klass)
 
     g_type_class_add_private (object_class, sizeof (MMBroadbandBearerHsoPrivate));
 
+    object_class->finalize = finalize;
     base_bearer_class->report_connection_status = report_connection_status;
     broadband_bearer_class->dial_3gpp = dial_3gpp;
     broadband_bearer_class->dial_3gpp_finish = dial_3gpp_finish;
@@ -52,8 +52,47 @@ struct _MMBroadbandModemHsoPrivate {
     GRegex *_owancall_regex;
 
     MMModemLocationSource enabled_sources;
+
+    /* Learned connection latency, in microseconds */
+    gint64 connect_latency;
 };
 
+/*****************************************************************************/
+/* Connection latency */
+
+/* Limits of the connection attempt timeout */
+#define CONNECT_TIMEOUT_MIN_SECS 10
+#define CONNECT_TIMEOUT_MAX_SECS 30
+#define CONNECT_TIMEOUT_FACTOR   3
+
+void
+mm_broadband_modem_hso_report_connect_time (MMBroadbandModemHso *self,
+                                            gint64 elapsed)
+{
+    /* Follow slower connections right away, faster ones slowly */
+    if (elapsed > self->priv->connect_latency)
+        self->priv->connect_latency = elapsed;
+    else
+        self->priv->connect_latency = (3 * self->priv->connect_latency + elapsed) / 4;
+
+    mm_dbg ("Connected in %.1fs, learned connection latency %.1fs",
+            (gdouble) elapsed / G_USEC_PER_SEC,
+            (gdouble) self->priv->connect_latency / G_USEC_PER_SEC);
+}
+
+guint
+mm_broadband_modem_hso_get_connect_timeout (MMBroadbandModemHso *self)
+{
+    guint64 secs;
+
+    /* Nothing learned yet */
+    if (!self->priv->connect_latency)
+        return CONNECT_TIMEOUT_MAX_SECS;
+
+    secs = (CONNECT_TIMEOUT_FACTOR * self->priv->connect_latency + G_USEC_PER_SEC - 1) / G_USEC_PER_SEC;
+    return (guint) CLAMP (secs, CONNECT_TIMEOUT_MIN_SECS, CONNECT_TIMEOUT_MAX_SECS);
+}
+
 /*****************************************************************************/
 /* Create Bearer (Modem interface) */
 
@@ -48,4 +48,10 @@ MMBroadbandModemHso *mm_broadband_modem_hso_new (const gchar *device,
                                                  guint16 vendor_id,
                                                  guint16 product_id);
 
+/* Connection attempts are timed out based on the latency of the previous
+ * ones; elapsed times in microseconds, timeout in seconds */
+void  mm_broadband_modem_hso_report_connect_time (MMBroadbandModemHso *self,
+                                                  gint64 elapsed);
+guint mm_broadband_modem_hso_get_connect_timeout (MMBroadbandModemHso *self);
+
 #endif /* MM_BROADBAND_MODEM_HSO_H */
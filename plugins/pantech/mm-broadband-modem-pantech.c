@@ -114,15 +114,7 @@ modem_after_sim_unlock_finish (MMIfaceModem *self,
                                GAsyncResult *res,
                                GError **error)
 {
-    return TRUE;
-}
-
-static gboolean
-after_sim_unlock_wait_cb (GSimpleAsyncResult *result)
-{
-    g_simple_async_result_complete (result);
-    g_object_unref (result);
-    return G_SOURCE_REMOVE;
+    return mm_broadband_modem_wait_sim_ready_finish (MM_BROADBAND_MODEM (self), res, error);
 }
 
 static void
@@ -130,15 +122,12 @@ modem_after_sim_unlock (MMIfaceModem *self,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
 {
-    GSimpleAsyncResult *result;
-
-    result = g_simple_async_result_new (G_OBJECT (self),
-                                        callback,
-                                        user_data,
-                                        modem_after_sim_unlock);
-
-    /* wait so sim pin is done */
-    g_timeout_add_seconds (5, (GSourceFunc)after_sim_unlock_wait_cb, result);
+    /* wait (up to 5 seconds) so sim pin is done */
+    mm_broadband_modem_wait_sim_ready (MM_BROADBAND_MODEM (self),
+                                       MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPIN,
+                                       5000,
+                                       callback,
+                                       user_data);
 }
 
 /*****************************************************************************/
@@ -249,12 +249,89 @@ mm_common_sierra_modem_power_up_finish (MMIfaceModem *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+/* Power up readiness checks, backing off up to the max interval */
+#define POWER_UP_CHECK_INITIAL_MS 1000
+#define POWER_UP_CHECK_MAX_MS     2000
+
+typedef struct {
+    MMBaseModem *self;
+    GSimpleAsyncResult *result;
+    gint64 deadline;
+    guint interval_ms;
+} PowerUpContext;
+
+static void
+power_up_context_complete_and_free (PowerUpContext *ctx)
+{
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->self);
+    g_slice_free (PowerUpContext, ctx);
+}
+
+static gboolean sierra_power_up_check (PowerUpContext *ctx);
+
+static void
+sierra_power_up_schedule_check (PowerUpContext *ctx)
+{
+    gint64 remaining_ms;
+
+    remaining_ms = (ctx->deadline - g_get_monotonic_time ()) / 1000;
+    if (remaining_ms <= 0) {
+        mm_dbg ("Power up readiness not reported, assuming powered up");
+        power_up_context_complete_and_free (ctx);
+        return;
+    }
+
+    g_timeout_add (MIN (ctx->interval_ms, (guint) remaining_ms), (GSourceFunc)sierra_power_up_check, ctx);
+    ctx->interval_ms = MIN (ctx->interval_ms * 2, POWER_UP_CHECK_MAX_MS);
+}
+
+/* The operating mode in the !GSTATUS? report, as in:
+ *   Reset Counter: 1        Mode:        ONLINE
+ * is LOW POWER MODE or similar until the radio is fully up. */
+static gboolean
+gstatus_is_online (const gchar *response)
+{
+    GRegex *r;
+    gboolean online;
+
+    r = g_regex_new ("(?:^|\\s)Mode:\\s*ONLINE", G_REGEX_MULTILINE, 0, NULL);
+    g_assert (r != NULL);
+    online = g_regex_match (r, response, 0, NULL);
+    g_regex_unref (r);
+    return online;
+}
+
+static void
+sierra_power_up_check_ready (MMBaseModem *self,
+                             GAsyncResult *res,
+                             PowerUpContext *ctx)
+{
+    const gchar *response;
+
+    /* Errors just mean that it isn't ready yet, or that the firmware doesn't
+     * know the command, in which case the full wait is done */
+    response = mm_base_modem_at_command_finish (self, res, NULL);
+    if (response && gstatus_is_online (response)) {
+        mm_dbg ("Modem reported online mode, powered up");
+        power_up_context_complete_and_free (ctx);
+        return;
+    }
+
+    sierra_power_up_schedule_check (ctx);
+}
+
 static gboolean
-sierra_power_up_wait_cb (GSimpleAsyncResult *result)
+sierra_power_up_check (PowerUpContext *ctx)
 {
-    g_simple_async_result_set_op_res_gboolean (result, TRUE);
-    g_simple_async_result_complete (result);
-    g_object_unref (result);
+    mm_base_modem_at_command (ctx->self,
+                              "!GSTATUS?",
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback)sierra_power_up_check_ready,
+                              ctx);
     return G_SOURCE_REMOVE;
 }
 
@@ -267,6 +344,7 @@ cfun_enable_ready (MMBaseModem *self,
     guint i;
     const gchar **drivers;
     gboolean is_new_sierra = FALSE;
+    PowerUpContext *ctx;
 
     if (!mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error)) {
         g_simple_async_result_take_error (simple, error);
@@ -277,10 +355,13 @@ cfun_enable_ready (MMBaseModem *self,
 
     /* Many Sierra devices return OK immediately in response to CFUN=1 but
      * need some time to finish powering up, otherwise subsequent commands
-     * may return failure or even crash the modem.  Give more time for older
-     * devices like the AC860 and C885, which aren't driven by the 'sierra_net'
-     * driver.  Assume any DirectIP (ie, sierra_net) device is new enough
-     * to allow a lower timeout.
+     * may return failure or even crash the modem.  +CFUN? just reports the
+     * functionality level requested, so wait until !GSTATUS? reports the
+     * online mode instead, leaving a second before the first check, and
+     * never longer than what these devices are known to need.  Give more
+     * time for older devices like the AC860 and C885, which aren't driven by
+     * the 'sierra_net' driver.  Assume any DirectIP (ie, sierra_net) device
+     * is new enough to allow a lower timeout.
      */
     drivers = mm_base_modem_get_drivers (MM_BASE_MODEM (self));
     for (i = 0; drivers[i]; i++) {
@@ -290,9 +371,12 @@ cfun_enable_ready (MMBaseModem *self,
         }
     }
 
-    /* The modem object will be valid in the callback as 'result' keeps a
-     * reference to it. */
-    g_timeout_add_seconds (is_new_sierra ? 5 : 10, (GSourceFunc)sierra_power_up_wait_cb, simple);
+    ctx = g_slice_new0 (PowerUpContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = simple;
+    ctx->deadline = g_get_monotonic_time () + (is_new_sierra ? 5 : 10) * G_USEC_PER_SEC;
+    ctx->interval_ms = POWER_UP_CHECK_INITIAL_MS;
+    sierra_power_up_schedule_check (ctx);
 }
 
 static void
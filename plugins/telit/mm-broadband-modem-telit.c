@@ -42,6 +42,11 @@ G_DEFINE_TYPE_EXTENDED (MMBroadbandModemTelit, mm_broadband_modem_telit, MM_TYPE
                         G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM, iface_modem_init)
                         G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM_3GPP, iface_modem_3gpp_init));
 
+struct _MMBroadbandModemTelitPrivate {
+    /* Unlock retries last loaded, valid while the serial doesn't change */
+    MMUnlockRetries *unlock_retries;
+    guint unlock_retries_serial;
+};
 
 /*****************************************************************************/
 /* After Sim Unlock (Modem interface) */
@@ -109,6 +114,7 @@ telit_qss_unsolicited_handler (MMPortSerialAt *port,
             break;
     }
 
+    mm_iface_modem_invalidate_unlock_retries (MM_IFACE_MODEM (self));
     mm_broadband_modem_update_sim_hot_swap_detected (MM_BROADBAND_MODEM (self));
 }
 
@@ -459,7 +465,6 @@ modem_load_supported_bands (MMIfaceModem *self,
 #define CSIM_QUERY_TIMEOUT 3
 
 typedef enum {
-    LOAD_UNLOCK_RETRIES_STEP_FIRST,
     LOAD_UNLOCK_RETRIES_STEP_PIN,
     LOAD_UNLOCK_RETRIES_STEP_PUK,
     LOAD_UNLOCK_RETRIES_STEP_PIN2,
@@ -467,15 +472,26 @@ typedef enum {
     LOAD_UNLOCK_RETRIES_STEP_LAST
 } LoadUnlockRetriesStep;
 
+static const gchar *csim_queries[] = {
+    CSIM_QUERY_PIN_RETRIES_STR,
+    CSIM_QUERY_PUK_RETRIES_STR,
+    CSIM_QUERY_PIN2_RETRIES_STR,
+    CSIM_QUERY_PUK2_RETRIES_STR
+};
+
 typedef struct {
     MMBroadbandModemTelit *self;
     GSimpleAsyncResult *result;
     MMUnlockRetries *retries;
-    LoadUnlockRetriesStep step;
+    guint serial;
+    guint pending_requests;
     guint succeded_requests;
 } LoadUnlockRetriesContext;
 
-static void load_unlock_retries_step (LoadUnlockRetriesContext *ctx);
+typedef struct {
+    LoadUnlockRetriesContext *ctx;
+    LoadUnlockRetriesStep step;
+} CsimQueryContext;
 
 static void
 load_unlock_retries_context_complete_and_free (LoadUnlockRetriesContext *ctx)
@@ -499,32 +515,59 @@ modem_load_unlock_retries_finish (MMIfaceModem *self,
                                                 G_SIMPLE_ASYNC_RESULT (res)));
 }
 
+static void
+load_unlock_retries_complete (LoadUnlockRetriesContext *ctx)
+{
+    if (ctx->succeded_requests == 0) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Could not get any of the SIM unlock retries values");
+    } else {
+        /* Keep them until a PIN operation or SIM event happens */
+        g_clear_object (&ctx->self->priv->unlock_retries);
+        ctx->self->priv->unlock_retries = g_object_ref (ctx->retries);
+        ctx->self->priv->unlock_retries_serial = ctx->serial;
+
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_object_ref (ctx->retries),
+                                                   (GDestroyNotify)g_object_unref);
+    }
+
+    load_unlock_retries_context_complete_and_free (ctx);
+}
+
 static void
 csim_query_ready (MMBaseModem *self,
                   GAsyncResult *res,
-                  LoadUnlockRetriesContext *ctx)
+                  CsimQueryContext *query)
 {
+    LoadUnlockRetriesContext *ctx = query->ctx;
+    LoadUnlockRetriesStep step = query->step;
     const gchar *response;
     gint unlock_retries;
     GError *error = NULL;
 
+    g_slice_free (CsimQueryContext, query);
+    ctx->pending_requests--;
+
     response = mm_base_modem_at_command_finish (self, res, &error);
 
     if (!response) {
-        mm_warn ("No respose for step %d: %s", ctx->step, error->message);
+        mm_warn ("No respose for step %d: %s", step, error->message);
         g_error_free (error);
-        goto next_step;
+        goto out;
     }
 
-    if ( (unlock_retries = mm_telit_parse_csim_response (ctx->step, response, &error)) < 0) {
-        mm_warn ("Parse error in step %d: %s.", ctx->step, error->message);
+    if ( (unlock_retries = mm_telit_parse_csim_response (step, response, &error)) < 0) {
+        mm_warn ("Parse error in step %d: %s.", step, error->message);
         g_error_free (error);
-        goto next_step;
+        goto out;
     }
 
     ctx->succeded_requests++;
 
-    switch (ctx->step) {
+    switch (step) {
         case LOAD_UNLOCK_RETRIES_STEP_PIN:
             mm_dbg ("PIN unlock retries left: %d", unlock_retries);
             mm_unlock_retries_set (ctx->retries, MM_MODEM_LOCK_SIM_PIN, unlock_retries);
@@ -545,67 +588,9 @@ csim_query_ready (MMBaseModem *self,
             break;
     }
 
-next_step:
-    ctx->step++;
-    load_unlock_retries_step (ctx);
-}
-
-static void
-load_unlock_retries_step (LoadUnlockRetriesContext *ctx)
-{
-    switch (ctx->step) {
-        case LOAD_UNLOCK_RETRIES_STEP_FIRST:
-            /* Fall back on next step */
-            ctx->step++;
-        case LOAD_UNLOCK_RETRIES_STEP_PIN:
-            mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                      CSIM_QUERY_PIN_RETRIES_STR,
-                                      CSIM_QUERY_TIMEOUT,
-                                      FALSE,
-                                      (GAsyncReadyCallback) csim_query_ready,
-                                      ctx);
-            break;
-        case LOAD_UNLOCK_RETRIES_STEP_PUK:
-            mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                      CSIM_QUERY_PUK_RETRIES_STR,
-                                      CSIM_QUERY_TIMEOUT,
-                                      FALSE,
-                                      (GAsyncReadyCallback) csim_query_ready,
-                                      ctx);
-            break;
-        case LOAD_UNLOCK_RETRIES_STEP_PIN2:
-            mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                      CSIM_QUERY_PIN2_RETRIES_STR,
-                                      CSIM_QUERY_TIMEOUT,
-                                      FALSE,
-                                      (GAsyncReadyCallback) csim_query_ready,
-                                      ctx);
-            break;
-        case LOAD_UNLOCK_RETRIES_STEP_PUK2:
-            mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                      CSIM_QUERY_PUK2_RETRIES_STR,
-                                      CSIM_QUERY_TIMEOUT,
-                                      FALSE,
-                                      (GAsyncReadyCallback) csim_query_ready,
-                                      ctx);
-            break;
-        case LOAD_UNLOCK_RETRIES_STEP_LAST:
-            if (ctx->succeded_requests == 0) {
-                g_simple_async_result_set_error (ctx->result,
-                                                 MM_CORE_ERROR,
-                                                 MM_CORE_ERROR_FAILED,
-                                                 "Could not get any of the SIM unlock retries values");
-            } else {
-                g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                           g_object_ref (ctx->retries),
-                                                           (GDestroyNotify)g_object_unref);
-            }
-
-            load_unlock_retries_context_complete_and_free (ctx);
-            break;
-        default:
-            break;
-    }
+out:
+    if (ctx->pending_requests == 0)
+        load_unlock_retries_complete (ctx);
 }
 
 static void
@@ -613,7 +598,9 @@ modem_load_unlock_retries (MMIfaceModem *self,
                            GAsyncReadyCallback callback,
                            gpointer user_data)
 {
+    MMBroadbandModemTelit *telit = MM_BROADBAND_MODEM_TELIT (self);
     LoadUnlockRetriesContext *ctx;
+    LoadUnlockRetriesStep step;
 
     ctx = g_slice_new0 (LoadUnlockRetriesContext);
     ctx->self = g_object_ref (self);
@@ -621,12 +608,39 @@ modem_load_unlock_retries (MMIfaceModem *self,
                                              callback,
                                              user_data,
                                              modem_load_unlock_retries);
+    ctx->serial = mm_iface_modem_get_unlock_retries_serial (self);
+
+    /* Nothing changed since they were last loaded */
+    if (telit->priv->unlock_retries && telit->priv->unlock_retries_serial == ctx->serial) {
+        mm_dbg ("Reusing SIM unlock retries loaded earlier");
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_object_ref (telit->priv->unlock_retries),
+                                                   (GDestroyNotify)g_object_unref);
+        g_simple_async_result_complete_in_idle (ctx->result);
+        g_object_unref (ctx->result);
+        g_object_unref (ctx->self);
+        g_slice_free (LoadUnlockRetriesContext, ctx);
+        return;
+    }
 
     ctx->retries = mm_unlock_retries_new ();
-    ctx->step = LOAD_UNLOCK_RETRIES_STEP_FIRST;
-    ctx->succeded_requests = 0;
 
-    load_unlock_retries_step (ctx);
+    /* All the queries are queued right away, so that they go out back to back;
+     * they can't be concatenated, as all the replies are +CSIM ones */
+    for (step = LOAD_UNLOCK_RETRIES_STEP_PIN; step < LOAD_UNLOCK_RETRIES_STEP_LAST; step++) {
+        CsimQueryContext *query;
+
+        query = g_slice_new (CsimQueryContext);
+        query->ctx = ctx;
+        query->step = step;
+        ctx->pending_requests++;
+        mm_base_modem_at_command (MM_BASE_MODEM (self),
+                                  csim_queries[step],
+                                  CSIM_QUERY_TIMEOUT,
+                                  FALSE,
+                                  (GAsyncReadyCallback) csim_query_ready,
+                                  query);
+    }
 }
 
 /*****************************************************************************/
@@ -1190,12 +1204,28 @@ mm_broadband_modem_telit_new (const gchar *device,
                          MM_BASE_MODEM_VENDOR_ID, vendor_id,
                          MM_BASE_MODEM_PRODUCT_ID, product_id,
                          MM_IFACE_MODEM_SIM_HOT_SWAP_SUPPORTED, TRUE,
+                         /* Read commands may be sent concatenated */
+                         MM_BASE_MODEM_AT_CONCATENATION, TRUE,
                          NULL);
 }
 
 static void
 mm_broadband_modem_telit_init (MMBroadbandModemTelit *self)
 {
+    /* Initialize private data */
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
+                                              MM_TYPE_BROADBAND_MODEM_TELIT,
+                                              MMBroadbandModemTelitPrivate);
+}
+
+static void
+finalize (GObject *object)
+{
+    MMBroadbandModemTelit *self = MM_BROADBAND_MODEM_TELIT (object);
+
+    g_clear_object (&self->priv->unlock_retries);
+
+    G_OBJECT_CLASS (mm_broadband_modem_telit_parent_class)->finalize (object);
 }
 
 static void
@@ -1241,4 +1271,9 @@ iface_modem_3gpp_init (MMIfaceModem3gpp *iface)
 static void
 mm_broadband_modem_telit_class_init (MMBroadbandModemTelitClass *klass)
 {
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMBroadbandModemTelitPrivate));
+
+    object_class->finalize = finalize;
 }
@@ -24,6 +24,7 @@
 
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
 #include "mm-modem-helpers-telit.h"
 
 
@@ -124,7 +125,7 @@ mm_telit_parse_csim_response (const guint step,
     gchar *retries_hex_str;
     guint retries;
 
-    r = g_regex_new ("\\+CSIM:\\s*[0-9]+,\\s*.*63C(.*)\"", G_REGEX_RAW, 0, NULL);
+    r = mm_regex_registry_get ("\\+CSIM:\\s*[0-9]+,\\s*.*63C(.*)\"", G_REGEX_RAW);
 
     if (!g_regex_match (r, response, 0, &match_info)) {
         g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
@@ -236,16 +237,16 @@ mm_telit_parse_bnd_response (const gchar *response,
         case LOAD_SUPPORTED_BANDS:
             /* Parse #BND=? response */
             if (modem_is_4g)
-                r = g_regex_new (SUPP_BAND_4G_MODEM_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+                r = mm_regex_registry_get (SUPP_BAND_4G_MODEM_RESPONSE_REGEX, G_REGEX_RAW);
             else
-                r = g_regex_new (SUPP_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+                r = mm_regex_registry_get (SUPP_BAND_RESPONSE_REGEX, G_REGEX_RAW);
             break;
         case LOAD_CURRENT_BANDS:
             /* Parse #BND? response */
             if (modem_is_4g)
-                r = g_regex_new (CURR_BAND_4G_MODEM_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+                r = mm_regex_registry_get (CURR_BAND_4G_MODEM_RESPONSE_REGEX, G_REGEX_RAW);
             else
-                r = g_regex_new (CURR_BAND_RESPONSE_REGEX, G_REGEX_RAW, 0, NULL);
+                r = mm_regex_registry_get (CURR_BAND_RESPONSE_REGEX, G_REGEX_RAW);
             break;
         default:
             break;
@@ -161,3 +161,52 @@ test_fixture_no_modem (TestFixture *fixture)
 {
     common_get_modem (fixture, FALSE);
 }
+
+void
+test_fixture_enable_virtual_clock (TestFixture *fixture)
+{
+    GError *error = NULL;
+
+    g_assert (fixture->test != NULL);
+    if (!mm_gdbus_test_call_enable_virtual_clock_sync (fixture->test,
+                                                       NULL, /* cancellable */
+                                                       &error))
+        g_error ("Error enabling virtual clock: %s", error->message);
+}
+
+void
+test_fixture_advance_clock (TestFixture *fixture,
+                            guint64      milliseconds,
+                            guint        settle)
+{
+    GError   *error = NULL;
+    GVariant *result;
+
+    /* No timeout, it runs for as long as it takes to go over all the timers;
+     * may be called from any thread */
+    g_assert (fixture->test != NULL);
+    result = g_dbus_proxy_call_sync (G_DBUS_PROXY (fixture->test),
+                                     "AdvanceClock",
+                                     g_variant_new ("(tu)", milliseconds, settle),
+                                     G_DBUS_CALL_FLAGS_NONE,
+                                     G_MAXINT,
+                                     NULL, /* cancellable */
+                                     &error);
+    if (!result)
+        g_error ("Error advancing virtual clock: %s", error->message);
+    g_variant_unref (result);
+}
+
+guint
+test_fixture_get_env_uint (const gchar *name,
+                           guint        default_value)
+{
+    const gchar *str;
+    guint64      value;
+
+    str = g_getenv (name);
+    if (!str || !str[0])
+        return default_value;
+    value = g_ascii_strtoull (str, NULL, 10);
+    return (value > 0 && value <= G_MAXUINT) ? (guint) value : default_value;
+}
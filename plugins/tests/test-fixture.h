@@ -51,4 +51,16 @@ void      test_fixture_set_profile (TestFixture *fixture,
 MMObject *test_fixture_get_modem   (TestFixture *fixture);
 void      test_fixture_no_modem    (TestFixture *fixture);
 
+/* Timers started after enabling the virtual clock only fire when the clock
+ * is advanced */
+void test_fixture_enable_virtual_clock (TestFixture *fixture);
+void test_fixture_advance_clock        (TestFixture *fixture,
+                                        guint64      milliseconds,
+                                        guint        settle);
+
+/* Positive integer from the environment, for the perf mode settings of the
+ * benchmarks; default_value if unset or invalid */
+guint test_fixture_get_env_uint (const gchar *name,
+                                 guint        default_value);
+
 #endif /* TEST_FIXTURE_H */
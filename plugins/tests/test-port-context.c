@@ -21,6 +21,11 @@
 
 #define BUFFER_SIZE 1024
 
+/* Commands files may also list unsolicited messages, as:
+ *   @unsolicited <interval ms> <burst> <message>
+ */
+#define UNSOLICITED_KEYWORD "@unsolicited"
+
 struct _TestPortContext {
     gchar *name;
     GThread *thread;
@@ -33,8 +38,21 @@ struct _TestPortContext {
     GSocketService *socket_service;
     GList *clients;
     GHashTable *commands;
+    guint latency_min_ms;
+    guint latency_max_ms;
+    GList *unsolicited;
+    gchar *default_response;
+    gboolean silent;
+    gint n_commands;
 };
 
+typedef struct {
+    TestPortContext *ctx;
+    gchar *message;
+    guint interval_ms;
+    guint burst;
+} Unsolicited;
+
 /*****************************************************************************/
 
 void
@@ -71,7 +89,19 @@ test_port_context_load_commands (TestPortContext *self,
         }
 
         g_strstrip (current);
-        if (current[0] != '\0' && current[0] != '#') {
+        if (g_str_has_prefix (current, UNSOLICITED_KEYWORD)) {
+            guint interval_ms;
+            guint burst;
+            gchar *message;
+
+            interval_ms = (guint) g_ascii_strtoull (current + strlen (UNSOLICITED_KEYWORD), &message, 10);
+            burst = (guint) g_ascii_strtoull (message, &message, 10);
+            while (*message == ' ')
+                message++;
+            g_assert (interval_ms > 0 && *message != '\0');
+
+            test_port_context_add_unsolicited (self, message, interval_ms, burst);
+        } else if (current[0] != '\0' && current[0] != '#') {
             gchar *response;
 
             response = current;
@@ -92,6 +122,66 @@ test_port_context_load_commands (TestPortContext *self,
     g_free (contents);
 }
 
+void
+test_port_context_set_latency (TestPortContext *self,
+                               guint min_ms,
+                               guint max_ms)
+{
+    g_assert (self->thread == NULL);
+    g_assert (min_ms <= max_ms);
+    self->latency_min_ms = min_ms;
+    self->latency_max_ms = max_ms;
+}
+
+void
+test_port_context_add_unsolicited (TestPortContext *self,
+                                   const gchar *message,
+                                   guint interval_ms,
+                                   guint burst)
+{
+    Unsolicited *unsolicited;
+
+    g_assert (self->thread == NULL);
+    g_assert (interval_ms > 0);
+
+    unsolicited = g_slice_new0 (Unsolicited);
+    unsolicited->ctx = self;
+    unsolicited->message = g_strcompress (message);
+    unsolicited->interval_ms = interval_ms;
+    unsolicited->burst = burst > 0 ? burst : 1;
+    self->unsolicited = g_list_append (self->unsolicited, unsolicited);
+}
+
+void
+test_port_context_set_default_response (TestPortContext *self,
+                                        const gchar *response)
+{
+    g_assert (self->thread == NULL);
+    g_free (self->default_response);
+    self->default_response = g_strcompress (response);
+}
+
+void
+test_port_context_set_silent (TestPortContext *self,
+                              gboolean silent)
+{
+    g_assert (self->thread == NULL);
+    self->silent = silent;
+}
+
+guint
+test_port_context_get_n_commands (TestPortContext *self)
+{
+    return (guint) g_atomic_int_get (&self->n_commands);
+}
+
+static void
+unsolicited_free (Unsolicited *unsolicited)
+{
+    g_free (unsolicited->message);
+    g_slice_free (Unsolicited, unsolicited);
+}
+
 static const gchar *
 process_next_command (TestPortContext *ctx,
                       GByteArray *buffer)
@@ -111,15 +201,19 @@ process_next_command (TestPortContext *ctx,
     while (i < buffer->len && (buffer->data[i] == '\r' || buffer->data[i] == '\n'))
         buffer->data[i++] = '\0';
 
+    g_atomic_int_inc (&ctx->n_commands);
+
     /* Setup command and lookup response */
     command = g_strndup ((gchar *)buffer->data, i);
-    response = g_hash_table_lookup (ctx->commands, command);
+    response = (ctx->commands ? g_hash_table_lookup (ctx->commands, command) : NULL);
     g_free (command);
 
     /* Remove command from buffer */
     g_byte_array_remove_range (buffer, 0, i);
 
-    return response ? response : error_response;
+    if (response)
+        return response;
+    return ctx->default_response ? ctx->default_response : error_response;
 }
 
 /*****************************************************************************/
@@ -128,12 +222,18 @@ typedef struct {
     TestPortContext *ctx;
     GSocketConnection *connection;
     GSource *connection_readable_source;
+    GSource *response_source;
+    const gchar *pending_response;
     GByteArray *buffer;
 } Client;
 
 static void
 client_free (Client *client)
 {
+    if (client->response_source) {
+        g_source_destroy (client->response_source);
+        g_source_unref (client->response_source);
+    }
     g_source_destroy (client->connection_readable_source);
     g_source_unref (client->connection_readable_source);
     g_output_stream_close (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)), NULL, NULL);
@@ -150,28 +250,68 @@ connection_close (Client *client)
     client_free (client);
 }
 
+static void
+client_write (Client *client,
+              const gchar *data)
+{
+    GError *error = NULL;
+
+    if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
+                                    data,
+                                    strlen (data),
+                                    NULL, /* bytes_written */
+                                    NULL, /* cancellable */
+                                    &error)) {
+        g_warning ("Cannot send response to client: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+static void client_parse_request (Client *client);
+
+static gboolean
+delayed_response_cb (Client *client)
+{
+    client_write (client, client->pending_response);
+    client->pending_response = NULL;
+    g_source_unref (client->response_source);
+    client->response_source = NULL;
+
+    /* Go on with the commands received in the meantime */
+    client_parse_request (client);
+    return FALSE;
+}
+
 static void
 client_parse_request (Client *client)
 {
+    TestPortContext *ctx = client->ctx;
     const gchar *response;
 
-    do {
-        response = process_next_command (client->ctx, client->buffer);
-        if (response) {
-            GError *error = NULL;
-
-            if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (client->connection)),
-                                            response,
-                                            strlen (response),
-                                            NULL, /* bytes_written */
-                                            NULL, /* cancellable */
-                                            &error)) {
-                g_warning ("Cannot send response to client: %s", error->message);
-                g_error_free (error);
-            }
+    /* Commands are answered in order, so wait for the delayed one */
+    if (client->response_source)
+        return;
+
+    while ((response = process_next_command (ctx, client->buffer)) != NULL) {
+        /* Commands are read but never answered */
+        if (ctx->silent)
+            continue;
+
+        if (ctx->latency_max_ms == 0) {
+            client_write (client, response);
+            continue;
         }
 
-    } while (response);
+        client->pending_response = response;
+        client->response_source = g_timeout_source_new (g_random_int_range (ctx->latency_min_ms,
+                                                                            ctx->latency_max_ms + 1));
+        g_source_set_callback (client->response_source,
+                               (GSourceFunc)delayed_response_cb,
+                               client,
+                               NULL);
+        g_source_attach (client->response_source, ctx->context);
+        break;
+    }
 }
 
 static gboolean
@@ -314,6 +454,37 @@ create_socket_service (TestPortContext *self)
 
 /*****************************************************************************/
 
+static gboolean
+unsolicited_cb (Unsolicited *unsolicited)
+{
+    GList *l;
+
+    for (l = unsolicited->ctx->clients; l; l = g_list_next (l)) {
+        guint i;
+
+        for (i = 0; i < unsolicited->burst; i++)
+            client_write ((Client *)l->data, unsolicited->message);
+    }
+    return TRUE;
+}
+
+static void
+schedule_unsolicited (TestPortContext *self)
+{
+    GList *l;
+
+    for (l = self->unsolicited; l; l = g_list_next (l)) {
+        GSource *source;
+
+        source = g_timeout_source_new (((Unsolicited *)l->data)->interval_ms);
+        g_source_set_callback (source, (GSourceFunc)unsolicited_cb, l->data, NULL);
+        g_source_attach (source, self->context);
+        g_source_unref (source);
+    }
+}
+
+/*****************************************************************************/
+
 static gboolean
 cancel_loop_cb (TestPortContext *self)
 {
@@ -349,6 +520,7 @@ port_context_thread_func (TestPortContext *self)
 
     /* Once the thread default context is setup, launch service */
     create_socket_service (self);
+    schedule_unsolicited (self);
 
     g_main_loop_run (self->loop);
 
@@ -388,6 +560,8 @@ test_port_context_free (TestPortContext *self)
 
     if (self->commands)
         g_hash_table_unref (self->commands);
+    g_free (self->default_response);
+    g_list_free_full (self->unsolicited, (GDestroyNotify)unsolicited_free);
     g_list_free_full (self->clients, (GDestroyNotify)client_free);
     if (self->socket) {
         GError *error = NULL;
@@ -418,3 +592,20 @@ test_port_context_new (const gchar *name)
     g_mutex_init (&self->ready_mutex);
     return self;
 }
+
+TestPortContext *
+test_port_context_new_started (const gchar *name,
+                               const gchar *commands_file,
+                               guint latency_min_ms,
+                               guint latency_max_ms)
+{
+    TestPortContext *self;
+
+    self = test_port_context_new (name);
+    if (commands_file)
+        test_port_context_load_commands (self, commands_file);
+    if (latency_max_ms > 0)
+        test_port_context_set_latency (self, latency_min_ms, latency_max_ms);
+    test_port_context_start (self);
+    return self;
+}
@@ -29,7 +29,38 @@ void             test_port_context_free          (TestPortContext *self);
 void             test_port_context_set_command   (TestPortContext *self,
                                                   const gchar *command,
                                                   const gchar *response);
+/* Besides command/response pairs, the file may have unsolicited messages,
+ * given as '@unsolicited <interval ms> <burst> <message>' */
 void             test_port_context_load_commands (TestPortContext *self,
                                                   const gchar *commands_file);
 
+/* Both must be called before starting the context. Responses get delayed a
+ * random time in [min_ms,max_ms]; unsolicited messages are sent to all
+ * clients every interval_ms, burst times in a row. */
+void             test_port_context_set_latency     (TestPortContext *self,
+                                                    guint min_ms,
+                                                    guint max_ms);
+void             test_port_context_add_unsolicited (TestPortContext *self,
+                                                    const gchar *message,
+                                                    guint interval_ms,
+                                                    guint burst);
+
+/* Must be called before starting the context. The default response is sent
+ * to commands without a response set, instead of ERROR; silent contexts read
+ * the commands but never reply. */
+void             test_port_context_set_default_response (TestPortContext *self,
+                                                         const gchar *response);
+void             test_port_context_set_silent           (TestPortContext *self,
+                                                         gboolean silent);
+
+/* New context answering the commands in commands_file (if any) with the
+ * given latency, already started */
+TestPortContext *test_port_context_new_started (const gchar *name,
+                                                const gchar *commands_file,
+                                                guint latency_min_ms,
+                                                guint latency_max_ms);
+
+/* Number of commands received so far, may be called while running */
+guint            test_port_context_get_n_commands       (TestPortContext *self);
+
 #endif /* TEST_PORT_CONTEXT_H */
@@ -0,0 +1,342 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+/*
+ * Probing benchmark: devices made of fake ports go through the real plugin
+ * manager support check (pre-probing filters of every plugin, AT probing,
+ * plugin selection), and the time spent in each part is reported.
+ *
+ * Each fake port is of one of these kinds:
+ *   at:     answers the common GSM commands right away
+ *   slow:   same, with a few hundred ms of latency
+ *   binary: answers every command with binary garbage, as diagnostics ports
+ *   silent: never answers
+ *
+ * The breakdown comes from the profile of the daemon: total support check
+ * time per device, time of the pre-probing filters per plugin and filter,
+ * time per probing step, and time each plugin spent probing.
+ *
+ * By default one device with an AT port and a binary port is probed once, as
+ * a smoke test. With '-m perf' the ports of the device and the number of
+ * devices probed may be changed in the environment:
+ *   $ MM_TEST_PROBING_PORTS=at,slow,binary,silent MM_TEST_PROBING_ITERATIONS=20 ./test-probing -m perf
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include <libmm-glib.h>
+
+#include "test-port-context.h"
+#include "test-fixture.h"
+
+#define SMOKE_PORTS      "at,binary"
+#define SMOKE_ITERATIONS 1
+#define PERF_PORTS       "at,slow,binary,silent"
+#define PERF_ITERATIONS  10
+
+/* Silent ports take several AT probing timeouts */
+#define PROBE_TIMEOUT_MS 300000
+
+#define SLOW_MIN_MS 200
+#define SLOW_MAX_MS 400
+
+/* Binary bytes, no NULs as responses are strings */
+#define BINARY_RESPONSE                                                  \
+    "\\176\\001\\002\\003\\004\\005\\006\\007\\010\\016\\017\\020\\021"  \
+    "\\022\\023\\024\\025\\026\\027\\030\\031\\032\\034\\035\\036\\037"  \
+    "\\200\\201\\202\\203\\204\\205\\206\\207\\376\\377\\176"
+
+/*****************************************************************************/
+
+static TestPortContext *
+port_context_new (const gchar *name,
+                  const gchar *kind)
+{
+    TestPortContext *port;
+
+    if (g_str_equal (kind, "at"))
+        return test_port_context_new_started (name, COMMON_GSM_PORT_CONF, 0, 0);
+    if (g_str_equal (kind, "slow"))
+        return test_port_context_new_started (name, COMMON_GSM_PORT_CONF, SLOW_MIN_MS, SLOW_MAX_MS);
+
+    port = test_port_context_new (name);
+    if (g_str_equal (kind, "binary"))
+        test_port_context_set_default_response (port, BINARY_RESPONSE);
+    else if (g_str_equal (kind, "silent"))
+        test_port_context_set_silent (port, TRUE);
+    else
+        g_error ("Unknown port kind '%s'", kind);
+    test_port_context_start (port);
+    return port;
+}
+
+/*****************************************************************************/
+/* Aggregation of the profile spans */
+
+typedef struct {
+    guint   count;
+    guint64 total;
+    guint64 max;
+} SpanStats;
+
+static void
+span_stats_add (GHashTable  *table,
+                const gchar *key,
+                guint64      duration)
+{
+    SpanStats *stats;
+
+    stats = g_hash_table_lookup (table, key);
+    if (!stats) {
+        stats = g_new0 (SpanStats, 1);
+        g_hash_table_insert (table, g_strdup (key), stats);
+    }
+    stats->count++;
+    stats->total += duration;
+    stats->max = MAX (stats->max, duration);
+}
+
+static GVariant *
+get_profile (TestFixture *fixture)
+{
+    GError   *error = NULL;
+    GVariant *result;
+    GVariant *profile;
+
+    result = g_dbus_connection_call_sync (fixture->connection,
+                                          "org.freedesktop.ModemManager1",
+                                          "/org/freedesktop/ModemManager1",
+                                          "org.freedesktop.ModemManager1",
+                                          "GetProfile",
+                                          NULL,
+                                          G_VARIANT_TYPE ("(a{sv})"),
+                                          G_DBUS_CALL_FLAGS_NONE,
+                                          -1,
+                                          NULL,
+                                          &error);
+    if (!result)
+        g_error ("Couldn't get profile: %s", error->message);
+    g_variant_get (result, "(@a{sv})", &profile);
+    g_variant_unref (result);
+    return profile;
+}
+
+/* Category -> (name -> SpanStats); only finished spans are accounted */
+static GHashTable *
+aggregate_profile (GVariant *profile)
+{
+    GHashTable   *categories;
+    GVariant     *spans;
+    GVariantIter  iter;
+    GVariant     *span;
+
+    categories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+
+    spans = g_variant_lookup_value (profile, "spans", G_VARIANT_TYPE ("aa{sv}"));
+    g_assert (spans != NULL);
+    g_variant_iter_init (&iter, spans);
+    while ((span = g_variant_iter_next_value (&iter)) != NULL) {
+        const gchar *category;
+        const gchar *name;
+        guint64      duration;
+        GHashTable  *table;
+
+        if (g_variant_lookup (span, "category", "&s", &category) &&
+            g_variant_lookup (span, "name", "&s", &name) &&
+            g_variant_lookup (span, "duration", "t", &duration)) {
+            table = g_hash_table_lookup (categories, category);
+            if (!table) {
+                table = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+                g_hash_table_insert (categories, g_strdup (category), table);
+            }
+            span_stats_add (table, name, duration);
+        }
+        g_variant_unref (span);
+    }
+    g_variant_unref (spans);
+    return categories;
+}
+
+static gint
+compare_total (gconstpointer a,
+               gconstpointer b,
+               gpointer      table)
+{
+    SpanStats *sa = g_hash_table_lookup (table, *(const gchar **) a);
+    SpanStats *sb = g_hash_table_lookup (table, *(const gchar **) b);
+
+    return (sa->total < sb->total) - (sa->total > sb->total);
+}
+
+/* Largest totals first */
+static void
+report_category (GHashTable  *categories,
+                 const gchar *category)
+{
+    GHashTable *table;
+    GPtrArray  *names;
+    GList      *keys;
+    GList      *l;
+    guint       i;
+
+    table = g_hash_table_lookup (categories, category);
+    if (!table) {
+        g_test_message ("%s: no spans", category);
+        return;
+    }
+
+    keys = g_hash_table_get_keys (table);
+    names = g_ptr_array_new ();
+    for (l = keys; l; l = g_list_next (l))
+        g_ptr_array_add (names, l->data);
+    g_list_free (keys);
+    g_ptr_array_sort_with_data (names, compare_total, table);
+
+    g_test_message ("%s:", category);
+    for (i = 0; i < names->len; i++) {
+        const gchar *name = g_ptr_array_index (names, i);
+        SpanStats   *stats = g_hash_table_lookup (table, name);
+
+        g_test_message ("  %-40s %4u x, total %9.3f ms, mean %8.3f ms, max %8.3f ms",
+                        name, stats->count,
+                        (gdouble) stats->total / 1000.0,
+                        (gdouble) stats->total / stats->count / 1000.0,
+                        (gdouble) stats->max / 1000.0);
+    }
+    g_ptr_array_unref (names);
+}
+
+/*****************************************************************************/
+
+static void
+test_probing (TestFixture *fixture)
+{
+    const gchar *ports_str;
+    gchar      **kinds;
+    guint        n_kinds;
+    guint        n_iterations;
+    GVariant    *profile;
+    GHashTable  *categories;
+    gint64       total = 0;
+    gint64       max = 0;
+    guint        n_supported = 0;
+    gboolean     has_at = FALSE;
+    guint        i;
+
+    if (g_test_perf ()) {
+        ports_str = g_getenv ("MM_TEST_PROBING_PORTS");
+        if (!ports_str || !ports_str[0])
+            ports_str = PERF_PORTS;
+        n_iterations = test_fixture_get_env_uint ("MM_TEST_PROBING_ITERATIONS", PERF_ITERATIONS);
+    } else {
+        ports_str = SMOKE_PORTS;
+        n_iterations = SMOKE_ITERATIONS;
+    }
+    kinds = g_strsplit (ports_str, ",", -1);
+    n_kinds = g_strv_length (kinds);
+    g_assert_cmpuint (n_kinds, >, 0);
+    for (i = 0; i < n_kinds; i++) {
+        if (g_str_equal (kinds[i], "at") || g_str_equal (kinds[i], "slow"))
+            has_at = TRUE;
+    }
+
+    /* The daemon keeps running across iterations, so whatever it learns about
+     * ports is reused in the later ones, as when a device is replugged */
+    for (i = 0; i < n_iterations; i++) {
+        GError           *error = NULL;
+        TestPortContext **ports;
+        gchar           **port_names;
+        gchar            *id;
+        gchar            *plugin = NULL;
+        GVariant         *result;
+        gint64            start;
+        gint64            elapsed;
+        guint             j;
+
+        ports = g_new0 (TestPortContext *, n_kinds);
+        port_names = g_new0 (gchar *, n_kinds + 1);
+        for (j = 0; j < n_kinds; j++) {
+            port_names[j] = g_strdup_printf ("abstract:probing-%u-%u-%s", i, j, kinds[j]);
+            ports[j] = port_context_new (port_names[j], kinds[j]);
+        }
+
+        id = g_strdup_printf ("probing-%u", i);
+        start = g_get_monotonic_time ();
+        result = g_dbus_proxy_call_sync (G_DBUS_PROXY (fixture->test),
+                                         "ProbeDevice",
+                                         g_variant_new ("(s^as)", id, port_names),
+                                         G_DBUS_CALL_FLAGS_NONE,
+                                         PROBE_TIMEOUT_MS,
+                                         NULL,
+                                         &error);
+        elapsed = g_get_monotonic_time () - start;
+        if (result) {
+            g_variant_get (result, "(s)", &plugin);
+            g_variant_unref (result);
+            n_supported++;
+        } else {
+            /* Devices without AT ports are expected to be unsupported */
+            g_test_message ("Device '%s' unsupported: %s", id, error->message);
+            g_error_free (error);
+        }
+        g_test_message ("Device '%s' probed in %.1f ms: %s",
+                        id, (gdouble) elapsed / 1000.0, plugin ? plugin : "unsupported");
+
+        total += elapsed;
+        max = MAX (max, elapsed);
+
+        g_free (plugin);
+        g_free (id);
+        for (j = 0; j < n_kinds; j++)
+            test_port_context_free (ports[j]);
+        g_free (ports);
+        g_strfreev (port_names);
+    }
+
+    profile = get_profile (fixture);
+    categories = aggregate_profile (profile);
+    report_category (categories, "Support check");
+    report_category (categories, "Plugin filters");
+    report_category (categories, "Port probing");
+    report_category (categories, "Probing");
+    g_hash_table_unref (categories);
+    g_variant_unref (profile);
+
+    g_test_minimized_result ((gdouble) total / n_iterations / 1000.0,
+                             "%u devices (%u supported) with ports '%s' probed: mean %.1f ms, max %.1f ms",
+                             n_iterations, n_supported, ports_str,
+                             (gdouble) total / n_iterations / 1000.0,
+                             (gdouble) max / 1000.0);
+
+    /* Any port answering AT makes the device supported */
+    if (has_at)
+        g_assert_cmpuint (n_supported, ==, n_iterations);
+
+    g_strfreev (kinds);
+}
+
+/*****************************************************************************/
+
+int main (int   argc,
+          char *argv[])
+{
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    TEST_ADD ("/MM/Probing/support-check", test_probing);
+
+    return g_test_run ();
+}
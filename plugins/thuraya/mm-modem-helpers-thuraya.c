@@ -24,6 +24,7 @@
 
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
 #include "mm-modem-helpers-thuraya.h"
 
 /*************************************************************************/
@@ -88,7 +89,7 @@ mm_thuraya_3gpp_parse_cpms_test_response (const gchar *reply,
         return FALSE;
     }
 
-    r = g_regex_new ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\s*\"([^,\\)]+)\"\\s*", 0);
     g_assert (r);
 
     for (i = 0; i < N_EXPECTED_GROUPS; i++) {
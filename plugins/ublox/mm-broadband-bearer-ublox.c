@@ -0,0 +1,466 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-base-modem-at.h"
+#include "mm-broadband-bearer-ublox.h"
+#include "mm-log.h"
+#include "mm-modem-helpers.h"
+#include "mm-modem-helpers-ublox.h"
+
+G_DEFINE_TYPE (MMBroadbandBearerUblox, mm_broadband_bearer_ublox, MM_TYPE_BROADBAND_BEARER)
+
+enum {
+    PROP_0,
+    PROP_NETWORKING_MODE,
+    PROP_LAST
+};
+
+struct _MMBroadbandBearerUbloxPrivate {
+    MMUbloxNetworkingMode mode;
+};
+
+/*****************************************************************************/
+/* 3GPP IP config retrieval (sub-step of the 3GPP Connection sequence) */
+
+typedef struct {
+    MMBroadbandBearerUblox *self;
+    MMBaseModem *modem;
+    MMPortSerialAt *primary;
+    GSimpleAsyncResult *result;
+} GetIpConfig3gppContext;
+
+static void
+get_ip_config_3gpp_context_complete_and_free (GetIpConfig3gppContext *ctx)
+{
+    g_simple_async_result_complete_in_idle (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->primary);
+    g_object_unref (ctx->modem);
+    g_object_unref (ctx->self);
+    g_slice_free (GetIpConfig3gppContext, ctx);
+}
+
+static gboolean
+get_ip_config_3gpp_finish (MMBroadbandBearer *self,
+                           GAsyncResult *res,
+                           MMBearerIpConfig **ipv4_config,
+                           MMBearerIpConfig **ipv6_config,
+                           GError **error)
+{
+    MMBearerIpConfig *config;
+
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return FALSE;
+
+    /* Only IPv4 supported */
+    config = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+    *ipv4_config = g_object_ref (config);
+    *ipv6_config = NULL;
+    return TRUE;
+}
+
+static void
+cgcontrdp_ready (MMBaseModem *modem,
+                 GAsyncResult *res,
+                 GetIpConfig3gppContext *ctx)
+{
+    MMBearerIpConfig *config;
+    const gchar *response;
+    GError *error = NULL;
+    gchar *address = NULL;
+    guint prefix = 0;
+    gchar *gateway = NULL;
+    gchar *dns[3] = { NULL, NULL, NULL };
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    if (!response ||
+        !mm_ublox_parse_cgcontrdp_response (response,
+                                            NULL,
+                                            &address,
+                                            &prefix,
+                                            &gateway,
+                                            &dns[0],
+                                            &dns[1],
+                                            &error)) {
+        g_simple_async_result_take_error (ctx->result, error);
+        get_ip_config_3gpp_context_complete_and_free (ctx);
+        return;
+    }
+
+    mm_dbg ("IPv4 settings retrieved: %s/%u", address, prefix);
+
+    config = mm_bearer_ip_config_new ();
+    mm_bearer_ip_config_set_method (config, MM_BEARER_IP_METHOD_STATIC);
+    mm_bearer_ip_config_set_address (config, address);
+    mm_bearer_ip_config_set_prefix (config, prefix);
+    if (gateway)
+        mm_bearer_ip_config_set_gateway (config, gateway);
+    /* If the first DNS server is missing, skip the empty slot */
+    if (!dns[0]) {
+        dns[0] = dns[1];
+        dns[1] = NULL;
+    }
+    if (dns[0])
+        mm_bearer_ip_config_set_dns (config, (const gchar **) dns);
+
+    g_simple_async_result_set_op_res_gpointer (ctx->result, config, (GDestroyNotify)g_object_unref);
+    get_ip_config_3gpp_context_complete_and_free (ctx);
+
+    g_free (address);
+    g_free (gateway);
+    g_free (dns[0]);
+    g_free (dns[1]);
+}
+
+static void
+get_ip_config_3gpp (MMBroadbandBearer *self,
+                    MMBroadbandModem *modem,
+                    MMPortSerialAt *primary,
+                    MMPortSerialAt *secondary,
+                    MMPort *data,
+                    guint cid,
+                    MMBearerIpFamily ip_family,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data)
+{
+    GetIpConfig3gppContext *ctx;
+    gchar *command;
+
+    ctx = g_slice_new0 (GetIpConfig3gppContext);
+    ctx->self = g_object_ref (self);
+    ctx->modem = MM_BASE_MODEM (g_object_ref (modem));
+    ctx->primary = g_object_ref (primary);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             get_ip_config_3gpp);
+
+    /* In router mode the module runs a DHCP server in the network interface,
+     * so there is nothing else to ask */
+    if (ctx->self->priv->mode == MM_UBLOX_NETWORKING_MODE_ROUTER) {
+        MMBearerIpConfig *config;
+
+        config = mm_bearer_ip_config_new ();
+        mm_bearer_ip_config_set_method (config, MM_BEARER_IP_METHOD_DHCP);
+        g_simple_async_result_set_op_res_gpointer (ctx->result, config, (GDestroyNotify)g_object_unref);
+        get_ip_config_3gpp_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* In bridge mode, the network interface gets the settings of the PDP
+     * context */
+    command = g_strdup_printf ("+CGCONTRDP=%u", cid);
+    mm_base_modem_at_command_full (ctx->modem,
+                                   ctx->primary,
+                                   command,
+                                   10,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback)cgcontrdp_ready,
+                                   ctx);
+    g_free (command);
+}
+
+/*****************************************************************************/
+/* 3GPP Dialing (sub-step of the 3GPP Connection sequence) */
+
+typedef struct {
+    MMBroadbandBearerUblox *self;
+    MMBaseModem *modem;
+    MMPort *data;
+    GSimpleAsyncResult *result;
+} Dial3gppContext;
+
+static void
+dial_3gpp_context_complete_and_free (Dial3gppContext *ctx)
+{
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->data);
+    g_object_unref (ctx->modem);
+    g_object_unref (ctx->self);
+    g_slice_free (Dial3gppContext, ctx);
+}
+
+static MMPort *
+dial_3gpp_finish (MMBroadbandBearer *self,
+                  GAsyncResult *res,
+                  GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return MM_PORT (g_object_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res))));
+}
+
+static void
+cgact_activate_ready (MMBaseModem *modem,
+                      GAsyncResult *res,
+                      Dial3gppContext *ctx)
+{
+    GError *error = NULL;
+
+    /* DO NOT check for cancellable here. If we got here without errors, the
+     * bearer is really connected and therefore we need to reflect that in
+     * the state machine. */
+    if (!mm_base_modem_at_command_full_finish (modem, res, &error))
+        g_simple_async_result_take_error (ctx->result, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_object_ref (ctx->data),
+                                                   (GDestroyNotify)g_object_unref);
+    dial_3gpp_context_complete_and_free (ctx);
+}
+
+static void
+dial_3gpp (MMBroadbandBearer *self,
+           MMBaseModem *modem,
+           MMPortSerialAt *primary,
+           guint cid,
+           GCancellable *cancellable,
+           GAsyncReadyCallback callback,
+           gpointer user_data)
+{
+    Dial3gppContext *ctx;
+    MMPort *data;
+    gchar *command;
+
+    /* The network interface is grabbed along with the TTYs when the modem is
+     * created out of the port probes */
+    data = mm_base_modem_peek_best_data_port (modem, MM_PORT_TYPE_NET);
+    if (!data) {
+        g_simple_async_report_error_in_idle (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_NOT_FOUND,
+                                             "No valid data port found to launch connection");
+        return;
+    }
+
+    ctx = g_slice_new0 (Dial3gppContext);
+    ctx->self = g_object_ref (self);
+    ctx->modem = g_object_ref (modem);
+    ctx->data = g_object_ref (data);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             dial_3gpp);
+
+    /* Activating the PDP context is enough, the module routes or bridges the
+     * traffic through the network interface by itself */
+    command = g_strdup_printf ("+CGACT=1,%u", cid);
+    mm_base_modem_at_command_full (ctx->modem,
+                                   primary,
+                                   command,
+                                   60,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback)cgact_activate_ready,
+                                   ctx);
+    g_free (command);
+}
+
+/*****************************************************************************/
+/* 3GPP disconnection */
+
+static gboolean
+disconnect_3gpp_finish (MMBroadbandBearer *self,
+                        GAsyncResult *res,
+                        GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+cgact_deactivate_ready (MMBaseModem *modem,
+                        GAsyncResult *res,
+                        GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_at_command_full_finish (modem, res, &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+disconnect_3gpp (MMBroadbandBearer *self,
+                 MMBroadbandModem *modem,
+                 MMPortSerialAt *primary,
+                 MMPortSerialAt *secondary,
+                 MMPort *data,
+                 guint cid,
+                 GAsyncReadyCallback callback,
+                 gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+    gchar *command;
+
+    g_assert (primary != NULL);
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        disconnect_3gpp);
+
+    /* If no specific CID was used, disable all PDP contexts */
+    command = (cid > 0 ?
+               g_strdup_printf ("+CGACT=0,%u", cid) :
+               g_strdup ("+CGACT=0"));
+    mm_base_modem_at_command_full (MM_BASE_MODEM (modem),
+                                   primary,
+                                   command,
+                                   60,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback)cgact_deactivate_ready,
+                                   result);
+    g_free (command);
+}
+
+/*****************************************************************************/
+
+MMBaseBearer *
+mm_broadband_bearer_ublox_new_finish (GAsyncResult *res,
+                                      GError **error)
+{
+    GObject *bearer;
+    GObject *source;
+
+    source = g_async_result_get_source_object (res);
+    bearer = g_async_initable_new_finish (G_ASYNC_INITABLE (source), res, error);
+    g_object_unref (source);
+
+    if (!bearer)
+        return NULL;
+
+    /* Only export valid bearers */
+    mm_base_bearer_export (MM_BASE_BEARER (bearer));
+
+    return MM_BASE_BEARER (bearer);
+}
+
+void
+mm_broadband_bearer_ublox_new (MMBroadbandModem *modem,
+                               MMUbloxNetworkingMode mode,
+                               MMBearerProperties *config,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    g_assert (mode == MM_UBLOX_NETWORKING_MODE_ROUTER ||
+              mode == MM_UBLOX_NETWORKING_MODE_BRIDGE);
+
+    g_async_initable_new_async (
+        MM_TYPE_BROADBAND_BEARER_UBLOX,
+        G_PRIORITY_DEFAULT,
+        cancellable,
+        callback,
+        user_data,
+        MM_BASE_BEARER_MODEM, modem,
+        MM_BASE_BEARER_CONFIG, config,
+        MM_BROADBAND_BEARER_UBLOX_NETWORKING_MODE, (guint) mode,
+        NULL);
+}
+
+static void
+set_property (GObject *object,
+              guint prop_id,
+              const GValue *value,
+              GParamSpec *pspec)
+{
+    MMBroadbandBearerUblox *self = MM_BROADBAND_BEARER_UBLOX (object);
+
+    switch (prop_id) {
+    case PROP_NETWORKING_MODE:
+        self->priv->mode = (MMUbloxNetworkingMode) g_value_get_uint (value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+get_property (GObject *object,
+              guint prop_id,
+              GValue *value,
+              GParamSpec *pspec)
+{
+    MMBroadbandBearerUblox *self = MM_BROADBAND_BEARER_UBLOX (object);
+
+    switch (prop_id) {
+    case PROP_NETWORKING_MODE:
+        g_value_set_uint (value, (guint) self->priv->mode);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+mm_broadband_bearer_ublox_init (MMBroadbandBearerUblox *self)
+{
+    /* Initialize private data */
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self),
+                                              MM_TYPE_BROADBAND_BEARER_UBLOX,
+                                              MMBroadbandBearerUbloxPrivate);
+    self->priv->mode = MM_UBLOX_NETWORKING_MODE_UNKNOWN;
+}
+
+static void
+mm_broadband_bearer_ublox_class_init (MMBroadbandBearerUbloxClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+    MMBroadbandBearerClass *broadband_bearer_class = MM_BROADBAND_BEARER_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMBroadbandBearerUbloxPrivate));
+
+    object_class->set_property = set_property;
+    object_class->get_property = get_property;
+    broadband_bearer_class->dial_3gpp = dial_3gpp;
+    broadband_bearer_class->dial_3gpp_finish = dial_3gpp_finish;
+    broadband_bearer_class->get_ip_config_3gpp = get_ip_config_3gpp;
+    broadband_bearer_class->get_ip_config_3gpp_finish = get_ip_config_3gpp_finish;
+    broadband_bearer_class->disconnect_3gpp = disconnect_3gpp;
+    broadband_bearer_class->disconnect_3gpp_finish = disconnect_3gpp_finish;
+
+    g_object_class_install_property (object_class, PROP_NETWORKING_MODE,
+        g_param_spec_uint (MM_BROADBAND_BEARER_UBLOX_NETWORKING_MODE,
+                           "Networking mode",
+                           "Networking mode of the module, as reported by +UBMCONF",
+                           MM_UBLOX_NETWORKING_MODE_UNKNOWN,
+                           MM_UBLOX_NETWORKING_MODE_BRIDGE,
+                           MM_UBLOX_NETWORKING_MODE_UNKNOWN,
+                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+}
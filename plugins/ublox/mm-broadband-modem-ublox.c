@@ -0,0 +1,717 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ModemManager.h"
+#include "mm-log.h"
+#include "mm-errors-types.h"
+#include "mm-iface-modem.h"
+#include "mm-iface-modem-3gpp.h"
+#include "mm-iface-modem-location.h"
+#include "mm-iface-modem-signal.h"
+#include "mm-base-modem-at.h"
+#include "mm-broadband-bearer.h"
+#include "mm-broadband-modem-ublox.h"
+#include "mm-broadband-bearer-ublox.h"
+#include "mm-modem-helpers-ublox.h"
+
+static void iface_modem_init (MMIfaceModem *iface);
+static void iface_modem_3gpp_init (MMIfaceModem3gpp *iface);
+static void iface_modem_signal_init (MMIfaceModemSignal *iface);
+
+static MMIfaceModem3gpp *iface_modem_3gpp_parent;
+
+G_DEFINE_TYPE_EXTENDED (MMBroadbandModemUblox, mm_broadband_modem_ublox, MM_TYPE_BROADBAND_MODEM, 0,
+                        G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM, iface_modem_init)
+                        G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM_3GPP, iface_modem_3gpp_init)
+                        G_IMPLEMENT_INTERFACE (MM_TYPE_IFACE_MODEM_SIGNAL, iface_modem_signal_init))
+
+struct _MMBroadbandModemUbloxPrivate {
+    /* Networking mode of the module, loaded once */
+    MMUbloxNetworkingMode mode;
+
+    /* Unsolicited messaging setup */
+    GRegex *ureg_regex;
+    GRegex *ucged_regex;
+
+    /* Last LTE signal info reported in +UCGED */
+    MMSignal *lte_signal;
+};
+
+/*****************************************************************************/
+/* Create bearer (Modem interface) */
+
+static MMBaseBearer *
+modem_create_bearer_finish (MMIfaceModem *self,
+                            GAsyncResult *res,
+                            GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return MM_BASE_BEARER (g_object_ref (
+                               g_simple_async_result_get_op_res_gpointer (
+                                   G_SIMPLE_ASYNC_RESULT (res))));
+}
+
+static void
+broadband_bearer_new_ready (GObject *source,
+                            GAsyncResult *res,
+                            GSimpleAsyncResult *simple)
+{
+    MMBaseBearer *bearer = NULL;
+    GError *error = NULL;
+
+    bearer = mm_broadband_bearer_new_finish (res, &error);
+    if (!bearer)
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   bearer,
+                                                   (GDestroyNotify)g_object_unref);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+broadband_bearer_ublox_new_ready (GObject *source,
+                                  GAsyncResult *res,
+                                  GSimpleAsyncResult *simple)
+{
+    MMBaseBearer *bearer = NULL;
+    GError *error = NULL;
+
+    bearer = mm_broadband_bearer_ublox_new_finish (res, &error);
+    if (!bearer)
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   bearer,
+                                                   (GDestroyNotify)g_object_unref);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+typedef struct {
+    MMBroadbandModemUblox *self;
+    MMBearerProperties *properties;
+    GSimpleAsyncResult *result;
+} CreateBearerContext;
+
+static void
+create_bearer_context_free (CreateBearerContext *ctx)
+{
+    g_object_unref (ctx->properties);
+    g_object_unref (ctx->self);
+    g_slice_free (CreateBearerContext, ctx);
+}
+
+static void
+create_bearer_with_mode (CreateBearerContext *ctx)
+{
+    if (ctx->self->priv->mode == MM_UBLOX_NETWORKING_MODE_UNKNOWN) {
+        /* Without a known networking mode the network interface cannot be
+         * used, so fallback to PPP */
+        mm_dbg ("u-blox: creating generic broadband bearer");
+        mm_broadband_bearer_new (MM_BROADBAND_MODEM (ctx->self),
+                                 ctx->properties,
+                                 NULL, /* cancellable */
+                                 (GAsyncReadyCallback)broadband_bearer_new_ready,
+                                 ctx->result);
+    } else {
+        mm_dbg ("u-blox: creating bearer in %s mode",
+                ctx->self->priv->mode == MM_UBLOX_NETWORKING_MODE_ROUTER ? "router" : "bridge");
+        mm_broadband_bearer_ublox_new (MM_BROADBAND_MODEM (ctx->self),
+                                       ctx->self->priv->mode,
+                                       ctx->properties,
+                                       NULL, /* cancellable */
+                                       (GAsyncReadyCallback)broadband_bearer_ublox_new_ready,
+                                       ctx->result);
+    }
+    create_bearer_context_free (ctx);
+}
+
+static void
+ubmconf_ready (MMBaseModem *self,
+               GAsyncResult *res,
+               CreateBearerContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+
+    response = mm_base_modem_at_command_finish (self, res, &error);
+    if (!response ||
+        !mm_ublox_parse_ubmconf_response (response, &ctx->self->priv->mode, &error)) {
+        mm_dbg ("u-blox: couldn't load networking mode: %s", error->message);
+        g_error_free (error);
+        ctx->self->priv->mode = MM_UBLOX_NETWORKING_MODE_UNKNOWN;
+    }
+
+    create_bearer_with_mode (ctx);
+}
+
+static void
+modem_create_bearer (MMIfaceModem *self,
+                     MMBearerProperties *properties,
+                     GAsyncReadyCallback callback,
+                     gpointer user_data)
+{
+    CreateBearerContext *ctx;
+
+    ctx = g_slice_new0 (CreateBearerContext);
+    ctx->self = g_object_ref (self);
+    ctx->properties = g_object_ref (properties);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             modem_create_bearer);
+
+    /* Without a NET port, plain generic broadband bearer */
+    if (!mm_base_modem_peek_best_data_port (MM_BASE_MODEM (self), MM_PORT_TYPE_NET)) {
+        mm_broadband_bearer_new (MM_BROADBAND_MODEM (self),
+                                 properties,
+                                 NULL, /* cancellable */
+                                 (GAsyncReadyCallback)broadband_bearer_new_ready,
+                                 ctx->result);
+        create_bearer_context_free (ctx);
+        return;
+    }
+
+    /* The networking mode is only loaded for the first bearer */
+    if (ctx->self->priv->mode != MM_UBLOX_NETWORKING_MODE_UNKNOWN) {
+        create_bearer_with_mode (ctx);
+        return;
+    }
+
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              "+UBMCONF?",
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback)ubmconf_ready,
+                              ctx);
+}
+
+/*****************************************************************************/
+/* Setup/Cleanup unsolicited events (3GPP interface) */
+
+static void
+ureg_received (MMPortSerialAt *port,
+               GMatchInfo *match_info,
+               MMBroadbandModemUblox *self)
+{
+    guint state = 0;
+
+    if (!mm_get_uint_from_match_info (match_info, 1, &state))
+        return;
+
+    mm_dbg ("u-blox: packet switched registration state changed (%u)", state);
+    mm_iface_modem_3gpp_update_access_technologies (
+        MM_IFACE_MODEM_3GPP (self),
+        mm_ublox_get_access_technology_from_ureg_state (state));
+}
+
+static void
+ucged_received (MMPortSerialAt *port,
+                GMatchInfo *match_info,
+                MMBroadbandModemUblox *self)
+{
+    gchar *str;
+    guint mcc = 0;
+    guint mnc = 0;
+    gulong tac = 0;
+    gulong ci = 0;
+    gdouble rsrp = 0.0;
+    gdouble rsrq = 0.0;
+    GError *error = NULL;
+
+    str = g_match_info_fetch (match_info, 1);
+    if (!mm_ublox_parse_ucged_lte (str, &mcc, &mnc, &tac, &ci, &rsrp, &rsrq, &error)) {
+        mm_dbg ("u-blox: ignored +UCGED report: %s", error->message);
+        g_error_free (error);
+        g_clear_object (&self->priv->lte_signal);
+        g_free (str);
+        return;
+    }
+    g_free (str);
+
+    /* Cell info goes straight to the 3GPP location */
+    if (MM_IS_IFACE_MODEM_LOCATION (self) && mcc > 0)
+        mm_iface_modem_location_3gpp_update_mcc_mnc (MM_IFACE_MODEM_LOCATION (self), mcc, mnc);
+    mm_iface_modem_3gpp_update_location (MM_IFACE_MODEM_3GPP (self), tac, ci);
+
+    /* And signal info is kept until the Signal interface asks for it */
+    if (!self->priv->lte_signal)
+        self->priv->lte_signal = mm_signal_new ();
+    mm_signal_set_rsrp (self->priv->lte_signal, rsrp);
+    mm_signal_set_rsrq (self->priv->lte_signal, rsrq);
+}
+
+static void
+set_3gpp_unsolicited_events_handlers (MMBroadbandModemUblox *self,
+                                      gboolean enable)
+{
+    MMPortSerialAt *ports[2];
+    guint i;
+
+    ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+
+    for (i = 0; i < G_N_ELEMENTS (ports); i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            self->priv->ureg_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn)ureg_received : NULL,
+            enable ? self : NULL,
+            NULL);
+
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            self->priv->ucged_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn)ucged_received : NULL,
+            enable ? self : NULL,
+            NULL);
+    }
+}
+
+static gboolean
+modem_3gpp_setup_cleanup_unsolicited_events_finish (MMIfaceModem3gpp *self,
+                                                    GAsyncResult *res,
+                                                    GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+parent_3gpp_setup_unsolicited_events_ready (MMIfaceModem3gpp *self,
+                                            GAsyncResult *res,
+                                            GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!iface_modem_3gpp_parent->setup_unsolicited_events_finish (self, res, &error))
+        g_simple_async_result_take_error (simple, error);
+    else {
+        /* Our own setup now */
+        set_3gpp_unsolicited_events_handlers (MM_BROADBAND_MODEM_UBLOX (self), TRUE);
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+    }
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+modem_3gpp_setup_unsolicited_events (MMIfaceModem3gpp *self,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        modem_3gpp_setup_unsolicited_events);
+
+    /* Chain up parent's setup */
+    iface_modem_3gpp_parent->setup_unsolicited_events (
+        self,
+        (GAsyncReadyCallback)parent_3gpp_setup_unsolicited_events_ready,
+        result);
+}
+
+static void
+parent_3gpp_cleanup_unsolicited_events_ready (MMIfaceModem3gpp *self,
+                                              GAsyncResult *res,
+                                              GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!iface_modem_3gpp_parent->cleanup_unsolicited_events_finish (self, res, &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+modem_3gpp_cleanup_unsolicited_events (MMIfaceModem3gpp *self,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        modem_3gpp_cleanup_unsolicited_events);
+
+    /* Our own cleanup first */
+    set_3gpp_unsolicited_events_handlers (MM_BROADBAND_MODEM_UBLOX (self), FALSE);
+
+    /* And now chain up parent's cleanup */
+    iface_modem_3gpp_parent->cleanup_unsolicited_events (
+        self,
+        (GAsyncReadyCallback)parent_3gpp_cleanup_unsolicited_events_ready,
+        result);
+}
+
+/*****************************************************************************/
+/* Enable/Disable unsolicited events (3GPP interface) */
+
+static gboolean
+modem_3gpp_enable_disable_unsolicited_events_finish (MMIfaceModem3gpp *self,
+                                                     GAsyncResult *res,
+                                                     GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+own_enable_disable_unsolicited_events_ready (MMBaseModem *self,
+                                             GAsyncResult *res,
+                                             GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    /* Not critical, the generic registration and signal reports still work */
+    if (!mm_base_modem_at_sequence_full_finish (self, res, NULL, &error)) {
+        mm_dbg ("u-blox: couldn't setup unsolicited reports: %s", error->message);
+        g_error_free (error);
+    }
+
+    g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static const MMBaseModemAtCommand unsolicited_enable_sequence[] = {
+    /* Packet switched registration and access technology reports */
+    { "+UREG=1",  3, FALSE, NULL },
+    /* Short form cell environment reports */
+    { "+UCGED=2", 3, FALSE, NULL },
+    { NULL }
+};
+
+static const MMBaseModemAtCommand unsolicited_disable_sequence[] = {
+    { "+UREG=0",  3, FALSE, NULL },
+    { "+UCGED=0", 3, FALSE, NULL },
+    { NULL }
+};
+
+static void
+parent_enable_unsolicited_events_ready (MMIfaceModem3gpp *self,
+                                        GAsyncResult *res,
+                                        GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!iface_modem_3gpp_parent->enable_unsolicited_events_finish (self, res, &error)) {
+        g_simple_async_result_take_error (simple, error);
+        g_simple_async_result_complete (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    /* Our own enable now */
+    mm_base_modem_at_sequence_full (
+        MM_BASE_MODEM (self),
+        mm_base_modem_peek_port_primary (MM_BASE_MODEM (self)),
+        unsolicited_enable_sequence,
+        NULL, /* response_processor_context */
+        NULL, /* response_processor_context_free */
+        NULL, /* cancellable */
+        (GAsyncReadyCallback)own_enable_disable_unsolicited_events_ready,
+        simple);
+}
+
+static void
+modem_3gpp_enable_unsolicited_events (MMIfaceModem3gpp *self,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        modem_3gpp_enable_unsolicited_events);
+
+    /* Chain up parent's enable */
+    iface_modem_3gpp_parent->enable_unsolicited_events (
+        self,
+        (GAsyncReadyCallback)parent_enable_unsolicited_events_ready,
+        result);
+}
+
+static void
+parent_disable_unsolicited_events_ready (MMIfaceModem3gpp *self,
+                                         GAsyncResult *res,
+                                         GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!iface_modem_3gpp_parent->disable_unsolicited_events_finish (self, res, &error))
+        g_simple_async_result_take_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+own_disable_unsolicited_events_ready (MMBaseModem *self,
+                                      GAsyncResult *res,
+                                      GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_at_sequence_full_finish (self, res, NULL, &error)) {
+        mm_dbg ("u-blox: couldn't disable unsolicited reports: %s", error->message);
+        g_error_free (error);
+    }
+
+    /* Next, chain up parent's disable */
+    iface_modem_3gpp_parent->disable_unsolicited_events (
+        MM_IFACE_MODEM_3GPP (self),
+        (GAsyncReadyCallback)parent_disable_unsolicited_events_ready,
+        simple);
+}
+
+static void
+modem_3gpp_disable_unsolicited_events (MMIfaceModem3gpp *self,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        modem_3gpp_disable_unsolicited_events);
+
+    /* Our own disable first */
+    mm_base_modem_at_sequence_full (
+        MM_BASE_MODEM (self),
+        mm_base_modem_peek_port_primary (MM_BASE_MODEM (self)),
+        unsolicited_disable_sequence,
+        NULL, /* response_processor_context */
+        NULL, /* response_processor_context_free */
+        NULL, /* cancellable */
+        (GAsyncReadyCallback)own_disable_unsolicited_events_ready,
+        result);
+}
+
+/*****************************************************************************/
+/* Check support (Signal interface) */
+
+static gboolean
+signal_check_support_finish (MMIfaceModemSignal *self,
+                             GAsyncResult *res,
+                             GError **error)
+{
+    return !!mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, error);
+}
+
+static void
+signal_check_support (MMIfaceModemSignal *self,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              "+UCGED=?",
+                              3,
+                              TRUE,
+                              callback,
+                              user_data);
+}
+
+/*****************************************************************************/
+/* Load extended signal information (Signal interface) */
+
+static gboolean
+signal_load_values_finish (MMIfaceModemSignal *self,
+                           GAsyncResult *res,
+                           MMSignal **cdma,
+                           MMSignal **evdo,
+                           MMSignal **gsm,
+                           MMSignal **umts,
+                           MMSignal **lte,
+                           GError **error)
+{
+    MMSignal *signal;
+
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return FALSE;
+
+    signal = g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+    *cdma = NULL;
+    *evdo = NULL;
+    *gsm  = NULL;
+    *umts = NULL;
+    *lte  = signal ? g_object_ref (signal) : NULL;
+    return TRUE;
+}
+
+static void
+ucged_query_ready (MMBaseModem *_self,
+                   GAsyncResult *res,
+                   GSimpleAsyncResult *simple)
+{
+    MMBroadbandModemUblox *self = MM_BROADBAND_MODEM_UBLOX (_self);
+    GError *error = NULL;
+
+    /* Don't care about the response; it will have been parsed by the +UCGED
+     * unsolicited message handler */
+    if (!mm_base_modem_at_command_finish (_self, res, &error))
+        g_simple_async_result_take_error (simple, error);
+    else if (self->priv->lte_signal)
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   g_object_ref (self->priv->lte_signal),
+                                                   (GDestroyNotify)g_object_unref);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+signal_load_values (MMIfaceModemSignal *_self,
+                    GCancellable *cancellable,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data)
+{
+    MMBroadbandModemUblox *self = MM_BROADBAND_MODEM_UBLOX (_self);
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        signal_load_values);
+
+    /* Values reported in the last +UCGED URC are good enough */
+    if (self->priv->lte_signal) {
+        g_simple_async_result_set_op_res_gpointer (result,
+                                                   g_object_ref (self->priv->lte_signal),
+                                                   (GDestroyNotify)g_object_unref);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              "+UCGED?",
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback)ucged_query_ready,
+                              result);
+}
+
+/*****************************************************************************/
+
+MMBroadbandModemUblox *
+mm_broadband_modem_ublox_new (const gchar *device,
+                              const gchar **drivers,
+                              const gchar *plugin,
+                              guint16 vendor_id,
+                              guint16 product_id)
+{
+    return g_object_new (MM_TYPE_BROADBAND_MODEM_UBLOX,
+                         MM_BASE_MODEM_DEVICE, device,
+                         MM_BASE_MODEM_DRIVERS, drivers,
+                         MM_BASE_MODEM_PLUGIN, plugin,
+                         MM_BASE_MODEM_VENDOR_ID, vendor_id,
+                         MM_BASE_MODEM_PRODUCT_ID, product_id,
+                         /* Read commands may be sent concatenated */
+                         MM_BASE_MODEM_AT_CONCATENATION, TRUE,
+                         /* Signal quality is reported with +CIEV and
+                          * registration with +CREG/+CEREG and +UREG */
+                         MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED, TRUE,
+                         MM_IFACE_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED, TRUE,
+                         NULL);
+}
+
+static void
+mm_broadband_modem_ublox_init (MMBroadbandModemUblox *self)
+{
+    /* Initialize private data */
+    self->priv = G_TYPE_INSTANCE_GET_PRIVATE ((self),
+                                              MM_TYPE_BROADBAND_MODEM_UBLOX,
+                                              MMBroadbandModemUbloxPrivate);
+    self->priv->mode = MM_UBLOX_NETWORKING_MODE_UNKNOWN;
+
+    self->priv->ureg_regex = g_regex_new ("\\r\\n\\+UREG:\\s*(\\d+)\\r\\n",
+                                          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    self->priv->ucged_regex = g_regex_new ("\\r\\n(\\+UCGED:\\s*2\\s*\\r\\n[^\\r\\n]+)\\r\\n",
+                                           G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+}
+
+static void
+finalize (GObject *object)
+{
+    MMBroadbandModemUblox *self = MM_BROADBAND_MODEM_UBLOX (object);
+
+    g_regex_unref (self->priv->ureg_regex);
+    g_regex_unref (self->priv->ucged_regex);
+    g_clear_object (&self->priv->lte_signal);
+
+    G_OBJECT_CLASS (mm_broadband_modem_ublox_parent_class)->finalize (object);
+}
+
+static void
+iface_modem_init (MMIfaceModem *iface)
+{
+    iface->create_bearer = modem_create_bearer;
+    iface->create_bearer_finish = modem_create_bearer_finish;
+}
+
+static void
+iface_modem_3gpp_init (MMIfaceModem3gpp *iface)
+{
+    iface_modem_3gpp_parent = g_type_interface_peek_parent (iface);
+
+    iface->setup_unsolicited_events = modem_3gpp_setup_unsolicited_events;
+    iface->setup_unsolicited_events_finish = modem_3gpp_setup_cleanup_unsolicited_events_finish;
+    iface->cleanup_unsolicited_events = modem_3gpp_cleanup_unsolicited_events;
+    iface->cleanup_unsolicited_events_finish = modem_3gpp_setup_cleanup_unsolicited_events_finish;
+    iface->enable_unsolicited_events = modem_3gpp_enable_unsolicited_events;
+    iface->enable_unsolicited_events_finish = modem_3gpp_enable_disable_unsolicited_events_finish;
+    iface->disable_unsolicited_events = modem_3gpp_disable_unsolicited_events;
+    iface->disable_unsolicited_events_finish = modem_3gpp_enable_disable_unsolicited_events_finish;
+}
+
+static void
+iface_modem_signal_init (MMIfaceModemSignal *iface)
+{
+    iface->check_support = signal_check_support;
+    iface->check_support_finish = signal_check_support_finish;
+    iface->load_values = signal_load_values;
+    iface->load_values_finish = signal_load_values_finish;
+}
+
+static void
+mm_broadband_modem_ublox_class_init (MMBroadbandModemUbloxClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    g_type_class_add_private (object_class, sizeof (MMBroadbandModemUbloxPrivate));
+
+    object_class->finalize = finalize;
+}
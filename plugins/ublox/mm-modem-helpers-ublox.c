@@ -0,0 +1,271 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
+#include "mm-modem-helpers-ublox.h"
+
+/*****************************************************************************/
+/* +UBMCONF response parser */
+
+gboolean
+mm_ublox_parse_ubmconf_response (const gchar            *response,
+                                 MMUbloxNetworkingMode  *out_mode,
+                                 GError                **error)
+{
+    GRegex *r;
+    GMatchInfo *match_info = NULL;
+    guint mode = MM_UBLOX_NETWORKING_MODE_UNKNOWN;
+
+    /* Response may be e.g.:
+     * +UBMCONF: 1
+     * +UBMCONF: 2
+     */
+    r = mm_regex_registry_get ("\\+UBMCONF:\\s*(\\d+)", G_REGEX_RAW);
+    g_assert (r != NULL);
+
+    if (g_regex_match (r, response, 0, &match_info))
+        mm_get_uint_from_match_info (match_info, 1, &mode);
+
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+
+    if (mode != MM_UBLOX_NETWORKING_MODE_ROUTER &&
+        mode != MM_UBLOX_NETWORKING_MODE_BRIDGE) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't parse networking mode from +UBMCONF response: '%s'",
+                     response);
+        return FALSE;
+    }
+
+    *out_mode = (MMUbloxNetworkingMode) mode;
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* +CGCONTRDP=N response parser */
+
+static gchar *
+fetch_non_empty (GMatchInfo *match_info,
+                 guint32     match_index)
+{
+    gchar *str;
+
+    str = g_match_info_fetch (match_info, match_index);
+    if (str && !str[0]) {
+        g_free (str);
+        str = NULL;
+    }
+    return str;
+}
+
+gboolean
+mm_ublox_parse_cgcontrdp_response (const gchar  *response,
+                                   guint        *out_cid,
+                                   gchar       **out_address,
+                                   guint        *out_prefix,
+                                   gchar       **out_gateway,
+                                   gchar       **out_dns1,
+                                   gchar       **out_dns2,
+                                   GError      **error)
+{
+    GRegex *r;
+    GMatchInfo *match_info = NULL;
+    gchar *local = NULL;
+    gchar **split = NULL;
+    gboolean ret = FALSE;
+    guint cid = 0;
+
+    /* Response may be e.g.:
+     * +CGCONTRDP: 1,5,"internet","10.10.10.2.255.255.255.0","10.10.10.1","8.8.8.8","8.8.4.4"
+     *
+     * The local address and the subnet mask are given in the same field, and
+     * the DNS servers may not be given.
+     */
+    r = mm_regex_registry_get ("\\+CGCONTRDP:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,"
+                               "\\s*\"?([^,\"\\r\\n]*)\"?\\s*,"   /* apn */
+                               "\\s*\"?([^,\"\\r\\n]*)\"?\\s*,"   /* local address and subnet mask */
+                               "\\s*\"?([^,\"\\r\\n]*)\"?"        /* gateway */
+                               "(?:\\s*,\\s*\"?([^,\"\\r\\n]*)\"?)?"  /* primary dns */
+                               "(?:\\s*,\\s*\"?([^,\"\\r\\n]*)\"?)?", /* secondary dns */
+                               G_REGEX_RAW);
+    g_assert (r != NULL);
+
+    if (!g_regex_match (r, response, 0, &match_info) ||
+        !mm_get_uint_from_match_info (match_info, 1, &cid)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't parse +CGCONTRDP response: '%s'", response);
+        goto out;
+    }
+
+    /* Only IPv4 supported: 4 fields for the address and 4 for the mask */
+    local = fetch_non_empty (match_info, 4);
+    if (local)
+        split = g_strsplit (local, ".", -1);
+    if (!split || g_strv_length (split) != 8) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                     "Unsupported local address in +CGCONTRDP response: '%s'",
+                     local ? local : "none");
+        goto out;
+    }
+
+    if (out_address)
+        *out_address = g_strdup_printf ("%s.%s.%s.%s", split[0], split[1], split[2], split[3]);
+    if (out_prefix) {
+        gchar *mask;
+
+        mask = g_strdup_printf ("%s.%s.%s.%s", split[4], split[5], split[6], split[7]);
+        *out_prefix = mm_netmask_to_cidr (mask);
+        g_free (mask);
+    }
+    if (out_cid)
+        *out_cid = cid;
+    if (out_gateway)
+        *out_gateway = fetch_non_empty (match_info, 5);
+    if (out_dns1)
+        *out_dns1 = fetch_non_empty (match_info, 6);
+    if (out_dns2)
+        *out_dns2 = fetch_non_empty (match_info, 7);
+    ret = TRUE;
+
+out:
+    g_strfreev (split);
+    g_free (local);
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+    return ret;
+}
+
+/*****************************************************************************/
+/* +UREG URC state to access technology */
+
+MMModemAccessTechnology
+mm_ublox_get_access_technology_from_ureg_state (guint state)
+{
+    switch (state) {
+    case 1:
+        return MM_MODEM_ACCESS_TECHNOLOGY_GPRS;
+    case 2:
+        return MM_MODEM_ACCESS_TECHNOLOGY_EDGE;
+    case 3:
+        return MM_MODEM_ACCESS_TECHNOLOGY_UMTS;
+    case 4:
+        return MM_MODEM_ACCESS_TECHNOLOGY_HSDPA;
+    case 5:
+        return MM_MODEM_ACCESS_TECHNOLOGY_HSUPA;
+    case 6:
+        return MM_MODEM_ACCESS_TECHNOLOGY_HSPA;
+    case 7:
+    case 9:  /* LTE Cat M1 */
+    case 10: /* LTE Cat NB1 */
+        return MM_MODEM_ACCESS_TECHNOLOGY_LTE;
+    case 8:  /* EC-GSM-IoT */
+        return MM_MODEM_ACCESS_TECHNOLOGY_GSM;
+    case 0:  /* not registered for PS */
+    default:
+        return MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
+    }
+}
+
+/*****************************************************************************/
+/* +UCGED=2 LTE cell info parser */
+
+gboolean
+mm_ublox_parse_ucged_lte (const gchar  *str,
+                          guint        *out_mcc,
+                          guint        *out_mnc,
+                          gulong       *out_tac,
+                          gulong       *out_ci,
+                          gdouble      *out_rsrp,
+                          gdouble      *out_rsrq,
+                          GError      **error)
+{
+    GRegex *r;
+    GMatchInfo *match_info = NULL;
+    gchar *line = NULL;
+    gchar **split = NULL;
+    guint mcc = 0;
+    guint mnc = 0;
+    guint tac = 0;
+    guint ci = 0;
+    gdouble rsrp = 0.0;
+    gdouble rsrq = 0.0;
+    gboolean ret = FALSE;
+
+    /* Report may be e.g.:
+     * +UCGED: 2
+     * 6,4,001,01,2525,3,50,50,b5,8a0cf1f,310,0000c822,8001,01,-94.40,-10.90,21,1,2,15,-94,147,0,0,0,0
+     *
+     * Where the fields after the RAT (6 for LTE) are:
+     *  <svc>,<MCC>,<MNC>,<EARFCN>,<Lband>,<ul_BW>,<dl_BW>,<tac>,<LcellId>,
+     *  <P-CID>,<mTmsi>,<mmeGrId>,<mmeCode>,<rsrp>,<rsrq>,...
+     * with TAC and cell ID in hex.
+     */
+    r = mm_regex_registry_get ("\\+UCGED:\\s*2\\s*[\\r\\n]+\\s*6\\s*,([^\\r\\n]*)",
+                               G_REGEX_RAW);
+    g_assert (r != NULL);
+
+    if (!g_regex_match (r, str, 0, &match_info)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't parse LTE cell info from +UCGED report: '%s'", str);
+        goto out;
+    }
+
+    line = g_match_info_fetch (match_info, 1);
+    split = g_strsplit (line, ",", -1);
+    if (g_strv_length (split) < 15) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Too few fields in +UCGED LTE cell info: '%s'", line);
+        goto out;
+    }
+
+    if (!mm_get_uint_from_str (split[1], &mcc) ||
+        !mm_get_uint_from_str (split[2], &mnc) ||
+        !mm_get_uint_from_hex_str (split[7], &tac) ||
+        !mm_get_uint_from_hex_str (split[8], &ci) ||
+        !mm_get_double_from_str (split[13], &rsrp) ||
+        !mm_get_double_from_str (split[14], &rsrq)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Invalid fields in +UCGED LTE cell info: '%s'", line);
+        goto out;
+    }
+
+    if (out_mcc)
+        *out_mcc = mcc;
+    if (out_mnc)
+        *out_mnc = mnc;
+    if (out_tac)
+        *out_tac = tac;
+    if (out_ci)
+        *out_ci = ci;
+    if (out_rsrp)
+        *out_rsrp = rsrp;
+    if (out_rsrq)
+        *out_rsrq = rsrq;
+    ret = TRUE;
+
+out:
+    g_strfreev (split);
+    g_free (line);
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+    return ret;
+}
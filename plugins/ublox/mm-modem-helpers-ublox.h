@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_MODEM_HELPERS_UBLOX_H
+#define MM_MODEM_HELPERS_UBLOX_H
+
+#include <glib.h>
+#include <ModemManager.h>
+
+/*****************************************************************************/
+/* +UBMCONF response parser */
+
+typedef enum {
+    MM_UBLOX_NETWORKING_MODE_UNKNOWN = 0,
+    MM_UBLOX_NETWORKING_MODE_ROUTER  = 1,
+    MM_UBLOX_NETWORKING_MODE_BRIDGE  = 2,
+} MMUbloxNetworkingMode;
+
+gboolean mm_ublox_parse_ubmconf_response (const gchar            *response,
+                                          MMUbloxNetworkingMode  *out_mode,
+                                          GError                **error);
+
+/*****************************************************************************/
+/* +CGCONTRDP=N response parser */
+
+gboolean mm_ublox_parse_cgcontrdp_response (const gchar  *response,
+                                            guint        *out_cid,
+                                            gchar       **out_address,
+                                            guint        *out_prefix,
+                                            gchar       **out_gateway,
+                                            gchar       **out_dns1,
+                                            gchar       **out_dns2,
+                                            GError      **error);
+
+/*****************************************************************************/
+/* +UREG URC state to access technology */
+
+MMModemAccessTechnology mm_ublox_get_access_technology_from_ureg_state (guint state);
+
+/*****************************************************************************/
+/* +UCGED=2 LTE cell info parser */
+
+gboolean mm_ublox_parse_ucged_lte (const gchar  *str,
+                                   guint        *out_mcc,
+                                   guint        *out_mnc,
+                                   gulong       *out_tac,
+                                   gulong       *out_ci,
+                                   gdouble      *out_rsrp,
+                                   gdouble      *out_rsrq,
+                                   GError      **error);
+
+#endif  /* MM_MODEM_HELPERS_UBLOX_H */
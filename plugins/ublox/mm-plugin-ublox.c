@@ -0,0 +1,84 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <gmodule.h>
+
+#include "mm-plugin-ublox.h"
+#include "mm-broadband-modem-ublox.h"
+#include "mm-log.h"
+
+G_DEFINE_TYPE (MMPluginUblox, mm_plugin_ublox, MM_TYPE_PLUGIN)
+
+MM_PLUGIN_DEFINE_MAJOR_VERSION
+MM_PLUGIN_DEFINE_MINOR_VERSION
+
+/*****************************************************************************/
+
+static MMBaseModem *
+create_modem (MMPlugin *self,
+              const gchar *uid,
+              const gchar **drivers,
+              guint16 vendor,
+              guint16 product,
+              GList *probes,
+              GError **error)
+{
+    GList *l;
+
+    /* The ECM/RNDIS network interface is grabbed as any other port, the
+     * bearer will pick it up when connecting */
+    for (l = probes; l; l = g_list_next (l)) {
+        if (g_str_equal (mm_port_probe_get_port_subsys (MM_PORT_PROBE (l->data)), "net"))
+            mm_dbg ("u-blox: network interface '%s' found",
+                    mm_port_probe_get_port_name (MM_PORT_PROBE (l->data)));
+    }
+
+    return MM_BASE_MODEM (mm_broadband_modem_ublox_new (uid,
+                                                        drivers,
+                                                        mm_plugin_get_name (self),
+                                                        vendor,
+                                                        product));
+}
+
+/*****************************************************************************/
+
+G_MODULE_EXPORT MMPlugin *
+mm_plugin_create (void)
+{
+    static const gchar *subsystems[] = { "tty", "net", NULL };
+    static const guint16 vendor_ids[] = { 0x1546, 0 };
+
+    return MM_PLUGIN (
+        g_object_new (MM_TYPE_PLUGIN_UBLOX,
+                      MM_PLUGIN_NAME,               "u-blox",
+                      MM_PLUGIN_ALLOWED_SUBSYSTEMS, subsystems,
+                      MM_PLUGIN_ALLOWED_VENDOR_IDS, vendor_ids,
+                      MM_PLUGIN_ALLOWED_AT,         TRUE,
+                      NULL));
+}
+
+static void
+mm_plugin_ublox_init (MMPluginUblox *self)
+{
+}
+
+static void
+mm_plugin_ublox_class_init (MMPluginUbloxClass *klass)
+{
+    MMPluginClass *plugin_class = MM_PLUGIN_CLASS (klass);
+
+    plugin_class->create_modem = create_modem;
+}
@@ -0,0 +1,236 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <glib.h>
+#include <glib-object.h>
+#include <locale.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-log.h"
+#include "mm-modem-helpers.h"
+#include "mm-modem-helpers-ublox.h"
+
+/*****************************************************************************/
+/* Test +UBMCONF responses */
+
+typedef struct {
+    const gchar           *str;
+    MMUbloxNetworkingMode  mode;
+} UbmconfResponseTest;
+
+static const UbmconfResponseTest ubmconf_response_tests[] = {
+    { "+UBMCONF: 1",  MM_UBLOX_NETWORKING_MODE_ROUTER  },
+    { "+UBMCONF: 2",  MM_UBLOX_NETWORKING_MODE_BRIDGE  },
+    { "+UBMCONF:2",   MM_UBLOX_NETWORKING_MODE_BRIDGE  },
+    { "+UBMCONF: 3",  MM_UBLOX_NETWORKING_MODE_UNKNOWN },
+    { "+UBMCONF: ",   MM_UBLOX_NETWORKING_MODE_UNKNOWN },
+};
+
+static void
+test_ubmconf_response (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (ubmconf_response_tests); i++) {
+        MMUbloxNetworkingMode mode = MM_UBLOX_NETWORKING_MODE_UNKNOWN;
+        GError *error = NULL;
+        gboolean success;
+
+        success = mm_ublox_parse_ubmconf_response (ubmconf_response_tests[i].str, &mode, &error);
+        if (ubmconf_response_tests[i].mode != MM_UBLOX_NETWORKING_MODE_UNKNOWN) {
+            g_assert_no_error (error);
+            g_assert (success);
+        } else {
+            g_assert (error != NULL);
+            g_assert (!success);
+            g_error_free (error);
+        }
+        g_assert_cmpuint (mode, ==, ubmconf_response_tests[i].mode);
+    }
+}
+
+/*****************************************************************************/
+/* Test +CGCONTRDP responses */
+
+typedef struct {
+    const gchar *str;
+    guint        cid;
+    const gchar *address;
+    guint        prefix;
+    const gchar *gateway;
+    const gchar *dns1;
+    const gchar *dns2;
+} CgcontrdpResponseTest;
+
+static const CgcontrdpResponseTest cgcontrdp_response_tests[] = {
+    {
+        "+CGCONTRDP: 1,5,\"internet\",\"10.10.10.2.255.255.255.0\",\"10.10.10.1\",\"8.8.8.8\",\"8.8.4.4\"",
+        1, "10.10.10.2", 24, "10.10.10.1", "8.8.8.8", "8.8.4.4"
+    },
+    {
+        "+CGCONTRDP: 2,6,\"internet\",\"100.64.0.7.255.255.0.0\",\"100.64.0.1\"",
+        2, "100.64.0.7", 16, "100.64.0.1", NULL, NULL
+    },
+    {
+        "+CGCONTRDP: 1,5,internet,10.10.10.2.255.255.255.252,10.10.10.1,8.8.8.8\r\n",
+        1, "10.10.10.2", 30, "10.10.10.1", "8.8.8.8", NULL
+    },
+    /* IPv6 address, unsupported */
+    {
+        "+CGCONTRDP: 1,5,\"internet\",\"32.1.13.184.0.0.0.0.0.0.0.0.0.0.0.1\",\"\"",
+        0, NULL, 0, NULL, NULL, NULL
+    },
+};
+
+static void
+test_cgcontrdp_response (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (cgcontrdp_response_tests); i++) {
+        GError *error = NULL;
+        gboolean success;
+        guint cid = 0;
+        gchar *address = NULL;
+        guint prefix = 0;
+        gchar *gateway = NULL;
+        gchar *dns1 = NULL;
+        gchar *dns2 = NULL;
+
+        success = mm_ublox_parse_cgcontrdp_response (cgcontrdp_response_tests[i].str,
+                                                     &cid, &address, &prefix, &gateway, &dns1, &dns2,
+                                                     &error);
+        if (cgcontrdp_response_tests[i].address) {
+            g_assert_no_error (error);
+            g_assert (success);
+        } else {
+            g_assert (error != NULL);
+            g_assert (!success);
+            g_error_free (error);
+        }
+
+        g_assert_cmpuint (cid, ==, cgcontrdp_response_tests[i].cid);
+        g_assert_cmpstr (address, ==, cgcontrdp_response_tests[i].address);
+        g_assert_cmpuint (prefix, ==, cgcontrdp_response_tests[i].prefix);
+        g_assert_cmpstr (gateway, ==, cgcontrdp_response_tests[i].gateway);
+        g_assert_cmpstr (dns1, ==, cgcontrdp_response_tests[i].dns1);
+        g_assert_cmpstr (dns2, ==, cgcontrdp_response_tests[i].dns2);
+
+        g_free (address);
+        g_free (gateway);
+        g_free (dns1);
+        g_free (dns2);
+    }
+}
+
+/*****************************************************************************/
+/* Test +UREG states */
+
+static void
+test_ureg_state (void)
+{
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (0),  ==, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (1),  ==, MM_MODEM_ACCESS_TECHNOLOGY_GPRS);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (3),  ==, MM_MODEM_ACCESS_TECHNOLOGY_UMTS);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (6),  ==, MM_MODEM_ACCESS_TECHNOLOGY_HSPA);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (7),  ==, MM_MODEM_ACCESS_TECHNOLOGY_LTE);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (10), ==, MM_MODEM_ACCESS_TECHNOLOGY_LTE);
+    g_assert_cmpuint (mm_ublox_get_access_technology_from_ureg_state (42), ==, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN);
+}
+
+/*****************************************************************************/
+/* Test +UCGED LTE reports */
+
+static void
+test_ucged_lte (void)
+{
+    const gchar *str =
+        "\r\n+UCGED: 2\r\n"
+        "6,4,001,01,2525,3,50,50,b5,8a0cf1f,310,0000c822,8001,01,-94.40,-10.90,21,1,2,15,-94,147,0,0,0,0\r\n";
+    GError *error = NULL;
+    gboolean success;
+    guint mcc = 0;
+    guint mnc = 0;
+    gulong tac = 0;
+    gulong ci = 0;
+    gdouble rsrp = 0.0;
+    gdouble rsrq = 0.0;
+
+    success = mm_ublox_parse_ucged_lte (str, &mcc, &mnc, &tac, &ci, &rsrp, &rsrq, &error);
+    g_assert_no_error (error);
+    g_assert (success);
+    g_assert_cmpuint (mcc, ==, 1);
+    g_assert_cmpuint (mnc, ==, 1);
+    g_assert_cmpuint (tac, ==, 0xb5);
+    g_assert_cmpuint (ci, ==, 0x8a0cf1f);
+    g_assert_cmpfloat (rsrp, ==, -94.40);
+    g_assert_cmpfloat (rsrq, ==, -10.90);
+}
+
+static void
+test_ucged_lte_not_lte (void)
+{
+    const gchar *str =
+        "\r\n+UCGED: 2\r\n"
+        "2,4,001,01,0050,1234,5678,01,-67,0,255,255,255\r\n";
+    GError *error = NULL;
+
+    g_assert (!mm_ublox_parse_ucged_lte (str, NULL, NULL, NULL, NULL, NULL, NULL, &error));
+    g_assert (error != NULL);
+    g_error_free (error);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    setlocale (LC_ALL, "");
+
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/ublox/ubmconf/response", test_ubmconf_response);
+    g_test_add_func ("/MM/ublox/cgcontrdp/response", test_cgcontrdp_response);
+    g_test_add_func ("/MM/ublox/ureg/state", test_ureg_state);
+    g_test_add_func ("/MM/ublox/ucged/lte", test_ucged_lte);
+    g_test_add_func ("/MM/ublox/ucged/not-lte", test_ucged_lte_not_lte);
+
+    return g_test_run ();
+}
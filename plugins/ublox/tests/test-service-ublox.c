@@ -0,0 +1,378 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+/*
+ * u-blox benchmark: the same simulated u-blox AT port (ublox-port.conf, with
+ * its stream of unsolicited messages) is handled first by the u-blox plugin
+ * and then by the generic plugin, and for each of them these are reported:
+ *   - initialization: from the device being created until the modem is
+ *     exported
+ *   - enable to registered
+ *   - Simple.Connect until the bearer is connected with IP settings
+ *   - steady state commands per minute sent to the port while registered
+ *
+ * The u-blox plugin relies on unsolicited messages instead of periodic
+ * signal quality and registration checks, so it must not send more commands
+ * in steady state than the generic plugin.
+ *
+ * Virtual ports have no vendor id, so AT probing of the same port ends up in
+ * the generic plugin; it is reported once, for both.
+ *
+ * By default the steady state lasts a few seconds, as a smoke test. With
+ * '-m perf' it lasts long enough to include several polling periods, and
+ * may be changed in the environment:
+ *   $ MM_TEST_UBLOX_SECONDS=300 ./test-service-ublox -m perf
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#include <libmm-glib.h>
+
+#include "test-port-context.h"
+#include "test-fixture.h"
+
+#define SMOKE_SECONDS 5
+#define PERF_SECONDS  120
+
+#define EXPORT_TIMEOUT_S   30
+#define REGISTER_TIMEOUT_S 30
+
+/* The slow-uart latency of the scale test */
+#define LATENCY_MIN_MS 50
+#define LATENCY_MAX_MS 200
+
+#define CONNECT_APN "internet"
+
+typedef struct {
+    const gchar *plugin;
+    gint64       init;
+    gint64       enable_to_registered;
+    gint64       connect;
+    guint        n_commands;
+    gdouble      commands_per_minute;
+} PluginResults;
+
+/*****************************************************************************/
+/* Waiting for modem objects and states */
+
+typedef struct {
+    GMainLoop   *loop;
+    const gchar *device;
+    MMObject    *object;
+    MMModemState state;
+    gboolean     timed_out;
+} WaitContext;
+
+static gboolean
+wait_timeout_cb (WaitContext *ctx)
+{
+    ctx->timed_out = TRUE;
+    g_main_loop_quit (ctx->loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+wait_run (WaitContext *ctx,
+          guint        timeout_s)
+{
+    guint timeout_id;
+
+    ctx->timed_out = FALSE;
+    timeout_id = g_timeout_add_seconds (timeout_s, (GSourceFunc) wait_timeout_cb, ctx);
+    g_main_loop_run (ctx->loop);
+    if (!ctx->timed_out)
+        g_source_remove (timeout_id);
+}
+
+static gboolean
+object_matches (MMObject    *object,
+                const gchar *device)
+{
+    MMModem *modem;
+
+    modem = mm_object_peek_modem (object);
+    return (modem && !g_strcmp0 (mm_modem_get_device (modem), device));
+}
+
+static void
+object_added (GDBusObjectManager *manager,
+              MMObject           *object,
+              WaitContext        *ctx)
+{
+    if (!ctx->object && object_matches (object, ctx->device)) {
+        ctx->object = g_object_ref (object);
+        g_main_loop_quit (ctx->loop);
+    }
+}
+
+/* The manager must have been created before the device */
+static MMObject *
+wait_modem (MMManager   *manager,
+            const gchar *device)
+{
+    WaitContext  ctx;
+    GList       *objects;
+    GList       *l;
+    gulong       added_id;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.device = device;
+
+    objects = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (manager));
+    for (l = objects; l && !ctx.object; l = g_list_next (l)) {
+        if (object_matches (MM_OBJECT (l->data), device))
+            ctx.object = g_object_ref (l->data);
+    }
+    g_list_free_full (objects, (GDestroyNotify) g_object_unref);
+    if (ctx.object)
+        return ctx.object;
+
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    added_id = g_signal_connect (manager, "object-added", G_CALLBACK (object_added), &ctx);
+    wait_run (&ctx, EXPORT_TIMEOUT_S);
+    g_signal_handler_disconnect (manager, added_id);
+    g_main_loop_unref (ctx.loop);
+
+    if (!ctx.object)
+        g_error ("Modem for device '%s' not exported", device);
+    return ctx.object;
+}
+
+static void
+state_updated (MMModem     *modem,
+               GParamSpec  *pspec,
+               WaitContext *ctx)
+{
+    if (mm_modem_get_state (modem) >= ctx->state)
+        g_main_loop_quit (ctx->loop);
+}
+
+static gboolean
+wait_modem_state (MMModem      *modem,
+                  MMModemState  state,
+                  guint         timeout_s)
+{
+    WaitContext ctx;
+    gulong      state_id;
+
+    if (mm_modem_get_state (modem) >= state)
+        return TRUE;
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.state = state;
+    ctx.loop = g_main_loop_new (NULL, FALSE);
+    state_id = g_signal_connect (modem, "notify::state", G_CALLBACK (state_updated), &ctx);
+    wait_run (&ctx, timeout_s);
+    g_signal_handler_disconnect (modem, state_id);
+    g_main_loop_unref (ctx.loop);
+
+    return (mm_modem_get_state (modem) >= state);
+}
+
+/*****************************************************************************/
+
+static void
+run_plugin (TestFixture   *fixture,
+            MMManager     *manager,
+            guint          seconds,
+            PluginResults *results)
+{
+    GError                    *error = NULL;
+    TestPortContext           *port;
+    MMObject                  *obj;
+    MMModem                   *modem;
+    MMModemSimple             *simple;
+    MMSimpleConnectProperties *properties;
+    MMBearer                  *bearer;
+    MMBearerIpConfig          *ipv4_config;
+    gchar                     *profile_name;
+    gchar                     *port_name;
+    gchar                     *device;
+    const gchar               *ports[2];
+    guint                      n_commands;
+    gint64                     start;
+
+    profile_name = g_strdup_printf ("ublox-benchmark-%s", results->plugin);
+    port_name = g_strdup_printf ("abstract:%s", profile_name);
+    device = g_strdup_printf ("/virtual/%s", profile_name);
+    port = test_port_context_new_started (port_name, UBLOX_PORT_CONF, LATENCY_MIN_MS, LATENCY_MAX_MS);
+
+    /* Initialization */
+    ports[0] = port_name;
+    ports[1] = NULL;
+    start = g_get_monotonic_time ();
+    test_fixture_set_profile (fixture, profile_name, results->plugin, ports);
+    obj = wait_modem (manager, device);
+    results->init = g_get_monotonic_time () - start;
+
+    modem = mm_object_get_modem (obj);
+    g_assert_cmpstr (mm_modem_get_plugin (modem), ==, results->plugin);
+    /* Don't let the default proxy timeout hit the slow port */
+    g_dbus_proxy_set_default_timeout (G_DBUS_PROXY (modem), 300000);
+
+    /* Enable to registered */
+    start = g_get_monotonic_time ();
+    mm_modem_enable_sync (modem, NULL, &error);
+    g_assert_no_error (error);
+    g_assert (wait_modem_state (modem, MM_MODEM_STATE_REGISTERED, REGISTER_TIMEOUT_S));
+    results->enable_to_registered = g_get_monotonic_time () - start;
+
+    /* Steady state, only unsolicited messages and whatever the plugin polls */
+    n_commands = test_port_context_get_n_commands (port);
+    start = g_get_monotonic_time ();
+    sleep (seconds);
+    results->n_commands = test_port_context_get_n_commands (port) - n_commands;
+    results->commands_per_minute = (gdouble) results->n_commands * 60.0 * G_USEC_PER_SEC /
+                                   (g_get_monotonic_time () - start);
+
+    /* Connection; no more AT commands can be sent afterwards in the single
+     * port, so this goes last */
+    simple = mm_object_get_modem_simple (obj);
+    g_assert (simple != NULL);
+    g_dbus_proxy_set_default_timeout (G_DBUS_PROXY (simple), 300000);
+    properties = mm_simple_connect_properties_new ();
+    mm_simple_connect_properties_set_apn (properties, CONNECT_APN);
+    start = g_get_monotonic_time ();
+    bearer = mm_modem_simple_connect_sync (simple, properties, NULL, &error);
+    results->connect = g_get_monotonic_time () - start;
+    g_assert_no_error (error);
+    g_assert (bearer != NULL);
+    g_assert (mm_bearer_get_connected (bearer));
+    ipv4_config = mm_bearer_get_ipv4_config (bearer);
+    g_assert (ipv4_config != NULL);
+    g_assert_cmpuint (mm_bearer_ip_config_get_method (ipv4_config), !=, MM_BEARER_IP_METHOD_UNKNOWN);
+    g_object_unref (ipv4_config);
+
+    g_object_unref (bearer);
+    g_object_unref (properties);
+    g_object_unref (simple);
+    g_object_unref (modem);
+    g_object_unref (obj);
+
+    test_port_context_stop (port);
+    test_port_context_free (port);
+    g_free (device);
+    g_free (port_name);
+    g_free (profile_name);
+}
+
+static gint64
+run_probing (TestFixture *fixture)
+{
+    GError          *error = NULL;
+    TestPortContext *port;
+    GVariant        *result;
+    const gchar     *ports[2];
+    gint64           start;
+    gint64           elapsed;
+
+    ports[0] = "abstract:ublox-benchmark-probing";
+    ports[1] = NULL;
+    port = test_port_context_new_started (ports[0], UBLOX_PORT_CONF, LATENCY_MIN_MS, LATENCY_MAX_MS);
+
+    start = g_get_monotonic_time ();
+    result = g_dbus_proxy_call_sync (G_DBUS_PROXY (fixture->test),
+                                     "ProbeDevice",
+                                     g_variant_new ("(s^as)", "ublox-benchmark-probing", ports),
+                                     G_DBUS_CALL_FLAGS_NONE,
+                                     300000,
+                                     NULL,
+                                     &error);
+    elapsed = g_get_monotonic_time () - start;
+    g_assert_no_error (error);
+    g_variant_unref (result);
+
+    test_port_context_stop (port);
+    test_port_context_free (port);
+    return elapsed;
+}
+
+static void
+report_results (const PluginResults *results)
+{
+    g_test_minimized_result ((gdouble) results->init / 1000.0,
+                             "%s: initialization %.1f ms",
+                             results->plugin, (gdouble) results->init / 1000.0);
+    g_test_minimized_result ((gdouble) results->enable_to_registered / 1000.0,
+                             "%s: enable to registered %.1f ms",
+                             results->plugin, (gdouble) results->enable_to_registered / 1000.0);
+    g_test_minimized_result ((gdouble) results->connect / 1000.0,
+                             "%s: Simple.Connect to IP %.1f ms",
+                             results->plugin, (gdouble) results->connect / 1000.0);
+    g_test_minimized_result (results->commands_per_minute,
+                             "%s: steady state %.1f commands per minute (%u commands)",
+                             results->plugin, results->commands_per_minute, results->n_commands);
+}
+
+/*****************************************************************************/
+
+static void
+test_benchmark (TestFixture *fixture)
+{
+    GError        *error = NULL;
+    MMManager     *manager;
+    PluginResults  ublox;
+    PluginResults  generic;
+    gint64         probing;
+    guint          seconds;
+
+    if (g_test_perf ())
+        seconds = test_fixture_get_env_uint ("MM_TEST_UBLOX_SECONDS", PERF_SECONDS);
+    else
+        seconds = SMOKE_SECONDS;
+
+    manager = mm_manager_new_sync (fixture->connection,
+                                   G_DBUS_OBJECT_MANAGER_CLIENT_FLAGS_NONE,
+                                   NULL, /* cancellable */
+                                   &error);
+    g_assert_no_error (error);
+
+    memset (&ublox, 0, sizeof (ublox));
+    ublox.plugin = "u-blox";
+    run_plugin (fixture, manager, seconds, &ublox);
+
+    memset (&generic, 0, sizeof (generic));
+    generic.plugin = "Generic";
+    run_plugin (fixture, manager, seconds, &generic);
+
+    probing = run_probing (fixture);
+
+    g_test_minimized_result ((gdouble) probing / 1000.0,
+                             "AT probing %.1f ms",
+                             (gdouble) probing / 1000.0);
+    report_results (&ublox);
+    report_results (&generic);
+
+    /* No polling in the u-blox plugin */
+    g_assert_cmpuint (ublox.n_commands, <=, generic.n_commands);
+
+    g_object_unref (manager);
+}
+
+/*****************************************************************************/
+
+int main (int   argc,
+          char *argv[])
+{
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    TEST_ADD ("/MM/Service/Ublox/benchmark", test_benchmark);
+
+    return g_test_run ();
+}
@@ -1212,15 +1212,7 @@ modem_after_sim_unlock_finish (MMIfaceModem *self,
                                GAsyncResult *res,
                                GError **error)
 {
-    return TRUE;
-}
-
-static gboolean
-after_sim_unlock_wait_cb (GSimpleAsyncResult *result)
-{
-    g_simple_async_result_complete (result);
-    g_object_unref (result);
-    return G_SOURCE_REMOVE;
+    return mm_broadband_modem_wait_sim_ready_finish (MM_BROADBAND_MODEM (self), res, error);
 }
 
 static void
@@ -1228,17 +1220,15 @@ modem_after_sim_unlock (MMIfaceModem *self,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
 {
-    GSimpleAsyncResult *result;
-
-    /* A short wait is necessary for SIM to become ready, otherwise reloading
-     * facility lock states may fail with a +CME ERROR: 515 error.
+    /* A short wait (up to 5 seconds) is necessary for SIM to become ready,
+     * otherwise reloading facility lock states may fail with a +CME ERROR: 515
+     * error; +CPMS? fails the same way until then.
      */
-    result = g_simple_async_result_new (G_OBJECT (self),
-                                        callback,
-                                        user_data,
-                                        modem_after_sim_unlock);
-
-    g_timeout_add_seconds (5, (GSourceFunc)after_sim_unlock_wait_cb, result);
+    mm_broadband_modem_wait_sim_ready (MM_BROADBAND_MODEM (self),
+                                       MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPMS,
+                                       5000,
+                                       callback,
+                                       user_data);
 }
 
 /*****************************************************************************/
@@ -120,10 +120,17 @@ load_unlock_retries (MMIfaceModem *self,
 /*****************************************************************************/
 /* After SIM unlock (Modem interface) */
 
+/* +CPMS? is retried while the SIM is busy, backing off up to the max
+ * interval, until the max wait elapses */
+#define CPMS_RETRY_INITIAL_MS 250
+#define CPMS_RETRY_MAX_MS     2000
+#define CPMS_MAX_WAIT_MS      6000
+
 typedef struct {
     MMBroadbandModemZte *self;
     GSimpleAsyncResult *result;
-    guint retries;
+    gint64 deadline;
+    guint retry_ms;
 } ModemAfterSimUnlockContext;
 
 static void
@@ -148,7 +155,6 @@ static void modem_after_sim_unlock_context_step (ModemAfterSimUnlockContext *ctx
 static gboolean
 cpms_timeout_cb (ModemAfterSimUnlockContext *ctx)
 {
-    ctx->retries--;
     modem_after_sim_unlock_context_step (ctx);
     return G_SOURCE_REMOVE;
 }
@@ -164,9 +170,25 @@ cpms_try_ready (MMBaseModem *self,
         g_error_matches (error,
                          MM_MOBILE_EQUIPMENT_ERROR,
                          MM_MOBILE_EQUIPMENT_ERROR_SIM_BUSY)) {
-            /* Retry in 2 seconds */
-        g_timeout_add_seconds (2, (GSourceFunc)cpms_timeout_cb, ctx);
+        gint64 remaining_ms;
+
         g_error_free (error);
+
+        remaining_ms = (ctx->deadline - g_get_monotonic_time ()) / 1000;
+        if (remaining_ms <= 0) {
+            g_simple_async_result_set_error (
+                ctx->result,
+                MM_CORE_ERROR,
+                MM_CORE_ERROR_FAILED,
+                "Consumed all attempts to wait for SIM not being busy");
+            modem_after_sim_unlock_context_complete_and_free (ctx);
+            return;
+        }
+
+        /* Retry soon */
+        mm_dbg ("SIM busy, retrying +CPMS? in %u ms", ctx->retry_ms);
+        g_timeout_add (MIN (ctx->retry_ms, (guint) remaining_ms), (GSourceFunc)cpms_timeout_cb, ctx);
+        ctx->retry_ms = MIN (ctx->retry_ms * 2, CPMS_RETRY_MAX_MS);
         return;
     }
 
@@ -181,17 +203,6 @@ cpms_try_ready (MMBaseModem *self,
 static void
 modem_after_sim_unlock_context_step (ModemAfterSimUnlockContext *ctx)
 {
-    if (ctx->retries == 0) {
-        /* Well... just return without error */
-        g_simple_async_result_set_error (
-            ctx->result,
-            MM_CORE_ERROR,
-            MM_CORE_ERROR_FAILED,
-            "Consumed all attempts to wait for SIM not being busy");
-        modem_after_sim_unlock_context_complete_and_free (ctx);
-        return;
-    }
-
     mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
                               "+CPMS?",
                               3,
@@ -213,7 +224,8 @@ modem_after_sim_unlock (MMIfaceModem *self,
                                              callback,
                                              user_data,
                                              modem_after_sim_unlock);
-    ctx->retries = 3;
+    ctx->deadline = g_get_monotonic_time () + CPMS_MAX_WAIT_MS * 1000;
+    ctx->retry_ms = CPMS_RETRY_INITIAL_MS;
 
     /* Attempt to disable floods of "+ZUSIMR:2" unsolicited responses that
      * eventually fill up the device's buffers and make it crash.  Normally
@@ -32,6 +32,7 @@ udev_rule_match_clear (MMUdevRuleMatch *rule_match)
 {
     g_free (rule_match->parameter);
     g_free (rule_match->value);
+    g_free (rule_match->parameter_key);
 }
 
 static void
@@ -114,6 +115,74 @@ out:
     return TRUE;
 }
 
+static const struct {
+    const gchar              *name;
+    MMUdevRuleMatchParameter  id;
+} attributes[] = {
+    { "idVendor",           MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID          },
+    { "idProduct",          MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID         },
+    { "manufacturer",       MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER       },
+    { "product",            MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT            },
+    { "bInterfaceClass",    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS    },
+    { "bInterfaceSubClass", MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS },
+    { "bInterfaceProtocol", MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL },
+    { "bInterfaceNumber",   MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER   },
+};
+
+static MMUdevRuleMatchParameter
+lookup_attribute (const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (attributes); i++) {
+        if (g_str_equal (name, attributes[i].name))
+            return attributes[i].id;
+    }
+    return MM_UDEV_RULE_MATCH_PARAMETER_ATTR_UNKNOWN;
+}
+
+/* Returns the contents of "<prefix>{<key>}" in a new string, or NULL if the
+ * parameter doesn't have the prefix */
+static gchar *
+parse_parameter_key (const gchar *parameter,
+                     const gchar *prefix)
+{
+    gchar *key;
+
+    if (!g_str_has_prefix (parameter, prefix))
+        return NULL;
+
+    key = g_strdup (&parameter[strlen (prefix)]);
+    g_strdelimit (key, "{}", ' ');
+    g_strstrip (key);
+    return key;
+}
+
+static void
+compile_rule_match (MMUdevRuleMatch *rule_match)
+{
+    const gchar *parameter = rule_match->parameter;
+
+    if (g_str_equal (parameter, "ACTION"))
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_ACTION;
+    else if (g_str_equal (parameter, "SUBSYSTEMS") || g_str_equal (parameter, "SUBSYSTEM"))
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM;
+    else if (g_str_equal (parameter, "DRIVER") || g_str_equal (parameter, "DRIVERS"))
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_DRIVER;
+    else if (g_str_equal (parameter, "KERNEL"))
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_KERNEL;
+    else if (g_str_equal (parameter, "DEVPATH"))
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH;
+    else if ((rule_match->parameter_key = parse_parameter_key (parameter, "ATTRS")) != NULL) {
+        rule_match->parameter_id = lookup_attribute (rule_match->parameter_key);
+        rule_match->value_any = g_str_equal (rule_match->value, "?*");
+        rule_match->value_uint_valid = mm_get_uint_from_hex_str (rule_match->value, &rule_match->value_uint);
+    } else if ((rule_match->parameter_key = parse_parameter_key (parameter, "ENV")) != NULL)
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_ENV;
+    else
+        rule_match->parameter_id = MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN;
+}
+
 static gboolean
 load_rule_result (MMUdevRuleResult  *rule_result,
                   const gchar       *item,
@@ -154,6 +223,15 @@ load_rule_result (MMUdevRuleResult  *rule_result,
         rule_result->content.property.name = g_strndup (left + 4, left_len - 5);
         rule_result->content.property.value = right;
         right = NULL;
+        if (g_str_has_prefix (rule_result->content.property.value, "$attr{")) {
+            gchar *attribute;
+
+            attribute = parse_parameter_key (rule_result->content.property.value, "$attr");
+            rule_result->content.property.value_attr = lookup_attribute (attribute);
+            g_free (attribute);
+            if (rule_result->content.property.value_attr < MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS)
+                rule_result->content.property.value_attr = MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN;
+        }
         goto out;
     }
 
@@ -202,6 +280,7 @@ load_rule_match (MMUdevRuleMatch  *rule_match,
     g_free (operator);
     rule_match->parameter = left;
     rule_match->value     = right;
+    compile_rule_match (rule_match);
     return TRUE;
 }
 
@@ -23,10 +23,38 @@ typedef enum {
     MM_UDEV_RULE_MATCH_TYPE_NOT_EQUAL,
 } MMUdevRuleMatchType;
 
+/* Parameters known by the generic kernel device, resolved when loading the
+ * rules so that they don't need to be parsed again for every device */
+typedef enum {
+    MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN,
+    MM_UDEV_RULE_MATCH_PARAMETER_ACTION,
+    MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM,
+    MM_UDEV_RULE_MATCH_PARAMETER_DRIVER,
+    MM_UDEV_RULE_MATCH_PARAMETER_KERNEL,
+    MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_UNKNOWN,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL,
+    MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER,
+    MM_UDEV_RULE_MATCH_PARAMETER_ENV,
+} MMUdevRuleMatchParameter;
+
 typedef struct {
     MMUdevRuleMatchType  type;
     gchar               *parameter;
     gchar               *value;
+
+    /* Pre-resolved parameter and value */
+    MMUdevRuleMatchParameter  parameter_id;
+    gchar                    *parameter_key;    /* ENV property or ATTRS attribute name */
+    gboolean                  value_any;        /* "?*" */
+    gboolean                  value_uint_valid;
+    guint                     value_uint;       /* hex value of ATTRS */
 } MMUdevRuleMatch;
 
 typedef enum {
@@ -40,6 +68,9 @@ typedef enum {
 typedef struct {
     gchar *name;
     gchar *value;
+    /* One of the ATTR_INTERFACE_* parameters if the value is read from the
+     * matching "$attr{}", UNKNOWN otherwise */
+    MMUdevRuleMatchParameter value_attr;
 } MMUdevRuleResultProperty;
 
 typedef struct {
@@ -17,6 +17,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <limits.h>
 
 #define _LIBMM_INSIDE_MM
 #include <libmm-glib.h>
@@ -38,11 +40,23 @@ enum {
     PROP_0,
     PROP_PROPERTIES,
     PROP_RULES,
+    PROP_CONTENTS,
     PROP_LAST
 };
 
 static GParamSpec *properties[PROP_LAST];
 
+/* Attributes of the physical device, read once and shared by all the ports
+ * exposed by the same device */
+typedef struct {
+    volatile gint  ref_count;
+    gchar         *sysfs_path;
+    guint16        vid;
+    guint16        pid;
+    gchar         *manufacturer;
+    gchar         *product;
+} PhysdevInfo;
+
 struct _MMKernelDeviceGenericPrivate {
     /* Input properties */
     MMKernelEventProperties *properties;
@@ -58,45 +72,130 @@ struct _MMKernelDeviceGenericPrivate {
     guint8   interface_protocol;
     guint8   interface_number;
     gchar   *physdev_sysfs_path;
-    guint16  physdev_vid;
-    guint16  physdev_pid;
-    gchar   *physdev_manufacturer;
-    gchar   *physdev_product;
+    PhysdevInfo *physdev;
+
+    /* Contents given instead of read from sysfs, only during construction */
+    const MMKernelDeviceGenericContents *contents;
+
+    /* Rule evaluation statistics */
+    guint   n_rules_checked;
+    guint   n_conditions_checked;
+    GArray *applied_rules;
 };
 
+/* Whether the indices of the applied rules are recorded */
+static gboolean rule_tracing;
+
+/* All attributes of a given directory are read relative to a single O_PATH
+ * descriptor, so that the path is only walked once */
+static gint
+open_sysfs_dir (const gchar *path)
+{
+    return open (path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+}
+
+static gchar *
+read_sysfs_attribute_as_string (gint         dirfd,
+                                const gchar *attribute)
+{
+    gchar  buffer[256];
+    gssize n_read;
+    gint   fd;
+
+    if (dirfd < 0)
+        return NULL;
+
+    fd = openat (dirfd, attribute, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+    n_read = read (fd, buffer, sizeof (buffer) - 1);
+    close (fd);
+    if (n_read < 0)
+        return NULL;
+
+    buffer[n_read] = '\0';
+    g_strdelimit (buffer, "\r\n", ' ');
+    return g_strdup (g_strstrip (buffer));
+}
+
 static guint
-read_sysfs_property_as_hex (const gchar *path,
-                            const gchar *property)
+read_sysfs_attribute_as_hex (gint         dirfd,
+                             const gchar *attribute)
 {
-    gchar *aux;
-    gchar *contents = NULL;
-    guint val = 0;
+    gchar *contents;
+    guint  val = 0;
 
-    aux = g_strdup_printf ("%s/%s", path, property);
-    if (g_file_get_contents (aux, &contents, NULL, NULL)) {
-        g_strdelimit (contents, "\r\n", ' ');
-        g_strstrip (contents);
+    contents = read_sysfs_attribute_as_string (dirfd, attribute);
+    if (contents)
         mm_get_uint_from_hex_str (contents, &val);
-    }
     g_free (contents);
-    g_free (aux);
     return val;
 }
 
-static gchar *
-read_sysfs_property_as_string (const gchar *path,
-                               const gchar *property)
+/*****************************************************************************/
+/* Shared physical device info */
+
+/* physdev sysfs path -> PhysdevInfo, not owned */
+static GHashTable *physdev_infos;
+
+static PhysdevInfo *
+physdev_info_acquire (const gchar                         *sysfs_path,
+                      const MMKernelDeviceGenericContents *contents)
 {
-    gchar *aux;
-    gchar *contents = NULL;
+    PhysdevInfo *info;
+    gint         dirfd;
+    guint        val;
 
-    aux = g_strdup_printf ("%s/%s", path, property);
-    if (g_file_get_contents (aux, &contents, NULL, NULL)) {
-        g_strdelimit (contents, "\r\n", ' ');
-        g_strstrip (contents);
+    if (G_UNLIKELY (!physdev_infos))
+        physdev_infos = g_hash_table_new (g_str_hash, g_str_equal);
+
+    info = g_hash_table_lookup (physdev_infos, sysfs_path);
+    if (info) {
+        g_atomic_int_inc (&info->ref_count);
+        return info;
     }
-    g_free (aux);
-    return contents;
+
+    info = g_slice_new0 (PhysdevInfo);
+    info->ref_count = 1;
+    info->sysfs_path = g_strdup (sysfs_path);
+
+    if (contents) {
+        info->vid = contents->vid;
+        info->pid = contents->pid;
+        info->manufacturer = g_strdup (contents->manufacturer);
+        info->product = g_strdup (contents->product);
+        g_hash_table_insert (physdev_infos, info->sysfs_path, info);
+        return info;
+    }
+
+    dirfd = open_sysfs_dir (sysfs_path);
+    val = read_sysfs_attribute_as_hex (dirfd, "idVendor");
+    if (val <= G_MAXUINT16)
+        info->vid = val;
+    val = read_sysfs_attribute_as_hex (dirfd, "idProduct");
+    if (val <= G_MAXUINT16)
+        info->pid = val;
+    info->manufacturer = read_sysfs_attribute_as_string (dirfd, "manufacturer");
+    info->product = read_sysfs_attribute_as_string (dirfd, "product");
+    if (dirfd >= 0)
+        close (dirfd);
+
+    g_hash_table_insert (physdev_infos, info->sysfs_path, info);
+    return info;
+}
+
+static void
+physdev_info_release (PhysdevInfo *info)
+{
+    if (!g_atomic_int_dec_and_test (&info->ref_count))
+        return;
+
+    /* Once the last port is gone, a new device may appear at the same path */
+    g_hash_table_remove (physdev_infos, info->sysfs_path);
+    g_free (info->manufacturer);
+    g_free (info->product);
+    g_free (info->sysfs_path);
+    g_slice_free (PhysdevInfo, info);
 }
 
 /*****************************************************************************/
@@ -105,26 +204,31 @@ read_sysfs_property_as_string (const gchar *path,
 static void
 preload_sysfs_path (MMKernelDeviceGeneric *self)
 {
-    gchar *tmp;
+    gchar *tmp = NULL;
 
     if (self->priv->sysfs_path)
         return;
 
-    /* sysfs can be built directly using subsystem and name; e.g. for subsystem
-     * usbmisc and name cdc-wdm0:
-     *    $ realpath /sys/class/usbmisc/cdc-wdm0
-     *    /sys/devices/pci0000:00/0000:00:1d.0/usb4/4-1/4-1.3/4-1.3:1.8/usbmisc/cdc-wdm0
-     */
-    tmp = g_strdup_printf ("/sys/class/%s/%s",
-                           mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                           mm_kernel_event_properties_get_name      (self->priv->properties));
-
-    self->priv->sysfs_path = canonicalize_file_name (tmp);
-    if (!self->priv->sysfs_path || !g_file_test (self->priv->sysfs_path, G_FILE_TEST_EXISTS)) {
-        mm_warn ("Invalid sysfs path read for %s/%s",
-                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                 mm_kernel_event_properties_get_name      (self->priv->properties));
-        g_clear_pointer (&self->priv->sysfs_path, g_free);
+    if (self->priv->contents)
+        self->priv->sysfs_path = g_strdup (self->priv->contents->sysfs_path);
+    else {
+        /* sysfs can be built directly using subsystem and name; e.g. for subsystem
+         * usbmisc and name cdc-wdm0:
+         *    $ realpath /sys/class/usbmisc/cdc-wdm0
+         *    /sys/devices/pci0000:00/0000:00:1d.0/usb4/4-1/4-1.3/4-1.3:1.8/usbmisc/cdc-wdm0
+         */
+        tmp = g_strdup_printf ("/sys/class/%s/%s",
+                               mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                               mm_kernel_event_properties_get_name      (self->priv->properties));
+
+        self->priv->sysfs_path = canonicalize_file_name (tmp);
+        if (!self->priv->sysfs_path || !g_file_test (self->priv->sysfs_path, G_FILE_TEST_EXISTS)) {
+            mm_warn ("Invalid sysfs path read for %s/%s",
+                     mm_kernel_event_properties_get_subsystem (self->priv->properties),
+                     mm_kernel_event_properties_get_name      (self->priv->properties));
+            g_clear_pointer (&self->priv->sysfs_path, g_free);
+        }
+        g_free (tmp);
     }
 
     if (self->priv->sysfs_path) {
@@ -139,7 +243,6 @@ preload_sysfs_path (MMKernelDeviceGeneric *self)
                    self->priv->sysfs_path);
         g_object_set_data_full (G_OBJECT (self), "DEVPATH", g_strdup (devpath), g_free);
     }
-    g_free (tmp);
 }
 
 static void
@@ -151,6 +254,11 @@ preload_interface_sysfs_path (MMKernelDeviceGeneric *self)
     if (self->priv->interface_sysfs_path || !self->priv->sysfs_path)
         return;
 
+    if (self->priv->contents) {
+        self->priv->interface_sysfs_path = g_strdup (self->priv->contents->interface_sysfs_path);
+        return;
+    }
+
     /* parent sysfs can be built directly using subsystem and name; e.g. for
      * subsystem usbmisc and name cdc-wdm0:
      *    $ realpath /sys/class/usbmisc/cdc-wdm0/device
@@ -230,18 +338,39 @@ preload_physdev_sysfs_path (MMKernelDeviceGeneric *self)
 }
 
 static void
-preload_driver (MMKernelDeviceGeneric *self)
+preload_interface (MMKernelDeviceGeneric *self)
 {
-    if (!self->priv->driver && self->priv->interface_sysfs_path) {
-        gchar *tmp;
-        gchar *tmp2;
-
-        tmp = g_strdup_printf ("%s/driver", self->priv->interface_sysfs_path);
-        tmp2 = canonicalize_file_name (tmp);
-        if (tmp2 && g_file_test (tmp2, G_FILE_TEST_EXISTS))
-            self->priv->driver = g_path_get_basename (tmp2);
-        g_free (tmp2);
-        g_free (tmp);
+    gint  dirfd;
+    gchar link[PATH_MAX];
+    gssize link_len;
+
+    if (!self->priv->interface_sysfs_path)
+        return;
+
+    if (self->priv->contents) {
+        self->priv->driver             = g_strdup (self->priv->contents->driver);
+        self->priv->interface_class    = self->priv->contents->interface_class;
+        self->priv->interface_subclass = self->priv->contents->interface_subclass;
+        self->priv->interface_protocol = self->priv->contents->interface_protocol;
+        self->priv->interface_number   = self->priv->contents->interface_number;
+    } else {
+        /* Driver and interface attributes, all in the same directory */
+        dirfd = open_sysfs_dir (self->priv->interface_sysfs_path);
+        if (dirfd < 0)
+            return;
+
+        if (!self->priv->driver) {
+            link_len = readlinkat (dirfd, "driver", link, sizeof (link) - 1);
+            if (link_len > 0) {
+                link[link_len] = '\0';
+                self->priv->driver = g_path_get_basename (link);
+            }
+        }
+        self->priv->interface_class    = read_sysfs_attribute_as_hex (dirfd, "bInterfaceClass");
+        self->priv->interface_subclass = read_sysfs_attribute_as_hex (dirfd, "bInterfaceSubClass");
+        self->priv->interface_protocol = read_sysfs_attribute_as_hex (dirfd, "bInterfaceProtocol");
+        self->priv->interface_number   = read_sysfs_attribute_as_hex (dirfd, "bInterfaceNumber");
+        close (dirfd);
     }
 
     if (self->priv->driver)
@@ -249,131 +378,74 @@ preload_driver (MMKernelDeviceGeneric *self)
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
                 self->priv->driver);
+    mm_dbg ("(%s/%s) interface class/subclass/protocol: 0x%02x/0x%02x/0x%02x",
+            mm_kernel_event_properties_get_subsystem (self->priv->properties),
+            mm_kernel_event_properties_get_name      (self->priv->properties),
+            self->priv->interface_class,
+            self->priv->interface_subclass,
+            self->priv->interface_protocol);
+    mm_dbg ("(%s/%s) interface number (ID_USB_INTERFACE_NUM): 0x%02x",
+            mm_kernel_event_properties_get_subsystem (self->priv->properties),
+            mm_kernel_event_properties_get_name      (self->priv->properties),
+            self->priv->interface_number);
+    g_object_set_data_full (G_OBJECT (self), "ID_USB_INTERFACE_NUM", g_strdup_printf ("%02x", self->priv->interface_number), g_free);
 }
 
 static void
-preload_physdev_vid (MMKernelDeviceGeneric *self)
+preload_physdev (MMKernelDeviceGeneric *self)
 {
-    if (!self->priv->physdev_vid && self->priv->physdev_sysfs_path) {
-        guint val;
+    PhysdevInfo *info;
 
-        val = read_sysfs_property_as_hex (self->priv->physdev_sysfs_path, "idVendor");
-        if (val && val <= G_MAXUINT16)
-            self->priv->physdev_vid = val;
-    }
+    if (self->priv->physdev || !self->priv->physdev_sysfs_path)
+        return;
 
-    if (self->priv->physdev_vid) {
+    /* Only the first port of the physical device reads the attributes */
+    info = physdev_info_acquire (self->priv->physdev_sysfs_path, self->priv->contents);
+    self->priv->physdev = info;
+
+    if (info->vid) {
         mm_dbg ("(%s/%s) vid (ID_VENDOR_ID): 0x%04x",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_vid);
-        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR_ID", g_strdup_printf ("%04x", self->priv->physdev_vid), g_free);
+                info->vid);
+        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR_ID", g_strdup_printf ("%04x", info->vid), g_free);
     } else
         mm_dbg ("(%s/%s) vid: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
 
-}
-
-static void
-preload_physdev_pid (MMKernelDeviceGeneric *self)
-{
-    if (!self->priv->physdev_pid && self->priv->physdev_sysfs_path) {
-        guint val;
-
-        val = read_sysfs_property_as_hex (self->priv->physdev_sysfs_path, "idProduct");
-        if (val && val <= G_MAXUINT16)
-            self->priv->physdev_pid = val;
-    }
-
-    if (self->priv->physdev_pid) {
+    if (info->pid) {
         mm_dbg ("(%s/%s) pid (ID_MODEL_ID): 0x%04x",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_pid);
-        g_object_set_data_full (G_OBJECT (self), "ID_MODEL_ID", g_strdup_printf ("%04x", self->priv->physdev_pid), g_free);
+                info->pid);
+        g_object_set_data_full (G_OBJECT (self), "ID_MODEL_ID", g_strdup_printf ("%04x", info->pid), g_free);
     } else
         mm_dbg ("(%s/%s) pid: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
-}
-
-static void
-preload_manufacturer (MMKernelDeviceGeneric *self)
-{
-    if (!self->priv->physdev_manufacturer)
-        self->priv->physdev_manufacturer = (self->priv->physdev_sysfs_path ? read_sysfs_property_as_string (self->priv->physdev_sysfs_path, "manufacturer") : NULL);
 
-    if (self->priv->physdev_manufacturer) {
+    if (info->manufacturer) {
         mm_dbg ("(%s/%s) manufacturer (ID_VENDOR): %s",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_manufacturer);
-        g_object_set_data_full (G_OBJECT (self), "ID_VENDOR", g_strdup (self->priv->physdev_manufacturer), g_free);
+                info->manufacturer);
+        g_object_set_data (G_OBJECT (self), "ID_VENDOR", info->manufacturer);
     } else
         mm_dbg ("(%s/%s) manufacturer: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
-}
 
-static void
-preload_product (MMKernelDeviceGeneric *self)
-{
-    if (!self->priv->physdev_product)
-        self->priv->physdev_product = (self->priv->physdev_sysfs_path ? read_sysfs_property_as_string (self->priv->physdev_sysfs_path, "product") : NULL);
-
-    if (self->priv->physdev_product) {
+    if (info->product) {
         mm_dbg ("(%s/%s) product (ID_MODEL): %s",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->physdev_product);
-        g_object_set_data_full (G_OBJECT (self), "ID_MODEL", g_strdup (self->priv->physdev_product), g_free);
+                info->product);
+        g_object_set_data (G_OBJECT (self), "ID_MODEL", info->product);
     } else
         mm_dbg ("(%s/%s) product: unknown",
                 mm_kernel_event_properties_get_subsystem (self->priv->properties),
                 mm_kernel_event_properties_get_name      (self->priv->properties));
-
-}
-
-static void
-preload_interface_class (MMKernelDeviceGeneric *self)
-{
-    self->priv->interface_class = (self->priv->interface_sysfs_path ? read_sysfs_property_as_hex (self->priv->interface_sysfs_path, "bInterfaceClass") : 0x00);
-    mm_dbg ("(%s/%s) interface class: 0x%02x",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->interface_class);
-}
-
-static void
-preload_interface_subclass (MMKernelDeviceGeneric *self)
-{
-    self->priv->interface_subclass = (self->priv->interface_sysfs_path ? read_sysfs_property_as_hex (self->priv->interface_sysfs_path, "bInterfaceSubClass") : 0x00);
-    mm_dbg ("(%s/%s) interface subclass: 0x%02x",
-                mm_kernel_event_properties_get_subsystem (self->priv->properties),
-                mm_kernel_event_properties_get_name      (self->priv->properties),
-                self->priv->interface_subclass);
-}
-
-static void
-preload_interface_protocol (MMKernelDeviceGeneric *self)
-{
-    self->priv->interface_protocol = (self->priv->interface_sysfs_path ? read_sysfs_property_as_hex (self->priv->interface_sysfs_path, "bInterfaceProtocol") : 0x00);
-    mm_dbg ("(%s/%s) interface protocol: 0x%02x",
-            mm_kernel_event_properties_get_subsystem (self->priv->properties),
-            mm_kernel_event_properties_get_name      (self->priv->properties),
-            self->priv->interface_protocol);
-}
-
-static void
-preload_interface_number (MMKernelDeviceGeneric *self)
-{
-    self->priv->interface_number = (self->priv->interface_sysfs_path ? read_sysfs_property_as_hex (self->priv->interface_sysfs_path, "bInterfaceNumber") : 0x00);
-    mm_dbg ("(%s/%s) interface number (ID_USB_INTERFACE_NUM): 0x%02x",
-            mm_kernel_event_properties_get_subsystem (self->priv->properties),
-            mm_kernel_event_properties_get_name      (self->priv->properties),
-            self->priv->interface_number);
-    g_object_set_data_full (G_OBJECT (self), "ID_USB_INTERFACE_NUM", g_strdup_printf ("%02x", self->priv->interface_number), g_free);
 }
 
 static void
@@ -381,16 +453,9 @@ preload_contents (MMKernelDeviceGeneric *self)
 {
     preload_sysfs_path           (self);
     preload_interface_sysfs_path (self);
-    preload_interface_class      (self);
-    preload_interface_subclass   (self);
-    preload_interface_protocol   (self);
-    preload_interface_number     (self);
+    preload_interface            (self);
     preload_physdev_sysfs_path   (self);
-    preload_manufacturer         (self);
-    preload_product              (self);
-    preload_driver               (self);
-    preload_physdev_vid          (self);
-    preload_physdev_pid          (self);
+    preload_physdev              (self);
 }
 
 /*****************************************************************************/
@@ -463,7 +528,7 @@ kernel_device_get_physdev_vid (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), 0);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_vid;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ? MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->vid : 0);
 }
 
 static guint16
@@ -471,7 +536,7 @@ kernel_device_get_physdev_pid (MMKernelDevice *self)
 {
     g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), 0);
 
-    return MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev_pid;
+    return (MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev ? MM_KERNEL_DEVICE_GENERIC (self)->priv->physdev->pid : 0);
 }
 
 static gboolean
@@ -542,38 +607,43 @@ kernel_device_cmp (MMKernelDevice *a,
 
 static gboolean
 string_match (const gchar *str,
-              const gchar *original_pattern)
+              const gchar *pattern)
 {
-    gchar    *pattern;
-    gchar    *start;
-    gboolean  open_prefix = FALSE;
-    gboolean  open_suffix = FALSE;
-    gboolean  match;
-
-    pattern = g_strdup (original_pattern);
-    start = pattern;
+    gboolean open_prefix = FALSE;
+    gboolean open_suffix = FALSE;
+    gsize    str_len;
+    gsize    len;
 
-    if (start[0] == '*') {
+    if (pattern[0] == '*') {
         open_prefix = TRUE;
-        start++;
+        pattern++;
     }
 
-    if (start[strlen (start) - 1] == '*') {
+    len = strlen (pattern);
+    if (len > 0 && pattern[len - 1] == '*') {
         open_suffix = TRUE;
-        start[strlen (start) - 1] = '\0';
+        len--;
     }
 
+    /* Compare without copying the pattern, this is run for every rule */
+    str_len = strlen (str);
+    if (len > str_len)
+        return FALSE;
+
     if (open_suffix && !open_prefix)
-        match = g_str_has_prefix (str, start);
-    else if (!open_suffix && open_prefix)
-        match = g_str_has_suffix (str, start);
-    else if (open_suffix && open_prefix)
-        match = !!strstr (str, start);
-    else
-        match = g_str_equal (str, start);
-
-    g_free (pattern);
-    return match;
+        return !strncmp (str, pattern, len);
+    if (!open_suffix && open_prefix)
+        return !strncmp (&str[str_len - len], pattern, len);
+    if (open_suffix && open_prefix) {
+        gsize i;
+
+        for (i = 0; i <= str_len - len; i++) {
+            if (!strncmp (&str[i], pattern, len))
+                return TRUE;
+        }
+        return FALSE;
+    }
+    return (len == str_len && !strncmp (str, pattern, len));
 }
 
 static gboolean
@@ -584,33 +654,34 @@ check_condition (MMKernelDeviceGeneric *self,
 
     condition_equal = (match->type == MM_UDEV_RULE_MATCH_TYPE_EQUAL);
 
-    /* We only apply 'add' rules */
-    if (g_str_equal (match->parameter, "ACTION"))
+    switch (match->parameter_id) {
+    case MM_UDEV_RULE_MATCH_PARAMETER_ACTION:
+        /* We only apply 'add' rules */
         return ((!!strstr (match->value, "add")) == condition_equal);
 
-    /* We look for the subsystem string in the whole sysfs path.
-     *
-     * Note that we're not really making a difference between "SUBSYSTEMS"
-     * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
-     * single device is checked), because a lot of the MM udev rules are meant
-     * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
-     * of the single ports. In our case with the custom parsing, we do tag all
-     * independent ports.
-     */
-    if (g_str_equal (match->parameter, "SUBSYSTEMS") || g_str_equal (match->parameter, "SUBSYSTEM"))
+    case MM_UDEV_RULE_MATCH_PARAMETER_SUBSYSTEM:
+        /* We look for the subsystem string in the whole sysfs path.
+         *
+         * Note that we're not really making a difference between "SUBSYSTEMS"
+         * (where the whole device tree is checked) and "SUBSYSTEM" (where just one
+         * single device is checked), because a lot of the MM udev rules are meant
+         * to just tag the physical device (e.g. with ID_MM_DEVICE_IGNORE) instead
+         * of the single ports. In our case with the custom parsing, we do tag all
+         * independent ports.
+         */
         return ((self->priv->sysfs_path && !!strstr (self->priv->sysfs_path, match->value)) == condition_equal);
 
-    /* Exact DRIVER match? We also include the check for DRIVERS, even if we
-     * only apply it to this port driver. */
-    if (g_str_equal (match->parameter, "DRIVER") || g_str_equal (match->parameter, "DRIVERS"))
+    case MM_UDEV_RULE_MATCH_PARAMETER_DRIVER:
+        /* Exact DRIVER match? We also include the check for DRIVERS, even if we
+         * only apply it to this port driver. */
         return ((!g_strcmp0 (match->value, mm_kernel_device_get_driver (MM_KERNEL_DEVICE (self)))) == condition_equal);
 
-    /* Device name checks */
-    if (g_str_equal (match->parameter, "KERNEL"))
+    case MM_UDEV_RULE_MATCH_PARAMETER_KERNEL:
+        /* Device name checks */
         return (string_match (mm_kernel_device_get_name (MM_KERNEL_DEVICE (self)), match->value) == condition_equal);
 
-    /* Device sysfs path checks; we allow both a direct match and a prefix patch */
-    if (g_str_equal (match->parameter, "DEVPATH")) {
+    case MM_UDEV_RULE_MATCH_PARAMETER_DEVPATH: {
+        /* Device sysfs path checks; we allow both a direct match and a prefix patch */
         const gchar *sysfs_path;
         gchar       *prefix_match = NULL;
         gboolean     result = FALSE;
@@ -648,64 +719,44 @@ check_condition (MMKernelDeviceGeneric *self,
         return result;
     }
 
-    /* Attributes checks */
-    if (g_str_has_prefix (match->parameter, "ATTRS")) {
-        gchar    *attribute;
-        gchar    *contents = NULL;
-        gboolean  result = FALSE;
-        guint     val;
-
-        attribute = g_strdup (&match->parameter[5]);
-        g_strdelimit (attribute, "{}", ' ');
-        g_strstrip (attribute);
-
+    /* Attributes checks, values already parsed when loading the rules */
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID:
         /* VID/PID directly from our API */
-        if (g_str_equal (attribute, "idVendor"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_vid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
-        else if (g_str_equal (attribute, "idProduct"))
-            result = ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                      ((mm_kernel_device_get_physdev_pid (MM_KERNEL_DEVICE (self)) == val) == condition_equal));
+        return (match->value_uint_valid &&
+                ((mm_kernel_device_get_physdev_vid (MM_KERNEL_DEVICE (self)) == match->value_uint) == condition_equal));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID:
+        return (match->value_uint_valid &&
+                ((mm_kernel_device_get_physdev_pid (MM_KERNEL_DEVICE (self)) == match->value_uint) == condition_equal));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_MANUFACTURER:
         /* manufacturer in the physdev */
-        else if (g_str_equal (attribute, "manufacturer"))
-            result = ((self->priv->physdev_manufacturer && g_str_equal (self->priv->physdev_manufacturer, match->value)) == condition_equal);
+        return ((self->priv->physdev && !g_strcmp0 (self->priv->physdev->manufacturer, match->value)) == condition_equal);
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT:
         /* product in the physdev */
-        else if (g_str_equal (attribute, "product"))
-            result = ((self->priv->physdev_product && g_str_equal (self->priv->physdev_product, match->value)) == condition_equal);
+        return ((self->priv->physdev && !g_strcmp0 (self->priv->physdev->product, match->value)) == condition_equal);
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS:
         /* interface class/subclass/protocol/number in the interface */
-        else if (g_str_equal (attribute, "bInterfaceClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_class == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceSubClass"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_subclass == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceProtocol"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_protocol == val) == condition_equal)));
-        else if (g_str_equal (attribute, "bInterfaceNumber"))
-            result = (g_str_equal (match->value, "?*") || ((mm_get_uint_from_hex_str (match->value, &val)) &&
-                                                           ((self->priv->interface_number == val) == condition_equal)));
-        else
-            mm_warn ("Unknown attribute: %s", attribute);
-
-        g_free (contents);
-        g_free (attribute);
-        return result;
-    }
-
-    /* Previously set property checks */
-    if (g_str_has_prefix (match->parameter, "ENV")) {
-        gchar    *property;
-        gboolean  result = FALSE;
-
-        property = g_strdup (&match->parameter[3]);
-        g_strdelimit (property, "{}", ' ');
-        g_strstrip (property);
+        return (match->value_any || (match->value_uint_valid &&
+                                     ((self->priv->interface_class == match->value_uint) == condition_equal)));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS:
+        return (match->value_any || (match->value_uint_valid &&
+                                     ((self->priv->interface_subclass == match->value_uint) == condition_equal)));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL:
+        return (match->value_any || (match->value_uint_valid &&
+                                     ((self->priv->interface_protocol == match->value_uint) == condition_equal)));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER:
+        return (match->value_any || (match->value_uint_valid &&
+                                     ((self->priv->interface_number == match->value_uint) == condition_equal)));
+    case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_UNKNOWN:
+        mm_warn ("Unknown attribute: %s", match->parameter_key);
+        return FALSE;
 
-        result = ((!g_strcmp0 ((const gchar *) g_object_get_data (G_OBJECT (self), property), match->value)) == condition_equal);
+    case MM_UDEV_RULE_MATCH_PARAMETER_ENV:
+        /* Previously set property checks */
+        return ((!g_strcmp0 ((const gchar *) g_object_get_data (G_OBJECT (self), match->parameter_key), match->value)) == condition_equal);
 
-        g_free (property);
-        return result;
+    case MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN:
+    default:
+        break;
     }
 
     mm_warn ("Unknown match condition parameter: %s", match->parameter);
@@ -722,6 +773,7 @@ check_rule (MMKernelDeviceGeneric *self,
     g_assert (rule_i < self->priv->rules->len);
 
     rule = &g_array_index (self->priv->rules, MMUdevRule, rule_i);
+    self->priv->n_rules_checked++;
     if (rule->conditions) {
         guint condition_i;
 
@@ -729,6 +781,7 @@ check_rule (MMKernelDeviceGeneric *self,
             MMUdevRuleMatch *match;
 
             match = &g_array_index (rule->conditions, MMUdevRuleMatch, condition_i);
+            self->priv->n_conditions_checked++;
             if (!check_condition (self, match)) {
                 apply = FALSE;
                 break;
@@ -737,18 +790,29 @@ check_rule (MMKernelDeviceGeneric *self,
     }
 
     if (apply) {
+        if (self->priv->applied_rules)
+            g_array_append_val (self->priv->applied_rules, rule_i);
+
         switch (rule->result.type) {
         case MM_UDEV_RULE_RESULT_TYPE_PROPERTY: {
             gchar *property_value_read = NULL;
 
-            if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceClass}"))
+            switch (rule->result.content.property.value_attr) {
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_CLASS:
                 property_value_read = g_strdup_printf ("%02x", self->priv->interface_class);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceSubClass}"))
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_SUBCLASS:
                 property_value_read = g_strdup_printf ("%02x", self->priv->interface_subclass);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceProtocol}"))
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_PROTOCOL:
                 property_value_read = g_strdup_printf ("%02x", self->priv->interface_protocol);
-            else if (g_str_equal (rule->result.content.property.value, "$attr{bInterfaceNumber}"))
+                break;
+            case MM_UDEV_RULE_MATCH_PARAMETER_ATTR_INTERFACE_NUMBER:
                 property_value_read = g_strdup_printf ("%02x", self->priv->interface_number);
+                break;
+            default:
+                break;
+            }
 
             /* add new property */
             mm_dbg ("(%s/%s) property added: %s=%s",
@@ -798,6 +862,9 @@ preload_properties (MMKernelDeviceGeneric *self)
     g_assert (self->priv->rules);
     g_assert (self->priv->rules->len > 0);
 
+    if (rule_tracing)
+        self->priv->applied_rules = g_array_new (FALSE, FALSE, sizeof (guint));
+
     /* Start to process rules */
     i = 0;
     while (i < self->priv->rules->len) {
@@ -909,6 +976,54 @@ mm_kernel_device_generic_new (MMKernelEventProperties  *properties,
     return mm_kernel_device_generic_new_with_rules (properties, rules, error);
 }
 
+MMKernelDevice *
+mm_kernel_device_generic_new_with_contents (MMKernelEventProperties              *properties,
+                                            GArray                               *rules,
+                                            const MMKernelDeviceGenericContents  *contents,
+                                            GError                              **error)
+{
+    g_return_val_if_fail (MM_IS_KERNEL_EVENT_PROPERTIES (properties), NULL);
+    g_return_val_if_fail (rules != NULL, NULL);
+    g_return_val_if_fail (contents != NULL && contents->sysfs_path != NULL, NULL);
+
+    return MM_KERNEL_DEVICE (g_initable_new (MM_TYPE_KERNEL_DEVICE_GENERIC,
+                                             NULL,
+                                             error,
+                                             "properties", properties,
+                                             "rules",      rules,
+                                             "contents",   contents,
+                                             NULL));
+}
+
+/*****************************************************************************/
+
+void
+mm_kernel_device_generic_set_rule_tracing (gboolean enabled)
+{
+    rule_tracing = enabled;
+}
+
+void
+mm_kernel_device_generic_get_rule_stats (MMKernelDeviceGeneric *self,
+                                         guint                 *n_rules_checked,
+                                         guint                 *n_conditions_checked)
+{
+    g_return_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self));
+
+    if (n_rules_checked)
+        *n_rules_checked = self->priv->n_rules_checked;
+    if (n_conditions_checked)
+        *n_conditions_checked = self->priv->n_conditions_checked;
+}
+
+const GArray *
+mm_kernel_device_generic_peek_applied_rules (MMKernelDeviceGeneric *self)
+{
+    g_return_val_if_fail (MM_IS_KERNEL_DEVICE_GENERIC (self), NULL);
+
+    return self->priv->applied_rules;
+}
+
 /*****************************************************************************/
 
 static void
@@ -930,12 +1045,13 @@ set_property (GObject      *object,
     case PROP_PROPERTIES:
         g_assert (!self->priv->properties);
         self->priv->properties = g_value_dup_object (value);
-        check_preload (self);
         break;
     case PROP_RULES:
         g_assert (!self->priv->rules);
         self->priv->rules = g_value_dup_boxed (value);
-        check_preload (self);
+        break;
+    case PROP_CONTENTS:
+        self->priv->contents = g_value_get_pointer (value);
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -958,6 +1074,9 @@ get_property (GObject    *object,
     case PROP_RULES:
         g_value_set_boxed (value, self->priv->rules);
         break;
+    case PROP_CONTENTS:
+        g_value_set_pointer (value, NULL);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -972,6 +1091,10 @@ initable_init (GInitable     *initable,
     MMKernelDeviceGeneric *self = MM_KERNEL_DEVICE_GENERIC (initable);
     const gchar *subsystem;
 
+    /* Once all construct properties are set */
+    check_preload (self);
+    self->priv->contents = NULL;
+
     subsystem = mm_kernel_device_get_subsystem (MM_KERNEL_DEVICE (self));
     if (!subsystem) {
         g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
@@ -1008,12 +1131,12 @@ dispose (GObject *object)
 {
     MMKernelDeviceGeneric *self = MM_KERNEL_DEVICE_GENERIC (object);
 
-    g_clear_pointer (&self->priv->physdev_product,      g_free);
-    g_clear_pointer (&self->priv->physdev_manufacturer, g_free);
+    g_clear_pointer (&self->priv->physdev,              physdev_info_release);
     g_clear_pointer (&self->priv->physdev_sysfs_path,   g_free);
     g_clear_pointer (&self->priv->interface_sysfs_path, g_free);
     g_clear_pointer (&self->priv->sysfs_path,           g_free);
     g_clear_pointer (&self->priv->rules,                g_array_unref);
+    g_clear_pointer (&self->priv->applied_rules,        g_array_unref);
     g_clear_object  (&self->priv->properties);
 
     G_OBJECT_CLASS (mm_kernel_device_generic_parent_class)->dispose (object);
@@ -1067,4 +1190,11 @@ mm_kernel_device_generic_class_init (MMKernelDeviceGenericClass *klass)
                             G_TYPE_ARRAY,
                             G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
     g_object_class_install_property (object_class, PROP_RULES, properties[PROP_RULES]);
+
+    properties[PROP_CONTENTS] =
+        g_param_spec_pointer ("contents",
+                              "Contents",
+                              "Device contents to use instead of reading sysfs",
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+    g_object_class_install_property (object_class, PROP_CONTENTS, properties[PROP_CONTENTS]);
 }
@@ -51,4 +51,34 @@ MMKernelDevice *mm_kernel_device_generic_new_with_rules (MMKernelEventProperties
                                                          GArray                   *rules,
                                                          GError                  **error);
 
+/* For testing and benchmarking the rules: the sysfs contents of the device
+ * are given instead of read from the system */
+typedef struct {
+    const gchar *sysfs_path;
+    /* The USB interface, NULL if none; the physical device is its parent */
+    const gchar *interface_sysfs_path;
+    const gchar *driver;
+    guint8       interface_class;
+    guint8       interface_subclass;
+    guint8       interface_protocol;
+    guint8       interface_number;
+    guint16      vid;
+    guint16      pid;
+    const gchar *manufacturer;
+    const gchar *product;
+} MMKernelDeviceGenericContents;
+
+MMKernelDevice *mm_kernel_device_generic_new_with_contents (MMKernelEventProperties              *properties,
+                                                            GArray                               *rules,
+                                                            const MMKernelDeviceGenericContents  *contents,
+                                                            GError                              **error);
+
+/* Number of rules and conditions evaluated for the device, and the indices of
+ * the rules applied (only recorded while tracing is enabled, NULL otherwise) */
+void          mm_kernel_device_generic_set_rule_tracing   (gboolean enabled);
+void          mm_kernel_device_generic_get_rule_stats     (MMKernelDeviceGeneric *self,
+                                                           guint                 *n_rules_checked,
+                                                           guint                 *n_conditions_checked);
+const GArray *mm_kernel_device_generic_peek_applied_rules (MMKernelDeviceGeneric *self);
+
 #endif /* MM_KERNEL_DEVICE_GENERIC_H */
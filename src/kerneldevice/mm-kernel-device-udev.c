@@ -42,9 +42,100 @@ struct _MMKernelDeviceUdevPrivate {
     guint16      vendor;
     guint16      product;
 
+    /* Resolution shared with the sibling ports */
+    struct _SharedParent *shared;
+
     MMKernelEventProperties *properties;
 };
 
+/*****************************************************************************/
+/* Physical device resolution shared by the ports of a device
+ *
+ * All ports of a device resolve to the same physical device, so the walk up
+ * the sysfs tree, the physdev uid and the vendor/product ids are only
+ * computed once. Ports are grouped by their parent device (e.g. the net and
+ * cdc-wdm ports of a QMI interface, or the ttys of a multi-port interface);
+ * ports under a different parent still walk up, but stop as soon as they
+ * reach a physical device that is already known.
+ *
+ * Entries are reference counted by the ports using them, so they are dropped
+ * once all ports of the physical device are gone.
+ */
+
+typedef struct {
+    guint        ref_count;
+    GUdevDevice *device;
+    const gchar *uid;
+} SharedPhysdev;
+
+typedef struct _SharedParent {
+    guint          ref_count;
+    gchar         *sysfs_path;
+    SharedPhysdev *physdev;
+    gboolean       ids_loaded;
+    gboolean       ids_found;
+    guint16        vendor;
+    guint16        product;
+} SharedParent;
+
+/* physdev sysfs path -> SharedPhysdev */
+static GHashTable *shared_physdevs;
+/* parent sysfs path -> SharedParent */
+static GHashTable *shared_parents;
+
+static SharedPhysdev *
+shared_physdev_get (GUdevDevice *device)
+{
+    SharedPhysdev *physdev;
+    const gchar   *sysfs_path;
+
+    if (G_UNLIKELY (!shared_physdevs))
+        shared_physdevs = g_hash_table_new (g_str_hash, g_str_equal);
+
+    /* Takes ownership of the device reference */
+    sysfs_path = g_udev_device_get_sysfs_path (device);
+    physdev = g_hash_table_lookup (shared_physdevs, sysfs_path);
+    if (physdev) {
+        g_object_unref (device);
+        physdev->ref_count++;
+        return physdev;
+    }
+
+    physdev = g_slice_new0 (SharedPhysdev);
+    physdev->ref_count = 1;
+    physdev->device = device;
+    physdev->uid = g_udev_device_get_property (device, "ID_MM_PHYSDEV_UID");
+    if (!physdev->uid)
+        physdev->uid = sysfs_path;
+    g_hash_table_insert (shared_physdevs, (gpointer) sysfs_path, physdev);
+    return physdev;
+}
+
+static void
+shared_physdev_unref (SharedPhysdev *physdev)
+{
+    if (--physdev->ref_count > 0)
+        return;
+
+    mm_dbg ("Dropping cached physical device '%s'", physdev->uid);
+    g_hash_table_remove (shared_physdevs, g_udev_device_get_sysfs_path (physdev->device));
+    g_object_unref (physdev->device);
+    g_slice_free (SharedPhysdev, physdev);
+}
+
+static void
+shared_parent_unref (SharedParent *parent)
+{
+    if (--parent->ref_count > 0)
+        return;
+
+    g_hash_table_remove (shared_parents, parent->sysfs_path);
+    if (parent->physdev)
+        shared_physdev_unref (parent->physdev);
+    g_free (parent->sysfs_path);
+    g_slice_free (SharedParent, parent);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -153,6 +244,8 @@ out:
     return success;
 }
 
+static void ensure_shared (MMKernelDeviceUdev *self);
+
 static void
 ensure_device_ids (MMKernelDeviceUdev *self)
 {
@@ -162,10 +255,24 @@ ensure_device_ids (MMKernelDeviceUdev *self)
     if (!self->priv->device)
         return;
 
-    if (!get_device_ids (self->priv->device, &self->priv->vendor, &self->priv->product))
-        mm_dbg ("(%s/%s) could not get vendor/product id",
-                g_udev_device_get_subsystem (self->priv->device),
-                g_udev_device_get_name      (self->priv->device));
+    ensure_shared (self);
+    if (self->priv->shared) {
+        SharedParent *shared = self->priv->shared;
+
+        if (!shared->ids_loaded) {
+            shared->ids_found = get_device_ids (self->priv->device, &shared->vendor, &shared->product);
+            shared->ids_loaded = TRUE;
+        }
+        self->priv->vendor = shared->vendor;
+        self->priv->product = shared->product;
+        if (shared->ids_found)
+            return;
+    } else if (get_device_ids (self->priv->device, &self->priv->vendor, &self->priv->product))
+        return;
+
+    mm_dbg ("(%s/%s) could not get vendor/product id",
+            g_udev_device_get_subsystem (self->priv->device),
+            g_udev_device_get_name      (self->priv->device));
 }
 
 /*****************************************************************************/
@@ -191,6 +298,14 @@ find_physical_gudevdevice (GUdevDevice *child)
 
     iter = g_object_ref (child);
     while (iter && i++ < 8) {
+        /* Already resolved by a port under a different parent */
+        if (iter != child &&
+            shared_physdevs &&
+            g_hash_table_contains (shared_physdevs, g_udev_device_get_sysfs_path (iter))) {
+            physdev = iter;
+            break;
+        }
+
         subsys = g_udev_device_get_subsystem (iter);
         if (subsys) {
             if (is_usb || g_str_has_prefix (subsys, "usb")) {
@@ -244,13 +359,73 @@ find_physical_gudevdevice (GUdevDevice *child)
     return physdev;
 }
 
+static void
+ensure_shared (MMKernelDeviceUdev *self)
+{
+    SharedParent *shared;
+    GUdevDevice  *physdev;
+    const gchar  *parent_sysfs_path;
+    const gchar  *name;
+
+    if (self->priv->shared || self->priv->physdev || !self->priv->device)
+        return;
+
+    /* rfcomm ports are their own physical device */
+    name = g_udev_device_get_name (self->priv->device);
+    if (name && strncmp (name, "rfcomm", 6) == 0)
+        return;
+
+    if (!self->priv->parent)
+        self->priv->parent = g_udev_device_get_parent (self->priv->device);
+    if (!self->priv->parent)
+        return;
+
+    parent_sysfs_path = g_udev_device_get_sysfs_path (self->priv->parent);
+    if (shared_parents) {
+        shared = g_hash_table_lookup (shared_parents, parent_sysfs_path);
+        if (shared) {
+            shared->ref_count++;
+            self->priv->shared = shared;
+            return;
+        }
+    }
+
+    physdev = find_physical_gudevdevice (self->priv->device);
+    if (physdev && !g_strcmp0 (g_udev_device_get_sysfs_path (physdev),
+                               g_udev_device_get_sysfs_path (self->priv->device))) {
+        /* A port being its own physical device can't share it with siblings */
+        self->priv->physdev = physdev;
+        return;
+    }
+
+    if (G_UNLIKELY (!shared_parents))
+        shared_parents = g_hash_table_new (g_str_hash, g_str_equal);
+
+    shared = g_slice_new0 (SharedParent);
+    shared->ref_count = 1;
+    shared->sysfs_path = g_strdup (parent_sysfs_path);
+    shared->physdev = (physdev ? shared_physdev_get (physdev) : NULL);
+    g_hash_table_insert (shared_parents, shared->sysfs_path, shared);
+    self->priv->shared = shared;
+}
+
 static void
 ensure_physdev (MMKernelDeviceUdev *self)
 {
+    if (self->priv->physdev || !self->priv->device)
+        return;
+
+    ensure_shared (self);
     if (self->priv->physdev)
         return;
-    if (self->priv->device)
+
+    if (!self->priv->shared) {
         self->priv->physdev = find_physical_gudevdevice (self->priv->device);
+        return;
+    }
+
+    if (self->priv->shared->physdev)
+        self->priv->physdev = g_object_ref (self->priv->shared->physdev->device);
 }
 
 /*****************************************************************************/
@@ -362,6 +537,9 @@ kernel_device_get_physdev_uid (MMKernelDevice *_self)
         if (!self->priv->physdev)
             return NULL;
 
+        if (self->priv->shared && self->priv->shared->physdev)
+            return self->priv->shared->physdev->uid;
+
         uid = g_udev_device_get_property (self->priv->physdev, "ID_MM_PHYSDEV_UID");
         if (!uid)
             uid = g_udev_device_get_sysfs_path (self->priv->physdev);
@@ -727,6 +905,10 @@ dispose (GObject *object)
 {
     MMKernelDeviceUdev *self = MM_KERNEL_DEVICE_UDEV (object);
 
+    if (self->priv->shared) {
+        shared_parent_unref (self->priv->shared);
+        self->priv->shared = NULL;
+    }
     g_clear_object (&self->priv->physdev);
     g_clear_object (&self->priv->parent);
     g_clear_object (&self->priv->device);
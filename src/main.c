@@ -29,17 +29,30 @@
 #include "mm-base-manager.h"
 #include "mm-log.h"
 #include "mm-context.h"
+#include "mm-serial-recorder.h"
+#include "mm-qcdm-log-stream.h"
+#include "mm-poll-scheduler.h"
+#include "mm-loop-monitor.h"
+#include "mm-profiler.h"
+#include "mm-regex-registry.h"
+#include "mm-string-pool.h"
+#include "mm-memory-budget.h"
+#include "mm-status-segment.h"
 
 #if WITH_SUSPEND_RESUME
 # include "mm-sleep-monitor.h"
 #endif
 
-/* Maximum time to wait for all modems to get disabled and removed */
-#define MAX_SHUTDOWN_TIME_SECS 20
-
 static GMainLoop *loop;
 static MMBaseManager *manager;
 
+static gboolean
+shutdown_deadline_cb (gboolean *expired)
+{
+    *expired = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
 static gboolean
 quit_cb (gpointer user_data)
 {
@@ -60,6 +73,15 @@ quit_cb (gpointer user_data)
 static void
 sleeping_cb (MMSleepMonitor *sleep_monitor)
 {
+    /* Nothing runs while sleeping; on resume, the delayed polling runs in
+     * order (registration, signal, bearers) instead of all at once */
+    mm_poll_scheduler_quiesce ();
+
+    if (mm_context_get_keep_modems_on_suspend ()) {
+        mm_dbg ("Keeping devices... (sleeping)");
+        return;
+    }
+
     mm_dbg ("Removing devices... (sleeping)");
     mm_base_manager_shutdown (manager, FALSE);
 }
@@ -67,6 +89,13 @@ sleeping_cb (MMSleepMonitor *sleep_monitor)
 static void
 resuming_cb (MMSleepMonitor *sleep_monitor)
 {
+    mm_poll_scheduler_resume ();
+
+    if (mm_context_get_keep_modems_on_suspend ()) {
+        mm_dbg ("Revalidating devices... (resuming)");
+        return;
+    }
+
     mm_dbg ("Re-scanning (resuming)");
     mm_base_manager_start (manager, FALSE);
 }
@@ -96,6 +125,13 @@ bus_acquired_cb (GDBusConnection *connection,
         g_main_loop_quit (loop);
         return;
     }
+
+    /* The bus is still used even if peers fail to get their socket */
+    if (mm_context_get_peer_socket () &&
+        !mm_base_manager_listen_peers (manager, mm_context_get_peer_socket (), &error)) {
+        mm_warn ("%s", error->message);
+        g_error_free (error);
+    }
 }
 
 static void
@@ -146,17 +182,57 @@ main (int argc, char *argv[])
                        mm_context_get_timestamps (),
                        mm_context_get_relative_timestamps (),
                        mm_context_get_debug (),
+                       mm_context_get_log_fsync_interval (),
                        &err)) {
         g_warning ("Failed to set up logging: %s", err->message);
         g_error_free (err);
         exit (1);
     }
 
+    if (mm_context_get_log_categories () &&
+        !mm_log_set_categories (mm_context_get_log_categories (), &err)) {
+        g_warning ("Failed to set up log categories: %s", err->message);
+        g_error_free (err);
+        exit (1);
+    }
+
+    if (mm_context_get_log_debug_ports ())
+        mm_log_set_debug_ports (mm_context_get_log_debug_ports ());
+
+    mm_memory_budget_init (mm_context_get_constrained ());
+
+    if (mm_context_get_serial_capture_dir ())
+        mm_serial_recorder_set_directory (mm_context_get_serial_capture_dir ());
+
+    if (mm_context_get_qcdm_log_dir () &&
+        !mm_qcdm_log_stream_configure (mm_context_get_qcdm_log_dir (),
+                                       mm_context_get_qcdm_log_codes (),
+                                       &err)) {
+        g_warning ("Failed to set up QCDM log streaming: %s", err->message);
+        g_error_free (err);
+        exit (1);
+    }
+
+    if (mm_context_get_status_segment () &&
+        !mm_status_segment_start (mm_context_get_status_segment (), &err)) {
+        g_warning ("Failed to set up status segment: %s", err->message);
+        g_error_free (err);
+        exit (1);
+    }
+
+    if (mm_context_get_loop_monitor ())
+        mm_loop_monitor_start (mm_context_get_loop_monitor ());
+
+    if (mm_context_get_profile ())
+        mm_profiler_start ();
+
     g_unix_signal_add (SIGTERM, quit_cb, NULL);
     g_unix_signal_add (SIGINT, quit_cb, NULL);
 
     mm_info ("ModemManager (version " MM_DIST_VERSION ") starting in %s bus...",
              mm_context_get_test_session () ? "session" : "system");
+    if (mm_memory_budget_is_constrained ())
+        mm_memory_budget_report ();
 
     /* Acquire name, don't allow replacement */
     name_id = g_bus_own_name (mm_context_get_test_session () ? G_BUS_TYPE_SESSION : G_BUS_TYPE_SYSTEM,
@@ -187,35 +263,47 @@ main (int argc, char *argv[])
     loop = NULL;
 
     if (manager) {
-        GTimer *timer;
+        GMainContext *ctx;
+        gboolean expired = FALSE;
+        guint deadline_id = 0;
 
         mm_base_manager_shutdown (manager, TRUE);
 
         /* Wait for all modems to be disabled and removed, but don't wait
-         * forever: if disabling the modems takes longer than 20s, just
-         * shutdown anyway. */
-        timer = g_timer_new ();
-        while (mm_base_manager_num_modems (manager) &&
-               g_timer_elapsed (timer, NULL) < (gdouble)MAX_SHUTDOWN_TIME_SECS) {
-            GMainContext *ctx = g_main_loop_get_context (inner);
-
-            g_main_context_iteration (ctx, FALSE);
-            g_usleep (50);
-        }
-
-        if (mm_base_manager_num_modems (manager))
+         * forever: if disabling the modems takes longer than the shutdown
+         * timeout, just shutdown anyway. */
+        ctx = g_main_loop_get_context (inner);
+        if (mm_context_get_shutdown_timeout ())
+            deadline_id = g_timeout_add_seconds (mm_context_get_shutdown_timeout (),
+                                                 (GSourceFunc)shutdown_deadline_cb,
+                                                 &expired);
+        else
+            expired = TRUE;
+        while (mm_base_manager_num_modems (manager) && !expired)
+            g_main_context_iteration (ctx, TRUE);
+        if (deadline_id && !expired)
+            g_source_remove (deadline_id);
+
+        if (mm_base_manager_num_modems (manager)) {
             mm_warn ("Disabling modems took too long, "
                      "shutting down with '%u' modems around",
                      mm_base_manager_num_modems (manager));
+            mm_base_manager_report_pending_modems (manager);
+        }
 
         g_object_unref (manager);
-        g_timer_destroy (timer);
     }
 
     g_main_loop_unref (inner);
 
     g_bus_unown_name (name_id);
 
+    mm_status_segment_stop ();
+
+    if (mm_context_get_regex_stats ())
+        mm_regex_registry_report ();
+    mm_string_pool_report ();
+
     mm_info ("ModemManager is shut down");
 
     mm_log_shutdown ();
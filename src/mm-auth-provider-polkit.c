@@ -23,11 +23,21 @@
 
 #include "mm-log.h"
 #include "mm-auth-provider-polkit.h"
+#include "mm-peer-server.h"
 
 G_DEFINE_TYPE (MMAuthProviderPolkit, mm_auth_provider_polkit, MM_TYPE_AUTH_PROVIDER)
 
+/* How long a positive authorization is reused, in microseconds */
+#define AUTHORIZATION_CACHE_TTL_USEC (30 * G_USEC_PER_SEC)
+
 struct _MMAuthProviderPolkitPrivate {
     PolkitAuthority *authority;
+    gulong authority_changed_id;
+    /* Positive decisions: sender unique name -> (action -> expiration time) */
+    GHashTable *cache;
+    /* Bus where senders are watched, to drop their decisions when they go */
+    GDBusConnection *connection;
+    guint name_owner_changed_id;
 };
 
 /*****************************************************************************/
@@ -38,6 +48,109 @@ mm_auth_provider_polkit_new (void)
     return g_object_new (MM_TYPE_AUTH_PROVIDER_POLKIT, NULL);
 }
 
+/*****************************************************************************/
+/* Authorization cache */
+
+static void
+authority_changed (PolkitAuthority *authority,
+                   MMAuthProviderPolkit *self)
+{
+    /* Policies or temporary authorizations changed, nothing can be reused */
+    mm_dbg ("PolicyKit authority changed, flushing authorization cache");
+    g_hash_table_remove_all (self->priv->cache);
+}
+
+static void
+name_owner_changed (GDBusConnection *connection,
+                    const gchar *sender_name,
+                    const gchar *object_path,
+                    const gchar *interface_name,
+                    const gchar *signal_name,
+                    GVariant *parameters,
+                    MMAuthProviderPolkit *self)
+{
+    const gchar *name;
+    const gchar *old_owner;
+    const gchar *new_owner;
+
+    g_variant_get (parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+
+    /* Unique names are never reused, but drop them once gone anyway */
+    if (name[0] == ':' && !new_owner[0])
+        g_hash_table_remove (self->priv->cache, name);
+}
+
+static void
+cache_watch_bus (MMAuthProviderPolkit *self,
+                 GDBusConnection *connection)
+{
+    if (self->priv->connection)
+        return;
+
+    self->priv->connection = g_object_ref (connection);
+    self->priv->name_owner_changed_id =
+        g_dbus_connection_signal_subscribe (connection,
+                                            "org.freedesktop.DBus",
+                                            "org.freedesktop.DBus",
+                                            "NameOwnerChanged",
+                                            "/org/freedesktop/DBus",
+                                            NULL,
+                                            G_DBUS_SIGNAL_FLAGS_NONE,
+                                            (GDBusSignalCallback)name_owner_changed,
+                                            self,
+                                            NULL);
+}
+
+static gboolean
+cache_lookup (MMAuthProviderPolkit *self,
+              const gchar *sender,
+              const gchar *authorization)
+{
+    GHashTable *actions;
+    gint64 *expiration;
+
+    /* Only messages from a bus have a sender */
+    if (!sender)
+        return FALSE;
+
+    actions = g_hash_table_lookup (self->priv->cache, sender);
+    if (!actions)
+        return FALSE;
+
+    expiration = g_hash_table_lookup (actions, authorization);
+    if (!expiration)
+        return FALSE;
+
+    if (g_get_monotonic_time () >= *expiration) {
+        g_hash_table_remove (actions, authorization);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void
+cache_add (MMAuthProviderPolkit *self,
+           const gchar *sender,
+           const gchar *authorization)
+{
+    GHashTable *actions;
+    gint64 *expiration;
+
+    if (!sender)
+        return;
+
+    actions = g_hash_table_lookup (self->priv->cache, sender);
+    if (!actions) {
+        actions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+        g_hash_table_insert (self->priv->cache, g_strdup (sender), actions);
+    }
+
+    expiration = g_new (gint64, 1);
+    *expiration = g_get_monotonic_time () + AUTHORIZATION_CACHE_TTL_USEC;
+    g_hash_table_replace (actions, g_strdup (authorization), expiration);
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -97,10 +210,13 @@ check_authorization_ready (PolkitAuthority *authority,
                                          error->message);
         g_error_free (error);
     } else {
-        if (polkit_authorization_result_get_is_authorized (pk_result))
+        if (polkit_authorization_result_get_is_authorized (pk_result)) {
             /* Good! */
+            cache_add (MM_AUTH_PROVIDER_POLKIT (ctx->self),
+                       g_dbus_method_invocation_get_sender (ctx->invocation),
+                       ctx->authorization);
             g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-        else if (polkit_authorization_result_get_is_challenge (pk_result))
+        } else if (polkit_authorization_result_get_is_challenge (pk_result))
             g_simple_async_result_set_error (ctx->result,
                                              MM_CORE_ERROR,
                                              MM_CORE_ERROR_UNAUTHORIZED,
@@ -118,6 +234,40 @@ check_authorization_ready (PolkitAuthority *authority,
     authorize_context_complete_and_free (ctx);
 }
 
+/* Clients on the bus are identified by their unique name, and peer-to-peer
+ * clients by the credentials of their socket along with the start time of the
+ * process, so that a later process reusing the pid isn't authorized instead */
+static PolkitSubject *
+build_subject (GDBusMethodInvocation *invocation)
+{
+    GDBusConnection *connection;
+    GCredentials *credentials;
+    const gchar *sender;
+    guint64 start_time;
+    pid_t pid;
+    uid_t uid;
+
+    sender = g_dbus_method_invocation_get_sender (invocation);
+    if (sender)
+        return polkit_system_bus_name_new (sender);
+
+    connection = g_dbus_method_invocation_get_connection (invocation);
+    credentials = g_dbus_connection_get_peer_credentials (connection);
+    if (!credentials)
+        return NULL;
+
+    pid = g_credentials_get_unix_pid (credentials, NULL);
+    uid = g_credentials_get_unix_user (credentials, NULL);
+    if (pid == (pid_t) -1 || uid == (uid_t) -1)
+        return NULL;
+
+    start_time = mm_peer_server_get_peer_start_time (connection);
+    if (!start_time)
+        return NULL;
+
+    return polkit_unix_process_new_for_owner (pid, start_time, uid);
+}
+
 static void
 authorize (MMAuthProvider *self,
            GDBusMethodInvocation *invocation,
@@ -128,6 +278,7 @@ authorize (MMAuthProvider *self,
 {
     MMAuthProviderPolkit *polkit = MM_AUTH_PROVIDER_POLKIT (self);
     AuthorizeContext *ctx;
+    PolkitSubject *subject;
 
     /* When creating the object, we actually allowed errors when looking for the
      * authority. If that is the case, we'll just forbid any incoming
@@ -143,6 +294,38 @@ authorize (MMAuthProvider *self,
         return;
     }
 
+    /* Reuse recent positive decisions for the same client */
+    if (cache_lookup (polkit,
+                      g_dbus_method_invocation_get_sender (invocation),
+                      authorization)) {
+        GSimpleAsyncResult *result;
+
+        result = g_simple_async_result_new (G_OBJECT (self),
+                                            callback,
+                                            user_data,
+                                            authorize);
+        g_simple_async_result_set_op_res_gboolean (result, TRUE);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    subject = build_subject (invocation);
+    if (!subject) {
+        g_simple_async_report_error_in_idle (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_UNAUTHORIZED,
+                                             "PolicyKit authorization failed: "
+                                             "unknown peer");
+        return;
+    }
+
+    /* Peers have no bus to watch, and aren't cached */
+    if (g_dbus_method_invocation_get_sender (invocation))
+        cache_watch_bus (polkit, g_dbus_method_invocation_get_connection (invocation));
+
     ctx = g_new (AuthorizeContext, 1);
     ctx->self = g_object_ref (self);
     ctx->invocation = g_object_ref (invocation);
@@ -152,7 +335,7 @@ authorize (MMAuthProvider *self,
                                              callback,
                                              user_data,
                                              authorize);
-    ctx->subject = polkit_system_bus_name_new (g_dbus_method_invocation_get_sender (ctx->invocation));
+    ctx->subject = subject;
 
     polkit_authority_check_authorization (polkit->priv->authority,
                                           ctx->subject,
@@ -175,6 +358,11 @@ mm_auth_provider_polkit_init (MMAuthProviderPolkit *self)
                                               MM_TYPE_AUTH_PROVIDER_POLKIT,
                                               MMAuthProviderPolkitPrivate);
 
+    self->priv->cache = g_hash_table_new_full (g_str_hash,
+                                               g_str_equal,
+                                               g_free,
+                                               (GDestroyNotify)g_hash_table_unref);
+
     self->priv->authority = polkit_authority_get_sync (NULL, &error);
     if (!self->priv->authority) {
         /* NOTE: we failed to create the polkit authority, but we still create
@@ -182,17 +370,45 @@ mm_auth_provider_polkit_init (MMAuthProviderPolkit *self)
         mm_warn ("failed to create PolicyKit authority: '%s'",
                  error ? error->message : "unknown");
         g_clear_error (&error);
+        return;
     }
+
+    self->priv->authority_changed_id = g_signal_connect (self->priv->authority,
+                                                         "changed",
+                                                         G_CALLBACK (authority_changed),
+                                                         self);
 }
 
 static void
 dispose (GObject *object)
 {
-    g_clear_object (&(MM_AUTH_PROVIDER_POLKIT (object)->priv->authority));
+    MMAuthProviderPolkit *self = MM_AUTH_PROVIDER_POLKIT (object);
+
+    if (self->priv->name_owner_changed_id) {
+        g_dbus_connection_signal_unsubscribe (self->priv->connection,
+                                              self->priv->name_owner_changed_id);
+        self->priv->name_owner_changed_id = 0;
+    }
+    g_clear_object (&self->priv->connection);
+
+    if (self->priv->authority_changed_id) {
+        g_signal_handler_disconnect (self->priv->authority,
+                                     self->priv->authority_changed_id);
+        self->priv->authority_changed_id = 0;
+    }
+    g_clear_object (&self->priv->authority);
 
     G_OBJECT_CLASS (mm_auth_provider_polkit_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    g_hash_table_unref (MM_AUTH_PROVIDER_POLKIT (object)->priv->cache);
+
+    G_OBJECT_CLASS (mm_auth_provider_polkit_parent_class)->finalize (object);
+}
+
 static void
 mm_auth_provider_polkit_class_init (MMAuthProviderPolkitClass *class)
 {
@@ -203,6 +419,7 @@ mm_auth_provider_polkit_class_init (MMAuthProviderPolkitClass *class)
 
     /* Virtual methods */
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
     auth_provider_class->authorize = authorize;
     auth_provider_class->authorize_finish = authorize_finish;
 }
@@ -35,9 +35,16 @@
 #include "mm-base-bearer.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
+#include "mm-clock.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
+#include "mm-poll-scheduler.h"
+#include "mm-netlink-stats.h"
+#include "mm-netlink-monitor.h"
 #include "mm-modem-helpers.h"
 #include "mm-bearer-stats.h"
+#include "mm-status-segment.h"
 
 /* We require up to 20s to get a proper IP when using PPP */
 #define BEARER_IP_TIMEOUT_DEFAULT 20
@@ -68,6 +75,13 @@ enum {
 
 static GParamSpec *properties[PROP_LAST];
 
+typedef struct {
+    guint  count;
+    gint64 last;
+    gint64 total;
+    gint64 max;
+} ConnectTimings;
+
 struct _MMBaseBearerPrivate {
     /* The connection to the system bus */
     GDBusConnection *connection;
@@ -106,8 +120,30 @@ struct _MMBaseBearerPrivate {
     MMBearerStats *stats;
     /* Handler id for the stats update timeout */
     guint stats_update_id;
+    /* Whether stats are read from the kernel counters of the interface, and
+     * the values of the counters when the connection started */
+    gboolean stats_from_kernel;
+    guint64 stats_rx_bytes_base;
+    guint64 stats_tx_bytes_base;
     /* Timer to measure the duration of the connection */
     GTimer *duration_timer;
+    /* Watch of the link state of the data interface */
+    guint link_watch_id;
+
+    /* Start of the ongoing connection attempt and time of the last step
+     * reported, both 0 if not connecting */
+    gint64 connect_start;
+    gint64 connect_last_step;
+    /* Steps reported in the ongoing attempt, and their durations */
+    guint connect_steps_reported;
+    gint64 connect_steps[MM_BEARER_CONNECT_STEP_LAST];
+    /* Whether the connection got established and the first stats are still
+     * to be reported */
+    gboolean first_stats_pending;
+    /* Aggregated timings of all the attempts, per step and of the whole
+     * successful connection setups */
+    ConnectTimings connect_timings[MM_BEARER_CONNECT_STEP_LAST];
+    ConnectTimings connect_timings_total;
 };
 
 /*****************************************************************************/
@@ -135,12 +171,150 @@ mm_base_bearer_export (MMBaseBearer *self)
 
 /*****************************************************************************/
 
+static void
+connect_timings_add (ConnectTimings *timings,
+                     gint64 elapsed)
+{
+    timings->count++;
+    timings->last = elapsed;
+    timings->total += elapsed;
+    timings->max = MAX (timings->max, elapsed);
+}
+
+static void
+connect_timings_build (GVariantBuilder *builder,
+                       const gchar *step,
+                       const ConnectTimings *timings)
+{
+    if (!timings->count)
+        return;
+
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (builder, "{sv}", "step", g_variant_new_string (step));
+    g_variant_builder_add (builder, "{sv}", "count", g_variant_new_uint32 (timings->count));
+    g_variant_builder_add (builder, "{sv}", "last", g_variant_new_uint32 ((guint32) (timings->last / 1000)));
+    g_variant_builder_add (builder, "{sv}", "average", g_variant_new_uint32 ((guint32) (timings->total / timings->count / 1000)));
+    g_variant_builder_add (builder, "{sv}", "max", g_variant_new_uint32 ((guint32) (timings->max / 1000)));
+    g_variant_builder_close (builder);
+}
+
+static void
+bearer_update_interface_connect_timings (MMBaseBearer *self)
+{
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (i = 0; i < MM_BEARER_CONNECT_STEP_LAST; i++)
+        connect_timings_build (&builder,
+                               mm_bearer_connect_step_get_string ((MMBearerConnectStep) i),
+                               &self->priv->connect_timings[i]);
+    connect_timings_build (&builder, "total", &self->priv->connect_timings_total);
+    mm_gdbus_bearer_set_connect_timings (MM_GDBUS_BEARER (self), g_variant_builder_end (&builder));
+}
+
+static void
+connect_timings_start (MMBaseBearer *self)
+{
+    self->priv->connect_start = g_get_monotonic_time ();
+    self->priv->connect_last_step = self->priv->connect_start;
+    self->priv->connect_steps_reported = 0;
+    memset (self->priv->connect_steps, 0, sizeof (self->priv->connect_steps));
+    self->priv->first_stats_pending = FALSE;
+}
+
+static void
+connect_timings_finish (MMBaseBearer *self,
+                        gboolean connected)
+{
+    GString *breakdown;
+    gint64 elapsed;
+    guint i;
+
+    if (!self->priv->connect_start)
+        return;
+
+    elapsed = g_get_monotonic_time () - self->priv->connect_start;
+    if (connected) {
+        connect_timings_add (&self->priv->connect_timings_total, elapsed);
+        mm_metric_observe (mm_metrics_histogram ("mm_bearer_connect_duration",
+                                                 "Time taken by the successful connection attempts",
+                                                 NULL, NULL),
+                           elapsed);
+    } else
+        mm_metric_inc (mm_metrics_counter ("mm_bearer_connect_failures",
+                                           "Connection attempts which didn't end up connected",
+                                           NULL, NULL));
+
+    breakdown = g_string_new ("");
+    for (i = 0; i < MM_BEARER_CONNECT_STEP_LAST; i++) {
+        if (!(self->priv->connect_steps_reported & (1 << i)))
+            continue;
+        connect_timings_add (&self->priv->connect_timings[i], self->priv->connect_steps[i]);
+        g_string_append_printf (breakdown, "%s%s: %" G_GINT64_FORMAT "ms",
+                                breakdown->len ? ", " : "",
+                                mm_bearer_connect_step_get_string ((MMBearerConnectStep) i),
+                                self->priv->connect_steps[i] / 1000);
+    }
+    mm_dbg ("Bearer '%s' %s after %" G_GINT64_FORMAT "ms (%s)",
+            self->priv->path,
+            connected ? "connected" : "not connected",
+            elapsed / 1000,
+            breakdown->len ? breakdown->str : "no steps reported");
+    g_string_free (breakdown, TRUE);
+
+    /* Once connected, the first stats are measured since the end of the
+     * connection setup */
+    self->priv->connect_start = 0;
+    self->priv->connect_last_step = connected ? g_get_monotonic_time () : 0;
+    self->priv->first_stats_pending = connected;
+    bearer_update_interface_connect_timings (self);
+}
+
+void
+mm_base_bearer_report_connect_step (MMBaseBearer *self,
+                                    MMBearerConnectStep step)
+{
+    gint64 now;
+    gint64 elapsed;
+
+    g_return_if_fail (step < MM_BEARER_CONNECT_STEP_LAST);
+
+    /* Late reports, e.g. after the attempt got cancelled, are ignored */
+    if (!self->priv->connect_start)
+        return;
+
+    now = g_get_monotonic_time ();
+    elapsed = now - self->priv->connect_last_step;
+    self->priv->connect_last_step = now;
+    self->priv->connect_steps[step] += elapsed;
+    self->priv->connect_steps_reported |= (1 << step);
+    mm_dbg ("Bearer '%s' connection step '%s' finished after %" G_GINT64_FORMAT "ms",
+            self->priv->path,
+            mm_bearer_connect_step_get_string (step),
+            elapsed / 1000);
+}
+
+/*****************************************************************************/
+
 static void
 bearer_update_interface_stats (MMBaseBearer *self)
 {
     mm_gdbus_bearer_set_stats (
         MM_GDBUS_BEARER (self),
         mm_bearer_stats_get_dictionary (self->priv->stats));
+
+    if (self->priv->first_stats_pending) {
+        gint64 elapsed;
+
+        elapsed = g_get_monotonic_time () - self->priv->connect_last_step;
+        self->priv->first_stats_pending = FALSE;
+        self->priv->connect_last_step = 0;
+        connect_timings_add (&self->priv->connect_timings[MM_BEARER_CONNECT_STEP_FIRST_STATS], elapsed);
+        mm_dbg ("Bearer '%s' first stats loaded after %" G_GINT64_FORMAT "ms",
+                self->priv->path, elapsed / 1000);
+        bearer_update_interface_connect_timings (self);
+    }
 }
 
 static void
@@ -161,9 +335,12 @@ bearer_stats_stop (MMBaseBearer *self)
     }
 
     if (self->priv->stats_update_id) {
-        g_source_remove (self->priv->stats_update_id);
+        mm_poll_scheduler_remove (self->priv->stats_update_id);
         self->priv->stats_update_id = 0;
     }
+
+    self->priv->stats_from_kernel = FALSE;
+    self->priv->first_stats_pending = FALSE;
 }
 
 static void
@@ -187,9 +364,45 @@ reload_stats_ready (MMBaseBearer *self,
     bearer_update_interface_stats (self);
 }
 
+static gboolean
+stats_update_from_kernel (MMBaseBearer *self)
+{
+    GError *error = NULL;
+    guint64 rx_bytes = 0;
+    guint64 tx_bytes = 0;
+
+    if (!mm_netlink_stats_get (mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self)),
+                               &rx_bytes,
+                               &tx_bytes,
+                               &error)) {
+        mm_dbg ("Couldn't read kernel stats: %s", error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    /* Counters are reset if the interface is re-created */
+    if (rx_bytes < self->priv->stats_rx_bytes_base || tx_bytes < self->priv->stats_tx_bytes_base) {
+        self->priv->stats_rx_bytes_base = 0;
+        self->priv->stats_tx_bytes_base = 0;
+    }
+
+    mm_bearer_stats_set_duration (self->priv->stats, (guint32) g_timer_elapsed (self->priv->duration_timer, NULL));
+    mm_bearer_stats_set_rx_bytes (self->priv->stats, rx_bytes - self->priv->stats_rx_bytes_base);
+    mm_bearer_stats_set_tx_bytes (self->priv->stats, tx_bytes - self->priv->stats_tx_bytes_base);
+    bearer_update_interface_stats (self);
+    return TRUE;
+}
+
 static gboolean
 stats_update_cb (MMBaseBearer *self)
 {
+    /* Kernel counters are exact and don't need any command to the modem */
+    if (self->priv->stats_from_kernel) {
+        if (stats_update_from_kernel (self))
+            return G_SOURCE_CONTINUE;
+        self->priv->stats_from_kernel = FALSE;
+    }
+
     /* If the implementation knows how to update stat values, run it */
     if (MM_BASE_BEARER_GET_CLASS (self)->reload_stats &&
         MM_BASE_BEARER_GET_CLASS (self)->reload_stats_finish) {
@@ -220,17 +433,72 @@ bearer_stats_start (MMBaseBearer *self)
     g_assert (!self->priv->duration_timer);
     self->priv->duration_timer = g_timer_new ();
 
+    /* Network interfaces have their own counters in the kernel; this
+     * won't work for TTYs, which get their stats from the modem */
+    self->priv->stats_from_kernel = (mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self)) &&
+                                     mm_netlink_stats_get (mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self)),
+                                                           &self->priv->stats_rx_bytes_base,
+                                                           &self->priv->stats_tx_bytes_base,
+                                                           NULL));
+    if (self->priv->stats_from_kernel)
+        mm_dbg ("Bearer stats read from the kernel counters");
+
     /* Schedule */
     g_assert (!self->priv->stats_update_id);
-    self->priv->stats_update_id = g_timeout_add_seconds (BEARER_STATS_UPDATE_TIMEOUT,
-                                                         (GSourceFunc) stats_update_cb,
-                                                         self);
+    self->priv->stats_update_id = mm_poll_scheduler_add_full ("bearer-stats",
+                                                              MM_POLL_SCHEDULER_STAGE_BEARER,
+                                                              BEARER_STATS_UPDATE_TIMEOUT,
+                                                              MM_POLL_SCHEDULER_DEFAULT_SLACK (BEARER_STATS_UPDATE_TIMEOUT),
+                                                              (GSourceFunc) stats_update_cb,
+                                                              self);
     /* Load initial values */
     stats_update_cb (self);
 }
 
 /*****************************************************************************/
 
+static void
+link_lost_cb (const gchar           *ifname,
+              MMNetlinkMonitorEvent  event,
+              MMBaseBearer          *self)
+{
+    /* Losing the link is expected while disconnecting */
+    if (self->priv->status != MM_BEARER_STATUS_CONNECTED)
+        return;
+
+    mm_info ("Bearer '%s' data interface '%s' %s: reporting disconnection",
+             self->priv->path,
+             ifname,
+             event == MM_NETLINK_MONITOR_EVENT_REMOVED ? "removed" : "lost carrier");
+
+    g_object_ref (self);
+    mm_base_bearer_report_connection_status (self, MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
+    g_object_unref (self);
+}
+
+static void
+bearer_link_watch_stop (MMBaseBearer *self)
+{
+    if (self->priv->link_watch_id) {
+        mm_netlink_monitor_unwatch (self->priv->link_watch_id);
+        self->priv->link_watch_id = 0;
+    }
+}
+
+static void
+bearer_link_watch_start (MMBaseBearer *self)
+{
+    /* Only network interfaces have a link the kernel tells us about; for
+     * TTYs this just never gets any event */
+    g_assert (!self->priv->link_watch_id);
+    if (mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self)))
+        self->priv->link_watch_id = mm_netlink_monitor_watch (mm_gdbus_bearer_get_interface (MM_GDBUS_BEARER (self)),
+                                                              (MMNetlinkMonitorFunc) link_lost_cb,
+                                                              self);
+}
+
+/*****************************************************************************/
+
 static void
 bearer_reset_interface_status (MMBaseBearer *self)
 {
@@ -260,9 +528,13 @@ bearer_update_status (MMBaseBearer *self,
      * interface when going into disconnected state. */
     if (self->priv->status == MM_BEARER_STATUS_DISCONNECTED) {
         bearer_reset_interface_status (self);
-        /* Stop statistics */
+        /* Stop statistics and link watch */
         bearer_stats_stop (self);
+        bearer_link_watch_stop (self);
     }
+
+    if (self->priv->modem)
+        mm_status_segment_update_modem (self->priv->modem);
 }
 
 static void
@@ -281,12 +553,16 @@ bearer_update_status_connected (MMBaseBearer *self,
         MM_GDBUS_BEARER (self),
         mm_bearer_ip_config_get_dictionary (ipv6_config));
 
-    /* Start statistics */
+    /* Start statistics and link watch */
     bearer_stats_start (self);
+    bearer_link_watch_start (self);
 
     /* Update the property value */
     self->priv->status = MM_BEARER_STATUS_CONNECTED;
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_STATUS]);
+
+    if (self->priv->modem)
+        mm_status_segment_update_modem (self->priv->modem);
 }
 
 /*****************************************************************************/
@@ -378,9 +654,9 @@ modem_3gpp_registration_state_changed (MMIfaceModem3gpp *modem,
         /* Otherwise, setup the new timeout */
         mm_dbg ("Connected bearer not registered in 3GPP network");
         self->priv->deferred_3gpp_unregistration_id =
-            g_timeout_add_seconds (BEARER_DEFERRED_UNREGISTRATION_TIMEOUT,
-                                   (GSourceFunc) deferred_3gpp_unregistration_cb,
-                                   self);
+            mm_clock_timeout_add_seconds (BEARER_DEFERRED_UNREGISTRATION_TIMEOUT,
+                                          (GSourceFunc) deferred_3gpp_unregistration_cb,
+                                          self);
         return;
     }
 
@@ -457,9 +733,9 @@ modem_cdma_registration_state_changed (MMIfaceModemCdma *modem,
         /* Otherwise, setup the new timeout */
         mm_dbg ("Connected bearer not registered in CDMA network");
         self->priv->deferred_cdma_unregistration_id =
-            g_timeout_add_seconds (BEARER_DEFERRED_UNREGISTRATION_TIMEOUT,
-                                   (GSourceFunc) deferred_cdma_unregistration_cb,
-                                   self);
+            mm_clock_timeout_add_seconds (BEARER_DEFERRED_UNREGISTRATION_TIMEOUT,
+                                          (GSourceFunc) deferred_cdma_unregistration_cb,
+                                          self);
         return;
     }
 
@@ -561,17 +837,15 @@ disconnect_after_cancel_ready (MMBaseBearer *self,
     mm_base_bearer_report_connection_status (self, MM_BEARER_CONNECTION_STATUS_DISCONNECTED);
 }
 
+/* Shared by connect() and adopt(); takes ownership of both result and error */
 static void
-connect_ready (MMBaseBearer *self,
-               GAsyncResult *res,
-               GSimpleAsyncResult *simple)
+connect_complete (MMBaseBearer *self,
+                  MMBearerConnectResult *result,
+                  GError *error,
+                  GSimpleAsyncResult *simple)
 {
-    GError *error = NULL;
     gboolean launch_disconnect = FALSE;
-    MMBearerConnectResult *result;
 
-    /* NOTE: connect() implementations *MUST* handle cancellations themselves */
-    result = MM_BASE_BEARER_GET_CLASS (self)->connect_finish (self, res, &error);
     if (!result) {
         mm_dbg ("Couldn't connect bearer '%s': '%s'",
                 self->priv->path,
@@ -623,11 +897,26 @@ connect_ready (MMBaseBearer *self,
     g_object_unref (simple);
 }
 
+static void
+connect_ready (MMBaseBearer *self,
+               GAsyncResult *res,
+               GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+    MMBearerConnectResult *result;
+
+    /* NOTE: connect() implementations *MUST* handle cancellations themselves */
+    result = MM_BASE_BEARER_GET_CLASS (self)->connect_finish (self, res, &error);
+    connect_timings_finish (self, result && !g_cancellable_is_cancelled (self->priv->connect_cancellable));
+    connect_complete (self, result, error, simple);
+}
+
 void
 mm_base_bearer_connect (MMBaseBearer *self,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
 {
+    MMPortSerialCommandPriority previous;
     GSimpleAsyncResult *result;
 
     g_assert (MM_BASE_BEARER_GET_CLASS (self)->connect != NULL);
@@ -704,13 +993,94 @@ mm_base_bearer_connect (MMBaseBearer *self,
     self->priv->connect_cancellable = g_cancellable_new ();
     bearer_update_status (self, MM_BEARER_STATUS_CONNECTING);
     bearer_reset_interface_stats (self);
+    connect_timings_start (self);
+    /* User request, serve it before any other pending command */
+    previous = mm_base_modem_set_command_priority (self->priv->modem,
+                                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE);
     MM_BASE_BEARER_GET_CLASS (self)->connect (
         self,
         self->priv->connect_cancellable,
         (GAsyncReadyCallback)connect_ready,
         result);
+    mm_base_modem_set_command_priority (self->priv->modem, previous);
+}
+
+/*****************************************************************************/
+/* ADOPT */
+
+gboolean
+mm_base_bearer_adopt_finish (MMBaseBearer *self,
+                             GAsyncResult *res,
+                             GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+static void
+adopt_ready (MMBaseBearer *self,
+             GAsyncResult *res,
+             GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+    MMBearerConnectResult *result;
+
+    /* NOTE: adopt() implementations *MUST* handle cancellations themselves */
+    result = MM_BASE_BEARER_GET_CLASS (self)->adopt_finish (self, res, &error);
+    connect_complete (self, result, error, simple);
+}
+
+void
+mm_base_bearer_adopt (MMBaseBearer *self,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    if (!MM_BASE_BEARER_GET_CLASS (self)->adopt ||
+        !MM_BASE_BEARER_GET_CLASS (self)->adopt_finish) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_UNSUPPORTED,
+            "Adopting existing connections is not supported by this bearer");
+        return;
+    }
+
+    /* Only bearers which were never connected may adopt a connection */
+    if (self->priv->status != MM_BEARER_STATUS_DISCONNECTED) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_WRONG_STATE,
+            "Bearer is not disconnected");
+        return;
+    }
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        mm_base_bearer_adopt);
+
+    /* The connection already exists, so there is no roaming check or connect
+     * timing to do here; a disconnection request while adopting cancels the
+     * operation just like it does with a connection attempt. */
+    mm_dbg ("Adopting existing connection in bearer '%s'", self->priv->path);
+    self->priv->connect_cancellable = g_cancellable_new ();
+    bearer_update_status (self, MM_BEARER_STATUS_CONNECTING);
+    bearer_reset_interface_stats (self);
+    MM_BASE_BEARER_GET_CLASS (self)->adopt (
+        self,
+        self->priv->connect_cancellable,
+        (GAsyncReadyCallback)adopt_ready,
+        result);
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MMBaseBearer *self;
     MMBaseModem *modem;
@@ -735,8 +1105,10 @@ handle_connect_ready (MMBaseBearer *self,
 
     if (!mm_base_bearer_connect_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (self);
         mm_gdbus_bearer_complete_connect (MM_GDBUS_BEARER (self), ctx->invocation);
+    }
 
     handle_connect_context_free (ctx);
 }
@@ -925,8 +1297,10 @@ handle_disconnect_ready (MMBaseBearer *self,
 
     if (!mm_base_bearer_disconnect_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (self);
         mm_gdbus_bearer_complete_disconnect (MM_GDBUS_BEARER (self), ctx->invocation);
+    }
 
     handle_disconnect_context_free (ctx);
 }
@@ -1045,6 +1419,31 @@ mm_base_bearer_get_default_ip_family (MMBaseBearer *self)
     return self->priv->default_ip_family;
 }
 
+gboolean
+mm_base_bearer_supports_concurrent_disconnect (MMBaseBearer *self)
+{
+    return MM_BASE_BEARER_GET_CLASS (self)->concurrent_disconnect;
+}
+
+void
+mm_base_bearer_update_adopted_config (MMBaseBearer *self,
+                                      const gchar *apn,
+                                      MMBearerIpFamily ip_family)
+{
+    MMBearerProperties *config;
+
+    /* Re-setting the config also re-exposes the properties in DBus */
+    config = (self->priv->config ?
+              mm_bearer_properties_dup (self->priv->config) :
+              mm_bearer_properties_new ());
+    if (apn)
+        mm_bearer_properties_set_apn (config, apn);
+    if (ip_family != MM_BEARER_IP_FAMILY_NONE)
+        mm_bearer_properties_set_ip_type (config, ip_family);
+    g_object_set (self, MM_BASE_BEARER_CONFIG, config, NULL);
+    g_object_unref (config);
+}
+
 /*****************************************************************************/
 
 static void
@@ -1247,6 +1646,7 @@ mm_base_bearer_init (MMBaseBearer *self)
                                     mm_bearer_ip_config_get_dictionary (NULL));
     mm_gdbus_bearer_set_ip6_config (MM_GDBUS_BEARER (self),
                                     mm_bearer_ip_config_get_dictionary (NULL));
+    bearer_update_interface_connect_timings (self);
 }
 
 static void
@@ -1265,6 +1665,7 @@ dispose (GObject *object)
     MMBaseBearer *self = MM_BASE_BEARER (object);
 
     bearer_stats_stop (self);
+    bearer_link_watch_stop (self);
     g_clear_object (&self->priv->stats);
 
     if (self->priv->connection) {
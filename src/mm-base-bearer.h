@@ -93,6 +93,16 @@ struct _MMBaseBearerClass {
                                                 GAsyncResult *res,
                                                 GError **error);
 
+    /* Take over a connection already established in the modem, e.g. one
+     * left behind by a previous daemon instance, without tearing it down */
+    void (* adopt) (MMBaseBearer *bearer,
+                    GCancellable *cancellable,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data);
+    MMBearerConnectResult * (* adopt_finish) (MMBaseBearer *bearer,
+                                              GAsyncResult *res,
+                                              GError **error);
+
     /* Disconnect this bearer */
     void (* disconnect) (MMBaseBearer *bearer,
                          GAsyncReadyCallback callback,
@@ -114,6 +124,10 @@ struct _MMBaseBearerClass {
     /* Report connection status of this bearer */
     void (* report_connection_status) (MMBaseBearer *bearer,
                                        MMBearerConnectionStatus status);
+
+    /* Whether disconnect() may run while other bearers of the same modem
+     * are being disconnected as well */
+    gboolean concurrent_disconnect;
 };
 
 GType mm_base_bearer_get_type (void);
@@ -125,6 +139,7 @@ MMBearerStatus      mm_base_bearer_get_status            (MMBaseBearer *self);
 MMBearerProperties *mm_base_bearer_peek_config           (MMBaseBearer *self);
 MMBearerProperties *mm_base_bearer_get_config            (MMBaseBearer *self);
 MMBearerIpFamily    mm_base_bearer_get_default_ip_family (MMBaseBearer *self);
+gboolean            mm_base_bearer_supports_concurrent_disconnect (MMBaseBearer *self);
 
 
 void     mm_base_bearer_connect        (MMBaseBearer *self,
@@ -134,6 +149,19 @@ gboolean mm_base_bearer_connect_finish (MMBaseBearer *self,
                                         GAsyncResult *res,
                                         GError **error);
 
+void     mm_base_bearer_adopt        (MMBaseBearer *self,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data);
+gboolean mm_base_bearer_adopt_finish (MMBaseBearer *self,
+                                      GAsyncResult *res,
+                                      GError **error);
+
+/* Used by adopt() implementations to publish the settings found in the
+ * already established connection */
+void mm_base_bearer_update_adopted_config (MMBaseBearer *self,
+                                           const gchar *apn,
+                                           MMBearerIpFamily ip_family);
+
 void     mm_base_bearer_disconnect        (MMBaseBearer *self,
                                            GAsyncReadyCallback callback,
                                            gpointer user_data);
@@ -146,4 +174,22 @@ void mm_base_bearer_disconnect_force (MMBaseBearer *self);
 void mm_base_bearer_report_connection_status (MMBaseBearer *self,
                                               MMBearerConnectionStatus status);
 
+/* Steps of the connection setup, reported by the implementations as they
+ * finish them. Each step is measured since the previous report, or since
+ * the connection attempt started; steps reported more than once in the same
+ * attempt (e.g. once per IP family) are added up. The first stats are
+ * reported by the base bearer itself. */
+typedef enum { /*< underscore_name=mm_bearer_connect_step >*/
+    MM_BEARER_CONNECT_STEP_PORT_OPEN,
+    MM_BEARER_CONNECT_STEP_CLIENT_ALLOCATION,
+    MM_BEARER_CONNECT_STEP_CONTEXT_SELECTION,
+    MM_BEARER_CONNECT_STEP_DIAL,
+    MM_BEARER_CONNECT_STEP_IP_CONFIG,
+    MM_BEARER_CONNECT_STEP_FIRST_STATS,
+    MM_BEARER_CONNECT_STEP_LAST /*< skip >*/
+} MMBearerConnectStep;
+
+void mm_base_bearer_report_connect_step (MMBaseBearer *self,
+                                         MMBearerConnectStep step);
+
 #endif /* MM_BASE_BEARER_H */
@@ -30,6 +30,7 @@
 #include "mm-iface-modem-voice.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 
@@ -52,6 +53,8 @@ struct _MMBaseCallPrivate {
     MMBaseModem *modem;
     /* The path where the call object is exported */
     gchar *path;
+    /* Index of the call in the modem, 0 if unknown */
+    guint index;
 };
 
 /*****************************************************************************/
@@ -87,6 +90,7 @@ handle_start_ready (MMBaseCall *self,
             /* Update state */
             mm_base_call_change_state (self, MM_CALL_STATE_DIALING, MM_CALL_STATE_REASON_OUTGOING_STARTED);
         }
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_call_complete_start (MM_GDBUS_CALL (ctx->self), ctx->invocation);
     }
 
@@ -189,6 +193,7 @@ handle_accept_ready (MMBaseCall *self,
             /* Update state */
             mm_base_call_change_state (self, MM_CALL_STATE_ACTIVE, MM_CALL_STATE_REASON_ACCEPTED);
         }
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_call_complete_accept (MM_GDBUS_CALL (ctx->self), ctx->invocation);
     }
 
@@ -293,6 +298,7 @@ handle_hangup_ready (MMBaseCall *self,
             /* Update state */
             mm_base_call_change_state (self, MM_CALL_STATE_TERMINATED, MM_CALL_STATE_REASON_TERMINATED);
         }
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_call_complete_hangup (MM_GDBUS_CALL (ctx->self), ctx->invocation);
     }
 
@@ -392,6 +398,7 @@ handle_send_dtmf_ready (MMBaseCall *self,
     if (!MM_BASE_CALL_GET_CLASS (self)->send_dtmf_finish (self, res, &error)) {
         g_dbus_method_invocation_take_error (ctx->invocation, error);
     } else {
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_call_complete_send_dtmf (MM_GDBUS_CALL (ctx->self), ctx->invocation);
     }
 
@@ -540,6 +547,19 @@ mm_base_call_get_path (MMBaseCall *self)
     return self->priv->path;
 }
 
+guint
+mm_base_call_get_index (MMBaseCall *self)
+{
+    return self->priv->index;
+}
+
+void
+mm_base_call_set_index (MMBaseCall *self,
+                        guint index)
+{
+    self->priv->index = index;
+}
+
 void
 mm_base_call_change_state(MMBaseCall *self, MMCallState new_state, MMCallStateReason reason)
 {
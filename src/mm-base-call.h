@@ -100,6 +100,9 @@ MMBaseCall *mm_base_call_new_from_properties (MMBaseModem *modem,
 void         mm_base_call_export         (MMBaseCall *self);
 void         mm_base_call_unexport       (MMBaseCall *self);
 const gchar *mm_base_call_get_path       (MMBaseCall *self);
+guint        mm_base_call_get_index      (MMBaseCall *self);
+void         mm_base_call_set_index      (MMBaseCall *self,
+                                          guint index);
 void         mm_base_call_change_state   (MMBaseCall *self,
                                           MMCallState new_state,
                                           MMCallStateReason reason);
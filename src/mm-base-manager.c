@@ -35,11 +35,26 @@
 #include <mm-gdbus-test.h>
 
 #include "mm-base-manager.h"
+#include "mm-context.h"
 #include "mm-device.h"
+#include "mm-iface-modem.h"
+#include "mm-iface-modem-3gpp.h"
+#include "mm-iface-modem-location.h"
+#include "mm-iface-modem-messaging.h"
+#include "mm-iface-modem-voice.h"
+#include "mm-sms-list.h"
+#include "mm-call-list.h"
+#include "mm-bearer-list.h"
 #include "mm-plugin-manager.h"
 #include "mm-auth.h"
 #include "mm-plugin.h"
 #include "mm-log.h"
+#include "mm-loop-monitor.h"
+#include "mm-metrics.h"
+#include "mm-clock.h"
+#include "mm-profiler.h"
+#include "mm-traffic-capture.h"
+#include "mm-peer-server.h"
 
 static void initable_iface_init (GInitableIface *iface);
 
@@ -75,8 +90,12 @@ struct _MMBaseManagerPrivate {
     MMPluginManager *plugin_manager;
     /* The container of devices being prepared */
     GHashTable *devices;
+    /* Index of the devices by the ports they own */
+    GHashTable *devices_by_port;
     /* The Object Manager server */
     GDBusObjectManagerServer *object_manager;
+    /* Private endpoint for peer-to-peer clients, if any */
+    MMPeerServer *peer_server;
 
     /* The Test interface support */
     MmGdbusTest *test_skeleton;
@@ -84,26 +103,102 @@ struct _MMBaseManagerPrivate {
 #if WITH_UDEV
     /* The UDev client */
     GUdevClient *udev;
+    /* Pending uevents, by physdev uid */
+    GHashTable *uevent_batches;
 #endif
 };
 
 /*****************************************************************************/
 
+/* Ports are indexed by subsystem and name, which is what identifies them
+ * unless they get renamed */
+static gchar *
+build_port_key (MMKernelDevice *port)
+{
+    return g_strdup_printf ("%s/%s",
+                            mm_kernel_device_get_subsystem (port),
+                            mm_kernel_device_get_name (port));
+}
+
+static void
+device_port_grabbed (MMDevice       *device,
+                     MMKernelDevice *port,
+                     MMBaseManager  *self)
+{
+    g_hash_table_insert (self->priv->devices_by_port, build_port_key (port), device);
+}
+
+static void
+device_port_released (MMDevice       *device,
+                      MMKernelDevice *port,
+                      MMBaseManager  *self)
+{
+    gchar *key;
+
+    key = build_port_key (port);
+    if (g_hash_table_lookup (self->priv->devices_by_port, key) == device)
+        g_hash_table_remove (self->priv->devices_by_port, key);
+    g_free (key);
+}
+
+static void
+add_device (MMBaseManager *self,
+            gchar         *physdev_uid,
+            MMDevice      *device)
+{
+    g_signal_connect (device,
+                      MM_DEVICE_PORT_GRABBED,
+                      G_CALLBACK (device_port_grabbed),
+                      self);
+    g_signal_connect (device,
+                      MM_DEVICE_PORT_RELEASED,
+                      G_CALLBACK (device_port_released),
+                      self);
+    /* Takes ownership of both the uid and the device */
+    g_hash_table_insert (self->priv->devices, physdev_uid, device);
+}
+
+static gboolean
+port_index_entry_matches_device (gpointer  key,
+                                 MMDevice *value,
+                                 MMDevice *device)
+{
+    return value == device;
+}
+
+static void
+forget_device (MMBaseManager *self,
+               MMDevice      *device)
+{
+    g_signal_handlers_disconnect_by_func (device, device_port_grabbed, self);
+    g_signal_handlers_disconnect_by_func (device, device_port_released, self);
+    g_hash_table_foreach_remove (self->priv->devices_by_port,
+                                 (GHRFunc)port_index_entry_matches_device,
+                                 device);
+}
+
+static void
+remove_device (MMBaseManager *self,
+               MMDevice      *device)
+{
+    forget_device (self, device);
+    g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+}
+
 static MMDevice *
 find_device_by_modem (MMBaseManager *manager,
                       MMBaseModem *modem)
 {
-    GHashTableIter iter;
-    gpointer key, value;
+    const gchar *uid;
+    MMDevice *device;
 
-    g_hash_table_iter_init (&iter, manager->priv->devices);
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        MMDevice *candidate = MM_DEVICE (value);
+    /* Modems are created with the uid of their device */
+    uid = mm_base_modem_get_device (modem);
+    if (!uid)
+        return NULL;
 
-        if (modem == mm_device_peek_modem (candidate))
-            return candidate;
-    }
-    return NULL;
+    device = g_hash_table_lookup (manager->priv->devices, uid);
+    return ((device && mm_device_peek_modem (device) == modem) ? device : NULL);
 }
 
 static MMDevice *
@@ -112,6 +207,19 @@ find_device_by_port (MMBaseManager  *manager,
 {
     GHashTableIter iter;
     gpointer key, value;
+    MMDevice *device;
+    gchar *port_key;
+
+    port_key = build_port_key (port);
+    device = g_hash_table_lookup (manager->priv->devices_by_port, port_key);
+    g_free (port_key);
+    if (device && mm_device_owns_port (device, port))
+        return device;
+
+    /* Renamed ports are matched by their previous sysfs path, which only the
+     * devices themselves can compare */
+    if (!mm_kernel_device_has_property (port, "DEVPATH_OLD"))
+        return NULL;
 
     g_hash_table_iter_init (&iter, manager->priv->devices);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
@@ -142,16 +250,35 @@ find_device_by_kernel_device (MMBaseManager  *manager,
 typedef struct {
     MMBaseManager *self;
     MMDevice *device;
+    /* When the first port was added */
+    gint64 start;
+    /* Only for devices probed through the Test interface */
+    GDBusMethodInvocation *invocation;
 } FindDeviceSupportContext;
 
 static void
 find_device_support_context_free (FindDeviceSupportContext *ctx)
 {
+    if (ctx->invocation)
+        g_object_unref (ctx->invocation);
     g_object_unref (ctx->self);
     g_object_unref (ctx->device);
     g_slice_free (FindDeviceSupportContext, ctx);
 }
 
+static FindDeviceSupportContext *
+find_device_support_context_new (MMBaseManager *self,
+                                 MMDevice      *device)
+{
+    FindDeviceSupportContext *ctx;
+
+    ctx = g_slice_new0 (FindDeviceSupportContext);
+    ctx->self = g_object_ref (self);
+    ctx->device = g_object_ref (device);
+    ctx->start = g_get_monotonic_time ();
+    return ctx;
+}
+
 static void
 device_support_check_ready (MMPluginManager          *plugin_manager,
                             GAsyncResult             *res,
@@ -162,22 +289,33 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
 
     /* Receive plugin result from the plugin manager */
     plugin = mm_plugin_manager_device_support_check_finish (plugin_manager, res, &error);
+
+    mm_profiler_add (mm_device_get_uid (ctx->device), "Support check",
+                     plugin ? mm_plugin_get_name (plugin) : "unsupported",
+                     ctx->start, g_get_monotonic_time ());
+
     if (!plugin) {
         mm_info ("Couldn't check support for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
-        g_error_free (error);
+        if (ctx->invocation)
+            g_dbus_method_invocation_take_error (ctx->invocation, error);
+        else
+            g_error_free (error);
         find_device_support_context_free (ctx);
         return;
     }
 
     /* Set the plugin as the one expected in the device */
     mm_device_set_plugin (ctx->device, G_OBJECT (plugin));
-    g_object_unref (plugin);
 
     if (!mm_device_create_modem (ctx->device, ctx->self->priv->object_manager, &error)) {
         mm_warn ("Couldn't create modem for device '%s': %s",
                  mm_device_get_uid (ctx->device), error->message);
-        g_error_free (error);
+        if (ctx->invocation)
+            g_dbus_method_invocation_take_error (ctx->invocation, error);
+        else
+            g_error_free (error);
+        g_object_unref (plugin);
         find_device_support_context_free (ctx);
         return;
     }
@@ -185,6 +323,11 @@ device_support_check_ready (MMPluginManager          *plugin_manager,
     /* Modem now created */
     mm_info ("Modem for device '%s' successfully created",
              mm_device_get_uid (ctx->device));
+    if (ctx->invocation)
+        mm_gdbus_test_complete_probe_device (ctx->self->priv->test_skeleton,
+                                             ctx->invocation,
+                                             mm_plugin_get_name (plugin));
+    g_object_unref (plugin);
     find_device_support_context_free (ctx);
 }
 
@@ -215,7 +358,7 @@ device_removed (MMBaseManager  *self,
                 if (mm_plugin_manager_device_support_check_cancel (self->priv->plugin_manager, device))
                     mm_dbg ("Device support check has been cancelled");
                 mm_device_remove_modem (device);
-                g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+                remove_device (self, device);
             }
         }
 
@@ -234,7 +377,7 @@ device_removed (MMBaseManager  *self,
     if (device) {
         mm_dbg ("Removing device '%s'", mm_device_get_uid (device));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        remove_device (self, device);
         return;
     }
 }
@@ -291,14 +434,10 @@ device_added (MMBaseManager  *manager,
 
         /* Keep the device listed in the Manager */
         device = mm_device_new (physdev_uid, hotplugged, FALSE);
-        g_hash_table_insert (manager->priv->devices,
-                             g_strdup (physdev_uid),
-                             device);
+        add_device (manager, g_strdup (physdev_uid), device);
 
         /* Launch device support check */
-        ctx = g_slice_new (FindDeviceSupportContext);
-        ctx->self = g_object_ref (manager);
-        ctx->device = g_object_ref (device);
+        ctx = find_device_support_context_new (manager, device);
         mm_plugin_manager_device_support_check (
             manager->priv->plugin_manager,
             device,
@@ -314,11 +453,23 @@ device_added (MMBaseManager  *manager,
     mm_device_grab_port (device, port);
 }
 
-static gboolean
-handle_kernel_event (MMBaseManager            *self,
-                     MMKernelEventProperties  *properties,
-                     GError                  **error)
+typedef struct {
+    MMKernelDevice *kernel_device;
+    gboolean        add;
+} KernelEvent;
+
+static void
+kernel_event_free (KernelEvent *event)
+{
+    g_object_unref (event->kernel_device);
+    g_slice_free (KernelEvent, event);
+}
+
+static KernelEvent *
+kernel_event_new (MMKernelEventProperties  *properties,
+                  GError                  **error)
 {
+    KernelEvent    *event;
     MMKernelDevice *kernel_device;
     const gchar    *action;
     const gchar    *subsystem;
@@ -362,21 +513,268 @@ handle_kernel_event (MMBaseManager            *self,
 #endif
 
     if (!kernel_device)
-        return FALSE;
+        return NULL;
+
+    event = g_slice_new (KernelEvent);
+    event->kernel_device = kernel_device;
+    event->add = (g_strcmp0 (action, "add") == 0);
+    return event;
+}
 
-    if (g_strcmp0 (action, "add") == 0)
-        device_added (self, kernel_device, TRUE, TRUE);
-    else if (g_strcmp0 (action, "remove") == 0)
-        device_removed (self, kernel_device);
+static void
+kernel_event_process (MMBaseManager *self,
+                      KernelEvent   *event)
+{
+    if (event->add)
+        device_added (self, event->kernel_device, TRUE, TRUE);
     else
-        g_assert_not_reached ();
-    g_object_unref (kernel_device);
+        device_removed (self, event->kernel_device);
+}
+
+static gboolean
+handle_kernel_event (MMBaseManager            *self,
+                     MMKernelEventProperties  *properties,
+                     GError                  **error)
+{
+    KernelEvent *event;
+
+    event = kernel_event_new (properties, error);
+    if (!event)
+        return FALSE;
 
+    kernel_event_process (self, event);
+    kernel_event_free (event);
     return TRUE;
 }
 
+/* Events are processed grouped by physical device, in the order each device
+ * was first seen, and in the original order within each device, so that all
+ * the ports of a device get into it before anything else happens */
+static void
+handle_kernel_events (MMBaseManager *self,
+                      GPtrArray     *events)
+{
+    GHashTable *groups;
+    GPtrArray  *order;
+    guint       i;
+
+    groups = g_hash_table_new (g_str_hash, g_str_equal);
+    order = g_ptr_array_new_with_free_func ((GDestroyNotify) g_ptr_array_unref);
+
+    for (i = 0; i < events->len; i++) {
+        KernelEvent *event;
+        const gchar *physdev_uid;
+        GPtrArray   *group;
+
+        event = g_ptr_array_index (events, i);
+        physdev_uid = mm_kernel_device_get_physdev_uid (event->kernel_device);
+        if (!physdev_uid)
+            physdev_uid = "";
+
+        group = g_hash_table_lookup (groups, physdev_uid);
+        if (!group) {
+            group = g_ptr_array_new ();
+            g_ptr_array_add (order, group);
+            g_hash_table_insert (groups, (gpointer) physdev_uid, group);
+        }
+        g_ptr_array_add (group, event);
+    }
+
+    mm_dbg ("Processing %u kernel events of %u devices", events->len, order->len);
+    for (i = 0; i < order->len; i++) {
+        GPtrArray *group;
+        guint      j;
+
+        group = g_ptr_array_index (order, i);
+        for (j = 0; j < group->len; j++)
+            kernel_event_process (self, g_ptr_array_index (group, j));
+    }
+
+    g_ptr_array_unref (order);
+    g_hash_table_unref (groups);
+}
+
 #if WITH_UDEV
 
+/* Events of the ports of the same physical device are not processed right
+ * away, but once no new events arrive for a short while, so that bursts of
+ * removals and additions (e.g. when a modem reboots or changes its USB
+ * composition) are folded into the final set of changes. */
+#define UEVENT_BATCH_WINDOW_MS 300
+#define UEVENT_BATCH_MAX_MS    2000
+
+typedef struct {
+    gchar *key;
+    /* The first removal seen, if any */
+    MMKernelDevice *removed;
+    /* The last addition, unless removed afterwards */
+    MMKernelDevice *added;
+} PendingPort;
+
+typedef struct {
+    MMBaseManager *self;
+    gchar *physdev_uid;
+    /* PendingPort, in the order the ports were first seen */
+    GPtrArray *ports;
+    gint64 first_event;
+    guint timeout_id;
+} UeventBatch;
+
+static void
+pending_port_free (PendingPort *pending)
+{
+    g_free (pending->key);
+    g_clear_object (&pending->removed);
+    g_clear_object (&pending->added);
+    g_slice_free (PendingPort, pending);
+}
+
+static void
+uevent_batch_free (UeventBatch *batch)
+{
+    if (batch->timeout_id)
+        g_source_remove (batch->timeout_id);
+    g_ptr_array_unref (batch->ports);
+    g_free (batch->physdev_uid);
+    g_slice_free (UeventBatch, batch);
+}
+
+static void
+uevent_batch_process (UeventBatch *batch)
+{
+    guint i;
+
+    /* All removals go first, so that the device gets all the new ports
+     * at once */
+    for (i = 0; i < batch->ports->len; i++) {
+        PendingPort *pending = g_ptr_array_index (batch->ports, i);
+
+        if (pending->removed)
+            device_removed (batch->self, pending->removed);
+    }
+
+    for (i = 0; i < batch->ports->len; i++) {
+        PendingPort *pending = g_ptr_array_index (batch->ports, i);
+
+        if (pending->added)
+            device_added (batch->self, pending->added, TRUE, FALSE);
+    }
+}
+
+static gboolean
+uevent_batch_timeout (UeventBatch *batch)
+{
+    MMBaseManager *self = batch->self;
+
+    batch->timeout_id = 0;
+    mm_dbg ("Processing %u batched port events of device '%s'",
+            batch->ports->len, batch->physdev_uid);
+
+    /* Steal the batch, so that events arriving while processing start a
+     * new one */
+    g_hash_table_steal (self->priv->uevent_batches, batch->physdev_uid);
+    uevent_batch_process (batch);
+    uevent_batch_free (batch);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+uevent_batches_flush (MMBaseManager *self)
+{
+    GHashTableIter iter;
+    UeventBatch *batch;
+
+    g_hash_table_iter_init (&iter, self->priv->uevent_batches);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&batch)) {
+        g_hash_table_iter_steal (&iter);
+        uevent_batch_process (batch);
+        uevent_batch_free (batch);
+        /* Processing may have modified the table */
+        g_hash_table_iter_init (&iter, self->priv->uevent_batches);
+    }
+}
+
+static void
+uevent_batch_add (MMBaseManager  *self,
+                  MMKernelDevice *kernel_device,
+                  gboolean        added)
+{
+    const gchar *physdev_uid;
+    UeventBatch *batch;
+    PendingPort *pending = NULL;
+    gchar *key;
+    gint64 now;
+    guint i;
+
+    /* The physical device may no longer be found for removed ports, but
+     * the device that owns them is known */
+    physdev_uid = mm_kernel_device_get_physdev_uid (kernel_device);
+    if (!physdev_uid && !added) {
+        MMDevice *device;
+
+        device = find_device_by_port (self, kernel_device);
+        if (device)
+            physdev_uid = mm_device_get_uid (device);
+    }
+
+    /* Events that cannot be attributed to a physical device are processed
+     * right away, after all the pending ones */
+    if (!physdev_uid) {
+        uevent_batches_flush (self);
+        if (added)
+            device_added (self, kernel_device, TRUE, FALSE);
+        else
+            device_removed (self, kernel_device);
+        return;
+    }
+
+    now = g_get_monotonic_time ();
+    batch = g_hash_table_lookup (self->priv->uevent_batches, physdev_uid);
+    if (!batch) {
+        batch = g_slice_new0 (UeventBatch);
+        batch->self = self;
+        batch->physdev_uid = g_strdup (physdev_uid);
+        batch->ports = g_ptr_array_new_with_free_func ((GDestroyNotify)pending_port_free);
+        batch->first_event = now;
+        g_hash_table_insert (self->priv->uevent_batches, batch->physdev_uid, batch);
+    }
+
+    key = build_port_key (kernel_device);
+    for (i = 0; i < batch->ports->len; i++) {
+        PendingPort *item = g_ptr_array_index (batch->ports, i);
+
+        if (g_str_equal (item->key, key)) {
+            pending = item;
+            break;
+        }
+    }
+    if (!pending) {
+        pending = g_slice_new0 (PendingPort);
+        pending->key = key;
+        g_ptr_array_add (batch->ports, pending);
+    } else
+        g_free (key);
+
+    if (added) {
+        g_clear_object (&pending->added);
+        pending->added = g_object_ref (kernel_device);
+    } else {
+        /* A port already known before the batch needs to be removed even if
+         * added again afterwards, so that the new one gets probed */
+        if (!pending->removed)
+            pending->removed = g_object_ref (kernel_device);
+        g_clear_object (&pending->added);
+    }
+
+    /* Wait for the burst to finish, but not forever */
+    if (batch->timeout_id)
+        g_source_remove (batch->timeout_id);
+    batch->timeout_id = g_timeout_add (MIN (UEVENT_BATCH_WINDOW_MS,
+                                            MAX (UEVENT_BATCH_MAX_MS - (now - batch->first_event) / 1000, 0)),
+                                       (GSourceFunc)uevent_batch_timeout,
+                                       batch);
+}
+
 static void
 handle_uevent (GUdevClient *client,
                const char *action,
@@ -403,90 +801,115 @@ handle_uevent (GUdevClient *client,
     name = mm_kernel_device_get_name (kernel_device);
     if (   (g_str_equal (action, "add") || g_str_equal (action, "move") || g_str_equal (action, "change"))
         && (!g_str_has_prefix (subsys, "usb") || (name && g_str_has_prefix (name, "cdc-wdm"))))
-        device_added (self, kernel_device, TRUE, FALSE);
+        uevent_batch_add (self, kernel_device, TRUE);
     else if (g_str_equal (action, "remove"))
-        device_removed (self, kernel_device);
+        uevent_batch_add (self, kernel_device, FALSE);
 
     g_object_unref (kernel_device);
 }
 
+/* Ports found in a scan are added grouped by physical device, so that each
+ * device gets all its ports at once and the support checks of all devices
+ * run in parallel */
 typedef struct {
     MMBaseManager *self;
-    GUdevDevice *device;
+    /* MMKernelDevice ports of the same physical device */
+    GPtrArray *ports;
     gboolean manual_scan;
 } StartDeviceAdded;
 
 static gboolean
 start_device_added_idle (StartDeviceAdded *ctx)
 {
-    MMKernelDevice *kernel_device;
+    guint i;
 
-    kernel_device = mm_kernel_device_udev_new (ctx->device);
-    device_added (ctx->self, kernel_device, FALSE, ctx->manual_scan);
-    g_object_unref (kernel_device);
+    for (i = 0; i < ctx->ports->len; i++)
+        device_added (ctx->self, g_ptr_array_index (ctx->ports, i), FALSE, ctx->manual_scan);
 
     g_object_unref (ctx->self);
-    g_object_unref (ctx->device);
+    g_ptr_array_unref (ctx->ports);
     g_slice_free (StartDeviceAdded, ctx);
     return G_SOURCE_REMOVE;
 }
 
 static void
 start_device_added (MMBaseManager *self,
-                    GUdevDevice *device,
-                    gboolean manual_scan)
+                    GPtrArray     *ports,
+                    gboolean       manual_scan)
 {
     StartDeviceAdded *ctx;
 
     ctx = g_slice_new (StartDeviceAdded);
     ctx->self = g_object_ref (self);
-    ctx->device = g_object_ref (device);
+    ctx->ports = g_ptr_array_ref (ports);
     ctx->manual_scan = manual_scan;
     g_idle_add ((GSourceFunc)start_device_added_idle, ctx);
 }
 
 static void
-process_scan (MMBaseManager *self,
-              gboolean       manual_scan)
+scan_subsystem (MMBaseManager *self,
+                const gchar   *subsystem,
+                gboolean       cdc_wdm_only,
+                GHashTable    *groups,
+                GPtrArray     *order)
 {
     GList *devices, *iter;
 
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "tty");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
-
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "net");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
-
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "usb");
+    devices = g_udev_client_query_by_subsystem (self->priv->udev, subsystem);
     for (iter = devices; iter; iter = g_list_next (iter)) {
+        MMKernelDevice *kernel_device;
         const gchar *name;
+        const gchar *physdev_uid;
+        GPtrArray *ports;
 
         name = g_udev_device_get_name (G_UDEV_DEVICE (iter->data));
-        if (name && g_str_has_prefix (name, "cdc-wdm"))
-            start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
+        if (cdc_wdm_only && !(name && g_str_has_prefix (name, "cdc-wdm"))) {
+            g_object_unref (G_OBJECT (iter->data));
+            continue;
+        }
+
+        kernel_device = mm_kernel_device_udev_new (G_UDEV_DEVICE (iter->data));
         g_object_unref (G_OBJECT (iter->data));
+
+        /* Ports without physical device are added on their own */
+        physdev_uid = mm_kernel_device_get_physdev_uid (kernel_device);
+        ports = (physdev_uid ? g_hash_table_lookup (groups, physdev_uid) : NULL);
+        if (!ports) {
+            ports = g_ptr_array_new_with_free_func (g_object_unref);
+            g_ptr_array_add (order, ports);
+            if (physdev_uid)
+                g_hash_table_insert (groups, g_strdup (physdev_uid), ports);
+        }
+        g_ptr_array_add (ports, kernel_device);
     }
     g_list_free (devices);
+}
 
+static void
+process_scan (MMBaseManager *self,
+              gboolean       manual_scan)
+{
+    GHashTable *groups;
+    GPtrArray *order;
+    guint i;
+
+    /* Physdev uid -> ports; owned by the array keeping the order in which
+     * devices were found */
+    groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    order = g_ptr_array_new_with_free_func ((GDestroyNotify)g_ptr_array_unref);
+
+    scan_subsystem (self, "tty", FALSE, groups, order);
+    scan_subsystem (self, "net", FALSE, groups, order);
+    scan_subsystem (self, "usb", TRUE, groups, order);
     /* Newer kernels report 'usbmisc' subsystem */
-    devices = g_udev_client_query_by_subsystem (self->priv->udev, "usbmisc");
-    for (iter = devices; iter; iter = g_list_next (iter)) {
-        const gchar *name;
+    scan_subsystem (self, "usbmisc", TRUE, groups, order);
 
-        name = g_udev_device_get_name (G_UDEV_DEVICE (iter->data));
-        if (name && g_str_has_prefix (name, "cdc-wdm"))
-            start_device_added (self, G_UDEV_DEVICE (iter->data), manual_scan);
-        g_object_unref (G_OBJECT (iter->data));
-    }
-    g_list_free (devices);
+    mm_dbg ("Found %u devices to add", order->len);
+    for (i = 0; i < order->len; i++)
+        start_device_added (self, g_ptr_array_index (order, i), manual_scan);
+
+    g_hash_table_destroy (groups);
+    g_ptr_array_unref (order);
 }
 
 #endif
@@ -497,6 +920,7 @@ process_initial_kernel_events (MMBaseManager *self)
     gchar *contents = NULL;
     gchar *line;
     GError *error = NULL;
+    GPtrArray *events;
 
     if (!self->priv->initial_kernel_events)
         return;
@@ -507,6 +931,7 @@ process_initial_kernel_events (MMBaseManager *self)
         return;
     }
 
+    events = g_ptr_array_new_with_free_func ((GDestroyNotify) kernel_event_free);
     line = contents;
     while (line) {
         gchar *next;
@@ -520,21 +945,28 @@ process_initial_kernel_events (MMBaseManager *self)
         /* ignore empty lines */
         if (line[0] != '\0') {
             MMKernelEventProperties *properties;
+            KernelEvent *event;
 
             properties = mm_kernel_event_properties_new_from_string (line, &error);
             if (!properties) {
                 g_warning ("Couldn't parse line '%s' as initial kernel event %s", line, error->message);
                 g_clear_error (&error);
-            } else if (!handle_kernel_event (self, properties, &error)) {
+            } else if (!(event = kernel_event_new (properties, &error))) {
                 g_warning ("Couldn't process line '%s' as initial kernel event %s", line, error->message);
                 g_clear_error (&error);
-            } else
-                g_debug ("Processed initial kernel event:' %s'", line);
+            } else {
+                g_ptr_array_add (events, event);
+                g_debug ("Loaded initial kernel event:' %s'", line);
+            }
+            if (properties)
+                g_object_unref (properties);
         }
 
         line = next;
     }
 
+    handle_kernel_events (self, events);
+    g_ptr_array_unref (events);
     g_free (contents);
 }
 
@@ -562,22 +994,78 @@ mm_base_manager_start (MMBaseManager *self,
 
 /*****************************************************************************/
 
+/* Modems are all disabled at once on shutdown (or, with --shutdown-radio-off,
+ * just set in low power mode); with --shutdown-modem-timeout, the ones taking
+ * longer than that are removed without waiting for them. */
+
+typedef struct {
+    MMBaseManager *self;
+    MMBaseModem *modem;
+    guint timeout_id;
+    gboolean timed_out;
+} ShutdownModemContext;
+
 static void
-remove_disable_ready (MMBaseModem *modem,
-                      GAsyncResult *res,
-                      MMBaseManager *self)
+shutdown_modem_remove (ShutdownModemContext *ctx)
 {
     MMDevice *device;
 
-    /* We don't care about errors disabling at this point */
-    mm_base_modem_disable_finish (modem, res, NULL);
-
-    device = find_device_by_modem (self, modem);
+    device = find_device_by_modem (ctx->self, ctx->modem);
     if (device) {
-        g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
+        g_cancellable_cancel (mm_base_modem_peek_cancellable (ctx->modem));
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, device);
+        remove_device (ctx->self, device);
+    }
+}
+
+static void
+shutdown_modem_complete (ShutdownModemContext *ctx)
+{
+    if (ctx->timeout_id)
+        g_source_remove (ctx->timeout_id);
+    if (!ctx->timed_out)
+        shutdown_modem_remove (ctx);
+    g_object_unref (ctx->modem);
+    g_slice_free (ShutdownModemContext, ctx);
+}
+
+static gboolean
+shutdown_modem_timeout_cb (ShutdownModemContext *ctx)
+{
+    ctx->timeout_id = 0;
+    ctx->timed_out = TRUE;
+
+    mm_warn ("Modem at '%s' missed its shutdown deadline (%us), removing it",
+             mm_base_modem_get_device (ctx->modem),
+             mm_context_get_shutdown_modem_timeout ());
+    shutdown_modem_remove (ctx);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+radio_off_ready (MMIfaceModem *modem,
+                 GAsyncResult *res,
+                 ShutdownModemContext *ctx)
+{
+    GError *error = NULL;
+
+    /* We don't care much about errors at this point */
+    if (!mm_iface_modem_set_power_state_finish (modem, res, &error)) {
+        mm_dbg ("Couldn't switch the radio off in modem at '%s': %s",
+                mm_base_modem_get_device (ctx->modem), error->message);
+        g_error_free (error);
     }
+    shutdown_modem_complete (ctx);
+}
+
+static void
+remove_disable_ready (MMBaseModem *modem,
+                      GAsyncResult *res,
+                      ShutdownModemContext *ctx)
+{
+    /* We don't care about errors disabling at this point */
+    mm_base_modem_disable_finish (modem, res, NULL);
+    shutdown_modem_complete (ctx);
 }
 
 static void
@@ -586,10 +1074,34 @@ foreach_disable (gpointer key,
                  MMBaseManager *self)
 {
     MMBaseModem *modem;
+    ShutdownModemContext *ctx;
 
     modem = mm_device_peek_modem (device);
-    if (modem)
-        mm_base_modem_disable (modem, (GAsyncReadyCallback)remove_disable_ready, self);
+    if (!modem)
+        return;
+
+    ctx = g_slice_new0 (ShutdownModemContext);
+    ctx->self = self;
+    ctx->modem = g_object_ref (modem);
+    if (mm_context_get_shutdown_modem_timeout ())
+        ctx->timeout_id = g_timeout_add_seconds (mm_context_get_shutdown_modem_timeout (),
+                                                 (GSourceFunc)shutdown_modem_timeout_cb,
+                                                 ctx);
+
+    if (mm_context_get_shutdown_radio_off ()) {
+        /* Modems not exposing the Modem interface have no radio to switch off */
+        if (!MM_IS_IFACE_MODEM (modem)) {
+            shutdown_modem_complete (ctx);
+            return;
+        }
+        mm_iface_modem_set_power_state (MM_IFACE_MODEM (modem),
+                                        MM_MODEM_POWER_STATE_LOW,
+                                        (GAsyncReadyCallback)radio_off_ready,
+                                        ctx);
+        return;
+    }
+
+    mm_base_modem_disable (modem, (GAsyncReadyCallback)remove_disable_ready, ctx);
 }
 
 static gboolean
@@ -603,6 +1115,7 @@ foreach_remove (gpointer key,
     if (modem)
         g_cancellable_cancel (mm_base_modem_peek_cancellable (modem));
     mm_device_remove_modem (device);
+    forget_device (self, device);
     return TRUE;
 }
 
@@ -616,6 +1129,12 @@ mm_base_manager_shutdown (MMBaseManager *self,
     /* Cancel all ongoing auth requests */
     g_cancellable_cancel (self->priv->authp_cancellable);
 
+#if WITH_UDEV
+    /* Forget about pending port events */
+    if (self->priv->uevent_batches)
+        g_hash_table_remove_all (self->priv->uevent_batches);
+#endif
+
     if (disable) {
         g_hash_table_foreach (self->priv->devices, (GHFunc)foreach_disable, self);
 
@@ -630,6 +1149,45 @@ mm_base_manager_shutdown (MMBaseManager *self,
     g_hash_table_foreach_remove (self->priv->devices, (GHRFunc)foreach_remove, self);
 }
 
+void
+mm_base_manager_report_pending_modems (MMBaseManager *self)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_return_if_fail (MM_IS_BASE_MANAGER (self));
+
+    g_hash_table_iter_init (&iter, self->priv->devices);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        MMBaseModem *modem;
+        const gchar *path;
+
+        modem = mm_device_peek_modem (MM_DEVICE (value));
+        if (!modem)
+            continue;
+
+        path = g_dbus_object_get_object_path (G_DBUS_OBJECT (modem));
+        mm_warn ("Modem at '%s' (%s) wasn't disabled before the shutdown deadline",
+                 mm_base_modem_get_device (modem),
+                 path ? path : "not exported");
+    }
+}
+
+gboolean
+mm_base_manager_listen_peers (MMBaseManager *self,
+                              const gchar *socket_path,
+                              GError **error)
+{
+    g_return_val_if_fail (MM_IS_BASE_MANAGER (self), FALSE);
+    g_return_val_if_fail (!self->priv->peer_server, FALSE);
+
+    self->priv->peer_server = mm_peer_server_new (socket_path,
+                                                  G_DBUS_INTERFACE_SKELETON (self),
+                                                  G_DBUS_OBJECT_MANAGER (self->priv->object_manager),
+                                                  error);
+    return !!self->priv->peer_server;
+}
+
 guint32
 mm_base_manager_num_modems (MMBaseManager *self)
 {
@@ -710,27 +1268,731 @@ handle_set_logging (MmGdbusOrgFreedesktopModemManager1 *manager,
 }
 
 /*****************************************************************************/
-/* Manual scan */
+/* Get port stats */
 
 typedef struct {
     MMBaseManager *self;
     GDBusMethodInvocation *invocation;
-} ScanDevicesContext;
+} GetPortStatsContext;
 
 static void
-scan_devices_context_free (ScanDevicesContext *ctx)
+get_port_stats_context_free (GetPortStatsContext *ctx)
 {
     g_object_unref (ctx->invocation);
     g_object_unref (ctx->self);
     g_free (ctx);
 }
 
-static void
-scan_devices_auth_ready (MMAuthProvider *authp,
-                         GAsyncResult *res,
-                         ScanDevicesContext *ctx)
+static GVariant *
+build_port_stats (MMBaseManager *self)
 {
-    GError *error = NULL;
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+
+    g_hash_table_iter_init (&iter, self->priv->devices);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        MMBaseModem *modem;
+        GList *ports, *l;
+
+        modem = mm_device_peek_modem (MM_DEVICE (value));
+        if (!modem)
+            continue;
+
+        ports = mm_base_modem_find_ports (modem, MM_PORT_SUBSYS_UNKNOWN, MM_PORT_TYPE_UNKNOWN, NULL);
+        for (l = ports; l; l = g_list_next (l)) {
+            GVariant *port_stats;
+            GVariantIter port_iter;
+            GVariant *item;
+
+            if (!MM_IS_PORT_SERIAL (l->data))
+                continue;
+
+            port_stats = mm_port_serial_get_stats (MM_PORT_SERIAL (l->data));
+            g_variant_iter_init (&port_iter, port_stats);
+            while ((item = g_variant_iter_next_value (&port_iter)) != NULL) {
+                g_variant_builder_add_value (&builder, item);
+                g_variant_unref (item);
+            }
+            g_variant_unref (port_stats);
+        }
+        g_list_free_full (ports, g_object_unref);
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
+static void
+get_port_stats_auth_ready (MMAuthProvider *authp,
+                           GAsyncResult *res,
+                           GetPortStatsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_port_stats (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            build_port_stats (ctx->self));
+
+    get_port_stats_context_free (ctx);
+}
+
+static gboolean
+handle_get_port_stats (MmGdbusOrgFreedesktopModemManager1 *manager,
+                       GDBusMethodInvocation *invocation)
+{
+    GetPortStatsContext *ctx;
+
+    ctx = g_new0 (GetPortStatsContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_port_stats_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get metrics */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} GetMetricsContext;
+
+static void
+get_metrics_context_free (GetMetricsContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static GVariant *
+build_queue_depths (MMBaseManager *self)
+{
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+
+    g_hash_table_iter_init (&iter, self->priv->devices);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        MMBaseModem *modem;
+        GList *ports, *l;
+
+        modem = mm_device_peek_modem (MM_DEVICE (value));
+        if (!modem)
+            continue;
+
+        ports = mm_base_modem_find_ports (modem, MM_PORT_SUBSYS_UNKNOWN, MM_PORT_TYPE_UNKNOWN, NULL);
+        for (l = ports; l; l = g_list_next (l)) {
+            if (MM_IS_PORT_SERIAL (l->data))
+                g_variant_builder_add (&builder, "{su}",
+                                       mm_port_get_device (MM_PORT (l->data)),
+                                       mm_port_serial_get_queue_length (MM_PORT_SERIAL (l->data)));
+        }
+        g_list_free_full (ports, g_object_unref);
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
+static void
+get_metrics_auth_ready (MMAuthProvider *authp,
+                        GAsyncResult *res,
+                        GetMetricsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else {
+        GVariant *port_stats;
+        GVariant *queue_depths;
+        gchar *metrics;
+
+        port_stats = g_variant_ref_sink (build_port_stats (ctx->self));
+        queue_depths = g_variant_ref_sink (build_queue_depths (ctx->self));
+        metrics = mm_metrics_build (port_stats, queue_depths, mm_log_get_dropped ());
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_metrics (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            metrics);
+        g_free (metrics);
+        g_variant_unref (port_stats);
+        g_variant_unref (queue_depths);
+    }
+
+    get_metrics_context_free (ctx);
+}
+
+static gboolean
+handle_get_metrics (MmGdbusOrgFreedesktopModemManager1 *manager,
+                    GDBusMethodInvocation *invocation)
+{
+    GetMetricsContext *ctx;
+
+    ctx = g_new0 (GetMetricsContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_metrics_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get census */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} GetCensusContext;
+
+static void
+get_census_context_free (GetCensusContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+add_modem_census (MMBaseModem     *modem,
+                  GVariantBuilder *builder)
+{
+    MMSerialReplyCache *cache;
+    const gchar *path;
+    GList *ports, *l;
+    guint64 buffer_bytes = 0;
+    guint64 cache_bytes = 0;
+    guint32 cache_entries = 0;
+    guint32 pending_commands = 0;
+
+    path = g_dbus_object_get_object_path (G_DBUS_OBJECT (modem));
+    if (!path)
+        return;
+
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("{oa{sv}}"));
+    g_variant_builder_add (builder, "o", path);
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+
+    if (MM_IS_IFACE_MODEM (modem)) {
+        MMBearerList *list = NULL;
+
+        g_object_get (modem, MM_IFACE_MODEM_BEARER_LIST, &list, NULL);
+        if (list) {
+            g_variant_builder_add (builder, "{sv}", "bearers",
+                                   g_variant_new_uint32 (mm_bearer_list_get_count (list)));
+            g_object_unref (list);
+        }
+    }
+
+    if (MM_IS_IFACE_MODEM_MESSAGING (modem)) {
+        MMSmsList *list = NULL;
+
+        g_object_get (modem, MM_IFACE_MODEM_MESSAGING_SMS_LIST, &list, NULL);
+        if (list) {
+            g_variant_builder_add (builder, "{sv}", "sms",
+                                   g_variant_new_uint32 (mm_sms_list_get_count (list)));
+            g_variant_builder_add (builder, "{sv}", "sms-parts",
+                                   g_variant_new_uint32 (mm_sms_list_get_n_parts (list)));
+            g_object_unref (list);
+        }
+    }
+
+    if (MM_IS_IFACE_MODEM_VOICE (modem)) {
+        MMCallList *list = NULL;
+
+        g_object_get (modem, MM_IFACE_MODEM_VOICE_CALL_LIST, &list, NULL);
+        if (list) {
+            g_variant_builder_add (builder, "{sv}", "calls",
+                                   g_variant_new_uint32 (mm_call_list_get_count (list)));
+            g_object_unref (list);
+        }
+    }
+
+    if (MM_IS_IFACE_MODEM_LOCATION (modem))
+        g_variant_builder_add (builder, "{sv}", "nmea-bytes",
+                               g_variant_new_uint64 (mm_iface_modem_location_get_nmea_size (MM_IFACE_MODEM_LOCATION (modem))));
+
+    /* The shared cache is accounted once, not per port */
+    cache = mm_base_modem_peek_shared_reply_cache (modem);
+    if (cache) {
+        cache_entries += mm_serial_reply_cache_get_length (cache);
+        cache_bytes += mm_serial_reply_cache_get_size (cache);
+    }
+
+    ports = mm_base_modem_find_ports (modem, MM_PORT_SUBSYS_UNKNOWN, MM_PORT_TYPE_UNKNOWN, NULL);
+    for (l = ports; l; l = g_list_next (l)) {
+        MMPortSerial *port;
+
+        if (!MM_IS_PORT_SERIAL (l->data))
+            continue;
+
+        port = MM_PORT_SERIAL (l->data);
+        buffer_bytes += mm_port_serial_get_buffer_size (port);
+        pending_commands += mm_port_serial_get_queue_length (port);
+        cache = mm_port_serial_peek_reply_cache (port);
+        if (cache) {
+            cache_entries += mm_serial_reply_cache_get_length (cache);
+            cache_bytes += mm_serial_reply_cache_get_size (cache);
+        }
+    }
+    g_list_free_full (ports, g_object_unref);
+
+    g_variant_builder_add (builder, "{sv}", "serial-buffer-bytes", g_variant_new_uint64 (buffer_bytes));
+    g_variant_builder_add (builder, "{sv}", "reply-cache-entries", g_variant_new_uint32 (cache_entries));
+    g_variant_builder_add (builder, "{sv}", "reply-cache-bytes", g_variant_new_uint64 (cache_bytes));
+    g_variant_builder_add (builder, "{sv}", "pending-commands", g_variant_new_uint32 (pending_commands));
+
+    g_variant_builder_close (builder);
+    g_variant_builder_close (builder);
+}
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+static void
+add_type_census (GType            type,
+                 GVariantBuilder *builder,
+                 guint           *n_types)
+{
+    GType *children;
+    guint n_children;
+    guint i;
+    gint count;
+
+    count = g_type_get_instance_count (type);
+    if (count > 0) {
+        g_variant_builder_add (builder, "{su}", g_type_name (type), (guint32) count);
+        (*n_types)++;
+    }
+
+    children = g_type_children (type, &n_children);
+    for (i = 0; i < n_children; i++)
+        add_type_census (children[i], builder, n_types);
+    g_free (children);
+}
+#endif
+
+static GVariant *
+build_census (MMBaseManager *self)
+{
+    GVariantBuilder builder;
+    GVariantBuilder modems;
+    GHashTableIter iter;
+    gpointer value;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+
+    g_variant_builder_init (&modems, G_VARIANT_TYPE ("a{oa{sv}}"));
+    g_hash_table_iter_init (&iter, self->priv->devices);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+        MMBaseModem *modem;
+
+        modem = mm_device_peek_modem (MM_DEVICE (value));
+        if (modem)
+            add_modem_census (modem, &modems);
+    }
+    g_variant_builder_add (&builder, "{sv}", "modems", g_variant_builder_end (&modems));
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+    {
+        GVariantBuilder types;
+        guint n_types = 0;
+
+        /* Instances are only counted with GOBJECT_DEBUG=instance-count */
+        g_variant_builder_init (&types, G_VARIANT_TYPE ("a{su}"));
+        add_type_census (G_TYPE_OBJECT, &types, &n_types);
+        if (n_types > 0)
+            g_variant_builder_add (&builder, "{sv}", "types", g_variant_builder_end (&types));
+        else
+            g_variant_builder_clear (&types);
+    }
+#endif
+
+    return g_variant_builder_end (&builder);
+}
+
+static void
+get_census_auth_ready (MMAuthProvider *authp,
+                       GAsyncResult *res,
+                       GetCensusContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_census (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            build_census (ctx->self));
+
+    get_census_context_free (ctx);
+}
+
+static gboolean
+handle_get_census (MmGdbusOrgFreedesktopModemManager1 *manager,
+                   GDBusMethodInvocation *invocation)
+{
+    GetCensusContext *ctx;
+
+    ctx = g_new0 (GetCensusContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_census_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Capture traffic */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+    gchar *path;
+} CaptureTrafficContext;
+
+static void
+capture_traffic_context_free (CaptureTrafficContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx->path);
+    g_free (ctx);
+}
+
+static void
+capture_traffic_auth_ready (MMAuthProvider *authp,
+                            GAsyncResult *res,
+                            CaptureTrafficContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else {
+        if (!ctx->path[0])
+            mm_traffic_capture_stop ();
+        else if (!mm_traffic_capture_start (ctx->path, &error)) {
+            g_dbus_method_invocation_take_error (ctx->invocation, error);
+            capture_traffic_context_free (ctx);
+            return;
+        }
+        mm_gdbus_org_freedesktop_modem_manager1_complete_capture_traffic (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation);
+    }
+
+    capture_traffic_context_free (ctx);
+}
+
+static gboolean
+handle_capture_traffic (MmGdbusOrgFreedesktopModemManager1 *manager,
+                        GDBusMethodInvocation *invocation,
+                        const gchar *path)
+{
+    CaptureTrafficContext *ctx;
+
+    ctx = g_new0 (CaptureTrafficContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->path = g_strdup (path);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)capture_traffic_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get loop stats */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} GetLoopStatsContext;
+
+static void
+get_loop_stats_context_free (GetLoopStatsContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+get_loop_stats_auth_ready (MMAuthProvider *authp,
+                           GAsyncResult *res,
+                           GetLoopStatsContext *ctx)
+{
+    GError *error = NULL;
+    GVariant *stats;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else if (!(stats = mm_loop_monitor_get_stats ()))
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Main loop monitoring is not enabled");
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_loop_stats (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            stats);
+
+    get_loop_stats_context_free (ctx);
+}
+
+static gboolean
+handle_get_loop_stats (MmGdbusOrgFreedesktopModemManager1 *manager,
+                       GDBusMethodInvocation *invocation)
+{
+    GetLoopStatsContext *ctx;
+
+    ctx = g_new0 (GetLoopStatsContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_loop_stats_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get profile */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} GetProfileContext;
+
+static void
+get_profile_context_free (GetProfileContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+get_profile_auth_ready (MMAuthProvider *authp,
+                        GAsyncResult *res,
+                        GetProfileContext *ctx)
+{
+    GError *error = NULL;
+    GVariant *profile;
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else if (!(profile = mm_profiler_get_profile ()))
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Profiling is not enabled");
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_get_profile (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation,
+            profile);
+
+    get_profile_context_free (ctx);
+}
+
+static gboolean
+handle_get_profile (MmGdbusOrgFreedesktopModemManager1 *manager,
+                    GDBusMethodInvocation *invocation)
+{
+    GetProfileContext *ctx;
+
+    ctx = g_new0 (GetProfileContext, 1);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)get_profile_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Get telemetry */
+
+static void
+add_bearer_telemetry (MMBaseBearer    *bearer,
+                      GVariantBuilder *builder)
+{
+    const gchar *path;
+    GVariant *stats;
+
+    path = mm_base_bearer_get_path (bearer);
+    if (!path)
+        return;
+
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (builder, "{sv}", "path", g_variant_new_object_path (path));
+    g_variant_builder_add (builder, "{sv}", "connected",
+                           g_variant_new_boolean (mm_base_bearer_get_status (bearer) == MM_BEARER_STATUS_CONNECTED));
+    stats = mm_gdbus_bearer_get_stats (MM_GDBUS_BEARER (bearer));
+    if (stats)
+        g_variant_builder_add (builder, "{sv}", "stats", stats);
+    g_variant_builder_close (builder);
+}
+
+static void
+add_modem_telemetry (MMBaseModem     *modem,
+                     GVariantBuilder *builder)
+{
+    MmGdbusModem *skeleton = NULL;
+    MmGdbusModem3gpp *skeleton_3gpp = NULL;
+    MMBearerList *list = NULL;
+    const gchar *path;
+    GVariant *signal_quality;
+
+    /* Modems not exported yet aren't visible to clients either */
+    path = g_dbus_object_get_object_path (G_DBUS_OBJECT (modem));
+    if (!path)
+        return;
+
+    g_object_get (modem,
+                  MM_IFACE_MODEM_DBUS_SKELETON, &skeleton,
+                  MM_IFACE_MODEM_BEARER_LIST,   &list,
+                  NULL);
+    if (!skeleton)
+        goto out;
+
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("{oa{sv}}"));
+    g_variant_builder_add (builder, "o", path);
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+
+    g_variant_builder_add (builder, "{sv}", "state", g_variant_new_int32 (mm_gdbus_modem_get_state (skeleton)));
+    g_variant_builder_add (builder, "{sv}", "access-technologies", g_variant_new_uint32 (mm_gdbus_modem_get_access_technologies (skeleton)));
+    signal_quality = mm_gdbus_modem_get_signal_quality (skeleton);
+    if (signal_quality)
+        g_variant_builder_add (builder, "{sv}", "signal-quality", signal_quality);
+
+    if (MM_IS_IFACE_MODEM_3GPP (modem))
+        g_object_get (modem,
+                      MM_IFACE_MODEM_3GPP_DBUS_SKELETON, &skeleton_3gpp,
+                      NULL);
+    if (skeleton_3gpp) {
+        const gchar *str;
+
+        g_variant_builder_add (builder, "{sv}", "registration-state",
+                               g_variant_new_uint32 (mm_gdbus_modem3gpp_get_registration_state (skeleton_3gpp)));
+        str = mm_gdbus_modem3gpp_get_operator_code (skeleton_3gpp);
+        if (str && str[0])
+            g_variant_builder_add (builder, "{sv}", "operator-code", g_variant_new_string (str));
+        str = mm_gdbus_modem3gpp_get_operator_name (skeleton_3gpp);
+        if (str && str[0])
+            g_variant_builder_add (builder, "{sv}", "operator-name", g_variant_new_string (str));
+        g_object_unref (skeleton_3gpp);
+    }
+
+    if (list) {
+        GVariantBuilder bearers;
+
+        g_variant_builder_init (&bearers, G_VARIANT_TYPE ("aa{sv}"));
+        mm_bearer_list_foreach (list, (MMBearerListForeachFunc)add_bearer_telemetry, &bearers);
+        g_variant_builder_add (builder, "{sv}", "bearers", g_variant_builder_end (&bearers));
+    }
+
+    g_variant_builder_close (builder);
+    g_variant_builder_close (builder);
+
+out:
+    g_clear_object (&skeleton);
+    g_clear_object (&list);
+}
+
+static GVariant *
+build_telemetry (MMBaseManager *self)
+{
+    GVariantBuilder builder;
+    GHashTableIter iter;
+    gpointer value;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{oa{sv}}"));
+
+    g_hash_table_iter_init (&iter, self->priv->devices);
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+        MMBaseModem *modem;
+
+        modem = mm_device_peek_modem (MM_DEVICE (value));
+        if (modem)
+            add_modem_telemetry (modem, &builder);
+    }
+
+    return g_variant_builder_end (&builder);
+}
+
+static gboolean
+handle_get_telemetry (MmGdbusOrgFreedesktopModemManager1 *manager,
+                      GDBusMethodInvocation *invocation)
+{
+    /* Everything in the snapshot is readable through the modem properties
+     * already, so no authorization is required */
+    mm_gdbus_org_freedesktop_modem_manager1_complete_get_telemetry (
+        manager,
+        invocation,
+        build_telemetry (MM_BASE_MANAGER (manager)));
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Manual scan */
+
+typedef struct {
+    MMBaseManager *self;
+    GDBusMethodInvocation *invocation;
+} ScanDevicesContext;
+
+static void
+scan_devices_context_free (ScanDevicesContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void
+scan_devices_auth_ready (MMAuthProvider *authp,
+                         GAsyncResult *res,
+                         ScanDevicesContext *ctx)
+{
+    GError *error = NULL;
 
     if (!mm_auth_provider_authorize_finish (authp, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
@@ -775,6 +2037,7 @@ handle_scan_devices (MmGdbusOrgFreedesktopModemManager1 *manager,
 typedef struct {
     MMBaseManager *self;
     GDBusMethodInvocation *invocation;
+    /* a{sv}, or aa{sv} when reporting several events */
     GVariant *dictionary;
 } ReportKernelEventContext;
 
@@ -826,6 +2089,85 @@ out:
     report_kernel_event_context_free (ctx);
 }
 
+static void
+report_kernel_events_auth_ready (MMAuthProvider           *authp,
+                                 GAsyncResult             *res,
+                                 ReportKernelEventContext *ctx)
+{
+    GError       *error = NULL;
+    GPtrArray    *events;
+    GVariantIter  iter;
+    GVariant     *dictionary;
+
+    events = g_ptr_array_new_with_free_func ((GDestroyNotify) kernel_event_free);
+
+    if (!mm_auth_provider_authorize_finish (authp, res, &error))
+        goto out;
+
+#if WITH_UDEV
+    if (ctx->self->priv->auto_scan) {
+        error = g_error_new_literal (MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED,
+                                     "Cannot report kernel events: "
+                                     "udev monitoring already in place");
+        goto out;
+    }
+#endif
+
+    /* Nothing is processed unless all the events are valid */
+    g_variant_iter_init (&iter, ctx->dictionary);
+    while (!error && (dictionary = g_variant_iter_next_value (&iter)) != NULL) {
+        MMKernelEventProperties *properties;
+        KernelEvent             *event;
+
+        properties = mm_kernel_event_properties_new_from_dictionary (dictionary, &error);
+        if (properties) {
+            event = kernel_event_new (properties, &error);
+            if (event)
+                g_ptr_array_add (events, event);
+            g_object_unref (properties);
+        }
+        if (error)
+            g_prefix_error (&error, "Invalid kernel event #%u: ", events->len);
+        g_variant_unref (dictionary);
+    }
+    if (error)
+        goto out;
+
+    handle_kernel_events (ctx->self, events);
+
+out:
+    if (error)
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else
+        mm_gdbus_org_freedesktop_modem_manager1_complete_report_kernel_events (
+            MM_GDBUS_ORG_FREEDESKTOP_MODEM_MANAGER1 (ctx->self),
+            ctx->invocation);
+
+    g_ptr_array_unref (events);
+    report_kernel_event_context_free (ctx);
+}
+
+static gboolean
+handle_report_kernel_events (MmGdbusOrgFreedesktopModemManager1 *manager,
+                             GDBusMethodInvocation *invocation,
+                             GVariant *events)
+{
+    ReportKernelEventContext *ctx;
+
+    ctx = g_slice_new0 (ReportKernelEventContext);
+    ctx->self = g_object_ref (manager);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->dictionary = g_variant_ref (events);
+
+    mm_auth_provider_authorize (ctx->self->priv->authp,
+                                invocation,
+                                MM_AUTHORIZATION_MANAGER_CONTROL,
+                                ctx->self->priv->authp_cancellable,
+                                (GAsyncReadyCallback)report_kernel_events_auth_ready,
+                                ctx);
+    return TRUE;
+}
+
 static gboolean
 handle_report_kernel_event (MmGdbusOrgFreedesktopModemManager1 *manager,
                             GDBusMethodInvocation *invocation,
@@ -868,7 +2210,7 @@ handle_set_profile (MmGdbusTest *skeleton,
     /* Create device and keep it listed in the Manager */
     physdev_uid = g_strdup_printf ("/virtual/%s", id);
     device = mm_device_new (physdev_uid, TRUE, TRUE);
-    g_hash_table_insert (self->priv->devices, physdev_uid, device);
+    add_device (self, physdev_uid, device);
 
     /* Grab virtual ports */
     mm_device_virtual_grab_ports (device, (const gchar **)ports);
@@ -902,7 +2244,7 @@ out:
 
     if (error) {
         mm_device_remove_modem (device);
-        g_hash_table_remove (self->priv->devices, mm_device_get_uid (device));
+        remove_device (self, device);
         g_dbus_method_invocation_return_gerror (invocation, error);
         g_error_free (error);
     } else
@@ -911,6 +2253,139 @@ out:
     return TRUE;
 }
 
+/*****************************************************************************/
+/* Test device probing */
+
+static gboolean
+handle_probe_device (MmGdbusTest *skeleton,
+                     GDBusMethodInvocation *invocation,
+                     const gchar *id,
+                     const gchar *const *ports,
+                     MMBaseManager *self)
+{
+    FindDeviceSupportContext *ctx;
+    MMDevice *device;
+    gchar *physdev_uid;
+    guint i;
+
+    if (!ports || !ports[0]) {
+        g_dbus_method_invocation_return_error (invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_INVALID_ARGS,
+                                               "No ports given");
+        return TRUE;
+    }
+
+    physdev_uid = g_strdup_printf ("/virtual/%s", id);
+    if (find_device_by_physdev_uid (self, physdev_uid)) {
+        g_dbus_method_invocation_return_error (invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_EXISTS,
+                                               "Device '%s' already exists",
+                                               physdev_uid);
+        g_free (physdev_uid);
+        return TRUE;
+    }
+
+    mm_info ("Test device probing: '%s'", id);
+
+    /* The timings of the support check are reported in the profile */
+    if (!mm_profiler_is_running ())
+        mm_profiler_start ();
+
+    /* Same as for the first port of a real device, but the ports are virtual
+     * so they're not subject to the udev candidate tags */
+    device = mm_device_new (physdev_uid, TRUE, FALSE);
+    add_device (self, physdev_uid, device);
+
+    ctx = find_device_support_context_new (self, device);
+    ctx->invocation = g_object_ref (invocation);
+    mm_plugin_manager_device_support_check (self->priv->plugin_manager,
+                                            device,
+                                            (GAsyncReadyCallback) device_support_check_ready,
+                                            ctx);
+
+    for (i = 0; ports[i]; i++) {
+        GError                  *error = NULL;
+        MMKernelDevice          *kernel_device;
+        MMKernelEventProperties *properties;
+
+        properties = mm_kernel_event_properties_new ();
+        mm_kernel_event_properties_set_action (properties, "add");
+        mm_kernel_event_properties_set_subsystem (properties, "virtual");
+        mm_kernel_event_properties_set_name (properties, ports[i]);
+        mm_kernel_event_properties_set_uid (properties, mm_device_get_uid (device));
+
+        kernel_device = mm_kernel_device_generic_new (properties, &error);
+        if (!kernel_device) {
+            mm_warn ("Could not add port (virtual/%s): '%s'", ports[i], error->message);
+            g_error_free (error);
+        } else {
+            mm_device_grab_port (device, kernel_device);
+            g_object_unref (kernel_device);
+        }
+        g_object_unref (properties);
+    }
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Test virtual clock */
+
+static gboolean
+handle_enable_virtual_clock (MmGdbusTest *skeleton,
+                             GDBusMethodInvocation *invocation,
+                             MMBaseManager *self)
+{
+    mm_info ("Test virtual clock enabled");
+    mm_clock_enable_virtual ();
+    mm_gdbus_test_complete_enable_virtual_clock (skeleton, invocation);
+    return TRUE;
+}
+
+typedef struct {
+    MmGdbusTest *skeleton;
+    GDBusMethodInvocation *invocation;
+} AdvanceClockContext;
+
+static void
+advance_clock_ready (GObject *source,
+                     GAsyncResult *res,
+                     AdvanceClockContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_clock_advance_finish (res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else
+        mm_gdbus_test_complete_advance_clock (ctx->skeleton, ctx->invocation);
+
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->skeleton);
+    g_slice_free (AdvanceClockContext, ctx);
+}
+
+static gboolean
+handle_advance_clock (MmGdbusTest *skeleton,
+                      GDBusMethodInvocation *invocation,
+                      guint64 milliseconds,
+                      guint settle,
+                      MMBaseManager *self)
+{
+    AdvanceClockContext *ctx;
+
+    ctx = g_slice_new0 (AdvanceClockContext);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+
+    mm_clock_advance ((gint64) MIN (milliseconds, G_MAXINT64 / 1000) * 1000,
+                      settle,
+                      (GAsyncReadyCallback)advance_clock_ready,
+                      ctx);
+    return TRUE;
+}
+
 /*****************************************************************************/
 
 MMBaseManager *
@@ -1031,6 +2506,7 @@ mm_base_manager_init (MMBaseManager *manager)
 
     /* Setup internal lists of device objects */
     priv->devices = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    priv->devices_by_port = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 #if WITH_UDEV
     {
@@ -1038,6 +2514,10 @@ mm_base_manager_init (MMBaseManager *manager)
 
         /* Setup UDev client */
         priv->udev = g_udev_client_new (subsys);
+        priv->uevent_batches = g_hash_table_new_full (g_str_hash,
+                                                      g_str_equal,
+                                                      NULL,
+                                                      (GDestroyNotify)uevent_batch_free);
     }
 #endif
 
@@ -1055,6 +2535,34 @@ mm_base_manager_init (MMBaseManager *manager)
                       "handle-set-logging",
                       G_CALLBACK (handle_set_logging),
                       NULL);
+    g_signal_connect (manager,
+                      "handle-get-port-stats",
+                      G_CALLBACK (handle_get_port_stats),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-get-metrics",
+                      G_CALLBACK (handle_get_metrics),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-get-census",
+                      G_CALLBACK (handle_get_census),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-capture-traffic",
+                      G_CALLBACK (handle_capture_traffic),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-get-loop-stats",
+                      G_CALLBACK (handle_get_loop_stats),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-get-profile",
+                      G_CALLBACK (handle_get_profile),
+                      NULL);
+    g_signal_connect (manager,
+                      "handle-get-telemetry",
+                      G_CALLBACK (handle_get_telemetry),
+                      NULL);
     g_signal_connect (manager,
                       "handle-scan-devices",
                       G_CALLBACK (handle_scan_devices),
@@ -1063,6 +2571,10 @@ mm_base_manager_init (MMBaseManager *manager)
                       "handle-report-kernel-event",
                       G_CALLBACK (handle_report_kernel_event),
                       NULL);
+    g_signal_connect (manager,
+                      "handle-report-kernel-events",
+                      G_CALLBACK (handle_report_kernel_events),
+                      NULL);
 }
 
 static gboolean
@@ -1101,6 +2613,18 @@ initable_init (GInitable *initable,
                           "handle-set-profile",
                           G_CALLBACK (handle_set_profile),
                           initable);
+        g_signal_connect (priv->test_skeleton,
+                          "handle-probe-device",
+                          G_CALLBACK (handle_probe_device),
+                          initable);
+        g_signal_connect (priv->test_skeleton,
+                          "handle-enable-virtual-clock",
+                          G_CALLBACK (handle_enable_virtual_clock),
+                          initable);
+        g_signal_connect (priv->test_skeleton,
+                          "handle-advance-clock",
+                          G_CALLBACK (handle_advance_clock),
+                          initable);
         if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (priv->test_skeleton),
                                                priv->connection,
                                                MM_DBUS_PATH,
@@ -1116,13 +2640,22 @@ static void
 finalize (GObject *object)
 {
     MMBaseManagerPrivate *priv = MM_BASE_MANAGER (object)->priv;
+    GHashTableIter iter;
+    gpointer value;
 
     g_free (priv->initial_kernel_events);
     g_free (priv->plugin_dir);
 
+    /* Devices may outlive the manager */
+    g_hash_table_iter_init (&iter, priv->devices);
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        forget_device (MM_BASE_MANAGER (object), MM_DEVICE (value));
+    g_hash_table_destroy (priv->devices_by_port);
     g_hash_table_destroy (priv->devices);
 
 #if WITH_UDEV
+    if (priv->uevent_batches)
+        g_hash_table_destroy (priv->uevent_batches);
     if (priv->udev)
         g_object_unref (priv->udev);
 #endif
@@ -1130,6 +2663,9 @@ finalize (GObject *object)
     if (priv->plugin_manager)
         g_object_unref (priv->plugin_manager);
 
+    if (priv->peer_server)
+        mm_peer_server_free (priv->peer_server);
+
     if (priv->object_manager)
         g_object_unref (priv->object_manager);
 
@@ -1145,6 +2681,9 @@ finalize (GObject *object)
     if (priv->authp_cancellable)
         g_object_unref (priv->authp_cancellable);
 
+    /* Flush whatever was captured */
+    mm_traffic_capture_stop ();
+
     G_OBJECT_CLASS (mm_base_manager_parent_class)->finalize (object);
 }
 
@@ -64,4 +64,12 @@ void             mm_base_manager_shutdown    (MMBaseManager *manager,
 
 guint32          mm_base_manager_num_modems  (MMBaseManager *manager);
 
+/* Warns about the modems still around when giving up on shutdown */
+void             mm_base_manager_report_pending_modems (MMBaseManager *manager);
+
+/* Exports the manager and modems also in a private peer-to-peer socket */
+gboolean         mm_base_manager_listen_peers (MMBaseManager *manager,
+                                               const gchar *socket_path,
+                                               GError **error);
+
 #endif /* MM_BASE_MANAGER_H */
@@ -20,6 +20,41 @@
 
 #include "mm-base-modem-at.h"
 #include "mm-errors-types.h"
+#include "mm-context.h"
+#include "mm-metrics.h"
+#include "mm-log.h"
+#include "mm-modem-helpers.h"
+
+/* Allocations of the per-command contexts, only counted in debug mode so that
+ * leaks and per-command costs can be checked through the metrics */
+typedef enum {
+    AT_CONTEXT_SEQUENCE,
+    AT_CONTEXT_COMMAND,
+    AT_CONTEXT_LAST
+} AtContextType;
+
+static void
+at_context_count (AtContextType type,
+                  gboolean      allocated)
+{
+    static const gchar *type_names[AT_CONTEXT_LAST] = { "sequence", "command" };
+    static MMMetric    *metrics[AT_CONTEXT_LAST][2];
+
+    if (!mm_context_get_debug ())
+        return;
+
+    if (!metrics[type][allocated]) {
+        if (allocated)
+            metrics[type][allocated] = mm_metrics_counter ("mm_at_context_allocations",
+                                                           "AT command contexts allocated (debug mode only)",
+                                                           "type", type_names[type]);
+        else
+            metrics[type][allocated] = mm_metrics_counter ("mm_at_context_frees",
+                                                           "AT command contexts freed (debug mode only)",
+                                                           "type", type_names[type]);
+    }
+    mm_metric_inc (metrics[type][allocated]);
+}
 
 static gboolean
 abort_async_if_port_unusable (MMBaseModem *self,
@@ -98,6 +133,11 @@ typedef struct {
     GCancellable *user_cancellable;
     const MMBaseModemAtCommand *current;
     const MMBaseModemAtCommand *sequence;
+    /* Steps sent in the concatenated command in flight, if any */
+    guint batch_len;
+    /* Steps before this one are not to be concatenated again */
+    const MMBaseModemAtCommand *no_batch_until;
+    MMPortSerialCommandPriority priority;
     GSimpleAsyncResult *simple;
     gpointer response_processor_context;
     GDestroyNotify response_processor_context_free;
@@ -127,7 +167,8 @@ at_sequence_context_free (AtSequenceContext *ctx)
         g_variant_unref (ctx->result);
     if (ctx->simple)
         g_object_unref (ctx->simple);
-    g_free (ctx);
+    g_slice_free (AtSequenceContext, ctx);
+    at_context_count (AT_CONTEXT_SEQUENCE, FALSE);
 }
 
 GVariant *
@@ -152,32 +193,64 @@ mm_base_modem_at_sequence_full_finish (MMBaseModem *self,
     return ctx->result;
 }
 
+/* Maximum number of sequence steps sent in a single concatenated command */
+#define AT_SEQUENCE_BATCH_MAX 8
+
+static void at_sequence_run_current (AtSequenceContext *ctx);
+
 static void
-at_sequence_parse_response (MMPortSerialAt *port,
-                            GAsyncResult *res,
-                            AtSequenceContext *ctx)
+at_sequence_complete (AtSequenceContext *ctx,
+                      GVariant *result)
 {
-    GVariant *result = NULL;
-    GError *result_error = NULL;
-    gboolean continue_sequence;
     GSimpleAsyncResult *simple;
-    const gchar *response;
-    GError *error = NULL;
 
-    response = mm_port_serial_at_command_finish (port, res, &error);
+    /* If we got a response, set it as result */
+    if (result)
+        /* transfer-full */
+        ctx->result = result;
 
-    /* Cancelled? */
-    if (g_cancellable_is_cancelled (ctx->cancellable)) {
-        g_simple_async_result_set_error (ctx->simple,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_CANCELLED,
-                                         "AT sequence was cancelled");
-        if (error)
-            g_error_free (error);
-        g_simple_async_result_complete (ctx->simple);
-        at_sequence_context_free (ctx);
-        return;
-    }
+    /* Set the whole context as result, in order to pass the response
+     * processor context during finish(). We do remove the simple async result
+     * from the context as well, so that we control its last unref. */
+    simple = ctx->simple;
+    ctx->simple = NULL;
+    g_simple_async_result_set_op_res_gpointer (
+        simple,
+        ctx,
+        (GDestroyNotify)at_sequence_context_free);
+
+    /* And complete. The whole context is owned by the result, and it will
+     * be freed when completed. */
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static gboolean
+at_sequence_complete_if_cancelled (AtSequenceContext *ctx)
+{
+    if (!g_cancellable_is_cancelled (ctx->cancellable))
+        return FALSE;
+
+    g_simple_async_result_set_error (ctx->simple,
+                                     MM_CORE_ERROR,
+                                     MM_CORE_ERROR_CANCELLED,
+                                     "AT sequence was cancelled");
+    g_simple_async_result_complete (ctx->simple);
+    at_sequence_context_free (ctx);
+    return TRUE;
+}
+
+/* Process the response of the current command. Returns TRUE if the sequence
+ * goes on with the next command, FALSE if it got completed (and the context
+ * freed). */
+static gboolean
+at_sequence_process_response (AtSequenceContext *ctx,
+                              const gchar *response,
+                              const GError *error)
+{
+    GVariant *result = NULL;
+    GError *result_error = NULL;
+    gboolean continue_sequence;
 
     if (!ctx->current->response_processor)
         /* No need to process response, go on to next command */
@@ -201,54 +274,225 @@ at_sequence_parse_response (MMPortSerialAt *port,
             g_simple_async_result_take_error (ctx->simple, result_error);
             g_simple_async_result_complete (ctx->simple);
             at_sequence_context_free (ctx);
-            if (error)
-                g_error_free (error);
-            return;
+            return FALSE;
         }
     }
 
-    if (error)
-        g_error_free (error);
-
     if (continue_sequence) {
         g_assert (result == NULL);
         ctx->current++;
-        if (ctx->current->command) {
-            /* Schedule the next command in the probing group */
-            mm_port_serial_at_command (
-                ctx->port,
-                ctx->current->command,
-                ctx->current->timeout,
-                FALSE,
-                ctx->current->allow_cached,
-                ctx->cancellable,
-                (GAsyncReadyCallback)at_sequence_parse_response,
-                ctx);
-            return;
-        }
+        if (ctx->current->command)
+            return TRUE;
 
         /* On last command, end. */
     }
 
-    /* If we got a response, set it as result */
-    if (result)
-        /* transfer-full */
-        ctx->result = result;
+    at_sequence_complete (ctx, result);
+    return FALSE;
+}
 
-    /* Set the whole context as result, in order to pass the response
-     * processor context during finish(). We do remove the simple async result
-     * from the context as well, so that we control its last unref. */
-    simple = ctx->simple;
-    ctx->simple = NULL;
-    g_simple_async_result_set_op_res_gpointer (
-        simple,
-        ctx,
-        (GDestroyNotify)at_sequence_context_free);
+static void
+at_sequence_parse_response (MMPortSerialAt *port,
+                            GAsyncResult *res,
+                            AtSequenceContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+    gboolean continue_sequence;
 
-    /* And complete. The whole context is owned by the result, and it will
-     * be freed when completed. */
-    g_simple_async_result_complete (simple);
-    g_object_unref (simple);
+    response = mm_port_serial_at_command_finish (port, res, &error);
+
+    /* Cancelled? */
+    if (at_sequence_complete_if_cancelled (ctx)) {
+        if (error)
+            g_error_free (error);
+        return;
+    }
+
+    continue_sequence = at_sequence_process_response (ctx, response, error);
+    if (error)
+        g_error_free (error);
+
+    if (continue_sequence)
+        /* Schedule the next command in the probing group */
+        at_sequence_run_current (ctx);
+}
+
+/*****************************************************************************/
+/* AT sequence concatenation
+ *
+ * When the modem supports it, consecutive read-only steps of a sequence
+ * (extended syntax queries like "+CREG?" or tests like "+CGDCONT=?") are
+ * sent as a single V.250 concatenated command, e.g. "+CREG?;+CGREG?;+CSQ?".
+ * Those commands reply with lines prefixed with the command name, which is
+ * what allows splitting the concatenated reply back into per-step responses.
+ * If the concatenated command fails, or if the reply cannot be attributed
+ * unambiguously, the steps are just run one by one as usual.
+ */
+
+/* Returns the length of the command name (e.g. "+CREG") if the step can be
+ * concatenated, 0 otherwise. */
+static gsize
+at_sequence_batchable_name_length (const MMBaseModemAtCommand *command)
+{
+    if (!command->command || command->allow_cached)
+        return 0;
+
+    return mm_at_command_get_concatenable_name_length (command->command);
+}
+
+static const gchar *
+at_sequence_command_name (const MMBaseModemAtCommand *command)
+{
+    return (g_ascii_strncasecmp (command->command, "AT", 2) == 0 ?
+            command->command + 2 :
+            command->command);
+}
+
+/* Number of steps from the current one which can be sent together */
+static guint
+at_sequence_batch_length (AtSequenceContext *ctx)
+{
+    guint n;
+
+    if (!mm_base_modem_get_at_concatenation (ctx->self) ||
+        ctx->current < ctx->no_batch_until)
+        return 0;
+
+    for (n = 0; n < AT_SEQUENCE_BATCH_MAX && ctx->current[n].command; n++) {
+        gsize name_len;
+        guint i;
+
+        name_len = at_sequence_batchable_name_length (&ctx->current[n]);
+        if (!name_len)
+            break;
+
+        /* Don't mix several commands with the same name in the same batch, as
+         * their replies could not be told apart */
+        for (i = 0; i < n; i++) {
+            if (at_sequence_batchable_name_length (&ctx->current[i]) == name_len &&
+                g_ascii_strncasecmp (at_sequence_command_name (&ctx->current[i]),
+                                     at_sequence_command_name (&ctx->current[n]),
+                                     name_len) == 0)
+                break;
+        }
+        if (i < n)
+            break;
+    }
+
+    return (n >= 2 ? n : 0);
+}
+
+/* Commands of the steps in the concatenated command in flight */
+static const gchar **
+at_sequence_batch_commands (AtSequenceContext *ctx)
+{
+    const gchar **commands;
+    guint i;
+
+    commands = g_new (const gchar *, ctx->batch_len);
+    for (i = 0; i < ctx->batch_len; i++)
+        commands[i] = ctx->current[i].command;
+    return commands;
+}
+
+static void
+at_sequence_batch_ready (MMPortSerialAt *port,
+                         GAsyncResult *res,
+                         AtSequenceContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+    gchar **responses = NULL;
+    gboolean continue_sequence = TRUE;
+    guint batch_len;
+    guint i;
+
+    response = mm_port_serial_at_command_finish (port, res, &error);
+
+    /* Cancelled? */
+    if (at_sequence_complete_if_cancelled (ctx)) {
+        if (error)
+            g_error_free (error);
+        return;
+    }
+
+    batch_len = ctx->batch_len;
+    if (!error) {
+        const gchar **commands;
+
+        commands = at_sequence_batch_commands (ctx);
+        responses = mm_at_concatenated_response_split (response, commands, batch_len);
+        g_free (commands);
+    }
+
+    if (!responses) {
+        if (error) {
+            mm_dbg ("Concatenated AT command failed, running steps one by one: %s", error->message);
+            g_error_free (error);
+        } else
+            mm_dbg ("Couldn't split concatenated AT command response, running steps one by one");
+
+        ctx->no_batch_until = ctx->current + batch_len;
+        ctx->batch_len = 0;
+        at_sequence_run_current (ctx);
+        return;
+    }
+
+    ctx->batch_len = 0;
+    for (i = 0; i < batch_len && continue_sequence; i++)
+        /* Once the sequence is completed, the remaining responses are ignored */
+        continue_sequence = at_sequence_process_response (ctx, responses[i], NULL);
+    g_strfreev (responses);
+
+    if (continue_sequence)
+        at_sequence_run_current (ctx);
+}
+
+static void
+at_sequence_run_current (AtSequenceContext *ctx)
+{
+    guint batch_len;
+
+    batch_len = at_sequence_batch_length (ctx);
+    if (batch_len) {
+        const gchar **commands;
+        gchar *command;
+        guint timeout = 0;
+        guint i;
+
+        ctx->batch_len = batch_len;
+        for (i = 0; i < batch_len; i++)
+            timeout += ctx->current[i].timeout;
+        commands = at_sequence_batch_commands (ctx);
+        command = mm_at_commands_concatenate (commands, batch_len);
+        g_free (commands);
+
+        mm_port_serial_at_command_full (
+            ctx->port,
+            command,
+            timeout,
+            FALSE,
+            FALSE,
+            ctx->priority,
+            ctx->cancellable,
+            (GAsyncReadyCallback)at_sequence_batch_ready,
+            ctx);
+        g_free (command);
+        return;
+    }
+
+    /* Never use cached replies for the first command in the sequence.
+     * Sequence commands are sent over and over, so use the shared bytes. */
+    mm_port_serial_at_command_interned (
+        ctx->port,
+        ctx->current->command,
+        ctx->current->timeout,
+        ctx->current == ctx->sequence ? FALSE : ctx->current->allow_cached,
+        ctx->priority,
+        ctx->cancellable,
+        (GAsyncReadyCallback)at_sequence_parse_response,
+        ctx);
 }
 
 void
@@ -263,12 +507,16 @@ mm_base_modem_at_sequence_full (MMBaseModem *self,
 {
     AtSequenceContext *ctx;
 
+    /* Commands for a connected primary port go to the secondary one */
+    port = mm_base_modem_route_at_port (self, port);
+
     /* Ensure that we have an open port */
     if (!abort_async_if_port_unusable (self, port, callback, user_data))
         return;
 
     /* Setup context */
-    ctx = g_new0 (AtSequenceContext, 1);
+    ctx = g_slice_new0 (AtSequenceContext);
+    at_context_count (AT_CONTEXT_SEQUENCE, TRUE);
     ctx->self = g_object_ref (self);
     ctx->port = g_object_ref (port);
     ctx->simple = g_simple_async_result_new (G_OBJECT (self),
@@ -276,6 +524,7 @@ mm_base_modem_at_sequence_full (MMBaseModem *self,
                                              user_data,
                                              mm_base_modem_at_sequence_full);
     ctx->current = ctx->sequence = sequence;
+    ctx->priority = mm_base_modem_get_command_priority (self);
     ctx->response_processor_context = response_processor_context;
     ctx->response_processor_context_free = response_processor_context_free;
 
@@ -296,15 +545,7 @@ mm_base_modem_at_sequence_full (MMBaseModem *self,
     }
 
     /* Go on with the first one in the sequence */
-    mm_port_serial_at_command (
-        ctx->port,
-        ctx->current->command,
-        ctx->current->timeout,
-        FALSE,
-        FALSE,
-        ctx->cancellable,
-        (GAsyncReadyCallback)at_sequence_parse_response,
-        ctx);
+    at_sequence_run_current (ctx);
 }
 
 GVariant *
@@ -457,7 +698,8 @@ at_command_context_free (AtCommandContext *ctx)
     g_object_unref (ctx->port);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
-    g_free (ctx);
+    g_slice_free (AtCommandContext, ctx);
+    at_context_count (AT_CONTEXT_COMMAND, FALSE);
 }
 
 const gchar *
@@ -517,11 +759,15 @@ mm_base_modem_at_command_full (MMBaseModem *self,
 {
     AtCommandContext *ctx;
 
+    /* Commands for a connected primary port go to the secondary one */
+    port = mm_base_modem_route_at_port (self, port);
+
     /* Ensure that we have an open port */
     if (!abort_async_if_port_unusable (self, port, callback, user_data))
         return;
 
-    ctx = g_new0 (AtCommandContext, 1);
+    ctx = g_slice_new0 (AtCommandContext);
+    at_context_count (AT_CONTEXT_COMMAND, TRUE);
     ctx->self = g_object_ref (self);
     ctx->port = g_object_ref (port);
     ctx->result = g_simple_async_result_new (G_OBJECT (self),
@@ -546,12 +792,13 @@ mm_base_modem_at_command_full (MMBaseModem *self,
     }
 
     /* Go on with the command */
-    mm_port_serial_at_command (
+    mm_port_serial_at_command_full (
         port,
         command,
         timeout,
         is_raw,
         allow_cached,
+        mm_base_modem_get_command_priority (self),
         ctx->cancellable,
         (GAsyncReadyCallback)at_command_ready,
         ctx);
@@ -571,6 +818,7 @@ _at_command (MMBaseModem *self,
              guint timeout,
              gboolean allow_cached,
              gboolean is_raw,
+             gboolean any_port,
              GAsyncReadyCallback callback,
              gpointer user_data)
 {
@@ -578,7 +826,9 @@ _at_command (MMBaseModem *self,
     GError *error = NULL;
 
     /* No port given, so we'll try to guess which is best */
-    port = mm_base_modem_peek_best_at_port (self, &error);
+    port = (any_port ?
+            mm_base_modem_peek_least_loaded_at_port (self, &error) :
+            mm_base_modem_peek_best_at_port (self, &error));
     if (!port) {
         g_assert (error != NULL);
         g_simple_async_report_take_gerror_in_idle (G_OBJECT (self),
@@ -607,7 +857,18 @@ mm_base_modem_at_command (MMBaseModem *self,
                           GAsyncReadyCallback callback,
                           gpointer user_data)
 {
-    _at_command (self, command, timeout, allow_cached, FALSE, callback, user_data);
+    _at_command (self, command, timeout, allow_cached, FALSE, FALSE, callback, user_data);
+}
+
+void
+mm_base_modem_at_command_any_port (MMBaseModem *self,
+                                   const gchar *command,
+                                   guint timeout,
+                                   gboolean allow_cached,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data)
+{
+    _at_command (self, command, timeout, allow_cached, FALSE, TRUE, callback, user_data);
 }
 
 void
@@ -618,5 +879,5 @@ mm_base_modem_at_command_raw (MMBaseModem *self,
                               GAsyncReadyCallback callback,
                               gpointer user_data)
 {
-    _at_command (self, command, timeout, allow_cached, TRUE, callback, user_data);
+    _at_command (self, command, timeout, allow_cached, TRUE, FALSE, callback, user_data);
 }
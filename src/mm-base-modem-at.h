@@ -145,6 +145,15 @@ void mm_base_modem_at_command_raw            (MMBaseModem *self,
                                               gboolean allow_cached,
                                               GAsyncReadyCallback callback,
                                               gpointer user_data);
+/* Like mm_base_modem_at_command(), for commands which don't change any state
+ * and which may therefore run in whichever AT port has less commands
+ * queued. Commands configuring the modem or its URCs must not use this. */
+void mm_base_modem_at_command_any_port       (MMBaseModem *self,
+                                              const gchar *command,
+                                              guint timeout,
+                                              gboolean allow_cached,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data);
 const gchar *mm_base_modem_at_command_finish (MMBaseModem *self,
                                               GAsyncResult *res,
                                               GError **error);
@@ -47,6 +47,7 @@ enum {
     PROP_PRODUCT_ID,
     PROP_CONNECTION,
     PROP_REPROBE,
+    PROP_AT_CONCATENATION,
     PROP_LAST
 };
 
@@ -73,14 +74,25 @@ struct _MMBaseModemPrivate {
     gboolean reprobe;
 
     guint max_timeouts;
+    /* AT ports being recovered after consecutive timeouts */
+    GList *recovering_ports;
+
+    /* Whether read-only AT sequence steps may be concatenated */
+    gboolean at_concatenation;
+
+    /* Priority of the AT commands being launched */
+    MMPortSerialCommandPriority command_priority;
 
     /* The authorization provider */
     MMAuthProvider *authp;
     GCancellable *authp_cancellable;
 
     GHashTable *ports;
+    /* Replies to modem-global commands, shared among the AT ports */
+    MMSerialReplyCache *shared_reply_cache;
     MMPortSerialAt *primary;
     MMPortSerialAt *secondary;
+    gulong primary_connected_id;
     MMPortSerialQcdm *qcdm;
     GList *data;
 
@@ -107,6 +119,115 @@ get_hash_key (const gchar *subsys,
     return g_strdup_printf ("%s%s", subsys, name);
 }
 
+/*****************************************************************************/
+/* Recovery of AT ports which stopped answering */
+
+/* Consecutive timeouts after which recovery is attempted */
+#define SERIAL_PORT_RECOVERY_TIMEOUTS 2
+/* Time the port is flashed, in ms */
+#define SERIAL_PORT_RECOVERY_FLASH_TIME 100
+/* Timeout of the AT probe checking whether the port answers again, in s */
+#define SERIAL_PORT_RECOVERY_PROBE_TIMEOUT 3
+
+typedef struct {
+    MMBaseModem *self;
+    MMPortSerialAt *port;
+} RecoveryContext;
+
+static void
+recovery_context_free (RecoveryContext *ctx)
+{
+    ctx->self->priv->recovering_ports = g_list_remove (ctx->self->priv->recovering_ports, ctx->port);
+    g_object_unref (ctx->port);
+    g_object_unref (ctx->self);
+    g_slice_free (RecoveryContext, ctx);
+}
+
+static void
+recovery_probe_ready (MMPortSerialAt *port,
+                      GAsyncResult *res,
+                      RecoveryContext *ctx)
+{
+    GError *error = NULL;
+
+    mm_port_serial_at_command_finish (port, res, &error);
+    if (!error)
+        mm_info ("(%s/%s) port answering again",
+                 mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (port))),
+                 mm_port_get_device (MM_PORT (port)));
+    else if (ctx->self->priv->max_timeouts > 0 && ctx->self->priv->cancellable) {
+        mm_warn ("(%s/%s) couldn't recover port: %s; marking modem '%s' as disabled",
+                 mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (port))),
+                 mm_port_get_device (MM_PORT (port)),
+                 error->message,
+                 g_dbus_object_get_object_path (G_DBUS_OBJECT (ctx->self)));
+        /* No point in waiting for the rest of timeouts */
+        g_cancellable_cancel (ctx->self->priv->cancellable);
+    } else
+        mm_warn ("(%s/%s) couldn't recover port: %s",
+                 mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (port))),
+                 mm_port_get_device (MM_PORT (port)),
+                 error->message);
+
+    g_clear_error (&error);
+    recovery_context_free (ctx);
+}
+
+static void
+recovery_flash_ready (MMPortSerial *port,
+                      GAsyncResult *res,
+                      RecoveryContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_port_serial_flash_finish (port, res, &error)) {
+        mm_dbg ("(%s/%s) couldn't flash port: %s",
+                mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (port))),
+                mm_port_get_device (MM_PORT (port)),
+                error->message);
+        g_error_free (error);
+    }
+
+    /* Ahead of anything else still queued */
+    mm_port_serial_at_command_full (ctx->port,
+                                    "AT",
+                                    SERIAL_PORT_RECOVERY_PROBE_TIMEOUT,
+                                    FALSE,
+                                    FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                    NULL,
+                                    (GAsyncReadyCallback)recovery_probe_ready,
+                                    ctx);
+}
+
+static void
+serial_port_recover (MMBaseModem *self,
+                     MMPortSerialAt *port)
+{
+    RecoveryContext *ctx;
+
+    if (g_list_find (self->priv->recovering_ports, port))
+        return;
+
+    mm_warn ("(%s/%s) port stopped answering, trying to recover it",
+             mm_port_subsys_get_string (mm_port_get_subsys (MM_PORT (port))),
+             mm_port_get_device (MM_PORT (port)));
+
+    ctx = g_slice_new0 (RecoveryContext);
+    ctx->self = g_object_ref (self);
+    ctx->port = g_object_ref (port);
+    self->priv->recovering_ports = g_list_prepend (self->priv->recovering_ports, port);
+
+    /* Polling queued behind the wedged command would just time out as well */
+    mm_port_serial_drain_background_commands (MM_PORT_SERIAL (port));
+
+    mm_port_serial_flash (MM_PORT_SERIAL (port),
+                          SERIAL_PORT_RECOVERY_FLASH_TIME,
+                          TRUE,
+                          (GAsyncReadyCallback)recovery_flash_ready,
+                          ctx);
+}
+
 static void
 serial_port_timed_out_cb (MMPortSerial *port,
                           guint n_consecutive_timeouts,
@@ -124,7 +245,13 @@ serial_port_timed_out_cb (MMPortSerial *port,
 
         /* Only set action to invalidate modem if not already done */
         g_cancellable_cancel (self->priv->cancellable);
+        return;
     }
+
+    if (n_consecutive_timeouts == SERIAL_PORT_RECOVERY_TIMEOUTS &&
+        MM_IS_PORT_SERIAL_AT (port) &&
+        mm_port_serial_is_open (port))
+        serial_port_recover (self, MM_PORT_SERIAL_AT (port));
 }
 
 gboolean
@@ -200,6 +327,14 @@ mm_base_modem_grab_port (MMBaseModem         *self,
                                                    mm_serial_parser_v1_destroy);
             /* Store flags already */
             mm_port_serial_at_set_flags (MM_PORT_SERIAL_AT (port), at_pflags);
+            /* Identification queries are answered once for all the ports */
+            if (!self->priv->shared_reply_cache)
+                self->priv->shared_reply_cache = mm_port_serial_at_shared_reply_cache_new ();
+            mm_port_serial_set_shared_reply_cache (MM_PORT_SERIAL (port), self->priv->shared_reply_cache);
+            /* Faster UARTs, e.g. in platform serial modems */
+            if (mm_kernel_device_get_property_as_int (kernel_device, "ID_MM_TTY_BAUDRATE_MAX") > 0)
+                mm_port_serial_at_set_max_baudrate (MM_PORT_SERIAL_AT (port),
+                                                    (guint) mm_kernel_device_get_property_as_int (kernel_device, "ID_MM_TTY_BAUDRATE_MAX"));
         } else if (ptype == MM_PORT_TYPE_GPS) {
             /* Raw GPS port */
             port = MM_PORT (mm_port_serial_gps_new (name));
@@ -214,6 +349,18 @@ mm_base_modem_grab_port (MMBaseModem         *self,
             return FALSE;
         }
 
+        mm_port_serial_set_adaptive_timeouts (MM_PORT_SERIAL (port), mm_context_get_adaptive_timeouts ());
+        mm_port_serial_set_share_commands (MM_PORT_SERIAL (port), mm_context_get_share_commands ());
+        if (mm_kernel_device_get_property_as_boolean (kernel_device, "ID_MM_TTY_LOW_LATENCY"))
+            mm_port_serial_set_low_latency (MM_PORT_SERIAL (port), TRUE);
+        /* Per-device delays, e.g. set for a given driver or vid:pid in udev rules */
+        if (mm_kernel_device_has_property (kernel_device, "ID_MM_TTY_REOPEN_TIME"))
+            mm_port_serial_set_reopen_time (MM_PORT_SERIAL (port),
+                                            mm_kernel_device_get_property_as_int (kernel_device, "ID_MM_TTY_REOPEN_TIME"));
+        if (mm_kernel_device_has_property (kernel_device, "ID_MM_TTY_FLASH_TIME"))
+            mm_port_serial_set_flash_time (MM_PORT_SERIAL (port),
+                                           mm_kernel_device_get_property_as_int (kernel_device, "ID_MM_TTY_FLASH_TIME"));
+
         /* For serial ports, enable port timeout checks */
         g_signal_connect (port,
                           "timed-out",
@@ -232,8 +379,10 @@ mm_base_modem_grab_port (MMBaseModem         *self,
     else if (g_str_has_prefix (subsys, "usb") &&
              g_str_has_prefix (name, "cdc-wdm")) {
 #if defined WITH_QMI
-        if (ptype == MM_PORT_TYPE_QMI)
+        if (ptype == MM_PORT_TYPE_QMI) {
             port = MM_PORT (mm_port_qmi_new (name));
+            mm_port_qmi_set_multiplex (MM_PORT_QMI (port), mm_context_get_qmi_multiplex ());
+        }
 #endif
 #if defined WITH_MBIM
         if (!port && ptype == MM_PORT_TYPE_MBIM)
@@ -313,6 +462,8 @@ mm_base_modem_disable (MMBaseModem *self,
     g_assert (MM_BASE_MODEM_GET_CLASS (self)->disable != NULL);
     g_assert (MM_BASE_MODEM_GET_CLASS (self)->disable_finish != NULL);
 
+    mm_base_modem_drain_background_commands (self);
+
     MM_BASE_MODEM_GET_CLASS (self)->disable (
         self,
         self->priv->cancellable,
@@ -391,6 +542,10 @@ mm_base_modem_set_valid (MMBaseModem *self,
 
     /* If validity changed OR if both old and new were invalid, notify. This
      * last case is to cover failures during initialization. */
+    /* Nothing still queued for polling is worth sending any more */
+    if (!new_valid)
+        mm_base_modem_drain_background_commands (self);
+
     if (self->priv->valid != new_valid ||
         !new_valid) {
         self->priv->valid = new_valid;
@@ -415,6 +570,100 @@ mm_base_modem_get_reprobe (MMBaseModem *self)
     return self->priv->reprobe;
 }
 
+MMPortSerialCommandPriority
+mm_base_modem_set_command_priority (MMBaseModem *self,
+                                    MMPortSerialCommandPriority priority)
+{
+    MMPortSerialCommandPriority previous;
+
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL);
+
+    previous = self->priv->command_priority;
+    self->priv->command_priority = priority;
+    return previous;
+}
+
+MMPortSerialCommandPriority
+mm_base_modem_get_command_priority (MMBaseModem *self)
+{
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL);
+
+    return self->priv->command_priority;
+}
+
+void
+mm_base_modem_drain_background_commands (MMBaseModem *self)
+{
+    GHashTableIter iter;
+    MMPort *port;
+
+    g_return_if_fail (MM_IS_BASE_MODEM (self));
+
+    if (!self->priv->ports)
+        return;
+
+    g_hash_table_iter_init (&iter, self->priv->ports);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&port)) {
+        if (MM_IS_PORT_SERIAL (port))
+            mm_port_serial_drain_background_commands (MM_PORT_SERIAL (port));
+    }
+}
+
+static void
+invalidate_port_sim_replies (MMBaseModem *self)
+{
+    GHashTableIter iter;
+    MMPort *port;
+
+    if (!self->priv->ports)
+        return;
+
+    g_hash_table_iter_init (&iter, self->priv->ports);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&port)) {
+        if (MM_IS_PORT_SERIAL_AT (port))
+            mm_port_serial_at_reply_cache_invalidate_sim (
+                mm_port_serial_peek_reply_cache (MM_PORT_SERIAL (port)));
+    }
+}
+
+void
+mm_base_modem_clear_shared_reply_cache (MMBaseModem *self)
+{
+    g_return_if_fail (MM_IS_BASE_MODEM (self));
+
+    if (self->priv->shared_reply_cache)
+        mm_serial_reply_cache_clear (self->priv->shared_reply_cache);
+    /* SIM replies may also be in the caches of each port */
+    invalidate_port_sim_replies (self);
+}
+
+void
+mm_base_modem_invalidate_sim_replies (MMBaseModem *self)
+{
+    g_return_if_fail (MM_IS_BASE_MODEM (self));
+
+    mm_dbg ("Invalidating cached SIM replies");
+    if (self->priv->shared_reply_cache)
+        mm_port_serial_at_reply_cache_invalidate_sim (self->priv->shared_reply_cache);
+    invalidate_port_sim_replies (self);
+}
+
+MMSerialReplyCache *
+mm_base_modem_peek_shared_reply_cache (MMBaseModem *self)
+{
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), NULL);
+
+    return self->priv->shared_reply_cache;
+}
+
+gboolean
+mm_base_modem_get_at_concatenation (MMBaseModem *self)
+{
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), FALSE);
+
+    return self->priv->at_concatenation;
+}
+
 gboolean
 mm_base_modem_get_valid (MMBaseModem *self)
 {
@@ -727,6 +976,16 @@ mm_base_modem_get_best_at_port (MMBaseModem *self,
     return (best ? g_object_ref (best) : NULL);
 }
 
+MMPortSerialAt *
+mm_base_modem_get_least_loaded_at_port (MMBaseModem *self,
+                                        GError **error)
+{
+    MMPortSerialAt *port;
+
+    port = mm_base_modem_peek_least_loaded_at_port (self, error);
+    return (port ? g_object_ref (port) : NULL);
+}
+
 MMPortSerialAt *
 mm_base_modem_peek_best_at_port (MMBaseModem *self,
                                  GError **error)
@@ -750,6 +1009,76 @@ mm_base_modem_peek_best_at_port (MMBaseModem *self,
     return NULL;
 }
 
+static gboolean
+secondary_can_take_commands (MMBaseModem *self)
+{
+    /* Opening the secondary port would run its init sequence in the middle
+     * of other operations */
+    return (self->priv->secondary &&
+            !mm_port_get_connected (MM_PORT (self->priv->secondary)) &&
+            mm_port_serial_is_open (MM_PORT_SERIAL (self->priv->secondary)));
+}
+
+MMPortSerialAt *
+mm_base_modem_route_at_port (MMBaseModem *self,
+                             MMPortSerialAt *port)
+{
+    g_return_val_if_fail (MM_IS_BASE_MODEM (self), port);
+
+    if (port &&
+        port == self->priv->primary &&
+        mm_port_get_connected (MM_PORT (port)) &&
+        secondary_can_take_commands (self))
+        return self->priv->secondary;
+
+    return port;
+}
+
+static void
+primary_connected_updated (MMPortSerialAt *primary,
+                           GParamSpec *pspec,
+                           MMBaseModem *self)
+{
+    /* Once disconnected, new commands go back to the primary port; the ones
+     * already queued in the secondary port are sent there */
+    if (!mm_port_get_connected (MM_PORT (primary))) {
+        mm_dbg ("(%s) AT commands routed back to the primary port",
+                mm_port_get_device (MM_PORT (primary)));
+        return;
+    }
+
+    if (!secondary_can_take_commands (self)) {
+        mm_dbg ("(%s) primary port connected, but no secondary port to route AT commands to",
+                mm_port_get_device (MM_PORT (primary)));
+        return;
+    }
+
+    mm_dbg ("(%s) primary port connected, AT commands routed to (%s)",
+            mm_port_get_device (MM_PORT (primary)),
+            mm_port_get_device (MM_PORT (self->priv->secondary)));
+    mm_port_serial_move_queued_commands (MM_PORT_SERIAL (primary),
+                                         MM_PORT_SERIAL (self->priv->secondary));
+}
+
+MMPortSerialAt *
+mm_base_modem_peek_least_loaded_at_port (MMBaseModem *self,
+                                         GError **error)
+{
+    MMPortSerialAt *best;
+
+    best = mm_base_modem_peek_best_at_port (self, error);
+    if (best != self->priv->primary)
+        return best;
+
+    /* Only move to the secondary port if it is already open */
+    if (secondary_can_take_commands (self) &&
+        (mm_port_serial_get_queue_length (MM_PORT_SERIAL (self->priv->secondary)) <
+         mm_port_serial_get_queue_length (MM_PORT_SERIAL (self->priv->primary))))
+        return self->priv->secondary;
+
+    return best;
+}
+
 gboolean
 mm_base_modem_has_at_port (MMBaseModem *self)
 {
@@ -1124,6 +1453,11 @@ mm_base_modem_organize_ports (MMBaseModem *self,
     self->priv->primary = (primary ? g_object_ref (primary) : NULL);
     self->priv->secondary = (secondary ? g_object_ref (secondary) : NULL);
     self->priv->qcdm = (qcdm ? g_object_ref (qcdm) : NULL);
+    if (self->priv->primary && self->priv->secondary)
+        self->priv->primary_connected_id = g_signal_connect (self->priv->primary,
+                                                             "notify::" MM_PORT_CONNECTED,
+                                                             G_CALLBACK (primary_connected_updated),
+                                                             self);
     self->priv->gps_control = (gps_control ? g_object_ref (gps_control) : NULL);
     self->priv->gps = (gps ? g_object_ref (gps) : NULL);
 
@@ -1300,6 +1634,8 @@ mm_base_modem_init (MMBaseModem *self)
                                self,
                                NULL);
 
+    self->priv->command_priority = MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL;
+
     self->priv->ports = g_hash_table_new_full (g_str_hash,
                                                g_str_equal,
                                                g_free,
@@ -1346,6 +1682,9 @@ set_property (GObject *object,
         g_clear_object (&self->priv->connection);
         self->priv->connection = g_value_dup_object (value);
         break;
+    case PROP_AT_CONCATENATION:
+        self->priv->at_concatenation = g_value_get_boolean (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -1388,6 +1727,9 @@ get_property (GObject *object,
     case PROP_CONNECTION:
         g_value_set_object (value, self->priv->connection);
         break;
+    case PROP_AT_CONCATENATION:
+        g_value_set_boolean (value, self->priv->at_concatenation);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -1432,6 +1774,10 @@ dispose (GObject *object)
     g_cancellable_cancel (self->priv->cancellable);
     g_clear_object (&self->priv->cancellable);
 
+    if (self->priv->primary_connected_id) {
+        g_signal_handler_disconnect (self->priv->primary, self->priv->primary_connected_id);
+        self->priv->primary_connected_id = 0;
+    }
     g_clear_object (&self->priv->primary);
     g_clear_object (&self->priv->secondary);
     g_list_free_full (self->priv->data, g_object_unref);
@@ -1456,10 +1802,25 @@ dispose (GObject *object)
 #endif
 
     if (self->priv->ports) {
+        GHashTableIter iter;
+        MMPort *port;
+
+        /* Ports may be kept around by someone else, so make sure they
+         * don't use the shared cache any more */
+        g_hash_table_iter_init (&iter, self->priv->ports);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&port)) {
+            if (MM_IS_PORT_SERIAL (port))
+                mm_port_serial_set_shared_reply_cache (MM_PORT_SERIAL (port), NULL);
+        }
         g_hash_table_destroy (self->priv->ports);
         self->priv->ports = NULL;
     }
 
+    if (self->priv->shared_reply_cache) {
+        mm_serial_reply_cache_free (self->priv->shared_reply_cache);
+        self->priv->shared_reply_cache = NULL;
+    }
+
     g_clear_object (&self->priv->connection);
 
     G_OBJECT_CLASS (mm_base_modem_parent_class)->dispose (object);
@@ -1487,6 +1848,15 @@ mm_base_modem_class_init (MMBaseModemClass *klass)
                            G_PARAM_READWRITE);
     g_object_class_install_property (object_class, PROP_MAX_TIMEOUTS, properties[PROP_MAX_TIMEOUTS]);
 
+    properties[PROP_AT_CONCATENATION] =
+        g_param_spec_boolean (MM_BASE_MODEM_AT_CONCATENATION,
+                              "AT concatenation",
+                              "Whether consecutive read-only commands in AT sequences "
+                              "may be sent as a single V.250 concatenated command.",
+                              FALSE,
+                              G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+    g_object_class_install_property (object_class, PROP_AT_CONCATENATION, properties[PROP_AT_CONCATENATION]);
+
     properties[PROP_VALID] =
         g_param_spec_boolean (MM_BASE_MODEM_VALID,
                               "Valid",
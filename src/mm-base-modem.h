@@ -63,6 +63,7 @@ typedef struct _MMBaseModemPrivate MMBaseModemPrivate;
 #define MM_BASE_MODEM_VENDOR_ID      "base-modem-vendor-id"
 #define MM_BASE_MODEM_PRODUCT_ID     "base-modem-product-id"
 #define MM_BASE_MODEM_REPROBE        "base-modem-reprobe"
+#define MM_BASE_MODEM_AT_CONCATENATION "base-modem-at-concatenation"
 
 struct _MMBaseModem {
     MmGdbusObjectSkeleton parent;
@@ -130,6 +131,10 @@ MMPortMbim       *mm_base_modem_peek_port_mbim          (MMBaseModem *self);
 MMPortMbim       *mm_base_modem_peek_port_mbim_for_data (MMBaseModem *self, MMPort *data, GError **error);
 #endif
 MMPortSerialAt   *mm_base_modem_peek_best_at_port      (MMBaseModem *self, GError **error);
+/* The port to actually send the commands for the given one to: while the
+ * primary port is connected, its commands go to the secondary port */
+MMPortSerialAt   *mm_base_modem_route_at_port          (MMBaseModem *self, MMPortSerialAt *port);
+MMPortSerialAt   *mm_base_modem_peek_least_loaded_at_port (MMBaseModem *self, GError **error);
 MMPort           *mm_base_modem_peek_best_data_port    (MMBaseModem *self, MMPortType type);
 GList            *mm_base_modem_peek_data_ports        (MMBaseModem *self);
 
@@ -147,6 +152,7 @@ MMPortMbim       *mm_base_modem_get_port_mbim          (MMBaseModem *self);
 MMPortMbim       *mm_base_modem_get_port_mbim_for_data (MMBaseModem *self, MMPort *data, GError **error);
 #endif
 MMPortSerialAt   *mm_base_modem_get_best_at_port      (MMBaseModem *self, GError **error);
+MMPortSerialAt   *mm_base_modem_get_least_loaded_at_port (MMBaseModem *self, GError **error);
 MMPort           *mm_base_modem_get_best_data_port    (MMBaseModem *self, MMPortType type);
 GList            *mm_base_modem_get_data_ports        (MMBaseModem *self);
 
@@ -170,6 +176,29 @@ void     mm_base_modem_set_reprobe (MMBaseModem *self,
                                     gboolean reprobe);
 gboolean mm_base_modem_get_reprobe (MMBaseModem *self);
 
+gboolean mm_base_modem_get_at_concatenation (MMBaseModem *self);
+
+/* AT commands launched while a priority is set are queued in the ports with
+ * that priority, even the ones sent afterwards as part of the same
+ * sequence. Returns the previous priority, to be restored afterwards. */
+MMPortSerialCommandPriority mm_base_modem_set_command_priority (MMBaseModem *self,
+                                                                MMPortSerialCommandPriority priority);
+MMPortSerialCommandPriority mm_base_modem_get_command_priority (MMBaseModem *self);
+
+/* Drops the background commands still waiting in the serial ports; done
+ * when disabling or when the modem goes away, so that obsolete polling
+ * doesn't delay what matters */
+void mm_base_modem_drain_background_commands (MMBaseModem *self);
+
+/* Cache of the replies to modem-global commands (identification, IMSI,
+ * ICCID) shared among the AT ports; cleared when those may have changed,
+ * e.g. after a reset or a SIM change, together with the SIM replies cached
+ * by each port. Invalidating the SIM replies alone is enough when only the
+ * SIM may have changed, e.g. after unlocking it. */
+MMSerialReplyCache *mm_base_modem_peek_shared_reply_cache  (MMBaseModem *self);
+void                mm_base_modem_clear_shared_reply_cache (MMBaseModem *self);
+void                mm_base_modem_invalidate_sim_replies   (MMBaseModem *self);
+
 const gchar  *mm_base_modem_get_device  (MMBaseModem *self);
 const gchar **mm_base_modem_get_drivers (MMBaseModem *self);
 const gchar  *mm_base_modem_get_plugin  (MMBaseModem *self);
@@ -30,6 +30,7 @@
 #include "mm-base-sim.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 
@@ -170,6 +171,7 @@ after_change_update_lock_info_ready (MMIfaceModem *self,
         g_dbus_method_invocation_take_error (ctx->invocation, ctx->save_error);
         ctx->save_error = NULL;
     } else {
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_sim_complete_change_pin (MM_GDBUS_SIM (ctx->self), ctx->invocation);
     }
 
@@ -190,6 +192,7 @@ handle_change_pin_ready (MMBaseSim *self,
             known_lock = MM_MODEM_LOCK_SIM_PUK;
     }
 
+    mm_iface_modem_invalidate_unlock_retries (MM_IFACE_MODEM (self->priv->modem));
     mm_iface_modem_update_lock_info (
         MM_IFACE_MODEM (self->priv->modem),
         known_lock,
@@ -343,6 +346,7 @@ after_enable_update_lock_info_ready (MMIfaceModem *modem,
     } else {
         /* Signal about the new lock state */
         g_signal_emit (ctx->self, signals[SIGNAL_PIN_LOCK_ENABLED], 0, ctx->enabled);
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_sim_complete_enable_pin (MM_GDBUS_SIM (ctx->self), ctx->invocation);
     }
 
@@ -363,6 +367,7 @@ handle_enable_pin_ready (MMBaseSim *self,
             known_lock = MM_MODEM_LOCK_SIM_PUK;
     }
 
+    mm_iface_modem_invalidate_unlock_retries (MM_IFACE_MODEM (self->priv->modem));
     mm_iface_modem_update_lock_info (
         MM_IFACE_MODEM (self->priv->modem),
         known_lock,
@@ -620,7 +625,10 @@ send_pin_ready (MMBaseSim *self,
             known_lock = MM_MODEM_LOCK_SIM_PUK;
     }
 
-    /* Once pin/puk has been sent, recheck lock */
+    /* Once pin/puk has been sent, recheck lock; what was read from the SIM
+     * while locked may not be valid any more */
+    mm_iface_modem_invalidate_unlock_retries (MM_IFACE_MODEM (self->priv->modem));
+    mm_base_modem_invalidate_sim_replies (self->priv->modem);
     mm_iface_modem_update_lock_info (
         MM_IFACE_MODEM (self->priv->modem),
         known_lock,
@@ -635,7 +643,10 @@ send_puk_ready (MMBaseSim *self,
 {
     MM_BASE_SIM_GET_CLASS (self)->send_puk_finish (self, res, &ctx->save_error);
 
-    /* Once pin/puk has been sent, recheck lock */
+    /* Once pin/puk has been sent, recheck lock; what was read from the SIM
+     * while locked may not be valid any more */
+    mm_iface_modem_invalidate_unlock_retries (MM_IFACE_MODEM (self->priv->modem));
+    mm_base_modem_invalidate_sim_replies (self->priv->modem);
     mm_iface_modem_update_lock_info (MM_IFACE_MODEM (self->priv->modem),
                                      MM_MODEM_LOCK_UNKNOWN, /* ask */
                                      (GAsyncReadyCallback)update_lock_info_ready,
@@ -739,8 +750,10 @@ handle_send_pin_ready (MMBaseSim *self,
 
     if (!mm_base_sim_send_pin_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (self);
         mm_gdbus_sim_complete_send_pin (MM_GDBUS_SIM (self), ctx->invocation);
+    }
 
     handle_send_pin_context_free (ctx);
 }
@@ -813,8 +826,10 @@ handle_send_puk_ready (MMBaseSim *self,
 
     if (!mm_base_sim_send_puk_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (self);
         mm_gdbus_sim_complete_send_puk (MM_GDBUS_SIM (self), ctx->invocation);
+    }
 
     handle_send_puk_context_free (ctx);
 }
@@ -1004,7 +1019,7 @@ load_sim_identifier (MMBaseSim *self,
     mm_dbg ("loading SIM identifier...");
 
     /* READ BINARY of EFiccid (ICC Identification) ETSI TS 102.221 section 13.2 */
-    mm_base_modem_at_command (
+    mm_base_modem_at_command_any_port (
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,12258,0,0,10",
         20,
@@ -1194,7 +1209,7 @@ load_operator_identifier (MMBaseSim *self,
     mm_dbg ("loading Operator ID...");
 
     /* READ BINARY of EFad (Administrative Data) ETSI 51.011 section 10.3.18 */
-    mm_base_modem_at_command (
+    mm_base_modem_at_command_any_port (
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,28589,0,0,4",
         10,
@@ -1289,7 +1304,7 @@ load_operator_name (MMBaseSim *self,
     mm_dbg ("loading Operator Name...");
 
     /* READ BINARY of EFspn (Service Provider Name) ETSI 51.011 section 10.3.11 */
-    mm_base_modem_at_command (
+    mm_base_modem_at_command_any_port (
         MM_BASE_MODEM (self->priv->modem),
         "+CRSM=176,28486,0,0,17",
         10,
@@ -1303,15 +1318,83 @@ load_operator_name (MMBaseSim *self,
 
 /*****************************************************************************/
 
+/* SIM info cached by ICCID, so that the SIM of a modem being reset (or
+ * re-probed) gets it back right after reading the ICCID again */
+
+typedef struct {
+    gchar *imsi;
+    gchar *operator_identifier;
+    gchar *operator_name;
+} SimCacheEntry;
+
+static GHashTable *sim_cache;
+
+static void
+sim_cache_entry_free (SimCacheEntry *entry)
+{
+    g_free (entry->imsi);
+    g_free (entry->operator_identifier);
+    g_free (entry->operator_name);
+    g_slice_free (SimCacheEntry, entry);
+}
+
+static void
+sim_cache_store (MMBaseSim *self)
+{
+    SimCacheEntry *entry;
+    const gchar *sim_identifier;
+
+    sim_identifier = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (self));
+    if (!sim_identifier)
+        return;
+
+    if (G_UNLIKELY (!sim_cache))
+        sim_cache = g_hash_table_new_full (g_str_hash,
+                                           g_str_equal,
+                                           g_free,
+                                           (GDestroyNotify) sim_cache_entry_free);
+
+    entry = g_slice_new0 (SimCacheEntry);
+    entry->imsi = g_strdup (mm_gdbus_sim_get_imsi (MM_GDBUS_SIM (self)));
+    entry->operator_identifier = g_strdup (mm_gdbus_sim_get_operator_identifier (MM_GDBUS_SIM (self)));
+    entry->operator_name = g_strdup (mm_gdbus_sim_get_operator_name (MM_GDBUS_SIM (self)));
+    g_hash_table_replace (sim_cache, g_strdup (sim_identifier), entry);
+}
+
+static void
+sim_cache_load (MMBaseSim *self)
+{
+    SimCacheEntry *entry;
+    const gchar *sim_identifier;
+
+    sim_identifier = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (self));
+    if (!sim_identifier || !sim_cache)
+        return;
+
+    entry = g_hash_table_lookup (sim_cache, sim_identifier);
+    if (!entry)
+        return;
+
+    mm_dbg ("reusing info cached for SIM %s", sim_identifier);
+    if (entry->imsi && !mm_gdbus_sim_get_imsi (MM_GDBUS_SIM (self)))
+        mm_gdbus_sim_set_imsi (MM_GDBUS_SIM (self), entry->imsi);
+    if (entry->operator_identifier && !mm_gdbus_sim_get_operator_identifier (MM_GDBUS_SIM (self)))
+        mm_gdbus_sim_set_operator_identifier (MM_GDBUS_SIM (self), entry->operator_identifier);
+    if (entry->operator_name && !mm_gdbus_sim_get_operator_name (MM_GDBUS_SIM (self)))
+        mm_gdbus_sim_set_operator_name (MM_GDBUS_SIM (self), entry->operator_name);
+}
+
+/*****************************************************************************/
+
 typedef struct _InitAsyncContext InitAsyncContext;
 static void interface_initialization_step (InitAsyncContext *ctx);
 
 typedef enum {
     INITIALIZATION_STEP_FIRST,
     INITIALIZATION_STEP_SIM_IDENTIFIER,
-    INITIALIZATION_STEP_IMSI,
+    INITIALIZATION_STEP_CACHE,
+    INITIALIZATION_STEP_IMSI_AND_OPERATOR_NAME,
     INITIALIZATION_STEP_OPERATOR_ID,
-    INITIALIZATION_STEP_OPERATOR_NAME,
     INITIALIZATION_STEP_LAST
 } InitializationStep;
 
@@ -1321,6 +1404,8 @@ struct _InitAsyncContext {
     MMBaseSim *self;
     InitializationStep step;
     guint sim_identifier_tries;
+    /* Loaders running at once in the current step */
+    guint n_pending;
 };
 
 static void
@@ -1415,7 +1500,10 @@ load_sim_identifier_ready (MMBaseSim *self,
             g_error_free (error);                                       \
         }                                                               \
                                                                         \
-        /* Go on to next step */                                        \
+        /* Go on to next step once all loaders of this one are done */  \
+        g_assert (ctx->n_pending > 0);                                  \
+        if (--ctx->n_pending > 0)                                       \
+            return;                                                     \
         ctx->step++;                                                    \
         interface_initialization_step (ctx);                            \
     }
@@ -1458,29 +1546,52 @@ interface_initialization_step (InitAsyncContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZATION_STEP_IMSI:
-        /* IMSI is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
+    case INITIALIZATION_STEP_CACHE:
+        /* Once the ICCID is known, reuse whatever was loaded for the same
+         * SIM before */
+        sim_cache_load (ctx->self);
+        /* Fall down to next step */
+        ctx->step++;
+
+    case INITIALIZATION_STEP_IMSI_AND_OPERATOR_NAME:
+        /* IMSI and Operator Name are meant to be loaded only once during the
+         * whole lifetime of the modem. Therefore, if we already have them
+         * loaded, don't try to load them again. They don't depend on each
+         * other, so both requests are issued right away; the extra count
+         * keeps a loader completing right away from ending the step. */
+        ctx->n_pending = 1;
         if (mm_gdbus_sim_get_imsi (MM_GDBUS_SIM (ctx->self)) == NULL &&
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_imsi &&
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_imsi_finish) {
+            ctx->n_pending++;
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_imsi (
                 ctx->self,
                 (GAsyncReadyCallback)load_imsi_ready,
                 ctx);
-            return;
         }
+        if (mm_gdbus_sim_get_operator_name (MM_GDBUS_SIM (ctx->self)) == NULL &&
+            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name &&
+            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name_finish) {
+            ctx->n_pending++;
+            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name (
+                ctx->self,
+                (GAsyncReadyCallback)load_operator_name_ready,
+                ctx);
+        }
+        if (--ctx->n_pending > 0)
+            return;
         /* Fall down to next step */
         ctx->step++;
 
     case INITIALIZATION_STEP_OPERATOR_ID:
         /* Operator ID is meant to be loaded only once during the whole
          * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
+         * don't try to load them again. It may be built from the IMSI, so
+         * it's loaded afterwards. */
         if (mm_gdbus_sim_get_operator_identifier (MM_GDBUS_SIM (ctx->self)) == NULL &&
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_identifier &&
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_identifier_finish) {
+            ctx->n_pending = 1;
             MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_identifier (
                 ctx->self,
                 (GAsyncReadyCallback)load_operator_identifier_ready,
@@ -1490,23 +1601,8 @@ interface_initialization_step (InitAsyncContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZATION_STEP_OPERATOR_NAME:
-        /* Operator Name is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_sim_get_operator_name (MM_GDBUS_SIM (ctx->self)) == NULL &&
-            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name &&
-            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name_finish) {
-            MM_BASE_SIM_GET_CLASS (ctx->self)->load_operator_name (
-                ctx->self,
-                (GAsyncReadyCallback)load_operator_name_ready,
-                ctx);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
-
     case INITIALIZATION_STEP_LAST:
+        sim_cache_store (ctx->self);
         /* We are done without errors! */
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         g_simple_async_result_complete_in_idle (ctx->result);
@@ -1538,6 +1634,7 @@ common_init_async (GAsyncInitable *initable,
                         NULL);
     ctx->step = INITIALIZATION_STEP_FIRST;
     ctx->sim_identifier_tries = 0;
+    ctx->n_pending = 0;
 
     interface_initialization_step (ctx);
 }
@@ -33,6 +33,7 @@
 #include "mm-sms-part-3gpp.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-modem.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
 #include "mm-modem-helpers.h"
 
@@ -354,6 +355,7 @@ handle_store_ready (MMBaseSms *self,
         if (mm_gdbus_sms_get_state (MM_GDBUS_SMS (ctx->self)) == MM_SMS_STATE_UNKNOWN)
             mm_gdbus_sms_set_state (MM_GDBUS_SMS (ctx->self), MM_SMS_STATE_STORED);
 
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_sms_complete_store (MM_GDBUS_SMS (ctx->self), ctx->invocation);
     }
 
@@ -412,10 +414,11 @@ handle_store_auth_ready (MMBaseModem *modem,
     /* First of all, check if we already have the SMS stored. */
     if (mm_base_sms_get_storage (ctx->self) != MM_SMS_STORAGE_UNKNOWN) {
         /* Check if SMS stored in some other storage */
-        if (mm_base_sms_get_storage (ctx->self) == ctx->storage)
+        if (mm_base_sms_get_storage (ctx->self) == ctx->storage) {
             /* Good, same storage */
+            mm_dbus_flush_properties (ctx->self);
             mm_gdbus_sms_complete_store (MM_GDBUS_SMS (ctx->self), ctx->invocation);
-        else
+        } else {
             g_dbus_method_invocation_return_error (
                 ctx->invocation,
                 MM_CORE_ERROR,
@@ -423,6 +426,7 @@ handle_store_auth_ready (MMBaseModem *modem,
                 "SMS is already stored in storage '%s', cannot store it in storage '%s'",
                 mm_sms_storage_get_string (mm_base_sms_get_storage (ctx->self)),
                 mm_sms_storage_get_string (ctx->storage));
+        }
         handle_store_context_free (ctx);
         return;
     }
@@ -534,6 +538,7 @@ handle_send_ready (MMBaseSms *self,
             mm_gdbus_sms_set_message_reference (MM_GDBUS_SMS (ctx->self),
                                                 mm_sms_part_get_message_reference ((MMSmsPart *)l->data));
         }
+        mm_dbus_flush_properties (ctx->self);
         mm_gdbus_sms_complete_send (MM_GDBUS_SMS (ctx->self), ctx->invocation);
     }
 
@@ -573,6 +578,7 @@ handle_send_auth_ready (MMBaseModem *modem,
                         GAsyncResult *res,
                         HandleSendContext *ctx)
 {
+    MMPortSerialCommandPriority previous;
     MMSmsState state;
     GError *error = NULL;
 
@@ -622,9 +628,13 @@ handle_send_auth_ready (MMBaseModem *modem,
         return;
     }
 
+    /* User request, serve it before any other pending command */
+    previous = mm_base_modem_set_command_priority (ctx->modem,
+                                                   MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE);
     MM_BASE_SMS_GET_CLASS (ctx->self)->send (ctx->self,
                                              (GAsyncReadyCallback)handle_send_ready,
                                              ctx);
+    mm_base_modem_set_command_priority (ctx->modem, previous);
 }
 
 static gboolean
@@ -1031,8 +1041,13 @@ typedef struct {
     gboolean need_unlock;
     gboolean from_storage;
     gboolean use_pdu_mode;
+    gboolean cmms_enabled;
     GList *current;
     gchar *msg_data;
+    /* Parts being sent from storage, all queued at once */
+    guint n_storage_pending;
+    GList *storage_failed;
+    GError *storage_error;
 } SmsSendContext;
 
 static void
@@ -1040,12 +1055,24 @@ sms_send_context_complete_and_free (SmsSendContext *ctx)
 {
     g_simple_async_result_complete_in_idle (ctx->result);
     g_object_unref (ctx->result);
+    /* Let the modem release the relay link right away; if this isn't done
+     * the link is anyway released after a few seconds of inactivity */
+    if (ctx->cmms_enabled)
+        mm_base_modem_at_command (ctx->modem,
+                                  "+CMMS=0",
+                                  3,
+                                  FALSE,
+                                  NULL,
+                                  NULL);
     /* Unlock mem2 storage if we had the lock */
     if (ctx->need_unlock)
         mm_broadband_modem_unlock_sms_storages (MM_BROADBAND_MODEM (ctx->modem), FALSE, TRUE);
     g_object_unref (ctx->modem);
     g_object_unref (ctx->self);
     g_free (ctx->msg_data);
+    g_list_free (ctx->storage_failed);
+    if (ctx->storage_error)
+        g_error_free (ctx->storage_error);
     g_free (ctx);
 }
 
@@ -1137,46 +1164,95 @@ send_generic_ready (MMBaseModem *modem,
                                   ctx);
 }
 
+typedef struct {
+    SmsSendContext *ctx;
+    MMSmsPart *part;
+} SendFromStorageContext;
+
 static void
 send_from_storage_ready (MMBaseModem *modem,
                          GAsyncResult *res,
-                         SmsSendContext *ctx)
+                         SendFromStorageContext *storage_ctx)
 {
+    SmsSendContext *ctx = storage_ctx->ctx;
+    MMSmsPart *part = storage_ctx->part;
     GError *error = NULL;
     const gchar *response;
-    gint message_reference;
+    gint message_reference = -1;
+
+    g_slice_free (SendFromStorageContext, storage_ctx);
 
     response = mm_base_modem_at_command_finish (modem, res, &error);
+    if (!error)
+        message_reference = read_message_reference_from_reply (response, &error);
+
     if (error) {
-        if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT)) {
-            g_simple_async_result_take_error (ctx->result, error);
-            sms_send_context_complete_and_free (ctx);
-            return;
-        }
+        /* Keep the failed parts in order, a timeout being the error to report */
+        ctx->storage_failed = g_list_append (ctx->storage_failed, part);
+        if (!ctx->storage_error ||
+            g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT)) {
+            if (ctx->storage_error)
+                g_error_free (ctx->storage_error);
+            ctx->storage_error = error;
+        } else
+            g_error_free (error);
+    } else
+        mm_sms_part_set_message_reference (part, (guint)message_reference);
 
-        mm_dbg ("Couldn't send SMS from storage: '%s'; trying generic send...",
-                error->message);
-        g_error_free (error);
+    if (--ctx->n_storage_pending > 0)
+        return;
 
-        ctx->from_storage = FALSE;
+    if (!ctx->storage_failed) {
+        ctx->current = NULL;
         sms_send_next_part (ctx);
         return;
     }
 
-    message_reference = read_message_reference_from_reply (response, &error);
-    if (error) {
-        g_simple_async_result_take_error (ctx->result, error);
+    if (g_error_matches (ctx->storage_error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT)) {
+        g_simple_async_result_take_error (ctx->result, ctx->storage_error);
+        ctx->storage_error = NULL;
         sms_send_context_complete_and_free (ctx);
         return;
     }
 
-    mm_sms_part_set_message_reference ((MMSmsPart *)ctx->current->data,
-                                       (guint)message_reference);
+    mm_dbg ("Couldn't send %u SMS part(s) from storage: '%s'; trying generic send...",
+            g_list_length (ctx->storage_failed),
+            ctx->storage_error->message);
+    g_clear_error (&ctx->storage_error);
 
-    ctx->current = g_list_next (ctx->current);
+    /* Only the parts which failed are sent again */
+    ctx->from_storage = FALSE;
+    ctx->current = ctx->storage_failed;
     sms_send_next_part (ctx);
 }
 
+static void
+sms_send_from_storage (SmsSendContext *ctx)
+{
+    GList *l;
+
+    /* All the +CMSS commands are queued at once, so that the port sends
+     * each one as soon as the previous reply arrives */
+    ctx->n_storage_pending = g_list_length (ctx->current);
+    for (l = ctx->current; l; l = g_list_next (l)) {
+        SendFromStorageContext *storage_ctx;
+        gchar *cmd;
+
+        storage_ctx = g_slice_new (SendFromStorageContext);
+        storage_ctx->ctx = ctx;
+        storage_ctx->part = (MMSmsPart *)l->data;
+
+        cmd = g_strdup_printf ("+CMSS=%d", mm_sms_part_get_index (storage_ctx->part));
+        mm_base_modem_at_command (ctx->modem,
+                                  cmd,
+                                  30,
+                                  FALSE,
+                                  (GAsyncReadyCallback)send_from_storage_ready,
+                                  storage_ctx);
+        g_free (cmd);
+    }
+}
+
 static void
 sms_send_next_part (SmsSendContext *ctx)
 {
@@ -1192,15 +1268,7 @@ sms_send_next_part (SmsSendContext *ctx)
 
     /* Send from storage */
     if (ctx->from_storage) {
-        cmd = g_strdup_printf ("+CMSS=%d",
-                               mm_sms_part_get_index ((MMSmsPart *)ctx->current->data));
-        mm_base_modem_at_command (ctx->modem,
-                                  cmd,
-                                  30,
-                                  FALSE,
-                                  (GAsyncReadyCallback)send_from_storage_ready,
-                                  ctx);
-        g_free (cmd);
+        sms_send_from_storage (ctx);
         return;
     }
 
@@ -1233,6 +1301,45 @@ sms_send_next_part (SmsSendContext *ctx)
     g_free (cmd);
 }
 
+static void
+cmms_enable_ready (MMBaseModem *modem,
+                   GAsyncResult *res,
+                   SmsSendContext *ctx)
+{
+    GError *error = NULL;
+
+    /* Not fatal, the parts are just sent without keeping the link */
+    mm_base_modem_at_command_finish (modem, res, &error);
+    if (error) {
+        mm_dbg ("Couldn't keep the relay link open between SMS parts: '%s'", error->message);
+        g_error_free (error);
+    } else
+        ctx->cmms_enabled = TRUE;
+
+    sms_send_next_part (ctx);
+}
+
+static void
+sms_send_start (SmsSendContext *ctx)
+{
+    ctx->current = ctx->self->priv->parts;
+
+    /* For multipart messages, ask the modem to keep the relay link open
+     * between parts (3GPP TS 27.005, +CMMS), so that it isn't released and
+     * set up again for each one of them */
+    if (ctx->current && g_list_next (ctx->current)) {
+        mm_base_modem_at_command (ctx->modem,
+                                  "+CMMS=1",
+                                  3,
+                                  FALSE,
+                                  (GAsyncReadyCallback)cmms_enable_ready,
+                                  ctx);
+        return;
+    }
+
+    sms_send_next_part (ctx);
+}
+
 static void
 send_lock_sms_storages_ready (MMBroadbandModem *modem,
                               GAsyncResult *res,
@@ -1251,8 +1358,7 @@ send_lock_sms_storages_ready (MMBroadbandModem *modem,
     ctx->need_unlock = TRUE;
 
     /* Go on to send the parts */
-    ctx->current = ctx->self->priv->parts;
-    sms_send_next_part (ctx);
+    sms_send_start (ctx);
 }
 
 static void
@@ -1289,8 +1395,7 @@ sms_send (MMBaseSms *self,
     g_object_get (self->priv->modem,
                   MM_IFACE_MODEM_MESSAGING_SMS_PDU_MODE, &ctx->use_pdu_mode,
                   NULL);
-    ctx->current = self->priv->parts;
-    sms_send_next_part (ctx);
+    sms_send_start (ctx);
 }
 
 /*****************************************************************************/
@@ -1341,7 +1446,10 @@ delete_part_ready (MMBaseModem *modem,
                 mm_sms_part_get_index ((MMSmsPart *)ctx->current->data),
                 error->message);
         g_error_free (error);
-    }
+    } else
+        mm_broadband_modem_forget_sms_part (MM_BROADBAND_MODEM (modem),
+                                            mm_base_sms_get_storage (ctx->self),
+                                            mm_sms_part_get_index ((MMSmsPart *)ctx->current->data));
 
     /* We reset the index, as there is no longer that part */
     mm_sms_part_set_index ((MMSmsPart *)ctx->current->data, SMS_PART_INVALID_INDEX);
@@ -1729,10 +1837,9 @@ mm_base_sms_singlepart_new (MMBaseModem *modem,
          * take it, and therefore the caller is responsible for freeing it. */
         self->priv->parts = g_list_remove (self->priv->parts, part);
         g_clear_object (&self);
-    } else
-        /* Only export once properly created */
-        mm_base_sms_export (self);
+    }
 
+    /* Exported by the SMS list, which may defer it */
     return self;
 }
 
@@ -1770,14 +1877,11 @@ mm_base_sms_multipart_new (MMBaseModem *modem,
     if (!mm_base_sms_multipart_take_part (self, first_part, error))
         g_clear_object (&self);
 
-    /* We do export uncomplete multipart messages, in order to be able to
-     *  request removal of all parts of those multipart SMS that will never
-     *  get completed.
+    /* Exported by the SMS list, which may defer it. We do export uncomplete
+     *  multipart messages, in order to be able to request removal of all
+     *  parts of those multipart SMS that will never get completed.
      * Only the STATE of the SMS object will be valid in the exported DBus
      *  interface.*/
-    if (self)
-        mm_base_sms_export (self);
-
     return self;
 }
 
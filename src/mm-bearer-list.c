@@ -41,15 +41,141 @@ enum {
 
 static GParamSpec *properties[PROP_LAST];
 
+typedef struct {
+    MMBaseBearer *bearer;
+    /* Order in which bearers were added, newest first in the indexes */
+    guint64 seq;
+    /* Path and properties key the bearer is indexed with */
+    gchar *path;
+    gchar *key;
+    gulong config_id;
+    gulong path_id;
+} BearerEntry;
+
 struct _MMBearerListPrivate {
     /* List of bearers */
     GList *bearers;
+    /* Bearer -> BearerEntry */
+    GHashTable *entries;
+    /* Path -> BearerEntry */
+    GHashTable *by_path;
+    /* Properties key -> GList of BearerEntry, newest first */
+    GHashTable *by_key;
+    guint64 last_seq;
     /* Max number of bearers */
     guint max_bearers;
     /* Max number of active bearers */
     guint max_active_bearers;
 };
 
+/*****************************************************************************/
+/* Indexes
+ *
+ * Bearers are indexed by path and by the key of their properties, and
+ * re-indexed whenever either changes. Several bearers may share the same
+ * properties, in which case lookups find the newest one. */
+
+static gint
+entry_cmp_newest_first (const BearerEntry *a,
+                        const BearerEntry *b)
+{
+    return (a->seq < b->seq) - (a->seq > b->seq);
+}
+
+static void
+entry_unindex (MMBearerList *self,
+               BearerEntry  *entry)
+{
+    if (entry->path) {
+        if (g_hash_table_lookup (self->priv->by_path, entry->path) == entry)
+            g_hash_table_remove (self->priv->by_path, entry->path);
+        g_free (entry->path);
+        entry->path = NULL;
+    }
+
+    if (entry->key) {
+        GList *same;
+
+        same = g_hash_table_lookup (self->priv->by_key, entry->key);
+        same = g_list_remove (same, entry);
+        if (same)
+            g_hash_table_replace (self->priv->by_key, g_strdup (entry->key), same);
+        else
+            g_hash_table_remove (self->priv->by_key, entry->key);
+        g_free (entry->key);
+        entry->key = NULL;
+    }
+}
+
+static void
+entry_index (MMBearerList *self,
+             BearerEntry  *entry)
+{
+    MMBearerProperties *config;
+    const gchar *path;
+
+    path = mm_base_bearer_get_path (entry->bearer);
+    if (path) {
+        entry->path = g_strdup (path);
+        g_hash_table_replace (self->priv->by_path, entry->path, entry);
+    }
+
+    config = mm_base_bearer_peek_config (entry->bearer);
+    if (config) {
+        GList *same;
+
+        entry->key = mm_bearer_properties_build_key (config);
+        same = g_hash_table_lookup (self->priv->by_key, entry->key);
+        same = g_list_insert_sorted (same, entry, (GCompareFunc) entry_cmp_newest_first);
+        g_hash_table_replace (self->priv->by_key, g_strdup (entry->key), same);
+    }
+}
+
+static void
+bearer_indexed_property_changed (MMBaseBearer *bearer,
+                                 GParamSpec   *pspec,
+                                 MMBearerList *self)
+{
+    BearerEntry *entry;
+
+    entry = g_hash_table_lookup (self->priv->entries, bearer);
+    g_assert (entry != NULL);
+    entry_unindex (self, entry);
+    entry_index (self, entry);
+}
+
+static BearerEntry *
+entry_new (MMBearerList *self,
+           MMBaseBearer *bearer)
+{
+    BearerEntry *entry;
+
+    entry = g_slice_new0 (BearerEntry);
+    entry->bearer = g_object_ref (bearer);
+    entry->seq = ++self->priv->last_seq;
+    entry->config_id = g_signal_connect (bearer,
+                                         "notify::" MM_BASE_BEARER_CONFIG,
+                                         G_CALLBACK (bearer_indexed_property_changed),
+                                         self);
+    entry->path_id = g_signal_connect (bearer,
+                                       "notify::" MM_BASE_BEARER_PATH,
+                                       G_CALLBACK (bearer_indexed_property_changed),
+                                       self);
+    entry_index (self, entry);
+    return entry;
+}
+
+static void
+entry_free (MMBearerList *self,
+            BearerEntry  *entry)
+{
+    entry_unindex (self, entry);
+    g_signal_handler_disconnect (entry->bearer, entry->config_id);
+    g_signal_handler_disconnect (entry->bearer, entry->path_id);
+    g_object_unref (entry->bearer);
+    g_slice_free (BearerEntry, entry);
+}
+
 /*****************************************************************************/
 
 guint
@@ -93,6 +219,7 @@ mm_bearer_list_add_bearer (MMBearerList *self,
 
     /* Keep our own reference */
     self->priv->bearers = g_list_prepend (self->priv->bearers, g_object_ref (bearer));
+    g_hash_table_insert (self->priv->entries, bearer, entry_new (self, bearer));
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_NUM_BEARERS]);
 
     return TRUE;
@@ -103,15 +230,19 @@ mm_bearer_list_delete_bearer (MMBearerList *self,
                               const gchar *path,
                               GError **error)
 {
-    GList *l;
-
-    for (l = self->priv->bearers; l; l = g_list_next (l)) {
-        if (g_str_equal (path, mm_base_bearer_get_path (MM_BASE_BEARER (l->data)))) {
-            g_object_unref (l->data);
-            self->priv->bearers = g_list_delete_link (self->priv->bearers, l);
-            g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_NUM_BEARERS]);
-            return TRUE;
-        }
+    BearerEntry *entry;
+
+    entry = g_hash_table_lookup (self->priv->by_path, path);
+    if (entry) {
+        MMBaseBearer *bearer;
+
+        bearer = entry->bearer;
+        g_hash_table_remove (self->priv->entries, bearer);
+        entry_free (self, entry);
+        self->priv->bearers = g_list_remove (self->priv->bearers, bearer);
+        g_object_unref (bearer);
+        g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_NUM_BEARERS]);
+        return TRUE;
     }
 
     g_set_error (error,
@@ -150,36 +281,36 @@ MMBaseBearer *
 mm_bearer_list_find_by_properties (MMBearerList *self,
                                    MMBearerProperties *properties)
 {
-    GList *l;
+    GList *same;
+    gchar *key;
 
-    for (l = self->priv->bearers; l; l = g_list_next (l)) {
-        if (mm_bearer_properties_cmp (mm_base_bearer_peek_config (MM_BASE_BEARER (l->data)), properties))
-            return g_object_ref (l->data);
-    }
+    key = mm_bearer_properties_build_key (properties);
+    same = g_hash_table_lookup (self->priv->by_key, key);
+    g_free (key);
 
-    return NULL;
+    return (same ? g_object_ref (((BearerEntry *) same->data)->bearer) : NULL);
 }
 
 MMBaseBearer *
 mm_bearer_list_find_by_path (MMBearerList *self,
                              const gchar *path)
 {
-    GList *l;
+    BearerEntry *entry;
 
-    for (l = self->priv->bearers; l; l = g_list_next (l)) {
-        if (g_str_equal (path, mm_base_bearer_get_path (MM_BASE_BEARER (l->data))))
-            return g_object_ref (l->data);
-    }
-
-    return NULL;
+    entry = g_hash_table_lookup (self->priv->by_path, path);
+    return (entry ? g_object_ref (entry->bearer) : NULL);
 }
 
 /*****************************************************************************/
 
 typedef struct {
     GSimpleAsyncResult *result;
+    /* Bearers to disconnect one after the other */
     GList *pending;
     MMBaseBearer *current;
+    /* Concurrent disconnections, plus the sequential chain */
+    guint n_running;
+    GError *error;
 } DisconnectAllContext;
 
 static void
@@ -201,6 +332,41 @@ mm_bearer_list_disconnect_all_bearers_finish (MMBearerList *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+static void
+disconnect_all_running_done (DisconnectAllContext *ctx,
+                             GError *error)
+{
+    /* Only the first error is reported */
+    if (error) {
+        if (!ctx->error)
+            ctx->error = error;
+        else
+            g_error_free (error);
+    }
+
+    g_assert (ctx->n_running > 0);
+    if (--ctx->n_running > 0)
+        return;
+
+    if (ctx->error)
+        g_simple_async_result_take_error (ctx->result, ctx->error);
+    else
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    disconnect_all_context_complete_and_free (ctx);
+}
+
+static void
+concurrent_disconnect_ready (MMBaseBearer *bearer,
+                             GAsyncResult *res,
+                             DisconnectAllContext *ctx)
+{
+    GError *error = NULL;
+
+    mm_base_bearer_disconnect_finish (bearer, res, &error);
+    g_object_unref (bearer);
+    disconnect_all_running_done (ctx, error);
+}
+
 static void disconnect_next_bearer (DisconnectAllContext *ctx);
 
 static void
@@ -211,8 +377,11 @@ disconnect_ready (MMBaseBearer *bearer,
     GError *error = NULL;
 
     if (!mm_base_bearer_disconnect_finish (bearer, res, &error)) {
-        g_simple_async_result_take_error (ctx->result, error);
-        disconnect_all_context_complete_and_free (ctx);
+        /* Don't go on with the sequential ones */
+        g_list_free_full (ctx->pending, (GDestroyNotify) g_object_unref);
+        ctx->pending = NULL;
+        g_clear_object (&ctx->current);
+        disconnect_all_running_done (ctx, error);
         return;
     }
 
@@ -227,8 +396,7 @@ disconnect_next_bearer (DisconnectAllContext *ctx)
 
     /* No more bearers? all done! */
     if (!ctx->pending) {
-        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-        disconnect_all_context_complete_and_free (ctx);
+        disconnect_all_running_done (ctx, NULL);
         return;
     }
 
@@ -246,15 +414,34 @@ mm_bearer_list_disconnect_all_bearers (MMBearerList *self,
                                        gpointer user_data)
 {
     DisconnectAllContext *ctx;
+    GList *concurrent = NULL;
+    GList *l;
 
     ctx = g_new0 (DisconnectAllContext, 1);
     ctx->result = g_simple_async_result_new (G_OBJECT (self),
                                              callback,
                                              user_data,
                                              mm_bearer_list_disconnect_all_bearers);
-    /* Get a copy of the list */
-    ctx->pending = g_list_copy (self->priv->bearers);
-    g_list_foreach (ctx->pending, (GFunc) g_object_ref, NULL);
+
+    /* Bearers which can be disconnected at the same time as others are all
+     * disconnected at once; the rest, one by one, keeping the list order */
+    for (l = self->priv->bearers; l; l = g_list_next (l)) {
+        if (mm_base_bearer_supports_concurrent_disconnect (MM_BASE_BEARER (l->data)))
+            concurrent = g_list_prepend (concurrent, g_object_ref (l->data));
+        else
+            ctx->pending = g_list_prepend (ctx->pending, g_object_ref (l->data));
+    }
+    ctx->pending = g_list_reverse (ctx->pending);
+
+    /* All running ones must be accounted for before any completes */
+    ctx->n_running = 1 + g_list_length (concurrent);
+
+    for (l = concurrent; l; l = g_list_next (l))
+        /* Reference transferred to the callback */
+        mm_base_bearer_disconnect (MM_BASE_BEARER (l->data),
+                                   (GAsyncReadyCallback)concurrent_disconnect_ready,
+                                   ctx);
+    g_list_free (concurrent);
 
     disconnect_next_bearer (ctx);
 }
@@ -331,6 +518,10 @@ mm_bearer_list_init (MMBearerList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_BEARER_LIST,
                                               MMBearerListPrivate);
+
+    self->priv->entries = g_hash_table_new (g_direct_hash, g_direct_equal);
+    self->priv->by_path = g_hash_table_new (g_str_hash, g_str_equal);
+    self->priv->by_key = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 }
 
 static void
@@ -338,6 +529,23 @@ dispose (GObject *object)
 {
     MMBearerList *self = MM_BEARER_LIST (object);
 
+    if (self->priv->entries) {
+        GHashTableIter iter;
+        BearerEntry *entry;
+
+        g_hash_table_iter_init (&iter, self->priv->entries);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+            g_hash_table_iter_remove (&iter);
+            entry_free (self, entry);
+        }
+        g_hash_table_unref (self->priv->entries);
+        self->priv->entries = NULL;
+        g_hash_table_unref (self->priv->by_path);
+        self->priv->by_path = NULL;
+        g_hash_table_unref (self->priv->by_key);
+        self->priv->by_key = NULL;
+    }
+
     if (self->priv->bearers) {
         g_list_free_full (self->priv->bearers, (GDestroyNotify) g_object_unref);
         self->priv->bearers = NULL;
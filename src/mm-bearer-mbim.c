@@ -47,6 +47,8 @@ struct _MMBearerMbimPrivate {
     guint32 session_id;
 
     MMPort *data;
+    /* Set when 'data' is the link of a session other than 0 */
+    MMPortMbim *mbim;
 };
 
 /*****************************************************************************/
@@ -84,10 +86,19 @@ peek_ports (gpointer self,
     }
 
     if (o_data) {
-        MMPort *port;
+        MMPort *port = NULL;
 
-        /* Grab a data port */
-        port = mm_base_modem_peek_best_data_port (modem, MM_PORT_TYPE_NET);
+        /* Grab a data port; sessions other than 0 run in their own link, so
+         * they don't care whether the net port is being used by another one */
+        if (MM_BEARER_MBIM (self)->priv->session_id > 0) {
+            GList *l;
+
+            for (l = mm_base_modem_peek_data_ports (modem); l && !port; l = g_list_next (l)) {
+                if (mm_port_get_port_type (MM_PORT (l->data)) == MM_PORT_TYPE_NET)
+                    port = MM_PORT (l->data);
+            }
+        } else
+            port = mm_base_modem_peek_best_data_port (modem, MM_PORT_TYPE_NET);
         if (!port) {
             g_simple_async_report_error_in_idle (G_OBJECT (self),
                                                  callback,
@@ -193,6 +204,32 @@ reload_stats (MMBaseBearer *self,
     ReloadStatsContext *ctx;
     MbimMessage *message;
 
+    /* The device statistics cover all the sessions, so use the counters of
+     * the link when there is one */
+    if (MM_BEARER_MBIM (self)->priv->mbim) {
+        ReloadStatsResult *stats;
+        GSimpleAsyncResult *result;
+        GError *error = NULL;
+
+        result = g_simple_async_result_new (G_OBJECT (self),
+                                            callback,
+                                            user_data,
+                                            reload_stats);
+        stats = g_new0 (ReloadStatsResult, 1);
+        if (mm_port_net_get_statistics (MM_BEARER_MBIM (self)->priv->data,
+                                        &stats->rx_bytes,
+                                        &stats->tx_bytes,
+                                        &error))
+            g_simple_async_result_set_op_res_gpointer (result, stats, g_free);
+        else {
+            g_simple_async_result_take_error (result, error);
+            g_free (stats);
+        }
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
     if (!peek_ports (self, &device, NULL, callback, user_data))
         return;
 
@@ -220,6 +257,7 @@ typedef enum {
     CONNECT_STEP_FIRST,
     CONNECT_STEP_PACKET_SERVICE,
     CONNECT_STEP_PROVISIONED_CONTEXTS,
+    CONNECT_STEP_SESSION_LINK,
     CONNECT_STEP_CONNECT,
     CONNECT_STEP_IP_CONFIGURATION,
     CONNECT_STEP_LAST
@@ -233,8 +271,12 @@ typedef struct {
     MMBearerProperties *properties;
     ConnectStep step;
     MMPort *data;
+    MMPortMbim *mbim;
+    MMPort *link;
     MbimContextIpType ip_type;
     MMBearerConnectResult *connect_result;
+    /* Set when taking over an already activated session */
+    gboolean adopt;
 } ConnectContext;
 
 static void
@@ -244,6 +286,12 @@ connect_context_complete_and_free (ConnectContext *ctx)
     g_object_unref (ctx->result);
     if (ctx->connect_result)
         mm_bearer_connect_result_unref (ctx->connect_result);
+    /* Only set if the connection wasn't established */
+    if (ctx->link) {
+        mm_port_mbim_del_session_link (ctx->mbim, ctx->link);
+        g_object_unref (ctx->link);
+    }
+    g_clear_object (&ctx->mbim);
     g_object_unref (ctx->data);
     g_object_unref (ctx->cancellable);
     g_object_unref (ctx->properties);
@@ -544,7 +592,7 @@ ip_configuration_query_ready (MbimDevice *device,
             ipv6_config = NULL;
 
         /* Store result */
-        ctx->connect_result = mm_bearer_connect_result_new (ctx->data,
+        ctx->connect_result = mm_bearer_connect_result_new (ctx->link ? ctx->link : ctx->data,
                                                             ipv4_config,
                                                             ipv6_config);
 
@@ -566,6 +614,7 @@ ip_configuration_query_ready (MbimDevice *device,
         connect_context_complete_and_free (ctx);
         return;
     }
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_IP_CONFIG);
 
     /* Keep on */
     ctx->step++;
@@ -630,6 +679,7 @@ connect_set_ready (MbimDevice *device,
         connect_context_complete_and_free (ctx);
         return;
     }
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
 
     /* Keep on */
     ctx->step++;
@@ -681,6 +731,9 @@ provisioned_contexts_query_ready (MbimDevice *device,
     if (response)
         mbim_message_unref (response);
 
+    /* The packet service attach is accounted in this step as well */
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_CONTEXT_SELECTION);
+
     /* Keep on */
     ctx->step++;
     connect_context_step (ctx);
@@ -814,6 +867,35 @@ connect_context_step (ConnectContext *ctx)
         mbim_message_unref (message);
         return;
 
+    case CONNECT_STEP_SESSION_LINK:
+        if (ctx->self->priv->session_id > 0) {
+            MMBaseModem *modem = NULL;
+            GError *error = NULL;
+
+            g_object_get (ctx->self,
+                          MM_BASE_BEARER_MODEM, &modem,
+                          NULL);
+            ctx->mbim = mm_base_modem_get_port_mbim (modem);
+            g_object_unref (modem);
+
+            if (ctx->mbim)
+                ctx->link = mm_port_mbim_add_session_link (ctx->mbim,
+                                                           ctx->data,
+                                                           ctx->self->priv->session_id,
+                                                           &error);
+            else
+                error = g_error_new (MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                                     "Couldn't get MBIM port");
+            if (!ctx->link) {
+                g_simple_async_result_take_error (ctx->result, error);
+                connect_context_complete_and_free (ctx);
+                return;
+            }
+        }
+
+        /* Fall down */
+        ctx->step++;
+
     case CONNECT_STEP_CONNECT: {
         const gchar *apn;
         const gchar *user;
@@ -822,6 +904,13 @@ connect_context_step (ConnectContext *ctx)
         MMBearerIpFamily ip_family;
         GError *error = NULL;
 
+        /* Adopted sessions are already activated */
+        if (ctx->adopt) {
+            ctx->step++;
+            connect_context_step (ctx);
+            return;
+        }
+
         /* Setup parameters to use */
 
         apn = mm_bearer_properties_get_apn (ctx->properties);
@@ -964,12 +1053,18 @@ connect_context_step (ConnectContext *ctx)
     }
 
     case CONNECT_STEP_LAST:
-        /* Port is connected; update the state */
-        mm_port_set_connected (MM_PORT (ctx->data), TRUE);
-
-        /* Keep the data port */
+        /* Keep the data port; when there is a session link, that is the
+         * one flagged as connected */
         g_assert (ctx->self->priv->data == NULL);
-        ctx->self->priv->data = g_object_ref (ctx->data);
+        if (ctx->link) {
+            ctx->self->priv->data = ctx->link;
+            ctx->self->priv->mbim = g_object_ref (ctx->mbim);
+            ctx->link = NULL;
+        } else
+            ctx->self->priv->data = g_object_ref (ctx->data);
+
+        /* Port is connected; update the state */
+        mm_port_set_connected (ctx->self->priv->data, TRUE);
 
         /* Set operation result */
         g_simple_async_result_set_op_res_gpointer (
@@ -1044,6 +1139,136 @@ _connect (MMBaseBearer *self,
     connect_context_step (ctx);
 }
 
+/*****************************************************************************/
+/* Adopt
+ *
+ * If the session of this bearer is already activated in the device (e.g.
+ * left behind by a previous daemon instance), run the connection sequence
+ * skipping the activation itself, so that the session is kept as it is and
+ * just its IP configuration is loaded.
+ */
+
+static void
+adopt_connect_query_ready (MbimDevice *device,
+                           GAsyncResult *res,
+                           ConnectContext *ctx)
+{
+    GError *error = NULL;
+    MbimMessage *response;
+    MbimActivationState activation_state = MBIM_ACTIVATION_STATE_UNKNOWN;
+    MbimContextIpType ip_type = MBIM_CONTEXT_IP_TYPE_DEFAULT;
+
+    response = mbim_device_command_finish (device, res, &error);
+    if (response &&
+        mbim_message_response_get_result (response, MBIM_MESSAGE_TYPE_COMMAND_DONE, &error))
+        mbim_message_connect_response_parse (
+            response,
+            NULL, /* session_id */
+            &activation_state,
+            NULL, /* voice_call_state */
+            &ip_type,
+            NULL, /* context_type */
+            NULL, /* nw_error */
+            &error);
+
+    if (response)
+        mbim_message_unref (response);
+
+    if (!error && activation_state != MBIM_ACTIVATION_STATE_ACTIVATED)
+        error = g_error_new (MM_CORE_ERROR,
+                             MM_CORE_ERROR_NOT_FOUND,
+                             "No data session to adopt (%s)",
+                             mbim_activation_state_get_string (activation_state));
+
+    if (error) {
+        g_simple_async_result_take_error (ctx->result, error);
+        connect_context_complete_and_free (ctx);
+        return;
+    }
+
+    switch (ip_type) {
+    case MBIM_CONTEXT_IP_TYPE_IPV6:
+        ctx->ip_type = ip_type;
+        mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self), NULL, MM_BEARER_IP_FAMILY_IPV6);
+        break;
+    case MBIM_CONTEXT_IP_TYPE_IPV4V6:
+        ctx->ip_type = ip_type;
+        mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self), NULL, MM_BEARER_IP_FAMILY_IPV4V6);
+        break;
+    case MBIM_CONTEXT_IP_TYPE_IPV4_AND_IPV6:
+        ctx->ip_type = ip_type;
+        mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self), NULL,
+                                              MM_BEARER_IP_FAMILY_IPV4 | MM_BEARER_IP_FAMILY_IPV6);
+        break;
+    default:
+        ctx->ip_type = MBIM_CONTEXT_IP_TYPE_IPV4;
+        mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self), NULL, MM_BEARER_IP_FAMILY_IPV4);
+        break;
+    }
+
+    mm_dbg ("Adopting session ID '%u' (IP type: %s)",
+            ctx->self->priv->session_id,
+            mbim_context_ip_type_get_string (ctx->ip_type));
+
+    /* Packet service and provisioned contexts are not needed, the session
+     * is already there */
+    ctx->step = CONNECT_STEP_SESSION_LINK;
+    connect_context_step (ctx);
+}
+
+static void
+adopt (MMBaseBearer *self,
+       GCancellable *cancellable,
+       GAsyncReadyCallback callback,
+       gpointer user_data)
+{
+    ConnectContext *ctx;
+    MMPort *data;
+    MbimDevice *device;
+    MbimMessage *message;
+    GError *error = NULL;
+
+    if (!peek_ports (self, &device, &data, callback, user_data))
+        return;
+
+    message = (mbim_message_connect_query_new (
+                   MM_BEARER_MBIM (self)->priv->session_id,
+                   MBIM_ACTIVATION_STATE_UNKNOWN,
+                   MBIM_VOICE_CALL_STATE_NONE,
+                   MBIM_CONTEXT_IP_TYPE_DEFAULT,
+                   mbim_uuid_from_context_type (MBIM_CONTEXT_TYPE_INTERNET),
+                   0,
+                   &error));
+    if (!message) {
+        g_simple_async_report_take_gerror_in_idle (G_OBJECT (self), callback, user_data, error);
+        return;
+    }
+
+    ctx = g_slice_new0 (ConnectContext);
+    ctx->self = g_object_ref (self);
+    ctx->device = g_object_ref (device);
+    ctx->data = g_object_ref (data);
+    ctx->cancellable = g_object_ref (cancellable);
+    ctx->adopt = TRUE;
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             adopt);
+
+    g_object_get (self,
+                  MM_BASE_BEARER_CONFIG, &ctx->properties,
+                  NULL);
+
+    mm_dbg ("Checking whether session ID '%u' can be adopted...", MM_BEARER_MBIM (self)->priv->session_id);
+    mbim_device_command (device,
+                         message,
+                         10,
+                         NULL,
+                         (GAsyncReadyCallback)adopt_connect_query_ready,
+                         ctx);
+    mbim_message_unref (message);
+}
+
 /*****************************************************************************/
 /* Disconnect */
 
@@ -1084,6 +1309,10 @@ reset_bearer_connection (MMBearerMbim *self)
 {
     if (self->priv->data) {
         mm_port_set_connected (self->priv->data, FALSE);
+        if (self->priv->mbim) {
+            mm_port_mbim_del_session_link (self->priv->mbim, self->priv->data);
+            g_clear_object (&self->priv->mbim);
+        }
         g_clear_object (&self->priv->data);
     }
 }
@@ -1350,6 +1579,10 @@ dispose (GObject *object)
 {
     MMBearerMbim *self = MM_BEARER_MBIM (object);
 
+    if (self->priv->mbim) {
+        mm_port_mbim_del_session_link (self->priv->mbim, self->priv->data);
+        g_clear_object (&self->priv->mbim);
+    }
     g_clear_object (&self->priv->data);
 
     G_OBJECT_CLASS (mm_bearer_mbim_parent_class)->dispose (object);
@@ -1370,8 +1603,12 @@ mm_bearer_mbim_class_init (MMBearerMbimClass *klass)
 
     base_bearer_class->connect = _connect;
     base_bearer_class->connect_finish = connect_finish;
+    base_bearer_class->adopt = adopt;
+    base_bearer_class->adopt_finish = connect_finish;
     base_bearer_class->disconnect = disconnect;
     base_bearer_class->disconnect_finish = disconnect_finish;
+    /* Each bearer has its own session id */
+    base_bearer_class->concurrent_disconnect = TRUE;
     base_bearer_class->report_connection_status = report_connection_status;
     base_bearer_class->reload_stats = reload_stats;
     base_bearer_class->reload_stats_finish = reload_stats_finish;
@@ -49,6 +49,11 @@ struct _MMBearerQmiPrivate {
     MMPort *data;
     guint32 packet_data_handle_ipv4;
     guint32 packet_data_handle_ipv6;
+
+    /* When multiplexed, 'data' is the QMAP link created in this port */
+    MMPortQmi *qmi;
+    MMPort *mux_parent;
+    guint mux_id;
 };
 
 /*****************************************************************************/
@@ -218,22 +223,40 @@ typedef enum {
     CONNECT_STEP_FIRST,
     CONNECT_STEP_OPEN_QMI_PORT,
     CONNECT_STEP_IP_METHOD,
-    CONNECT_STEP_IPV4,
-    CONNECT_STEP_WDS_CLIENT_IPV4,
-    CONNECT_STEP_IP_FAMILY_IPV4,
-    CONNECT_STEP_ENABLE_INDICATIONS_IPV4,
-    CONNECT_STEP_START_NETWORK_IPV4,
-    CONNECT_STEP_GET_CURRENT_SETTINGS_IPV4,
-    CONNECT_STEP_IPV6,
-    CONNECT_STEP_WDS_CLIENT_IPV6,
-    CONNECT_STEP_IP_FAMILY_IPV6,
-    CONNECT_STEP_ENABLE_INDICATIONS_IPV6,
-    CONNECT_STEP_START_NETWORK_IPV6,
-    CONNECT_STEP_GET_CURRENT_SETTINGS_IPV6,
+    CONNECT_STEP_MUX_LINK,
+    CONNECT_STEP_IP_FAMILIES,
     CONNECT_STEP_LAST
 } ConnectStep;
 
+typedef enum {
+    CONNECT_FAMILY_STEP_FIRST,
+    CONNECT_FAMILY_STEP_WDS_CLIENT,
+    CONNECT_FAMILY_STEP_BIND_MUX,
+    CONNECT_FAMILY_STEP_IP_FAMILY,
+    CONNECT_FAMILY_STEP_ENABLE_INDICATIONS,
+    CONNECT_FAMILY_STEP_START_NETWORK,
+    CONNECT_FAMILY_STEP_GET_CURRENT_SETTINGS,
+    CONNECT_FAMILY_STEP_LAST
+} ConnectFamilyStep;
+
+typedef struct _ConnectContext ConnectContext;
+
+/* Session setup of a single IP family. Each family uses its own WDS client,
+ * so the IPv4 and IPv6 setups of dual stack bearers run in parallel. */
 typedef struct {
+    ConnectContext *ctx;
+    ConnectFamilyStep step;
+    const gchar *name;
+    QmiWdsIpFamily ip_family;
+    MMPortQmiFlag flag;
+    QmiClientWds *client;
+    gboolean default_ip_family_set;
+    guint packet_service_status_indication_id;
+    guint32 packet_data_handle;
+    GError *error;
+} ConnectFamilyContext;
+
+struct _ConnectContext {
     MMBearerQmi *self;
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
@@ -245,26 +268,38 @@ typedef struct {
     gchar *apn;
     QmiWdsAuthentication auth;
     gboolean no_ip_family_preference;
-    gboolean default_ip_family_set;
 
     MMBearerIpMethod ip_method;
 
+    /* QMAP link, if the QMI port is multiplexed */
+    MMPort *link;
+    guint mux_id;
+
     gboolean ipv4;
-    gboolean running_ipv4;
-    QmiClientWds *client_ipv4;
-    guint packet_service_status_ipv4_indication_id;
-    guint32 packet_data_handle_ipv4;
+    ConnectFamilyContext family_ipv4;
     MMBearerIpConfig *ipv4_config;
-    GError *error_ipv4;
 
     gboolean ipv6;
-    gboolean running_ipv6;
-    QmiClientWds *client_ipv6;
-    guint packet_service_status_ipv6_indication_id;
-    guint32 packet_data_handle_ipv6;
+    ConnectFamilyContext family_ipv6;
     MMBearerIpConfig *ipv6_config;
-    GError *error_ipv6;
-} ConnectContext;
+
+    /* Number of IP family setups still running */
+    guint families_pending;
+};
+
+static void
+connect_family_context_clear (ConnectFamilyContext *fctx)
+{
+    if (fctx->packet_service_status_indication_id) {
+        common_setup_cleanup_unsolicited_events (fctx->ctx->self,
+                                                 fctx->client,
+                                                 FALSE,
+                                                 &fctx->packet_service_status_indication_id);
+    }
+
+    g_clear_error (&fctx->error);
+    g_clear_object (&fctx->client);
+}
 
 static void
 connect_context_complete_and_free (ConnectContext *ctx)
@@ -275,25 +310,15 @@ connect_context_complete_and_free (ConnectContext *ctx)
     g_free (ctx->user);
     g_free (ctx->password);
 
-    if (ctx->packet_service_status_ipv4_indication_id) {
-        common_setup_cleanup_unsolicited_events (ctx->self,
-                                                 ctx->client_ipv4,
-                                                 FALSE,
-                                                 &ctx->packet_service_status_ipv4_indication_id);
-    }
-    if (ctx->packet_service_status_ipv6_indication_id) {
-        common_setup_cleanup_unsolicited_events (ctx->self,
-                                                 ctx->client_ipv6,
-                                                 FALSE,
-                                                 &ctx->packet_service_status_ipv6_indication_id);
-    }
-
-    g_clear_error (&ctx->error_ipv4);
-    g_clear_error (&ctx->error_ipv6);
-    g_clear_object (&ctx->client_ipv4);
-    g_clear_object (&ctx->client_ipv6);
+    connect_family_context_clear (&ctx->family_ipv4);
+    connect_family_context_clear (&ctx->family_ipv6);
     g_clear_object (&ctx->ipv4_config);
     g_clear_object (&ctx->ipv6_config);
+    /* Only set if the connection wasn't established */
+    if (ctx->link) {
+        mm_port_qmi_del_mux_link (ctx->qmi, ctx->data, ctx->mux_id);
+        g_object_unref (ctx->link);
+    }
     g_object_unref (ctx->data);
     g_object_unref (ctx->qmi);
     g_object_unref (ctx->cancellable);
@@ -313,18 +338,16 @@ connect_finish (MMBaseBearer *self,
 }
 
 static void connect_context_step (ConnectContext *ctx);
+static void connect_family_step (ConnectFamilyContext *fctx);
 
 static void
 start_network_ready (QmiClientWds *client,
                      GAsyncResult *res,
-                     ConnectContext *ctx)
+                     ConnectFamilyContext *fctx)
 {
     GError *error = NULL;
     QmiMessageWdsStartNetworkOutput *output;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-    g_assert (!(ctx->running_ipv4 && ctx->running_ipv6));
-
     output = qmi_client_wds_start_network_finish (client, res, &error);
     if (output &&
         !qmi_message_wds_start_network_output_get_result (output, &error)) {
@@ -338,14 +361,11 @@ start_network_ready (QmiClientWds *client,
                              QMI_PROTOCOL_ERROR_NO_EFFECT)) {
             g_error_free (error);
             error = NULL;
-            if (ctx->running_ipv4)
-                ctx->packet_data_handle_ipv4 = GLOBAL_PACKET_DATA_HANDLE;
-            else
-                ctx->packet_data_handle_ipv6 = GLOBAL_PACKET_DATA_HANDLE;
+            fctx->packet_data_handle = GLOBAL_PACKET_DATA_HANDLE;
 
             /* Fall down to a successful connection */
         } else {
-            mm_info ("error: couldn't start network: %s", error->message);
+            mm_info ("error: couldn't start %s network: %s", fctx->name, error->message);
             if (g_error_matches (error,
                                  QMI_PROTOCOL_ERROR,
                                  QMI_PROTOCOL_ERROR_CALL_FAILED)) {
@@ -375,35 +395,28 @@ start_network_ready (QmiClientWds *client,
         }
     }
 
-    if (error) {
-        if (ctx->running_ipv4)
-            ctx->error_ipv4 = error;
-        else
-            ctx->error_ipv6 = error;
-    } else {
-        if (ctx->running_ipv4)
-            qmi_message_wds_start_network_output_get_packet_data_handle (output, &ctx->packet_data_handle_ipv4, NULL);
-        else
-            qmi_message_wds_start_network_output_get_packet_data_handle (output, &ctx->packet_data_handle_ipv6, NULL);
+    if (error)
+        fctx->error = error;
+    else {
+        qmi_message_wds_start_network_output_get_packet_data_handle (output, &fctx->packet_data_handle, NULL);
+        mm_base_bearer_report_connect_step (MM_BASE_BEARER (fctx->ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
     }
 
     if (output)
         qmi_message_wds_start_network_output_unref (output);
 
     /* Keep on */
-    ctx->step++;
-    connect_context_step (ctx);
+    fctx->step++;
+    connect_family_step (fctx);
 }
 
 static QmiMessageWdsStartNetworkInput *
-build_start_network_input (ConnectContext *ctx)
+build_start_network_input (ConnectFamilyContext *fctx)
 {
+    ConnectContext *ctx = fctx->ctx;
     QmiMessageWdsStartNetworkInput *input;
     gboolean has_user, has_password;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-    g_assert (!(ctx->running_ipv4 && ctx->running_ipv6));
-
     input = qmi_message_wds_start_network_input_new ();
 
     if (ctx->apn && ctx->apn[0])
@@ -433,10 +446,10 @@ build_start_network_input (ConnectContext *ctx)
      * TLV if we already set a default IP family preference with "WDS Set IP
      * Family" */
     if (!ctx->no_ip_family_preference &&
-        !ctx->default_ip_family_set) {
+        !fctx->default_ip_family_set) {
         qmi_message_wds_start_network_input_set_ip_family_preference (
             input,
-            (ctx->running_ipv6 ? QMI_WDS_IP_FAMILY_IPV6 : QMI_WDS_IP_FAMILY_IPV4),
+            fctx->ip_family,
             NULL);
     }
 
@@ -636,13 +649,12 @@ get_ipv6_config (MMBearerQmi *self,
 static void
 get_current_settings_ready (QmiClientWds *client,
                             GAsyncResult *res,
-                            ConnectContext *ctx)
+                            ConnectFamilyContext *fctx)
 {
+    ConnectContext *ctx = fctx->ctx;
     GError *error = NULL;
     QmiMessageWdsGetCurrentSettingsOutput *output;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-
     output = qmi_client_wds_get_current_settings_finish (client, res, &error);
     if (!output ||
         !qmi_message_wds_get_current_settings_output_get_result (output, &error)) {
@@ -669,10 +681,15 @@ get_current_settings_ready (QmiClientWds *client,
             g_clear_error (&error);
         }
 
-        if (ip_family == QMI_WDS_IP_FAMILY_IPV4)
+        /* Both setups run in parallel, so never leak the settings already
+         * reported for the same family */
+        if (ip_family == QMI_WDS_IP_FAMILY_IPV4) {
+            g_clear_object (&ctx->ipv4_config);
             ctx->ipv4_config = get_ipv4_config (ctx->self, ctx->ip_method, output, mtu);
-        else if (ip_family == QMI_WDS_IP_FAMILY_IPV6)
+        } else if (ip_family == QMI_WDS_IP_FAMILY_IPV6) {
+            g_clear_object (&ctx->ipv6_config);
             ctx->ipv6_config = get_ipv6_config (ctx->self, ctx->ip_method, output, mtu);
+        }
 
         /* Domain names */
         if (qmi_message_wds_get_current_settings_output_get_domain_name_list (output, &array, &error)) {
@@ -695,19 +712,19 @@ get_current_settings_ready (QmiClientWds *client,
     if (output)
         qmi_message_wds_get_current_settings_output_unref (output);
 
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_IP_CONFIG);
+
     /* Keep on */
-    ctx->step++;
-    connect_context_step (ctx);
+    fctx->step++;
+    connect_family_step (fctx);
 }
 
 static void
-get_current_settings (ConnectContext *ctx, QmiClientWds *client)
+get_current_settings (ConnectFamilyContext *fctx)
 {
     QmiMessageWdsGetCurrentSettingsInput *input;
     QmiWdsGetCurrentSettingsRequestedSettings requested;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-
     requested = QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_DNS_ADDRESS |
                 QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_GRANTED_QOS |
                 QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_IP_ADDRESS |
@@ -718,26 +735,23 @@ get_current_settings (ConnectContext *ctx, QmiClientWds *client)
 
     input = qmi_message_wds_get_current_settings_input_new ();
     qmi_message_wds_get_current_settings_input_set_requested_settings (input, requested, NULL);
-    qmi_client_wds_get_current_settings (client,
+    qmi_client_wds_get_current_settings (fctx->client,
                                          input,
                                          10,
-                                         ctx->cancellable,
+                                         fctx->ctx->cancellable,
                                          (GAsyncReadyCallback)get_current_settings_ready,
-                                         ctx);
+                                         fctx);
     qmi_message_wds_get_current_settings_input_unref (input);
 }
 
 static void
 set_ip_family_ready (QmiClientWds *client,
                      GAsyncResult *res,
-                     ConnectContext *ctx)
+                     ConnectFamilyContext *fctx)
 {
     GError *error = NULL;
     QmiMessageWdsSetIpFamilyOutput *output;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-    g_assert (!(ctx->running_ipv4 && ctx->running_ipv6));
-
     output = qmi_client_wds_set_ip_family_finish (client, res, &error);
     if (output) {
         qmi_message_wds_set_ip_family_output_get_result (output, &error);
@@ -748,15 +762,15 @@ set_ip_family_ready (QmiClientWds *client,
         /* Ensure we add the IP family preference TLV */
         mm_dbg ("Couldn't set IP family preference: '%s'", error->message);
         g_error_free (error);
-        ctx->default_ip_family_set = FALSE;
+        fctx->default_ip_family_set = FALSE;
     } else {
         /* No need to add IP family preference */
-        ctx->default_ip_family_set = TRUE;
+        fctx->default_ip_family_set = TRUE;
     }
 
     /* Keep on */
-    ctx->step++;
-    connect_context_step (ctx);
+    fctx->step++;
+    connect_family_step (fctx);
 }
 
 static void
@@ -828,34 +842,51 @@ common_setup_cleanup_unsolicited_events (MMBearerQmi *self,
     }
 }
 
+#if defined WITH_NEWEST_QMI_COMMANDS
+
 static void
-qmi_port_allocate_client_ready (MMPortQmi *qmi,
-                                GAsyncResult *res,
-                                ConnectContext *ctx)
+bind_mux_data_port_ready (QmiClientWds *client,
+                          GAsyncResult *res,
+                          ConnectFamilyContext *fctx)
 {
-    GError *error = NULL;
+    QmiMessageWdsBindMuxDataPortOutput *output;
 
-    g_assert (ctx->running_ipv4 || ctx->running_ipv6);
-    g_assert (!(ctx->running_ipv4 && ctx->running_ipv6));
+    output = qmi_client_wds_bind_mux_data_port_finish (client, res, &fctx->error);
+    if (!output || !qmi_message_wds_bind_mux_data_port_output_get_result (output, &fctx->error)) {
+        g_prefix_error (&fctx->error, "Couldn't bind %s client to mux id %u: ",
+                        fctx->name, fctx->ctx->mux_id);
+        fctx->step = CONNECT_FAMILY_STEP_LAST;
+    } else
+        fctx->step++;
 
-    if (!mm_port_qmi_allocate_client_finish (qmi, res, &error)) {
-        g_simple_async_result_take_error (ctx->result, error);
-        connect_context_complete_and_free (ctx);
+    if (output)
+        qmi_message_wds_bind_mux_data_port_output_unref (output);
+
+    connect_family_step (fctx);
+}
+
+#endif /* WITH_NEWEST_QMI_COMMANDS */
+
+static void
+qmi_port_allocate_client_ready (MMPortQmi *qmi,
+                                GAsyncResult *res,
+                                ConnectFamilyContext *fctx)
+{
+    if (!mm_port_qmi_allocate_client_finish (qmi, res, &fctx->error)) {
+        /* Only this family fails; the other one may still connect */
+        fctx->step = CONNECT_FAMILY_STEP_LAST;
+        connect_family_step (fctx);
         return;
     }
 
-    if (ctx->running_ipv4)
-        ctx->client_ipv4 = QMI_CLIENT_WDS (mm_port_qmi_get_client (qmi,
-                                                                   QMI_SERVICE_WDS,
-                                                                   MM_PORT_QMI_FLAG_WDS_IPV4));
-    else
-        ctx->client_ipv6 = QMI_CLIENT_WDS (mm_port_qmi_get_client (qmi,
-                                                                   QMI_SERVICE_WDS,
-                                                                   MM_PORT_QMI_FLAG_WDS_IPV6));
+    fctx->client = QMI_CLIENT_WDS (mm_port_qmi_get_client (qmi,
+                                                           QMI_SERVICE_WDS,
+                                                           fctx->flag));
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (fctx->ctx->self), MM_BEARER_CONNECT_STEP_CLIENT_ALLOCATION);
 
     /* Keep on */
-    ctx->step++;
-    connect_context_step (ctx);
+    fctx->step++;
+    connect_family_step (fctx);
 }
 
 static void
@@ -870,6 +901,7 @@ qmi_port_open_ready (MMPortQmi *qmi,
         connect_context_complete_and_free (ctx);
         return;
     }
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_PORT_OPEN);
 
     /* Keep on */
     ctx->step++;
@@ -877,289 +909,297 @@ qmi_port_open_ready (MMPortQmi *qmi,
 }
 
 static void
-connect_context_step (ConnectContext *ctx)
+connect_family_step (ConnectFamilyContext *fctx)
 {
-    /* If cancelled, complete */
-    if (g_cancellable_is_cancelled (ctx->cancellable)) {
-        g_simple_async_result_set_error (ctx->result,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_CANCELLED,
-                                         "Connection setup operation has been cancelled");
-        connect_context_complete_and_free (ctx);
-        return;
+    ConnectContext *ctx = fctx->ctx;
+
+    /* If cancelled, finish this family; the error is reported once both
+     * setups are over */
+    if (fctx->step != CONNECT_FAMILY_STEP_LAST &&
+        g_cancellable_is_cancelled (ctx->cancellable)) {
+        if (!fctx->error)
+            fctx->error = g_error_new (MM_CORE_ERROR,
+                                       MM_CORE_ERROR_CANCELLED,
+                                       "Connection setup operation has been cancelled");
+        fctx->step = CONNECT_FAMILY_STEP_LAST;
     }
 
-    switch (ctx->step) {
-    case CONNECT_STEP_FIRST:
-
-        g_assert (ctx->ipv4 || ctx->ipv6);
-
-        /* Fall down */
-        ctx->step++;
-
-    case CONNECT_STEP_OPEN_QMI_PORT:
-        if (!mm_port_qmi_is_open (ctx->qmi)) {
-            mm_port_qmi_open (ctx->qmi,
-                              TRUE,
-                              ctx->cancellable,
-                              (GAsyncReadyCallback)qmi_port_open_ready,
-                              ctx);
-            return;
-        }
-
-        /* If already open, just fall down */
-        ctx->step++;
-
-    case CONNECT_STEP_IP_METHOD:
-        /* Once the QMI port is open, we decide the IP method we're going
-         * to request. If the LLP is raw-ip, we force Static IP, because not
-         * all DHCP clients support the raw-ip interfaces; otherwise default
-         * to DHCP as always. */
-        if (mm_port_qmi_llp_is_raw_ip (ctx->qmi))
-            ctx->ip_method = MM_BEARER_IP_METHOD_STATIC;
-        else
-            ctx->ip_method = MM_BEARER_IP_METHOD_DHCP;
-
-        mm_dbg ("Defaulting to use %s IP method", mm_bearer_ip_method_get_string (ctx->ip_method));
-
+    switch (fctx->step) {
+    case CONNECT_FAMILY_STEP_FIRST:
+        mm_dbg ("Running %s connection setup", fctx->name);
         /* Just fall down */
-        ctx->step++;
+        fctx->step++;
 
-    case CONNECT_STEP_IPV4:
-        /* If no IPv4 setup needed, jump to IPv6 */
-        if (!ctx->ipv4) {
-            ctx->step = CONNECT_STEP_IPV6;
-            connect_context_step (ctx);
-            return;
-        }
-
-        /* Start IPv4 setup */
-        mm_dbg ("Running IPv4 connection setup");
-        ctx->running_ipv4 = TRUE;
-        ctx->running_ipv6 = FALSE;
-        /* Just fall down */
-        ctx->step++;
-
-    case CONNECT_STEP_WDS_CLIENT_IPV4: {
+    case CONNECT_FAMILY_STEP_WDS_CLIENT: {
         QmiClient *client;
 
         client = mm_port_qmi_get_client (ctx->qmi,
                                          QMI_SERVICE_WDS,
-                                         MM_PORT_QMI_FLAG_WDS_IPV4);
+                                         fctx->flag);
         if (!client) {
-            mm_dbg ("Allocating IPv4-specific WDS client");
+            mm_dbg ("Allocating %s-specific WDS client", fctx->name);
             mm_port_qmi_allocate_client (ctx->qmi,
                                          QMI_SERVICE_WDS,
-                                         MM_PORT_QMI_FLAG_WDS_IPV4,
+                                         fctx->flag,
                                          ctx->cancellable,
                                          (GAsyncReadyCallback)qmi_port_allocate_client_ready,
-                                         ctx);
+                                         fctx);
             return;
         }
 
-        ctx->client_ipv4 = QMI_CLIENT_WDS (client);
+        fctx->client = QMI_CLIENT_WDS (client);
         /* Just fall down */
-        ctx->step++;
+        fctx->step++;
     }
 
-    case CONNECT_STEP_IP_FAMILY_IPV4:
+    case CONNECT_FAMILY_STEP_BIND_MUX:
+#if defined WITH_NEWEST_QMI_COMMANDS
+        /* Clients of multiplexed sessions must be bound to their link */
+        if (ctx->link) {
+            QmiMessageWdsBindMuxDataPortInput *input;
+
+            mm_dbg ("Binding %s client to mux id %u...", fctx->name, ctx->mux_id);
+            input = qmi_message_wds_bind_mux_data_port_input_new ();
+            qmi_message_wds_bind_mux_data_port_input_set_endpoint_info (
+                input,
+                QMI_DATA_ENDPOINT_TYPE_HSUSB,
+                mm_port_qmi_get_interface_number (ctx->qmi),
+                NULL);
+            qmi_message_wds_bind_mux_data_port_input_set_mux_id (input, ctx->mux_id, NULL);
+            qmi_client_wds_bind_mux_data_port (fctx->client,
+                                               input,
+                                               10,
+                                               ctx->cancellable,
+                                               (GAsyncReadyCallback)bind_mux_data_port_ready,
+                                               fctx);
+            qmi_message_wds_bind_mux_data_port_input_unref (input);
+            return;
+        }
+#endif
+        /* Just fall down */
+        fctx->step++;
+
+    case CONNECT_FAMILY_STEP_IP_FAMILY:
         /* If client is new enough, select IP family */
         if (!ctx->no_ip_family_preference &&
-            qmi_client_check_version (QMI_CLIENT (ctx->client_ipv4), 1, 9)) {
+            qmi_client_check_version (QMI_CLIENT (fctx->client), 1, 9)) {
             QmiMessageWdsSetIpFamilyInput *input;
 
-            mm_dbg ("Setting default IP family to: IPv4");
+            mm_dbg ("Setting default IP family to: %s", fctx->name);
             input = qmi_message_wds_set_ip_family_input_new ();
-            qmi_message_wds_set_ip_family_input_set_preference (input, QMI_WDS_IP_FAMILY_IPV4, NULL);
-            qmi_client_wds_set_ip_family (ctx->client_ipv4,
+            qmi_message_wds_set_ip_family_input_set_preference (input, fctx->ip_family, NULL);
+            qmi_client_wds_set_ip_family (fctx->client,
                                           input,
                                           10,
                                           ctx->cancellable,
                                           (GAsyncReadyCallback)set_ip_family_ready,
-                                          ctx);
+                                          fctx);
             qmi_message_wds_set_ip_family_input_unref (input);
             return;
         }
 
-        ctx->default_ip_family_set = FALSE;
+        fctx->default_ip_family_set = FALSE;
 
         /* Just fall down */
-        ctx->step++;
+        fctx->step++;
 
-    case CONNECT_STEP_ENABLE_INDICATIONS_IPV4:
+    case CONNECT_FAMILY_STEP_ENABLE_INDICATIONS:
         common_setup_cleanup_unsolicited_events (ctx->self,
-                                                 ctx->client_ipv4,
+                                                 fctx->client,
                                                  TRUE,
-                                                 &ctx->packet_service_status_ipv4_indication_id);
+                                                 &fctx->packet_service_status_indication_id);
         /* Just fall down */
-        ctx->step++;
+        fctx->step++;
 
-    case CONNECT_STEP_START_NETWORK_IPV4: {
+    case CONNECT_FAMILY_STEP_START_NETWORK: {
         QmiMessageWdsStartNetworkInput *input;
 
-        mm_dbg ("Starting IPv4 connection...");
-        input = build_start_network_input (ctx);
-        qmi_client_wds_start_network (ctx->client_ipv4,
+        mm_dbg ("Starting %s connection...", fctx->name);
+        input = build_start_network_input (fctx);
+        qmi_client_wds_start_network (fctx->client,
                                       input,
                                       45,
                                       ctx->cancellable,
                                       (GAsyncReadyCallback)start_network_ready,
-                                      ctx);
+                                      fctx);
         qmi_message_wds_start_network_input_unref (input);
         return;
     }
 
-    case CONNECT_STEP_GET_CURRENT_SETTINGS_IPV4: {
+    case CONNECT_FAMILY_STEP_GET_CURRENT_SETTINGS:
         /* Retrieve and print IP configuration */
-        if (ctx->packet_data_handle_ipv4) {
-            mm_dbg ("Getting IPv4 configuration...");
-            get_current_settings (ctx, ctx->client_ipv4);
+        if (fctx->packet_data_handle) {
+            mm_dbg ("Getting %s configuration...", fctx->name);
+            get_current_settings (fctx);
             return;
         }
         /* Fall through */
-        ctx->step++;
-    }
-
-    case CONNECT_STEP_IPV6:
-        /* If no IPv6 setup needed, jump to last */
-        if (!ctx->ipv6) {
-            ctx->step = CONNECT_STEP_LAST;
+        fctx->step++;
+
+    case CONNECT_FAMILY_STEP_LAST:
+        /* Once both families are done, go on with the whole connection.
+         * Note that the context may be gone after this. */
+        g_assert (ctx->families_pending > 0);
+        if (--ctx->families_pending == 0) {
+            ctx->step++;
             connect_context_step (ctx);
-            return;
         }
+        return;
+    }
+}
 
-        /* Start IPv6 setup */
-        mm_dbg ("Running IPv6 connection setup");
-        ctx->running_ipv4 = FALSE;
-        ctx->running_ipv6 = TRUE;
-        /* Just fall down */
-        ctx->step++;
-
-    case CONNECT_STEP_WDS_CLIENT_IPV6: {
-        QmiClient *client;
-
-        client = mm_port_qmi_get_client (ctx->qmi,
-                                         QMI_SERVICE_WDS,
-                                         MM_PORT_QMI_FLAG_WDS_IPV6);
-        if (!client) {
-            mm_dbg ("Allocating IPv6-specific WDS client");
-            mm_port_qmi_allocate_client (ctx->qmi,
-                                         QMI_SERVICE_WDS,
-                                         MM_PORT_QMI_FLAG_WDS_IPV6,
-                                         ctx->cancellable,
-                                         (GAsyncReadyCallback)qmi_port_allocate_client_ready,
-                                         ctx);
-            return;
-        }
+static void
+connect_family_context_init (ConnectContext *ctx,
+                             ConnectFamilyContext *fctx,
+                             QmiWdsIpFamily ip_family)
+{
+    fctx->ctx = ctx;
+    fctx->step = CONNECT_FAMILY_STEP_FIRST;
+    fctx->ip_family = ip_family;
+    if (ip_family == QMI_WDS_IP_FAMILY_IPV6) {
+        fctx->name = "IPv6";
+        fctx->flag = MM_PORT_QMI_FLAG_WDS_IPV6;
+    } else {
+        fctx->name = "IPv4";
+        fctx->flag = MM_PORT_QMI_FLAG_WDS_IPV4;
+    }
+}
 
-        ctx->client_ipv6 = QMI_CLIENT_WDS (client);
-        /* Just fall down */
-        ctx->step++;
+static void
+connect_context_step (ConnectContext *ctx)
+{
+    /* If cancelled, complete */
+    if (g_cancellable_is_cancelled (ctx->cancellable)) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_CANCELLED,
+                                         "Connection setup operation has been cancelled");
+        connect_context_complete_and_free (ctx);
+        return;
     }
 
-    case CONNECT_STEP_IP_FAMILY_IPV6:
+    switch (ctx->step) {
+    case CONNECT_STEP_FIRST:
 
-        g_assert (ctx->no_ip_family_preference == FALSE);
+        g_assert (ctx->ipv4 || ctx->ipv6);
 
-        /* If client is new enough, select IP family */
-        if (qmi_client_check_version (QMI_CLIENT (ctx->client_ipv6), 1, 9)) {
-            QmiMessageWdsSetIpFamilyInput *input;
+        /* Fall down */
+        ctx->step++;
 
-            mm_dbg ("Setting default IP family to: IPv6");
-            input = qmi_message_wds_set_ip_family_input_new ();
-            qmi_message_wds_set_ip_family_input_set_preference (input, QMI_WDS_IP_FAMILY_IPV6, NULL);
-            qmi_client_wds_set_ip_family (ctx->client_ipv6,
-                                          input,
-                                          10,
-                                          ctx->cancellable,
-                                          (GAsyncReadyCallback)set_ip_family_ready,
-                                          ctx);
-            qmi_message_wds_set_ip_family_input_unref (input);
+    case CONNECT_STEP_OPEN_QMI_PORT:
+        if (!mm_port_qmi_is_open (ctx->qmi)) {
+            mm_port_qmi_open (ctx->qmi,
+                              TRUE,
+                              ctx->cancellable,
+                              (GAsyncReadyCallback)qmi_port_open_ready,
+                              ctx);
             return;
         }
 
-        ctx->default_ip_family_set = FALSE;
-
-        /* Just fall down */
+        /* If already open, just fall down */
         ctx->step++;
 
-    case CONNECT_STEP_ENABLE_INDICATIONS_IPV6:
-        common_setup_cleanup_unsolicited_events (ctx->self,
-                                                 ctx->client_ipv6,
-                                                 TRUE,
-                                                 &ctx->packet_service_status_ipv6_indication_id);
+    case CONNECT_STEP_IP_METHOD:
+        /* Once the QMI port is open, we decide the IP method we're going
+         * to request. If the LLP is raw-ip, we force Static IP, because not
+         * all DHCP clients support the raw-ip interfaces; otherwise default
+         * to DHCP as always. */
+        if (mm_port_qmi_llp_is_raw_ip (ctx->qmi))
+            ctx->ip_method = MM_BEARER_IP_METHOD_STATIC;
+        else
+            ctx->ip_method = MM_BEARER_IP_METHOD_DHCP;
+
+        mm_dbg ("Defaulting to use %s IP method", mm_bearer_ip_method_get_string (ctx->ip_method));
+
         /* Just fall down */
         ctx->step++;
 
-    case CONNECT_STEP_START_NETWORK_IPV6: {
-        QmiMessageWdsStartNetworkInput *input;
-
-        mm_dbg ("Starting IPv6 connection...");
-        input = build_start_network_input (ctx);
-        qmi_client_wds_start_network (ctx->client_ipv6,
-                                      input,
-                                      45,
-                                      ctx->cancellable,
-                                      (GAsyncReadyCallback)start_network_ready,
-                                      ctx);
-        qmi_message_wds_start_network_input_unref (input);
-        return;
-    }
+    case CONNECT_STEP_MUX_LINK:
+        /* Multiplexed sessions run in their own link, so that the physical
+         * net port is left available for the bearers of other PDNs */
+        if (mm_port_qmi_is_multiplexed (ctx->qmi)) {
+            GError *error = NULL;
+
+            ctx->link = mm_port_qmi_add_mux_link (ctx->qmi, ctx->data, &ctx->mux_id, &error);
+            if (!ctx->link) {
+                g_simple_async_result_take_error (ctx->result, error);
+                connect_context_complete_and_free (ctx);
+                return;
+            }
 
-    case CONNECT_STEP_GET_CURRENT_SETTINGS_IPV6: {
-        /* Retrieve and print IP configuration */
-        if (ctx->packet_data_handle_ipv6) {
-            mm_dbg ("Getting IPv6 configuration...");
-            get_current_settings (ctx, ctx->client_ipv6);
-            return;
+            /* Each link needs its own set of WDS clients */
+            ctx->family_ipv4.flag = MM_PORT_QMI_FLAG_WDS_MUX_IPV4 + ctx->mux_id;
+            ctx->family_ipv6.flag = MM_PORT_QMI_FLAG_WDS_MUX_IPV6 + ctx->mux_id;
         }
-        /* Fall through */
+
+        /* Just fall down */
         ctx->step++;
-    }
+
+    case CONNECT_STEP_IP_FAMILIES:
+        /* Both counted before launching any of them, as a setup may finish
+         * right away if the operation gets cancelled */
+        ctx->families_pending = (ctx->ipv4 ? 1 : 0) + (ctx->ipv6 ? 1 : 0);
+        if (ctx->ipv4)
+            connect_family_step (&ctx->family_ipv4);
+        if (ctx->ipv6)
+            connect_family_step (&ctx->family_ipv6);
+        return;
 
     case CONNECT_STEP_LAST:
         /* If one of IPv4 or IPv6 succeeds, we're connected */
-        if (ctx->packet_data_handle_ipv4 || ctx->packet_data_handle_ipv6) {
+        if (ctx->family_ipv4.packet_data_handle || ctx->family_ipv6.packet_data_handle) {
+            MMPort *data;
+
+            /* When multiplexed, only the link is flagged as connected */
+            data = ctx->link ? ctx->link : ctx->data;
+
             /* Port is connected; update the state */
-            mm_port_set_connected (MM_PORT (ctx->data), TRUE);
+            mm_port_set_connected (data, TRUE);
 
             /* Keep connection related data */
             g_assert (ctx->self->priv->data == NULL);
-            ctx->self->priv->data = g_object_ref (ctx->data);
+            ctx->self->priv->data = g_object_ref (data);
+            if (ctx->link) {
+                g_assert (ctx->self->priv->mux_id == 0);
+                ctx->self->priv->qmi = g_object_ref (ctx->qmi);
+                ctx->self->priv->mux_parent = g_object_ref (ctx->data);
+                ctx->self->priv->mux_id = ctx->mux_id;
+                g_clear_object (&ctx->link);
+            }
 
             g_assert (ctx->self->priv->packet_data_handle_ipv4 == 0);
             g_assert (ctx->self->priv->client_ipv4 == NULL);
-            if (ctx->packet_data_handle_ipv4) {
-                ctx->self->priv->packet_data_handle_ipv4 = ctx->packet_data_handle_ipv4;
-                ctx->self->priv->packet_service_status_ipv4_indication_id = ctx->packet_service_status_ipv4_indication_id;
-                ctx->packet_service_status_ipv4_indication_id = 0;
-                ctx->self->priv->client_ipv4 = g_object_ref (ctx->client_ipv4);
+            if (ctx->family_ipv4.packet_data_handle) {
+                ctx->self->priv->packet_data_handle_ipv4 = ctx->family_ipv4.packet_data_handle;
+                ctx->self->priv->packet_service_status_ipv4_indication_id = ctx->family_ipv4.packet_service_status_indication_id;
+                ctx->family_ipv4.packet_service_status_indication_id = 0;
+                ctx->self->priv->client_ipv4 = g_object_ref (ctx->family_ipv4.client);
             }
 
             g_assert (ctx->self->priv->packet_data_handle_ipv6 == 0);
             g_assert (ctx->self->priv->client_ipv6 == NULL);
-            if (ctx->packet_data_handle_ipv6) {
-                ctx->self->priv->packet_data_handle_ipv6 = ctx->packet_data_handle_ipv6;
-                ctx->self->priv->packet_service_status_ipv6_indication_id = ctx->packet_service_status_ipv6_indication_id;
-                ctx->packet_service_status_ipv6_indication_id = 0;
-                ctx->self->priv->client_ipv6 = g_object_ref (ctx->client_ipv6);
+            if (ctx->family_ipv6.packet_data_handle) {
+                ctx->self->priv->packet_data_handle_ipv6 = ctx->family_ipv6.packet_data_handle;
+                ctx->self->priv->packet_service_status_ipv6_indication_id = ctx->family_ipv6.packet_service_status_indication_id;
+                ctx->family_ipv6.packet_service_status_indication_id = 0;
+                ctx->self->priv->client_ipv6 = g_object_ref (ctx->family_ipv6.client);
             }
 
             /* Set operation result */
             g_simple_async_result_set_op_res_gpointer (
                 ctx->result,
-                mm_bearer_connect_result_new (ctx->data, ctx->ipv4_config, ctx->ipv6_config),
+                mm_bearer_connect_result_new (data, ctx->ipv4_config, ctx->ipv6_config),
                 (GDestroyNotify)mm_bearer_connect_result_unref);
         } else {
             GError *error;
 
             /* No connection, set error. If both set, IPv4 error preferred */
-            if (ctx->error_ipv4) {
-                error = ctx->error_ipv4;
-                ctx->error_ipv4 = NULL;
+            if (ctx->family_ipv4.error) {
+                error = ctx->family_ipv4.error;
+                ctx->family_ipv4.error = NULL;
             } else {
-                error = ctx->error_ipv6;
-                ctx->error_ipv6 = NULL;
+                error = ctx->family_ipv6.error;
+                ctx->family_ipv6.error = NULL;
             }
 
             g_simple_async_result_take_error (ctx->result, error);
@@ -1260,6 +1300,8 @@ _connect (MMBaseBearer *self,
     ctx->cancellable = g_object_ref (cancellable);
     ctx->step = CONNECT_STEP_FIRST;
     ctx->ip_method = MM_BEARER_IP_METHOD_UNKNOWN;
+    connect_family_context_init (ctx, &ctx->family_ipv4, QMI_WDS_IP_FAMILY_IPV4);
+    connect_family_context_init (ctx, &ctx->family_ipv6, QMI_WDS_IP_FAMILY_IPV6);
     ctx->result = g_simple_async_result_new (G_OBJECT (self),
                                              callback,
                                              user_data,
@@ -1345,6 +1387,319 @@ _connect (MMBaseBearer *self,
     connect_context_step (ctx);
 }
 
+/*****************************************************************************/
+/* Adopt
+ *
+ * The modem keeps a data session up as long as the WDS client which started
+ * it isn't released, so a session started by a previous daemon instance may
+ * still be there. If so, its APN and IP family are loaded and the usual
+ * connection sequence is run on top of it: "Start Network" reports
+ * 'no effect' for an already active session, which is then kept with the
+ * global packet data handle, without any reconnection.
+ */
+
+typedef enum {
+    ADOPT_STEP_FIRST,
+    ADOPT_STEP_WDS_CLIENT,
+    ADOPT_STEP_PACKET_SERVICE_STATUS,
+    ADOPT_STEP_CURRENT_SETTINGS,
+    ADOPT_STEP_CONNECT,
+    ADOPT_STEP_LAST
+} AdoptStep;
+
+typedef struct {
+    MMBearerQmi *self;
+    MMPortQmi *qmi;
+    QmiClientWds *client;
+    GCancellable *cancellable;
+    GSimpleAsyncResult *result;
+    AdoptStep step;
+} AdoptContext;
+
+static void
+adopt_context_complete_and_free (AdoptContext *ctx)
+{
+    g_simple_async_result_complete_in_idle (ctx->result);
+    g_object_unref (ctx->result);
+    g_clear_object (&ctx->client);
+    g_object_unref (ctx->cancellable);
+    g_object_unref (ctx->qmi);
+    g_object_unref (ctx->self);
+    g_slice_free (AdoptContext, ctx);
+}
+
+static MMBearerConnectResult *
+adopt_finish (MMBaseBearer *self,
+              GAsyncResult *res,
+              GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return mm_bearer_connect_result_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void adopt_context_step (AdoptContext *ctx);
+
+static void
+adopt_connect_ready (MMBaseBearer *self,
+                     GAsyncResult *res,
+                     AdoptContext *ctx)
+{
+    MMBearerConnectResult *result;
+    GError *error = NULL;
+
+    result = connect_finish (self, res, &error);
+    if (!result) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                               result,
+                                               (GDestroyNotify)mm_bearer_connect_result_unref);
+    adopt_context_complete_and_free (ctx);
+}
+
+static void
+adopt_get_current_settings_ready (QmiClientWds *client,
+                                  GAsyncResult *res,
+                                  AdoptContext *ctx)
+{
+    GError *error = NULL;
+    QmiMessageWdsGetCurrentSettingsOutput *output;
+    const gchar *apn = NULL;
+    QmiWdsIpFamily ip_family = QMI_WDS_IP_FAMILY_UNSPECIFIED;
+
+    output = qmi_client_wds_get_current_settings_finish (client, res, &error);
+    if (!output ||
+        !qmi_message_wds_get_current_settings_output_get_result (output, &error)) {
+        /* Not fatal; without an explicit APN, the session is started again
+         * with the default profile, which is also the one the running
+         * session is expected to use */
+        mm_dbg ("Couldn't get settings of the session to adopt: %s", error->message);
+        g_error_free (error);
+    } else {
+        qmi_message_wds_get_current_settings_output_get_apn_name (output, &apn, NULL);
+        qmi_message_wds_get_current_settings_output_get_ip_family (output, &ip_family, NULL);
+    }
+
+    mm_dbg ("Adopting session with APN '%s'", apn ? apn : "");
+    mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self),
+                                          apn ? apn : "",
+                                          (ip_family == QMI_WDS_IP_FAMILY_IPV6 ?
+                                           MM_BEARER_IP_FAMILY_IPV6 :
+                                           MM_BEARER_IP_FAMILY_IPV4));
+
+    if (output)
+        qmi_message_wds_get_current_settings_output_unref (output);
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_get_packet_service_status_ready (QmiClientWds *client,
+                                       GAsyncResult *res,
+                                       AdoptContext *ctx)
+{
+    GError *error = NULL;
+    QmiMessageWdsGetPacketServiceStatusOutput *output;
+    QmiWdsConnectionStatus status = QMI_WDS_CONNECTION_STATUS_UNKNOWN;
+
+    output = qmi_client_wds_get_packet_service_status_finish (client, res, &error);
+    if (output &&
+        qmi_message_wds_get_packet_service_status_output_get_result (output, &error))
+        qmi_message_wds_get_packet_service_status_output_get_connection_status (output, &status, NULL);
+
+    if (output)
+        qmi_message_wds_get_packet_service_status_output_unref (output);
+
+    if (error) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    if (status != QMI_WDS_CONNECTION_STATUS_CONNECTED) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_NOT_FOUND,
+                                         "No data session to adopt (%s)",
+                                         qmi_wds_connection_status_get_string (status));
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_allocate_client_ready (MMPortQmi *qmi,
+                             GAsyncResult *res,
+                             AdoptContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_port_qmi_allocate_client_finish (qmi, res, &error)) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_context_step (AdoptContext *ctx)
+{
+    if (g_cancellable_is_cancelled (ctx->cancellable)) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_CANCELLED,
+                                         "Connection adoption has been cancelled");
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    switch (ctx->step) {
+    case ADOPT_STEP_FIRST:
+        /* Fall down */
+        ctx->step++;
+
+    case ADOPT_STEP_WDS_CLIENT:
+        /* Use the same client the IPv4 connection setup would use, so that
+         * it ends up owning the adopted session */
+        if (!mm_port_qmi_peek_client (ctx->qmi, QMI_SERVICE_WDS, MM_PORT_QMI_FLAG_WDS_IPV4)) {
+            mm_port_qmi_allocate_client (ctx->qmi,
+                                         QMI_SERVICE_WDS,
+                                         MM_PORT_QMI_FLAG_WDS_IPV4,
+                                         ctx->cancellable,
+                                         (GAsyncReadyCallback)adopt_allocate_client_ready,
+                                         ctx);
+            return;
+        }
+        /* Fall down */
+        ctx->step++;
+
+    case ADOPT_STEP_PACKET_SERVICE_STATUS:
+        ctx->client = QMI_CLIENT_WDS (mm_port_qmi_get_client (ctx->qmi,
+                                                              QMI_SERVICE_WDS,
+                                                              MM_PORT_QMI_FLAG_WDS_IPV4));
+        qmi_client_wds_get_packet_service_status (ctx->client,
+                                                  NULL,
+                                                  10,
+                                                  ctx->cancellable,
+                                                  (GAsyncReadyCallback)adopt_get_packet_service_status_ready,
+                                                  ctx);
+        return;
+
+    case ADOPT_STEP_CURRENT_SETTINGS: {
+        QmiMessageWdsGetCurrentSettingsInput *input;
+
+        input = qmi_message_wds_get_current_settings_input_new ();
+        qmi_message_wds_get_current_settings_input_set_requested_settings (
+            input,
+            (QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_APN_NAME |
+             QMI_WDS_GET_CURRENT_SETTINGS_REQUESTED_SETTINGS_IP_FAMILY),
+            NULL);
+        qmi_client_wds_get_current_settings (ctx->client,
+                                             input,
+                                             10,
+                                             ctx->cancellable,
+                                             (GAsyncReadyCallback)adopt_get_current_settings_ready,
+                                             ctx);
+        qmi_message_wds_get_current_settings_input_unref (input);
+        return;
+    }
+
+    case ADOPT_STEP_CONNECT:
+        _connect (MM_BASE_BEARER (ctx->self),
+                  ctx->cancellable,
+                  (GAsyncReadyCallback)adopt_connect_ready,
+                  ctx);
+        return;
+
+    case ADOPT_STEP_LAST:
+        g_assert_not_reached ();
+    }
+}
+
+static void
+adopt (MMBaseBearer *self,
+       GCancellable *cancellable,
+       GAsyncReadyCallback callback,
+       gpointer user_data)
+{
+    AdoptContext *ctx;
+    MMBaseModem *modem = NULL;
+    MMPort *data;
+    MMPortQmi *qmi;
+    GError *error = NULL;
+
+    g_object_get (self,
+                  MM_BASE_BEARER_MODEM, &modem,
+                  NULL);
+    g_assert (modem);
+
+    data = mm_base_modem_peek_best_data_port (modem, MM_PORT_TYPE_NET);
+    if (!data) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_NOT_FOUND,
+            "No valid data port found to adopt connection");
+        g_object_unref (modem);
+        return;
+    }
+
+    qmi = mm_base_modem_get_port_qmi_for_data (modem, data, &error);
+    g_object_unref (modem);
+    if (!qmi) {
+        g_simple_async_report_take_gerror_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            error);
+        return;
+    }
+
+    /* Sessions in QMAP links are bound to a mux id which isn't known after
+     * a restart, so only sessions in the physical net port are adopted */
+    if (!mm_port_qmi_is_open (qmi) || mm_port_qmi_is_multiplexed (qmi)) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_UNSUPPORTED,
+            "Cannot adopt connection in QMI port '%s'",
+            mm_port_get_device (MM_PORT (qmi)));
+        g_object_unref (qmi);
+        return;
+    }
+
+    ctx = g_slice_new0 (AdoptContext);
+    ctx->self = g_object_ref (self);
+    ctx->qmi = qmi;
+    ctx->cancellable = g_object_ref (cancellable);
+    ctx->step = ADOPT_STEP_FIRST;
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             adopt);
+
+    adopt_context_step (ctx);
+}
+
 /*****************************************************************************/
 /* Disconnect */
 
@@ -1420,6 +1775,12 @@ reset_bearer_connection (MMBearerQmi *self,
             mm_port_set_connected (self->priv->data, FALSE);
             g_clear_object (&self->priv->data);
         }
+        if (self->priv->mux_id) {
+            mm_port_qmi_del_mux_link (self->priv->qmi, self->priv->mux_parent, self->priv->mux_id);
+            self->priv->mux_id = 0;
+            g_clear_object (&self->priv->mux_parent);
+            g_clear_object (&self->priv->qmi);
+        }
     }
 }
 
@@ -1649,7 +2010,14 @@ dispose (GObject *object)
                                                  &self->priv->packet_service_status_ipv6_indication_id);
     }
 
+    if (self->priv->mux_id) {
+        mm_port_qmi_del_mux_link (self->priv->qmi, self->priv->mux_parent, self->priv->mux_id);
+        self->priv->mux_id = 0;
+    }
+
     g_clear_object (&self->priv->data);
+    g_clear_object (&self->priv->mux_parent);
+    g_clear_object (&self->priv->qmi);
     g_clear_object (&self->priv->client_ipv4);
     g_clear_object (&self->priv->client_ipv6);
 
@@ -1669,8 +2037,12 @@ mm_bearer_qmi_class_init (MMBearerQmiClass *klass)
 
     base_bearer_class->connect = _connect;
     base_bearer_class->connect_finish = connect_finish;
+    base_bearer_class->adopt = adopt;
+    base_bearer_class->adopt_finish = adopt_finish;
     base_bearer_class->disconnect = disconnect;
     base_bearer_class->disconnect_finish = disconnect_finish;
+    /* Each bearer has its own WDS clients */
+    base_bearer_class->concurrent_disconnect = TRUE;
     base_bearer_class->report_connection_status = report_connection_status;
     base_bearer_class->reload_stats = reload_stats;
     base_bearer_class->reload_stats_finish = reload_stats_finish;
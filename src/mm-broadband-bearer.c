@@ -86,6 +86,7 @@ typedef struct {
     guint cid;
     guint max_cid;
     gboolean use_existing_cid;
+    gboolean cid_from_cache;
     MMBearerIpFamily ip_family;
 } DetailedConnectContext;
 
@@ -247,6 +248,7 @@ dial_cdma_ready (MMBaseModem *modem,
     }
 
     /* else... Yuhu! */
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
 
     /* Keep port open during connection */
     ctx->close_data_on_exit = FALSE;
@@ -417,6 +419,7 @@ connect_cdma (MMBroadbandBearer *self,
         return;
     }
     ctx->close_data_on_exit = TRUE;
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (self), MM_BEARER_CONNECT_STEP_PORT_OPEN);
 
     if (mm_bearer_properties_get_rm_protocol (
             mm_base_bearer_peek_config (MM_BASE_BEARER (self))) !=
@@ -604,6 +607,7 @@ dial_3gpp (MMBroadbandBearer *self,
         dial_3gpp_context_complete_and_free (ctx);
         return;
     }
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (self), MM_BEARER_CONNECT_STEP_PORT_OPEN);
 
     /* Use default *99 to connect */
     command = g_strdup_printf ("ATD*99***%d#", cid);
@@ -625,7 +629,8 @@ dial_3gpp (MMBroadbandBearer *self,
  * 3GPP connection procedure of a bearer involves several steps:
  * 1) Get data port from the modem. Default implementation will have only
  *    one single possible data port, but plugins may have more.
- * 2) Decide which PDP context to use
+ * 2) Decide which PDP context to use, from the PDP contexts cached in the
+ *    modem if any, otherwise listing them
  *   2.1) Look for an already existing PDP context with the same APN.
  *   2.2) If none found with the same APN, try to find a PDP context without any
  *        predefined APN.
@@ -652,6 +657,7 @@ get_ip_config_3gpp_ready (MMBroadbandModem *modem,
         detailed_connect_context_complete_and_free (ctx);
         return;
     }
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_IP_CONFIG);
 
     /* Keep port open during connection */
     if (MM_IS_PORT_SERIAL_AT (ctx->data))
@@ -683,11 +689,16 @@ dial_3gpp_ready (MMBroadbandModem *modem,
     if (!ctx->data) {
         /* Clear CID when it failed to connect. */
         ctx->self->priv->cid = 0;
+        /* The cached contexts may be stale, so read them again next time */
+        if (ctx->cid_from_cache)
+            mm_broadband_modem_invalidate_pdp_contexts (MM_BROADBAND_MODEM (ctx->modem));
         g_simple_async_result_take_error (ctx->result, error);
         detailed_connect_context_complete_and_free (ctx);
         return;
     }
 
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_DIAL);
+
     /* If the dialling operation used an AT port, it is assumed to have an extra
      * open() count. */
     if (MM_IS_PORT_SERIAL_AT (ctx->data))
@@ -746,6 +757,8 @@ dial_3gpp_ready (MMBroadbandModem *modem,
 static void
 start_3gpp_dial (DetailedConnectContext *ctx)
 {
+    mm_base_bearer_report_connect_step (MM_BASE_BEARER (ctx->self), MM_BEARER_CONNECT_STEP_CONTEXT_SELECTION);
+
     /* Keep CID around after initializing the PDP context in order to
      * handle corresponding unsolicited PDP activation responses. */
     ctx->self->priv->cid = ctx->cid;
@@ -773,38 +786,26 @@ initialize_pdp_context_ready (MMBaseModem *modem,
     if (error) {
         mm_warn ("Couldn't initialize PDP context with our APN: '%s'",
                  error->message);
+        mm_broadband_modem_invalidate_pdp_contexts (MM_BROADBAND_MODEM (modem));
         g_simple_async_result_take_error (ctx->result, error);
         detailed_connect_context_complete_and_free (ctx);
         return;
     }
 
+    mm_broadband_modem_update_pdp_context (MM_BROADBAND_MODEM (modem),
+                                           ctx->cid,
+                                           ctx->ip_family,
+                                           mm_bearer_properties_get_apn (mm_base_bearer_peek_config (MM_BASE_BEARER (ctx->self))));
     start_3gpp_dial (ctx);
 }
 
 static void
-find_cid_ready (MMBaseModem *modem,
-                GAsyncResult *res,
-                DetailedConnectContext *ctx)
+use_cid (DetailedConnectContext *ctx,
+         guint cid)
 {
-    GVariant *result;
     gchar *apn, *command;
-    GError *error = NULL;
     const gchar *pdp_type;
 
-    result = mm_base_modem_at_sequence_full_finish (modem, res, NULL, &error);
-    if (!result) {
-        mm_warn ("Couldn't find best CID to use: '%s'", error->message);
-        g_simple_async_result_take_error (ctx->result, error);
-        detailed_connect_context_complete_and_free (ctx);
-        return;
-    }
-
-    /* If cancelled, complete. Normally, we would get the cancellation error
-     * already when finishing the sequence, but we may still get cancelled
-     * between last command result parsing in the sequence and the ready(). */
-    if (detailed_connect_context_complete_and_free_if_cancelled (ctx))
-        return;
-
     pdp_type = mm_3gpp_get_pdp_type_from_ip_family (ctx->ip_family);
     if (!pdp_type) {
         gchar * str;
@@ -819,7 +820,7 @@ find_cid_ready (MMBaseModem *modem,
         detailed_connect_context_complete_and_free (ctx);
         return;
     }
-    ctx->cid = g_variant_get_uint32 (result);
+    ctx->cid = cid;
 
     /* If there's already a PDP context defined, just use it */
     if (ctx->use_existing_cid) {
@@ -846,6 +847,31 @@ find_cid_ready (MMBaseModem *modem,
     g_free (command);
 }
 
+static void
+find_cid_ready (MMBaseModem *modem,
+                GAsyncResult *res,
+                DetailedConnectContext *ctx)
+{
+    GVariant *result;
+    GError *error = NULL;
+
+    result = mm_base_modem_at_sequence_full_finish (modem, res, NULL, &error);
+    if (!result) {
+        mm_warn ("Couldn't find best CID to use: '%s'", error->message);
+        g_simple_async_result_take_error (ctx->result, error);
+        detailed_connect_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* If cancelled, complete. Normally, we would get the cancellation error
+     * already when finishing the sequence, but we may still get cancelled
+     * between last command result parsing in the sequence and the ready(). */
+    if (detailed_connect_context_complete_and_free_if_cancelled (ctx))
+        return;
+
+    use_cid (ctx, g_variant_get_uint32 (result));
+}
+
 static gboolean
 parse_cid_range (MMBaseModem *modem,
                  DetailedConnectContext *ctx,
@@ -906,57 +932,15 @@ parse_cid_range (MMBaseModem *modem,
     return TRUE;
 }
 
-static gboolean
-parse_pdp_list (MMBaseModem *modem,
-                DetailedConnectContext *ctx,
-                const gchar *command,
-                const gchar *response,
-                gboolean last_command,
-                const GError *error,
-                GVariant **result,
-                GError **result_error)
+static guint
+select_cid_from_pdp_list (DetailedConnectContext *ctx,
+                          GList *pdp_list)
 {
-    GError *inner_error = NULL;
-    GList *pdp_list;
     GList *l;
-    guint cid;
-
-    /* If cancelled, set result error */
-    if (detailed_connect_context_set_error_if_cancelled (ctx, result_error))
-        return FALSE;
+    guint cid = 0;
 
     ctx->max_cid = 0;
 
-    /* Some Android phones don't support querying existing PDP contexts,
-     * but will accept setting the APN.  So if CGDCONT? isn't supported,
-     * just ignore that error and hope for the best. (bgo #637327)
-     */
-    if (g_error_matches (error,
-                         MM_MOBILE_EQUIPMENT_ERROR,
-                         MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED)) {
-        mm_dbg ("Querying PDP context list is unsupported");
-        return FALSE;
-    }
-
-    if (error) {
-        mm_dbg ("Unexpected +CGDCONT? error: '%s'", error->message);
-        return FALSE;
-    }
-
-    pdp_list = mm_3gpp_parse_cgdcont_read_response (response, &inner_error);
-    if (!pdp_list) {
-        if (inner_error) {
-            mm_dbg ("%s", inner_error->message);
-            g_error_free (inner_error);
-        } else {
-            /* No predefined PDP contexts found */
-            mm_dbg ("No PDP contexts found");
-        }
-        return FALSE;
-    }
-
-    cid = 0;
-
     /* Show all found PDP contexts in debug log */
     mm_dbg ("Found '%u' PDP contexts", g_list_length (pdp_list));
     for (l = pdp_list; l; l = g_list_next (l)) {
@@ -1004,7 +988,63 @@ parse_pdp_list (MMBaseModem *modem,
         if (ctx->max_cid < pdp->cid)
             ctx->max_cid = pdp->cid;
     }
-    mm_3gpp_pdp_context_list_free (pdp_list);
+
+    return cid;
+}
+
+static gboolean
+parse_pdp_list (MMBaseModem *modem,
+                DetailedConnectContext *ctx,
+                const gchar *command,
+                const gchar *response,
+                gboolean last_command,
+                const GError *error,
+                GVariant **result,
+                GError **result_error)
+{
+    GError *inner_error = NULL;
+    GList *pdp_list;
+    guint cid;
+
+    /* If cancelled, set result error */
+    if (detailed_connect_context_set_error_if_cancelled (ctx, result_error))
+        return FALSE;
+
+    ctx->max_cid = 0;
+
+    /* Some Android phones don't support querying existing PDP contexts,
+     * but will accept setting the APN.  So if CGDCONT? isn't supported,
+     * just ignore that error and hope for the best. (bgo #637327)
+     */
+    if (g_error_matches (error,
+                         MM_MOBILE_EQUIPMENT_ERROR,
+                         MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED)) {
+        mm_dbg ("Querying PDP context list is unsupported");
+        return FALSE;
+    }
+
+    if (error) {
+        mm_dbg ("Unexpected +CGDCONT? error: '%s'", error->message);
+        return FALSE;
+    }
+
+    pdp_list = mm_3gpp_parse_cgdcont_read_response (response, &inner_error);
+    if (!pdp_list) {
+        if (inner_error) {
+            mm_dbg ("%s", inner_error->message);
+            g_error_free (inner_error);
+        } else {
+            /* No predefined PDP contexts found */
+            mm_dbg ("No PDP contexts found");
+            mm_broadband_modem_set_pdp_contexts (MM_BROADBAND_MODEM (modem), NULL);
+        }
+        return FALSE;
+    }
+
+    cid = select_cid_from_pdp_list (ctx, pdp_list);
+
+    /* Keep the list for the next connection attempts */
+    mm_broadband_modem_set_pdp_contexts (MM_BROADBAND_MODEM (modem), pdp_list);
 
     if (cid > 0) {
         *result = g_variant_new_uint32 (cid);
@@ -1020,6 +1060,13 @@ static const MMBaseModemAtCommand find_cid_sequence[] = {
     { NULL }
 };
 
+/* When the PDP contexts are cached, only the CID range is needed, and the
+ * test command response is cached as well */
+static const MMBaseModemAtCommand find_cid_range_sequence[] = {
+    { "+CGDCONT=?", 3, TRUE,  (MMBaseModemAtResponseProcessor)parse_cid_range },
+    { NULL }
+};
+
 static void
 connect_3gpp (MMBroadbandBearer *self,
               MMBroadbandModem *modem,
@@ -1030,6 +1077,8 @@ connect_3gpp (MMBroadbandBearer *self,
               gpointer user_data)
 {
     DetailedConnectContext *ctx;
+    const MMBaseModemAtCommand *sequence = find_cid_sequence;
+    GList *pdp_list;
 
     g_assert (primary != NULL);
 
@@ -1041,10 +1090,23 @@ connect_3gpp (MMBroadbandBearer *self,
                                         callback,
                                         user_data);
 
-    mm_dbg ("Looking for best CID...");
+    if (mm_broadband_modem_peek_pdp_contexts (modem, &pdp_list)) {
+        guint cid;
+
+        mm_dbg ("Looking for best CID in cached PDP contexts...");
+        ctx->cid_from_cache = TRUE;
+        cid = select_cid_from_pdp_list (ctx, pdp_list);
+        if (cid > 0) {
+            use_cid (ctx, cid);
+            return;
+        }
+        sequence = find_cid_range_sequence;
+    } else
+        mm_dbg ("Looking for best CID...");
+
     mm_base_modem_at_sequence_full (ctx->modem,
                                     ctx->primary,
-                                    find_cid_sequence,
+                                    sequence,
                                     ctx, /* also passed as response processor context */
                                     NULL, /* response_processor_context_free */
                                     NULL, /* cancellable */
@@ -1282,6 +1344,348 @@ connect (MMBaseBearer *self,
     g_assert_not_reached ();
 }
 
+/*****************************************************************************/
+/* ADOPT
+ *
+ * A 3GPP connection left established by a previous daemon instance is taken
+ * over as long as it runs in a net port: the first active PDP context is
+ * looked up with +CGACT?, its settings are read with +CGDCONT?, and the IP
+ * configuration is retrieved as in a normal connection, but nothing is
+ * dialled. PPP sessions died with the process that ran pppd, so they are
+ * never adopted.
+ */
+
+typedef enum {
+    ADOPT_STEP_FIRST,
+    ADOPT_STEP_ACTIVE_CONTEXT,
+    ADOPT_STEP_CONTEXT_SETTINGS,
+    ADOPT_STEP_IP_CONFIG,
+    ADOPT_STEP_LAST
+} AdoptStep;
+
+typedef struct {
+    MMBroadbandBearer *self;
+    MMBaseModem *modem;
+    MMPortSerialAt *primary;
+    MMPort *data;
+    GCancellable *cancellable;
+    GSimpleAsyncResult *result;
+    AdoptStep step;
+    guint cid;
+    MMBearerIpFamily ip_family;
+    MMBearerIpConfig *ipv4_config;
+    MMBearerIpConfig *ipv6_config;
+} AdoptContext;
+
+static void
+adopt_context_complete_and_free (AdoptContext *ctx)
+{
+    g_simple_async_result_complete_in_idle (ctx->result);
+    g_object_unref (ctx->result);
+    g_clear_object (&ctx->ipv4_config);
+    g_clear_object (&ctx->ipv6_config);
+    g_object_unref (ctx->cancellable);
+    g_object_unref (ctx->data);
+    g_object_unref (ctx->primary);
+    g_object_unref (ctx->modem);
+    g_object_unref (ctx->self);
+    g_slice_free (AdoptContext, ctx);
+}
+
+static MMBearerConnectResult *
+adopt_finish (MMBaseBearer *self,
+              GAsyncResult *res,
+              GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return mm_bearer_connect_result_ref (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void adopt_context_step (AdoptContext *ctx);
+
+static void
+adopt_get_ip_config_3gpp_ready (MMBroadbandBearer *self,
+                                GAsyncResult *res,
+                                AdoptContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!MM_BROADBAND_BEARER_GET_CLASS (self)->get_ip_config_3gpp_finish (self,
+                                                                          res,
+                                                                          &ctx->ipv4_config,
+                                                                          &ctx->ipv6_config,
+                                                                          &error)) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_cgdcont_query_ready (MMBaseModem *modem,
+                           GAsyncResult *res,
+                           AdoptContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+    GList *pdp_list;
+    GList *l;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    if (!response) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    pdp_list = mm_3gpp_parse_cgdcont_read_response (response, &error);
+    if (error) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    for (l = pdp_list; l; l = g_list_next (l)) {
+        MM3gppPdpContext *pdp = l->data;
+
+        if (pdp->cid == ctx->cid) {
+            mm_dbg ("Adopted PDP context %u uses APN '%s'", pdp->cid, pdp->apn ? pdp->apn : "");
+            ctx->ip_family = pdp->pdp_type;
+            mm_base_bearer_update_adopted_config (MM_BASE_BEARER (ctx->self),
+                                                  pdp->apn ? pdp->apn : "",
+                                                  pdp->pdp_type);
+            break;
+        }
+    }
+    mm_3gpp_pdp_context_list_free (pdp_list);
+
+    /* Not fatal, the context is active anyway; just assume IPv4 */
+    if (ctx->ip_family == MM_BEARER_IP_FAMILY_NONE) {
+        mm_dbg ("Couldn't find settings of PDP context %u; assuming IPv4", ctx->cid);
+        ctx->ip_family = MM_BEARER_IP_FAMILY_IPV4;
+    }
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_cgact_query_ready (MMBaseModem *modem,
+                         GAsyncResult *res,
+                         AdoptContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+    GList *pdp_active_list;
+    GList *l;
+
+    response = mm_base_modem_at_command_full_finish (modem, res, &error);
+    if (!response) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    pdp_active_list = mm_3gpp_parse_cgact_read_response (response, &error);
+    if (error) {
+        g_simple_async_result_take_error (ctx->result, error);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* The list is sorted by CID; take the first active one */
+    for (l = pdp_active_list; l && !ctx->cid; l = g_list_next (l)) {
+        MM3gppPdpContextActive *pdp_active = l->data;
+
+        if (pdp_active->active)
+            ctx->cid = pdp_active->cid;
+    }
+    mm_3gpp_pdp_context_active_list_free (pdp_active_list);
+
+    if (!ctx->cid) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_NOT_FOUND,
+                                         "No active PDP context to adopt");
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    mm_dbg ("Found active PDP context %u", ctx->cid);
+
+    /* Keep on */
+    ctx->step++;
+    adopt_context_step (ctx);
+}
+
+static void
+adopt_context_step (AdoptContext *ctx)
+{
+    if (g_cancellable_is_cancelled (ctx->cancellable)) {
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_CANCELLED,
+                                         "Connection adoption has been cancelled");
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    switch (ctx->step) {
+    case ADOPT_STEP_FIRST:
+        /* Fall down */
+        ctx->step++;
+
+    case ADOPT_STEP_ACTIVE_CONTEXT:
+        mm_base_modem_at_command_full (ctx->modem,
+                                       ctx->primary,
+                                       "+CGACT?",
+                                       10,
+                                       FALSE,
+                                       FALSE, /* raw */
+                                       NULL, /* cancellable */
+                                       (GAsyncReadyCallback)adopt_cgact_query_ready,
+                                       ctx);
+        return;
+
+    case ADOPT_STEP_CONTEXT_SETTINGS:
+        mm_base_modem_at_command_full (ctx->modem,
+                                       ctx->primary,
+                                       "+CGDCONT?",
+                                       10,
+                                       FALSE,
+                                       FALSE, /* raw */
+                                       NULL, /* cancellable */
+                                       (GAsyncReadyCallback)adopt_cgdcont_query_ready,
+                                       ctx);
+        return;
+
+    case ADOPT_STEP_IP_CONFIG:
+        if (MM_BROADBAND_BEARER_GET_CLASS (ctx->self)->get_ip_config_3gpp &&
+            MM_BROADBAND_BEARER_GET_CLASS (ctx->self)->get_ip_config_3gpp_finish) {
+            MM_BROADBAND_BEARER_GET_CLASS (ctx->self)->get_ip_config_3gpp (
+                ctx->self,
+                MM_BROADBAND_MODEM (ctx->modem),
+                ctx->primary,
+                mm_base_modem_peek_port_secondary (ctx->modem),
+                ctx->data,
+                ctx->cid,
+                ctx->ip_family,
+                (GAsyncReadyCallback)adopt_get_ip_config_3gpp_ready,
+                ctx);
+            return;
+        }
+
+        /* Same defaults as in a normal connection through a net port */
+        if (ctx->ip_family & MM_BEARER_IP_FAMILY_IPV4 ||
+            ctx->ip_family & MM_BEARER_IP_FAMILY_IPV4V6) {
+            ctx->ipv4_config = mm_bearer_ip_config_new ();
+            mm_bearer_ip_config_set_method (ctx->ipv4_config, MM_BEARER_IP_METHOD_DHCP);
+        }
+        if (ctx->ip_family & MM_BEARER_IP_FAMILY_IPV6 ||
+            ctx->ip_family & MM_BEARER_IP_FAMILY_IPV4V6) {
+            ctx->ipv6_config = mm_bearer_ip_config_new ();
+            mm_bearer_ip_config_set_method (ctx->ipv6_config, MM_BEARER_IP_METHOD_DHCP);
+        }
+
+        /* Fall down */
+        ctx->step++;
+
+    case ADOPT_STEP_LAST:
+        /* Keep connected port, CID and type of connection, so that the
+         * adopted connection is torn down as any other one */
+        ctx->self->priv->cid = ctx->cid;
+        ctx->self->priv->port = g_object_ref (ctx->data);
+        ctx->self->priv->connection_type = CONNECTION_TYPE_3GPP;
+        mm_port_set_connected (ctx->self->priv->port, TRUE);
+
+        g_simple_async_result_set_op_res_gpointer (
+            ctx->result,
+            mm_bearer_connect_result_new (ctx->data, ctx->ipv4_config, ctx->ipv6_config),
+            (GDestroyNotify)mm_bearer_connect_result_unref);
+        adopt_context_complete_and_free (ctx);
+        return;
+    }
+
+    g_assert_not_reached ();
+}
+
+static void
+adopt (MMBaseBearer *self,
+       GCancellable *cancellable,
+       GAsyncReadyCallback callback,
+       gpointer user_data)
+{
+    AdoptContext *ctx;
+    MMBaseModem *modem = NULL;
+    MMPortSerialAt *primary;
+    MMPort *data;
+
+    g_object_get (self,
+                  MM_BASE_BEARER_MODEM, &modem,
+                  NULL);
+    g_assert (modem != NULL);
+
+    if (!mm_iface_modem_is_3gpp (MM_IFACE_MODEM (modem))) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_UNSUPPORTED,
+            "Couldn't adopt connection: only 3GPP connections may be adopted");
+        g_object_unref (modem);
+        return;
+    }
+
+    primary = mm_base_modem_peek_port_primary (modem);
+    if (!primary) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_FAILED,
+            "Couldn't adopt connection: couldn't get primary port");
+        g_object_unref (modem);
+        return;
+    }
+
+    data = mm_base_modem_peek_best_data_port (modem, MM_PORT_TYPE_NET);
+    if (!data) {
+        g_simple_async_report_error_in_idle (
+            G_OBJECT (self),
+            callback,
+            user_data,
+            MM_CORE_ERROR,
+            MM_CORE_ERROR_UNSUPPORTED,
+            "Couldn't adopt connection: no net data port available");
+        g_object_unref (modem);
+        return;
+    }
+
+    ctx = g_slice_new0 (AdoptContext);
+    ctx->self = g_object_ref (self);
+    ctx->modem = modem;
+    ctx->primary = g_object_ref (primary);
+    ctx->data = g_object_ref (data);
+    ctx->cancellable = g_object_ref (cancellable);
+    ctx->step = ADOPT_STEP_FIRST;
+    ctx->ip_family = MM_BEARER_IP_FAMILY_NONE;
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             adopt);
+
+    adopt_context_step (ctx);
+}
+
 /*****************************************************************************/
 /* Detailed disconnect context, used in both CDMA and 3GPP sequences */
 
@@ -2100,6 +2504,8 @@ mm_broadband_bearer_class_init (MMBroadbandBearerClass *klass)
 
     base_bearer_class->connect = connect;
     base_bearer_class->connect_finish = connect_finish;
+    base_bearer_class->adopt = adopt;
+    base_bearer_class->adopt_finish = adopt_finish;
     base_bearer_class->disconnect = disconnect;
     base_bearer_class->disconnect_finish = disconnect_finish;
     base_bearer_class->report_connection_status = report_connection_status;
@@ -28,6 +28,7 @@
 #include "mm-sms-mbim.h"
 
 #include "ModemManager.h"
+#include "mm-clock.h"
 #include "mm-log.h"
 #include "mm-errors-types.h"
 #include "mm-error-helpers.h"
@@ -82,6 +83,13 @@ struct _MMBroadbandModemMbimPrivate {
     /* Access technology updates */
     MbimDataClass available_data_classes;
     MbimDataClass highest_available_data_class;
+
+#if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
+    /* QMI-over-MBIM device and DMS client used for the FCC authentication,
+     * kept for the whole lifetime of the modem once created */
+    QmiDevice *qmi_device;
+    QmiClient *qmi_client_dms;
+#endif
 };
 
 /*****************************************************************************/
@@ -510,11 +518,16 @@ typedef struct {
     GSimpleAsyncResult *result;
     guint n_ready_status_checks;
     MbimDevice *device;
+    /* Next check, if the SIM isn't ready yet */
+    guint retry_id;
+    gulong notification_id;
 } LoadUnlockRequiredContext;
 
 static void
 load_unlock_required_context_complete_and_free (LoadUnlockRequiredContext *ctx)
 {
+    g_assert (ctx->retry_id == 0);
+    g_signal_handler_disconnect (ctx->device, ctx->notification_id);
     g_simple_async_result_complete (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->device);
@@ -577,7 +590,8 @@ pin_query_ready (MbimDevice *device,
     load_unlock_required_context_complete_and_free (ctx);
 }
 
-static gboolean wait_for_sim_ready (LoadUnlockRequiredContext *ctx);
+static void wait_for_sim_ready (LoadUnlockRequiredContext *ctx);
+static gboolean wait_for_sim_ready_retry (LoadUnlockRequiredContext *ctx);
 
 static void
 unlock_required_subscriber_ready_state_ready (MbimDevice *device,
@@ -629,7 +643,7 @@ unlock_required_subscriber_ready_state_ready (MbimDevice *device,
     /* Need to retry? */
     else if (ready_state == MBIM_SUBSCRIBER_READY_STATE_NOT_INITIALIZED ||
              ready_state == MBIM_SUBSCRIBER_READY_STATE_SIM_NOT_INSERTED) {
-        if (--ctx->n_ready_status_checks == 0) {
+        if (ctx->n_ready_status_checks == 0) {
             /* All retries consumed, issue error */
             if (ready_state == MBIM_SUBSCRIBER_READY_STATE_SIM_NOT_INSERTED)
                 g_simple_async_result_take_error (
@@ -642,8 +656,9 @@ unlock_required_subscriber_ready_state_ready (MbimDevice *device,
                                                  "Error waiting for SIM to get initialized");
             load_unlock_required_context_complete_and_free (ctx);
         } else {
-            /* Retry */
-            g_timeout_add_seconds (1, (GSourceFunc)wait_for_sim_ready, ctx);
+            /* Retry as soon as the SIM state changes, or after a while if the
+             * device doesn't report the change */
+            ctx->retry_id = mm_clock_timeout_add_seconds (1, (GSourceFunc)wait_for_sim_ready_retry, ctx);
         }
     }
     /* Initialized but locked? */
@@ -673,7 +688,7 @@ unlock_required_subscriber_ready_state_ready (MbimDevice *device,
         mbim_message_unref (response);
 }
 
-static gboolean
+static void
 wait_for_sim_ready (LoadUnlockRequiredContext *ctx)
 {
     MbimMessage *message;
@@ -686,9 +701,36 @@ wait_for_sim_ready (LoadUnlockRequiredContext *ctx)
                          (GAsyncReadyCallback)unlock_required_subscriber_ready_state_ready,
                          ctx);
     mbim_message_unref (message);
+}
+
+static gboolean
+wait_for_sim_ready_retry (LoadUnlockRequiredContext *ctx)
+{
+    /* Only the retries done after a timeout count */
+    ctx->retry_id = 0;
+    ctx->n_ready_status_checks--;
+    wait_for_sim_ready (ctx);
     return G_SOURCE_REMOVE;
 }
 
+static void
+wait_for_sim_ready_notification_cb (MbimDevice *device,
+                                    MbimMessage *notification,
+                                    LoadUnlockRequiredContext *ctx)
+{
+    /* Only if waiting for the next check; if a check is ongoing already, its
+     * response will have the new state */
+    if (!ctx->retry_id ||
+        mbim_message_indicate_status_get_service (notification) != MBIM_SERVICE_BASIC_CONNECT ||
+        mbim_message_indicate_status_get_cid (notification) != MBIM_CID_BASIC_CONNECT_SUBSCRIBER_READY_STATUS)
+        return;
+
+    mm_dbg ("Subscriber ready status changed, checking SIM state right away...");
+    g_source_remove (ctx->retry_id);
+    ctx->retry_id = 0;
+    wait_for_sim_ready (ctx);
+}
+
 static void
 modem_load_unlock_required (MMIfaceModem *self,
                             GAsyncReadyCallback callback,
@@ -700,9 +742,13 @@ modem_load_unlock_required (MMIfaceModem *self,
     if (!peek_device (self, &device, callback, user_data))
         return;
 
-    ctx = g_slice_new (LoadUnlockRequiredContext);
+    ctx = g_slice_new0 (LoadUnlockRequiredContext);
     ctx->self = g_object_ref (self);
     ctx->device = g_object_ref (device);
+    ctx->notification_id = g_signal_connect (device,
+                                             MBIM_DEVICE_SIGNAL_INDICATE_STATUS,
+                                             G_CALLBACK (wait_for_sim_ready_notification_cb),
+                                             ctx);
     ctx->result = g_simple_async_result_new (G_OBJECT (self),
                                         callback,
                                         user_data,
@@ -952,7 +998,6 @@ typedef enum {
     POWER_UP_CONTEXT_STEP_QMI_DEVICE_OPEN,
     POWER_UP_CONTEXT_STEP_ALLOCATE_QMI_CLIENT_DMS,
     POWER_UP_CONTEXT_STEP_FCC_AUTH,
-    POWER_UP_CONTEXT_STEP_RELEASE_QMI_CLIENT_DMS,
     POWER_UP_CONTEXT_STEP_RETRY,
 #endif
     POWER_UP_CONTEXT_STEP_LAST,
@@ -964,8 +1009,6 @@ typedef struct {
     GSimpleAsyncResult *result;
     PowerUpContextStep step;
 #if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
-    QmiDevice *qmi_device;
-    QmiClient *qmi_client;
     GError *saved_error;
 #endif
 } PowerUpContext;
@@ -974,16 +1017,6 @@ static void
 power_up_context_complete_and_free (PowerUpContext *ctx)
 {
 #if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
-    if (ctx->qmi_device) {
-        if (ctx->qmi_client) {
-            qmi_device_release_client (ctx->qmi_device,
-                                       ctx->qmi_client,
-                                       QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
-                                       3, NULL, NULL, NULL);
-            g_object_unref (ctx->qmi_client);
-        }
-        g_object_unref (ctx->qmi_device);
-    }
     if (ctx->saved_error)
         g_error_free (ctx->saved_error);
 #endif
@@ -1006,35 +1039,6 @@ static void power_up_context_step (PowerUpContext *ctx);
 
 #if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
 
-static void
-release_qmi_client_dms_ready (QmiDevice      *dev,
-                              GAsyncResult   *res,
-                              PowerUpContext *ctx)
-{
-    GError *error = NULL;
-
-    /* Non-fatal error */
-    if (!qmi_device_release_client_finish (dev, res, &error)) {
-        mm_dbg ("error: couldn't release client: %s", error->message);
-        g_error_free (error);
-    }
-
-    ctx->step++;
-    power_up_context_step (ctx);
-}
-
-static void
-set_radio_state_release_qmi_client_dms (PowerUpContext *ctx)
-{
-    qmi_device_release_client (ctx->qmi_device,
-                               ctx->qmi_client,
-                               QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
-                               10,
-                               NULL,
-                               (GAsyncReadyCallback)release_qmi_client_dms_ready,
-                               ctx);
-}
-
 static void
 set_fcc_authentication_ready (QmiClientDms   *client,
                               GAsyncResult   *res,
@@ -1065,7 +1069,7 @@ out:
 static void
 set_radio_state_fcc_auth (PowerUpContext *ctx)
 {
-    qmi_client_dms_set_fcc_authentication (QMI_CLIENT_DMS (ctx->qmi_client),
+    qmi_client_dms_set_fcc_authentication (QMI_CLIENT_DMS (ctx->self->priv->qmi_client_dms),
                                            NULL,
                                            10,
                                            NULL, /* cancellable */
@@ -1080,8 +1084,8 @@ qmi_client_dms_ready (QmiDevice      *dev,
 {
     GError *error = NULL;
 
-    ctx->qmi_client = qmi_device_allocate_client_finish (dev, res, &error);
-    if (!ctx->qmi_client) {
+    ctx->self->priv->qmi_client_dms = qmi_device_allocate_client_finish (dev, res, &error);
+    if (!ctx->self->priv->qmi_client_dms) {
         mm_dbg ("error: couldn't create DMS client: %s", error->message);
         g_error_free (error);
         g_assert (ctx->saved_error);
@@ -1098,8 +1102,8 @@ qmi_client_dms_ready (QmiDevice      *dev,
 static void
 set_radio_state_allocate_qmi_client_dms (PowerUpContext *ctx)
 {
-    g_assert (ctx->qmi_device);
-    qmi_device_allocate_client (ctx->qmi_device,
+    g_assert (ctx->self->priv->qmi_device);
+    qmi_device_allocate_client (ctx->self->priv->qmi_device,
                                 QMI_SERVICE_DMS,
                                 QMI_CID_NONE,
                                 10,
@@ -1133,8 +1137,8 @@ static void
 set_radio_state_qmi_device_open (PowerUpContext *ctx)
 {
     /* Open the device */
-    g_assert (ctx->qmi_device);
-    qmi_device_open (ctx->qmi_device,
+    g_assert (ctx->self->priv->qmi_device);
+    qmi_device_open (ctx->self->priv->qmi_device,
                      (QMI_DEVICE_OPEN_FLAGS_PROXY | QMI_DEVICE_OPEN_FLAGS_MBIM),
                      15,
                      NULL, /* cancellable */
@@ -1149,8 +1153,8 @@ qmi_device_new_ready (GObject        *unused,
 {
     GError *error = NULL;
 
-    ctx->qmi_device = qmi_device_new_finish (res, &error);
-    if (!ctx->qmi_device) {
+    ctx->self->priv->qmi_device = qmi_device_new_finish (res, &error);
+    if (!ctx->self->priv->qmi_device) {
         mm_dbg ("error: couldn't create QmiDevice: %s", error->message);
         g_error_free (error);
         g_assert (ctx->saved_error);
@@ -1260,26 +1264,36 @@ power_up_context_step (PowerUpContext *ctx)
 
 #if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
 
+    /* The QMI device and the DMS client are reused if already available
+     * from a previous power up */
     case POWER_UP_CONTEXT_STEP_QMI_DEVICE_NEW:
-        set_radio_state_qmi_device_new (ctx);
-        return;
+        if (!ctx->self->priv->qmi_device) {
+            set_radio_state_qmi_device_new (ctx);
+            return;
+        }
+        ctx->step++;
+        /* Fall down to next step */
 
     case POWER_UP_CONTEXT_STEP_QMI_DEVICE_OPEN:
-        set_radio_state_qmi_device_open (ctx);
-        return;
+        if (!qmi_device_is_open (ctx->self->priv->qmi_device)) {
+            set_radio_state_qmi_device_open (ctx);
+            return;
+        }
+        ctx->step++;
+        /* Fall down to next step */
 
     case POWER_UP_CONTEXT_STEP_ALLOCATE_QMI_CLIENT_DMS:
-        set_radio_state_allocate_qmi_client_dms (ctx);
-        return;
+        if (!ctx->self->priv->qmi_client_dms) {
+            set_radio_state_allocate_qmi_client_dms (ctx);
+            return;
+        }
+        ctx->step++;
+        /* Fall down to next step */
 
     case POWER_UP_CONTEXT_STEP_FCC_AUTH:
         set_radio_state_fcc_auth (ctx);
         return;
 
-    case POWER_UP_CONTEXT_STEP_RELEASE_QMI_CLIENT_DMS:
-        set_radio_state_release_qmi_client_dms (ctx);
-        return;
-
     case POWER_UP_CONTEXT_STEP_RETRY:
         set_radio_state_up (ctx);
         return;
@@ -3182,6 +3196,21 @@ finalize (GObject *object)
     g_free (self->priv->current_operator_id);
     g_free (self->priv->current_operator_name);
 
+#if defined WITH_QMI && QMI_MBIM_QMUX_SUPPORTED
+    if (self->priv->qmi_device) {
+        if (self->priv->qmi_client_dms) {
+            qmi_device_release_client (self->priv->qmi_device,
+                                       self->priv->qmi_client_dms,
+                                       QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
+                                       3, NULL, NULL, NULL);
+            g_object_unref (self->priv->qmi_client_dms);
+        }
+        if (qmi_device_is_open (self->priv->qmi_device))
+            qmi_device_close (self->priv->qmi_device, NULL);
+        g_object_unref (self->priv->qmi_device);
+    }
+#endif
+
     mbim = mm_base_modem_peek_port_mbim (MM_BASE_MODEM (self));
     /* If we did open the MBIM port during initialization, close it now */
     if (mbim && mm_port_mbim_is_open (mbim)) {
@@ -3304,6 +3333,8 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->disable_unsolicited_events = disable_unsolicited_events_messaging;
     iface->disable_unsolicited_events_finish = common_enable_disable_unsolicited_events_messaging_finish;
     iface->create_sms = messaging_create_sms;
+    iface->delete_all_sms_parts = NULL;
+    iface->delete_all_sms_parts_finish = NULL;
 }
 
 static void
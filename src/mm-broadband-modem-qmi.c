@@ -26,10 +26,12 @@
 #include "mm-broadband-modem-qmi.h"
 
 #include "ModemManager.h"
+#include "mm-clock.h"
 #include "mm-log.h"
 #include "mm-errors-types.h"
 #include "mm-modem-helpers.h"
 #include "mm-modem-helpers-qmi.h"
+#include "mm-string-pool.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-3gpp-ussd.h"
@@ -4200,9 +4202,9 @@ get_3gpp_network_info (QmiMessageNasNetworkScanOutputNetworkInformationElement *
     else
         g_string_append_printf (aux, "%.2"G_GUINT16_FORMAT, element->mnc);
 
-    info->operator_code = g_string_free (aux, FALSE);
+    info->operator_code = mm_string_pool_take (g_string_free (aux, FALSE));
     info->operator_short = NULL;
-    info->operator_long = g_strdup (element->description);
+    info->operator_long = mm_string_pool_ref (element->description);
     info->access_tech = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
 
     return info;
@@ -5985,7 +5987,7 @@ activate_manual_get_msisdn_ready (QmiClientDms *client,
     if (ctx->n_mdn_check_retries < MAX_MDN_CHECK_RETRIES) {
         /* Retry after some time */
         mm_dbg ("MDN not yet updated, retrying...");
-        g_timeout_add (1, (GSourceFunc) retry_msisdn_check_cb, ctx);
+        mm_clock_timeout_add (1, (GSourceFunc) retry_msisdn_check_cb, ctx);
         return;
     }
 
@@ -7033,8 +7035,87 @@ event_report_indication_cb (QmiClientNas *client,
     }
 }
 
+static gdouble
+get_db_from_sinr_level (QmiNasEvdoSinrLevel level)
+{
+    switch (level) {
+    case QMI_NAS_EVDO_SINR_LEVEL_0: return -9.0;
+    case QMI_NAS_EVDO_SINR_LEVEL_1: return -6;
+    case QMI_NAS_EVDO_SINR_LEVEL_2: return -4.5;
+    case QMI_NAS_EVDO_SINR_LEVEL_3: return -3;
+    case QMI_NAS_EVDO_SINR_LEVEL_4: return -2;
+    case QMI_NAS_EVDO_SINR_LEVEL_5: return 1;
+    case QMI_NAS_EVDO_SINR_LEVEL_6: return 3;
+    case QMI_NAS_EVDO_SINR_LEVEL_7: return 6;
+    case QMI_NAS_EVDO_SINR_LEVEL_8: return +9;
+    default:
+        mm_warn ("Invalid SINR level '%u'", level);
+        return -G_MAXDOUBLE;
+    }
+}
+
 #if defined WITH_NEWEST_QMI_COMMANDS
 
+static void
+signal_info_indication_update_extended (MMBroadbandModemQmi *self,
+                                        QmiIndicationNasSignalInfoOutput *output)
+{
+    MMSignal *cdma = NULL;
+    MMSignal *evdo = NULL;
+    MMSignal *gsm = NULL;
+    MMSignal *umts = NULL;
+    MMSignal *lte = NULL;
+    gint8 rssi;
+    gint16 ecio;
+    QmiNasEvdoSinrLevel sinr_level;
+    gint32 io;
+    gint8 rsrq;
+    gint16 rsrp;
+    gint16 snr;
+
+    if (qmi_indication_nas_signal_info_output_get_cdma_signal_strength (output, &rssi, &ecio, NULL)) {
+        cdma = mm_signal_new ();
+        mm_signal_set_rssi (cdma, (gdouble)rssi);
+        mm_signal_set_ecio (cdma, ((gdouble)ecio) * (-0.5));
+    }
+
+    if (qmi_indication_nas_signal_info_output_get_hdr_signal_strength (output, &rssi, &ecio, &sinr_level, &io, NULL)) {
+        evdo = mm_signal_new ();
+        mm_signal_set_rssi (evdo, (gdouble)rssi);
+        mm_signal_set_ecio (evdo, ((gdouble)ecio) * (-0.5));
+        mm_signal_set_sinr (evdo, get_db_from_sinr_level (sinr_level));
+        mm_signal_set_io (evdo, (gdouble)io);
+    }
+
+    if (qmi_indication_nas_signal_info_output_get_gsm_signal_strength (output, &rssi, NULL)) {
+        gsm = mm_signal_new ();
+        mm_signal_set_rssi (gsm, (gdouble)rssi);
+    }
+
+    if (qmi_indication_nas_signal_info_output_get_wcdma_signal_strength (output, &rssi, &ecio, NULL)) {
+        umts = mm_signal_new ();
+        mm_signal_set_rssi (umts, (gdouble)rssi);
+        mm_signal_set_ecio (umts, ((gdouble)ecio) * (-0.5));
+    }
+
+    if (qmi_indication_nas_signal_info_output_get_lte_signal_strength (output, &rssi, &rsrq, &rsrp, &snr, NULL)) {
+        lte = mm_signal_new ();
+        mm_signal_set_rssi (lte, (gdouble)rssi);
+        mm_signal_set_rsrq (lte, (gdouble)rsrq);
+        mm_signal_set_rsrp (lte, (gdouble)rsrp);
+        mm_signal_set_snr (lte, (0.1) * ((gdouble)snr));
+    }
+
+    if (cdma || evdo || gsm || umts || lte)
+        mm_iface_modem_signal_update (MM_IFACE_MODEM_SIGNAL (self), cdma, evdo, gsm, umts, lte);
+
+    g_clear_object (&cdma);
+    g_clear_object (&evdo);
+    g_clear_object (&gsm);
+    g_clear_object (&umts);
+    g_clear_object (&lte);
+}
+
 static void
 signal_info_indication_cb (QmiClientNas *client,
                            QmiIndicationNasSignalInfoOutput *output,
@@ -7054,6 +7135,10 @@ signal_info_indication_cb (QmiClientNas *client,
     qmi_indication_nas_signal_info_output_get_wcdma_signal_strength (output, &wcdma_rssi, NULL, NULL);
     qmi_indication_nas_signal_info_output_get_lte_signal_strength (output, &lte_rssi, NULL, NULL, NULL, NULL);
 
+    /* Feed the extended signal information as well, so that the Signal
+     * interface doesn't need to poll while these indications arrive */
+    signal_info_indication_update_extended (self, output);
+
     if (common_signal_info_get_quality (cdma1x_rssi,
                                         evdo_rssi,
                                         gsm_rssi,
@@ -7874,6 +7959,143 @@ load_initial_sms_parts (MMIfaceModemMessaging *_self,
     load_initial_sms_parts_step (ctx);
 }
 
+/*****************************************************************************/
+/* Delete all SMS parts in a storage (Messaging interface) */
+
+typedef struct {
+    MMBroadbandModemQmi *self;
+    GSimpleAsyncResult *result;
+    QmiClientWms *client;
+    MMSmsStorage storage;
+    /* Each message mode is deleted separately */
+    gboolean delete_3gpp;
+    gboolean delete_cdma;
+} DeleteAllSmsPartsContext;
+
+static void
+delete_all_sms_parts_context_complete_and_free (DeleteAllSmsPartsContext *ctx)
+{
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->client);
+    g_object_unref (ctx->self);
+    g_slice_free (DeleteAllSmsPartsContext, ctx);
+}
+
+static gboolean
+messaging_delete_all_sms_parts_finish (MMIfaceModemMessaging *_self,
+                                       GAsyncResult *res,
+                                       GError **error)
+{
+    MMBroadbandModemQmi *self = MM_BROADBAND_MODEM_QMI (_self);
+
+    /* Handle fallback */
+    if (self->priv->messaging_fallback_at)
+        return iface_modem_messaging_parent->delete_all_sms_parts_finish (_self, res, error);
+
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void delete_all_sms_parts_next (DeleteAllSmsPartsContext *ctx);
+
+static void
+wms_delete_all_ready (QmiClientWms *client,
+                      GAsyncResult *res,
+                      DeleteAllSmsPartsContext *ctx)
+{
+    QmiMessageWmsDeleteOutput *output;
+    GError *error = NULL;
+
+    output = qmi_client_wms_delete_finish (client, res, &error);
+    if (!output) {
+        g_prefix_error (&error, "QMI operation failed: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    if (!qmi_message_wms_delete_output_get_result (output, &error)) {
+        g_prefix_error (&error, "Couldn't delete SMS parts: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        qmi_message_wms_delete_output_unref (output);
+        return;
+    }
+
+    qmi_message_wms_delete_output_unref (output);
+    delete_all_sms_parts_next (ctx);
+}
+
+static void
+delete_all_sms_parts_next (DeleteAllSmsPartsContext *ctx)
+{
+    QmiMessageWmsDeleteInput *input;
+    QmiWmsMessageMode mode;
+
+    if (ctx->delete_3gpp) {
+        ctx->delete_3gpp = FALSE;
+        mode = QMI_WMS_MESSAGE_MODE_GSM_WCDMA;
+    } else if (ctx->delete_cdma) {
+        ctx->delete_cdma = FALSE;
+        mode = QMI_WMS_MESSAGE_MODE_CDMA;
+    } else {
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Without memory index nor tag, all messages in the storage are deleted */
+    input = qmi_message_wms_delete_input_new ();
+    qmi_message_wms_delete_input_set_memory_storage (
+        input,
+        mm_sms_storage_to_qmi_storage_type (ctx->storage),
+        NULL);
+    qmi_message_wms_delete_input_set_message_mode (input, mode, NULL);
+    qmi_client_wms_delete (ctx->client,
+                           input,
+                           30,
+                           NULL,
+                           (GAsyncReadyCallback)wms_delete_all_ready,
+                           ctx);
+    qmi_message_wms_delete_input_unref (input);
+}
+
+static void
+messaging_delete_all_sms_parts (MMIfaceModemMessaging *_self,
+                                MMSmsStorage storage,
+                                GArray *indices,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
+    MMBroadbandModemQmi *self = MM_BROADBAND_MODEM_QMI (_self);
+    DeleteAllSmsPartsContext *ctx;
+    QmiClient *client = NULL;
+
+    /* Handle fallback */
+    if (self->priv->messaging_fallback_at) {
+        iface_modem_messaging_parent->delete_all_sms_parts (_self, storage, indices, callback, user_data);
+        return;
+    }
+
+    if (!ensure_qmi_client (MM_BROADBAND_MODEM_QMI (self),
+                            QMI_SERVICE_WMS, &client,
+                            callback, user_data))
+        return;
+
+    ctx = g_slice_new0 (DeleteAllSmsPartsContext);
+    ctx->self = g_object_ref (self);
+    ctx->client = g_object_ref (client);
+    ctx->storage = storage;
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             messaging_delete_all_sms_parts);
+    ctx->delete_3gpp = mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self));
+    ctx->delete_cdma = mm_iface_modem_is_cdma (MM_IFACE_MODEM (self));
+
+    delete_all_sms_parts_next (ctx);
+}
+
 /*****************************************************************************/
 /* Setup/Cleanup unsolicited event handlers (Messaging interface) */
 
@@ -8637,6 +8859,229 @@ location_set_supl_server (MMIfaceModemLocation *self,
     qmi_message_pds_set_agps_config_input_unref (input);
 }
 
+/*****************************************************************************/
+/* Assistance data (Location interface)
+ *
+ * gpsOneXTRA predicted orbits are injected through the LOC service, in parts
+ * small enough for a single QMI message. The LOC client is only allocated
+ * when first needed, as it isn't used for anything else.
+ */
+
+#if QMI_CHECK_VERSION (1,22,0)
+
+#define XTRA_PART_SIZE 1024
+
+static MMModemLocationAssistanceDataType
+location_load_supported_assistance_data_finish (MMIfaceModemLocation *self,
+                                                GAsyncResult *res,
+                                                GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_NONE;
+
+    return (MMModemLocationAssistanceDataType) GPOINTER_TO_UINT (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+loc_allocate_client_ready (MMPortQmi *qmi,
+                           GAsyncResult *res,
+                           GSimpleAsyncResult *simple)
+{
+    GError *error = NULL;
+
+    if (!mm_port_qmi_allocate_client_finish (qmi, res, &error)) {
+        mm_dbg ("Couldn't allocate LOC client, assistance data unsupported: %s", error->message);
+        g_error_free (error);
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   GUINT_TO_POINTER (MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_NONE),
+                                                   NULL);
+    } else
+        g_simple_async_result_set_op_res_gpointer (simple,
+                                                   GUINT_TO_POINTER (MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_XTRA),
+                                                   NULL);
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+location_load_supported_assistance_data (MMIfaceModemLocation *self,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+    MMPortQmi *port;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        location_load_supported_assistance_data);
+
+    port = mm_base_modem_peek_port_qmi (MM_BASE_MODEM (self));
+    if (!port) {
+        g_simple_async_result_set_error (result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Couldn't peek QMI port");
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    if (mm_port_qmi_peek_client (port, QMI_SERVICE_LOC, MM_PORT_QMI_FLAG_DEFAULT)) {
+        g_simple_async_result_set_op_res_gpointer (result,
+                                                   GUINT_TO_POINTER (MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_XTRA),
+                                                   NULL);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    mm_port_qmi_allocate_client (port,
+                                 QMI_SERVICE_LOC,
+                                 MM_PORT_QMI_FLAG_DEFAULT,
+                                 NULL,
+                                 (GAsyncReadyCallback)loc_allocate_client_ready,
+                                 result);
+}
+
+typedef struct {
+    GSimpleAsyncResult *result;
+    QmiClientLoc *client;
+    guint8 *data;
+    gsize data_size;
+    guint n_parts;
+    guint part;
+} InjectAssistanceDataContext;
+
+static void
+inject_assistance_data_context_complete_and_free (InjectAssistanceDataContext *ctx)
+{
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->client);
+    g_free (ctx->data);
+    g_slice_free (InjectAssistanceDataContext, ctx);
+}
+
+static gboolean
+location_inject_assistance_data_finish (MMIfaceModemLocation *self,
+                                        GAsyncResult *res,
+                                        GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void inject_assistance_data_next (InjectAssistanceDataContext *ctx);
+
+static void
+inject_predicted_orbits_data_ready (QmiClientLoc *client,
+                                    GAsyncResult *res,
+                                    InjectAssistanceDataContext *ctx)
+{
+    QmiMessageLocInjectPredictedOrbitsDataOutput *output;
+    GError *error = NULL;
+
+    output = qmi_client_loc_inject_predicted_orbits_data_finish (client, res, &error);
+    if (!output) {
+        g_prefix_error (&error, "QMI operation failed: ");
+        g_simple_async_result_take_error (ctx->result, error);
+        inject_assistance_data_context_complete_and_free (ctx);
+        return;
+    }
+
+    if (!qmi_message_loc_inject_predicted_orbits_data_output_get_result (output, &error)) {
+        g_prefix_error (&error, "Couldn't inject part %u/%u of the predicted orbits data: ",
+                        ctx->part + 1, ctx->n_parts);
+        g_simple_async_result_take_error (ctx->result, error);
+        qmi_message_loc_inject_predicted_orbits_data_output_unref (output);
+        inject_assistance_data_context_complete_and_free (ctx);
+        return;
+    }
+
+    qmi_message_loc_inject_predicted_orbits_data_output_unref (output);
+    ctx->part++;
+    inject_assistance_data_next (ctx);
+}
+
+static void
+inject_assistance_data_next (InjectAssistanceDataContext *ctx)
+{
+    QmiMessageLocInjectPredictedOrbitsDataInput *input;
+    GArray *part_data;
+    gsize offset;
+    gsize len;
+
+    if (ctx->part == ctx->n_parts) {
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        inject_assistance_data_context_complete_and_free (ctx);
+        return;
+    }
+
+    offset = (gsize) ctx->part * XTRA_PART_SIZE;
+    len = MIN (ctx->data_size - offset, XTRA_PART_SIZE);
+    part_data = g_array_sized_new (FALSE, FALSE, sizeof (guint8), len);
+    g_array_append_vals (part_data, ctx->data + offset, len);
+
+    input = qmi_message_loc_inject_predicted_orbits_data_input_new ();
+    qmi_message_loc_inject_predicted_orbits_data_input_set_total_size (input, (guint32) ctx->data_size, NULL);
+    qmi_message_loc_inject_predicted_orbits_data_input_set_total_parts (input, (guint16) ctx->n_parts, NULL);
+    qmi_message_loc_inject_predicted_orbits_data_input_set_part_number (input, (guint16) (ctx->part + 1), NULL);
+    qmi_message_loc_inject_predicted_orbits_data_input_set_part_data (input, part_data, NULL);
+    qmi_message_loc_inject_predicted_orbits_data_input_set_format_type (input, QMI_LOC_PREDICTED_ORBITS_DATA_FORMAT_XTRA, NULL);
+
+    qmi_client_loc_inject_predicted_orbits_data (ctx->client,
+                                                 input,
+                                                 10,
+                                                 NULL,
+                                                 (GAsyncReadyCallback)inject_predicted_orbits_data_ready,
+                                                 ctx);
+    qmi_message_loc_inject_predicted_orbits_data_input_unref (input);
+    g_array_unref (part_data);
+}
+
+static void
+location_inject_assistance_data (MMIfaceModemLocation *self,
+                                 const guint8 *data,
+                                 gsize data_size,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data)
+{
+    InjectAssistanceDataContext *ctx;
+    QmiClient *client = NULL;
+
+    if (!ensure_qmi_client (MM_BROADBAND_MODEM_QMI (self),
+                            QMI_SERVICE_LOC, &client,
+                            callback, user_data))
+        return;
+
+    if (data_size > G_MAXUINT32 || (data_size + XTRA_PART_SIZE - 1) / XTRA_PART_SIZE > G_MAXUINT16) {
+        g_simple_async_report_error_in_idle (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_INVALID_ARGS,
+                                             "Assistance data too big: %" G_GSIZE_FORMAT " bytes",
+                                             data_size);
+        return;
+    }
+
+    ctx = g_slice_new0 (InjectAssistanceDataContext);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             location_inject_assistance_data);
+    ctx->client = g_object_ref (client);
+    ctx->data = g_memdup (data, data_size);
+    ctx->data_size = data_size;
+    ctx->n_parts = (data_size + XTRA_PART_SIZE - 1) / XTRA_PART_SIZE;
+
+    mm_dbg ("Injecting %" G_GSIZE_FORMAT " bytes of predicted orbits data in %u parts",
+            data_size, ctx->n_parts);
+    inject_assistance_data_next (ctx);
+}
+
+#endif /* QMI_CHECK_VERSION (1,22,0) */
+
 /*****************************************************************************/
 /* Disable location gathering (Location interface) */
 
@@ -10670,25 +11115,6 @@ signal_load_values_context_complete_and_free (SignalLoadValuesContext *ctx)
     g_slice_free (SignalLoadValuesContext, ctx);
 }
 
-static gdouble
-get_db_from_sinr_level (QmiNasEvdoSinrLevel level)
-{
-    switch (level) {
-    case QMI_NAS_EVDO_SINR_LEVEL_0: return -9.0;
-    case QMI_NAS_EVDO_SINR_LEVEL_1: return -6;
-    case QMI_NAS_EVDO_SINR_LEVEL_2: return -4.5;
-    case QMI_NAS_EVDO_SINR_LEVEL_3: return -3;
-    case QMI_NAS_EVDO_SINR_LEVEL_4: return -2;
-    case QMI_NAS_EVDO_SINR_LEVEL_5: return 1;
-    case QMI_NAS_EVDO_SINR_LEVEL_6: return 3;
-    case QMI_NAS_EVDO_SINR_LEVEL_7: return 6;
-    case QMI_NAS_EVDO_SINR_LEVEL_8: return +9;
-    default:
-        mm_warn ("Invalid SINR level '%u'", level);
-        return -G_MAXDOUBLE;
-    }
-}
-
 static gboolean
 signal_load_values_finish (MMIfaceModemSignal *self,
                            GAsyncResult *res,
@@ -11112,6 +11538,7 @@ typedef struct {
     GSimpleAsyncResult *result;
     MMPortQmi *qmi;
     QmiService services[32];
+    MMPortQmiFlag flags[32];
     guint service_index;
 } InitializationStartedContext;
 
@@ -11202,7 +11629,7 @@ allocate_next_client (InitializationStartedContext *ctx)
     /* Otherwise, allocate next client */
     mm_port_qmi_allocate_client (ctx->qmi,
                                  ctx->services[ctx->service_index],
-                                 MM_PORT_QMI_FLAG_DEFAULT,
+                                 ctx->flags[ctx->service_index],
                                  NULL,
                                  (GAsyncReadyCallback)qmi_port_allocate_client_ready,
                                  ctx);
@@ -11287,7 +11714,14 @@ initialization_started (MMBroadbandModem *self,
     ctx->services[3] = QMI_SERVICE_PDS;
     ctx->services[4] = QMI_SERVICE_OMA;
     ctx->services[5] = QMI_SERVICE_UIM;
-    ctx->services[6] = QMI_SERVICE_UNKNOWN;
+    /* The WDS clients used by the bearers are also allocated right away, so
+     * that connection attempts don't need to wait for them; flags of the
+     * other services are left to DEFAULT */
+    ctx->services[6] = QMI_SERVICE_WDS;
+    ctx->flags[6] = MM_PORT_QMI_FLAG_WDS_IPV4;
+    ctx->services[7] = QMI_SERVICE_WDS;
+    ctx->flags[7] = MM_PORT_QMI_FLAG_WDS_IPV6;
+    ctx->services[8] = QMI_SERVICE_UNKNOWN;
 
     /* Now open our QMI port */
     mm_port_qmi_open (ctx->qmi,
@@ -11546,6 +11980,8 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->disable_unsolicited_events = messaging_disable_unsolicited_events;
     iface->disable_unsolicited_events_finish = messaging_disable_unsolicited_events_finish;
     iface->create_sms = messaging_create_sms;
+    iface->delete_all_sms_parts = messaging_delete_all_sms_parts;
+    iface->delete_all_sms_parts_finish = messaging_delete_all_sms_parts_finish;
 }
 
 static void
@@ -11559,6 +11995,12 @@ iface_modem_location_init (MMIfaceModemLocation *iface)
     iface->load_supl_server_finish = location_load_supl_server_finish;
     iface->set_supl_server = location_set_supl_server;
     iface->set_supl_server_finish = location_set_supl_server_finish;
+#if QMI_CHECK_VERSION (1,22,0)
+    iface->load_supported_assistance_data = location_load_supported_assistance_data;
+    iface->load_supported_assistance_data_finish = location_load_supported_assistance_data_finish;
+    iface->inject_assistance_data = location_inject_assistance_data;
+    iface->inject_assistance_data_finish = location_inject_assistance_data_finish;
+#endif
     iface->enable_location_gathering = enable_location_gathering;
     iface->enable_location_gathering_finish = enable_location_gathering_finish;
     iface->disable_location_gathering = disable_location_gathering;
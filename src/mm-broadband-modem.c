@@ -41,14 +41,20 @@
 #include "mm-iface-modem-firmware.h"
 #include "mm-iface-modem-signal.h"
 #include "mm-iface-modem-oma.h"
+#include "mm-context.h"
 #include "mm-broadband-bearer.h"
 #include "mm-bearer-list.h"
 #include "mm-sms-list.h"
+#include "mm-sms-cache.h"
 #include "mm-sms-part-3gpp.h"
 #include "mm-call-list.h"
 #include "mm-base-sim.h"
+#include "mm-clock.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
+#include "mm-lazy-interface.h"
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
 #include "mm-error-helpers.h"
 #include "mm-port-serial-qcdm.h"
 #include "libqcdm/src/errors.h"
@@ -115,6 +121,8 @@ enum {
     PROP_MODEM_VOICE_CALL_LIST,
     PROP_MODEM_SIMPLE_STATUS,
     PROP_MODEM_SIM_HOT_SWAP_SUPPORTED,
+    PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED,
+    PROP_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED,
     PROP_LAST
 };
 
@@ -130,6 +138,9 @@ struct _MMBroadbandModemPrivate {
     PortsContext *sim_hot_swap_ports_ctx;
     gboolean modem_init_run;
     gboolean sim_hot_swap_supported;
+    gboolean periodic_signal_check_disabled;
+    gboolean periodic_registration_check_disabled;
+    gboolean bearer_adoption_done;
 
     /*<--- Modem interface --->*/
     /* Properties */
@@ -138,6 +149,8 @@ struct _MMBroadbandModemPrivate {
     MMBearerList *modem_bearer_list;
     MMModemState modem_state;
     /* Implementation helpers */
+    gpointer sim_ready_ctx;
+    /* Implementation helpers */
     MMModemCharset modem_current_charset;
     gboolean modem_cind_support_checked;
     gboolean modem_cind_supported;
@@ -155,8 +168,10 @@ struct _MMBroadbandModemPrivate {
     gboolean modem_3gpp_ps_network_supported;
     gboolean modem_3gpp_eps_network_supported;
     /* Implementation helpers */
-    GPtrArray *modem_3gpp_registration_regex;
     MMModem3gppFacility modem_3gpp_ignored_facility_locks;
+    /* Cached list of MM3gppPdpContext, as last read with +CGDCONT? */
+    GList *pdp_contexts;
+    gboolean pdp_contexts_valid;
 
     /*<--- Modem 3GPP USSD interface --->*/
     /* Properties */
@@ -178,6 +193,9 @@ struct _MMBroadbandModemPrivate {
     gboolean has_spservice;
     gboolean has_speri;
     gint evdo_pilot_rssi;
+    /* Last combined QCDM poll, and requests waiting for the running one */
+    struct _QcdmSnapshot *qcdm_snapshot;
+    GList *qcdm_snapshot_waiters;
 
     /*<--- Modem Simple interface --->*/
     /* Properties */
@@ -198,8 +216,19 @@ struct _MMBroadbandModemPrivate {
     gboolean sms_supported_modes_checked;
     gboolean mem1_storage_locked;
     MMSmsStorage current_sms_mem1_storage;
+    /* Number of messages in mem1 reported when locking it, -1 if unknown */
+    gint mem1_storage_used;
     gboolean mem2_storage_locked;
     MMSmsStorage current_sms_mem2_storage;
+    MMSmsCache *sms_cache;
+    gboolean sms_cache_loaded;
+    /* +CMTI indications waiting to be read, as CmtiIndication */
+    GArray *cmti_pending;
+    guint cmti_batch_id;
+    gboolean cmti_batch_running;
+    /* Messages delivered in +CMT/+CDS and acknowledged with +CNMA, instead
+     * of stored and announced with +CMTI */
+    gboolean sms_direct_delivery;
 
     /*<--- Modem Voice interface --->*/
     /* Properties */
@@ -1716,6 +1745,207 @@ modem_load_supported_ip_families (MMIfaceModem *self,
         result);
 }
 
+/*****************************************************************************/
+/* Combined QCDM status snapshot (Modem and CDMA interfaces)
+ *
+ * CDMA signal quality (pilot sets) and registration (CDMA status and HDR
+ * state) are loaded from a single QCDM poll: the three commands are queued
+ * back-to-back, and the responses are reused for a few seconds so that the
+ * signal quality and registration checks share one poll.
+ */
+
+#define QCDM_SNAPSHOT_MAX_AGE_SECS 5
+
+typedef struct _QcdmSnapshot {
+    volatile gint ref_count;
+    gint64 timestamp;
+    /* Raw responses, NULL if the command failed */
+    GByteArray *pilot_sets;
+    GByteArray *cdma_status;
+    GByteArray *hdr_state;
+} QcdmSnapshot;
+
+static QcdmSnapshot *
+qcdm_snapshot_ref (QcdmSnapshot *snapshot)
+{
+    g_atomic_int_inc (&snapshot->ref_count);
+    return snapshot;
+}
+
+static void
+qcdm_snapshot_unref (QcdmSnapshot *snapshot)
+{
+    if (g_atomic_int_dec_and_test (&snapshot->ref_count)) {
+        if (snapshot->pilot_sets)
+            g_byte_array_unref (snapshot->pilot_sets);
+        if (snapshot->cdma_status)
+            g_byte_array_unref (snapshot->cdma_status);
+        if (snapshot->hdr_state)
+            g_byte_array_unref (snapshot->hdr_state);
+        g_slice_free (QcdmSnapshot, snapshot);
+    }
+}
+
+typedef struct {
+    MMBroadbandModem *self;
+    QcdmSnapshot *snapshot;
+    guint n_pending;
+} QcdmSnapshotContext;
+
+typedef struct {
+    QcdmSnapshotContext *ctx;
+    GByteArray **response;
+} QcdmSnapshotCommand;
+
+static QcdmSnapshot *
+qcdm_snapshot_load_finish (MMBroadbandModem *self,
+                           GAsyncResult *res,
+                           GError **error)
+{
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
+        return NULL;
+
+    return qcdm_snapshot_ref ((QcdmSnapshot *) g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)));
+}
+
+static void
+qcdm_snapshot_context_complete_and_free (QcdmSnapshotContext *ctx)
+{
+    MMBroadbandModem *self = ctx->self;
+    QcdmSnapshot *snapshot = ctx->snapshot;
+    GList *waiters;
+    GList *l;
+
+    if (snapshot->pilot_sets || snapshot->cdma_status || snapshot->hdr_state) {
+        snapshot->timestamp = mm_clock_get_time ();
+        if (self->priv->qcdm_snapshot)
+            qcdm_snapshot_unref (self->priv->qcdm_snapshot);
+        self->priv->qcdm_snapshot = qcdm_snapshot_ref (snapshot);
+    }
+
+    waiters = self->priv->qcdm_snapshot_waiters;
+    self->priv->qcdm_snapshot_waiters = NULL;
+    for (l = waiters; l; l = g_list_next (l)) {
+        GSimpleAsyncResult *result = l->data;
+
+        if (self->priv->qcdm_snapshot == snapshot)
+            g_simple_async_result_set_op_res_gpointer (result,
+                                                       qcdm_snapshot_ref (snapshot),
+                                                       (GDestroyNotify) qcdm_snapshot_unref);
+        else
+            g_simple_async_result_set_error (result,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_FAILED,
+                                             "QCDM status poll failed");
+        g_simple_async_result_complete (result);
+        g_object_unref (result);
+    }
+    g_list_free (waiters);
+
+    qcdm_snapshot_unref (snapshot);
+    g_object_unref (self);
+    g_slice_free (QcdmSnapshotContext, ctx);
+}
+
+static void
+qcdm_snapshot_command_ready (MMPortSerialQcdm *port,
+                             GAsyncResult *res,
+                             QcdmSnapshotCommand *command)
+{
+    QcdmSnapshotContext *ctx = command->ctx;
+    GError *error = NULL;
+
+    *command->response = mm_port_serial_qcdm_command_finish (port, res, &error);
+    if (error) {
+        mm_dbg ("QCDM status poll command failed: %s", error->message);
+        g_error_free (error);
+    }
+    g_slice_free (QcdmSnapshotCommand, command);
+
+    if (--ctx->n_pending == 0)
+        qcdm_snapshot_context_complete_and_free (ctx);
+}
+
+static void
+qcdm_snapshot_command (QcdmSnapshotContext *ctx,
+                       MMPortSerialQcdm *qcdm,
+                       GByteArray *cmd,
+                       GByteArray **response)
+{
+    QcdmSnapshotCommand *command;
+
+    g_assert (cmd->len);
+    command = g_slice_new (QcdmSnapshotCommand);
+    command->ctx = ctx;
+    command->response = response;
+    ctx->n_pending++;
+    mm_port_serial_qcdm_command (qcdm,
+                                 cmd,
+                                 3,
+                                 NULL,
+                                 (GAsyncReadyCallback)qcdm_snapshot_command_ready,
+                                 command);
+    g_byte_array_unref (cmd);
+}
+
+static void
+qcdm_snapshot_load (MMBroadbandModem *self,
+                    MMPortSerialQcdm *qcdm,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+    QcdmSnapshotContext *ctx;
+    GByteArray *cmd;
+    gboolean running;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        qcdm_snapshot_load);
+
+    /* Reuse the last poll if recent enough */
+    if (self->priv->qcdm_snapshot &&
+        (mm_clock_get_time () - self->priv->qcdm_snapshot->timestamp) < (QCDM_SNAPSHOT_MAX_AGE_SECS * G_USEC_PER_SEC)) {
+        g_simple_async_result_set_op_res_gpointer (result,
+                                                   qcdm_snapshot_ref (self->priv->qcdm_snapshot),
+                                                   (GDestroyNotify) qcdm_snapshot_unref);
+        g_simple_async_result_complete_in_idle (result);
+        g_object_unref (result);
+        return;
+    }
+
+    /* If a poll is already running, just wait for it */
+    running = !!self->priv->qcdm_snapshot_waiters;
+    self->priv->qcdm_snapshot_waiters = g_list_append (self->priv->qcdm_snapshot_waiters, result);
+    if (running)
+        return;
+
+    ctx = g_slice_new0 (QcdmSnapshotContext);
+    ctx->self = g_object_ref (self);
+    ctx->snapshot = g_slice_new0 (QcdmSnapshot);
+    ctx->snapshot->ref_count = 1;
+
+    /* All commands are queued at once, so that they go out back-to-back. The
+     * extra pending count keeps the context alive while queueing them. */
+    ctx->n_pending = 1;
+
+    cmd = g_byte_array_sized_new (25);
+    cmd->len = qcdm_cmd_pilot_sets_new ((char *) cmd->data, 25);
+    qcdm_snapshot_command (ctx, qcdm, cmd, &ctx->snapshot->pilot_sets);
+
+    cmd = g_byte_array_sized_new (25);
+    cmd->len = qcdm_cmd_cdma_status_new ((char *) cmd->data, 25);
+    qcdm_snapshot_command (ctx, qcdm, cmd, &ctx->snapshot->cdma_status);
+
+    cmd = g_byte_array_sized_new (25);
+    cmd->len = qcdm_cmd_hdr_subsys_state_info_new ((char *) cmd->data, 25);
+    qcdm_snapshot_command (ctx, qcdm, cmd, &ctx->snapshot->hdr_state);
+
+    if (--ctx->n_pending == 0)
+        qcdm_snapshot_context_complete_and_free (ctx);
+}
+
 /*****************************************************************************/
 /* Signal quality loading (Modem interface) */
 
@@ -1820,12 +2050,16 @@ signal_quality_csq_ready (MMBroadbandModem *self,
 
     result_str = g_variant_get_string (result, NULL);
     if (result_str) {
-        /* Got valid reply */
-        int quality;
-        int ber;
-
-        result_str = mm_strip_tag (result_str, "+CSQ:");
-        if (sscanf (result_str, "%d, %d", &quality, &ber)) {
+        /* +CSQ: <rssi>[,<ber>] */
+        static const MMAtResponseShape shape = {
+            "+CSQ:", FALSE, 1,
+            { MM_AT_FIELD_INT, MM_AT_FIELD_INT }
+        };
+        MMAtResponseFields fields;
+        gint quality;
+
+        if (mm_at_response_shape_parse (&shape, result_str, &fields, NULL) &&
+            mm_at_response_fields_get_int (&fields, 0, &quality)) {
             if (quality == 99) {
                 /* 99 can mean unknown, no service, etc.  But the modem may
                  * also only report CDMA 1x quality in CSQ, so try EVDO via
@@ -1970,29 +2204,39 @@ signal_quality_cind (SignalQualityContext *ctx)
 }
 
 static void
-signal_quality_qcdm_ready (MMPortSerialQcdm *port,
+signal_quality_qcdm_ready (MMBroadbandModem *self,
                            GAsyncResult *res,
                            SignalQualityContext *ctx)
 {
     QcdmResult *result;
+    QcdmSnapshot *snapshot;
     guint32 num = 0, quality = 0, i;
     gfloat best_db = -28;
     gint err = QCDM_SUCCESS;
-    GByteArray *response;
     GError *error = NULL;
 
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
+    snapshot = qcdm_snapshot_load_finish (self, res, &error);
+    if (!snapshot) {
         g_simple_async_result_take_error (ctx->result, error);
         signal_quality_context_complete_and_free (ctx);
         return;
     }
 
+    if (!snapshot->pilot_sets) {
+        qcdm_snapshot_unref (snapshot);
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Failed to load pilot sets");
+        signal_quality_context_complete_and_free (ctx);
+        return;
+    }
+
     /* Parse the response */
-    result = qcdm_cmd_pilot_sets_result ((const gchar *) response->data,
-                                         response->len,
+    result = qcdm_cmd_pilot_sets_result ((const gchar *) snapshot->pilot_sets->data,
+                                         snapshot->pilot_sets->len,
                                          &err);
-    g_byte_array_unref (response);
+    qcdm_snapshot_unref (snapshot);
     if (!result) {
         g_simple_async_result_set_error (ctx->result,
                                          MM_CORE_ERROR,
@@ -2039,7 +2283,6 @@ signal_quality_qcdm_ready (MMPortSerialQcdm *port,
 static void
 signal_quality_qcdm (SignalQualityContext *ctx)
 {
-    GByteArray *pilot_sets;
     guint quality;
 
     /* If EVDO is active try that signal strength first */
@@ -2053,17 +2296,10 @@ signal_quality_qcdm (SignalQualityContext *ctx)
     }
 
     /* Use CDMA1x pilot EC/IO if we can */
-    pilot_sets = g_byte_array_sized_new (25);
-    pilot_sets->len = qcdm_cmd_pilot_sets_new ((char *) pilot_sets->data, 25);
-    g_assert (pilot_sets->len);
-
-    mm_port_serial_qcdm_command (MM_PORT_SERIAL_QCDM (ctx->port),
-                                 pilot_sets,
-                                 3,
-                                 NULL,
-                                 (GAsyncReadyCallback)signal_quality_qcdm_ready,
-                                 ctx);
-    g_byte_array_unref (pilot_sets);
+    qcdm_snapshot_load (ctx->self,
+                        MM_PORT_SERIAL_QCDM (ctx->port),
+                        (GAsyncReadyCallback)signal_quality_qcdm_ready,
+                        ctx);
 }
 
 static void
@@ -2082,8 +2318,9 @@ modem_load_signal_quality (MMIfaceModem *self,
                                              user_data,
                                              modem_load_signal_quality);
 
-    /* Check whether we can get a non-connected AT port */
-    ctx->port = (MMPortSerial *)mm_base_modem_get_best_at_port (MM_BASE_MODEM (self), &error);
+    /* Check whether we can get a non-connected AT port; signal quality
+     * queries don't change any state, so any of them will do */
+    ctx->port = (MMPortSerial *)mm_base_modem_get_least_loaded_at_port (MM_BASE_MODEM (self), &error);
     if (ctx->port) {
         if (MM_BROADBAND_MODEM (self)->priv->modem_cind_supported &&
             CIND_INDICATOR_IS_VALID (MM_BROADBAND_MODEM (self)->priv->modem_cind_indicator_signal_quality))
@@ -3149,6 +3386,11 @@ cfun_query_ready (MMBaseModem *self,
                   GAsyncResult *res,
                   GSimpleAsyncResult *simple)
 {
+    static const MMAtResponseShape cfun_shape = {
+        "+CFUN:", FALSE, 1,
+        { MM_AT_FIELD_UINT }
+    };
+    MMAtResponseFields fields;
     const gchar *result;
     guint state;
     GError *error = NULL;
@@ -3161,9 +3403,9 @@ cfun_query_ready (MMBaseModem *self,
         return;
     }
 
-    /* Parse power state reply */
-    result = mm_strip_tag (result, "+CFUN:");
-    if (!mm_get_uint_from_str (result, &state)) {
+    /* Parse power state reply: +CFUN: <fun>[,...] */
+    if (!mm_at_response_shape_parse (&cfun_shape, result, &fields, NULL) ||
+        !mm_at_response_fields_get_uint (&fields, 0, &state)) {
         g_simple_async_result_set_error (simple,
                                          MM_CORE_ERROR,
                                          MM_CORE_ERROR_FAILED,
@@ -3616,8 +3858,10 @@ registration_state_changed (MMPortSerialAt *port,
     gboolean cgreg = FALSE;
     gboolean cereg = FALSE;
     GError *error = NULL;
+    gchar *str;
 
-    if (!mm_3gpp_parse_creg_response (match_info,
+    str = g_match_info_fetch (match_info, 1);
+    if (!mm_3gpp_parse_creg_response (str,
                                       &state,
                                       &lac,
                                       &cell_id,
@@ -3628,8 +3872,10 @@ registration_state_changed (MMPortSerialAt *port,
         mm_warn ("error parsing unsolicited registration: %s",
                  error && error->message ? error->message : "(unknown)");
         g_clear_error (&error);
+        g_free (str);
         return;
     }
+    g_free (str);
 
     /* Report new registration state */
     if (cgreg)
@@ -3658,9 +3904,8 @@ modem_3gpp_setup_unsolicited_registration_events (MMIfaceModem3gpp *self,
 {
     GSimpleAsyncResult *result;
     MMPortSerialAt *ports[2];
-    GPtrArray *array;
+    GRegex *regex;
     guint i;
-    guint j;
 
     result = g_simple_async_result_new (G_OBJECT (self),
                                         callback,
@@ -3671,23 +3916,21 @@ modem_3gpp_setup_unsolicited_registration_events (MMIfaceModem3gpp *self,
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
 
     /* Set up CREG unsolicited message handlers in both ports */
-    array = mm_3gpp_creg_regex_get (FALSE);
+    regex = mm_3gpp_creg_regex_get ();
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
 
         mm_dbg ("(%s) setting up 3GPP unsolicited registration messages handlers",
                 mm_port_get_device (MM_PORT (ports[i])));
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (
-                MM_PORT_SERIAL_AT (ports[i]),
-                (GRegex *) g_ptr_array_index (array, j),
-                (MMPortSerialAtUnsolicitedMsgFn)registration_state_changed,
-                self,
-                NULL);
-        }
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            MM_PORT_SERIAL_AT (ports[i]),
+            regex,
+            (MMPortSerialAtUnsolicitedMsgFn)registration_state_changed,
+            self,
+            NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
+    g_regex_unref (regex);
 
     g_simple_async_result_set_op_res_gboolean (result, TRUE);
     g_simple_async_result_complete_in_idle (result);
@@ -3712,9 +3955,8 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
 {
     GSimpleAsyncResult *result;
     MMPortSerialAt *ports[2];
-    GPtrArray *array;
+    GRegex *regex;
     guint i;
-    guint j;
 
     result = g_simple_async_result_new (G_OBJECT (self),
                                         callback,
@@ -3725,7 +3967,7 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
 
     /* Set up CREG unsolicited message handlers in both ports */
-    array = mm_3gpp_creg_regex_get (FALSE);
+    regex = mm_3gpp_creg_regex_get ();
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
@@ -3733,16 +3975,14 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
         mm_dbg ("(%s) cleaning up unsolicited registration messages handlers",
                 mm_port_get_device (MM_PORT (ports[i])));
 
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (
-                MM_PORT_SERIAL_AT (ports[i]),
-                (GRegex *) g_ptr_array_index (array, j),
-                NULL,
-                NULL,
-                NULL);
-        }
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            MM_PORT_SERIAL_AT (ports[i]),
+            regex,
+            NULL,
+            NULL,
+            NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
+    g_regex_unref (regex);
 
     g_simple_async_result_set_op_res_gboolean (result, TRUE);
     g_simple_async_result_complete_in_idle (result);
@@ -3752,18 +3992,66 @@ modem_3gpp_cleanup_unsolicited_registration_events (MMIfaceModem3gpp *self,
 /*****************************************************************************/
 /* Scan networks (3GPP interface) */
 
+typedef struct {
+    MMBroadbandModem *self;
+    GSimpleAsyncResult *result;
+    MMPortSerialAt *port;
+    guint n_networks;
+} ScanNetworksContext;
+
+static void
+scan_networks_context_complete_and_free (ScanNetworksContext *ctx)
+{
+    mm_port_serial_at_set_partial_response_handler (ctx->port, NULL, NULL);
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->port);
+    g_object_unref (ctx->self);
+    g_slice_free (ScanNetworksContext, ctx);
+}
+
 static GList *
 modem_3gpp_scan_networks_finish (MMIfaceModem3gpp *self,
                                  GAsyncResult *res,
                                  GError **error)
 {
-    const gchar *result;
-
-    result = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, error);
-    if (!result)
+    if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
         return NULL;
 
-    return mm_3gpp_parse_cops_test_response (result, error);
+    return mm_3gpp_parse_cops_test_response (g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res)),
+                                             error);
+}
+
+static void
+cops_test_partial_response (MMPortSerialAt *port,
+                            const gchar *partial,
+                            ScanNetworksContext *ctx)
+{
+    GList *info_list;
+
+    /* The whole response received so far is parsed each time, as URCs
+     * in between may have been removed from it */
+    info_list = mm_3gpp_parse_cops_test_partial_response (partial, &ctx->n_networks);
+    if (info_list) {
+        mm_iface_modem_3gpp_report_scanned_networks (MM_IFACE_MODEM_3GPP (ctx->self), info_list);
+        mm_3gpp_network_info_list_free (info_list);
+    }
+}
+
+static void
+cops_test_ready (MMBaseModem *self,
+                 GAsyncResult *res,
+                 ScanNetworksContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+
+    response = mm_base_modem_at_command_full_finish (self, res, &error);
+    if (!response)
+        g_simple_async_result_take_error (ctx->result, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (ctx->result, g_strdup (response), g_free);
+    scan_networks_context_complete_and_free (ctx);
 }
 
 static void
@@ -3771,12 +4059,42 @@ modem_3gpp_scan_networks (MMIfaceModem3gpp *self,
                           GAsyncReadyCallback callback,
                           gpointer user_data)
 {
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              "+COPS=?",
-                              120,
-                              FALSE,
-                              callback,
-                              user_data);
+    ScanNetworksContext *ctx;
+    MMPortSerialAt *port;
+    GError *error = NULL;
+
+    port = mm_base_modem_peek_best_at_port (MM_BASE_MODEM (self), &error);
+    if (!port) {
+        g_simple_async_report_take_gerror_in_idle (G_OBJECT (self),
+                                                   callback,
+                                                   user_data,
+                                                   error);
+        return;
+    }
+
+    ctx = g_slice_new0 (ScanNetworksContext);
+    ctx->self = g_object_ref (self);
+    ctx->port = g_object_ref (port);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             modem_3gpp_scan_networks);
+
+    /* Networks are reported as soon as the modem gives them, as the whole
+     * scan may take minutes */
+    mm_port_serial_at_set_partial_response_handler (port,
+                                                    (MMPortSerialAtPartialResponseFn)cops_test_partial_response,
+                                                    ctx);
+
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   port,
+                                   "+COPS=?",
+                                   120,
+                                   FALSE,
+                                   FALSE, /* raw */
+                                   NULL, /* cancellable */
+                                   (GAsyncReadyCallback)cops_test_ready,
+                                   ctx);
 }
 
 /*****************************************************************************/
@@ -3875,8 +4193,6 @@ registration_status_check_ready (MMBroadbandModem *self,
 {
     const gchar *response;
     GError *error = NULL;
-    GMatchInfo *match_info;
-    guint i;
     gboolean parsed;
     gboolean cgreg;
     gboolean cereg;
@@ -3913,43 +4229,13 @@ registration_status_check_ready (MMBroadbandModem *self,
         return;
     }
 
-    /* Try to match the response */
-    for (i = 0;
-         i < self->priv->modem_3gpp_registration_regex->len;
-         i++) {
-        if (g_regex_match ((GRegex *)g_ptr_array_index (
-                               self->priv->modem_3gpp_registration_regex, i),
-                           response,
-                           0,
-                           &match_info))
-            break;
-        g_match_info_free (match_info);
-        match_info = NULL;
-    }
-
-    if (!match_info) {
-        error = g_error_new (MM_CORE_ERROR,
-                             MM_CORE_ERROR_FAILED,
-                             "Unknown registration status response: '%s'",
-                             response);
-        if (ctx->running_cs)
-            ctx->cs_error = error;
-        else if (ctx->running_ps)
-            ctx->ps_error = error;
-        else
-            ctx->eps_error = error;
-
-        run_registration_checks_context_step (ctx);
-        return;
-    }
-
     cgreg = FALSE;
     cereg = FALSE;
     state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     act = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
     lac = 0;
     cid = 0;
-    parsed = mm_3gpp_parse_creg_response (match_info,
+    parsed = mm_3gpp_parse_creg_response (response,
                                           &state,
                                           &lac,
                                           &cid,
@@ -3957,7 +4243,6 @@ registration_status_check_ready (MMBroadbandModem *self,
                                           &cgreg,
                                           &cereg,
                                           &error);
-    g_match_info_free (match_info);
 
     if (!parsed) {
         if (!error)
@@ -4013,12 +4298,12 @@ run_registration_checks_context_step (RunRegistrationChecksContext *ctx)
         ctx->running_cs = TRUE;
         ctx->run_cs = FALSE;
         /* Check current CS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                  "+CREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  ctx);
+        mm_base_modem_at_command_any_port (MM_BASE_MODEM (ctx->self),
+                                           "+CREG?",
+                                           10,
+                                           FALSE,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           ctx);
         return;
     }
 
@@ -4026,12 +4311,12 @@ run_registration_checks_context_step (RunRegistrationChecksContext *ctx)
         ctx->running_ps = TRUE;
         ctx->run_ps = FALSE;
         /* Check current PS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                  "+CGREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  ctx);
+        mm_base_modem_at_command_any_port (MM_BASE_MODEM (ctx->self),
+                                           "+CGREG?",
+                                           10,
+                                           FALSE,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           ctx);
         return;
     }
 
@@ -4039,12 +4324,12 @@ run_registration_checks_context_step (RunRegistrationChecksContext *ctx)
         ctx->running_eps = TRUE;
         ctx->run_eps = FALSE;
         /* Check current EPS-registration state. */
-        mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                                  "+CEREG?",
-                                  10,
-                                  FALSE,
-                                  (GAsyncReadyCallback)registration_status_check_ready,
-                                  ctx);
+        mm_base_modem_at_command_any_port (MM_BASE_MODEM (ctx->self),
+                                           "+CEREG?",
+                                           10,
+                                           FALSE,
+                                           (GAsyncReadyCallback)registration_status_check_ready,
+                                           ctx);
         return;
     }
 
@@ -5456,8 +5741,9 @@ lock_storages_cpms_set_ready (MMBaseModem *self,
                               LockSmsStoragesContext *ctx)
 {
     GError *error = NULL;
+    const gchar *response;
 
-    mm_base_modem_at_command_finish (self, res, &error);
+    response = mm_base_modem_at_command_finish (self, res, &error);
     if (error) {
         g_simple_async_result_take_error (ctx->result, error);
         /* Reset previous storages and set unlocked */
@@ -5470,8 +5756,14 @@ lock_storages_cpms_set_ready (MMBaseModem *self,
             ctx->self->priv->mem2_storage_locked = FALSE;
         }
     }
-    else
+    else {
+        guint used;
+
+        /* The reply tells how many messages there are in mem1 */
+        if (ctx->mem1_locked && mm_3gpp_parse_cpms_set_response (response, &used, NULL))
+            ctx->self->priv->mem1_storage_used = (gint) MIN (used, G_MAXINT);
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    }
 
     lock_sms_storages_context_complete_and_free (ctx);
 }
@@ -5516,6 +5808,7 @@ mm_broadband_modem_lock_sms_storages (MMBroadbandModem *self,
     if (mem1 != MM_SMS_STORAGE_UNKNOWN) {
         ctx->mem1_locked = TRUE;
         ctx->previous_mem1 = self->priv->current_sms_mem1_storage;
+        self->priv->mem1_storage_used = -1;
         self->priv->mem1_storage_locked = TRUE;
         self->priv->current_sms_mem1_storage = mem1;
         mem1_str = g_ascii_strup (mm_sms_storage_get_string (self->priv->current_sms_mem1_storage), -1);
@@ -5756,33 +6049,71 @@ modem_messaging_setup_cleanup_unsolicited_events_finish (MMIfaceModemMessaging *
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
+/* +CMTI indications arriving in bursts (e.g. all the parts of a multipart
+ * message, or everything queued while out of coverage) are collected for this
+ * long, and then read in one go for each storage */
+#define CMTI_BATCH_WINDOW_MS 200
+/* Time before retrying if the storage was locked by someone else */
+#define CMTI_BATCH_RETRY_MS  1000
+
+typedef struct {
+    MMSmsStorage storage;
+    guint idx;
+} CmtiIndication;
+
 typedef struct {
     MMBroadbandModem *self;
-    GSimpleAsyncResult *result;
+    MMSmsStorage storage;
+    /* Array of guint */
+    GArray *indexes;
+    guint pending_reads;
+} CmtiBatchContext;
+
+typedef struct {
+    CmtiBatchContext *batch;
     guint idx;
-} SmsPartContext;
+} CmtiReadContext;
+
+static void cmti_batch_schedule (MMBroadbandModem *self,
+                                 guint timeout_ms);
 
 static void
-sms_part_context_complete_and_free (SmsPartContext *ctx)
+cmti_batch_context_free (CmtiBatchContext *ctx)
 {
-    g_simple_async_result_complete (ctx->result);
-    g_object_unref (ctx->result);
+    g_array_unref (ctx->indexes);
     g_object_unref (ctx->self);
-    g_free (ctx);
+    g_slice_free (CmtiBatchContext, ctx);
+}
+
+static void
+cmti_batch_finish (CmtiBatchContext *ctx)
+{
+    MMBroadbandModem *self = ctx->self;
+
+    /* Always always always unlock mem1 storage. Warned you've been. */
+    mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+    self->priv->cmti_batch_running = FALSE;
+
+    /* Indications for other storages, or received meanwhile */
+    if (self->priv->cmti_pending && self->priv->cmti_pending->len > 0)
+        cmti_batch_schedule (self, 0);
+
+    cmti_batch_context_free (ctx);
 }
 
 static void
 sms_part_ready (MMBroadbandModem *self,
                 GAsyncResult *res,
-                SmsPartContext *ctx)
+                CmtiReadContext *read_ctx)
 {
+    CmtiBatchContext *ctx = read_ctx->batch;
+    guint idx = read_ctx->idx;
     MMSmsPart *part;
     MM3gppPduInfo *info;
     const gchar *response;
     GError *error = NULL;
 
-    /* Always always always unlock mem1 storage. Warned you've been. */
-    mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+    g_slice_free (CmtiReadContext, read_ctx);
 
     response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
     if (error) {
@@ -5790,66 +6121,162 @@ sms_part_ready (MMBroadbandModem *self,
          * passed to the async operation, so just log the error here. */
         mm_warn ("Couldn't retrieve SMS part: '%s'",
                  error->message);
-        g_simple_async_result_take_error (ctx->result, error);
-        sms_part_context_complete_and_free (ctx);
-        return;
+        g_error_free (error);
+        goto out;
     }
 
-    info = mm_3gpp_parse_cmgr_read_response (response, ctx->idx, &error);
+    info = mm_3gpp_parse_cmgr_read_response (response, idx, &error);
     if (!info) {
         mm_warn ("Couldn't parse SMS part: '%s'",
                  error->message);
-        g_simple_async_result_take_error (ctx->result, error);
-        sms_part_context_complete_and_free (ctx);
-        return;
+        g_error_free (error);
+        goto out;
     }
 
     part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
     if (part) {
-        mm_dbg ("Correctly parsed PDU (%d)", ctx->idx);
+        mm_dbg ("Correctly parsed PDU (%d)", idx);
         mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
                                             part,
                                             MM_SMS_STATE_RECEIVED,
                                             self->priv->modem_messaging_sms_default_storage);
+        if (peek_sms_cache (self))
+            mm_sms_cache_add (peek_sms_cache (self), ctx->storage, idx, info->status, info->pdu);
     } else {
         /* Don't treat the error as critical */
-        mm_dbg ("Error parsing PDU (%d): %s", ctx->idx, error->message);
+        mm_dbg ("Error parsing PDU (%d): %s", idx, error->message);
         g_error_free (error);
     }
 
-    /* All done */
     mm_3gpp_pdu_info_free (info);
-    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-    sms_part_context_complete_and_free (ctx);
+
+out:
+    if (--ctx->pending_reads == 0)
+        cmti_batch_finish (ctx);
 }
 
 static void
 indication_lock_storages_ready (MMBroadbandModem *self,
                                 GAsyncResult *res,
-                                SmsPartContext *ctx)
+                                CmtiBatchContext *ctx)
 {
-    gchar *command;
     GError *error = NULL;
+    guint i;
 
     if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
-        /* TODO: we should either make this lock() never fail, by automatically
-         * retrying after some time, or otherwise retry here. */
-        g_simple_async_result_take_error (ctx->result, error);
-        sms_part_context_complete_and_free (ctx);
+        self->priv->cmti_batch_running = FALSE;
+
+        /* Storage in use by someone else; keep the indications and try again
+         * a bit later */
+        if (g_error_matches (error, MM_CORE_ERROR, MM_CORE_ERROR_RETRY)) {
+            for (i = 0; i < ctx->indexes->len; i++) {
+                CmtiIndication indication;
+
+                indication.storage = ctx->storage;
+                indication.idx = g_array_index (ctx->indexes, guint, i);
+                g_array_append_val (self->priv->cmti_pending, indication);
+            }
+            cmti_batch_schedule (self, CMTI_BATCH_RETRY_MS);
+        } else {
+            mm_warn ("Couldn't lock SMS storage to read new messages: '%s'", error->message);
+            if (self->priv->cmti_pending->len > 0)
+                cmti_batch_schedule (self, 0);
+        }
+
+        g_error_free (error);
+        cmti_batch_context_free (ctx);
         return;
     }
 
-    /* Storage now set and locked */
+    /* Storage now set and locked; all the reads are queued right away, so that
+     * they go out back to back */
+    mm_dbg ("Reading %u new messages", ctx->indexes->len);
+    ctx->pending_reads = ctx->indexes->len;
+    for (i = 0; i < ctx->indexes->len; i++) {
+        CmtiReadContext *read_ctx;
+        gchar *command;
 
-    /* Retrieve the message */
-    command = g_strdup_printf ("+CMGR=%d", ctx->idx);
-    mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
-                              command,
-                              10,
-                              FALSE,
-                              (GAsyncReadyCallback)sms_part_ready,
-                              ctx);
-    g_free (command);
+        read_ctx = g_slice_new (CmtiReadContext);
+        read_ctx->batch = ctx;
+        read_ctx->idx = g_array_index (ctx->indexes, guint, i);
+
+        command = g_strdup_printf ("+CMGR=%d", read_ctx->idx);
+        mm_base_modem_at_command (MM_BASE_MODEM (self),
+                                  command,
+                                  10,
+                                  FALSE,
+                                  (GAsyncReadyCallback)sms_part_ready,
+                                  read_ctx);
+        g_free (command);
+    }
+}
+
+static gboolean
+cmti_batch_cb (MMBroadbandModem *self)
+{
+    CmtiBatchContext *ctx;
+    GArray *pending;
+    guint i;
+
+    self->priv->cmti_batch_id = 0;
+
+    if (self->priv->cmti_batch_running || !self->priv->cmti_pending->len)
+        return G_SOURCE_REMOVE;
+
+    ctx = g_slice_new0 (CmtiBatchContext);
+    ctx->self = g_object_ref (self);
+    ctx->indexes = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    /* Take all the indications of the storage of the first one; the others
+     * are left for the next batch */
+    pending = self->priv->cmti_pending;
+    ctx->storage = g_array_index (pending, CmtiIndication, 0).storage;
+    for (i = 0; i < pending->len; ) {
+        CmtiIndication *indication = &g_array_index (pending, CmtiIndication, i);
+
+        if (indication->storage == ctx->storage) {
+            g_array_append_val (ctx->indexes, indication->idx);
+            g_array_remove_index (pending, i);
+        } else
+            i++;
+    }
+
+    self->priv->cmti_batch_running = TRUE;
+    mm_broadband_modem_lock_sms_storages (self,
+                                          ctx->storage,
+                                          MM_SMS_STORAGE_UNKNOWN,
+                                          (GAsyncReadyCallback)indication_lock_storages_ready,
+                                          ctx);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+cmti_batch_schedule (MMBroadbandModem *self,
+                     guint timeout_ms)
+{
+    /* A running batch schedules the next one once done */
+    if (self->priv->cmti_batch_id || self->priv->cmti_batch_running)
+        return;
+
+    self->priv->cmti_batch_id = mm_clock_timeout_add (timeout_ms,
+                                                      (GSourceFunc)cmti_batch_cb,
+                                                      self);
+}
+
+static gboolean
+cmti_indication_pending (MMBroadbandModem *self,
+                         MMSmsStorage storage,
+                         guint idx)
+{
+    guint i;
+
+    for (i = 0; i < self->priv->cmti_pending->len; i++) {
+        CmtiIndication *indication = &g_array_index (self->priv->cmti_pending, CmtiIndication, i);
+
+        if (indication->storage == storage && indication->idx == idx)
+            return TRUE;
+    }
+    return FALSE;
 }
 
 static void
@@ -5857,7 +6284,7 @@ cmti_received (MMPortSerialAt *port,
                GMatchInfo *info,
                MMBroadbandModem *self)
 {
-    SmsPartContext *ctx;
+    CmtiIndication indication;
     guint idx = 0;
     MMSmsStorage storage;
     gchar *str;
@@ -5883,17 +6310,82 @@ cmti_received (MMPortSerialAt *port,
         return;
     }
 
-    ctx = g_new0 (SmsPartContext, 1);
-    ctx->self = g_object_ref (self);
-    ctx->result = g_simple_async_result_new (G_OBJECT (self), NULL, NULL, cmti_received);
-    ctx->idx = idx;
+    if (!self->priv->cmti_pending)
+        self->priv->cmti_pending = g_array_new (FALSE, FALSE, sizeof (CmtiIndication));
+    else if (cmti_indication_pending (self, storage, idx)) {
+        mm_dbg ("Skipping CMTI indication, part already going to be read");
+        return;
+    }
 
-    /* First, request to set the proper storage to read from */
-    mm_broadband_modem_lock_sms_storages (ctx->self,
-                                          storage,
-                                          MM_SMS_STORAGE_UNKNOWN,
-                                          (GAsyncReadyCallback)indication_lock_storages_ready,
-                                          ctx);
+    indication.storage = storage;
+    indication.idx = idx;
+    g_array_append_val (self->priv->cmti_pending, indication);
+    cmti_batch_schedule (self, CMTI_BATCH_WINDOW_MS);
+}
+
+static void
+cnma_ready (MMBaseModem *self,
+            GAsyncResult *res)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_at_command_full_finish (self, res, &error)) {
+        mm_dbg ("Couldn't acknowledge directly delivered message: %s", error->message);
+        g_error_free (error);
+    }
+}
+
+/* In direct delivery mode every +CMT and +CDS needs an acknowledgement, or the
+ * network retries the delivery and the modem may fall back to storing them */
+static void
+acknowledge_direct_delivery (MMBroadbandModem *self,
+                             MMPortSerialAt *port)
+{
+    if (!self->priv->sms_direct_delivery)
+        return;
+
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   port,
+                                   "+CNMA",
+                                   3,
+                                   FALSE,
+                                   FALSE,
+                                   NULL,
+                                   (GAsyncReadyCallback)cnma_ready,
+                                   NULL);
+}
+
+static void
+cmt_received (MMPortSerialAt *port,
+              GMatchInfo *info,
+              MMBroadbandModem *self)
+{
+    GError *error = NULL;
+    MMSmsPart *part;
+    gchar *pdu;
+
+    mm_dbg ("Got new directly delivered message");
+
+    pdu = g_match_info_fetch (info, 2);
+    if (!pdu)
+        return;
+
+    /* Acknowledged even if it can't be parsed, it would just come again */
+    acknowledge_direct_delivery (self, port);
+
+    part = mm_sms_part_3gpp_new_from_pdu (SMS_PART_INVALID_INDEX, pdu, &error);
+    if (part) {
+        mm_dbg ("Correctly parsed directly delivered PDU");
+        mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
+                                            part,
+                                            MM_SMS_STATE_RECEIVED,
+                                            MM_SMS_STORAGE_UNKNOWN);
+    } else {
+        /* Don't treat the error as critical */
+        mm_dbg ("Error parsing directly delivered PDU: %s", error->message);
+        g_error_free (error);
+    }
+    g_free (pdu);
 }
 
 static void
@@ -5915,6 +6407,8 @@ cds_received (MMPortSerialAt *port,
     if (!pdu)
         return;
 
+    acknowledge_direct_delivery (self, port);
+
     part = mm_sms_part_3gpp_new_from_pdu (SMS_PART_INVALID_INDEX, pdu, &error);
     if (part) {
         mm_dbg ("Correctly parsed non-stored PDU");
@@ -5938,6 +6432,7 @@ set_messaging_unsolicited_events_handlers (MMIfaceModemMessaging *self,
     GSimpleAsyncResult *result;
     MMPortSerialAt *ports[2];
     GRegex *cmti_regex;
+    GRegex *cmt_regex;
     GRegex *cds_regex;
     guint i;
 
@@ -5947,6 +6442,7 @@ set_messaging_unsolicited_events_handlers (MMIfaceModemMessaging *self,
                                         set_messaging_unsolicited_events_handlers);
 
     cmti_regex = mm_3gpp_cmti_regex_get ();
+    cmt_regex = mm_3gpp_cmt_regex_get ();
     cds_regex = mm_3gpp_cds_regex_get ();
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
@@ -5966,6 +6462,12 @@ set_messaging_unsolicited_events_handlers (MMIfaceModemMessaging *self,
             enable ? (MMPortSerialAtUnsolicitedMsgFn) cmti_received : NULL,
             enable ? self : NULL,
             NULL);
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            cmt_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn) cmt_received : NULL,
+            enable ? self : NULL,
+            NULL);
         mm_port_serial_at_add_unsolicited_msg_handler (
             ports[i],
             cds_regex,
@@ -5975,6 +6477,7 @@ set_messaging_unsolicited_events_handlers (MMIfaceModemMessaging *self,
     }
 
     g_regex_unref (cmti_regex);
+    g_regex_unref (cmt_regex);
     g_regex_unref (cds_regex);
     g_simple_async_result_set_op_res_gboolean (result, TRUE);
     g_simple_async_result_complete_in_idle (result);
@@ -6046,6 +6549,14 @@ static const MMBaseModemAtCommand cnmi_sequence[] = {
     { NULL }
 };
 
+/* Same as above, but with messages routed directly in +CMT */
+static const MMBaseModemAtCommand cnmi_direct_sequence[] = {
+    { "+CNMI=2,2,2,1,0", 3, FALSE, cnmi_response_processor },
+    { "+CNMI=2,2,2,2,0", 3, FALSE, cnmi_response_processor },
+    { "+CNMI=2,2,2,0,0", 3, FALSE, cnmi_response_processor },
+    { NULL }
+};
+
 static void
 modem_messaging_enable_unsolicited_events_secondary_ready (MMBaseModem *self,
                                                            GAsyncResult *res,
@@ -6115,6 +6626,51 @@ modem_messaging_enable_unsolicited_events_primary_ready (MMBaseModem *self,
     g_object_unref (final_result);
 }
 
+static void
+modem_messaging_enable_unsolicited_events_storage (MMBaseModem *self,
+                                                   MMPortSerialAt *primary,
+                                                   GSimpleAsyncResult *result)
+{
+    mm_base_modem_at_sequence_full (
+        self,
+        primary,
+        cnmi_sequence,
+        NULL, /* response_processor_context */
+        NULL, /* response_processor_context_free */
+        NULL,
+        (GAsyncReadyCallback)modem_messaging_enable_unsolicited_events_primary_ready,
+        result);
+}
+
+static void
+modem_messaging_enable_unsolicited_events_direct_ready (MMBaseModem *self,
+                                                        GAsyncResult *res,
+                                                        GSimpleAsyncResult *result)
+{
+    GError *inner_error = NULL;
+    MMPortSerialAt *primary;
+
+    primary = mm_base_modem_peek_port_primary (self);
+
+    mm_base_modem_at_sequence_full_finish (self, res, NULL, &inner_error);
+    if (inner_error) {
+        mm_dbg ("(%s) Direct message delivery not supported, storing messages instead: %s",
+                mm_port_get_device (MM_PORT (primary)),
+                inner_error->message);
+        g_error_free (inner_error);
+        modem_messaging_enable_unsolicited_events_storage (self, primary, result);
+        return;
+    }
+
+    /* Messages are only routed to the primary port, which is the one that
+     * acknowledges them; the secondary is left alone */
+    mm_dbg ("(%s) Messaging unsolicited events enabled on primary, with direct delivery",
+            mm_port_get_device (MM_PORT (primary)));
+    MM_BROADBAND_MODEM (self)->priv->sms_direct_delivery = TRUE;
+    g_simple_async_result_complete (result);
+    g_object_unref (result);
+}
+
 static void
 modem_messaging_enable_unsolicited_events (MMIfaceModemMessaging *self,
                                            GAsyncReadyCallback callback,
@@ -6129,6 +6685,25 @@ modem_messaging_enable_unsolicited_events (MMIfaceModemMessaging *self,
                                         modem_messaging_enable_unsolicited_events);
 
     primary = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    MM_BROADBAND_MODEM (self)->priv->sms_direct_delivery = FALSE;
+
+    /* Direct delivery, if requested in udev; it's only handled in PDU mode */
+    if (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode &&
+        mm_kernel_device_get_property_as_boolean (mm_port_peek_kernel_device (MM_PORT (primary)),
+                                                  "ID_MM_SMS_DIRECT_DELIVERY")) {
+        mm_dbg ("(%s) Enabling messaging unsolicited events on primary port, with direct delivery",
+                mm_port_get_device (MM_PORT (primary)));
+        mm_base_modem_at_sequence_full (
+            MM_BASE_MODEM (self),
+            primary,
+            cnmi_direct_sequence,
+            NULL, /* response_processor_context */
+            NULL, /* response_processor_context_free */
+            NULL,
+            (GAsyncReadyCallback)modem_messaging_enable_unsolicited_events_direct_ready,
+            result);
+        return;
+    }
 
     /* Enable unsolicited events for primary port */
     mm_dbg ("(%s) Enabling messaging unsolicited events on primary port",
@@ -6144,6 +6719,55 @@ modem_messaging_enable_unsolicited_events (MMIfaceModemMessaging *self,
         result);
 }
 
+/*****************************************************************************/
+/* SMS cache (Messaging interface implementation helper) */
+
+static MMSmsCache *
+peek_sms_cache (MMBroadbandModem *self)
+{
+    MMBaseSim *sim = NULL;
+    const gchar *equipment_id = NULL;
+    const gchar *iccid = NULL;
+
+    if (self->priv->sms_cache_loaded)
+        return self->priv->sms_cache;
+
+    if (!mm_context_get_sms_cache_dir ()) {
+        self->priv->sms_cache_loaded = TRUE;
+        return NULL;
+    }
+
+    /* Retried until both the device and the SIM are known */
+    if (self->priv->modem_dbus_skeleton)
+        equipment_id = mm_gdbus_modem_get_equipment_identifier (MM_GDBUS_MODEM (self->priv->modem_dbus_skeleton));
+    g_object_get (self,
+                  MM_IFACE_MODEM_SIM, &sim,
+                  NULL);
+    if (sim)
+        iccid = mm_gdbus_sim_get_sim_identifier (MM_GDBUS_SIM (sim));
+
+    if (equipment_id && iccid) {
+        self->priv->sms_cache = mm_sms_cache_open (equipment_id, iccid);
+        self->priv->sms_cache_loaded = TRUE;
+    }
+
+    if (sim)
+        g_object_unref (sim);
+    return self->priv->sms_cache;
+}
+
+void
+mm_broadband_modem_forget_sms_part (MMBroadbandModem *self,
+                                    MMSmsStorage storage,
+                                    guint index)
+{
+    MMSmsCache *cache;
+
+    cache = peek_sms_cache (self);
+    if (cache)
+        mm_sms_cache_remove (cache, storage, index);
+}
+
 /*****************************************************************************/
 /* Load initial list of SMS parts (Messaging interface) */
 
@@ -6151,11 +6775,25 @@ typedef struct {
     MMBroadbandModem *self;
     GSimpleAsyncResult *result;
     MMSmsStorage list_storage;
+    /* Port and handler used to process PDU mode listings while received */
+    MMPortSerialAt *port;
+    GRegex *cmgl_regex;
+    guint n_streamed;
+    /* MM3gppPduInfo of each record, to update the cache, in reverse order */
+    GList *listed;
 } ListPartsContext;
 
 static void
 list_parts_context_complete_and_free (ListPartsContext *ctx)
 {
+    if (ctx->port) {
+        /* Disabled, so that matching text is no longer consumed */
+        mm_port_serial_at_enable_unsolicited_msg_handler (ctx->port, ctx->cmgl_regex, FALSE);
+        g_object_unref (ctx->port);
+    }
+    if (ctx->cmgl_regex)
+        g_regex_unref (ctx->cmgl_regex);
+    mm_3gpp_pdu_info_list_free (ctx->listed);
     g_simple_async_result_complete (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
@@ -6218,8 +6856,8 @@ sms_text_part_list_ready (MMBroadbandModem *self,
     }
 
     /* +CMGL: <index>,<stat>,<oa/da>,[alpha],<scts><CR><LF><data><CR><LF> */
-    r = g_regex_new ("\\+CMGL:\\s*(\\d+)\\s*,\\s*([^,]*),\\s*([^,]*),\\s*([^,]*),\\s*([^\\r\\n]*)\\r\\n([^\\r\\n]*)",
-                     0, 0, NULL);
+    r = mm_regex_registry_get ("\\+CMGL:\\s*(\\d+)\\s*,\\s*([^,]*),\\s*([^,]*),\\s*([^,]*),\\s*([^\\r\\n]*)\\r\\n([^\\r\\n]*)",
+                               0);
     g_assert (r);
 
     if (!g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, NULL)) {
@@ -6328,6 +6966,51 @@ sms_state_from_index (guint index)
     }
 }
 
+static void
+sms_pdu_part_take (MMBroadbandModem *self,
+                   gint index,
+                   gint status,
+                   const gchar *pdu,
+                   MMSmsStorage storage)
+{
+    MMSmsPart *part;
+    GError *error = NULL;
+
+    part = mm_sms_part_3gpp_new_from_pdu (index, pdu, &error);
+    if (part) {
+        mm_dbg ("Correctly parsed PDU (%d)", index);
+        mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
+                                            part,
+                                            sms_state_from_index (status),
+                                            storage);
+    } else {
+        /* Don't treat the error as critical */
+        mm_dbg ("Error parsing PDU (%d): %s", index, error->message);
+        g_error_free (error);
+    }
+}
+
+static void
+cmgl_pdu_record_received (MMPortSerialAt *port,
+                          GMatchInfo *match_info,
+                          ListPartsContext *ctx)
+{
+    MM3gppPduInfo *info;
+
+    info = g_new0 (MM3gppPduInfo, 1);
+    if (!mm_get_int_from_match_info (match_info, 1, &info->index) ||
+        !mm_get_int_from_match_info (match_info, 2, &info->status) ||
+        !(info->pdu = mm_get_string_unquoted_from_match_info (match_info, 3))) {
+        mm_dbg ("Couldn't parse +CMGL record");
+        mm_3gpp_pdu_info_free (info);
+        return;
+    }
+
+    sms_pdu_part_take (ctx->self, info->index, info->status, info->pdu, ctx->list_storage);
+    ctx->n_streamed++;
+    ctx->listed = g_list_prepend (ctx->listed, info);
+}
+
 static void
 sms_pdu_part_list_ready (MMBroadbandModem *self,
                          GAsyncResult *res,
@@ -6341,13 +7024,15 @@ sms_pdu_part_list_ready (MMBroadbandModem *self,
     /* Always always always unlock mem1 storage. Warned you've been. */
     mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
 
-    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &error);
+    response = mm_base_modem_at_command_full_finish (MM_BASE_MODEM (self), res, &error);
     if (error) {
         g_simple_async_result_take_error (ctx->result, error);
         list_parts_context_complete_and_free (ctx);
         return;
     }
 
+    /* Most records were already processed while the listing was received;
+     * parse whatever the handler didn't match */
     info_list = mm_3gpp_parse_pdu_cmgl_response (response, &error);
     if (error) {
         g_simple_async_result_take_error (ctx->result, error);
@@ -6355,25 +7040,22 @@ sms_pdu_part_list_ready (MMBroadbandModem *self,
         return;
     }
 
+    mm_dbg ("Listed %u SMS parts (%u while receiving)",
+            ctx->n_streamed + g_list_length (info_list),
+            ctx->n_streamed);
+
     for (l = info_list; l; l = g_list_next (l)) {
         MM3gppPduInfo *info = l->data;
-        MMSmsPart *part;
 
-        part = mm_sms_part_3gpp_new_from_pdu (info->index, info->pdu, &error);
-        if (part) {
-            mm_dbg ("Correctly parsed PDU (%d)", info->index);
-            mm_iface_modem_messaging_take_part (MM_IFACE_MODEM_MESSAGING (self),
-                                                part,
-                                                sms_state_from_index (info->status),
-                                                ctx->list_storage);
-        } else {
-            /* Don't treat the error as critical */
-            mm_dbg ("Error parsing PDU (%d): %s", info->index, error->message);
-            g_clear_error (&error);
-        }
+        sms_pdu_part_take (self, info->index, info->status, info->pdu, ctx->list_storage);
     }
 
-    mm_3gpp_pdu_info_list_free (info_list);
+    /* Keep a copy of the whole listing for the next time */
+    ctx->listed = g_list_concat (g_list_reverse (info_list), ctx->listed);
+    if (peek_sms_cache (self)) {
+        ctx->listed = g_list_reverse (ctx->listed);
+        mm_sms_cache_store (peek_sms_cache (self), ctx->list_storage, ctx->listed);
+    }
 
     /* We consider all done */
     g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
@@ -6399,16 +7081,64 @@ list_parts_lock_storages_ready (MMBroadbandModem *self,
 
     /* Get SMS parts from ALL types.
      * Different command to be used if we are on Text or PDU mode */
-    mm_base_modem_at_command (MM_BASE_MODEM (self),
-                              (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                               "+CMGL=4" :
-                               "+CMGL=\"ALL\""),
-                              20,
-                              FALSE,
-                              (GAsyncReadyCallback) (MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode ?
-                                                     sms_pdu_part_list_ready :
-                                                     sms_text_part_list_ready),
-                              ctx);
+    if (!MM_BROADBAND_MODEM (self)->priv->modem_messaging_sms_pdu_mode) {
+        mm_base_modem_at_command (MM_BASE_MODEM (self),
+                                  "+CMGL=\"ALL\"",
+                                  20,
+                                  FALSE,
+                                  (GAsyncReadyCallback)sms_text_part_list_ready,
+                                  ctx);
+        return;
+    }
+
+    /* If the storage didn't change since it was last listed, take the parts
+     * from the cache instead */
+    if (self->priv->mem1_storage_used >= 0 &&
+        peek_sms_cache (self) &&
+        mm_sms_cache_lookup (peek_sms_cache (self),
+                             ctx->list_storage,
+                             (guint) self->priv->mem1_storage_used,
+                             &ctx->listed)) {
+        GList *l;
+
+        mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+        mm_dbg ("Taking %u SMS parts from the cache", g_list_length (ctx->listed));
+        for (l = ctx->listed; l; l = g_list_next (l)) {
+            MM3gppPduInfo *info = l->data;
+
+            sms_pdu_part_take (self, info->index, info->status, info->pdu, ctx->list_storage);
+        }
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        list_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    ctx->port = mm_base_modem_get_best_at_port (MM_BASE_MODEM (self), &error);
+    if (!ctx->port) {
+        mm_broadband_modem_unlock_sms_storages (self, TRUE, FALSE);
+        g_simple_async_result_take_error (ctx->result, error);
+        list_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Listings may be tens of KB long; take each part as soon as its record
+     * is received, instead of buffering the whole reply */
+    ctx->cmgl_regex = mm_3gpp_cmgl_pdu_regex_get ();
+    mm_port_serial_at_add_unsolicited_msg_handler (ctx->port,
+                                                   ctx->cmgl_regex,
+                                                   (MMPortSerialAtUnsolicitedMsgFn)cmgl_pdu_record_received,
+                                                   ctx,
+                                                   NULL);
+
+    mm_base_modem_at_command_full (MM_BASE_MODEM (self),
+                                   ctx->port,
+                                   "+CMGL=4",
+                                   20,
+                                   FALSE,
+                                   FALSE,
+                                   NULL,
+                                   (GAsyncReadyCallback)sms_pdu_part_list_ready,
+                                   ctx);
 }
 
 static void
@@ -6439,16 +7169,183 @@ modem_messaging_load_initial_sms_parts (MMIfaceModemMessaging *self,
 }
 
 /*****************************************************************************/
-/* Create SMS (Messaging interface) */
+/* Delete all SMS parts in a storage (Messaging interface) */
 
-static MMBaseSms *
-modem_messaging_create_sms (MMIfaceModemMessaging *self)
+typedef struct {
+    MMBroadbandModem *self;
+    GSimpleAsyncResult *result;
+    MMSmsStorage storage;
+    GArray *indices;
+    gboolean need_unlock;
+    guint n_pending;
+    guint n_failed;
+} DeleteAllSmsPartsContext;
+
+static void
+delete_all_sms_parts_context_complete_and_free (DeleteAllSmsPartsContext *ctx)
 {
-    return mm_base_sms_new (MM_BASE_MODEM (self));
-}
+    MMSmsCache *cache;
 
-/*****************************************************************************/
-/* Check if Voice supported (Voice interface) */
+    /* Either the storage is now known to be empty, or the parts which are
+     * still there aren't known */
+    cache = peek_sms_cache (ctx->self);
+    if (cache && ctx->need_unlock) {
+        if (g_simple_async_result_get_op_res_gboolean (ctx->result))
+            mm_sms_cache_store (cache, ctx->storage, NULL);
+        else
+            mm_sms_cache_invalidate (cache, ctx->storage);
+    }
+
+    /* Unlock mem1 storage if we had the lock */
+    if (ctx->need_unlock)
+        mm_broadband_modem_unlock_sms_storages (ctx->self, TRUE, FALSE);
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_array_unref (ctx->indices);
+    g_object_unref (ctx->self);
+    g_slice_free (DeleteAllSmsPartsContext, ctx);
+}
+
+static gboolean
+modem_messaging_delete_all_sms_parts_finish (MMIfaceModemMessaging *self,
+                                             GAsyncResult *res,
+                                             GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+cmgd_index_ready (MMBaseModem *self,
+                  GAsyncResult *res,
+                  DeleteAllSmsPartsContext *ctx)
+{
+    GError *error = NULL;
+
+    mm_base_modem_at_command_finish (self, res, &error);
+    if (error) {
+        mm_dbg ("Couldn't delete SMS part: '%s'", error->message);
+        g_error_free (error);
+        ctx->n_failed++;
+    }
+
+    if (--ctx->n_pending > 0)
+        return;
+
+    if (ctx->n_failed > 0)
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Couldn't delete %u SMS parts",
+                                         ctx->n_failed);
+    else
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    delete_all_sms_parts_context_complete_and_free (ctx);
+}
+
+static void
+cmgd_all_ready (MMBaseModem *self,
+                GAsyncResult *res,
+                DeleteAllSmsPartsContext *ctx)
+{
+    GError *error = NULL;
+    guint i;
+
+    mm_base_modem_at_command_finish (self, res, &error);
+    if (!error) {
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    mm_dbg ("Couldn't delete all SMS parts at once: '%s'", error->message);
+    g_error_free (error);
+
+    if (!ctx->indices->len) {
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* Fall back to deleting the parts one by one. All the commands are queued
+     * right away, so that each one is sent as soon as the previous reply is
+     * received. */
+    ctx->n_pending = ctx->indices->len;
+    for (i = 0; i < ctx->indices->len; i++) {
+        gchar *cmd;
+
+        cmd = g_strdup_printf ("+CMGD=%u", g_array_index (ctx->indices, guint, i));
+        mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
+                                  cmd,
+                                  10,
+                                  FALSE,
+                                  (GAsyncReadyCallback)cmgd_index_ready,
+                                  ctx);
+        g_free (cmd);
+    }
+}
+
+static void
+delete_all_sms_parts_lock_storages_ready (MMBroadbandModem *self,
+                                          GAsyncResult *res,
+                                          DeleteAllSmsPartsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_broadband_modem_lock_sms_storages_finish (self, res, &error)) {
+        g_simple_async_result_take_error (ctx->result, error);
+        delete_all_sms_parts_context_complete_and_free (ctx);
+        return;
+    }
+
+    /* We are now locked. Whatever result we have here, we need to make sure
+     * we unlock the storages before finishing. */
+    ctx->need_unlock = TRUE;
+
+    /* Delete flag 4: all messages in mem1, whatever their status */
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              "+CMGD=1,4",
+                              60,
+                              FALSE,
+                              (GAsyncReadyCallback)cmgd_all_ready,
+                              ctx);
+}
+
+static void
+modem_messaging_delete_all_sms_parts (MMIfaceModemMessaging *self,
+                                      MMSmsStorage storage,
+                                      GArray *indices,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data)
+{
+    DeleteAllSmsPartsContext *ctx;
+
+    ctx = g_slice_new0 (DeleteAllSmsPartsContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             modem_messaging_delete_all_sms_parts);
+    ctx->storage = storage;
+    ctx->indices = g_array_ref (indices);
+
+    mm_broadband_modem_lock_sms_storages (ctx->self,
+                                          storage,
+                                          MM_SMS_STORAGE_UNKNOWN,
+                                          (GAsyncReadyCallback)delete_all_sms_parts_lock_storages_ready,
+                                          ctx);
+}
+
+/*****************************************************************************/
+/* Create SMS (Messaging interface) */
+
+static MMBaseSms *
+modem_messaging_create_sms (MMIfaceModemMessaging *self)
+{
+    return mm_base_sms_new (MM_BASE_MODEM (self));
+}
+
+/*****************************************************************************/
+/* Check if Voice supported (Voice interface) */
 
 static gboolean
 modem_voice_check_support_finish (MMIfaceModemVoice *self,
@@ -6520,6 +7417,7 @@ ring_received (MMPortSerialAt *port,
 {
     mm_dbg ("Ringing");
     mm_iface_modem_voice_create_incoming_call (MM_IFACE_MODEM_VOICE (self));
+    mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -6537,6 +7435,7 @@ cring_received (MMPortSerialAt *port,
     g_free (str);
 
     mm_iface_modem_voice_create_incoming_call (MM_IFACE_MODEM_VOICE (self));
+    mm_iface_modem_voice_refresh_call_list (MM_IFACE_MODEM_VOICE (self));
 }
 
 static void
@@ -6706,6 +7605,38 @@ modem_voice_enable_unsolicited_events (MMIfaceModemVoice *self,
         user_data);
 }
 
+/*****************************************************************************/
+/* Load call list (Voice interface) */
+
+static GList *
+modem_voice_load_call_list_finish (MMIfaceModemVoice *self,
+                                   GAsyncResult *res,
+                                   GError **error)
+{
+    const gchar *response;
+    GList *call_info_list = NULL;
+
+    response = mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, error);
+    if (!response || !mm_3gpp_parse_clcc_response (response, &call_info_list, error))
+        return NULL;
+
+    return call_info_list;
+}
+
+static void
+modem_voice_load_call_list (MMIfaceModemVoice *self,
+                            GAsyncReadyCallback callback,
+                            gpointer user_data)
+{
+    /* Only reads state, so any port will do */
+    mm_base_modem_at_command_any_port (MM_BASE_MODEM (self),
+                                       "+CLCC",
+                                       5,
+                                       FALSE,
+                                       callback,
+                                       user_data);
+}
+
 /*****************************************************************************/
 /* Create CALL (Voice interface) */
 
@@ -6818,31 +7749,13 @@ cdma_unsolicited_events_context_complete_and_free (CdmaUnsolicitedEventsContext
 }
 
 static void
-logcmd_qcdm_ready (MMPortSerialQcdm *port,
-                   GAsyncResult *res,
-                   CdmaUnsolicitedEventsContext *ctx)
+log_mask_qcdm_ready (MMPortSerialQcdm *port,
+                     GAsyncResult *res,
+                     CdmaUnsolicitedEventsContext *ctx)
 {
-    QcdmResult *result;
-    gint err = QCDM_SUCCESS;
-    GByteArray *response;
     GError *error = NULL;
 
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
-        cdma_unsolicited_events_context_complete_and_free (ctx, TRUE, error);
-        return;
-    }
-
-    /* Parse the response */
-    result = qcdm_cmd_log_config_set_mask_result ((const gchar *) response->data,
-                                                  response->len,
-                                                  &err);
-    g_byte_array_unref (response);
-    if (!result) {
-        error = g_error_new (MM_CORE_ERROR,
-                             MM_CORE_ERROR_FAILED,
-                             "Failed to parse Log Config Set Mask command result: %d",
-                             err);
+    if (!mm_port_serial_qcdm_set_log_mask_finish (port, res, &error)) {
         cdma_unsolicited_events_context_complete_and_free (ctx, TRUE, error);
         return;
     }
@@ -6853,8 +7766,6 @@ logcmd_qcdm_ready (MMPortSerialQcdm *port,
                                                      ctx->self,
                                                      NULL);
 
-    qcdm_result_unref (result);
-
     /* Balance the mm_port_seral_open() from modem_cdma_setup_cleanup_unsolicited_events().
      * We want to close it in either case:
      *  (a) we're cleaning up and setup opened the port
@@ -6873,8 +7784,7 @@ modem_cdma_setup_cleanup_unsolicited_events (MMBroadbandModem *self,
                                              gpointer user_data)
 {
     CdmaUnsolicitedEventsContext *ctx;
-    GByteArray *logcmd;
-    u_int16_t log_items[] = { DM_LOG_ITEM_EVDO_PILOT_SETS_V2, 0 };
+    static const guint16 log_items[] = { DM_LOG_ITEM_EVDO_PILOT_SETS_V2 };
     GError *error = NULL;
 
     ctx = g_new0 (CdmaUnsolicitedEventsContext, 1);
@@ -6901,20 +7811,12 @@ modem_cdma_setup_cleanup_unsolicited_events (MMBroadbandModem *self,
         }
     }
 
-    logcmd = g_byte_array_sized_new (512);
-    logcmd->len = qcdm_cmd_log_config_set_mask_new ((char *) logcmd->data,
-                                                    512,
-                                                    0x01,  /* Equipment ID */
-                                                    setup ? log_items : NULL);
-    assert (logcmd->len);
-
-    mm_port_serial_qcdm_command (ctx->qcdm,
-                                 logcmd,
-                                 5,
-                                 NULL,
-                                 (GAsyncReadyCallback)logcmd_qcdm_ready,
-                                 ctx);
-    g_byte_array_unref (logcmd);
+    /* Log codes being streamed into files are kept enabled by the port */
+    mm_port_serial_qcdm_set_log_mask (ctx->qcdm,
+                                      log_items,
+                                      setup ? G_N_ELEMENTS (log_items) : 0,
+                                      (GAsyncReadyCallback)log_mask_qcdm_ready,
+                                      ctx);
 }
 
 static gboolean
@@ -6993,28 +7895,38 @@ modem_cdma_get_hdr_state_finish (MMIfaceModemCdma *self,
 }
 
 static void
-hdr_subsys_state_info_ready (MMPortSerialQcdm *port,
+hdr_subsys_state_info_ready (MMBroadbandModem *self,
                              GAsyncResult *res,
                              HdrStateContext *ctx)
 {
     QcdmResult *result;
+    QcdmSnapshot *snapshot;
     HdrStateResults *results;
     gint err = QCDM_SUCCESS;
     GError *error = NULL;
-    GByteArray *response;
 
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error) {
-        g_simple_async_result_set_from_error (ctx->result, error);
+    snapshot = qcdm_snapshot_load_finish (self, res, &error);
+    if (!snapshot) {
+        g_simple_async_result_take_error (ctx->result, error);
+        hdr_state_context_complete_and_free (ctx);
+        return;
+    }
+
+    if (!snapshot->hdr_state) {
+        qcdm_snapshot_unref (snapshot);
+        g_simple_async_result_set_error (ctx->result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Failed to load HDR subsys state info");
         hdr_state_context_complete_and_free (ctx);
         return;
     }
 
     /* Parse the response */
-    result = qcdm_cmd_hdr_subsys_state_info_result ((const gchar *) response->data,
-                                                    response->len,
+    result = qcdm_cmd_hdr_subsys_state_info_result ((const gchar *) snapshot->hdr_state->data,
+                                                    snapshot->hdr_state->len,
                                                     &err);
-    g_byte_array_unref (response);
+    qcdm_snapshot_unref (snapshot);
     if (!result) {
         g_simple_async_result_set_error (ctx->result,
                                          MM_CORE_ERROR,
@@ -7045,7 +7957,6 @@ modem_cdma_get_hdr_state (MMIfaceModemCdma *self,
 {
     MMPortSerialQcdm *qcdm;
     HdrStateContext *ctx;
-    GByteArray *hdrstate;
 
     qcdm = mm_base_modem_peek_port_qcdm (MM_BASE_MODEM (self));
     if (!qcdm) {
@@ -7067,18 +7978,10 @@ modem_cdma_get_hdr_state (MMIfaceModemCdma *self,
                                              modem_cdma_get_hdr_state);
     ctx->qcdm = g_object_ref (qcdm);
 
-    /* Setup command */
-    hdrstate = g_byte_array_sized_new (25);
-    hdrstate->len = qcdm_cmd_hdr_subsys_state_info_new ((gchar *) hdrstate->data, 25);
-    g_assert (hdrstate->len);
-
-    mm_port_serial_qcdm_command (ctx->qcdm,
-                                 hdrstate,
-                                 3,
-                                 NULL,
-                                 (GAsyncReadyCallback)hdr_subsys_state_info_ready,
-                                 ctx);
-    g_byte_array_unref (hdrstate);
+    qcdm_snapshot_load (ctx->self,
+                        ctx->qcdm,
+                        (GAsyncReadyCallback)hdr_subsys_state_info_ready,
+                        ctx);
 }
 
 /*****************************************************************************/
@@ -7307,7 +8210,7 @@ css_query_ready (MMIfaceModemCdma *self,
         GMatchInfo *match_info;
 
         /* Format is "<band_class>,<band>,<sid>" */
-        r = g_regex_new ("\\s*([^,]*?)\\s*,\\s*([^,]*?)\\s*,\\s*(\\d+)", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        r = mm_regex_registry_get ("\\s*([^,]*?)\\s*,\\s*([^,]*?)\\s*,\\s*(\\d+)", G_REGEX_RAW);
         if (!r) {
             g_simple_async_result_set_error (
                 ctx->result,
@@ -7396,24 +8299,27 @@ css_query_ready (MMIfaceModemCdma *self,
 }
 
 static void
-qcdm_cdma_status_ready (MMPortSerialQcdm *port,
+qcdm_cdma_status_ready (MMBroadbandModem *self,
                         GAsyncResult *res,
                         Cdma1xServingSystemContext *ctx)
 {
     Cdma1xServingSystemResults *results;
     QcdmResult *result = NULL;
+    QcdmSnapshot *snapshot;
     guint32 sid = MM_MODEM_CDMA_SID_UNKNOWN;
     guint32 nid = MM_MODEM_CDMA_NID_UNKNOWN;
     guint32 rxstate = 0;
     gint err = QCDM_SUCCESS;
     GError *error = NULL;
-    GByteArray *response;
 
-    response = mm_port_serial_qcdm_command_finish (port, res, &error);
-    if (error ||
-        (result = qcdm_cmd_cdma_status_result ((const gchar *) response->data,
-                                               response->len,
-                                               &err)) == NULL) {
+    snapshot = qcdm_snapshot_load_finish (self, res, &error);
+    if (snapshot && snapshot->cdma_status)
+        result = qcdm_cmd_cdma_status_result ((const gchar *) snapshot->cdma_status->data,
+                                              snapshot->cdma_status->len,
+                                              &err);
+    if (snapshot)
+        qcdm_snapshot_unref (snapshot);
+    if (!result) {
         if (err != QCDM_SUCCESS)
             mm_dbg ("Failed to parse cdma status command result: %d", err);
         /* If there was some error, fall back to use +CSS like we did before QCDM */
@@ -7425,13 +8331,9 @@ qcdm_cdma_status_ready (MMPortSerialQcdm *port,
                                   ctx);
         if (error)
             g_error_free (error);
-        if (response)
-            g_byte_array_unref (response);
         return;
     }
 
-    g_byte_array_unref (response);
-
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_RX_STATE, &rxstate);
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_SID, &sid);
     qcdm_result_get_u32 (result, QCDM_CMD_CDMA_STATUS_ITEM_NID, &nid);
@@ -7476,19 +8378,10 @@ modem_cdma_get_cdma1x_serving_system (MMIfaceModemCdma *self,
     ctx->qcdm = mm_base_modem_get_port_qcdm (MM_BASE_MODEM (self));
 
     if (ctx->qcdm) {
-        GByteArray *cdma_status;
-
-        /* Setup command */
-        cdma_status = g_byte_array_sized_new (25);
-        cdma_status->len = qcdm_cmd_cdma_status_new ((char *) cdma_status->data, 25);
-        g_assert (cdma_status->len);
-        mm_port_serial_qcdm_command (ctx->qcdm,
-                                     cdma_status,
-                                     3,
-                                     NULL,
-                                     (GAsyncReadyCallback)qcdm_cdma_status_ready,
-                                     ctx);
-        g_byte_array_unref (cdma_status);
+        qcdm_snapshot_load (ctx->self,
+                            ctx->qcdm,
+                            (GAsyncReadyCallback)qcdm_cdma_status_ready,
+                            ctx);
         return;
     }
 
@@ -7529,11 +8422,15 @@ cad_query_ready (MMIfaceModemCdma *self,
     if (error)
         g_simple_async_result_take_error (simple, error);
     else {
+        static const MMAtResponseShape shape = {
+            "+CAD:", FALSE, 1,
+            { MM_AT_FIELD_UINT }
+        };
+        MMAtResponseFields fields;
         guint cad;
 
-        /* Strip any leading command tag and spaces */
-        result = mm_strip_tag (result, "+CAD:");
-        if (!mm_get_uint_from_str (result, &cad))
+        if (!mm_at_response_shape_parse (&shape, result, &fields, NULL) ||
+            !mm_at_response_fields_get_uint (&fields, 0, &cad))
             g_simple_async_result_set_error (simple,
                                              MM_CORE_ERROR,
                                              MM_CORE_ERROR_FAILED,
@@ -8058,9 +8955,9 @@ run_cdma_registration_checks_ready (MMBroadbandModem *self,
 
     /* Check again in a few seconds. */
     mm_dbg ("Modem not yet registered in a CDMA network... will recheck soon");
-    g_timeout_add_seconds (3,
-                           (GSourceFunc)run_cdma_registration_checks_again,
-                           ctx);
+    mm_clock_timeout_add_seconds (3,
+                                  (GSourceFunc)run_cdma_registration_checks_again,
+                                  ctx);
 }
 
 static void
@@ -8252,104 +9149,262 @@ modem_time_load_network_timezone (MMIfaceModemTime *self,
 }
 
 /*****************************************************************************/
-/* Check support (Time interface) */
-
-static const MMBaseModemAtCommand time_check_sequence[] = {
-    { "+CTZU=1",  3, TRUE, mm_base_modem_response_processor_no_result_continue },
-    { "+CCLK?",   3, TRUE, mm_base_modem_response_processor_string },
-    { NULL }
-};
-
-static gboolean
-modem_time_check_support_finish (MMIfaceModemTime *self,
-                                 GAsyncResult *res,
-                                 GError **error)
-{
-    return !!mm_base_modem_at_sequence_finish (MM_BASE_MODEM (self), res, NULL, error);
-}
+/* Setup/Cleanup unsolicited events (Time interface) */
 
 static void
-modem_time_check_support (MMIfaceModemTime *self,
-                          GAsyncReadyCallback callback,
-                          gpointer user_data)
+ctz_received (MMPortSerialAt *port,
+              GMatchInfo *match_info,
+              MMBroadbandModem *self)
 {
-    mm_base_modem_at_sequence (MM_BASE_MODEM (self),
-                               time_check_sequence,
-                               NULL, /* response_processor_context */
-                               NULL, /* response_processor_context_free */
-                               callback,
-                               user_data);
-}
-
-/*****************************************************************************/
+    MMNetworkTimezone *tz;
 
-static const gchar *primary_init_sequence[] = {
-    /* Ensure echo is off */
-    "E0",
-    /* Get word responses */
-    "V1",
-    /* Extended numeric codes */
-    "+CMEE=1",
-    /* Report all call status */
-    "X4",
-    /* Assert DCD when carrier detected */
-    "&C1",
-    NULL
-};
+    tz = mm_3gpp_parse_ctz_match (match_info);
+    if (!tz) {
+        mm_dbg ("Couldn't parse timezone report");
+        return;
+    }
 
-static const gchar *secondary_init_sequence[] = {
-    /* Ensure echo is off */
-    "E0",
-    NULL
-};
+    mm_iface_modem_time_update_network_timezone (MM_IFACE_MODEM_TIME (self), tz);
+    g_object_unref (tz);
+}
 
 static void
-setup_ports (MMBroadbandModem *self)
+set_time_unsolicited_events_handlers (MMBroadbandModem *self,
+                                      gboolean enable)
 {
     MMPortSerialAt *ports[2];
-    GRegex *regex;
-    GPtrArray *array;
-    gint i, j;
+    GRegex *ctz_regex;
+    guint i;
 
+    ctz_regex = mm_3gpp_ctz_regex_get ();
     ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
     ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
 
-    if (ports[0])
-        g_object_set (ports[0],
-                      MM_PORT_SERIAL_AT_INIT_SEQUENCE, primary_init_sequence,
-                      NULL);
-
-    if (ports[1])
-        g_object_set (ports[1],
-                      MM_PORT_SERIAL_AT_INIT_SEQUENCE, secondary_init_sequence,
-                      NULL);
-
-    /* Cleanup all unsolicited message handlers in all AT ports */
-
-    /* Set up CREG unsolicited message handlers, with NULL callbacks */
-    array = mm_3gpp_creg_regex_get (FALSE);
     for (i = 0; i < 2; i++) {
         if (!ports[i])
             continue;
 
-        for (j = 0; j < array->len; j++) {
-            mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
-                                                           (GRegex *)g_ptr_array_index (array, j),
-                                                           NULL,
-                                                           NULL,
-                                                           NULL);
-        }
+        mm_dbg ("(%s) %s time unsolicited events handlers",
+                mm_port_get_device (MM_PORT (ports[i])),
+                enable ? "Setting" : "Removing");
+        mm_port_serial_at_add_unsolicited_msg_handler (
+            ports[i],
+            ctz_regex,
+            enable ? (MMPortSerialAtUnsolicitedMsgFn) ctz_received : NULL,
+            enable ? self : NULL,
+            NULL);
     }
-    mm_3gpp_creg_regex_destroy (array);
 
-    /* Set up CIEV unsolicited message handler, with NULL callback */
-    regex = mm_3gpp_ciev_regex_get ();
-    for (i = 0; i < 2; i++) {
-        if (!ports[i])
-            continue;
+    g_regex_unref (ctz_regex);
+}
 
-        mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
-                                                       regex,
+static gboolean
+modem_time_setup_cleanup_unsolicited_events_finish (MMIfaceModemTime *self,
+                                                    GAsyncResult *res,
+                                                    GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+modem_time_setup_cleanup_unsolicited_events (MMIfaceModemTime *self,
+                                             gboolean enable,
+                                             GAsyncReadyCallback callback,
+                                             gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        modem_time_setup_cleanup_unsolicited_events);
+
+    set_time_unsolicited_events_handlers (MM_BROADBAND_MODEM (self), enable);
+
+    g_simple_async_result_set_op_res_gboolean (result, TRUE);
+    g_simple_async_result_complete_in_idle (result);
+    g_object_unref (result);
+}
+
+static void
+modem_time_setup_unsolicited_events (MMIfaceModemTime *self,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+    modem_time_setup_cleanup_unsolicited_events (self, TRUE, callback, user_data);
+}
+
+static void
+modem_time_cleanup_unsolicited_events (MMIfaceModemTime *self,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    modem_time_setup_cleanup_unsolicited_events (self, FALSE, callback, user_data);
+}
+
+/*****************************************************************************/
+/* Enable/Disable unsolicited events (Time interface) */
+
+static const MMBaseModemAtCommand time_enable_unsolicited_events_sequence[] = {
+    /* Prefer the extended reports, which include the DST adjustment */
+    { "+CTZR=2", 3, FALSE, mm_base_modem_response_processor_continue_on_error },
+    { "+CTZR=1", 3, FALSE, mm_base_modem_response_processor_continue_on_error },
+    { NULL }
+};
+
+static gboolean
+modem_time_enable_unsolicited_events_finish (MMIfaceModemTime *self,
+                                             GAsyncResult *res,
+                                             GError **error)
+{
+    GError *inner_error = NULL;
+
+    mm_base_modem_at_sequence_finish (MM_BASE_MODEM (self), res, NULL, &inner_error);
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+modem_time_enable_unsolicited_events (MMIfaceModemTime *self,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data)
+{
+    /* Timezone reports are optional, modems without them are polled */
+    mm_base_modem_at_sequence (MM_BASE_MODEM (self),
+                               time_enable_unsolicited_events_sequence,
+                               NULL, /* response_processor_context */
+                               NULL, /* response_processor_context_free */
+                               callback,
+                               user_data);
+}
+
+static gboolean
+modem_time_disable_unsolicited_events_finish (MMIfaceModemTime *self,
+                                              GAsyncResult *res,
+                                              GError **error)
+{
+    GError *inner_error = NULL;
+
+    /* Modems without timezone reports don't need them disabled */
+    if (!mm_base_modem_at_command_finish (MM_BASE_MODEM (self), res, &inner_error)) {
+        mm_dbg ("Couldn't disable timezone reports: '%s'", inner_error->message);
+        g_error_free (inner_error);
+    }
+    return TRUE;
+}
+
+static void
+modem_time_disable_unsolicited_events (MMIfaceModemTime *self,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    mm_base_modem_at_command (MM_BASE_MODEM (self),
+                              "+CTZR=0",
+                              3,
+                              FALSE,
+                              callback,
+                              user_data);
+}
+
+/*****************************************************************************/
+/* Check support (Time interface) */
+
+static const MMBaseModemAtCommand time_check_sequence[] = {
+    { "+CTZU=1",  3, TRUE, mm_base_modem_response_processor_no_result_continue },
+    { "+CCLK?",   3, TRUE, mm_base_modem_response_processor_string },
+    { NULL }
+};
+
+static gboolean
+modem_time_check_support_finish (MMIfaceModemTime *self,
+                                 GAsyncResult *res,
+                                 GError **error)
+{
+    return !!mm_base_modem_at_sequence_finish (MM_BASE_MODEM (self), res, NULL, error);
+}
+
+static void
+modem_time_check_support (MMIfaceModemTime *self,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data)
+{
+    mm_base_modem_at_sequence (MM_BASE_MODEM (self),
+                               time_check_sequence,
+                               NULL, /* response_processor_context */
+                               NULL, /* response_processor_context_free */
+                               callback,
+                               user_data);
+}
+
+/*****************************************************************************/
+
+static const gchar *primary_init_sequence[] = {
+    /* Ensure echo is off */
+    "E0",
+    /* Get word responses */
+    "V1",
+    /* Extended numeric codes */
+    "+CMEE=1",
+    /* Report all call status */
+    "X4",
+    /* Assert DCD when carrier detected */
+    "&C1",
+    NULL
+};
+
+static const gchar *secondary_init_sequence[] = {
+    /* Ensure echo is off */
+    "E0",
+    NULL
+};
+
+static void
+setup_ports (MMBroadbandModem *self)
+{
+    MMPortSerialAt *ports[2];
+    GRegex *regex;
+    gint i;
+
+    ports[0] = mm_base_modem_peek_port_primary (MM_BASE_MODEM (self));
+    ports[1] = mm_base_modem_peek_port_secondary (MM_BASE_MODEM (self));
+
+    if (ports[0])
+        g_object_set (ports[0],
+                      MM_PORT_SERIAL_AT_INIT_SEQUENCE, primary_init_sequence,
+                      NULL);
+
+    if (ports[1])
+        g_object_set (ports[1],
+                      MM_PORT_SERIAL_AT_INIT_SEQUENCE, secondary_init_sequence,
+                      NULL);
+
+    /* Cleanup all unsolicited message handlers in all AT ports */
+
+    /* Set up CREG unsolicited message handlers, with NULL callbacks */
+    regex = mm_3gpp_creg_regex_get ();
+    for (i = 0; i < 2; i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
+                                                       regex,
+                                                       NULL,
+                                                       NULL,
+                                                       NULL);
+    }
+    g_regex_unref (regex);
+
+    /* Set up CIEV unsolicited message handler, with NULL callback */
+    regex = mm_3gpp_ciev_regex_get ();
+    for (i = 0; i < 2; i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
+                                                       regex,
                                                        NULL,
                                                        NULL,
                                                        NULL);
@@ -8370,6 +9425,20 @@ setup_ports (MMBroadbandModem *self)
     }
     g_regex_unref (regex);
 
+    /* Set up CMT unsolicited message handler, with NULL callback */
+    regex = mm_3gpp_cmt_regex_get ();
+    for (i = 0; i < 2; i++) {
+        if (!ports[i])
+            continue;
+
+        mm_port_serial_at_add_unsolicited_msg_handler (MM_PORT_SERIAL_AT (ports[i]),
+                                                       regex,
+                                                       NULL,
+                                                       NULL,
+                                                       NULL);
+    }
+    g_regex_unref (regex);
+
     /* Set up CUSD unsolicited message handler, with NULL callback */
     regex = mm_3gpp_cusd_regex_get ();
     for (i = 0; i < 2; i++) {
@@ -8660,7 +9729,7 @@ enabling_modem_init_ready (MMBroadbandModem *self,
 
     /* After the modem init sequence, give a 500ms period for the modem to settle */
     mm_dbg ("Giving some time to settle the modem...");
-    g_timeout_add (500, (GSourceFunc)enabling_after_modem_init_timeout, ctx);
+    mm_clock_timeout_add (500, (GSourceFunc)enabling_after_modem_init_timeout, ctx);
 }
 
 static void
@@ -8744,6 +9813,7 @@ open_ports_enabling (MMBroadbandModem *self,
             return FALSE;
         }
         ctx->qcdm_open = TRUE;
+        mm_port_serial_qcdm_start_log_stream (ctx->qcdm);
     }
 
     return TRUE;
@@ -8850,6 +9920,100 @@ schedule_initial_registration_checks (MMBroadbandModem *self)
     g_idle_add ((GSourceFunc) schedule_initial_registration_checks_cb, g_object_ref (self));
 }
 
+/*****************************************************************************/
+/* Adoption of connections established before the daemon started */
+
+static void
+adopt_bearer_ready (MMBaseBearer *bearer,
+                    GAsyncResult *res,
+                    MMBroadbandModem *self)
+{
+    GError *error = NULL;
+
+    if (!mm_base_bearer_adopt_finish (bearer, res, &error)) {
+        mm_dbg ("No existing connection adopted: %s", error->message);
+        g_error_free (error);
+
+        /* Don't leave around a bearer the user never asked for */
+        if (self->priv->modem_bearer_list)
+            mm_bearer_list_delete_bearer (self->priv->modem_bearer_list,
+                                          mm_base_bearer_get_path (bearer),
+                                          NULL);
+    } else
+        mm_info ("Adopted existing connection in bearer '%s'", mm_base_bearer_get_path (bearer));
+
+    g_object_unref (self);
+}
+
+static void
+adopt_create_bearer_ready (MMIfaceModem *self,
+                           GAsyncResult *res)
+{
+    MMBaseBearer *bearer;
+    GError *error = NULL;
+
+    bearer = mm_iface_modem_create_bearer_finish (self, res, &error);
+    if (!bearer) {
+        mm_warn ("Couldn't create bearer to adopt existing connection: %s", error->message);
+        g_error_free (error);
+        g_object_unref (self);
+        return;
+    }
+
+    /* The full reference is passed along */
+    mm_base_bearer_adopt (bearer,
+                          (GAsyncReadyCallback) adopt_bearer_ready,
+                          self);
+    g_object_unref (bearer);
+}
+
+static gboolean
+schedule_bearer_adoption_cb (MMBroadbandModem *self)
+{
+    MMBearerProperties *properties;
+
+    /* The settings are loaded from the connection itself, if adopted. Note
+     * that the full reference we got is passed along. */
+    properties = mm_bearer_properties_new ();
+    mm_iface_modem_create_bearer (MM_IFACE_MODEM (self),
+                                  properties,
+                                  (GAsyncReadyCallback) adopt_create_bearer_ready,
+                                  NULL);
+    g_object_unref (properties);
+    return G_SOURCE_REMOVE;
+}
+
+/* A connection left established by a previous daemon instance is only looked
+ * for in the first enabling, and only if no bearer has been created yet; the
+ * adoption runs once the modem is reported as enabled, so that the modem
+ * state follows the bearer status as with any other connection. */
+static void
+schedule_bearer_adoption (MMBroadbandModem *self)
+{
+    if (!mm_context_get_adopt_bearers () ||
+        self->priv->bearer_adoption_done ||
+        !mm_iface_modem_is_3gpp (MM_IFACE_MODEM (self)))
+        return;
+
+    self->priv->bearer_adoption_done = TRUE;
+
+    if (!self->priv->modem_bearer_list ||
+        mm_bearer_list_get_count (self->priv->modem_bearer_list) > 0)
+        return;
+
+    g_idle_add ((GSourceFunc) schedule_bearer_adoption_cb, g_object_ref (self));
+}
+
+/*****************************************************************************/
+
+/* Interfaces exported to be initialized on demand are only enabled and
+ * disabled once initialized */
+static gboolean
+iface_skeleton_initialized (GObject *skeleton)
+{
+    return (skeleton && !mm_lazy_interface_is_pending (G_DBUS_INTERFACE_SKELETON (skeleton)));
+}
+
 /*****************************************************************************/
 
 typedef enum {
@@ -9085,7 +10249,7 @@ disabling_step (DisablingContext *ctx)
         ctx->step++;
 
     case DISABLING_STEP_IFACE_OMA:
-        if (ctx->self->priv->modem_oma_dbus_skeleton) {
+        if (iface_skeleton_initialized (ctx->self->priv->modem_oma_dbus_skeleton)) {
             mm_dbg ("Modem has OMA capabilities, disabling the OMA interface...");
             /* Disabling the Modem Oma interface */
             mm_iface_modem_oma_disable (MM_IFACE_MODEM_OMA (ctx->self),
@@ -9231,22 +10395,75 @@ typedef enum {
     ENABLING_STEP_FIRST,
     ENABLING_STEP_WAIT_FOR_FINAL_STATE,
     ENABLING_STEP_STARTED,
-    ENABLING_STEP_IFACE_MODEM,
-    ENABLING_STEP_IFACE_3GPP,
-    ENABLING_STEP_IFACE_3GPP_USSD,
-    ENABLING_STEP_IFACE_CDMA,
-    ENABLING_STEP_IFACE_CONTACTS,
-    ENABLING_STEP_IFACE_LOCATION,
-    ENABLING_STEP_IFACE_MESSAGING,
-    ENABLING_STEP_IFACE_VOICE,
-    ENABLING_STEP_IFACE_TIME,
-    ENABLING_STEP_IFACE_SIGNAL,
-    ENABLING_STEP_IFACE_OMA,
-    ENABLING_STEP_IFACE_FIRMWARE,
-    ENABLING_STEP_IFACE_SIMPLE,
+    ENABLING_STEP_IFACES,
     ENABLING_STEP_LAST,
 } EnablingStep;
 
+/* Interfaces enabled in the ENABLING_STEP_IFACES step; each one is enabled as
+ * soon as all the ones it depends on are, so independent interfaces get
+ * enabled concurrently. Commands sent by concurrent interfaces to the same
+ * port are still serialized by the port command queue. */
+typedef enum {
+    ENABLING_IFACE_MODEM,
+    ENABLING_IFACE_3GPP,
+    ENABLING_IFACE_3GPP_USSD,
+    ENABLING_IFACE_CDMA,
+    ENABLING_IFACE_LOCATION,
+    ENABLING_IFACE_MESSAGING,
+    ENABLING_IFACE_VOICE,
+    ENABLING_IFACE_TIME,
+    ENABLING_IFACE_SIGNAL,
+    ENABLING_IFACE_OMA,
+    ENABLING_IFACE_LAST
+} EnablingIface;
+
+#define ENABLING_IFACE_BIT(iface) (1 << (iface))
+
+typedef struct {
+    const gchar *name;
+    /* Mask of ENABLING_IFACE_BIT()s */
+    guint depends_on;
+    /* Whether failing to enable the interface makes the whole enabling fail */
+    gboolean fatal_errors;
+} EnablingIfaceInfo;
+
+static const EnablingIfaceInfo enabling_ifaces[ENABLING_IFACE_LAST] = {
+    [ENABLING_IFACE_MODEM] = {
+        "Modem", 0, TRUE
+    },
+    /* 3GPP and CDMA setup registration and access technology reporting;
+     * they are still enabled one after the other in multimode modems, as
+     * both drive the same registration state */
+    [ENABLING_IFACE_3GPP] = {
+        "Modem 3GPP", ENABLING_IFACE_BIT (ENABLING_IFACE_MODEM), TRUE
+    },
+    [ENABLING_IFACE_3GPP_USSD] = {
+        "Modem 3GPP/USSD", ENABLING_IFACE_BIT (ENABLING_IFACE_3GPP), TRUE
+    },
+    [ENABLING_IFACE_CDMA] = {
+        "Modem CDMA", ENABLING_IFACE_BIT (ENABLING_IFACE_3GPP), TRUE
+    },
+    /* Location needs the registration info (e.g. LAC/CI) */
+    [ENABLING_IFACE_LOCATION] = {
+        "Location", ENABLING_IFACE_BIT (ENABLING_IFACE_3GPP) | ENABLING_IFACE_BIT (ENABLING_IFACE_CDMA), FALSE
+    },
+    [ENABLING_IFACE_MESSAGING] = {
+        "Messaging", ENABLING_IFACE_BIT (ENABLING_IFACE_3GPP) | ENABLING_IFACE_BIT (ENABLING_IFACE_CDMA), FALSE
+    },
+    [ENABLING_IFACE_VOICE] = {
+        "Voice", ENABLING_IFACE_BIT (ENABLING_IFACE_3GPP) | ENABLING_IFACE_BIT (ENABLING_IFACE_CDMA), FALSE
+    },
+    [ENABLING_IFACE_TIME] = {
+        "Time", ENABLING_IFACE_BIT (ENABLING_IFACE_MODEM), FALSE
+    },
+    [ENABLING_IFACE_SIGNAL] = {
+        "Signal", ENABLING_IFACE_BIT (ENABLING_IFACE_MODEM), FALSE
+    },
+    [ENABLING_IFACE_OMA] = {
+        "OMA", ENABLING_IFACE_BIT (ENABLING_IFACE_MODEM), FALSE
+    },
+};
+
 typedef struct {
     MMBroadbandModem *self;
     GCancellable *cancellable;
@@ -9254,6 +10471,15 @@ typedef struct {
     EnablingStep step;
     MMModemState previous_state;
     gboolean enabled;
+    /* ENABLING_STEP_IFACES */
+    guint ifaces_launched;
+    guint ifaces_done;
+    guint ifaces_pending;
+    GError *ifaces_error;
+    gboolean ifaces_scheduling;
+    gboolean ifaces_reschedule;
+    /* When each interface was launched, for the profiler */
+    gint64 ifaces_start[ENABLING_IFACE_LAST];
 } EnablingContext;
 
 static void enabling_step (EnablingContext *ctx);
@@ -9275,6 +10501,7 @@ enabling_context_complete_and_free (EnablingContext *ctx)
                                      MM_MODEM_STATE_CHANGE_REASON_UNKNOWN);
     }
 
+    g_assert (!ctx->ifaces_error);
     g_object_unref (ctx->cancellable);
     g_object_unref (ctx->self);
     g_free (ctx);
@@ -9305,44 +10532,240 @@ enable_finish (MMBaseModem *self,
     return TRUE;
 }
 
-#undef INTERFACE_ENABLE_READY_FN
-#define INTERFACE_ENABLE_READY_FN(NAME,TYPE,FATAL_ERRORS)               \
-    static void                                                         \
-    NAME##_enable_ready (MMBroadbandModem *self,                        \
-                         GAsyncResult *result,                          \
-                         EnablingContext *ctx)                          \
-    {                                                                   \
-        GError *error = NULL;                                           \
-                                                                        \
-        if (!mm_##NAME##_enable_finish (TYPE (self),                    \
-                                        result,                         \
-                                        &error)) {                      \
-            if (FATAL_ERRORS) {                                         \
-                g_simple_async_result_take_error (ctx->result, error);  \
-                enabling_context_complete_and_free (ctx);               \
-                return;                                                 \
-            }                                                           \
-                                                                        \
-            mm_dbg ("Couldn't enable interface: '%s'",                  \
-                    error->message);                                    \
-            g_error_free (error);                                       \
-        }                                                               \
+static void enabling_ifaces_schedule (EnablingContext *ctx);
+
+static void
+enabling_iface_ready (EnablingContext *ctx,
+                      EnablingIface iface,
+                      GError *error)
+{
+    g_assert (ctx->ifaces_pending > 0);
+    ctx->ifaces_pending--;
+    ctx->ifaces_done |= ENABLING_IFACE_BIT (iface);
+
+    if (mm_profiler_is_running ()) {
+        gchar *category;
+
+        category = g_strdup_printf ("%s interface enabling", enabling_ifaces[iface].name);
+        mm_profiler_add (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                         category,
+                         error ? "failed" : "enabled",
+                         ctx->ifaces_start[iface],
+                         g_get_monotonic_time ());
+        g_free (category);
+    }
+
+    if (error) {
+        if (enabling_ifaces[iface].fatal_errors && !ctx->ifaces_error)
+            ctx->ifaces_error = error;
+        else {
+            mm_dbg ("Couldn't enable %s interface: '%s'",
+                    enabling_ifaces[iface].name,
+                    error->message);
+            g_error_free (error);
+        }
+    }
+
+    enabling_ifaces_schedule (ctx);
+}
+
+#undef INTERFACE_ENABLE_READY_FN
+#define INTERFACE_ENABLE_READY_FN(NAME,TYPE,IFACE)                      \
+    static void                                                         \
+    NAME##_enable_ready (MMBroadbandModem *self,                        \
+                         GAsyncResult *result,                          \
+                         EnablingContext *ctx)                          \
+    {                                                                   \
+        GError *error = NULL;                                           \
                                                                         \
-        /* Go on to next step */                                        \
-        ctx->step++;                                                    \
-        enabling_step (ctx);                                            \
+        mm_##NAME##_enable_finish (TYPE (self), result, &error);        \
+        enabling_iface_ready (ctx, IFACE, error);                       \
+    }
+
+INTERFACE_ENABLE_READY_FN (iface_modem,           MM_IFACE_MODEM,           ENABLING_IFACE_MODEM)
+INTERFACE_ENABLE_READY_FN (iface_modem_3gpp,      MM_IFACE_MODEM_3GPP,      ENABLING_IFACE_3GPP)
+INTERFACE_ENABLE_READY_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD, ENABLING_IFACE_3GPP_USSD)
+INTERFACE_ENABLE_READY_FN (iface_modem_cdma,      MM_IFACE_MODEM_CDMA,      ENABLING_IFACE_CDMA)
+INTERFACE_ENABLE_READY_FN (iface_modem_location,  MM_IFACE_MODEM_LOCATION,  ENABLING_IFACE_LOCATION)
+INTERFACE_ENABLE_READY_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING, ENABLING_IFACE_MESSAGING)
+INTERFACE_ENABLE_READY_FN (iface_modem_voice,     MM_IFACE_MODEM_VOICE,     ENABLING_IFACE_VOICE)
+INTERFACE_ENABLE_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    ENABLING_IFACE_SIGNAL)
+INTERFACE_ENABLE_READY_FN (iface_modem_time,      MM_IFACE_MODEM_TIME,      ENABLING_IFACE_TIME)
+INTERFACE_ENABLE_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       ENABLING_IFACE_OMA)
+
+/* Returns FALSE if the modem doesn't export the interface */
+static gboolean
+enabling_iface_launch (EnablingContext *ctx,
+                       EnablingIface iface)
+{
+    switch (iface) {
+    case ENABLING_IFACE_MODEM:
+        g_assert (ctx->self->priv->modem_dbus_skeleton != NULL);
+        mm_iface_modem_enable (MM_IFACE_MODEM (ctx->self),
+                               ctx->cancellable,
+                               (GAsyncReadyCallback)iface_modem_enable_ready,
+                               ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_3GPP:
+        if (!ctx->self->priv->modem_3gpp_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has 3GPP capabilities, enabling the Modem 3GPP interface...");
+        mm_iface_modem_3gpp_enable (MM_IFACE_MODEM_3GPP (ctx->self),
+                                    ctx->cancellable,
+                                    (GAsyncReadyCallback)iface_modem_3gpp_enable_ready,
+                                    ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_3GPP_USSD:
+        if (!ctx->self->priv->modem_3gpp_ussd_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has 3GPP/USSD capabilities, enabling the Modem 3GPP/USSD interface...");
+        mm_iface_modem_3gpp_ussd_enable (MM_IFACE_MODEM_3GPP_USSD (ctx->self),
+                                         (GAsyncReadyCallback)iface_modem_3gpp_ussd_enable_ready,
+                                         ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_CDMA:
+        if (!ctx->self->priv->modem_cdma_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has CDMA capabilities, enabling the Modem CDMA interface...");
+        mm_iface_modem_cdma_enable (MM_IFACE_MODEM_CDMA (ctx->self),
+                                    ctx->cancellable,
+                                    (GAsyncReadyCallback)iface_modem_cdma_enable_ready,
+                                    ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_LOCATION:
+        if (!ctx->self->priv->modem_location_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has location capabilities, enabling the Location interface...");
+        mm_iface_modem_location_enable (MM_IFACE_MODEM_LOCATION (ctx->self),
+                                        ctx->cancellable,
+                                        (GAsyncReadyCallback)iface_modem_location_enable_ready,
+                                        ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_MESSAGING:
+        if (!ctx->self->priv->modem_messaging_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has messaging capabilities, enabling the Messaging interface...");
+        mm_iface_modem_messaging_enable (MM_IFACE_MODEM_MESSAGING (ctx->self),
+                                         ctx->cancellable,
+                                         (GAsyncReadyCallback)iface_modem_messaging_enable_ready,
+                                         ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_VOICE:
+        if (!ctx->self->priv->modem_voice_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has voice capabilities, enabling the Voice interface...");
+        mm_iface_modem_voice_enable (MM_IFACE_MODEM_VOICE (ctx->self),
+                                     ctx->cancellable,
+                                     (GAsyncReadyCallback)iface_modem_voice_enable_ready,
+                                     ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_TIME:
+        if (!ctx->self->priv->modem_time_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has time capabilities, enabling the Time interface...");
+        mm_iface_modem_time_enable (MM_IFACE_MODEM_TIME (ctx->self),
+                                    ctx->cancellable,
+                                    (GAsyncReadyCallback)iface_modem_time_enable_ready,
+                                    ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_SIGNAL:
+        if (!ctx->self->priv->modem_signal_dbus_skeleton)
+            return FALSE;
+        mm_dbg ("Modem has extended signal reporting capabilities, enabling the Signal interface...");
+        mm_iface_modem_signal_enable (MM_IFACE_MODEM_SIGNAL (ctx->self),
+                                      ctx->cancellable,
+                                      (GAsyncReadyCallback)iface_modem_signal_enable_ready,
+                                      ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_OMA:
+        if (!iface_skeleton_initialized (ctx->self->priv->modem_oma_dbus_skeleton))
+            return FALSE;
+        mm_dbg ("Modem has OMA capabilities, enabling the OMA interface...");
+        mm_iface_modem_oma_enable (MM_IFACE_MODEM_OMA (ctx->self),
+                                   ctx->cancellable,
+                                   (GAsyncReadyCallback)iface_modem_oma_enable_ready,
+                                   ctx);
+        return TRUE;
+
+    case ENABLING_IFACE_LAST:
+        break;
+    }
+
+    g_assert_not_reached ();
+    return FALSE;
+}
+
+static void
+enabling_ifaces_schedule (EnablingContext *ctx)
+{
+    /* Interfaces completing right away while being launched are handled by
+     * the loop below */
+    if (ctx->ifaces_scheduling) {
+        ctx->ifaces_reschedule = TRUE;
+        return;
     }
 
-INTERFACE_ENABLE_READY_FN (iface_modem,           MM_IFACE_MODEM,           TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_3gpp,      MM_IFACE_MODEM_3GPP,      TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_3gpp_ussd, MM_IFACE_MODEM_3GPP_USSD, TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_cdma,      MM_IFACE_MODEM_CDMA,      TRUE)
-INTERFACE_ENABLE_READY_FN (iface_modem_location,  MM_IFACE_MODEM_LOCATION,  FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_messaging, MM_IFACE_MODEM_MESSAGING, FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_voice,     MM_IFACE_MODEM_VOICE,     FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_time,      MM_IFACE_MODEM_TIME,      FALSE)
-INTERFACE_ENABLE_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       FALSE)
+    ctx->ifaces_scheduling = TRUE;
+    do {
+        guint i;
+
+        ctx->ifaces_reschedule = FALSE;
+
+        /* After a fatal error or a cancellation, only wait for the interfaces
+         * already being enabled */
+        if (!ctx->ifaces_error && g_cancellable_is_cancelled (ctx->cancellable))
+            ctx->ifaces_error = g_error_new (MM_CORE_ERROR,
+                                             MM_CORE_ERROR_CANCELLED,
+                                             "Enabling cancelled");
+        if (ctx->ifaces_error)
+            break;
+
+        for (i = 0; i < ENABLING_IFACE_LAST; i++) {
+            guint depends_on = enabling_ifaces[i].depends_on;
+
+            if (ctx->ifaces_launched & ENABLING_IFACE_BIT (i))
+                continue;
+            if ((ctx->ifaces_done & depends_on) != depends_on)
+                continue;
+
+            ctx->ifaces_launched |= ENABLING_IFACE_BIT (i);
+            ctx->ifaces_pending++;
+            ctx->ifaces_start[i] = g_get_monotonic_time ();
+            if (!enabling_iface_launch (ctx, (EnablingIface) i)) {
+                /* Not exported, so it's done already */
+                ctx->ifaces_pending--;
+                ctx->ifaces_done |= ENABLING_IFACE_BIT (i);
+                ctx->ifaces_reschedule = TRUE;
+            }
+        }
+    } while (ctx->ifaces_reschedule);
+    ctx->ifaces_scheduling = FALSE;
+
+    if (ctx->ifaces_pending > 0)
+        return;
+
+    if (ctx->ifaces_error) {
+        g_simple_async_result_take_error (ctx->result, ctx->ifaces_error);
+        ctx->ifaces_error = NULL;
+        enabling_context_complete_and_free (ctx);
+        return;
+    }
+
+    g_assert (ctx->ifaces_done == ENABLING_IFACE_BIT (ENABLING_IFACE_LAST) - 1);
+
+    /* Go on to next step */
+    ctx->step++;
+    enabling_step (ctx);
+}
 
 static void
 enabling_started_ready (MMBroadbandModem *self,
@@ -9400,6 +10823,11 @@ enabling_step (EnablingContext *ctx)
     if (enabling_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Enabling",
+                      ctx->step,
+                      ENABLING_STEP_LAST);
+
     switch (ctx->step) {
     case ENABLING_STEP_FIRST:
         /* Fall down to next step */
@@ -9423,157 +10851,305 @@ enabling_step (EnablingContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
-    case ENABLING_STEP_IFACE_MODEM:
-        g_assert (ctx->self->priv->modem_dbus_skeleton != NULL);
-        /* Enabling the Modem interface */
-        mm_iface_modem_enable (MM_IFACE_MODEM (ctx->self),
-                               ctx->cancellable,
-                               (GAsyncReadyCallback)iface_modem_enable_ready,
-                               ctx);
+    case ENABLING_STEP_IFACES:
+        enabling_ifaces_schedule (ctx);
         return;
 
-    case ENABLING_STEP_IFACE_3GPP:
-        if (ctx->self->priv->modem_3gpp_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP capabilities, enabling the Modem 3GPP interface...");
-            /* Enabling the Modem 3GPP interface */
-            mm_iface_modem_3gpp_enable (MM_IFACE_MODEM_3GPP (ctx->self),
-                                        ctx->cancellable,
-                                        (GAsyncReadyCallback)iface_modem_3gpp_enable_ready,
-                                        ctx);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+    case ENABLING_STEP_LAST:
+        ctx->enabled = TRUE;
 
-    case ENABLING_STEP_IFACE_3GPP_USSD:
-        if (ctx->self->priv->modem_3gpp_ussd_dbus_skeleton) {
-            mm_dbg ("Modem has 3GPP/USSD capabilities, enabling the Modem 3GPP/USSD interface...");
-            mm_iface_modem_3gpp_ussd_enable (MM_IFACE_MODEM_3GPP_USSD (ctx->self),
-                                             (GAsyncReadyCallback)iface_modem_3gpp_ussd_enable_ready,
-                                             ctx);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+        /* Once all interfaces have been enabled, trigger registration checks in
+         * 3GPP and CDMA modems. We have to do this at this point so that e.g.
+         * location interface gets proper registration related info reported.
+         *
+         * We do this in an idle so that we don't mess up the logs at this point
+         * with the new requests being triggered.
+         */
+        schedule_initial_registration_checks (ctx->self);
 
-    case ENABLING_STEP_IFACE_CDMA:
-        if (ctx->self->priv->modem_cdma_dbus_skeleton) {
-            mm_dbg ("Modem has CDMA capabilities, enabling the Modem CDMA interface...");
-            /* Enabling the Modem CDMA interface */
-            mm_iface_modem_cdma_enable (MM_IFACE_MODEM_CDMA (ctx->self),
-                                        ctx->cancellable,
-                                        (GAsyncReadyCallback)iface_modem_cdma_enable_ready,
-                                        ctx);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+        /* Optionally, take over connections already established */
+        schedule_bearer_adoption (ctx->self);
 
-    case ENABLING_STEP_IFACE_CONTACTS:
-        /* Fall down to next step */
-        ctx->step++;
+        /* All enabled without errors! */
+        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+        enabling_context_complete_and_free (ctx);
+        return;
+    }
 
-    case ENABLING_STEP_IFACE_LOCATION:
-        if (ctx->self->priv->modem_location_dbus_skeleton) {
-            mm_dbg ("Modem has location capabilities, enabling the Location interface...");
-            /* Enabling the Modem Location interface */
-            mm_iface_modem_location_enable (MM_IFACE_MODEM_LOCATION (ctx->self),
-                                            ctx->cancellable,
-                                            (GAsyncReadyCallback)iface_modem_location_enable_ready,
-                                            ctx);
-            return;
-        }
-        /* Fall down to next step */
-        ctx->step++;
+    g_assert_not_reached ();
+}
 
-    case ENABLING_STEP_IFACE_MESSAGING:
-        if (ctx->self->priv->modem_messaging_dbus_skeleton) {
-            mm_dbg ("Modem has messaging capabilities, enabling the Messaging interface...");
-            /* Enabling the Modem Messaging interface */
-            mm_iface_modem_messaging_enable (MM_IFACE_MODEM_MESSAGING (ctx->self),
-                                             ctx->cancellable,
-                                             (GAsyncReadyCallback)iface_modem_messaging_enable_ready,
-                                             ctx);
-            return;
-        }
-        /* Fall down to next step */
+static void
+enable (MMBaseModem *self,
+        GCancellable *cancellable,
+        GAsyncReadyCallback callback,
+        gpointer user_data)
+{
+    GSimpleAsyncResult *result;
+
+    result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, enable);
+
+    /* Check state before launching modem enabling */
+    switch (MM_BROADBAND_MODEM (self)->priv->modem_state) {
+    case MM_MODEM_STATE_UNKNOWN:
+        /* We should never have a UNKNOWN->ENABLED transition */
+        g_assert_not_reached ();
+        break;
+
+    case MM_MODEM_STATE_FAILED:
+    case MM_MODEM_STATE_INITIALIZING:
+        g_simple_async_result_set_error (result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_WRONG_STATE,
+                                         "Cannot enable modem: "
+                                         "device not fully initialized yet");
+        break;
+
+    case MM_MODEM_STATE_LOCKED:
+        g_simple_async_result_set_error (result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_WRONG_STATE,
+                                         "Cannot enable modem: device locked");
+        break;
+
+    case MM_MODEM_STATE_DISABLED: {
+        EnablingContext *ctx;
+
+        ctx = g_new0 (EnablingContext, 1);
+        ctx->self = g_object_ref (self);
+        ctx->result = result;
+        ctx->cancellable = g_object_ref (cancellable);
+        ctx->step = ENABLING_STEP_FIRST;
+        enabling_step (ctx);
+        return;
+    }
+
+    case MM_MODEM_STATE_DISABLING:
+        g_simple_async_result_set_error (result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_WRONG_STATE,
+                                         "Cannot enable modem: "
+                                         "currently being disabled");
+        break;
+
+    case MM_MODEM_STATE_ENABLING:
+        g_simple_async_result_set_error (result,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_IN_PROGRESS,
+                                         "Cannot enable modem: "
+                                         "already being enabled");
+        break;
+
+    case MM_MODEM_STATE_ENABLED:
+    case MM_MODEM_STATE_SEARCHING:
+    case MM_MODEM_STATE_REGISTERED:
+    case MM_MODEM_STATE_DISCONNECTING:
+    case MM_MODEM_STATE_CONNECTING:
+    case MM_MODEM_STATE_CONNECTED:
+        /* Just return success, don't relaunch enabling */
+        g_simple_async_result_set_op_res_gboolean (result, TRUE);
+        break;
+    }
+
+    g_simple_async_result_complete_in_idle (result);
+    g_object_unref (result);
+}
+
+/*****************************************************************************/
+/* Interfaces initialized on demand (--lazy-interfaces)
+ *
+ * Interfaces rarely used and without unsolicited state of their own to keep
+ * up with (OMA, Firmware) only get their support checked during the modem
+ * initialization, and if supported are exported with their default property
+ * values, to be fully initialized on their first method call. If the modem is
+ * enabled by then, they are also enabled right away. USSD and Voice are
+ * always initialized along with the modem, as they must not miss network
+ * initiated sessions or incoming calls.
+ */
+
+typedef enum {
+    LAZY_IFACE_OMA,
+    LAZY_IFACE_FIRMWARE,
+    LAZY_IFACE_UNKNOWN
+} LazyIface;
+
+typedef enum {
+    LAZY_INITIALIZE_STEP_FIRST,
+    LAZY_INITIALIZE_STEP_INITIALIZE,
+    LAZY_INITIALIZE_STEP_WAIT_FOR_FINAL_STATE,
+    LAZY_INITIALIZE_STEP_ENABLE,
+    LAZY_INITIALIZE_STEP_LAST,
+} LazyInitializeStep;
+
+typedef struct {
+    MMBroadbandModem *self;
+    GSimpleAsyncResult *result;
+    GCancellable *cancellable;
+    LazyIface iface;
+    LazyInitializeStep step;
+} LazyInitializeContext;
+
+static void lazy_initialize_step (LazyInitializeContext *ctx);
+
+static void
+lazy_initialize_context_complete_and_free (LazyInitializeContext *ctx)
+{
+    g_simple_async_result_complete_in_idle (ctx->result);
+    g_object_unref (ctx->result);
+    g_object_unref (ctx->cancellable);
+    g_object_unref (ctx->self);
+    g_slice_free (LazyInitializeContext, ctx);
+}
+
+static gboolean
+lazy_initialize_finish (GObject *owner,
+                        GAsyncResult *res,
+                        GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+#undef INTERFACE_LAZY_ENABLE_READY_FN
+#define INTERFACE_LAZY_ENABLE_READY_FN(NAME,TYPE)                       \
+    static void                                                         \
+    NAME##_lazy_enable_ready (MMBroadbandModem *self,                   \
+                              GAsyncResult *result,                     \
+                              LazyInitializeContext *ctx)               \
+    {                                                                   \
+        GError *error = NULL;                                           \
+                                                                        \
+        /* Not fatal, the interface is still usable */                  \
+        if (!mm_##NAME##_enable_finish (TYPE (self), result, &error)) { \
+            mm_dbg ("Couldn't enable interface: '%s'", error->message); \
+            g_error_free (error);                                       \
+        }                                                               \
+                                                                        \
+        /* Go on to next step */                                        \
+        ctx->step++;                                                    \
+        lazy_initialize_step (ctx);                                     \
+    }
+
+INTERFACE_LAZY_ENABLE_READY_FN (iface_modem_oma, MM_IFACE_MODEM_OMA)
+
+static void
+lazy_wait_for_final_state_ready (MMIfaceModem *self,
+                                 GAsyncResult *res,
+                                 LazyInitializeContext *ctx)
+{
+    MMModemState state;
+    GError *error = NULL;
+
+    state = mm_iface_modem_wait_for_final_state_finish (self, res, &error);
+    if (error) {
+        mm_dbg ("Couldn't wait for final state: '%s'", error->message);
+        g_error_free (error);
+        state = MM_MODEM_STATE_UNKNOWN;
+    }
+
+    /* Only enable if the modem is enabled */
+    if (state >= MM_MODEM_STATE_ENABLED)
         ctx->step++;
+    else
+        ctx->step = LAZY_INITIALIZE_STEP_LAST;
+    lazy_initialize_step (ctx);
+}
 
-    case ENABLING_STEP_IFACE_VOICE:
-        if (ctx->self->priv->modem_voice_dbus_skeleton) {
-            mm_dbg ("Modem has voice capabilities, enabling the Voice interface...");
-            /* Enabling the Modem Voice interface */
-            mm_iface_modem_voice_enable (MM_IFACE_MODEM_VOICE (ctx->self),
-                                             ctx->cancellable,
-                                             (GAsyncReadyCallback)iface_modem_voice_enable_ready,
-                                             ctx);
+#undef INTERFACE_LAZY_INIT_READY_FN
+#define INTERFACE_LAZY_INIT_READY_FN(NAME,TYPE)                         \
+    static void                                                         \
+    NAME##_lazy_initialize_ready (MMBroadbandModem *self,               \
+                                  GAsyncResult *result,                 \
+                                  LazyInitializeContext *ctx)           \
+    {                                                                   \
+        GError *error = NULL;                                           \
+                                                                        \
+        if (!mm_##NAME##_initialize_finish (TYPE (self), result, &error)) { \
+            /* Just shutdown this interface */                          \
+            mm_##NAME##_shutdown (TYPE (self));                         \
+            g_simple_async_result_take_error (ctx->result, error);      \
+            lazy_initialize_context_complete_and_free (ctx);            \
+            return;                                                     \
+        }                                                               \
+                                                                        \
+        /* bind simple properties */                                    \
+        mm_##NAME##_bind_simple_status (TYPE (self), self->priv->modem_simple_status); \
+                                                                        \
+        /* Go on to next step */                                        \
+        ctx->step++;                                                    \
+        lazy_initialize_step (ctx);                                     \
+    }
+
+INTERFACE_LAZY_INIT_READY_FN (iface_modem_oma,      MM_IFACE_MODEM_OMA)
+INTERFACE_LAZY_INIT_READY_FN (iface_modem_firmware, MM_IFACE_MODEM_FIRMWARE)
+
+static void
+lazy_initialize_step (LazyInitializeContext *ctx)
+{
+    switch (ctx->step) {
+    case LAZY_INITIALIZE_STEP_FIRST:
+        if (ctx->iface == LAZY_IFACE_UNKNOWN) {
+            /* The interface was shut down in the meantime */
+            g_simple_async_result_set_error (ctx->result,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_ABORTED,
+                                             "Interface is no longer available");
+            lazy_initialize_context_complete_and_free (ctx);
             return;
         }
         /* Fall down to next step */
         ctx->step++;
 
-    case ENABLING_STEP_IFACE_TIME:
-        if (ctx->self->priv->modem_time_dbus_skeleton) {
-            mm_dbg ("Modem has time capabilities, enabling the Time interface...");
-            /* Enabling the Modem Time interface */
-            mm_iface_modem_time_enable (MM_IFACE_MODEM_TIME (ctx->self),
-                                        ctx->cancellable,
-                                        (GAsyncReadyCallback)iface_modem_time_enable_ready,
-                                        ctx);
+    case LAZY_INITIALIZE_STEP_INITIALIZE:
+        switch (ctx->iface) {
+        case LAZY_IFACE_OMA:
+            mm_iface_modem_oma_initialize (MM_IFACE_MODEM_OMA (ctx->self),
+                                           ctx->cancellable,
+                                           (GAsyncReadyCallback)iface_modem_oma_lazy_initialize_ready,
+                                           ctx);
+            return;
+        case LAZY_IFACE_FIRMWARE:
+            mm_iface_modem_firmware_initialize (MM_IFACE_MODEM_FIRMWARE (ctx->self),
+                                                ctx->cancellable,
+                                                (GAsyncReadyCallback)iface_modem_firmware_lazy_initialize_ready,
+                                                ctx);
             return;
+        case LAZY_IFACE_UNKNOWN:
+            break;
         }
-        /* Fall down to next step */
-        ctx->step++;
+        g_assert_not_reached ();
 
-    case ENABLING_STEP_IFACE_SIGNAL:
-        if (ctx->self->priv->modem_signal_dbus_skeleton) {
-            mm_dbg ("Modem has extended signal reporting capabilities, enabling the Signal interface...");
-            /* Enabling the Modem Signal interface */
-            mm_iface_modem_signal_enable (MM_IFACE_MODEM_SIGNAL (ctx->self),
-                                          ctx->cancellable,
-                                          (GAsyncReadyCallback)iface_modem_signal_enable_ready,
-                                          ctx);
+    case LAZY_INITIALIZE_STEP_WAIT_FOR_FINAL_STATE:
+        /* The Firmware interface has nothing to enable */
+        if (ctx->iface == LAZY_IFACE_FIRMWARE) {
+            ctx->step = LAZY_INITIALIZE_STEP_LAST;
+            lazy_initialize_step (ctx);
             return;
         }
-        /* Fall down to next step */
-        ctx->step++;
+        /* If the modem is being enabled, the interface was skipped by the
+         * enabling sequence, so wait for it to finish */
+        mm_iface_modem_wait_for_final_state (MM_IFACE_MODEM (ctx->self),
+                                             MM_MODEM_STATE_UNKNOWN, /* just any */
+                                             (GAsyncReadyCallback)lazy_wait_for_final_state_ready,
+                                             ctx);
+        return;
 
-    case ENABLING_STEP_IFACE_OMA:
-        if (ctx->self->priv->modem_oma_dbus_skeleton) {
-            mm_dbg ("Modem has OMA capabilities, enabling the OMA interface...");
-            /* Enabling the Modem Oma interface */
+    case LAZY_INITIALIZE_STEP_ENABLE:
+        switch (ctx->iface) {
+        case LAZY_IFACE_OMA:
             mm_iface_modem_oma_enable (MM_IFACE_MODEM_OMA (ctx->self),
                                        ctx->cancellable,
-                                       (GAsyncReadyCallback)iface_modem_oma_enable_ready,
+                                       (GAsyncReadyCallback)iface_modem_oma_lazy_enable_ready,
                                        ctx);
             return;
+        case LAZY_IFACE_FIRMWARE:
+        case LAZY_IFACE_UNKNOWN:
+            break;
         }
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_FIRMWARE:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_IFACE_SIMPLE:
-        /* Fall down to next step */
-        ctx->step++;
-
-    case ENABLING_STEP_LAST:
-        ctx->enabled = TRUE;
-
-        /* Once all interfaces have been enabled, trigger registration checks in
-         * 3GPP and CDMA modems. We have to do this at this point so that e.g.
-         * location interface gets proper registration related info reported.
-         *
-         * We do this in an idle so that we don't mess up the logs at this point
-         * with the new requests being triggered.
-         */
-        schedule_initial_registration_checks (ctx->self);
+        g_assert_not_reached ();
 
-        /* All enabled without errors! */
+    case LAZY_INITIALIZE_STEP_LAST:
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
-        enabling_context_complete_and_free (ctx);
+        lazy_initialize_context_complete_and_free (ctx);
         return;
     }
 
@@ -9581,79 +11157,38 @@ enabling_step (EnablingContext *ctx)
 }
 
 static void
-enable (MMBaseModem *self,
-        GCancellable *cancellable,
-        GAsyncReadyCallback callback,
-        gpointer user_data)
+lazy_initialize (GObject *owner,
+                 GDBusInterfaceSkeleton *skeleton,
+                 GAsyncReadyCallback callback,
+                 gpointer user_data)
 {
-    GSimpleAsyncResult *result;
-
-    result = g_simple_async_result_new (G_OBJECT (self), callback, user_data, enable);
-
-    /* Check state before launching modem enabling */
-    switch (MM_BROADBAND_MODEM (self)->priv->modem_state) {
-    case MM_MODEM_STATE_UNKNOWN:
-        /* We should never have a UNKNOWN->ENABLED transition */
-        g_assert_not_reached ();
-        break;
-
-    case MM_MODEM_STATE_FAILED:
-    case MM_MODEM_STATE_INITIALIZING:
-        g_simple_async_result_set_error (result,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_WRONG_STATE,
-                                         "Cannot enable modem: "
-                                         "device not fully initialized yet");
-        break;
-
-    case MM_MODEM_STATE_LOCKED:
-        g_simple_async_result_set_error (result,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_WRONG_STATE,
-                                         "Cannot enable modem: device locked");
-        break;
-
-    case MM_MODEM_STATE_DISABLED: {
-        EnablingContext *ctx;
-
-        ctx = g_new0 (EnablingContext, 1);
-        ctx->self = g_object_ref (self);
-        ctx->result = result;
-        ctx->cancellable = g_object_ref (cancellable);
-        ctx->step = ENABLING_STEP_FIRST;
-        enabling_step (ctx);
-        return;
-    }
+    MMBroadbandModem *self = MM_BROADBAND_MODEM (owner);
+    LazyInitializeContext *ctx;
 
-    case MM_MODEM_STATE_DISABLING:
-        g_simple_async_result_set_error (result,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_WRONG_STATE,
-                                         "Cannot enable modem: "
-                                         "currently being disabled");
-        break;
+    ctx = g_slice_new0 (LazyInitializeContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = g_simple_async_result_new (owner, callback, user_data, lazy_initialize);
+    ctx->cancellable = g_cancellable_new ();
+    ctx->step = LAZY_INITIALIZE_STEP_FIRST;
 
-    case MM_MODEM_STATE_ENABLING:
-        g_simple_async_result_set_error (result,
-                                         MM_CORE_ERROR,
-                                         MM_CORE_ERROR_IN_PROGRESS,
-                                         "Cannot enable modem: "
-                                         "already being enabled");
-        break;
+    if ((GObject *) skeleton == self->priv->modem_oma_dbus_skeleton)
+        ctx->iface = LAZY_IFACE_OMA;
+    else if ((GObject *) skeleton == self->priv->modem_firmware_dbus_skeleton)
+        ctx->iface = LAZY_IFACE_FIRMWARE;
+    else
+        ctx->iface = LAZY_IFACE_UNKNOWN;
 
-    case MM_MODEM_STATE_ENABLED:
-    case MM_MODEM_STATE_SEARCHING:
-    case MM_MODEM_STATE_REGISTERED:
-    case MM_MODEM_STATE_DISCONNECTING:
-    case MM_MODEM_STATE_CONNECTING:
-    case MM_MODEM_STATE_CONNECTED:
-        /* Just return success, don't relaunch enabling */
-        g_simple_async_result_set_op_res_gboolean (result, TRUE);
-        break;
-    }
+    lazy_initialize_step (ctx);
+}
 
-    g_simple_async_result_complete_in_idle (result);
-    g_object_unref (result);
+/* Whether the interface is to be initialized on demand; once initialized that
+ * way, it's initialized again along with the whole modem (e.g. after
+ * unlocking) */
+static gboolean
+iface_initialize_lazily (GObject *skeleton)
+{
+    return (mm_context_get_lazy_interfaces () &&
+            (!skeleton || mm_lazy_interface_is_pending (G_DBUS_INTERFACE_SKELETON (skeleton))));
 }
 
 /*****************************************************************************/
@@ -9875,6 +11410,36 @@ INTERFACE_INIT_READY_FN (iface_modem_signal,    MM_IFACE_MODEM_SIGNAL,    FALSE)
 INTERFACE_INIT_READY_FN (iface_modem_oma,       MM_IFACE_MODEM_OMA,       FALSE)
 INTERFACE_INIT_READY_FN (iface_modem_firmware,  MM_IFACE_MODEM_FIRMWARE,  FALSE)
 
+#undef INTERFACE_INIT_LAZY_READY_FN
+#define INTERFACE_INIT_LAZY_READY_FN(NAME,TYPE,SKELETON)                \
+    static void                                                         \
+    NAME##_initialize_lazy_ready (MMBroadbandModem *self,               \
+                                  GAsyncResult *result,                 \
+                                  InitializeContext *ctx)               \
+    {                                                                   \
+        GError *error = NULL;                                           \
+                                                                        \
+        if (!mm_##NAME##_initialize_finish (TYPE (self), result, &error)) { \
+            mm_dbg ("Couldn't initialize interface: '%s'",              \
+                    error->message);                                    \
+            /* Just shutdown this interface */                          \
+            mm_##NAME##_shutdown (TYPE (self));                         \
+            g_error_free (error);                                       \
+        } else                                                          \
+            /* Supported and exported, the rest is done on demand */    \
+            mm_lazy_interface_setup (G_DBUS_INTERFACE_SKELETON (self->priv->SKELETON), \
+                                     G_OBJECT (self),                   \
+                                     lazy_initialize,                   \
+                                     lazy_initialize_finish);           \
+                                                                        \
+        /* Go on to next step */                                        \
+        ctx->step++;                                                    \
+        initialize_step (ctx);                                          \
+    }
+
+INTERFACE_INIT_LAZY_READY_FN (iface_modem_oma,      MM_IFACE_MODEM_OMA,      modem_oma_dbus_skeleton)
+INTERFACE_INIT_LAZY_READY_FN (iface_modem_firmware, MM_IFACE_MODEM_FIRMWARE, modem_firmware_dbus_skeleton)
+
 static void
 initialize_step (InitializeContext *ctx)
 {
@@ -9882,6 +11447,11 @@ initialize_step (InitializeContext *ctx)
     if (initialize_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Initialization",
+                      ctx->step,
+                      INITIALIZE_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZE_STEP_FIRST:
         /* Fall down to next step */
@@ -10002,6 +11572,14 @@ initialize_step (InitializeContext *ctx)
         return;
 
     case INITIALIZE_STEP_IFACE_OMA:
+        if (iface_initialize_lazily (ctx->self->priv->modem_oma_dbus_skeleton)) {
+            /* Only check support and export the Oma interface */
+            mm_iface_modem_oma_initialize_lazy (MM_IFACE_MODEM_OMA (ctx->self),
+                                                ctx->cancellable,
+                                                (GAsyncReadyCallback)iface_modem_oma_initialize_lazy_ready,
+                                                ctx);
+            return;
+        }
         /* Initialize the Oma interface */
         mm_iface_modem_oma_initialize (MM_IFACE_MODEM_OMA (ctx->self),
                                        ctx->cancellable,
@@ -10010,6 +11588,14 @@ initialize_step (InitializeContext *ctx)
         return;
 
     case INITIALIZE_STEP_IFACE_FIRMWARE:
+        if (iface_initialize_lazily (ctx->self->priv->modem_firmware_dbus_skeleton)) {
+            /* Only check support and export the Firmware interface */
+            mm_iface_modem_firmware_initialize_lazy (MM_IFACE_MODEM_FIRMWARE (ctx->self),
+                                                     ctx->cancellable,
+                                                     (GAsyncReadyCallback)iface_modem_firmware_initialize_lazy_ready,
+                                                     ctx);
+            return;
+        }
         /* Initialize the Firmware interface */
         mm_iface_modem_firmware_initialize (MM_IFACE_MODEM_FIRMWARE (ctx->self),
                                             ctx->cancellable,
@@ -10280,6 +11866,9 @@ mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self)
         self->priv->sim_hot_swap_ports_ctx = NULL;
     }
 
+    /* Replies given with the previous SIM are no longer valid */
+    mm_base_modem_clear_shared_reply_cache (MM_BASE_MODEM (self));
+
     mm_base_modem_set_reprobe (MM_BASE_MODEM (self), TRUE);
     mm_base_modem_disable (MM_BASE_MODEM (self),
                            (GAsyncReadyCallback) after_hotswap_event_disable_ready,
@@ -10288,6 +11877,242 @@ mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self)
 
 /*****************************************************************************/
 
+gboolean
+mm_broadband_modem_peek_pdp_contexts (MMBroadbandModem *self,
+                                      GList **out_pdp_list)
+{
+    if (!self->priv->pdp_contexts_valid)
+        return FALSE;
+
+    *out_pdp_list = self->priv->pdp_contexts;
+    return TRUE;
+}
+
+void
+mm_broadband_modem_set_pdp_contexts (MMBroadbandModem *self,
+                                     GList *pdp_list)
+{
+    mm_3gpp_pdp_context_list_free (self->priv->pdp_contexts);
+    self->priv->pdp_contexts = pdp_list;
+    self->priv->pdp_contexts_valid = TRUE;
+}
+
+void
+mm_broadband_modem_update_pdp_context (MMBroadbandModem *self,
+                                       guint cid,
+                                       MMBearerIpFamily pdp_type,
+                                       const gchar *apn)
+{
+    MM3gppPdpContext *pdp = NULL;
+    GList *l;
+
+    if (!self->priv->pdp_contexts_valid)
+        return;
+
+    for (l = self->priv->pdp_contexts; l; l = g_list_next (l)) {
+        if (((MM3gppPdpContext *)l->data)->cid == cid) {
+            pdp = l->data;
+            break;
+        }
+    }
+
+    if (!pdp) {
+        pdp = g_slice_new0 (MM3gppPdpContext);
+        pdp->cid = cid;
+        self->priv->pdp_contexts = g_list_append (self->priv->pdp_contexts, pdp);
+    }
+
+    pdp->pdp_type = pdp_type;
+    g_free (pdp->apn);
+    pdp->apn = g_strdup (apn);
+}
+
+void
+mm_broadband_modem_invalidate_pdp_contexts (MMBroadbandModem *self)
+{
+    if (self->priv->pdp_contexts_valid)
+        mm_dbg ("Invalidating cached PDP contexts");
+
+    mm_3gpp_pdp_context_list_free (self->priv->pdp_contexts);
+    self->priv->pdp_contexts = NULL;
+    self->priv->pdp_contexts_valid = FALSE;
+}
+
+/*****************************************************************************/
+/* Waiting for the SIM to be ready after unlocking it */
+
+/* Interval before the first poll, doubled after every attempt up to the max */
+#define SIM_READY_POLL_FIRST_MS 250
+#define SIM_READY_POLL_MAX_MS   1000
+
+typedef struct {
+    MMBroadbandModem *self;
+    /* NULL once completed */
+    GSimpleAsyncResult *result;
+    MMBroadbandModemSimReadyIndicator indicator;
+    gint64 start;
+    guint poll_ms;
+    guint poll_id;
+    guint deadline_id;
+    gboolean command_running;
+} SimReadyContext;
+
+static void sim_ready_poll (SimReadyContext *ctx);
+
+static void
+sim_ready_context_free (SimReadyContext *ctx)
+{
+    g_object_unref (ctx->self);
+    g_slice_free (SimReadyContext, ctx);
+}
+
+static void
+sim_ready_context_complete (SimReadyContext *ctx,
+                            const gchar *reason)
+{
+    if (ctx->poll_id) {
+        g_source_remove (ctx->poll_id);
+        ctx->poll_id = 0;
+    }
+    if (ctx->deadline_id) {
+        g_source_remove (ctx->deadline_id);
+        ctx->deadline_id = 0;
+    }
+
+    mm_dbg ("(%s) SIM %s after %" G_GINT64_FORMAT " ms",
+            mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+            reason,
+            (mm_clock_get_time () - ctx->start) / 1000);
+
+    ctx->self->priv->sim_ready_ctx = NULL;
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    g_simple_async_result_complete_in_idle (ctx->result);
+    g_clear_object (&ctx->result);
+
+    /* A running command gets its reply later */
+    if (!ctx->command_running)
+        sim_ready_context_free (ctx);
+}
+
+static gboolean
+sim_ready_deadline_cb (SimReadyContext *ctx)
+{
+    ctx->deadline_id = 0;
+    sim_ready_context_complete (ctx, "readiness not detected, going on anyway");
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+sim_ready_poll_cb (SimReadyContext *ctx)
+{
+    ctx->poll_id = 0;
+    sim_ready_poll (ctx);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+sim_ready_check_ready (MMBaseModem *self,
+                       GAsyncResult *res,
+                       SimReadyContext *ctx)
+{
+    const gchar *response;
+    gboolean ready = FALSE;
+
+    ctx->command_running = FALSE;
+    /* Errors, e.g. 'SIM busy', just mean that it isn't ready yet */
+    response = mm_base_modem_at_command_finish (self, res, NULL);
+
+    /* Deadline reached meanwhile */
+    if (!ctx->result) {
+        sim_ready_context_free (ctx);
+        return;
+    }
+
+    switch (ctx->indicator) {
+    case MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPMS:
+        ready = (response != NULL);
+        break;
+    case MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPIN:
+        ready = (response && strstr (response, "READY") != NULL);
+        break;
+    case MM_BROADBAND_MODEM_SIM_READY_INDICATOR_URC:
+        g_assert_not_reached ();
+    }
+
+    if (ready) {
+        sim_ready_context_complete (ctx, "ready");
+        return;
+    }
+
+    ctx->poll_id = mm_clock_timeout_add (ctx->poll_ms, (GSourceFunc) sim_ready_poll_cb, ctx);
+    ctx->poll_ms = MIN (ctx->poll_ms * 2, SIM_READY_POLL_MAX_MS);
+}
+
+static void
+sim_ready_poll (SimReadyContext *ctx)
+{
+    ctx->command_running = TRUE;
+    mm_base_modem_at_command (MM_BASE_MODEM (ctx->self),
+                              (ctx->indicator == MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPIN ?
+                               "+CPIN?" : "+CPMS?"),
+                              3,
+                              FALSE,
+                              (GAsyncReadyCallback) sim_ready_check_ready,
+                              ctx);
+}
+
+gboolean
+mm_broadband_modem_wait_sim_ready_finish (MMBroadbandModem *self,
+                                          GAsyncResult *res,
+                                          GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+void
+mm_broadband_modem_wait_sim_ready (MMBroadbandModem *self,
+                                   MMBroadbandModemSimReadyIndicator indicator,
+                                   guint max_wait_ms,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data)
+{
+    SimReadyContext *ctx;
+
+    ctx = g_slice_new0 (SimReadyContext);
+    ctx->self = g_object_ref (self);
+    ctx->result = g_simple_async_result_new (G_OBJECT (self),
+                                             callback,
+                                             user_data,
+                                             mm_broadband_modem_wait_sim_ready);
+    ctx->indicator = indicator;
+    ctx->start = mm_clock_get_time ();
+    ctx->poll_ms = SIM_READY_POLL_FIRST_MS;
+
+    /* A previous wait which didn't finish yet just completes right away */
+    if (self->priv->sim_ready_ctx)
+        sim_ready_context_complete (self->priv->sim_ready_ctx, "wait superseded");
+    self->priv->sim_ready_ctx = ctx;
+
+    /* The fixed wait used before is now just the upper bound */
+    ctx->deadline_id = mm_clock_timeout_add (max_wait_ms, (GSourceFunc) sim_ready_deadline_cb, ctx);
+
+    if (indicator == MM_BROADBAND_MODEM_SIM_READY_INDICATOR_URC)
+        return;
+
+    /* Don't send anything right after the unlock, some devices don't like it */
+    ctx->poll_id = mm_clock_timeout_add (MIN (ctx->poll_ms, max_wait_ms), (GSourceFunc) sim_ready_poll_cb, ctx);
+    ctx->poll_ms = MIN (ctx->poll_ms * 2, SIM_READY_POLL_MAX_MS);
+}
+
+void
+mm_broadband_modem_notify_sim_ready (MMBroadbandModem *self)
+{
+    if (self->priv->sim_ready_ctx)
+        sim_ready_context_complete (self->priv->sim_ready_ctx, "ready indication received");
+}
+
+/*****************************************************************************/
+
 MMBroadbandModem *
 mm_broadband_modem_new (const gchar *device,
                         const gchar **drivers,
@@ -10364,6 +12189,8 @@ set_property (GObject *object,
     case PROP_MODEM_SIM:
         g_clear_object (&self->priv->modem_sim);
         self->priv->modem_sim = g_value_dup_object (value);
+        /* Contexts may be stored in the SIM */
+        mm_broadband_modem_invalidate_pdp_contexts (self);
         break;
     case PROP_MODEM_BEARER_LIST:
         g_clear_object (&self->priv->modem_bearer_list);
@@ -10420,6 +12247,12 @@ set_property (GObject *object,
     case PROP_MODEM_SIM_HOT_SWAP_SUPPORTED:
         self->priv->sim_hot_swap_supported = g_value_get_boolean (value);
         break;
+    case PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED:
+        self->priv->periodic_signal_check_disabled = g_value_get_boolean (value);
+        break;
+    case PROP_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED:
+        self->priv->periodic_registration_check_disabled = g_value_get_boolean (value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -10525,6 +12358,12 @@ get_property (GObject *object,
     case PROP_MODEM_SIM_HOT_SWAP_SUPPORTED:
         g_value_set_boolean (value, self->priv->sim_hot_swap_supported);
         break;
+    case PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED:
+        g_value_set_boolean (value, self->priv->periodic_signal_check_disabled);
+        break;
+    case PROP_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED:
+        g_value_set_boolean (value, self->priv->periodic_registration_check_disabled);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -10539,7 +12378,6 @@ mm_broadband_modem_init (MMBroadbandModem *self)
                                               MM_TYPE_BROADBAND_MODEM,
                                               MMBroadbandModemPrivate);
     self->priv->modem_state = MM_MODEM_STATE_UNKNOWN;
-    self->priv->modem_3gpp_registration_regex = mm_3gpp_creg_regex_get (TRUE);
     self->priv->modem_current_charset = MM_MODEM_CHARSET_UNKNOWN;
     self->priv->modem_3gpp_registration_state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     self->priv->modem_3gpp_cs_network_supported = TRUE;
@@ -10552,8 +12390,11 @@ mm_broadband_modem_init (MMBroadbandModem *self)
     self->priv->modem_cdma_evdo_network_supported = TRUE;
     self->priv->modem_messaging_sms_default_storage = MM_SMS_STORAGE_UNKNOWN;
     self->priv->current_sms_mem1_storage = MM_SMS_STORAGE_UNKNOWN;
+    self->priv->mem1_storage_used = -1;
     self->priv->current_sms_mem2_storage = MM_SMS_STORAGE_UNKNOWN;
     self->priv->sim_hot_swap_supported = FALSE;
+    self->priv->periodic_signal_check_disabled = FALSE;
+    self->priv->periodic_registration_check_disabled = FALSE;
 }
 
 static void
@@ -10564,8 +12405,16 @@ finalize (GObject *object)
     if (self->priv->enabled_ports_ctx)
         ports_context_unref (self->priv->enabled_ports_ctx);
 
-    if (self->priv->modem_3gpp_registration_regex)
-        mm_3gpp_creg_regex_destroy (self->priv->modem_3gpp_registration_regex);
+    if (self->priv->cmti_batch_id)
+        g_source_remove (self->priv->cmti_batch_id);
+    if (self->priv->cmti_pending)
+        g_array_unref (self->priv->cmti_pending);
+
+    if (self->priv->qcdm_snapshot)
+        qcdm_snapshot_unref (self->priv->qcdm_snapshot);
+
+    mm_sms_cache_free (self->priv->sms_cache);
+    mm_3gpp_pdp_context_list_free (self->priv->pdp_contexts);
 
     G_OBJECT_CLASS (mm_broadband_modem_parent_class)->finalize (object);
 }
@@ -10820,6 +12669,8 @@ iface_modem_messaging_init (MMIfaceModemMessaging *iface)
     iface->create_sms = modem_messaging_create_sms;
     iface->init_current_storages = modem_messaging_init_current_storages;
     iface->init_current_storages_finish = modem_messaging_init_current_storages_finish;
+    iface->delete_all_sms_parts = modem_messaging_delete_all_sms_parts;
+    iface->delete_all_sms_parts_finish = modem_messaging_delete_all_sms_parts_finish;
 }
 
 static void
@@ -10834,6 +12685,8 @@ iface_modem_voice_init (MMIfaceModemVoice *iface)
     iface->cleanup_unsolicited_events = modem_voice_cleanup_unsolicited_events;
     iface->cleanup_unsolicited_events_finish = modem_voice_setup_cleanup_unsolicited_events_finish;
     iface->create_call = modem_voice_create_call;
+    iface->load_call_list = modem_voice_load_call_list;
+    iface->load_call_list_finish = modem_voice_load_call_list_finish;
 }
 
 static void
@@ -10845,6 +12698,14 @@ iface_modem_time_init (MMIfaceModemTime *iface)
     iface->load_network_time_finish = modem_time_load_network_time_finish;
     iface->load_network_timezone = modem_time_load_network_timezone;
     iface->load_network_timezone_finish = modem_time_load_network_timezone_finish;
+    iface->setup_unsolicited_events = modem_time_setup_unsolicited_events;
+    iface->setup_unsolicited_events_finish = modem_time_setup_cleanup_unsolicited_events_finish;
+    iface->cleanup_unsolicited_events = modem_time_cleanup_unsolicited_events;
+    iface->cleanup_unsolicited_events_finish = modem_time_setup_cleanup_unsolicited_events_finish;
+    iface->enable_unsolicited_events = modem_time_enable_unsolicited_events;
+    iface->enable_unsolicited_events_finish = modem_time_enable_unsolicited_events_finish;
+    iface->disable_unsolicited_events = modem_time_disable_unsolicited_events;
+    iface->disable_unsolicited_events_finish = modem_time_disable_unsolicited_events_finish;
 }
 
 static void
@@ -11012,4 +12873,12 @@ mm_broadband_modem_class_init (MMBroadbandModemClass *klass)
     g_object_class_override_property (object_class,
                                       PROP_MODEM_SIM_HOT_SWAP_SUPPORTED,
                                       MM_IFACE_MODEM_SIM_HOT_SWAP_SUPPORTED);
+
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED,
+                                      MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED);
+
+    g_object_class_override_property (object_class,
+                                      PROP_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED,
+                                      MM_IFACE_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED);
 }
@@ -124,10 +124,54 @@ void     mm_broadband_modem_lock_sms_storages        (MMBroadbandModem *self,
 gboolean mm_broadband_modem_lock_sms_storages_finish (MMBroadbandModem *self,
                                                       GAsyncResult *res,
                                                       GError **error);
+/* Drops a deleted SMS part from the cached copies of the storages */
+void     mm_broadband_modem_forget_sms_part          (MMBroadbandModem *self,
+                                                      MMSmsStorage storage,
+                                                      guint index);
 void     mm_broadband_modem_unlock_sms_storages      (MMBroadbandModem *self,
                                                       gboolean mem1,
                                                       gboolean mem2);
 /* Helper to update SIM hot swap */
 void mm_broadband_modem_update_sim_hot_swap_detected (MMBroadbandModem *self);
 
+/* Cache of the PDP contexts defined in the device, so that bearers don't need
+ * to list them with +CGDCONT? on every connection attempt. The cache is
+ * dropped when the SIM changes; whoever writes a context with +CGDCONT must
+ * either update or invalidate it. */
+gboolean mm_broadband_modem_peek_pdp_contexts       (MMBroadbandModem *self,
+                                                     GList **out_pdp_list);
+void     mm_broadband_modem_set_pdp_contexts        (MMBroadbandModem *self,
+                                                     GList *pdp_list);
+void     mm_broadband_modem_update_pdp_context      (MMBroadbandModem *self,
+                                                     guint cid,
+                                                     MMBearerIpFamily pdp_type,
+                                                     const gchar *apn);
+void     mm_broadband_modem_invalidate_pdp_contexts (MMBroadbandModem *self);
+
+/* Waiting for the SIM to be ready after unlocking it, instead of a fixed
+ * sleep: the indicator given by the plugin is polled with a short backoff,
+ * and vendor specific SIM ready indications reported with notify_sim_ready()
+ * complete the wait right away. The wait never fails; once max_wait_ms elapse
+ * it completes anyway. */
+typedef enum {
+    /* +CPMS? succeeds, i.e. the SIM file system can be read. The default, as
+     * +CPIN? replying READY only tells the SIM is unlocked. */
+    MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPMS,
+    /* +CPIN? replies READY, for devices only waiting for the PIN to settle */
+    MM_BROADBAND_MODEM_SIM_READY_INDICATOR_CPIN,
+    /* Nothing is polled, only a vendor indication ends the wait early, for
+     * devices which may misbehave when sent commands too early */
+    MM_BROADBAND_MODEM_SIM_READY_INDICATOR_URC,
+} MMBroadbandModemSimReadyIndicator;
+
+void     mm_broadband_modem_wait_sim_ready        (MMBroadbandModem *self,
+                                                   MMBroadbandModemSimReadyIndicator indicator,
+                                                   guint max_wait_ms,
+                                                   GAsyncReadyCallback callback,
+                                                   gpointer user_data);
+gboolean mm_broadband_modem_wait_sim_ready_finish (MMBroadbandModem *self,
+                                                   GAsyncResult *res,
+                                                   GError **error);
+void     mm_broadband_modem_notify_sim_ready      (MMBroadbandModem *self);
+
 #endif /* MM_BROADBAND_MODEM_H */
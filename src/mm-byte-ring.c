@@ -0,0 +1,207 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-byte-ring.h"
+
+struct _MMByteRing {
+    guint8 *data;
+    guint   size;
+
+    /* Free-running byte counters, only written by the producer and by the
+     * consumer respectively */
+    gint    head;
+    gint    tail;
+    gint    closed;
+    gint    flush_waiters;
+
+    /* Only used to sleep and wake up, the data itself is lock-free */
+    GMutex  mutex;
+    GCond   readable;
+    GCond   drained;
+};
+
+MMByteRing *
+mm_byte_ring_new (gsize size)
+{
+    MMByteRing *self;
+
+    g_return_val_if_fail (size > 0 && (size & (size - 1)) == 0, NULL);
+    g_return_val_if_fail (size <= G_MAXINT, NULL);
+
+    self = g_slice_new0 (MMByteRing);
+    self->data = g_malloc (size);
+    self->size = (guint) size;
+    g_mutex_init (&self->mutex);
+    g_cond_init (&self->readable);
+    g_cond_init (&self->drained);
+    return self;
+}
+
+void
+mm_byte_ring_free (MMByteRing *self)
+{
+    if (!self)
+        return;
+
+    g_cond_clear (&self->drained);
+    g_cond_clear (&self->readable);
+    g_mutex_clear (&self->mutex);
+    g_free (self->data);
+    g_slice_free (MMByteRing, self);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_byte_ring_push (MMByteRing   *self,
+                   const guint8 *data,
+                   gsize         len)
+{
+    guint head;
+    guint tail;
+    guint offset;
+
+    head = (guint) self->head;
+    tail = (guint) g_atomic_int_get (&self->tail);
+    if (len > self->size - (head - tail))
+        return FALSE;
+    if (len == 0)
+        return TRUE;
+
+    offset = head & (self->size - 1);
+    if (offset + len > self->size) {
+        memcpy (self->data + offset, data, self->size - offset);
+        memcpy (self->data, data + (self->size - offset), len - (self->size - offset));
+    } else
+        memcpy (self->data + offset, data, len);
+
+    /* Publish only once fully written */
+    g_atomic_int_set (&self->head, (gint) (head + len));
+
+    /* If everything pushed before was already released, the consumer may be
+     * going to sleep. It reads the head after releasing, and the atomic
+     * operations are full barriers, so either it sees this push or this
+     * check sees its release and wakes it up. */
+    if ((guint) g_atomic_int_get (&self->tail) == head) {
+        g_mutex_lock (&self->mutex);
+        g_cond_signal (&self->readable);
+        g_mutex_unlock (&self->mutex);
+    }
+    return TRUE;
+}
+
+static gboolean
+flushed (MMByteRing *self,
+         guint       target)
+{
+    /* The tail may already be past the target if more was pushed */
+    return (gint) ((guint) g_atomic_int_get (&self->tail) - target) >= 0;
+}
+
+gboolean
+mm_byte_ring_flush (MMByteRing *self,
+                    gint64      end_time)
+{
+    guint target;
+    gboolean done;
+
+    target = (guint) g_atomic_int_get (&self->head);
+
+    g_mutex_lock (&self->mutex);
+    g_atomic_int_inc (&self->flush_waiters);
+    while (!(done = flushed (self, target))) {
+        if (!g_cond_wait_until (&self->drained, &self->mutex, end_time)) {
+            done = flushed (self, target);
+            break;
+        }
+    }
+    g_atomic_int_add (&self->flush_waiters, -1);
+    g_mutex_unlock (&self->mutex);
+    return done;
+}
+
+void
+mm_byte_ring_close (MMByteRing *self)
+{
+    g_mutex_lock (&self->mutex);
+    g_atomic_int_set (&self->closed, TRUE);
+    g_cond_signal (&self->readable);
+    g_mutex_unlock (&self->mutex);
+}
+
+/*****************************************************************************/
+
+static gboolean
+readable (MMByteRing *self)
+{
+    return (guint) g_atomic_int_get (&self->head) != (guint) self->tail;
+}
+
+gboolean
+mm_byte_ring_wait (MMByteRing *self,
+                   gint64      end_time)
+{
+    gboolean ready;
+
+    g_mutex_lock (&self->mutex);
+    while (!(ready = readable (self)) && !g_atomic_int_get (&self->closed)) {
+        if (end_time < 0)
+            g_cond_wait (&self->readable, &self->mutex);
+        else if (!g_cond_wait_until (&self->readable, &self->mutex, end_time)) {
+            ready = readable (self);
+            break;
+        }
+    }
+    g_mutex_unlock (&self->mutex);
+    return ready;
+}
+
+gboolean
+mm_byte_ring_is_closed (MMByteRing *self)
+{
+    return g_atomic_int_get (&self->closed);
+}
+
+gsize
+mm_byte_ring_peek (MMByteRing    *self,
+                   const guint8 **data)
+{
+    guint head;
+    guint tail;
+    guint offset;
+
+    head = (guint) g_atomic_int_get (&self->head);
+    tail = (guint) self->tail;
+    offset = tail & (self->size - 1);
+
+    *data = self->data + offset;
+    return MIN (head - tail, self->size - offset);
+}
+
+void
+mm_byte_ring_release (MMByteRing *self,
+                      gsize       len)
+{
+    /* Release the space only once the data was used */
+    g_atomic_int_set (&self->tail, (gint) ((guint) self->tail + len));
+
+    if (g_atomic_int_get (&self->flush_waiters) > 0) {
+        g_mutex_lock (&self->mutex);
+        g_cond_broadcast (&self->drained);
+        g_mutex_unlock (&self->mutex);
+    }
+}
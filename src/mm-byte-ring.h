@@ -0,0 +1,61 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_BYTE_RING_H
+#define MM_BYTE_RING_H
+
+#include <glib.h>
+
+/*
+ * Ring of bytes passed from a producer thread to a consumer thread, e.g. log
+ * lines drained into a file by a writer thread.
+ *
+ * Pushing never blocks: data that doesn't fit is refused as a whole, and the
+ * caller decides what to do with it. The consumer sleeps until there is
+ * something to read, woken up by the producer when the ring goes from empty
+ * to non-empty, or when the ring is closed. Only one thread may push at a
+ * time; several producers must serialize the pushes themselves.
+ */
+typedef struct _MMByteRing MMByteRing;
+
+/* The size must be a power of two */
+MMByteRing *mm_byte_ring_new       (gsize size);
+void        mm_byte_ring_free      (MMByteRing *self);
+
+/* Producer side */
+gboolean    mm_byte_ring_push      (MMByteRing   *self,
+                                    const guint8 *data,
+                                    gsize         len);
+/* Waits until the consumer released everything pushed so far, or until the
+ * given monotonic time; FALSE if it didn't */
+gboolean    mm_byte_ring_flush     (MMByteRing   *self,
+                                    gint64        end_time);
+/* Wakes up the consumer for good; what was pushed before can still be read */
+void        mm_byte_ring_close     (MMByteRing   *self);
+
+/* Consumer side. Waits until there is something to read, the ring is closed
+ * or the given monotonic time (-1 for none) is reached; TRUE if there is
+ * something to read. */
+gboolean    mm_byte_ring_wait      (MMByteRing   *self,
+                                    gint64        end_time);
+gboolean    mm_byte_ring_is_closed (MMByteRing   *self);
+/* Contiguous bytes readable at the tail; data going around the end of the
+ * ring is got with a second peek after releasing the first part */
+gsize       mm_byte_ring_peek      (MMByteRing    *self,
+                                    const guint8 **data);
+void        mm_byte_ring_release   (MMByteRing   *self,
+                                    gsize         len);
+
+#endif /* MM_BYTE_RING_H */
@@ -50,6 +50,8 @@ struct _MMCallListPrivate {
     MMBaseModem *modem;
     /* List of call objects */
     GList *list;
+    /* Calls by their index in the modem, not owned */
+    GHashTable *index;
 };
 
 /*****************************************************************************/
@@ -189,6 +191,41 @@ MMBaseCall* mm_call_list_get_first_non_terminated_call(MMCallList *self)
     return call;
 }
 
+MMBaseCall *
+mm_call_list_get_call_by_index (MMCallList *self,
+                                guint index)
+{
+    return g_hash_table_lookup (self->priv->index, GUINT_TO_POINTER (index));
+}
+
+void
+mm_call_list_set_call_index (MMCallList *self,
+                             MMBaseCall *call,
+                             guint index)
+{
+    guint old_index;
+
+    old_index = mm_base_call_get_index (call);
+    if (old_index == index)
+        return;
+
+    if (old_index &&
+        g_hash_table_lookup (self->priv->index, GUINT_TO_POINTER (old_index)) == call)
+        g_hash_table_remove (self->priv->index, GUINT_TO_POINTER (old_index));
+
+    mm_base_call_set_index (call, index);
+    if (index)
+        g_hash_table_replace (self->priv->index, GUINT_TO_POINTER (index), call);
+}
+
+void
+mm_call_list_foreach (MMCallList *self,
+                      MMCallListForeachFunc func,
+                      gpointer user_data)
+{
+    g_list_foreach (self->priv->list, (GFunc)func, user_data);
+}
+
 gboolean mm_call_list_send_dtmf_to_active_calls(MMCallList *self, gchar *dtmf)
 {
     gboolean signaled = FALSE;
@@ -265,6 +302,7 @@ delete_ready (MMBaseCall *call,
                             ctx->path,
                             (GCompareFunc)cmp_call_by_path);
     if (l) {
+        mm_call_list_set_call_index (ctx->self, MM_BASE_CALL (l->data), 0);
         g_object_unref (MM_BASE_CALL (l->data));
         ctx->self->priv->list = g_list_delete_link (ctx->self->priv->list, l);
     }
@@ -386,6 +424,7 @@ mm_call_list_init (MMCallList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_CALL_LIST,
                                               MMCallListPrivate);
+    self->priv->index = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 static void
@@ -394,6 +433,7 @@ dispose (GObject *object)
     MMCallList *self = MM_CALL_LIST (object);
 
     g_clear_object (&self->priv->modem);
+    g_clear_pointer (&self->priv->index, g_hash_table_unref);
     g_list_free_full (self->priv->list, (GDestroyNotify)g_object_unref);
 
     G_OBJECT_CLASS (mm_call_list_parent_class)->dispose (object);
@@ -79,4 +79,17 @@ MMBaseCall* mm_call_list_get_first_non_terminated_call  (MMCallList *self);
 gboolean    mm_call_list_send_dtmf_to_active_calls      (MMCallList *self,
                                                          gchar *dtmf);
 
+/* Calls known by their index in the modem */
+MMBaseCall *mm_call_list_get_call_by_index (MMCallList *self,
+                                            guint index);
+void        mm_call_list_set_call_index    (MMCallList *self,
+                                            MMBaseCall *call,
+                                            guint index);
+
+typedef void (*MMCallListForeachFunc) (MMBaseCall *call,
+                                       gpointer user_data);
+void        mm_call_list_foreach           (MMCallList *self,
+                                            MMCallListForeachFunc func,
+                                            gpointer user_data);
+
 #endif /* MM_CALL_LIST_H */
@@ -79,8 +79,8 @@ mm_modem_charset_from_string (const char *string)
     return MM_MODEM_CHARSET_UNKNOWN;
 }
 
-static const char *
-charset_iconv_to (MMModemCharset charset)
+static const CharsetEntry *
+charset_entry_lookup (MMModemCharset charset)
 {
     CharsetEntry *iter = &charset_map[0];
 
@@ -88,79 +88,286 @@ charset_iconv_to (MMModemCharset charset)
 
     while (iter->gsm_name) {
         if (iter->charset == charset)
-            return iter->iconv_to_name;
+            return iter;
         iter++;
     }
     g_warn_if_reached ();
     return NULL;
 }
 
-static const char *
-charset_iconv_from (MMModemCharset charset)
+/*****************************************************************************/
+/* Cached iconv converters
+ *
+ * Opening an iconv descriptor loads and sets up the conversion tables, which
+ * is much more expensive than the conversion of the short strings we usually
+ * get. So, instead of g_convert(), the descriptors are opened once for each
+ * charset and kept for the whole lifetime of the process. */
+
+typedef enum {
+    CONVERTER_TO_UTF8,
+    CONVERTER_FROM_UTF8,
+    CONVERTER_FROM_UTF8_TRANSLIT,
+    N_CONVERTERS
+} ConverterType;
+
+static GIConv converters[G_N_ELEMENTS (charset_map)][N_CONVERTERS];
+
+static gchar *
+charset_convert (const gchar *str,
+                 gssize len,
+                 MMModemCharset charset,
+                 ConverterType type,
+                 gsize *out_len,
+                 GError **error)
 {
-    CharsetEntry *iter = &charset_map[0];
+    const CharsetEntry *entry;
+    const gchar *to = NULL;
+    const gchar *from = NULL;
+    GIConv *converter;
 
-    g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
+    entry = charset_entry_lookup (charset);
+    if (!entry)
+        return NULL;
 
-    while (iter->gsm_name) {
-        if (iter->charset == charset)
-            return iter->iconv_from_name;
-        iter++;
+    switch (type) {
+    case CONVERTER_TO_UTF8:
+        to = "UTF-8//TRANSLIT";
+        from = entry->iconv_from_name;
+        break;
+    case CONVERTER_FROM_UTF8:
+        to = entry->iconv_from_name;
+        from = "UTF-8";
+        break;
+    case CONVERTER_FROM_UTF8_TRANSLIT:
+        to = entry->iconv_to_name;
+        from = "UTF-8";
+        break;
+    default:
+        g_assert_not_reached ();
     }
-    g_warn_if_reached ();
-    return NULL;
+
+    if (!to || !from) {
+        g_set_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_NO_CONVERSION,
+                     "No iconv conversion available for the %s character set",
+                     entry->gsm_name);
+        return NULL;
+    }
+
+    converter = &converters[entry - charset_map][type];
+    if (!*converter) {
+        *converter = g_iconv_open (to, from);
+        if (*converter == (GIConv) -1)
+            mm_warn ("couldn't open converter from %s to %s", from, to);
+    }
+
+    if (*converter == (GIConv) -1) {
+        g_set_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_NO_CONVERSION,
+                     "Conversion from character set '%s' to '%s' is not supported",
+                     from, to);
+        return NULL;
+    }
+
+    /* Make sure no state is left from a previous failed conversion */
+    g_iconv (*converter, NULL, NULL, NULL, NULL);
+    return g_convert_with_iconv (str, len, *converter, NULL, out_len, error);
 }
 
+/*****************************************************************************/
+/* UCS-2 fast paths
+ *
+ * Surrogates and characters out of the BMP can't be represented in UCS-2; the
+ * fast paths leave those strings to iconv, which handles them as before. */
+
+static const gchar hex_digits[] = "0123456789ABCDEF";
+
+static gchar *
+ucs2_hex_to_utf8 (const gchar *hex,
+                  gboolean *handled)
+{
+    GString *utf8;
+    gsize len;
+    gsize i;
+
+    *handled = FALSE;
+
+    len = strlen (hex);
+    if (len % 4)
+        return NULL;
+
+    /* Worst case, 3 UTF-8 bytes for each 4 hex digits */
+    utf8 = g_string_sized_new ((len / 4) * 3 + 1);
+    for (i = 0; i < len; i += 4) {
+        gint high, low;
+        gunichar c;
+        gchar buf[6];
+
+        high = mm_utils_hex2byte (&hex[i]);
+        low = mm_utils_hex2byte (&hex[i + 2]);
+        if (high < 0 || low < 0) {
+            /* Not valid hex, nothing iconv can do */
+            *handled = TRUE;
+            g_string_free (utf8, TRUE);
+            return NULL;
+        }
+
+        c = (high << 8) | low;
+        if (c >= 0xD800 && c <= 0xDFFF) {
+            g_string_free (utf8, TRUE);
+            return NULL;
+        }
+
+        g_string_append_len (utf8, buf, g_unichar_to_utf8 (c, buf));
+    }
+
+    *handled = TRUE;
+    return g_string_free (utf8, FALSE);
+}
+
+static gboolean
+utf8_is_bmp (const gchar *utf8)
+{
+    const gchar *p;
+
+    if (!g_utf8_validate (utf8, -1, NULL))
+        return FALSE;
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        if (g_utf8_get_char (p) > 0xFFFF)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gchar *
+utf8_to_ucs2_hex (const gchar *utf8)
+{
+    GString *hex;
+    const gchar *p;
+
+    hex = g_string_sized_new (g_utf8_strlen (utf8, -1) * 4 + 1);
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        gunichar c;
+
+        c = g_utf8_get_char (p);
+        g_string_append_c (hex, hex_digits[(c >> 12) & 0x0F]);
+        g_string_append_c (hex, hex_digits[(c >> 8) & 0x0F]);
+        g_string_append_c (hex, hex_digits[(c >> 4) & 0x0F]);
+        g_string_append_c (hex, hex_digits[c & 0x0F]);
+    }
+    return g_string_free (hex, FALSE);
+}
+
+static void
+utf8_append_ucs2 (GByteArray *array,
+                  const gchar *utf8)
+{
+    const gchar *p;
+
+    for (p = utf8; *p; p = g_utf8_next_char (p)) {
+        gunichar c;
+        guint8 ucs2[2];
+
+        c = g_utf8_get_char (p);
+        ucs2[0] = (c >> 8) & 0xFF;
+        ucs2[1] = c & 0xFF;
+        g_byte_array_append (array, ucs2, 2);
+    }
+}
+
+static gboolean
+utf8_is_ascii (const gchar *utf8)
+{
+    const gchar *p;
+
+    for (p = utf8; *p; p++) {
+        if ((guchar) *p > 0x7F)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static gchar *gsm_hex_to_utf8 (const gchar *hex);
+
+/*****************************************************************************/
+
 gboolean
 mm_modem_charset_byte_array_append (GByteArray *array,
                                     const char *utf8,
                                     gboolean quoted,
                                     MMModemCharset charset)
 {
-    const char *iconv_to;
-    char *converted;
+    char *converted = NULL;
     GError *error = NULL;
     gsize written = 0;
 
     g_return_val_if_fail (array != NULL, FALSE);
     g_return_val_if_fail (utf8 != NULL, FALSE);
+    g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, FALSE);
 
-    iconv_to = charset_iconv_to (charset);
-    g_return_val_if_fail (iconv_to != NULL, FALSE);
+    if (quoted)
+        g_byte_array_append (array, (const guint8 *) "\"", 1);
 
-    converted = g_convert (utf8, -1, iconv_to, "UTF-8", NULL, &written, &error);
-    if (!converted) {
-        if (error) {
-            mm_warn ("failed to convert '%s' to %s character set: (%d) %s",
-                     utf8, iconv_to, error->code, error->message);
-            g_error_free (error);
+    /* Strings which don't need any actual conversion are appended as they
+     * are, and UCS-2 is encoded right into the array */
+    if ((charset == MM_MODEM_CHARSET_UTF8 && g_utf8_validate (utf8, -1, NULL)) ||
+        (charset == MM_MODEM_CHARSET_IRA && utf8_is_ascii (utf8)))
+        g_byte_array_append (array, (const guint8 *) utf8, strlen (utf8));
+    else if (charset == MM_MODEM_CHARSET_UCS2 && utf8_is_bmp (utf8))
+        utf8_append_ucs2 (array, utf8);
+    else if (charset == MM_MODEM_CHARSET_GSM) {
+        guint32 len = 0;
+
+        if (g_utf8_validate (utf8, -1, NULL))
+            converted = (gchar *) mm_charset_utf8_to_unpacked_gsm (utf8, &len);
+        if (!converted) {
+            mm_warn ("failed to convert '%s' to GSM character set", utf8);
+            goto failed;
         }
-        return FALSE;
+        g_byte_array_append (array, (const guint8 *) converted, len);
+    } else {
+        converted = charset_convert (utf8, -1, charset, CONVERTER_FROM_UTF8_TRANSLIT, &written, &error);
+        if (!converted) {
+            if (error) {
+                mm_warn ("failed to convert '%s' to %s character set: (%d) %s",
+                         utf8, mm_modem_charset_to_string (charset), error->code, error->message);
+                g_error_free (error);
+            }
+            goto failed;
+        }
+        g_byte_array_append (array, (const guint8 *) converted, written);
     }
 
-    if (quoted)
-        g_byte_array_append (array, (const guint8 *) "\"", 1);
-    g_byte_array_append (array, (const guint8 *) converted, written);
     if (quoted)
         g_byte_array_append (array, (const guint8 *) "\"", 1);
 
     g_free (converted);
     return TRUE;
+
+failed:
+    /* Remove the opening quote */
+    if (quoted)
+        g_byte_array_set_size (array, array->len - 1);
+    return FALSE;
 }
 
 char *
 mm_modem_charset_hex_to_utf8 (const char *src, MMModemCharset charset)
 {
     char *unconverted, *converted;
-    const char *iconv_from;
     gsize unconverted_len = 0;
     GError *error = NULL;
 
     g_return_val_if_fail (src != NULL, NULL);
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
-    iconv_from = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_from != NULL, FALSE);
+    if (charset == MM_MODEM_CHARSET_UCS2) {
+        gboolean handled;
+
+        converted = ucs2_hex_to_utf8 (src, &handled);
+        if (handled)
+            return converted;
+    } else if (charset == MM_MODEM_CHARSET_GSM)
+        return gsm_hex_to_utf8 (src);
 
     unconverted = mm_utils_hexstr2bin (src, &unconverted_len);
     if (!unconverted)
@@ -169,9 +376,9 @@ mm_modem_charset_hex_to_utf8 (const char *src, MMModemCharset charset)
     if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
         return unconverted;
 
-    converted = g_convert (unconverted, unconverted_len,
-                           "UTF-8//TRANSLIT", iconv_from,
-                           NULL, NULL, &error);
+    converted = charset_convert (unconverted, unconverted_len,
+                                 charset, CONVERTER_TO_UTF8,
+                                 NULL, &error);
     if (!converted || error) {
         g_clear_error (&error);
         converted = NULL;
@@ -187,22 +394,21 @@ mm_modem_charset_utf8_to_hex (const char *src, MMModemCharset charset)
 {
     gsize converted_len = 0;
     char *converted;
-    const char *iconv_to;
     GError *error = NULL;
     gchar *hex;
 
     g_return_val_if_fail (src != NULL, NULL);
     g_return_val_if_fail (charset != MM_MODEM_CHARSET_UNKNOWN, NULL);
 
-    iconv_to = charset_iconv_from (charset);
-    g_return_val_if_fail (iconv_to != NULL, FALSE);
-
     if (charset == MM_MODEM_CHARSET_UTF8 || charset == MM_MODEM_CHARSET_IRA)
         return g_strdup (src);
 
-    converted = g_convert (src, strlen (src),
-                           iconv_to, "UTF-8//TRANSLIT",
-                           NULL, &converted_len, &error);
+    if (charset == MM_MODEM_CHARSET_UCS2 && utf8_is_bmp (src))
+        return utf8_to_ucs2_hex (src);
+
+    converted = charset_convert (src, strlen (src),
+                                 charset, CONVERTER_FROM_UTF8,
+                                 &converted_len, &error);
     if (!converted || error) {
         g_clear_error (&error);
         g_free (converted);
@@ -419,6 +625,73 @@ mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len)
     return g_byte_array_free (utf8, FALSE);
 }
 
+/* Same as mm_charset_gsm_unpacked_to_utf8(), reading the unpacked GSM
+ * characters right from their hex representation */
+static gchar *
+gsm_hex_to_utf8 (const gchar *hex)
+{
+    GString *utf8;
+    gsize len;
+    gsize i;
+
+    len = strlen (hex);
+    if (len % 2)
+        return NULL;
+
+    /* worst case initial length */
+    utf8 = g_string_sized_new (len + 1);
+
+    for (i = 0; i < len; i += 2) {
+        guint8 uchars[4];
+        guint8 ulen;
+        gint c;
+
+        c = mm_utils_hex2byte (&hex[i]);
+        if (c < 0) {
+            g_string_free (utf8, TRUE);
+            return NULL;
+        }
+
+        if (c == GSM_ESCAPE_CHAR) {
+            gint next = 0;
+
+            /* Extended alphabet, decode next char */
+            if (i + 2 < len && (next = mm_utils_hex2byte (&hex[i + 2])) < 0) {
+                g_string_free (utf8, TRUE);
+                return NULL;
+            }
+            ulen = gsm_ext_char_to_utf8 ((guint8) next, uchars);
+            if (ulen)
+                i += 2;
+        } else {
+            /* Default alphabet */
+            ulen = gsm_def_char_to_utf8 ((guint8) c, uchars);
+        }
+
+        if (ulen)
+            g_string_append_len (utf8, (const gchar *) uchars, ulen);
+        else
+            g_string_append_c (utf8, '?');
+    }
+
+    return g_string_free (utf8, FALSE);
+}
+
+guint
+mm_charset_utf8_char_to_gsm (const gchar *utf8,
+                             gsize len,
+                             guint8 out_gsm[2])
+{
+    /* Try escaped chars first, then default alphabet */
+    if (utf8_to_gsm_ext_char (utf8, len, &out_gsm[1])) {
+        out_gsm[0] = GSM_ESCAPE_CHAR;
+        return 2;
+    }
+    if (utf8_to_gsm_def_char (utf8, len, &out_gsm[0]))
+        return 1;
+    return 0;
+}
+
 guint8 *
 mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len)
 {
@@ -636,40 +909,136 @@ mm_charset_get_encoded_len (const char *utf8,
     return len;
 }
 
+/* Septets are handled in blocks of 8, which fill exactly 7 octets, so every
+ * block starts at the same bit offset within its first octet. Each block is
+ * loaded into (or built in) a 64-bit word, so that no per-septet bit
+ * arithmetic across octet boundaries is needed. */
+#define SEPTETS_PER_BLOCK 8
+#define OCTETS_PER_BLOCK  7
+
+static inline guint8
+unpack_septet (const guint8 *gsm,
+               guint32 start_bit)
+{
+    guint8 offset;
+    guint8 c;
+
+    offset = start_bit % 8;
+    c = gsm[start_bit / 8] >> offset;
+    /* Grab any bits that spilled over to next byte */
+    if (offset > 1)
+        c |= gsm[(start_bit / 8) + 1] << (8 - offset);
+    return c & 0x7F;
+}
+
+void
+gsm_unpack_buffer (const guint8 *gsm,
+                   guint32 num_septets,
+                   guint8 start_offset,  /* in _bits_ */
+                   guint8 *out)
+{
+    guint32 i = 0;
+    guint8 offset;
+    guint n_octets;
+
+    gsm += start_offset / 8;
+    offset = start_offset % 8;
+    /* The octets holding the 56 bits of a block, given the initial offset */
+    n_octets = offset ? OCTETS_PER_BLOCK + 1 : OCTETS_PER_BLOCK;
+
+    for (; i + SEPTETS_PER_BLOCK <= num_septets; i += SEPTETS_PER_BLOCK) {
+        guint64 block = 0;
+        guint j;
+
+        for (j = 0; j < n_octets; j++)
+            block |= ((guint64) gsm[j]) << (8 * j);
+        block >>= offset;
+
+        for (j = 0; j < SEPTETS_PER_BLOCK; j++)
+            out[i + j] = (block >> (7 * j)) & 0x7F;
+
+        gsm += OCTETS_PER_BLOCK;
+    }
+
+    /* Remaining septets, less than a block */
+    for (; i < num_septets; i++)
+        out[i] = unpack_septet (gsm, offset + ((i % SEPTETS_PER_BLOCK) * 7));
+}
+
 guint8 *
 gsm_unpack (const guint8 *gsm,
             guint32 num_septets,
             guint8 start_offset,  /* in _bits_ */
             guint32 *out_unpacked_len)
 {
-    GByteArray *unpacked;
-    int i;
+    guint8 *unpacked;
 
-    unpacked = g_byte_array_sized_new (num_septets + 1);
+    unpacked = g_malloc (num_septets + 1);
+    gsm_unpack_buffer (gsm, num_septets, start_offset, unpacked);
 
-    for (i = 0; i < num_septets; i++) {
-        guint8 bits_here, bits_in_next, octet, offset, c;
-        guint32 start_bit;
+    *out_unpacked_len = num_septets;
+    return unpacked;
+}
 
-        start_bit = start_offset + (i * 7); /* Overall bit offset of char in buffer */
-        offset = start_bit % 8;  /* Offset to start of char in this byte */
-        bits_here = offset ? (8 - offset) : 7;
-        bits_in_next = 7 - bits_here;
+guint32
+gsm_packed_len (guint32 num_septets,
+                guint8 start_offset)
+{
+    return ((num_septets * 7) + start_offset + 7) / 8;
+}
 
-        /* Grab bits in the current byte */
-        octet = gsm[start_bit / 8];
-        c = (octet >> offset) & (0xFF >> (8 - bits_here));
+void
+gsm_pack_buffer (const guint8 *src,
+                 guint32 src_len,
+                 guint8 start_offset,
+                 guint8 *out)
+{
+    guint32 i = 0;
+    guint32 plen;
+    guint n_octets;
+    guint8 *packed;
 
-        /* Grab any bits that spilled over to next byte */
-        if (bits_in_next) {
-            octet = gsm[(start_bit / 8) + 1];
-            c |= (octet & (0xFF >> (8 - bits_in_next))) << bits_here;
-        }
-        g_byte_array_append (unpacked, &c, 1);
+    g_return_if_fail (start_offset < 8);
+
+    plen = gsm_packed_len (src_len, start_offset);
+    memset (out, 0, plen);
+
+    /* The octets receiving the 56 bits of a block, given the initial offset */
+    n_octets = start_offset ? OCTETS_PER_BLOCK + 1 : OCTETS_PER_BLOCK;
+
+    packed = out;
+    for (; i + SEPTETS_PER_BLOCK <= src_len; i += SEPTETS_PER_BLOCK) {
+        guint64 block = 0;
+        guint j;
+
+        for (j = 0; j < SEPTETS_PER_BLOCK; j++)
+            block |= ((guint64) (src[i + j] & 0x7F)) << (7 * j);
+        block <<= start_offset;
+
+        /* The last octet is shared with the next block */
+        for (j = 0; j < n_octets; j++)
+            packed[j] |= (block >> (8 * j)) & 0xFF;
+
+        packed += OCTETS_PER_BLOCK;
     }
 
-    *out_unpacked_len = unpacked->len;
-    return g_byte_array_free (unpacked, FALSE);
+    /* Remaining septets, less than a block */
+    for (; i < src_len; i++) {
+        guint32 start_bit;
+        guint8 offset;
+        guint8 c;
+
+        start_bit = start_offset + ((i % SEPTETS_PER_BLOCK) * 7);
+        offset = start_bit % 8;
+        c = src[i] & 0x7F;
+
+        packed[start_bit / 8] |= c << offset;
+        if (offset > 1) {
+            /* Grab the lost bits and add to next octet */
+            g_assert (&packed[(start_bit / 8) + 1] < out + plen);
+            packed[(start_bit / 8) + 1] |= c >> (8 - offset);
+        }
+    }
 }
 
 guint8 *
@@ -679,29 +1048,14 @@ gsm_pack (const guint8 *src,
           guint32 *out_packed_len)
 {
     guint8 *packed;
-    guint octet = 0, lshift, plen;
-    int i = 0;
+    guint32 plen;
 
     g_return_val_if_fail (start_offset < 8, NULL);
 
-    plen = (src_len * 7) + start_offset; /* total length in bits */
-    if (plen % 8)
-        plen += 8;
-    plen /= 8;  /* now in bytes */
-
-    packed = g_malloc0 (plen);
-
-    for (i = 0, lshift = start_offset; i < src_len; i++) {
-        packed[octet] |= (src[i] & 0x7F) << lshift;
-        if (lshift > 1) {
-            /* Grab the lost bits and add to next octet */
-            g_assert (octet + 1 < plen);
-            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
-        }
-        if (lshift)
-            octet++;
-        lshift = lshift ? lshift - 1 : 7;
-    }
+    plen = gsm_packed_len (src_len, start_offset);
+    packed = g_malloc (plen);
+    if (plen)
+        gsm_pack_buffer (src, src_len, start_offset, packed);
 
     if (out_packed_len)
         *out_packed_len = plen;
@@ -735,13 +1089,11 @@ mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset)
     case MM_MODEM_CHARSET_8859_1:
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
-        const gchar *iconv_from;
         GError *error = NULL;
 
-        iconv_from = charset_iconv_from (charset);
-        utf8 = g_convert (str, strlen (str),
-                          "UTF-8//TRANSLIT", iconv_from,
-                          NULL, NULL, &error);
+        utf8 = charset_convert (str, strlen (str),
+                                charset, CONVERTER_TO_UTF8,
+                                NULL, &error);
         if (!utf8 || error) {
             g_clear_error (&error);
             utf8 = NULL;
@@ -858,13 +1210,11 @@ mm_utf8_take_and_convert_to_charset (gchar *str,
     case MM_MODEM_CHARSET_8859_1:
     case MM_MODEM_CHARSET_PCCP437:
     case MM_MODEM_CHARSET_PCDN: {
-        const gchar *iconv_to;
         GError *error = NULL;
 
-        iconv_to = charset_iconv_from (charset);
-        encoded = g_convert (str, strlen (str),
-                             iconv_to, "UTF-8",
-                             NULL, NULL, &error);
+        encoded = charset_convert (str, strlen (str),
+                                   charset, CONVERTER_FROM_UTF8,
+                                   NULL, &error);
         if (!encoded || error) {
             g_clear_error (&error);
             encoded = NULL;
@@ -874,28 +1224,10 @@ mm_utf8_take_and_convert_to_charset (gchar *str,
         break;
     }
 
-    case MM_MODEM_CHARSET_UCS2: {
-        const gchar *iconv_to;
-        gsize encoded_len = 0;
-        GError *error = NULL;
-        gchar *hex;
-
-        iconv_to = charset_iconv_from (charset);
-        encoded = g_convert (str, strlen (str),
-                             iconv_to, "UTF-8",
-                             NULL, &encoded_len, &error);
-        if (!encoded || error) {
-            g_clear_error (&error);
-            encoded = NULL;
-        }
-
-        /* Get hex representation of the string */
-        hex = mm_utils_bin2hexstr ((guint8 *)encoded, encoded_len);
-        g_free (encoded);
-        encoded = hex;
+    case MM_MODEM_CHARSET_UCS2:
+        encoded = mm_modem_charset_utf8_to_hex (str, charset);
         g_free (str);
         break;
-    }
 
     /* If the given charset is ASCII or UTF8, we really expect the final string
      * already here. */
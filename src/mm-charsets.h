@@ -55,6 +55,13 @@ char *mm_modem_charset_utf8_to_hex (const char *src, MMModemCharset charset);
 
 guint8 *mm_charset_utf8_to_unpacked_gsm (const char *utf8, guint32 *out_len);
 
+/* Writes the unpacked GSM septets for the single UTF-8 character of 'len'
+ * bytes at 'utf8', and returns how many were written: 1, 2 for characters of
+ * the extension table, or 0 if the character isn't in the GSM alphabet. */
+guint mm_charset_utf8_char_to_gsm (const gchar *utf8,
+                                   gsize len,
+                                   guint8 out_gsm[2]);
+
 guint8 *mm_charset_gsm_unpacked_to_utf8 (const guint8 *gsm, guint32 len);
 
 /* Returns the size in bytes required to hold the UTF-8 string in the given charset */
@@ -72,6 +79,22 @@ guint8 *gsm_pack (const guint8 *src,
                   guint8 start_offset,  /* in bits */
                   guint32 *out_packed_len);
 
+/* Same as gsm_unpack() and gsm_pack(), but writing into a caller-supplied
+ * buffer, which must be at least 'num_septets' bytes long when unpacking, and
+ * gsm_packed_len() bytes long when packing. */
+void gsm_unpack_buffer (const guint8 *gsm,
+                        guint32 num_septets,
+                        guint8 start_offset,  /* in bits */
+                        guint8 *out);
+
+guint32 gsm_packed_len (guint32 num_septets,
+                        guint8 start_offset);  /* in bits */
+
+void gsm_pack_buffer (const guint8 *src,
+                      guint32 src_len,
+                      guint8 start_offset,  /* in bits */
+                      guint8 *out);
+
 gchar *mm_charset_take_and_convert_to_utf8 (gchar *str, MMModemCharset charset);
 
 gchar *mm_utf8_take_and_convert_to_charset (gchar *str,
@@ -0,0 +1,273 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-clock.h"
+#include "mm-log.h"
+
+static gboolean virtual_enabled;
+static gint64   virtual_now;
+/* Virtual timeout sources alive, to find the next one due */
+static GList   *virtual_timeouts;
+
+/*****************************************************************************/
+
+typedef struct {
+    GSource source;
+    gint64  interval;
+    gint64  due;
+} VirtualTimeout;
+
+static gboolean
+virtual_timeout_prepare (GSource *source,
+                         gint    *timeout)
+{
+    /* Never woken up by real time, only by mm_clock_advance() */
+    *timeout = -1;
+    return virtual_now >= ((VirtualTimeout *) source)->due;
+}
+
+static gboolean
+virtual_timeout_check (GSource *source)
+{
+    return virtual_now >= ((VirtualTimeout *) source)->due;
+}
+
+static gboolean
+virtual_timeout_dispatch (GSource     *source,
+                          GSourceFunc  callback,
+                          gpointer     user_data)
+{
+    VirtualTimeout *self = (VirtualTimeout *) source;
+
+    if (!callback) {
+        g_warning ("Virtual timeout source dispatched without callback");
+        return G_SOURCE_REMOVE;
+    }
+
+    if (callback (user_data) == G_SOURCE_REMOVE)
+        return G_SOURCE_REMOVE;
+
+    self->due = virtual_now + self->interval;
+    return G_SOURCE_CONTINUE;
+}
+
+static void
+virtual_timeout_finalize (GSource *source)
+{
+    virtual_timeouts = g_list_remove (virtual_timeouts, source);
+}
+
+static GSourceFuncs virtual_timeout_funcs = {
+    virtual_timeout_prepare,
+    virtual_timeout_check,
+    virtual_timeout_dispatch,
+    virtual_timeout_finalize,
+};
+
+static GSource *
+virtual_timeout_source_new (gint64 interval)
+{
+    VirtualTimeout *self;
+
+    self = (VirtualTimeout *) g_source_new (&virtual_timeout_funcs, sizeof (VirtualTimeout));
+    self->interval = interval;
+    self->due = virtual_now + interval;
+    virtual_timeouts = g_list_prepend (virtual_timeouts, self);
+    return (GSource *) self;
+}
+
+/* Earliest due time of the attached virtual timeouts, G_MAXINT64 if none */
+static gint64
+virtual_timeouts_next_due (void)
+{
+    GList  *l;
+    gint64  next = G_MAXINT64;
+
+    for (l = virtual_timeouts; l; l = g_list_next (l)) {
+        VirtualTimeout *timeout = l->data;
+
+        if (g_source_is_destroyed ((GSource *) timeout) ||
+            !g_source_get_context ((GSource *) timeout))
+            continue;
+        next = MIN (next, timeout->due);
+    }
+    return next;
+}
+
+/*****************************************************************************/
+
+void
+mm_clock_enable_virtual (void)
+{
+    if (virtual_enabled)
+        return;
+
+    /* Start from the real time, so that timestamps taken before remain
+     * comparable */
+    virtual_now = g_get_monotonic_time ();
+    virtual_enabled = TRUE;
+    mm_dbg ("Virtual clock enabled");
+}
+
+gboolean
+mm_clock_is_virtual (void)
+{
+    return virtual_enabled;
+}
+
+gint64
+mm_clock_get_time (void)
+{
+    if (G_LIKELY (!virtual_enabled))
+        return g_get_monotonic_time ();
+    return virtual_now;
+}
+
+/*****************************************************************************/
+
+GSource *
+mm_clock_timeout_source_new (guint interval_ms)
+{
+    if (G_LIKELY (!virtual_enabled))
+        return g_timeout_source_new (interval_ms);
+    return virtual_timeout_source_new ((gint64) interval_ms * 1000);
+}
+
+GSource *
+mm_clock_timeout_source_new_seconds (guint interval)
+{
+    if (G_LIKELY (!virtual_enabled))
+        return g_timeout_source_new_seconds (interval);
+    return virtual_timeout_source_new ((gint64) interval * G_USEC_PER_SEC);
+}
+
+static guint
+timeout_attach (GSource     *source,
+                GSourceFunc  function,
+                gpointer     data)
+{
+    guint id;
+
+    g_source_set_callback (source, function, data, NULL);
+    id = g_source_attach (source, NULL);
+    g_source_unref (source);
+    return id;
+}
+
+guint
+mm_clock_timeout_add (guint       interval_ms,
+                      GSourceFunc function,
+                      gpointer    data)
+{
+    if (G_LIKELY (!virtual_enabled))
+        return g_timeout_add (interval_ms, function, data);
+    return timeout_attach (mm_clock_timeout_source_new (interval_ms), function, data);
+}
+
+guint
+mm_clock_timeout_add_seconds (guint       interval,
+                              GSourceFunc function,
+                              gpointer    data)
+{
+    if (G_LIKELY (!virtual_enabled))
+        return g_timeout_add_seconds (interval, function, data);
+    return timeout_attach (mm_clock_timeout_source_new_seconds (interval), function, data);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    GSimpleAsyncResult *result;
+    gint64              target;
+    guint               n_steps;
+} AdvanceContext;
+
+/* Only one advance at a time */
+static AdvanceContext *advancing;
+
+static gboolean
+advance_step_cb (AdvanceContext *ctx)
+{
+    gint64 next;
+
+    /* The timeouts made due by the previous step have all run by now, as
+     * they have higher priority than us */
+    next = virtual_timeouts_next_due ();
+    if (next <= ctx->target) {
+        if (next > virtual_now) {
+            virtual_now = next;
+            ctx->n_steps++;
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    virtual_now = ctx->target;
+    mm_dbg ("Virtual clock advanced in %u steps", ctx->n_steps);
+
+    advancing = NULL;
+    g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    g_simple_async_result_complete (ctx->result);
+    g_object_unref (ctx->result);
+    g_slice_free (AdvanceContext, ctx);
+    return G_SOURCE_REMOVE;
+}
+
+gboolean
+mm_clock_advance_finish (GAsyncResult  *res,
+                         GError       **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+void
+mm_clock_advance (gint64               usecs,
+                  guint                settle_ms,
+                  GAsyncReadyCallback  callback,
+                  gpointer             user_data)
+{
+    AdvanceContext *ctx;
+    GSource        *source;
+
+    if (!virtual_enabled) {
+        g_simple_async_report_error_in_idle (NULL, callback, user_data,
+                                             MM_CORE_ERROR, MM_CORE_ERROR_WRONG_STATE,
+                                             "Virtual clock not enabled");
+        return;
+    }
+
+    if (advancing) {
+        g_simple_async_report_error_in_idle (NULL, callback, user_data,
+                                             MM_CORE_ERROR, MM_CORE_ERROR_IN_PROGRESS,
+                                             "Virtual clock already being advanced");
+        return;
+    }
+
+    mm_dbg ("Advancing virtual clock by %" G_GINT64_FORMAT "ms", usecs / 1000);
+
+    ctx = g_slice_new0 (AdvanceContext);
+    ctx->result = g_simple_async_result_new (NULL, callback, user_data, mm_clock_advance);
+    ctx->target = virtual_now + MAX (usecs, 0);
+    advancing = ctx;
+
+    /* Low priority, so that steps are only taken when nothing else is ready */
+    source = (settle_ms ? g_timeout_source_new (settle_ms) : g_idle_source_new ());
+    g_source_set_priority (source, G_PRIORITY_LOW);
+    g_source_set_callback (source, (GSourceFunc) advance_step_cb, ctx, NULL);
+    g_source_attach (source, NULL);
+    g_source_unref (source);
+}
@@ -0,0 +1,60 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_CLOCK_H
+#define MM_CLOCK_H
+
+#include <gio/gio.h>
+
+/*
+ * Monotonic time and timeouts of the daemon's own timers (probing, polling,
+ * command timeouts...), which can be switched to a virtual clock in tests and
+ * benchmarks so that hours of timer driven behavior run in seconds.
+ *
+ * With the real clock (the default) these are just g_get_monotonic_time() and
+ * the GLib timeout sources. Once the virtual clock is enabled, time only moves
+ * forward when mm_clock_advance() is called, and timeout sources created from
+ * then on fire in virtual time; sources created before keep the real clock.
+ * Everything must be used from the main thread and main context only.
+ */
+
+void     mm_clock_enable_virtual (void);
+gboolean mm_clock_is_virtual     (void);
+
+/* Monotonic time in microseconds, like g_get_monotonic_time() */
+gint64 mm_clock_get_time (void);
+
+GSource *mm_clock_timeout_source_new         (guint interval_ms);
+GSource *mm_clock_timeout_source_new_seconds (guint interval);
+guint    mm_clock_timeout_add                (guint       interval_ms,
+                                              GSourceFunc function,
+                                              gpointer    data);
+guint    mm_clock_timeout_add_seconds        (guint       interval,
+                                              GSourceFunc function,
+                                              gpointer    data);
+
+/* Moves the virtual clock forward, firing every timeout due on the way in
+ * order. Each step to the next timeout is only taken when the main loop has
+ * nothing else ready, and after 'settle_ms' of real time, so that I/O
+ * triggered by the previous timeouts (e.g. replies to AT commands) can be
+ * processed before the next ones fire. */
+void     mm_clock_advance        (gint64               usecs,
+                                  guint                settle_ms,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data);
+gboolean mm_clock_advance_finish (GAsyncResult        *res,
+                                  GError             **error);
+
+#endif /* MM_CLOCK_H */
@@ -25,6 +25,9 @@ static gboolean     version_flag;
 static gboolean     debug;
 static const gchar *log_level;
 static const gchar *log_file;
+static gint         log_fsync_interval = 5;
+static const gchar *log_categories;
+static const gchar *log_debug_ports;
 static gboolean     show_ts;
 static gboolean     rel_ts;
 
@@ -35,12 +38,37 @@ static gboolean no_auto_scan = TRUE;
 #endif
 
 static const gchar *initial_kernel_events;
+static const gchar *serial_capture_dir;
+static const gchar *qcdm_log_dir;
+static const gchar *qcdm_log_codes;
+static const gchar *location_journal_dir;
+static const gchar *port_probe_cache;
+static const gchar *modem_info_cache;
+static const gchar *sms_cache_dir;
+static gboolean     keep_modems_on_suspend;
+static gboolean     lazy_interfaces;
+static gint         loop_monitor;
+static gboolean     profile;
+static gboolean     qmi_multiplex;
+static gint         shutdown_timeout = 20;
+static gint         shutdown_modem_timeout;
+static gboolean     shutdown_radio_off;
+static gboolean     adopt_bearers;
+static gboolean     regex_stats;
+static gboolean     adaptive_timeouts;
+static gboolean     share_commands;
+static gboolean     constrained;
+static const gchar *peer_socket;
+static const gchar *status_segment;
 
 static const GOptionEntry entries[] = {
     { "version", 'V', 0, G_OPTION_ARG_NONE, &version_flag, "Print version", NULL },
     { "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Run with extended debugging capabilities", NULL },
     { "log-level", 0, 0, G_OPTION_ARG_STRING, &log_level, "Log level: one of ERR, WARN, INFO, DEBUG", "[LEVEL]" },
     { "log-file", 0, 0, G_OPTION_ARG_FILENAME, &log_file, "Path to log file", "[PATH]" },
+    { "log-fsync-interval", 0, 0, G_OPTION_ARG_INT, &log_fsync_interval, "Interval between syncs of the log file to disk, in seconds; 0 to only sync on exit (default 5)", "[SECS]" },
+    { "log-categories", 0, 0, G_OPTION_ARG_STRING, &log_categories, "Per-category log levels, e.g. serial-at:DEBUG,qmi:WARN; categories: serial-at, serial-qcdm, gps, qmi, plugin-manager", "[LIST]" },
+    { "log-debug-ports", 0, 0, G_OPTION_ARG_STRING, &log_debug_ports, "Comma-separated list of port names whose traffic is always logged", "[LIST]" },
     { "timestamps", 0, 0, G_OPTION_ARG_NONE, &show_ts, "Show timestamps in log output", NULL },
     { "relative-timestamps", 0, 0, G_OPTION_ARG_NONE, &rel_ts, "Use relative timestamps (from MM start)", NULL },
 #if WITH_UDEV
@@ -51,6 +79,28 @@ static const GOptionEntry entries[] = {
     { "no-auto-scan", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &no_auto_scan, NULL, NULL },
 #endif
     { "initial-kernel-events", 0, 0, G_OPTION_ARG_FILENAME, &initial_kernel_events, "Path to initial kernel events file", "[PATH]" },
+    { "serial-capture-dir", 0, 0, G_OPTION_ARG_FILENAME, &serial_capture_dir, "Directory where to record the traffic of serial ports", "[PATH]" },
+    { "qcdm-log-dir", 0, 0, G_OPTION_ARG_FILENAME, &qcdm_log_dir, "Directory where to stream the log packets of QCDM ports", "[PATH]" },
+    { "qcdm-log-codes", 0, 0, G_OPTION_ARG_STRING, &qcdm_log_codes, "Comma-separated list of QCDM log codes to stream", "[CODES]" },
+    { "location-journal-dir", 0, 0, G_OPTION_ARG_FILENAME, &location_journal_dir, "Directory where to keep the location history of each modem", "[PATH]" },
+    { "port-probe-cache", 0, 0, G_OPTION_ARG_FILENAME, &port_probe_cache, "Path to the file where to cache port probing results", "[PATH]" },
+    { "modem-info-cache", 0, 0, G_OPTION_ARG_FILENAME, &modem_info_cache, "Path to the file where to cache the static info of each modem", "[PATH]" },
+    { "sms-cache-dir", 0, 0, G_OPTION_ARG_FILENAME, &sms_cache_dir, "Directory where to keep a copy of the SMS storages of each SIM", "[PATH]" },
+    { "keep-modems-on-suspend", 0, 0, G_OPTION_ARG_NONE, &keep_modems_on_suspend, "Keep modems across system suspend, only pausing their polling", NULL },
+    { "lazy-interfaces", 0, 0, G_OPTION_ARG_NONE, &lazy_interfaces, "Initialize the OMA and Firmware interfaces on their first use", NULL },
+    { "loop-monitor", 0, 0, G_OPTION_ARG_INT, &loop_monitor, "Warn about main loop stalls longer than the given time, in milliseconds", "[MS]" },
+    { "profile", 0, 0, G_OPTION_ARG_NONE, &profile, "Record the timeline of probing, initialization and enabling steps", NULL },
+    { "qmi-multiplex", 0, 0, G_OPTION_ARG_NONE, &qmi_multiplex, "Run the data sessions of QMI modems over QMAP multiplexed links", NULL },
+    { "shutdown-timeout", 0, 0, G_OPTION_ARG_INT, &shutdown_timeout, "Maximum time to wait for all modems to be disabled on shutdown, in seconds (default 20)", "[SECS]" },
+    { "shutdown-modem-timeout", 0, 0, G_OPTION_ARG_INT, &shutdown_modem_timeout, "Maximum time to wait for each modem to be disabled on shutdown, in seconds", "[SECS]" },
+    { "shutdown-radio-off", 0, 0, G_OPTION_ARG_NONE, &shutdown_radio_off, "Only switch the radio off on shutdown, instead of fully disabling modems", NULL },
+    { "adopt-bearers", 0, 0, G_OPTION_ARG_NONE, &adopt_bearers, "Take over the data connections found already established when modems are first enabled", NULL },
+    { "regex-stats", 0, 0, G_OPTION_ARG_NONE, &regex_stats, "Log the compile time and use count of the shared regular expressions on exit", NULL },
+    { "adaptive-timeouts", 0, 0, G_OPTION_ARG_NONE, &adaptive_timeouts, "Shorten the timeouts of serial port commands based on the response times seen for each command", NULL },
+    { "share-commands", 0, 0, G_OPTION_ARG_NONE, &share_commands, "Send read-only serial port commands only once when queued again before the first one gets its reply", NULL },
+    { "constrained", 0, 0, G_OPTION_ARG_NONE, &constrained, "Run with hard caps on the memory used by each modem, for targets with little memory", NULL },
+    { "peer-socket", 0, 0, G_OPTION_ARG_FILENAME, &peer_socket, "Path of a UNIX socket where local clients may connect without going through the bus", "[PATH]" },
+    { "status-segment", 0, 0, G_OPTION_ARG_FILENAME, &status_segment, "Path of a file where to publish the status of each modem for local clients to map in memory", "[PATH]" },
     { NULL }
 };
 
@@ -72,6 +122,24 @@ mm_context_get_log_file (void)
     return log_file;
 }
 
+guint
+mm_context_get_log_fsync_interval (void)
+{
+    return (log_fsync_interval > 0 ? (guint) log_fsync_interval : 0);
+}
+
+const gchar *
+mm_context_get_log_categories (void)
+{
+    return log_categories;
+}
+
+const gchar *
+mm_context_get_log_debug_ports (void)
+{
+    return log_debug_ports;
+}
+
 gboolean
 mm_context_get_timestamps (void)
 {
@@ -96,6 +164,138 @@ mm_context_get_no_auto_scan (void)
     return no_auto_scan;
 }
 
+const gchar *
+mm_context_get_serial_capture_dir (void)
+{
+    return serial_capture_dir;
+}
+
+const gchar *
+mm_context_get_qcdm_log_dir (void)
+{
+    return qcdm_log_dir;
+}
+
+const gchar *
+mm_context_get_qcdm_log_codes (void)
+{
+    return qcdm_log_codes;
+}
+
+const gchar *
+mm_context_get_location_journal_dir (void)
+{
+    return location_journal_dir;
+}
+
+const gchar *
+mm_context_get_port_probe_cache (void)
+{
+    return port_probe_cache;
+}
+
+const gchar *
+mm_context_get_modem_info_cache (void)
+{
+    return modem_info_cache;
+}
+
+const gchar *
+mm_context_get_sms_cache_dir (void)
+{
+    return sms_cache_dir;
+}
+
+gboolean
+mm_context_get_keep_modems_on_suspend (void)
+{
+    return keep_modems_on_suspend;
+}
+
+gboolean
+mm_context_get_lazy_interfaces (void)
+{
+    return lazy_interfaces;
+}
+
+guint
+mm_context_get_loop_monitor (void)
+{
+    return (loop_monitor > 0 ? (guint) loop_monitor : 0);
+}
+
+gboolean
+mm_context_get_profile (void)
+{
+    return profile;
+}
+
+gboolean
+mm_context_get_qmi_multiplex (void)
+{
+    return qmi_multiplex;
+}
+
+guint
+mm_context_get_shutdown_timeout (void)
+{
+    return (shutdown_timeout > 0 ? (guint) shutdown_timeout : 0);
+}
+
+guint
+mm_context_get_shutdown_modem_timeout (void)
+{
+    return (shutdown_modem_timeout > 0 ? (guint) shutdown_modem_timeout : 0);
+}
+
+gboolean
+mm_context_get_shutdown_radio_off (void)
+{
+    return shutdown_radio_off;
+}
+
+gboolean
+mm_context_get_adopt_bearers (void)
+{
+    return adopt_bearers;
+}
+
+gboolean
+mm_context_get_regex_stats (void)
+{
+    return regex_stats;
+}
+
+gboolean
+mm_context_get_adaptive_timeouts (void)
+{
+    return adaptive_timeouts;
+}
+
+gboolean
+mm_context_get_share_commands (void)
+{
+    return share_commands;
+}
+
+gboolean
+mm_context_get_constrained (void)
+{
+    return constrained;
+}
+
+const gchar *
+mm_context_get_peer_socket (void)
+{
+    return peer_socket;
+}
+
+const gchar *
+mm_context_get_status_segment (void)
+{
+    return status_segment;
+}
+
 /*****************************************************************************/
 /* Test context */
 
@@ -29,10 +29,35 @@ void mm_context_init (gint argc,
 gboolean     mm_context_get_debug                 (void);
 const gchar *mm_context_get_log_level             (void);
 const gchar *mm_context_get_log_file              (void);
+guint        mm_context_get_log_fsync_interval (void);
+const gchar *mm_context_get_log_categories     (void);
+const gchar *mm_context_get_log_debug_ports    (void);
 gboolean     mm_context_get_timestamps            (void);
 gboolean     mm_context_get_relative_timestamps   (void);
 const gchar *mm_context_get_initial_kernel_events (void);
 gboolean     mm_context_get_no_auto_scan          (void);
+const gchar *mm_context_get_serial_capture_dir    (void);
+const gchar *mm_context_get_qcdm_log_dir          (void);
+const gchar *mm_context_get_qcdm_log_codes        (void);
+const gchar *mm_context_get_location_journal_dir  (void);
+const gchar *mm_context_get_port_probe_cache      (void);
+const gchar *mm_context_get_modem_info_cache      (void);
+const gchar *mm_context_get_sms_cache_dir         (void);
+gboolean     mm_context_get_keep_modems_on_suspend (void);
+gboolean     mm_context_get_lazy_interfaces        (void);
+guint        mm_context_get_loop_monitor           (void);
+gboolean     mm_context_get_profile                (void);
+gboolean     mm_context_get_qmi_multiplex          (void);
+guint        mm_context_get_shutdown_timeout       (void);
+guint        mm_context_get_shutdown_modem_timeout (void);
+gboolean     mm_context_get_shutdown_radio_off     (void);
+gboolean     mm_context_get_adopt_bearers          (void);
+gboolean     mm_context_get_regex_stats            (void);
+gboolean     mm_context_get_adaptive_timeouts      (void);
+gboolean     mm_context_get_share_commands         (void);
+gboolean     mm_context_get_constrained            (void);
+const gchar *mm_context_get_peer_socket            (void);
+const gchar *mm_context_get_status_segment         (void);
 
 /* Testing support */
 gboolean     mm_context_get_test_session    (void);
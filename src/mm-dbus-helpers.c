@@ -0,0 +1,33 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-dbus-helpers.h"
+
+void
+mm_dbus_flush_properties (gpointer skeleton)
+{
+    GDBusObject *object;
+
+    g_return_if_fail (G_IS_DBUS_INTERFACE_SKELETON (skeleton));
+
+    /* A method of one interface may update properties of the others, e.g.
+     * Simple.Connect changing the Modem state and bearers; all of them must
+     * reach the bus before the reply */
+    object = g_dbus_interface_get_object (G_DBUS_INTERFACE (skeleton));
+    if (object && G_IS_DBUS_OBJECT_SKELETON (object))
+        g_dbus_object_skeleton_flush (G_DBUS_OBJECT_SKELETON (object));
+    else
+        g_dbus_interface_skeleton_flush (G_DBUS_INTERFACE_SKELETON (skeleton));
+}
@@ -0,0 +1,34 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_DBUS_HELPERS_H
+#define MM_DBUS_HELPERS_H
+
+#include <glib.h>
+#include <gio/gio.h>
+
+/*
+ * The skeletons merge all the property changes of one interface done within
+ * a main loop dispatch, and emit them in a single PropertiesChanged from an
+ * idle source. Method replies are sent right away instead, so a client could
+ * get the reply before the property updates caused by the method.
+ *
+ * Flushing emits the changes pending in all the interfaces of the object
+ * exporting the given interface skeleton (or of the skeleton alone, if not
+ * in an object) in one go. Run it just before completing a method call.
+ */
+void mm_dbus_flush_properties (gpointer skeleton);
+
+#endif /* MM_DBUS_HELPERS_H */
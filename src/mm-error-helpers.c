@@ -18,6 +18,8 @@
 #include "mm-error-helpers.h"
 #include "mm-log.h"
 
+#include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
 
 typedef struct {
@@ -26,6 +28,78 @@ typedef struct {
     const gchar *message;
 } ErrorTable;
 
+/* Error tables are sorted by code, and each comes with an array of indexes in
+ * the table sorted by error string, so that both lookups are binary searches.
+ * Keep both in order when adding new errors. */
+
+/* Longer than any error string in the tables */
+#define MAX_ERROR_STRING_LEN 64
+
+static gint
+error_table_code_cmp (gconstpointer key,
+                      gconstpointer entry)
+{
+    guint code = GPOINTER_TO_UINT (key);
+    const ErrorTable *error = entry;
+
+    return (code < error->code) ? -1 : (code > error->code);
+}
+
+static const ErrorTable *
+error_table_lookup_code (const ErrorTable *table,
+                         gsize             n_entries,
+                         guint             code)
+{
+    return bsearch (GUINT_TO_POINTER (code), table, n_entries, sizeof (ErrorTable), error_table_code_cmp);
+}
+
+/* Normalizes 'str' into 'buf' by stripping whitespace and odd characters;
+ * FALSE if it is too long to be in any table */
+static gboolean
+error_string_normalize (const gchar *str,
+                        gchar       *buf)
+{
+    guint i;
+    guint j;
+
+    for (i = 0, j = 0; str[i]; i++) {
+        if (isalnum (str[i])) {
+            if (j == MAX_ERROR_STRING_LEN - 1) {
+                buf[j] = '\0';
+                return FALSE;
+            }
+            buf[j++] = tolower (str[i]);
+        }
+    }
+    buf[j] = '\0';
+    return TRUE;
+}
+
+static const ErrorTable *
+error_table_lookup_string (const ErrorTable *table,
+                           const guint8     *by_string,
+                           gsize             n_entries,
+                           const gchar      *str)
+{
+    gsize low = 0;
+    gsize high = n_entries;
+
+    while (low < high) {
+        gsize mid;
+        gint  cmp;
+
+        mid = low + (high - low) / 2;
+        cmp = strcmp (str, table[by_string[mid]].error);
+        if (cmp == 0)
+            return &table[by_string[mid]];
+        if (cmp < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return NULL;
+}
+
 /* --- Connection errors --- */
 
 GError *
@@ -62,7 +136,7 @@ mm_connection_error_for_code (MMConnectionError code)
 
 /* --- Mobile equipment errors --- */
 
-static ErrorTable me_errors[] = {
+static const ErrorTable me_errors[] = {
     { MM_MOBILE_EQUIPMENT_ERROR_PHONE_FAILURE,                      "phonefailure",                              "Phone failure" },
     { MM_MOBILE_EQUIPMENT_ERROR_NO_CONNECTION,                      "noconnectiontophone",                       "No connection to phone" },
     { MM_MOBILE_EQUIPMENT_ERROR_LINK_RESERVED,                      "phoneadapterlinkreserved",                  "Phone-adaptor link reserved" },
@@ -114,18 +188,70 @@ static ErrorTable me_errors[] = {
     { MM_MOBILE_EQUIPMENT_ERROR_GPRS_INVALID_MOBILE_CLASS,          "invalidmobileclass",                        "Invalid mobile class" },
 };
 
+static const guint8 me_errors_by_string[] = {
+    34, /* corporatepersonalizationpinrequired */
+    35, /* corporatepersonalizationpukrequired */
+    23, /* dialstringtoolong */
+    39, /* gprsservicesnotallowed */
+    38, /* illegalme */
+    37, /* illegalms */
+    14, /* incorrectpassword */
+    24, /* invalidcharactersindialstring */
+    22, /* invalidcharactersintextstring */
+    18, /* invalidindex */
+    48, /* invalidmobileclass */
+    41, /* locationareanotallowed */
+    20, /* memoryfailure */
+    17, /* memoryfull */
+    27, /* networknotallowedemergencycallsonly */
+    28, /* networkpersonalizationpinrequired */
+    29, /* networkpersonalizationpukrequired */
+    30, /* networksubsetpersonalizationpinrequired */
+    31, /* networksubsetpersonalizationpukrequired */
+    26, /* networktimeout */
+     1, /* noconnectiontophone */
+    25, /* nonetworkservice */
+    19, /* notfound */
+     3, /* operationnotallowed */
+     4, /* operationnotsupported */
+    47, /* pdpauthenticationfailure */
+     6, /* phfsimpinrequired */
+     7, /* phfsimpukrequired */
+     2, /* phoneadapterlinkreserved */
+     0, /* phonefailure */
+     5, /* phsimpinrequired */
+    40, /* plmnnotallowed */
+    44, /* requestedserviceoptionnotsubscribed */
+    42, /* roamingnotallowedinthislocationarea */
+    43, /* serviceoperationnotsupported */
+    45, /* serviceoptiontemporarilyoutoforder */
+    32, /* serviceproviderpersonalizationpinrequired */
+    33, /* serviceproviderpersonalizationpukrequired */
+    12, /* simbusy */
+    11, /* simfailure */
+     8, /* simnotinserted */
+    15, /* simpin2required */
+     9, /* simpinrequired */
+    16, /* simpuk2required */
+    10, /* simpukrequired */
+    13, /* simwrong */
+    21, /* textstringtoolong */
+    36, /* unknownerror */
+    46, /* unspecifiedgprserror */
+};
+G_STATIC_ASSERT (G_N_ELEMENTS (me_errors_by_string) == G_N_ELEMENTS (me_errors));
+
 GError *
 mm_mobile_equipment_error_for_code (MMMobileEquipmentError code)
 {
-    guint i;
+    const ErrorTable *error;
 
     /* Look for the code */
-    for (i = 0; i < G_N_ELEMENTS (me_errors); i++) {
-        if (me_errors[i].code == code)
-            return g_error_new_literal (MM_MOBILE_EQUIPMENT_ERROR,
-                                        code,
-                                        me_errors[i].message);
-    }
+    error = error_table_lookup_code (me_errors, G_N_ELEMENTS (me_errors), code);
+    if (error)
+        return g_error_new_literal (MM_MOBILE_EQUIPMENT_ERROR,
+                                    code,
+                                    error->message);
 
     /* Not found? Then, default */
     mm_dbg ("Invalid mobile equipment error code: %u", (guint)code);
@@ -137,45 +263,29 @@ mm_mobile_equipment_error_for_code (MMMobileEquipmentError code)
 GError *
 mm_mobile_equipment_error_for_string (const gchar *str)
 {
-    MMMobileEquipmentError code = MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN;
-    const gchar *msg = NULL;
-    gchar *buf;
-    guint i;
-    guint j;
+    const ErrorTable *error = NULL;
+    gchar buf[MAX_ERROR_STRING_LEN];
 
     g_return_val_if_fail (str != NULL, NULL);
 
-    /* Normalize the error code by stripping whitespace and odd characters */
-    buf = g_strdup (str);
-    for (i = 0, j = 0; str[i]; i++) {
-        if (isalnum (str[i]))
-            buf[j++] = tolower (str[i]);
-    }
-    buf[j] = '\0';
-
-    /* Look for the string */
-    for (i = 0; i < G_N_ELEMENTS (me_errors); i++) {
-        if (g_str_equal (me_errors[i].error, buf)) {
-            code = me_errors[i].code;
-            msg = me_errors[i].message;
-            break;
-        }
-    }
+    /* Normalize the error code and look for the string */
+    if (error_string_normalize (str, buf))
+        error = error_table_lookup_string (me_errors, me_errors_by_string, G_N_ELEMENTS (me_errors), buf);
 
     /* Not found? Then, default */
-    if (!msg) {
+    if (!error) {
         mm_dbg ("Invalid mobile equipment error string: '%s' (%s)", str, buf);
-        code = MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN;
-        msg = "Unknown error";
+        return g_error_new_literal (MM_MOBILE_EQUIPMENT_ERROR,
+                                    MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN,
+                                    "Unknown error");
     }
 
-    g_free (buf);
-    return g_error_new_literal (MM_MOBILE_EQUIPMENT_ERROR, code, msg);
+    return g_error_new_literal (MM_MOBILE_EQUIPMENT_ERROR, error->code, error->message);
 }
 
 /* --- Message errors --- */
 
-static ErrorTable msg_errors[] = {
+static const ErrorTable msg_errors[] = {
     { MM_MESSAGE_ERROR_ME_FAILURE,             "mefailure",             "ME failure" },
     { MM_MESSAGE_ERROR_SMS_SERVICE_RESERVED,   "smsservicereserved",    "SMS service reserved" },
     { MM_MESSAGE_ERROR_NOT_ALLOWED,            "operationnotallowed",   "Operation not allowed" },
@@ -201,18 +311,44 @@ static ErrorTable msg_errors[] = {
     { MM_MESSAGE_ERROR_UNKNOWN,                "unknown",               "Unknown" }
 };
 
+static const guint8 msg_errors_by_string[] = {
+    16, /* invalidindex */
+     4, /* invalidpduparameter */
+     5, /* invalidtextparameter */
+     0, /* mefailure */
+    15, /* memoryfailure */
+    17, /* memoryfull */
+    20, /* networktimeout */
+    21, /* nocnmaackexpected */
+    19, /* nonetwork */
+     2, /* operationnotallowed */
+     3, /* operationnotsupported */
+     8, /* phsimpinrequired */
+    10, /* simbusy */
+     9, /* simfailure */
+     6, /* simnotinserted */
+    13, /* simpin2required */
+     7, /* simpinrequired */
+    14, /* simpuk2required */
+    12, /* simpukrequired */
+    11, /* simwrong */
+    18, /* smscaddressunknown */
+     1, /* smsservicereserved */
+    22, /* unknown */
+};
+G_STATIC_ASSERT (G_N_ELEMENTS (msg_errors_by_string) == G_N_ELEMENTS (msg_errors));
+
 GError *
 mm_message_error_for_code (MMMessageError code)
 {
-    guint i;
+    const ErrorTable *error;
 
     /* Look for the code */
-    for (i = 0; i < G_N_ELEMENTS (msg_errors); i++) {
-        if (msg_errors[i].code == code)
-            return g_error_new_literal (MM_MESSAGE_ERROR,
-                                        code,
-                                        msg_errors[i].message);
-    }
+    error = error_table_lookup_code (msg_errors, G_N_ELEMENTS (msg_errors), code);
+    if (error)
+        return g_error_new_literal (MM_MESSAGE_ERROR,
+                                    code,
+                                    error->message);
 
     /* Not found? Then, default */
     mm_dbg ("Invalid message error code: %u", (guint)code);
@@ -224,38 +360,22 @@ mm_message_error_for_code (MMMessageError code)
 GError *
 mm_message_error_for_string (const gchar *str)
 {
-    MMMessageError code = MM_MESSAGE_ERROR_UNKNOWN;
-    const gchar *msg = NULL;
-    gchar *buf;
-    guint i;
-    guint j;
+    const ErrorTable *error = NULL;
+    gchar buf[MAX_ERROR_STRING_LEN];
 
     g_return_val_if_fail (str != NULL, NULL);
 
-    /* Normalize the error code by stripping whitespace and odd characters */
-    buf = g_strdup (str);
-    for (i = 0, j = 0; str[i]; i++) {
-        if (isalnum (str[i]))
-            buf[j++] = tolower (str[i]);
-    }
-    buf[j] = '\0';
-
-    /* Look for the string */
-    for (i = 0; i < G_N_ELEMENTS (msg_errors); i++) {
-        if (g_str_equal (msg_errors[i].error, buf)) {
-            code = msg_errors[i].code;
-            msg = msg_errors[i].message;
-            break;
-        }
-    }
+    /* Normalize the error code and look for the string */
+    if (error_string_normalize (str, buf))
+        error = error_table_lookup_string (msg_errors, msg_errors_by_string, G_N_ELEMENTS (msg_errors), buf);
 
     /* Not found? Then, default */
-    if (!msg) {
+    if (!error) {
         mm_dbg ("Invalid message error string: '%s' (%s)", str, buf);
-        code = MM_MESSAGE_ERROR_UNKNOWN;
-        msg = "Unknown error";
+        return g_error_new_literal (MM_MESSAGE_ERROR,
+                                    MM_MESSAGE_ERROR_UNKNOWN,
+                                    "Unknown error");
     }
 
-    g_free (buf);
-    return g_error_new_literal (MM_MESSAGE_ERROR, code, msg);
+    return g_error_new_literal (MM_MESSAGE_ERROR, error->code, error->message);
 }
@@ -26,7 +26,9 @@
 #include "mm-iface-modem-3gpp-ussd.h"
 #include "mm-base-modem.h"
 #include "mm-modem-helpers.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define SUPPORT_CHECKED_TAG "3gpp-ussd-support-checked-tag"
 #define SUPPORTED_TAG       "3gpp-ussd-supported-tag"
@@ -120,8 +122,10 @@ handle_cancel_ready (MMIfaceModem3gppUssd *self,
 
     if (!MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->cancel_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem3gpp_ussd_complete_cancel (ctx->skeleton, ctx->invocation);
+    }
 
     handle_cancel_context_free (ctx);
 }
@@ -199,10 +203,12 @@ handle_respond_ready (MMIfaceModem3gppUssd *self,
     reply = MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send_finish (self, res,&error);
     if (!reply)
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem3gpp_ussd_complete_respond (ctx->skeleton,
                                                   ctx->invocation,
                                                   reply);
+    }
     handle_respond_context_free (ctx);
 }
 
@@ -303,10 +309,12 @@ handle_initiate_ready (MMIfaceModem3gppUssd *self,
     reply = MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send_finish (self, res, &error);
     if (!reply)
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem3gpp_ussd_complete_initiate (ctx->skeleton,
                                                    ctx->invocation,
                                                    reply);
+    }
     handle_initiate_context_free (ctx);
 }
 
@@ -379,6 +387,152 @@ handle_initiate (MmGdbusModem3gppUssd *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModem3gppUssd *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModem3gppUssd *self;
+    gchar **commands;
+    guint n_commands;
+    guint current;
+} HandleInitiateSessionContext;
+
+static void
+handle_initiate_session_context_free (HandleInitiateSessionContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_strfreev (ctx->commands);
+    g_free (ctx);
+}
+
+static void
+handle_initiate_session_ready (MMIfaceModem3gppUssd *self,
+                               GAsyncResult *res,
+                               HandleInitiateSessionContext *ctx)
+{
+    GError *error = NULL;
+    const gchar *reply;
+
+    reply = MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send_finish (self, res, &error);
+    if (!reply) {
+        g_prefix_error (&error, "USSD session step %u/%u failed: ", ctx->current + 1, ctx->n_commands);
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_initiate_session_context_free (ctx);
+        return;
+    }
+
+    /* Last reply goes back to the caller */
+    if (++ctx->current == ctx->n_commands) {
+        mm_dbus_flush_properties (ctx->skeleton);
+        mm_gdbus_modem3gpp_ussd_complete_initiate_session (ctx->skeleton,
+                                                           ctx->invocation,
+                                                           reply);
+        handle_initiate_session_context_free (ctx);
+        return;
+    }
+
+    /* The network must still be waiting for our input */
+    if (mm_gdbus_modem3gpp_ussd_get_state (ctx->skeleton) != MM_MODEM_3GPP_USSD_SESSION_STATE_USER_RESPONSE) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "USSD session ended by the network after step %u/%u: '%s'",
+                                               ctx->current, ctx->n_commands, reply);
+        handle_initiate_session_context_free (ctx);
+        return;
+    }
+
+    /* Send the next selection right away, without going back to the caller */
+    mm_dbg ("USSD session step %u/%u: '%s'", ctx->current + 1, ctx->n_commands, ctx->commands[ctx->current]);
+    MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send (
+        self,
+        ctx->commands[ctx->current],
+        (GAsyncReadyCallback)handle_initiate_session_ready,
+        ctx);
+}
+
+static void
+handle_initiate_session_auth_ready (MMBaseModem *self,
+                                    GAsyncResult *res,
+                                    HandleInitiateSessionContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error) ||
+        !ensure_enabled (self, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_initiate_session_context_free (ctx);
+        return;
+    }
+
+    if (!ctx->n_commands) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_INVALID_ARGS,
+                                               "Cannot initiate USSD session: "
+                                               "no commands given");
+        handle_initiate_session_context_free (ctx);
+        return;
+    }
+
+    g_assert (MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send != NULL);
+    g_assert (MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send_finish != NULL);
+
+    switch (mm_gdbus_modem3gpp_ussd_get_state (ctx->skeleton)) {
+    case MM_MODEM_3GPP_USSD_SESSION_STATE_ACTIVE:
+    case MM_MODEM_3GPP_USSD_SESSION_STATE_USER_RESPONSE:
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot initiate USSD session: "
+                                               "a session is already active");
+        break;
+
+    case MM_MODEM_3GPP_USSD_SESSION_STATE_IDLE:
+        mm_dbg ("USSD session step 1/%u: '%s'", ctx->n_commands, ctx->commands[0]);
+        MM_IFACE_MODEM_3GPP_USSD_GET_INTERFACE (self)->send (
+            MM_IFACE_MODEM_3GPP_USSD (self),
+            ctx->commands[0],
+            (GAsyncReadyCallback)handle_initiate_session_ready,
+            ctx);
+        return;
+
+    case MM_MODEM_3GPP_USSD_SESSION_STATE_UNKNOWN:
+    default:
+        /* We should never have a DBus request when in UNKNOWN state */
+        g_assert_not_reached ();
+        break;
+    }
+
+    handle_initiate_session_context_free (ctx);
+}
+
+static gboolean
+handle_initiate_session (MmGdbusModem3gppUssd *skeleton,
+                         GDBusMethodInvocation *invocation,
+                         const gchar *const *commands,
+                         MMIfaceModem3gppUssd *self)
+{
+    HandleInitiateSessionContext *ctx;
+
+    ctx = g_new0 (HandleInitiateSessionContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->commands = g_strdupv ((gchar **)commands);
+    ctx->n_commands = g_strv_length (ctx->commands);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_USSD,
+                             (GAsyncReadyCallback)handle_initiate_session_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 gchar *
 mm_iface_modem_3gpp_ussd_encode (MMIfaceModem3gppUssd *self,
                                  const gchar *command,
@@ -801,6 +955,11 @@ check_support_ready (MMIfaceModem3gppUssd *self,
 static void
 interface_initialization_step (InitializationContext *ctx)
 {
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "3GPP USSD interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -864,6 +1023,10 @@ interface_initialization_step (InitializationContext *ctx)
                           "handle-initiate",
                           G_CALLBACK (handle_initiate),
                           ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-initiate-session",
+                          G_CALLBACK (handle_initiate_session),
+                          ctx->self);
         g_signal_connect (ctx->skeleton,
                           "handle-respond",
                           G_CALLBACK (handle_respond),
@@ -26,17 +26,27 @@
 #include "mm-base-modem.h"
 #include "mm-modem-helpers.h"
 #include "mm-error-helpers.h"
+#include "mm-clock.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
+#include "mm-poll-scheduler.h"
+#include "mm-status-segment.h"
 
 #define REGISTRATION_CHECK_TIMEOUT_SEC 30
 
+/* Checks requested this soon after the last one completed get its result */
+#define REGISTRATION_CHECKS_FRESH_USEC (2 * G_USEC_PER_SEC)
+
 #define SUBSYSTEM_3GPP "3gpp"
 
 #define REGISTRATION_STATE_CONTEXT_TAG    "3gpp-registration-state-context-tag"
 #define REGISTRATION_CHECK_CONTEXT_TAG    "3gpp-registration-check-context-tag"
+#define REGISTRATION_CHECKS_CONTEXT_TAG   "3gpp-registration-checks-context-tag"
 
 static GQuark registration_state_context_quark;
 static GQuark registration_check_context_quark;
+static GQuark registration_checks_context_quark;
 
 /*****************************************************************************/
 
@@ -295,7 +305,7 @@ run_registration_checks_ready (MMIfaceModem3gpp *self,
      * well.
      */
     mm_dbg ("Modem not yet registered in a 3GPP network... will recheck soon");
-    g_timeout_add_seconds (3, (GSourceFunc)run_registration_checks_again, ctx);
+    mm_clock_timeout_add_seconds (3, (GSourceFunc)run_registration_checks_again, ctx);
 }
 
 static void
@@ -450,8 +460,10 @@ handle_register_ready (MMIfaceModem3gpp *self,
 
     if (!MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->register_in_network_finish (self, res,&error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem3gpp_complete_register (ctx->skeleton, ctx->invocation);
+    }
 
     handle_register_context_free (ctx);
 }
@@ -575,6 +587,24 @@ handle_scan_context_free (HandleScanContext *ctx)
     g_free (ctx);
 }
 
+static void
+scan_networks_add_network (GVariantBuilder *builder,
+                           MM3gppNetworkInfo *info)
+{
+    g_variant_builder_add (builder, "{sv}",
+                           "operator-code", g_variant_new_string (info->operator_code));
+    g_variant_builder_add (builder, "{sv}",
+                           "status", g_variant_new_uint32 (info->status));
+    g_variant_builder_add (builder, "{sv}",
+                           "access-technology", g_variant_new_uint32 (info->access_tech));
+    if (info->operator_long)
+        g_variant_builder_add (builder, "{sv}",
+                               "operator-long", g_variant_new_string (info->operator_long));
+    if (info->operator_short)
+        g_variant_builder_add (builder, "{sv}",
+                               "operator-short", g_variant_new_string (info->operator_short));
+}
+
 static GVariant *
 scan_networks_build_result (GList *info_list)
 {
@@ -592,25 +622,42 @@ scan_networks_build_result (GList *info_list)
         }
 
         g_variant_builder_open (&builder, G_VARIANT_TYPE ("a{sv}"));
-
-        g_variant_builder_add (&builder, "{sv}",
-                               "operator-code", g_variant_new_string (info->operator_code));
-        g_variant_builder_add (&builder, "{sv}",
-                               "status", g_variant_new_uint32 (info->status));
-        g_variant_builder_add (&builder, "{sv}",
-                               "access-technology", g_variant_new_uint32 (info->access_tech));
-        if (info->operator_long)
-            g_variant_builder_add (&builder, "{sv}",
-                                   "operator-long", g_variant_new_string (info->operator_long));
-        if (info->operator_short)
-            g_variant_builder_add (&builder, "{sv}",
-                                   "operator-short", g_variant_new_string (info->operator_short));
+        scan_networks_add_network (&builder, info);
         g_variant_builder_close (&builder);
     }
 
     return g_variant_ref (g_variant_builder_end (&builder));
 }
 
+void
+mm_iface_modem_3gpp_report_scanned_networks (MMIfaceModem3gpp *self,
+                                             GList *info_list)
+{
+    MmGdbusModem3gpp *skeleton = NULL;
+    GList *l;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_DBUS_SKELETON, &skeleton,
+                  NULL);
+    if (!skeleton)
+        return;
+
+    for (l = info_list; l; l = g_list_next (l)) {
+        MM3gppNetworkInfo *info = l->data;
+        GVariantBuilder builder;
+
+        if (!info->operator_code)
+            continue;
+
+        mm_dbg ("Network found while scanning: '%s'", info->operator_code);
+        g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+        scan_networks_add_network (&builder, info);
+        mm_gdbus_modem3gpp_emit_network_found (skeleton, g_variant_builder_end (&builder));
+    }
+
+    g_object_unref (skeleton);
+}
+
 static void
 handle_scan_ready (MMIfaceModem3gpp *self,
                    GAsyncResult *res,
@@ -626,6 +673,7 @@ handle_scan_ready (MMIfaceModem3gpp *self,
         GVariant *dict_array;
 
         dict_array = scan_networks_build_result (info_list);
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem3gpp_complete_scan (ctx->skeleton,
                                           ctx->invocation,
                                           dict_array);
@@ -729,13 +777,93 @@ handle_scan (MmGdbusModem3gpp *skeleton,
 
 /*****************************************************************************/
 
+/* Registration checks are single-flight: callers requesting them while
+ * there is one in progress get the result of that one, and so do callers
+ * requesting them right after one completed. */
+
+typedef struct {
+    /* GSimpleAsyncResults of the callers waiting for the running checks */
+    GList *waiting;
+    gboolean running;
+    /* Result of the last completed checks */
+    gint64 last_completed;
+    GError *last_error;
+} RegistrationChecksContext;
+
+static void
+registration_checks_context_free (RegistrationChecksContext *ctx)
+{
+    g_assert (!ctx->waiting);
+    g_clear_error (&ctx->last_error);
+    g_slice_free (RegistrationChecksContext, ctx);
+}
+
+static RegistrationChecksContext *
+get_registration_checks_context (MMIfaceModem3gpp *self)
+{
+    RegistrationChecksContext *ctx;
+
+    if (G_UNLIKELY (!registration_checks_context_quark))
+        registration_checks_context_quark = (g_quark_from_static_string (
+                                                 REGISTRATION_CHECKS_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), registration_checks_context_quark);
+    if (!ctx) {
+        ctx = g_slice_new0 (RegistrationChecksContext);
+        g_object_set_qdata_full (G_OBJECT (self),
+                                 registration_checks_context_quark,
+                                 ctx,
+                                 (GDestroyNotify)registration_checks_context_free);
+    }
+
+    return ctx;
+}
+
+static void
+registration_checks_set_result (GSimpleAsyncResult *simple,
+                                const GError *error)
+{
+    if (error)
+        g_simple_async_result_set_from_error (simple, error);
+    else
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+}
+
 gboolean
 mm_iface_modem_3gpp_run_registration_checks_finish (MMIfaceModem3gpp *self,
                                                     GAsyncResult *res,
                                                     GError **error)
 {
-    g_assert (MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->run_registration_checks_finish != NULL);
-    return MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->run_registration_checks_finish (self, res, error);
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+registration_checks_ready (MMIfaceModem3gpp *self,
+                           GAsyncResult *res)
+{
+    RegistrationChecksContext *ctx;
+    GList *waiting;
+    GList *l;
+
+    ctx = get_registration_checks_context (self);
+
+    g_clear_error (&ctx->last_error);
+    MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->run_registration_checks_finish (self, res, &ctx->last_error);
+    ctx->last_completed = mm_clock_get_time ();
+    ctx->running = FALSE;
+
+    /* Callbacks may request new checks, which must not find the list of
+     * the ones being completed */
+    waiting = ctx->waiting;
+    ctx->waiting = NULL;
+    for (l = waiting; l; l = g_list_next (l)) {
+        GSimpleAsyncResult *simple = l->data;
+
+        registration_checks_set_result (simple, ctx->last_error);
+        g_simple_async_result_complete (simple);
+        g_object_unref (simple);
+    }
+    g_list_free (waiting);
 }
 
 void
@@ -743,11 +871,41 @@ mm_iface_modem_3gpp_run_registration_checks (MMIfaceModem3gpp *self,
                                              GAsyncReadyCallback callback,
                                              gpointer user_data)
 {
+    RegistrationChecksContext *ctx;
+    GSimpleAsyncResult *simple;
     gboolean cs_supported = FALSE;
     gboolean ps_supported = FALSE;
     gboolean eps_supported = FALSE;
 
     g_assert (MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->run_registration_checks != NULL);
+    g_assert (MM_IFACE_MODEM_3GPP_GET_INTERFACE (self)->run_registration_checks_finish != NULL);
+
+    simple = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        mm_iface_modem_3gpp_run_registration_checks);
+
+    ctx = get_registration_checks_context (self);
+
+    /* Join the checks in progress */
+    if (ctx->running) {
+        mm_dbg ("Registration checks already running, waiting for them");
+        ctx->waiting = g_list_append (ctx->waiting, simple);
+        return;
+    }
+
+    /* Reuse the result of checks just completed */
+    if (ctx->last_completed &&
+        mm_clock_get_time () - ctx->last_completed < REGISTRATION_CHECKS_FRESH_USEC) {
+        mm_dbg ("Registration checks just completed, reusing their result");
+        registration_checks_set_result (simple, ctx->last_error);
+        g_simple_async_result_complete_in_idle (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    ctx->running = TRUE;
+    ctx->waiting = g_list_append (ctx->waiting, simple);
 
     g_object_get (self,
                   MM_IFACE_MODEM_3GPP_CS_NETWORK_SUPPORTED, &cs_supported,
@@ -764,8 +922,8 @@ mm_iface_modem_3gpp_run_registration_checks (MMIfaceModem3gpp *self,
                                                                        cs_supported,
                                                                        ps_supported,
                                                                        eps_supported,
-                                                                       callback,
-                                                                       user_data);
+                                                                       (GAsyncReadyCallback)registration_checks_ready,
+                                                                       NULL);
 }
 
 /*****************************************************************************/
@@ -814,8 +972,10 @@ load_operator_name_ready (MMIfaceModem3gpp *self,
         g_error_free (error);
     }
 
-    if (ctx->skeleton)
+    if (ctx->skeleton) {
         mm_gdbus_modem3gpp_set_operator_name (ctx->skeleton, str);
+        mm_status_segment_update_modem (MM_BASE_MODEM (self));
+    }
     g_free (str);
 
     ctx->operator_name_loaded = TRUE;
@@ -864,8 +1024,10 @@ load_operator_code_ready (MMIfaceModem3gpp *self,
         g_error_free (error);
     }
 
-    if (ctx->skeleton)
+    if (ctx->skeleton) {
         mm_gdbus_modem3gpp_set_operator_code (ctx->skeleton, str);
+        mm_status_segment_update_modem (MM_BASE_MODEM (self));
+    }
 
     /* If we also implement the location interface, update the 3GPP location */
     if (str && MM_IS_IFACE_MODEM_LOCATION (self)) {
@@ -998,6 +1160,7 @@ mm_iface_modem_3gpp_clear_current_operator (MMIfaceModem3gpp *self)
 
     mm_gdbus_modem3gpp_set_operator_code (skeleton, NULL);
     mm_gdbus_modem3gpp_set_operator_name (skeleton, NULL);
+    mm_status_segment_update_modem (MM_BASE_MODEM (self));
     if (MM_IS_IFACE_MODEM_LOCATION (self))
         mm_iface_modem_location_3gpp_update_mcc_mnc (MM_IFACE_MODEM_LOCATION (self), 0, 0);
 }
@@ -1017,6 +1180,12 @@ clear_subscription_state (MMIfaceModem3gpp *self)
 
 /*****************************************************************************/
 
+typedef struct {
+    guint timeout_source;
+    gboolean running;
+    gboolean access_tech_reported;
+} RegistrationCheckContext;
+
 void
 mm_iface_modem_3gpp_update_access_technologies (MMIfaceModem3gpp *self,
                                                 MMModemAccessTechnology access_tech)
@@ -1036,10 +1205,20 @@ mm_iface_modem_3gpp_update_access_technologies (MMIfaceModem3gpp *self,
     if (state == MM_MODEM_3GPP_REGISTRATION_STATE_HOME ||
         state == MM_MODEM_3GPP_REGISTRATION_STATE_ROAMING ||
         ctx->reloading_registration_info) {
-        if (access_tech != MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN)
+        if (access_tech != MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN) {
+            RegistrationCheckContext *check_ctx;
+
+            /* Let an ongoing periodic check know it needn't query it again */
+            check_ctx = (registration_check_context_quark ?
+                         g_object_get_qdata (G_OBJECT (self), registration_check_context_quark) :
+                         NULL);
+            if (check_ctx && check_ctx->running)
+                check_ctx->access_tech_reported = TRUE;
+
             mm_iface_modem_update_access_technologies (MM_IFACE_MODEM (self),
                                                        access_tech,
                                                        MM_IFACE_MODEM_3GPP_ALL_ACCESS_TECHNOLOGIES_MASK);
+        }
     } else
         mm_iface_modem_update_access_technologies (MM_IFACE_MODEM (self),
                                                    MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN,
@@ -1100,6 +1279,7 @@ update_registration_reload_current_registration_info_ready (MMIfaceModem3gpp *se
     g_object_set (self,
                   MM_IFACE_MODEM_3GPP_REGISTRATION_STATE, new_state,
                   NULL);
+    mm_status_segment_update_modem (MM_BASE_MODEM (self));
 
     mm_iface_modem_update_subsystem_state (MM_IFACE_MODEM (self),
                                            SUBSYSTEM_3GPP,
@@ -1131,6 +1311,7 @@ update_non_registered_state (MMIfaceModem3gpp *self,
     g_object_set (self,
                   MM_IFACE_MODEM_3GPP_REGISTRATION_STATE, new_state,
                   NULL);
+    mm_status_segment_update_modem (MM_BASE_MODEM (self));
 
     mm_iface_modem_update_subsystem_state (
         MM_IFACE_MODEM (self),
@@ -1263,16 +1444,11 @@ mm_iface_modem_3gpp_update_subscription_state (MMIfaceModem3gpp *self,
 
 /*****************************************************************************/
 
-typedef struct {
-    guint timeout_source;
-    gboolean running;
-} RegistrationCheckContext;
-
 static void
 registration_check_context_free (RegistrationCheckContext *ctx)
 {
     if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+        mm_poll_scheduler_remove (ctx->timeout_source);
     g_free (ctx);
 }
 
@@ -1291,8 +1467,14 @@ periodic_registration_checks_ready (MMIfaceModem3gpp *self,
 
     /* Remove the running tag */
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
-    if (ctx)
-        ctx->running = FALSE;
+    if (!ctx)
+        return;
+    ctx->running = FALSE;
+
+    /* Access technologies are checked in the same sequence, unless the
+     * registration replies already gave them */
+    if (!ctx->access_tech_reported)
+        mm_iface_modem_run_coalesced_access_technologies_check (MM_IFACE_MODEM (self));
 }
 
 static gboolean
@@ -1304,6 +1486,7 @@ periodic_registration_check (MMIfaceModem3gpp *self)
     ctx = g_object_get_qdata (G_OBJECT (self), registration_check_context_quark);
     if (!ctx->running) {
         ctx->running = TRUE;
+        ctx->access_tech_reported = FALSE;
         mm_iface_modem_3gpp_run_registration_checks (
             self,
             (GAsyncReadyCallback)periodic_registration_checks_ready,
@@ -1324,6 +1507,9 @@ periodic_registration_check_disable (MMIfaceModem3gpp *self)
                         registration_check_context_quark,
                         NULL);
 
+    /* Access technology checks go back to their own job */
+    mm_iface_modem_coalesce_access_technologies_check (MM_IFACE_MODEM (self), FALSE);
+
     mm_dbg ("Periodic 3GPP registration checks disabled");
 }
 
@@ -1331,6 +1517,15 @@ static void
 periodic_registration_check_enable (MMIfaceModem3gpp *self)
 {
     RegistrationCheckContext *ctx;
+    gboolean periodic_registration_check_disabled = FALSE;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED, &periodic_registration_check_disabled,
+                  NULL);
+    if (periodic_registration_check_disabled) {
+        mm_dbg ("Periodic 3GPP registration checks not required");
+        return;
+    }
 
     if (G_UNLIKELY (!registration_check_context_quark))
         registration_check_context_quark = (g_quark_from_static_string (
@@ -1345,13 +1540,20 @@ periodic_registration_check_enable (MMIfaceModem3gpp *self)
     /* Create context and keep it as object data */
     mm_dbg ("Periodic 3GPP registration checks enabled");
     ctx = g_new0 (RegistrationCheckContext, 1);
-    ctx->timeout_source = g_timeout_add_seconds (REGISTRATION_CHECK_TIMEOUT_SEC,
-                                                 (GSourceFunc)periodic_registration_check,
-                                                 self);
+    ctx->timeout_source = mm_poll_scheduler_add_full ("registration",
+                                                      MM_POLL_SCHEDULER_STAGE_REGISTRATION,
+                                                      REGISTRATION_CHECK_TIMEOUT_SEC,
+                                                      MM_POLL_SCHEDULER_DEFAULT_SLACK (REGISTRATION_CHECK_TIMEOUT_SEC),
+                                                      (GSourceFunc)periodic_registration_check,
+                                                      self);
     g_object_set_qdata_full (G_OBJECT (self),
                              registration_check_context_quark,
                              ctx,
                              (GDestroyNotify)registration_check_context_free);
+
+    /* A single status poll: access technologies are checked right after the
+     * registration state, in the same wakeup */
+    mm_iface_modem_coalesce_access_technologies_check (MM_IFACE_MODEM (self), TRUE);
 }
 
 /*****************************************************************************/
@@ -1936,6 +2138,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "3GPP interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Fall down to next step */
@@ -2138,6 +2345,14 @@ iface_modem_3gpp_init (gpointer g_iface)
                              MM_MODEM_3GPP_FACILITY_NONE,
                              G_PARAM_READWRITE));
 
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_boolean (MM_IFACE_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED,
+                               "Periodic registration check disabled",
+                               "Whether periodic registration check is disabled.",
+                               FALSE,
+                               G_PARAM_READWRITE));
+
     initialized = TRUE;
 }
 
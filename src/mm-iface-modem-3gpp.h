@@ -34,6 +34,7 @@
 #define MM_IFACE_MODEM_3GPP_PS_NETWORK_SUPPORTED    "iface-modem-3gpp-ps-network-supported"
 #define MM_IFACE_MODEM_3GPP_EPS_NETWORK_SUPPORTED   "iface-modem-3gpp-eps-network-supported"
 #define MM_IFACE_MODEM_3GPP_IGNORED_FACILITY_LOCKS  "iface-modem-3gpp-ignored-facility-locks"
+#define MM_IFACE_MODEM_3GPP_PERIODIC_REGISTRATION_CHECK_DISABLED "iface-modem-3gpp-periodic-registration-check-disabled"
 
 #define MM_IFACE_MODEM_3GPP_ALL_ACCESS_TECHNOLOGIES_MASK    \
     (MM_MODEM_ACCESS_TECHNOLOGY_GSM |                       \
@@ -242,6 +243,11 @@ void mm_iface_modem_3gpp_update_location            (MMIfaceModem3gpp *self,
                                                      gulong location_area_code,
                                                      gulong cell_id);
 
+/* Objects implementing this interface can report the networks found while a
+ * scan is still in progress, given as a list of MM3gppNetworkInfo */
+void mm_iface_modem_3gpp_report_scanned_networks (MMIfaceModem3gpp *self,
+                                                  GList *info_list);
+
 /* Run all registration checks */
 void mm_iface_modem_3gpp_run_registration_checks (MMIfaceModem3gpp *self,
                                                   GAsyncReadyCallback callback,
@@ -23,7 +23,10 @@
 #include "mm-iface-modem-cdma.h"
 #include "mm-base-modem.h"
 #include "mm-modem-helpers.h"
+#include "mm-clock.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define REGISTRATION_CHECK_TIMEOUT_SEC 30
 
@@ -95,8 +98,10 @@ handle_activate_ready (MMIfaceModemCdma *self,
 
     if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->activate_finish (self, res,&error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_cdma_complete_activate (ctx->skeleton, ctx->invocation);
+    }
 
     handle_activate_context_free (ctx);
 }
@@ -118,6 +123,7 @@ handle_activate_auth_ready (MMBaseModem *self,
     /* If we're already activated, nothing to do */
     if (mm_gdbus_modem_cdma_get_activation_state (ctx->skeleton) == MM_MODEM_CDMA_ACTIVATION_STATE_ACTIVATED) {
         mm_dbg ("Modem is already activated");
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_cdma_complete_activate (ctx->skeleton, ctx->invocation);
         handle_activate_context_free (ctx);
         return;
@@ -249,8 +255,10 @@ handle_activate_manual_ready (MMIfaceModemCdma *self,
 
     if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->activate_manual_finish (self, res,&error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_cdma_complete_activate_manual (ctx->skeleton, ctx->invocation);
+    }
 
     handle_activate_manual_context_free (ctx);
 }
@@ -273,6 +281,7 @@ handle_activate_manual_auth_ready (MMBaseModem *self,
     /* If we're already activated, nothing to do */
     if (mm_gdbus_modem_cdma_get_activation_state (ctx->skeleton) == MM_MODEM_CDMA_ACTIVATION_STATE_ACTIVATED) {
         mm_dbg ("Modem is already activated");
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_cdma_complete_activate_manual (ctx->skeleton, ctx->invocation);
         handle_activate_manual_context_free (ctx);
         return;
@@ -441,16 +450,9 @@ static void registration_check_step (RunRegistrationChecksContext *ctx);
 typedef enum {
     REGISTRATION_CHECK_STEP_FIRST,
     REGISTRATION_CHECK_STEP_SETUP_REGISTRATION_CHECKS,
-
-    REGISTRATION_CHECK_STEP_QCDM_CALL_MANAGER_STATE,
-    REGISTRATION_CHECK_STEP_QCDM_HDR_STATE,
-    REGISTRATION_CHECK_STEP_QCDM_CDMA1X_SERVING_SYSTEM,
-    REGISTRATION_CHECK_STEP_QCDM_LAST,
-
-    REGISTRATION_CHECK_STEP_AT_CDMA_SERVICE_STATUS,
-    REGISTRATION_CHECK_STEP_AT_CDMA1X_SERVING_SYSTEM,
-    REGISTRATION_CHECK_STEP_AT_LAST,
-
+    REGISTRATION_CHECK_STEP_QCDM_AND_AT_CHECKS,
+    REGISTRATION_CHECK_STEP_QCDM_RESULTS,
+    REGISTRATION_CHECK_STEP_AT_RESULTS,
     REGISTRATION_CHECK_STEP_DETAILED_REGISTRATION_STATE,
     REGISTRATION_CHECK_STEP_LAST,
 } RegistrationCheckStep;
@@ -470,6 +472,10 @@ struct _RunRegistrationChecksContext {
     gboolean skip_at_cdma1x_serving_system_step;
     gboolean skip_detailed_registration_state;
 
+    /* QCDM and AT checks run at the same time, each on its own port */
+    guint n_pending;
+
+    gboolean qcdm_ok;
     guint call_manager_system_mode;
     guint call_manager_operating_mode;
 
@@ -477,6 +483,15 @@ struct _RunRegistrationChecksContext {
     guint8 hdr_almp_state;
     guint8 hdr_hybrid_mode;
 
+    gboolean service_status_run;
+    gboolean has_service;
+    GError *service_status_error;
+
+    gboolean serving_system_run;
+    GError *serving_system_error;
+    guint serving_system_sid;
+    guint serving_system_nid;
+
     guint cdma1x_class;
     guint cdma1x_band;
     guint cdma1x_sid;
@@ -487,6 +502,10 @@ static void
 run_registration_checks_context_complete_and_free (RunRegistrationChecksContext *ctx)
 {
     g_simple_async_result_complete_in_idle (ctx->result);
+    if (ctx->service_status_error)
+        g_error_free (ctx->service_status_error);
+    if (ctx->serving_system_error)
+        g_error_free (ctx->serving_system_error);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
     g_free (ctx);
@@ -527,6 +546,41 @@ setup_registration_checks_ready (MMIfaceModemCdma *self,
     registration_check_step (ctx);
 }
 
+static void
+qcdm_and_at_check_done (RunRegistrationChecksContext *ctx)
+{
+    g_assert (ctx->n_pending > 0);
+    if (--ctx->n_pending > 0)
+        return;
+
+    /* All checks are done, merge their results */
+    ctx->step++;
+    registration_check_step (ctx);
+}
+
+static void
+get_hdr_state_ready (MMIfaceModemCdma *self,
+                     GAsyncResult *res,
+                     RunRegistrationChecksContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state_finish (
+            self,
+            res,
+            &ctx->hdr_hybrid_mode,
+            &ctx->hdr_session_state,
+            &ctx->hdr_almp_state,
+            &error)) {
+        mm_dbg ("Could not get HDR state: %s", error->message);
+        g_error_free (error);
+        /* Fallback to AT-based check */
+        ctx->qcdm_ok = FALSE;
+    }
+
+    qcdm_and_at_check_done (ctx);
+}
+
 static void
 get_call_manager_state_ready (MMIfaceModemCdma *self,
                               GAsyncResult *res,
@@ -543,48 +597,92 @@ get_call_manager_state_ready (MMIfaceModemCdma *self,
         mm_dbg ("Could not get call manager state: %s", error->message);
         g_error_free (error);
         /* Fallback to AT-based check */
-        ctx->step = REGISTRATION_CHECK_STEP_AT_CDMA_SERVICE_STATUS;
-        registration_check_step (ctx);
+        qcdm_and_at_check_done (ctx);
         return;
     }
 
-    /* If no CDMA service, just finish checks */
-    if (ctx->call_manager_operating_mode != QCDM_CMD_CM_SUBSYS_STATE_INFO_OPERATING_MODE_ONLINE) {
-        ctx->step = REGISTRATION_CHECK_STEP_LAST;
-        registration_check_step (ctx);
+    ctx->qcdm_ok = TRUE;
+
+    /* If no CDMA service, no need to look at HDR */
+    if (ctx->call_manager_operating_mode == QCDM_CMD_CM_SUBSYS_STATE_INFO_OPERATING_MODE_ONLINE &&
+        ctx->evdo_supported &&
+        !ctx->skip_qcdm_hdr_step &&
+        MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state &&
+        MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state_finish) {
+        /* Get HDR (EVDO) state. */
+        MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state (
+            self,
+            (GAsyncReadyCallback)get_hdr_state_ready,
+            ctx);
         return;
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    registration_check_step (ctx);
+    mm_dbg ("  Skipping HDR check");
+    qcdm_and_at_check_done (ctx);
 }
 
 static void
-get_hdr_state_ready (MMIfaceModemCdma *self,
-                     GAsyncResult *res,
-                     RunRegistrationChecksContext *ctx)
+get_service_status_ready (MMIfaceModemCdma *self,
+                          GAsyncResult *res,
+                          RunRegistrationChecksContext *ctx)
 {
-    GError *error = NULL;
+    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_service_status_finish (self,
+                                                                              res,
+                                                                              &ctx->has_service,
+                                                                              &ctx->service_status_error))
+        mm_dbg ("Could not get service status: %s", ctx->service_status_error->message);
 
-    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_hdr_state_finish (
+    qcdm_and_at_check_done (ctx);
+}
+
+static void
+get_cdma1x_serving_system_ready (MMIfaceModemCdma *self,
+                                 GAsyncResult *res,
+                                 RunRegistrationChecksContext *ctx)
+{
+    /* Note: used for *both* AT and QCDM serving system checks */
+
+    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_cdma1x_serving_system_finish (
             self,
             res,
-            &ctx->hdr_hybrid_mode,
-            &ctx->hdr_session_state,
-            &ctx->hdr_almp_state,
-            &error)) {
-        mm_dbg ("Could not get HDR state: %s", error->message);
-        g_error_free (error);
-        /* Fallback to AT-based check */
-        ctx->step = REGISTRATION_CHECK_STEP_AT_CDMA_SERVICE_STATUS;
-        registration_check_step (ctx);
-        return;
+            &ctx->cdma1x_class,
+            &ctx->cdma1x_band,
+            &ctx->serving_system_sid,
+            &ctx->serving_system_nid,
+            &ctx->serving_system_error))
+        mm_dbg ("Could not get serving system: %s", ctx->serving_system_error->message);
+
+    /* TODO: not sure why we also take class/band here */
+
+    qcdm_and_at_check_done (ctx);
+}
+
+static gboolean
+apply_cdma1x_serving_system (RunRegistrationChecksContext *ctx)
+{
+    if (!ctx->serving_system_run)
+        return TRUE;
+
+    if (ctx->serving_system_error) {
+        /* Treat as fatal all errors except for no-network */
+        if (!g_error_matches (ctx->serving_system_error,
+                              MM_MOBILE_EQUIPMENT_ERROR,
+                              MM_MOBILE_EQUIPMENT_ERROR_NO_NETWORK)) {
+            mm_warn ("Could not get serving system: %s", ctx->serving_system_error->message);
+            g_simple_async_result_take_error (ctx->result, ctx->serving_system_error);
+            ctx->serving_system_error = NULL;
+            run_registration_checks_context_complete_and_free (ctx);
+            return FALSE;
+        }
+
+        ctx->cdma1x_sid = MM_MODEM_CDMA_SID_UNKNOWN;
+        ctx->cdma1x_nid = MM_MODEM_CDMA_NID_UNKNOWN;
+        return TRUE;
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    registration_check_step (ctx);
+    ctx->cdma1x_sid = ctx->serving_system_sid;
+    ctx->cdma1x_nid = ctx->serving_system_nid;
+    return TRUE;
 }
 
 static void
@@ -595,6 +693,18 @@ parse_qcdm_results (RunRegistrationChecksContext *ctx)
     mm_dbg ("QCDM HDR Session State: %d", ctx->hdr_session_state);
     mm_dbg ("QCDM HDR ALMP State: %d", ctx->hdr_almp_state);
 
+    /* If no CDMA service, just finish checks */
+    if (ctx->call_manager_operating_mode != QCDM_CMD_CM_SUBSYS_STATE_INFO_OPERATING_MODE_ONLINE) {
+        ctx->step = REGISTRATION_CHECK_STEP_LAST;
+        registration_check_step (ctx);
+        return;
+    }
+
+    /* We only care about SID/NID here; nothing to do with registration
+     * state. */
+    if (!apply_cdma1x_serving_system (ctx))
+        return;
+
     /* Set QCDM-obtained registration info */
     switch (ctx->call_manager_system_mode) {
     case QCDM_CMD_CM_SUBSYS_STATE_INFO_SYSTEM_MODE_CDMA:
@@ -627,75 +737,35 @@ parse_qcdm_results (RunRegistrationChecksContext *ctx)
 }
 
 static void
-get_service_status_ready (MMIfaceModemCdma *self,
-                          GAsyncResult *res,
-                          RunRegistrationChecksContext *ctx)
-{
-    GError *error = NULL;
-    gboolean has_service = FALSE;
-
-    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_service_status_finish (self,
-                                                                              res,
-                                                                              &has_service,
-                                                                              &error)) {
-        mm_warn ("Could not get service status: %s", error->message);
-        g_simple_async_result_take_error (ctx->result, error);
-        run_registration_checks_context_complete_and_free (ctx);
-        return;
-    }
-
-    if (!has_service) {
-        /* There is no CDMA service at all, end registration checks */
-        mm_dbg ("No CDMA service found");
-        ctx->step = REGISTRATION_CHECK_STEP_LAST;
-    } else
-        /* If we do have service, go on to next step */
-        ctx->step++;
-
-    registration_check_step (ctx);
-}
-
-static void
-get_cdma1x_serving_system_ready (MMIfaceModemCdma *self,
-                                 GAsyncResult *res,
-                                 RunRegistrationChecksContext *ctx)
+parse_at_results (RunRegistrationChecksContext *ctx)
 {
-    GError *error = NULL;
-
-    /* Note: used for *both* AT and QCDM serving system checks */
-
-    if (!MM_IFACE_MODEM_CDMA_GET_INTERFACE (self)->get_cdma1x_serving_system_finish (
-            self,
-            res,
-            &ctx->cdma1x_class,
-            &ctx->cdma1x_band,
-            &ctx->cdma1x_sid,
-            &ctx->cdma1x_nid,
-            &error)) {
-        /* Treat as fatal all errors except for no-network */
-        if (!g_error_matches (error,
-                              MM_MOBILE_EQUIPMENT_ERROR,
-                              MM_MOBILE_EQUIPMENT_ERROR_NO_NETWORK)) {
-            mm_warn ("Could not get serving system: %s", error->message);
-            g_simple_async_result_take_error (ctx->result, error);
+    /* If we don't have means to get service status, just assume we do have
+     * CDMA service and keep on */
+    if (ctx->service_status_run) {
+        if (ctx->service_status_error) {
+            mm_warn ("Could not get service status: %s", ctx->service_status_error->message);
+            g_simple_async_result_take_error (ctx->result, ctx->service_status_error);
+            ctx->service_status_error = NULL;
             run_registration_checks_context_complete_and_free (ctx);
             return;
         }
 
-        ctx->cdma1x_sid = MM_MODEM_CDMA_SID_UNKNOWN;
-        ctx->cdma1x_nid = MM_MODEM_CDMA_NID_UNKNOWN;
+        if (!ctx->has_service) {
+            /* There is no CDMA service at all, end registration checks */
+            mm_dbg ("No CDMA service found");
+            ctx->step = REGISTRATION_CHECK_STEP_LAST;
+            registration_check_step (ctx);
+            return;
+        }
     }
 
-    /* TODO: not sure why we also take class/band here */
-
-    /* Go on to next step */
-    ctx->step++;
-    registration_check_step (ctx);
-}
+    /* The serving system may have been queried only for the QCDM-based
+     * checks, in which case it must be ignored here */
+    if (ctx->skip_at_cdma1x_serving_system_step)
+        mm_dbg ("  Skipping CDMA1x Serving System check");
+    else if (!apply_cdma1x_serving_system (ctx))
+        return;
 
-static void
-parse_at_results (RunRegistrationChecksContext *ctx)
-{
     /* 99999 means unknown/no service */
     if (ctx->cdma1x_sid == MM_MODEM_CDMA_SID_UNKNOWN &&
         ctx->cdma1x_nid == MM_MODEM_CDMA_NID_UNKNOWN) {
@@ -764,105 +834,74 @@ registration_check_step (RunRegistrationChecksContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
-    case REGISTRATION_CHECK_STEP_QCDM_CALL_MANAGER_STATE:
-        mm_dbg ("Starting QCDM-based registration checks");
-        if (!ctx->skip_qcdm_call_manager_step &&
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_call_manager_state &&
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_call_manager_state_finish) {
-            /* Start by trying to get the call manager state. */
+    case REGISTRATION_CHECK_STEP_QCDM_AND_AT_CHECKS: {
+        gboolean run_qcdm;
+
+        /* The QCDM-based checks and the AT-based ones go through different
+         * ports, so launch them all at once instead of only trying the AT
+         * ones after the QCDM ones failed. The pending count starts at one, so
+         * that the merge doesn't happen before all of them are launched. */
+        ctx->n_pending = 1;
+
+        run_qcdm = (!ctx->skip_qcdm_call_manager_step &&
+                    MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_call_manager_state &&
+                    MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_call_manager_state_finish);
+        if (run_qcdm) {
+            mm_dbg ("Starting QCDM-based registration checks");
+            ctx->n_pending++;
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_call_manager_state (
                 ctx->self,
                 (GAsyncReadyCallback)get_call_manager_state_ready,
                 ctx);
-            return;
-        }
-        /* Fallback to AT-based check */
-        mm_dbg ("  Skipping all QCDM-based checks and falling back to AT-based checks");
-        ctx->step = REGISTRATION_CHECK_STEP_AT_CDMA_SERVICE_STATUS;
-        registration_check_step (ctx);
-        return;
-
-    case REGISTRATION_CHECK_STEP_QCDM_HDR_STATE:
-        if (ctx->evdo_supported &&
-            !ctx->skip_qcdm_hdr_step &&
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_hdr_state &&
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_hdr_state_finish) {
-            /* Get HDR (EVDO) state. */
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_hdr_state (
-                ctx->self,
-                (GAsyncReadyCallback)get_hdr_state_ready,
-                ctx);
-            return;
-        }
-        mm_dbg ("  Skipping HDR check");
-        /* Fall down to next step */
-        ctx->step++;
-
-    case REGISTRATION_CHECK_STEP_QCDM_CDMA1X_SERVING_SYSTEM:
-        /* We only care about SID/NID here; nothing to do with registration
-         * state.
-         */
-        if (MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system &&
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system_finish) {
-            MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system (
-                ctx->self,
-                (GAsyncReadyCallback)get_cdma1x_serving_system_ready,
-                ctx);
-            return;
-        }
-        mm_dbg ("  Skipping CDMA1x Serving System check");
-        /* Fall down to next step */
-        ctx->step++;
+        } else
+            mm_dbg ("  Skipping all QCDM-based checks and falling back to AT-based checks");
 
-    case REGISTRATION_CHECK_STEP_QCDM_LAST:
-        /* When we get all QCDM results, parse them */
-        parse_qcdm_results (ctx);
-        return;
-
-    case REGISTRATION_CHECK_STEP_AT_CDMA_SERVICE_STATUS:
         mm_dbg ("Starting AT-based registration checks");
-
-        /* If we don't have means to get service status, just assume we do have
-         * CDMA service and keep on */
         if (!ctx->skip_at_cdma_service_status_step &&
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_service_status &&
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_service_status_finish) {
+            ctx->service_status_run = TRUE;
+            ctx->n_pending++;
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_service_status (
                 ctx->self,
                 (GAsyncReadyCallback)get_service_status_ready,
                 ctx);
-            return;
-        }
-        mm_dbg ("  Skipping CDMA service status check, assuming with service");
-        /* Fall down to next step */
-        ctx->step++;
-
-    case REGISTRATION_CHECK_STEP_AT_CDMA1X_SERVING_SYSTEM:
-        /* Now that we have some sort of service, check if the the device is
-         * registered on the network.
-         */
+        } else
+            mm_dbg ("  Skipping CDMA service status check, assuming with service");
 
         /* Some devices key the AT+CSS? response off the 1X state, but if the
          * device has EVDO service but no 1X service, then reading AT+CSS? will
          * error out too early.  Let subclasses that know that their AT+CSS?
          * response is wrong in this case handle more specific registration
          * themselves; if they do, they'll set these callbacks to NULL..
+         * The QCDM-based checks always need it, though.
          */
-        if (!ctx->skip_at_cdma1x_serving_system_step &&
+        if ((run_qcdm || !ctx->skip_at_cdma1x_serving_system_step) &&
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system &&
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system_finish) {
+            ctx->serving_system_run = TRUE;
+            ctx->n_pending++;
             MM_IFACE_MODEM_CDMA_GET_INTERFACE (ctx->self)->get_cdma1x_serving_system (
                 ctx->self,
                 (GAsyncReadyCallback)get_cdma1x_serving_system_ready,
                 ctx);
+        } else
+            mm_dbg ("  Skipping CDMA1x Serving System check");
+
+        qcdm_and_at_check_done (ctx);
+        return;
+    }
+
+    case REGISTRATION_CHECK_STEP_QCDM_RESULTS:
+        /* QCDM results are preferred, when we got them */
+        if (ctx->qcdm_ok) {
+            parse_qcdm_results (ctx);
             return;
         }
-        mm_dbg ("  Skipping CDMA1x Serving System check");
         /* Fall down to next step */
         ctx->step++;
 
-    case REGISTRATION_CHECK_STEP_AT_LAST:
-        /* When we get all AT results, parse them */
+    case REGISTRATION_CHECK_STEP_AT_RESULTS:
         parse_at_results (ctx);
         return;
 
@@ -1196,9 +1235,9 @@ periodic_registration_check_enable (MMIfaceModemCdma *self)
     /* Create context and keep it as object data */
     mm_dbg ("Periodic CDMA registration checks enabled");
     ctx = g_new0 (RegistrationCheckContext, 1);
-    ctx->timeout_source = g_timeout_add_seconds (REGISTRATION_CHECK_TIMEOUT_SEC,
-                                                 (GSourceFunc)periodic_registration_check,
-                                                 self);
+    ctx->timeout_source = mm_clock_timeout_add_seconds (REGISTRATION_CHECK_TIMEOUT_SEC,
+                                                        (GSourceFunc)periodic_registration_check,
+                                                        self);
     g_object_set_qdata_full (G_OBJECT (self),
                              registration_check_context_quark,
                              ctx,
@@ -1681,6 +1720,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "CDMA interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Fall down to next step */
@@ -19,7 +19,9 @@
 
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-firmware.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define SUPPORT_CHECKED_TAG "firmware-support-checked-tag"
 #define SUPPORTED_TAG       "firmware-supported-tag"
@@ -36,23 +38,95 @@ mm_iface_modem_firmware_bind_simple_status (MMIfaceModemFirmware *self,
 }
 
 /*****************************************************************************/
-/* Handle the 'List' method from DBus */
+/* Firmware list cache
+ *
+ * Loading the list of installed images may need several slow vendor
+ * specific queries, so it is loaded on first use and then kept until a
+ * firmware change or a reset happens. List requests received while the
+ * list is being loaded all wait for that same load.
+ */
+
+#define LIST_CACHE_TAG "firmware-list-cache-tag"
+
+static GQuark list_cache_quark;
+
+typedef struct _HandleListContext HandleListContext;
 
 typedef struct {
+    /* Cached list, valid if loaded_time != 0 */
+    GList *list;
+    MMFirmwareProperties *current;
+    gint64 loaded_time;
+    /* Incremented each time the cache is invalidated */
+    guint generation;
+    /* List requests waiting for an ongoing load */
+    GList *waiters;
+} ListCache;
+
+static void
+list_cache_clear (ListCache *cache)
+{
+    if (cache->list) {
+        g_list_free_full (cache->list, (GDestroyNotify)g_object_unref);
+        cache->list = NULL;
+    }
+    g_clear_object (&cache->current);
+    cache->loaded_time = 0;
+}
+
+static void
+list_cache_free (ListCache *cache)
+{
+    /* No waiters may be left, as they hold a reference to the modem */
+    g_assert (cache->waiters == NULL);
+    list_cache_clear (cache);
+    g_slice_free (ListCache, cache);
+}
+
+static ListCache *
+get_list_cache (MMIfaceModemFirmware *self)
+{
+    ListCache *cache;
+
+    if (G_UNLIKELY (!list_cache_quark))
+        list_cache_quark = g_quark_from_static_string (LIST_CACHE_TAG);
+
+    cache = g_object_get_qdata (G_OBJECT (self), list_cache_quark);
+    if (!cache) {
+        cache = g_slice_new0 (ListCache);
+        g_object_set_qdata_full (G_OBJECT (self),
+                                 list_cache_quark,
+                                 cache,
+                                 (GDestroyNotify)list_cache_free);
+    }
+    return cache;
+}
+
+void
+mm_iface_modem_firmware_invalidate_list (MMIfaceModemFirmware *self)
+{
+    ListCache *cache;
+
+    cache = get_list_cache (self);
+    if (cache->loaded_time)
+        mm_dbg ("Firmware list cache invalidated");
+    list_cache_clear (cache);
+    /* Results of any ongoing load are no longer valid for caching */
+    cache->generation++;
+}
+
+/*****************************************************************************/
+/* Handle the 'List' method from DBus */
+
+struct _HandleListContext {
     MMIfaceModemFirmware *self;
     MmGdbusModemFirmware *skeleton;
     GDBusMethodInvocation *invocation;
-    GList *list;
-    MMFirmwareProperties *current;
-} HandleListContext;
+};
 
 static void
 handle_list_context_free (HandleListContext *ctx)
 {
-    if (ctx->list)
-        g_list_free_full (ctx->list, (GDestroyNotify)g_object_unref);
-    if (ctx->current)
-        g_object_unref (ctx->current);
     g_object_unref (ctx->skeleton);
     g_object_unref (ctx->invocation);
     g_object_unref (ctx->self);
@@ -60,48 +134,103 @@ handle_list_context_free (HandleListContext *ctx)
 }
 
 static void
-load_current_ready (MMIfaceModemFirmware *self,
-                    GAsyncResult *res,
-                    HandleListContext *ctx)
+handle_list_complete (HandleListContext *ctx,
+                      GList *list,
+                      MMFirmwareProperties *current)
 {
     GVariantBuilder builder;
     GList *l;
-    GError *error = NULL;
-
-    /* reported current may be NULL and we don't treat it as error */
-    ctx->current = MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->load_current_finish (self, res, &error);
-    if (error) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        handle_list_context_free (ctx);
-        return;
-    }
 
     /* Build array of dicts */
     g_variant_builder_init (&builder, G_VARIANT_TYPE_ARRAY);
-    for (l = ctx->list; l; l = g_list_next (l))
+    for (l = list; l; l = g_list_next (l))
         g_variant_builder_add_value (
             &builder,
             mm_firmware_properties_get_dictionary (MM_FIRMWARE_PROPERTIES (l->data)));
 
+    mm_dbus_flush_properties (ctx->skeleton);
     mm_gdbus_modem_firmware_complete_list (
         ctx->skeleton,
         ctx->invocation,
-        (ctx->current ? mm_firmware_properties_get_unique_id (ctx->current) : ""),
+        (current ? mm_firmware_properties_get_unique_id (current) : ""),
         g_variant_builder_end (&builder));
     handle_list_context_free (ctx);
 }
 
+typedef struct {
+    MMIfaceModemFirmware *self;
+    guint generation;
+    GList *list;
+} LoadListContext;
+
+static void
+load_list_complete (LoadListContext *ctx,
+                    MMFirmwareProperties *current,
+                    GError *error)
+{
+    ListCache *cache;
+    GList *waiters;
+    GList *l;
+
+    cache = get_list_cache (ctx->self);
+    waiters = cache->waiters;
+    cache->waiters = NULL;
+
+    for (l = waiters; l; l = g_list_next (l)) {
+        HandleListContext *handle_ctx = l->data;
+
+        if (error) {
+            g_dbus_method_invocation_return_gerror (handle_ctx->invocation, error);
+            handle_list_context_free (handle_ctx);
+        } else
+            handle_list_complete (handle_ctx, ctx->list, current);
+    }
+    g_list_free (waiters);
+
+    /* Errors are not cached, and neither is a list loaded before the last
+     * invalidation */
+    if (!error && ctx->generation == cache->generation) {
+        list_cache_clear (cache);
+        cache->list = ctx->list;
+        cache->current = current ? g_object_ref (current) : NULL;
+        cache->loaded_time = g_get_monotonic_time ();
+        ctx->list = NULL;
+    }
+
+    if (ctx->list)
+        g_list_free_full (ctx->list, (GDestroyNotify)g_object_unref);
+    g_object_unref (ctx->self);
+    g_slice_free (LoadListContext, ctx);
+}
+
+static void
+load_current_ready (MMIfaceModemFirmware *self,
+                    GAsyncResult *res,
+                    LoadListContext *ctx)
+{
+    MMFirmwareProperties *current;
+    GError *error = NULL;
+
+    /* reported current may be NULL and we don't treat it as error */
+    current = MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->load_current_finish (self, res, &error);
+    load_list_complete (ctx, current, error);
+    if (current)
+        g_object_unref (current);
+    if (error)
+        g_error_free (error);
+}
+
 static void
 load_list_ready (MMIfaceModemFirmware *self,
                  GAsyncResult *res,
-                 HandleListContext *ctx)
+                 LoadListContext *ctx)
 {
     GError *error = NULL;
 
     ctx->list = MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->load_list_finish (self, res, &error);
     if (error) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        handle_list_context_free (ctx);
+        load_list_complete (ctx, NULL, error);
+        g_error_free (error);
         return;
     }
 
@@ -116,6 +245,8 @@ list_auth_ready (MMBaseModem *self,
                  HandleListContext *ctx)
 {
     GError *error = NULL;
+    ListCache *cache;
+    LoadListContext *load_ctx;
 
     if (!mm_base_modem_authorize_finish (self, res, &error)) {
         g_dbus_method_invocation_take_error (ctx->invocation, error);
@@ -123,9 +254,28 @@ list_auth_ready (MMBaseModem *self,
         return;
     }
 
+    cache = get_list_cache (MM_IFACE_MODEM_FIRMWARE (self));
+
+    /* Reply right away if we already have the list */
+    if (cache->loaded_time) {
+        mm_dbg ("Firmware list reported from cache (%" G_GINT64_FORMAT "s old)",
+                (g_get_monotonic_time () - cache->loaded_time) / G_USEC_PER_SEC);
+        handle_list_complete (ctx, cache->list, cache->current);
+        return;
+    }
+
+    /* Wait for the ongoing load, if any */
+    cache->waiters = g_list_append (cache->waiters, ctx);
+    if (cache->waiters->next)
+        return;
+
+    load_ctx = g_slice_new0 (LoadListContext);
+    load_ctx->self = g_object_ref (self);
+    load_ctx->generation = cache->generation;
+
     MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->load_list (MM_IFACE_MODEM_FIRMWARE (self),
                                                              (GAsyncReadyCallback)load_list_ready,
-                                                             ctx);
+                                                             load_ctx);
 }
 
 static gboolean
@@ -181,10 +331,15 @@ change_current_ready (MMIfaceModemFirmware *self,
 {
     GError *error = NULL;
 
+    /* The current firmware may have changed even on errors */
+    mm_iface_modem_firmware_invalidate_list (self);
+
     if (!MM_IFACE_MODEM_FIRMWARE_GET_INTERFACE (self)->change_current_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_firmware_complete_select (ctx->skeleton, ctx->invocation);
+    }
     handle_select_context_free (ctx);
 }
 
@@ -251,6 +406,8 @@ struct _InitializationContext {
     GCancellable *cancellable;
     GSimpleAsyncResult *result;
     InitializationStep step;
+    /* Only check support and export, to be initialized on demand */
+    gboolean lazy;
 };
 
 static void
@@ -312,6 +469,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Firmware interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -368,6 +530,16 @@ interface_initialization_step (InitializationContext *ctx)
     case INITIALIZATION_STEP_LAST:
         /* We are done without errors! */
 
+        /* Method invocations are handled once initialized on demand */
+        if (ctx->lazy) {
+            if (!mm_gdbus_object_peek_modem_firmware (MM_GDBUS_OBJECT (ctx->self)))
+                mm_gdbus_object_skeleton_set_modem_firmware (MM_GDBUS_OBJECT_SKELETON (ctx->self),
+                                                 MM_GDBUS_MODEM_FIRMWARE (ctx->skeleton));
+            g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+            initialization_context_complete_and_free (ctx);
+            return;
+        }
+
         /* Handle method invocations */
         g_signal_connect (ctx->skeleton,
                           "handle-list",
@@ -378,9 +550,11 @@ interface_initialization_step (InitializationContext *ctx)
                           G_CALLBACK (handle_select),
                           ctx->self);
 
-        /* Finally, export the new interface */
-        mm_gdbus_object_skeleton_set_modem_firmware (MM_GDBUS_OBJECT_SKELETON (ctx->self),
-                                                     MM_GDBUS_MODEM_FIRMWARE (ctx->skeleton));
+        /* Finally, export the new interface, unless already done to be
+         * initialized on demand */
+        if (!mm_gdbus_object_peek_modem_firmware (MM_GDBUS_OBJECT (ctx->self)))
+            mm_gdbus_object_skeleton_set_modem_firmware (MM_GDBUS_OBJECT_SKELETON (ctx->self),
+                                                         MM_GDBUS_MODEM_FIRMWARE (ctx->skeleton));
 
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         initialization_context_complete_and_free (ctx);
@@ -398,13 +572,9 @@ mm_iface_modem_firmware_initialize_finish (MMIfaceModemFirmware *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
-void
-mm_iface_modem_firmware_initialize (MMIfaceModemFirmware *self,
-                                    GCancellable *cancellable,
-                                    GAsyncReadyCallback callback,
-                                    gpointer user_data)
+static MmGdbusModemFirmware *
+get_or_create_skeleton (MMIfaceModemFirmware *self)
 {
-    InitializationContext *ctx;
     MmGdbusModemFirmware *skeleton = NULL;
 
     /* Did we already create it? */
@@ -418,6 +588,18 @@ mm_iface_modem_firmware_initialize (MMIfaceModemFirmware *self,
                       NULL);
     }
 
+    return skeleton;
+}
+
+static void
+initialization_start (MMIfaceModemFirmware *self,
+                      gboolean lazy,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+    InitializationContext *ctx;
+
     /* Perform async initialization here */
 
     ctx = g_new0 (InitializationContext, 1);
@@ -428,11 +610,30 @@ mm_iface_modem_firmware_initialize (MMIfaceModemFirmware *self,
                                              user_data,
                                              mm_iface_modem_firmware_initialize);
     ctx->step = INITIALIZATION_STEP_FIRST;
-    ctx->skeleton = skeleton;
+    ctx->skeleton = get_or_create_skeleton (self);
+    ctx->lazy = lazy;
 
     interface_initialization_step (ctx);
 }
 
+void
+mm_iface_modem_firmware_initialize_lazy (MMIfaceModemFirmware *self,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data)
+{
+    initialization_start (self, TRUE, cancellable, callback, user_data);
+}
+
+void
+mm_iface_modem_firmware_initialize (MMIfaceModemFirmware *self,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+    initialization_start (self, FALSE, cancellable, callback, user_data);
+}
+
 void
 mm_iface_modem_firmware_shutdown (MMIfaceModemFirmware *self)
 {
@@ -70,6 +70,14 @@ struct _MMIfaceModemFirmware {
 
 GType mm_iface_modem_firmware_get_type (void);
 
+/* Only check support and export the interface with its default property
+ * values, so that it can be initialized on demand later on; finished with
+ * mm_iface_modem_firmware_initialize_finish() */
+void mm_iface_modem_firmware_initialize_lazy (MMIfaceModemFirmware *self,
+                                              GCancellable *cancellable,
+                                              GAsyncReadyCallback callback,
+                                              gpointer user_data);
+
 /* Initialize Firmware interface (async) */
 void     mm_iface_modem_firmware_initialize        (MMIfaceModemFirmware *self,
                                                     GCancellable *cancellable,
@@ -82,6 +90,9 @@ gboolean mm_iface_modem_firmware_initialize_finish (MMIfaceModemFirmware *self,
 /* Shutdown Firmware interface */
 void mm_iface_modem_firmware_shutdown (MMIfaceModemFirmware *self);
 
+/* Drop the cached firmware list, e.g. after a reset */
+void mm_iface_modem_firmware_invalidate_list (MMIfaceModemFirmware *self);
+
 /* Bind properties for simple GetStatus() */
 void mm_iface_modem_firmware_bind_simple_status (MMIfaceModemFirmware *self,
                                                  MMSimpleStatus *status);
@@ -14,16 +14,32 @@
  * Copyright (C) 2012 Lanedo GmbH <aleksander@lanedo.com>
  */
 
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <gio/gunixfdlist.h>
+
 #include <ModemManager.h>
 #define _LIBMM_INSIDE_MM
 #include <libmm-glib.h>
 
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-location.h"
+#include "mm-location-journal.h"
+#include "mm-context.h"
+#include "mm-clock.h"
+#include "mm-memory-budget.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define MM_LOCATION_GPS_REFRESH_TIME_SECS 30
 
+/* Maximum number of NMEA streams open at the same time per modem */
+#define MM_LOCATION_NMEA_STREAMS_MAX 8
+
 #define LOCATION_CONTEXT_TAG "location-context-tag"
 
 static GQuark location_context_quark;
@@ -42,17 +58,52 @@ typedef struct {
     /* 3GPP location */
     MMLocation3gpp *location_3gpp;
     /* GPS location */
-    time_t location_gps_nmea_last_time;
     MMLocationGpsNmea *location_gps_nmea;
-    time_t location_gps_raw_last_time;
     MMLocationGpsRaw *location_gps_raw;
     /* CDMA BS location */
     MMLocationCdmaBs *location_cdma_bs;
+    /* Sources updated but not yet exposed in the Location property; they are
+     * all exposed at once, at most once per refresh window */
+    MMModemLocationSource pending_sources;
+    gint64 last_update_time;
+    guint pending_id;
+    /* Our end of the open NMEA streams */
+    GArray *nmea_streams;
+    /* Location history, opened on first use */
+    MMLocationJournal *journal;
+    gboolean journal_loaded;
+    /* Last serving cell reported in CellChanged, "" if none */
+    gchar *last_cell;
+    /* When the raw GPS source was enabled, until the first fix */
+    gint64 gps_raw_enable_time;
+    /* Whether assistance data was ever injected */
+    gboolean assistance_injected;
 } LocationContext;
 
+static void
+nmea_streams_close (LocationContext *ctx)
+{
+    guint i;
+
+    if (!ctx->nmea_streams)
+        return;
+
+    for (i = 0; i < ctx->nmea_streams->len; i++)
+        close (g_array_index (ctx->nmea_streams, gint, i));
+    g_array_set_size (ctx->nmea_streams, 0);
+}
+
 static void
 location_context_free (LocationContext *ctx)
 {
+    if (ctx->pending_id)
+        g_source_remove (ctx->pending_id);
+    if (ctx->nmea_streams) {
+        nmea_streams_close (ctx);
+        g_array_unref (ctx->nmea_streams);
+    }
+    mm_location_journal_free (ctx->journal);
+    g_free (ctx->last_cell);
     if (ctx->location_3gpp)
         g_object_unref (ctx->location_3gpp);
     if (ctx->location_gps_nmea)
@@ -209,17 +260,70 @@ build_location_dictionary (GVariant *previous,
 
 /*****************************************************************************/
 
+static MMLocationJournal *
+get_location_journal (MMIfaceModemLocation *self,
+                      LocationContext *ctx)
+{
+    MmGdbusModem *modem_skeleton = NULL;
+    gchar *equipment_id = NULL;
+    gchar *basename;
+    gchar *path;
+    GError *error = NULL;
+
+    if (ctx->journal_loaded)
+        return ctx->journal;
+
+    if (!mm_context_get_location_journal_dir ())
+        return NULL;
+
+    /* The history is kept per device, not per modem object */
+    g_object_get (self,
+                  MM_IFACE_MODEM_DBUS_SKELETON, &modem_skeleton,
+                  NULL);
+    if (modem_skeleton) {
+        equipment_id = g_strdup (mm_gdbus_modem_get_equipment_identifier (modem_skeleton));
+        g_object_unref (modem_skeleton);
+    }
+    if (!equipment_id) {
+        /* Not loaded yet; tried again with the next location update */
+        mm_dbg ("Not keeping location history yet: unknown equipment identifier");
+        return NULL;
+    }
+
+    g_strdelimit (equipment_id, G_DIR_SEPARATOR_S, '_');
+    basename = g_strdup_printf ("%s.journal", equipment_id);
+    path = g_build_filename (mm_context_get_location_journal_dir (), basename, NULL);
+    /* Opened only once, failures included, so that they're not reported
+     * on every update */
+    ctx->journal_loaded = TRUE;
+    ctx->journal = mm_location_journal_open (path, MM_LOCATION_JOURNAL_DEFAULT_CAPACITY, &error);
+    if (!ctx->journal) {
+        mm_warn ("Not keeping location history: %s", error->message);
+        g_error_free (error);
+    }
+    g_free (path);
+    g_free (basename);
+    g_free (equipment_id);
+
+    return ctx->journal;
+}
+
+/*****************************************************************************/
+
 static void
-notify_gps_location_update (MMIfaceModemLocation *self,
-                            MmGdbusModemLocation *skeleton,
-                            MMLocationGpsNmea *location_gps_nmea,
-                            MMLocationGpsRaw *location_gps_raw)
+location_updates_flush (MMIfaceModemLocation *self,
+                        MmGdbusModemLocation *skeleton,
+                        LocationContext *ctx)
 {
-    const gchar *dbus_path;
+    MMModemLocationSource sources;
 
-    dbus_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (self));
-    mm_dbg ("Modem %s: GPS location updated",
-            dbus_path);
+    sources = ctx->pending_sources;
+    ctx->pending_sources = MM_MODEM_LOCATION_SOURCE_NONE;
+    ctx->last_update_time = mm_clock_get_time ();
+
+    if (sources & (MM_MODEM_LOCATION_SOURCE_GPS_NMEA | MM_MODEM_LOCATION_SOURCE_GPS_RAW))
+        mm_dbg ("Modem %s: GPS location updated",
+                g_dbus_object_get_object_path (G_DBUS_OBJECT (self)));
 
     /* We only update the property if we are supposed to signal
      * location */
@@ -227,10 +331,154 @@ notify_gps_location_update (MMIfaceModemLocation *self,
         mm_gdbus_modem_location_set_location (
             skeleton,
             build_location_dictionary (mm_gdbus_modem_location_get_location (skeleton),
-                                       NULL,
-                                       location_gps_nmea,
-                                       location_gps_raw,
-                                       NULL));
+                                       (sources & MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI) ? ctx->location_3gpp : NULL,
+                                       (sources & MM_MODEM_LOCATION_SOURCE_GPS_NMEA) ? ctx->location_gps_nmea : NULL,
+                                       (sources & MM_MODEM_LOCATION_SOURCE_GPS_RAW) ? ctx->location_gps_raw : NULL,
+                                       (sources & MM_MODEM_LOCATION_SOURCE_CDMA_BS) ? ctx->location_cdma_bs : NULL));
+
+    if ((sources & (MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI | MM_MODEM_LOCATION_SOURCE_GPS_RAW)) &&
+        get_location_journal (self, ctx))
+        mm_location_journal_append (ctx->journal, ctx->location_3gpp, ctx->location_gps_raw);
+}
+
+static gboolean
+location_updates_flush_cb (MMIfaceModemLocation *self)
+{
+    MmGdbusModemLocation *skeleton;
+    LocationContext *ctx;
+
+    ctx = get_location_context (self);
+    ctx->pending_id = 0;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_LOCATION_DBUS_SKELETON, &skeleton,
+                  NULL);
+    if (skeleton) {
+        location_updates_flush (self, skeleton, ctx);
+        g_object_unref (skeleton);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+location_updates_schedule (MMIfaceModemLocation *self,
+                           MmGdbusModemLocation *skeleton,
+                           MMModemLocationSource sources)
+{
+    LocationContext *ctx;
+    gint64 window;
+    gint64 now;
+
+    ctx = get_location_context (self);
+    ctx->pending_sources |= sources;
+
+    /* Already waiting for the refresh window to end */
+    if (ctx->pending_id)
+        return;
+
+    /* Right away if we're out of the refresh window */
+    window = (gint64) mm_gdbus_modem_location_get_gps_refresh_rate (skeleton) * G_USEC_PER_SEC;
+    now = mm_clock_get_time ();
+    if (!window || !ctx->last_update_time || now - ctx->last_update_time >= window) {
+        location_updates_flush (self, skeleton, ctx);
+        return;
+    }
+
+    ctx->pending_id = mm_clock_timeout_add ((guint) ((ctx->last_update_time + window - now) / 1000) + 1,
+                                            (GSourceFunc) location_updates_flush_cb,
+                                            self);
+}
+
+static void
+nmea_streams_write (LocationContext *ctx,
+                    const gchar *nmea_trace)
+{
+    struct iovec iov[2];
+    struct msghdr msg;
+    gsize len;
+    guint i;
+
+    if (!ctx->nmea_streams || !ctx->nmea_streams->len)
+        return;
+
+    len = strlen (nmea_trace);
+    memset (&msg, 0, sizeof (msg));
+    iov[0].iov_base = (gchar *) nmea_trace;
+    iov[0].iov_len = len;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 1;
+    if (!g_str_has_suffix (nmea_trace, "\r\n")) {
+        iov[1].iov_base = (gchar *) "\r\n";
+        iov[1].iov_len = 2;
+        msg.msg_iovlen = 2;
+        len += 2;
+    }
+
+    for (i = 0; i < ctx->nmea_streams->len; ) {
+        gint fd;
+        gssize sent;
+
+        fd = g_array_index (ctx->nmea_streams, gint, i);
+        sent = sendmsg (fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+        /* Reader not keeping up, skip the trace */
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            i++;
+            continue;
+        }
+
+        /* Reader gone; or trace partially written, so the stream is no
+         * longer aligned to trace boundaries */
+        if (sent < 0 || (gsize) sent != len) {
+            mm_dbg ("Closing NMEA stream: %s",
+                    sent < 0 ? g_strerror (errno) : "reader too slow");
+            close (fd);
+            g_array_remove_index_fast (ctx->nmea_streams, i);
+            continue;
+        }
+
+        i++;
+    }
+}
+
+gsize
+mm_iface_modem_location_get_nmea_size (MMIfaceModemLocation *self)
+{
+    LocationContext *ctx;
+    gchar *full;
+    gsize size;
+
+    ctx = get_location_context (self);
+    if (!ctx->location_gps_nmea)
+        return 0;
+
+    full = mm_location_gps_nmea_build_full (ctx->location_gps_nmea);
+    size = full ? strlen (full) : 0;
+    g_free (full);
+    return size;
+}
+
+/* Reports the time to first fix, once the raw GPS location gets one after
+ * enabling the source */
+static void
+gps_raw_check_first_fix (MmGdbusModemLocation *skeleton,
+                         LocationContext *ctx)
+{
+    guint ttff;
+
+    if (!ctx->gps_raw_enable_time ||
+        mm_location_gps_raw_get_latitude (ctx->location_gps_raw) == MM_LOCATION_LATITUDE_UNKNOWN ||
+        mm_location_gps_raw_get_longitude (ctx->location_gps_raw) == MM_LOCATION_LONGITUDE_UNKNOWN)
+        return;
+
+    ttff = (guint) ((mm_clock_get_time () - ctx->gps_raw_enable_time) / 1000);
+    ctx->gps_raw_enable_time = 0;
+
+    mm_info ("GPS fix acquired in %u.%03us%s",
+             ttff / 1000, ttff % 1000,
+             ctx->assistance_injected ? " (with assistance data)" : "");
+    mm_gdbus_modem_location_set_time_to_first_fix (skeleton, ttff);
 }
 
 void
@@ -239,8 +487,7 @@ mm_iface_modem_location_gps_update (MMIfaceModemLocation *self,
 {
     MmGdbusModemLocation *skeleton;
     LocationContext *ctx;
-    gboolean update_nmea = FALSE;
-    gboolean update_raw = FALSE;
+    MMModemLocationSource updated = MM_MODEM_LOCATION_SOURCE_NONE;
 
     ctx = get_location_context (self);
     g_object_get (self,
@@ -249,37 +496,103 @@ mm_iface_modem_location_gps_update (MMIfaceModemLocation *self,
     if (!skeleton)
         return;
 
+    nmea_streams_write (ctx, nmea_trace);
+
     if (mm_gdbus_modem_location_get_enabled (skeleton) & MM_MODEM_LOCATION_SOURCE_GPS_NMEA) {
         g_assert (ctx->location_gps_nmea != NULL);
-        if (mm_location_gps_nmea_add_trace (ctx->location_gps_nmea, nmea_trace) &&
-            (ctx->location_gps_nmea_last_time == 0 ||
-             time (NULL) - ctx->location_gps_nmea_last_time >= mm_gdbus_modem_location_get_gps_refresh_rate (skeleton))) {
-            ctx->location_gps_nmea_last_time = time (NULL);
-            update_nmea = TRUE;
-        }
+        if (mm_location_gps_nmea_add_trace (ctx->location_gps_nmea, nmea_trace))
+            updated |= MM_MODEM_LOCATION_SOURCE_GPS_NMEA;
     }
 
     if (mm_gdbus_modem_location_get_enabled (skeleton) & MM_MODEM_LOCATION_SOURCE_GPS_RAW) {
         g_assert (ctx->location_gps_raw != NULL);
-        if (mm_location_gps_raw_add_trace (ctx->location_gps_raw, nmea_trace) &&
-            (ctx->location_gps_raw_last_time == 0 ||
-             time (NULL) - ctx->location_gps_raw_last_time >= mm_gdbus_modem_location_get_gps_refresh_rate (skeleton))) {
-            ctx->location_gps_raw_last_time = time (NULL);
-            update_raw = TRUE;
+        if (mm_location_gps_raw_add_trace (ctx->location_gps_raw, nmea_trace)) {
+            updated |= MM_MODEM_LOCATION_SOURCE_GPS_RAW;
+            gps_raw_check_first_fix (skeleton, ctx);
         }
     }
 
-    if (update_nmea || update_raw)
-        notify_gps_location_update (self,
-                                    skeleton,
-                                    update_nmea ? ctx->location_gps_nmea : NULL,
-                                    update_raw ? ctx->location_gps_raw : NULL);
+    if (updated)
+        location_updates_schedule (self, skeleton, updated);
+
+    g_object_unref (skeleton);
+}
+
+/* Fixes which don't come in NMEA traces, e.g. from binary protocols, only
+ * update the raw GPS location */
+void
+mm_iface_modem_location_gps_raw_update (MMIfaceModemLocation *self,
+                                        const gchar *utc_time,
+                                        gdouble latitude,
+                                        gdouble longitude,
+                                        gdouble altitude)
+{
+    MmGdbusModemLocation *skeleton;
+    LocationContext *ctx;
+
+    ctx = get_location_context (self);
+    g_object_get (self,
+                  MM_IFACE_MODEM_LOCATION_DBUS_SKELETON, &skeleton,
+                  NULL);
+    if (!skeleton)
+        return;
+
+    if (mm_gdbus_modem_location_get_enabled (skeleton) & MM_MODEM_LOCATION_SOURCE_GPS_RAW) {
+        g_assert (ctx->location_gps_raw != NULL);
+        mm_location_gps_raw_set_fix (ctx->location_gps_raw, utc_time, latitude, longitude, altitude);
+        gps_raw_check_first_fix (skeleton, ctx);
+        location_updates_schedule (self, skeleton, MM_MODEM_LOCATION_SOURCE_GPS_RAW);
+    }
 
     g_object_unref (skeleton);
 }
 
 /*****************************************************************************/
 
+static void
+emit_cell_changed (MMIfaceModemLocation *self,
+                   MmGdbusModemLocation *skeleton,
+                   LocationContext *ctx,
+                   MMLocation3gpp *location_3gpp)
+{
+    MmGdbusModem *modem_skeleton = NULL;
+    MMModemAccessTechnology access_technology = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
+    GVariant *variant;
+    gchar *cell;
+
+    /* Only full cells are reported, as in the Location property */
+    variant = mm_location_3gpp_get_string_variant (location_3gpp);
+    cell = variant ? g_variant_dup_string (variant, NULL) : g_strdup ("");
+    if (variant)
+        g_variant_unref (variant);
+
+    /* Only MCC/MNC may have changed, or LAC/CI without a full cell */
+    if (g_strcmp0 (cell, ctx->last_cell ? ctx->last_cell : "") == 0) {
+        g_free (cell);
+        return;
+    }
+
+    /* Like the Location property, only signaled if allowed */
+    if (mm_gdbus_modem_location_get_signals_location (skeleton)) {
+        g_object_get (self,
+                      MM_IFACE_MODEM_DBUS_SKELETON, &modem_skeleton,
+                      NULL);
+        if (modem_skeleton) {
+            access_technology = mm_gdbus_modem_get_access_technologies (modem_skeleton);
+            g_object_unref (modem_skeleton);
+        }
+
+        mm_gdbus_modem_location_emit_cell_changed (skeleton,
+                                                   ctx->last_cell ? ctx->last_cell : "",
+                                                   cell,
+                                                   g_get_real_time (),
+                                                   access_technology);
+    }
+
+    g_free (ctx->last_cell);
+    ctx->last_cell = cell;
+}
+
 static void
 notify_3gpp_location_update (MMIfaceModemLocation *self,
                              MmGdbusModemLocation *skeleton,
@@ -287,6 +600,9 @@ notify_3gpp_location_update (MMIfaceModemLocation *self,
 {
     const gchar *dbus_path;
 
+    /* Cell changes are signaled right away, not once per refresh window */
+    emit_cell_changed (self, skeleton, get_location_context (self), location_3gpp);
+
     dbus_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (self));
     mm_dbg ("Modem %s: 3GPP location updated "
             "(MCC: '%u', MNC: '%u', Location area code: '%lX', Cell ID: '%lX')",
@@ -296,15 +612,7 @@ notify_3gpp_location_update (MMIfaceModemLocation *self,
             mm_location_3gpp_get_location_area_code (location_3gpp),
             mm_location_3gpp_get_cell_id (location_3gpp));
 
-    /* We only update the property if we are supposed to signal
-     * location */
-    if (mm_gdbus_modem_location_get_signals_location (skeleton))
-        mm_gdbus_modem_location_set_location (
-            skeleton,
-            build_location_dictionary (mm_gdbus_modem_location_get_location (skeleton),
-                                       location_3gpp,
-                                       NULL, NULL,
-                                       NULL));
+    location_updates_schedule (self, skeleton, MM_MODEM_LOCATION_SOURCE_3GPP_LAC_CI);
 }
 
 void
@@ -411,15 +719,7 @@ notify_cdma_bs_location_update (MMIfaceModemLocation *self,
             mm_location_cdma_bs_get_longitude (location_cdma_bs),
             mm_location_cdma_bs_get_latitude (location_cdma_bs));
 
-    /* We only update the property if we are supposed to signal
-     * location */
-    if (mm_gdbus_modem_location_get_signals_location (skeleton))
-        mm_gdbus_modem_location_set_location (
-            skeleton,
-            build_location_dictionary (mm_gdbus_modem_location_get_location (skeleton),
-                                       NULL,
-                                       NULL, NULL,
-                                       location_cdma_bs));
+    location_updates_schedule (self, skeleton, MM_MODEM_LOCATION_SOURCE_CDMA_BS);
 }
 
 void
@@ -485,22 +785,33 @@ update_location_source_status (MMIfaceModemLocation *self,
         if (enabled) {
             if (!ctx->location_3gpp)
                 ctx->location_3gpp = mm_location_3gpp_new ();
-        } else
+        } else {
             g_clear_object (&ctx->location_3gpp);
+            g_clear_pointer (&ctx->last_cell, g_free);
+        }
         break;
     case MM_MODEM_LOCATION_SOURCE_GPS_NMEA:
         if (enabled) {
-            if (!ctx->location_gps_nmea)
+            if (!ctx->location_gps_nmea) {
                 ctx->location_gps_nmea = mm_location_gps_nmea_new ();
+                mm_location_gps_nmea_set_limits (ctx->location_gps_nmea,
+                                                 mm_memory_budget_get ()->nmea_traces,
+                                                 mm_memory_budget_get ()->nmea_trace_size);
+            }
         } else
             g_clear_object (&ctx->location_gps_nmea);
         break;
     case MM_MODEM_LOCATION_SOURCE_GPS_RAW:
         if (enabled) {
-            if (!ctx->location_gps_raw)
+            if (!ctx->location_gps_raw) {
                 ctx->location_gps_raw = mm_location_gps_raw_new ();
-        } else
+                ctx->gps_raw_enable_time = mm_clock_get_time ();
+                mm_gdbus_modem_location_set_time_to_first_fix (skeleton, 0);
+            }
+        } else {
             g_clear_object (&ctx->location_gps_raw);
+            ctx->gps_raw_enable_time = 0;
+        }
         break;
     case MM_MODEM_LOCATION_SOURCE_CDMA_BS:
         if (enabled) {
@@ -516,6 +827,10 @@ update_location_source_status (MMIfaceModemLocation *self,
         break;
     }
 
+    /* NMEA streams are only fed while GPS sources are enabled */
+    if (!(mask & (MM_MODEM_LOCATION_SOURCE_GPS_NMEA | MM_MODEM_LOCATION_SOURCE_GPS_RAW)))
+        nmea_streams_close (ctx);
+
     mm_gdbus_modem_location_set_enabled (skeleton, mask);
 
     g_object_unref (skeleton);
@@ -802,8 +1117,10 @@ setup_gathering_ready (MMIfaceModemLocation *self,
 
     if (!setup_gathering_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_location_complete_setup (ctx->skeleton, ctx->invocation);
+    }
 
     handle_setup_context_free (ctx);
 }
@@ -939,6 +1256,7 @@ set_supl_server_ready (MMIfaceModemLocation *self,
         g_dbus_method_invocation_take_error (ctx->invocation, error);
     else {
         mm_gdbus_modem_location_set_supl_server (ctx->skeleton, ctx->supl);
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_location_complete_set_supl_server (ctx->skeleton, ctx->invocation);
     }
 
@@ -1025,6 +1343,127 @@ handle_set_supl_server (MmGdbusModemLocation *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModemLocation *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemLocation *self;
+    GVariant *datav;
+} HandleInjectAssistanceDataContext;
+
+static void
+handle_inject_assistance_data_context_free (HandleInjectAssistanceDataContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_variant_unref (ctx->datav);
+    g_slice_free (HandleInjectAssistanceDataContext, ctx);
+}
+
+static void
+inject_assistance_data_ready (MMIfaceModemLocation *self,
+                              GAsyncResult *res,
+                              HandleInjectAssistanceDataContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!MM_IFACE_MODEM_LOCATION_GET_INTERFACE (self)->inject_assistance_data_finish (self, res, &error)) {
+        mm_warn ("couldn't inject assistance data: '%s'", error->message);
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    } else {
+        mm_info ("Injected %" G_GSIZE_FORMAT " bytes of assistance data",
+                 g_variant_get_size (ctx->datav));
+        get_location_context (self)->assistance_injected = TRUE;
+        mm_dbus_flush_properties (ctx->skeleton);
+        mm_gdbus_modem_location_complete_inject_assistance_data (ctx->skeleton, ctx->invocation);
+    }
+
+    handle_inject_assistance_data_context_free (ctx);
+}
+
+static void
+handle_inject_assistance_data_auth_ready (MMBaseModem *self,
+                                          GAsyncResult *res,
+                                          HandleInjectAssistanceDataContext *ctx)
+{
+    GError *error = NULL;
+    MMModemState modem_state;
+    const guint8 *data;
+    gsize data_size;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_inject_assistance_data_context_free (ctx);
+        return;
+    }
+
+    modem_state = MM_MODEM_STATE_UNKNOWN;
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot inject assistance data: "
+                                               "device not yet enabled");
+        handle_inject_assistance_data_context_free (ctx);
+        return;
+    }
+
+    /* If no assistance data type is supported, set error */
+    if (mm_gdbus_modem_location_get_supported_assistance_data (ctx->skeleton) == MM_MODEM_LOCATION_ASSISTANCE_DATA_TYPE_NONE ||
+        !MM_IFACE_MODEM_LOCATION_GET_INTERFACE (self)->inject_assistance_data ||
+        !MM_IFACE_MODEM_LOCATION_GET_INTERFACE (self)->inject_assistance_data_finish) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Cannot inject assistance data: not supported");
+        handle_inject_assistance_data_context_free (ctx);
+        return;
+    }
+
+    data = g_variant_get_fixed_array (ctx->datav, &data_size, sizeof (guint8));
+    if (!data_size) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_INVALID_ARGS,
+                                               "Cannot inject assistance data: no data given");
+        handle_inject_assistance_data_context_free (ctx);
+        return;
+    }
+
+    MM_IFACE_MODEM_LOCATION_GET_INTERFACE (self)->inject_assistance_data (ctx->self,
+                                                                          data,
+                                                                          data_size,
+                                                                          (GAsyncReadyCallback)inject_assistance_data_ready,
+                                                                          ctx);
+}
+
+static gboolean
+handle_inject_assistance_data (MmGdbusModemLocation *skeleton,
+                               GDBusMethodInvocation *invocation,
+                               GVariant *datav,
+                               MMIfaceModemLocation *self)
+{
+    HandleInjectAssistanceDataContext *ctx;
+
+    ctx = g_slice_new (HandleInjectAssistanceDataContext);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->datav = g_variant_ref (datav);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_DEVICE_CONTROL,
+                             (GAsyncReadyCallback)handle_inject_assistance_data_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MmGdbusModemLocation *skeleton;
     GDBusMethodInvocation *invocation;
@@ -1082,6 +1521,7 @@ handle_set_gps_refresh_rate_auth_ready (MMBaseModem *self,
 
     /* Set the new rate in the interface */
     mm_gdbus_modem_location_set_gps_refresh_rate (ctx->skeleton, ctx->rate);
+    mm_dbus_flush_properties (ctx->skeleton);
     mm_gdbus_modem_location_complete_set_gps_refresh_rate (ctx->skeleton, ctx->invocation);
     handle_set_gps_refresh_rate_context_free (ctx);
 }
@@ -1155,6 +1595,7 @@ handle_get_location_auth_ready (MMBaseModem *self,
     }
 
     location_ctx = get_location_context (ctx->self);
+    mm_dbus_flush_properties (ctx->skeleton);
     mm_gdbus_modem_location_complete_get_location (
         ctx->skeleton,
         ctx->invocation,
@@ -1188,6 +1629,221 @@ handle_get_location (MmGdbusModemLocation *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModemLocation *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemLocation *self;
+} HandleOpenNmeaStreamContext;
+
+static void
+handle_open_nmea_stream_context_free (HandleOpenNmeaStreamContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_slice_free (HandleOpenNmeaStreamContext, ctx);
+}
+
+static void
+handle_open_nmea_stream_auth_ready (MMBaseModem *self,
+                                    GAsyncResult *res,
+                                    HandleOpenNmeaStreamContext *ctx)
+{
+    MMModemState modem_state;
+    LocationContext *location_ctx;
+    GUnixFDList *fd_list;
+    GError *error = NULL;
+    gint fds[2];
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    modem_state = MM_MODEM_STATE_UNKNOWN;
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot open NMEA stream: "
+                                               "device not yet enabled");
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    /* If GPS is NOT supported, set error */
+    if (!(mm_gdbus_modem_location_get_capabilities (ctx->skeleton) & ((MM_MODEM_LOCATION_SOURCE_GPS_RAW |
+                                                                       MM_MODEM_LOCATION_SOURCE_GPS_NMEA)))) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Cannot open NMEA stream: GPS not supported");
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    if (!(mm_gdbus_modem_location_get_enabled (ctx->skeleton) & ((MM_MODEM_LOCATION_SOURCE_GPS_RAW |
+                                                                  MM_MODEM_LOCATION_SOURCE_GPS_NMEA)))) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot open NMEA stream: GPS location gathering not enabled");
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    location_ctx = get_location_context (ctx->self);
+    if (!location_ctx->nmea_streams)
+        location_ctx->nmea_streams = g_array_new (FALSE, FALSE, sizeof (gint));
+    if (location_ctx->nmea_streams->len >= MM_LOCATION_NMEA_STREAMS_MAX) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_TOO_MANY,
+                                               "Cannot open NMEA stream: too many streams open");
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_FAILED,
+                                               "Cannot open NMEA stream: %s",
+                                               g_strerror (errno));
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+
+    /* We only write to our end */
+    shutdown (fds[0], SHUT_RD);
+    shutdown (fds[1], SHUT_WR);
+
+    fd_list = g_unix_fd_list_new ();
+    if (g_unix_fd_list_append (fd_list, fds[1], &error) < 0) {
+        close (fds[0]);
+        close (fds[1]);
+        g_object_unref (fd_list);
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_open_nmea_stream_context_free (ctx);
+        return;
+    }
+    /* The list keeps its own copy */
+    close (fds[1]);
+
+    g_array_append_val (location_ctx->nmea_streams, fds[0]);
+    mm_dbg ("Opened NMEA stream (%u open)", location_ctx->nmea_streams->len);
+
+    mm_dbus_flush_properties (ctx->skeleton);
+    mm_gdbus_modem_location_complete_open_nmea_stream (ctx->skeleton, ctx->invocation, fd_list, 0);
+    g_object_unref (fd_list);
+    handle_open_nmea_stream_context_free (ctx);
+}
+
+static gboolean
+handle_open_nmea_stream (MmGdbusModemLocation *skeleton,
+                         GDBusMethodInvocation *invocation,
+                         GUnixFDList *fd_list,
+                         MMIfaceModemLocation *self)
+{
+    HandleOpenNmeaStreamContext *ctx;
+
+    ctx = g_slice_new (HandleOpenNmeaStreamContext);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_LOCATION,
+                             (GAsyncReadyCallback)handle_open_nmea_stream_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    MmGdbusModemLocation *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemLocation *self;
+    guint64 from;
+    guint64 to;
+} HandleGetLocationHistoryContext;
+
+static void
+handle_get_location_history_context_free (HandleGetLocationHistoryContext *ctx)
+{
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_slice_free (HandleGetLocationHistoryContext, ctx);
+}
+
+static void
+handle_get_location_history_auth_ready (MMBaseModem *self,
+                                        GAsyncResult *res,
+                                        HandleGetLocationHistoryContext *ctx)
+{
+    MMLocationJournal *journal;
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_get_location_history_context_free (ctx);
+        return;
+    }
+
+    /* The history doesn't need the modem to be enabled, it may come from
+     * a previous run */
+    journal = get_location_journal (ctx->self, get_location_context (ctx->self));
+    if (!journal) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Cannot get location history: "
+                                               "location history not kept");
+        handle_get_location_history_context_free (ctx);
+        return;
+    }
+
+    mm_dbus_flush_properties (ctx->skeleton);
+    mm_gdbus_modem_location_complete_get_location_history (
+        ctx->skeleton,
+        ctx->invocation,
+        mm_location_journal_query (journal, ctx->from, ctx->to));
+    handle_get_location_history_context_free (ctx);
+}
+
+static gboolean
+handle_get_location_history (MmGdbusModemLocation *skeleton,
+                             GDBusMethodInvocation *invocation,
+                             guint64 from,
+                             guint64 to,
+                             MMIfaceModemLocation *self)
+{
+    HandleGetLocationHistoryContext *ctx;
+
+    ctx = g_slice_new (HandleGetLocationHistoryContext);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->from = from;
+    ctx->to = to;
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_LOCATION,
+                             (GAsyncReadyCallback)handle_get_location_history_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 typedef struct _DisablingContext DisablingContext;
 static void interface_disabling_step (DisablingContext *ctx);
 
@@ -1447,6 +2103,7 @@ typedef enum {
     INITIALIZATION_STEP_CAPABILITIES,
     INITIALIZATION_STEP_VALIDATE_CAPABILITIES,
     INITIALIZATION_STEP_SUPL_SERVER,
+    INITIALIZATION_STEP_SUPPORTED_ASSISTANCE_DATA,
     INITIALIZATION_STEP_GPS_REFRESH_RATE,
     INITIALIZATION_STEP_LAST
 } InitializationStep;
@@ -1507,6 +2164,27 @@ load_supl_server_ready (MMIfaceModemLocation *self,
     interface_initialization_step (ctx);
 }
 
+static void
+load_supported_assistance_data_ready (MMIfaceModemLocation *self,
+                                      GAsyncResult *res,
+                                      InitializationContext *ctx)
+{
+    GError *error = NULL;
+    MMModemLocationAssistanceDataType mask;
+
+    mask = MM_IFACE_MODEM_LOCATION_GET_INTERFACE (self)->load_supported_assistance_data_finish (self, res, &error);
+    if (error) {
+        mm_dbg ("couldn't load supported assistance data types: '%s'", error->message);
+        g_error_free (error);
+    }
+
+    mm_gdbus_modem_location_set_supported_assistance_data (ctx->skeleton, (guint32) mask);
+
+    /* Go on to next step */
+    ctx->step++;
+    interface_initialization_step (ctx);
+}
+
 static void
 load_capabilities_ready (MMIfaceModemLocation *self,
                          GAsyncResult *res,
@@ -1534,6 +2212,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Location interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Fall down to next step */
@@ -1583,6 +2266,21 @@ interface_initialization_step (InitializationContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
+    case INITIALIZATION_STEP_SUPPORTED_ASSISTANCE_DATA:
+        /* If the modem supports GPS, load the assistance data it accepts */
+        if (ctx->capabilities & ((MM_MODEM_LOCATION_SOURCE_GPS_RAW |
+                                  MM_MODEM_LOCATION_SOURCE_GPS_NMEA)) &&
+            MM_IFACE_MODEM_LOCATION_GET_INTERFACE (ctx->self)->load_supported_assistance_data &&
+            MM_IFACE_MODEM_LOCATION_GET_INTERFACE (ctx->self)->load_supported_assistance_data_finish) {
+            MM_IFACE_MODEM_LOCATION_GET_INTERFACE (ctx->self)->load_supported_assistance_data (
+                ctx->self,
+                (GAsyncReadyCallback)load_supported_assistance_data_ready,
+                ctx);
+            return;
+        }
+        /* Fall down to next step */
+        ctx->step++;
+
     case INITIALIZATION_STEP_GPS_REFRESH_RATE:
         /* If we have GPS capabilities, expose the GPS refresh rate */
         if (ctx->capabilities & ((MM_MODEM_LOCATION_SOURCE_GPS_RAW |
@@ -1605,6 +2303,10 @@ interface_initialization_step (InitializationContext *ctx)
                           "handle-set-supl-server",
                           G_CALLBACK (handle_set_supl_server),
                           ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-inject-assistance-data",
+                          G_CALLBACK (handle_inject_assistance_data),
+                          ctx->self);
         g_signal_connect (ctx->skeleton,
                           "handle-set-gps-refresh-rate",
                           G_CALLBACK (handle_set_gps_refresh_rate),
@@ -1613,6 +2315,14 @@ interface_initialization_step (InitializationContext *ctx)
                           "handle-get-location",
                           G_CALLBACK (handle_get_location),
                           ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-open-nmea-stream",
+                          G_CALLBACK (handle_open_nmea_stream),
+                          ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-get-location-history",
+                          G_CALLBACK (handle_get_location_history),
+                          ctx->self);
 
         /* Finally, export the new interface */
         mm_gdbus_object_skeleton_set_modem_location (MM_GDBUS_OBJECT_SKELETON (ctx->self),
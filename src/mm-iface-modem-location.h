@@ -76,6 +76,24 @@ struct _MMIfaceModemLocation {
     gboolean (*set_supl_server_finish) (MMIfaceModemLocation *self,
                                         GAsyncResult *res,
                                         GError **error);
+
+    /* Loading of the SupportedAssistanceData property */
+    void (* load_supported_assistance_data) (MMIfaceModemLocation *self,
+                                             GAsyncReadyCallback callback,
+                                             gpointer user_data);
+    MMModemLocationAssistanceDataType (* load_supported_assistance_data_finish) (MMIfaceModemLocation *self,
+                                                                                GAsyncResult *res,
+                                                                                GError **error);
+
+    /* Inject assistance data (async) */
+    void (* inject_assistance_data) (MMIfaceModemLocation *self,
+                                     const guint8 *data,
+                                     gsize data_size,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data);
+    gboolean (*inject_assistance_data_finish) (MMIfaceModemLocation *self,
+                                               GAsyncResult *res,
+                                               GError **error);
 };
 
 GType mm_iface_modem_location_get_type (void);
@@ -121,6 +139,14 @@ void mm_iface_modem_location_3gpp_update_lac_ci  (MMIfaceModemLocation *self,
 /* Update GPS location */
 void mm_iface_modem_location_gps_update (MMIfaceModemLocation *self,
                                          const gchar *nmea_trace);
+void mm_iface_modem_location_gps_raw_update (MMIfaceModemLocation *self,
+                                             const gchar *utc_time,
+                                             gdouble latitude,
+                                             gdouble longitude,
+                                             gdouble altitude);
+
+/* Bytes of the NMEA traces stored for the GPS NMEA location */
+gsize mm_iface_modem_location_get_nmea_size (MMIfaceModemLocation *self);
 
 /* Update CDMA BS location */
 void mm_iface_modem_location_cdma_bs_update (MMIfaceModemLocation *self,
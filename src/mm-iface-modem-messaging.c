@@ -20,7 +20,9 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-list.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define SUPPORT_CHECKED_TAG "messaging-support-checked-tag"
 #define SUPPORTED_TAG       "messaging-supported-tag"
@@ -168,8 +170,10 @@ handle_delete_ready (MMSmsList *list,
 
     if (!mm_sms_list_delete_sms_finish (list, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_messaging_complete_delete (ctx->skeleton, ctx->invocation);
+    }
 
     handle_delete_context_free (ctx);
 }
@@ -245,6 +249,222 @@ handle_delete (MmGdbusModemMessaging *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    MmGdbusModemMessaging *skeleton;
+    GDBusMethodInvocation *invocation;
+    MMIfaceModemMessaging *self;
+    MMSmsList *list;
+    MMSmsStorage storage;
+    /* Storages to clear, one after the other */
+    GArray *storages;
+    guint i;
+    /* When the modem can't delete all parts at once, messages are deleted
+     * one by one */
+    gchar **paths;
+    guint path_i;
+    guint n_deleted;
+} HandleDeleteAllContext;
+
+static void
+handle_delete_all_context_free (HandleDeleteAllContext *ctx)
+{
+    g_strfreev (ctx->paths);
+    if (ctx->storages)
+        g_array_unref (ctx->storages);
+    if (ctx->list)
+        g_object_unref (ctx->list);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->self);
+    g_free (ctx);
+}
+
+static void delete_all_next_storage (HandleDeleteAllContext *ctx);
+static void delete_all_next_path (HandleDeleteAllContext *ctx);
+
+static void
+delete_all_sms_ready (MMSmsList *list,
+                      GAsyncResult *res,
+                      HandleDeleteAllContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_sms_list_delete_sms_finish (list, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    ctx->n_deleted++;
+    ctx->path_i++;
+    delete_all_next_path (ctx);
+}
+
+static void
+delete_all_next_path (HandleDeleteAllContext *ctx)
+{
+    if (!ctx->paths[ctx->path_i]) {
+        g_strfreev (ctx->paths);
+        ctx->paths = NULL;
+        ctx->i++;
+        delete_all_next_storage (ctx);
+        return;
+    }
+
+    mm_sms_list_delete_sms (ctx->list,
+                            ctx->paths[ctx->path_i],
+                            (GAsyncReadyCallback)delete_all_sms_ready,
+                            ctx);
+}
+
+static void
+delete_all_sms_parts_ready (MMIfaceModemMessaging *self,
+                            GAsyncResult *res,
+                            HandleDeleteAllContext *ctx)
+{
+    GError *error = NULL;
+    MMSmsStorage storage;
+
+    if (!MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->delete_all_sms_parts_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    /* All objects in the storage go away in a single list update */
+    storage = g_array_index (ctx->storages, MMSmsStorage, ctx->i);
+    ctx->n_deleted += mm_sms_list_remove_storage (ctx->list, storage);
+    ctx->i++;
+    delete_all_next_storage (ctx);
+}
+
+static void
+delete_all_next_storage (HandleDeleteAllContext *ctx)
+{
+    MMSmsStorage storage;
+
+    if (ctx->i >= ctx->storages->len) {
+        mm_dbg ("Deleted %u SMS messages", ctx->n_deleted);
+        mm_dbus_flush_properties (ctx->skeleton);
+        mm_gdbus_modem_messaging_complete_delete_all (ctx->skeleton, ctx->invocation, ctx->n_deleted);
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    storage = g_array_index (ctx->storages, MMSmsStorage, ctx->i);
+    mm_dbg ("Deleting all SMS messages in storage '%s'...",
+            mm_sms_storage_get_string (storage));
+
+    if (MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->delete_all_sms_parts &&
+        MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->delete_all_sms_parts_finish) {
+        GArray *indices;
+
+        indices = mm_sms_list_get_part_indices (ctx->list, storage);
+        MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->delete_all_sms_parts (
+            ctx->self,
+            storage,
+            indices,
+            (GAsyncReadyCallback)delete_all_sms_parts_ready,
+            ctx);
+        g_array_unref (indices);
+        return;
+    }
+
+    ctx->paths = mm_sms_list_get_paths_paged (ctx->list, 0, 0, MM_SMS_STATE_UNKNOWN, storage, 0, 0, NULL);
+    ctx->path_i = 0;
+    delete_all_next_path (ctx);
+}
+
+static void
+handle_delete_all_auth_ready (MMBaseModem *self,
+                              GAsyncResult *res,
+                              HandleDeleteAllContext *ctx)
+{
+    MMModemState modem_state = MM_MODEM_STATE_UNKNOWN;
+    StorageContext *storage_ctx;
+    GError *error = NULL;
+    guint i;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot delete SMS: device not yet enabled");
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &ctx->list,
+                  NULL);
+    if (!ctx->list) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot delete SMS: missing SMS list");
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    /* Messages are listed and deleted from the mem1 storages */
+    storage_ctx = get_storage_context (ctx->self);
+    ctx->storages = g_array_new (FALSE, FALSE, sizeof (MMSmsStorage));
+    for (i = 0; storage_ctx->supported_mem1 && i < storage_ctx->supported_mem1->len; i++) {
+        MMSmsStorage storage;
+
+        storage = g_array_index (storage_ctx->supported_mem1, MMSmsStorage, i);
+        if (ctx->storage == MM_SMS_STORAGE_UNKNOWN || ctx->storage == storage)
+            g_array_append_val (ctx->storages, storage);
+    }
+
+    if (ctx->storage != MM_SMS_STORAGE_UNKNOWN && !ctx->storages->len) {
+        g_dbus_method_invocation_return_error (ctx->invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_UNSUPPORTED,
+                                               "Cannot delete SMS: storage '%s' not supported",
+                                               mm_sms_storage_get_string (ctx->storage));
+        handle_delete_all_context_free (ctx);
+        return;
+    }
+
+    ctx->i = 0;
+    delete_all_next_storage (ctx);
+}
+
+static gboolean
+handle_delete_all (MmGdbusModemMessaging *skeleton,
+                   GDBusMethodInvocation *invocation,
+                   guint storage,
+                   MMIfaceModemMessaging *self)
+{
+    HandleDeleteAllContext *ctx;
+
+    ctx = g_new0 (HandleDeleteAllContext, 1);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->self = g_object_ref (self);
+    ctx->storage = (MMSmsStorage)storage;
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_MESSAGING,
+                             (GAsyncReadyCallback)handle_delete_all_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MmGdbusModemMessaging *skeleton;
     GDBusMethodInvocation *invocation;
@@ -328,6 +548,7 @@ handle_create_auth_ready (MMBaseModem *self,
     mm_sms_list_add_sms (list, sms);
 
     /* Complete the DBus call */
+    mm_dbus_flush_properties (ctx->skeleton);
     mm_gdbus_modem_messaging_complete_create (ctx->skeleton,
                                               ctx->invocation,
                                               mm_base_sms_get_path (sms));
@@ -398,6 +619,7 @@ handle_list (MmGdbusModemMessaging *skeleton,
     }
 
     paths = mm_sms_list_get_paths (list);
+    mm_dbus_flush_properties (skeleton);
     mm_gdbus_modem_messaging_complete_list (skeleton,
                                             invocation,
                                             (const gchar *const *)paths);
@@ -408,6 +630,141 @@ handle_list (MmGdbusModemMessaging *skeleton,
 
 /*****************************************************************************/
 
+static gboolean
+parse_list_filter (GVariant *filter,
+                   MMSmsState *state,
+                   MMSmsStorage *storage,
+                   guint64 *timestamp_from,
+                   guint64 *timestamp_to,
+                   GError **error)
+{
+    GVariantIter iter;
+    const gchar *key;
+    GVariant *value;
+
+    *state = MM_SMS_STATE_UNKNOWN;
+    *storage = MM_SMS_STORAGE_UNKNOWN;
+    *timestamp_from = 0;
+    *timestamp_to = 0;
+
+    g_variant_iter_init (&iter, filter);
+    while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+        gboolean valid = FALSE;
+
+        if (g_str_equal (key, "state")) {
+            if ((valid = g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)))
+                *state = (MMSmsState) g_variant_get_uint32 (value);
+        } else if (g_str_equal (key, "storage")) {
+            if ((valid = g_variant_is_of_type (value, G_VARIANT_TYPE_UINT32)))
+                *storage = (MMSmsStorage) g_variant_get_uint32 (value);
+        } else if (g_str_equal (key, "timestamp-from")) {
+            if ((valid = g_variant_is_of_type (value, G_VARIANT_TYPE_UINT64)))
+                *timestamp_from = g_variant_get_uint64 (value);
+        } else if (g_str_equal (key, "timestamp-to")) {
+            if ((valid = g_variant_is_of_type (value, G_VARIANT_TYPE_UINT64)))
+                *timestamp_to = g_variant_get_uint64 (value);
+        } else {
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_INVALID_ARGS,
+                         "Unknown filter '%s'",
+                         key);
+            g_variant_unref (value);
+            return FALSE;
+        }
+
+        if (!valid) {
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_INVALID_ARGS,
+                         "Invalid type '%s' for filter '%s'",
+                         g_variant_get_type_string (value),
+                         key);
+            g_variant_unref (value);
+            return FALSE;
+        }
+        g_variant_unref (value);
+    }
+
+    if (*timestamp_to && *timestamp_from > *timestamp_to) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_INVALID_ARGS,
+                     "Invalid timestamp range");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+handle_list_paged (MmGdbusModemMessaging *skeleton,
+                   GDBusMethodInvocation *invocation,
+                   guint offset,
+                   guint limit,
+                   GVariant *filter,
+                   MMIfaceModemMessaging *self)
+{
+    GStrv paths;
+    MMSmsList *list = NULL;
+    MMModemState modem_state;
+    MMSmsState state;
+    MMSmsStorage storage;
+    guint64 timestamp_from;
+    guint64 timestamp_to;
+    guint total = 0;
+    GError *error = NULL;
+
+    modem_state = MM_MODEM_STATE_UNKNOWN;
+    g_object_get (self,
+                  MM_IFACE_MODEM_STATE, &modem_state,
+                  NULL);
+
+    if (modem_state < MM_MODEM_STATE_ENABLED) {
+        g_dbus_method_invocation_return_error (invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot list SMS messages: "
+                                               "device not yet enabled");
+        return TRUE;
+    }
+
+    if (!parse_list_filter (filter, &state, &storage, &timestamp_from, &timestamp_to, &error)) {
+        g_dbus_method_invocation_take_error (invocation, error);
+        return TRUE;
+    }
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &list,
+                  NULL);
+    if (!list) {
+        g_dbus_method_invocation_return_error (invocation,
+                                               MM_CORE_ERROR,
+                                               MM_CORE_ERROR_WRONG_STATE,
+                                               "Cannot list SMS: missing SMS list");
+        return TRUE;
+    }
+
+    paths = mm_sms_list_get_paths_paged (list,
+                                         offset,
+                                         limit,
+                                         state,
+                                         storage,
+                                         timestamp_from,
+                                         timestamp_to,
+                                         &total);
+    mm_dbus_flush_properties (skeleton);
+    mm_gdbus_modem_messaging_complete_list_paged (skeleton,
+                                                  invocation,
+                                                  (const gchar *const *)paths,
+                                                  total);
+    g_strfreev (paths);
+    g_object_unref (list);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 gboolean
 mm_iface_modem_messaging_take_part (MMIfaceModemMessaging *self,
                                     MMSmsPart *sms_part,
@@ -513,6 +870,16 @@ sms_added (MMSmsList *list,
     mm_gdbus_modem_messaging_emit_added (skeleton, sms_path, received);
 }
 
+static void
+sms_batch_added (MMSmsList *list,
+                 guint n_added,
+                 MmGdbusModemMessaging *skeleton)
+{
+    /* No Added signal for each one, the new list is enough */
+    mm_dbg ("Added %u SMS in batch", n_added);
+    update_message_list (skeleton, list);
+}
+
 static void
 sms_deleted (MMSmsList *list,
              const gchar *sms_path,
@@ -756,6 +1123,38 @@ setup_sms_format_ready (MMIfaceModemMessaging *self,
 
 static void load_initial_sms_parts_from_storages (EnablingContext *ctx);
 
+static gboolean
+export_initial_sms_filter (MMBaseSms *sms,
+                           MMIfaceModemMessaging *self)
+{
+    return MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->export_initial_sms (self, sms);
+}
+
+/* Messages loaded from the storages are exported all at once when done, so
+ * that a single Messages update is emitted instead of one per message */
+static void
+initial_sms_batch (MMIfaceModemMessaging *self,
+                   gboolean begin)
+{
+    MMSmsList *list = NULL;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_MESSAGING_SMS_LIST, &list,
+                  NULL);
+    if (!list)
+        return;
+
+    if (begin)
+        mm_sms_list_begin_batch (list);
+    else
+        mm_sms_list_end_batch (list,
+                               (MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (self)->export_initial_sms ?
+                                (MMSmsListExportFilter)export_initial_sms_filter :
+                                NULL),
+                               self);
+    g_object_unref (list);
+}
+
 static void
 load_initial_sms_parts_ready (MMIfaceModemMessaging *self,
                               GAsyncResult *res,
@@ -820,6 +1219,8 @@ load_initial_sms_parts_from_storages (EnablingContext *ctx)
     }
 
     if (all_loaded) {
+        initial_sms_batch (ctx->self, FALSE);
+
         /* Go on with next step */
         ctx->step++;
         interface_enabling_step (ctx);
@@ -919,6 +1320,10 @@ interface_enabling_step (EnablingContext *ctx)
                           MM_SMS_ADDED,
                           G_CALLBACK (sms_added),
                           ctx->skeleton);
+        g_signal_connect (list,
+                          MM_SMS_BATCH_ADDED,
+                          G_CALLBACK (sms_batch_added),
+                          ctx->skeleton);
         g_signal_connect (list,
                           MM_SMS_DELETED,
                           G_CALLBACK (sms_deleted),
@@ -974,6 +1379,7 @@ interface_enabling_step (EnablingContext *ctx)
         /* Allow loading the initial list of SMS parts */
         if (MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->load_initial_sms_parts &&
             MM_IFACE_MODEM_MESSAGING_GET_INTERFACE (ctx->self)->load_initial_sms_parts_finish) {
+            initial_sms_batch (ctx->self, TRUE);
             load_initial_sms_parts_from_storages (ctx);
             return;
         }
@@ -1244,6 +1650,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Messaging interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -1337,6 +1748,14 @@ interface_initialization_step (InitializationContext *ctx)
                           "handle-list",
                           G_CALLBACK (handle_list),
                           ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-delete-all",
+                          G_CALLBACK (handle_delete_all),
+                          ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-list-paged",
+                          G_CALLBACK (handle_list_paged),
+                          ctx->self);
 
         /* Finally, export the new interface */
         mm_gdbus_object_skeleton_set_modem_messaging (MM_GDBUS_OBJECT_SKELETON (ctx->self),
@@ -129,8 +129,26 @@ struct _MMIfaceModemMessaging {
                                                GAsyncResult *res,
                                                GError **error);
 
+    /* Whether an SMS object built from the initial SMS parts gets exported
+     * in DBus; optional, all of them are exported if not given. Objects not
+     * exported are still counted, but not listed in the Messages property */
+    gboolean (* export_initial_sms) (MMIfaceModemMessaging *self,
+                                     MMBaseSms *sms);
+
     /* Create SMS objects */
     MMBaseSms * (* create_sms) (MMIfaceModemMessaging *self);
+
+    /* Delete all SMS parts in a storage at once (async).
+     * The indices of the parts known in the storage are given, for the
+     * implementations which need to fall back to deleting them one by one */
+    void (* delete_all_sms_parts) (MMIfaceModemMessaging *self,
+                                   MMSmsStorage storage,
+                                   GArray *indices,
+                                   GAsyncReadyCallback callback,
+                                   gpointer user_data);
+    gboolean (* delete_all_sms_parts_finish) (MMIfaceModemMessaging *self,
+                                              GAsyncResult *res,
+                                              GError **error);
 };
 
 GType mm_iface_modem_messaging_get_type (void);
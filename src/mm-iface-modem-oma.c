@@ -19,7 +19,9 @@
 
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-oma.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define SUPPORT_CHECKED_TAG "oma-support-checked-tag"
 #define SUPPORTED_TAG       "oma-supported-tag"
@@ -173,6 +175,7 @@ setup_ready (MMIfaceModemOma *self,
     else {
         /* Update current features in the interface */
         mm_gdbus_modem_oma_set_features (ctx->skeleton, ctx->features);
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_oma_complete_setup (ctx->skeleton, ctx->invocation);
     }
 
@@ -284,6 +287,7 @@ start_client_initiated_session_ready (MMIfaceModemOma *self,
         /* Update interface info */
         mm_gdbus_modem_oma_set_session_type (ctx->skeleton, ctx->session_type);
         mm_iface_modem_oma_update_session_state (self, MM_OMA_SESSION_STATE_STARTED, MM_OMA_SESSION_STATE_FAILED_REASON_UNKNOWN);
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_oma_complete_start_client_initiated_session (ctx->skeleton, ctx->invocation);
     }
 
@@ -413,6 +417,7 @@ accept_network_initiated_session_ready (MMIfaceModemOma *self,
             mm_iface_modem_oma_update_session_state (self, MM_OMA_SESSION_STATE_STARTED, MM_OMA_SESSION_STATE_FAILED_REASON_UNKNOWN);
         }
 
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_oma_complete_accept_network_initiated_session (ctx->skeleton, ctx->invocation);
     }
 
@@ -570,6 +575,7 @@ cancel_session_ready (MMIfaceModemOma *self,
         mm_gdbus_modem_oma_set_session_type (ctx->skeleton, MM_OMA_SESSION_TYPE_UNKNOWN);
         mm_iface_modem_oma_update_session_state (self, MM_OMA_SESSION_STATE_UNKNOWN, MM_OMA_SESSION_STATE_FAILED_REASON_UNKNOWN);
 
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_oma_complete_cancel_session (ctx->skeleton, ctx->invocation);
     }
 
@@ -1015,6 +1021,8 @@ struct _InitializationContext {
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
     InitializationStep step;
+    /* Only check support and export, to be initialized on demand */
+    gboolean lazy;
 };
 
 static void
@@ -1074,6 +1082,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "OMA interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -1130,6 +1143,16 @@ interface_initialization_step (InitializationContext *ctx)
     case INITIALIZATION_STEP_LAST:
         /* We are done without errors! */
 
+        /* Method invocations are handled once initialized on demand */
+        if (ctx->lazy) {
+            if (!mm_gdbus_object_peek_modem_oma (MM_GDBUS_OBJECT (ctx->self)))
+                mm_gdbus_object_skeleton_set_modem_oma (MM_GDBUS_OBJECT_SKELETON (ctx->self),
+                                                 MM_GDBUS_MODEM_OMA (ctx->skeleton));
+            g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+            initialization_context_complete_and_free (ctx);
+            return;
+        }
+
         /* Handle method invocations */
         g_signal_connect (ctx->skeleton,
                           "handle-setup",
@@ -1148,9 +1171,11 @@ interface_initialization_step (InitializationContext *ctx)
                           G_CALLBACK (handle_cancel_session),
                           ctx->self);
 
-        /* Finally, export the new interface */
-        mm_gdbus_object_skeleton_set_modem_oma (MM_GDBUS_OBJECT_SKELETON (ctx->self),
-                                                MM_GDBUS_MODEM_OMA (ctx->skeleton));
+        /* Finally, export the new interface, unless already done to be
+         * initialized on demand */
+        if (!mm_gdbus_object_peek_modem_oma (MM_GDBUS_OBJECT (ctx->self)))
+            mm_gdbus_object_skeleton_set_modem_oma (MM_GDBUS_OBJECT_SKELETON (ctx->self),
+                                                    MM_GDBUS_MODEM_OMA (ctx->skeleton));
 
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         initialization_context_complete_and_free (ctx);
@@ -1168,13 +1193,9 @@ mm_iface_modem_oma_initialize_finish (MMIfaceModemOma *self,
     return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
 }
 
-void
-mm_iface_modem_oma_initialize (MMIfaceModemOma *self,
-                               GCancellable *cancellable,
-                               GAsyncReadyCallback callback,
-                               gpointer user_data)
+static MmGdbusModemOma *
+get_or_create_skeleton (MMIfaceModemOma *self)
 {
-    InitializationContext *ctx;
     MmGdbusModemOma *skeleton = NULL;
 
     /* Did we already create it? */
@@ -1194,6 +1215,18 @@ mm_iface_modem_oma_initialize (MMIfaceModemOma *self,
         mm_gdbus_modem_oma_set_pending_network_initiated_sessions (skeleton, mm_common_build_oma_pending_network_initiated_sessions_default ());
     }
 
+    return skeleton;
+}
+
+static void
+initialization_start (MMIfaceModemOma *self,
+                      gboolean lazy,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+    InitializationContext *ctx;
+
     /* Perform async initialization here */
 
     ctx = g_new0 (InitializationContext, 1);
@@ -1204,11 +1237,30 @@ mm_iface_modem_oma_initialize (MMIfaceModemOma *self,
                                              user_data,
                                              mm_iface_modem_oma_initialize);
     ctx->step = INITIALIZATION_STEP_FIRST;
-    ctx->skeleton = skeleton;
+    ctx->skeleton = get_or_create_skeleton (self);
+    ctx->lazy = lazy;
 
     interface_initialization_step (ctx);
 }
 
+void
+mm_iface_modem_oma_initialize_lazy (MMIfaceModemOma *self,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+    initialization_start (self, TRUE, cancellable, callback, user_data);
+}
+
+void
+mm_iface_modem_oma_initialize (MMIfaceModemOma *self,
+                               GCancellable *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer user_data)
+{
+    initialization_start (self, FALSE, cancellable, callback, user_data);
+}
+
 void
 mm_iface_modem_oma_shutdown (MMIfaceModemOma *self)
 {
@@ -121,6 +121,14 @@ struct _MMIfaceModemOma {
 
 GType mm_iface_modem_oma_get_type (void);
 
+/* Only check support and export the interface with its default property
+ * values, so that it can be initialized on demand later on; finished with
+ * mm_iface_modem_oma_initialize_finish() */
+void mm_iface_modem_oma_initialize_lazy (MMIfaceModemOma *self,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data);
+
 /* Initialize Oma interface (async) */
 void     mm_iface_modem_oma_initialize        (MMIfaceModemOma *self,
                                                GCancellable *cancellable,
@@ -13,21 +13,31 @@
  * Copyright (C) 2013 Aleksander Morgado <aleksander@gnu.org>
  */
 
+#include <math.h>
+#include <stdlib.h>
+
 #include <ModemManager.h>
 #define _LIBMM_INSIDE_MM
 #include <libmm-glib.h>
 
+#include "mm-base-modem.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-signal.h"
+#include "mm-clock.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
+#include "mm-poll-scheduler.h"
 
 #define SUPPORT_CHECKED_TAG "signal-support-checked-tag"
 #define SUPPORTED_TAG       "signal-supported-tag"
 #define REFRESH_CONTEXT_TAG "signal-refresh-context-tag"
+#define HISTORY_TAG         "signal-history-tag"
 
 static GQuark support_checked_quark;
 static GQuark supported_quark;
 static GQuark refresh_context_quark;
+static GQuark history_quark;
 
 /*****************************************************************************/
 
@@ -42,13 +52,15 @@ mm_iface_modem_signal_bind_simple_status (MMIfaceModemSignal *self,
 typedef struct {
     guint rate;
     guint timeout_source;
+    /* Time of the last values reported by the modem on its own */
+    gint64 last_update;
 } RefreshContext;
 
 static void
 refresh_context_free (RefreshContext *ctx)
 {
     if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+        mm_poll_scheduler_remove (ctx->timeout_source);
     g_slice_free (RefreshContext, ctx);
 }
 
@@ -71,18 +83,394 @@ clear_values (MMIfaceModemSignal *self)
     g_object_unref (skeleton);
 }
 
+/*****************************************************************************/
+/* Thresholds */
+
+typedef gdouble (* SignalGetFunc) (MMSignal *self);
+
+static const SignalGetFunc signal_getters[] = {
+    mm_signal_get_rssi,
+    mm_signal_get_ecio,
+    mm_signal_get_sinr,
+    mm_signal_get_io,
+    mm_signal_get_rsrq,
+    mm_signal_get_rsrp,
+    mm_signal_get_snr,
+};
+
+static MMSignal *
+load_thresholds (MmGdbusModemSignal *skeleton)
+{
+    GVariant *dictionary;
+
+    /* An empty dictionary gives no object */
+    dictionary = mm_gdbus_modem_signal_get_thresholds (skeleton);
+    return (dictionary ? mm_signal_new_from_dictionary (dictionary, NULL) : NULL);
+}
+
+static gboolean
+value_changed (gdouble previous,
+               gdouble current,
+               gdouble threshold)
+{
+    /* Values becoming available or unavailable are always reported */
+    if (previous == MM_SIGNAL_UNKNOWN || current == MM_SIGNAL_UNKNOWN)
+        return previous != current;
+
+    if (threshold == MM_SIGNAL_UNKNOWN)
+        threshold = 0.0;
+
+    return (current != previous && ABS (current - previous) >= threshold);
+}
+
+static gboolean
+signal_changed (MMSignal *previous,
+                MMSignal *current,
+                MMSignal *thresholds)
+{
+    guint i;
+
+    if (!previous)
+        return TRUE;
+
+    for (i = 0; i < G_N_ELEMENTS (signal_getters); i++) {
+        if (value_changed (signal_getters[i] (previous),
+                           signal_getters[i] (current),
+                           signal_getters[i] (thresholds)))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+/*****************************************************************************/
+/* History
+ *
+ * Every set of values retrieved is kept in a fixed-size ring per access
+ * technology, so that statistics over a window can be computed in the daemon
+ * instead of clients polling the properties at a high rate.
+ */
+
+#define HISTORY_SIZE 256
+
+typedef enum {
+    HISTORY_TECHNOLOGY_CDMA,
+    HISTORY_TECHNOLOGY_EVDO,
+    HISTORY_TECHNOLOGY_GSM,
+    HISTORY_TECHNOLOGY_UMTS,
+    HISTORY_TECHNOLOGY_LTE,
+    HISTORY_TECHNOLOGY_LAST
+} HistoryTechnology;
+
+static const MMModemAccessTechnology history_access_technologies[] = {
+    [HISTORY_TECHNOLOGY_CDMA] = MM_MODEM_ACCESS_TECHNOLOGY_1XRTT,
+    [HISTORY_TECHNOLOGY_EVDO] = MM_MODEM_ACCESS_TECHNOLOGY_EVDO0,
+    [HISTORY_TECHNOLOGY_GSM]  = MM_MODEM_ACCESS_TECHNOLOGY_GSM,
+    [HISTORY_TECHNOLOGY_UMTS] = MM_MODEM_ACCESS_TECHNOLOGY_UMTS,
+    [HISTORY_TECHNOLOGY_LTE]  = MM_MODEM_ACCESS_TECHNOLOGY_LTE,
+};
+
+/* Same order as signal_getters */
+static const gchar *signal_metric_names[] = {
+    "rssi",
+    "ecio",
+    "sinr",
+    "io",
+    "rsrq",
+    "rsrp",
+    "snr",
+};
+
+#define N_SIGNAL_METRICS G_N_ELEMENTS (signal_getters)
+G_STATIC_ASSERT (G_N_ELEMENTS (signal_metric_names) == N_SIGNAL_METRICS);
+
+typedef struct {
+    /* Monotonic time */
+    gint64 time;
+    /* NaN if unknown */
+    gfloat values[N_SIGNAL_METRICS];
+} HistorySample;
+
+typedef struct {
+    HistorySample samples[HISTORY_SIZE];
+    guint first;
+    guint n_samples;
+} HistoryRing;
+
+typedef struct {
+    HistoryRing rings[HISTORY_TECHNOLOGY_LAST];
+} History;
+
+static void
+history_clear (MMIfaceModemSignal *self)
+{
+    if (G_UNLIKELY (!history_quark))
+        history_quark = g_quark_from_static_string (HISTORY_TAG);
+    g_object_set_qdata (G_OBJECT (self), history_quark, NULL);
+}
+
+static void
+history_add (MMIfaceModemSignal *self,
+             HistoryTechnology technology,
+             MMSignal *signal,
+             gint64 now)
+{
+    History *history;
+    HistoryRing *ring;
+    HistorySample *sample;
+    guint i;
+
+    if (G_UNLIKELY (!history_quark))
+        history_quark = g_quark_from_static_string (HISTORY_TAG);
+
+    history = g_object_get_qdata (G_OBJECT (self), history_quark);
+    if (!history) {
+        history = g_new0 (History, 1);
+        g_object_set_qdata_full (G_OBJECT (self), history_quark, history, g_free);
+    }
+
+    /* Overwrite the oldest sample once full */
+    ring = &history->rings[technology];
+    if (ring->n_samples < HISTORY_SIZE)
+        sample = &ring->samples[(ring->first + ring->n_samples++) % HISTORY_SIZE];
+    else {
+        sample = &ring->samples[ring->first];
+        ring->first = (ring->first + 1) % HISTORY_SIZE;
+    }
+
+    sample->time = now;
+    for (i = 0; i < N_SIGNAL_METRICS; i++) {
+        gdouble value;
+
+        value = signal_getters[i] (signal);
+        sample->values[i] = (value == MM_SIGNAL_UNKNOWN ? NAN : (gfloat) value);
+    }
+}
+
+static void
+history_add_all (MMIfaceModemSignal *self,
+                 MMSignal *cdma,
+                 MMSignal *evdo,
+                 MMSignal *gsm,
+                 MMSignal *umts,
+                 MMSignal *lte)
+{
+    gint64 now;
+
+    now = mm_clock_get_time ();
+    if (cdma)
+        history_add (self, HISTORY_TECHNOLOGY_CDMA, cdma, now);
+    if (evdo)
+        history_add (self, HISTORY_TECHNOLOGY_EVDO, evdo, now);
+    if (gsm)
+        history_add (self, HISTORY_TECHNOLOGY_GSM, gsm, now);
+    if (umts)
+        history_add (self, HISTORY_TECHNOLOGY_UMTS, umts, now);
+    if (lte)
+        history_add (self, HISTORY_TECHNOLOGY_LTE, lte, now);
+}
+
+static gint
+compare_doubles (gconstpointer a,
+                 gconstpointer b)
+{
+    gdouble da = *(const gdouble *)a;
+    gdouble db = *(const gdouble *)b;
+
+    return (da < db) ? -1 : (da > db);
+}
+
+/* Nearest-rank percentile of sorted values */
+static gdouble
+percentile (const gdouble *sorted,
+            guint n,
+            guint p)
+{
+    guint rank;
+
+    rank = (p * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+static void
+history_build (MMIfaceModemSignal *self,
+               guint window,
+               gboolean include_samples,
+               GVariant **aggregates,
+               GVariant **samples)
+{
+    GVariantBuilder aggregates_builder;
+    GVariantBuilder samples_builder;
+    History *history = NULL;
+    gint64 now;
+    gint64 real_now;
+    guint t;
+
+    g_variant_builder_init (&aggregates_builder, G_VARIANT_TYPE ("a(usudddddd)"));
+    g_variant_builder_init (&samples_builder, G_VARIANT_TYPE ("a(uxddddddd)"));
+
+    now = mm_clock_get_time ();
+    real_now = g_get_real_time ();
+
+    if (history_quark)
+        history = g_object_get_qdata (G_OBJECT (self), history_quark);
+
+    for (t = 0; history && t < HISTORY_TECHNOLOGY_LAST; t++) {
+        HistoryRing *ring = &history->rings[t];
+        guint first;
+        guint n_samples;
+        guint i;
+        guint m;
+
+        /* Skip samples older than the window */
+        for (first = 0; first < ring->n_samples; first++) {
+            HistorySample *sample = &ring->samples[(ring->first + first) % HISTORY_SIZE];
+
+            if (!window || now - sample->time <= (gint64) window * G_USEC_PER_SEC)
+                break;
+        }
+        n_samples = ring->n_samples - first;
+        if (!n_samples)
+            continue;
+
+        for (m = 0; m < N_SIGNAL_METRICS; m++) {
+            gdouble values[HISTORY_SIZE];
+            gdouble sum = 0.0;
+            guint n_values = 0;
+
+            for (i = first; i < ring->n_samples; i++) {
+                gfloat value;
+
+                value = ring->samples[(ring->first + i) % HISTORY_SIZE].values[m];
+                if (isnan (value))
+                    continue;
+                values[n_values++] = value;
+                sum += value;
+            }
+            if (!n_values)
+                continue;
+
+            qsort (values, n_values, sizeof (gdouble), compare_doubles);
+            g_variant_builder_add (&aggregates_builder,
+                                   "(usudddddd)",
+                                   history_access_technologies[t],
+                                   signal_metric_names[m],
+                                   n_values,
+                                   values[0],
+                                   values[n_values - 1],
+                                   sum / n_values,
+                                   percentile (values, n_values, 10),
+                                   percentile (values, n_values, 50),
+                                   percentile (values, n_values, 90));
+        }
+
+        if (!include_samples)
+            continue;
+
+        for (i = first; i < ring->n_samples; i++) {
+            HistorySample *sample = &ring->samples[(ring->first + i) % HISTORY_SIZE];
+
+            g_variant_builder_add (&samples_builder,
+                                   "(uxddddddd)",
+                                   history_access_technologies[t],
+                                   real_now - (now - sample->time),
+                                   (gdouble) sample->values[0],
+                                   (gdouble) sample->values[1],
+                                   (gdouble) sample->values[2],
+                                   (gdouble) sample->values[3],
+                                   (gdouble) sample->values[4],
+                                   (gdouble) sample->values[5],
+                                   (gdouble) sample->values[6]);
+        }
+    }
+
+    *aggregates = g_variant_builder_end (&aggregates_builder);
+    *samples = g_variant_builder_end (&samples_builder);
+}
+
+static void
+update_values (MmGdbusModemSignal *skeleton,
+               MMSignal *thresholds,
+               MMSignal *current,
+               GVariant * (* get_func) (MmGdbusModemSignal *object),
+               void (* set_func) (MmGdbusModemSignal *object, GVariant *value))
+{
+    GVariant *dictionary;
+
+    /* Compare against the last published values, so that slow drifts are
+     * also reported once they accumulate over the threshold */
+    if (thresholds) {
+        MMSignal *previous = NULL;
+        gboolean changed;
+
+        dictionary = get_func (skeleton);
+        if (dictionary)
+            previous = mm_signal_new_from_dictionary (dictionary, NULL);
+        changed = signal_changed (previous, current, thresholds);
+        g_clear_object (&previous);
+        if (!changed)
+            return;
+    }
+
+    dictionary = mm_signal_get_dictionary (current);
+    set_func (skeleton, dictionary);
+    g_variant_unref (dictionary);
+}
+
+static void
+update_all_values (MMIfaceModemSignal *self,
+                   MMSignal *cdma,
+                   MMSignal *evdo,
+                   MMSignal *gsm,
+                   MMSignal *umts,
+                   MMSignal *lte)
+{
+    MMSignal *thresholds;
+    MmGdbusModemSignal *skeleton;
+
+    g_object_get (self,
+                  MM_IFACE_MODEM_SIGNAL_DBUS_SKELETON, &skeleton,
+                  NULL);
+    if (!skeleton) {
+        mm_warn ("Cannot update extended signal information: "
+                 "Couldn't get interface skeleton");
+        return;
+    }
+
+    /* All values go into the history, regardless of the thresholds */
+    history_add_all (self, cdma, evdo, gsm, umts, lte);
+
+    thresholds = load_thresholds (skeleton);
+
+    if (cdma)
+        update_values (skeleton, thresholds, cdma, mm_gdbus_modem_signal_get_cdma, mm_gdbus_modem_signal_set_cdma);
+    if (evdo)
+        update_values (skeleton, thresholds, evdo, mm_gdbus_modem_signal_get_evdo, mm_gdbus_modem_signal_set_evdo);
+    if (gsm)
+        update_values (skeleton, thresholds, gsm, mm_gdbus_modem_signal_get_gsm, mm_gdbus_modem_signal_set_gsm);
+    if (umts)
+        update_values (skeleton, thresholds, umts, mm_gdbus_modem_signal_get_umts, mm_gdbus_modem_signal_set_umts);
+    if (lte)
+        update_values (skeleton, thresholds, lte, mm_gdbus_modem_signal_get_lte, mm_gdbus_modem_signal_set_lte);
+
+    g_clear_object (&thresholds);
+
+    /* Flush right away */
+    g_dbus_interface_skeleton_flush (G_DBUS_INTERFACE_SKELETON (skeleton));
+
+    g_object_unref (skeleton);
+}
+
 static void
 load_values_ready (MMIfaceModemSignal *self,
                    GAsyncResult *res)
 {
-    GVariant *dictionary;
     GError *error = NULL;
     MMSignal *cdma = NULL;
     MMSignal *evdo = NULL;
     MMSignal *gsm = NULL;
     MMSignal *umts = NULL;
     MMSignal *lte = NULL;
-    MmGdbusModemSignal *skeleton;
 
     if (!MM_IFACE_MODEM_SIGNAL_GET_INTERFACE (self)->load_values_finish (
             self,
@@ -99,64 +487,58 @@ load_values_ready (MMIfaceModemSignal *self,
         return;
     }
 
-    g_object_get (self,
-                  MM_IFACE_MODEM_SIGNAL_DBUS_SKELETON, &skeleton,
-                  NULL);
-    if (!skeleton) {
-        mm_warn ("Cannot update extended signal information: "
-                 "Couldn't get interface skeleton");
-        return;
-    }
-
-    if (cdma) {
-        dictionary = mm_signal_get_dictionary (cdma);
-        mm_gdbus_modem_signal_set_cdma (skeleton, dictionary);
-        g_variant_unref (dictionary);
-        g_object_unref (cdma);
-    }
+    update_all_values (self, cdma, evdo, gsm, umts, lte);
 
-    if (evdo) {
-        dictionary = mm_signal_get_dictionary (evdo);
-        mm_gdbus_modem_signal_set_evdo (skeleton, dictionary);
-        g_variant_unref (dictionary);
-        g_object_unref (evdo);
-    }
-
-    if (gsm) {
-        dictionary = mm_signal_get_dictionary (gsm);
-        mm_gdbus_modem_signal_set_gsm (skeleton, dictionary);
-        g_variant_unref (dictionary);
-        g_object_unref (gsm);
-    }
-
-    if (umts) {
-        dictionary = mm_signal_get_dictionary (umts);
-        mm_gdbus_modem_signal_set_umts (skeleton, dictionary);
-        g_variant_unref (dictionary);
-        g_object_unref (umts);
-    }
+    g_clear_object (&cdma);
+    g_clear_object (&evdo);
+    g_clear_object (&gsm);
+    g_clear_object (&umts);
+    g_clear_object (&lte);
+}
 
-    if (lte) {
-        dictionary = mm_signal_get_dictionary (lte);
-        mm_gdbus_modem_signal_set_lte (skeleton, dictionary);
-        g_variant_unref (dictionary);
-        g_object_unref (lte);
-    }
+void
+mm_iface_modem_signal_update (MMIfaceModemSignal *self,
+                              MMSignal *cdma,
+                              MMSignal *evdo,
+                              MMSignal *gsm,
+                              MMSignal *umts,
+                              MMSignal *lte)
+{
+    RefreshContext *ctx;
 
-    /* Flush right away */
-    g_dbus_interface_skeleton_flush (G_DBUS_INTERFACE_SKELETON (skeleton));
+    /* Only while reporting is enabled */
+    if (G_UNLIKELY (!refresh_context_quark))
+        refresh_context_quark  = g_quark_from_static_string (REFRESH_CONTEXT_TAG);
+    ctx = g_object_get_qdata (G_OBJECT (self), refresh_context_quark);
+    if (!ctx)
+        return;
 
-    g_object_unref (skeleton);
+    ctx->last_update = mm_clock_get_time ();
+    update_all_values (self, cdma, evdo, gsm, umts, lte);
 }
 
 static gboolean
 refresh_context_cb (MMIfaceModemSignal *self)
 {
+    MMPortSerialCommandPriority previous;
+    RefreshContext *ctx;
+
+    /* No need to poll while the modem keeps on reporting the values on its
+     * own; polling comes back if the reports stop for a whole period */
+    ctx = g_object_get_qdata (G_OBJECT (self), refresh_context_quark);
+    if (ctx && ctx->last_update &&
+        mm_clock_get_time () - ctx->last_update < (gint64) ctx->rate * G_USEC_PER_SEC)
+        return G_SOURCE_CONTINUE;
+
+    /* Polling shouldn't delay user requests */
+    previous = mm_base_modem_set_command_priority (MM_BASE_MODEM (self),
+                                                   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND);
     MM_IFACE_MODEM_SIGNAL_GET_INTERFACE (self)->load_values (
         self,
         NULL,
         (GAsyncReadyCallback)load_values_ready,
         NULL);
+    mm_base_modem_set_command_priority (MM_BASE_MODEM (self), previous);
     return G_SOURCE_CONTINUE;
 }
 
@@ -165,6 +547,7 @@ teardown_refresh_context (MMIfaceModemSignal *self)
 {
     mm_dbg ("Extended signal information reporting disabled");
     clear_values (self);
+    history_clear (self);
     if (G_UNLIKELY (!refresh_context_quark))
         refresh_context_quark  = g_quark_from_static_string (REFRESH_CONTEXT_TAG);
     g_object_set_qdata (G_OBJECT (self), refresh_context_quark, NULL);
@@ -205,6 +588,7 @@ setup_refresh_context (MMIfaceModemSignal *self,
     if (new_rate == 0) {
         mm_dbg ("Extended signal information reporting disabled (rate: 0 seconds)");
         clear_values (self);
+        history_clear (self);
         g_object_set_qdata (G_OBJECT (self), refresh_context_quark, NULL);
         return TRUE;
     }
@@ -234,8 +618,13 @@ setup_refresh_context (MMIfaceModemSignal *self,
     mm_dbg ("Extended signal information reporting enabled (rate: %u seconds)", new_rate);
     ctx->rate = new_rate;
     if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
-    ctx->timeout_source = g_timeout_add_seconds (ctx->rate, (GSourceFunc) refresh_context_cb, self);
+        mm_poll_scheduler_remove (ctx->timeout_source);
+    ctx->timeout_source = mm_poll_scheduler_add_full ("extended-signal",
+                                                      MM_POLL_SCHEDULER_STAGE_SIGNAL,
+                                                      ctx->rate,
+                                                      MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->rate),
+                                                      (GSourceFunc) refresh_context_cb,
+                                                      self);
 
     /* Also launch right away */
     refresh_context_cb (self);
@@ -272,8 +661,10 @@ handle_setup_auth_ready (MMBaseModem *self,
         g_dbus_method_invocation_take_error (ctx->invocation, error);
     else if (!setup_refresh_context (ctx->self, TRUE, ctx->rate, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_signal_complete_setup (ctx->skeleton, ctx->invocation);
+    }
     handle_setup_context_free (ctx);
 }
 
@@ -301,6 +692,175 @@ handle_setup (MmGdbusModemSignal *skeleton,
 
 /*****************************************************************************/
 
+typedef struct {
+    GDBusMethodInvocation *invocation;
+    MmGdbusModemSignal *skeleton;
+    MMIfaceModemSignal *self;
+    GVariant *settings;
+} HandleSetupThresholdsContext;
+
+static void
+handle_setup_thresholds_context_free (HandleSetupThresholdsContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->self);
+    g_variant_unref (ctx->settings);
+    g_slice_free (HandleSetupThresholdsContext, ctx);
+}
+
+static gboolean
+setup_thresholds (HandleSetupThresholdsContext *ctx,
+                  GError **error)
+{
+    MMSignal *thresholds;
+    GVariant *dictionary;
+    GError *inner_error = NULL;
+    guint i;
+
+    thresholds = mm_signal_new_from_dictionary (ctx->settings, &inner_error);
+    if (inner_error) {
+        g_propagate_error (error, inner_error);
+        return FALSE;
+    }
+
+    /* Empty dictionary, disable thresholds */
+    if (!thresholds) {
+        mm_dbg ("Extended signal information thresholds disabled");
+        mm_gdbus_modem_signal_set_thresholds (ctx->skeleton, g_variant_new ("a{sv}", NULL));
+        return TRUE;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS (signal_getters); i++) {
+        gdouble value;
+
+        value = signal_getters[i] (thresholds);
+        if (value != MM_SIGNAL_UNKNOWN && value < 0.0) {
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_INVALID_ARGS,
+                         "Invalid negative threshold: %lf", value);
+            g_object_unref (thresholds);
+            return FALSE;
+        }
+    }
+
+    /* Publish the parsed values, without any unknown key */
+    dictionary = mm_signal_get_dictionary (thresholds);
+    mm_gdbus_modem_signal_set_thresholds (ctx->skeleton, dictionary);
+    g_variant_unref (dictionary);
+    g_object_unref (thresholds);
+
+    mm_dbg ("Extended signal information thresholds updated");
+    return TRUE;
+}
+
+static void
+handle_setup_thresholds_auth_ready (MMBaseModem *self,
+                                    GAsyncResult *res,
+                                    HandleSetupThresholdsContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else if (!setup_thresholds (ctx, &error))
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
+        mm_gdbus_modem_signal_complete_setup_thresholds (ctx->skeleton, ctx->invocation);
+    }
+    handle_setup_thresholds_context_free (ctx);
+}
+
+static gboolean
+handle_setup_thresholds (MmGdbusModemSignal *skeleton,
+                         GDBusMethodInvocation *invocation,
+                         GVariant *settings,
+                         MMIfaceModemSignal *self)
+{
+    HandleSetupThresholdsContext *ctx;
+
+    ctx = g_slice_new (HandleSetupThresholdsContext);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->self = g_object_ref (self);
+    ctx->settings = g_variant_ref (settings);
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_DEVICE_CONTROL,
+                             (GAsyncReadyCallback)handle_setup_thresholds_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    GDBusMethodInvocation *invocation;
+    MmGdbusModemSignal *skeleton;
+    MMIfaceModemSignal *self;
+    guint window;
+    gboolean include_samples;
+} HandleGetHistoryContext;
+
+static void
+handle_get_history_context_free (HandleGetHistoryContext *ctx)
+{
+    g_object_unref (ctx->invocation);
+    g_object_unref (ctx->skeleton);
+    g_object_unref (ctx->self);
+    g_slice_free (HandleGetHistoryContext, ctx);
+}
+
+static void
+handle_get_history_auth_ready (MMBaseModem *self,
+                               GAsyncResult *res,
+                               HandleGetHistoryContext *ctx)
+{
+    GError *error = NULL;
+    GVariant *aggregates;
+    GVariant *samples;
+
+    if (!mm_base_modem_authorize_finish (self, res, &error)) {
+        g_dbus_method_invocation_take_error (ctx->invocation, error);
+        handle_get_history_context_free (ctx);
+        return;
+    }
+
+    history_build (ctx->self, ctx->window, ctx->include_samples, &aggregates, &samples);
+    mm_dbus_flush_properties (ctx->skeleton);
+    mm_gdbus_modem_signal_complete_get_history (ctx->skeleton, ctx->invocation, aggregates, samples);
+    handle_get_history_context_free (ctx);
+}
+
+static gboolean
+handle_get_history (MmGdbusModemSignal *skeleton,
+                    GDBusMethodInvocation *invocation,
+                    guint window,
+                    gboolean include_samples,
+                    MMIfaceModemSignal *self)
+{
+    HandleGetHistoryContext *ctx;
+
+    ctx = g_slice_new (HandleGetHistoryContext);
+    ctx->invocation = g_object_ref (invocation);
+    ctx->skeleton = g_object_ref (skeleton);
+    ctx->self = g_object_ref (self);
+    ctx->window = window;
+    ctx->include_samples = include_samples;
+
+    mm_base_modem_authorize (MM_BASE_MODEM (self),
+                             invocation,
+                             MM_AUTHORIZATION_DEVICE_CONTROL,
+                             (GAsyncReadyCallback)handle_get_history_auth_ready,
+                             ctx);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 gboolean
 mm_iface_modem_signal_disable_finish (MMIfaceModemSignal *self,
                                       GAsyncResult *res,
@@ -447,6 +1007,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Signal interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -508,6 +1073,14 @@ interface_initialization_step (InitializationContext *ctx)
                           "handle-setup",
                           G_CALLBACK (handle_setup),
                           ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-setup-thresholds",
+                          G_CALLBACK (handle_setup_thresholds),
+                          ctx->self);
+        g_signal_connect (ctx->skeleton,
+                          "handle-get-history",
+                          G_CALLBACK (handle_get_history),
+                          ctx->self);
         /* Finally, export the new interface */
         mm_gdbus_object_skeleton_set_modem_signal (MM_GDBUS_OBJECT_SKELETON (ctx->self),
                                                    MM_GDBUS_MODEM_SIGNAL (ctx->skeleton));
@@ -535,6 +1108,7 @@ mm_iface_modem_signal_initialize (MMIfaceModemSignal *self,
                   NULL);
     if (!skeleton) {
         skeleton = mm_gdbus_modem_signal_skeleton_new ();
+        mm_gdbus_modem_signal_set_thresholds (skeleton, g_variant_new ("a{sv}", NULL));
         clear_values (self);
         g_object_set (self,
                       MM_IFACE_MODEM_SIGNAL_DBUS_SKELETON, skeleton,
@@ -88,6 +88,15 @@ gboolean mm_iface_modem_signal_disable_finish (MMIfaceModemSignal *self,
 /* Shutdown Signal interface */
 void mm_iface_modem_signal_shutdown (MMIfaceModemSignal *self);
 
+/* Report values received from the modem without polling, e.g. in
+ * indications. Polling is skipped while these keep on arriving. */
+void mm_iface_modem_signal_update (MMIfaceModemSignal *self,
+                                   MMSignal *cdma,
+                                   MMSignal *evdo,
+                                   MMSignal *gsm,
+                                   MMSignal *umts,
+                                   MMSignal *lte);
+
 /* Bind properties for simple GetStatus() */
 void mm_iface_modem_signal_bind_simple_status (MMIfaceModemSignal *self,
                                                MMSimpleStatus *status);
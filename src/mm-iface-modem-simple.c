@@ -26,6 +26,7 @@
 #include "mm-iface-modem-3gpp.h"
 #include "mm-iface-modem-cdma.h"
 #include "mm-iface-modem-simple.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
 
 /*****************************************************************************/
@@ -190,6 +191,10 @@ typedef struct {
     GVariant *dictionary;
     MMSimpleConnectProperties *properties;
 
+    /* Registration and bearer setup run in parallel */
+    guint n_pending;
+    GError *pending_error;
+
     /* Results to set */
     MMBaseBearer *bearer;
 } ConnectionContext;
@@ -197,6 +202,7 @@ typedef struct {
 static void
 connection_context_free (ConnectionContext *ctx)
 {
+    g_assert (ctx->pending_error == NULL);
     g_variant_unref (ctx->dictionary);
     if (ctx->properties)
         g_object_unref (ctx->properties);
@@ -210,6 +216,35 @@ connection_context_free (ConnectionContext *ctx)
 
 static void connection_step (ConnectionContext *ctx);
 
+/* Registration may take a while, so the bearer is set up meanwhile; each of
+ * them reports here when finished, and the connection goes on once both
+ * are done. */
+static void
+register_and_bearer_done (ConnectionContext *ctx,
+                          GError *error)
+{
+    if (error) {
+        if (!ctx->pending_error)
+            ctx->pending_error = error;
+        else
+            g_error_free (error);
+    }
+
+    g_assert (ctx->n_pending > 0);
+    if (--ctx->n_pending > 0)
+        return;
+
+    if (ctx->pending_error) {
+        g_dbus_method_invocation_take_error (ctx->invocation, ctx->pending_error);
+        ctx->pending_error = NULL;
+        connection_context_free (ctx);
+        return;
+    }
+
+    ctx->step = CONNECTION_STEP_CONNECT;
+    connection_step (ctx);
+}
+
 static void
 connect_bearer_ready (MMBaseBearer *bearer,
                       GAsyncResult *res,
@@ -238,15 +273,9 @@ create_bearer_ready (MMIfaceModem *self,
 
     /* ownership for the caller */
     ctx->bearer = mm_iface_modem_create_bearer_finish (self, res, &error);
-    if (!ctx->bearer) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        connection_context_free (ctx);
-        return;
-    }
 
-    /* Bearer available! */
-    ctx->step++;
-    connection_step (ctx);
+    /* Bearer available, unless error */
+    register_and_bearer_done (ctx, error);
 }
 
 static void
@@ -256,15 +285,10 @@ register_in_3gpp_or_cdma_network_ready (MMIfaceModemSimple *self,
 {
     GError *error = NULL;
 
-    if (!register_in_3gpp_or_cdma_network_finish (self, res, &error)) {
-        g_dbus_method_invocation_take_error (ctx->invocation, error);
-        connection_context_free (ctx);
-        return;
-    }
+    if (register_in_3gpp_or_cdma_network_finish (self, res, &error))
+        mm_dbg ("Simple connect: registered");
 
-    /* Registered now! */
-    ctx->step++;
-    connection_step (ctx);
+    register_and_bearer_done (ctx, error);
 }
 
 static void
@@ -479,18 +503,18 @@ connection_step (ConnectionContext *ctx)
 
         if (mm_iface_modem_is_3gpp (MM_IFACE_MODEM (ctx->self)) ||
             mm_iface_modem_is_cdma (MM_IFACE_MODEM (ctx->self))) {
-            /* 3GPP or CDMA registration */
+            /* 3GPP or CDMA registration, while the bearer gets ready */
+            ctx->n_pending++;
             register_in_3gpp_or_cdma_network (
                 ctx->self,
                 mm_simple_connect_properties_get_operator_id (ctx->properties),
                 (GAsyncReadyCallback)register_in_3gpp_or_cdma_network_ready,
                 ctx);
-            return;
         }
 
         /* If not 3GPP and not CDMA, this will possibly be a POTS modem,
          * which won't require any specific registration anywhere.
-         * So, fall down to next step */
+         * In any case, fall down to next step */
         ctx->step++;
 
     case CONNECTION_STEP_BEARER: {
@@ -500,16 +524,16 @@ connection_step (ConnectionContext *ctx)
         mm_info ("Simple connect state (%d/%d): Bearer",
                  ctx->step, CONNECTION_STEP_LAST);
 
+        ctx->n_pending++;
+
         g_object_get (ctx->self,
                       MM_IFACE_MODEM_BEARER_LIST, &list,
                       NULL);
         if (!list) {
-            g_dbus_method_invocation_return_error (
-                ctx->invocation,
-                MM_CORE_ERROR,
-                MM_CORE_ERROR_FAILED,
-                "Couldn't get the bearer list");
-            connection_context_free (ctx);
+            register_and_bearer_done (ctx,
+                                      g_error_new (MM_CORE_ERROR,
+                                                   MM_CORE_ERROR_FAILED,
+                                                   "Couldn't get the bearer list"));
             return;
         }
 
@@ -548,14 +572,12 @@ connection_step (ConnectionContext *ctx)
 
                 /* Re-check space, and if we still are in max, return an error */
                 if (mm_bearer_list_get_max (list) == mm_bearer_list_get_count (list)) {
-                    g_dbus_method_invocation_return_error (
-                        ctx->invocation,
-                        MM_CORE_ERROR,
-                        MM_CORE_ERROR_TOO_MANY,
-                        "Cannot create new bearer: all existing bearers are connected");
-                    connection_context_free (ctx);
                     g_object_unref (list);
                     g_object_unref (bearer_properties);
+                    register_and_bearer_done (ctx,
+                                              g_error_new (MM_CORE_ERROR,
+                                                           MM_CORE_ERROR_TOO_MANY,
+                                                           "Cannot create new bearer: all existing bearers are connected"));
                     return;
                 }
             }
@@ -574,8 +596,8 @@ connection_step (ConnectionContext *ctx)
                 mm_base_bearer_get_path (ctx->bearer));
         g_object_unref (list);
         g_object_unref (bearer_properties);
-        /* Fall down to next step */
-        ctx->step++;
+        register_and_bearer_done (ctx, NULL);
+        return;
     }
 
     case CONNECTION_STEP_CONNECT:
@@ -601,6 +623,7 @@ connection_step (ConnectionContext *ctx)
         mm_info ("Simple connect state (%d/%d): All done",
                  ctx->step, CONNECTION_STEP_LAST);
         /* All done, yey! */
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_simple_complete_connect (
             ctx->skeleton,
             ctx->invocation,
@@ -790,6 +813,7 @@ disconnect_next_bearer (DisconnectionContext *ctx)
 
     /* No more bearers? all done! */
     if (!ctx->bearers) {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_simple_complete_disconnect (ctx->skeleton,
                                                    ctx->invocation);
         disconnection_context_free (ctx);
@@ -903,6 +927,7 @@ handle_get_status (MmGdbusModemSimple *skeleton,
                   NULL);
 
     dictionary = mm_simple_status_get_dictionary (status);
+    mm_dbus_flush_properties (skeleton);
     mm_gdbus_modem_simple_complete_get_status (skeleton, invocation, dictionary);
     g_variant_unref (dictionary);
 
@@ -17,9 +17,13 @@
 #define _LIBMM_INSIDE_MM
 #include <libmm-glib.h>
 
+#include "mm-base-modem.h"
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-time.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
+#include "mm-poll-scheduler.h"
 
 #define SUPPORT_CHECKED_TAG              "time-support-checked-tag"
 #define SUPPORTED_TAG                    "time-supported-tag"
@@ -29,8 +33,10 @@ static GQuark support_checked_quark;
 static GQuark supported_quark;
 static GQuark network_timezone_cancellable_quark;
 
-#define TIMEZONE_POLL_INTERVAL_SEC 5
-#define TIMEZONE_POLL_RETRIES 6
+/* The poll interval is doubled after every retry, up to the max */
+#define TIMEZONE_POLL_INTERVAL_SEC     5
+#define TIMEZONE_POLL_INTERVAL_MAX_SEC 60
+#define TIMEZONE_POLL_RETRIES          6
 
 /*****************************************************************************/
 
@@ -70,10 +76,12 @@ load_network_time_ready (MMIfaceModemTime *self,
                                                                                    &error);
     if (error)
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_time_complete_get_network_time (ctx->skeleton,
                                                        ctx->invocation,
                                                        time_str);
+    }
     g_free (time_str);
     handle_get_network_time_context_free (ctx);
 }
@@ -132,6 +140,7 @@ typedef struct {
     gulong state_changed_id;
     guint network_timezone_poll_id;
     guint network_timezone_poll_retries;
+    guint network_timezone_poll_interval;
 } UpdateNetworkTimezoneContext;
 
 static gboolean timezone_poll_cb (UpdateNetworkTimezoneContext *ctx);
@@ -165,7 +174,7 @@ cancelled (GCancellable *cancellable,
 
     /* If waiting in the timeout loop, remove the timeout */
     else if (ctx->network_timezone_poll_id)
-        g_source_remove (ctx->network_timezone_poll_id);
+        mm_poll_scheduler_remove (ctx->network_timezone_poll_id);
 
     g_simple_async_result_set_error (ctx->result,
                                      MM_CORE_ERROR,
@@ -232,12 +241,17 @@ load_network_timezone_ready (MMIfaceModemTime *self,
         }
 
         /* Otherwise, reconnect cancellable and relaunch timeout to query a bit
-         * later */
+         * later, backing off so that the ports are not kept busy while the
+         * modem is registering */
         ctx->cancelled_id = g_cancellable_connect (ctx->cancellable,
                                                    G_CALLBACK (cancelled),
                                                    ctx,
                                                    NULL);
-        ctx->network_timezone_poll_id = g_timeout_add_seconds (TIMEZONE_POLL_INTERVAL_SEC,
+        ctx->network_timezone_poll_interval = MIN (ctx->network_timezone_poll_interval * 2,
+                                                   TIMEZONE_POLL_INTERVAL_MAX_SEC);
+        ctx->network_timezone_poll_id = mm_poll_scheduler_add ("network-timezone",
+                                                               ctx->network_timezone_poll_interval,
+                                                               MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->network_timezone_poll_interval),
                                                                (GSourceFunc)timezone_poll_cb,
                                                                ctx);
 
@@ -255,6 +269,8 @@ load_network_timezone_ready (MMIfaceModemTime *self,
 static gboolean
 timezone_poll_cb (UpdateNetworkTimezoneContext *ctx)
 {
+    MMPortSerialCommandPriority previous;
+
     ctx->network_timezone_poll_id = 0;
 
     /* Before we launch the async loading of the network timezone,
@@ -265,10 +281,14 @@ timezone_poll_cb (UpdateNetworkTimezoneContext *ctx)
                               ctx->cancelled_id);
     ctx->cancelled_id = 0;
 
+    /* Polling shouldn't delay user requests */
+    previous = mm_base_modem_set_command_priority (MM_BASE_MODEM (ctx->self),
+                                                   MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND);
     MM_IFACE_MODEM_TIME_GET_INTERFACE (ctx->self)->load_network_timezone (
         ctx->self,
         (GAsyncReadyCallback)load_network_timezone_ready,
         ctx);
+    mm_base_modem_set_command_priority (MM_BASE_MODEM (ctx->self), previous);
 
     return G_SOURCE_REMOVE;
 }
@@ -279,7 +299,10 @@ start_timezone_poll (UpdateNetworkTimezoneContext *ctx)
     /* Setup loop to query current timezone, don't do it right away.
      * Note that we're passing the context reference to the loop. */
     ctx->network_timezone_poll_retries = TIMEZONE_POLL_RETRIES;
-    ctx->network_timezone_poll_id = g_timeout_add_seconds (TIMEZONE_POLL_INTERVAL_SEC,
+    ctx->network_timezone_poll_interval = TIMEZONE_POLL_INTERVAL_SEC;
+    ctx->network_timezone_poll_id = mm_poll_scheduler_add ("network-timezone",
+                                                           ctx->network_timezone_poll_interval,
+                                                           MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->network_timezone_poll_interval),
                                                            (GSourceFunc)timezone_poll_cb,
                                                            ctx);
 }
@@ -386,6 +409,26 @@ mm_iface_modem_time_update_network_time (MMIfaceModemTime *self,
 
 /*****************************************************************************/
 
+void
+mm_iface_modem_time_update_network_timezone (MMIfaceModemTime *self,
+                                             MMNetworkTimezone *tz)
+{
+    GCancellable *cancellable = NULL;
+
+    update_network_timezone_dictionary (self, tz);
+
+    /* The modem reported the timezone by itself, so there's no need to keep
+     * on polling for it */
+    if (G_LIKELY (network_timezone_cancellable_quark))
+        cancellable = g_object_get_qdata (G_OBJECT (self), network_timezone_cancellable_quark);
+    if (cancellable && !g_cancellable_is_cancelled (cancellable)) {
+        mm_dbg ("Network timezone reported by the modem, stopping timezone polling");
+        g_cancellable_cancel (cancellable);
+    }
+}
+
+/*****************************************************************************/
+
 typedef struct _DisablingContext DisablingContext;
 static void interface_disabling_step (DisablingContext *ctx);
 
@@ -618,7 +661,10 @@ update_network_timezone_ready (MMIfaceModemTime *self,
     if (!update_network_timezone_finish (self, res, &error)) {
         if (!g_error_matches (error,
                               MM_CORE_ERROR,
-                              MM_CORE_ERROR_UNSUPPORTED))
+                              MM_CORE_ERROR_UNSUPPORTED) &&
+            !g_error_matches (error,
+                              MM_CORE_ERROR,
+                              MM_CORE_ERROR_CANCELLED))
             mm_dbg ("Couldn't update network timezone: '%s'", error->message);
         g_error_free (error);
     }
@@ -850,6 +896,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Time interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -20,13 +20,18 @@
 #include "mm-iface-modem.h"
 #include "mm-iface-modem-voice.h"
 #include "mm-call-list.h"
+#include "mm-modem-helpers.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 
 #define SUPPORT_CHECKED_TAG "voice-support-checked-tag"
 #define SUPPORTED_TAG       "voice-supported-tag"
+#define CALL_LIST_REFRESH_CONTEXT_TAG "voice-call-list-refresh-context-tag"
 
 static GQuark support_checked_quark;
 static GQuark supported_quark;
+static GQuark call_list_refresh_context_quark;
 
 /*****************************************************************************/
 
@@ -212,6 +217,247 @@ mm_iface_modem_voice_received_dtmf (MMIfaceModemVoice *self,
     return updated;
 }
 
+/*****************************************************************************/
+/* Full call list reporting */
+
+static MMCallStateReason
+reason_for_reported_state (MMCallState state)
+{
+    switch (state) {
+    case MM_CALL_STATE_DIALING:
+    case MM_CALL_STATE_RINGING_OUT:
+        return MM_CALL_STATE_REASON_OUTGOING_STARTED;
+    case MM_CALL_STATE_RINGING_IN:
+    case MM_CALL_STATE_WAITING:
+        return MM_CALL_STATE_REASON_INCOMING_NEW;
+    case MM_CALL_STATE_ACTIVE:
+        return MM_CALL_STATE_REASON_ACCEPTED;
+    case MM_CALL_STATE_TERMINATED:
+        return MM_CALL_STATE_REASON_TERMINATED;
+    default:
+        return MM_CALL_STATE_REASON_UNKNOWN;
+    }
+}
+
+typedef struct {
+    MMCallDirection direction;
+    MMBaseCall *found;
+} FindUnindexedCallContext;
+
+static void
+find_unindexed_call (MMBaseCall *call,
+                     FindUnindexedCallContext *ctx)
+{
+    MMCallState state;
+    MMCallDirection direction;
+
+    if (ctx->found || mm_base_call_get_index (call))
+        return;
+
+    g_object_get (call,
+                  "state",     &state,
+                  "direction", &direction,
+                  NULL);
+    if (state != MM_CALL_STATE_TERMINATED && direction == ctx->direction)
+        ctx->found = call;
+}
+
+static MMBaseCall *
+create_reported_call (MMIfaceModemVoice *self,
+                      MMCallList *list,
+                      const MMCallInfo *call_info)
+{
+    MMBaseCall *call;
+
+    mm_dbg ("Reported call %u does not exist; create it", call_info->index);
+
+    call = mm_base_call_new (MM_BASE_MODEM (self));
+    g_object_set (call,
+                  "state",        call_info->state,
+                  "state-reason", reason_for_reported_state (call_info->state),
+                  "direction",    call_info->direction,
+                  NULL);
+    mm_base_call_export (call);
+    mm_call_list_add_call (list, call);
+    g_object_unref (call);
+
+    return call;
+}
+
+typedef struct {
+    MMCallList *list;
+    GList *call_info_list;
+} TerminateUnreportedContext;
+
+static void
+terminate_unreported_call (MMBaseCall *call,
+                           TerminateUnreportedContext *ctx)
+{
+    MMCallState state;
+    guint index;
+    GList *l;
+
+    g_object_get (call, "state", &state, NULL);
+    if (state == MM_CALL_STATE_TERMINATED)
+        return;
+
+    index = mm_base_call_get_index (call);
+    if (index) {
+        for (l = ctx->call_info_list; l; l = g_list_next (l)) {
+            if (((MMCallInfo *)l->data)->index == index)
+                return;
+        }
+    } else if (state == MM_CALL_STATE_DIALING)
+        /* Not yet known by the modem */
+        return;
+
+    mm_dbg ("Call %u no longer reported, terminated", index);
+    mm_call_list_set_call_index (ctx->list, call, 0);
+    mm_base_call_change_state (call, MM_CALL_STATE_TERMINATED, MM_CALL_STATE_REASON_TERMINATED);
+}
+
+void
+mm_iface_modem_voice_report_all_calls (MMIfaceModemVoice *self,
+                                       GList *call_info_list)
+{
+    MMCallList *list = NULL;
+    TerminateUnreportedContext terminate_ctx;
+    GList *l;
+
+    g_object_get (MM_BASE_MODEM (self),
+                  MM_IFACE_MODEM_VOICE_CALL_LIST, &list,
+                  NULL);
+    if (!list)
+        return;
+
+    for (l = call_info_list; l; l = g_list_next (l)) {
+        const MMCallInfo *call_info = l->data;
+        MMBaseCall *call;
+        MMCallState state;
+        const gchar *number;
+
+        call = mm_call_list_get_call_by_index (list, call_info->index);
+        if (!call) {
+            FindUnindexedCallContext find_ctx;
+
+            /* Either a call we already know of but which the modem hadn't
+             * reported yet, or a new one */
+            find_ctx.direction = call_info->direction;
+            find_ctx.found = NULL;
+            mm_call_list_foreach (list, (MMCallListForeachFunc)find_unindexed_call, &find_ctx);
+            call = (find_ctx.found ?
+                    find_ctx.found :
+                    create_reported_call (self, list, call_info));
+            mm_call_list_set_call_index (list, call, call_info->index);
+        }
+
+        number = mm_gdbus_call_get_number (MM_GDBUS_CALL (call));
+        if (call_info->number && (!number || !number[0])) {
+            g_object_set (call, "number", call_info->number, NULL);
+            mm_gdbus_call_set_number (MM_GDBUS_CALL (call), call_info->number);
+        }
+
+        g_object_get (call, "state", &state, NULL);
+        if (state != call_info->state)
+            mm_base_call_change_state (call,
+                                       call_info->state,
+                                       reason_for_reported_state (call_info->state));
+    }
+
+    terminate_ctx.list = list;
+    terminate_ctx.call_info_list = call_info_list;
+    mm_call_list_foreach (list, (MMCallListForeachFunc)terminate_unreported_call, &terminate_ctx);
+
+    g_object_unref (list);
+}
+
+typedef struct {
+    gboolean running;
+    gboolean pending;
+} CallListRefreshContext;
+
+static CallListRefreshContext *
+get_call_list_refresh_context (MMIfaceModemVoice *self)
+{
+    CallListRefreshContext *ctx;
+
+    if (G_UNLIKELY (!call_list_refresh_context_quark))
+        call_list_refresh_context_quark = (g_quark_from_static_string (
+                                               CALL_LIST_REFRESH_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), call_list_refresh_context_quark);
+    if (!ctx) {
+        ctx = g_new0 (CallListRefreshContext, 1);
+        g_object_set_qdata_full (G_OBJECT (self),
+                                 call_list_refresh_context_quark,
+                                 ctx,
+                                 g_free);
+    }
+
+    return ctx;
+}
+
+static void run_call_list_refresh (MMIfaceModemVoice *self);
+
+static void
+load_call_list_ready (MMIfaceModemVoice *self,
+                      GAsyncResult *res,
+                      gpointer unused)
+{
+    CallListRefreshContext *ctx;
+    GList *call_info_list;
+    GError *error = NULL;
+
+    call_info_list = MM_IFACE_MODEM_VOICE_GET_INTERFACE (self)->load_call_list_finish (self, res, &error);
+    if (error) {
+        mm_dbg ("Couldn't load call list: '%s'", error->message);
+        g_error_free (error);
+    } else {
+        mm_iface_modem_voice_report_all_calls (self, call_info_list);
+        mm_3gpp_call_info_list_free (call_info_list);
+    }
+
+    /* Requested again while loading? The list may have changed meanwhile */
+    ctx = get_call_list_refresh_context (self);
+    ctx->running = FALSE;
+    if (ctx->pending)
+        run_call_list_refresh (self);
+
+    g_object_unref (self);
+}
+
+static void
+run_call_list_refresh (MMIfaceModemVoice *self)
+{
+    CallListRefreshContext *ctx;
+
+    ctx = get_call_list_refresh_context (self);
+    if (ctx->running) {
+        ctx->pending = TRUE;
+        return;
+    }
+
+    /* Released when loaded */
+    g_object_ref (self);
+    ctx->running = TRUE;
+    ctx->pending = FALSE;
+    MM_IFACE_MODEM_VOICE_GET_INTERFACE (self)->load_call_list (
+        self,
+        (GAsyncReadyCallback)load_call_list_ready,
+        NULL);
+}
+
+gboolean
+mm_iface_modem_voice_refresh_call_list (MMIfaceModemVoice *self)
+{
+    if (!MM_IFACE_MODEM_VOICE_GET_INTERFACE (self)->load_call_list ||
+        !MM_IFACE_MODEM_VOICE_GET_INTERFACE (self)->load_call_list_finish)
+        return FALSE;
+
+    run_call_list_refresh (self);
+    return TRUE;
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -240,8 +486,10 @@ handle_delete_ready (MMCallList *list,
 
     if (!mm_call_list_delete_call_finish (list, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_voice_complete_delete_call (ctx->skeleton, ctx->invocation);
+    }
 
     handle_delete_context_free (ctx);
 }
@@ -400,6 +648,7 @@ handle_create_auth_ready (MMBaseModem *self,
     mm_call_list_add_call (list, call);
 
     /* Complete the DBus call */
+    mm_dbus_flush_properties (ctx->skeleton);
     mm_gdbus_modem_voice_complete_create_call (ctx->skeleton,
                                                ctx->invocation,
                                                mm_base_call_get_path (call));
@@ -470,6 +719,7 @@ handle_list (MmGdbusModemVoice *skeleton,
     }
 
     paths = mm_call_list_get_paths (list);
+    mm_dbus_flush_properties (skeleton);
     mm_gdbus_modem_voice_complete_list_calls (skeleton,
                                               invocation,
                                               (const gchar *const *)paths);
@@ -935,6 +1185,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Voice interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Setup quarks if we didn't do it before */
@@ -79,6 +79,14 @@ struct _MMIfaceModemVoice {
 
     /* Create CALL objects */
     MMBaseCall * (* create_call) (MMIfaceModemVoice *self);
+
+    /* Load the list of current calls, as a list of MMCallInfo (optional) */
+    void (* load_call_list) (MMIfaceModemVoice *self,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data);
+    GList * (* load_call_list_finish) (MMIfaceModemVoice *self,
+                                       GAsyncResult *res,
+                                       GError **error);
 };
 
 GType mm_iface_modem_voice_get_type (void);
@@ -129,6 +137,15 @@ gboolean    mm_iface_modem_voice_network_hangup                 (MMIfaceModemVoi
 gboolean    mm_iface_modem_voice_received_dtmf                  (MMIfaceModemVoice *self,
                                                                  gchar *dtmf);
 
+/* Update all CALL objects from the full list of current calls in the modem,
+ * given as a list of MMCallInfo */
+void        mm_iface_modem_voice_report_all_calls               (MMIfaceModemVoice *self,
+                                                                 GList *call_info_list);
+
+/* Reload the list of current calls and report it; returns FALSE if the
+ * modem can't load it, so that the caller may fall back to other means */
+gboolean    mm_iface_modem_voice_refresh_call_list              (MMIfaceModemVoice *self);
+
 /* Look for a new valid multipart reference */
 guint8 mm_iface_modem_voice_get_local_multipart_reference (MMIfaceModemVoice *self,
                                                            const gchar *number,
@@ -20,29 +20,40 @@
 
 #include "mm-modem-helpers.h"
 #include "mm-iface-modem.h"
+#include "mm-iface-modem-firmware.h"
 #include "mm-base-modem.h"
 #include "mm-base-modem-at.h"
 #include "mm-base-sim.h"
 #include "mm-bearer-list.h"
+#include "mm-clock.h"
+#include "mm-dbus-helpers.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
+#include "mm-poll-scheduler.h"
 #include "mm-context.h"
+#include "mm-modem-info-cache.h"
+#include "mm-status-segment.h"
 
 #define SIGNAL_QUALITY_RECENT_TIMEOUT_SEC        60
 #define SIGNAL_QUALITY_INITIAL_CHECK_TIMEOUT_SEC 3
 #define SIGNAL_QUALITY_CHECK_TIMEOUT_SEC         30
+#define SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC      300
 #define ACCESS_TECHNOLOGIES_CHECK_TIMEOUT_SEC    30
+#define ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC 300
 
 #define STATE_UPDATE_CONTEXT_TAG              "state-update-context-tag"
 #define SIGNAL_QUALITY_UPDATE_CONTEXT_TAG     "signal-quality-update-context-tag"
 #define SIGNAL_QUALITY_CHECK_CONTEXT_TAG      "signal-quality-check-context-tag"
 #define ACCESS_TECHNOLOGIES_CHECK_CONTEXT_TAG "access-technologies-check-context-tag"
 #define RESTART_INITIALIZE_IDLE_TAG           "restart-initialize-tag"
+#define UNLOCK_RETRIES_SERIAL_TAG             "unlock-retries-serial-tag"
 
 static GQuark state_update_context_quark;
 static GQuark signal_quality_update_context_quark;
 static GQuark signal_quality_check_context_quark;
 static GQuark access_technologies_check_context_quark;
 static GQuark restart_initialize_idle_quark;
+static GQuark unlock_retries_serial_quark;
 
 /*****************************************************************************/
 
@@ -205,9 +216,9 @@ mm_iface_modem_wait_for_final_state (MMIfaceModem *self,
                                               G_CALLBACK (state_changed),
                                               ctx);
     /* But we don't want to wait forever */
-    ctx->state_changed_wait_id = g_timeout_add_seconds (10,
-                                                        (GSourceFunc)state_changed_wait_expired,
-                                                        ctx);
+    ctx->state_changed_wait_id = mm_clock_timeout_add_seconds (10,
+                                                               (GSourceFunc)state_changed_wait_expired,
+                                                               ctx);
 }
 
 /*****************************************************************************/
@@ -290,9 +301,9 @@ load_unlock_required_ready (MMIfaceModem *self,
             mm_dbg ("Retrying (%u) unlock required check", ctx->retries);
 
             g_assert (ctx->pin_check_timeout_id == 0);
-            ctx->pin_check_timeout_id = g_timeout_add_seconds (2,
-                                                               (GSourceFunc)load_unlock_required_again,
-                                                               ctx);
+            ctx->pin_check_timeout_id = mm_clock_timeout_add_seconds (2,
+                                                                      (GSourceFunc)load_unlock_required_again,
+                                                                      ctx);
             g_error_free (error);
             return;
         }
@@ -586,6 +597,7 @@ handle_create_bearer_ready (MMIfaceModem *self,
     if (!bearer)
         g_dbus_method_invocation_take_error (ctx->invocation, error);
     else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_create_bearer (ctx->skeleton,
                                                ctx->invocation,
                                                mm_base_bearer_get_path (bearer));
@@ -679,8 +691,10 @@ command_ready (MMIfaceModem *self,
                                                                   &error);
     if (error)
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_command (ctx->skeleton, ctx->invocation, result);
+    }
 
     handle_command_context_free (ctx);
 }
@@ -792,8 +806,10 @@ delete_bearer_disconnect_ready (MMBaseBearer *bearer,
 
     if (!mm_bearer_list_delete_bearer (ctx->list, ctx->bearer_path, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_delete_bearer (ctx->skeleton, ctx->invocation);
+    }
     handle_delete_bearer_context_free (ctx);
 }
 
@@ -883,6 +899,7 @@ handle_list_bearers (MmGdbusModem *skeleton,
     }
 
     paths = mm_bearer_list_get_paths (list);
+    mm_dbus_flush_properties (skeleton);
     mm_gdbus_modem_complete_list_bearers (skeleton,
                                           invocation,
                                           (const gchar *const *)paths);
@@ -923,6 +940,7 @@ mm_iface_modem_update_access_technologies (MMIfaceModem *self,
         gchar *new_access_tech_string;
 
         mm_gdbus_modem_set_access_technologies (skeleton, built_access_tech);
+        mm_status_segment_update_modem (MM_BASE_MODEM (self));
 
         /* Log */
         old_access_tech_string = mm_modem_access_technology_build_string_from_mask (old_access_tech);
@@ -942,14 +960,18 @@ mm_iface_modem_update_access_technologies (MMIfaceModem *self,
 
 typedef struct {
     guint timeout_source;
+    guint interval;
     gboolean running;
+    gboolean coalesced;
+    time_t last_unsolicited_update;
+    time_t last_check;
 } AccessTechnologiesCheckContext;
 
 static void
 access_technologies_check_context_free (AccessTechnologiesCheckContext *ctx)
 {
     if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+        mm_poll_scheduler_remove (ctx->timeout_source);
     g_free (ctx);
 }
 
@@ -983,6 +1005,31 @@ access_technologies_check_ready (MMIfaceModem *self,
         ctx->running = FALSE;
 }
 
+static gboolean periodic_access_technologies_check (MMIfaceModem *self);
+
+static void
+access_technologies_check_reschedule (MMIfaceModem *self,
+                                      AccessTechnologiesCheckContext *ctx,
+                                      guint interval)
+{
+    ctx->interval = interval;
+    if (ctx->timeout_source) {
+        mm_poll_scheduler_remove (ctx->timeout_source);
+        ctx->timeout_source = 0;
+    }
+
+    /* When coalesced, checks are run by the periodic registration check */
+    if (ctx->coalesced)
+        return;
+
+    ctx->timeout_source = mm_poll_scheduler_add_full ("access-technologies",
+                                                      MM_POLL_SCHEDULER_STAGE_SIGNAL,
+                                                      ctx->interval,
+                                                      MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->interval),
+                                                      (GSourceFunc)periodic_access_technologies_check,
+                                                      self);
+}
+
 static gboolean
 periodic_access_technologies_check (MMIfaceModem *self)
 {
@@ -990,14 +1037,34 @@ periodic_access_technologies_check (MMIfaceModem *self)
 
     ctx = g_object_get_qdata (G_OBJECT (self), access_technologies_check_context_quark);
 
+    /* Nothing to do while the modem keeps reporting by itself; otherwise a
+     * single check at the watchdog interval */
+    if (ctx->interval == ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC &&
+        time (NULL) - ctx->last_unsolicited_update < ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC)
+        return G_SOURCE_CONTINUE;
+
+    /* When coalesced we're run at the registration check interval, so keep
+     * the watchdog pace by ourselves */
+    if (ctx->coalesced &&
+        ctx->interval == ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC &&
+        time (NULL) - ctx->last_check < ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC)
+        return G_SOURCE_CONTINUE;
+
     /* Only launch a new one if not one running already OR if the last one run
      * was more than 15s ago. */
     if (!ctx->running) {
+        MMPortSerialCommandPriority previous;
+
         ctx->running = TRUE;
+        ctx->last_check = time (NULL);
+        /* Polling shouldn't delay user requests */
+        previous = mm_base_modem_set_command_priority (MM_BASE_MODEM (self),
+                                                       MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND);
         MM_IFACE_MODEM_GET_INTERFACE (self)->load_access_technologies (
             self,
             (GAsyncReadyCallback)access_technologies_check_ready,
             NULL);
+        mm_base_modem_set_command_priority (MM_BASE_MODEM (self), previous);
     }
 
     return G_SOURCE_CONTINUE;
@@ -1017,16 +1084,75 @@ mm_iface_modem_refresh_access_technologies (MMIfaceModem *self)
         return;
 
     /* Re-set timeout */
-    if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
-    ctx->timeout_source = g_timeout_add_seconds (ACCESS_TECHNOLOGIES_CHECK_TIMEOUT_SEC,
-                                                 (GSourceFunc)periodic_access_technologies_check,
-                                                 self);
+    access_technologies_check_reschedule (self, ctx, ctx->interval);
 
     /* Get first access technology value */
     periodic_access_technologies_check (self);
 }
 
+void
+mm_iface_modem_coalesce_access_technologies_check (MMIfaceModem *self,
+                                                   gboolean coalesce)
+{
+    AccessTechnologiesCheckContext *ctx;
+
+    if (G_UNLIKELY (!access_technologies_check_context_quark))
+        access_technologies_check_context_quark = (g_quark_from_static_string (
+                                                       ACCESS_TECHNOLOGIES_CHECK_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), access_technologies_check_context_quark);
+    if (!ctx || ctx->coalesced == coalesce)
+        return;
+
+    mm_dbg ("Periodic access technology checks %s the registration checks",
+            coalesce ? "coalesced with" : "no longer coalesced with");
+    ctx->coalesced = coalesce;
+    access_technologies_check_reschedule (self, ctx, ctx->interval);
+}
+
+void
+mm_iface_modem_run_coalesced_access_technologies_check (MMIfaceModem *self)
+{
+    AccessTechnologiesCheckContext *ctx;
+
+    if (G_UNLIKELY (!access_technologies_check_context_quark))
+        access_technologies_check_context_quark = (g_quark_from_static_string (
+                                                       ACCESS_TECHNOLOGIES_CHECK_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), access_technologies_check_context_quark);
+    if (!ctx || !ctx->coalesced)
+        return;
+
+    periodic_access_technologies_check (self);
+}
+
+void
+mm_iface_modem_update_access_technologies_unsolicited (MMIfaceModem *self,
+                                                       MMModemAccessTechnology access_tech,
+                                                       guint32 mask)
+{
+    AccessTechnologiesCheckContext *ctx;
+
+    mm_iface_modem_update_access_technologies (self, access_tech, mask);
+
+    if (G_UNLIKELY (!access_technologies_check_context_quark))
+        access_technologies_check_context_quark = (g_quark_from_static_string (
+                                                       ACCESS_TECHNOLOGIES_CHECK_CONTEXT_TAG));
+
+    ctx = g_object_get_qdata (G_OBJECT (self), access_technologies_check_context_quark);
+    if (!ctx)
+        return;
+
+    ctx->last_unsolicited_update = time (NULL);
+
+    /* The modem reports access technology changes by itself, so polling is
+     * only needed as a watchdog in case the reports stop */
+    if (ctx->interval != ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC) {
+        mm_dbg ("Access technology reported by the modem, backing off periodic checks");
+        access_technologies_check_reschedule (self, ctx, ACCESS_TECHNOLOGIES_WATCHDOG_TIMEOUT_SEC);
+    }
+}
+
 static void
 periodic_access_technologies_check_disable (MMIfaceModem *self)
 {
@@ -1074,6 +1200,7 @@ periodic_access_technologies_check_enable (MMIfaceModem *self)
     /* Create context and keep it as object data */
     mm_dbg ("Periodic access technology checks enabled");
     ctx = g_new0 (AccessTechnologiesCheckContext, 1);
+    ctx->interval = ACCESS_TECHNOLOGIES_CHECK_TIMEOUT_SEC;
     g_object_set_qdata_full (G_OBJECT (self),
                              access_technologies_check_context_quark,
                              ctx,
@@ -1142,6 +1269,7 @@ expire_signal_quality (MMIfaceModem *self)
                                                g_variant_new ("(ub)",
                                                               signal_quality,
                                                               FALSE));
+            mm_status_segment_update_modem (MM_BASE_MODEM (self));
         }
 
         g_object_unref (skeleton);
@@ -1197,6 +1325,7 @@ update_signal_quality (MMIfaceModem *self,
                                        g_variant_new ("(ub)",
                                                       signal_quality,
                                                       expire));
+    mm_status_segment_update_modem (MM_BASE_MODEM (self));
 
     dbus_path = g_dbus_object_get_object_path (G_DBUS_OBJECT (self));
     mm_dbg ("Modem %s: signal quality updated (%u)",
@@ -1211,7 +1340,7 @@ update_signal_quality (MMIfaceModem *self,
 
     /* If we got a new expirable value, setup new timeout */
     if (expire)
-        ctx->recent_timeout_source = (g_timeout_add_seconds (
+        ctx->recent_timeout_source = (mm_clock_timeout_add_seconds (
                                           SIGNAL_QUALITY_RECENT_TIMEOUT_SEC,
                                           (GSourceFunc)expire_signal_quality,
                                           self));
@@ -1219,11 +1348,14 @@ update_signal_quality (MMIfaceModem *self,
     g_object_unref (skeleton);
 }
 
+static void signal_quality_check_unsolicited_update (MMIfaceModem *self);
+
 void
 mm_iface_modem_update_signal_quality (MMIfaceModem *self,
                                       guint signal_quality)
 {
     update_signal_quality (self, signal_quality, TRUE);
+    signal_quality_check_unsolicited_update (self);
 }
 
 /*****************************************************************************/
@@ -1233,18 +1365,58 @@ typedef struct {
     guint initial_retries;
     guint timeout_source;
     gboolean running;
+    /* Last time the modem reported the signal quality by itself */
+    time_t last_unsolicited_update;
 } SignalQualityCheckContext;
 
 static void
 signal_quality_check_context_free (SignalQualityCheckContext *ctx)
 {
     if (ctx->timeout_source)
-        g_source_remove (ctx->timeout_source);
+        mm_poll_scheduler_remove (ctx->timeout_source);
     g_free (ctx);
 }
 
 static gboolean periodic_signal_quality_check (MMIfaceModem *self);
 
+static void
+signal_quality_check_reschedule (MMIfaceModem *self,
+                                 SignalQualityCheckContext *ctx,
+                                 guint interval)
+{
+    ctx->interval = interval;
+    if (!ctx->timeout_source)
+        return;
+
+    mm_dbg ("Periodic signal quality checks rescheduled (interval = %ds)", ctx->interval);
+    mm_poll_scheduler_remove (ctx->timeout_source);
+    ctx->timeout_source = mm_poll_scheduler_add_full ("signal-quality",
+                                                      MM_POLL_SCHEDULER_STAGE_SIGNAL,
+                                                      ctx->interval,
+                                                      MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->interval),
+                                                      (GSourceFunc)periodic_signal_quality_check,
+                                                      self);
+}
+
+static void
+signal_quality_check_unsolicited_update (MMIfaceModem *self)
+{
+    SignalQualityCheckContext *ctx;
+
+    ctx = g_object_get_qdata (G_OBJECT (self), signal_quality_check_context_quark);
+    if (!ctx)
+        return;
+
+    ctx->last_unsolicited_update = time (NULL);
+
+    /* The modem reports signal quality changes by itself, so polling is only
+     * needed as a watchdog in case the reports stop */
+    if (ctx->interval != SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC) {
+        mm_dbg ("Signal quality reported by the modem, backing off periodic checks");
+        signal_quality_check_reschedule (self, ctx, SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC);
+    }
+}
+
 static void
 signal_quality_check_ready (MMIfaceModem *self,
                             GAsyncResult *res)
@@ -1268,16 +1440,8 @@ signal_quality_check_ready (MMIfaceModem *self,
     ctx = g_object_get_qdata (G_OBJECT (self), signal_quality_check_context_quark);
     if (ctx) {
         if (ctx->interval == SIGNAL_QUALITY_INITIAL_CHECK_TIMEOUT_SEC &&
-            (signal_quality != 0 || --ctx->initial_retries == 0)) {
-            ctx->interval = SIGNAL_QUALITY_CHECK_TIMEOUT_SEC;
-            if (ctx->timeout_source) {
-                mm_dbg ("Periodic signal quality checks rescheduled (interval = %ds)", ctx->interval);
-                g_source_remove(ctx->timeout_source);
-                ctx->timeout_source = g_timeout_add_seconds (ctx->interval,
-                                                             (GSourceFunc)periodic_signal_quality_check,
-                                                             self);
-            }
-        }
+            (signal_quality != 0 || --ctx->initial_retries == 0))
+            signal_quality_check_reschedule (self, ctx, SIGNAL_QUALITY_CHECK_TIMEOUT_SEC);
         ctx->running = FALSE;
     }
 }
@@ -1289,15 +1453,32 @@ periodic_signal_quality_check (MMIfaceModem *self)
 
     ctx = g_object_get_qdata (G_OBJECT (self), signal_quality_check_context_quark);
 
+    if (ctx->interval == SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC) {
+        /* Nothing to do while the modem keeps reporting by itself */
+        if (time (NULL) - ctx->last_unsolicited_update < SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC)
+            return G_SOURCE_CONTINUE;
+
+        mm_dbg ("Signal quality not reported by the modem in %us, resuming periodic checks",
+                SIGNAL_QUALITY_WATCHDOG_TIMEOUT_SEC);
+        signal_quality_check_reschedule (self, ctx, SIGNAL_QUALITY_CHECK_TIMEOUT_SEC);
+    }
+
     /* Only launch a new one if not one running already OR if the last one run
      * was more than 15s ago. */
     if (!ctx->running ||
         (time (NULL) - get_last_signal_quality_update_time (self) > (ctx->interval / 2))) {
+        MMPortSerialCommandPriority previous;
+
         ctx->running = TRUE;
+        ctx->last_check = time (NULL);
+        /* Polling shouldn't delay user requests */
+        previous = mm_base_modem_set_command_priority (MM_BASE_MODEM (self),
+                                                       MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND);
         MM_IFACE_MODEM_GET_INTERFACE (self)->load_signal_quality (
             self,
             (GAsyncReadyCallback)signal_quality_check_ready,
             NULL);
+        mm_base_modem_set_command_priority (MM_BASE_MODEM (self), previous);
     }
 
     return G_SOURCE_CONTINUE;
@@ -1325,6 +1506,7 @@ static void
 periodic_signal_quality_check_enable (MMIfaceModem *self)
 {
     SignalQualityCheckContext *ctx;
+    gboolean periodic_signal_check_disabled = FALSE;
 
     if (!MM_IFACE_MODEM_GET_INTERFACE (self)->load_signal_quality ||
         !MM_IFACE_MODEM_GET_INTERFACE (self)->load_signal_quality_finish) {
@@ -1333,6 +1515,20 @@ periodic_signal_quality_check_enable (MMIfaceModem *self)
         return;
     }
 
+    g_object_get (self,
+                  MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED, &periodic_signal_check_disabled,
+                  NULL);
+    if (periodic_signal_check_disabled) {
+        /* Signal quality updates are reported by the modem itself, so just
+         * load the initial value */
+        mm_dbg ("Periodic signal quality checks not required");
+        MM_IFACE_MODEM_GET_INTERFACE (self)->load_signal_quality (
+            self,
+            (GAsyncReadyCallback)signal_quality_check_ready,
+            NULL);
+        return;
+    }
+
     if (G_UNLIKELY (!signal_quality_check_context_quark))
         signal_quality_check_context_quark = (g_quark_from_static_string (
                                                   SIGNAL_QUALITY_CHECK_CONTEXT_TAG));
@@ -1353,9 +1549,12 @@ periodic_signal_quality_check_enable (MMIfaceModem *self)
     ctx->interval = SIGNAL_QUALITY_INITIAL_CHECK_TIMEOUT_SEC;
     ctx->initial_retries = 5;
     mm_dbg ("Periodic signal quality checks enabled (interval = %ds)", ctx->interval);
-    ctx->timeout_source = g_timeout_add_seconds (ctx->interval,
-                                                 (GSourceFunc)periodic_signal_quality_check,
-                                                 self);
+    ctx->timeout_source = mm_poll_scheduler_add_full ("signal-quality",
+                                                      MM_POLL_SCHEDULER_STAGE_SIGNAL,
+                                                      ctx->interval,
+                                                      MM_POLL_SCHEDULER_DEFAULT_SLACK (ctx->interval),
+                                                      (GSourceFunc)periodic_signal_quality_check,
+                                                      self);
     g_object_set_qdata_full (G_OBJECT (self),
                              signal_quality_check_context_quark,
                              ctx,
@@ -1435,6 +1634,7 @@ __iface_modem_update_state_internal (MMIfaceModem *self,
         g_object_set (self,
                       MM_IFACE_MODEM_STATE, new_state,
                       NULL);
+        mm_status_segment_update_modem (MM_BASE_MODEM (self));
 
         /* Signal status change */
         if (skeleton) {
@@ -1660,13 +1860,17 @@ enable_ready (MMBaseModem *self,
     if (ctx->enable) {
         if (!mm_base_modem_enable_finish (self, res, &error))
             g_dbus_method_invocation_take_error (ctx->invocation, error);
-        else
+        else {
+            mm_dbus_flush_properties (ctx->skeleton);
             mm_gdbus_modem_complete_enable (ctx->skeleton, ctx->invocation);
+        }
     } else {
         if (!mm_base_modem_disable_finish (self, res, &error))
             g_dbus_method_invocation_take_error (ctx->invocation, error);
-        else
+        else {
+            mm_dbus_flush_properties (ctx->skeleton);
             mm_gdbus_modem_complete_enable (ctx->skeleton, ctx->invocation);
+        }
     }
 
     handle_enable_context_free (ctx);
@@ -1744,8 +1948,10 @@ set_power_state_ready (MMIfaceModem *self,
 
     if (!mm_iface_modem_set_power_state_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_set_power_state (ctx->skeleton, ctx->invocation);
+    }
     handle_set_power_state_context_free (ctx);
 }
 
@@ -1858,10 +2064,18 @@ handle_reset_ready (MMIfaceModem *self,
 {
     GError *error = NULL;
 
+    /* Images and current firmware may be different after a reset */
+    if (MM_IS_IFACE_MODEM_FIRMWARE (self))
+        mm_iface_modem_firmware_invalidate_list (MM_IFACE_MODEM_FIRMWARE (self));
+    /* And so may the identification and SIM replies already cached */
+    mm_base_modem_clear_shared_reply_cache (MM_BASE_MODEM (self));
+
     if (!MM_IFACE_MODEM_GET_INTERFACE (self)->reset_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_reset (ctx->skeleton, ctx->invocation);
+    }
 
     handle_reset_context_free (ctx);
 }
@@ -1942,10 +2156,18 @@ handle_factory_reset_ready (MMIfaceModem *self,
 {
     GError *error = NULL;
 
+    /* Images and current firmware may be different after a reset */
+    if (MM_IS_IFACE_MODEM_FIRMWARE (self))
+        mm_iface_modem_firmware_invalidate_list (MM_IFACE_MODEM_FIRMWARE (self));
+    /* And so may the identification and SIM replies already cached */
+    mm_base_modem_clear_shared_reply_cache (MM_BASE_MODEM (self));
+
     if (!MM_IFACE_MODEM_GET_INTERFACE (self)->factory_reset_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_factory_reset (ctx->skeleton, ctx->invocation);
+    }
 
     handle_factory_reset_context_free (ctx);
 }
@@ -2032,8 +2254,10 @@ set_current_capabilities_ready (MMIfaceModem *self,
 
     if (!MM_IFACE_MODEM_GET_INTERFACE (self)->set_current_capabilities_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_set_current_capabilities (ctx->skeleton, ctx->invocation);
+    }
     handle_set_current_capabilities_context_free (ctx);
 }
 
@@ -2091,6 +2315,7 @@ handle_set_current_capabilities_auth_ready (MMBaseModem *self,
     /* Check if we already are in the requested setup */
     if (mm_gdbus_modem_get_current_capabilities (ctx->skeleton) == ctx->capabilities) {
         /* Nothing to do */
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_set_current_capabilities (ctx->skeleton, ctx->invocation);
         handle_set_current_capabilities_context_free (ctx);
         return;
@@ -2407,8 +2632,10 @@ handle_set_current_bands_ready (MMIfaceModem *self,
 
     if (!mm_iface_modem_set_current_bands_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_set_current_bands (ctx->skeleton, ctx->invocation);
+    }
 
     handle_set_current_bands_context_free (ctx);
 }
@@ -2722,8 +2949,10 @@ handle_set_current_modes_ready (MMIfaceModem *self,
 
     if (!mm_iface_modem_set_current_modes_finish (self, res, &error))
         g_dbus_method_invocation_take_error (ctx->invocation, error);
-    else
+    else {
+        mm_dbus_flush_properties (ctx->skeleton);
         mm_gdbus_modem_complete_set_current_modes (ctx->skeleton, ctx->invocation);
+    }
 
     handle_set_current_modes_context_free (ctx);
 }
@@ -3159,6 +3388,33 @@ mm_iface_modem_update_lock_info (MMIfaceModem *self,
     update_lock_info_context_step (ctx);
 }
 
+/*****************************************************************************/
+/* Unlock retries invalidation */
+
+static GQuark
+get_unlock_retries_serial_quark (void)
+{
+    if (G_UNLIKELY (!unlock_retries_serial_quark))
+        unlock_retries_serial_quark = (g_quark_from_static_string (
+                                           UNLOCK_RETRIES_SERIAL_TAG));
+    return unlock_retries_serial_quark;
+}
+
+void
+mm_iface_modem_invalidate_unlock_retries (MMIfaceModem *self)
+{
+    guint serial;
+
+    serial = GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (self), get_unlock_retries_serial_quark ()));
+    g_object_set_qdata (G_OBJECT (self), get_unlock_retries_serial_quark (), GUINT_TO_POINTER (serial + 1));
+}
+
+guint
+mm_iface_modem_get_unlock_retries_serial (MMIfaceModem *self)
+{
+    return GPOINTER_TO_UINT (g_object_get_qdata (G_OBJECT (self), get_unlock_retries_serial_quark ()));
+}
+
 /*****************************************************************************/
 /* Set power state sequence */
 
@@ -3736,13 +3992,18 @@ static void interface_initialization_step (InitializationContext *ctx);
 typedef enum {
     INITIALIZATION_STEP_FIRST,
     INITIALIZATION_STEP_CURRENT_CAPABILITIES,
+    INITIALIZATION_STEP_CACHE_REVISION,
+    INITIALIZATION_STEP_CACHE_EQUIPMENT_ID,
+    INITIALIZATION_STEP_CACHE_APPLY,
     INITIALIZATION_STEP_SUPPORTED_CAPABILITIES,
     INITIALIZATION_STEP_BEARERS,
+    INITIALIZATION_STEP_CONCURRENT_DEVICE_INFO,
     INITIALIZATION_STEP_MANUFACTURER,
     INITIALIZATION_STEP_MODEL,
     INITIALIZATION_STEP_REVISION,
     INITIALIZATION_STEP_EQUIPMENT_ID,
     INITIALIZATION_STEP_DEVICE_ID,
+    INITIALIZATION_STEP_CONCURRENT_SUPPORTED,
     INITIALIZATION_STEP_SUPPORTED_MODES,
     INITIALIZATION_STEP_SUPPORTED_BANDS,
     INITIALIZATION_STEP_SUPPORTED_IP_FAMILIES,
@@ -3763,6 +4024,10 @@ struct _InitializationContext {
     GCancellable *cancellable;
     MmGdbusModem *skeleton;
     GError *fatal_error;
+    /* Whether independent loaders may run at the same time; and how many of
+     * them are still running when they do */
+    gboolean concurrent;
+    guint loaders_pending;
 };
 
 static void
@@ -3797,6 +4062,19 @@ initialization_context_complete_and_free_if_cancelled (InitializationContext *ct
     return TRUE;
 }
 
+static void
+initialization_step_done (InitializationContext *ctx)
+{
+    /* When loading concurrently, the step is already the last one of the
+     * group, so only the last loader to finish goes on */
+    if (ctx->loaders_pending > 0 && --ctx->loaders_pending > 0)
+        return;
+
+    /* Go on to next step */
+    ctx->step++;
+    interface_initialization_step (ctx);
+}
+
 #undef STR_REPLY_READY_FN
 #define STR_REPLY_READY_FN(NAME,DISPLAY)                                \
     static void                                                         \
@@ -3816,9 +4094,26 @@ initialization_context_complete_and_free_if_cancelled (InitializationContext *ct
             g_error_free (error);                                       \
         }                                                               \
                                                                         \
-        /* Go on to next step */                                        \
-        ctx->step++;                                                    \
-        interface_initialization_step (ctx);                            \
+        initialization_step_done (ctx);                                 \
+    }
+
+/* Launches the loader if the property isn't loaded yet; these are meant to
+ * be loaded only once during the whole lifetime of the modem. */
+#undef STR_LOAD_IF_NEEDED_FN
+#define STR_LOAD_IF_NEEDED_FN(NAME)                                     \
+    static gboolean                                                     \
+    load_##NAME##_if_needed (InitializationContext *ctx)                \
+    {                                                                   \
+        if (mm_gdbus_modem_get_##NAME (ctx->skeleton) != NULL ||        \
+            !MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_##NAME ||   \
+            !MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_##NAME##_finish) \
+            return FALSE;                                               \
+                                                                        \
+        MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_##NAME (         \
+            ctx->self,                                                  \
+            (GAsyncReadyCallback)load_##NAME##_ready,                   \
+            ctx);                                                       \
+        return TRUE;                                                    \
     }
 
 #undef UINT_REPLY_READY_FN
@@ -3956,6 +4251,12 @@ STR_REPLY_READY_FN (revision, "Revision")
 STR_REPLY_READY_FN (equipment_identifier, "Equipment Identifier")
 STR_REPLY_READY_FN (device_identifier, "Device Identifier")
 
+STR_LOAD_IF_NEEDED_FN (manufacturer)
+STR_LOAD_IF_NEEDED_FN (model)
+STR_LOAD_IF_NEEDED_FN (revision)
+STR_LOAD_IF_NEEDED_FN (equipment_identifier)
+STR_LOAD_IF_NEEDED_FN (device_identifier)
+
 static void
 load_supported_modes_ready (MMIfaceModem *self,
                             GAsyncResult *res,
@@ -3976,9 +4277,7 @@ load_supported_modes_ready (MMIfaceModem *self,
         g_error_free (error);
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    interface_initialization_step (ctx);
+    initialization_step_done (ctx);
 }
 
 static void
@@ -4002,9 +4301,7 @@ load_supported_bands_ready (MMIfaceModem *self,
         g_error_free (error);
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    interface_initialization_step (ctx);
+    initialization_step_done (ctx);
 }
 
 static void
@@ -4025,9 +4322,92 @@ load_supported_ip_families_ready (MMIfaceModem *self,
         g_error_free (error);
     }
 
-    /* Go on to next step */
-    ctx->step++;
-    interface_initialization_step (ctx);
+    initialization_step_done (ctx);
+}
+
+static gboolean
+load_supported_modes_if_needed (InitializationContext *ctx)
+{
+    GArray *supported_modes;
+    MMModemModeCombination *mode = NULL;
+    gboolean load;
+
+    if (!MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes ||
+        !MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes_finish)
+        return FALSE;
+
+    supported_modes = (mm_common_mode_combinations_variant_to_garray (
+                           mm_gdbus_modem_get_supported_modes (ctx->skeleton)));
+
+    /* Supported modes are meant to be loaded only once during the whole
+     * lifetime of the modem. Therefore, if we already have them loaded,
+     * don't try to load them again. */
+    if (supported_modes->len == 1)
+        mode = &g_array_index (supported_modes, MMModemModeCombination, 0);
+    load = (supported_modes->len == 0 ||
+            (mode && mode->allowed == MM_MODEM_MODE_ANY && mode->preferred == MM_MODEM_MODE_NONE));
+    g_array_unref (supported_modes);
+
+    if (!load)
+        return FALSE;
+
+    MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes (
+        ctx->self,
+        (GAsyncReadyCallback)load_supported_modes_ready,
+        ctx);
+    return TRUE;
+}
+
+static gboolean
+load_supported_bands_if_needed (InitializationContext *ctx)
+{
+    GArray *supported_bands;
+    gboolean load;
+
+    supported_bands = (mm_common_bands_variant_to_garray (
+                           mm_gdbus_modem_get_supported_bands (ctx->skeleton)));
+
+    /* Supported bands are meant to be loaded only once during the whole
+     * lifetime of the modem. Therefore, if we already have them loaded,
+     * don't try to load them again. */
+    load = (supported_bands->len == 0 ||
+            g_array_index (supported_bands, MMModemBand, 0)  == MM_MODEM_BAND_UNKNOWN);
+    g_array_unref (supported_bands);
+
+    if (!load)
+        return FALSE;
+
+    if (MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands &&
+        MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands_finish) {
+        MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands (
+            ctx->self,
+            (GAsyncReadyCallback)load_supported_bands_ready,
+            ctx);
+        return TRUE;
+    }
+
+    /* Loading supported bands not implemented, default to UNKNOWN */
+    mm_gdbus_modem_set_supported_bands (ctx->skeleton, mm_common_build_bands_unknown ());
+    mm_gdbus_modem_set_current_bands (ctx->skeleton, mm_common_build_bands_unknown ());
+    return FALSE;
+}
+
+static gboolean
+load_supported_ip_families_if_needed (InitializationContext *ctx)
+{
+    /* Supported ip_families are meant to be loaded only once during the whole
+     * lifetime of the modem. Therefore, if we already have them loaded,
+     * don't try to load them again. */
+    if (!MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families ||
+        !MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families_finish ||
+        mm_gdbus_modem_get_supported_ip_families (ctx->skeleton) != MM_BEARER_IP_FAMILY_NONE)
+        return FALSE;
+
+    MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families (
+        ctx->self,
+        (GAsyncReadyCallback)load_supported_ip_families_ready,
+        ctx);
+    return TRUE;
 }
 
 UINT_REPLY_READY_FN (power_state, "Power State")
@@ -4232,6 +4612,11 @@ interface_initialization_step (InitializationContext *ctx)
     if (initialization_context_complete_and_free_if_cancelled (ctx))
         return;
 
+    mm_profiler_step (mm_base_modem_get_device (MM_BASE_MODEM (ctx->self)),
+                      "Modem interface initialization",
+                      ctx->step,
+                      INITIALIZATION_STEP_LAST);
+
     switch (ctx->step) {
     case INITIALIZATION_STEP_FIRST:
         /* Load device if not done before */
@@ -4310,6 +4695,28 @@ interface_initialization_step (InitializationContext *ctx)
         /* Fall down to next step */
         ctx->step++;
 
+    case INITIALIZATION_STEP_CACHE_REVISION:
+        /* When caching modem info, the revision and the equipment identifier
+         * are loaded first, as they're the key of the cache entries */
+        if (mm_modem_info_cache_is_enabled () && load_revision_if_needed (ctx))
+            return;
+        /* Fall down to next step */
+        ctx->step++;
+
+    case INITIALIZATION_STEP_CACHE_EQUIPMENT_ID:
+        if (mm_modem_info_cache_is_enabled () && load_equipment_identifier_if_needed (ctx))
+            return;
+        /* Fall down to next step */
+        ctx->step++;
+
+    case INITIALIZATION_STEP_CACHE_APPLY:
+        /* Presets whatever makes the loaders below skip or not need the
+         * device */
+        if (mm_modem_info_cache_is_enabled ())
+            mm_modem_info_cache_apply (MM_BASE_MODEM (ctx->self), ctx->skeleton);
+        /* Fall down to next step */
+        ctx->step++;
+
     case INITIALIZATION_STEP_SUPPORTED_CAPABILITIES: {
         GArray *supported_capabilities;
 
@@ -4391,159 +4798,85 @@ interface_initialization_step (InitializationContext *ctx)
         ctx->step++;
     }
 
-    case INITIALIZATION_STEP_MANUFACTURER:
-        /* Manufacturer is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_modem_get_manufacturer (ctx->skeleton) == NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_manufacturer &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_manufacturer_finish) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_manufacturer (
-                ctx->self,
-                (GAsyncReadyCallback)load_manufacturer_ready,
-                ctx);
+    case INITIALIZATION_STEP_CONCURRENT_DEVICE_INFO:
+        /* Manufacturer, model, revision and equipment ID don't depend on each
+         * other, so they may be loaded all at once */
+        if (ctx->concurrent) {
+            /* Hold one extra reference so that loaders finishing right away
+             * don't go on before all the others are launched */
+            ctx->step = INITIALIZATION_STEP_EQUIPMENT_ID;
+            ctx->loaders_pending = 1;
+            ctx->loaders_pending += load_manufacturer_if_needed (ctx);
+            ctx->loaders_pending += load_model_if_needed (ctx);
+            ctx->loaders_pending += load_revision_if_needed (ctx);
+            ctx->loaders_pending += load_equipment_identifier_if_needed (ctx);
+            initialization_step_done (ctx);
             return;
         }
         /* Fall down to next step */
         ctx->step++;
 
+    case INITIALIZATION_STEP_MANUFACTURER:
+        if (load_manufacturer_if_needed (ctx))
+            return;
+        /* Fall down to next step */
+        ctx->step++;
+
     case INITIALIZATION_STEP_MODEL:
-        /* Model is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_modem_get_model (ctx->skeleton) == NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_model &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_model_finish) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_model (
-                ctx->self,
-                (GAsyncReadyCallback)load_model_ready,
-                ctx);
+        if (load_model_if_needed (ctx))
             return;
-        }
         /* Fall down to next step */
         ctx->step++;
 
     case INITIALIZATION_STEP_REVISION:
-        /* Revision is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_modem_get_revision (ctx->skeleton) == NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_revision &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_revision_finish) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_revision (
-                ctx->self,
-                (GAsyncReadyCallback)load_revision_ready,
-                ctx);
+        if (load_revision_if_needed (ctx))
             return;
-        }
         /* Fall down to next step */
         ctx->step++;
 
     case INITIALIZATION_STEP_EQUIPMENT_ID:
-        /* Equipment ID is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_modem_get_equipment_identifier (ctx->skeleton) == NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_equipment_identifier &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_equipment_identifier_finish) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_equipment_identifier (
-                ctx->self,
-                (GAsyncReadyCallback)load_equipment_identifier_ready,
-                ctx);
+        if (load_equipment_identifier_if_needed (ctx))
             return;
-        }
         /* Fall down to next step */
         ctx->step++;
 
     case INITIALIZATION_STEP_DEVICE_ID:
-        /* Device ID is meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (mm_gdbus_modem_get_device_identifier (ctx->skeleton) == NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_device_identifier &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_device_identifier_finish) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_device_identifier (
-                ctx->self,
-                (GAsyncReadyCallback)load_device_identifier_ready,
-                ctx);
+        /* The device ID is built from all the previous ones */
+        if (load_device_identifier_if_needed (ctx))
             return;
-        }
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZATION_STEP_SUPPORTED_MODES:
-        if (MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes != NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes_finish != NULL) {
-            GArray *supported_modes;
-            MMModemModeCombination *mode = NULL;
-
-            supported_modes = (mm_common_mode_combinations_variant_to_garray (
-                                   mm_gdbus_modem_get_supported_modes (ctx->skeleton)));
-
-            /* Supported modes are meant to be loaded only once during the whole
-             * lifetime of the modem. Therefore, if we already have them loaded,
-             * don't try to load them again. */
-            if (supported_modes->len == 1)
-                mode = &g_array_index (supported_modes, MMModemModeCombination, 0);
-            if (supported_modes->len == 0 ||
-                (mode && mode->allowed == MM_MODEM_MODE_ANY && mode->preferred == MM_MODEM_MODE_NONE)) {
-                MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_modes (
-                    ctx->self,
-                    (GAsyncReadyCallback)load_supported_modes_ready,
-                    ctx);
-                g_array_unref (supported_modes);
-                return;
-            }
-
-            g_array_unref (supported_modes);
+    case INITIALIZATION_STEP_CONCURRENT_SUPPORTED:
+        /* Supported modes, bands and IP families only depend on the current
+         * capabilities, already loaded */
+        if (ctx->concurrent) {
+            ctx->step = INITIALIZATION_STEP_SUPPORTED_IP_FAMILIES;
+            ctx->loaders_pending = 1;
+            ctx->loaders_pending += load_supported_modes_if_needed (ctx);
+            ctx->loaders_pending += load_supported_bands_if_needed (ctx);
+            ctx->loaders_pending += load_supported_ip_families_if_needed (ctx);
+            initialization_step_done (ctx);
+            return;
         }
         /* Fall down to next step */
         ctx->step++;
 
-    case INITIALIZATION_STEP_SUPPORTED_BANDS: {
-        GArray *supported_bands;
-
-        supported_bands = (mm_common_bands_variant_to_garray (
-                               mm_gdbus_modem_get_supported_bands (ctx->skeleton)));
-
-        /* Supported bands are meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (supported_bands->len == 0 ||
-            g_array_index (supported_bands, MMModemBand, 0)  == MM_MODEM_BAND_UNKNOWN) {
-            if (MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands &&
-                MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands_finish) {
-                MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_bands (
-                    ctx->self,
-                    (GAsyncReadyCallback)load_supported_bands_ready,
-                    ctx);
-                g_array_unref (supported_bands);
-                return;
-            }
-
-            /* Loading supported bands not implemented, default to UNKNOWN */
-            mm_gdbus_modem_set_supported_bands (ctx->skeleton, mm_common_build_bands_unknown ());
-            mm_gdbus_modem_set_current_bands (ctx->skeleton, mm_common_build_bands_unknown ());
-        }
-        g_array_unref (supported_bands);
+    case INITIALIZATION_STEP_SUPPORTED_MODES:
+        if (load_supported_modes_if_needed (ctx))
+            return;
+        /* Fall down to next step */
+        ctx->step++;
 
+    case INITIALIZATION_STEP_SUPPORTED_BANDS:
+        if (load_supported_bands_if_needed (ctx))
+            return;
         /* Fall down to next step */
         ctx->step++;
-    }
 
     case INITIALIZATION_STEP_SUPPORTED_IP_FAMILIES:
-        /* Supported ip_families are meant to be loaded only once during the whole
-         * lifetime of the modem. Therefore, if we already have them loaded,
-         * don't try to load them again. */
-        if (MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families != NULL &&
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families_finish != NULL &&
-            mm_gdbus_modem_get_supported_ip_families (ctx->skeleton) == MM_BEARER_IP_FAMILY_NONE) {
-            MM_IFACE_MODEM_GET_INTERFACE (ctx->self)->load_supported_ip_families (
-                ctx->self,
-                (GAsyncReadyCallback)load_supported_ip_families_ready,
-                ctx);
+        if (load_supported_ip_families_if_needed (ctx))
             return;
-        }
         /* Fall down to next step */
         ctx->step++;
 
@@ -4786,6 +5119,7 @@ interface_initialization_step (InitializationContext *ctx)
                               "handle-set-current-modes",
                               G_CALLBACK (handle_set_current_modes),
                               ctx->self);
+            mm_modem_info_cache_store (MM_BASE_MODEM (ctx->self), ctx->skeleton);
             g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         }
 
@@ -4873,6 +5207,18 @@ mm_iface_modem_initialize (MMIfaceModem *self,
     ctx->step = INITIALIZATION_STEP_FIRST;
     ctx->skeleton = skeleton;
 
+    /* Loaders are run concurrently only in modems controlled through
+     * message-based ports, which handle several requests at the same time;
+     * AT-based modems keep the serial order */
+#if defined WITH_QMI
+    if (mm_base_modem_peek_port_qmi (MM_BASE_MODEM (self)))
+        ctx->concurrent = TRUE;
+#endif
+#if defined WITH_MBIM
+    if (mm_base_modem_peek_port_mbim (MM_BASE_MODEM (self)))
+        ctx->concurrent = TRUE;
+#endif
+
     interface_initialization_step (ctx);
 }
 
@@ -5173,6 +5519,14 @@ iface_modem_init (gpointer g_iface)
                                FALSE,
                                G_PARAM_READWRITE));
 
+    g_object_interface_install_property
+        (g_iface,
+         g_param_spec_boolean (MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED,
+                               "Periodic signal check disabled",
+                               "Whether periodic signal check is disabled.",
+                               FALSE,
+                               G_PARAM_READWRITE));
+
     initialized = TRUE;
 }
 
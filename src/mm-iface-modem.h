@@ -37,6 +37,7 @@
 #define MM_IFACE_MODEM_SIM                     "iface-modem-sim"
 #define MM_IFACE_MODEM_BEARER_LIST             "iface-modem-bearer-list"
 #define MM_IFACE_MODEM_SIM_HOT_SWAP_SUPPORTED  "iface-modem-sim-hot-swap-supported"
+#define MM_IFACE_MODEM_PERIODIC_SIGNAL_CHECK_DISABLED "iface-modem-periodic-signal-check-disabled"
 
 typedef struct _MMIfaceModem MMIfaceModem;
 
@@ -413,6 +414,12 @@ MMModemLock mm_iface_modem_update_lock_info_finish (MMIfaceModem *self,
                                                     GAsyncResult *res,
                                                     GError **error);
 
+/* Unlock retries only change with PIN operations, so implementations may
+ * keep the ones they loaded as long as this serial doesn't change; the SIM
+ * bumps it after every PIN operation. */
+void  mm_iface_modem_invalidate_unlock_retries (MMIfaceModem *self);
+guint mm_iface_modem_get_unlock_retries_serial (MMIfaceModem *self);
+
 /* Request signal quality check update.
  * It will not only return the signal quality status, but also set the property
  * values in the DBus interface. */
@@ -444,9 +451,21 @@ void mm_iface_modem_update_access_technologies (MMIfaceModem *self,
                                                 MMModemAccessTechnology access_tech,
                                                 guint32 mask);
 
+/* Allow reporting new access tech as notified by the modem itself; once
+ * reported this way, periodic checks only run as a watchdog */
+void mm_iface_modem_update_access_technologies_unsolicited (MMIfaceModem *self,
+                                                            MMModemAccessTechnology access_tech,
+                                                            guint32 mask);
+
 /* Allow requesting to refresh access tech */
 void mm_iface_modem_refresh_access_technologies (MMIfaceModem *self);
 
+/* Allow running the periodic access tech checks as part of another periodic
+ * job (i.e. the 3GPP registration checks) instead of in a job of their own */
+void mm_iface_modem_coalesce_access_technologies_check      (MMIfaceModem *self,
+                                                             gboolean coalesce);
+void mm_iface_modem_run_coalesced_access_technologies_check (MMIfaceModem *self);
+
 /* Allow updating signal quality */
 void mm_iface_modem_update_signal_quality (MMIfaceModem *self,
                                            guint signal_quality);
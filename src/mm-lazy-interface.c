@@ -0,0 +1,195 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-lazy-interface.h"
+#include "mm-log.h"
+
+#define LAZY_INTERFACE_TAG "lazy-interface-tag"
+static GQuark lazy_interface_quark;
+
+typedef struct {
+    /* Weak reference, the owner keeps the skeleton */
+    GObject *owner;
+    MMLazyInterfaceInitializeFn initialize;
+    MMLazyInterfaceInitializeFinishFn initialize_finish;
+    gulong authorize_id;
+    gboolean initialized;
+    gboolean running;
+    /* Method calls held until initialized */
+    GQueue *invocations;
+} LazyInterface;
+
+static void
+lazy_interface_free (LazyInterface *lazy)
+{
+    /* Nothing can be held without a running initialization, which keeps a
+     * reference to the skeleton */
+    g_assert (g_queue_is_empty (lazy->invocations));
+    g_queue_free (lazy->invocations);
+    if (lazy->owner)
+        g_object_remove_weak_pointer (lazy->owner, (gpointer *) &lazy->owner);
+    g_slice_free (LazyInterface, lazy);
+}
+
+static LazyInterface *
+peek_lazy_interface (GDBusInterfaceSkeleton *skeleton)
+{
+    if (G_UNLIKELY (!lazy_interface_quark))
+        return NULL;
+    return g_object_get_qdata (G_OBJECT (skeleton), lazy_interface_quark);
+}
+
+/*****************************************************************************/
+
+static void
+dispatch_invocation (GDBusInterfaceSkeleton *skeleton,
+                     GDBusMethodInvocation  *invocation)
+{
+    GDBusInterfaceVTable *vtable;
+
+    /* Run the method call through the generated skeleton vtable again, which
+     * emits the handle-* signal; authorization was already done. The
+     * reference to the invocation is transferred. */
+    vtable = g_dbus_interface_skeleton_get_vtable (skeleton);
+    vtable->method_call (g_dbus_method_invocation_get_connection (invocation),
+                         g_dbus_method_invocation_get_sender (invocation),
+                         g_dbus_method_invocation_get_object_path (invocation),
+                         g_dbus_method_invocation_get_interface_name (invocation),
+                         g_dbus_method_invocation_get_method_name (invocation),
+                         g_dbus_method_invocation_get_parameters (invocation),
+                         invocation,
+                         skeleton);
+}
+
+static void
+initialize_ready (GObject                *owner,
+                  GAsyncResult           *res,
+                  GDBusInterfaceSkeleton *skeleton)
+{
+    LazyInterface *lazy;
+    GDBusMethodInvocation *invocation;
+    GError *error = NULL;
+
+    lazy = peek_lazy_interface (skeleton);
+    g_assert (lazy && lazy->running);
+    lazy->running = FALSE;
+
+    if (!lazy->initialize_finish (owner, res, &error)) {
+        mm_dbg ("Couldn't initialize '%s' interface on demand: '%s'",
+                g_dbus_interface_skeleton_get_info (skeleton)->name,
+                error->message);
+        while ((invocation = g_queue_pop_head (lazy->invocations)) != NULL)
+            g_dbus_method_invocation_return_gerror (invocation, error);
+        g_error_free (error);
+        g_object_unref (skeleton);
+        return;
+    }
+
+    mm_dbg ("Initialized '%s' interface on demand",
+            g_dbus_interface_skeleton_get_info (skeleton)->name);
+    lazy->initialized = TRUE;
+    g_signal_handler_disconnect (skeleton, lazy->authorize_id);
+    lazy->authorize_id = 0;
+
+    while ((invocation = g_queue_pop_head (lazy->invocations)) != NULL)
+        dispatch_invocation (skeleton, invocation);
+
+    g_object_unref (skeleton);
+}
+
+static void
+launch_initialization (GDBusInterfaceSkeleton *skeleton,
+                       LazyInterface          *lazy)
+{
+    if (lazy->initialized || lazy->running)
+        return;
+
+    if (!lazy->owner) {
+        GDBusMethodInvocation *invocation;
+
+        while ((invocation = g_queue_pop_head (lazy->invocations)) != NULL)
+            g_dbus_method_invocation_return_error (invocation,
+                                                   MM_CORE_ERROR,
+                                                   MM_CORE_ERROR_ABORTED,
+                                                   "Modem is gone");
+        return;
+    }
+
+    mm_dbg ("Initializing '%s' interface on demand...",
+            g_dbus_interface_skeleton_get_info (skeleton)->name);
+    lazy->running = TRUE;
+    lazy->initialize (lazy->owner,
+                      skeleton,
+                      (GAsyncReadyCallback) initialize_ready,
+                      g_object_ref (skeleton));
+}
+
+static gboolean
+authorize_method_cb (GDBusInterfaceSkeleton *skeleton,
+                     GDBusMethodInvocation  *invocation,
+                     LazyInterface          *lazy)
+{
+    if (lazy->initialized)
+        return TRUE;
+
+    /* Hold the call, we'll dispatch it ourselves once initialized */
+    g_queue_push_tail (lazy->invocations, g_object_ref (invocation));
+    launch_initialization (skeleton, lazy);
+    return FALSE;
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_lazy_interface_is_pending (GDBusInterfaceSkeleton *skeleton)
+{
+    LazyInterface *lazy;
+
+    lazy = peek_lazy_interface (skeleton);
+    return (lazy && !lazy->initialized);
+}
+
+void
+mm_lazy_interface_setup (GDBusInterfaceSkeleton            *skeleton,
+                         GObject                           *owner,
+                         MMLazyInterfaceInitializeFn        initialize,
+                         MMLazyInterfaceInitializeFinishFn  initialize_finish)
+{
+    LazyInterface *lazy;
+
+    if (G_UNLIKELY (!lazy_interface_quark))
+        lazy_interface_quark = g_quark_from_static_string (LAZY_INTERFACE_TAG);
+
+    if (peek_lazy_interface (skeleton))
+        return;
+
+    lazy = g_slice_new0 (LazyInterface);
+    lazy->owner = owner;
+    g_object_add_weak_pointer (owner, (gpointer *) &lazy->owner);
+    lazy->initialize = initialize;
+    lazy->initialize_finish = initialize_finish;
+    lazy->invocations = g_queue_new ();
+    lazy->authorize_id = g_signal_connect (skeleton,
+                                           "g-authorize-method",
+                                           G_CALLBACK (authorize_method_cb),
+                                           lazy);
+    g_object_set_qdata_full (G_OBJECT (skeleton),
+                             lazy_interface_quark,
+                             lazy,
+                             (GDestroyNotify) lazy_interface_free);
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_LAZY_INTERFACE_H
+#define MM_LAZY_INTERFACE_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+/*
+ * Interfaces initialized on demand, with --lazy-interfaces.
+ *
+ * The interface skeleton is exported with its default property values, and
+ * its initialization is only run on the first method call. Method calls
+ * received in the meantime are held, and dispatched to the handlers of the
+ * skeleton once initialized, or replied to with the initialization error
+ * otherwise.
+ */
+
+typedef void     (* MMLazyInterfaceInitializeFn)       (GObject                 *owner,
+                                                        GDBusInterfaceSkeleton  *skeleton,
+                                                        GAsyncReadyCallback      callback,
+                                                        gpointer                 user_data);
+typedef gboolean (* MMLazyInterfaceInitializeFinishFn) (GObject                 *owner,
+                                                        GAsyncResult            *res,
+                                                        GError                 **error);
+
+/* Does nothing if already set up in the skeleton */
+void     mm_lazy_interface_setup      (GDBusInterfaceSkeleton            *skeleton,
+                                       GObject                           *owner,
+                                       MMLazyInterfaceInitializeFn        initialize,
+                                       MMLazyInterfaceInitializeFinishFn  initialize_finish);
+
+/* TRUE if set up and not yet successfully initialized */
+gboolean mm_lazy_interface_is_pending (GDBusInterfaceSkeleton *skeleton);
+
+#endif /* MM_LAZY_INTERFACE_H */
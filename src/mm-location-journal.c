@@ -0,0 +1,250 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <ModemManager.h>
+
+#include "mm-location-journal.h"
+#include "mm-log.h"
+
+#define JOURNAL_MAGIC   "MMLJ"
+#define JOURNAL_VERSION 1
+
+#define RECORD_FLAG_GPS  (1 << 0)
+#define RECORD_FLAG_3GPP (1 << 1)
+
+typedef struct {
+    gchar   magic[4];
+    guint32 version;
+    guint32 record_size;
+    guint32 capacity;
+    /* Number of records ever written; the next one goes in head % capacity */
+    guint64 head;
+} JournalHeader;
+
+typedef struct {
+    /* Seconds since the epoch */
+    gint64  timestamp;
+    gdouble latitude;
+    gdouble longitude;
+    gdouble altitude;
+    guint32 location_area_code;
+    guint32 cell_id;
+    guint16 mobile_country_code;
+    guint16 mobile_network_code;
+    guint32 flags;
+} JournalRecord;
+
+struct _MMLocationJournal {
+    gint           fd;
+    gsize          size;
+    JournalHeader *header;
+    JournalRecord *records;
+};
+
+/*****************************************************************************/
+
+static gboolean
+header_valid (const JournalHeader *header,
+              guint                capacity)
+{
+    return (!memcmp (header->magic, JOURNAL_MAGIC, sizeof (header->magic)) &&
+            header->version == JOURNAL_VERSION &&
+            header->record_size == sizeof (JournalRecord) &&
+            header->capacity == capacity);
+}
+
+MMLocationJournal *
+mm_location_journal_open (const gchar  *path,
+                          guint         capacity,
+                          GError      **error)
+{
+    MMLocationJournal *self;
+    struct stat        st;
+    gsize              size;
+    gint               fd;
+    gpointer           map;
+
+    g_return_val_if_fail (capacity > 0, NULL);
+
+    fd = open (path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't open location journal '%s': %s", path, g_strerror (errno));
+        return NULL;
+    }
+
+    size = sizeof (JournalHeader) + (gsize) capacity * sizeof (JournalRecord);
+    if (fstat (fd, &st) < 0 ||
+        ((gsize) st.st_size != size && ftruncate (fd, size) < 0)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't setup location journal '%s': %s", path, g_strerror (errno));
+        close (fd);
+        return NULL;
+    }
+
+    map = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't map location journal '%s': %s", path, g_strerror (errno));
+        close (fd);
+        return NULL;
+    }
+
+    self = g_slice_new0 (MMLocationJournal);
+    self->fd = fd;
+    self->size = size;
+    self->header = map;
+    self->records = (JournalRecord *) (self->header + 1);
+
+    /* New files, files from other versions or with a different capacity all
+     * start from scratch */
+    if (!header_valid (self->header, capacity)) {
+        mm_dbg ("Initializing location journal '%s'", path);
+        memset (map, 0, size);
+        memcpy (self->header->magic, JOURNAL_MAGIC, sizeof (self->header->magic));
+        self->header->version = JOURNAL_VERSION;
+        self->header->record_size = sizeof (JournalRecord);
+        self->header->capacity = capacity;
+        msync (map, size, MS_ASYNC);
+    } else
+        mm_dbg ("Opened location journal '%s' (%" G_GUINT64_FORMAT " records written)",
+                path, self->header->head);
+
+    return self;
+}
+
+void
+mm_location_journal_free (MMLocationJournal *self)
+{
+    if (!self)
+        return;
+
+    msync (self->header, self->size, MS_ASYNC);
+    munmap (self->header, self->size);
+    close (self->fd);
+    g_slice_free (MMLocationJournal, self);
+}
+
+/*****************************************************************************/
+
+void
+mm_location_journal_append (MMLocationJournal *self,
+                            MMLocation3gpp    *location_3gpp,
+                            MMLocationGpsRaw  *location_gps_raw)
+{
+    JournalRecord  record;
+    JournalRecord *last = NULL;
+    JournalRecord *slot;
+
+    memset (&record, 0, sizeof (record));
+    record.timestamp = g_get_real_time () / G_USEC_PER_SEC;
+
+    if (location_gps_raw &&
+        mm_location_gps_raw_get_latitude (location_gps_raw) != MM_LOCATION_LATITUDE_UNKNOWN &&
+        mm_location_gps_raw_get_longitude (location_gps_raw) != MM_LOCATION_LONGITUDE_UNKNOWN) {
+        record.latitude = mm_location_gps_raw_get_latitude (location_gps_raw);
+        record.longitude = mm_location_gps_raw_get_longitude (location_gps_raw);
+        record.altitude = mm_location_gps_raw_get_altitude (location_gps_raw);
+        record.flags |= RECORD_FLAG_GPS;
+    }
+
+    if (location_3gpp &&
+        mm_location_3gpp_get_mobile_country_code (location_3gpp) != 0) {
+        record.mobile_country_code = (guint16) mm_location_3gpp_get_mobile_country_code (location_3gpp);
+        record.mobile_network_code = (guint16) mm_location_3gpp_get_mobile_network_code (location_3gpp);
+        record.location_area_code = (guint32) mm_location_3gpp_get_location_area_code (location_3gpp);
+        record.cell_id = (guint32) mm_location_3gpp_get_cell_id (location_3gpp);
+        record.flags |= RECORD_FLAG_3GPP;
+    }
+
+    if (!record.flags)
+        return;
+
+    if (self->header->head > 0)
+        last = &self->records[(self->header->head - 1) % self->header->capacity];
+
+    /* Keep at most one record per second */
+    if (last && last->timestamp == record.timestamp) {
+        *last = record;
+    } else {
+        /* Write the record before moving the head, so that an interrupted
+         * write never exposes a half-written record */
+        slot = &self->records[self->header->head % self->header->capacity];
+        *slot = record;
+        self->header->head++;
+    }
+
+    msync (self->header, self->size, MS_ASYNC);
+}
+
+/*****************************************************************************/
+
+static GVariant *
+record_build_dictionary (const JournalRecord *record)
+{
+    GVariantBuilder builder;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&builder, "{sv}", "timestamp", g_variant_new_uint64 ((guint64) record->timestamp));
+    if (record->flags & RECORD_FLAG_GPS) {
+        g_variant_builder_add (&builder, "{sv}", "latitude", g_variant_new_double (record->latitude));
+        g_variant_builder_add (&builder, "{sv}", "longitude", g_variant_new_double (record->longitude));
+        if (record->altitude != MM_LOCATION_ALTITUDE_UNKNOWN)
+            g_variant_builder_add (&builder, "{sv}", "altitude", g_variant_new_double (record->altitude));
+    }
+    if (record->flags & RECORD_FLAG_3GPP) {
+        g_variant_builder_add (&builder, "{sv}", "mcc", g_variant_new_uint32 (record->mobile_country_code));
+        g_variant_builder_add (&builder, "{sv}", "mnc", g_variant_new_uint32 (record->mobile_network_code));
+        g_variant_builder_add (&builder, "{sv}", "lac", g_variant_new_uint32 (record->location_area_code));
+        g_variant_builder_add (&builder, "{sv}", "ci", g_variant_new_uint32 (record->cell_id));
+    }
+    return g_variant_builder_end (&builder);
+}
+
+GVariant *
+mm_location_journal_query (MMLocationJournal *self,
+                           guint64            from,
+                           guint64            to)
+{
+    GVariantBuilder builder;
+    guint64         first;
+    guint64         i;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+
+    first = (self->header->head > self->header->capacity ?
+             self->header->head - self->header->capacity :
+             0);
+    for (i = first; i < self->header->head; i++) {
+        const JournalRecord *record;
+
+        record = &self->records[i % self->header->capacity];
+        /* The clock may have gone back, so check every record */
+        if (record->timestamp < 0 ||
+            (guint64) record->timestamp < from ||
+            (to && (guint64) record->timestamp > to))
+            continue;
+        g_variant_builder_add_value (&builder, record_build_dictionary (record));
+    }
+
+    return g_variant_builder_end (&builder);
+}
@@ -0,0 +1,53 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_LOCATION_JOURNAL_H
+#define MM_LOCATION_JOURNAL_H
+
+#include <glib.h>
+
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+/*
+ * History of the location of a modem, kept in a fixed-size file which is
+ * memory-mapped and used as a ring buffer of binary records, so that it
+ * survives daemon restarts. The file uses the host byte order; files with a
+ * header that cannot be used are reinitialized.
+ */
+
+/* About a day of history with one record every 10s */
+#define MM_LOCATION_JOURNAL_DEFAULT_CAPACITY 8640
+
+typedef struct _MMLocationJournal MMLocationJournal;
+
+MMLocationJournal *mm_location_journal_open (const gchar  *path,
+                                             guint         capacity,
+                                             GError      **error);
+void               mm_location_journal_free (MMLocationJournal *self);
+
+/* Stores a record with the current time; an update in the same second as
+ * the last record replaces it. Nothing is stored without location data. */
+void mm_location_journal_append (MMLocationJournal *self,
+                                 MMLocation3gpp    *location_3gpp,
+                                 MMLocationGpsRaw  *location_gps_raw);
+
+/* Returns an "aa{sv}" variant with the records in the [from, to] range of
+ * UNIX timestamps, oldest first; a 'to' of 0 means no upper bound */
+GVariant *mm_location_journal_query (MMLocationJournal *self,
+                                     guint64            from,
+                                     guint64            to);
+
+#endif /* MM_LOCATION_JOURNAL_H */
@@ -36,6 +36,7 @@
 #endif
 
 #include "mm-log.h"
+#include "mm-byte-ring.h"
 
 enum {
     TS_FLAG_NONE = 0,
@@ -49,6 +50,137 @@ static GTimeVal rel_start = { 0, 0 };
 static int logfd = -1;
 static gboolean func_loc = FALSE;
 
+/*****************************************************************************/
+/* Log file writer
+ *
+ * When logging to a file, formatted messages are pushed into a ring buffer
+ * and written by a separate thread, which batches whatever is pending in a
+ * single write and only syncs the file to disk periodically. Logging never
+ * blocks on the file: if the ring is full, the message is dropped and counted,
+ * and the writer reports how many were lost. */
+
+#define RING_SIZE         (1 << 18)
+/* Longest time to wait for the writer to catch up when flushing */
+#define FLUSH_TIMEOUT_MS  2000
+
+static MMByteRing *ring;
+static GThread    *writer;
+static guint       fsync_interval;
+
+/* Producers are serialized by the lock, never held by the writer */
+static gint dropped;
+static gint dropped_total;
+G_LOCK_DEFINE_STATIC (producer);
+
+static void
+write_all (const gchar *buf,
+           gsize        len)
+{
+    while (len > 0) {
+        gssize written;
+
+        written = write (logfd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            /* Nothing else to do, the log file is where errors go */
+            return;
+        }
+        buf += written;
+        len -= written;
+    }
+}
+
+/* Runs in the writer thread; must not log */
+static gpointer
+writer_thread (gpointer unused)
+{
+    gint64 last_sync;
+    gboolean pending_sync = FALSE;
+
+    last_sync = g_get_monotonic_time ();
+
+    for (;;) {
+        const guint8 *data;
+        gboolean closed;
+        gsize len;
+        guint n_dropped;
+
+        /* Sleep until there is something to write, or until the next sync
+         * is due */
+        mm_byte_ring_wait (ring,
+                           (pending_sync && fsync_interval > 0) ?
+                           last_sync + (gint64) fsync_interval * G_USEC_PER_SEC : -1);
+
+        /* Checked before reading, so that everything pushed before closing
+         * is written */
+        closed = mm_byte_ring_is_closed (ring);
+
+        /* Whatever is pending, in at most two writes */
+        while ((len = mm_byte_ring_peek (ring, &data)) > 0) {
+            write_all ((const gchar *) data, len);
+            mm_byte_ring_release (ring, len);
+            pending_sync = TRUE;
+        }
+
+        n_dropped = (guint) g_atomic_int_and ((guint *) &dropped, 0);
+        if (n_dropped > 0) {
+            gchar *msg;
+
+            msg = g_strdup_printf ("<warn>  %u log messages dropped\n", n_dropped);
+            write_all (msg, strlen (msg));
+            g_free (msg);
+            pending_sync = TRUE;
+        }
+
+        if (pending_sync &&
+            (closed ||
+             (fsync_interval > 0 &&
+              g_get_monotonic_time () - last_sync >= (gint64) fsync_interval * G_USEC_PER_SEC))) {
+            fsync (logfd);
+            last_sync = g_get_monotonic_time ();
+            pending_sync = FALSE;
+        }
+
+        if (closed)
+            break;
+    }
+
+    return NULL;
+}
+
+static void
+log_file_push (const gchar *buf,
+               gsize        len)
+{
+    /* No writer, write right away */
+    if (!writer) {
+        write_all (buf, len);
+        return;
+    }
+
+    G_LOCK (producer);
+    if (!mm_byte_ring_push (ring, (const guint8 *) buf, len)) {
+        g_atomic_int_inc (&dropped);
+        g_atomic_int_inc (&dropped_total);
+    }
+    G_UNLOCK (producer);
+}
+
+/* Wait for the writer to go through everything pushed so far, e.g. before
+ * aborting on a fatal error */
+static void
+log_file_flush (void)
+{
+    if (!writer)
+        return;
+
+    mm_byte_ring_flush (ring, g_get_monotonic_time () + FLUSH_TIMEOUT_MS * 1000);
+    fsync (logfd);
+}
+
+/*****************************************************************************/
+
 typedef struct {
     guint32 num;
     const char *name;
@@ -62,23 +194,36 @@ static const LogDesc level_descs[] = {
     { 0, NULL }
 };
 
+/* Levels of each category; those not explicitly configured follow the
+ * global level */
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST] = {
+    [0 ... MM_LOG_CATEGORY_LAST - 1] = LOGL_INFO | LOGL_WARN | LOGL_ERR
+};
+static gboolean category_configured[MM_LOG_CATEGORY_LAST];
+
+static const gchar *category_names[MM_LOG_CATEGORY_LAST] = {
+    [MM_LOG_CATEGORY_SERIAL_AT]      = "serial-at",
+    [MM_LOG_CATEGORY_SERIAL_QCDM]    = "serial-qcdm",
+    [MM_LOG_CATEGORY_GPS]            = "gps",
+    [MM_LOG_CATEGORY_QMI]            = "qmi",
+    [MM_LOG_CATEGORY_PLUGIN_MANAGER] = "plugin-manager",
+};
+
+/* Ports whose traffic is logged regardless of the level of their category */
+static gchar **debug_ports;
+
 static GString *msgbuf = NULL;
 static volatile gsize msgbuf_once = 0;
 
-void
-_mm_log (const char *loc,
-         const char *func,
-         guint32 level,
-         const char *fmt,
-         ...)
+static void
+log_valist (const char *loc,
+            const char *func,
+            guint32 level,
+            const char *fmt,
+            va_list args)
 {
-    va_list args;
     GTimeVal tv;
     int syslog_priority = LOG_INFO;
-    ssize_t ign;
-
-    if (!(log_level & level))
-        return;
 
     if (g_once_init_enter (&msgbuf_once)) {
         msgbuf = g_string_sized_new (512);
@@ -86,14 +231,14 @@ _mm_log (const char *loc,
     } else
         g_string_truncate (msgbuf, 0);
 
-    if ((log_level & LOGL_DEBUG) && (level == LOGL_DEBUG))
+    if (level == LOGL_DEBUG)
         g_string_append (msgbuf, "<debug> ");
-    else if ((log_level & LOGL_INFO) && (level == LOGL_INFO))
+    else if (level == LOGL_INFO)
         g_string_append (msgbuf, "<info>  ");
-    else if ((log_level & LOGL_WARN) && (level == LOGL_WARN)) {
+    else if (level == LOGL_WARN) {
         g_string_append (msgbuf, "<warn>  ");
         syslog_priority = LOG_WARNING;
-    } else if ((log_level & LOGL_ERR) && (level == LOGL_ERR)) {
+    } else if (level == LOGL_ERR) {
         g_string_append (msgbuf, "<error> ");
         syslog_priority = LOG_ERR;
     } else
@@ -120,20 +265,45 @@ _mm_log (const char *loc,
     if (func_loc && log_level & LOGL_DEBUG)
         g_string_append_printf (msgbuf, "[%s] %s(): ", loc, func);
 
-    va_start (args, fmt);
     g_string_append_vprintf (msgbuf, fmt, args);
-    va_end (args);
 
     g_string_append_c (msgbuf, '\n');
 
     if (logfd < 0)
         syslog (syslog_priority, "%s", msgbuf->str);
-    else {
-        ign = write (logfd, msgbuf->str, msgbuf->len);
-        if (ign) {} /* whatever; really shut up about unused result */
+    else
+        log_file_push (msgbuf->str, msgbuf->len);
+}
 
-        fsync (logfd);  /* Make sure output is dumped to disk immediately */
-    }
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+    va_list args;
+
+    if (!(log_level & level))
+        return;
+
+    va_start (args, fmt);
+    log_valist (loc, func, level, fmt, args);
+    va_end (args);
+}
+
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+    va_list args;
+
+    va_start (args, fmt);
+    log_valist (loc, func, level, fmt, args);
+    va_end (args);
 }
 
 static void
@@ -143,7 +313,6 @@ log_handler (const gchar *log_domain,
              gpointer ignored)
 {
     int syslog_priority;
-    ssize_t ign;
 
     switch (level) {
     case G_LOG_LEVEL_ERROR:
@@ -170,38 +339,138 @@ log_handler (const gchar *log_domain,
     if (logfd < 0)
         syslog (syslog_priority, "%s", message);
     else {
-        ign = write (logfd, message, strlen (message));
-        if (ign) {} /* whatever; really shut up about unused result */
+        log_file_push (message, strlen (message));
+        /* Make sure fatal errors reach the disk before aborting */
+        if (level & (G_LOG_LEVEL_ERROR | G_LOG_FLAG_FATAL))
+            log_file_flush ();
     }
 }
 
-gboolean
-mm_log_set_level (const char *level, GError **error)
+static gboolean
+parse_level (const char *level,
+             guint32 *num,
+             GError **error)
 {
-    gboolean found = FALSE;
     const LogDesc *diter;
 
     for (diter = &level_descs[0]; diter->name; diter++) {
         if (!strcasecmp (diter->name, level)) {
-            log_level = diter->num;
-            found = TRUE;
-            break;
+            *num = diter->num;
+            return TRUE;
         }
     }
 
-    if (!found)
-        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
-                     "Unknown log level '%s'", level);
+    g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                 "Unknown log level '%s'", level);
+    return FALSE;
+}
 
+static void
+update_traces (void)
+{
 #if defined WITH_QMI
-    qmi_utils_set_traces_enabled (log_level & LOGL_DEBUG ? TRUE : FALSE);
+    qmi_utils_set_traces_enabled (mm_log_category_levels[MM_LOG_CATEGORY_QMI] & LOGL_DEBUG ? TRUE : FALSE);
 #endif
 
 #if defined WITH_MBIM
     mbim_utils_set_traces_enabled (log_level & LOGL_DEBUG ? TRUE : FALSE);
 #endif
+}
 
-    return found;
+gboolean
+mm_log_set_level (const char *level, GError **error)
+{
+    guint i;
+
+    if (!parse_level (level, &log_level, error))
+        return FALSE;
+
+    for (i = 0; i < MM_LOG_CATEGORY_LAST; i++) {
+        if (!category_configured[i])
+            mm_log_category_levels[i] = log_level;
+    }
+
+    update_traces ();
+    return TRUE;
+}
+
+gboolean
+mm_log_set_categories (const char *categories, GError **error)
+{
+    guint32 levels[MM_LOG_CATEGORY_LAST];
+    gboolean configured[MM_LOG_CATEGORY_LAST] = { FALSE };
+    gchar **split;
+    guint i;
+
+    /* Validate everything before applying anything */
+    split = g_strsplit (categories, ",", -1);
+    for (i = 0; split[i]; i++) {
+        gchar *name;
+        gchar *level;
+        guint j;
+
+        name = g_strstrip (split[i]);
+        if (!name[0])
+            continue;
+
+        level = strchr (name, ':');
+        if (!level) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                         "Missing level in log category '%s'", name);
+            g_strfreev (split);
+            return FALSE;
+        }
+        *level++ = '\0';
+
+        for (j = 0; j < MM_LOG_CATEGORY_LAST; j++) {
+            if (g_str_equal (category_names[j], name))
+                break;
+        }
+        if (j == MM_LOG_CATEGORY_LAST) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                         "Unknown log category '%s'", name);
+            g_strfreev (split);
+            return FALSE;
+        }
+
+        if (!parse_level (level, &levels[j], error)) {
+            g_strfreev (split);
+            return FALSE;
+        }
+        configured[j] = TRUE;
+    }
+    g_strfreev (split);
+
+    for (i = 0; i < MM_LOG_CATEGORY_LAST; i++) {
+        category_configured[i] = configured[i];
+        mm_log_category_levels[i] = configured[i] ? levels[i] : log_level;
+    }
+
+    update_traces ();
+    return TRUE;
+}
+
+void
+mm_log_set_debug_ports (const char *ports)
+{
+    guint i;
+
+    g_strfreev (debug_ports);
+    debug_ports = ports ? g_strsplit (ports, ",", -1) : NULL;
+    for (i = 0; debug_ports && debug_ports[i]; i++)
+        g_strstrip (debug_ports[i]);
+}
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+    guint i;
+
+    for (i = 0; debug_ports && debug_ports[i]; i++) {
+        if (g_str_equal (debug_ports[i], device))
+            return TRUE;
+    }
+    return FALSE;
 }
 
 gboolean
@@ -210,6 +479,7 @@ mm_log_setup (const char *level,
               gboolean show_timestamps,
               gboolean rel_timestamps,
               gboolean debug_func_loc,
+              guint log_fsync_interval,
               GError **error)
 {
     /* levels */
@@ -238,6 +508,14 @@ mm_log_setup (const char *level,
                          errno, strerror (errno));
             return FALSE;
         }
+
+        fsync_interval = log_fsync_interval;
+        ring = mm_byte_ring_new (RING_SIZE);
+        writer = g_thread_try_new ("log-writer", writer_thread, NULL, NULL);
+        if (!writer) {
+            /* Not fatal, just write synchronously */
+            g_clear_pointer (&ring, mm_byte_ring_free);
+        }
     }
 
     g_log_set_handler (G_LOG_DOMAIN,
@@ -262,11 +540,26 @@ mm_log_setup (const char *level,
     return TRUE;
 }
 
+guint
+mm_log_get_dropped (void)
+{
+    return (guint) g_atomic_int_get (&dropped_total);
+}
+
 void
 mm_log_shutdown (void)
 {
-    if (logfd < 0)
+    if (logfd < 0) {
         closelog ();
-    else
-        close (logfd);
+        return;
+    }
+
+    if (writer) {
+        mm_byte_ring_close (ring);
+        g_thread_join (writer);
+        writer = NULL;
+        g_clear_pointer (&ring, mm_byte_ring_free);
+    } else
+        fsync (logfd);
+    close (logfd);
 }
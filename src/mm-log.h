@@ -49,13 +49,62 @@ void _mm_log (const char *loc,
 
 gboolean mm_log_set_level (const char *level, GError **error);
 
+/* Log categories, each with its own level; unless explicitly configured, they
+ * follow the global level. Whether a category is enabled is checked inline,
+ * so that messages which are expensive to build (e.g. port traffic) cost
+ * nothing when disabled. */
+typedef enum {
+    MM_LOG_CATEGORY_SERIAL_AT,
+    MM_LOG_CATEGORY_SERIAL_QCDM,
+    MM_LOG_CATEGORY_GPS,
+    MM_LOG_CATEGORY_QMI,
+    MM_LOG_CATEGORY_PLUGIN_MANAGER,
+    MM_LOG_CATEGORY_LAST
+} MMLogCategory;
+
+extern guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+#define mm_log_category_enabled(category, level) \
+    ((mm_log_category_levels[category] & (level)) != 0)
+
+#define mm_log_category(category, level, ...)                                \
+    G_STMT_START {                                                           \
+        if (mm_log_category_enabled (category, level))                       \
+            _mm_log_unchecked (G_STRLOC, G_STRFUNC, level, ## __VA_ARGS__); \
+    } G_STMT_END
+
+#define mm_dbg_category(category, ...) \
+    mm_log_category (category, LOGL_DEBUG, ## __VA_ARGS__)
+
+/* For callers which already checked whether the message is to be logged */
+#define mm_log_unchecked(level, ...) \
+    _mm_log_unchecked (G_STRLOC, G_STRFUNC, level, ## __VA_ARGS__ )
+
+void _mm_log_unchecked (const char *loc,
+                        const char *func,
+                        guint32 level,
+                        const char *fmt,
+                        ...)  __attribute__((__format__ (__printf__, 4, 5)));
+
+/* Comma-separated list of category:LEVEL pairs, e.g. "serial-at:DEBUG" */
+gboolean mm_log_set_categories (const char *categories, GError **error);
+
+/* Comma-separated list of port names whose traffic is always logged */
+void     mm_log_set_debug_ports    (const char *ports);
+gboolean mm_log_port_debug_enabled (const char *device);
+
 gboolean mm_log_setup (const char *level,
                        const char *log_file,
                        gboolean show_ts,
                        gboolean rel_ts,
                        gboolean debug_func_loc,
+                       guint log_fsync_interval,
                        GError **error);
 
 void mm_log_shutdown (void);
 
+/* Number of messages dropped since startup because the log file writer
+ * couldn't keep up */
+guint mm_log_get_dropped (void);
+
 #endif  /* MM_LOG_H */
@@ -0,0 +1,319 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mm-loop-monitor.h"
+#include "mm-log.h"
+
+#define HEARTBEAT_INTERVAL_MS 100
+/* One minute of heartbeats */
+#define LAG_SAMPLES           600
+/* Deeper sections are counted but not tracked */
+#define MAX_SECTION_DEPTH     8
+
+typedef struct {
+    guint64 count;
+    guint64 total;
+    gint64  max;
+} SectionStats;
+
+typedef struct {
+    /* Interned */
+    const gchar *name;
+    gint64       start;
+    /* Set once a stall has been reported in this section or a nested one */
+    gboolean     reported;
+} ActiveSection;
+
+static gboolean  running;
+static gint64    threshold;
+static GPollFunc default_poll_func;
+
+/* Section name -> SectionStats */
+static GHashTable    *sections;
+static ActiveSection  stack[MAX_SECTION_DEPTH];
+static guint          depth;
+
+/* Current iteration of the main loop, since the last poll returned */
+static gint64       iteration_start;
+static gboolean     iteration_reported;
+static const gchar *iteration_slowest;
+static gint64       iteration_slowest_time;
+
+static guint64 iterations;
+static gint64  iteration_max;
+static guint   stalls;
+
+/* Ring buffer of the latest lag samples */
+static gint64  lag_samples[LAG_SAMPLES];
+static guint64 n_lag_samples;
+static gint64  heartbeat_due;
+
+/*****************************************************************************/
+
+static gchar *
+build_stack_hint (guint n)
+{
+    GString *str;
+    guint i;
+
+    str = g_string_new ("");
+    for (i = 0; i < n && i < MAX_SECTION_DEPTH; i++) {
+        if (i > 0)
+            g_string_append (str, " > ");
+        g_string_append (str, stack[i].name);
+    }
+    return g_string_free (str, FALSE);
+}
+
+void
+mm_loop_monitor_section_begin (const gchar *name)
+{
+    if (!running)
+        return;
+
+    if (depth < MAX_SECTION_DEPTH) {
+        stack[depth].name = g_intern_string (name);
+        stack[depth].start = g_get_monotonic_time ();
+        stack[depth].reported = FALSE;
+    }
+    depth++;
+}
+
+void
+mm_loop_monitor_section_end (void)
+{
+    ActiveSection *section;
+    SectionStats *stats;
+    gint64 elapsed;
+
+    if (!running)
+        return;
+
+    g_return_if_fail (depth > 0);
+
+    depth--;
+    if (depth >= MAX_SECTION_DEPTH)
+        return;
+
+    section = &stack[depth];
+    elapsed = g_get_monotonic_time () - section->start;
+
+    stats = g_hash_table_lookup (sections, section->name);
+    if (!stats) {
+        stats = g_slice_new0 (SectionStats);
+        g_hash_table_insert (sections, (gpointer) section->name, stats);
+    }
+    stats->count++;
+    stats->total += elapsed;
+    stats->max = MAX (stats->max, elapsed);
+
+    if (elapsed > iteration_slowest_time) {
+        iteration_slowest = section->name;
+        iteration_slowest_time = elapsed;
+    }
+
+    /* Only the innermost section that stalled is reported */
+    if (elapsed > threshold && !section->reported) {
+        GSource *source;
+        const gchar *source_name = NULL;
+        gchar *hint;
+        guint i;
+
+        source = g_main_current_source ();
+        if (source)
+            source_name = g_source_get_name (source);
+
+        hint = build_stack_hint (depth + 1);
+        mm_warn ("Main loop stalled for %" G_GINT64_FORMAT "ms in '%s' (source: %s, sections: %s)",
+                 elapsed / 1000,
+                 section->name,
+                 source_name ? source_name : "unnamed",
+                 hint);
+        g_free (hint);
+
+        for (i = 0; i < depth; i++)
+            stack[i].reported = TRUE;
+        iteration_reported = TRUE;
+        stalls++;
+    }
+}
+
+/*****************************************************************************/
+
+static void
+iteration_finish (void)
+{
+    gint64 elapsed;
+
+    if (!iteration_start)
+        return;
+
+    elapsed = g_get_monotonic_time () - iteration_start;
+    iterations++;
+    iteration_max = MAX (iteration_max, elapsed);
+
+    if (elapsed > threshold && !iteration_reported) {
+        if (iteration_slowest)
+            mm_warn ("Main loop stalled for %" G_GINT64_FORMAT "ms (slowest section: '%s', %" G_GINT64_FORMAT "ms)",
+                     elapsed / 1000,
+                     iteration_slowest,
+                     iteration_slowest_time / 1000);
+        else
+            mm_warn ("Main loop stalled for %" G_GINT64_FORMAT "ms outside of any monitored section",
+                     elapsed / 1000);
+        stalls++;
+    }
+
+    iteration_reported = FALSE;
+    iteration_slowest = NULL;
+    iteration_slowest_time = 0;
+}
+
+static gint
+monitored_poll (GPollFD *fds,
+                guint    nfds,
+                gint     timeout)
+{
+    gint ret;
+
+    iteration_finish ();
+    ret = default_poll_func (fds, nfds, timeout);
+    iteration_start = g_get_monotonic_time ();
+
+    return ret;
+}
+
+static gboolean
+heartbeat_cb (void)
+{
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+    lag_samples[n_lag_samples % LAG_SAMPLES] = MAX (now - heartbeat_due, 0);
+    n_lag_samples++;
+
+    /* Timeouts are re-armed relative to the time they are dispatched */
+    heartbeat_due = now + HEARTBEAT_INTERVAL_MS * 1000;
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static gint
+lag_cmp (const void *a,
+         const void *b)
+{
+    gint64 lag_a = *(const gint64 *) a;
+    gint64 lag_b = *(const gint64 *) b;
+
+    return (lag_a > lag_b) - (lag_a < lag_b);
+}
+
+static guint32
+to_uint32 (gint64 value)
+{
+    return (guint32) CLAMP (value, 0, G_MAXUINT32);
+}
+
+GVariant *
+mm_loop_monitor_get_stats (void)
+{
+    GVariantBuilder builder;
+    GVariantBuilder sections_builder;
+    GHashTableIter iter;
+    const gchar *name;
+    SectionStats *stats;
+    gint64 sorted[LAG_SAMPLES];
+    guint n;
+
+    if (!running)
+        return NULL;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&builder, "{sv}", "threshold", g_variant_new_uint32 (threshold / 1000));
+    g_variant_builder_add (&builder, "{sv}", "iterations", g_variant_new_uint64 (iterations));
+    g_variant_builder_add (&builder, "{sv}", "iteration-max", g_variant_new_uint32 (to_uint32 (iteration_max)));
+    g_variant_builder_add (&builder, "{sv}", "stalls", g_variant_new_uint32 (stalls));
+
+    n = MIN (n_lag_samples, LAG_SAMPLES);
+    g_variant_builder_add (&builder, "{sv}", "lag-samples", g_variant_new_uint32 (n));
+    if (n > 0) {
+        memcpy (sorted, lag_samples, n * sizeof (gint64));
+        qsort (sorted, n, sizeof (gint64), lag_cmp);
+        g_variant_builder_add (&builder, "{sv}", "lag-p50", g_variant_new_uint32 (to_uint32 (sorted[(n - 1) * 50 / 100])));
+        g_variant_builder_add (&builder, "{sv}", "lag-p90", g_variant_new_uint32 (to_uint32 (sorted[(n - 1) * 90 / 100])));
+        g_variant_builder_add (&builder, "{sv}", "lag-p99", g_variant_new_uint32 (to_uint32 (sorted[(n - 1) * 99 / 100])));
+        g_variant_builder_add (&builder, "{sv}", "lag-max", g_variant_new_uint32 (to_uint32 (sorted[n - 1])));
+    }
+
+    g_variant_builder_init (&sections_builder, G_VARIANT_TYPE ("aa{sv}"));
+    g_hash_table_iter_init (&iter, sections);
+    while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &stats)) {
+        g_variant_builder_open (&sections_builder, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&sections_builder, "{sv}", "name", g_variant_new_string (name));
+        g_variant_builder_add (&sections_builder, "{sv}", "count", g_variant_new_uint64 (stats->count));
+        g_variant_builder_add (&sections_builder, "{sv}", "total", g_variant_new_uint64 (stats->total));
+        g_variant_builder_add (&sections_builder, "{sv}", "max", g_variant_new_uint32 (to_uint32 (stats->max)));
+        g_variant_builder_close (&sections_builder);
+    }
+    g_variant_builder_add (&builder, "{sv}", "sections", g_variant_builder_end (&sections_builder));
+
+    return g_variant_builder_end (&builder);
+}
+
+/*****************************************************************************/
+
+static void
+section_stats_free (SectionStats *stats)
+{
+    g_slice_free (SectionStats, stats);
+}
+
+gboolean
+mm_loop_monitor_is_running (void)
+{
+    return running;
+}
+
+void
+mm_loop_monitor_start (guint threshold_ms)
+{
+    GMainContext *context;
+    guint id;
+
+    g_return_if_fail (!running);
+    g_return_if_fail (threshold_ms > 0);
+
+    context = g_main_context_default ();
+    default_poll_func = g_main_context_get_poll_func (context);
+    g_main_context_set_poll_func (context, monitored_poll);
+
+    /* Section names are interned strings */
+    sections = g_hash_table_new_full (g_direct_hash,
+                                      g_direct_equal,
+                                      NULL,
+                                      (GDestroyNotify) section_stats_free);
+
+    threshold = (gint64) threshold_ms * 1000;
+    heartbeat_due = g_get_monotonic_time () + HEARTBEAT_INTERVAL_MS * 1000;
+    id = g_timeout_add (HEARTBEAT_INTERVAL_MS, (GSourceFunc) heartbeat_cb, NULL);
+    g_source_set_name_by_id (id, "[mm] loop monitor heartbeat");
+    running = TRUE;
+
+    mm_info ("Monitoring main loop stalls longer than %ums", threshold_ms);
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_LOOP_MONITOR_H
+#define MM_LOOP_MONITOR_H
+
+#include <glib.h>
+
+/*
+ * Instrumentation of the default main context, for debugging purposes.
+ *
+ * GLib doesn't allow hooking into the dispatch of each source, so the time
+ * spent between two polls of the main context is measured instead, and the
+ * daemon code marks the sections of its own callbacks that are worth telling
+ * apart (e.g. the input from serial ports). A warning is logged whenever a
+ * section or a whole main loop iteration takes longer than the threshold,
+ * along with the sections which were running at the time.
+ *
+ * The lag of the loop is sampled with a periodic heartbeat timeout, as the
+ * delay between the expected and the actual time of each wakeup.
+ *
+ * All the calls are no-ops until the monitor is started, and must only be
+ * done from the main thread.
+ */
+
+void     mm_loop_monitor_start      (guint threshold_ms);
+gboolean mm_loop_monitor_is_running (void);
+
+/* Sections may be nested; 'name' doesn't need to outlive the section */
+void mm_loop_monitor_section_begin (const gchar *name);
+void mm_loop_monitor_section_end   (void);
+
+/* Returns an "a{sv}" variant with the collected statistics, or NULL if the
+ * monitor isn't running */
+GVariant *mm_loop_monitor_get_stats (void);
+
+#endif /* MM_LOOP_MONITOR_H */
@@ -0,0 +1,101 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-memory-budget.h"
+#include "mm-log.h"
+
+/* Each structure applies its own limits */
+static const MMMemoryBudget default_budget = {
+    0,    /* serial_buffer */
+    0,    /* reply_cache_entries */
+    0,    /* reply_cache_size */
+    0,    /* sms_objects */
+    0,    /* nmea_traces */
+    0,    /* nmea_trace_size */
+    TRUE, /* regex_optimize */
+};
+
+static const MMMemoryBudget constrained_budget = {
+    8192,  /* serial_buffer */
+    16,    /* reply_cache_entries */
+    4096,  /* reply_cache_size */
+    32,    /* sms_objects */
+    16,    /* nmea_traces */
+    1024,  /* nmea_trace_size */
+    FALSE, /* regex_optimize */
+};
+
+static const MMMemoryBudget *budget = &default_budget;
+
+/*****************************************************************************/
+
+void
+mm_memory_budget_init (gboolean constrained)
+{
+    budget = (constrained ? &constrained_budget : &default_budget);
+}
+
+gboolean
+mm_memory_budget_is_constrained (void)
+{
+    return budget == &constrained_budget;
+}
+
+const MMMemoryBudget *
+mm_memory_budget_get (void)
+{
+    return budget;
+}
+
+/*****************************************************************************/
+
+static gchar *
+cap_to_string (gsize        cap,
+               const gchar *units)
+{
+    return (cap ? g_strdup_printf ("%" G_GSIZE_FORMAT " %s", cap, units) : g_strdup ("unbounded"));
+}
+
+void
+mm_memory_budget_report (void)
+{
+    gchar *serial_buffer;
+    gchar *reply_cache_entries;
+    gchar *reply_cache_size;
+    gchar *sms_objects;
+    gchar *nmea_traces;
+    gchar *nmea_trace_size;
+
+    serial_buffer = cap_to_string (budget->serial_buffer, "bytes");
+    reply_cache_entries = cap_to_string (budget->reply_cache_entries, "entries");
+    reply_cache_size = cap_to_string (budget->reply_cache_size, "bytes");
+    sms_objects = cap_to_string (budget->sms_objects, "messages");
+    nmea_traces = cap_to_string (budget->nmea_traces, "types");
+    nmea_trace_size = cap_to_string (budget->nmea_trace_size, "bytes");
+
+    mm_info ("Memory budget (%s profile):", mm_memory_budget_is_constrained () ? "constrained" : "default");
+    mm_info ("  serial response buffer: %s per port", serial_buffer);
+    mm_info ("  reply cache:            %s, %s per cache", reply_cache_entries, reply_cache_size);
+    mm_info ("  SMS in memory:          %s per modem", sms_objects);
+    mm_info ("  NMEA traces:            %s per modem, %s per type", nmea_traces, nmea_trace_size);
+    mm_info ("  regex optimization:     %s", budget->regex_optimize ? "enabled" : "disabled");
+
+    g_free (serial_buffer);
+    g_free (reply_cache_entries);
+    g_free (reply_cache_size);
+    g_free (sms_objects);
+    g_free (nmea_traces);
+    g_free (nmea_trace_size);
+}
@@ -0,0 +1,53 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_MEMORY_BUDGET_H
+#define MM_MEMORY_BUDGET_H
+
+#include <glib.h>
+
+/*
+ * Caps on the structures which would otherwise grow with whatever the modems
+ * send. By default each structure keeps its own limits (if any); in the
+ * constrained profile, meant for targets with very little memory, all of them
+ * get hard caps and regular expressions are compiled without optimization,
+ * trading speed for a smaller and predictable footprint.
+ *
+ * A cap of 0 means no limit.
+ */
+typedef struct {
+    /* Bytes kept in the response buffer of each serial port */
+    gsize    serial_buffer;
+    /* Entries and bytes kept in each reply cache */
+    guint    reply_cache_entries;
+    gsize    reply_cache_size;
+    /* SMS objects kept in memory by each modem */
+    guint    sms_objects;
+    /* NMEA trace types, and bytes per trace type, kept by each modem */
+    guint    nmea_traces;
+    gsize    nmea_trace_size;
+    /* Whether regular expressions are compiled with G_REGEX_OPTIMIZE */
+    gboolean regex_optimize;
+} MMMemoryBudget;
+
+/* Must be called before any modem is created */
+void                  mm_memory_budget_init           (gboolean constrained);
+gboolean              mm_memory_budget_is_constrained (void);
+const MMMemoryBudget *mm_memory_budget_get            (void);
+
+/* Logs the caps in use */
+void                  mm_memory_budget_report         (void);
+
+#endif /* MM_MEMORY_BUDGET_H */
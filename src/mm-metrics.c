@@ -0,0 +1,420 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-metrics.h"
+
+/* Upper limits of the buckets of the duration histograms, in microseconds;
+ * there is one more bucket without upper limit */
+static const gint64 duration_bucket_limits[] = {
+    100000, 500000, 1000000, 2500000, 5000000, 10000000, 30000000, 60000000, 120000000
+};
+#define N_DURATION_BUCKETS (G_N_ELEMENTS (duration_bucket_limits) + 1)
+
+typedef enum {
+    METRIC_TYPE_COUNTER,
+    METRIC_TYPE_HISTOGRAM,
+} MetricType;
+
+/* Values are pointer-sized, so that they can be updated atomically */
+struct _MMMetric {
+    MetricType  type;
+    gchar      *label_value;
+    gsize       value;                       /* counters */
+    gsize       sum;                         /* histograms, microseconds */
+    gsize       buckets[N_DURATION_BUCKETS]; /* histograms, not cumulative */
+};
+
+typedef struct {
+    gchar      *name;
+    gchar      *help;
+    gchar      *label_name;
+    MetricType  type;
+    GPtrArray  *metrics;
+} Family;
+
+/* Only modified from the main thread */
+static GPtrArray *families;
+
+/*****************************************************************************/
+
+static MMMetric *
+metrics_lookup (MetricType   type,
+                const gchar *family_name,
+                const gchar *help,
+                const gchar *label_name,
+                const gchar *label_value)
+{
+    Family   *family = NULL;
+    MMMetric *metric;
+    guint     i;
+
+    g_return_val_if_fail (family_name != NULL, NULL);
+    g_return_val_if_fail ((label_name == NULL) == (label_value == NULL), NULL);
+
+    if (G_UNLIKELY (!families))
+        families = g_ptr_array_new ();
+
+    for (i = 0; i < families->len; i++) {
+        if (g_str_equal (((Family *) g_ptr_array_index (families, i))->name, family_name)) {
+            family = g_ptr_array_index (families, i);
+            break;
+        }
+    }
+
+    if (!family) {
+        family = g_slice_new0 (Family);
+        family->name = g_strdup (family_name);
+        family->help = g_strdup (help);
+        family->label_name = g_strdup (label_name);
+        family->type = type;
+        family->metrics = g_ptr_array_new ();
+        g_ptr_array_add (families, family);
+    }
+
+    g_return_val_if_fail (family->type == type, NULL);
+    g_return_val_if_fail (g_strcmp0 (family->label_name, label_name) == 0, NULL);
+
+    for (i = 0; i < family->metrics->len; i++) {
+        metric = g_ptr_array_index (family->metrics, i);
+        if (g_strcmp0 (metric->label_value, label_value) == 0)
+            return metric;
+    }
+
+    metric = g_slice_new0 (MMMetric);
+    metric->type = type;
+    metric->label_value = g_strdup (label_value);
+    g_ptr_array_add (family->metrics, metric);
+    return metric;
+}
+
+MMMetric *
+mm_metrics_counter (const gchar *family,
+                    const gchar *help,
+                    const gchar *label_name,
+                    const gchar *label_value)
+{
+    return metrics_lookup (METRIC_TYPE_COUNTER, family, help, label_name, label_value);
+}
+
+MMMetric *
+mm_metrics_histogram (const gchar *family,
+                      const gchar *help,
+                      const gchar *label_name,
+                      const gchar *label_value)
+{
+    return metrics_lookup (METRIC_TYPE_HISTOGRAM, family, help, label_name, label_value);
+}
+
+void
+mm_metric_inc (MMMetric *metric)
+{
+    g_return_if_fail (metric != NULL);
+    g_return_if_fail (metric->type == METRIC_TYPE_COUNTER);
+
+    g_atomic_pointer_add (&metric->value, 1);
+}
+
+void
+mm_metric_observe (MMMetric *metric,
+                   gint64    duration)
+{
+    guint i;
+
+    g_return_if_fail (metric != NULL);
+    g_return_if_fail (metric->type == METRIC_TYPE_HISTOGRAM);
+
+    if (duration < 0)
+        duration = 0;
+    for (i = 0; i < G_N_ELEMENTS (duration_bucket_limits); i++) {
+        if (duration <= duration_bucket_limits[i])
+            break;
+    }
+    g_atomic_pointer_add (&metric->buckets[i], 1);
+    g_atomic_pointer_add (&metric->sum, (gssize) duration);
+}
+
+/*****************************************************************************/
+/* OpenMetrics text */
+
+#define ATOMIC_GET(location) GPOINTER_TO_SIZE (g_atomic_pointer_get (location))
+
+static void
+append_escaped (GString     *str,
+                const gchar *value)
+{
+    for (; *value; value++) {
+        switch (*value) {
+        case '\\':
+            g_string_append (str, "\\\\");
+            break;
+        case '"':
+            g_string_append (str, "\\\"");
+            break;
+        case '\n':
+            g_string_append (str, "\\n");
+            break;
+        default:
+            g_string_append_c (str, *value);
+            break;
+        }
+    }
+}
+
+/* Appends the label set, if any; 'le' is the bucket limit in seconds, a
+ * negative one for the last bucket */
+static void
+append_labels (GString            *str,
+               const gchar *const *names,
+               const gchar *const *values,
+               gboolean            with_le,
+               gdouble             le)
+{
+    gboolean first = TRUE;
+    guint    i;
+
+    for (i = 0; names && names[i]; i++) {
+        if (!values[i])
+            continue;
+        g_string_append (str, first ? "{" : ",");
+        g_string_append_printf (str, "%s=\"", names[i]);
+        append_escaped (str, values[i]);
+        g_string_append_c (str, '"');
+        first = FALSE;
+    }
+
+    if (with_le) {
+        gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+        g_string_append (str, first ? "{" : ",");
+        if (le < 0)
+            g_string_append (str, "le=\"+Inf\"");
+        else
+            g_string_append_printf (str, "le=\"%s\"", g_ascii_dtostr (buf, sizeof (buf), le));
+        first = FALSE;
+    }
+
+    if (!first)
+        g_string_append_c (str, '}');
+}
+
+static void
+append_header (GString     *str,
+               const gchar *name,
+               const gchar *type,
+               const gchar *help)
+{
+    g_string_append_printf (str, "# TYPE %s %s\n", name, type);
+    if (help)
+        g_string_append_printf (str, "# HELP %s %s\n", name, help);
+}
+
+/* Buckets are given as non-cumulative counts; limits in seconds */
+static void
+append_histogram (GString            *str,
+                  const gchar        *name,
+                  const gchar *const *label_names,
+                  const gchar *const *label_values,
+                  const gdouble      *limits,
+                  const gsize        *buckets,
+                  guint               n_buckets,
+                  gboolean            with_sum,
+                  gdouble             sum)
+{
+    gsize cumulative = 0;
+    guint i;
+
+    for (i = 0; i < n_buckets; i++) {
+        cumulative += buckets[i];
+        g_string_append_printf (str, "%s_bucket", name);
+        append_labels (str, label_names, label_values, TRUE, i < n_buckets - 1 ? limits[i] : -1.0);
+        g_string_append_printf (str, " %" G_GSIZE_FORMAT "\n", cumulative);
+    }
+    g_string_append_printf (str, "%s_count", name);
+    append_labels (str, label_names, label_values, FALSE, 0);
+    g_string_append_printf (str, " %" G_GSIZE_FORMAT "\n", cumulative);
+    if (with_sum) {
+        gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+        g_string_append_printf (str, "%s_sum", name);
+        append_labels (str, label_names, label_values, FALSE, 0);
+        g_string_append_printf (str, " %s\n", g_ascii_dtostr (buf, sizeof (buf), sum));
+    }
+}
+
+static void
+append_family (GString *str,
+               Family  *family)
+{
+    const gchar *label_names[] = { family->label_name, NULL };
+    gchar       *name;
+    guint        i;
+
+    if (family->type == METRIC_TYPE_COUNTER) {
+        append_header (str, family->name, "counter", family->help);
+        for (i = 0; i < family->metrics->len; i++) {
+            MMMetric    *metric = g_ptr_array_index (family->metrics, i);
+            const gchar *label_values[] = { metric->label_value, NULL };
+
+            g_string_append_printf (str, "%s_total", family->name);
+            append_labels (str, label_names, label_values, FALSE, 0);
+            g_string_append_printf (str, " %" G_GSIZE_FORMAT "\n", ATOMIC_GET (&metric->value));
+        }
+        return;
+    }
+
+    name = g_strdup_printf ("%s_seconds", family->name);
+    append_header (str, name, "histogram", family->help);
+    for (i = 0; i < family->metrics->len; i++) {
+        MMMetric    *metric = g_ptr_array_index (family->metrics, i);
+        const gchar *label_values[] = { metric->label_value, NULL };
+        gdouble      limits[N_DURATION_BUCKETS - 1];
+        gsize        buckets[N_DURATION_BUCKETS];
+        guint        j;
+
+        for (j = 0; j < N_DURATION_BUCKETS; j++)
+            buckets[j] = ATOMIC_GET (&metric->buckets[j]);
+        for (j = 0; j < G_N_ELEMENTS (limits); j++)
+            limits[j] = (gdouble) duration_bucket_limits[j] / G_USEC_PER_SEC;
+        append_histogram (str, name, label_names, label_values,
+                          limits, buckets, N_DURATION_BUCKETS,
+                          TRUE, (gdouble) ATOMIC_GET (&metric->sum) / G_USEC_PER_SEC);
+    }
+    g_free (name);
+}
+
+/* One family built from the "aa{sv}" port stats, either a counter from an
+ * unsigned key or a histogram from an array key */
+static void
+append_port_stats_family (GString     *str,
+                          GVariant    *port_stats,
+                          const gchar *name,
+                          const gchar *help,
+                          const gchar *key,
+                          gboolean     histogram)
+{
+    const gchar *label_names[] = { "port", "command", NULL };
+    GVariantIter iter;
+    GVariant    *item;
+
+    append_header (str, name, histogram ? "histogram" : "counter", help);
+
+    g_variant_iter_init (&iter, port_stats);
+    while ((item = g_variant_iter_next_value (&iter)) != NULL) {
+        const gchar *label_values[] = { NULL, NULL, NULL };
+
+        g_variant_lookup (item, "port", "&s", &label_values[0]);
+        g_variant_lookup (item, "prefix", "&s", &label_values[1]);
+
+        if (!histogram) {
+            guint32 value = 0;
+
+            g_variant_lookup (item, key, "u", &value);
+            g_string_append_printf (str, "%s_total", name);
+            append_labels (str, label_names, label_values, FALSE, 0);
+            g_string_append_printf (str, " %u\n", value);
+        } else {
+            GVariant *limits_variant = NULL;
+            GVariant *buckets_variant = NULL;
+
+            if (g_variant_lookup (item, "bucket-limits", "@au", &limits_variant) &&
+                g_variant_lookup (item, key, "@au", &buckets_variant)) {
+                const guint32 *limits_ms;
+                const guint32 *counts;
+                gsize          n_limits;
+                gsize          n_counts;
+
+                limits_ms = g_variant_get_fixed_array (limits_variant, &n_limits, sizeof (guint32));
+                counts = g_variant_get_fixed_array (buckets_variant, &n_counts, sizeof (guint32));
+                if (n_counts == n_limits + 1) {
+                    gdouble *limits;
+                    gsize   *buckets;
+                    guint    i;
+
+                    limits = g_new (gdouble, n_limits);
+                    buckets = g_new (gsize, n_counts);
+                    for (i = 0; i < n_limits; i++)
+                        limits[i] = (gdouble) limits_ms[i] / 1000.0;
+                    for (i = 0; i < n_counts; i++)
+                        buckets[i] = counts[i];
+                    append_histogram (str, name, label_names, label_values,
+                                      limits, buckets, n_counts, FALSE, 0);
+                    g_free (limits);
+                    g_free (buckets);
+                }
+            }
+            if (limits_variant)
+                g_variant_unref (limits_variant);
+            if (buckets_variant)
+                g_variant_unref (buckets_variant);
+        }
+        g_variant_unref (item);
+    }
+}
+
+gchar *
+mm_metrics_build (GVariant *port_stats,
+                  GVariant *queue_depths,
+                  guint64   log_dropped)
+{
+    GString *str;
+    guint    i;
+
+    str = g_string_sized_new (4096);
+
+    for (i = 0; families && i < families->len; i++)
+        append_family (str, g_ptr_array_index (families, i));
+
+    if (port_stats) {
+        append_port_stats_family (str, port_stats, "mm_serial_commands",
+                                  "Commands sent on each serial port",
+                                  "count", FALSE);
+        append_port_stats_family (str, port_stats, "mm_serial_command_timeouts",
+                                  "Commands timed out on each serial port",
+                                  "timeouts", FALSE);
+        append_port_stats_family (str, port_stats, "mm_serial_queue_wait_seconds",
+                                  "Time since a command was queued until it started to be written",
+                                  "queue-wait", TRUE);
+        append_port_stats_family (str, port_stats, "mm_serial_response_seconds",
+                                  "Time since a command started to be written until its final result",
+                                  "response", TRUE);
+    }
+
+    if (queue_depths) {
+        const gchar *label_names[] = { "port", NULL };
+        GVariantIter iter;
+        const gchar *port;
+        guint32      depth;
+
+        append_header (str, "mm_serial_queue_depth", "gauge",
+                       "Commands queued on each serial port, including the one in progress");
+        g_variant_iter_init (&iter, queue_depths);
+        while (g_variant_iter_next (&iter, "{&su}", &port, &depth)) {
+            const gchar *label_values[] = { port, NULL };
+
+            g_string_append (str, "mm_serial_queue_depth");
+            append_labels (str, label_names, label_values, FALSE, 0);
+            g_string_append_printf (str, " %u\n", depth);
+        }
+    }
+
+    append_header (str, "mm_log_dropped_messages", "counter",
+                   "Log messages dropped because the log file writer fell behind");
+    g_string_append_printf (str, "mm_log_dropped_messages_total %" G_GUINT64_FORMAT "\n", log_dropped);
+
+    g_string_append (str, "# EOF\n");
+    return g_string_free (str, FALSE);
+}
@@ -0,0 +1,55 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_METRICS_H
+#define MM_METRICS_H
+
+#include <glib.h>
+
+/*
+ * Counters and histograms about the internals of the daemon, exported in the
+ * OpenMetrics text format for monitoring purposes. They are always enabled.
+ *
+ * Metrics are looked up (and created on first use) by family name and an
+ * optional label, which must only be done from the main thread; lookups are a
+ * linear search, so frequent updaters should keep the returned metric around.
+ * Updating a metric is just an atomic add, and may be done from any thread.
+ * Metrics are never freed.
+ */
+typedef struct _MMMetric MMMetric;
+
+/* Family names are given without the "_total" or "_seconds" suffixes */
+MMMetric *mm_metrics_counter   (const gchar *family,
+                                const gchar *help,
+                                const gchar *label_name,
+                                const gchar *label_value);
+MMMetric *mm_metrics_histogram (const gchar *family,
+                                const gchar *help,
+                                const gchar *label_name,
+                                const gchar *label_value);
+
+void mm_metric_inc     (MMMetric *metric);
+/* Histograms only; duration in microseconds */
+void mm_metric_observe (MMMetric *metric,
+                        gint64    duration);
+
+/* Builds the OpenMetrics text with all the registered metrics, plus the
+ * command statistics of the serial ports (as given by GetPortStats), the
+ * queue depth of each port (a{su}) and the number of log messages dropped */
+gchar *mm_metrics_build (GVariant *port_stats,
+                         GVariant *queue_depths,
+                         guint64   log_dropped);
+
+#endif /* MM_METRICS_H */
@@ -15,6 +15,7 @@
 
 #include "mm-modem-helpers-mbim.h"
 #include "mm-modem-helpers.h"
+#include "mm-string-pool.h"
 #include "mm-enums-types.h"
 #include "mm-errors-types.h"
 #include "mm-log.h"
@@ -162,9 +163,9 @@ mm_3gpp_network_info_list_from_mbim_providers (const MbimProvider *const *provid
 
         info = g_new0 (MM3gppNetworkInfo, 1);
         info->status = mm_modem_3gpp_network_availability_from_mbim_provider_state (providers[i]->provider_state);
-        info->operator_long = g_strdup (providers[i]->provider_name);
-        info->operator_short = g_strdup (providers[i]->provider_name);
-        info->operator_code = g_strdup (providers[i]->provider_id);
+        info->operator_long = mm_string_pool_ref (providers[i]->provider_name);
+        info->operator_short = mm_string_pool_ref (providers[i]->provider_name);
+        info->operator_code = mm_string_pool_ref (providers[i]->provider_id);
         info->access_tech = mm_modem_access_technology_from_mbim_data_class (providers[i]->cellular_class);
 
         info_list = g_list_append (info_list, info);
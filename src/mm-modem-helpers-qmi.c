@@ -150,6 +150,89 @@ mm_3gpp_facility_to_qmi_uim_facility (MMModem3gppFacility mm)
     }
 }
 
+/*****************************************************************************/
+/* Band mask lookups
+ *
+ * The maps below are the reference, but walking them linearly for each
+ * conversion is too expensive for something done on every NAS indication.
+ * Each map is turned, the first time it's used, into tables indexed by the
+ * bit position in the QMI mask and by the ModemManager band value, so that
+ * masks can be converted by iterating over their bits only.
+ */
+
+#define BANDS_LOOKUP_SIZE MM_MODEM_BAND_ANY
+
+typedef struct {
+    gboolean    initialized;
+    /* All QMI bits with a ModemManager counterpart */
+    guint64     expected;
+    /* Bit position in the QMI mask -> ModemManager band */
+    MMModemBand from_qmi[64];
+    /* ModemManager band -> QMI mask */
+    guint64     to_qmi[BANDS_LOOKUP_SIZE];
+} BandsLookup;
+
+static inline guint
+lowest_bit (guint64 mask)
+{
+    /* gulong may only be 32 bits wide */
+    if (mask & G_GUINT64_CONSTANT (0xFFFFFFFF))
+        return (guint) g_bit_nth_lsf ((gulong) (mask & G_GUINT64_CONSTANT (0xFFFFFFFF)), -1);
+    return 32 + (guint) g_bit_nth_lsf ((gulong) (mask >> 32), -1);
+}
+
+static void
+bands_lookup_add (BandsLookup *lookup,
+                  guint64 qmi_band,
+                  MMModemBand mm_band)
+{
+    g_assert (mm_band < BANDS_LOOKUP_SIZE);
+
+    /* The first match wins, as with the linear search over the map */
+    if (!lookup->to_qmi[mm_band])
+        lookup->to_qmi[mm_band] = qmi_band;
+
+    for (; qmi_band; qmi_band &= qmi_band - 1) {
+        guint bit;
+
+        bit = lowest_bit (qmi_band);
+        if (!(lookup->expected & (G_GUINT64_CONSTANT (1) << bit)))
+            lookup->from_qmi[bit] = mm_band;
+        lookup->expected |= (G_GUINT64_CONSTANT (1) << bit);
+    }
+}
+
+#define BANDS_LOOKUP_INIT(lookup, map) do {                                 \
+        guint _i;                                                           \
+                                                                            \
+        if (G_LIKELY ((lookup)->initialized))                               \
+            break;                                                          \
+        for (_i = 0; _i < G_N_ELEMENTS (map); _i++)                         \
+            bands_lookup_add ((lookup), (guint64) map[_i].qmi_band, map[_i].mm_band); \
+        (lookup)->initialized = TRUE;                                       \
+    } while (0)
+
+static void
+bands_lookup_append (const BandsLookup *lookup,
+                     GArray *mm_bands,
+                     guint64 qmi_bands)
+{
+    /* Several bits may map to the same band */
+    guint64 added[BANDS_LOOKUP_SIZE / 64] = { 0 };
+
+    g_assert (mm_bands != NULL);
+
+    for (qmi_bands &= lookup->expected; qmi_bands; qmi_bands &= qmi_bands - 1) {
+        MMModemBand band;
+
+        band = lookup->from_qmi[lowest_bit (qmi_bands)];
+        if (added[band / 64] & (G_GUINT64_CONSTANT (1) << (band % 64)))
+            continue;
+        added[band / 64] |= (G_GUINT64_CONSTANT (1) << (band % 64));
+        g_array_append_val (mm_bands, band);
+    }
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -218,38 +301,28 @@ static const DmsBandsMap dms_bands_map [] = {
      */
 };
 
+static BandsLookup dms_bands_lookup;
+
 static void
 dms_add_qmi_bands (GArray *mm_bands,
                    QmiDmsBandCapability qmi_bands)
 {
-    static QmiDmsBandCapability qmi_bands_expected = 0;
-    QmiDmsBandCapability not_expected;
-    guint i;
+    guint64 not_expected;
 
-    g_assert (mm_bands != NULL);
-
-    /* Build mask of expected bands only once */
-    if (G_UNLIKELY (qmi_bands_expected == 0)) {
-        for (i = 0; i < G_N_ELEMENTS (dms_bands_map); i++) {
-            qmi_bands_expected |= dms_bands_map[i].qmi_band;
-        }
-    }
+    BANDS_LOOKUP_INIT (&dms_bands_lookup, dms_bands_map);
 
     /* Log about the bands that cannot be represented in ModemManager */
-    not_expected = ((qmi_bands_expected ^ qmi_bands) & qmi_bands);
+    not_expected = ((guint64) qmi_bands & ~dms_bands_lookup.expected);
     if (not_expected) {
         gchar *aux;
 
-        aux = qmi_dms_band_capability_build_string_from_mask (not_expected);
+        aux = qmi_dms_band_capability_build_string_from_mask ((QmiDmsBandCapability) not_expected);
         mm_dbg ("Cannot add the following bands: '%s'", aux);
         g_free (aux);
     }
 
     /* And add the expected ones */
-    for (i = 0; i < G_N_ELEMENTS (dms_bands_map); i++) {
-        if (qmi_bands & dms_bands_map[i].qmi_band)
-            g_array_append_val (mm_bands, dms_bands_map[i].mm_band);
-    }
+    bands_lookup_append (&dms_bands_lookup, mm_bands, (guint64) qmi_bands);
 }
 
 typedef struct {
@@ -300,20 +373,16 @@ static const DmsLteBandsMap dms_lte_bands_map [] = {
      */
 };
 
+static BandsLookup dms_lte_bands_lookup;
+
 static void
 dms_add_qmi_lte_bands (GArray *mm_bands,
                        QmiDmsLteBandCapability qmi_bands)
 {
     /* All QMI LTE bands have a counterpart in ModemManager, no need to check
      * for unexpected ones */
-    guint i;
-
-    g_assert (mm_bands != NULL);
-
-    for (i = 0; i < G_N_ELEMENTS (dms_lte_bands_map); i++) {
-        if (qmi_bands & dms_lte_bands_map[i].qmi_band)
-            g_array_append_val (mm_bands, dms_lte_bands_map[i].mm_band);
-    }
+    BANDS_LOOKUP_INIT (&dms_lte_bands_lookup, dms_lte_bands_map);
+    bands_lookup_append (&dms_lte_bands_lookup, mm_bands, (guint64) qmi_bands);
 }
 
 GArray *
@@ -395,38 +464,28 @@ static const NasBandsMap nas_bands_map [] = {
      */
 };
 
+static BandsLookup nas_bands_lookup;
+
 static void
 nas_add_qmi_bands (GArray *mm_bands,
                    QmiNasBandPreference qmi_bands)
 {
-    static QmiNasBandPreference qmi_bands_expected = 0;
-    QmiNasBandPreference not_expected;
-    guint i;
-
-    g_assert (mm_bands != NULL);
+    guint64 not_expected;
 
-    /* Build mask of expected bands only once */
-    if (G_UNLIKELY (qmi_bands_expected == 0)) {
-        for (i = 0; i < G_N_ELEMENTS (nas_bands_map); i++) {
-            qmi_bands_expected |= nas_bands_map[i].qmi_band;
-        }
-    }
+    BANDS_LOOKUP_INIT (&nas_bands_lookup, nas_bands_map);
 
     /* Log about the bands that cannot be represented in ModemManager */
-    not_expected = ((qmi_bands_expected ^ qmi_bands) & qmi_bands);
+    not_expected = ((guint64) qmi_bands & ~nas_bands_lookup.expected);
     if (not_expected) {
         gchar *aux;
 
-        aux = qmi_nas_band_preference_build_string_from_mask (not_expected);
+        aux = qmi_nas_band_preference_build_string_from_mask ((QmiNasBandPreference) not_expected);
         mm_dbg ("Cannot add the following bands: '%s'", aux);
         g_free (aux);
     }
 
     /* And add the expected ones */
-    for (i = 0; i < G_N_ELEMENTS (nas_bands_map); i++) {
-        if (qmi_bands & nas_bands_map[i].qmi_band)
-            g_array_append_val (mm_bands, nas_bands_map[i].mm_band);
-    }
+    bands_lookup_append (&nas_bands_lookup, mm_bands, (guint64) qmi_bands);
 }
 
 typedef struct {
@@ -477,20 +536,16 @@ static const NasLteBandsMap nas_lte_bands_map [] = {
      */
 };
 
+static BandsLookup nas_lte_bands_lookup;
+
 static void
 nas_add_qmi_lte_bands (GArray *mm_bands,
                        QmiNasLteBandPreference qmi_bands)
 {
     /* All QMI LTE bands have a counterpart in ModemManager, no need to check
      * for unexpected ones */
-    guint i;
-
-    g_assert (mm_bands != NULL);
-
-    for (i = 0; i < G_N_ELEMENTS (nas_lte_bands_map); i++) {
-        if (qmi_bands & nas_lte_bands_map[i].qmi_band)
-            g_array_append_val (mm_bands, nas_lte_bands_map[i].mm_band);
-    }
+    BANDS_LOOKUP_INIT (&nas_lte_bands_lookup, nas_lte_bands_map);
+    bands_lookup_append (&nas_lte_bands_lookup, mm_bands, (guint64) qmi_bands);
 }
 
 GArray *
@@ -511,10 +566,12 @@ mm_modem_bands_to_qmi_band_preference (GArray *mm_bands,
                                        QmiNasBandPreference *qmi_bands,
                                        QmiNasLteBandPreference *qmi_lte_bands)
 {
+    guint64 bands = 0;
+    guint64 lte_bands = 0;
     guint i;
 
-    *qmi_bands = 0;
-    *qmi_lte_bands = 0;
+    BANDS_LOOKUP_INIT (&nas_bands_lookup, nas_bands_map);
+    BANDS_LOOKUP_INIT (&nas_lte_bands_lookup, nas_lte_bands_map);
 
     for (i = 0; i < mm_bands->len; i++) {
         MMModemBand band;
@@ -524,34 +581,23 @@ mm_modem_bands_to_qmi_band_preference (GArray *mm_bands,
         if (band <= MM_MODEM_BAND_EUTRAN_XLIV &&
             band >= MM_MODEM_BAND_EUTRAN_I) {
             /* Add LTE band preference */
-            guint j;
-
-            for (j = 0; j < G_N_ELEMENTS (nas_lte_bands_map); j++) {
-                if (nas_lte_bands_map[j].mm_band == band) {
-                    *qmi_lte_bands |= nas_lte_bands_map[j].qmi_band;
-                    break;
-                }
-            }
-
-            if (j == G_N_ELEMENTS (nas_lte_bands_map))
+            if (nas_lte_bands_lookup.to_qmi[band])
+                lte_bands |= nas_lte_bands_lookup.to_qmi[band];
+            else
                 mm_dbg ("Cannot add the following LTE band: '%s'",
                         mm_modem_band_get_string (band));
         } else {
             /* Add non-LTE band preference */
-            guint j;
-
-            for (j = 0; j < G_N_ELEMENTS (nas_bands_map); j++) {
-                if (nas_bands_map[j].mm_band == band) {
-                    *qmi_bands |= nas_bands_map[j].qmi_band;
-                    break;
-                }
-            }
-
-            if (j == G_N_ELEMENTS (nas_bands_map))
+            if (band < BANDS_LOOKUP_SIZE && nas_bands_lookup.to_qmi[band])
+                bands |= nas_bands_lookup.to_qmi[band];
+            else
                 mm_dbg ("Cannot add the following band: '%s'",
                         mm_modem_band_get_string (band));
         }
     }
+
+    *qmi_bands = (QmiNasBandPreference) bands;
+    *qmi_lte_bands = (QmiNasLteBandPreference) lte_bands;
 }
 
 /*****************************************************************************/
@@ -653,28 +699,53 @@ static const ActiveBandsMap active_bands_map [] = {
      */
 };
 
+/* Active bands are plain values, not masks; the table is indexed by value
+ * and unmatched entries are left as MM_MODEM_BAND_UNKNOWN */
+#define ACTIVE_BANDS_LOOKUP_SIZE 256
+
+static MMModemBand *
+get_active_bands_lookup (void)
+{
+    static MMModemBand lookup[ACTIVE_BANDS_LOOKUP_SIZE];
+    static gboolean initialized;
+    guint i;
+
+    if (G_LIKELY (initialized))
+        return lookup;
+
+    for (i = 0; i < G_N_ELEMENTS (active_bands_map); i++) {
+        g_assert ((guint) active_bands_map[i].qmi_band < ACTIVE_BANDS_LOOKUP_SIZE);
+        /* The first match wins, as with the linear search over the map */
+        if (lookup[active_bands_map[i].qmi_band] == MM_MODEM_BAND_UNKNOWN)
+            lookup[active_bands_map[i].qmi_band] = active_bands_map[i].mm_band;
+    }
+    initialized = TRUE;
+    return lookup;
+}
+
 static void
 add_active_bands (GArray *mm_bands,
                   QmiNasActiveBand qmi_bands)
 {
-    guint i;
+    MMModemBand band;
+    guint j;
 
     g_assert (mm_bands != NULL);
 
-    for (i = 0; i < G_N_ELEMENTS (active_bands_map); i++) {
-        if (qmi_bands == active_bands_map[i].qmi_band) {
-            guint j;
+    if ((guint) qmi_bands >= ACTIVE_BANDS_LOOKUP_SIZE)
+        return;
 
-            /* Avoid adding duplicate band entries */
-            for (j = 0; j < mm_bands->len; j++) {
-                if (g_array_index (mm_bands, MMModemBand, j) == active_bands_map[i].mm_band)
-                    return;
-            }
+    band = get_active_bands_lookup ()[qmi_bands];
+    if (band == MM_MODEM_BAND_UNKNOWN)
+        return;
 
-            g_array_append_val (mm_bands, active_bands_map[i].mm_band);
+    /* Avoid adding duplicate band entries */
+    for (j = 0; j < mm_bands->len; j++) {
+        if (g_array_index (mm_bands, MMModemBand, j) == band)
             return;
-        }
     }
+
+    g_array_append_val (mm_bands, band);
 }
 
 GArray *
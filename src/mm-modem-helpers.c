@@ -30,6 +30,8 @@
 
 #include "mm-sms-part.h"
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
+#include "mm-string-pool.h"
 #include "mm-log.h"
 
 /*****************************************************************************/
@@ -68,6 +70,285 @@ mm_strip_tag (const gchar *str, const gchar *cmd)
 
 /*****************************************************************************/
 
+#define IS_FIELD_SPACE(c) ((c) == ' ' || (c) == '\t')
+#define IS_LINE_END(c)    ((c) == '\0' || (c) == '\r' || (c) == '\n')
+
+static gboolean
+parse_number_field (const gchar *start,
+                    const gchar *end,
+                    MMAtFieldType type,
+                    gint64 *out)
+{
+    guint64 value = 0;
+    guint64 limit = G_MAXINT64;
+    gboolean negative = FALSE;
+    guint base;
+
+    if (type == MM_AT_FIELD_INT && (*start == '-' || *start == '+')) {
+        negative = (*start == '-');
+        start++;
+    }
+    if (start == end)
+        return FALSE;
+
+    base = (type == MM_AT_FIELD_HEX ? 16 : 10);
+    for (; start < end; start++) {
+        gint digit;
+
+        digit = (base == 16 ? g_ascii_xdigit_value (*start) : g_ascii_digit_value (*start));
+        if (digit < 0 || value > (limit - digit) / base)
+            return FALSE;
+        value = value * base + digit;
+    }
+
+    *out = (negative ? -(gint64) value : (gint64) value);
+    return TRUE;
+}
+
+gboolean
+mm_at_response_shape_parse (const MMAtResponseShape *shape,
+                            const gchar *response,
+                            MMAtResponseFields *fields,
+                            GError **error)
+{
+    const gchar *p;
+    guint i;
+
+    fields->present = 0;
+
+    p = (response ? response : "");
+    while (isspace (*p))
+        p++;
+
+    if (shape->tag) {
+        gsize tag_len;
+
+        tag_len = strlen (shape->tag);
+        if (!strncmp (p, shape->tag, tag_len))
+            p += tag_len;
+        else if (shape->tag_required) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Missing '%s' tag in response '%s'", shape->tag, response);
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < MM_AT_RESPONSE_SHAPE_MAX_FIELDS && shape->fields[i] != MM_AT_FIELD_END; i++) {
+        const gchar *start;
+        const gchar *end;
+        gboolean quoted = FALSE;
+
+        if (i > 0) {
+            if (*p != ',')
+                break;
+            p++;
+        }
+        while (IS_FIELD_SPACE (*p))
+            p++;
+
+        if (*p == '"') {
+            quoted = TRUE;
+            start = ++p;
+            while (*p != '"' && !IS_LINE_END (*p))
+                p++;
+            if (*p != '"') {
+                g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                             "Unterminated string in field #%u of response '%s'", i, response);
+                return FALSE;
+            }
+            end = p++;
+            while (IS_FIELD_SPACE (*p))
+                p++;
+        } else {
+            start = p;
+            while (*p != ',' && !IS_LINE_END (*p))
+                p++;
+            end = p;
+            while (end > start && IS_FIELD_SPACE (end[-1]))
+                end--;
+        }
+
+        /* Empty fields are given, but not present; except for empty strings */
+        if (start == end && !(quoted && shape->fields[i] == MM_AT_FIELD_STRING))
+            continue;
+
+        switch (shape->fields[i]) {
+        case MM_AT_FIELD_UINT:
+        case MM_AT_FIELD_INT:
+        case MM_AT_FIELD_HEX:
+            if (!parse_number_field (start, end, shape->fields[i], &fields->number[i])) {
+                g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                             "Invalid number in field #%u of response '%s'", i, response);
+                return FALSE;
+            }
+            break;
+        case MM_AT_FIELD_STRING:
+            fields->str[i] = start;
+            fields->str_len[i] = end - start;
+            break;
+        default:
+            break;
+        }
+        fields->present |= (1 << i);
+    }
+
+    /* Anything else must be more fields */
+    if (*p != ',' && !IS_LINE_END (*p)) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Unexpected contents after field #%u of response '%s'", i, response);
+        return FALSE;
+    }
+
+    for (i = 0; i < shape->n_required; i++) {
+        if (!(fields->present & (1 << i))) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Missing field #%u in response '%s'", i, response);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+gboolean
+mm_at_response_fields_get_uint (const MMAtResponseFields *fields,
+                                guint i,
+                                guint *value)
+{
+    if (!(fields->present & (1 << i)) ||
+        fields->number[i] < 0 ||
+        fields->number[i] > G_MAXUINT)
+        return FALSE;
+
+    *value = (guint) fields->number[i];
+    return TRUE;
+}
+
+gboolean
+mm_at_response_fields_get_int (const MMAtResponseFields *fields,
+                               guint i,
+                               gint *value)
+{
+    if (!(fields->present & (1 << i)) ||
+        fields->number[i] < G_MININT ||
+        fields->number[i] > G_MAXINT)
+        return FALSE;
+
+    *value = (gint) fields->number[i];
+    return TRUE;
+}
+
+gchar *
+mm_at_response_fields_dup_string (const MMAtResponseFields *fields,
+                                  guint i)
+{
+    if (!(fields->present & (1 << i)))
+        return NULL;
+
+    return g_strndup (fields->str[i], fields->str_len[i]);
+}
+
+/*****************************************************************************/
+
+static const gchar *
+at_command_skip_prefix (const gchar *command)
+{
+    return (g_ascii_strncasecmp (command, "AT", 2) == 0 ? command + 2 : command);
+}
+
+gsize
+mm_at_command_get_concatenable_name_length (const gchar *command)
+{
+    const gchar *str;
+    gsize len;
+
+    str = at_command_skip_prefix (command);
+    if (str[0] != '+' && str[0] != '^' && str[0] != '$' && str[0] != '%' && str[0] != '*')
+        return 0;
+
+    for (len = 1; g_ascii_isalnum (str[len]); len++);
+    if (len == 1)
+        return 0;
+
+    if (g_str_equal (&str[len], "?") || g_str_equal (&str[len], "=?"))
+        return len;
+
+    return 0;
+}
+
+gchar *
+mm_at_commands_concatenate (const gchar **commands,
+                            guint n_commands)
+{
+    GString *str;
+    guint i;
+
+    str = g_string_new ("");
+    for (i = 0; i < n_commands; i++) {
+        if (i > 0)
+            g_string_append_c (str, ';');
+        g_string_append (str, at_command_skip_prefix (commands[i]));
+    }
+    return g_string_free (str, FALSE);
+}
+
+gchar **
+mm_at_concatenated_response_split (const gchar *response,
+                                   const gchar **commands,
+                                   guint n_commands)
+{
+    GString **responses;
+    gchar **split;
+    gchar **lines;
+    guint i;
+
+    responses = g_new0 (GString *, n_commands);
+    for (i = 0; i < n_commands; i++)
+        responses[i] = g_string_new ("");
+
+    lines = g_strsplit_set (response ? response : "", "\r\n", -1);
+    for (i = 0; lines[i]; i++) {
+        gchar *line;
+        guint j;
+
+        line = g_strstrip (lines[i]);
+        if (!line[0])
+            continue;
+
+        for (j = 0; j < n_commands; j++) {
+            gsize name_len;
+
+            name_len = mm_at_command_get_concatenable_name_length (commands[j]);
+            if (name_len &&
+                g_ascii_strncasecmp (line, at_command_skip_prefix (commands[j]), name_len) == 0 &&
+                line[name_len] == ':')
+                break;
+        }
+        if (j == n_commands)
+            break;
+
+        /* Keep the same layout as when the command is sent alone */
+        g_string_append_printf (responses[j], "\r\n%s\r\n", line);
+    }
+
+    /* Some line could not be attributed */
+    if (lines[i]) {
+        for (i = 0; i < n_commands; i++)
+            g_string_free (responses[i], TRUE);
+        split = NULL;
+    } else {
+        split = g_new0 (gchar *, n_commands + 1);
+        for (i = 0; i < n_commands; i++)
+            split[i] = g_string_free (responses[i], FALSE);
+    }
+
+    g_strfreev (lines);
+    g_free (responses);
+    return split;
+}
+
+/*****************************************************************************/
+
 gchar **
 mm_split_string_groups (const gchar *str)
 {
@@ -309,6 +590,47 @@ mm_new_iso8601_time (guint year,
     return g_string_free (str, FALSE);
 }
 
+/* Parses the strings built by mm_new_iso8601_time(); if no offset is given,
+ * the time is assumed to be UTC */
+gboolean
+mm_parse_iso8601_time (const gchar *str,
+                       guint64 *unix_time)
+{
+    guint year, month, day, hour, minute, second;
+    guint offset_hours = 0, offset_minutes = 0;
+    gchar sign = '+';
+    gint n;
+    gint64 value;
+    GDateTime *dt;
+
+    if (!str)
+        return FALSE;
+
+    n = sscanf (str, "%4u-%2u-%2uT%2u:%2u:%2u%c%2u:%2u",
+                &year, &month, &day, &hour, &minute, &second,
+                &sign, &offset_hours, &offset_minutes);
+    if (n != 6 && n != 8 && n != 9)
+        return FALSE;
+    if (n > 6 && sign != '+' && sign != '-')
+        return FALSE;
+
+    dt = g_date_time_new_utc (year, month, day, hour, minute, second);
+    if (!dt)
+        return FALSE;
+    value = g_date_time_to_unix (dt);
+    g_date_time_unref (dt);
+
+    if (sign == '+')
+        value -= (offset_hours * 60 + offset_minutes) * 60;
+    else
+        value += (offset_hours * 60 + offset_minutes) * 60;
+    if (value < 0)
+        return FALSE;
+
+    *unix_time = (guint64) value;
+    return TRUE;
+}
+
 /*****************************************************************************/
 
 GArray *
@@ -386,16 +708,108 @@ mm_filter_supported_capabilities (MMModemCapability all,
 
 /*****************************************************************************/
 
+static const guint standard_baudrates[] = {
+    300, 600, 1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400,
+    460800, 500000, 576000, 921600, 1000000, 1152000, 1500000, 2000000,
+    2500000, 3000000, 3500000, 4000000
+};
+
+static gint
+uint_compare_func (gconstpointer a,
+                   gconstpointer b)
+{
+    guint val_a = *((const guint *) a);
+    guint val_b = *((const guint *) b);
+
+    return (val_a > val_b) - (val_a < val_b);
+}
+
+static void
+ipr_add_rate (GArray *rates,
+              guint rate)
+{
+    guint i;
+
+    for (i = 0; i < rates->len; i++) {
+        if (g_array_index (rates, guint, i) == rate)
+            return;
+    }
+    g_array_append_val (rates, rate);
+}
+
+GArray *
+mm_parse_ipr_test_response (const gchar *reply,
+                            GError **error)
+{
+    GArray *rates;
+    gchar **groups;
+    guint i;
+
+    /* Expected reply format is a list of autodetectable rates, optionally
+     * followed by a list of fixed-only rates; either may give ranges:
+     *   +IPR: (0,300,600,1200,2400,4800,9600,19200,38400,57600,115200),(230400,460800,921600)
+     *   +IPR: (0),(300-921600)
+     */
+    reply = mm_strip_tag (reply, "+IPR:");
+    groups = mm_split_string_groups (reply);
+    rates = g_array_new (FALSE, FALSE, sizeof (guint));
+
+    for (i = 0; groups && groups[i]; i++) {
+        gchar **items;
+        guint j;
+
+        items = g_strsplit (groups[i], ",", -1);
+        for (j = 0; items[j]; j++) {
+            gchar *separator;
+            guint min;
+            guint max;
+
+            g_strstrip (items[j]);
+            separator = strchr (items[j], '-');
+            if (separator) {
+                guint k;
+
+                *separator = '\0';
+                if (!mm_get_uint_from_str (items[j], &min) ||
+                    !mm_get_uint_from_str (separator + 1, &max))
+                    continue;
+                for (k = 0; k < G_N_ELEMENTS (standard_baudrates); k++) {
+                    if (standard_baudrates[k] >= min && standard_baudrates[k] <= max)
+                        ipr_add_rate (rates, standard_baudrates[k]);
+                }
+            } else if (mm_get_uint_from_str (items[j], &min) && min > 0) {
+                /* 0 means autobauding, not a rate */
+                ipr_add_rate (rates, min);
+            }
+        }
+        g_strfreev (items);
+    }
+    g_strfreev (groups);
+
+    if (rates->len == 0) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_FAILED,
+                     "Couldn't parse supported baudrates: response didn't match (%s)",
+                     reply);
+        g_array_unref (rates);
+        return NULL;
+    }
+
+    g_array_sort (rates, uint_compare_func);
+    return rates;
+}
+
+/*****************************************************************************/
+
 GRegex *
 mm_voice_ring_regex_get (void)
 {
     /* Example:
      * <CR><LF>RING<CR><LF>
      */
-    return g_regex_new ("\\r\\nRING\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\nRING\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 GRegex *
@@ -405,10 +819,8 @@ mm_voice_cring_regex_get (void)
      * <CR><LF>+CRING: VOICE<CR><LF>
      * <CR><LF>+CRING: DATA<CR><LF>
      */
-    return g_regex_new ("\\r\\n\\+CRING:\\s*(\\S+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CRING:\\s*(\\S+)\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 GRegex *
@@ -418,166 +830,20 @@ mm_voice_clip_regex_get (void)
      * <CR><LF>+CLIP: "+393351391306",145,,,,0<CR><LF>
      *                 \_ Number      \_ Type \_ Validity
      */
-    return g_regex_new ("\\r\\n\\+CLIP:\\s*(\\S+),\\s*(\\d+),\\s*,\\s*,\\s*,\\s*(\\d+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CLIP:\\s*(\\S+),\\s*(\\d+),\\s*,\\s*,\\s*,\\s*(\\d+)\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 /*************************************************************************/
 
-/* +CREG: <stat>                      (GSM 07.07 CREG=1 unsolicited) */
-#define CREG1 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>                  (GSM 07.07 CREG=1 solicited) */
-#define CREG2 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])"
-
-/* +CREG: <stat>,<lac>,<ci>           (GSM 07.07 CREG=2 unsolicited) */
-#define CREG3 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)"
-#define CREG11 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*(\"[^\"\\s]*\")\\s*,\\s*(\"[^\"\\s]*\")"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>       (GSM 07.07 solicited and some CREG=2 unsolicited) */
-#define CREG4 "\\+(CREG|CGREG|CEREG):\\s*([0-9]),\\s*([0-9])\\s*,\\s*([^,]*)\\s*,\\s*([^,\\s]*)"
-#define CREG5 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*(\"[^,]*\")\\s*,\\s*(\"[^,\\s]*\")"
-
-/* +CREG: <stat>,<lac>,<ci>,<AcT>     (ETSI 27.007 CREG=2 unsolicited) */
-#define CREG6 "\\+(CREG|CGREG|CEREG):\\s*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([0-9])"
-#define CREG7 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9])\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*(\"[^,\\s]*\")\\s*,\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>,<AcT> (ETSI 27.007 solicited and some CREG=2 unsolicited) */
-#define CREG8 "\\+(CREG|CGREG|CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-/* +CREG: <n>,<stat>,<lac>,<ci>,<AcT?>,<something> (Samsung Wave S8500) */
-/* '<CR><LF>+CREG: 2,1,000B,2816, B, C2816<CR><LF><CR><LF>OK<CR><LF>' */
-#define CREG9 "\\+(CREG|CGREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*[^,\\s]*"
-
-/* +CREG: <stat>,<lac>,<ci>,<AcT>,<RAC> (ETSI 27.007 v9.20 CREG=2 unsolicited with RAC) */
-#define CREG10 "\\+(CREG|CGREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])\\s*,\\s*([^,\\s]*)"
-
-/* +CEREG: <stat>,<lac>,<rac>,<ci>,<AcT>     (ETSI 27.007 v8.6 CREG=2 unsolicited with RAC) */
-#define CEREG1 "\\+(CEREG):\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-/* +CEREG: <n>,<stat>,<lac>,<rac>,<ci>,<AcT> (ETSI 27.007 v8.6 CREG=2 solicited with RAC) */
-#define CEREG2 "\\+(CEREG):\\s*0*([0-9]),\\s*0*([0-9])\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*([^,\\s]*)\\s*,\\s*0*([0-9])"
-
-GPtrArray *
-mm_3gpp_creg_regex_get (gboolean solicited)
-{
-    GPtrArray *array = g_ptr_array_sized_new (13);
-    GRegex *regex;
-
-    /* #1 */
-    if (solicited)
-        regex = g_regex_new (CREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #2 */
-    if (solicited)
-        regex = g_regex_new (CREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #3 */
-    if (solicited)
-        regex = g_regex_new (CREG3 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG3 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #4 */
-    if (solicited)
-        regex = g_regex_new (CREG4 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG4 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #5 */
-    if (solicited)
-        regex = g_regex_new (CREG5 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG5 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #6 */
-    if (solicited)
-        regex = g_regex_new (CREG6 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG6 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #7 */
-    if (solicited)
-        regex = g_regex_new (CREG7 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG7 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #8 */
-    if (solicited)
-        regex = g_regex_new (CREG8 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG8 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #9 */
-    if (solicited)
-        regex = g_regex_new (CREG9 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG9 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #10 */
-    if (solicited)
-        regex = g_regex_new (CREG10 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG10 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* #11 */
-    if (solicited)
-        regex = g_regex_new (CREG11 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CREG11 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* CEREG #1 */
-    if (solicited)
-        regex = g_regex_new (CEREG1 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CEREG1 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    /* CEREG #2 */
-    if (solicited)
-        regex = g_regex_new (CEREG2 "$", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    else
-        regex = g_regex_new ("\\r\\n" CEREG2 "\\r\\n", G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
-    g_assert (regex);
-    g_ptr_array_add (array, regex);
-
-    return array;
-}
-
-void
-mm_3gpp_creg_regex_destroy (GPtrArray *array)
+GRegex *
+mm_3gpp_creg_regex_get (void)
 {
-    g_ptr_array_foreach (array, (GFunc) g_regex_unref, NULL);
-    g_ptr_array_free (array, TRUE);
+    /* A single handler for all +CREG, +CGREG and +CEREG forms; the fields are
+     * then split by mm_3gpp_parse_creg_response(). The leading digit keeps
+     * test responses like '+CREG: (0-2)' out. */
+    return mm_regex_registry_get ("\\r\\n(\\+C[GE]?REG:\\s*[0-9][^\\r\\n]*)\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 /*************************************************************************/
@@ -585,10 +851,8 @@ mm_3gpp_creg_regex_destroy (GPtrArray *array)
 GRegex *
 mm_3gpp_ciev_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CIEV: (.*),(\\d)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CIEV: (.*),(\\d)\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 /*************************************************************************/
@@ -596,10 +860,8 @@ mm_3gpp_ciev_regex_get (void)
 GRegex *
 mm_3gpp_cusd_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CUSD:\\s*(.*)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CUSD:\\s*(.*)\\r\\n",
+                                  G_REGEX_RAW);
 }
 
 /*************************************************************************/
@@ -607,10 +869,18 @@ mm_3gpp_cusd_regex_get (void)
 GRegex *
 mm_3gpp_cmti_regex_get (void)
 {
-    return g_regex_new ("\\r\\n\\+CMTI:\\s*\"(\\S+)\",\\s*(\\d+)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CMTI:\\s*\"(\\S+)\",\\s*(\\d+)\\r\\n",
+                                  G_REGEX_RAW);
+}
+
+/* Matches each complete record of a +CMGL PDU listing, so that the parts can
+ * be processed while the listing is still being received. The trailing line
+ * terminator is left in the buffer, as the next record starts with it. */
+GRegex *
+mm_3gpp_cmgl_pdu_regex_get (void)
+{
+    return mm_regex_registry_get ("\\r\\n\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,[^\\r\\n]*\\r\\n([0-9A-Fa-f]+)(?=\\r\\n)",
+                                  G_REGEX_RAW);
 }
 
 GRegex *
@@ -619,10 +889,50 @@ mm_3gpp_cds_regex_get (void)
     /* Example:
      * <CR><LF>+CDS: 24<CR><LF>07914356060013F10659098136395339F6219011707193802190117071938030<CR><LF>
      */
-    return g_regex_new ("\\r\\n\\+CDS:\\s*(\\d+)\\r\\n(.*)\\r\\n",
-                        G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                        0,
-                        NULL);
+    return mm_regex_registry_get ("\\r\\n\\+CDS:\\s*(\\d+)\\r\\n(.*)\\r\\n",
+                                  G_REGEX_RAW);
+}
+
+GRegex *
+mm_3gpp_cmt_regex_get (void)
+{
+    /* PDU mode only, with or without alpha. Example:
+     * <CR><LF>+CMT: ,24<CR><LF>07914356060013F1040A9181...<CR><LF>
+     */
+    return mm_regex_registry_get ("\\r\\n\\+CMT:\\s*(?:\"[^\"]*\"|[^,\\r\\n]*),\\s*(\\d+)\\r\\n([0-9A-Fa-f]+)\\r\\n",
+                                  G_REGEX_RAW);
+}
+
+GRegex *
+mm_3gpp_ctz_regex_get (void)
+{
+    /* Examples:
+     * <CR><LF>+CTZV: +8<CR><LF>
+     * <CR><LF>+CTZE: "+8",1,"2015/02/28,20:30:40"<CR><LF>
+     */
+    return mm_regex_registry_get ("\\r\\n\\+CTZ[EV]:\\s*\"?([-+]?\\d+)\"?(?:,\\s*(\\d+))?[^\\r\\n]*\\r\\n",
+                                  G_REGEX_RAW);
+}
+
+MMNetworkTimezone *
+mm_3gpp_parse_ctz_match (GMatchInfo *match_info)
+{
+    MMNetworkTimezone *tz;
+    gint offset;
+    guint dst;
+
+    /* Timezone offset, in quarters of an hour */
+    if (!mm_get_int_from_match_info (match_info, 1, &offset))
+        return NULL;
+
+    tz = mm_network_timezone_new ();
+    mm_network_timezone_set_offset (tz, offset * 15);
+
+    /* Daylight saving time adjustment, in hours; only in +CTZE */
+    if (mm_get_uint_from_match_info (match_info, 2, &dst))
+        mm_network_timezone_set_dst_offset (tz, dst * 60);
+
+    return tz;
 }
 
 /*************************************************************************/
@@ -630,9 +940,9 @@ mm_3gpp_cds_regex_get (void)
 static void
 mm_3gpp_network_info_free (MM3gppNetworkInfo *info)
 {
-    g_free (info->operator_long);
-    g_free (info->operator_short);
-    g_free (info->operator_code);
+    mm_string_pool_unref (info->operator_long);
+    mm_string_pool_unref (info->operator_short);
+    mm_string_pool_unref (info->operator_code);
     g_free (info);
 }
 
@@ -735,7 +1045,7 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
      *       +COPS: (2,"","T-Mobile","31026",0),(1,"AT&T","AT&T","310410"),0)
      */
 
-    r = g_regex_new ("\\((\\d),\"([^\"\\)]*)\",([^,\\)]*),([^,\\)]*)[\\)]?,(\\d)\\)", G_REGEX_UNGREEDY, 0, &inner_error);
+    r = mm_regex_registry_get ("\\((\\d),\"([^\"\\)]*)\",([^,\\)]*),([^,\\)]*)[\\)]?,(\\d)\\)", G_REGEX_UNGREEDY);
     if (inner_error) {
         mm_err ("Invalid regular expression: %s", inner_error->message);
         g_error_free (inner_error);
@@ -764,7 +1074,7 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
          *       +COPS: (2,"T - Mobile",,"31026"),(1,"Einstein PCS",,"31064"),(1,"Cingular",,"31041"),,(0,1,3),(0,2)
          */
 
-        r = g_regex_new ("\\((\\d),([^,\\)]*),([^,\\)]*),([^\\)]*)\\)", G_REGEX_UNGREEDY, 0, &inner_error);
+        r = mm_regex_registry_get ("\\((\\d),([^,\\)]*),([^,\\)]*),([^\\)]*)\\)", G_REGEX_UNGREEDY);
         if (inner_error) {
             mm_err ("Invalid regular expression: %s", inner_error->message);
             g_error_free (inner_error);
@@ -790,9 +1100,9 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
         info->status = parse_network_status (tmp);
         g_free (tmp);
 
-        info->operator_long = mm_get_string_unquoted_from_match_info (match_info, 2);
-        info->operator_short = mm_get_string_unquoted_from_match_info (match_info, 3);
-        info->operator_code = mm_get_string_unquoted_from_match_info (match_info, 4);
+        info->operator_long = mm_string_pool_take (mm_get_string_unquoted_from_match_info (match_info, 2));
+        info->operator_short = mm_string_pool_take (mm_get_string_unquoted_from_match_info (match_info, 3));
+        info->operator_code = mm_string_pool_take (mm_get_string_unquoted_from_match_info (match_info, 4));
 
         /* Only try for access technology with UMTS-format matches.
          * If none give, assume GSM */
@@ -810,14 +1120,14 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
          * but there's no good way to ignore it.
          */
         if (info->operator_code && (strlen (info->operator_code) >= 5)) {
+            const gchar *p;
+
             valid = TRUE;
-            tmp = info->operator_code;
-            while (*tmp) {
-                if (!isdigit (*tmp) && (*tmp != '-')) {
+            for (p = info->operator_code; *p; p++) {
+                if (!isdigit (*p) && (*p != '-')) {
                     valid = FALSE;
                     break;
                 }
-                tmp++;
             }
         }
 
@@ -847,6 +1157,70 @@ mm_3gpp_parse_cops_test_response (const gchar *reply,
     return info_list;
 }
 
+GList *
+mm_3gpp_parse_cops_test_partial_response (const gchar *partial,
+                                          guint *n_groups)
+{
+    const gchar *p;
+    const gchar *group_start = NULL;
+    GList *info_list = NULL;
+    gboolean in_quotes = FALSE;
+    guint depth = 0;
+    guint n = 0;
+
+    g_return_val_if_fail (partial != NULL, NULL);
+    g_return_val_if_fail (n_groups != NULL, NULL);
+
+    p = strstr (partial, "+COPS:");
+    if (!p)
+        return NULL;
+
+    for (p += 6; *p; p++) {
+        if (in_quotes) {
+            if (*p == '"')
+                in_quotes = FALSE;
+            continue;
+        }
+
+        switch (*p) {
+        case '"':
+            in_quotes = TRUE;
+            break;
+        case '(':
+            if (depth++ == 0)
+                group_start = p;
+            break;
+        case ')':
+            /* Stray ones (e.g. TM-506) are ignored */
+            if (depth == 0 || --depth > 0)
+                break;
+            /* Parse each group only once it's complete, and only if it
+             * wasn't already reported */
+            if (n++ >= *n_groups) {
+                gchar *group;
+
+                group = g_strdup_printf ("+COPS: %.*s", (gint) (p - group_start + 1), group_start);
+                info_list = g_list_concat (info_list, mm_3gpp_parse_cops_test_response (group, NULL));
+                g_free (group);
+            }
+            break;
+        case ',':
+            /* An empty field ends the list of networks; the supported modes
+             * and formats come after it */
+            if (depth == 0 && *(p + 1) == ',') {
+                *n_groups = n;
+                return info_list;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    *n_groups = n;
+    return info_list;
+}
+
 /*************************************************************************/
 
 
@@ -876,9 +1250,8 @@ mm_3gpp_parse_cgdcont_test_response (const gchar *response,
         return NULL;
     }
 
-    r = g_regex_new ("\\+CGDCONT:\\s*\\(\\s*(\\d+)\\s*-?\\s*(\\d+)?[^\\)]*\\)\\s*,\\s*\\(?\"(\\S+)\"",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, &inner_error);
+    r = mm_regex_registry_get ("\\+CGDCONT:\\s*\\(\\s*(\\d+)\\s*-?\\s*(\\d+)?[^\\)]*\\)\\s*,\\s*\\(?\"(\\S+)\"",
+                               G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
     g_assert (r != NULL);
 
     g_regex_match_full (r, response, strlen (response), 0, 0, &match_info, &inner_error);
@@ -964,9 +1337,8 @@ mm_3gpp_parse_cgdcont_read_response (const gchar *reply,
         return NULL;
 
     list = NULL;
-    r = g_regex_new ("\\+CGDCONT:\\s*(\\d+)\\s*,([^, \\)]*)\\s*,([^, \\)]*)\\s*,([^, \\)]*)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, &inner_error);
+    r = mm_regex_registry_get ("\\+CGDCONT:\\s*(\\d+)\\s*,([^, \\)]*)\\s*,([^, \\)]*)\\s*,([^, \\)]*)",
+                               G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
     if (r) {
         g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
 
@@ -1018,6 +1390,195 @@ mm_3gpp_parse_cgdcont_read_response (const gchar *reply,
 
 /*************************************************************************/
 
+static void
+mm_3gpp_pdp_context_active_free (MM3gppPdpContextActive *pdp_active)
+{
+    g_slice_free (MM3gppPdpContextActive, pdp_active);
+}
+
+void
+mm_3gpp_pdp_context_active_list_free (GList *pdp_active_list)
+{
+    g_list_free_full (pdp_active_list, (GDestroyNotify) mm_3gpp_pdp_context_active_free);
+}
+
+static gint
+mm_3gpp_pdp_context_active_cmp (MM3gppPdpContextActive *a,
+                                MM3gppPdpContextActive *b)
+{
+    return (a->cid - b->cid);
+}
+
+GList *
+mm_3gpp_parse_cgact_read_response (const gchar *reply,
+                                   GError **error)
+{
+    GError *inner_error = NULL;
+    GRegex *r;
+    GMatchInfo *match_info;
+    GList *list;
+
+    if (!reply || !reply[0])
+        /* Nothing configured, all done */
+        return NULL;
+
+    list = NULL;
+    r = mm_regex_registry_get ("\\+CGACT:\\s*(\\d+)\\s*,\\s*(\\d+)",
+                               G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
+    if (r) {
+        g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
+
+        while (!inner_error &&
+               g_match_info_matches (match_info)) {
+            MM3gppPdpContextActive *pdp_active;
+            guint aux = 0;
+
+            pdp_active = g_slice_new0 (MM3gppPdpContextActive);
+            if (!mm_get_uint_from_match_info (match_info, 1, &pdp_active->cid)) {
+                inner_error = g_error_new (MM_CORE_ERROR,
+                                           MM_CORE_ERROR_FAILED,
+                                           "Couldn't parse CID from reply: '%s'",
+                                           reply);
+                mm_3gpp_pdp_context_active_free (pdp_active);
+                break;
+            }
+            if (!mm_get_uint_from_match_info (match_info, 2, &aux) || (aux != 0 && aux != 1)) {
+                inner_error = g_error_new (MM_CORE_ERROR,
+                                           MM_CORE_ERROR_FAILED,
+                                           "Couldn't parse context status from reply: '%s'",
+                                           reply);
+                mm_3gpp_pdp_context_active_free (pdp_active);
+                break;
+            }
+            pdp_active->active = (gboolean) aux;
+
+            list = g_list_prepend (list, pdp_active);
+            g_match_info_next (match_info, &inner_error);
+        }
+
+        g_match_info_free (match_info);
+        g_regex_unref (r);
+    }
+
+    if (inner_error) {
+        mm_3gpp_pdp_context_active_list_free (list);
+        g_propagate_error (error, inner_error);
+        g_prefix_error (error, "Couldn't properly parse list of active/inactive PDP contexts. ");
+        return NULL;
+    }
+
+    list = g_list_sort (list, (GCompareFunc)mm_3gpp_pdp_context_active_cmp);
+
+    return list;
+}
+
+/*************************************************************************/
+
+static void
+mm_3gpp_call_info_free (MMCallInfo *call_info)
+{
+    g_free (call_info->number);
+    g_slice_free (MMCallInfo, call_info);
+}
+
+void
+mm_3gpp_call_info_list_free (GList *call_info_list)
+{
+    g_list_free_full (call_info_list, (GDestroyNotify) mm_3gpp_call_info_free);
+}
+
+static gint
+mm_3gpp_call_info_cmp (MMCallInfo *a,
+                       MMCallInfo *b)
+{
+    return (a->index - b->index);
+}
+
+gboolean
+mm_3gpp_parse_clcc_response (const gchar *reply,
+                             GList **out_list,
+                             GError **error)
+{
+    /* <stat> values, 3GPP TS 27.007 section 7.18 */
+    static const MMCallState call_states[] = {
+        MM_CALL_STATE_ACTIVE,
+        MM_CALL_STATE_HELD,
+        MM_CALL_STATE_DIALING,
+        MM_CALL_STATE_RINGING_OUT,
+        MM_CALL_STATE_RINGING_IN,
+        MM_CALL_STATE_WAITING,
+    };
+    GError *inner_error = NULL;
+    GRegex *r;
+    GMatchInfo *match_info;
+    GList *list = NULL;
+
+    g_assert (out_list);
+
+    /* No calls, all done */
+    if (!reply || !reply[0]) {
+        *out_list = NULL;
+        return TRUE;
+    }
+
+    /* +CLCC: <id>,<dir>,<stat>,<mode>,<mpty>[,<number>,<type>[,...]] */
+    r = mm_regex_registry_get ("\\+CLCC:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*(\\d+)"
+                               "(?:\\s*,\\s*\"([^\"]*)\")?",
+                               G_REGEX_RAW);
+    g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &inner_error);
+    while (!inner_error && g_match_info_matches (match_info)) {
+        MMCallInfo *call_info;
+        guint dir;
+        guint stat;
+        guint mode;
+
+        call_info = g_slice_new0 (MMCallInfo);
+        if (!mm_get_uint_from_match_info (match_info, 1, &call_info->index) ||
+            !call_info->index ||
+            !mm_get_uint_from_match_info (match_info, 2, &dir) || dir > 1 ||
+            !mm_get_uint_from_match_info (match_info, 3, &stat) || stat >= G_N_ELEMENTS (call_states) ||
+            !mm_get_uint_from_match_info (match_info, 4, &mode)) {
+            inner_error = g_error_new (MM_CORE_ERROR,
+                                       MM_CORE_ERROR_FAILED,
+                                       "Couldn't parse call from reply: '%s'",
+                                       reply);
+            mm_3gpp_call_info_free (call_info);
+            break;
+        }
+
+        /* Only voice calls */
+        if (mode != 0) {
+            mm_3gpp_call_info_free (call_info);
+            g_match_info_next (match_info, &inner_error);
+            continue;
+        }
+
+        call_info->direction = (dir == 0 ? MM_CALL_DIRECTION_OUTGOING : MM_CALL_DIRECTION_INCOMING);
+        call_info->state = call_states[stat];
+        call_info->number = g_match_info_fetch (match_info, 6);
+        if (call_info->number && !call_info->number[0])
+            g_clear_pointer (&call_info->number, g_free);
+
+        list = g_list_prepend (list, call_info);
+        g_match_info_next (match_info, &inner_error);
+    }
+
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+
+    if (inner_error) {
+        mm_3gpp_call_info_list_free (list);
+        g_propagate_error (error, inner_error);
+        g_prefix_error (error, "Couldn't properly parse list of current calls. ");
+        return FALSE;
+    }
+
+    *out_list = g_list_sort (list, (GCompareFunc)mm_3gpp_call_info_cmp);
+    return TRUE;
+}
+
+/*************************************************************************/
+
 static gulong
 parse_uint (char *str, int base, glong nmin, glong nmax, gboolean *valid)
 {
@@ -1043,22 +1604,28 @@ parse_uint (char *str, int base, glong nmin, glong nmax, gboolean *valid)
     return *valid ? (guint) ret : 0;
 }
 
+/* A <stat> is always a single digit, without quotes, although some modems
+ * (e.g. Iridium) zero-pad it; a <lac> is either quoted or given as 4 hex
+ * digits */
 static gboolean
-item_is_lac_not_stat (GMatchInfo *info, guint32 item)
+creg_field_is_lac_not_stat (const gchar *field)
 {
-    gchar *str;
-    gboolean is_lac = FALSE;
+    const gchar *p;
 
-    /* A <stat> will always be a single digit, without quotes */
-    str = g_match_info_fetch (info, item);
-    g_assert (str);
-    is_lac = (strchr (str, '"') || strlen (str) > 1);
-    g_free (str);
-    return is_lac;
+    if (strlen (field) > 3)
+        return TRUE;
+    for (p = field; *p; p++) {
+        if (!g_ascii_isdigit (*p))
+            return TRUE;
+    }
+    return (strtol (field, NULL, 10) > 9);
 }
 
+/* +CREG, +CGREG and +CEREG carry at most <n>,<stat>,<lac>,<rac>,<ci>,<AcT> */
+#define CREG_MAX_FIELDS 6
+
 gboolean
-mm_3gpp_parse_creg_response (GMatchInfo *info,
+mm_3gpp_parse_creg_response (const gchar *reply,
                              MMModem3gppRegistrationState *out_reg_state,
                              gulong *out_lac,
                              gulong *out_ci,
@@ -1068,12 +1635,18 @@ mm_3gpp_parse_creg_response (GMatchInfo *info,
                              GError **error)
 {
     gboolean success = FALSE, foo;
-    gint n_matches, act = -1;
+    gint act = -1;
     gulong stat = 0, lac = 0, ci = 0;
-    guint istat = 0, ilac = 0, ici = 0, iact = 0;
-    gchar *str;
+    gint istat = -1, ilac = -1, ici = -1, iact = -1;
+    gchar *fields[CREG_MAX_FIELDS];
+    guint n_fields = 0;
+    guint i;
+    gboolean in_quotes = FALSE;
+    const gchar *p;
+    gchar *line;
+    gchar *q;
 
-    g_return_val_if_fail (info != NULL, FALSE);
+    g_return_val_if_fail (reply != NULL, FALSE);
     g_return_val_if_fail (out_reg_state != NULL, FALSE);
     g_return_val_if_fail (out_lac != NULL, FALSE);
     g_return_val_if_fail (out_ci != NULL, FALSE);
@@ -1081,122 +1654,162 @@ mm_3gpp_parse_creg_response (GMatchInfo *info,
     g_return_val_if_fail (out_cgreg != NULL, FALSE);
     g_return_val_if_fail (out_cereg != NULL, FALSE);
 
-    str = g_match_info_fetch (info, 1);
-    *out_cgreg = (str && strstr (str, "CGREG")) ? TRUE : FALSE;
-    *out_cereg = (str && strstr (str, "CEREG")) ? TRUE : FALSE;
-    g_free (str);
+    *out_cgreg = FALSE;
+    *out_cereg = FALSE;
 
-    /* Normally the number of matches could be used to determine what each
-     * item is, but we have overlap in one case.
-     */
-    n_matches = g_match_info_get_match_count (info);
-    if (n_matches == 3) {
+    /* Look for the first message, skipping any leading garbage */
+    for (p = strchr (reply, '+'); p; p = strchr (p + 1, '+')) {
+        if (g_str_has_prefix (p, "+CREG:")) {
+            p += 6;
+            break;
+        }
+        if (g_str_has_prefix (p, "+CGREG:")) {
+            *out_cgreg = TRUE;
+            p += 7;
+            break;
+        }
+        if (g_str_has_prefix (p, "+CEREG:")) {
+            *out_cereg = TRUE;
+            p += 7;
+            break;
+        }
+    }
+
+    if (!p) {
+        g_set_error (error,
+                     MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Not a registration status response: '%s'",
+                     reply);
+        return FALSE;
+    }
+
+    /* Split the line in fields; commas within quotes don't separate fields,
+     * e.g. Thuraya reports the CI as "F0,0F" */
+    line = g_strndup (p, strcspn (p, "\r\n"));
+    fields[n_fields++] = line;
+    for (q = line; *q; q++) {
+        if (*q == '"')
+            in_quotes = !in_quotes;
+        else if (*q == ',' && !in_quotes) {
+            if (n_fields == CREG_MAX_FIELDS) {
+                g_set_error (error,
+                             MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                             "Too many fields in registration status response: '%s'",
+                             reply);
+                g_free (line);
+                return FALSE;
+            }
+            *q = '\0';
+            fields[n_fields++] = q + 1;
+        }
+    }
+    for (i = 0; i < n_fields; i++)
+        fields[i] = g_strstrip (fields[i]);
+
+    /* The number of fields tells which form we got, except for the cases
+     * where the second field may be either <stat> or <lac> */
+    switch (n_fields) {
+    case 1:
         /* CREG=1: +CREG: <stat> */
-        istat = 2;
-    } else if (n_matches == 4) {
+        istat = 0;
+        break;
+    case 2:
         /* Solicited response: +CREG: <n>,<stat> */
-        istat = 3;
-    } else if (n_matches == 5) {
+        istat = 1;
+        break;
+    case 3:
         /* CREG=2 (GSM 07.07): +CREG: <stat>,<lac>,<ci> */
-        istat = 2;
-        ilac = 3;
-        ici = 4;
-    } else if (n_matches == 6) {
+        istat = 0;
+        ilac = 1;
+        ici = 2;
+        break;
+    case 4:
         /* CREG=2 (ETSI 27.007): +CREG: <stat>,<lac>,<ci>,<AcT>
          * CREG=2 (non-standard): +CREG: <n>,<stat>,<lac>,<ci>
          */
-
-        /* Check if the third item is the LAC to distinguish the two cases */
-        if (item_is_lac_not_stat (info, 3)) {
-            istat = 2;
-            ilac = 3;
-            ici = 4;
-            iact = 5;
+        if (creg_field_is_lac_not_stat (fields[1])) {
+            istat = 0;
+            ilac = 1;
+            ici = 2;
+            iact = 3;
         } else {
-            istat = 3;
-            ilac = 4;
-            ici = 5;
+            istat = 1;
+            ilac = 2;
+            ici = 3;
         }
-    } else if (n_matches == 7) {
-        /* CREG=2 (solicited):            +CREG: <n>,<stat>,<lac>,<ci>,<AcT>
-         * CREG=2 (unsolicited with RAC): +CREG: <stat>,<lac>,<ci>,<AcT>,<RAC>
-         * CEREG=2 (solicited):           +CEREG: <n>,<stat>,<lac>,<ci>,<AcT>
+        break;
+    case 5:
+        /* CREG=2 (solicited):             +CREG: <n>,<stat>,<lac>,<ci>,<AcT>
+         * CREG=2 (unsolicited with RAC):  +CREG: <stat>,<lac>,<ci>,<AcT>,<RAC>
+         * CEREG=2 (solicited):            +CEREG: <n>,<stat>,<lac>,<ci>,<AcT>
          * CEREG=2 (unsolicited with RAC): +CEREG: <stat>,<lac>,<rac>,<ci>,<AcT>
          */
-
-        if (*out_cereg) {
-            /* Check if the third item is the LAC to distinguish the two cases */
-            if (item_is_lac_not_stat (info, 3)) {
-                istat = 2;
-                ilac = 3;
-            } else {
-                istat = 3;
-                ilac = 4;
-            }
-            ici = 5;
-            iact = 6;
+        if (!creg_field_is_lac_not_stat (fields[1])) {
+            istat = 1;
+            ilac = 2;
+            ici = 3;
+            iact = 4;
+        } else if (*out_cereg) {
+            istat = 0;
+            ilac = 1;
+            ici = 3;
+            iact = 4;
         } else {
-            /* Check if the third item is the LAC to distinguish the two cases */
-            if (item_is_lac_not_stat (info, 3)) {
-                istat = 2;
-                ilac = 3;
-                ici = 4;
-                iact = 5;
-            } else {
-                istat = 3;
-                ilac = 4;
-                ici = 5;
-                iact = 6;
-            }
+            istat = 0;
+            ilac = 1;
+            ici = 2;
+            iact = 3;
         }
-    } else if (n_matches == 8) {
-        /* CEREG=2 (solicited with RAC):  +CEREG: <n>,<stat>,<lac>,<rac>,<ci>,<AcT>
+        break;
+    case 6:
+        /* CEREG=2 (solicited with RAC): +CEREG: <n>,<stat>,<lac>,<rac>,<ci>,<AcT>
+         * CREG=2 (Samsung Wave S8500):  +CREG: <n>,<stat>,<lac>,<ci>,<AcT?>,<something>
          */
+        istat = 1;
+        ilac = 2;
         if (*out_cereg) {
-            istat = 3;
-            ilac = 4;
-            ici = 6;
-            iact = 7;
+            ici = 4;
+            iact = 5;
+        } else {
+            ici = 3;
+            iact = 4;
         }
-     }
+        break;
+    default:
+        g_assert_not_reached ();
+    }
 
     /* Status */
-    str = g_match_info_fetch (info, istat);
-    stat = parse_uint (str, 10, 0, 5, &success);
-    g_free (str);
+    stat = parse_uint (fields[istat], 10, 0, 5, &success);
     if (!success) {
         g_set_error_literal (error,
                              MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
                              "Could not parse the registration status response");
+        g_free (line);
         return FALSE;
     }
 
     /* Location Area Code */
-    if (ilac) {
+    if (ilac >= 0) {
         /* FIXME: some phones apparently swap the LAC bytes (LG, SonyEricsson,
          * Sagem).  Need to handle that.
          */
-        str = g_match_info_fetch (info, ilac);
-        lac = parse_uint (str, 16, 1, 0xFFFF, &foo);
-        g_free (str);
+        lac = parse_uint (fields[ilac], 16, 1, 0xFFFF, &foo);
     }
 
     /* Cell ID */
-    if (ici) {
-        str = g_match_info_fetch (info, ici);
-        ci = parse_uint (str, 16, 1, 0x0FFFFFFE, &foo);
-        g_free (str);
-    }
+    if (ici >= 0)
+        ci = parse_uint (fields[ici], 16, 1, 0x0FFFFFFE, &foo);
 
     /* Access Technology */
-    if (iact) {
-        str = g_match_info_fetch (info, iact);
-        act = (gint) parse_uint (str, 10, 0, 7, &foo);
-        g_free (str);
+    if (iact >= 0) {
+        act = (gint) parse_uint (fields[iact], 10, 0, 7, &foo);
         if (!foo)
             act = -1;
     }
 
+    g_free (line);
+
     /* 'roaming' is the last valid state */
     if (stat > MM_MODEM_3GPP_REGISTRATION_STATE_ROAMING) {
         mm_warn ("Registration State '%lu' is unknown", stat);
@@ -1235,7 +1848,7 @@ mm_3gpp_parse_cmgf_test_response (const gchar *reply,
     while (isspace (*reply))
         reply++;
 
-    r = g_regex_new ("\\(?\\s*(\\d+)\\s*[-,]?\\s*(\\d+)?\\s*\\)?", 0, 0, error);
+    r = mm_regex_registry_get ("\\(?\\s*(\\d+)\\s*[-,]?\\s*(\\d+)?\\s*\\)?", 0);
     if (!r)
         return FALSE;
 
@@ -1287,7 +1900,7 @@ mm_3gpp_parse_cmgr_read_response (const gchar *reply,
 
     /* +CMGR: <stat>,<alpha>,<length>(whitespace)<pdu> */
     /* The <alpha> and <length> fields are matched, but not currently used */
-    r = g_regex_new ("\\+CMGR:\\s*(\\d+)\\s*,([^,]*),\\s*(\\d+)\\s*([^\\r\\n]*)", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\+CMGR:\\s*(\\d+)\\s*,([^,]*),\\s*(\\d+)\\s*([^\\r\\n]*)", 0);
     g_assert (r);
 
     if (!g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL)) {
@@ -1352,8 +1965,12 @@ mm_3gpp_parse_crsm_response (const gchar *reply,
                              gchar **hex,
                              GError **error)
 {
-    GRegex *r;
-    GMatchInfo *match_info;
+    static const MMAtResponseShape shape = {
+        "+CRSM:", TRUE, 3,
+        { MM_AT_FIELD_UINT, MM_AT_FIELD_UINT, MM_AT_FIELD_STRING }
+    };
+    MMAtResponseFields fields;
+    gsize i;
 
     g_assert (sw1 != NULL);
     g_assert (sw2 != NULL);
@@ -1368,17 +1985,14 @@ mm_3gpp_parse_crsm_response (const gchar *reply,
         return FALSE;
     }
 
-    r = g_regex_new ("\\+CRSM:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,\\s*\"?([0-9a-fA-F]+)\"?",
-                     G_REGEX_RAW, 0, NULL);
-    g_assert (r != NULL);
-
-    if (g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL) &&
-        mm_get_uint_from_match_info (match_info, 1, sw1) &&
-        mm_get_uint_from_match_info (match_info, 2, sw2))
-        *hex = mm_get_string_unquoted_from_match_info (match_info, 3);
-
-    g_match_info_free (match_info);
-    g_regex_unref (r);
+    if (mm_at_response_shape_parse (&shape, reply, &fields, NULL) &&
+        mm_at_response_fields_get_uint (&fields, 0, sw1) &&
+        mm_at_response_fields_get_uint (&fields, 1, sw2) &&
+        fields.str_len[2] > 0) {
+        for (i = 0; i < fields.str_len[2] && g_ascii_isxdigit (fields.str[2][i]); i++);
+        if (i == fields.str_len[2])
+            *hex = mm_at_response_fields_dup_string (&fields, 2);
+    }
 
     if (*hex == NULL) {
         g_set_error (error,
@@ -1442,7 +2056,7 @@ mm_3gpp_parse_cpms_test_response (const gchar *reply,
         return FALSE;
     }
 
-    r = g_regex_new ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\s*\"([^,\\)]+)\"\\s*", 0);
     g_assert (r);
 
     for (i = 0; i < N_EXPECTED_GROUPS; i++) {
@@ -1524,7 +2138,7 @@ mm_3gpp_parse_cpms_query_response (const gchar *reply,
     gboolean ret = FALSE;
     GMatchInfo *match_info = NULL;
 
-    r = g_regex_new (CPMS_QUERY_REGEX, G_REGEX_RAW, 0, NULL);
+    r = mm_regex_registry_get (CPMS_QUERY_REGEX, G_REGEX_RAW);
 
     g_assert(r);
 
@@ -1560,6 +2174,33 @@ end:
     return ret;
 }
 
+gboolean
+mm_3gpp_parse_cpms_set_response (const gchar *reply,
+                                 guint *mem1_used,
+                                 guint *mem1_total)
+{
+    /* +CPMS: <used1>,<total1>[,<used2>,<total2>[,<used3>,<total3>]] */
+    static const MMAtResponseShape shape = {
+        "+CPMS:", FALSE, 2,
+        { MM_AT_FIELD_UINT, MM_AT_FIELD_UINT }
+    };
+    MMAtResponseFields fields;
+    guint used;
+    guint total;
+
+    if (!reply ||
+        !mm_at_response_shape_parse (&shape, reply, &fields, NULL) ||
+        !mm_at_response_fields_get_uint (&fields, 0, &used) ||
+        !mm_at_response_fields_get_uint (&fields, 1, &total))
+        return FALSE;
+
+    if (mem1_used)
+        *mem1_used = used;
+    if (mem1_total)
+        *mem1_total = total;
+    return TRUE;
+}
+
 gboolean
 mm_3gpp_get_cpms_storage_match (GMatchInfo *match_info,
                                 const gchar *match_name,
@@ -1614,7 +2255,7 @@ mm_3gpp_parse_cscs_test_response (const gchar *reply,
     }
 
     /* Now parse each charset */
-    r = g_regex_new ("\\s*([^,\\)]+)\\s*", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\s*([^,\\)]+)\\s*", 0);
     if (!r)
         return FALSE;
 
@@ -1656,7 +2297,7 @@ mm_3gpp_parse_clck_test_response (const gchar *reply,
     reply = mm_strip_tag (reply, "+CLCK:");
 
     /* Now parse each facility */
-    r = g_regex_new ("\\s*\"([^,\\)]+)\"\\s*", 0, 0, NULL);
+    r = mm_regex_registry_get ("\\s*\"([^,\\)]+)\"\\s*", 0);
     g_assert (r != NULL);
 
     *out_facilities = MM_MODEM_3GPP_FACILITY_NONE;
@@ -1685,40 +2326,24 @@ gboolean
 mm_3gpp_parse_clck_write_response (const gchar *reply,
                                    gboolean *enabled)
 {
-    GRegex *r;
-    GMatchInfo *match_info;
-    gboolean success = FALSE;
+    /* +CLCK: <status>[,<class>] */
+    static const MMAtResponseShape shape = {
+        "+CLCK:", FALSE, 1,
+        { MM_AT_FIELD_UINT }
+    };
+    MMAtResponseFields fields;
+    guint status;
 
     g_return_val_if_fail (reply != NULL, FALSE);
     g_return_val_if_fail (enabled != NULL, FALSE);
 
-    reply = mm_strip_tag (reply, "+CLCK:");
-
-    r = g_regex_new ("\\s*([01])\\s*", 0, 0, NULL);
-    g_assert (r != NULL);
-
-    if (g_regex_match (r, reply, 0, &match_info)) {
-        gchar *str;
-
-        str = g_match_info_fetch (match_info, 1);
-        if (str) {
-            /* We're trying to match either '0' or '1',
-             * so we don't expect any other thing */
-            if (*str == '0')
-                *enabled = FALSE;
-            else if (*str == '1')
-                *enabled = TRUE;
-            else
-                g_assert_not_reached ();
-
-            g_free (str);
-            success = TRUE;
-        }
-    }
-    g_match_info_free (match_info);
-    g_regex_unref (r);
+    if (!mm_at_response_shape_parse (&shape, reply, &fields, NULL) ||
+        !mm_at_response_fields_get_uint (&fields, 0, &status) ||
+        status > 1)
+        return FALSE;
 
-    return success;
+    *enabled = (status == 1);
+    return TRUE;
 }
 
 /*************************************************************************/
@@ -1735,8 +2360,8 @@ mm_3gpp_parse_cnum_exec_response (const gchar *reply,
     if (!reply || !reply[0])
         return NULL;
 
-    r = g_regex_new ("\\+CNUM:\\s*((\"([^\"]|(\\\"))*\")|([^,]*)),\"(?<num>\\S+)\",\\d",
-                     G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_registry_get ("\\+CNUM:\\s*((\"([^\"]|(\\\"))*\")|([^,]*)),\"(?<num>\\S+)\",\\d",
+                               G_REGEX_UNGREEDY);
     g_assert (r != NULL);
 
     g_regex_match (r, reply, 0, &match_info);
@@ -1856,7 +2481,7 @@ mm_3gpp_parse_cind_test_response (const gchar *reply,
     while (isspace (*reply))
         reply++;
 
-    r = g_regex_new ("\\(([^,]*),\\((\\d+)[-,](\\d+).*\\)", G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_registry_get ("\\(([^,]*),\\((\\d+)[-,](\\d+).*\\)", G_REGEX_UNGREEDY);
     if (!r) {
         g_set_error_literal (error,
                              MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
@@ -1920,7 +2545,7 @@ mm_3gpp_parse_cind_read_response (const gchar *reply,
 
     reply = mm_strip_tag (reply, CIND_TAG);
 
-    r = g_regex_new ("(\\d+)[^0-9]+", G_REGEX_UNGREEDY, 0, NULL);
+    r = mm_regex_registry_get ("(\\d+)[^0-9]+", G_REGEX_UNGREEDY);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, NULL)) {
@@ -2001,8 +2626,8 @@ mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
      *
      * We just read <index>, <stat> and the PDU itself.
      */
-    r = g_regex_new ("\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,(.*)\\r\\n([^\\r\\n]*)(\\r\\n)?",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+    r = mm_regex_registry_get ("\\+CMGL:\\s*(\\d+)\\s*,\\s*(\\d+)\\s*,(.*)\\r\\n([^\\r\\n]*)(\\r\\n)?",
+                               G_REGEX_RAW);
     g_assert (r != NULL);
 
     g_regex_match_full (r, str, strlen (str), 0, 0, &match_info, &inner_error);
@@ -2013,14 +2638,15 @@ mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
         if (mm_get_int_from_match_info (match_info, 1, &info->index) &&
             mm_get_int_from_match_info (match_info, 2, &info->status) &&
             (info->pdu = mm_get_string_unquoted_from_match_info (match_info, 4)) != NULL) {
-            /* Append to our list of results and keep on */
-            list = g_list_append (list, info);
+            /* Add to our list of results and keep on */
+            list = g_list_prepend (list, info);
             g_match_info_next (match_info, &inner_error);
         } else {
             inner_error = g_error_new (MM_CORE_ERROR,
                                        MM_CORE_ERROR_FAILED,
                                        "Error parsing +CMGL response: '%s'",
                                        str);
+            g_free (info);
         }
     }
 
@@ -2033,7 +2659,7 @@ mm_3gpp_parse_pdu_cmgl_response (const gchar *str,
         return NULL;
     }
 
-    return list;
+    return g_list_reverse (list);
 }
 
 /*************************************************************************/
@@ -2163,7 +2789,7 @@ mm_3gpp_parse_operator (const gchar *reply,
         GMatchInfo *match_info;
 
         reply += 7;
-        r = g_regex_new ("(\\d),(\\d),\"(.+)\"", G_REGEX_UNGREEDY, 0, NULL);
+        r = mm_regex_registry_get ("(\\d),(\\d),\"(.+)\"", G_REGEX_UNGREEDY);
         if (!r)
             return NULL;
 
@@ -2683,9 +3309,8 @@ mm_cdma_parse_crm_test_response (const gchar *reply,
      *   <--- +CRM: (0-2)
      */
 
-    r = g_regex_new ("\\+CRM:\\s*\\((\\d+)-(\\d+)\\)",
-                     G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW,
-                     0, error);
+    r = mm_regex_registry_get ("\\+CRM:\\s*\\((\\d+)-(\\d+)\\)",
+                               G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW);
     g_assert (r != NULL);
 
     if (g_regex_match_full (r, reply, strlen (reply), 0, 0, &match_info, &match_error)) {
@@ -2968,7 +3593,7 @@ mm_parse_cclk_response (const char *response,
     g_assert (iso8601p || tzp); /* at least one */
 
     /* Sample reply: +CCLK: "15/03/05,14:14:26-32" */
-    r = g_regex_new ("[+]CCLK: \"(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d+)([-+]\\d+)\"", 0, 0, NULL);
+    r = mm_regex_registry_get ("[+]CCLK: \"(\\d+)/(\\d+)/(\\d+),(\\d+):(\\d+):(\\d+)([-+]\\d+)\"", 0);
     g_assert (r != NULL);
 
     if (!g_regex_match_full (r, response, -1, 0, 0, &match_info, &match_error)) {
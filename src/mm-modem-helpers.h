@@ -53,6 +53,78 @@ const gchar *mm_strip_tag    (const gchar *str,
 
 gchar **mm_split_string_groups (const gchar *str);
 
+/*****************************************************************************/
+/* Simple response shapes */
+
+/* Responses made of a tag and comma separated fields of known types, like
+ * '+CSQ: <rssi>,<ber>', declared statically and decoded without allocating:
+ * strings point into the response. Only the first line is parsed, and fields
+ * beyond the declared ones are ignored. Numeric fields may be quoted. */
+
+#define MM_AT_RESPONSE_SHAPE_MAX_FIELDS 8
+
+typedef enum {
+    MM_AT_FIELD_END = 0, /* Ends the list if less than the maximum */
+    MM_AT_FIELD_UINT,
+    MM_AT_FIELD_INT,
+    MM_AT_FIELD_HEX,
+    MM_AT_FIELD_STRING,  /* Quotes removed */
+    MM_AT_FIELD_SKIP,    /* Anything, not decoded */
+} MMAtFieldType;
+
+typedef struct {
+    /* Skipped if found at the start of the response; NULL if none */
+    const gchar   *tag;
+    /* Whether a response without the tag is invalid */
+    gboolean       tag_required;
+    /* Leading fields which must be given and not empty */
+    guint          n_required;
+    MMAtFieldType  fields[MM_AT_RESPONSE_SHAPE_MAX_FIELDS];
+} MMAtResponseShape;
+
+typedef struct {
+    /* Bitmask of the fields given and not empty */
+    guint        present;
+    /* UINT, INT and HEX fields */
+    gint64       number[MM_AT_RESPONSE_SHAPE_MAX_FIELDS];
+    /* STRING fields, not NUL-terminated */
+    const gchar *str[MM_AT_RESPONSE_SHAPE_MAX_FIELDS];
+    gsize        str_len[MM_AT_RESPONSE_SHAPE_MAX_FIELDS];
+} MMAtResponseFields;
+
+gboolean mm_at_response_shape_parse (const MMAtResponseShape *shape,
+                                     const gchar *response,
+                                     MMAtResponseFields *fields,
+                                     GError **error);
+
+/* FALSE if the field isn't present or out of range */
+gboolean mm_at_response_fields_get_uint (const MMAtResponseFields *fields,
+                                         guint i,
+                                         guint *value);
+gboolean mm_at_response_fields_get_int  (const MMAtResponseFields *fields,
+                                         guint i,
+                                         gint *value);
+/* NULL if the field isn't present */
+gchar   *mm_at_response_fields_dup_string (const MMAtResponseFields *fields,
+                                           guint i);
+
+/* V.250 concatenation of read-only extended syntax commands, i.e. reads
+ * ('+NAME?') and tests ('+NAME=?'), e.g. '+CREG?;+CGREG?;+CSQ?'. Their reply
+ * lines are prefixed with the command name, which allows splitting the reply
+ * of the concatenated command back into per-command responses. */
+
+/* Length of the command name (e.g. 5 for '+CREG?'), without any leading 'AT';
+ * 0 if the command cannot be concatenated */
+gsize    mm_at_command_get_concatenable_name_length (const gchar *command);
+/* Without any leading 'AT' */
+gchar   *mm_at_commands_concatenate                 (const gchar **commands,
+                                                     guint n_commands);
+/* One response per command, possibly empty, laid out as if the command was
+ * sent alone; NULL if some line can't be attributed to any command. */
+gchar  **mm_at_concatenated_response_split          (const gchar *response,
+                                                     const gchar **commands,
+                                                     guint n_commands);
+
 guint mm_count_bits_set (gulong number);
 
 gchar *mm_create_device_identifier (guint vid,
@@ -77,6 +149,8 @@ gchar *mm_new_iso8601_time (guint year,
                             guint second,
                             gboolean have_offset,
                             gint offset_minutes);
+gboolean mm_parse_iso8601_time (const gchar *str,
+                                guint64 *unix_time);
 
 GArray *mm_filter_supported_modes (const GArray *all,
                                    const GArray *supported_combinations);
@@ -84,6 +158,11 @@ GArray *mm_filter_supported_modes (const GArray *all,
 GArray *mm_filter_supported_capabilities (MMModemCapability all,
                                           const GArray *supported_combinations);
 
+/* AT+IPR=? response parser. Returns the supported fixed rates, as guints in
+ * ascending order; ranges are expanded into the standard rates they cover */
+GArray *mm_parse_ipr_test_response (const gchar *reply,
+                                    GError **error);
+
 /*****************************************************************************/
 /* VOICE specific helpers and utilities */
 /*****************************************************************************/
@@ -96,25 +175,37 @@ GRegex *mm_voice_clip_regex_get (void);
 /*****************************************************************************/
 
 /* Common Regex getters */
-GPtrArray *mm_3gpp_creg_regex_get     (gboolean solicited);
-void       mm_3gpp_creg_regex_destroy (GPtrArray *array);
+GRegex    *mm_3gpp_creg_regex_get (void);
 GRegex    *mm_3gpp_ciev_regex_get (void);
 GRegex    *mm_3gpp_cusd_regex_get (void);
 GRegex    *mm_3gpp_cmti_regex_get (void);
+GRegex    *mm_3gpp_cmgl_pdu_regex_get (void);
 GRegex    *mm_3gpp_cds_regex_get (void);
+GRegex    *mm_3gpp_cmt_regex_get (void);
+GRegex    *mm_3gpp_ctz_regex_get (void);
+
+/* +CTZV/+CTZE unsolicited message parser; NULL if it couldn't be parsed */
+MMNetworkTimezone *mm_3gpp_parse_ctz_match (GMatchInfo *match_info);
 
 
-/* AT+COPS=? (network scan) response parser */
+/* AT+COPS=? (network scan) response parser. Operator names and code are
+ * taken from the string pool, see mm-string-pool.h */
 typedef struct {
     MMModem3gppNetworkAvailability status;
-    gchar *operator_long;
-    gchar *operator_short;
-    gchar *operator_code; /* mandatory */
+    const gchar *operator_long;
+    const gchar *operator_short;
+    const gchar *operator_code; /* mandatory */
     MMModemAccessTechnology access_tech;
 } MM3gppNetworkInfo;
 void mm_3gpp_network_info_list_free (GList *info_list);
 GList *mm_3gpp_parse_cops_test_response (const gchar *reply,
                                          GError **error);
+/* Parses the networks reported so far in an incomplete +COPS=? reply, as
+ * received while the scan is still running. @n_groups is the number of
+ * groups already parsed in previous calls, which are skipped, and is
+ * updated with the new count. */
+GList *mm_3gpp_parse_cops_test_partial_response (const gchar *partial,
+                                                 guint *n_groups);
 
 /* AT+CGDCONT=? (PDP context format) test parser */
 typedef struct {
@@ -136,8 +227,29 @@ void mm_3gpp_pdp_context_list_free (GList *pdp_list);
 GList *mm_3gpp_parse_cgdcont_read_response (const gchar *reply,
                                             GError **error);
 
-/* CREG/CGREG response/unsolicited message parser */
-gboolean mm_3gpp_parse_creg_response (GMatchInfo *info,
+/* AT+CGACT? (PDP context activation query) response parser */
+typedef struct {
+    guint cid;
+    gboolean active;
+} MM3gppPdpContextActive;
+void mm_3gpp_pdp_context_active_list_free (GList *pdp_active_list);
+GList *mm_3gpp_parse_cgact_read_response (const gchar *reply,
+                                          GError **error);
+
+/* AT+CLCC (list of current calls) response parser, voice calls only */
+typedef struct {
+    guint index;
+    MMCallDirection direction;
+    MMCallState state;
+    gchar *number;
+} MMCallInfo;
+void mm_3gpp_call_info_list_free (GList *call_info_list);
+gboolean mm_3gpp_parse_clcc_response (const gchar *reply,
+                                      GList **out_list,
+                                      GError **error);
+
+/* CREG/CGREG/CEREG response/unsolicited message parser */
+gboolean mm_3gpp_parse_creg_response (const gchar *reply,
                                       MMModem3gppRegistrationState *out_reg_state,
                                       gulong *out_lac,
                                       gulong *out_ci,
@@ -163,6 +275,11 @@ gboolean mm_3gpp_parse_cpms_query_response (const gchar *reply,
                                             MMSmsStorage *mem1,
                                             MMSmsStorage *mem2,
                                             GError** error);
+/* AT+CPMS=<mem1>[,...] (Set SMS storages) response parser, giving the
+ * number of messages in mem1 and its capacity */
+gboolean mm_3gpp_parse_cpms_set_response (const gchar *reply,
+                                          guint *mem1_used,
+                                          guint *mem1_total);
 gboolean mm_3gpp_get_cpms_storage_match (GMatchInfo *match_info,
                                          const gchar *match_name,
                                          MMSmsStorage *storage,
@@ -0,0 +1,334 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-modem-info-cache.h"
+#include "mm-port-serial-at.h"
+#include "mm-serial-reply-cache.h"
+#include "mm-context.h"
+#include "mm-log.h"
+
+#define KEY_MANUFACTURER           "manufacturer"
+#define KEY_MODEL                  "model"
+#define KEY_SUPPORTED_CAPABILITIES "supported-capabilities"
+#define KEY_SUPPORTED_IP_FAMILIES  "supported-ip-families"
+#define KEY_COMMANDS               "commands"
+#define KEY_REPLIES                "replies"
+
+/* Replies which only depend on the firmware; all of them are always
+ * cacheable in AT ports, so they're found in the reply cache once sent */
+static const gchar *static_commands[] = {
+    "AT+CFUN=?\r",
+    "AT+CGDCONT=?\r",
+    "AT+CIND=?\r",
+    "AT+CMGF=?\r",
+    "AT+CNMI=?\r",
+    "AT+CSCS=?\r",
+    "AT+WS46=?\r",
+    "AT^PREFMODE=?\r",
+    "AT^SCFG=?\r",
+    "AT^SYSCFG=?\r",
+    "AT^SYSCFGEX=?\r",
+};
+
+/* Loaded once, from the file given in the command line */
+static GKeyFile *cache;
+static gboolean  cache_loaded;
+
+static GKeyFile *
+peek_cache (void)
+{
+    const gchar *path;
+    GError *error = NULL;
+
+    if (cache_loaded)
+        return cache;
+    cache_loaded = TRUE;
+
+    path = mm_context_get_modem_info_cache ();
+    if (!path)
+        return NULL;
+
+    cache = g_key_file_new ();
+    if (!g_key_file_load_from_file (cache, path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("Couldn't load modem info cache '%s': %s", path, error->message);
+        g_error_free (error);
+    } else
+        mm_dbg ("Loaded modem info cache '%s'", path);
+
+    return cache;
+}
+
+static gchar *
+build_group (MMBaseModem  *modem,
+             MmGdbusModem *skeleton)
+{
+    const gchar *equipment_id;
+    const gchar *revision;
+    gchar *group;
+
+    equipment_id = mm_gdbus_modem_get_equipment_identifier (skeleton);
+    revision = mm_gdbus_modem_get_revision (skeleton);
+    if (!equipment_id || !revision)
+        return NULL;
+
+    /* Group names cannot have brackets nor line breaks */
+    group = g_strdup_printf ("%s/%s/%s",
+                             mm_base_modem_get_plugin (modem),
+                             equipment_id,
+                             revision);
+    return g_strdelimit (group, "[]\r\n", '_');
+}
+
+static void
+save_cache (GKeyFile *keyfile)
+{
+    gchar *data;
+    gsize len;
+    GError *error = NULL;
+
+    data = g_key_file_to_data (keyfile, &len, NULL);
+    if (!g_file_set_contents (mm_context_get_modem_info_cache (), data, len, &error)) {
+        mm_warn ("Couldn't write modem info cache '%s': %s",
+                 mm_context_get_modem_info_cache (), error->message);
+        g_error_free (error);
+    }
+    g_free (data);
+}
+
+/* Same choice as the one done by the ports when sending the command */
+static MMSerialReplyCache *
+peek_reply_cache (MMBaseModem      *modem,
+                  const GByteArray *command)
+{
+    MMSerialReplyCache *shared;
+    MMPortSerialAt *primary;
+
+    shared = mm_base_modem_peek_shared_reply_cache (modem);
+    if (shared && mm_serial_reply_cache_is_always_cacheable (shared, command))
+        return shared;
+
+    primary = mm_base_modem_peek_port_primary (modem);
+    return (primary ? mm_port_serial_peek_reply_cache (MM_PORT_SERIAL (primary)) : NULL);
+}
+
+static GByteArray *
+byte_array_new_from_string (const gchar *str)
+{
+    GByteArray *array;
+
+    array = g_byte_array_sized_new (strlen (str));
+    g_byte_array_append (array, (const guint8 *) str, strlen (str));
+    return array;
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_modem_info_cache_is_enabled (void)
+{
+    return !!mm_context_get_modem_info_cache ();
+}
+
+static void
+apply_replies (GKeyFile    *keyfile,
+               const gchar *group,
+               MMBaseModem *modem)
+{
+    gchar **commands;
+    gchar **replies;
+    gsize n_commands = 0;
+    gsize n_replies = 0;
+    guint i;
+
+    commands = g_key_file_get_string_list (keyfile, group, KEY_COMMANDS, &n_commands, NULL);
+    replies = g_key_file_get_string_list (keyfile, group, KEY_REPLIES, &n_replies, NULL);
+
+    for (i = 0; i < n_commands && i < n_replies; i++) {
+        MMSerialReplyCache *reply_cache;
+        GByteArray *command;
+        GByteArray *reply;
+
+        command = byte_array_new_from_string (commands[i]);
+        reply_cache = peek_reply_cache (modem, command);
+        /* Only the commands flagged as always cacheable are looked up in
+         * the cache when sent, so don't preload anything else */
+        if (reply_cache && mm_serial_reply_cache_is_always_cacheable (reply_cache, command)) {
+            reply = byte_array_new_from_string (replies[i]);
+            mm_serial_reply_cache_insert (reply_cache, command, reply);
+            g_byte_array_unref (reply);
+        }
+        g_byte_array_unref (command);
+    }
+
+    g_strfreev (commands);
+    g_strfreev (replies);
+}
+
+gboolean
+mm_modem_info_cache_apply (MMBaseModem  *modem,
+                           MmGdbusModem *skeleton)
+{
+    GKeyFile *keyfile;
+    gchar *group;
+    gchar *str;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return FALSE;
+
+    group = build_group (modem, skeleton);
+    if (!group || !g_key_file_has_group (keyfile, group)) {
+        g_free (group);
+        return FALSE;
+    }
+
+    mm_dbg ("Reusing cached modem info for '%s'", group);
+
+    if (!mm_gdbus_modem_get_manufacturer (skeleton) &&
+        (str = g_key_file_get_string (keyfile, group, KEY_MANUFACTURER, NULL))) {
+        mm_gdbus_modem_set_manufacturer (skeleton, str);
+        g_free (str);
+    }
+
+    if (!mm_gdbus_modem_get_model (skeleton) &&
+        (str = g_key_file_get_string (keyfile, group, KEY_MODEL, NULL))) {
+        mm_gdbus_modem_set_model (skeleton, str);
+        g_free (str);
+    }
+
+    if ((str = g_key_file_get_string (keyfile, group, KEY_SUPPORTED_CAPABILITIES, NULL))) {
+        GVariant *variant;
+
+        variant = g_variant_parse (G_VARIANT_TYPE ("au"), str, NULL, NULL, NULL);
+        if (variant && g_variant_n_children (variant) > 0)
+            mm_gdbus_modem_set_supported_capabilities (skeleton, variant);
+        else if (variant)
+            g_variant_unref (variant);
+        g_free (str);
+    }
+
+    if (mm_gdbus_modem_get_supported_ip_families (skeleton) == MM_BEARER_IP_FAMILY_NONE)
+        mm_gdbus_modem_set_supported_ip_families (
+            skeleton,
+            (guint) g_key_file_get_integer (keyfile, group, KEY_SUPPORTED_IP_FAMILIES, NULL));
+
+    apply_replies (keyfile, group, modem);
+
+    g_free (group);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+set_optional_string (GKeyFile    *keyfile,
+                     const gchar *group,
+                     const gchar *key,
+                     const gchar *value)
+{
+    if (value)
+        g_key_file_set_string (keyfile, group, key, value);
+    else
+        g_key_file_remove_key (keyfile, group, key, NULL);
+}
+
+static void
+store_replies (GKeyFile    *keyfile,
+               const gchar *group,
+               MMBaseModem *modem)
+{
+    GPtrArray *commands;
+    GPtrArray *replies;
+    guint i;
+
+    commands = g_ptr_array_new ();
+    replies = g_ptr_array_new_with_free_func (g_free);
+
+    for (i = 0; i < G_N_ELEMENTS (static_commands); i++) {
+        MMSerialReplyCache *reply_cache;
+        GByteArray *command;
+        const GByteArray *reply = NULL;
+
+        command = byte_array_new_from_string (static_commands[i]);
+        reply_cache = peek_reply_cache (modem, command);
+        if (reply_cache)
+            reply = mm_serial_reply_cache_peek (reply_cache, command);
+        /* Replies are text, but may not be NUL-terminated */
+        if (reply && !memchr (reply->data, '\0', reply->len)) {
+            g_ptr_array_add (commands, (gpointer) static_commands[i]);
+            g_ptr_array_add (replies, g_strndup ((const gchar *) reply->data, reply->len));
+        }
+        g_byte_array_unref (command);
+    }
+
+    g_key_file_set_string_list (keyfile, group, KEY_COMMANDS,
+                                (const gchar * const *) commands->pdata, commands->len);
+    g_key_file_set_string_list (keyfile, group, KEY_REPLIES,
+                                (const gchar * const *) replies->pdata, replies->len);
+
+    g_ptr_array_unref (commands);
+    g_ptr_array_unref (replies);
+}
+
+void
+mm_modem_info_cache_store (MMBaseModem  *modem,
+                           MmGdbusModem *skeleton)
+{
+    GKeyFile *keyfile;
+    GVariant *capabilities;
+    gchar *group;
+    gchar *old_data;
+    gchar *new_data;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return;
+
+    group = build_group (modem, skeleton);
+    if (!group)
+        return;
+
+    old_data = g_key_file_to_data (keyfile, NULL, NULL);
+
+    set_optional_string (keyfile, group, KEY_MANUFACTURER, mm_gdbus_modem_get_manufacturer (skeleton));
+    set_optional_string (keyfile, group, KEY_MODEL, mm_gdbus_modem_get_model (skeleton));
+
+    capabilities = mm_gdbus_modem_get_supported_capabilities (skeleton);
+    if (capabilities) {
+        gchar *str;
+
+        str = g_variant_print (capabilities, FALSE);
+        g_key_file_set_string (keyfile, group, KEY_SUPPORTED_CAPABILITIES, str);
+        g_free (str);
+    } else
+        g_key_file_remove_key (keyfile, group, KEY_SUPPORTED_CAPABILITIES, NULL);
+
+    g_key_file_set_integer (keyfile, group, KEY_SUPPORTED_IP_FAMILIES,
+                            (gint) mm_gdbus_modem_get_supported_ip_families (skeleton));
+
+    store_replies (keyfile, group, modem);
+
+    /* Usually nothing changed, as the entry was applied during initialization */
+    new_data = g_key_file_to_data (keyfile, NULL, NULL);
+    if (g_strcmp0 (old_data, new_data) != 0)
+        save_cache (keyfile);
+
+    g_free (new_data);
+    g_free (old_data);
+    g_free (group);
+}
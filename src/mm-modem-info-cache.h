@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_MODEM_INFO_CACHE_H
+#define MM_MODEM_INFO_CACHE_H
+
+#include <glib.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-base-modem.h"
+
+/*
+ * Static modem information, kept in a key file given with --modem-info-cache
+ * so that it doesn't need to be loaded again each time the modem shows up.
+ * Entries are keyed by plugin, equipment identifier and firmware revision,
+ * which are the only values loaded before the cache is looked up.
+ *
+ * Two kinds of information are cached:
+ *  - Modem interface properties which are loaded without side effects in any
+ *    implementation (manufacturer, model, supported capabilities and IP
+ *    families), preset in the skeleton so that their loaders are skipped.
+ *  - Replies to the test commands listing static capabilities in the primary
+ *    AT port (e.g. ^SYSCFG=? or ^SCFG=?), preloaded in the port reply cache.
+ *    The loaders using them still run, so that plugins build their own
+ *    tables, but without talking to the device.
+ *
+ * Without the option, nothing is cached.
+ */
+
+gboolean mm_modem_info_cache_is_enabled (void);
+
+/* Presets the cached information if there is an entry for the equipment
+ * identifier and revision already set in the skeleton; returns TRUE if so */
+gboolean mm_modem_info_cache_apply (MMBaseModem  *modem,
+                                    MmGdbusModem *skeleton);
+
+/* Stores the information once the Modem interface is initialized */
+void     mm_modem_info_cache_store (MMBaseModem  *modem,
+                                    MmGdbusModem *skeleton);
+
+#endif /* MM_MODEM_INFO_CACHE_H */
@@ -0,0 +1,262 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "mm-netlink-monitor.h"
+#include "mm-log.h"
+
+typedef struct {
+    gchar                *ifname;
+    MMNetlinkMonitorFunc  callback;
+    gpointer              user_data;
+    /* Whether the interface was last seen up and with carrier */
+    gboolean              running;
+} Watch;
+
+/* Watch id -> Watch */
+static GHashTable *watches;
+static guint       next_id;
+
+static GIOChannel *channel;
+static guint       channel_id;
+
+/*****************************************************************************/
+
+static void
+watch_free (Watch *watch)
+{
+    g_free (watch->ifname);
+    g_slice_free (Watch, watch);
+}
+
+static void
+dispatch (const gchar           *ifname,
+          gboolean               removed,
+          guint                  flags)
+{
+    GHashTableIter  iter;
+    gpointer        key;
+    Watch          *watch;
+    GSList         *pending = NULL;
+    GSList         *l;
+
+    /* Callbacks may remove watches, so collect the ones to notify first */
+    g_hash_table_iter_init (&iter, watches);
+    while (g_hash_table_iter_next (&iter, &key, (gpointer *) &watch)) {
+        gboolean running;
+
+        if (!g_str_equal (watch->ifname, ifname))
+            continue;
+
+        if (removed) {
+            pending = g_slist_prepend (pending, key);
+            continue;
+        }
+
+        running = ((flags & IFF_UP) && (flags & IFF_RUNNING));
+        if (watch->running && !running && (flags & IFF_UP))
+            pending = g_slist_prepend (pending, key);
+        watch->running = running;
+    }
+
+    for (l = pending; l; l = g_slist_next (l)) {
+        watch = g_hash_table_lookup (watches, l->data);
+        if (!watch)
+            continue;
+        mm_dbg ("Interface '%s' %s", ifname, removed ? "removed" : "lost carrier");
+        watch->callback (ifname,
+                         removed ? MM_NETLINK_MONITOR_EVENT_REMOVED : MM_NETLINK_MONITOR_EVENT_CARRIER_LOST,
+                         watch->user_data);
+    }
+    g_slist_free (pending);
+}
+
+static void
+process_link (struct nlmsghdr *nlh)
+{
+    struct ifinfomsg *ifm;
+    struct rtattr    *rta;
+    gint              len;
+    const gchar      *ifname = NULL;
+
+    ifm = NLMSG_DATA (nlh);
+    len = IFLA_PAYLOAD (nlh);
+    for (rta = IFLA_RTA (ifm); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == IFLA_IFNAME) {
+            ifname = RTA_DATA (rta);
+            break;
+        }
+    }
+
+    if (ifname)
+        dispatch (ifname, nlh->nlmsg_type == RTM_DELLINK, ifm->ifi_flags);
+}
+
+static gboolean
+channel_input_available (GIOChannel   *source,
+                         GIOCondition  condition,
+                         gpointer      data)
+{
+    guint8 buffer[8192];
+    gint   fd;
+
+    fd = g_io_channel_unix_get_fd (source);
+
+    for (;;) {
+        struct nlmsghdr *nlh;
+        gssize           len;
+
+        len = recv (fd, buffer, sizeof (buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            /* On overruns the lost events are just skipped; the periodic
+             * checks will notice what we missed */
+            if (errno == ENOBUFS) {
+                mm_dbg ("Netlink monitor overrun, link events lost");
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                mm_warn ("Couldn't read netlink events: %s", g_strerror (errno));
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *) buffer; NLMSG_OK (nlh, len); nlh = NLMSG_NEXT (nlh, len)) {
+            if (nlh->nlmsg_type == RTM_NEWLINK || nlh->nlmsg_type == RTM_DELLINK)
+                process_link (nlh);
+            /* The last watch may have been removed by a callback */
+            if (source != channel)
+                return G_SOURCE_REMOVE;
+        }
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+monitor_open (void)
+{
+    struct sockaddr_nl addr;
+    gint               fd;
+
+    fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_ROUTE);
+    if (fd < 0) {
+        mm_warn ("Couldn't open netlink socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    memset (&addr, 0, sizeof (addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK;
+    if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+        mm_warn ("Couldn't subscribe to netlink link events: %s", g_strerror (errno));
+        close (fd);
+        return FALSE;
+    }
+
+    channel = g_io_channel_unix_new (fd);
+    g_io_channel_set_close_on_unref (channel, TRUE);
+    g_io_channel_set_encoding (channel, NULL, NULL);
+    g_io_channel_set_buffered (channel, FALSE);
+    channel_id = g_io_add_watch (channel, G_IO_IN, channel_input_available, NULL);
+    mm_dbg ("Netlink monitor started");
+    return TRUE;
+}
+
+static void
+monitor_close (void)
+{
+    if (channel_id) {
+        g_source_remove (channel_id);
+        channel_id = 0;
+    }
+    if (channel) {
+        g_io_channel_unref (channel);
+        channel = NULL;
+        mm_dbg ("Netlink monitor stopped");
+    }
+}
+
+static guint
+get_interface_flags (const gchar *ifname)
+{
+    struct ifreq ifr;
+    guint        flags = 0;
+    gint         fd;
+
+    fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return 0;
+
+    memset (&ifr, 0, sizeof (ifr));
+    g_strlcpy (ifr.ifr_name, ifname, sizeof (ifr.ifr_name));
+    if (ioctl (fd, SIOCGIFFLAGS, &ifr) == 0)
+        flags = (guint16) ifr.ifr_flags;
+    close (fd);
+    return flags;
+}
+
+/*****************************************************************************/
+
+guint
+mm_netlink_monitor_watch (const gchar          *ifname,
+                          MMNetlinkMonitorFunc  callback,
+                          gpointer              user_data)
+{
+    Watch *watch;
+    guint  flags;
+
+    g_return_val_if_fail (ifname != NULL, 0);
+    g_return_val_if_fail (callback != NULL, 0);
+
+    if (!channel && !monitor_open ())
+        return 0;
+
+    if (G_UNLIKELY (!watches))
+        watches = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) watch_free);
+
+    watch = g_slice_new0 (Watch);
+    watch->ifname = g_strdup (ifname);
+    watch->callback = callback;
+    watch->user_data = user_data;
+
+    /* The events only tell about changes, so start from the current state */
+    flags = get_interface_flags (ifname);
+    watch->running = ((flags & IFF_UP) && (flags & IFF_RUNNING));
+
+    if (G_UNLIKELY (++next_id == 0))
+        next_id = 1;
+    g_hash_table_insert (watches, GUINT_TO_POINTER (next_id), watch);
+    return next_id;
+}
+
+void
+mm_netlink_monitor_unwatch (guint id)
+{
+    if (!watches || !id)
+        return;
+
+    g_hash_table_remove (watches, GUINT_TO_POINTER (id));
+    if (g_hash_table_size (watches) == 0)
+        monitor_close ();
+}
@@ -0,0 +1,46 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_NETLINK_MONITOR_H
+#define MM_NETLINK_MONITOR_H
+
+#include <glib.h>
+
+/*
+ * Link state changes of network interfaces, as notified by the kernel over
+ * rtnetlink. A single socket subscribed to the link events is shared by all
+ * the watches, and it is only kept open while there is at least one.
+ *
+ * Carrier loss is only reported while the interface is administratively up
+ * and after it has been seen running, so that bringing the interface up or
+ * down by hand is not reported.
+ */
+
+typedef enum {
+    MM_NETLINK_MONITOR_EVENT_CARRIER_LOST,
+    MM_NETLINK_MONITOR_EVENT_REMOVED,
+} MMNetlinkMonitorEvent;
+
+typedef void (* MMNetlinkMonitorFunc) (const gchar           *ifname,
+                                       MMNetlinkMonitorEvent  event,
+                                       gpointer               user_data);
+
+/* Watches may be removed from within the callback */
+guint mm_netlink_monitor_watch   (const gchar          *ifname,
+                                  MMNetlinkMonitorFunc  callback,
+                                  gpointer              user_data);
+void  mm_netlink_monitor_unwatch (guint                 id);
+
+#endif /* MM_NETLINK_MONITOR_H */
@@ -0,0 +1,188 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-netlink-stats.h"
+#include "mm-log.h"
+
+/* How long a dump is reused, in microseconds */
+#define DUMP_MAX_AGE_USEC G_USEC_PER_SEC
+
+typedef struct {
+    guint64 rx_bytes;
+    guint64 tx_bytes;
+} LinkStats;
+
+/* Interface name -> LinkStats */
+static GHashTable *links;
+static gint64      links_timestamp;
+
+/*****************************************************************************/
+
+static void
+process_link (struct nlmsghdr *nlh)
+{
+    struct ifinfomsg *ifm;
+    struct rtattr    *rta;
+    gint              len;
+    const gchar      *ifname = NULL;
+    LinkStats        *stats = NULL;
+
+    ifm = NLMSG_DATA (nlh);
+    len = IFLA_PAYLOAD (nlh);
+    for (rta = IFLA_RTA (ifm); RTA_OK (rta, len); rta = RTA_NEXT (rta, len)) {
+        if (rta->rta_type == IFLA_IFNAME)
+            ifname = RTA_DATA (rta);
+        else if (rta->rta_type == IFLA_STATS64 &&
+                 RTA_PAYLOAD (rta) >= sizeof (struct rtnl_link_stats64)) {
+            struct rtnl_link_stats64 link_stats;
+
+            /* Attribute data is only 4-byte aligned */
+            memcpy (&link_stats, RTA_DATA (rta), sizeof (link_stats));
+            stats = g_slice_new (LinkStats);
+            stats->rx_bytes = link_stats.rx_bytes;
+            stats->tx_bytes = link_stats.tx_bytes;
+        }
+    }
+
+    if (ifname && stats)
+        g_hash_table_insert (links, g_strdup (ifname), stats);
+    else if (stats)
+        g_slice_free (LinkStats, stats);
+}
+
+static void
+link_stats_free (LinkStats *stats)
+{
+    g_slice_free (LinkStats, stats);
+}
+
+static gboolean
+dump_links (GError **error)
+{
+    struct {
+        struct nlmsghdr  nlh;
+        struct ifinfomsg ifm;
+    } request;
+    static guint32  seq;
+    guint8          buffer[16384];
+    gboolean        done = FALSE;
+    gint            fd;
+
+    fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't open netlink socket: %s", g_strerror (errno));
+        return FALSE;
+    }
+
+    memset (&request, 0, sizeof (request));
+    request.nlh.nlmsg_len = NLMSG_LENGTH (sizeof (struct ifinfomsg));
+    request.nlh.nlmsg_type = RTM_GETLINK;
+    request.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.nlh.nlmsg_seq = ++seq;
+    request.ifm.ifi_family = AF_UNSPEC;
+
+    if (send (fd, &request, request.nlh.nlmsg_len, 0) < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't request link dump: %s", g_strerror (errno));
+        close (fd);
+        return FALSE;
+    }
+
+    g_hash_table_remove_all (links);
+
+    while (!done) {
+        struct nlmsghdr *nlh;
+        gssize           len;
+
+        len = recv (fd, buffer, sizeof (buffer), 0);
+        if (len < 0) {
+            if (errno == EINTR)
+                continue;
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                         "Couldn't read link dump: %s", g_strerror (errno));
+            break;
+        }
+
+        for (nlh = (struct nlmsghdr *) buffer; NLMSG_OK (nlh, len); nlh = NLMSG_NEXT (nlh, len)) {
+            if (nlh->nlmsg_seq != seq)
+                continue;
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                done = TRUE;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                             "Link dump failed");
+                len = -1;
+                break;
+            }
+            if (nlh->nlmsg_type == RTM_NEWLINK)
+                process_link (nlh);
+        }
+        if (len < 0)
+            break;
+    }
+
+    close (fd);
+    return done;
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_netlink_stats_get (const gchar  *ifname,
+                      guint64      *rx_bytes,
+                      guint64      *tx_bytes,
+                      GError      **error)
+{
+    LinkStats *stats;
+    gint64     now;
+
+    if (G_UNLIKELY (!links))
+        links = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) link_stats_free);
+
+    now = g_get_monotonic_time ();
+    if (!links_timestamp || now - links_timestamp > DUMP_MAX_AGE_USEC) {
+        if (!dump_links (error)) {
+            links_timestamp = 0;
+            return FALSE;
+        }
+        links_timestamp = now;
+    }
+
+    stats = g_hash_table_lookup (links, ifname);
+    if (!stats) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_NOT_FOUND,
+                     "No kernel stats for interface '%s'", ifname);
+        return FALSE;
+    }
+
+    *rx_bytes = stats->rx_bytes;
+    *tx_bytes = stats->tx_bytes;
+    return TRUE;
+}
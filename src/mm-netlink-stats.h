@@ -0,0 +1,33 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_NETLINK_STATS_H
+#define MM_NETLINK_STATS_H
+
+#include <glib.h>
+
+/*
+ * Byte counters of network interfaces, as kept by the kernel. The counters
+ * of all interfaces are loaded with a single rtnetlink dump, which is reused
+ * for a second, so that the stats updates of all the bearers run together
+ * only cost one request.
+ */
+
+gboolean mm_netlink_stats_get (const gchar  *ifname,
+                               guint64      *rx_bytes,
+                               guint64      *tx_bytes,
+                               GError      **error);
+
+#endif /* MM_NETLINK_STATS_H */
@@ -0,0 +1,323 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <glib/gstdio.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-peer-server.h"
+#include "mm-log.h"
+
+typedef struct {
+    MMPeerServer             *server;
+    GDBusConnection          *connection;
+    GDBusObjectManagerServer *object_manager;
+    gulong                    closed_id;
+} Peer;
+
+struct _MMPeerServer {
+    gchar                  *socket_path;
+    GDBusServer            *dbus_server;
+    GDBusAuthObserver      *observer;
+    GDBusInterfaceSkeleton *manager_skeleton;
+    GDBusObjectManager     *object_manager;
+    gulong                  object_added_id;
+    gulong                  object_removed_id;
+    GList                  *peers;
+};
+
+/*****************************************************************************/
+
+static void
+peer_free (Peer *peer)
+{
+    GList *objects;
+    GList *l;
+
+    g_signal_handler_disconnect (peer->connection, peer->closed_id);
+
+    /* Only unexport from this connection, the objects stay on the bus */
+    objects = g_dbus_object_manager_get_objects (G_DBUS_OBJECT_MANAGER (peer->object_manager));
+    for (l = objects; l; l = g_list_next (l))
+        g_dbus_object_manager_server_unexport (peer->object_manager,
+                                               g_dbus_object_get_object_path (G_DBUS_OBJECT (l->data)));
+    g_list_free_full (objects, (GDestroyNotify) g_object_unref);
+    g_object_unref (peer->object_manager);
+
+    if (g_dbus_interface_skeleton_has_connection (peer->server->manager_skeleton, peer->connection))
+        g_dbus_interface_skeleton_unexport_from_connection (peer->server->manager_skeleton, peer->connection);
+
+    g_object_unref (peer->connection);
+    g_slice_free (Peer, peer);
+}
+
+static void
+peer_closed (GDBusConnection *connection,
+             gboolean         remote_peer_vanished,
+             GError          *error,
+             Peer            *peer)
+{
+    mm_dbg ("Peer connection closed");
+    peer->server->peers = g_list_remove (peer->server->peers, peer);
+    peer_free (peer);
+}
+
+static gboolean
+new_connection (GDBusServer     *dbus_server,
+                GDBusConnection *connection,
+                MMPeerServer    *self)
+{
+    GError       *error = NULL;
+    GCredentials *credentials;
+    Peer         *peer;
+    GList        *objects;
+    GList        *l;
+
+    peer = g_slice_new0 (Peer);
+    peer->server = self;
+    peer->connection = g_object_ref (connection);
+    peer->object_manager = g_dbus_object_manager_server_new (MM_DBUS_PATH);
+
+    if (!g_dbus_interface_skeleton_export (self->manager_skeleton, connection, MM_DBUS_PATH, &error)) {
+        mm_warn ("Couldn't export manager interface to peer: %s", error->message);
+        g_error_free (error);
+        g_object_unref (peer->object_manager);
+        g_object_unref (peer->connection);
+        g_slice_free (Peer, peer);
+        return FALSE;
+    }
+
+    objects = g_dbus_object_manager_get_objects (self->object_manager);
+    for (l = objects; l; l = g_list_next (l))
+        g_dbus_object_manager_server_export (peer->object_manager, G_DBUS_OBJECT_SKELETON (l->data));
+    g_list_free_full (objects, (GDestroyNotify) g_object_unref);
+    g_dbus_object_manager_server_set_connection (peer->object_manager, connection);
+
+    peer->closed_id = g_signal_connect (connection, "closed", G_CALLBACK (peer_closed), peer);
+    self->peers = g_list_prepend (self->peers, peer);
+
+    credentials = g_dbus_connection_get_peer_credentials (connection);
+    mm_dbg ("New peer connection (pid %d)",
+            credentials ? (gint) g_credentials_get_unix_pid (credentials, NULL) : -1);
+    return TRUE;
+}
+
+/*****************************************************************************/
+/* Objects added to or removed from the bus are mirrored in every peer */
+
+static void
+object_added (GDBusObjectManager *object_manager,
+              GDBusObject        *object,
+              MMPeerServer       *self)
+{
+    GList *l;
+
+    for (l = self->peers; l; l = g_list_next (l))
+        g_dbus_object_manager_server_export (((Peer *) l->data)->object_manager,
+                                             G_DBUS_OBJECT_SKELETON (object));
+}
+
+static void
+object_removed (GDBusObjectManager *object_manager,
+                GDBusObject        *object,
+                MMPeerServer       *self)
+{
+    GList *l;
+
+    for (l = self->peers; l; l = g_list_next (l))
+        g_dbus_object_manager_server_unexport (((Peer *) l->data)->object_manager,
+                                               g_dbus_object_get_object_path (object));
+}
+
+/*****************************************************************************/
+/* Start time of the peer process, so that it can't be confused with a later
+ * process reusing the same pid */
+
+#define PEER_START_TIME_KEY "mm-peer-start-time"
+
+static guint64
+read_process_start_time (pid_t pid)
+{
+    gchar   *path;
+    gchar   *contents = NULL;
+    gchar   *str;
+    gchar  **fields = NULL;
+    guint64  start_time = 0;
+
+    path = g_strdup_printf ("/proc/%d/stat", (gint) pid);
+    if (!g_file_get_contents (path, &contents, NULL, NULL))
+        goto out;
+
+    /* The command name may have spaces, fields are counted after it; the
+     * start time is the 22nd field */
+    str = strrchr (contents, ')');
+    if (!str)
+        goto out;
+    fields = g_strsplit (str + 2, " ", 21);
+    if (g_strv_length (fields) < 20)
+        goto out;
+    start_time = g_ascii_strtoull (fields[19], NULL, 10);
+
+out:
+    g_strfreev (fields);
+    g_free (contents);
+    g_free (path);
+    return start_time;
+}
+
+guint64
+mm_peer_server_get_peer_start_time (GDBusConnection *connection)
+{
+    guint64 *start_time;
+
+    start_time = g_object_get_data (G_OBJECT (g_dbus_connection_get_stream (connection)),
+                                    PEER_START_TIME_KEY);
+    return start_time ? *start_time : 0;
+}
+
+/*****************************************************************************/
+/* Authentication */
+
+static gboolean
+allow_mechanism (GDBusAuthObserver *observer,
+                 const gchar       *mechanism,
+                 MMPeerServer      *self)
+{
+    /* Only credentials passed over the socket are trusted */
+    return g_str_equal (mechanism, "EXTERNAL");
+}
+
+static gboolean
+authorize_authenticated_peer (GDBusAuthObserver *observer,
+                              GIOStream         *stream,
+                              GCredentials      *credentials,
+                              MMPeerServer      *self)
+{
+    uid_t    uid;
+    pid_t    pid;
+    guint64 *start_time;
+
+    if (!credentials) {
+        mm_dbg ("Peer rejected: no credentials");
+        return FALSE;
+    }
+
+    uid = g_credentials_get_unix_user (credentials, NULL);
+    if (uid == (uid_t) -1 || (uid != 0 && uid != getuid ())) {
+        mm_dbg ("Peer rejected: user %d not allowed", (gint) uid);
+        return FALSE;
+    }
+
+    /* The peer is still waiting for the end of the handshake, so the pid
+     * is surely its own at this point */
+    pid = g_credentials_get_unix_pid (credentials, NULL);
+    start_time = g_new (guint64, 1);
+    *start_time = (pid != (pid_t) -1 ? read_process_start_time (pid) : 0);
+    if (!*start_time) {
+        mm_dbg ("Peer rejected: unknown process start time");
+        g_free (start_time);
+        return FALSE;
+    }
+    g_object_set_data_full (G_OBJECT (stream), PEER_START_TIME_KEY, start_time, g_free);
+
+    return TRUE;
+}
+
+/*****************************************************************************/
+
+MMPeerServer *
+mm_peer_server_new (const gchar             *socket_path,
+                    GDBusInterfaceSkeleton  *manager_skeleton,
+                    GDBusObjectManager      *object_manager,
+                    GError                 **error)
+{
+    MMPeerServer *self;
+    gchar        *address;
+    gchar        *guid;
+
+    /* Remove any stale socket of a previous run */
+    if (g_unlink (socket_path) < 0 && errno != ENOENT) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't remove stale peer socket '%s': %s",
+                     socket_path, g_strerror (errno));
+        return NULL;
+    }
+
+    self = g_slice_new0 (MMPeerServer);
+    self->socket_path = g_strdup (socket_path);
+    self->manager_skeleton = g_object_ref (manager_skeleton);
+    self->object_manager = g_object_ref (object_manager);
+
+    self->observer = g_dbus_auth_observer_new ();
+    g_signal_connect (self->observer, "allow-mechanism", G_CALLBACK (allow_mechanism), self);
+    g_signal_connect (self->observer, "authorize-authenticated-peer", G_CALLBACK (authorize_authenticated_peer), self);
+
+    address = g_strdup_printf ("unix:path=%s", socket_path);
+    guid = g_dbus_generate_guid ();
+    self->dbus_server = g_dbus_server_new_sync (address,
+                                                G_DBUS_SERVER_FLAGS_NONE,
+                                                guid,
+                                                self->observer,
+                                                NULL,
+                                                error);
+    g_free (guid);
+    g_free (address);
+    if (!self->dbus_server) {
+        g_prefix_error (error, "Couldn't listen for peers in '%s': ", socket_path);
+        mm_peer_server_free (self);
+        return NULL;
+    }
+
+    g_signal_connect (self->dbus_server, "new-connection", G_CALLBACK (new_connection), self);
+    self->object_added_id = g_signal_connect (object_manager, "object-added", G_CALLBACK (object_added), self);
+    self->object_removed_id = g_signal_connect (object_manager, "object-removed", G_CALLBACK (object_removed), self);
+    g_dbus_server_start (self->dbus_server);
+
+    mm_info ("Listening for peer connections in '%s'", socket_path);
+    return self;
+}
+
+void
+mm_peer_server_free (MMPeerServer *self)
+{
+    if (self->dbus_server) {
+        g_dbus_server_stop (self->dbus_server);
+        g_object_unref (self->dbus_server);
+        g_unlink (self->socket_path);
+    }
+
+    while (self->peers) {
+        Peer *peer = self->peers->data;
+
+        self->peers = g_list_delete_link (self->peers, self->peers);
+        g_dbus_connection_close (peer->connection, NULL, NULL, NULL);
+        peer_free (peer);
+    }
+
+    if (self->object_added_id)
+        g_signal_handler_disconnect (self->object_manager, self->object_added_id);
+    if (self->object_removed_id)
+        g_signal_handler_disconnect (self->object_manager, self->object_removed_id);
+    g_object_unref (self->object_manager);
+    g_object_unref (self->manager_skeleton);
+    g_object_unref (self->observer);
+    g_free (self->socket_path);
+    g_slice_free (MMPeerServer, self);
+}
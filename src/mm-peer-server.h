@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_PEER_SERVER_H
+#define MM_PEER_SERVER_H
+
+#include <gio/gio.h>
+
+/*
+ * Private peer-to-peer D-Bus endpoint, a UNIX socket where local clients
+ * connect directly instead of going through the bus.
+ *
+ * Peers authenticate with the EXTERNAL mechanism, i.e. with the credentials
+ * of the socket (SO_PEERCRED), and only root and the user running the daemon
+ * are accepted. Method calls are then authorized by the auth provider as
+ * those coming from the bus, with the process identified by its pid and the
+ * start time recorded when it connected.
+ *
+ * Each peer gets the manager interface and the objects of the given object
+ * manager, following the objects added and removed while connected. Objects
+ * exported on their own (bearers, SIMs, SMS and calls) are only available on
+ * the bus.
+ */
+
+typedef struct _MMPeerServer MMPeerServer;
+
+MMPeerServer *mm_peer_server_new  (const gchar             *socket_path,
+                                   GDBusInterfaceSkeleton  *manager_skeleton,
+                                   GDBusObjectManager      *object_manager,
+                                   GError                 **error);
+void          mm_peer_server_free (MMPeerServer            *self);
+
+/* Start time of the process at the other end of a peer connection, in clock
+ * ticks since boot as in /proc/<pid>/stat, or 0 if unknown */
+guint64 mm_peer_server_get_peer_start_time (GDBusConnection *connection);
+
+#endif /* MM_PEER_SERVER_H */
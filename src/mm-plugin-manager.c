@@ -27,7 +27,27 @@
 
 #include "mm-plugin-manager.h"
 #include "mm-plugin.h"
+#include "mm-port-probe.h"
+#include "mm-port-probe-cache.h"
+#include "mm-clock.h"
 #include "mm-log.h"
+#include "mm-metrics.h"
+#include "mm-profiler.h"
+
+/* Profiler category of the support checks of devices and ports */
+#define PROFILER_CATEGORY "Probing"
+
+/* Duration of the support checks, either of a whole device or of a port */
+static void
+probing_duration_observe (const gchar *scope,
+                          GTimer      *timer)
+{
+    mm_metric_observe (mm_metrics_histogram ("mm_probing_duration",
+                                             "Time taken by the support checks",
+                                             "scope",
+                                             scope),
+                       (gint64) (g_timer_elapsed (timer, NULL) * G_USEC_PER_SEC));
+}
 
 static void initable_iface_init (GInitableIface *iface);
 
@@ -52,8 +72,21 @@ struct _MMPluginManagerPrivate {
     /* Last, the generic plugin. */
     MMPlugin *generic;
 
+    /* Plugins that may support a device with a given vendor ID (key), in the
+     * same order as in the full list above; and the plugins that may support
+     * devices with vendor IDs not in the index. Built after loading the plugins
+     * so that the pre-probing filters of plugins bound to other vendors aren't
+     * run for every port. */
+    GHashTable *vendor_index;
+    GList *vendor_unbound_plugins;
+
     /* List of ongoing device support checks */
     GList *device_contexts;
+
+    /* Number of ports being probed, and device support checks waiting for
+     * the number to go down before starting to probe their ports */
+    guint n_probing_ports;
+    GQueue *slot_wait_device_contexts;
 };
 
 /*****************************************************************************/
@@ -65,10 +98,21 @@ plugin_manager_build_plugins_list (MMPluginManager *self,
                                    MMKernelDevice  *port)
 {
     GList *list = NULL;
+    GList *candidates;
     GList *l;
     gboolean supported_found = FALSE;
 
-    for (l = self->priv->plugins; l && !supported_found; l = g_list_next (l)) {
+    /* Only plugins which may support the vendor ID of the device */
+    candidates = g_hash_table_lookup (self->priv->vendor_index,
+                                      GUINT_TO_POINTER ((guint) mm_device_get_vendor (device)));
+    if (!candidates)
+        candidates = self->priv->vendor_unbound_plugins;
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] (%s/%s) skipped pre-probing filters of %u plugins not matching vendor ID",
+                                                     mm_kernel_device_get_subsystem (port),
+                                                     mm_kernel_device_get_name (port),
+                                                     g_list_length (self->priv->plugins) - g_list_length (candidates));
+
+    for (l = candidates; l && !supported_found; l = g_list_next (l)) {
         MMPluginSupportsHint hint;
 
         hint = mm_plugin_discard_port_early (MM_PLUGIN (l->data), device, port);
@@ -261,8 +305,10 @@ port_context_complete (PortContext *port_context)
     port_context->task = NULL;
 
     /* Log about the time required to complete the checks */
-    mm_dbg ("[plugin manager] task %s: finished in '%lf' seconds",
-            port_context->name, g_timer_elapsed (port_context->timer, NULL));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: finished in '%lf' seconds",
+                                                     port_context->name, g_timer_elapsed (port_context->timer, NULL));
+    mm_profiler_end (mm_kernel_device_get_name (port_context->port), PROFILER_CATEGORY);
+    probing_duration_observe ("port", port_context->timer);
 
     if (!port_context->best_plugin)
         g_task_return_new_error (task, MM_CORE_ERROR, MM_CORE_ERROR_UNSUPPORTED, "Unsupported");
@@ -277,10 +323,16 @@ static void
 port_context_supported (PortContext *port_context,
                         MMPlugin    *plugin)
 {
+    MMPortProbe *probe;
+
     g_assert (plugin);
 
-    mm_dbg ("[plugin manager] task %s: found best plugin for port (%s)",
-            port_context->name, mm_plugin_get_name (plugin));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: found best plugin for port (%s)",
+                                                     port_context->name, mm_plugin_get_name (plugin));
+
+    probe = MM_PORT_PROBE (mm_device_peek_port_probe (port_context->device, port_context->port));
+    if (probe)
+        mm_port_probe_cache_store (probe, mm_plugin_get_name (plugin));
 
     /* Found a best plugin, store it to return it */
     port_context->best_plugin = g_object_ref (plugin);
@@ -295,6 +347,21 @@ port_context_defer_ready (PortContext *port_context)
     return G_SOURCE_REMOVE;
 }
 
+/* Retries right away a support check waiting for the defer timeout. The
+ * probing results already gathered in the shared port probe are not asked
+ * again, so this is cheap; if the plugin still needs to wait, the port just
+ * gets deferred again. */
+static void
+port_context_resume_deferred (PortContext *port_context)
+{
+    g_assert (port_context->defer_id);
+
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: resuming deferred support check",
+                                                     port_context->name);
+    g_source_remove (port_context->defer_id);
+    port_context->defer_id = g_idle_add ((GSourceFunc) port_context_defer_ready, port_context);
+}
+
 static void
 port_context_set_suggestion (PortContext *port_context,
                              MMPlugin    *suggested_plugin)
@@ -322,8 +389,8 @@ port_context_set_suggestion (PortContext *port_context,
         port_context->defer_until_suggested = FALSE;
 
         if (suggested_plugin) {
-            mm_dbg ("[plugin manager] task %s: deferred task completed, got suggested plugin (%s)",
-                    port_context->name, mm_plugin_get_name (suggested_plugin));
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: deferred task completed, got suggested plugin (%s)",
+                                                             port_context->name, mm_plugin_get_name (suggested_plugin));
             /* Advance to the suggested plugin and re-check support there */
             port_context->suggested_plugin = g_object_ref (suggested_plugin);
             port_context->current = g_list_find (port_context->current, port_context->suggested_plugin);
@@ -333,8 +400,8 @@ port_context_set_suggestion (PortContext *port_context,
             return;
         }
 
-        mm_dbg ("[plugin manager] task %s: deferred task completed, no suggested plugin",
-                port_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: deferred task completed, no suggested plugin",
+                                                         port_context->name);
         port_context_complete (port_context);
         return;
     }
@@ -362,9 +429,17 @@ port_context_set_suggestion (PortContext *port_context,
      * should run its probing independently, and we'll later decide
      * which result applies to the whole device.
      */
-    mm_dbg ("[plugin manager] task %s: got suggested plugin (%s)",
-            port_context->name, mm_plugin_get_name (suggested_plugin));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: got suggested plugin (%s)",
+                                                     port_context->name, mm_plugin_get_name (suggested_plugin));
     port_context->suggested_plugin = g_object_ref (suggested_plugin);
+
+    /* If the port was waiting to retry the support check, don't wait for the
+     * timeout to expire; the results already found in the other ports tell us
+     * which plugin to check. */
+    if (port_context->defer_id) {
+        port_context->current = g_list_find (port_context->current, port_context->suggested_plugin);
+        port_context_resume_deferred (port_context);
+    }
 }
 
 static void
@@ -386,8 +461,8 @@ port_context_unsupported (PortContext *port_context,
      * just cancel the port probing and avoid more tests.
      */
     if (port_context->suggested_plugin == plugin) {
-        mm_dbg ("[plugin manager] task %s: ignoring port unsupported by physical modem's plugin",
-                port_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: ignoring port unsupported by physical modem's plugin",
+                                                         port_context->name);
         port_context_complete (port_context);
         return;
     }
@@ -404,20 +479,22 @@ port_context_defer (PortContext *port_context)
 {
     /* Try with the suggested one after being deferred */
     if (port_context->suggested_plugin) {
-        mm_dbg ("[plugin manager] task %s: deferring support check (%s suggested)",
-                port_context->name, mm_plugin_get_name (MM_PLUGIN (port_context->suggested_plugin)));
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: deferring support check (%s suggested)",
+                                                         port_context->name, mm_plugin_get_name (MM_PLUGIN (port_context->suggested_plugin)));
         port_context->current = g_list_find (port_context->current, port_context->suggested_plugin);
     } else
-        mm_dbg ("[plugin manager] task %s: deferring support check",
-                port_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: deferring support check",
+                                                         port_context->name);
+
+    mm_profiler_begin (mm_kernel_device_get_name (port_context->port), PROFILER_CATEGORY, "deferred");
 
     /* Schedule checking support.
      *
      * In this case we don't pass a port context reference because we're able
      * to fully cancel the timeout ourselves. */
-    port_context->defer_id = g_timeout_add_seconds (DEFER_TIMEOUT_SECS,
-                                                    (GSourceFunc) port_context_defer_ready,
-                                                    port_context);
+    port_context->defer_id = mm_clock_timeout_add_seconds (DEFER_TIMEOUT_SECS,
+                                                           (GSourceFunc) port_context_defer_ready,
+                                                           port_context);
 }
 
 static void
@@ -430,8 +507,8 @@ port_context_defer_until_suggested (PortContext *port_context,
     if (port_context->suggested_plugin) {
         /* We can finish this context */
         if (port_context->suggested_plugin == plugin) {
-            mm_dbg ("[plugin manager] task %s: completed, got suggested plugin (%s)",
-                    port_context->name, mm_plugin_get_name (port_context->suggested_plugin));
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: completed, got suggested plugin (%s)",
+                                                             port_context->name, mm_plugin_get_name (port_context->suggested_plugin));
             /* Store best plugin and end operation */
             port_context->best_plugin = g_object_ref (port_context->suggested_plugin);
             port_context_complete (port_context);
@@ -439,8 +516,8 @@ port_context_defer_until_suggested (PortContext *port_context,
         }
 
         /* Recheck support in deferred task */
-        mm_dbg ("[plugin manager] task %s: re-checking support on deferred task, got suggested plugin (%s)",
-                port_context->name, mm_plugin_get_name (port_context->suggested_plugin));
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: re-checking support on deferred task, got suggested plugin (%s)",
+                                                         port_context->name, mm_plugin_get_name (port_context->suggested_plugin));
         port_context->current = g_list_find (port_context->current, port_context->suggested_plugin);
         port_context_next (port_context);
         return;
@@ -449,9 +526,10 @@ port_context_defer_until_suggested (PortContext *port_context,
     /* We are deferred until a suggested plugin is given. If last supports task
      * of a given device is finished without finding a best plugin, this task
      * will get finished reporting unsupported. */
-    mm_dbg ("[plugin manager] task %s: deferring support check until result suggested",
-            port_context->name);
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: deferring support check until result suggested",
+                                                     port_context->name);
     port_context->defer_until_suggested = TRUE;
+    mm_profiler_begin (mm_kernel_device_get_name (port_context->port), PROFILER_CATEGORY, "waiting for suggested plugin");
 }
 
 static void
@@ -464,6 +542,7 @@ plugin_supports_port_ready (MMPlugin     *plugin,
 
     /* Get supports check results */
     support_result = mm_plugin_supports_port_finish (plugin, res, &error);
+    mm_profiler_end (mm_kernel_device_get_name (port_context->port), PROFILER_CATEGORY);
     if (error) {
         g_assert_cmpuint (support_result, ==, MM_PLUGIN_SUPPORTS_PORT_UNKNOWN);
         mm_warn ("[plugin manager] task %s: error when checking support with plugin '%s': '%s'",
@@ -515,8 +594,9 @@ port_context_next (PortContext *port_context)
      * async method because we want to make sure the context is still valid
      * once the method finishes. */
     plugin = MM_PLUGIN (port_context->current->data);
-    mm_dbg ("[plugin manager] task %s: checking with plugin '%s'",
-            port_context->name, mm_plugin_get_name (plugin));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: checking with plugin '%s'",
+                                                     port_context->name, mm_plugin_get_name (plugin));
+    mm_profiler_begin (mm_kernel_device_get_name (port_context->port), PROFILER_CATEGORY, mm_plugin_get_name (plugin));
     mm_plugin_supports_port (plugin,
                              port_context->device,
                              port_context->port,
@@ -537,7 +617,7 @@ port_context_cancel (PortContext *port_context)
     if (g_cancellable_is_cancelled (port_context->cancellable))
         return FALSE;
 
-    mm_dbg ("[plugin manager) task %s: cancellation requested",
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager) task %s: cancellation requested",
             port_context->name);
 
     /* The port context is cancelled now */
@@ -595,31 +675,31 @@ port_context_run (MMPluginManager     *self,
         gboolean  suggested_found = FALSE;
         GList    *l;
 
-        mm_dbg ("[plugin manager] task %s: found '%u' plugins to try",
-                port_context->name, g_list_length (port_context->plugins));
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: found '%u' plugins to try",
+                                                         port_context->name, g_list_length (port_context->plugins));
 
         for (l = port_context->plugins; l; l = g_list_next (l)) {
             MMPlugin *plugin;
 
             plugin = MM_PLUGIN (l->data);
             if (suggested_found) {
-                mm_dbg ("[plugin manager] task %s: may try with plugin '%s'",
-                        port_context->name, mm_plugin_get_name (plugin));
+                mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: may try with plugin '%s'",
+                                                                 port_context->name, mm_plugin_get_name (plugin));
                 continue;
             }
             if (suggested && l == port_context->current) {
                 suggested_found = TRUE;
-                mm_dbg ("[plugin manager] task %s: will try with plugin '%s' (suggested)",
-                        port_context->name, mm_plugin_get_name (plugin));
+                mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: will try with plugin '%s' (suggested)",
+                                                                 port_context->name, mm_plugin_get_name (plugin));
                 continue;
             }
             if (suggested && !suggested_found) {
-                mm_dbg ("[plugin manager] task %s: won't try with plugin '%s' (skipped)",
-                        port_context->name, mm_plugin_get_name (plugin));
+                mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: won't try with plugin '%s' (skipped)",
+                                                                 port_context->name, mm_plugin_get_name (plugin));
                 continue;
             }
-            mm_dbg ("[plugin manager] task %s: will try with plugin '%s'",
-                    port_context->name, mm_plugin_get_name (plugin));
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: will try with plugin '%s'",
+                                                             port_context->name, mm_plugin_get_name (plugin));
         }
     }
 
@@ -632,7 +712,7 @@ port_context_run (MMPluginManager     *self,
      * best plugin found for the port. */
     port_context->task = g_task_new (self, port_context->cancellable, callback, user_data);
 
-    mm_dbg ("[plugin manager) task %s: started", port_context->name);
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager) task %s: started", port_context->name);
 
     /* Go probe with the first plugin */
     port_context_next (port_context);
@@ -655,6 +735,9 @@ port_context_new (MMPluginManager *self,
     /* Set context name */
     port_context->name = g_strdup_printf ("%s,%s", parent_name, mm_kernel_device_get_name (port));
 
+    /* Show the timeline of the port along with the one of its device */
+    mm_profiler_set_track_group (mm_kernel_device_get_name (port), mm_device_get_uid (device));
+
     return port_context;
 }
 
@@ -671,6 +754,17 @@ port_context_new (MMPluginManager *self,
 /* The wait time we define must always be less than the probing time */
 G_STATIC_ASSERT (MIN_WAIT_TIME_MSECS < MIN_PROBING_TIME_MSECS);
 
+/* Time without new ports after which the device is considered settled, even
+ * if the min wait time hasn't expired yet */
+#define QUIET_TIME_MSECS 500
+
+G_STATIC_ASSERT (QUIET_TIME_MSECS < MIN_WAIT_TIME_MSECS);
+
+/* Max number of ports probed at the same time, over all devices. Devices
+ * start probing all their ports at once, as long as they fit; a device with
+ * more ports than this only starts once nothing else is being probed. */
+#define MAX_PROBING_PORTS 32
+
 /*
  * Device context
  *
@@ -706,6 +800,12 @@ struct _DeviceContext {
     guint min_wait_time_id;
     /* Port support check contexts waiting to be run after min wait time */
     GList *wait_port_contexts;
+    /* Quiet time. Rearmed every time a new port is grabbed while waiting; if it
+     * expires, the min wait time is considered elapsed. */
+    guint quiet_time_id;
+    /* Number of ports the device is known to expose, or 0 if unknown. Once
+     * all of them are grabbed, the min wait time is considered elapsed. */
+    guint expected_ports;
 
     /* Minimum probing_time. The device support check task cannot be finished
      * before this timeout expires. Once the timeout is expired, the id is reset
@@ -720,8 +820,16 @@ struct _DeviceContext {
 
     /* Port support check contexts being run */
     GList *port_contexts;
+
+    /* Number of ports accounted in the plugin manager while probing, and
+     * whether the context is waiting for its turn to start probing */
+    guint n_probing_ports;
+    gboolean waiting_slots;
 };
 
+static void device_context_launch   (DeviceContext *device_context);
+static void device_context_continue (DeviceContext *device_context);
+
 static void
 device_context_unref (DeviceContext *device_context)
 {
@@ -732,6 +840,7 @@ device_context_unref (DeviceContext *device_context)
         g_assert (!device_context->released_id);
         g_assert (!device_context->min_wait_time_id);
         g_assert (!device_context->min_probing_time_id);
+        g_assert (!device_context->quiet_time_id);
         g_assert (!device_context->port_contexts);
 
         /* The device support check task must have been completed previously */
@@ -809,8 +918,10 @@ device_context_complete (DeviceContext *device_context)
     device_context->task = NULL;
 
     /* Log about the time required to complete the checks */
-    mm_dbg ("[plugin manager] task %s: finished in '%lf' seconds",
-            device_context->name, g_timer_elapsed (device_context->timer, NULL));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: finished in '%lf' seconds",
+                                                     device_context->name, g_timer_elapsed (device_context->timer, NULL));
+    mm_profiler_end (mm_device_get_uid (device_context->device), PROFILER_CATEGORY);
+    probing_duration_observe ("device", device_context->timer);
 
     /* Remove signal handlers */
     if (device_context->grabbed_id) {
@@ -822,6 +933,33 @@ device_context_complete (DeviceContext *device_context)
         device_context->released_id = 0;
     }
 
+    /* Let other devices probe their ports */
+    g_assert (!device_context->waiting_slots);
+    if (device_context->n_probing_ports) {
+        MMPluginManager *self = MM_PLUGIN_MANAGER (device_context->self);
+
+        self->priv->n_probing_ports -= device_context->n_probing_ports;
+        device_context->n_probing_ports = 0;
+
+        while (!g_queue_is_empty (self->priv->slot_wait_device_contexts)) {
+            DeviceContext *next;
+            guint n;
+
+            next = g_queue_peek_head (self->priv->slot_wait_device_contexts);
+            n = g_list_length (next->wait_port_contexts);
+            if (self->priv->n_probing_ports > 0 && self->priv->n_probing_ports + n > MAX_PROBING_PORTS)
+                break;
+
+            g_queue_pop_head (self->priv->slot_wait_device_contexts);
+            next->waiting_slots = FALSE;
+            device_context_launch (next);
+            /* All ports may have gone while waiting */
+            if (!next->port_contexts)
+                device_context_continue (next);
+            device_context_unref (next);
+        }
+    }
+
     /* Remove timeouts, if still around */
     if (device_context->min_wait_time_id) {
         g_source_remove (device_context->min_wait_time_id);
@@ -831,6 +969,21 @@ device_context_complete (DeviceContext *device_context)
         g_source_remove (device_context->min_probing_time_id);
         device_context->min_probing_time_id = 0;
     }
+    if (device_context->quiet_time_id) {
+        g_source_remove (device_context->quiet_time_id);
+        device_context->quiet_time_id = 0;
+    }
+
+    /* Remember how many ports the device has, so that next time we don't need
+     * to wait for more */
+    if (device_context->best_plugin && !g_cancellable_is_cancelled (device_context->cancellable)) {
+        GList *probes;
+
+        probes = mm_device_peek_port_probe_list (device_context->device);
+        if (probes)
+            mm_port_probe_cache_store_n_ports (mm_port_probe_peek_port (MM_PORT_PROBE (probes->data)),
+                                               g_list_length (probes));
+    }
 
     /* Task completion */
     if (!device_context->best_plugin)
@@ -882,14 +1035,14 @@ device_context_set_best_plugin (DeviceContext *device_context,
          * suggested), we'll end up arriving here. Don't ignore it, it may well
          * be a wwan port that we do need to grab. */
         if (device_context->best_plugin) {
-            mm_dbg ("[plugin manager] task %s: assuming port can be handled by the '%s' plugin",
-                    port_context->name, mm_plugin_get_name (device_context->best_plugin));
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: assuming port can be handled by the '%s' plugin",
+                                                             port_context->name, mm_plugin_get_name (device_context->best_plugin));
             return;
         }
 
         /* Unsupported error, this is generic when we cannot find a plugin */
-        mm_dbg ("[plugin manager] task %s: not supported by any plugin" ,
-                port_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: not supported by any plugin" ,
+                                                         port_context->name);
 
         /* Tell the device to ignore this port */
         mm_device_ignore_port (device_context->device, port_context->port);
@@ -909,8 +1062,8 @@ device_context_set_best_plugin (DeviceContext *device_context,
          device_context->best_plugin != best_plugin)) {
         /* Only log best plugin if it's not the generic one */
         if (!g_str_equal (mm_plugin_get_name (best_plugin), MM_PLUGIN_GENERIC_NAME))
-            mm_dbg ("[plugin manager] task %s: found best plugin: %s",
-                    port_context->name, mm_plugin_get_name (best_plugin));
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: found best plugin: %s",
+                                                             port_context->name, mm_plugin_get_name (best_plugin));
         /* Store and suggest this plugin also to other port probes */
         device_context->best_plugin = g_object_ref (best_plugin);
         device_context_suggest_plugin (device_context, port_context, best_plugin);
@@ -962,8 +1115,8 @@ device_context_set_best_plugin (DeviceContext *device_context,
     }
 
     /* Device plugin equal to best plugin */
-    mm_dbg ("[plugin manager] task %s: best plugin matches device reported one: %s",
-            port_context->name, mm_plugin_get_name (best_plugin));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: best plugin matches device reported one: %s",
+                                                     port_context->name, mm_plugin_get_name (best_plugin));
 }
 
 static void
@@ -974,9 +1127,13 @@ device_context_continue (DeviceContext *device_context)
     guint    n = 0;
     guint    n_active = 0;
 
+    /* Nothing to do until probing starts */
+    if (device_context->waiting_slots)
+        return;
+
     /* If there are no running port contexts around, we're free to finish */
     if (!device_context->port_contexts) {
-        mm_dbg ("[plugin manager] task %s: no more ports to probe", device_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: no more ports to probe", device_context->name);
         device_context_complete (device_context);
         return;
     }
@@ -1001,16 +1158,29 @@ device_context_continue (DeviceContext *device_context)
     }
 
     g_assert (n > 0 && s);
-    mm_dbg ("[plugin Manager] task %s: still %u running probes (%u active): %s",
-            device_context->name, n, n_active, s->str);
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin Manager] task %s: still %u running probes (%u active): %s",
+                                                     device_context->name, n, n_active, s->str);
     g_string_free (s, TRUE);
 
     if (n_active == 0) {
-        mm_dbg ("[plugin manager] task %s: no active tasks to probe", device_context->name);
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: no active tasks to probe", device_context->name);
         device_context_suggest_plugin (device_context, NULL, NULL);
     }
 }
 
+static void
+device_context_resume_deferred (DeviceContext *device_context)
+{
+    GList *l;
+
+    for (l = device_context->port_contexts; l; l = g_list_next (l)) {
+        PortContext *port_context = l->data;
+
+        if (port_context->defer_id)
+            port_context_resume_deferred (port_context);
+    }
+}
+
 static void
 port_context_run_ready (MMPluginManager    *self,
                         GAsyncResult       *res,
@@ -1043,6 +1213,11 @@ port_context_run_ready (MMPluginManager    *self,
                                                            common->port_context);
     port_context_unref (common->port_context);
 
+    /* Ports deferred because a plugin asked to retry are usually waiting for
+     * something done in a sibling port (e.g. the custom init run in the first
+     * interface), so once a sibling is resolved retry them right away */
+    device_context_resume_deferred (common->device_context);
+
     /* Continue the device context logic */
     device_context_continue (common->device_context);
 
@@ -1055,7 +1230,7 @@ device_context_min_probing_time_elapsed (DeviceContext *device_context)
 {
     device_context->min_probing_time_id = 0;
 
-    mm_dbg ("[plugin manager] task %s: min probing time elapsed", device_context->name);
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: min probing time elapsed", device_context->name);
 
     /* Wakeup the device context logic */
     device_context_continue (device_context);
@@ -1097,8 +1272,8 @@ device_context_run_port_context (DeviceContext *device_context,
     g_list_free_full (plugins, g_object_unref);
 }
 
-static gboolean
-device_context_min_wait_time_elapsed (DeviceContext *device_context)
+static void
+device_context_launch (DeviceContext *device_context)
 {
     MMPluginManager *self;
     GList           *l;
@@ -1106,29 +1281,107 @@ device_context_min_wait_time_elapsed (DeviceContext *device_context)
     /* Recover plugin manager */
     self = MM_PLUGIN_MANAGER (device_context->self);
 
-    device_context->min_wait_time_id = 0;
-    mm_dbg ("[plugin manager] task %s: min wait time elapsed", device_context->name);
+    device_context->n_probing_ports = g_list_length (device_context->wait_port_contexts);
+    self->priv->n_probing_ports += device_context->n_probing_ports;
 
     /* Move list of port contexts out of the wait list */
     g_assert (!device_context->port_contexts);
     device_context->port_contexts = device_context->wait_port_contexts;
     device_context->wait_port_contexts = NULL;
 
+    mm_profiler_begin (mm_device_get_uid (device_context->device), PROFILER_CATEGORY, "probing ports");
+
     /* Launch supports check for each port in the Plugin Manager */
     for (l = device_context->port_contexts; l; l = g_list_next (l))
         device_context_run_port_context (device_context, (PortContext *)(l->data));
+}
+
+static gboolean
+device_context_min_wait_time_elapsed (DeviceContext *device_context)
+{
+    MMPluginManager *self;
+    guint            n;
+
+    /* Recover plugin manager */
+    self = MM_PLUGIN_MANAGER (device_context->self);
+
+    device_context->min_wait_time_id = 0;
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: min wait time elapsed", device_context->name);
+
+    /* No longer waiting for more ports */
+    if (device_context->quiet_time_id) {
+        g_source_remove (device_context->quiet_time_id);
+        device_context->quiet_time_id = 0;
+    }
+
+    /* Wait for other devices if there are already too many ports being
+     * probed */
+    n = g_list_length (device_context->wait_port_contexts);
+    if (self->priv->n_probing_ports > 0 && self->priv->n_probing_ports + n > MAX_PROBING_PORTS) {
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: waiting to probe %u ports (%u already being probed)",
+                                                         device_context->name, n, self->priv->n_probing_ports);
+        device_context->waiting_slots = TRUE;
+        g_queue_push_tail (self->priv->slot_wait_device_contexts, device_context_ref (device_context));
+        mm_profiler_begin (mm_device_get_uid (device_context->device), PROFILER_CATEGORY, "waiting for probing slots");
+        return G_SOURCE_REMOVE;
+    }
+
+    device_context_launch (device_context);
+    return G_SOURCE_REMOVE;
+}
 
+static gboolean
+device_context_quiet_time_elapsed (DeviceContext *device_context)
+{
+    device_context->quiet_time_id = 0;
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: no new ports in the last %ums, device settled",
+                                                     device_context->name, QUIET_TIME_MSECS);
+
+    /* Don't wait for the full min wait time */
+    g_assert (device_context->min_wait_time_id);
+    g_source_remove (device_context->min_wait_time_id);
+    device_context_min_wait_time_elapsed (device_context);
     return G_SOURCE_REMOVE;
 }
 
+static void
+device_context_check_settled (DeviceContext  *device_context,
+                              MMKernelDevice *port)
+{
+    /* The number of ports may be given in udev, or known from the last time
+     * the device was probed */
+    if (!device_context->expected_ports) {
+        device_context->expected_ports = mm_kernel_device_get_property_as_int (port, "ID_MM_EXPECTED_PORTS");
+        if (!device_context->expected_ports)
+            device_context->expected_ports = mm_port_probe_cache_get_n_ports (port);
+    }
+
+    if (device_context->expected_ports &&
+        g_list_length (device_context->wait_port_contexts) >= device_context->expected_ports) {
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: all %u expected ports available, device settled",
+                                                         device_context->name, device_context->expected_ports);
+        g_source_remove (device_context->min_wait_time_id);
+        device_context_min_wait_time_elapsed (device_context);
+        return;
+    }
+
+    /* Otherwise, wait until no new port shows up for a while. The min wait
+     * time stays as the upper bound. */
+    if (device_context->quiet_time_id)
+        g_source_remove (device_context->quiet_time_id);
+    device_context->quiet_time_id = mm_clock_timeout_add (QUIET_TIME_MSECS,
+                                                          (GSourceFunc) device_context_quiet_time_elapsed,
+                                                          device_context);
+}
+
 static void
 device_context_port_released (DeviceContext  *device_context,
                               MMKernelDevice *port)
 {
     PortContext *port_context;
 
-    mm_dbg ("[plugin manager] task %s: port released: %s",
-            device_context->name, mm_kernel_device_get_name (port));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: port released: %s",
+                                                     device_context->name, mm_kernel_device_get_name (port));
 
     /* Check if there's a waiting port context */
     port_context = device_context_peek_waiting_port_context (device_context, port);
@@ -1149,8 +1402,8 @@ device_context_port_released (DeviceContext  *device_context,
 
     /* This is not something worth warning. If the probing task has already
      * been finished, it will already be removed from the list */
-    mm_dbg ("[plugin manager] task %s: port wasn't found: %s",
-            device_context->name, mm_kernel_device_get_name (port));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: port wasn't found: %s",
+                                                     device_context->name, mm_kernel_device_get_name (port));
 }
 
 static void
@@ -1163,8 +1416,8 @@ device_context_port_grabbed (DeviceContext  *device_context,
     /* Recover plugin manager */
     self = MM_PLUGIN_MANAGER (device_context->self);
 
-    mm_dbg ("[plugin manager] task %s: port grabbed: %s",
-            device_context->name, mm_kernel_device_get_name (port));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: port grabbed: %s",
+                                                     device_context->name, mm_kernel_device_get_name (port));
 
     /* Ignore if for any reason we still have it in the running list */
     port_context = device_context_peek_running_port_context (device_context, port);
@@ -1188,15 +1441,22 @@ device_context_port_grabbed (DeviceContext  *device_context,
                                      device_context->device,
                                      port);
 
-    mm_dbg ("[plugin manager] task %s: new support task for port",
-            port_context->name);
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: new support task for port",
+                                                     port_context->name);
 
-    /* Îf still waiting the min wait time, store it in the waiting list */
+    /* Îf still waiting the min wait time or the turn to probe, store it in
+     * the waiting list */
+    if (device_context->waiting_slots) {
+        device_context->wait_port_contexts = g_list_prepend (device_context->wait_port_contexts, port_context);
+        return;
+    }
     if (device_context->min_wait_time_id) {
-        mm_dbg ("[plugin manager) task %s: deferred until min wait time elapsed",
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager) task %s: deferred until min wait time elapsed",
                 port_context->name);
         /* Store the port reference in the list within the device */
         device_context->wait_port_contexts = g_list_prepend (device_context->wait_port_contexts, port_context);
+        /* Launch probing earlier if the device looks settled already */
+        device_context_check_settled (device_context, port);
         return;
     }
 
@@ -1215,12 +1475,21 @@ device_context_cancel (DeviceContext *device_context)
     if (g_cancellable_is_cancelled (device_context->cancellable))
         return FALSE;
 
-    mm_dbg ("[plugin manager) task %s: cancellation requested",
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager) task %s: cancellation requested",
             device_context->name);
 
     /* The device context is cancelled now */
     g_cancellable_cancel (device_context->cancellable);
 
+    /* No longer waiting for the turn to probe */
+    if (device_context->waiting_slots) {
+        MMPluginManager *self = MM_PLUGIN_MANAGER (device_context->self);
+
+        g_queue_remove (self->priv->slot_wait_device_contexts, device_context);
+        device_context->waiting_slots = FALSE;
+        device_context_unref (device_context);
+    }
+
     /* Remove all port contexts in the waiting list. This will allow early cancellation
      * if it arrives before the min wait time has elapsed */
     if (device_context->wait_port_contexts) {
@@ -1253,6 +1522,7 @@ device_context_run (MMPluginManager     *self,
     g_assert (!device_context->released_id);
     g_assert (!device_context->min_wait_time_id);
     g_assert (!device_context->min_probing_time_id);
+    g_assert (!device_context->quiet_time_id);
 
     /* Connect to device port grabbed/released notifications from the device */
     device_context->grabbed_id = g_signal_connect_swapped (device_context->device,
@@ -1269,9 +1539,10 @@ device_context_run (MMPluginManager     *self,
      * as possible. If we don't do this, some plugin filters won't work properly,
      * like the 'forbidden-drivers' one.
      */
-    device_context->min_wait_time_id = g_timeout_add (MIN_WAIT_TIME_MSECS,
-                                                      (GSourceFunc) device_context_min_wait_time_elapsed,
-                                                      device_context);
+    device_context->min_wait_time_id = mm_clock_timeout_add (MIN_WAIT_TIME_MSECS,
+                                                             (GSourceFunc) device_context_min_wait_time_elapsed,
+                                                             device_context);
+    mm_profiler_begin (mm_device_get_uid (device_context->device), PROFILER_CATEGORY, "waiting for ports");
 
     /* Set the initial probing timeout. We force the probing time of the device to
      * be at least this amount of time, so that the kernel has enough time to
@@ -1279,9 +1550,9 @@ device_context_run (MMPluginManager     *self,
      * device has been exposed in udev, this timeout effectively means that we
      * leave up to 2s to the remaining ports to appear.
      */
-    device_context->min_probing_time_id = g_timeout_add (MIN_PROBING_TIME_MSECS,
-                                                         (GSourceFunc) device_context_min_probing_time_elapsed,
-                                                         device_context);
+    device_context->min_probing_time_id = mm_clock_timeout_add (MIN_PROBING_TIME_MSECS,
+                                                                (GSourceFunc) device_context_min_probing_time_elapsed,
+                                                                device_context);
 
     /* The full device context is now cancellable. We pass this cancellable also
      * to the inner GTask, so that if we're cancelled we always return a
@@ -1438,8 +1709,8 @@ mm_plugin_manager_device_support_check (MMPluginManager     *self,
     /* Track the device context in the list within the plugin manager. */
     self->priv->device_contexts = g_list_prepend (self->priv->device_contexts, device_context);
 
-    mm_dbg ("[plugin manager] task %s: new support task for device: %s",
-            device_context->name, mm_device_get_uid (device_context->device));
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] task %s: new support task for device: %s",
+                                                     device_context->name, mm_device_get_uid (device_context->device));
 
     /* Run device context */
     device_context_run (self,
@@ -1537,6 +1808,135 @@ out:
     return plugin;
 }
 
+static void
+build_vendor_index (MMPluginManager *self)
+{
+    GList *l;
+    GList *bound = NULL;
+
+    self->priv->vendor_index = g_hash_table_new_full (g_direct_hash,
+                                                      g_direct_equal,
+                                                      NULL,
+                                                      (GDestroyNotify) g_list_free);
+
+    /* Create an entry for every vendor ID required by any plugin */
+    for (l = self->priv->plugins; l; l = g_list_next (l)) {
+        GArray *vendor_ids;
+        guint i;
+
+        vendor_ids = mm_plugin_build_required_vendor_ids (MM_PLUGIN (l->data));
+        if (!vendor_ids) {
+            self->priv->vendor_unbound_plugins = g_list_prepend (self->priv->vendor_unbound_plugins, l->data);
+            continue;
+        }
+
+        for (i = 0; i < vendor_ids->len; i++)
+            g_hash_table_insert (self->priv->vendor_index,
+                                 GUINT_TO_POINTER ((guint) g_array_index (vendor_ids, guint16, i)),
+                                 NULL);
+        bound = g_list_prepend (bound, vendor_ids);
+    }
+    bound = g_list_reverse (bound);
+    self->priv->vendor_unbound_plugins = g_list_reverse (self->priv->vendor_unbound_plugins);
+
+    /* Fill each entry keeping the order of the full list; the plugins not bound
+     * to any vendor ID are in all of them */
+    for (l = self->priv->plugins; l; l = g_list_next (l)) {
+        GHashTableIter iter;
+        gpointer key;
+        gpointer value;
+        GArray *vendor_ids = NULL;
+
+        if (!g_list_find (self->priv->vendor_unbound_plugins, l->data)) {
+            vendor_ids = (GArray *) bound->data;
+            bound = g_list_delete_link (bound, bound);
+        }
+
+        g_hash_table_iter_init (&iter, self->priv->vendor_index);
+        while (g_hash_table_iter_next (&iter, &key, &value)) {
+            gboolean match = !vendor_ids;
+            guint i;
+
+            for (i = 0; vendor_ids && i < vendor_ids->len && !match; i++)
+                match = (GPOINTER_TO_UINT (key) == g_array_index (vendor_ids, guint16, i));
+            if (match) {
+                GList *list;
+
+                /* Only the first item changes the head of the list */
+                list = g_list_append ((GList *) value, l->data);
+                if (!value)
+                    g_hash_table_iter_replace (&iter, list);
+            }
+        }
+
+        if (vendor_ids)
+            g_array_unref (vendor_ids);
+    }
+    g_assert (!bound);
+
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] %u plugins indexed by vendor ID (%u vendor IDs)",
+                                                     g_list_length (self->priv->plugins) - g_list_length (self->priv->vendor_unbound_plugins),
+                                                     g_hash_table_size (self->priv->vendor_index));
+}
+
+static void
+register_plugin (MMPluginManager *self,
+                 MMPlugin *plugin)
+{
+    if (g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME))
+        /* Generic plugin */
+        self->priv->generic = plugin;
+    else
+        /* Vendor specific plugin */
+        self->priv->plugins = g_list_append (self->priv->plugins, plugin);
+}
+
+#if defined WITH_BUILTIN_PLUGINS
+
+static void
+load_builtin_plugins (MMPluginManager *self)
+{
+    guint i;
+
+    for (i = 0; mm_plugins_builtin[i].name; i++) {
+        MMPlugin *plugin;
+
+        plugin = mm_plugins_builtin[i].create ();
+        if (!plugin) {
+            mm_warn ("[plugin manager] could not load built-in plugin '%s': initialization failed",
+                     mm_plugins_builtin[i].name);
+            continue;
+        }
+
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] loaded built-in plugin '%s'", mm_plugin_get_name (plugin));
+        register_plugin (self, plugin);
+    }
+}
+
+static gboolean
+is_builtin_plugin_file (const gchar *fname)
+{
+    guint i;
+
+    /* Leftovers of a previous install without built-in plugins */
+    for (i = 0; mm_plugins_builtin[i].name; i++) {
+        gchar *module_name;
+        gchar *builtin_fname;
+        gboolean match;
+
+        module_name = g_strdup_printf ("mm-plugin-%s", mm_plugins_builtin[i].name);
+        builtin_fname = g_module_build_path (NULL, module_name);
+        match = g_str_equal (fname, builtin_fname);
+        g_free (builtin_fname);
+        g_free (module_name);
+        if (match)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+#endif /* WITH_BUILTIN_PLUGINS */
+
 static gboolean
 load_plugins (MMPluginManager *self,
               GError **error)
@@ -1544,27 +1944,30 @@ load_plugins (MMPluginManager *self,
     GDir *dir = NULL;
     const gchar *fname;
     gchar *plugindir_display = NULL;
+    GError *inner_error = NULL;
 
-    if (!g_module_supported ()) {
-        g_set_error (error,
-                     MM_CORE_ERROR,
-                     MM_CORE_ERROR_UNSUPPORTED,
-                     "modules are not supported on your platform!");
-        goto out;
-    }
+#if defined WITH_BUILTIN_PLUGINS
+    load_builtin_plugins (self);
+#endif
 
     /* Get printable UTF-8 string of the path */
     plugindir_display = g_filename_display_name (self->priv->plugin_dir);
 
-    mm_dbg ("[plugin manager] looking for plugins in '%s'", plugindir_display);
+    if (!g_module_supported ()) {
+        inner_error = g_error_new (MM_CORE_ERROR,
+                                   MM_CORE_ERROR_UNSUPPORTED,
+                                   "modules are not supported on your platform!");
+        goto loaded;
+    }
+
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] looking for plugins in '%s'", plugindir_display);
     dir = g_dir_open (self->priv->plugin_dir, 0, NULL);
     if (!dir) {
-        g_set_error (error,
-                     MM_CORE_ERROR,
-                     MM_CORE_ERROR_NO_PLUGINS,
-                     "plugin directory '%s' not found",
-                     plugindir_display);
-        goto out;
+        inner_error = g_error_new (MM_CORE_ERROR,
+                                   MM_CORE_ERROR_NO_PLUGINS,
+                                   "plugin directory '%s' not found",
+                                   plugindir_display);
+        goto loaded;
     }
 
     while ((fname = g_dir_read_name (dir)) != NULL) {
@@ -1574,6 +1977,13 @@ load_plugins (MMPluginManager *self,
         if (!g_str_has_suffix (fname, G_MODULE_SUFFIX))
             continue;
 
+#if defined WITH_BUILTIN_PLUGINS
+        if (is_builtin_plugin_file (fname)) {
+            mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] ignoring '%s': plugin is built-in", fname);
+            continue;
+        }
+#endif
+
         path = g_module_build_path (self->priv->plugin_dir, fname);
         plugin = load_plugin (path);
         g_free (path);
@@ -1581,32 +1991,38 @@ load_plugins (MMPluginManager *self,
         if (!plugin)
             continue;
 
-        mm_dbg ("[plugin manager] loaded plugin '%s'", mm_plugin_get_name (plugin));
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] loaded plugin '%s'", mm_plugin_get_name (plugin));
+        register_plugin (self, plugin);
+    }
 
-        if (g_str_equal (mm_plugin_get_name (plugin), MM_PLUGIN_GENERIC_NAME))
-            /* Generic plugin */
-            self->priv->generic = plugin;
+loaded:
+    /* Treat as error if we don't find any plugin; not being able to load
+     * external plugins is fine if there are built-in ones */
+    if (!self->priv->plugins && !self->priv->generic) {
+        if (inner_error)
+            g_propagate_error (error, inner_error);
         else
-            /* Vendor specific plugin */
-            self->priv->plugins = g_list_append (self->priv->plugins, plugin);
+            g_set_error (error,
+                         MM_CORE_ERROR,
+                         MM_CORE_ERROR_NO_PLUGINS,
+                         "no plugins found in plugin directory '%s'",
+                         plugindir_display);
+        goto out;
+    }
+
+    if (inner_error) {
+        mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] no external plugins loaded: %s", inner_error->message);
+        g_error_free (inner_error);
     }
 
     /* Check the generic plugin once all looped */
     if (!self->priv->generic)
         mm_warn ("[plugin manager] generic plugin not loaded");
 
-    /* Treat as error if we don't find any plugin */
-    if (!self->priv->plugins && !self->priv->generic) {
-        g_set_error (error,
-                     MM_CORE_ERROR,
-                     MM_CORE_ERROR_NO_PLUGINS,
-                     "no plugins found in plugin directory '%s'",
-                     plugindir_display);
-        goto out;
-    }
+    mm_dbg_category (MM_LOG_CATEGORY_PLUGIN_MANAGER, "[plugin manager] successfully loaded %u plugins",
+                                                     g_list_length (self->priv->plugins) + !!self->priv->generic);
 
-    mm_dbg ("[plugin manager] successfully loaded %u plugins",
-            g_list_length (self->priv->plugins) + !!self->priv->generic);
+    build_vendor_index (self);
 
 out:
     if (dir)
@@ -1635,6 +2051,7 @@ mm_plugin_manager_init (MMPluginManager *manager)
     manager->priv = G_TYPE_INSTANCE_GET_PRIVATE (manager,
                                                  MM_TYPE_PLUGIN_MANAGER,
                                                  MMPluginManagerPrivate);
+    manager->priv->slot_wait_device_contexts = g_queue_new ();
 }
 
 static void
@@ -1688,6 +2105,14 @@ dispose (GObject *object)
 {
     MMPluginManager *self = MM_PLUGIN_MANAGER (object);
 
+    /* Cleanup vendor index, it doesn't hold references */
+    if (self->priv->vendor_index) {
+        g_hash_table_unref (self->priv->vendor_index);
+        self->priv->vendor_index = NULL;
+    }
+    g_list_free (self->priv->vendor_unbound_plugins);
+    self->priv->vendor_unbound_plugins = NULL;
+
     /* Cleanup list of plugins */
     if (self->priv->plugins) {
         g_list_free_full (self->priv->plugins, (GDestroyNotify)g_object_unref);
@@ -1698,6 +2123,14 @@ dispose (GObject *object)
     g_free (self->priv->plugin_dir);
     self->priv->plugin_dir = NULL;
 
+    /* Device contexts waiting to probe hold a reference to the manager, so
+     * there can't be any left */
+    if (self->priv->slot_wait_device_contexts) {
+        g_assert (g_queue_is_empty (self->priv->slot_wait_device_contexts));
+        g_queue_free (self->priv->slot_wait_device_contexts);
+        self->priv->slot_wait_device_contexts = NULL;
+    }
+
     G_OBJECT_CLASS (mm_plugin_manager_parent_class)->dispose (object);
 }
 
@@ -32,9 +32,11 @@
 #include "mm-kernel-device-generic.h"
 #include "mm-port-serial-at.h"
 #include "mm-port-serial-qcdm.h"
+#include "mm-port-probe-cache.h"
 #include "mm-serial-parsers.h"
 #include "mm-private-boxed-types.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 #include "mm-daemon-enums-types.h"
 
 G_DEFINE_TYPE (MMPlugin, mm_plugin, G_TYPE_OBJECT)
@@ -126,6 +128,29 @@ mm_plugin_get_name (MMPlugin *self)
     return self->priv->name;
 }
 
+GArray *
+mm_plugin_build_required_vendor_ids (MMPlugin *self)
+{
+    GArray *vendor_ids;
+    guint i;
+
+    /* Plugins may still support devices not matching the vendor/product ID
+     * filters if they also match by vendor/product strings, see
+     * apply_pre_probing_filters() */
+    if ((!self->priv->vendor_ids && !self->priv->product_ids) ||
+        self->priv->vendor_strings ||
+        self->priv->product_strings ||
+        self->priv->forbidden_product_strings)
+        return NULL;
+
+    vendor_ids = g_array_new (FALSE, FALSE, sizeof (guint16));
+    for (i = 0; self->priv->vendor_ids && self->priv->vendor_ids[i]; i++)
+        g_array_append_val (vendor_ids, self->priv->vendor_ids[i]);
+    for (i = 0; self->priv->product_ids && self->priv->product_ids[i].l; i++)
+        g_array_append_val (vendor_ids, self->priv->product_ids[i].l);
+    return vendor_ids;
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -177,6 +202,10 @@ apply_subsystem_filter (MMPlugin       *self,
             else if (g_str_equal (self->priv->subsystems[i], "usb") &&
                      g_str_equal (subsys, "usbmisc"))
                 break;
+            /* Virtual ports are serial ports over a socket */
+            else if (g_str_equal (self->priv->subsystems[i], "tty") &&
+                     g_str_equal (subsys, "virtual"))
+                break;
         }
 
         /* If we didn't match any subsystem: unsupported */
@@ -187,32 +216,98 @@ apply_subsystem_filter (MMPlugin       *self,
     return FALSE;
 }
 
-/* Returns TRUE if the support check request was filtered out */
-static gboolean
-apply_pre_probing_filters (MMPlugin       *self,
-                           MMDevice       *device,
-                           MMKernelDevice *port,
-                           gboolean       *need_vendor_probing,
-                           gboolean       *need_product_probing)
+/* Returns the filter that discarded the list of drivers, or NULL if none */
+static const gchar *
+apply_drivers_filter (MMPlugin     *self,
+                      const gchar **drivers)
 {
-    guint16 vendor;
-    guint16 product;
-    gboolean product_filtered = FALSE;
-    gboolean vendor_filtered = FALSE;
     guint i;
 
-    *need_vendor_probing = FALSE;
-    *need_product_probing = FALSE;
+    /* If error retrieving driver: unsupported */
+    if (!drivers)
+        return "unknown drivers";
 
-    /* The plugin may specify that only some subsystems are supported. If that
-     * is the case, filter by subsystem */
-    if (apply_subsystem_filter (self, port)) {
-        mm_dbg ("(%s) [%s] filtered by subsystem",
-                self->priv->name,
-                mm_kernel_device_get_name (port));
-        return TRUE;
+    /* Filtering by allowed drivers */
+    if (self->priv->drivers) {
+        gboolean found = FALSE;
+
+        for (i = 0; self->priv->drivers[i] && !found; i++) {
+            guint j;
+
+            for (j = 0; drivers[j] && !found; j++) {
+                if (g_str_equal (drivers[j], self->priv->drivers[i]))
+                    found = TRUE;
+            }
+        }
+
+        /* If we didn't match any driver: unsupported */
+        if (!found)
+            return "drivers";
     }
 
+    /* Filtering by forbidden drivers */
+    if (self->priv->forbidden_drivers) {
+        for (i = 0; self->priv->forbidden_drivers[i]; i++) {
+            guint j;
+
+            for (j = 0; drivers[j]; j++) {
+                /* If we match a forbidden driver: unsupported */
+                if (g_str_equal (drivers[j], self->priv->forbidden_drivers[i]))
+                    return "forbidden drivers";
+            }
+        }
+    }
+
+    /* Implicit filter for forbidden QMI driver */
+    if (!self->priv->qmi) {
+        for (i = 0; drivers[i]; i++) {
+            /* If we match the QMI driver: unsupported */
+            if (g_str_equal (drivers[i], "qmi_wwan"))
+                return "implicit QMI driver";
+        }
+    }
+
+    /* Implicit filter for forbidden MBIM driver */
+    if (!self->priv->mbim) {
+        for (i = 0; drivers[i]; i++) {
+            /* If we match the MBIM driver: unsupported */
+            if (g_str_equal (drivers[i], "cdc_mbim"))
+                return "implicit MBIM driver";
+        }
+    }
+
+    return NULL;
+}
+
+/* Results of the pre-probing filters which only depend on the device, shared
+ * by all its ports */
+typedef struct {
+    /* Drivers of the device when computed; more may be added with new ports */
+    guint        n_drivers;
+    const gchar *drivers_filtered_by;
+    gboolean     vendor_filtered;
+    gboolean     product_filtered;
+    gboolean     forbidden_product_filtered;
+} DeviceFilters;
+
+#define DEVICE_FILTERS_TAG "plugin-device-filters"
+
+static void
+device_filters_free (DeviceFilters *filters)
+{
+    g_slice_free (DeviceFilters, filters);
+}
+
+static void
+device_filters_compute (MMPlugin      *self,
+                        MMDevice      *device,
+                        DeviceFilters *filters)
+{
+    const gchar **drivers;
+    guint16 vendor;
+    guint16 product;
+    guint i;
+
     /* The plugin may specify that only some drivers are supported, or that some
      * drivers are not supported. If that is the case, filter by driver.
      *
@@ -224,95 +319,13 @@ apply_pre_probing_filters (MMPlugin       *self,
      * is allowed, we won't take that as a mandatory requirement to look for the
      * QMI driver (as the plugin may handle non-QMI modems as well)
      */
+    drivers = mm_device_get_drivers (device);
+    filters->n_drivers = (drivers ? g_strv_length ((gchar **) drivers) : 0);
     if (self->priv->drivers ||
         self->priv->forbidden_drivers ||
         !self->priv->qmi ||
-        !self->priv->mbim) {
-        static const gchar *virtual_drivers [] = { "virtual", NULL };
-        const gchar **drivers;
-
-        /* Detect any modems accessible through the list of virtual ports */
-        drivers = (is_virtual_port (mm_kernel_device_get_name (port)) ?
-                   virtual_drivers :
-                   mm_device_get_drivers (device));
-
-        /* If error retrieving driver: unsupported */
-        if (!drivers) {
-            mm_dbg ("(%s) [%s] filtered as couldn't retrieve drivers",
-                    self->priv->name,
-                    mm_kernel_device_get_name (port));
-            return TRUE;
-        }
-
-        /* Filtering by allowed drivers */
-        if (self->priv->drivers) {
-            gboolean found = FALSE;
-
-            for (i = 0; self->priv->drivers[i] && !found; i++) {
-                guint j;
-
-                for (j = 0; drivers[j] && !found; j++) {
-                    if (g_str_equal (drivers[j], self->priv->drivers[i]))
-                        found = TRUE;
-                }
-            }
-
-            /* If we didn't match any driver: unsupported */
-            if (!found) {
-                mm_dbg ("(%s) [%s] filtered by drivers",
-                        self->priv->name,
-                        mm_kernel_device_get_name (port));
-                return TRUE;
-            }
-        }
-
-        /* Filtering by forbidden drivers */
-        if (self->priv->forbidden_drivers) {
-            for (i = 0; self->priv->forbidden_drivers[i]; i++) {
-                guint j;
-
-                for (j = 0; drivers[j]; j++) {
-                    /* If we match a forbidden driver: unsupported */
-                    if (g_str_equal (drivers[j], self->priv->forbidden_drivers[i])) {
-                        mm_dbg ("(%s) [%s] filtered by forbidden drivers",
-                                self->priv->name,
-                                mm_kernel_device_get_name (port));
-                        return TRUE;
-                    }
-                }
-            }
-        }
-
-        /* Implicit filter for forbidden QMI driver */
-        if (!self->priv->qmi) {
-            guint j;
-
-            for (j = 0; drivers[j]; j++) {
-                /* If we match the QMI driver: unsupported */
-                if (g_str_equal (drivers[j], "qmi_wwan")) {
-                    mm_dbg ("(%s) [%s] filtered by implicit QMI driver",
-                            self->priv->name,
-                            mm_kernel_device_get_name (port));
-                    return TRUE;
-                }
-            }
-        }
-
-        /* Implicit filter for forbidden MBIM driver */
-        if (!self->priv->mbim) {
-            guint j;
-
-            for (j = 0; drivers[j]; j++) {
-                /* If we match the MBIM driver: unsupported */
-                if (g_str_equal (drivers[j], "cdc_mbim")) {
-                    mm_dbg ("(%s) [%s] filtered by implicit MBIM driver",
-                            self->priv->name,
-                            mm_kernel_device_get_name (port));
-                    return TRUE;
-                }
-            }
-        }
-    }
+        !self->priv->mbim)
+        filters->drivers_filtered_by = apply_drivers_filter (self, drivers);
 
     vendor = mm_device_get_vendor (device);
     product = mm_device_get_product (device);
@@ -322,7 +335,7 @@ apply_pre_probing_filters (MMPlugin       *self,
     if (self->priv->vendor_ids) {
         /* If we didn't get any vendor: filtered */
         if (!vendor)
-            vendor_filtered = TRUE;
+            filters->vendor_filtered = TRUE;
         else {
             for (i = 0; self->priv->vendor_ids[i]; i++)
                 if (vendor == self->priv->vendor_ids[i])
@@ -330,7 +343,7 @@ apply_pre_probing_filters (MMPlugin       *self,
 
             /* If we didn't match any vendor: filtered */
             if (!self->priv->vendor_ids[i])
-                vendor_filtered = TRUE;
+                filters->vendor_filtered = TRUE;
         }
     }
 
@@ -339,7 +352,7 @@ apply_pre_probing_filters (MMPlugin       *self,
     if (self->priv->product_ids) {
         /* If we didn't get any product: filtered */
         if (!product || !vendor)
-            product_filtered = TRUE;
+            filters->product_filtered = TRUE;
         else {
             for (i = 0; self->priv->product_ids[i].l; i++)
                 if (vendor == self->priv->product_ids[i].l &&
@@ -348,16 +361,109 @@ apply_pre_probing_filters (MMPlugin       *self,
 
             /* If we didn't match any product: filtered */
             if (!self->priv->product_ids[i].l)
-                product_filtered = TRUE;
+                filters->product_filtered = TRUE;
         }
 
         /* When both vendor ids and product ids are given, it may be the case that
          * we're allowing a full VID1 and only a subset of another VID2, so try to
          * handle that properly. */
-        if (vendor_filtered && !product_filtered)
-            vendor_filtered = FALSE;
-        if (product_filtered && self->priv->vendor_ids && !vendor_filtered)
-            product_filtered = FALSE;
+        if (filters->vendor_filtered && !filters->product_filtered)
+            filters->vendor_filtered = FALSE;
+        if (filters->product_filtered && self->priv->vendor_ids && !filters->vendor_filtered)
+            filters->product_filtered = FALSE;
+    }
+
+    /* The plugin may specify that some product IDs are not supported. If
+     * that is the case, filter by forbidden vendor+product ID pair */
+    if (self->priv->forbidden_product_ids && product && vendor) {
+        for (i = 0; self->priv->forbidden_product_ids[i].l; i++) {
+            if (vendor == self->priv->forbidden_product_ids[i].l &&
+                product == self->priv->forbidden_product_ids[i].r) {
+                filters->forbidden_product_filtered = TRUE;
+                break;
+            }
+        }
+    }
+}
+
+/* Device filters of this plugin, computed the first time any port of the
+ * device is checked, and again only if the device got new drivers */
+static const DeviceFilters *
+device_filters_get (MMPlugin *self,
+                    MMDevice *device)
+{
+    GHashTable *table;
+    DeviceFilters *filters;
+    const gchar **drivers;
+
+    table = g_object_get_data (G_OBJECT (device), DEVICE_FILTERS_TAG);
+    if (!table) {
+        table = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) device_filters_free);
+        g_object_set_data_full (G_OBJECT (device), DEVICE_FILTERS_TAG, table, (GDestroyNotify) g_hash_table_unref);
+    }
+
+    drivers = mm_device_get_drivers (device);
+    filters = g_hash_table_lookup (table, self);
+    if (filters && filters->n_drivers == (drivers ? g_strv_length ((gchar **) drivers) : 0))
+        return filters;
+
+    filters = g_slice_new0 (DeviceFilters);
+    device_filters_compute (self, device, filters);
+    g_hash_table_replace (table, self, filters);
+    return filters;
+}
+
+/* Returns TRUE if the support check request was filtered out, giving the
+ * filter in 'filtered_by' */
+static gboolean
+apply_pre_probing_filters (MMPlugin       *self,
+                           MMDevice       *device,
+                           MMKernelDevice *port,
+                           gboolean       *need_vendor_probing,
+                           gboolean       *need_product_probing,
+                           const gchar   **filtered_by)
+{
+    const DeviceFilters *filters;
+    const gchar *drivers_filtered_by;
+    guint i;
+
+    *need_vendor_probing = FALSE;
+    *need_product_probing = FALSE;
+
+    /* The plugin may specify that only some subsystems are supported. If that
+     * is the case, filter by subsystem */
+    if (apply_subsystem_filter (self, port)) {
+        mm_dbg ("(%s) [%s] filtered by subsystem",
+                self->priv->name,
+                mm_kernel_device_get_name (port));
+        *filtered_by = "subsystem";
+        return TRUE;
+    }
+
+    /* Everything depending only on the device (drivers, vendor and product
+     * IDs) is shared by all its ports */
+    filters = device_filters_get (self, device);
+
+    /* Detect any modems accessible through the list of virtual ports, which
+     * are filtered by driver as 'virtual' */
+    drivers_filtered_by = filters->drivers_filtered_by;
+    if ((self->priv->drivers ||
+         self->priv->forbidden_drivers ||
+         !self->priv->qmi ||
+         !self->priv->mbim) &&
+        is_virtual_port (mm_kernel_device_get_name (port))) {
+        static const gchar *virtual_drivers [] = { "virtual", NULL };
+
+        drivers_filtered_by = apply_drivers_filter (self, virtual_drivers);
+    }
+
+    if (drivers_filtered_by) {
+        mm_dbg ("(%s) [%s] filtered by %s",
+                self->priv->name,
+                mm_kernel_device_get_name (port),
+                drivers_filtered_by);
+        *filtered_by = drivers_filtered_by;
+        return TRUE;
     }
 
     /* If we got filtered by vendor or product IDs; mark it as unsupported only if:
@@ -365,7 +471,7 @@ apply_pre_probing_filters (MMPlugin       *self,
      *      doesn't have explicit vendor/product strings
      *   b) the port is NOT an AT port which we can use for AT probing
      */
-    if ((vendor_filtered || product_filtered) &&
+    if ((filters->vendor_filtered || filters->product_filtered) &&
         ((!self->priv->vendor_strings &&
           !self->priv->product_strings &&
           !self->priv->forbidden_product_strings) ||
@@ -374,21 +480,16 @@ apply_pre_probing_filters (MMPlugin       *self,
         mm_dbg ("(%s) [%s] filtered by vendor/product IDs",
                 self->priv->name,
                 mm_kernel_device_get_name (port));
+        *filtered_by = "vendor/product IDs";
         return TRUE;
     }
 
-    /* The plugin may specify that some product IDs are not supported. If
-     * that is the case, filter by forbidden vendor+product ID pair */
-    if (self->priv->forbidden_product_ids && product && vendor) {
-        for (i = 0; self->priv->forbidden_product_ids[i].l; i++) {
-            if (vendor == self->priv->forbidden_product_ids[i].l &&
-                product == self->priv->forbidden_product_ids[i].r) {
-                mm_dbg ("(%s) [%s] filtered by forbidden vendor/product IDs",
-                        self->priv->name,
-                        mm_kernel_device_get_name (port));
-                return TRUE;
-            }
-        }
+    if (filters->forbidden_product_filtered) {
+        mm_dbg ("(%s) [%s] filtered by forbidden vendor/product IDs",
+                self->priv->name,
+                mm_kernel_device_get_name (port));
+        *filtered_by = "forbidden vendor/product IDs";
+        return TRUE;
     }
 
     /* Check if we need vendor/product string probing
@@ -399,8 +500,8 @@ apply_pre_probing_filters (MMPlugin       *self,
      * In other words, don't require vendor/product string probing if the plugin
      * already had vendor/product ID filters and we actually passed those. */
     if ((!self->priv->vendor_ids && !self->priv->product_ids) ||
-        vendor_filtered ||
-        product_filtered) {
+        filters->vendor_filtered ||
+        filters->product_filtered) {
         /* If product strings related filters around, we need to probe for both
          * vendor and product strings */
         if (self->priv->product_strings ||
@@ -427,6 +528,7 @@ apply_pre_probing_filters (MMPlugin       *self,
             mm_dbg ("(%s) [%s] filtered by udev tags",
                     self->priv->name,
                     mm_kernel_device_get_name (port));
+            *filtered_by = "udev tags";
             return TRUE;
         }
     }
@@ -594,6 +696,33 @@ port_probe_run_context_free (PortProbeRunContext *ctx)
     g_slice_free (PortProbeRunContext, ctx);
 }
 
+static MMPluginSupportsResult
+check_probe_results (MMPlugin        *self,
+                     MMDevice        *device,
+                     MMPortProbeFlag  flags,
+                     MMPortProbe     *probe)
+{
+    GList *l;
+
+    /* Apply post probing filters */
+    if (apply_post_probing_filters (self, flags, probe))
+        return MM_PLUGIN_SUPPORTS_PORT_UNSUPPORTED;
+
+    /* Port is supported! If we were looking for AT ports, and the port is AT,
+     * and we were told that only one AT port is expected, cancel AT probings
+     * in the other available support tasks of the SAME device. */
+    if (self->priv->single_at &&
+        flags & MM_PORT_PROBE_AT &&
+        mm_port_probe_is_at (probe)) {
+        for (l = mm_device_peek_port_probe_list (device); l; l = g_list_next (l)) {
+            if (l->data != probe)
+                mm_port_probe_run_cancel_at_probing (MM_PORT_PROBE (l->data));
+        }
+    }
+
+    return MM_PLUGIN_SUPPORTS_PORT_SUPPORTED;
+}
+
 static void
 port_probe_run_ready (MMPortProbe *probe,
                       GAsyncResult *probe_result,
@@ -602,8 +731,15 @@ port_probe_run_ready (MMPortProbe *probe,
     GError *error = NULL;
     MMPluginSupportsResult result = MM_PLUGIN_SUPPORTS_PORT_UNKNOWN;
     PortProbeRunContext *ctx;
+    gboolean run;
 
-    if (!mm_port_probe_run_finish (probe, probe_result, &error)) {
+    run = mm_port_probe_run_finish (probe, probe_result, &error);
+
+    /* Forget cached results which the probing didn't confirm */
+    ctx = g_task_get_task_data (task);
+    mm_port_probe_cache_check (probe, ctx->self->priv->name);
+
+    if (!run) {
         /* Probing failed saying the port is unsupported. This is not to be
          * treated as a generic error, the plugin is just telling us as nicely
          * as it can that the port is not supported, so don't warn these cases.
@@ -626,31 +762,8 @@ port_probe_run_ready (MMPortProbe *probe,
         return;
     }
 
-    /* Probing succeeded, recover context */
-    ctx = g_task_get_task_data (task);
-
-    /* Apply post probing filters */
-    if (!apply_post_probing_filters (ctx->self, ctx->flags, probe)) {
-        /* Port is supported! */
-        result = MM_PLUGIN_SUPPORTS_PORT_SUPPORTED;
-
-        /* If we were looking for AT ports, and the port is AT,
-         * and we were told that only one AT port is expected, cancel AT
-         * probings in the other available support tasks of the SAME
-         * device. */
-        if (ctx->self->priv->single_at &&
-            ctx->flags & MM_PORT_PROBE_AT &&
-            mm_port_probe_is_at (probe)) {
-            GList *l;
-
-            for (l = mm_device_peek_port_probe_list (ctx->device); l; l = g_list_next (l)) {
-                if (l->data != probe)
-                    mm_port_probe_run_cancel_at_probing (MM_PORT_PROBE (l->data));
-            }
-        }
-    } else
-        /* Filtered by post probing filters */
-        result = MM_PLUGIN_SUPPORTS_PORT_UNSUPPORTED;
+    /* Probing succeeded */
+    result = check_probe_results (ctx->self, ctx->device, ctx->flags, probe);
 
 out:
     /* Complete action */
@@ -687,6 +800,9 @@ mm_plugin_supports_port (MMPlugin            *self,
     gboolean need_product_probing;
     MMPortProbeFlag probe_run_flags;
     gchar *probe_list_str;
+    const gchar *filtered_by = NULL;
+    gboolean filtered;
+    gint64 filters_start = 0;
 
     g_return_if_fail (MM_IS_PLUGIN (self));
     g_return_if_fail (MM_IS_DEVICE (device));
@@ -696,11 +812,23 @@ mm_plugin_supports_port (MMPlugin            *self,
     task = g_task_new (self, cancellable, callback, user_data);
 
     /* Apply filters before launching the probing */
-    if (apply_pre_probing_filters (self,
-                                   device,
-                                   port,
-                                   &need_vendor_probing,
-                                   &need_product_probing)) {
+    if (mm_profiler_is_running ())
+        filters_start = g_get_monotonic_time ();
+    filtered = apply_pre_probing_filters (self,
+                                          device,
+                                          port,
+                                          &need_vendor_probing,
+                                          &need_product_probing,
+                                          &filtered_by);
+    if (filters_start) {
+        gchar *span_name;
+
+        span_name = g_strdup_printf ("%s: %s", self->priv->name, filtered ? filtered_by : "passed");
+        mm_profiler_add (mm_kernel_device_get_name (port), "Plugin filters", span_name,
+                         filters_start, g_get_monotonic_time ());
+        g_free (span_name);
+    }
+    if (filtered) {
         /* Filtered! */
         g_task_return_int (task, MM_PLUGIN_SUPPORTS_PORT_UNSUPPORTED);
         g_object_unref (task);
@@ -732,6 +860,24 @@ mm_plugin_supports_port (MMPlugin            *self,
         return;
     }
 
+    /* Ports with a type given in udev tags don't need AT/QCDM probing */
+    if (g_str_has_prefix (mm_kernel_device_get_subsystem (port), "tty")) {
+        if (mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_AT_PRIMARY") ||
+            mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_AT_SECONDARY")) {
+            mm_dbg ("(%s) [%s] AT port type given in udev tags",
+                    self->priv->name, mm_kernel_device_get_name (port));
+            mm_port_probe_set_result_at (probe, TRUE);
+        } else if (mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_GPS")) {
+            mm_dbg ("(%s) [%s] GPS port type given in udev tags",
+                    self->priv->name, mm_kernel_device_get_name (port));
+            mm_port_probe_set_result_at (probe, FALSE);
+            mm_port_probe_set_result_qcdm (probe, FALSE);
+        }
+    }
+
+    /* Reuse the results of the last probing done by this same plugin */
+    mm_port_probe_cache_apply (probe, self->priv->name);
+
     /* Build flags depending on what probing needed */
     probe_run_flags = MM_PORT_PROBE_NONE;
     if (!g_str_has_prefix (mm_kernel_device_get_name (port), "cdc-wdm")) {
@@ -786,6 +932,19 @@ mm_plugin_supports_port (MMPlugin            *self,
         mm_port_probe_set_result_at (probe, FALSE);
     }
 
+    /* The shared port probe may already have everything this plugin needs,
+     * gathered while checking other plugins; if so, just check the results
+     * without running the probe again */
+    if (mm_port_probe_has_results (probe, probe_run_flags)) {
+        mm_dbg ("(%s) [%s] probing results already available",
+                self->priv->name,
+                mm_kernel_device_get_name (port));
+        mm_port_probe_cache_check (probe, self->priv->name);
+        g_task_return_int (task, check_probe_results (self, device, probe_run_flags, probe));
+        g_object_unref (task);
+        return;
+    }
+
     /* Setup async call context */
     ctx = g_slice_new0 (PortProbeRunContext);
     ctx->self   = g_object_ref (self);
@@ -824,13 +983,15 @@ mm_plugin_discard_port_early (MMPlugin       *self,
 {
     gboolean need_vendor_probing = FALSE;
     gboolean need_product_probing = FALSE;
+    const gchar *filtered_by = NULL;
 
     /* If fully filtered by pre-probing filters, port unsupported */
     if (apply_pre_probing_filters (self,
                                    device,
                                    port,
                                    &need_vendor_probing,
-                                   &need_product_probing))
+                                   &need_product_probing,
+                                   &filtered_by))
         return MM_PLUGIN_SUPPORTS_HINT_UNSUPPORTED;
 
     /* If there are no post-probing filters, this plugin is the only one (except
@@ -848,6 +1009,30 @@ mm_plugin_discard_port_early (MMPlugin       *self,
 
 /*****************************************************************************/
 
+static gboolean
+grab_port_with_udev_tags (MMBaseModem  *modem,
+                          MMPortProbe  *probe,
+                          GError      **error)
+{
+    MMKernelDevice *port;
+    MMPortType ptype;
+    MMPortSerialAtFlag pflags = MM_PORT_SERIAL_AT_FLAG_NONE;
+
+    port = mm_port_probe_peek_port (probe);
+    ptype = mm_port_probe_get_port_type (probe);
+
+    if (ptype == MM_PORT_TYPE_AT) {
+        if (mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_AT_PRIMARY"))
+            pflags = MM_PORT_SERIAL_AT_FLAG_PRIMARY;
+        else if (mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_AT_SECONDARY"))
+            pflags = MM_PORT_SERIAL_AT_FLAG_SECONDARY;
+    } else if (ptype == MM_PORT_TYPE_UNKNOWN &&
+               mm_kernel_device_get_property_as_boolean (port, "ID_MM_PORT_TYPE_GPS"))
+        ptype = MM_PORT_TYPE_GPS;
+
+    return mm_base_modem_grab_port (modem, port, ptype, pflags, error);
+}
+
 MMBaseModem *
 mm_plugin_create_modem (MMPlugin  *self,
                         MMDevice *device,
@@ -936,11 +1121,7 @@ mm_plugin_create_modem (MMPlugin  *self,
                                                                  probe,
                                                                  &inner_error);
             else
-                grabbed = mm_base_modem_grab_port (modem,
-                                                   mm_port_probe_peek_port (probe),
-                                                   mm_port_probe_get_port_type (probe),
-                                                   MM_PORT_SERIAL_AT_FLAG_NONE,
-                                                   &inner_error);
+                grabbed = grab_port_with_udev_tags (modem, probe, &inner_error);
             if (!grabbed) {
                 mm_warn ("Could not grab port (%s/%s): '%s'",
                          mm_port_probe_get_port_subsys (MM_PORT_PROBE (l->data)),
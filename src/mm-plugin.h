@@ -37,6 +37,16 @@
 #define VISIBILITY
 #endif
 
+/* Plugins linked into the daemon are built with MM_PLUGIN_BUILTIN set to
+ * their name, so that each one gets its own entry points */
+#if defined (MM_PLUGIN_BUILTIN)
+#define MM_PLUGIN_BUILTIN_SYMBOL_(symbol, name) mm_plugin_##symbol##_##name
+#define MM_PLUGIN_BUILTIN_SYMBOL(symbol, name)  MM_PLUGIN_BUILTIN_SYMBOL_ (symbol, name)
+#define mm_plugin_major_version MM_PLUGIN_BUILTIN_SYMBOL (major_version, MM_PLUGIN_BUILTIN)
+#define mm_plugin_minor_version MM_PLUGIN_BUILTIN_SYMBOL (minor_version, MM_PLUGIN_BUILTIN)
+#define mm_plugin_create        MM_PLUGIN_BUILTIN_SYMBOL (create,        MM_PLUGIN_BUILTIN)
+#endif
+
 #define MM_PLUGIN_DEFINE_MAJOR_VERSION VISIBILITY int mm_plugin_major_version = MM_PLUGIN_MAJOR_VERSION;
 #define MM_PLUGIN_DEFINE_MINOR_VERSION VISIBILITY int mm_plugin_minor_version = MM_PLUGIN_MINOR_VERSION;
 
@@ -93,6 +103,15 @@ typedef struct _MMPluginPrivate MMPluginPrivate;
 
 typedef MMPlugin *(*MMPluginCreateFunc) (void);
 
+/* Table of the plugins linked into the daemon (--with-builtin-plugins),
+ * generated at build time and terminated with an empty entry */
+typedef struct {
+    const gchar        *name;
+    MMPluginCreateFunc  create;
+} MMPluginBuiltin;
+
+extern const MMPluginBuiltin mm_plugins_builtin[];
+
 struct _MMPlugin {
     GObject parent;
     MMPluginPrivate *priv;
@@ -123,6 +142,10 @@ GType mm_plugin_get_type (void);
 
 const gchar *mm_plugin_get_name (MMPlugin *plugin);
 
+/* Vendor IDs of the only devices the plugin may ever support, as an array of
+ * guint16, or NULL if not restricted by vendor ID */
+GArray *mm_plugin_build_required_vendor_ids (MMPlugin *plugin);
+
 /* This method will run all pre-probing filters, to see if we can discard this
  * plugin from the probing logic as soon as possible. */
 MMPluginSupportsHint mm_plugin_discard_port_early (MMPlugin       *plugin,
@@ -0,0 +1,298 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-poll-scheduler.h"
+#include "mm-clock.h"
+#include "mm-log.h"
+#include "mm-loop-monitor.h"
+
+/* Seconds between the stages run on resume */
+#define RESUME_STAGE_SPACING_SEC 1
+
+typedef struct {
+    guint                 id;
+    gchar                *name;
+    MMPollSchedulerStage  stage;
+    guint                 interval;
+    guint        slack;
+    /* Monotonic time of the next run, in seconds */
+    gint64       due;
+    GSourceFunc  callback;
+    gpointer     user_data;
+} Job;
+
+/* Job id -> Job */
+static GHashTable *jobs;
+static guint       last_id;
+static guint       source_id;
+static gint64      source_due;
+static gboolean    quiesced;
+
+static void rearm (void);
+
+/*****************************************************************************/
+
+static void
+job_free (Job *job)
+{
+    g_free (job->name);
+    g_slice_free (Job, job);
+}
+
+static gint64
+now_secs (void)
+{
+    return mm_clock_get_time () / G_USEC_PER_SEC;
+}
+
+/* Earliest wakeup of other jobs in the [ideal - slack, ideal] window, or the
+ * ideal time itself if there is none */
+static gint64
+find_due (Job    *job,
+          gint64  now,
+          gint64  ideal)
+{
+    GHashTableIter  iter;
+    Job            *other;
+    gint64          earliest;
+    gint64          best;
+
+    earliest = MAX (ideal - (gint64) job->slack, now + 1);
+    best = ideal;
+
+    g_hash_table_iter_init (&iter, jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &other)) {
+        if (other != job && other->due >= earliest && other->due < best)
+            best = other->due;
+    }
+    return best;
+}
+
+static gboolean
+dispatch_cb (void)
+{
+    GHashTableIter  iter;
+    Job            *job;
+    GArray         *due_ids;
+    gint64          now;
+    guint           i;
+
+    source_id = 0;
+    now = now_secs ();
+
+    /* Seconds-based timeouts may fire slightly before the exact second, so
+     * anything due in the next second is run in this wakeup as well */
+    due_ids = g_array_new (FALSE, FALSE, sizeof (guint));
+    g_hash_table_iter_init (&iter, jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job)) {
+        if (job->due <= now + 1)
+            g_array_append_val (due_ids, job->id);
+    }
+
+    /* Callbacks may add or remove jobs, including themselves, so look them
+     * up again every time */
+    for (i = 0; i < due_ids->len; i++) {
+        guint id;
+        gboolean keep;
+
+        id = g_array_index (due_ids, guint, i);
+        job = g_hash_table_lookup (jobs, GUINT_TO_POINTER (id));
+        if (!job)
+            continue;
+
+        mm_loop_monitor_section_begin (job->name);
+        keep = job->callback (job->user_data);
+        mm_loop_monitor_section_end ();
+
+        if (keep == G_SOURCE_REMOVE) {
+            g_hash_table_remove (jobs, GUINT_TO_POINTER (id));
+            continue;
+        }
+
+        job = g_hash_table_lookup (jobs, GUINT_TO_POINTER (id));
+        if (job)
+            job->due = find_due (job, now, now + job->interval);
+    }
+    g_array_unref (due_ids);
+
+    rearm ();
+    return G_SOURCE_REMOVE;
+}
+
+static void
+rearm (void)
+{
+    GHashTableIter  iter;
+    Job            *job;
+    gint64          next = G_MAXINT64;
+    gint64          now;
+
+    g_hash_table_iter_init (&iter, jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+        next = MIN (next, job->due);
+
+    if (source_id) {
+        if (next == source_due && !quiesced)
+            return;
+        g_source_remove (source_id);
+        source_id = 0;
+    }
+
+    if (next == G_MAXINT64 || quiesced)
+        return;
+
+    now = now_secs ();
+    source_due = next;
+    source_id = mm_clock_timeout_add_seconds ((guint) MAX (next - now, 1),
+                                              (GSourceFunc) dispatch_cb,
+                                              NULL);
+}
+
+/*****************************************************************************/
+
+guint
+mm_poll_scheduler_add (const gchar *name,
+                       guint        interval,
+                       guint        slack,
+                       GSourceFunc  callback,
+                       gpointer     user_data)
+{
+    return mm_poll_scheduler_add_full (name,
+                                       MM_POLL_SCHEDULER_STAGE_OTHER,
+                                       interval,
+                                       slack,
+                                       callback,
+                                       user_data);
+}
+
+guint
+mm_poll_scheduler_add_full (const gchar          *name,
+                            MMPollSchedulerStage  stage,
+                            guint                 interval,
+                            guint                 slack,
+                            GSourceFunc           callback,
+                            gpointer              user_data)
+{
+    Job    *job;
+    gint64  now;
+
+    g_return_val_if_fail (interval > 0, 0);
+    g_return_val_if_fail (callback != NULL, 0);
+
+    if (G_UNLIKELY (!jobs))
+        jobs = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) job_free);
+
+    job = g_slice_new0 (Job);
+    /* Never hand out 0, it means 'no job' for the callers */
+    do {
+        job->id = ++last_id;
+    } while (!job->id || g_hash_table_contains (jobs, GUINT_TO_POINTER (job->id)));
+    job->name = g_strdup (name);
+    job->stage = stage;
+    job->interval = interval;
+    job->slack = MIN (slack, interval - 1);
+    job->callback = callback;
+    job->user_data = user_data;
+
+    now = now_secs ();
+    job->due = find_due (job, now, now + interval);
+    g_hash_table_insert (jobs, GUINT_TO_POINTER (job->id), job);
+
+    mm_dbg ("Poll job '%s' (%u) scheduled every %us, next run in %us",
+            job->name, job->id, interval, (guint) (job->due - now));
+    rearm ();
+    return job->id;
+}
+
+void
+mm_poll_scheduler_remove (guint id)
+{
+    if (!jobs || !g_hash_table_remove (jobs, GUINT_TO_POINTER (id)))
+        return;
+
+    /* If called from a callback, the wakeup is re-armed once it finishes */
+    if (source_id)
+        rearm ();
+}
+
+/*****************************************************************************/
+
+void
+mm_poll_scheduler_quiesce (void)
+{
+    if (quiesced)
+        return;
+
+    mm_dbg ("Poll jobs quiesced");
+    quiesced = TRUE;
+    if (jobs)
+        rearm ();
+}
+
+void
+mm_poll_scheduler_resume (void)
+{
+    GHashTableIter  iter;
+    Job            *job;
+    gint64          now;
+
+    if (!quiesced)
+        return;
+
+    mm_dbg ("Poll jobs resumed");
+    quiesced = FALSE;
+    if (!jobs)
+        return;
+
+    /* Whatever was due while quiesced runs now, in stages, instead of every
+     * job running at its own time */
+    now = now_secs ();
+    g_hash_table_iter_init (&iter, jobs);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &job))
+        job->due = now + 1 + (gint64) job->stage * RESUME_STAGE_SPACING_SEC;
+
+    rearm ();
+}
+
+/*****************************************************************************/
+
+static gint
+job_cmp_due (const Job *a,
+             const Job *b)
+{
+    return (a->due < b->due ? -1 : (a->due > b->due ? 1 : 0));
+}
+
+void
+mm_poll_scheduler_foreach (MMPollSchedulerForeachFunc func,
+                           gpointer                   user_data)
+{
+    GList  *list;
+    GList  *l;
+    gint64  now;
+
+    if (!jobs)
+        return;
+
+    now = now_secs ();
+    list = g_list_sort (g_hash_table_get_values (jobs), (GCompareFunc) job_cmp_due);
+    for (l = list; l; l = g_list_next (l)) {
+        Job *job = l->data;
+
+        func (job->id, job->name, job->interval, job->slack,
+              (guint) MAX (job->due - now, 0), user_data);
+    }
+    g_list_free (list);
+}
@@ -0,0 +1,69 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_POLL_SCHEDULER_H
+#define MM_POLL_SCHEDULER_H
+
+#include <glib.h>
+
+/*
+ * Periodic polling jobs of all modems, served from a single timeout source.
+ * Each run of a job may be moved up to 'slack' seconds earlier so that it
+ * coincides with the runs of other jobs, and so all of them are served in
+ * the same wakeup. The callback returns G_SOURCE_CONTINUE to keep the job
+ * scheduled or G_SOURCE_REMOVE to remove it, like a GSourceFunc.
+ */
+
+/* Default slack: a quarter of the interval */
+#define MM_POLL_SCHEDULER_DEFAULT_SLACK(interval) ((interval) / 4)
+
+/* Order in which jobs run when polling is resumed after a suspend */
+typedef enum {
+    MM_POLL_SCHEDULER_STAGE_REGISTRATION,
+    MM_POLL_SCHEDULER_STAGE_SIGNAL,
+    MM_POLL_SCHEDULER_STAGE_BEARER,
+    MM_POLL_SCHEDULER_STAGE_OTHER,
+} MMPollSchedulerStage;
+
+guint mm_poll_scheduler_add      (const gchar          *name,
+                                  guint                 interval,
+                                  guint                 slack,
+                                  GSourceFunc           callback,
+                                  gpointer              user_data);
+guint mm_poll_scheduler_add_full (const gchar          *name,
+                                  MMPollSchedulerStage  stage,
+                                  guint                 interval,
+                                  guint                 slack,
+                                  GSourceFunc           callback,
+                                  gpointer              user_data);
+void  mm_poll_scheduler_remove   (guint id);
+
+/* While quiesced, jobs are kept but none of them runs. On resume, all the
+ * jobs run right away, one stage after the other, and then keep their usual
+ * intervals from there. */
+void  mm_poll_scheduler_quiesce (void);
+void  mm_poll_scheduler_resume  (void);
+
+/* Jobs are reported ordered by the seconds remaining until their next run */
+typedef void (* MMPollSchedulerForeachFunc) (guint        id,
+                                             const gchar *name,
+                                             guint        interval,
+                                             guint        slack,
+                                             guint        remaining,
+                                             gpointer     user_data);
+void  mm_poll_scheduler_foreach (MMPollSchedulerForeachFunc func,
+                                 gpointer                   user_data);
+
+#endif /* MM_POLL_SCHEDULER_H */
@@ -15,22 +15,60 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/if_vlan.h>
+#include <linux/sockios.h>
 
 #include <ModemManager.h>
 #include <mm-errors-types.h>
 
 #include "mm-port-mbim.h"
 #include "mm-log.h"
+#include "mm-traffic-capture.h"
 
 G_DEFINE_TYPE (MMPortMbim, mm_port_mbim, MM_TYPE_PORT)
 
 struct _MMPortMbimPrivate {
     gboolean in_progress;
     MbimDevice *mbim_device;
+    gulong indicate_status_id;
 };
 
 /*****************************************************************************/
 
+static void
+device_indicate_status_cb (MbimDevice  *device,
+                           MbimMessage *message,
+                           MMPortMbim  *self)
+{
+    const guint8 *raw;
+    guint32       len = 0;
+
+    raw = mbim_message_get_raw (message, &len, NULL);
+    if (raw)
+        mm_traffic_capture_write (mm_port_get_device (MM_PORT (self)),
+                                  MM_PORT_TYPE_MBIM,
+                                  MM_TRAFFIC_CAPTURE_DIRECTION_RECEIVED,
+                                  raw,
+                                  len);
+}
+
+static void
+device_clear (MMPortMbim *self)
+{
+    if (self->priv->indicate_status_id) {
+        g_signal_handler_disconnect (self->priv->mbim_device, self->priv->indicate_status_id);
+        self->priv->indicate_status_id = 0;
+    }
+    g_clear_object (&self->priv->mbim_device);
+}
+
+/*****************************************************************************/
+
 typedef struct {
     MMPortMbim *self;
     GSimpleAsyncResult *result;
@@ -88,8 +126,14 @@ mbim_device_open_ready (MbimDevice *mbim_device,
     if (!mbim_device_open_full_finish (mbim_device, res, &error)) {
         g_clear_object (&ctx->self->priv->mbim_device);
         g_simple_async_result_take_error (ctx->result, error);
-    } else
+    } else {
+        /* libmbim doesn't expose requests and responses, only indications */
+        ctx->self->priv->indicate_status_id = g_signal_connect (mbim_device,
+                                                                MBIM_DEVICE_SIGNAL_INDICATE_STATUS,
+                                                                G_CALLBACK (device_indicate_status_cb),
+                                                                ctx->self);
         g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
+    }
 
     port_context_complete_and_free (ctx);
 }
@@ -229,7 +273,7 @@ mm_port_mbim_close (MMPortMbim *self,
                        NULL,
                        (GAsyncReadyCallback)mbim_device_close_ready,
                        ctx);
-    g_clear_object (&self->priv->mbim_device);
+    device_clear (self);
 }
 
 /*****************************************************************************/
@@ -242,6 +286,98 @@ mm_port_mbim_peek_device (MMPortMbim *self)
     return self->priv->mbim_device;
 }
 
+/*****************************************************************************/
+/* Session links
+ *
+ * The cdc_mbim driver exchanges the traffic of the session 0 untagged over
+ * the net port, and the traffic of any other session tagged with a VLAN id
+ * equal to the session id. */
+
+static gboolean
+vlan_ioctl (struct vlan_ioctl_args *args,
+            GError **error)
+{
+    gint fd;
+    gboolean done = FALSE;
+
+    fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        done = (ioctl (fd, SIOCSIFVLAN, args) == 0);
+        close (fd);
+    }
+    if (!done)
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "VLAN request failed in '%s': %s",
+                     args->device1, g_strerror (errno));
+    return done;
+}
+
+MMPort *
+mm_port_mbim_add_session_link (MMPortMbim *self,
+                               MMPort *data,
+                               guint32 session_id,
+                               GError **error)
+{
+    struct vlan_ioctl_args args;
+    GHashTable *previous;
+    MMPort *link;
+
+    g_return_val_if_fail (session_id > 0 && session_id < 4095, NULL);
+
+    /* The net port carries the traffic of all the sessions */
+    if (!mm_port_net_set_up (data, error))
+        return NULL;
+
+    memset (&args, 0, sizeof (args));
+    args.cmd = ADD_VLAN_CMD;
+    g_strlcpy (args.device1, mm_port_get_device (data), sizeof (args.device1));
+    args.u.VID = session_id;
+
+    /* The name of the new interface depends on the system VLAN settings,
+     * so look for it instead of guessing it */
+    previous = mm_port_net_list_upper_links (data);
+    if (!vlan_ioctl (&args, error)) {
+        g_hash_table_unref (previous);
+        return NULL;
+    }
+    link = mm_port_net_find_new_upper_link (data, previous);
+    g_hash_table_unref (previous);
+
+    if (!link) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't find the link created for session %u in '%s'",
+                     session_id, mm_port_get_device (data));
+        return NULL;
+    }
+
+    if (!mm_port_net_set_up (link, error)) {
+        mm_port_mbim_del_session_link (self, link);
+        g_object_unref (link);
+        return NULL;
+    }
+
+    mm_dbg ("Created link '%s' for session %u in '%s'",
+            mm_port_get_device (link), session_id, mm_port_get_device (data));
+    return link;
+}
+
+void
+mm_port_mbim_del_session_link (MMPortMbim *self,
+                               MMPort *link)
+{
+    struct vlan_ioctl_args args;
+    GError *error = NULL;
+
+    memset (&args, 0, sizeof (args));
+    args.cmd = DEL_VLAN_CMD;
+    g_strlcpy (args.device1, mm_port_get_device (link), sizeof (args.device1));
+
+    if (!vlan_ioctl (&args, &error)) {
+        mm_warn ("Couldn't delete session link: %s", error->message);
+        g_error_free (error);
+    }
+}
+
 /*****************************************************************************/
 
 MMPortMbim *
@@ -266,7 +402,7 @@ dispose (GObject *object)
     MMPortMbim *self = MM_PORT_MBIM (object);
 
     /* Clear device object */
-    g_clear_object (&self->priv->mbim_device);
+    device_clear (self);
 
     G_OBJECT_CLASS (mm_port_mbim_parent_class)->dispose (object);
 }
@@ -65,4 +65,13 @@ gboolean mm_port_mbim_close_finish (MMPortMbim *self,
 
 MbimDevice *mm_port_mbim_peek_device (MMPortMbim *self);
 
+/* Net interfaces for the sessions other than 0 in the given net port; the
+ * returned port must be deleted once the session is over */
+MMPort *mm_port_mbim_add_session_link (MMPortMbim *self,
+                                       MMPort *data,
+                                       guint32 session_id,
+                                       GError **error);
+void    mm_port_mbim_del_session_link (MMPortMbim *self,
+                                       MMPort *link);
+
 #endif /* MM_PORT_MBIM_H */
@@ -0,0 +1,333 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include <ModemManager.h>
+
+#include "mm-port-probe-cache.h"
+#include "mm-context.h"
+#include "mm-log.h"
+
+#define KEY_DRIVER  "driver"
+#define KEY_PLUGIN  "plugin"
+#define KEY_AT      "at"
+#define KEY_QCDM    "qcdm"
+#define KEY_QMI     "qmi"
+#define KEY_MBIM    "mbim"
+#define KEY_ICERA   "icera"
+#define KEY_VENDOR  "vendor"
+#define KEY_PRODUCT "product"
+#define KEY_N_PORTS "ports"
+
+/* Loaded once, from the file given in the command line */
+static GKeyFile *cache;
+static gboolean  cache_loaded;
+
+static GKeyFile *
+peek_cache (void)
+{
+    const gchar *path;
+    GError *error = NULL;
+
+    if (cache_loaded)
+        return cache;
+    cache_loaded = TRUE;
+
+    path = mm_context_get_port_probe_cache ();
+    if (!path)
+        return NULL;
+
+    cache = g_key_file_new ();
+    if (!g_key_file_load_from_file (cache, path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("Couldn't load port probe cache '%s': %s", path, error->message);
+        g_error_free (error);
+    } else
+        mm_dbg ("Loaded port probe cache '%s'", path);
+
+    return cache;
+}
+
+static gchar *
+build_group (MMKernelDevice *port)
+{
+    const gchar *uid;
+    const gchar *ifnum;
+
+    uid = mm_kernel_device_get_physdev_uid (port);
+    if (!uid)
+        return NULL;
+
+    /* The port name is not stable across reboots, the interface number is */
+    ifnum = mm_kernel_device_get_property (port, "ID_USB_INTERFACE_NUM");
+    return g_strdup_printf ("%s/%s/%04x:%04x",
+                            uid,
+                            ifnum ? ifnum : mm_kernel_device_get_name (port),
+                            mm_kernel_device_get_physdev_vid (port),
+                            mm_kernel_device_get_physdev_pid (port));
+}
+
+/* Device-wide info doesn't depend on the interface */
+static gchar *
+build_device_group (MMKernelDevice *port)
+{
+    const gchar *uid;
+
+    uid = mm_kernel_device_get_physdev_uid (port);
+    if (!uid)
+        return NULL;
+
+    return g_strdup_printf ("%s/%04x:%04x",
+                            uid,
+                            mm_kernel_device_get_physdev_vid (port),
+                            mm_kernel_device_get_physdev_pid (port));
+}
+
+static void
+save_cache (GKeyFile *keyfile)
+{
+    gchar *data;
+    gsize len;
+    GError *error = NULL;
+
+    /* The file is small, so just write it all every time */
+    data = g_key_file_to_data (keyfile, &len, NULL);
+    if (!g_file_set_contents (mm_context_get_port_probe_cache (), data, len, &error)) {
+        mm_warn ("Couldn't write port probe cache '%s': %s",
+                 mm_context_get_port_probe_cache (), error->message);
+        g_error_free (error);
+    }
+    g_free (data);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_port_probe_cache_apply (MMPortProbe *probe,
+                           const gchar *plugin_name)
+{
+    GKeyFile *keyfile;
+    MMKernelDevice *port;
+    gchar *group;
+    gchar *plugin = NULL;
+    gchar *driver = NULL;
+    gboolean applied = FALSE;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return FALSE;
+
+    port = mm_port_probe_peek_port (probe);
+    group = build_group (port);
+    if (!group || !g_key_file_has_group (keyfile, group))
+        goto out;
+
+    /* Only reuse the results in the same conditions they were found */
+    plugin = g_key_file_get_string (keyfile, group, KEY_PLUGIN, NULL);
+    driver = g_key_file_get_string (keyfile, group, KEY_DRIVER, NULL);
+    if (g_strcmp0 (plugin, plugin_name) ||
+        g_strcmp0 (driver, mm_kernel_device_get_driver (port)))
+        goto out;
+
+    /* Nothing is trusted without a cheap check that the port is still what
+     * the entry says: for AT ports the strings are preset but the AT probe
+     * still runs, which ends with the first reply to a single AT; for QCDM
+     * ports only the AT probe is skipped. QMI and MBIM probing is already a
+     * single open of the port, so it is left as is. If the check fails, the
+     * entry is dropped with mm_port_probe_cache_check(). */
+    if (g_key_file_get_boolean (keyfile, group, KEY_AT, NULL)) {
+        gchar *vendor;
+        gchar *product;
+
+        mm_dbg ("(%s/%s) revalidating cached AT probing results",
+                mm_kernel_device_get_subsystem (port),
+                mm_kernel_device_get_name (port));
+        vendor = g_key_file_get_string (keyfile, group, KEY_VENDOR, NULL);
+        product = g_key_file_get_string (keyfile, group, KEY_PRODUCT, NULL);
+        mm_port_probe_set_result_at_vendor (probe, vendor);
+        mm_port_probe_set_result_at_product (probe, product);
+        mm_port_probe_set_result_at_icera (probe, g_key_file_get_boolean (keyfile, group, KEY_ICERA, NULL));
+        g_free (vendor);
+        g_free (product);
+    } else if (g_key_file_get_boolean (keyfile, group, KEY_QCDM, NULL)) {
+        mm_dbg ("(%s/%s) revalidating cached QCDM probing results",
+                mm_kernel_device_get_subsystem (port),
+                mm_kernel_device_get_name (port));
+        mm_port_probe_set_result_at (probe, FALSE);
+    } else
+        goto out;
+
+    applied = TRUE;
+
+out:
+    g_free (driver);
+    g_free (plugin);
+    g_free (group);
+    return applied;
+}
+
+/*****************************************************************************/
+
+void
+mm_port_probe_cache_check (MMPortProbe *probe,
+                           const gchar *plugin_name)
+{
+    GKeyFile *keyfile;
+    MMKernelDevice *port;
+    gchar *group;
+    gchar *plugin = NULL;
+    gboolean valid = TRUE;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return;
+
+    port = mm_port_probe_peek_port (probe);
+    group = build_group (port);
+    if (!group || !g_key_file_has_group (keyfile, group))
+        goto out;
+
+    /* Only the entries applied to this plugin were revalidated */
+    plugin = g_key_file_get_string (keyfile, group, KEY_PLUGIN, NULL);
+    if (g_strcmp0 (plugin, plugin_name))
+        goto out;
+
+    if (g_key_file_get_boolean (keyfile, group, KEY_AT, NULL))
+        valid = (!mm_port_probe_has_results (probe, MM_PORT_PROBE_AT) || mm_port_probe_is_at (probe));
+    else if (g_key_file_get_boolean (keyfile, group, KEY_QCDM, NULL))
+        valid = (!mm_port_probe_has_results (probe, MM_PORT_PROBE_QCDM) || mm_port_probe_is_qcdm (probe));
+    else if (g_key_file_get_boolean (keyfile, group, KEY_QMI, NULL))
+        valid = (!mm_port_probe_has_results (probe, MM_PORT_PROBE_QMI) || mm_port_probe_is_qmi (probe));
+    else if (g_key_file_get_boolean (keyfile, group, KEY_MBIM, NULL))
+        valid = (!mm_port_probe_has_results (probe, MM_PORT_PROBE_MBIM) || mm_port_probe_is_mbim (probe));
+
+    if (!valid) {
+        mm_dbg ("(%s/%s) cached probing results no longer valid, dropping them",
+                mm_kernel_device_get_subsystem (port),
+                mm_kernel_device_get_name (port));
+        g_key_file_remove_group (keyfile, group, NULL);
+        save_cache (keyfile);
+    }
+
+out:
+    g_free (plugin);
+    g_free (group);
+}
+
+/*****************************************************************************/
+
+static void
+set_optional_string (GKeyFile    *keyfile,
+                     const gchar *group,
+                     const gchar *key,
+                     const gchar *value)
+{
+    if (value)
+        g_key_file_set_string (keyfile, group, key, value);
+    else
+        g_key_file_remove_key (keyfile, group, key, NULL);
+}
+
+void
+mm_port_probe_cache_store (MMPortProbe *probe,
+                           const gchar *plugin_name)
+{
+    GKeyFile *keyfile;
+    MMKernelDevice *port;
+    gchar *group;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return;
+
+    /* Net ports are never probed */
+    port = mm_port_probe_peek_port (probe);
+    if (g_str_equal (mm_kernel_device_get_subsystem (port), "net"))
+        return;
+
+    group = build_group (port);
+    if (!group)
+        return;
+
+    /* Only positive results are kept, a port found to be nothing is probed
+     * again next time */
+    if (!mm_port_probe_is_at (probe) &&
+        !mm_port_probe_is_qcdm (probe) &&
+        !mm_port_probe_is_qmi (probe) &&
+        !mm_port_probe_is_mbim (probe)) {
+        if (g_key_file_remove_group (keyfile, group, NULL))
+            save_cache (keyfile);
+        g_free (group);
+        return;
+    }
+
+    set_optional_string (keyfile, group, KEY_PLUGIN, plugin_name);
+    set_optional_string (keyfile, group, KEY_DRIVER, mm_kernel_device_get_driver (port));
+    g_key_file_set_boolean (keyfile, group, KEY_AT, mm_port_probe_is_at (probe));
+    g_key_file_set_boolean (keyfile, group, KEY_QCDM, mm_port_probe_is_qcdm (probe));
+    g_key_file_set_boolean (keyfile, group, KEY_QMI, mm_port_probe_is_qmi (probe));
+    g_key_file_set_boolean (keyfile, group, KEY_MBIM, mm_port_probe_is_mbim (probe));
+    g_key_file_set_boolean (keyfile, group, KEY_ICERA, mm_port_probe_is_icera (probe));
+    set_optional_string (keyfile, group, KEY_VENDOR, mm_port_probe_get_vendor (probe));
+    set_optional_string (keyfile, group, KEY_PRODUCT, mm_port_probe_get_product (probe));
+    g_free (group);
+
+    save_cache (keyfile);
+}
+
+/*****************************************************************************/
+
+guint
+mm_port_probe_cache_get_n_ports (MMKernelDevice *port)
+{
+    GKeyFile *keyfile;
+    gchar *group;
+    gint n_ports;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return 0;
+
+    group = build_device_group (port);
+    if (!group)
+        return 0;
+
+    n_ports = g_key_file_get_integer (keyfile, group, KEY_N_PORTS, NULL);
+    g_free (group);
+    return (n_ports > 0 ? (guint) n_ports : 0);
+}
+
+void
+mm_port_probe_cache_store_n_ports (MMKernelDevice *port,
+                                   guint           n_ports)
+{
+    GKeyFile *keyfile;
+    gchar *group;
+
+    keyfile = peek_cache ();
+    if (!keyfile)
+        return;
+
+    group = build_device_group (port);
+    if (!group)
+        return;
+
+    if (g_key_file_get_integer (keyfile, group, KEY_N_PORTS, NULL) != (gint) n_ports) {
+        g_key_file_set_integer (keyfile, group, KEY_N_PORTS, (gint) n_ports);
+        save_cache (keyfile);
+    }
+    g_free (group);
+}
@@ -0,0 +1,53 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_PORT_PROBE_CACHE_H
+#define MM_PORT_PROBE_CACHE_H
+
+#include <glib.h>
+
+#include "mm-port-probe.h"
+
+/*
+ * Results of previous port probings, kept in a key file given with
+ * --port-probe-cache so that they survive daemon restarts. Entries are keyed
+ * by the physical device uid, the USB interface number and the VID/PID of the
+ * port, and are only reused by the same plugin with the same kernel driver.
+ * Only ports found to be AT, QCDM, QMI or MBIM are kept. Without the option,
+ * nothing is cached.
+ */
+
+/* Presets the probing results of the port if the given plugin was the one
+ * selected for it last time, leaving a cheap probing to revalidate them;
+ * returns TRUE if the results were applied */
+gboolean mm_port_probe_cache_apply (MMPortProbe *probe,
+                                    const gchar *plugin_name);
+
+/* Once probing is done for the given plugin, drops the entry of the port if
+ * the revalidation failed */
+void     mm_port_probe_cache_check (MMPortProbe *probe,
+                                    const gchar *plugin_name);
+
+/* Stores the probing results of a port once a plugin is selected for it */
+void     mm_port_probe_cache_store (MMPortProbe *probe,
+                                    const gchar *plugin_name);
+
+/* Number of ports exposed by the device of the given port, as seen the last
+ * time a plugin was found for it; 0 if unknown */
+guint    mm_port_probe_cache_get_n_ports   (MMKernelDevice *port);
+void     mm_port_probe_cache_store_n_ports (MMKernelDevice *port,
+                                            guint           n_ports);
+
+#endif /* MM_PORT_PROBE_CACHE_H */
@@ -25,7 +25,9 @@
 #include <mm-errors-types.h>
 
 #include "mm-port-probe.h"
+#include "mm-clock.h"
 #include "mm-log.h"
+#include "mm-profiler.h"
 #include "mm-port-serial-at.h"
 #include "mm-port-serial.h"
 #include "mm-serial-parsers.h"
@@ -62,6 +64,9 @@
 
 G_DEFINE_TYPE (MMPortProbe, mm_port_probe, G_TYPE_OBJECT)
 
+/* Each step of a probing run is a span of this category, in the port track */
+#define PROFILER_CATEGORY "Port probing"
+
 enum {
     PROP_0,
     PROP_DEVICE,
@@ -107,6 +112,7 @@ port_probe_task_return_error_if_cancelled (MMPortProbe *self)
     self->priv->task = NULL;
 
     if (g_task_return_error_if_cancelled (task)) {
+        mm_profiler_end (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY);
         g_object_unref (task);
         return TRUE;
     }
@@ -123,6 +129,7 @@ port_probe_task_return_error (MMPortProbe *self,
 
     task = self->priv->task;
     self->priv->task = NULL;
+    mm_profiler_end (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY);
     g_task_return_error (task, error);
     g_object_unref (task);
 }
@@ -135,6 +142,7 @@ port_probe_task_return_boolean (MMPortProbe *self,
 
     task = self->priv->task;
     self->priv->task = NULL;
+    mm_profiler_end (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY);
     g_task_return_boolean (task, result);
     g_object_unref (task);
 }
@@ -345,6 +353,8 @@ typedef struct {
     gboolean at_send_lf;
     /* Number of times we tried to open the AT port */
     guint at_open_tries;
+    /* When opening the AT port first failed, in us */
+    gint64 at_open_first_failure;
     /* Custom initialization setup */
     gboolean at_custom_init_run;
     MMPortProbeAtCustomInit at_custom_init;
@@ -355,6 +365,8 @@ typedef struct {
     const MMPortProbeAtCommand *at_commands;
     /* Seconds between each AT command sent in the group */
     guint at_commands_wait_secs;
+    /* Whether vendor and product were already asked in a single command */
+    gboolean at_vendor_product_tried;
     /* Current AT Result processor */
     void (* at_result_processor) (MMPortProbe *self,
                                   GVariant *result);
@@ -468,6 +480,8 @@ wdm_probe_qmi (MMPortProbe *self)
     g_assert (self->priv->task);
     ctx = g_task_get_task_data (self->priv->task);
 
+    mm_profiler_begin (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY, "QMI");
+
 #if defined WITH_QMI
     mm_dbg ("(%s/%s) probing QMI...",
             mm_kernel_device_get_subsystem (self->priv->port),
@@ -544,6 +558,8 @@ wdm_probe_mbim (MMPortProbe *self)
     g_assert (self->priv->task);
     ctx = g_task_get_task_data (self->priv->task);
 
+    mm_profiler_begin (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY, "MBIM");
+
 #if defined WITH_MBIM
     mm_dbg ("(%s/%s) probing MBIM...",
             mm_kernel_device_get_subsystem (self->priv->port),
@@ -685,9 +701,17 @@ serial_probe_qcdm (MMPortProbe *self)
     if (port_probe_task_return_error_if_cancelled (self))
         return G_SOURCE_REMOVE;
 
+    /* Virtual ports are AT only */
+    if (g_str_equal (mm_kernel_device_get_subsystem (self->priv->port), "virtual")) {
+        mm_port_probe_set_result_qcdm (self, FALSE);
+        serial_probe_schedule (self);
+        return G_SOURCE_REMOVE;
+    }
+
     mm_dbg ("(%s/%s) probing QCDM...",
             mm_kernel_device_get_subsystem (self->priv->port),
             mm_kernel_device_get_name (self->priv->port));
+    mm_profiler_begin (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY, "QCDM");
 
     /* If open, close the AT port */
     if (ctx->serial) {
@@ -778,6 +802,29 @@ static const guint8 zerobuf[32] = {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
+/* Minimum amount of data to look at before deciding that it's binary */
+#define NON_AT_MIN_BINARY_LEN 32
+
+static gboolean
+is_binary_response (const guint8 *data, gsize len)
+{
+    gsize n_binary = 0;
+    gsize i;
+
+    if (len < NON_AT_MIN_BINARY_LEN)
+        return FALSE;
+
+    /* AT responses are text; allow some noise (e.g. garbage received when the
+     * port is opened, or non-ASCII characters in some info strings) but not
+     * a quarter of the data being control or 8-bit characters */
+    for (i = 0; i < len; i++) {
+        if ((data[i] < 0x20 && data[i] != '\r' && data[i] != '\n' && data[i] != '\t') ||
+            data[i] >= 0x7f)
+            n_binary++;
+    }
+    return (n_binary * 4 > len);
+}
+
 static gboolean
 is_non_at_response (const guint8 *data, gsize len)
 {
@@ -785,6 +832,11 @@ is_non_at_response (const guint8 *data, gsize len)
     gsize iter_len;
     gsize i;
 
+    /* Binary data (e.g. QCDM or other diagnostics protocols) comes from ports
+     * which will never reply to AT commands, no need to wait for timeouts */
+    if (is_binary_response (data, len))
+        return TRUE;
+
     /* Some devices (observed on a ZTE branded "QUALCOMM INCORPORATED" model
      * "154") spew NULLs from some ports.
      */
@@ -860,6 +912,24 @@ serial_probe_at_vendor_result_processor (MMPortProbe *self,
     mm_port_probe_set_result_at_vendor (self, NULL);
 }
 
+static void
+serial_probe_at_vendor_product_result_processor (MMPortProbe *self,
+                                                 GVariant *result)
+{
+    const gchar *vendor;
+    const gchar *product;
+
+    /* If the combined query didn't work, the separate vendor and product
+     * probings will be run next */
+    if (!result)
+        return;
+
+    g_assert (g_variant_is_of_type (result, G_VARIANT_TYPE ("(ss)")));
+    g_variant_get (result, "(&s&s)", &vendor, &product);
+    mm_port_probe_set_result_at_vendor (self, vendor);
+    mm_port_probe_set_result_at_product (self, product);
+}
+
 static void
 serial_probe_at_result_processor (MMPortProbe *self,
                                   GVariant *result)
@@ -944,7 +1014,7 @@ serial_probe_at_parse_response (MMPortSerialAt *port,
                     mm_kernel_device_get_subsystem (self->priv->port),
                     mm_kernel_device_get_name (self->priv->port),
                     ctx->at_commands_wait_secs);
-            ctx->source_id = g_timeout_add_seconds (ctx->at_commands_wait_secs, (GSourceFunc) serial_probe_at, self);
+            ctx->source_id = mm_clock_timeout_add_seconds (ctx->at_commands_wait_secs, (GSourceFunc) serial_probe_at, self);
         }
         goto out;
     }
@@ -1011,6 +1081,49 @@ static const MMPortProbeAtCommand vendor_probing[] = {
     { NULL }
 };
 
+/* Both +CGMI and +CGMM reply with a single line of info text, so when both
+ * strings are needed, try to get them in one go */
+static gboolean
+response_processor_vendor_product (const gchar *command,
+                                   const gchar *response,
+                                   gboolean last_command,
+                                   const GError *error,
+                                   GVariant **result,
+                                   GError **result_error)
+{
+    gchar **lines;
+    gchar *vendor = NULL;
+    gchar *product = NULL;
+    guint n_lines = 0;
+    guint i;
+
+    if (error)
+        return FALSE;
+
+    lines = g_strsplit_set (response, "\r\n", -1);
+    for (i = 0; lines[i]; i++) {
+        g_strstrip (lines[i]);
+        if (!lines[i][0])
+            continue;
+        if (n_lines == 0)
+            vendor = lines[i];
+        else if (n_lines == 1)
+            product = lines[i];
+        n_lines++;
+    }
+
+    /* Anything else than one line per command can't be split reliably */
+    if (n_lines == 2)
+        *result = g_variant_new ("(ss)", vendor, product);
+    g_strfreev (lines);
+    return (n_lines == 2);
+}
+
+static const MMPortProbeAtCommand vendor_product_probing[] = {
+    { "+CGMI;+CGMM", 3, response_processor_vendor_product },
+    { NULL }
+};
+
 static const MMPortProbeAtCommand product_probing[] = {
     { "+CGMM", 3, mm_port_probe_response_processor_string },
     { "+GMM",  3, mm_port_probe_response_processor_string },
@@ -1052,6 +1165,7 @@ static void
 serial_probe_schedule (MMPortProbe *self)
 {
     PortProbeRunContext *ctx;
+    const gchar         *step_name;
 
     g_assert (self->priv->task);
     ctx = g_task_get_task_data (self->priv->task);
@@ -1077,6 +1191,7 @@ serial_probe_schedule (MMPortProbe *self)
     ctx->at_result_processor   = NULL;
     ctx->at_commands           = NULL;
     ctx->at_commands_wait_secs = 0;
+    step_name = NULL;
 
     /* AT check requested and not already probed? */
     if ((ctx->flags & MM_PORT_PROBE_AT) &&
@@ -1087,6 +1202,18 @@ serial_probe_schedule (MMPortProbe *self)
         else
             ctx->at_commands = at_probing;
         ctx->at_result_processor = serial_probe_at_result_processor;
+        step_name = "AT";
+    }
+    /* Both vendor and product requested, and not already probed? */
+    else if ((ctx->flags & MM_PORT_PROBE_AT_VENDOR) &&
+             (ctx->flags & MM_PORT_PROBE_AT_PRODUCT) &&
+             !(self->priv->flags & (MM_PORT_PROBE_AT_VENDOR | MM_PORT_PROBE_AT_PRODUCT)) &&
+             !ctx->at_vendor_product_tried) {
+        /* Prepare AT vendor and product probing in a single command */
+        ctx->at_vendor_product_tried = TRUE;
+        ctx->at_result_processor = serial_probe_at_vendor_product_result_processor;
+        ctx->at_commands = vendor_product_probing;
+        step_name = "AT vendor and product";
     }
     /* Vendor requested and not already probed? */
     else if ((ctx->flags & MM_PORT_PROBE_AT_VENDOR) &&
@@ -1094,6 +1221,7 @@ serial_probe_schedule (MMPortProbe *self)
         /* Prepare AT vendor probing */
         ctx->at_result_processor = serial_probe_at_vendor_result_processor;
         ctx->at_commands = vendor_probing;
+        step_name = "AT vendor";
     }
     /* Product requested and not already probed? */
     else if ((ctx->flags & MM_PORT_PROBE_AT_PRODUCT) &&
@@ -1101,6 +1229,7 @@ serial_probe_schedule (MMPortProbe *self)
         /* Prepare AT product probing */
         ctx->at_result_processor = serial_probe_at_product_result_processor;
         ctx->at_commands = product_probing;
+        step_name = "AT product";
     }
     /* Icera support check requested and not already done? */
     else if ((ctx->flags & MM_PORT_PROBE_AT_ICERA) &&
@@ -1110,11 +1239,13 @@ serial_probe_schedule (MMPortProbe *self)
         ctx->at_commands = icera_probing;
         /* By default, wait 2 seconds between ICERA probing retries */
         ctx->at_commands_wait_secs = 2;
+        step_name = "AT Icera";
     }
 
     /* If a next AT group detected, go for it */
     if (ctx->at_result_processor &&
         ctx->at_commands) {
+        mm_profiler_begin (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY, step_name);
         ctx->source_id = g_idle_add ((GSourceFunc) serial_probe_at, self);
         return;
     }
@@ -1142,13 +1273,14 @@ serial_flash_ready (MMPortSerial *port,
 }
 
 static void
-serial_buffer_full (MMPortSerial *serial,
-                    GByteArray   *buffer,
-                    MMPortProbe  *self)
+serial_buffer_full (MMPortSerial   *serial,
+                    MMSerialBuffer *buffer,
+                    MMPortProbe    *self)
 {
     PortProbeRunContext *ctx;
 
-    if (!is_non_at_response (buffer->data, buffer->len))
+    if (!is_non_at_response (mm_serial_buffer_get_data (buffer),
+                             mm_serial_buffer_get_length (buffer)))
         return;
 
     g_assert (self->priv->task);
@@ -1180,6 +1312,73 @@ serial_parser_filter_cb (gpointer   filter,
     return TRUE;
 }
 
+/*****************************************************************************/
+/* Learned AT port open delays
+ *
+ * Some ports can't be opened right away after being exposed (e.g. nozomi).
+ * Instead of always retrying after a worst-case delay, the time it took for
+ * the port to be ready is learned for each device type (vid:pid, or driver),
+ * and the following ports of the same type are retried accordingly. Retrying
+ * at half the learned time makes the estimate converge to the actual one. */
+
+/* Total time allowed to open the port */
+#define AT_OPEN_TIMEOUT_MS 4000
+/* Initial guess of the time until the port may be opened */
+#define AT_OPEN_DEFAULT_READY_MS 2000
+#define AT_OPEN_RETRY_MIN_MS 100
+#define AT_OPEN_RETRY_MAX_MS 1000
+
+/* Profile key -> learned ready time in ms */
+static GHashTable *open_ready_times;
+
+static gchar *
+port_probe_build_profile_key (MMPortProbe *self)
+{
+    if (mm_kernel_device_get_physdev_vid (self->priv->port))
+        return g_strdup_printf ("%04x:%04x",
+                                mm_kernel_device_get_physdev_vid (self->priv->port),
+                                mm_kernel_device_get_physdev_pid (self->priv->port));
+    return g_strdup (mm_kernel_device_get_driver (self->priv->port));
+}
+
+static guint
+port_probe_get_open_retry_ms (MMPortProbe *self)
+{
+    gchar *key;
+    guint ready_ms = AT_OPEN_DEFAULT_READY_MS;
+
+    key = port_probe_build_profile_key (self);
+    if (key && open_ready_times && g_hash_table_contains (open_ready_times, key))
+        ready_ms = GPOINTER_TO_UINT (g_hash_table_lookup (open_ready_times, key));
+    g_free (key);
+
+    return CLAMP (ready_ms / 2, AT_OPEN_RETRY_MIN_MS, AT_OPEN_RETRY_MAX_MS);
+}
+
+static void
+port_probe_learn_open_ready_ms (MMPortProbe *self,
+                                guint observed_ms)
+{
+    gchar *key;
+    guint ready_ms = AT_OPEN_DEFAULT_READY_MS;
+
+    key = port_probe_build_profile_key (self);
+    if (!key)
+        return;
+
+    if (G_UNLIKELY (!open_ready_times))
+        open_ready_times = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    else if (g_hash_table_contains (open_ready_times, key))
+        ready_ms = GPOINTER_TO_UINT (g_hash_table_lookup (open_ready_times, key));
+
+    ready_ms = (ready_ms * 3 + observed_ms) / 4;
+    mm_dbg ("(%s/%s) port ready after %ums, expecting %ums for '%s' ports",
+            mm_kernel_device_get_subsystem (self->priv->port),
+            mm_kernel_device_get_name (self->priv->port),
+            observed_ms, ready_ms, key);
+    g_hash_table_replace (open_ready_times, key, GUINT_TO_POINTER (ready_ms));
+}
+
 static gboolean
 serial_open_at (MMPortProbe *self)
 {
@@ -1201,6 +1400,8 @@ serial_open_at (MMPortProbe *self)
 
         if (g_str_has_prefix (mm_kernel_device_get_subsystem (self->priv->port), "usb"))
             subsys = MM_PORT_SUBSYS_USB;
+        else if (g_str_equal (mm_kernel_device_get_subsystem (self->priv->port), "virtual"))
+            subsys = MM_PORT_SUBSYS_UNIX;
 
         ctx->serial = MM_PORT_SERIAL (mm_port_serial_at_new (mm_kernel_device_get_name (self->priv->port), subsys));
         if (!ctx->serial) {
@@ -1219,6 +1420,13 @@ serial_open_at (MMPortProbe *self)
                       MM_PORT_SERIAL_AT_REMOVE_ECHO, ctx->at_remove_echo,
                       MM_PORT_SERIAL_AT_SEND_LF,     ctx->at_send_lf,
                       NULL);
+        /* Some devices legitimately give replies longer than the default */
+        if (mm_kernel_device_get_property_as_int (self->priv->port, "ID_MM_TTY_MAX_RESPONSE_SIZE") > 0)
+            mm_port_serial_set_spew_limit (ctx->serial,
+                                           (guint) mm_kernel_device_get_property_as_int (self->priv->port, "ID_MM_TTY_MAX_RESPONSE_SIZE"));
+        if (mm_kernel_device_has_property (self->priv->port, "ID_MM_TTY_FLASH_TIME"))
+            mm_port_serial_set_flash_time (ctx->serial,
+                                           mm_kernel_device_get_property_as_int (self->priv->port, "ID_MM_TTY_FLASH_TIME"));
 
         parser = mm_serial_parser_v1_new ();
         mm_serial_parser_v1_add_filter (parser,
@@ -1232,22 +1440,29 @@ serial_open_at (MMPortProbe *self)
 
     /* Try to open the port */
     if (!mm_port_serial_open (ctx->serial, &error)) {
-        /* Abort if maximum number of open tries reached */
-        if (++ctx->at_open_tries > 4) {
+        ctx->at_open_tries++;
+        if (!ctx->at_open_first_failure)
+            ctx->at_open_first_failure = mm_clock_get_time ();
+
+        /* Abort if the port took too long to open */
+        if (mm_clock_get_time () - ctx->at_open_first_failure >= AT_OPEN_TIMEOUT_MS * 1000) {
             /* took too long to open the port; give up */
             port_probe_task_return_error (self,
                                           g_error_new (MM_CORE_ERROR,
                                                        MM_CORE_ERROR_FAILED,
-                                                       "(%s/%s) failed to open port after 4 tries",
+                                                       "(%s/%s) failed to open port after %u tries",
                                                        mm_kernel_device_get_subsystem (self->priv->port),
-                                                       mm_kernel_device_get_name (self->priv->port)));
+                                                       mm_kernel_device_get_name (self->priv->port),
+                                                       ctx->at_open_tries));
             g_clear_error (&error);
             return G_SOURCE_REMOVE;
         }
 
         if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_OPEN_FAILED_NO_DEVICE)) {
             /* this is nozomi being dumb; try again */
-            ctx->source_id = g_timeout_add_seconds (1, (GSourceFunc) serial_open_at, self);
+            ctx->source_id = mm_clock_timeout_add (port_probe_get_open_retry_ms (self),
+                                                   (GSourceFunc) serial_open_at,
+                                                   self);
             g_clear_error (&error);
             return G_SOURCE_REMOVE;
         }
@@ -1264,6 +1479,9 @@ serial_open_at (MMPortProbe *self)
     }
 
     /* success, start probing */
+    if (ctx->at_open_first_failure)
+        port_probe_learn_open_ready_ms (self, (guint) ((mm_clock_get_time () - ctx->at_open_first_failure) / 1000));
+
     ctx->buffer_full_id = g_signal_connect (ctx->serial, "buffer-full",
                                             G_CALLBACK (serial_buffer_full), self);
     mm_port_serial_flash (MM_PORT_SERIAL (ctx->serial),
@@ -1388,6 +1606,7 @@ mm_port_probe_run (MMPortProbe                *self,
                                                                         (GCallback) at_cancellable_cancel,
                                                                         g_object_ref (ctx->at_probing_cancellable),
                                                                         (GDestroyNotify) g_object_unref);
+        mm_profiler_begin (mm_kernel_device_get_name (self->priv->port), PROFILER_CATEGORY, "AT open");
         ctx->source_id = g_idle_add ((GSourceFunc) serial_open_at, self);
         return;
     }
@@ -1408,6 +1627,16 @@ mm_port_probe_run (MMPortProbe                *self,
     g_assert_not_reached ();
 }
 
+/* Whether all the given probings were already done, by any plugin */
+gboolean
+mm_port_probe_has_results (MMPortProbe     *self,
+                           MMPortProbeFlag  flags)
+{
+    g_return_val_if_fail (MM_IS_PORT_PROBE (self), FALSE);
+
+    return ((self->priv->flags & flags) == flags);
+}
+
 gboolean
 mm_port_probe_is_at (MMPortProbe *self)
 {
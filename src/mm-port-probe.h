@@ -123,6 +123,8 @@ gboolean mm_port_probe_run_finish (MMPortProbe *self,
 gboolean mm_port_probe_run_cancel_at_probing (MMPortProbe *self);
 
 /* Probing result getters */
+gboolean      mm_port_probe_has_results      (MMPortProbe *self,
+                                              MMPortProbeFlag flags);
 MMPortType    mm_port_probe_get_port_type    (MMPortProbe *self);
 gboolean      mm_port_probe_is_at            (MMPortProbe *self);
 gboolean      mm_port_probe_is_qcdm          (MMPortProbe *self);
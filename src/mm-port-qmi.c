@@ -15,6 +15,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <libqmi-glib.h>
 
@@ -23,9 +27,16 @@
 
 #include "mm-port-qmi.h"
 #include "mm-log.h"
+#include "mm-traffic-capture.h"
 
 G_DEFINE_TYPE (MMPortQmi, mm_port_qmi, MM_TYPE_PORT)
 
+/* Mux ids go from 1 up to this */
+#define QMAP_MAX_MUX_LINKS    16
+/* Downlink aggregation requested to the device */
+#define QMAP_DL_MAX_DATAGRAMS 32
+#define QMAP_DL_MAX_SIZE      32768
+
 typedef struct {
     QmiService service;
     QmiClient *client;
@@ -35,8 +46,17 @@ typedef struct {
 struct _MMPortQmiPrivate {
     gboolean opening;
     QmiDevice *qmi_device;
+    gulong indication_id;
     GList *services;
+    /* Client allocations in progress */
+    GList *allocations;
     gboolean llp_is_raw_ip;
+    /* QMAP multiplexing requested, and negotiated when opening */
+    gboolean multiplex;
+    gboolean qmap;
+    guint interface_number;
+    /* Bitmask of the mux ids in use */
+    guint32 mux_ids;
 };
 
 /*****************************************************************************/
@@ -72,21 +92,39 @@ mm_port_qmi_get_client (MMPortQmi *self,
 
 /*****************************************************************************/
 
+/* Allocations requested for the same service and flag while one is already
+ * in progress are all completed with the outcome of that one, so that we
+ * don't end up with duplicate clients; e.g. when the modem initialization and
+ * a connection attempt request the same client at the same time. */
 typedef struct {
     MMPortQmi *self;
-    GSimpleAsyncResult *result;
+    GList *results;
     ServiceInfo *info;
 } AllocateClientContext;
 
 static void
-allocate_client_context_complete_and_free (AllocateClientContext *ctx)
+allocate_client_context_complete_and_free (AllocateClientContext *ctx,
+                                           const GError *error)
 {
-    g_simple_async_result_complete (ctx->result);
+    GList *l;
+
+    ctx->self->priv->allocations = g_list_remove (ctx->self->priv->allocations, ctx);
+
+    for (l = ctx->results; l; l = g_list_next (l)) {
+        GSimpleAsyncResult *result = l->data;
+
+        if (error)
+            g_simple_async_result_set_from_error (result, error);
+        else
+            g_simple_async_result_set_op_res_gboolean (result, TRUE);
+        g_simple_async_result_complete (result);
+    }
+    g_list_free_full (ctx->results, g_object_unref);
+
     if (ctx->info) {
         g_assert (ctx->info->client == NULL);
         g_free (ctx->info);
     }
-    g_object_unref (ctx->result);
     g_object_unref (ctx->self);
     g_free (ctx);
 }
@@ -111,15 +149,15 @@ allocate_client_ready (QmiDevice *qmi_device,
         g_prefix_error (&error,
                         "Couldn't create client for service '%s': ",
                         qmi_service_get_string (ctx->info->service));
-        g_simple_async_result_take_error (ctx->result, error);
     } else {
-        g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         /* Move the service info to our internal list */
         ctx->self->priv->services = g_list_prepend (ctx->self->priv->services, ctx->info);
         ctx->info = NULL;
     }
 
-    allocate_client_context_complete_and_free (ctx);
+    allocate_client_context_complete_and_free (ctx, error);
+    if (error)
+        g_error_free (error);
 }
 
 void
@@ -131,6 +169,8 @@ mm_port_qmi_allocate_client (MMPortQmi *self,
                              gpointer user_data)
 {
     AllocateClientContext *ctx;
+    GSimpleAsyncResult *result;
+    GList *l;
 
     if (!!mm_port_qmi_peek_client (self, service, flag)) {
         g_simple_async_report_error_in_idle (G_OBJECT (self),
@@ -143,16 +183,31 @@ mm_port_qmi_allocate_client (MMPortQmi *self,
         return;
     }
 
+    result = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        mm_port_qmi_allocate_client);
+
+    for (l = self->priv->allocations; l; l = g_list_next (l)) {
+        ctx = l->data;
+        if (ctx->info->service == service && ctx->info->flag == flag) {
+            mm_dbg_category (MM_LOG_CATEGORY_QMI, "Waiting for the ongoing allocation of a client for service '%s'",
+                                                  qmi_service_get_string (service));
+            ctx->results = g_list_append (ctx->results, result);
+            return;
+        }
+    }
+
     ctx = g_new0 (AllocateClientContext, 1);
     ctx->self = g_object_ref (self);
-    ctx->result = g_simple_async_result_new (G_OBJECT (self),
-                                             callback,
-                                             user_data,
-                                             mm_port_qmi_allocate_client);
+    ctx->results = g_list_append (NULL, result);
     ctx->info = g_new0 (ServiceInfo, 1);
     ctx->info->service = service;
     ctx->info->flag = flag;
+    self->priv->allocations = g_list_prepend (self->priv->allocations, ctx);
 
+    /* The cancellable of the first request applies to all the ones sharing
+     * the allocation */
     qmi_device_allocate_client (self->priv->qmi_device,
                                 service,
                                 QMI_CID_NONE,
@@ -170,6 +225,173 @@ mm_port_qmi_llp_is_raw_ip (MMPortQmi *self)
     return self->priv->llp_is_raw_ip;
 }
 
+/*****************************************************************************/
+/* QMAP links
+ *
+ * The qmi_wwan driver creates one 'qmimux' net interface per mux id written
+ * to the 'add_mux' attribute of the physical interface, and links it as an
+ * upper device of it. */
+
+void
+mm_port_qmi_set_multiplex (MMPortQmi *self,
+                           gboolean multiplex)
+{
+    self->priv->multiplex = multiplex;
+}
+
+gboolean
+mm_port_qmi_is_multiplexed (MMPortQmi *self)
+{
+    return self->priv->qmap;
+}
+
+guint
+mm_port_qmi_get_interface_number (MMPortQmi *self)
+{
+    return self->priv->interface_number;
+}
+
+#if defined WITH_NEWEST_QMI_COMMANDS
+
+static gboolean
+load_interface_number (MMPortQmi *self)
+{
+    gchar *path;
+    gchar *contents = NULL;
+    gboolean loaded = FALSE;
+
+    path = g_strdup_printf ("/sys/class/usbmisc/%s/device/bInterfaceNumber",
+                            mm_port_get_device (MM_PORT (self)));
+    if (g_file_get_contents (path, &contents, NULL, NULL)) {
+        self->priv->interface_number = (guint) strtoul (contents, NULL, 16);
+        loaded = TRUE;
+    }
+    g_free (contents);
+    g_free (path);
+    return loaded;
+}
+
+#endif /* WITH_NEWEST_QMI_COMMANDS */
+
+static gboolean
+write_mux_attribute (const gchar *iface,
+                     const gchar *attribute,
+                     guint mux_id,
+                     GError **error)
+{
+    gchar *path;
+    gchar value[8];
+    gint fd;
+    gint len;
+    gboolean written = FALSE;
+
+    path = g_strdup_printf ("/sys/class/net/%s/qmi/%s", iface, attribute);
+    len = g_snprintf (value, sizeof (value), "%u\n", mux_id);
+
+    /* Not g_file_set_contents(), sysfs attributes can't be replaced */
+    fd = open (path, O_WRONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        written = (write (fd, value, len) == len);
+        close (fd);
+    }
+    if (!written)
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't write '%s': %s", path, g_strerror (errno));
+    g_free (path);
+    return written;
+}
+
+MMPort *
+mm_port_qmi_add_mux_link (MMPortQmi *self,
+                          MMPort *data,
+                          guint *mux_id,
+                          GError **error)
+{
+    const gchar *iface;
+    GHashTable *previous;
+    MMPort *link;
+    guint id;
+
+    g_return_val_if_fail (self->priv->qmap, NULL);
+
+    for (id = 1; id <= QMAP_MAX_MUX_LINKS; id++) {
+        if (!(self->priv->mux_ids & (1 << id)))
+            break;
+    }
+    if (id > QMAP_MAX_MUX_LINKS) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_TOO_MANY,
+                     "No more multiplexed links allowed in '%s'",
+                     mm_port_get_device (data));
+        return NULL;
+    }
+
+    /* The physical interface carries the traffic of all the links */
+    iface = mm_port_get_device (data);
+    if (!mm_port_net_set_up (data, error))
+        return NULL;
+
+    previous = mm_port_net_list_upper_links (data);
+    if (!write_mux_attribute (iface, "add_mux", id, error)) {
+        g_hash_table_unref (previous);
+        return NULL;
+    }
+    link = mm_port_net_find_new_upper_link (data, previous);
+    g_hash_table_unref (previous);
+
+    if (!link) {
+        write_mux_attribute (iface, "del_mux", id, NULL);
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't find the multiplexed link created in '%s'", iface);
+        return NULL;
+    }
+
+    mm_dbg_category (MM_LOG_CATEGORY_QMI, "Created multiplexed link '%s' with mux id %u in '%s'",
+                                          mm_port_get_device (link), id, iface);
+    self->priv->mux_ids |= (1 << id);
+    *mux_id = id;
+    return link;
+}
+
+void
+mm_port_qmi_del_mux_link (MMPortQmi *self,
+                          MMPort *data,
+                          guint mux_id)
+{
+    GError *error = NULL;
+
+    g_return_if_fail (mux_id > 0 && mux_id <= QMAP_MAX_MUX_LINKS);
+
+    if (!write_mux_attribute (mm_port_get_device (data), "del_mux", mux_id, &error)) {
+        mm_warn ("Couldn't delete multiplexed link with mux id %u: %s", mux_id, error->message);
+        g_error_free (error);
+    }
+    self->priv->mux_ids &= ~(1 << mux_id);
+}
+
+/*****************************************************************************/
+
+static void
+device_indication_cb (QmiDevice  *device,
+                      GByteArray *message,
+                      MMPortQmi  *self)
+{
+    mm_traffic_capture_write (mm_port_get_device (MM_PORT (self)),
+                              MM_PORT_TYPE_QMI,
+                              MM_TRAFFIC_CAPTURE_DIRECTION_RECEIVED,
+                              message->data,
+                              message->len);
+}
+
+static void
+device_clear (MMPortQmi *self)
+{
+    if (self->priv->indication_id) {
+        g_signal_handler_disconnect (self->priv->qmi_device, self->priv->indication_id);
+        self->priv->indication_id = 0;
+    }
+    g_clear_object (&self->priv->qmi_device);
+}
+
 /*****************************************************************************/
 
 typedef enum {
@@ -181,6 +403,7 @@ typedef enum {
     PORT_OPEN_STEP_GET_KERNEL_DATA_FORMAT,
     PORT_OPEN_STEP_ALLOCATE_WDA_CLIENT,
     PORT_OPEN_STEP_GET_WDA_DATA_FORMAT,
+    PORT_OPEN_STEP_SET_WDA_QMAP_FORMAT,
     PORT_OPEN_STEP_CHECK_DATA_FORMAT,
     PORT_OPEN_STEP_SET_KERNEL_DATA_FORMAT,
     PORT_OPEN_STEP_OPEN_WITH_DATA_FORMAT,
@@ -198,6 +421,7 @@ typedef struct {
     gboolean set_data_format;
     QmiDeviceExpectedDataFormat kernel_data_format;
     QmiWdaLinkLayerProtocol llp;
+    gboolean qmap;
 } PortOpenContext;
 
 static void
@@ -266,6 +490,36 @@ get_data_format_ready (QmiClientWda *client,
     port_open_context_step (ctx);
 }
 
+#if defined WITH_NEWEST_QMI_COMMANDS
+
+static void
+set_qmap_format_ready (QmiClientWda *client,
+                       GAsyncResult *res,
+                       PortOpenContext *ctx)
+{
+    QmiMessageWdaSetDataFormatOutput *output;
+    GError *error = NULL;
+
+    output = qmi_client_wda_set_data_format_finish (client, res, &error);
+    if (!output || !qmi_message_wda_set_data_format_output_get_result (output, &error)) {
+        /* Not fatal, single data session over the plain net port */
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Couldn't enable QMAP multiplexing: %s", error->message);
+        g_error_free (error);
+    } else {
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "QMAP multiplexing enabled");
+        ctx->llp = QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP;
+        ctx->qmap = TRUE;
+    }
+
+    if (output)
+        qmi_message_wda_set_data_format_output_unref (output);
+
+    ctx->step++;
+    port_open_context_step (ctx);
+}
+
+#endif /* WITH_NEWEST_QMI_COMMANDS */
+
 static void
 allocate_client_wda_ready (QmiDevice *device,
                            GAsyncResult *res,
@@ -325,12 +579,12 @@ port_open_context_step (PortOpenContext *ctx)
 {
     switch (ctx->step) {
     case PORT_OPEN_STEP_FIRST:
-        mm_dbg ("Opening QMI device...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Opening QMI device...");
         ctx->step++;
         /* Fall down to next step */
 
     case PORT_OPEN_STEP_CHECK_OPENING:
-        mm_dbg ("Checking if QMI device already opening...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Checking if QMI device already opening...");
         if (ctx->self->priv->opening) {
             g_simple_async_result_set_error (ctx->result,
                                              MM_CORE_ERROR,
@@ -343,7 +597,7 @@ port_open_context_step (PortOpenContext *ctx)
         /* Fall down to next step */
 
     case PORT_OPEN_STEP_CHECK_ALREADY_OPEN:
-        mm_dbg ("Checking if QMI device already open...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Checking if QMI device already open...");
         if (ctx->self->priv->qmi_device) {
             g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
             port_open_context_complete_and_free (ctx);
@@ -364,7 +618,7 @@ port_open_context_step (PortOpenContext *ctx)
          * that all callbacks go through the LAST step for completing. */
         ctx->self->priv->opening = TRUE;
 
-        mm_dbg ("Creating QMI device...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Creating QMI device...");
         qmi_device_new (file,
                         ctx->cancellable,
                         (GAsyncReadyCallback) qmi_device_new_ready,
@@ -377,7 +631,7 @@ port_open_context_step (PortOpenContext *ctx)
 
     case PORT_OPEN_STEP_OPEN_WITHOUT_DATA_FORMAT:
         /* Now open the QMI device without any data format CTL flag */
-        mm_dbg ("Opening device without data format update...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Opening device without data format update...");
         qmi_device_open (ctx->device,
                          (QMI_DEVICE_OPEN_FLAGS_VERSION_INFO |
                           QMI_DEVICE_OPEN_FLAGS_PROXY),
@@ -388,7 +642,7 @@ port_open_context_step (PortOpenContext *ctx)
         return;
 
     case PORT_OPEN_STEP_GET_KERNEL_DATA_FORMAT:
-        mm_dbg ("Querying kernel data format...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Querying kernel data format...");
         /* Try to gather expected data format from the sysfs file */
         ctx->kernel_data_format = qmi_device_get_expected_data_format (ctx->device, NULL);
         /* If data format cannot be retrieved, we fallback to 802.3 via CTL */
@@ -402,7 +656,7 @@ port_open_context_step (PortOpenContext *ctx)
 
     case PORT_OPEN_STEP_ALLOCATE_WDA_CLIENT:
         /* Allocate WDA client */
-        mm_dbg ("Allocating WDA client...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Allocating WDA client...");
         qmi_device_allocate_client (ctx->device,
                                     QMI_SERVICE_WDA,
                                     QMI_CID_NONE,
@@ -415,7 +669,7 @@ port_open_context_step (PortOpenContext *ctx)
     case PORT_OPEN_STEP_GET_WDA_DATA_FORMAT:
         /* If we have WDA client, query current data format */
         g_assert (ctx->wda);
-        mm_dbg ("Querying device data format...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Querying device data format...");
         qmi_client_wda_get_data_format (QMI_CLIENT_WDA (ctx->wda),
                                         NULL,
                                         10,
@@ -424,12 +678,43 @@ port_open_context_step (PortOpenContext *ctx)
                                         ctx);
         return;
 
+    case PORT_OPEN_STEP_SET_WDA_QMAP_FORMAT:
+#if defined WITH_NEWEST_QMI_COMMANDS
+        /* QMAP needs raw-ip and the interface number to bind the links */
+        if (ctx->self->priv->multiplex && load_interface_number (ctx->self)) {
+            QmiMessageWdaSetDataFormatInput *input;
+
+            mm_dbg_category (MM_LOG_CATEGORY_QMI, "Enabling QMAP multiplexing...");
+            input = qmi_message_wda_set_data_format_input_new ();
+            qmi_message_wda_set_data_format_input_set_link_layer_protocol (
+                input, QMI_WDA_LINK_LAYER_PROTOCOL_RAW_IP, NULL);
+            qmi_message_wda_set_data_format_input_set_uplink_data_aggregation_protocol (
+                input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_protocol (
+                input, QMI_WDA_DATA_AGGREGATION_PROTOCOL_QMAP, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_max_datagrams (
+                input, QMAP_DL_MAX_DATAGRAMS, NULL);
+            qmi_message_wda_set_data_format_input_set_downlink_data_aggregation_max_size (
+                input, QMAP_DL_MAX_SIZE, NULL);
+            qmi_client_wda_set_data_format (QMI_CLIENT_WDA (ctx->wda),
+                                            input,
+                                            10,
+                                            ctx->cancellable,
+                                            (GAsyncReadyCallback) set_qmap_format_ready,
+                                            ctx);
+            qmi_message_wda_set_data_format_input_unref (input);
+            return;
+        }
+#endif
+        ctx->step++;
+        /* Fall down to next step */
+
     case PORT_OPEN_STEP_CHECK_DATA_FORMAT:
         /* We now have the WDA data format and the kernel data format, if they're
          * equal, we're done */
-        mm_dbg ("Checking data format: kernel %s, device %s",
-                qmi_device_expected_data_format_get_string (ctx->kernel_data_format),
-                qmi_wda_link_layer_protocol_get_string (ctx->llp));
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Checking data format: kernel %s, device %s",
+                                              qmi_device_expected_data_format_get_string (ctx->kernel_data_format),
+                                              qmi_wda_link_layer_protocol_get_string (ctx->llp));
 
         if (ctx->kernel_data_format == QMI_DEVICE_EXPECTED_DATA_FORMAT_802_3 &&
             ctx->llp == QMI_WDA_LINK_LAYER_PROTOCOL_802_3) {
@@ -452,7 +737,7 @@ port_open_context_step (PortOpenContext *ctx)
 
     case PORT_OPEN_STEP_SET_KERNEL_DATA_FORMAT:
         /* Update the data format to be expected by the kernel */
-        mm_dbg ("Updating kernel data format: %s", qmi_wda_link_layer_protocol_get_string (ctx->llp));
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Updating kernel data format: %s", qmi_wda_link_layer_protocol_get_string (ctx->llp));
         if (ctx->llp == QMI_WDA_LINK_LAYER_PROTOCOL_802_3) {
             ctx->kernel_data_format = QMI_DEVICE_EXPECTED_DATA_FORMAT_802_3;
             ctx->self->priv->llp_is_raw_ip = FALSE;
@@ -472,7 +757,7 @@ port_open_context_step (PortOpenContext *ctx)
 
     case PORT_OPEN_STEP_OPEN_WITH_DATA_FORMAT:
         /* Need to reopen setting 802.3 using CTL */
-        mm_dbg ("Closing device to reopen it right away...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Closing device to reopen it right away...");
         if (!qmi_device_close (ctx->device, &ctx->error)) {
             mm_warn ("Couldn't close QMI device to reopen it");
             ctx->step = PORT_OPEN_STEP_LAST;
@@ -480,7 +765,7 @@ port_open_context_step (PortOpenContext *ctx)
             return;
         }
 
-        mm_dbg ("Reopening device with data format...");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Reopening device with data format...");
         qmi_device_open (ctx->device,
                          (QMI_DEVICE_OPEN_FLAGS_VERSION_INFO |
                           QMI_DEVICE_OPEN_FLAGS_PROXY        |
@@ -493,7 +778,7 @@ port_open_context_step (PortOpenContext *ctx)
         return;
 
     case PORT_OPEN_STEP_LAST:
-        mm_dbg ("QMI port open operation finished");
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "QMI port open operation finished");
 
         /* Reset opening flag */
         ctx->self->priv->opening = FALSE;
@@ -509,6 +794,12 @@ port_open_context_step (PortOpenContext *ctx)
             g_assert (ctx->device);
             g_assert (!ctx->self->priv->qmi_device);
             ctx->self->priv->qmi_device = g_object_ref (ctx->device);
+            /* libqmi doesn't expose requests and responses, only indications */
+            ctx->self->priv->indication_id = g_signal_connect (ctx->self->priv->qmi_device,
+                                                               QMI_DEVICE_SIGNAL_INDICATION,
+                                                               G_CALLBACK (device_indication_cb),
+                                                               ctx->self);
+            ctx->self->priv->qmap = ctx->qmap;
             g_simple_async_result_set_op_res_gboolean (ctx->result, TRUE);
         }
         port_open_context_complete_and_free (ctx);
@@ -565,7 +856,7 @@ mm_port_qmi_close (MMPortQmi *self)
     for (l = self->priv->services; l; l = g_list_next (l)) {
         ServiceInfo *info = l->data;
 
-        mm_dbg ("Releasing client for service '%s'...", qmi_service_get_string (info->service));
+        mm_dbg_category (MM_LOG_CATEGORY_QMI, "Releasing client for service '%s'...", qmi_service_get_string (info->service));
         qmi_device_release_client (self->priv->qmi_device,
                                    info->client,
                                    QMI_DEVICE_RELEASE_CLIENT_FLAGS_RELEASE_CID,
@@ -582,7 +873,9 @@ mm_port_qmi_close (MMPortQmi *self)
         g_error_free (error);
     }
 
-    g_clear_object (&self->priv->qmi_device);
+    device_clear (self);
+    self->priv->qmap = FALSE;
+    self->priv->mux_ids = 0;
 }
 
 /*****************************************************************************/
@@ -620,7 +913,7 @@ dispose (GObject *object)
     self->priv->services = NULL;
 
     /* Clear device object */
-    g_clear_object (&self->priv->qmi_device);
+    device_clear (self);
 
     G_OBJECT_CLASS (mm_port_qmi_parent_class)->dispose (object);
 }
@@ -62,7 +62,10 @@ void     mm_port_qmi_close       (MMPortQmi *self);
 typedef enum {
     MM_PORT_QMI_FLAG_DEFAULT  = 0,
     MM_PORT_QMI_FLAG_WDS_IPV4 = 100,
-    MM_PORT_QMI_FLAG_WDS_IPV6 = 101
+    MM_PORT_QMI_FLAG_WDS_IPV6 = 101,
+    /* Clients bound to multiplexed links; the mux id is added to these */
+    MM_PORT_QMI_FLAG_WDS_MUX_IPV4 = 1000,
+    MM_PORT_QMI_FLAG_WDS_MUX_IPV6 = 2000
 } MMPortQmiFlag;
 
 void     mm_port_qmi_allocate_client        (MMPortQmi *self,
@@ -84,4 +87,19 @@ QmiClient *mm_port_qmi_get_client  (MMPortQmi *self,
 
 gboolean mm_port_qmi_llp_is_raw_ip (MMPortQmi *self);
 
+/* QMAP multiplexing of several data sessions over the same net port. It
+ * needs to be requested before opening the port, and is only available if
+ * both the device and the kernel driver support it. */
+void     mm_port_qmi_set_multiplex        (MMPortQmi *self,
+                                           gboolean multiplex);
+gboolean mm_port_qmi_is_multiplexed       (MMPortQmi *self);
+guint    mm_port_qmi_get_interface_number (MMPortQmi *self);
+MMPort  *mm_port_qmi_add_mux_link         (MMPortQmi *self,
+                                           MMPort *data,
+                                           guint *mux_id,
+                                           GError **error);
+void     mm_port_qmi_del_mux_link         (MMPortQmi *self,
+                                           MMPort *data,
+                                           guint mux_id);
+
 #endif /* MM_PORT_QMI_H */
@@ -22,6 +22,9 @@
 #include <string.h>
 
 #include "mm-port-serial-at.h"
+#include "mm-modem-helpers.h"
+#include "mm-metrics.h"
+#include "mm-memory-budget.h"
 #include "mm-log.h"
 
 G_DEFINE_TYPE (MMPortSerialAt, mm_port_serial_at, MM_TYPE_PORT_SERIAL)
@@ -41,7 +44,19 @@ struct _MMPortSerialAtPrivate {
     gpointer response_parser_user_data;
     GDestroyNotify response_parser_notify;
 
+    /* Handler of incomplete responses */
+    MMPortSerialAtPartialResponseFn partial_response_fn;
+    gpointer partial_response_user_data;
+
+    /* String given to the response parser, reused until a reply is built
+     * with it. While the reply arrives it mirrors the response buffer, and
+     * only the newly read data is appended to it. */
+    GString *parser_string;
+
     GSList *unsolicited_msg_handlers;
+    GHashTable *unsolicited_msg_prefixes;
+    GArray *unsolicited_msg_prefix_lengths;
+    GArray *unsolicited_msg_matches;
 
     MMPortSerialAtFlag flags;
 
@@ -50,6 +65,10 @@ struct _MMPortSerialAtPrivate {
     guint init_sequence_enabled;
     gchar **init_sequence;
     gboolean send_lf;
+
+    /* Highest baudrate to switch to, if any, and whether it was tried */
+    guint max_baudrate;
+    gboolean baudrate_negotiated;
 };
 
 /*****************************************************************************/
@@ -97,66 +116,118 @@ mm_port_serial_at_set_response_parser (MMPortSerialAt *self,
 }
 
 void
-mm_port_serial_at_remove_echo (GByteArray *response)
+mm_port_serial_at_set_partial_response_handler (MMPortSerialAt *self,
+                                                MMPortSerialAtPartialResponseFn fn,
+                                                gpointer user_data)
 {
-    guint i;
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
 
-    if (response->len <= 2)
-        return;
+    self->priv->partial_response_fn = fn;
+    self->priv->partial_response_user_data = user_data;
+}
+
+static gsize
+echo_length (const guint8 *data,
+             gsize         len)
+{
+    gsize i;
 
-    for (i = 0; i < (response->len - 1); i++) {
+    if (len <= 2)
+        return 0;
+
+    for (i = 0; i < (len - 1); i++) {
         /* If there is any content before the first
          * <CR><LF>, assume it's echo or garbage, and skip it */
-        if (response->data[i] == '\r' && response->data[i + 1] == '\n') {
-            if (i > 0)
-                g_byte_array_remove_range (response, 0, i);
-            /* else, good, we're already started with <CR><LF> */
-            break;
-        }
+        if (data[i] == '\r' && data[i + 1] == '\n')
+            return i;
     }
+
+    return 0;
+}
+
+void
+mm_port_serial_at_remove_echo (GByteArray *response)
+{
+    gsize len;
+
+    len = echo_length (response->data, response->len);
+    if (len > 0)
+        g_byte_array_remove_range (response, 0, len);
+}
+
+static void
+remove_echo (MMSerialBuffer *response)
+{
+    gsize len;
+
+    len = echo_length (mm_serial_buffer_get_data (response),
+                       mm_serial_buffer_get_length (response));
+    if (len > 0)
+        mm_serial_buffer_consume (response, len);
 }
 
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (port);
     GString *string;
     gsize parsed_len;
+    gsize response_len;
+    gsize copied;
+    gsize scanned;
     GError *inner_error = NULL;
 
     g_return_val_if_fail (self->priv->response_parser_fn != NULL, FALSE);
 
     /* Remove echo */
     if (self->priv->remove_echo)
-        mm_port_serial_at_remove_echo (response);
+        remove_echo (response);
 
     /* If there's no response to receive, we're done; e.g. if we only got
      * unsolicited messages */
-    if (!response->len)
+    response_len = mm_serial_buffer_get_length (response);
+    if (!response_len)
         return MM_PORT_SERIAL_RESPONSE_NONE;
 
-    /* Construct the string that AT-parsing functions expect */
-    string = g_string_sized_new (response->len + 1);
-    g_string_append_len (string, (const char *) response->data, response->len);
-
-    /* Fully cleanup the response array, we'll consider the contents we got
-     * as the full reply that the command may expect. */
-    g_byte_array_remove_range (response, 0, response->len);
+    /* Construct the string that AT-parsing functions expect, copying just
+     * what wasn't already copied in previous reads */
+    copied = 0;
+    if (self->priv->parser_string) {
+        string = self->priv->parser_string;
+        self->priv->parser_string = NULL;
+        copied = MIN (mm_serial_buffer_get_copied (response), string->len);
+        g_string_truncate (string, copied);
+    } else
+        string = g_string_sized_new (response_len + 1);
+    g_string_append_len (string,
+                         (const char *) mm_serial_buffer_get_data (response) + copied,
+                         response_len - copied);
 
     /* Parse it; returns FALSE if there is nothing we can do with this
-     * response yet. */
-    if (!self->priv->response_parser_fn (self->priv->response_parser_user_data, string, &inner_error)) {
-        /* Copy what we got back in the response buffer. */
-        g_byte_array_append (response, (const guint8 *) string->str, string->len);
-        g_string_free (string, TRUE);
+     * response yet, in which case we just leave the response buffer
+     * untouched, and remember how much of it the parser already scanned. */
+    scanned = mm_serial_buffer_get_mark (response);
+    if (!self->priv->response_parser_fn (self->priv->response_parser_user_data, string, &scanned, &inner_error)) {
+        mm_serial_buffer_set_mark (response, scanned);
+        if (self->priv->partial_response_fn)
+            self->priv->partial_response_fn (self, string->str, self->priv->partial_response_user_data);
+        /* The parser may have skipped leading garbage, in which case the
+         * string no longer mirrors the buffer */
+        mm_serial_buffer_set_copied (response, string->len == response_len ? response_len : 0);
+        self->priv->parser_string = string;
         return MM_PORT_SERIAL_RESPONSE_NONE;
     }
 
+    /* Fully consume the response buffer, we'll consider the contents we got
+     * as the full reply that the command may expect. */
+    mm_serial_buffer_consume (response, response_len);
+
     /* If we got an error, propagate it without any further response string */
     if (inner_error) {
+        self->priv->parser_string = string;
         g_propagate_error (error, inner_error);
         return MM_PORT_SERIAL_RESPONSE_ERROR;
     }
@@ -169,14 +240,221 @@ parse_response (MMPortSerial *port,
 
 /*****************************************************************************/
 
+/* Literal prefix of the unsolicited messages expected by a handler; multiple
+ * handlers may share the same one. */
+typedef struct {
+    gchar *prefix;
+    gsize prefix_len;
+    /* Whether found at the beginning of a line in the current buffer */
+    gboolean seen;
+} MMAtUnsolicitedMsgPrefix;
+
 typedef struct {
     GRegex *regex;
     MMPortSerialAtUnsolicitedMsgFn callback;
     gboolean enable;
     gpointer user_data;
     GDestroyNotify notify;
+    /* If NULL, the handler regex is always run */
+    MMAtUnsolicitedMsgPrefix *prefix;
+    /* Messages matched, shared by all the handlers with the same regex */
+    MMMetric *metric;
 } MMAtUnsolicitedMsgHandler;
 
+static void
+unsolicited_msg_prefix_free (MMAtUnsolicitedMsgPrefix *prefix)
+{
+    g_free (prefix->prefix);
+    g_slice_free (MMAtUnsolicitedMsgPrefix, prefix);
+}
+
+/* Skip a character class or a group in a regex pattern, returning the position
+ * right after its end, or NULL if not found */
+static const gchar *
+skip_regex_group (const gchar *p)
+{
+    guint    depth = 0;
+    gboolean in_class = FALSE;
+
+    for (; *p; p++) {
+        if (*p == '\\') {
+            if (!*(++p))
+                return NULL;
+            continue;
+        }
+        if (in_class) {
+            if (*p == ']')
+                in_class = FALSE;
+            continue;
+        }
+        if (*p == '[')
+            in_class = TRUE;
+        else if (*p == '(')
+            depth++;
+        else if (*p == ')' && --depth == 0)
+            return p + 1;
+    }
+    return NULL;
+}
+
+#define UNSOLICITED_MSG_PREFIX_MAX_LEN 32
+
+gchar *
+mm_port_serial_at_unsolicited_msg_prefix_from_regex (GRegex *regex)
+{
+    const gchar *pattern;
+    const gchar *p;
+    const gchar *group = NULL;
+    GString     *prefix;
+
+    if (g_regex_get_compile_flags (regex) & (G_REGEX_CASELESS | G_REGEX_EXTENDED))
+        return NULL;
+
+    pattern = g_regex_get_pattern (regex);
+
+    /* Alternations may allow matches without the prefix */
+    if (strchr (pattern, '|'))
+        return NULL;
+
+    /* The message must start right after a line boundary, i.e. with one or
+     * more <CR> or <LF> which are not optional */
+    p = pattern;
+    if (!g_str_has_prefix (p, "\\r") && !g_str_has_prefix (p, "\\n"))
+        return NULL;
+    while (g_str_has_prefix (p, "\\r") || g_str_has_prefix (p, "\\n")) {
+        p += 2;
+        if (*p == '+')
+            p++;
+        else if (*p == '*' || *p == '?' || *p == '{')
+            return NULL;
+    }
+
+    /* Allow the prefix to be within a capture group */
+    if (*p == '(' && *(p + 1) != '?') {
+        group = p;
+        p++;
+    }
+
+    prefix = g_string_new (NULL);
+    while (*p && prefix->len < UNSOLICITED_MSG_PREFIX_MAX_LEN) {
+        const gchar *next;
+        gchar        c;
+
+        if (*p == '\\') {
+            /* Only escaped punctuation is literal, e.g. \+ or \^ */
+            if (!*(p + 1) || g_ascii_isalnum (*(p + 1)))
+                break;
+            c = *(p + 1);
+            next = p + 2;
+        } else if (g_ascii_isalnum (*p) || strchr (":,;_-!#%&@=/'\"<>~ ", *p)) {
+            c = *p;
+            next = p + 1;
+        } else
+            break;
+
+        /* Quantified characters may not be there */
+        if (*next == '?' || *next == '*' || *next == '{')
+            break;
+
+        g_string_append_c (prefix, c);
+        p = next;
+
+        /* Repeated characters, just keep the first one */
+        if (*p == '+')
+            break;
+    }
+
+    /* The group holding the prefix must not be optional */
+    if (group) {
+        p = skip_regex_group (group);
+        if (!p || *p == '?' || *p == '*' || *p == '{') {
+            g_string_free (prefix, TRUE);
+            return NULL;
+        }
+    }
+
+    if (!prefix->len) {
+        g_string_free (prefix, TRUE);
+        return NULL;
+    }
+
+    return g_string_free (prefix, FALSE);
+}
+
+static MMAtUnsolicitedMsgPrefix *
+unsolicited_msg_prefix_get (MMPortSerialAt *self,
+                            GRegex         *regex)
+{
+    MMAtUnsolicitedMsgPrefix *prefix;
+    gchar                    *str;
+    guint                     i;
+
+    str = mm_port_serial_at_unsolicited_msg_prefix_from_regex (regex);
+    if (!str)
+        return NULL;
+
+    prefix = g_hash_table_lookup (self->priv->unsolicited_msg_prefixes, str);
+    if (prefix) {
+        g_free (str);
+        return prefix;
+    }
+
+    prefix = g_slice_new0 (MMAtUnsolicitedMsgPrefix);
+    prefix->prefix = str;
+    prefix->prefix_len = strlen (str);
+    g_hash_table_insert (self->priv->unsolicited_msg_prefixes, prefix->prefix, prefix);
+
+    /* Keep track of all the different prefix lengths, so that we know which
+     * keys to look up for each line */
+    for (i = 0; i < self->priv->unsolicited_msg_prefix_lengths->len; i++) {
+        if (g_array_index (self->priv->unsolicited_msg_prefix_lengths, gsize, i) == prefix->prefix_len)
+            break;
+    }
+    if (i == self->priv->unsolicited_msg_prefix_lengths->len)
+        g_array_append_val (self->priv->unsolicited_msg_prefix_lengths, prefix->prefix_len);
+
+    return prefix;
+}
+
+/* Flag which of the known prefixes are found at the beginning of a line */
+static void
+unsolicited_msg_prefixes_lookup (MMPortSerialAt *self,
+                                 const guint8   *data,
+                                 gsize           len)
+{
+    GHashTableIter            iter;
+    MMAtUnsolicitedMsgPrefix *prefix;
+    gchar                     key[UNSOLICITED_MSG_PREFIX_MAX_LEN + 1];
+    gsize                     i;
+    guint                     j;
+
+    g_hash_table_iter_init (&iter, self->priv->unsolicited_msg_prefixes);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&prefix))
+        prefix->seen = FALSE;
+
+    for (i = 0; i < len; i++) {
+        /* Lines start after any <CR> or <LF> */
+        if (data[i] != '\r' && data[i] != '\n')
+            continue;
+        if (i + 1 < len && (data[i + 1] == '\r' || data[i + 1] == '\n'))
+            continue;
+
+        for (j = 0; j < self->priv->unsolicited_msg_prefix_lengths->len; j++) {
+            gsize prefix_len;
+
+            prefix_len = g_array_index (self->priv->unsolicited_msg_prefix_lengths, gsize, j);
+            if (i + 1 + prefix_len > len)
+                continue;
+
+            memcpy (key, &data[i + 1], prefix_len);
+            key[prefix_len] = '\0';
+            prefix = g_hash_table_lookup (self->priv->unsolicited_msg_prefixes, key);
+            if (prefix)
+                prefix->seen = TRUE;
+        }
+    }
+}
+
 static gint
 unsolicited_msg_handler_cmp (MMAtUnsolicitedMsgHandler *handler,
                              GRegex *regex)
@@ -210,6 +488,11 @@ mm_port_serial_at_add_unsolicited_msg_handler (MMPortSerialAt *self,
         handler = g_slice_new (MMAtUnsolicitedMsgHandler);
         self->priv->unsolicited_msg_handlers = g_slist_append (self->priv->unsolicited_msg_handlers, handler);
         handler->regex = g_regex_ref (regex);
+        handler->prefix = unsolicited_msg_prefix_get (self, regex);
+        handler->metric = mm_metrics_counter ("mm_unsolicited_messages",
+                                              "Unsolicited messages matched by each handler",
+                                              "pattern",
+                                              g_regex_get_pattern (regex));
     }
 
     handler->callback = callback;
@@ -239,67 +522,94 @@ mm_port_serial_at_enable_unsolicited_msg_handler (MMPortSerialAt *self,
 }
 
 static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
+range_overlaps (GArray *ranges,
+                gsize   start,
+                gsize   end)
 {
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
+    guint i;
 
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
+    for (i = 0; i < ranges->len; i++) {
+        MMSerialBufferRange *range;
 
+        range = &g_array_index (ranges, MMSerialBufferRange, i);
+        if (start < range->offset + range->len && end > range->offset)
+            return TRUE;
+    }
     return FALSE;
 }
 
 static void
-parse_unsolicited (MMPortSerial *port, GByteArray *response)
+parse_unsolicited (MMPortSerial *port, MMSerialBuffer *response)
 {
     MMPortSerialAt *self = MM_PORT_SERIAL_AT (port);
     GSList *iter;
 
     /* Remove echo */
     if (self->priv->remove_echo)
-        mm_port_serial_at_remove_echo (response);
+        remove_echo (response);
+
+    if (!mm_serial_buffer_get_length (response))
+        return;
+
+    /* Look for the known message prefixes, so that we only run the regex of
+     * the handlers that may really match */
+    if (g_hash_table_size (self->priv->unsolicited_msg_prefixes) > 0)
+        unsolicited_msg_prefixes_lookup (self,
+                                         mm_serial_buffer_get_data (response),
+                                         mm_serial_buffer_get_length (response));
 
     for (iter = self->priv->unsolicited_msg_handlers; iter; iter = iter->next) {
         MMAtUnsolicitedMsgHandler *handler = (MMAtUnsolicitedMsgHandler *) iter->data;
         GMatchInfo *match_info;
-        gboolean matches;
 
         if (!handler->enable)
             continue;
 
-        matches = g_regex_match_full (handler->regex,
-                                      (const char *) response->data,
-                                      response->len,
-                                      0, 0, &match_info, NULL);
-        if (handler->callback) {
-            while (g_match_info_matches (match_info)) {
-                handler->callback (self, match_info, handler->user_data);
-                g_match_info_next (match_info, NULL);
+        if (handler->prefix && !handler->prefix->seen)
+            continue;
+
+        g_regex_match_full (handler->regex,
+                            (const char *) mm_serial_buffer_get_data (response),
+                            mm_serial_buffer_get_length (response),
+                            0, 0, &match_info, NULL);
+        while (g_match_info_matches (match_info)) {
+            gint start;
+            gint end;
+
+            /* Matches are removed from the buffer only once all handlers have
+             * been run, so make sure we skip those matching text already
+             * processed by a previous handler. */
+            if (g_match_info_fetch_pos (match_info, 0, &start, &end) &&
+                end > start &&
+                !range_overlaps (self->priv->unsolicited_msg_matches, start, end)) {
+                MMSerialBufferRange range;
+
+                /* Drop cached replies made stale by this message */
+                mm_serial_reply_cache_invalidate (mm_port_serial_peek_reply_cache (port),
+                                                  mm_serial_buffer_get_data (response) + start,
+                                                  end - start);
+                if (mm_port_serial_peek_shared_reply_cache (port))
+                    mm_serial_reply_cache_invalidate (mm_port_serial_peek_shared_reply_cache (port),
+                                                      mm_serial_buffer_get_data (response) + start,
+                                                      end - start);
+
+                mm_metric_inc (handler->metric);
+                if (handler->callback)
+                    handler->callback (self, match_info, handler->user_data);
+
+                range.offset = start;
+                range.len = end - start;
+                g_array_append_val (self->priv->unsolicited_msg_matches, range);
             }
+            g_match_info_next (match_info, NULL);
         }
 
         g_match_info_free (match_info);
-
-        if (matches) {
-            /* Remove matches */
-            char *str;
-            int result_len = response->len;
-
-            str = g_regex_replace_eval (handler->regex,
-                                        (const char *) response->data,
-                                        response->len,
-                                        0, 0,
-                                        remove_eval_cb, &result_len, NULL);
-
-            g_byte_array_remove_range (response, 0, response->len);
-            g_byte_array_append (response, (const guint8 *) str, result_len);
-            g_free (str);
-        }
     }
+
+    /* Remove all matches in one go */
+    mm_serial_buffer_remove_ranges (response, self->priv->unsolicited_msg_matches);
+    g_array_set_size (self->priv->unsolicited_msg_matches, 0);
 }
 
 /*****************************************************************************/
@@ -339,24 +649,57 @@ at_command_to_byte_array (const char *command, gboolean is_raw, gboolean send_lf
     return buf;
 }
 
+/* Commands built once and shared, per send_lf setting. Bounded, so that a
+ * misbehaving caller doesn't make it grow forever. */
+#define INTERNED_COMMANDS_MAX 512
+
+static GHashTable *interned_commands[2];
+G_LOCK_DEFINE_STATIC (interned_commands);
+
+GByteArray *
+mm_port_serial_at_command_intern (const gchar *command,
+                                  gboolean send_lf)
+{
+    GHashTable *table;
+    GByteArray *buf;
+
+    g_return_val_if_fail (command != NULL, NULL);
+
+    G_LOCK (interned_commands);
+
+    table = interned_commands[!!send_lf];
+    if (G_UNLIKELY (!table))
+        table = interned_commands[!!send_lf] = g_hash_table_new_full (g_str_hash,
+                                                                      g_str_equal,
+                                                                      g_free,
+                                                                      (GDestroyNotify) g_byte_array_unref);
+
+    buf = g_hash_table_lookup (table, command);
+    if (buf)
+        g_byte_array_ref (buf);
+    else {
+        buf = at_command_to_byte_array (command, FALSE, send_lf);
+        if (g_hash_table_size (table) < INTERNED_COMMANDS_MAX)
+            g_hash_table_insert (table, g_strdup (command), g_byte_array_ref (buf));
+    }
+
+    G_UNLOCK (interned_commands);
+
+    return buf;
+}
+
 const gchar *
 mm_port_serial_at_command_finish (MMPortSerialAt *self,
                                   GAsyncResult *res,
                                   GError **error)
 {
-    GString *str;
+    GByteArray *response;
 
     if (g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error))
         return NULL;
 
-    str = (GString *)g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
-    return str->str;
-}
-
-static void
-string_free (GString *str)
-{
-    g_string_free (str, TRUE);
+    response = (GByteArray *)g_simple_async_result_get_op_res_gpointer (G_SIMPLE_ASYNC_RESULT (res));
+    return (const gchar *)response->data;
 }
 
 static void
@@ -366,7 +709,6 @@ serial_command_ready (MMPortSerial *port,
 {
     GByteArray *response_buffer;
     GError *error = NULL;
-    GString *response;
 
     response_buffer = mm_port_serial_command_finish (port, res, &error);
     if (!response_buffer) {
@@ -376,16 +718,12 @@ serial_command_ready (MMPortSerial *port,
         return;
     }
 
-    /* Build a GString just with the response we need, and clear the
-     * processed range from the response buffer */
-    response = g_string_new_len ((const gchar *)response_buffer->data, response_buffer->len);
-    if (response_buffer->len > 0)
-        g_byte_array_remove_range (response_buffer, 0, response_buffer->len);
-    g_byte_array_unref (response_buffer);
-
+    /* The reply is ours, so just NUL-terminate it and give it as the
+     * string result, instead of copying it */
+    g_byte_array_append (response_buffer, (const guint8 *) "", 1);
     g_simple_async_result_set_op_res_gpointer (simple,
-                                               response,
-                                               (GDestroyNotify)string_free);
+                                               response_buffer,
+                                               (GDestroyNotify)g_byte_array_unref);
     g_simple_async_result_complete (simple);
     g_object_unref (simple);
 }
@@ -399,33 +737,95 @@ mm_port_serial_at_command (MMPortSerialAt *self,
                            GCancellable *cancellable,
                            GAsyncReadyCallback callback,
                            gpointer user_data)
+{
+    mm_port_serial_at_command_full (self,
+                                    command,
+                                    timeout_seconds,
+                                    is_raw,
+                                    allow_cached,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL,
+                                    cancellable,
+                                    callback,
+                                    user_data);
+}
+
+static void
+port_serial_at_command (MMPortSerialAt *self,
+                        GByteArray *buf,
+                        guint32 timeout_seconds,
+                        gboolean allow_cached,
+                        MMPortSerialCommandPriority priority,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data)
 {
     GSimpleAsyncResult *simple;
+
+    simple = g_simple_async_result_new (G_OBJECT (self),
+                                        callback,
+                                        user_data,
+                                        mm_port_serial_at_command);
+
+    mm_port_serial_command_full (MM_PORT_SERIAL (self),
+                                 buf,
+                                 timeout_seconds,
+                                 allow_cached,
+                                 priority,
+                                 cancellable,
+                                 (GAsyncReadyCallback)serial_command_ready,
+                                 simple);
+}
+
+static gboolean
+port_serial_at_send_lf (MMPortSerialAt *self)
+{
+    return (mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY ?
+            self->priv->send_lf :
+            TRUE);
+}
+
+void
+mm_port_serial_at_command_full (MMPortSerialAt *self,
+                                const char *command,
+                                guint32 timeout_seconds,
+                                gboolean is_raw,
+                                gboolean allow_cached,
+                                MMPortSerialCommandPriority priority,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
     GByteArray *buf;
 
     g_return_if_fail (self != NULL);
     g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
     g_return_if_fail (command != NULL);
 
-    buf = at_command_to_byte_array (command,
-                                    is_raw,
-                                    (mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY ?
-                                     self->priv->send_lf :
-                                     TRUE));
+    buf = at_command_to_byte_array (command, is_raw, port_serial_at_send_lf (self));
     g_return_if_fail (buf != NULL);
 
-    simple = g_simple_async_result_new (G_OBJECT (self),
-                                        callback,
-                                        user_data,
-                                        mm_port_serial_at_command);
+    port_serial_at_command (self, buf, timeout_seconds, allow_cached, priority, cancellable, callback, user_data);
+    g_byte_array_unref (buf);
+}
 
-    mm_port_serial_command (MM_PORT_SERIAL (self),
-                            buf,
-                            timeout_seconds,
-                            allow_cached,
-                            cancellable,
-                            (GAsyncReadyCallback)serial_command_ready,
-                            simple);
+void
+mm_port_serial_at_command_interned (MMPortSerialAt *self,
+                                    const char *command,
+                                    guint32 timeout_seconds,
+                                    gboolean allow_cached,
+                                    MMPortSerialCommandPriority priority,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+    GByteArray *buf;
+
+    g_return_if_fail (self != NULL);
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
+    g_return_if_fail (command != NULL);
+
+    buf = mm_port_serial_at_command_intern (command, port_serial_at_send_lf (self));
+    port_serial_at_command (self, buf, timeout_seconds, allow_cached, priority, cancellable, callback, user_data);
     g_byte_array_unref (buf);
 }
 
@@ -456,7 +856,7 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
     }
 
     g_string_append_c (debug, '\'');
-    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    mm_log_unchecked (LOGL_DEBUG, "(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
     g_string_truncate (debug, 0);
 }
 
@@ -507,6 +907,229 @@ mm_port_serial_at_run_init_sequence (MMPortSerialAt *self)
     }
 }
 
+/*****************************************************************************/
+/* Baudrate negotiation */
+
+/* Attempts to talk to the modem at the new rate before giving up */
+#define BAUDRATE_VERIFY_ATTEMPTS 3
+
+typedef struct {
+    MMPortSerialAt *self;
+    guint old_baud;
+    guint new_baud;
+    guint verify_attempts;
+} NegotiateBaudrateContext;
+
+static void
+negotiate_baudrate_context_free (NegotiateBaudrateContext *ctx)
+{
+    g_object_unref (ctx->self);
+    g_slice_free (NegotiateBaudrateContext, ctx);
+}
+
+static void
+fallback_verify_ready (MMPortSerialAt *self,
+                       GAsyncResult *res,
+                       NegotiateBaudrateContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_port_serial_at_command_finish (self, res, &error)) {
+        mm_warn ("(%s): modem not responding after failed baudrate switch: %s",
+                 mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+    } else
+        mm_dbg ("(%s): back at %u bps", mm_port_get_device (MM_PORT (self)), ctx->old_baud);
+    negotiate_baudrate_context_free (ctx);
+}
+
+static void
+negotiate_baudrate_fallback_verify (NegotiateBaudrateContext *ctx)
+{
+    mm_port_serial_at_command_full (ctx->self,
+                                    "",
+                                    3,
+                                    FALSE,
+                                    FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                    NULL,
+                                    (GAsyncReadyCallback)fallback_verify_ready,
+                                    ctx);
+}
+
+static void negotiate_baudrate_verify (NegotiateBaudrateContext *ctx);
+
+static void
+verify_ready (MMPortSerialAt *self,
+              GAsyncResult *res,
+              NegotiateBaudrateContext *ctx)
+{
+    GError *error = NULL;
+
+    if (mm_port_serial_at_command_finish (self, res, &error)) {
+        mm_info ("(%s): switched to %u bps", mm_port_get_device (MM_PORT (self)), ctx->new_baud);
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+
+    mm_dbg ("(%s): no reply at %u bps: %s",
+            mm_port_get_device (MM_PORT (self)), ctx->new_baud, error->message);
+    g_error_free (error);
+
+    if (++ctx->verify_attempts < BAUDRATE_VERIFY_ATTEMPTS) {
+        negotiate_baudrate_verify (ctx);
+        return;
+    }
+
+    /* Fall back to the previous rate, which the modem keeps if it didn't
+     * really switch */
+    mm_warn ("(%s): couldn't talk to the modem at %u bps, falling back to %u bps",
+             mm_port_get_device (MM_PORT (self)), ctx->new_baud, ctx->old_baud);
+    if (!mm_port_serial_set_baudrate (MM_PORT_SERIAL (self), ctx->old_baud, &error)) {
+        mm_warn ("(%s): couldn't restore baudrate: %s",
+                 mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+    negotiate_baudrate_fallback_verify (ctx);
+}
+
+static void
+negotiate_baudrate_verify (NegotiateBaudrateContext *ctx)
+{
+    mm_port_serial_at_command_full (ctx->self,
+                                    "",
+                                    1,
+                                    FALSE,
+                                    FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                    NULL,
+                                    (GAsyncReadyCallback)verify_ready,
+                                    ctx);
+}
+
+static void
+ipr_set_ready (MMPortSerialAt *self,
+               GAsyncResult *res,
+               NegotiateBaudrateContext *ctx)
+{
+    GError *error = NULL;
+
+    if (!mm_port_serial_at_command_finish (self, res, &error)) {
+        mm_dbg ("(%s): modem refused to switch to %u bps: %s",
+                mm_port_get_device (MM_PORT (self)), ctx->new_baud, error->message);
+        g_error_free (error);
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+
+    /* The modem switches right after replying; switch our end before any
+     * other command gets sent */
+    if (!mm_port_serial_set_baudrate (MM_PORT_SERIAL (self), ctx->new_baud, &error)) {
+        mm_warn ("(%s): couldn't switch to %u bps: %s",
+                 mm_port_get_device (MM_PORT (self)), ctx->new_baud, error->message);
+        g_error_free (error);
+        negotiate_baudrate_fallback_verify (ctx);
+        return;
+    }
+
+    negotiate_baudrate_verify (ctx);
+}
+
+static void
+ipr_test_ready (MMPortSerialAt *self,
+                GAsyncResult *res,
+                NegotiateBaudrateContext *ctx)
+{
+    const gchar *response;
+    GError *error = NULL;
+    GArray *rates;
+    gchar *command;
+    guint i;
+
+    response = mm_port_serial_at_command_finish (self, res, &error);
+    rates = (response ? mm_parse_ipr_test_response (response, &error) : NULL);
+    if (!rates) {
+        mm_dbg ("(%s): couldn't load supported baudrates: %s",
+                mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+
+    /* Highest rate supported by both ends, not above the limit */
+    for (i = 0; i < rates->len; i++) {
+        guint rate;
+
+        rate = g_array_index (rates, guint, i);
+        if (rate > ctx->new_baud &&
+            rate <= self->priv->max_baudrate &&
+            mm_port_serial_baudrate_is_supported (rate))
+            ctx->new_baud = rate;
+    }
+    g_array_unref (rates);
+
+    if (ctx->new_baud == ctx->old_baud) {
+        mm_dbg ("(%s): no faster baudrate than %u bps available",
+                mm_port_get_device (MM_PORT (self)), ctx->old_baud);
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+
+    mm_dbg ("(%s): switching from %u to %u bps...",
+            mm_port_get_device (MM_PORT (self)), ctx->old_baud, ctx->new_baud);
+    command = g_strdup_printf ("+IPR=%u", ctx->new_baud);
+    mm_port_serial_at_command_full (self,
+                                    command,
+                                    3,
+                                    FALSE,
+                                    FALSE,
+                                    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+                                    NULL,
+                                    (GAsyncReadyCallback)ipr_set_ready,
+                                    ctx);
+    g_free (command);
+}
+
+static void
+negotiate_baudrate (MMPortSerialAt *self)
+{
+    NegotiateBaudrateContext *ctx;
+
+    self->priv->baudrate_negotiated = TRUE;
+
+    ctx = g_slice_new0 (NegotiateBaudrateContext);
+    ctx->self = g_object_ref (self);
+    g_object_get (self, MM_PORT_SERIAL_BAUD, &ctx->old_baud, NULL);
+    ctx->new_baud = ctx->old_baud;
+
+    if (ctx->old_baud >= self->priv->max_baudrate) {
+        negotiate_baudrate_context_free (ctx);
+        return;
+    }
+
+    mm_port_serial_at_command (self,
+                               "+IPR=?",
+                               3,
+                               FALSE,
+                               FALSE,
+                               NULL,
+                               (GAsyncReadyCallback)ipr_test_ready,
+                               ctx);
+}
+
+void
+mm_port_serial_at_set_max_baudrate (MMPortSerialAt *self,
+                                    guint max_baudrate)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_AT (self));
+
+    self->priv->max_baudrate = max_baudrate;
+}
+
+/*****************************************************************************/
+
 static void
 config (MMPortSerial *_self)
 {
@@ -514,6 +1137,46 @@ config (MMPortSerial *_self)
 
     if (self->priv->init_sequence_enabled)
         mm_port_serial_at_run_init_sequence (self);
+
+    /* Only tried once; the rate is kept when the port is reopened */
+    if (self->priv->max_baudrate &&
+        !self->priv->baudrate_negotiated &&
+        mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY)
+        negotiate_baudrate (self);
+}
+
+/* Execution commands which just report state */
+static const gchar *shareable_commands[] = {
+    "AT+CSQ\r",
+    "AT+CESQ\r",
+    "AT+CNUM\r",
+    "AT+CIMI\r",
+    "AT+CGSN\r",
+};
+
+static gboolean
+command_is_shareable (MMPortSerial *self,
+                      const GByteArray *command)
+{
+    const gchar *str = (const gchar *) command->data;
+    guint i;
+
+    /* Single read and test commands, e.g. "AT+COPS?" or "AT+CFUN=?". Several
+     * commands chained in one line may include writes. */
+    if (command->len > 4 &&
+        g_ascii_strncasecmp (str, "AT", 2) == 0 &&
+        str[command->len - 2] == '?' &&
+        str[command->len - 1] == '\r' &&
+        !memchr (str, ';', command->len))
+        return TRUE;
+
+    for (i = 0; i < G_N_ELEMENTS (shareable_commands); i++) {
+        if (command->len == strlen (shareable_commands[i]) &&
+            g_ascii_strncasecmp (str, shareable_commands[i], command->len) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
 }
 
 /*****************************************************************************/
@@ -533,6 +1196,143 @@ mm_port_serial_at_new (const char *name,
                                             NULL));
 }
 
+/* Commands whose replies don't change while the port exists */
+static const gchar *reply_cache_always_cacheable[] = {
+    "AT+CGMI\r", "AT+GMI\r",
+    "AT+CGMM\r", "AT+GMM\r",
+    "AT+CGMR\r", "AT+GMR\r",
+    "AT+CGSN\r", "AT+GSN\r",
+    "AT+CPMS=?\r",
+    /* Test commands listing static capabilities */
+    "AT+CFUN=?\r",
+    "AT+CGDCONT=?\r",
+    "AT+CIND=?\r",
+    "AT+CMGF=?\r",
+    "AT+CNMI=?\r",
+    "AT+CSCS=?\r",
+    "AT+WS46=?\r",
+    "AT^PREFMODE=?\r",
+    "AT^SCFG=?\r",
+    "AT^SYSCFG=?\r",
+    "AT^SYSCFGEX=?\r",
+};
+
+/* Cached replies to invalidate when a given unsolicited message arrives */
+static const struct {
+    const gchar *unsolicited_prefix;
+    const gchar *command_prefix;
+} reply_cache_invalidations[] = {
+    { "+CREG",  "AT+COPS?"  },
+    { "+CREG",  "AT+CREG?"  },
+    { "+CGREG", "AT+COPS?"  },
+    { "+CGREG", "AT+CGREG?" },
+    { "+CEREG", "AT+COPS?"  },
+    { "+CEREG", "AT+CEREG?" },
+    { "+CPIN",  "AT+CPIN?"  },
+    { "+CPIN",  "AT+CIMI"   },
+    { "+CPIN",  "AT+CCID"   },
+    { "+CIEV",  "AT+CIND?"  },
+};
+
+/* Commands whose replies come from the SIM card. They don't change while the
+ * same SIM is in use, but the card may be swapped without the modem telling
+ * (no +CPIN URC, or no hot swap support), so they are only kept for a while
+ * and explicitly dropped whenever a SIM change is possible. */
+static const gchar *reply_cache_sim_commands[] = {
+    "AT+CIMI\r",
+    "AT+CCID\r",
+};
+
+#define SIM_REPLY_CACHE_TTL_MS (5 * 60 * 1000)
+
+static void
+reply_cache_add_sim_classes (MMSerialReplyCache *cache)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (reply_cache_sim_commands); i++)
+        mm_serial_reply_cache_add_class (cache,
+                                         reply_cache_sim_commands[i],
+                                         SIM_REPLY_CACHE_TTL_MS,
+                                         TRUE);
+}
+
+void
+mm_port_serial_at_reply_cache_invalidate_sim (MMSerialReplyCache *cache)
+{
+    guint i;
+
+    g_return_if_fail (cache != NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (reply_cache_sim_commands); i++) {
+        GByteArray *command;
+
+        command = g_byte_array_new ();
+        g_byte_array_append (command,
+                             (const guint8 *) reply_cache_sim_commands[i],
+                             strlen (reply_cache_sim_commands[i]));
+        mm_serial_reply_cache_remove (cache, command);
+        g_byte_array_unref (command);
+    }
+}
+
+static void
+reply_cache_setup (MMPortSerialAt *self)
+{
+    MMSerialReplyCache *cache;
+    guint i;
+
+    cache = mm_port_serial_peek_reply_cache (MM_PORT_SERIAL (self));
+
+    for (i = 0; i < G_N_ELEMENTS (reply_cache_always_cacheable); i++)
+        mm_serial_reply_cache_add_class (cache,
+                                         reply_cache_always_cacheable[i],
+                                         MM_SERIAL_REPLY_CACHE_TTL_INFINITE,
+                                         TRUE);
+    reply_cache_add_sim_classes (cache);
+
+    for (i = 0; i < G_N_ELEMENTS (reply_cache_invalidations); i++)
+        mm_serial_reply_cache_add_invalidation (cache,
+                                                reply_cache_invalidations[i].unsolicited_prefix,
+                                                reply_cache_invalidations[i].command_prefix);
+}
+
+/* Commands whose replies are the same whichever port of the modem sends them */
+static const gchar *shared_reply_cache_commands[] = {
+    "AT+CGMI\r", "AT+GMI\r",
+    "AT+CGMM\r", "AT+GMM\r",
+    "AT+CGMR\r", "AT+GMR\r",
+    "AT+CGSN\r", "AT+GSN\r",
+};
+
+/* Maximum number of replies in the shared cache; one per command suffices */
+#define SHARED_REPLY_CACHE_MAX_ENTRIES \
+    (G_N_ELEMENTS (shared_reply_cache_commands) + G_N_ELEMENTS (reply_cache_sim_commands))
+
+MMSerialReplyCache *
+mm_port_serial_at_shared_reply_cache_new (void)
+{
+    MMSerialReplyCache *cache;
+    guint i;
+
+    cache = mm_serial_reply_cache_new (SHARED_REPLY_CACHE_MAX_ENTRIES,
+                                       MM_SERIAL_REPLY_CACHE_TTL_INFINITE);
+    mm_serial_reply_cache_set_max_size (cache, mm_memory_budget_get ()->reply_cache_size);
+
+    for (i = 0; i < G_N_ELEMENTS (shared_reply_cache_commands); i++)
+        mm_serial_reply_cache_add_class (cache,
+                                         shared_reply_cache_commands[i],
+                                         MM_SERIAL_REPLY_CACHE_TTL_INFINITE,
+                                         TRUE);
+    reply_cache_add_sim_classes (cache);
+
+    /* A different SIM may be inserted */
+    mm_serial_reply_cache_add_invalidation (cache, "+CPIN", "AT+CIMI");
+    mm_serial_reply_cache_add_invalidation (cache, "+CPIN", "AT+CCID");
+
+    return cache;
+}
+
 static void
 mm_port_serial_at_init (MMPortSerialAt *self)
 {
@@ -545,6 +1345,15 @@ mm_port_serial_at_init (MMPortSerialAt *self)
 
     /* By default, don't send line feed */
     self->priv->send_lf = FALSE;
+
+    self->priv->unsolicited_msg_prefixes = g_hash_table_new_full (g_str_hash,
+                                                                  g_str_equal,
+                                                                  NULL,
+                                                                  (GDestroyNotify)unsolicited_msg_prefix_free);
+    self->priv->unsolicited_msg_prefix_lengths = g_array_new (FALSE, FALSE, sizeof (gsize));
+    self->priv->unsolicited_msg_matches = g_array_new (FALSE, FALSE, sizeof (MMSerialBufferRange));
+
+    reply_cache_setup (self);
 }
 
 static void
@@ -619,11 +1428,18 @@ finalize (GObject *object)
                                                                     self->priv->unsolicited_msg_handlers);
     }
 
+    g_hash_table_unref (self->priv->unsolicited_msg_prefixes);
+    g_array_unref (self->priv->unsolicited_msg_prefix_lengths);
+    g_array_unref (self->priv->unsolicited_msg_matches);
+
     if (self->priv->response_parser_notify)
         self->priv->response_parser_notify (self->priv->response_parser_user_data);
 
     g_strfreev (self->priv->init_sequence);
 
+    if (self->priv->parser_string)
+        g_string_free (self->priv->parser_string, TRUE);
+
     G_OBJECT_CLASS (mm_port_serial_at_parent_class)->finalize (object);
 }
 
@@ -643,7 +1459,9 @@ mm_port_serial_at_class_init (MMPortSerialAtClass *klass)
     serial_class->parse_unsolicited = parse_unsolicited;
     serial_class->parse_response = parse_response;
     serial_class->debug_log = debug_log;
+    serial_class->log_category = MM_LOG_CATEGORY_SERIAL_AT;
     serial_class->config = config;
+    serial_class->command_is_shareable = command_is_shareable;
 
     g_object_class_install_property
         (object_class, PROP_REMOVE_ECHO,
@@ -53,14 +53,25 @@ typedef enum { /*< underscore_name=mm_port_serial_at_flag >*/
     MM_PORT_SERIAL_AT_FLAG_GPS_CONTROL = 1 << 3,
 } MMPortSerialAtFlag;
 
+/* The parser gets the whole response received so far; @scanned is the amount
+ * of bytes at the beginning of the response that the parser itself reported
+ * as already scanned in previous calls, and which it may skip. It is updated
+ * by the port every time data is consumed or removed from the buffer. */
 typedef gboolean (*MMPortSerialAtResponseParserFn) (gpointer user_data,
                                                     GString *response,
+                                                    gsize *scanned,
                                                     GError **error);
 
 typedef void (*MMPortSerialAtUnsolicitedMsgFn) (MMPortSerialAt *port,
                                                 GMatchInfo *match_info,
                                                 gpointer user_data);
 
+/* Gets the response received so far each time more data arrives for a
+ * command whose response is still incomplete */
+typedef void (*MMPortSerialAtPartialResponseFn) (MMPortSerialAt *port,
+                                                 const gchar *partial,
+                                                 gpointer user_data);
+
 #define MM_PORT_SERIAL_AT_REMOVE_ECHO           "remove-echo"
 #define MM_PORT_SERIAL_AT_INIT_SEQUENCE_ENABLED "init-sequence-enabled"
 #define MM_PORT_SERIAL_AT_INIT_SEQUENCE         "init-sequence"
@@ -80,6 +91,10 @@ GType mm_port_serial_at_get_type (void);
 MMPortSerialAt *mm_port_serial_at_new (const char *name,
                                        MMPortSubsys subsys);
 
+/* Messages are expected to be given right after a line boundary. If the regex
+ * starts with <CR> and/or <LF> followed by some literal text (e.g. "\\+CREG:"),
+ * that text is used as prefix to look for in the beginning of each line, and the
+ * regex is only run if the prefix is found. */
 void     mm_port_serial_at_add_unsolicited_msg_handler (MMPortSerialAt *self,
                                                         GRegex *regex,
                                                         MMPortSerialAtUnsolicitedMsgFn callback,
@@ -95,6 +110,11 @@ void     mm_port_serial_at_set_response_parser (MMPortSerialAt *self,
                                                 gpointer user_data,
                                                 GDestroyNotify notify);
 
+/* Only one at a time; set NULL to clear it */
+void     mm_port_serial_at_set_partial_response_handler (MMPortSerialAt *self,
+                                                         MMPortSerialAtPartialResponseFn fn,
+                                                         gpointer user_data);
+
 void         mm_port_serial_at_command        (MMPortSerialAt *self,
                                                const char *command,
                                                guint32 timeout_seconds,
@@ -103,10 +123,35 @@ void         mm_port_serial_at_command        (MMPortSerialAt *self,
                                                GCancellable *cancellable,
                                                GAsyncReadyCallback callback,
                                                gpointer user_data);
+void         mm_port_serial_at_command_full   (MMPortSerialAt *self,
+                                               const char *command,
+                                               guint32 timeout_seconds,
+                                               gboolean is_raw,
+                                               gboolean allow_cached,
+                                               MMPortSerialCommandPriority priority,
+                                               GCancellable *cancellable,
+                                               GAsyncReadyCallback callback,
+                                               gpointer user_data);
+/* Like mm_port_serial_at_command_full(), for non-raw commands which are sent
+ * over and over, like the ones in static sequences: the bytes to send are
+ * built once and shared. Not to be used with commands carrying user data. */
+void         mm_port_serial_at_command_interned (MMPortSerialAt *self,
+                                                 const char *command,
+                                                 guint32 timeout_seconds,
+                                                 gboolean allow_cached,
+                                                 MMPortSerialCommandPriority priority,
+                                                 GCancellable *cancellable,
+                                                 GAsyncReadyCallback callback,
+                                                 gpointer user_data);
 const gchar *mm_port_serial_at_command_finish (MMPortSerialAt *self,
                                                GAsyncResult *res,
                                                GError **error);
 
+/* Bytes to send for the given non-raw command, shared by all callers; must
+ * not be modified. Returns a new reference. */
+GByteArray  *mm_port_serial_at_command_intern (const gchar *command,
+                                               gboolean send_lf);
+
 /*
  * Convert a string into a quoted and escaped string. Returns a new
  * allocated string. Follows ITU V.250 5.4.2.2 "String constants".
@@ -115,6 +160,7 @@ gchar   *mm_port_serial_at_quote_string (const char *string);
 
 /* Just for unit tests */
 void     mm_port_serial_at_remove_echo (GByteArray *response);
+gchar   *mm_port_serial_at_unsolicited_msg_prefix_from_regex (GRegex *regex);
 
 void     mm_port_serial_at_set_flags (MMPortSerialAt *self,
                                       MMPortSerialAtFlag flags);
@@ -124,4 +170,21 @@ MMPortSerialAtFlag mm_port_serial_at_get_flags (MMPortSerialAt *self);
 /* Tell the port to run its init sequence, if any, right away */
 void mm_port_serial_at_run_init_sequence (MMPortSerialAt *self);
 
+/* When the port is first configured, switch to the highest rate supported
+ * by both ends (AT+IPR), not above the given one; 0 to disable. If the modem
+ * can't be reached at the new rate, the previous one is restored. */
+void mm_port_serial_at_set_max_baudrate (MMPortSerialAt *self,
+                                         guint max_baudrate);
+
+/* New cache for the replies to modem-global commands (identification, IMSI,
+ * ICCID), to be shared among all the AT ports of a modem with
+ * mm_port_serial_set_shared_reply_cache(). Free with
+ * mm_serial_reply_cache_free(). */
+MMSerialReplyCache *mm_port_serial_at_shared_reply_cache_new (void);
+
+/* Drop the cached replies read from the SIM card (IMSI, ICCID), either from
+ * the port's own cache or from the shared one; e.g. after the SIM is unlocked
+ * or may have been swapped. */
+void mm_port_serial_at_reply_cache_invalidate_sim (MMSerialReplyCache *cache);
+
 #endif /* MM_PORT_SERIAL_AT_H */
@@ -29,8 +29,13 @@ struct _MMPortSerialGpsPrivate {
     gpointer user_data;
     GDestroyNotify notify;
 
-    /* Regex for all known traces */
-    GRegex *known_traces_regex;
+    /* UBX-NAV-PVT handler data; if set, UBX frames are also looked for */
+    MMPortSerialGpsUbxPvtFn ubx_pvt_callback;
+    gpointer ubx_pvt_user_data;
+    GDestroyNotify ubx_pvt_notify;
+
+    /* Scratch string where traces are given to the handler */
+    GString *trace;
 };
 
 /*****************************************************************************/
@@ -51,85 +56,281 @@ mm_port_serial_gps_add_trace_handler (MMPortSerialGps *self,
     self->priv->notify = notify;
 }
 
+void
+mm_port_serial_gps_add_ubx_pvt_handler (MMPortSerialGps *self,
+                                        MMPortSerialGpsUbxPvtFn callback,
+                                        gpointer user_data,
+                                        GDestroyNotify notify)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_GPS (self));
+
+    if (self->priv->ubx_pvt_notify)
+        self->priv->ubx_pvt_notify (self->priv->ubx_pvt_user_data);
+
+    self->priv->ubx_pvt_callback = callback;
+    self->priv->ubx_pvt_user_data = user_data;
+    self->priv->ubx_pvt_notify = notify;
+}
+
 /*****************************************************************************/
 
-static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
+/* UBX frames are "<B5><62><class><id><length:LE16><payload><CK_A><CK_B>",
+ * with an 8-bit Fletcher checksum computed from the class to the end of the
+ * payload. */
+#define UBX_SYNC_1          0xB5
+#define UBX_SYNC_2          0x62
+#define UBX_HEADER_LEN      6
+#define UBX_CHECKSUM_LEN    2
+#define UBX_MAX_PAYLOAD_LEN 1024
+
+#define UBX_CLASS_NAV       0x01
+#define UBX_ID_NAV_PVT      0x07
+#define UBX_NAV_PVT_LEN     92
+
+static guint16
+ubx_read_u16 (const guint8 *data)
+{
+    return (guint16) (data[0] | (data[1] << 8));
+}
+
+static gint32
+ubx_read_i32 (const guint8 *data)
+{
+    return (gint32) ((guint32) data[0] |
+                     ((guint32) data[1] << 8) |
+                     ((guint32) data[2] << 16) |
+                     ((guint32) data[3] << 24));
+}
+
+static void
+ubx_process_nav_pvt (MMPortSerialGps *self,
+                     const guint8 *payload)
 {
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
+    MMPortSerialGpsUbxPvt pvt;
+
+    pvt.year = ubx_read_u16 (&payload[4]);
+    pvt.month = payload[6];
+    pvt.day = payload[7];
+    pvt.hour = payload[8];
+    pvt.minute = payload[9];
+    pvt.second = payload[10];
+    pvt.valid = payload[11];
+    pvt.fix_type = payload[20];
+    pvt.flags = payload[21];
+    pvt.num_sv = payload[23];
+    pvt.longitude = ubx_read_i32 (&payload[24]) * 1e-7;
+    pvt.latitude = ubx_read_i32 (&payload[28]) * 1e-7;
+    pvt.altitude = ubx_read_i32 (&payload[36]) / 1000.0;
+
+    self->priv->ubx_pvt_callback (self, &pvt, self->priv->ubx_pvt_user_data);
+}
 
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
+/* Returns the length of the frame found at @start, 0 if it is incomplete or
+ * -1 if it isn't a valid frame */
+static gssize
+ubx_parse_frame (MMPortSerialGps *self,
+                 const guint8 *start,
+                 gsize available,
+                 gboolean *is_nav_pvt)
+{
+    guint16 payload_len;
+    guint8 ck_a = 0;
+    guint8 ck_b = 0;
+    gsize i;
+
+    *is_nav_pvt = FALSE;
+
+    if (available < 2)
+        return 0;
+    if (start[1] != UBX_SYNC_2)
+        return -1;
+    if (available < UBX_HEADER_LEN)
+        return 0;
+
+    payload_len = ubx_read_u16 (&start[4]);
+    if (payload_len > UBX_MAX_PAYLOAD_LEN)
+        return -1;
+    if (available < (gsize) UBX_HEADER_LEN + payload_len + UBX_CHECKSUM_LEN)
+        return 0;
+
+    for (i = 2; i < (gsize) UBX_HEADER_LEN + payload_len; i++) {
+        ck_a += start[i];
+        ck_b += ck_a;
+    }
+    if (start[i] != ck_a || start[i + 1] != ck_b) {
+        mm_dbg ("(%s): ignoring UBX frame with invalid checksum",
+                mm_port_get_device (MM_PORT (self)));
+        return -1;
+    }
 
-    return FALSE;
+    *is_nav_pvt = (start[2] == UBX_CLASS_NAV &&
+                   start[3] == UBX_ID_NAV_PVT &&
+                   payload_len == UBX_NAV_PVT_LEN);
+    return UBX_HEADER_LEN + payload_len + UBX_CHECKSUM_LEN;
+}
+
+/*****************************************************************************/
+
+/* Longest sentence waited for; NMEA limits them to 82 bytes, but some
+ * proprietary ones are longer */
+#define NMEA_MAX_SENTENCE_LEN 1024
+
+static void
+append_non_trace (GByteArray   **remaining,
+                  const guint8  *data,
+                  gsize          len)
+{
+    if (!len)
+        return;
+    if (!*remaining)
+        *remaining = g_byte_array_sized_new (len);
+    g_byte_array_append (*remaining, data, len);
+}
+
+/* Next byte which may start a NMEA sentence or, if enabled, a UBX frame */
+static const guint8 *
+find_frame_start (const guint8 *data,
+                  gsize len,
+                  gboolean ubx)
+{
+    gsize i;
+
+    if (!ubx)
+        return memchr (data, '$', len);
+
+    for (i = 0; i < len; i++) {
+        if (data[i] == '$' || data[i] == UBX_SYNC_1)
+            return &data[i];
+    }
+    return NULL;
 }
 
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
     MMPortSerialGps *self = MM_PORT_SERIAL_GPS (port);
-    gboolean matches;
-    GMatchInfo *match_info;
-    gchar *str;
-    gint result_len;
-    guint i;
-
-    for (i = 0; i < response->len; i++) {
-        /* If there is any content before the first $,
-         * assume it's garbage, and skip it */
-        if (response->data[i] == '$') {
-            if (i > 0)
-                g_byte_array_remove_range (response, 0, i);
-            /* else, good, we're already started with $ */
+    GByteArray *remaining = NULL;
+    const guint8 *data;
+    gsize len;
+    gsize pos = 0;
+    gboolean ubx;
+
+    ubx = !!self->priv->ubx_pvt_callback;
+    data = mm_serial_buffer_get_data (response);
+    len = mm_serial_buffer_get_length (response);
+
+    /* Sentences are framed as "$<body>[*HH]\r\n"; if the checksum is given,
+     * it's the XOR of all the bytes in the body. Everything else found in the
+     * buffer is not a trace, and is given as parsed response; this includes
+     * UBX frames other than NAV-PVT, e.g. the acknowledgements of commands. */
+    while (pos < len) {
+        const guint8 *start;
+        const guint8 *star = NULL;
+        const guint8 *p;
+        guint8 checksum = 0;
+
+        start = find_frame_start (&data[pos], len - pos, ubx);
+        if (!start) {
+            append_non_trace (&remaining, &data[pos], len - pos);
+            pos = len;
             break;
         }
-    }
+        append_non_trace (&remaining, &data[pos], start - &data[pos]);
+        pos = start - data;
+
+        if (*start == UBX_SYNC_1) {
+            gboolean is_nav_pvt;
+            gssize frame_len;
+
+            frame_len = ubx_parse_frame (self, start, len - pos, &is_nav_pvt);
+            /* Incomplete frame, wait for the rest */
+            if (frame_len == 0)
+                break;
+            /* Not a frame, skip the sync byte and look again */
+            if (frame_len < 0) {
+                append_non_trace (&remaining, start, 1);
+                pos++;
+                continue;
+            }
 
-    matches = g_regex_match_full (self->priv->known_traces_regex,
-                                  (const gchar *) response->data,
-                                  response->len,
-                                  0, 0, &match_info, NULL);
+            if (is_nav_pvt)
+                ubx_process_nav_pvt (self, &start[UBX_HEADER_LEN]);
+            else
+                append_non_trace (&remaining, start, frame_len);
+            pos += frame_len;
+            continue;
+        }
 
-    if (self->priv->callback) {
-        while (g_match_info_matches (match_info)) {
-            gchar *trace;
+        for (p = start + 1;
+             p < &data[len] && *p != '\n' && *p != '$' && !(ubx && *p == UBX_SYNC_1);
+             p++) {
+            if (star)
+                continue;
+            if (*p == '*')
+                star = p;
+            else
+                checksum ^= *p;
+        }
 
-            trace = g_match_info_fetch (match_info, 0);
-            if (trace) {
-                self->priv->callback (self, trace, self->priv->user_data);
-                g_free (trace);
+        /* Incomplete sentence, wait for the rest unless it's too long */
+        if (p == &data[len]) {
+            if ((gsize) (p - start) > NMEA_MAX_SENTENCE_LEN) {
+                append_non_trace (&remaining, start, p - start);
+                pos = len;
             }
-            g_match_info_next (match_info, NULL);
+            break;
         }
-    }
 
-    g_match_info_free (match_info);
+        /* A new sentence or frame started before the end of the current one */
+        if (*p != '\n') {
+            append_non_trace (&remaining, start, p - start);
+            pos = p - data;
+            continue;
+        }
 
-    if (!matches)
-        return MM_PORT_SERIAL_RESPONSE_NONE;
+        /* Found the end of the sentence */
+        pos = p + 1 - data;
+        if (p[-1] != '\r') {
+            append_non_trace (&remaining, start, p + 1 - start);
+            continue;
+        }
 
-    /* Remove matches */
-    result_len = response->len;
-    str = g_regex_replace_eval (self->priv->known_traces_regex,
-                                (const char *) response->data,
-                                response->len,
-                                0, 0,
-                                remove_eval_cb, &result_len, NULL);
+        if (star) {
+            gint high = -1;
+            gint low = -1;
 
-    /* Cleanup response buffer */
-    g_byte_array_remove_range (response, 0, response->len);
+            if (p - star == 4) {
+                high = g_ascii_xdigit_value (star[1]);
+                low = g_ascii_xdigit_value (star[2]);
+            }
+            if (high < 0 || low < 0 || ((high << 4) | low) != checksum) {
+                mm_dbg ("(%s): ignoring NMEA trace with invalid checksum",
+                        mm_port_get_device (MM_PORT (self)));
+                continue;
+            }
+        }
 
-    /* Build parsed response */
-    *parsed_response = g_byte_array_new_take ((guint8 *)str, result_len);
+        if (self->priv->callback) {
+            /* Reuse the same string for all traces, the callback must copy it
+             * if it needs to keep it */
+            g_string_truncate (self->priv->trace, 0);
+            g_string_append_len (self->priv->trace, (const gchar *) start, p + 1 - start);
+            self->priv->callback (self, self->priv->trace->str, self->priv->user_data);
+        }
+    }
+
+    /* Cleanup response buffer, keeping the incomplete sentence, if any */
+    mm_serial_buffer_consume (response, pos);
 
-    return TRUE;
+    if (!remaining)
+        return MM_PORT_SERIAL_RESPONSE_NONE;
+
+    /* Build parsed response */
+    *parsed_response = remaining;
+    return MM_PORT_SERIAL_RESPONSE_BUFFER;
 }
 
 /*****************************************************************************/
@@ -161,7 +362,7 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
     }
 
     g_string_append_c (debug, '\'');
-    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    mm_log_unchecked (LOGL_DEBUG, "(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
     g_string_truncate (debug, 0);
 }
 
@@ -184,12 +385,7 @@ mm_port_serial_gps_init (MMPortSerialGps *self)
                                               MM_TYPE_PORT_SERIAL_GPS,
                                               MMPortSerialGpsPrivate);
 
-    /* We'll assume that all traces start with the dollar sign and end with \r\n */
-    self->priv->known_traces_regex =
-        g_regex_new ("\\$.*\\r\\n",
-                     G_REGEX_RAW | G_REGEX_OPTIMIZE,
-                     0,
-                     NULL);
+    self->priv->trace = g_string_sized_new (128);
 }
 
 static void
@@ -199,8 +395,10 @@ finalize (GObject *object)
 
     if (self->priv->notify)
         self->priv->notify (self->priv->user_data);
+    if (self->priv->ubx_pvt_notify)
+        self->priv->ubx_pvt_notify (self->priv->ubx_pvt_user_data);
 
-    g_regex_unref (self->priv->known_traces_regex);
+    g_string_free (self->priv->trace, TRUE);
 
     G_OBJECT_CLASS (mm_port_serial_gps_parent_class)->finalize (object);
 }
@@ -218,4 +416,5 @@ mm_port_serial_gps_class_init (MMPortSerialGpsClass *klass)
 
     serial_class->parse_response = parse_response;
     serial_class->debug_log = debug_log;
+    serial_class->log_category = MM_LOG_CATEGORY_GPS;
 }
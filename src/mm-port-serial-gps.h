@@ -32,10 +32,40 @@ typedef struct _MMPortSerialGps MMPortSerialGps;
 typedef struct _MMPortSerialGpsClass MMPortSerialGpsClass;
 typedef struct _MMPortSerialGpsPrivate MMPortSerialGpsPrivate;
 
+/* The trace, including the trailing <CR><LF>, is only valid during the call */
 typedef void (*MMPortSerialGpsTraceFn) (MMPortSerialGps *port,
                                         const gchar *trace,
                                         gpointer user_data);
 
+/* Fix reported in a UBX-NAV-PVT frame by u-blox receivers */
+typedef struct {
+    /* UTC time */
+    guint16 year;
+    guint8 month;
+    guint8 day;
+    guint8 hour;
+    guint8 minute;
+    guint8 second;
+    /* Validity flags of date and time */
+    guint8 valid;
+    /* GNSS fix type: 0 if no fix, 2 for 2D, 3 for 3D... */
+    guint8 fix_type;
+    /* Fix status flags, bit 0 is set if the fix is valid */
+    guint8 flags;
+    /* Number of satellites used in the fix */
+    guint8 num_sv;
+    /* Degrees */
+    gdouble longitude;
+    gdouble latitude;
+    /* Meters above mean sea level */
+    gdouble altitude;
+} MMPortSerialGpsUbxPvt;
+
+/* The fix is only valid during the call */
+typedef void (*MMPortSerialGpsUbxPvtFn) (MMPortSerialGps *port,
+                                         const MMPortSerialGpsUbxPvt *pvt,
+                                         gpointer user_data);
+
 struct _MMPortSerialGps {
     MMPortSerial parent;
     MMPortSerialGpsPrivate *priv;
@@ -54,4 +84,11 @@ void mm_port_serial_gps_add_trace_handler (MMPortSerialGps *self,
                                            gpointer user_data,
                                            GDestroyNotify notify);
 
+/* Setting a UBX-NAV-PVT handler enables the framing of UBX binary frames,
+ * which may be mixed with NMEA traces */
+void mm_port_serial_gps_add_ubx_pvt_handler (MMPortSerialGps *self,
+                                             MMPortSerialGpsUbxPvtFn callback,
+                                             gpointer user_data,
+                                             GDestroyNotify notify);
+
 #endif /* MM_PORT_SERIAL_GPS_H */
@@ -26,75 +26,110 @@
 #include "libqcdm/src/com.h"
 #include "libqcdm/src/utils.h"
 #include "libqcdm/src/errors.h"
+#include "libqcdm/src/commands.h"
 #include "libqcdm/src/dm-commands.h"
+#include "mm-qcdm-log-stream.h"
 #include "mm-log.h"
 
 G_DEFINE_TYPE (MMPortSerialQcdm, mm_port_serial_qcdm, MM_TYPE_PORT_SERIAL)
 
+/* Initial size of the buffer frames are decapsulated into */
+#define SCRATCH_INITIAL_SIZE 1024
+
 struct _MMPortSerialQcdmPrivate {
     GSList *unsolicited_msg_handlers;
+    /* Reused for every frame; grown as needed */
+    GByteArray *scratch;
+    /* Log codes requested with set_log_mask() */
+    GArray *log_codes;
+    MMQcdmLogStream *log_stream;
 };
 
 /*****************************************************************************/
 
+/* Returns TRUE and the offset where the frame starts if a full frame is
+ * found. Otherwise, returns FALSE and the amount of data that can never be
+ * part of a frame, i.e. up to the last frame marker. */
 static gboolean
-find_qcdm_start (GByteArray *response, gsize *start)
+find_qcdm_start (MMSerialBuffer *response, gsize *start)
 {
-    int i, last = -1;
+    const guint8 *data;
+    const guint8 *marker;
+    gsize len;
+    gsize i;
+    gssize last = -1;
 
     /* Look for 3 bytes and a QCDM frame marker, ie enough data for a valid
      * frame.  There will usually be three cases here; (1) a QCDM frame
      * starting with data and terminated by 0x7E, and (2) a QCDM frame starting
      * with 0x7E and ending with 0x7E, and (3) a non-QCDM frame that still
      * uses HDLC framing (like Sierra CnS) that starts and ends with 0x7E.
+     *
+     * Data up to the buffer mark was already scanned in a previous attempt,
+     * and has no frame markers.
      */
-    for (i = 0; i < response->len; i++) {
-        if (response->data[i] == 0x7E) {
-            if (i > last + 3) {
-                /* Got a full QCDM frame; 3 non-0x7E bytes and a terminator */
-                if (start)
-                    *start = last + 1;
-                return TRUE;
-            }
-
-            /* Save position of the last QCDM frame marker */
-            last = i;
+    data = mm_serial_buffer_get_data (response);
+    len = mm_serial_buffer_get_length (response);
+    for (i = mm_serial_buffer_get_mark (response);
+         i < len && (marker = memchr (data + i, 0x7E, len - i)) != NULL;
+         i++) {
+        i = marker - data;
+        if ((gssize) i > last + 3) {
+            /* Got a full QCDM frame; 3 non-0x7E bytes and a terminator */
+            *start = last + 1;
+            return TRUE;
         }
+
+        /* Save position of the last QCDM frame marker */
+        last = i;
     }
+
+    *start = last + 1;
     return FALSE;
 }
 
+/* On success, the decapsulated frame is left in the scratch buffer of the
+ * port, which is only valid until the next frame is parsed */
 static MMPortSerialResponseType
-parse_qcdm (GByteArray *response,
+parse_qcdm (MMPortSerialQcdm *self,
+            MMSerialBuffer *response,
             gboolean want_log,
-            GByteArray **parsed_response,
             GError **error)
 {
+    GByteArray *scratch = self->priv->scratch;
     gsize start = 0;
     gsize used = 0;
     gsize unescaped_len = 0;
-    guint8 *unescaped_buffer;
+    gsize len;
     qcdmbool more = FALSE;
 
     /* Get the offset into the buffer of where the QCDM frame starts */
     if (!find_qcdm_start (response, &start)) {
         /* Discard the unparsable data right away, we do need a QCDM
          * start, and anything that comes before it is unknown data
-         * that we'll never use. */
+         * that we'll never use. What's left has no frame markers, so
+         * the next attempt goes on from its end. */
+        mm_serial_buffer_consume (response, start);
+        mm_serial_buffer_set_mark (response, mm_serial_buffer_get_length (response));
         return MM_PORT_SERIAL_RESPONSE_NONE;
     }
 
     /* If there is anything before the start marker, remove it */
-    g_byte_array_remove_range (response, 0, start);
-    if (response->len == 0)
+    mm_serial_buffer_consume (response, start);
+    len = mm_serial_buffer_get_length (response);
+    if (len == 0)
         return MM_PORT_SERIAL_RESPONSE_NONE;
 
-    /* Try to decapsulate the response into a buffer */
-    unescaped_buffer = g_malloc (1024);
-    if (!dm_decapsulate_buffer ((const char *)(response->data),
-                                response->len,
-                                (char *)unescaped_buffer,
-                                1024,
+    /* Unescaping never makes the data longer, so a buffer as long as the
+     * received data is always enough, whatever the size of the frame. Growing
+     * the array only reallocates it if it never got this long before. */
+    g_byte_array_set_size (scratch, len + 1);
+
+    /* Try to decapsulate the response into the scratch buffer */
+    if (!dm_decapsulate_buffer ((const char *) mm_serial_buffer_get_data (response),
+                                len,
+                                (char *) scratch->data,
+                                scratch->len,
                                 &unescaped_len,
                                 &used,
                                 &more)) {
@@ -105,45 +140,48 @@ parse_qcdm (GByteArray *response,
                      MM_SERIAL_ERROR,
                      MM_SERIAL_ERROR_PARSE_FAILED,
                      "Failed to unescape QCDM packet");
-        g_free (unescaped_buffer);
         return MM_PORT_SERIAL_RESPONSE_ERROR;
     }
 
     if (more) {
         /* Need more data, we leave the original byte array untouched so that
          * we can retry later when more data arrives. */
-        g_free (unescaped_buffer);
         return MM_PORT_SERIAL_RESPONSE_NONE;
     }
 
-    if (want_log && unescaped_buffer[0] != DIAG_CMD_LOG) {
+    g_byte_array_set_size (scratch, unescaped_len);
+
+    if (want_log && (unescaped_len == 0 || scratch->data[0] != DIAG_CMD_LOG)) {
         /* If we only want log items and this isn't one, don't remove this
          * DM packet from the buffer.
          */
-        g_free (unescaped_buffer);
         return MM_PORT_SERIAL_RESPONSE_NONE;
     }
 
-    /* Successfully decapsulated the DM command. We'll build a new byte array
-     * with the response, and leave the input buffer cleaned up. */
-    g_assert (unescaped_len <= 1024);
-    unescaped_buffer = g_realloc (unescaped_buffer, unescaped_len);
-    *parsed_response = g_byte_array_new_take (unescaped_buffer, unescaped_len);
-
     /* Remove the data we used from the input buffer, leaving out any
      * additional data that may already been received (e.g. from the following
      * message). */
-    g_byte_array_remove_range (response, 0, used);
+    mm_serial_buffer_consume (response, used);
     return MM_PORT_SERIAL_RESPONSE_BUFFER;
 }
 
 static MMPortSerialResponseType
 parse_response (MMPortSerial *port,
-                GByteArray *response,
+                MMSerialBuffer *response,
                 GByteArray **parsed_response,
                 GError **error)
 {
-    return parse_qcdm (response, FALSE, parsed_response, error);
+    MMPortSerialQcdm *self = MM_PORT_SERIAL_QCDM (port);
+    MMPortSerialResponseType type;
+
+    type = parse_qcdm (self, response, FALSE, error);
+    if (type == MM_PORT_SERIAL_RESPONSE_BUFFER) {
+        /* Responses outlive the scratch buffer (e.g. in the reply cache), so
+         * they get their own copy */
+        *parsed_response = g_byte_array_sized_new (self->priv->scratch->len);
+        g_byte_array_append (*parsed_response, self->priv->scratch->data, self->priv->scratch->len);
+    }
+    return type;
 }
 
 /*****************************************************************************/
@@ -218,10 +256,161 @@ debug_log (MMPortSerial *port, const char *prefix, const char *buf, gsize len)
     while (len--)
         g_string_append_printf (debug, " %02x", (guint8) (*s++ & 0xFF));
 
-    mm_dbg ("(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
+    mm_log_unchecked (LOGL_DEBUG, "(%s): %s", mm_port_get_device (MM_PORT (port)), debug->str);
     g_string_truncate (debug, 0);
 }
 
+/*****************************************************************************/
+/* Log mask */
+
+/* Equipment ID of all the log codes we enable */
+#define LOG_EQUIPMENT_ID 0x01
+
+gboolean
+mm_port_serial_qcdm_set_log_mask_finish (MMPortSerialQcdm *self,
+                                         GAsyncResult *res,
+                                         GError **error)
+{
+    return !g_simple_async_result_propagate_error (G_SIMPLE_ASYNC_RESULT (res), error);
+}
+
+static void
+set_log_mask_ready (MMPortSerialQcdm *self,
+                    GAsyncResult *res,
+                    GSimpleAsyncResult *simple)
+{
+    QcdmResult *result;
+    GByteArray *response;
+    GError *error = NULL;
+    gint err = QCDM_SUCCESS;
+
+    response = mm_port_serial_qcdm_command_finish (self, res, &error);
+    if (!response) {
+        g_simple_async_result_take_error (simple, error);
+        g_simple_async_result_complete (simple);
+        g_object_unref (simple);
+        return;
+    }
+
+    result = qcdm_cmd_log_config_set_mask_result ((const gchar *) response->data,
+                                                  response->len,
+                                                  &err);
+    g_byte_array_unref (response);
+    if (!result)
+        g_simple_async_result_set_error (simple,
+                                         MM_CORE_ERROR,
+                                         MM_CORE_ERROR_FAILED,
+                                         "Failed to parse Log Config Set Mask command result: %d",
+                                         err);
+    else {
+        g_simple_async_result_set_op_res_gboolean (simple, TRUE);
+        qcdm_result_unref (result);
+    }
+    g_simple_async_result_complete (simple);
+    g_object_unref (simple);
+}
+
+static void
+send_log_mask (MMPortSerialQcdm *self,
+               GSimpleAsyncResult *simple)
+{
+    const guint16 *stream_codes = NULL;
+    guint n_stream_codes = 0;
+    GArray *items;
+    GByteArray *logcmd;
+    guint16 end = 0;
+
+    /* The log codes streamed are always enabled along with the ones
+     * explicitly requested */
+    items = g_array_new (FALSE, FALSE, sizeof (guint16));
+    g_array_append_vals (items, self->priv->log_codes->data, self->priv->log_codes->len);
+    if (mm_qcdm_log_stream_get_directory ())
+        stream_codes = mm_qcdm_log_stream_get_log_codes (&n_stream_codes);
+    g_array_append_vals (items, stream_codes, n_stream_codes);
+
+    /* A NULL list disables all the log codes */
+    if (items->len > 0)
+        g_array_append_val (items, end);
+
+    logcmd = g_byte_array_sized_new (512);
+    logcmd->len = qcdm_cmd_log_config_set_mask_new ((char *) logcmd->data,
+                                                    512,
+                                                    LOG_EQUIPMENT_ID,
+                                                    items->len > 0 ? (u_int16_t *) items->data : NULL);
+    g_array_unref (items);
+    g_assert (logcmd->len);
+
+    mm_port_serial_qcdm_command (self,
+                                 logcmd,
+                                 5,
+                                 NULL,
+                                 (GAsyncReadyCallback)set_log_mask_ready,
+                                 simple);
+    g_byte_array_unref (logcmd);
+}
+
+void
+mm_port_serial_qcdm_set_log_mask (MMPortSerialQcdm *self,
+                                  const guint16 *log_codes,
+                                  guint n_log_codes,
+                                  GAsyncReadyCallback callback,
+                                  gpointer user_data)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
+
+    g_array_set_size (self->priv->log_codes, 0);
+    g_array_append_vals (self->priv->log_codes, log_codes, n_log_codes);
+
+    send_log_mask (self,
+                   g_simple_async_result_new (G_OBJECT (self),
+                                              callback,
+                                              user_data,
+                                              mm_port_serial_qcdm_set_log_mask));
+}
+
+/*****************************************************************************/
+/* Log stream */
+
+static void
+start_log_stream_ready (MMPortSerialQcdm *self,
+                        GAsyncResult *res)
+{
+    GError *error = NULL;
+
+    if (!mm_port_serial_qcdm_set_log_mask_finish (self, res, &error)) {
+        mm_warn ("(%s) couldn't enable the streamed QCDM log codes: %s",
+                 mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+    }
+}
+
+void
+mm_port_serial_qcdm_start_log_stream (MMPortSerialQcdm *self)
+{
+    guint n_codes = 0;
+
+    g_return_if_fail (MM_IS_PORT_SERIAL_QCDM (self));
+
+    if (!mm_qcdm_log_stream_get_directory ())
+        return;
+
+    if (!self->priv->log_stream) {
+        self->priv->log_stream = mm_qcdm_log_stream_new (mm_port_get_device (MM_PORT (self)));
+        if (!self->priv->log_stream)
+            return;
+    }
+
+    mm_qcdm_log_stream_get_log_codes (&n_codes);
+    if (!n_codes)
+        return;
+
+    send_log_mask (self,
+                   g_simple_async_result_new (G_OBJECT (self),
+                                              (GAsyncReadyCallback)start_log_stream_ready,
+                                              NULL,
+                                              mm_port_serial_qcdm_set_log_mask));
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -293,19 +482,22 @@ mm_port_serial_qcdm_enable_unsolicited_msg_handler (MMPortSerialQcdm *self,
 }
 
 static void
-parse_unsolicited (MMPortSerial *port, GByteArray *response)
+parse_unsolicited (MMPortSerial *port, MMSerialBuffer *response)
 {
     MMPortSerialQcdm *self = MM_PORT_SERIAL_QCDM (port);
-    GByteArray *log_buffer = NULL;
+    GByteArray *log_buffer;
     GSList *iter;
 
-    if (parse_qcdm (response,
+    if (parse_qcdm (self,
+                    response,
                     TRUE,
-                    &log_buffer,
                     NULL) != MM_PORT_SERIAL_RESPONSE_BUFFER) {
         return;
     }
 
+    /* Handlers get the scratch buffer itself, no copies */
+    log_buffer = self->priv->scratch;
+
     /* These should be guaranteed by parse_qcdm() */
     g_return_if_fail (log_buffer);
     g_return_if_fail (log_buffer->len > 0);
@@ -314,6 +506,13 @@ parse_unsolicited (MMPortSerial *port, GByteArray *response)
     if (log_buffer->len < sizeof (DMCmdLog))
         return;
 
+    /* The log item is what follows the command code, the 'more' flag and
+     * the outer length */
+    if (self->priv->log_stream)
+        mm_qcdm_log_stream_push (self->priv->log_stream,
+                                 log_buffer->data + G_STRUCT_OFFSET (DMCmdLog, _unknown2),
+                                 log_buffer->len - G_STRUCT_OFFSET (DMCmdLog, _unknown2));
+
     for (iter = self->priv->unsolicited_msg_handlers; iter; iter = iter->next) {
         MMQcdmUnsolicitedMsgHandler *handler = (MMQcdmUnsolicitedMsgHandler *) iter->data;
         DMCmdLog *log_cmd = (DMCmdLog *) log_buffer->data;
@@ -378,6 +577,8 @@ static void
 mm_port_serial_qcdm_init (MMPortSerialQcdm *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_PORT_SERIAL_QCDM, MMPortSerialQcdmPrivate);
+    self->priv->scratch = g_byte_array_sized_new (SCRATCH_INITIAL_SIZE);
+    self->priv->log_codes = g_array_new (FALSE, FALSE, sizeof (guint16));
 }
 
 static void
@@ -396,6 +597,10 @@ finalize (GObject *object)
                                                                     self->priv->unsolicited_msg_handlers);
     }
 
+    mm_qcdm_log_stream_free (self->priv->log_stream);
+    g_array_unref (self->priv->log_codes);
+    g_byte_array_unref (self->priv->scratch);
+
     G_OBJECT_CLASS (mm_port_serial_qcdm_parent_class)->finalize (object);
 }
 
@@ -413,4 +618,5 @@ mm_port_serial_qcdm_class_init (MMPortSerialQcdmClass *klass)
     port_class->parse_response = parse_response;
     port_class->config_fd = config_fd;
     port_class->debug_log = debug_log;
+    port_class->log_category = MM_LOG_CATEGORY_SERIAL_QCDM;
 }
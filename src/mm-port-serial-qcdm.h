@@ -57,6 +57,23 @@ GByteArray *mm_port_serial_qcdm_command_finish (MMPortSerialQcdm *self,
                                                 GAsyncResult *res,
                                                 GError **error);
 
+/* Sets the log codes enabled in the device. The ones streamed into files
+ * (see mm-qcdm-log-stream.h) are always enabled as well. */
+void     mm_port_serial_qcdm_set_log_mask        (MMPortSerialQcdm *self,
+                                                  const guint16 *log_codes,
+                                                  guint n_log_codes,
+                                                  GAsyncReadyCallback callback,
+                                                  gpointer user_data);
+gboolean mm_port_serial_qcdm_set_log_mask_finish (MMPortSerialQcdm *self,
+                                                  GAsyncResult *res,
+                                                  GError **error);
+
+/* Starts streaming the received log packets into a file, and enables the
+ * streamed log codes, if a log stream directory is set. The port must be
+ * open. */
+void     mm_port_serial_qcdm_start_log_stream    (MMPortSerialQcdm *self);
+
+/* The log buffer is owned by the port and is only valid during the call */
 typedef void (*MMPortSerialQcdmUnsolicitedMsgFn) (MMPortSerialQcdm *port,
                                                   GByteArray *log_buffer,
                                                   gpointer user_data);
@@ -34,6 +34,13 @@
 #include <mm-errors-types.h>
 
 #include "mm-port-serial.h"
+#include "mm-serial-stats.h"
+#include "mm-serial-recorder.h"
+#include "mm-traffic-capture.h"
+#include "mm-loop-monitor.h"
+#include "mm-profiler.h"
+#include "mm-clock.h"
+#include "mm-memory-budget.h"
 #include "mm-log.h"
 
 static gboolean port_serial_queue_process          (gpointer data);
@@ -41,9 +48,6 @@ static void     port_serial_schedule_queue_process (MMPortSerial *self,
                                                     guint timeout_ms);
 static void     port_serial_close_force            (MMPortSerial *self);
 static void     port_serial_reopen_cancel          (MMPortSerial *self);
-static void     port_serial_set_cached_reply       (MMPortSerial *self,
-                                                    const GByteArray *command,
-                                                    const GByteArray *response);
 
 G_DEFINE_TYPE (MMPortSerial, mm_port_serial, MM_TYPE_PORT)
 
@@ -54,6 +58,7 @@ enum {
     PROP_PARITY,
     PROP_STOPBITS,
     PROP_SEND_DELAY,
+    PROP_SEND_CHUNK_DELAY,
     PROP_FD,
     PROP_SPEW_CONTROL,
     PROP_RTS_CTS,
@@ -74,13 +79,42 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 #define SERIAL_BUF_SIZE 2048
 
+/* Spew control: once this many bytes were trimmed with less than a tenth as
+ * many parsed, the stream is taken as garbage (NMEA, binary...) and the port
+ * input is dropped without parsing for a while, doubling each time */
+#define SPEW_MUTE_MIN_DISCARDED   (SERIAL_BUF_SIZE * 4)
+#define SPEW_MUTE_RATIO           10
+#define SPEW_MUTE_BACKOFF_MIN_S   5
+#define SPEW_MUTE_BACKOFF_MAX_S   120
+/* Byte counts are halved when their sum goes above this */
+#define SPEW_STATS_WINDOW         (SERIAL_BUF_SIZE * 32)
+
+/* Time a queued command needs to wait to be promoted to the next priority
+ * class, in microseconds */
+#define COMMAND_PRIORITY_AGING 3000000
+
+/* Default interval between chunks of paced writes, in microseconds */
+#define SEND_CHUNK_DELAY_DEFAULT 10000
+
+/* Maximum number of cached replies per port */
+#define REPLY_CACHE_MAX_ENTRIES 64
+
 struct _MMPortSerialPrivate {
     guint32 open_count;
     gboolean forced_close;
     int fd;
-    GHashTable *reply_cache;
+    MMSerialReplyCache *reply_cache;
+    /* Not owned; cache shared by the ports of the same modem */
+    MMSerialReplyCache *shared_reply_cache;
+    MMSerialStats *stats;
+    MMSerialRecorder *recorder;
+    /* Whether the traffic is logged regardless of the log category */
+    gboolean log_debug;
+    gboolean adaptive_timeouts;
+    gboolean share_commands;
+    gboolean low_latency;
     GQueue *queue;
-    GByteArray *response;
+    MMSerialBuffer *response;
 
     /* For real ports, iochannel, and we implement the eagain limit */
     GIOChannel *iochannel;
@@ -96,9 +130,21 @@ struct _MMPortSerialPrivate {
     char parity;
     guint stopbits;
     guint64 send_delay;
+    guint64 send_chunk_delay;
     gboolean spew_control;
+    /* Buffer size allowed while a reply is awaited on a parseable stream */
+    guint spew_limit;
+    /* Hard cap of the response buffer, regardless of spew control; 0 if none */
+    gsize max_response;
+    guint64 spew_parsed;
+    guint64 spew_discarded;
+    gint64 spew_muted_until;
+    guint spew_backoff_s;
     gboolean rts_cts;
     gboolean flash_ok;
+    /* Delays overriding the ones given by callers, or -1 */
+    gint reopen_time;
+    gint flash_time;
 
     guint queue_id;
     guint timeout_id;
@@ -114,30 +160,156 @@ struct _MMPortSerialPrivate {
     gpointer reopen_ctx;
 };
 
+/*****************************************************************************/
+/* Sources of the port, driven by the clock so that tests may use a virtual
+ * one */
+
+static guint
+port_serial_source_attach (MMPortSerial *self,
+                           GSource      *source,
+                           GSourceFunc   callback)
+{
+    guint id;
+
+    g_source_set_callback (source, callback, self, NULL);
+    id = g_source_attach (source, NULL);
+    g_source_unref (source);
+    return id;
+}
+
+static guint
+port_serial_timeout_add (MMPortSerial *self,
+                         guint         interval_ms,
+                         GSourceFunc   callback)
+{
+    return port_serial_source_attach (self, mm_clock_timeout_source_new (interval_ms), callback);
+}
+
+static guint
+port_serial_timeout_add_seconds (MMPortSerial *self,
+                                 guint         interval,
+                                 GSourceFunc   callback)
+{
+    return port_serial_source_attach (self, mm_clock_timeout_source_new_seconds (interval), callback);
+}
+
+static guint
+port_serial_idle_add (MMPortSerial *self,
+                      GSourceFunc   callback)
+{
+    return port_serial_source_attach (self, g_idle_source_new (), callback);
+}
+
+static void
+port_serial_source_remove (MMPortSerial *self,
+                           guint         id)
+{
+    GSource *source;
+
+    source = g_main_context_find_source_by_id (NULL, id);
+    if (source)
+        g_source_destroy (source);
+}
+
 /*****************************************************************************/
 /* Command */
 
-typedef struct {
+typedef struct _CommandContext CommandContext;
+struct _CommandContext {
     MMPortSerial *self;
     GSimpleAsyncResult *result;
     GCancellable *cancellable;
     GByteArray *command;
     guint32 timeout;
     gboolean allow_cached;
+    MMPortSerialCommandPriority priority;
+    gint64 queued_time;
+    gint64 write_time;
+    gint64 first_byte_time;
     guint32 eagain_count;
 
     guint32 idx;
     gboolean started;
     gboolean done;
-} CommandContext;
+
+    /* Paced writes: token bucket and the timer sending the chunks */
+    gint64 pacing_last;
+    guint64 pacing_credit;
+    guint pacing_source_id;
+
+    /* Identical commands queued afterwards, which get the same result */
+    GSList *followers;
+
+    /* Cancellation while still waiting in the queue */
+    gulong cancelled_id;
+    guint cancelled_idle_id;
+};
+
+static void
+command_context_set_result (CommandContext *ctx,
+                            GByteArray *response,
+                            const GError *error)
+{
+    GSList *l;
+
+    if (error)
+        g_simple_async_result_set_from_error (ctx->result, error);
+    else
+        g_simple_async_result_set_op_res_gpointer (ctx->result,
+                                                   g_byte_array_ref (response),
+                                                   (GDestroyNotify) g_byte_array_unref);
+
+    /* Each follower gets its own copy, as callers consume the reply */
+    for (l = ctx->followers; l; l = g_slist_next (l)) {
+        CommandContext *follower = l->data;
+
+        if (error)
+            g_simple_async_result_set_from_error (follower->result, error);
+        else {
+            GByteArray *copy;
+
+            copy = g_byte_array_sized_new (response->len);
+            g_byte_array_append (copy, response->data, response->len);
+            g_simple_async_result_set_op_res_gpointer (follower->result,
+                                                       copy,
+                                                       (GDestroyNotify) g_byte_array_unref);
+        }
+    }
+}
 
 static void
 command_context_complete_and_free (CommandContext *ctx, gboolean idle)
 {
+    GSList *followers;
+
+    if (ctx->cancelled_idle_id)
+        port_serial_source_remove (ctx->self, ctx->cancelled_idle_id);
+    if (ctx->cancelled_id)
+        g_cancellable_disconnect (ctx->cancellable, ctx->cancelled_id);
+
     if (idle)
         g_simple_async_result_complete_in_idle (ctx->result);
     else
         g_simple_async_result_complete (ctx->result);
+
+    /* Followers complete after the command they attached to, in the order
+     * they were queued */
+    followers = g_slist_reverse (ctx->followers);
+    ctx->followers = NULL;
+    while (followers) {
+        CommandContext *follower = followers->data;
+
+        followers = g_slist_delete_link (followers, followers);
+        if (idle)
+            g_simple_async_result_complete_in_idle (follower->result);
+        else
+            g_simple_async_result_complete (follower->result);
+        g_object_unref (follower->result);
+        g_byte_array_unref (follower->command);
+        g_object_unref (follower->self);
+        g_slice_free (CommandContext, follower);
+    }
+
     g_object_unref (ctx->result);
     g_byte_array_unref (ctx->command);
     if (ctx->cancellable)
@@ -165,6 +337,110 @@ mm_port_serial_command (MMPortSerial *self,
                         GCancellable *cancellable,
                         GAsyncReadyCallback callback,
                         gpointer user_data)
+{
+    mm_port_serial_command_full (self,
+                                 command,
+                                 timeout_seconds,
+                                 allow_cached,
+                                 MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL,
+                                 cancellable,
+                                 callback,
+                                 user_data);
+}
+
+/* Replies to modem-global commands go to the cache shared among all the
+ * ports of the modem, if any; everything else stays in the port cache */
+static MMSerialReplyCache *
+port_serial_reply_cache_for_command (MMPortSerial     *self,
+                                     const GByteArray *command)
+{
+    if (self->priv->shared_reply_cache &&
+        mm_serial_reply_cache_is_always_cacheable (self->priv->shared_reply_cache, command))
+        return self->priv->shared_reply_cache;
+    return self->priv->reply_cache;
+}
+
+static gboolean
+port_serial_share_command (MMPortSerial *self,
+                           CommandContext *ctx)
+{
+    GList *l;
+
+    if (!self->priv->share_commands ||
+        ctx->cancellable ||
+        !MM_PORT_SERIAL_GET_CLASS (self)->command_is_shareable ||
+        !MM_PORT_SERIAL_GET_CLASS (self)->command_is_shareable (self, ctx->command))
+        return FALSE;
+
+    for (l = self->priv->queue->head; l; l = g_list_next (l)) {
+        CommandContext *leader = l->data;
+
+        if (leader->cancellable ||
+            leader->command->len != ctx->command->len ||
+            memcmp (leader->command->data, ctx->command->data, ctx->command->len) != 0)
+            continue;
+
+        /* The shared command must not wait longer than the new one would */
+        if (ctx->priority < leader->priority)
+            leader->priority = ctx->priority;
+
+        mm_dbg ("(%s) command shared with an identical one %s",
+                mm_port_get_device (MM_PORT (self)),
+                leader->started ? "in flight" : "queued");
+        leader->followers = g_slist_prepend (leader->followers, ctx);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static gboolean
+queued_command_cancelled_idle (CommandContext *ctx)
+{
+    MMPortSerial *self = ctx->self;
+
+    ctx->cancelled_idle_id = 0;
+
+    /* Once sent, cancellation is handled while waiting for the reply */
+    if (ctx->started)
+        return G_SOURCE_REMOVE;
+
+    mm_dbg ("(%s) queued command cancelled before being sent",
+            mm_port_get_device (MM_PORT (self)));
+    g_queue_remove (self->priv->queue, ctx);
+    g_simple_async_result_set_error (ctx->result,
+                                     MM_CORE_ERROR,
+                                     MM_CORE_ERROR_CANCELLED,
+                                     "Command cancelled before being sent");
+    command_context_complete_and_free (ctx, FALSE);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+queued_command_cancelled (GCancellable *cancellable,
+                          CommandContext *ctx)
+{
+    /* The handler cannot be disconnected from within the signal emission, so
+     * the command is removed from the queue right afterwards */
+    if (!ctx->cancelled_idle_id) {
+        GSource *source;
+
+        source = g_idle_source_new ();
+        g_source_set_callback (source, (GSourceFunc) queued_command_cancelled_idle, ctx, NULL);
+        ctx->cancelled_idle_id = g_source_attach (source, NULL);
+        g_source_unref (source);
+    }
+}
+
+void
+mm_port_serial_command_full (MMPortSerial *self,
+                             GByteArray *command,
+                             guint32 timeout_seconds,
+                             gboolean allow_cached,
+                             MMPortSerialCommandPriority priority,
+                             GCancellable *cancellable,
+                             GAsyncReadyCallback callback,
+                             gpointer user_data)
 {
     CommandContext *ctx;
 
@@ -179,7 +455,10 @@ mm_port_serial_command (MMPortSerial *self,
                                              user_data,
                                              mm_port_serial_command);
     ctx->command = g_byte_array_ref (command);
-    ctx->allow_cached = allow_cached;
+    ctx->priority = priority;
+    ctx->queued_time = g_get_monotonic_time ();
+    ctx->allow_cached = (allow_cached ||
+                         mm_serial_reply_cache_is_always_cacheable (port_serial_reply_cache_for_command (self, command), command));
     ctx->timeout = timeout_seconds;
     ctx->cancellable = (cancellable ? g_object_ref (cancellable) : NULL);
 
@@ -199,8 +478,28 @@ mm_port_serial_command (MMPortSerial *self,
     }
 
     /* Clear the cached value for this command if not asking for cached value */
-    if (!allow_cached)
-        port_serial_set_cached_reply (self, ctx->command, NULL);
+    if (!ctx->allow_cached)
+        mm_serial_reply_cache_remove (port_serial_reply_cache_for_command (self, ctx->command), ctx->command);
+
+    /* Attach to an identical command if any, instead of sending it again */
+    if (port_serial_share_command (self, ctx))
+        return;
+
+    /* Commands cancelled while queued are removed right away */
+    if (ctx->cancellable) {
+        if (g_cancellable_is_cancelled (ctx->cancellable)) {
+            g_simple_async_result_set_error (ctx->result,
+                                             MM_CORE_ERROR,
+                                             MM_CORE_ERROR_CANCELLED,
+                                             "Command cancelled before being sent");
+            command_context_complete_and_free (ctx, TRUE);
+            return;
+        }
+        ctx->cancelled_id = g_cancellable_connect (ctx->cancellable,
+                                                   G_CALLBACK (queued_command_cancelled),
+                                                   ctx,
+                                                   NULL);
+    }
 
     g_queue_push_tail (self->priv->queue, ctx);
 
@@ -293,61 +592,68 @@ mm_port_serial_print_config (MMPortSerial *port,
 }
 #endif
 
+static const struct {
+    guint baud;
+    speed_t speed;
+} baudrates[] = {
+    { 0,      B0      },
+    { 50,     B50     },
+    { 75,     B75     },
+    { 110,    B110    },
+    { 150,    B150    },
+    { 300,    B300    },
+    { 600,    B600    },
+    { 1200,   B1200   },
+    { 2400,   B2400   },
+    { 4800,   B4800   },
+    { 9600,   B9600   },
+    { 19200,  B19200  },
+    { 38400,  B38400  },
+    { 57600,  B57600  },
+    { 115200, B115200 },
+    { 230400, B230400 },
+    { 460800, B460800 },
+#if defined B921600
+    { 921600, B921600 },
+#endif
+#if defined B1000000
+    { 1000000, B1000000 },
+#endif
+#if defined B1500000
+    { 1500000, B1500000 },
+#endif
+#if defined B2000000
+    { 2000000, B2000000 },
+#endif
+#if defined B3000000
+    { 3000000, B3000000 },
+#endif
+#if defined B4000000
+    { 4000000, B4000000 },
+#endif
+};
+
+static gboolean
+baudrate_to_speed (guint baud,
+                   speed_t *speed)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (baudrates); i++) {
+        if (baudrates[i].baud == baud) {
+            *speed = baudrates[i].speed;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 static int
 parse_baudrate (guint i)
 {
-    int speed;
+    speed_t speed;
 
-    switch (i) {
-    case 0:
-        speed = B0;
-        break;
-    case 50:
-        speed = B50;
-        break;
-    case 75:
-        speed = B75;
-        break;
-    case 110:
-        speed = B110;
-        break;
-    case 150:
-        speed = B150;
-        break;
-    case 300:
-        speed = B300;
-        break;
-    case 600:
-        speed = B600;
-        break;
-    case 1200:
-        speed = B1200;
-        break;
-    case 2400:
-        speed = B2400;
-        break;
-    case 4800:
-        speed = B4800;
-        break;
-    case 9600:
-        speed = B9600;
-        break;
-    case 19200:
-        speed = B19200;
-        break;
-    case 38400:
-        speed = B38400;
-        break;
-    case 57600:
-        speed = B57600;
-        break;
-    case 115200:
-        speed = B115200;
-        break;
-    case 460800:
-        speed = B460800;
-        break;
-    default:
+    if (!baudrate_to_speed (i, &speed)) {
         mm_warn ("Invalid baudrate '%d'", i);
         speed = B9600;
     }
@@ -427,6 +733,27 @@ parse_stopbits (guint i)
     return stopbits;
 }
 
+/* USB serial bridges like the FTDI ones hold received data for up to this
+ * timer (16ms by default) before sending it to the host */
+#define LOW_LATENCY_TIMER_MS "1"
+
+static void
+port_serial_set_latency_timer (MMPortSerial *self)
+{
+    gchar *path;
+    GError *error = NULL;
+
+    path = g_strdup_printf ("/sys/class/tty/%s/device/latency_timer",
+                            mm_port_get_device (MM_PORT (self)));
+    if (g_file_test (path, G_FILE_TEST_EXISTS) &&
+        !g_file_set_contents (path, LOW_LATENCY_TIMER_MS, -1, &error)) {
+        mm_dbg ("(%s): couldn't set latency timer: %s",
+                mm_port_get_device (MM_PORT (self)), error->message);
+        g_error_free (error);
+    }
+    g_free (path);
+}
+
 static gboolean
 real_config_fd (MMPortSerial *self, int fd, GError **error)
 {
@@ -521,10 +848,102 @@ serial_debug (MMPortSerial *self, const char *prefix, const char *buf, gsize len
 {
     g_return_if_fail (len > 0);
 
-    if (MM_PORT_SERIAL_GET_CLASS (self)->debug_log)
+    if (self->priv->recorder)
+        mm_serial_recorder_write (self->priv->recorder,
+                                  (prefix[0] == '-' ?
+                                   MM_SERIAL_RECORD_DIRECTION_SENT :
+                                   MM_SERIAL_RECORD_DIRECTION_RECEIVED),
+                                  (const guint8 *) buf,
+                                  len);
+
+    mm_traffic_capture_write (mm_port_get_device (MM_PORT (self)),
+                              mm_port_get_port_type (MM_PORT (self)),
+                              (prefix[0] == '-' ?
+                               MM_TRAFFIC_CAPTURE_DIRECTION_SENT :
+                               MM_TRAFFIC_CAPTURE_DIRECTION_RECEIVED),
+                              (const guint8 *) buf,
+                              len);
+
+    /* Checked before building anything, as most of the time traffic isn't
+     * logged */
+    if (MM_PORT_SERIAL_GET_CLASS (self)->debug_log &&
+        (self->priv->log_debug ||
+         mm_log_category_enabled (MM_PORT_SERIAL_GET_CLASS (self)->log_category, LOGL_DEBUG)))
         MM_PORT_SERIAL_GET_CLASS (self)->debug_log (self, prefix, buf, len);
 }
 
+/*****************************************************************************/
+/* Paced writes
+ *
+ * When a send delay is given for TTY ports, writes are paced with a token
+ * bucket: the bucket is refilled with one byte every 'send-delay' us (or
+ * slower, if the baud rate doesn't allow that many), and it's emptied in
+ * chunks every 'send-chunk-delay' us, so that a single timer is needed for
+ * the whole command instead of one per byte.
+ */
+
+static gboolean
+port_serial_is_paced (MMPortSerial *self)
+{
+    return (self->priv->send_delay > 0 && mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY);
+}
+
+static guint64
+port_serial_get_byte_time (MMPortSerial *self)
+{
+    guint64 line_byte_time = 0;
+
+    /* 10 bits per byte: start, 8 data bits, stop */
+    if (self->priv->baud > 0)
+        line_byte_time = (10 * G_USEC_PER_SEC) / self->priv->baud;
+
+    return MAX (self->priv->send_delay, line_byte_time);
+}
+
+static guint64
+port_serial_get_chunk_delay (MMPortSerial *self)
+{
+    if (self->priv->send_chunk_delay > 0)
+        return MAX (self->priv->send_chunk_delay, self->priv->send_delay);
+    return MAX (SEND_CHUNK_DELAY_DEFAULT, self->priv->send_delay);
+}
+
+/* Number of bytes that may be sent right away */
+static gsize
+port_serial_pacing_budget (MMPortSerial *self,
+                           CommandContext *ctx)
+{
+    guint64 byte_time;
+    guint64 burst;
+    gint64 now;
+
+    byte_time = port_serial_get_byte_time (self);
+    burst = MAX (port_serial_get_chunk_delay (self), byte_time);
+
+    now = g_get_monotonic_time ();
+    if (!ctx->pacing_last)
+        /* Start with a full bucket */
+        ctx->pacing_credit = burst;
+    else
+        ctx->pacing_credit = MIN (burst, ctx->pacing_credit + (guint64) (now - ctx->pacing_last));
+    ctx->pacing_last = now;
+
+    return MIN (ctx->pacing_credit / byte_time, ctx->command->len - ctx->idx);
+}
+
+static void
+port_serial_pacing_consume (MMPortSerial *self,
+                            CommandContext *ctx,
+                            gsize sent)
+{
+    guint64 used;
+
+    used = sent * port_serial_get_byte_time (self);
+    ctx->pacing_credit = (ctx->pacing_credit > used ? ctx->pacing_credit - used : 0);
+}
+
+/*****************************************************************************/
+
 static gboolean
 port_serial_process_command (MMPortSerial *self,
                              CommandContext *ctx,
@@ -533,6 +952,7 @@ port_serial_process_command (MMPortSerial *self,
     const gchar *p;
     gsize written;
     gssize send_len;
+    guint32 idx_before;
 
     if (self->priv->iochannel == NULL && self->priv->socket == NULL) {
         g_set_error_literal (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_SEND_FAILED,
@@ -549,18 +969,27 @@ port_serial_process_command (MMPortSerial *self,
     /* Only print command the first time */
     if (ctx->started == FALSE) {
         ctx->started = TRUE;
+        ctx->write_time = g_get_monotonic_time ();
+        /* A reply is expected, so listen again */
+        if (self->priv->spew_muted_until) {
+            mm_dbg ("(%s) unmuting port input to send a command",
+                    mm_port_get_device (MM_PORT (self)));
+            self->priv->spew_muted_until = 0;
+        }
         serial_debug (self, "-->", (const char *) ctx->command->data, ctx->command->len);
     }
 
-    if (self->priv->send_delay == 0 || mm_port_get_subsys (MM_PORT (self)) != MM_PORT_SUBSYS_TTY) {
-        /* Send the whole command in one write */
-        send_len = (gssize)ctx->command->len;
-        p = (gchar *)ctx->command->data;
+    if (!port_serial_is_paced (self)) {
+        /* Send the whole pending command in one write */
+        send_len = (gssize)(ctx->command->len - ctx->idx);
     } else {
-        /* Send just one byte of the command */
-        send_len = 1;
-        p = (gchar *)&ctx->command->data[ctx->idx];
+        /* Send as much as the bucket allows; if nothing, wait for the next chunk */
+        send_len = (gssize) port_serial_pacing_budget (self, ctx);
+        if (send_len == 0)
+            return TRUE;
     }
+    p = (gchar *)&ctx->command->data[ctx->idx];
+    idx_before = ctx->idx;
 
     /* GIOChannel based setup */
     if (self->priv->iochannel) {
@@ -640,37 +1069,190 @@ port_serial_process_command (MMPortSerial *self,
     } else
         g_assert_not_reached ();
 
+    if (port_serial_is_paced (self))
+        port_serial_pacing_consume (self, ctx, ctx->idx - idx_before);
+
     if (ctx->idx >= ctx->command->len)
         ctx->done = TRUE;
 
     return TRUE;
 }
 
-static void
-port_serial_set_cached_reply (MMPortSerial *self,
-                              const GByteArray *command,
-                              const GByteArray *response)
+GVariant *
+mm_port_serial_get_stats (MMPortSerial *self)
+{
+    GVariantBuilder builder;
+
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), NULL);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    mm_serial_stats_build (self->priv->stats, mm_port_get_device (MM_PORT (self)), &builder);
+    return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+void
+mm_port_serial_set_adaptive_timeouts (MMPortSerial *self,
+                                      gboolean enabled)
 {
-    g_return_if_fail (self != NULL);
     g_return_if_fail (MM_IS_PORT_SERIAL (self));
-    g_return_if_fail (command != NULL);
 
-    if (response) {
-        GByteArray *cmd_copy = g_byte_array_sized_new (command->len);
-        GByteArray *rsp_copy = g_byte_array_sized_new (response->len);
+    self->priv->adaptive_timeouts = enabled;
+}
 
-        g_byte_array_append (cmd_copy, command->data, command->len);
-        g_byte_array_append (rsp_copy, response->data, response->len);
-        g_hash_table_insert (self->priv->reply_cache, cmd_copy, rsp_copy);
-    } else
-        g_hash_table_remove (self->priv->reply_cache, command);
+guint
+mm_port_serial_drain_background_commands (MMPortSerial *self)
+{
+    GList *l;
+    GError *error;
+    guint n_drained = 0;
+
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+
+    error = g_error_new_literal (MM_CORE_ERROR,
+                                 MM_CORE_ERROR_CANCELLED,
+                                 "Background command drained before being sent");
+    l = self->priv->queue->head;
+    while (l) {
+        CommandContext *ctx = l->data;
+        GList *next = g_list_next (l);
+
+        if (!ctx->started && ctx->priority == MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND) {
+            g_queue_delete_link (self->priv->queue, l);
+            command_context_set_result (ctx, NULL, error);
+            command_context_complete_and_free (ctx, TRUE);
+            n_drained++;
+        }
+        l = next;
+    }
+    g_error_free (error);
+
+    if (n_drained)
+        mm_dbg ("(%s) drained %u background commands",
+                mm_port_get_device (MM_PORT (self)), n_drained);
+    return n_drained;
+}
+
+guint
+mm_port_serial_move_queued_commands (MMPortSerial *self,
+                                     MMPortSerial *target)
+{
+    GList *l;
+    gboolean target_idle;
+    guint n_moved = 0;
+
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (target), 0);
+
+    if (self == target || target->priv->open_count == 0)
+        return 0;
+
+    target_idle = g_queue_is_empty (target->priv->queue);
+
+    l = self->priv->queue->head;
+    while (l) {
+        CommandContext *ctx = l->data;
+        GList *next = g_list_next (l);
+        GSList *f;
+
+        /* Commands with a cancellation pending are removed from this queue */
+        if (!ctx->started && !ctx->cancelled_idle_id) {
+            g_queue_delete_link (self->priv->queue, l);
+            g_object_unref (ctx->self);
+            ctx->self = g_object_ref (target);
+            for (f = ctx->followers; f; f = g_slist_next (f)) {
+                CommandContext *follower = f->data;
+
+                g_object_unref (follower->self);
+                follower->self = g_object_ref (target);
+            }
+            g_queue_push_tail (target->priv->queue, ctx);
+            n_moved++;
+        }
+        l = next;
+    }
+
+    if (!n_moved)
+        return 0;
+
+    mm_dbg ("(%s) moved %u queued commands to (%s)",
+            mm_port_get_device (MM_PORT (self)),
+            n_moved,
+            mm_port_get_device (MM_PORT (target)));
+    if (target_idle)
+        port_serial_schedule_queue_process (target, 0);
+    return n_moved;
+}
+
+void
+mm_port_serial_set_reopen_time (MMPortSerial *self,
+                                gint reopen_time_ms)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->reopen_time = reopen_time_ms;
+}
+
+void
+mm_port_serial_set_flash_time (MMPortSerial *self,
+                               gint flash_time_ms)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->flash_time = flash_time_ms;
+}
+
+void
+mm_port_serial_set_spew_limit (MMPortSerial *self,
+                               guint max_bytes)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->spew_limit = MAX (max_bytes, SERIAL_BUF_SIZE);
+    if (self->priv->max_response)
+        self->priv->spew_limit = MIN (self->priv->spew_limit, self->priv->max_response);
+}
+
+void
+mm_port_serial_set_low_latency (MMPortSerial *self,
+                                gboolean enabled)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->low_latency = enabled;
+}
+
+void
+mm_port_serial_set_share_commands (MMPortSerial *self,
+                                   gboolean enabled)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->share_commands = enabled;
+}
+
+MMSerialReplyCache *
+mm_port_serial_peek_reply_cache (MMPortSerial *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), NULL);
+
+    return self->priv->reply_cache;
+}
+
+void
+mm_port_serial_set_shared_reply_cache (MMPortSerial       *self,
+                                       MMSerialReplyCache *cache)
+{
+    g_return_if_fail (MM_IS_PORT_SERIAL (self));
+
+    self->priv->shared_reply_cache = cache;
 }
 
-static const GByteArray *
-port_serial_get_cached_reply (MMPortSerial *self,
-                              GByteArray *command)
+MMSerialReplyCache *
+mm_port_serial_peek_shared_reply_cache (MMPortSerial *self)
 {
-    return (const GByteArray *)g_hash_table_lookup (self->priv->reply_cache, command);
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), NULL);
+
+    return self->priv->shared_reply_cache;
 }
 
 static void
@@ -687,9 +1269,9 @@ port_serial_schedule_queue_process (MMPortSerial *self, guint timeout_ms)
     }
 
     if (timeout_ms)
-        self->priv->queue_id = g_timeout_add (timeout_ms, port_serial_queue_process, self);
+        self->priv->queue_id = port_serial_timeout_add (self, timeout_ms, port_serial_queue_process);
     else
-        self->priv->queue_id = g_idle_add (port_serial_queue_process, self);
+        self->priv->queue_id = port_serial_idle_add (self, port_serial_queue_process);
 }
 
 static void
@@ -701,7 +1283,7 @@ port_serial_got_response (MMPortSerial *self,
     g_assert ((parsed_response && !error) || (!parsed_response && error));
 
     if (self->priv->timeout_id) {
-        g_source_remove (self->priv->timeout_id);
+        port_serial_source_remove (self, self->priv->timeout_id);
         self->priv->timeout_id = 0;
     }
 
@@ -724,17 +1306,38 @@ port_serial_got_response (MMPortSerial *self,
 
         ctx = (CommandContext *) g_queue_pop_head (self->priv->queue);
         if (ctx) {
-            /* Complete the command context with the appropriate result */
-            if (error)
-                g_simple_async_result_set_from_error (ctx->result, error);
-            else {
-                if (ctx->allow_cached)
-                    port_serial_set_cached_reply (self, ctx->command, parsed_response);
-                g_simple_async_result_set_op_res_gpointer (ctx->result,
-                                                           g_byte_array_ref (parsed_response),
-                                                           (GDestroyNotify) g_byte_array_unref);
+            /* Only commands really sent are accounted */
+            if (ctx->started) {
+                gint64 now;
+
+                now = g_get_monotonic_time ();
+                mm_serial_stats_record (self->priv->stats,
+                                        ctx->command,
+                                        ctx->write_time - ctx->queued_time,
+                                        ctx->first_byte_time ? ctx->first_byte_time - ctx->write_time : -1,
+                                        now - ctx->write_time,
+                                        g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT));
+
+                if (mm_profiler_is_running ()) {
+                    gchar *prefix;
+
+                    prefix = mm_serial_stats_command_prefix (ctx->command);
+                    mm_profiler_add (mm_port_get_device (MM_PORT (self)),
+                                     "Commands",
+                                     prefix,
+                                     ctx->write_time,
+                                     now);
+                    g_free (prefix);
+                }
             }
 
+            /* Complete the command context with the appropriate result */
+            if (!error && ctx->allow_cached)
+                mm_serial_reply_cache_insert (port_serial_reply_cache_for_command (self, ctx->command),
+                                              ctx->command,
+                                              parsed_response);
+            command_context_set_result (ctx, parsed_response, error);
+
             /* Don't complete in idle. We need the caller remove the response range which
              * was processed, and that must be done before processing any new queued command */
             command_context_complete_and_free (ctx, FALSE);
@@ -746,6 +1349,39 @@ port_serial_got_response (MMPortSerial *self,
     g_object_unref (self);
 }
 
+/* Adaptive timeouts: the p99 of the response latency of the command prefix,
+ * times a safety factor, never below the floor nor above the static timeout.
+ * Timed out commands are recorded as well, so a timeout found too short
+ * grows again. */
+#define ADAPTIVE_TIMEOUT_PERCENTILE  99
+#define ADAPTIVE_TIMEOUT_FACTOR      4
+#define ADAPTIVE_TIMEOUT_FLOOR_MS    2000
+#define ADAPTIVE_TIMEOUT_MIN_SAMPLES 20
+
+static guint32
+port_serial_get_timeout_ms (MMPortSerial *self,
+                            CommandContext *ctx)
+{
+    guint32 static_ms;
+    guint32 p99_ms;
+    guint32 timeout_ms;
+
+    static_ms = ctx->timeout * 1000;
+    if (!self->priv->adaptive_timeouts ||
+        !mm_serial_stats_get_response_percentile (self->priv->stats,
+                                                  ctx->command,
+                                                  ADAPTIVE_TIMEOUT_PERCENTILE,
+                                                  ADAPTIVE_TIMEOUT_MIN_SAMPLES,
+                                                  &p99_ms))
+        return static_ms;
+
+    timeout_ms = MIN (MAX (p99_ms * ADAPTIVE_TIMEOUT_FACTOR, ADAPTIVE_TIMEOUT_FLOOR_MS), static_ms);
+    if (timeout_ms < static_ms)
+        mm_dbg ("(%s) using adaptive timeout: %ums instead of %ums",
+                mm_port_get_device (MM_PORT (self)), timeout_ms, static_ms);
+    return timeout_ms;
+}
+
 static gboolean
 port_serial_timed_out (gpointer data)
 {
@@ -800,23 +1436,72 @@ port_serial_response_wait_cancelled (GCancellable *cancellable,
     g_error_free (error);
 }
 
+/* Move the command to serve next to the head of the queue */
+static CommandContext *
+port_serial_queue_select_next (MMPortSerial *self)
+{
+    CommandContext *best = NULL;
+    gint64 best_score = 0;
+    GList *l;
+
+    /* Never reorder a command which is already being sent */
+    best = (CommandContext *) g_queue_peek_head (self->priv->queue);
+    if (!best || best->started || g_queue_get_length (self->priv->queue) == 1)
+        return best;
+
+    /* Lowest score wins; each priority class adds some time to the time the
+     * command was queued, so that waiting commands age into the higher
+     * classes. On ties, the first one queued wins. */
+    for (l = self->priv->queue->head; l; l = g_list_next (l)) {
+        CommandContext *ctx = l->data;
+        gint64 score;
+
+        score = ctx->queued_time + ((gint64) ctx->priority * COMMAND_PRIORITY_AGING);
+        if (l == self->priv->queue->head || score < best_score) {
+            best = ctx;
+            best_score = score;
+        }
+    }
+
+    if (best != g_queue_peek_head (self->priv->queue)) {
+        g_queue_remove (self->priv->queue, best);
+        g_queue_push_head (self->priv->queue, best);
+    }
+
+    return best;
+}
+
 static gboolean
 port_serial_queue_process (gpointer data)
 {
     MMPortSerial *self = MM_PORT_SERIAL (data);
     CommandContext *ctx;
     GError *error = NULL;
+    guint source_id;
 
+    source_id = self->priv->queue_id;
     self->priv->queue_id = 0;
 
-    ctx = (CommandContext *) g_queue_peek_head (self->priv->queue);
+    ctx = port_serial_queue_select_next (self);
     if (!ctx)
         return G_SOURCE_REMOVE;
 
+    /* Never send a command already cancelled */
+    if (!ctx->started && ctx->cancellable && g_cancellable_is_cancelled (ctx->cancellable)) {
+        error = g_error_new (MM_CORE_ERROR,
+                             MM_CORE_ERROR_CANCELLED,
+                             "Command cancelled before being sent");
+        /* Note: may complete last operation and unref the MMPortSerial */
+        port_serial_got_response (self, NULL, error);
+        g_error_free (error);
+        return G_SOURCE_REMOVE;
+    }
+
     if (ctx->allow_cached) {
         const GByteArray *cached;
 
-        cached = port_serial_get_cached_reply (self, ctx->command);
+        cached = mm_serial_reply_cache_lookup (port_serial_reply_cache_for_command (self, ctx->command),
+                                               ctx->command);
         if (cached) {
             GByteArray *parsed_response;
 
@@ -839,17 +1524,40 @@ port_serial_queue_process (gpointer data)
         return G_SOURCE_REMOVE;
     }
 
-    /* Schedule the next byte of the command to be sent */
+    /* Schedule the next chunk of the command to be sent */
     if (!ctx->done) {
-        port_serial_schedule_queue_process (self,
-                                            (mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY ?
-                                             self->priv->send_delay / 1000 :
-                                             0));
+        if (!port_serial_is_paced (self)) {
+            port_serial_schedule_queue_process (self, 0);
+            return G_SOURCE_REMOVE;
+        }
+
+        /* Keep on with the same timer until the whole command is sent */
+        if (ctx->pacing_source_id && ctx->pacing_source_id == source_id) {
+            self->priv->queue_id = source_id;
+            return G_SOURCE_CONTINUE;
+        }
+
+        port_serial_schedule_queue_process (self, MAX (port_serial_get_chunk_delay (self) / 1000, 1));
+        ctx->pacing_source_id = self->priv->queue_id;
         return G_SOURCE_REMOVE;
     }
 
     /* Setup the cancellable so that we can stop waiting for a response */
     if (ctx->cancellable) {
+        if (ctx->cancelled_id) {
+            g_cancellable_disconnect (ctx->cancellable, ctx->cancelled_id);
+            ctx->cancelled_id = 0;
+        }
+        /* If already cancelled, connecting would run the handler right away */
+        if (g_cancellable_is_cancelled (ctx->cancellable)) {
+            error = g_error_new (MM_CORE_ERROR,
+                                 MM_CORE_ERROR_CANCELLED,
+                                 "Won't wait for the reply");
+            /* Note: may complete last operation and unref the MMPortSerial */
+            port_serial_got_response (self, NULL, error);
+            g_error_free (error);
+            return G_SOURCE_REMOVE;
+        }
         self->priv->cancellable = g_object_ref (ctx->cancellable);
         self->priv->cancellable_id = (g_cancellable_connect (
                                           ctx->cancellable,
@@ -868,9 +1576,14 @@ port_serial_queue_process (gpointer data)
     }
 
     /* If the command is finished being sent, schedule the timeout */
-    self->priv->timeout_id = g_timeout_add_seconds (ctx->timeout,
-                                                    port_serial_timed_out,
-                                                    self);
+    if (self->priv->adaptive_timeouts)
+        self->priv->timeout_id = port_serial_timeout_add (self,
+                                                          port_serial_get_timeout_ms (self, ctx),
+                                                          port_serial_timed_out);
+    else
+        self->priv->timeout_id = port_serial_timeout_add_seconds (self,
+                                                                  ctx->timeout,
+                                                                  port_serial_timed_out);
     return G_SOURCE_REMOVE;
 }
 
@@ -922,11 +1635,77 @@ parse_response_buffer (MMPortSerial *self)
     }
 }
 
+/*****************************************************************************/
+/* Spew control */
+
+static gboolean
+port_serial_spew_is_muted (MMPortSerial *self)
+{
+    if (!self->priv->spew_muted_until)
+        return FALSE;
+
+    if (mm_clock_get_time () < self->priv->spew_muted_until)
+        return TRUE;
+
+    mm_dbg ("(%s) unmuting port input", mm_port_get_device (MM_PORT (self)));
+    self->priv->spew_muted_until = 0;
+    return FALSE;
+}
+
+/* Valid long replies may go up to the configured limit, but only while one
+ * is awaited and the stream has been mostly parseable so far */
+static gsize
+port_serial_spew_threshold (MMPortSerial *self)
+{
+    CommandContext *ctx;
+
+    ctx = g_queue_peek_head (self->priv->queue);
+    if (ctx && ctx->started &&
+        self->priv->spew_parsed > 0 &&
+        self->priv->spew_parsed >= self->priv->spew_discarded)
+        return self->priv->spew_limit;
+    return SERIAL_BUF_SIZE;
+}
+
+static void
+port_serial_spew_account (MMPortSerial *self,
+                          gsize         parsed,
+                          gsize         discarded)
+{
+    self->priv->spew_parsed += parsed;
+    self->priv->spew_discarded += discarded;
+
+    if (self->priv->spew_discarded >= SPEW_MUTE_MIN_DISCARDED &&
+        self->priv->spew_parsed * SPEW_MUTE_RATIO < self->priv->spew_discarded) {
+        self->priv->spew_backoff_s = (self->priv->spew_backoff_s ?
+                                      MIN (self->priv->spew_backoff_s * 2, SPEW_MUTE_BACKOFF_MAX_S) :
+                                      SPEW_MUTE_BACKOFF_MIN_S);
+        self->priv->spew_muted_until = mm_clock_get_time () + self->priv->spew_backoff_s * G_USEC_PER_SEC;
+        mm_dbg ("(%s) muting port input for %us: %" G_GUINT64_FORMAT " bytes discarded, %" G_GUINT64_FORMAT " parsed",
+                mm_port_get_device (MM_PORT (self)),
+                self->priv->spew_backoff_s,
+                self->priv->spew_discarded,
+                self->priv->spew_parsed);
+        self->priv->spew_parsed = 0;
+        self->priv->spew_discarded = 0;
+        mm_serial_buffer_clear (self->priv->response);
+        return;
+    }
+
+    /* Older traffic weighs less; a healthy window forgets past mutes */
+    if (self->priv->spew_parsed + self->priv->spew_discarded > SPEW_STATS_WINDOW) {
+        if (self->priv->spew_parsed >= self->priv->spew_discarded)
+            self->priv->spew_backoff_s = 0;
+        self->priv->spew_parsed /= 2;
+        self->priv->spew_discarded /= 2;
+    }
+}
+
 static gboolean
 common_input_available (MMPortSerial *self,
                         GIOCondition condition)
 {
-    char buf[SERIAL_BUF_SIZE + 1];
+    guint8 *tail;
     gsize bytes_read;
     GIOStatus status = G_IO_STATUS_NORMAL;
     CommandContext *ctx;
@@ -939,15 +1718,13 @@ common_input_available (MMPortSerial *self,
         device = mm_port_get_device (MM_PORT (self));
         mm_dbg ("(%s) unexpected port hangup!", device);
 
-        if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+        mm_serial_buffer_clear (self->priv->response);
         port_serial_close_force (self);
         return G_SOURCE_REMOVE;
     }
 
     if (condition & G_IO_ERR) {
-        if (self->priv->response->len)
-            g_byte_array_remove_range (self->priv->response, 0, self->priv->response->len);
+        mm_serial_buffer_clear (self->priv->response);
         return G_SOURCE_CONTINUE;
     }
 
@@ -959,23 +1736,35 @@ common_input_available (MMPortSerial *self,
     while (iterate) {
         bytes_read = 0;
 
+        /* Read straight into the free space of the response buffer */
+        tail = mm_serial_buffer_reserve (self->priv->response, SERIAL_BUF_SIZE);
+
         if (self->priv->iochannel) {
-            status = g_io_channel_read_chars (self->priv->iochannel,
-                                              buf,
-                                              SERIAL_BUF_SIZE,
-                                              &bytes_read,
-                                              &error);
-            if (status == G_IO_STATUS_ERROR) {
-                if (error) {
-                    mm_warn ("(%s): read error: %s",
-                             mm_port_get_device (MM_PORT (self)),
-                             error->message);
-                }
-                g_clear_error (&error);
+            gssize n;
+
+            /* The channel is unbuffered and has no encoding, so reading from
+             * the fd directly is the same as going through the channel, just
+             * without the intermediate copy */
+            do {
+                n = read (self->priv->fd, tail, SERIAL_BUF_SIZE);
+            } while (n < 0 && errno == EINTR);
+
+            if (n > 0) {
+                bytes_read = (gsize) n;
+                status = G_IO_STATUS_NORMAL;
+            } else if (n == 0)
+                status = G_IO_STATUS_EOF;
+            else if (errno == EAGAIN || errno == EWOULDBLOCK)
+                status = G_IO_STATUS_AGAIN;
+            else {
+                status = G_IO_STATUS_ERROR;
+                mm_warn ("(%s): read error: %s",
+                         mm_port_get_device (MM_PORT (self)),
+                         g_strerror (errno));
             }
         } else if (self->priv->socket) {
             bytes_read = g_socket_receive (self->priv->socket,
-                                           buf,
+                                           (gchar *) tail,
                                            SERIAL_BUF_SIZE,
                                            NULL, /* cancellable */
                                            &error);
@@ -998,14 +1787,37 @@ common_input_available (MMPortSerial *self,
             break;
 
         g_assert (bytes_read > 0);
-        serial_debug (self, "<--", buf, bytes_read);
-        g_byte_array_append (self->priv->response, (const guint8 *) buf, bytes_read);
+        serial_debug (self, "<--", (const char *) tail, bytes_read);
+        mm_serial_buffer_commit (self->priv->response, bytes_read);
+
+        /* Keep track of when the reply started to arrive */
+        {
+            CommandContext *ctx;
+
+            ctx = (CommandContext *) g_queue_peek_head (self->priv->queue);
+            if (ctx && ctx->started && !ctx->first_byte_time)
+                ctx->first_byte_time = g_get_monotonic_time ();
+        }
+
+        /* Muted garbage streams are drained without parsing */
+        if (self->priv->spew_control && port_serial_spew_is_muted (self)) {
+            mm_serial_buffer_clear (self->priv->response);
+            iterate = (bytes_read == SERIAL_BUF_SIZE || status == G_IO_STATUS_AGAIN);
+            continue;
+        }
 
         /* Make sure the response doesn't grow too long */
-        if ((self->priv->response->len > SERIAL_BUF_SIZE) && self->priv->spew_control) {
+        if (self->priv->spew_control &&
+            mm_serial_buffer_get_length (self->priv->response) > port_serial_spew_threshold (self)) {
             /* Notify listeners and then trim the buffer */
             g_signal_emit (self, signals[BUFFER_FULL], 0, self->priv->response);
-            g_byte_array_remove_range (self->priv->response, 0, (SERIAL_BUF_SIZE / 2));
+            mm_serial_buffer_consume (self->priv->response, (SERIAL_BUF_SIZE / 2));
+            port_serial_spew_account (self, 0, SERIAL_BUF_SIZE / 2);
+        } else if (self->priv->max_response &&
+                   mm_serial_buffer_get_length (self->priv->response) > self->priv->max_response) {
+            g_signal_emit (self, signals[BUFFER_FULL], 0, self->priv->response);
+            mm_serial_buffer_consume (self->priv->response,
+                                      mm_serial_buffer_get_length (self->priv->response) - (self->priv->max_response / 2));
         }
 
         /* See if we can parse anything. The response parsing may actually
@@ -1016,7 +1828,14 @@ common_input_available (MMPortSerial *self,
          * we should be keeping this socket/iochannel source or not. */
         g_object_ref (self);
         {
+            gsize length_before;
+            gsize length_after;
+
+            length_before = mm_serial_buffer_get_length (self->priv->response);
             parse_response_buffer (self);
+            length_after = mm_serial_buffer_get_length (self->priv->response);
+            if (self->priv->spew_control && length_after < length_before)
+                port_serial_spew_account (self, length_before - length_after, 0);
 
             /* If we didn't end up closing the iochannel/socket in the previous
              * operation, we keep this source. */
@@ -1039,7 +1858,12 @@ iochannel_input_available (GIOChannel *iochannel,
                            GIOCondition condition,
                            gpointer data)
 {
-    return common_input_available (MM_PORT_SERIAL (data), condition);
+    gboolean keep_source;
+
+    mm_loop_monitor_section_begin ("serial input");
+    keep_source = common_input_available (MM_PORT_SERIAL (data), condition);
+    mm_loop_monitor_section_end ();
+    return keep_source;
 }
 
 static gboolean
@@ -1047,7 +1871,12 @@ socket_input_available (GSocket *socket,
                         GIOCondition condition,
                         gpointer data)
 {
-    return common_input_available (MM_PORT_SERIAL (data), condition);
+    gboolean keep_source;
+
+    mm_loop_monitor_section_begin ("serial input");
+    keep_source = common_input_available (MM_PORT_SERIAL (data), condition);
+    mm_loop_monitor_section_end ();
+    return keep_source;
 }
 
 static void
@@ -1056,7 +1885,7 @@ data_watch_enable (MMPortSerial *self, gboolean enable)
     if (self->priv->iochannel_id) {
         if (enable)
             g_warn_if_fail (self->priv->iochannel_id == 0);
-        g_source_remove (self->priv->iochannel_id);
+        port_serial_source_remove (self, self->priv->iochannel_id);
         self->priv->iochannel_id = 0;
     }
 
@@ -1070,10 +1899,10 @@ data_watch_enable (MMPortSerial *self, gboolean enable)
 
     if (enable) {
         if (self->priv->iochannel) {
-            self->priv->iochannel_id = g_io_add_watch (self->priv->iochannel,
-                                                       G_IO_IN | G_IO_ERR | G_IO_HUP,
-                                                       iochannel_input_available,
-                                                       self);
+            self->priv->iochannel_id = port_serial_source_attach (self,
+                                                                  g_io_create_watch (self->priv->iochannel,
+                                                                                     G_IO_IN | G_IO_ERR | G_IO_HUP),
+                                                                  (GSourceFunc)iochannel_input_available);
         } else if (self->priv->socket) {
             self->priv->socket_source = g_socket_create_source (self->priv->socket,
                                                                 G_IO_IN | G_IO_ERR | G_IO_HUP,
@@ -1204,10 +2033,16 @@ mm_port_serial_open (MMPortSerial *self, GError **error)
          */
         if (ioctl (self->priv->fd, TIOCGSERIAL, &sinfo) == 0) {
             sinfo.closing_wait = ASYNC_CLOSING_WAIT_NONE;
+            /* Deliver received data right away instead of batching it */
+            if (self->priv->low_latency)
+                sinfo.flags |= ASYNC_LOW_LATENCY;
             if (ioctl (self->priv->fd, TIOCSSERIAL, &sinfo) < 0)
                 mm_warn ("(%s): couldn't set serial port closing_wait to none: %s",
                          device, g_strerror (errno));
         }
+
+        if (self->priv->low_latency)
+            port_serial_set_latency_timer (self);
     }
 
     g_warn_if_fail (MM_PORT_SERIAL_GET_CLASS (self)->config_fd);
@@ -1287,6 +2122,14 @@ success:
     self->priv->open_count++;
     mm_dbg ("(%s) device open count is %d (open)", device, self->priv->open_count);
 
+    /* Start capturing traffic if requested */
+    if (self->priv->open_count == 1 && !self->priv->recorder)
+        self->priv->recorder = mm_serial_recorder_new (device);
+
+    /* Per-port debug settings are reloaded each time the port is opened */
+    if (self->priv->open_count == 1)
+        self->priv->log_debug = mm_log_port_debug_enabled (device);
+
     /* Run additional port config if just opened */
     if (self->priv->open_count == 1 && MM_PORT_SERIAL_GET_CLASS (self)->config)
         MM_PORT_SERIAL_GET_CLASS (self)->config (self);
@@ -1325,6 +2168,22 @@ mm_port_serial_is_open (MMPortSerial *self)
     return !!self->priv->open_count;
 }
 
+guint
+mm_port_serial_get_queue_length (MMPortSerial *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+
+    return g_queue_get_length (self->priv->queue);
+}
+
+gsize
+mm_port_serial_get_buffer_size (MMPortSerial *self)
+{
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), 0);
+
+    return mm_serial_buffer_get_allocated (self->priv->response);
+}
+
 static void
 _close_internal (MMPortSerial *self, gboolean force)
 {
@@ -1418,25 +2277,30 @@ _close_internal (MMPortSerial *self, gboolean force)
     }
 
     /* Clear the command queue */
-    for (i = 0; i < g_queue_get_length (self->priv->queue); i++) {
-        CommandContext *ctx;
-
-        ctx = g_queue_peek_nth (self->priv->queue, i);
-        g_simple_async_result_set_error (ctx->result,
-                                         MM_SERIAL_ERROR,
-                                         MM_SERIAL_ERROR_SEND_FAILED,
-                                         "Serial port is now closed");
-        command_context_complete_and_free (ctx, TRUE);
+    if (!g_queue_is_empty (self->priv->queue)) {
+        GError *error;
+
+        error = g_error_new_literal (MM_SERIAL_ERROR,
+                                     MM_SERIAL_ERROR_SEND_FAILED,
+                                     "Serial port is now closed");
+        for (i = 0; i < g_queue_get_length (self->priv->queue); i++) {
+            CommandContext *ctx;
+
+            ctx = g_queue_peek_nth (self->priv->queue, i);
+            command_context_set_result (ctx, NULL, error);
+            command_context_complete_and_free (ctx, TRUE);
+        }
+        g_queue_clear (self->priv->queue);
+        g_error_free (error);
     }
-    g_queue_clear (self->priv->queue);
 
     if (self->priv->timeout_id) {
-        g_source_remove (self->priv->timeout_id);
+        port_serial_source_remove (self, self->priv->timeout_id);
         self->priv->timeout_id = 0;
     }
 
     if (self->priv->queue_id) {
-        g_source_remove (self->priv->queue_id);
+        port_serial_source_remove (self, self->priv->queue_id);
         self->priv->queue_id = 0;
     }
 
@@ -1448,6 +2312,11 @@ _close_internal (MMPortSerial *self, gboolean force)
     }
 
     g_clear_object (&self->priv->cancellable);
+
+    if (self->priv->recorder) {
+        mm_serial_recorder_free (self->priv->recorder);
+        self->priv->recorder = NULL;
+    }
 }
 
 void
@@ -1500,7 +2369,7 @@ static void
 reopen_context_complete_and_free (ReopenContext *ctx)
 {
     if (ctx->reopen_id)
-        g_source_remove (ctx->reopen_id);
+        port_serial_source_remove (ctx->self, ctx->reopen_id);
     g_simple_async_result_complete_in_idle (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
@@ -1575,6 +2444,9 @@ mm_port_serial_reopen (MMPortSerial *self,
 
     g_return_if_fail (MM_IS_PORT_SERIAL (self));
 
+    if (self->priv->reopen_time >= 0)
+        reopen_time = (guint32) self->priv->reopen_time;
+
     /* Setup context */
     ctx = g_slice_new0 (ReopenContext);
     ctx->self = g_object_ref (self);
@@ -1611,9 +2483,9 @@ mm_port_serial_reopen (MMPortSerial *self,
         mm_port_serial_close (self);
 
     if (reopen_time > 0)
-        ctx->reopen_id = g_timeout_add (reopen_time, (GSourceFunc)reopen_do, self);
+        ctx->reopen_id = port_serial_timeout_add (self, reopen_time, (GSourceFunc)reopen_do);
     else
-        ctx->reopen_id = g_idle_add ((GSourceFunc)reopen_do, self);
+        ctx->reopen_id = port_serial_idle_add (self, (GSourceFunc)reopen_do);
 
     /* Store context in private info */
     self->priv->reopen_ctx = ctx;
@@ -1701,6 +2573,46 @@ set_speed (MMPortSerial *self, speed_t speed, GError **error)
     return TRUE;
 }
 
+gboolean
+mm_port_serial_baudrate_is_supported (guint baud)
+{
+    speed_t speed;
+
+    return baudrate_to_speed (baud, &speed);
+}
+
+gboolean
+mm_port_serial_set_baudrate (MMPortSerial *self,
+                             guint baud,
+                             GError **error)
+{
+    speed_t speed;
+
+    g_return_val_if_fail (MM_IS_PORT_SERIAL (self), FALSE);
+
+    if (!baudrate_to_speed (baud, &speed)) {
+        g_set_error (error,
+                     MM_CORE_ERROR,
+                     MM_CORE_ERROR_UNSUPPORTED,
+                     "Unsupported baudrate %u",
+                     baud);
+        return FALSE;
+    }
+
+    /* Applied right away if open, so that the very next command already
+     * goes out at the new rate */
+    if (self->priv->fd >= 0 && mm_port_get_subsys (MM_PORT (self)) == MM_PORT_SUBSYS_TTY) {
+        tcdrain (self->priv->fd);
+        if (!set_speed (self, speed, error))
+            return FALSE;
+    }
+
+    mm_dbg ("(%s) baudrate changed from %u to %u",
+            mm_port_get_device (MM_PORT (self)), self->priv->baud, baud);
+    self->priv->baud = baud;
+    return TRUE;
+}
+
 /*****************************************************************************/
 /* Flash */
 
@@ -1715,7 +2627,7 @@ static void
 flash_context_complete_and_free (FlashContext *ctx)
 {
     if (ctx->flash_id)
-        g_source_remove (ctx->flash_id);
+        port_serial_source_remove (ctx->self, ctx->flash_id);
     g_simple_async_result_complete_in_idle (ctx->result);
     g_object_unref (ctx->result);
     g_object_unref (ctx->self);
@@ -1795,6 +2707,9 @@ mm_port_serial_flash (MMPortSerial *self,
 
     g_return_if_fail (MM_IS_PORT_SERIAL (self));
 
+    if (self->priv->flash_time >= 0)
+        flash_time = (guint32) self->priv->flash_time;
+
     /* Setup context */
     ctx = g_slice_new0 (FlashContext);
     ctx->self = g_object_ref (self);
@@ -1824,7 +2739,7 @@ mm_port_serial_flash (MMPortSerial *self,
     /* Flashing only in TTY */
     if (!self->priv->flash_ok || mm_port_get_subsys (MM_PORT (self)) != MM_PORT_SUBSYS_TTY) {
         self->priv->flash_ctx = ctx;
-        ctx->flash_id = g_idle_add ((GSourceFunc)flash_do, self);
+        ctx->flash_id = port_serial_idle_add (self, (GSourceFunc)flash_do);
         return;
     }
 
@@ -1846,7 +2761,7 @@ mm_port_serial_flash (MMPortSerial *self,
     g_clear_error (&error);
 
     self->priv->flash_ctx = ctx;
-    ctx->flash_id = g_timeout_add (flash_time, (GSourceFunc)flash_do, self);
+    ctx->flash_id = port_serial_timeout_add (self, flash_time, (GSourceFunc)flash_do);
 }
 
 /*****************************************************************************/
@@ -1861,54 +2776,18 @@ mm_port_serial_new (const char *name, MMPortType ptype)
                                          NULL));
 }
 
-static gboolean
-ba_equal (gconstpointer v1, gconstpointer v2)
-{
-    const GByteArray *a = v1;
-    const GByteArray *b = v2;
-
-    if (!a && b)
-        return -1;
-    else if (a && !b)
-        return 1;
-    else if (!a && !b)
-        return 0;
-
-    g_assert (a && b);
-    if (a->len < b->len)
-        return -1;
-    else if (a->len > b->len)
-        return 1;
-
-    g_assert (a->len == b->len);
-    return !memcmp (a->data, b->data, a->len);
-}
-
-static guint
-ba_hash (gconstpointer v)
-{
-    /* 31 bit hash function */
-    const GByteArray *array = v;
-    guint32 i, h = (const signed char) array->data[0];
-
-    for (i = 1; i < array->len; i++)
-        h = (h << 5) - h + (const signed char) array->data[i];
-
-    return h;
-}
-
-static void
-ba_free (gpointer v)
-{
-    g_byte_array_unref ((GByteArray *) v);
-}
-
 static void
 mm_port_serial_init (MMPortSerial *self)
 {
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self, MM_TYPE_PORT_SERIAL, MMPortSerialPrivate);
 
-    self->priv->reply_cache = g_hash_table_new_full (ba_hash, ba_equal, ba_free, ba_free);
+    self->priv->reply_cache = mm_serial_reply_cache_new (REPLY_CACHE_MAX_ENTRIES,
+                                                         MM_SERIAL_REPLY_CACHE_TTL_INFINITE);
+    if (mm_memory_budget_get ()->reply_cache_entries)
+        mm_serial_reply_cache_set_max_entries (self->priv->reply_cache,
+                                               MIN (REPLY_CACHE_MAX_ENTRIES, mm_memory_budget_get ()->reply_cache_entries));
+    mm_serial_reply_cache_set_max_size (self->priv->reply_cache, mm_memory_budget_get ()->reply_cache_size);
+    self->priv->stats = mm_serial_stats_new ();
 
     self->priv->fd = -1;
     self->priv->baud = 57600;
@@ -1916,9 +2795,15 @@ mm_port_serial_init (MMPortSerial *self)
     self->priv->parity = 'n';
     self->priv->stopbits = 1;
     self->priv->send_delay = 1000;
+    self->priv->reopen_time = -1;
+    self->priv->flash_time = -1;
 
     self->priv->queue = g_queue_new ();
-    self->priv->response = g_byte_array_sized_new (500);
+    self->priv->response = mm_serial_buffer_new (SERIAL_BUF_SIZE * 2);
+    self->priv->spew_limit = SERIAL_BUF_SIZE;
+    /* Room for at least two full reads */
+    if (mm_memory_budget_get ()->serial_buffer)
+        self->priv->max_response = MAX (mm_memory_budget_get ()->serial_buffer, SERIAL_BUF_SIZE * 2);
 }
 
 static void
@@ -1948,6 +2833,9 @@ set_property (GObject *object,
     case PROP_SEND_DELAY:
         self->priv->send_delay = g_value_get_uint64 (value);
         break;
+    case PROP_SEND_CHUNK_DELAY:
+        self->priv->send_chunk_delay = g_value_get_uint64 (value);
+        break;
     case PROP_SPEW_CONTROL:
         self->priv->spew_control = g_value_get_boolean (value);
         break;
@@ -1990,6 +2878,9 @@ get_property (GObject *object,
     case PROP_SEND_DELAY:
         g_value_set_uint64 (value, self->priv->send_delay);
         break;
+    case PROP_SEND_CHUNK_DELAY:
+        g_value_set_uint64 (value, self->priv->send_chunk_delay);
+        break;
     case PROP_SPEW_CONTROL:
         g_value_set_boolean (value, self->priv->spew_control);
         break;
@@ -2020,13 +2911,15 @@ finalize (GObject *object)
     g_assert (self->priv->socket_source == NULL);
 
     if (self->priv->timeout_id)
-        g_source_remove (self->priv->timeout_id);
+        port_serial_source_remove (self, self->priv->timeout_id);
 
     if (self->priv->queue_id)
-        g_source_remove (self->priv->queue_id);
+        port_serial_source_remove (self, self->priv->queue_id);
 
-    g_hash_table_destroy (self->priv->reply_cache);
-    g_byte_array_unref (self->priv->response);
+    mm_serial_reply_cache_free (self->priv->reply_cache);
+    mm_serial_stats_free (self->priv->stats);
+    mm_serial_recorder_free (self->priv->recorder);
+    mm_serial_buffer_free (self->priv->response);
     g_queue_free (self->priv->queue);
 
     G_OBJECT_CLASS (mm_port_serial_parent_class)->finalize (object);
@@ -2095,6 +2988,15 @@ mm_port_serial_class_init (MMPortSerialClass *klass)
                               0, G_MAXUINT64, 0,
                               G_PARAM_READWRITE));
 
+    g_object_class_install_property
+        (object_class, PROP_SEND_CHUNK_DELAY,
+         g_param_spec_uint64 (MM_PORT_SERIAL_SEND_CHUNK_DELAY,
+                              "SendChunkDelay",
+                              "Delay between chunks of paced writes in microseconds, "
+                              "when a send delay is given. If 0, a default is used.",
+                              0, G_MAXUINT64, 0,
+                              G_PARAM_READWRITE));
+
     g_object_class_install_property
         (object_class, PROP_SPEW_CONTROL,
          g_param_spec_boolean (MM_PORT_SERIAL_SPEW_CONTROL,
@@ -22,6 +22,9 @@
 #include <gio/gio.h>
 
 #include "mm-port.h"
+#include "mm-serial-buffer.h"
+#include "mm-serial-reply-cache.h"
+#include "mm-log.h"
 
 #define MM_TYPE_PORT_SERIAL            (mm_port_serial_get_type ())
 #define MM_PORT_SERIAL(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MM_TYPE_PORT_SERIAL, MMPortSerial))
@@ -35,6 +38,7 @@
 #define MM_PORT_SERIAL_PARITY       "parity"
 #define MM_PORT_SERIAL_STOPBITS     "stopbits"
 #define MM_PORT_SERIAL_SEND_DELAY   "send-delay"
+#define MM_PORT_SERIAL_SEND_CHUNK_DELAY "send-chunk-delay"
 #define MM_PORT_SERIAL_RTS_CTS      "rts-cts"
 #define MM_PORT_SERIAL_FD           "fd" /* Construct-only */
 #define MM_PORT_SERIAL_SPEW_CONTROL "spew-control" /* Construct-only */
@@ -46,6 +50,14 @@ typedef enum {
     MM_PORT_SERIAL_RESPONSE_ERROR,
 } MMPortSerialResponseType;
 
+/* Commands are served in priority order; commands waiting for long enough
+ * get promoted, so that lower priority ones never starve */
+typedef enum {
+    MM_PORT_SERIAL_COMMAND_PRIORITY_INTERACTIVE,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_NORMAL,
+    MM_PORT_SERIAL_COMMAND_PRIORITY_BACKGROUND,
+} MMPortSerialCommandPriority;
+
 typedef struct _MMPortSerial MMPortSerial;
 typedef struct _MMPortSerialClass MMPortSerialClass;
 typedef struct _MMPortSerialPrivate MMPortSerialPrivate;
@@ -60,9 +72,9 @@ struct _MMPortSerialClass {
 
     /* Called for subclasses to parse unsolicited responses.  If any recognized
      * unsolicited response is found, it should be removed from the 'response'
-     * byte array before returning.
+     * buffer before returning.
      */
-    void     (*parse_unsolicited) (MMPortSerial *self, GByteArray *response);
+    void     (*parse_unsolicited) (MMPortSerial *self, MMSerialBuffer *response);
 
     /*
      * Called to parse the device's response to a command or determine if the
@@ -77,11 +89,12 @@ struct _MMPortSerialClass {
      * If there is no response, @MM_PORT_SERIAL_RESPONSE_NONE will be returned,
      * and neither @error nor @parsed_response will be set.
      *
-     * The implementation is allowed to cleanup the @response byte array, e.g. to
-     * just remove 1 single response if more than one found.
+     * The implementation is expected to consume from the @response buffer the
+     * data processed, e.g. to just remove 1 single response if more than one
+     * found. Consuming data from the head of the buffer doesn't copy.
      */
     MMPortSerialResponseType (*parse_response) (MMPortSerial *self,
-                                                GByteArray *response,
+                                                MMSerialBuffer *response,
                                                 GByteArray **parsed_response,
                                                 GError **error);
 
@@ -94,13 +107,22 @@ struct _MMPortSerialClass {
      * should get ignored. */
     void     (*config)            (MMPortSerial *self);
 
+    /* Logs the traffic of the port; only called if the log category of the
+     * port has debug enabled, or debug is enabled for this port */
     void (*debug_log)             (MMPortSerial *self,
                                    const char *prefix,
                                    const char *buf,
                                    gsize len);
 
+    /* Whether the command doesn't change the state of the device, so that
+     * its reply may be given to several identical commands queued at the
+     * same time */
+    gboolean (*command_is_shareable) (MMPortSerial *self,
+                                      const GByteArray *command);
+    MMLogCategory log_category;
+
     /* Signals */
-    void (*buffer_full)           (MMPortSerial *port, const GByteArray *buffer);
+    void (*buffer_full)           (MMPortSerial *port, const MMSerialBuffer *buffer);
     void (*timed_out)             (MMPortSerial *port, guint n_consecutive_replies);
     void (*forced_close)          (MMPortSerial *port);
 };
@@ -115,6 +137,12 @@ MMPortSerial *mm_port_serial_new (const char *name, MMPortType ptype);
 
 gboolean mm_port_serial_is_open           (MMPortSerial *self);
 
+/* Number of commands queued, including the one being processed */
+guint    mm_port_serial_get_queue_length  (MMPortSerial *self);
+
+/* Bytes allocated for the response buffer */
+gsize    mm_port_serial_get_buffer_size   (MMPortSerial *self);
+
 gboolean mm_port_serial_open              (MMPortSerial *self,
                                            GError  **error);
 
@@ -146,8 +174,83 @@ void        mm_port_serial_command        (MMPortSerial *self,
                                            GCancellable *cancellable,
                                            GAsyncReadyCallback callback,
                                            gpointer user_data);
+void        mm_port_serial_command_full   (MMPortSerial *self,
+                                           GByteArray *command,
+                                           guint32 timeout_seconds,
+                                           gboolean allow_cached,
+                                           MMPortSerialCommandPriority priority,
+                                           GCancellable *cancellable,
+                                           GAsyncReadyCallback callback,
+                                           gpointer user_data);
 GByteArray *mm_port_serial_command_finish (MMPortSerial *self,
                                            GAsyncResult *res,
                                            GError **error);
 
+/* Delays in ms to use instead of the ones given to mm_port_serial_reopen()
+ * and mm_port_serial_flash(), which are worst-case guesses, e.g. when the
+ * device is known to be ready sooner; negative to use the given ones, which
+ * is the default. */
+void mm_port_serial_set_reopen_time (MMPortSerial *self,
+                                     gint reopen_time_ms);
+void mm_port_serial_set_flash_time  (MMPortSerial *self,
+                                     gint flash_time_ms);
+
+/* With spew control enabled, the response buffer is trimmed when it goes
+ * above 2048 bytes, and streams which are mostly trimmed rather than parsed
+ * are muted (input dropped unparsed) for a while, or until a command is sent.
+ * While a reply is awaited on a stream that has been mostly parsed, the
+ * buffer may instead grow up to this many bytes. Defaults to 2048. */
+void mm_port_serial_set_spew_limit (MMPortSerial *self,
+                                    guint max_bytes);
+
+/* Whether the TTY driver is asked to deliver received data right away
+ * (ASYNC_LOW_LATENCY), and USB serial bridges with a latency timer get it at
+ * its minimum. Applied when the port is opened. Disabled by default. */
+void mm_port_serial_set_low_latency (MMPortSerial *self,
+                                     gboolean enabled);
+
+/* Changes the baudrate of the port, right away if it is open, and for all
+ * the following openings otherwise. Only the local end is changed. */
+gboolean mm_port_serial_baudrate_is_supported (guint baud);
+gboolean mm_port_serial_set_baudrate          (MMPortSerial *self,
+                                               guint baud,
+                                               GError **error);
+
+/* Removes the background priority commands not sent yet from the queue,
+ * completing them with a CANCELLED error. Returns how many were removed. */
+guint mm_port_serial_drain_background_commands (MMPortSerial *self);
+
+/* Moves the commands not sent yet to the tail of the queue of another open
+ * port, keeping their order; their callbacks still get this port as source
+ * object. Returns how many were moved. */
+guint mm_port_serial_move_queued_commands (MMPortSerial *self,
+                                          MMPortSerial *target);
+
+/* Command statistics of the port, as an aa{sv}; see mm_serial_stats_build() */
+GVariant *mm_port_serial_get_stats (MMPortSerial *self);
+
+/* Whether the response timeout of each command is shortened to what the
+ * latencies seen so far for commands with the same prefix suggest, never
+ * going above the timeout given by the caller. Disabled by default. */
+void mm_port_serial_set_adaptive_timeouts (MMPortSerial *self,
+                                           gboolean enabled);
+
+/* Whether a shareable command (see command_is_shareable()) which is
+ * byte-identical to one already queued or in flight is not sent again, and
+ * instead gets a copy of the reply to that one. Commands with a cancellable
+ * are never shared. Disabled by default. */
+void mm_port_serial_set_share_commands (MMPortSerial *self,
+                                        gboolean enabled);
+
+/* Reply cache of the port, where subclasses and plugins may setup command
+ * classes and invalidation rules */
+MMSerialReplyCache *mm_port_serial_peek_reply_cache (MMPortSerial *self);
+
+/* Cache owned by the modem and shared among all its ports, used instead of
+ * the port cache for the commands flagged as always cacheable in it. The
+ * owner must unset it before freeing the cache. */
+void                mm_port_serial_set_shared_reply_cache  (MMPortSerial       *self,
+                                                            MMSerialReplyCache *cache);
+MMSerialReplyCache *mm_port_serial_peek_shared_reply_cache (MMPortSerial       *self);
+
 #endif /* MM_PORT_SERIAL_H */
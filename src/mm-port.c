@@ -17,6 +17,13 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
 
 #include "mm-port.h"
 #include "mm-log.h"
@@ -103,6 +110,119 @@ mm_port_peek_kernel_device (MMPort *self)
     return self->priv->kernel_device;
 }
 
+/*****************************************************************************/
+/* Net port links */
+
+gboolean
+mm_port_net_set_up (MMPort *self,
+                    GError **error)
+{
+    struct ifreq ifr;
+    gint fd;
+    gboolean up = FALSE;
+
+    g_return_val_if_fail (self->priv->subsys == MM_PORT_SUBSYS_NET, FALSE);
+
+    memset (&ifr, 0, sizeof (ifr));
+    g_strlcpy (ifr.ifr_name, self->priv->device, sizeof (ifr.ifr_name));
+
+    fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        if (ioctl (fd, SIOCGIFFLAGS, &ifr) == 0) {
+            if (ifr.ifr_flags & IFF_UP)
+                up = TRUE;
+            else {
+                ifr.ifr_flags |= IFF_UP;
+                up = (ioctl (fd, SIOCSIFFLAGS, &ifr) == 0);
+            }
+        }
+        close (fd);
+    }
+    if (!up)
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't set interface '%s' up: %s",
+                     self->priv->device, g_strerror (errno));
+    return up;
+}
+
+GHashTable *
+mm_port_net_list_upper_links (MMPort *self)
+{
+    GHashTable *links;
+    gchar *path;
+    GDir *dir;
+    const gchar *name;
+
+    links = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    path = g_strdup_printf ("/sys/class/net/%s", self->priv->device);
+    dir = g_dir_open (path, 0, NULL);
+    if (dir) {
+        while ((name = g_dir_read_name (dir)) != NULL) {
+            if (g_str_has_prefix (name, "upper_"))
+                g_hash_table_add (links, g_strdup (name + strlen ("upper_")));
+        }
+        g_dir_close (dir);
+    }
+    g_free (path);
+    return links;
+}
+
+MMPort *
+mm_port_net_find_new_upper_link (MMPort *self,
+                                 GHashTable *previous)
+{
+    GHashTable *current;
+    GHashTableIter iter;
+    const gchar *name;
+    MMPort *link = NULL;
+
+    current = mm_port_net_list_upper_links (self);
+    g_hash_table_iter_init (&iter, current);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&name, NULL)) {
+        if (g_hash_table_contains (previous, name))
+            continue;
+        link = MM_PORT (g_object_new (MM_TYPE_PORT,
+                                      MM_PORT_DEVICE, name,
+                                      MM_PORT_SUBSYS, MM_PORT_SUBSYS_NET,
+                                      MM_PORT_TYPE, MM_PORT_TYPE_NET,
+                                      NULL));
+        break;
+    }
+    g_hash_table_unref (current);
+    return link;
+}
+
+static gboolean
+read_statistic (const gchar *device,
+                const gchar *name,
+                guint64 *value,
+                GError **error)
+{
+    gchar *path;
+    gchar *contents = NULL;
+    gboolean read;
+
+    path = g_strdup_printf ("/sys/class/net/%s/statistics/%s", device, name);
+    read = g_file_get_contents (path, &contents, NULL, error);
+    if (read)
+        *value = g_ascii_strtoull (contents, NULL, 10);
+    g_free (contents);
+    g_free (path);
+    return read;
+}
+
+gboolean
+mm_port_net_get_statistics (MMPort *self,
+                            guint64 *rx_bytes,
+                            guint64 *tx_bytes,
+                            GError **error)
+{
+    g_return_val_if_fail (self->priv->subsys == MM_PORT_SUBSYS_NET, FALSE);
+
+    return (read_statistic (self->priv->device, "rx_bytes", rx_bytes, error) &&
+            read_statistic (self->priv->device, "tx_bytes", tx_bytes, error));
+}
+
 /*****************************************************************************/
 
 static void
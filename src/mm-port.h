@@ -79,4 +79,15 @@ gboolean        mm_port_get_connected      (MMPort *self);
 void            mm_port_set_connected      (MMPort *self, gboolean connected);
 MMKernelDevice *mm_port_peek_kernel_device (MMPort *self);
 
+/* Helpers for net ports, e.g. to find the links created on top of them */
+gboolean    mm_port_net_set_up              (MMPort *self,
+                                             GError **error);
+GHashTable *mm_port_net_list_upper_links    (MMPort *self);
+MMPort     *mm_port_net_find_new_upper_link (MMPort *self,
+                                             GHashTable *previous);
+gboolean    mm_port_net_get_statistics      (MMPort *self,
+                                             guint64 *rx_bytes,
+                                             guint64 *tx_bytes,
+                                             GError **error);
+
 #endif /* MM_PORT_H */
@@ -0,0 +1,305 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-profiler.h"
+#include "mm-log.h"
+
+/* Latest finished spans kept */
+#define MAX_SPANS 8192
+
+typedef struct {
+    /* All interned */
+    const gchar *track;
+    const gchar *category;
+    const gchar *name;
+    gint64       start;
+    gint64       end;
+    /* First step of the span, or -1 if not a step */
+    gint         step;
+} Span;
+
+static gboolean running;
+static gint64   start_time;
+
+/* Ring buffer of the latest finished spans */
+static Span    spans[MAX_SPANS];
+static guint64 n_spans;
+
+/* "track\ncategory" -> running Span */
+static GHashTable *running_spans;
+/* Interned track -> interned group */
+static GHashTable *groups;
+
+/*****************************************************************************/
+
+static gchar *
+build_key (const gchar *track,
+           const gchar *category)
+{
+    return g_strdup_printf ("%s\n%s", track, category);
+}
+
+static void
+record (const gchar *track,
+        const gchar *category,
+        const gchar *name,
+        gint64       start,
+        gint64       end)
+{
+    Span *span;
+
+    span = &spans[n_spans % MAX_SPANS];
+    span->track = track;
+    span->category = category;
+    span->name = name;
+    span->start = start;
+    span->end = end;
+    span->step = -1;
+    n_spans++;
+}
+
+/* 'next_step' is the step being started, or -1 */
+static void
+finish (const gchar *track,
+        const gchar *category,
+        gint         next_step,
+        gint64       now)
+{
+    Span *span;
+    gchar *key;
+
+    key = build_key (track, category);
+    span = g_hash_table_lookup (running_spans, key);
+    if (span) {
+        const gchar *name = span->name;
+
+        /* State machines usually fall through the steps with nothing to do,
+         * and are resumed in the step which follows the one they waited
+         * for, so the span covers all the steps in between */
+        if (span->step >= 0 && next_step > span->step + 1) {
+            gchar *str;
+
+            str = g_strdup_printf ("steps %d-%d", span->step, next_step - 1);
+            name = g_intern_string (str);
+            g_free (str);
+        }
+        record (span->track, span->category, name, span->start, now);
+        g_hash_table_remove (running_spans, key);
+    }
+    g_free (key);
+}
+
+static void
+begin (const gchar *track,
+       const gchar *category,
+       const gchar *name,
+       gint         step)
+{
+    Span *span;
+    gint64 now;
+
+    now = g_get_monotonic_time ();
+    finish (track, category, step, now);
+
+    span = g_slice_new0 (Span);
+    span->track = g_intern_string (track);
+    span->category = g_intern_string (category);
+    span->name = g_intern_string (name);
+    span->start = now;
+    span->step = step;
+    g_hash_table_insert (running_spans, build_key (track, category), span);
+}
+
+void
+mm_profiler_begin (const gchar *track,
+                   const gchar *category,
+                   const gchar *name)
+{
+    if (!running)
+        return;
+
+    g_return_if_fail (track != NULL);
+    g_return_if_fail (category != NULL);
+    g_return_if_fail (name != NULL);
+
+    begin (track, category, name, -1);
+}
+
+void
+mm_profiler_end (const gchar *track,
+                 const gchar *category)
+{
+    if (!running)
+        return;
+
+    g_return_if_fail (track != NULL);
+    g_return_if_fail (category != NULL);
+
+    finish (track, category, -1, g_get_monotonic_time ());
+}
+
+void
+mm_profiler_step (const gchar *track,
+                  const gchar *category,
+                  guint        step,
+                  guint        last)
+{
+    gchar *name;
+
+    if (!running)
+        return;
+
+    g_return_if_fail (track != NULL);
+    g_return_if_fail (category != NULL);
+    g_return_if_fail (step <= G_MAXINT);
+
+    if (step >= last) {
+        finish (track, category, (gint) step, g_get_monotonic_time ());
+        return;
+    }
+
+    name = g_strdup_printf ("step %u", step);
+    begin (track, category, name, (gint) step);
+    g_free (name);
+}
+
+void
+mm_profiler_add (const gchar *track,
+                 const gchar *category,
+                 const gchar *name,
+                 gint64       start,
+                 gint64       end)
+{
+    if (!running)
+        return;
+
+    g_return_if_fail (track != NULL);
+    g_return_if_fail (category != NULL);
+    g_return_if_fail (name != NULL);
+
+    /* Spans started before the profiler are of no use */
+    if (start < start_time)
+        return;
+
+    record (g_intern_string (track),
+            g_intern_string (category),
+            g_intern_string (name),
+            start,
+            MAX (start, end));
+}
+
+void
+mm_profiler_set_track_group (const gchar *track,
+                             const gchar *group)
+{
+    if (!running)
+        return;
+
+    g_return_if_fail (track != NULL);
+
+    if (group)
+        g_hash_table_insert (groups,
+                             (gpointer) g_intern_string (track),
+                             (gpointer) g_intern_string (group));
+    else
+        g_hash_table_remove (groups, g_intern_string (track));
+}
+
+/*****************************************************************************/
+
+static void
+add_span (GVariantBuilder *builder,
+          const Span      *span)
+{
+    const gchar *group;
+
+    g_variant_builder_open (builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (builder, "{sv}", "track", g_variant_new_string (span->track));
+    group = g_hash_table_lookup (groups, span->track);
+    if (group)
+        g_variant_builder_add (builder, "{sv}", "group", g_variant_new_string (group));
+    g_variant_builder_add (builder, "{sv}", "category", g_variant_new_string (span->category));
+    g_variant_builder_add (builder, "{sv}", "name", g_variant_new_string (span->name));
+    g_variant_builder_add (builder, "{sv}", "start", g_variant_new_uint64 ((guint64) (span->start - start_time)));
+    /* Running spans have no duration */
+    if (span->end)
+        g_variant_builder_add (builder, "{sv}", "duration", g_variant_new_uint64 ((guint64) (span->end - span->start)));
+    g_variant_builder_close (builder);
+}
+
+GVariant *
+mm_profiler_get_profile (void)
+{
+    GVariantBuilder builder;
+    GVariantBuilder spans_builder;
+    GHashTableIter iter;
+    Span *span;
+    guint64 first;
+    guint64 i;
+
+    if (!running)
+        return NULL;
+
+    first = (n_spans > MAX_SPANS ? n_spans - MAX_SPANS : 0);
+
+    g_variant_builder_init (&spans_builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (i = first; i < n_spans; i++)
+        add_span (&spans_builder, &spans[i % MAX_SPANS]);
+    g_hash_table_iter_init (&iter, running_spans);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &span))
+        add_span (&spans_builder, span);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+    /* Wall clock time when the profiler started, so that span offsets can be
+     * matched against the logs */
+    g_variant_builder_add (&builder, "{sv}", "start-time",
+                           g_variant_new_int64 (g_get_real_time () - (g_get_monotonic_time () - start_time)));
+    g_variant_builder_add (&builder, "{sv}", "dropped", g_variant_new_uint64 (first));
+    g_variant_builder_add (&builder, "{sv}", "spans", g_variant_builder_end (&spans_builder));
+
+    return g_variant_builder_end (&builder);
+}
+
+/*****************************************************************************/
+
+static void
+span_free (Span *span)
+{
+    g_slice_free (Span, span);
+}
+
+gboolean
+mm_profiler_is_running (void)
+{
+    return running;
+}
+
+void
+mm_profiler_start (void)
+{
+    g_return_if_fail (!running);
+
+    running_spans = g_hash_table_new_full (g_str_hash,
+                                           g_str_equal,
+                                           g_free,
+                                           (GDestroyNotify) span_free);
+    /* Track and group names are interned strings */
+    groups = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+    start_time = g_get_monotonic_time ();
+    running = TRUE;
+
+    mm_info ("Profiling probing, initialization and enabling steps");
+}
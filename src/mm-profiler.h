@@ -0,0 +1,67 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_PROFILER_H
+#define MM_PROFILER_H
+
+#include <glib.h>
+
+/*
+ * Timeline of what the daemon does with each device, for debugging purposes:
+ * probing phases, initialization and enabling steps, and the commands sent
+ * to each port.
+ *
+ * Each span is recorded in a track (e.g. the device uid or a port name) and a
+ * category (e.g. "Modem initialization"). Within a track, only one span per
+ * category is running at any time, so beginning a new one ends the previous
+ * one. Tracks of ports may be grouped under the track of their device.
+ *
+ * The latest spans are kept in a bounded buffer. All the calls are no-ops
+ * until the profiler is started, and must only be done from the main thread.
+ */
+
+void     mm_profiler_start      (void);
+gboolean mm_profiler_is_running (void);
+
+void mm_profiler_set_track_group (const gchar *track,
+                                  const gchar *group);
+
+void mm_profiler_begin (const gchar *track,
+                        const gchar *category,
+                        const gchar *name);
+void mm_profiler_end   (const gchar *track,
+                        const gchar *category);
+
+/* For step-based state machines, called each time the machine is run: begins
+ * a span named after the step number, or just ends the running one once
+ * 'step' reaches 'last'. The span of a run covers the steps it went through
+ * until the next run, e.g. "steps 3-5". */
+void mm_profiler_step  (const gchar *track,
+                        const gchar *category,
+                        guint        step,
+                        guint        last);
+
+/* Records an already finished span, given in monotonic time */
+void mm_profiler_add   (const gchar *track,
+                        const gchar *category,
+                        const gchar *name,
+                        gint64       start,
+                        gint64       end);
+
+/* Returns an "a{sv}" variant with the recorded spans, or NULL if the profiler
+ * isn't running */
+GVariant *mm_profiler_get_profile (void);
+
+#endif /* MM_PROFILER_H */
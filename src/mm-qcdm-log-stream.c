@@ -0,0 +1,241 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-qcdm-log-stream.h"
+#include "mm-byte-ring.h"
+#include "mm-log.h"
+
+/* Items are just appended to the file, so they go through the ring as a
+ * plain stream of bytes */
+#define RING_SIZE (1 << 20)
+
+static gchar   *directory;
+static guint16 *codes;
+static guint    n_codes;
+
+gboolean
+mm_qcdm_log_stream_configure (const gchar  *path,
+                              const gchar  *log_codes,
+                              GError      **error)
+{
+    GArray *array;
+    gchar **split = NULL;
+    guint i;
+
+    array = g_array_new (FALSE, FALSE, sizeof (guint16));
+    if (log_codes)
+        split = g_strsplit (log_codes, ",", -1);
+    for (i = 0; split && split[i]; i++) {
+        guint64 value;
+        gchar *end = NULL;
+        guint16 code;
+
+        g_strstrip (split[i]);
+        value = g_ascii_strtoull (split[i], &end, 0);
+        if (!split[i][0] || (end && *end) || value == 0 || value > G_MAXUINT16) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS,
+                         "Invalid QCDM log code: '%s'", split[i]);
+            g_strfreev (split);
+            g_array_unref (array);
+            return FALSE;
+        }
+        code = (guint16) value;
+        g_array_append_val (array, code);
+    }
+    g_strfreev (split);
+
+    g_free (directory);
+    directory = g_strdup (path);
+    g_free (codes);
+    n_codes = array->len;
+    codes = (guint16 *) g_array_free (array, FALSE);
+    return TRUE;
+}
+
+const gchar *
+mm_qcdm_log_stream_get_directory (void)
+{
+    return directory;
+}
+
+const guint16 *
+mm_qcdm_log_stream_get_log_codes (guint *n_log_codes)
+{
+    *n_log_codes = n_codes;
+    return codes;
+}
+
+/*****************************************************************************/
+
+struct _MMQcdmLogStream {
+    gchar      *port_name;
+    gint        fd;
+    MMByteRing *ring;
+    GThread    *thread;
+
+    gint        write_failed;
+    gboolean    write_failure_reported;
+    guint64     dropped;
+};
+
+static gboolean
+write_all (gint          fd,
+           const guint8 *buf,
+           gsize         len)
+{
+    while (len > 0) {
+        gssize written;
+
+        written = write (fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return FALSE;
+        }
+        buf += written;
+        len -= written;
+    }
+    return TRUE;
+}
+
+/* Runs in the writer thread; must not log, as logging isn't thread-safe */
+static gpointer
+writer_thread (MMQcdmLogStream *self)
+{
+    for (;;) {
+        const guint8 *data;
+        gboolean closed;
+        gsize len;
+
+        mm_byte_ring_wait (self->ring, -1);
+        closed = mm_byte_ring_is_closed (self->ring);
+
+        while ((len = mm_byte_ring_peek (self->ring, &data)) > 0) {
+            /* Once writing failed, keep on draining the ring, but don't
+             * try to write any more */
+            if (!g_atomic_int_get (&self->write_failed) &&
+                !write_all (self->fd, data, len))
+                g_atomic_int_set (&self->write_failed, errno ? errno : EIO);
+            mm_byte_ring_release (self->ring, len);
+        }
+
+        if (closed)
+            break;
+    }
+
+    return NULL;
+}
+
+MMQcdmLogStream *
+mm_qcdm_log_stream_new (const gchar *port_name)
+{
+    MMQcdmLogStream *self;
+    GDateTime       *now;
+    gchar           *basename;
+    gchar           *safe_name;
+    gchar           *path;
+    gchar           *timestamp;
+    gint             fd;
+
+    if (!directory)
+        return NULL;
+
+    now = g_date_time_new_now_local ();
+    timestamp = g_date_time_format (now, "%Y%m%d-%H%M%S");
+    safe_name = g_strdelimit (g_strdup (port_name), G_DIR_SEPARATOR_S, '_');
+    basename = g_strdup_printf ("%s-%s.dlf", safe_name, timestamp);
+    path = g_build_filename (directory, basename, NULL);
+    g_date_time_unref (now);
+    g_free (safe_name);
+    g_free (timestamp);
+    g_free (basename);
+
+    fd = open (path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        mm_warn ("(%s) couldn't create QCDM log stream file '%s': %s",
+                 port_name, path, g_strerror (errno));
+        g_free (path);
+        return NULL;
+    }
+    mm_dbg ("(%s) streaming QCDM log packets into '%s'", port_name, path);
+    g_free (path);
+
+    self = g_slice_new0 (MMQcdmLogStream);
+    self->port_name = g_strdup (port_name);
+    self->fd = fd;
+    self->ring = mm_byte_ring_new (RING_SIZE);
+    self->thread = g_thread_new ("qcdm-log-stream", (GThreadFunc) writer_thread, self);
+    return self;
+}
+
+static void
+report_write_failure (MMQcdmLogStream *self)
+{
+    gint failure;
+
+    if (self->write_failure_reported)
+        return;
+
+    failure = g_atomic_int_get (&self->write_failed);
+    if (!failure)
+        return;
+
+    mm_warn ("(%s) couldn't write QCDM log stream: %s",
+             self->port_name, g_strerror (failure));
+    self->write_failure_reported = TRUE;
+}
+
+void
+mm_qcdm_log_stream_free (MMQcdmLogStream *self)
+{
+    if (!self)
+        return;
+
+    mm_byte_ring_close (self->ring);
+    g_thread_join (self->thread);
+    report_write_failure (self);
+    if (self->dropped)
+        mm_dbg ("(%s) %" G_GUINT64_FORMAT " QCDM log packets were dropped from the stream",
+                self->port_name, self->dropped);
+
+    close (self->fd);
+    mm_byte_ring_free (self->ring);
+    g_free (self->port_name);
+    g_slice_free (MMQcdmLogStream, self);
+}
+
+gboolean
+mm_qcdm_log_stream_push (MMQcdmLogStream *self,
+                         const guint8    *item,
+                         gsize            len)
+{
+    report_write_failure (self);
+
+    /* Items too large would just take the room of many others */
+    if (len == 0 || len > RING_SIZE / 2 ||
+        !mm_byte_ring_push (self->ring, item, len)) {
+        self->dropped++;
+        return FALSE;
+    }
+    return TRUE;
+}
@@ -0,0 +1,56 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_QCDM_LOG_STREAM_H
+#define MM_QCDM_LOG_STREAM_H
+
+#include <glib.h>
+
+/*
+ * Streaming of the log packets received in QCDM ports into files, e.g. for
+ * RF drive testing.
+ *
+ * Files are in the DLF format: the log item of each packet (length, log code,
+ * timestamp and payload) one after the other, as sent by the device.
+ *
+ * Packets are pushed from the main loop into a lock-free ring, which a
+ * dedicated thread drains in batches into the file, so that thousands of
+ * packets per second or slow storage never stall the main loop. Packets are
+ * dropped if the ring is full.
+ */
+
+/* Directory where QCDM ports store their log streams, and the list of log
+ * codes to enable, as decimal or 0x-prefixed hex values separated by commas.
+ * If no directory is set, nothing is streamed. */
+gboolean     mm_qcdm_log_stream_configure      (const gchar  *directory,
+                                                const gchar  *log_codes,
+                                                GError      **error);
+const gchar *mm_qcdm_log_stream_get_directory  (void);
+const guint16 *mm_qcdm_log_stream_get_log_codes (guint *n_log_codes);
+
+typedef struct _MMQcdmLogStream MMQcdmLogStream;
+
+/* Returns NULL if no directory is set or if the file cannot be created */
+MMQcdmLogStream *mm_qcdm_log_stream_new  (const gchar *port_name);
+
+/* Flushes all the pending packets before returning */
+void             mm_qcdm_log_stream_free (MMQcdmLogStream *self);
+
+/* Main thread only; never blocks. Returns FALSE if the packet was dropped. */
+gboolean         mm_qcdm_log_stream_push (MMQcdmLogStream *self,
+                                          const guint8    *item,
+                                          gsize            len);
+
+#endif /* MM_QCDM_LOG_STREAM_H */
@@ -0,0 +1,118 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#include "mm-regex-registry.h"
+#include "mm-memory-budget.h"
+#include "mm-log.h"
+
+typedef struct {
+    GRegex             *regex;
+    GRegexCompileFlags  compile_options;
+    gint64              compile_time_us;
+    guint               lookups;
+} RegistryEntry;
+
+/* Pattern -> GSList of RegistryEntry, one per set of compile options */
+static GHashTable *registry;
+G_LOCK_DEFINE_STATIC (registry);
+
+GRegex *
+mm_regex_registry_get (const gchar        *pattern,
+                       GRegexCompileFlags  compile_options)
+{
+    RegistryEntry *entry = NULL;
+    GSList        *entries;
+    GSList        *l;
+    GRegex        *regex;
+
+    g_return_val_if_fail (pattern != NULL, NULL);
+
+    /* Optimized patterns match faster but take more memory */
+    if (mm_memory_budget_get ()->regex_optimize)
+        compile_options |= G_REGEX_OPTIMIZE;
+    else
+        compile_options &= ~G_REGEX_OPTIMIZE;
+
+    G_LOCK (registry);
+
+    if (G_UNLIKELY (!registry))
+        registry = g_hash_table_new (g_str_hash, g_str_equal);
+
+    entries = g_hash_table_lookup (registry, pattern);
+    for (l = entries; l; l = g_slist_next (l)) {
+        if (((RegistryEntry *) l->data)->compile_options == compile_options) {
+            entry = l->data;
+            break;
+        }
+    }
+
+    if (!entry) {
+        GError *error = NULL;
+        gint64  start;
+
+        start = g_get_monotonic_time ();
+        regex = g_regex_new (pattern, compile_options, 0, &error);
+        if (!regex)
+            g_error ("Invalid regular expression '%s': %s", pattern, error->message);
+
+        entry = g_slice_new0 (RegistryEntry);
+        entry->regex = regex;
+        entry->compile_options = compile_options;
+        entry->compile_time_us = g_get_monotonic_time () - start;
+
+        /* Entries are never removed, so the key is owned by the regex */
+        entries = g_slist_prepend (entries, entry);
+        g_hash_table_replace (registry, (gpointer) g_regex_get_pattern (regex), entries);
+    }
+
+    entry->lookups++;
+    regex = g_regex_ref (entry->regex);
+
+    G_UNLOCK (registry);
+
+    return regex;
+}
+
+void
+mm_regex_registry_report (void)
+{
+    GHashTableIter  iter;
+    GSList         *entries;
+    gint64          total_us = 0;
+    guint           n_regex = 0;
+
+    G_LOCK (registry);
+
+    if (registry) {
+        g_hash_table_iter_init (&iter, registry);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entries)) {
+            GSList *l;
+
+            for (l = entries; l; l = g_slist_next (l)) {
+                RegistryEntry *entry = l->data;
+
+                mm_dbg ("regex registry: %u lookups, compiled in %" G_GINT64_FORMAT "us: '%s'",
+                        entry->lookups,
+                        entry->compile_time_us,
+                        g_regex_get_pattern (entry->regex));
+                total_us += entry->compile_time_us;
+                n_regex++;
+            }
+        }
+    }
+
+    mm_dbg ("regex registry: %u regular expressions compiled in %" G_GINT64_FORMAT "us",
+            n_regex, total_us);
+
+    G_UNLOCK (registry);
+}
@@ -0,0 +1,35 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+#ifndef MM_REGEX_REGISTRY_H
+#define MM_REGEX_REGISTRY_H
+
+#include <glib.h>
+
+/*
+ * Process-wide registry of compiled regular expressions, shared by all
+ * modems. Each pattern is compiled once, the first time it is requested, with
+ * G_REGEX_OPTIMIZE unless the memory budget says otherwise; GRegex objects are
+ * immutable and may be used by several matches at the same time.
+ *
+ * The pattern must be valid, as failing to compile it is a programming error.
+ * A new reference is returned, to be released with g_regex_unref(), so that
+ * it can be used wherever g_regex_new() was.
+ */
+GRegex *mm_regex_registry_get (const gchar        *pattern,
+                               GRegexCompileFlags  compile_options);
+
+/* Logs the compile time and number of lookups of each pattern */
+void    mm_regex_registry_report (void);
+
+#endif /* MM_REGEX_REGISTRY_H */
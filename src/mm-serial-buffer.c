@@ -0,0 +1,287 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-serial-buffer.h"
+
+struct _MMSerialBuffer {
+    guint8 *storage;
+    gsize   allocated;
+    /* Read cursor */
+    gsize   start;
+    /* Number of unconsumed bytes after the read cursor */
+    gsize   len;
+    /* Parser mark, relative to the read cursor */
+    gsize   mark;
+    /* Leading bytes unchanged since a consumer copied them */
+    gsize   copied;
+};
+
+MMSerialBuffer *
+mm_serial_buffer_new (gsize reserved_size)
+{
+    MMSerialBuffer *self;
+
+    self = g_slice_new0 (MMSerialBuffer);
+    self->allocated = (reserved_size > 0 ? reserved_size : 1);
+    self->storage = g_malloc (self->allocated);
+    return self;
+}
+
+void
+mm_serial_buffer_free (MMSerialBuffer *self)
+{
+    if (!self)
+        return;
+    g_free (self->storage);
+    g_slice_free (MMSerialBuffer, self);
+}
+
+const guint8 *
+mm_serial_buffer_get_data (const MMSerialBuffer *self)
+{
+    return self->storage + self->start;
+}
+
+gsize
+mm_serial_buffer_get_length (const MMSerialBuffer *self)
+{
+    return self->len;
+}
+
+static void
+ensure_room (MMSerialBuffer *self,
+             gsize           len)
+{
+    /* Not enough room at the tail? */
+    if (self->start + self->len + len > self->allocated) {
+        /* Move the unconsumed data back to the beginning of the storage; this
+         * is the only place where data is ever copied around. */
+        if (self->start > 0) {
+            if (self->len > 0)
+                memmove (self->storage, self->storage + self->start, self->len);
+            self->start = 0;
+        }
+
+        /* And grow if still not enough */
+        if (self->len + len > self->allocated) {
+            while (self->len + len > self->allocated)
+                self->allocated *= 2;
+            self->storage = g_realloc (self->storage, self->allocated);
+        }
+    }
+}
+
+void
+mm_serial_buffer_append (MMSerialBuffer *self,
+                         const guint8   *data,
+                         gsize           len)
+{
+    if (!len)
+        return;
+
+    ensure_room (self, len);
+    memcpy (self->storage + self->start + self->len, data, len);
+    self->len += len;
+}
+
+guint8 *
+mm_serial_buffer_reserve (MMSerialBuffer *self,
+                          gsize           len)
+{
+    ensure_room (self, len);
+    return self->storage + self->start + self->len;
+}
+
+void
+mm_serial_buffer_commit (MMSerialBuffer *self,
+                         gsize           len)
+{
+    g_return_if_fail (self->start + self->len + len <= self->allocated);
+
+    self->len += len;
+}
+
+void
+mm_serial_buffer_consume (MMSerialBuffer *self,
+                          gsize           len)
+{
+    g_return_if_fail (len <= self->len);
+
+    self->len -= len;
+    self->mark = (self->mark > len ? self->mark - len : 0);
+    if (len)
+        self->copied = 0;
+    /* When everything consumed, rewind the cursor for free */
+    self->start = (self->len ? self->start + len : 0);
+}
+
+void
+mm_serial_buffer_remove_range (MMSerialBuffer *self,
+                               gsize           offset,
+                               gsize           len)
+{
+    gsize tail_len;
+
+    g_return_if_fail (offset <= self->len && len <= self->len - offset);
+
+    if (!len)
+        return;
+
+    if (offset == 0) {
+        mm_serial_buffer_consume (self, len);
+        return;
+    }
+
+    tail_len = self->len - offset - len;
+    if (offset < tail_len) {
+        /* Head is shorter: move it forward and advance the cursor */
+        memmove (self->storage + self->start + len, self->storage + self->start, offset);
+        self->start += len;
+    } else if (tail_len > 0) {
+        /* Tail is shorter: move it backwards */
+        memmove (self->storage + self->start + offset,
+                 self->storage + self->start + offset + len,
+                 tail_len);
+    }
+    self->len -= len;
+
+    if (self->mark > offset)
+        self->mark = (self->mark >= offset + len ? self->mark - len : offset);
+    self->copied = MIN (self->copied, offset);
+}
+
+static gint
+range_cmp (const MMSerialBufferRange *a,
+           const MMSerialBufferRange *b)
+{
+    return (a->offset < b->offset ? -1 : (a->offset > b->offset ? 1 : 0));
+}
+
+void
+mm_serial_buffer_remove_ranges (MMSerialBuffer *self,
+                                GArray         *ranges)
+{
+    guint8 *data;
+    gsize   read_pos = 0;
+    gsize   write_pos = 0;
+    gsize   new_mark;
+    guint   i;
+
+    if (!ranges->len)
+        return;
+
+    if (ranges->len == 1) {
+        MMSerialBufferRange *range;
+
+        range = &g_array_index (ranges, MMSerialBufferRange, 0);
+        mm_serial_buffer_remove_range (self, range->offset, range->len);
+        return;
+    }
+
+    /* Validate all ranges before touching anything, so that a bad one doesn't
+     * leave the data and the mark half updated */
+    for (i = 0; i < ranges->len; i++) {
+        MMSerialBufferRange *range;
+
+        range = &g_array_index (ranges, MMSerialBufferRange, i);
+        g_return_if_fail (range->offset <= self->len && range->len <= self->len - range->offset);
+    }
+
+    g_array_sort (ranges, (GCompareFunc) range_cmp);
+    self->copied = MIN (self->copied, g_array_index (ranges, MMSerialBufferRange, 0).offset);
+
+    data = self->storage + self->start;
+    new_mark = self->mark;
+    for (i = 0; i < ranges->len; i++) {
+        MMSerialBufferRange *range;
+        gsize                range_start;
+        gsize                range_end;
+
+        range = &g_array_index (ranges, MMSerialBufferRange, i);
+
+        /* Overlapping with the previous one? */
+        range_start = MAX (range->offset, read_pos);
+        range_end = range->offset + range->len;
+        if (range_end <= range_start)
+            continue;
+
+        /* Keep the data before the range */
+        if (range_start > read_pos) {
+            if (write_pos != read_pos)
+                memmove (data + write_pos, data + read_pos, range_start - read_pos);
+            write_pos += range_start - read_pos;
+        }
+        read_pos = range_end;
+
+        /* Update mark */
+        if (self->mark > range_start)
+            new_mark -= (MIN (self->mark, range_end) - range_start);
+    }
+
+    /* Keep the data after the last range */
+    if (read_pos < self->len) {
+        if (write_pos != read_pos)
+            memmove (data + write_pos, data + read_pos, self->len - read_pos);
+        write_pos += self->len - read_pos;
+    }
+
+    self->len = write_pos;
+    self->mark = new_mark;
+    if (!self->len)
+        self->start = 0;
+}
+
+void
+mm_serial_buffer_clear (MMSerialBuffer *self)
+{
+    self->start = 0;
+    self->len = 0;
+    self->mark = 0;
+    self->copied = 0;
+}
+
+gsize
+mm_serial_buffer_get_mark (const MMSerialBuffer *self)
+{
+    return self->mark;
+}
+
+void
+mm_serial_buffer_set_mark (MMSerialBuffer *self,
+                           gsize           mark)
+{
+    self->mark = MIN (mark, self->len);
+}
+
+gsize
+mm_serial_buffer_get_copied (const MMSerialBuffer *self)
+{
+    return self->copied;
+}
+
+gsize
+mm_serial_buffer_get_allocated (const MMSerialBuffer *self)
+{
+    return self->allocated;
+}
+
+void
+mm_serial_buffer_set_copied (MMSerialBuffer *self,
+                             gsize           copied)
+{
+    self->copied = MIN (copied, self->len);
+}
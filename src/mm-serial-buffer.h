@@ -0,0 +1,92 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SERIAL_BUFFER_H
+#define MM_SERIAL_BUFFER_H
+
+#include <glib.h>
+
+/*
+ * Response buffer used by serial ports.
+ *
+ * Data is appended at the tail and consumed from the head by just moving a
+ * read cursor, so that consuming N bytes never copies the remaining ones. The
+ * unconsumed data is always kept contiguous (parsers rely on running regexes
+ * over it), and it is only moved back to the beginning of the storage when
+ * appending new data wouldn't fit otherwise.
+ */
+typedef struct _MMSerialBuffer MMSerialBuffer;
+
+MMSerialBuffer *mm_serial_buffer_new          (gsize reserved_size);
+void            mm_serial_buffer_free         (MMSerialBuffer *self);
+
+/* View of the unconsumed data; only valid until the buffer is modified */
+const guint8   *mm_serial_buffer_get_data     (const MMSerialBuffer *self);
+gsize           mm_serial_buffer_get_length   (const MMSerialBuffer *self);
+
+void            mm_serial_buffer_append       (MMSerialBuffer *self,
+                                               const guint8   *data,
+                                               gsize           len);
+
+/* Get room for at least N more bytes at the tail, so that data can be read
+ * directly into the buffer, and then commit the bytes actually written
+ * there. The returned pointer is only valid until the buffer is modified. */
+guint8         *mm_serial_buffer_reserve      (MMSerialBuffer *self,
+                                               gsize           len);
+void            mm_serial_buffer_commit       (MMSerialBuffer *self,
+                                               gsize           len);
+
+/* Consume N bytes from the head of the unconsumed data */
+void            mm_serial_buffer_consume      (MMSerialBuffer *self,
+                                               gsize           len);
+
+/* Remove a range at any position of the unconsumed data; the shortest side
+ * of the buffer is the one moved to fill the gap. */
+void            mm_serial_buffer_remove_range (MMSerialBuffer *self,
+                                               gsize           offset,
+                                               gsize           len);
+
+/* Remove multiple ranges of the unconsumed data at once, moving each byte
+ * that is kept at most once. Ranges may be given in any order and may
+ * overlap; the array is sorted in place. */
+typedef struct {
+    gsize offset;
+    gsize len;
+} MMSerialBufferRange;
+
+void            mm_serial_buffer_remove_ranges (MMSerialBuffer *self,
+                                                GArray         *ranges);
+
+void            mm_serial_buffer_clear        (MMSerialBuffer *self);
+
+/* Offset within the unconsumed data that parsers may use to flag how much
+ * of it they already scanned. It's updated whenever data before it is
+ * consumed or removed. */
+gsize           mm_serial_buffer_get_mark     (const MMSerialBuffer *self);
+void            mm_serial_buffer_set_mark     (MMSerialBuffer *self,
+                                               gsize           mark);
+
+/* Number of leading bytes of the unconsumed data that a consumer flagged as
+ * already copied elsewhere, and which haven't changed since then; so that
+ * only the data appended afterwards needs to be copied again. It's lowered
+ * whenever data before it is consumed or removed. */
+gsize           mm_serial_buffer_get_copied   (const MMSerialBuffer *self);
+void            mm_serial_buffer_set_copied   (MMSerialBuffer *self,
+                                               gsize           copied);
+
+/* Bytes of storage allocated, whether in use or not */
+gsize           mm_serial_buffer_get_allocated (const MMSerialBuffer *self);
+
+#endif /* MM_SERIAL_BUFFER_H */
@@ -50,50 +50,256 @@ response_clean (GString *response)
 }
 
 
+/*****************************************************************************/
+/* Final result scanner
+ *
+ * Final result codes are looked up in a single linear pass over the response,
+ * instead of matching one regex after another against the whole string.
+ *
+ * Some of the result codes are only accepted at the end of the response
+ * (e.g. OK or +CME ERROR), so we just need to look at its last line. The
+ * others may appear in any line (e.g. CONNECT or ERROR), and for those we
+ * keep track of how much of the response was already scanned in previous
+ * reads, so that each byte is only looked at once.
+ */
+
+/* When resuming a scan, go back a bit so that a result code split around a
+ * range removed from the buffer (e.g. an unsolicited message) is not missed.
+ * Longer than any of the line tokens we look for. */
+#define SCAN_BACKOFF 16
+
+typedef struct {
+    /* Position of the first line matching each token, or -1 */
+    gssize connect;
+    gssize error;
+    gssize connect_failed;
+    gssize na;
+    MMConnectionError connect_failed_code;
+    /* Where the next incremental scan should start */
+    gsize  resume;
+} ScanResult;
+
+typedef enum {
+    LINE_TOKEN_MATCH,
+    LINE_TOKEN_NO_MATCH,
+    LINE_TOKEN_PENDING,
+} LineTokenMatch;
+
+static LineTokenMatch
+match_line_token (const gchar *line,
+                  gsize        left,
+                  const gchar *token,
+                  gsize        token_len)
+{
+    if (left >= token_len)
+        return (memcmp (line, token, token_len) == 0 ? LINE_TOKEN_MATCH : LINE_TOKEN_NO_MATCH);
+    /* Not enough data yet; may be the beginning of the token */
+    return (memcmp (line, token, left) == 0 ? LINE_TOKEN_PENDING : LINE_TOKEN_NO_MATCH);
+}
+
+static const struct {
+    const gchar       *token;
+    gsize              token_len;
+    MMConnectionError  code;
+} connect_failed_tokens[] = {
+    { "NO CARRIER", 10, MM_CONNECTION_ERROR_NO_CARRIER },
+    { "BUSY",        4, MM_CONNECTION_ERROR_BUSY       },
+    { "NO ANSWER",   9, MM_CONNECTION_ERROR_NO_ANSWER  },
+};
+
+static void
+scan_lines (const GString *response,
+            gsize          from,
+            ScanResult    *result)
+{
+    const gchar *str = response->str;
+    const gchar *end = response->str + response->len;
+    const gchar *p;
+    gsize        pending = response->len;
+    guint        i;
+
+    result->connect = -1;
+    result->error = -1;
+    result->connect_failed = -1;
+    result->na = -1;
+
+    p = str + MIN (from, response->len);
+    while (p < end && (p = memchr (p, '\r', end - p)) != NULL) {
+        const gchar    *line;
+        gsize           left;
+        LineTokenMatch  match;
+
+        /* A trailing <CR> may become the start of a line in the next read */
+        if (p + 1 == end) {
+            pending = MIN (pending, (gsize)(p - str));
+            break;
+        }
+
+        if (p[1] != '\n') {
+            p++;
+            continue;
+        }
+
+        line = p + 2;
+        left = end - line;
+
+        /* CONNECT, with anything up to the end of the line */
+        if (result->connect < 0) {
+            match = match_line_token (line, left, "CONNECT", 7);
+            if (match == LINE_TOKEN_MATCH) {
+                const gchar *lf;
+
+                lf = memchr (line + 7, '\n', left - 7);
+                if (!lf)
+                    pending = MIN (pending, (gsize)(p - str));
+                else if (lf - 1 >= line + 7 && *(lf - 1) == '\r')
+                    result->connect = p - str;
+            } else if (match == LINE_TOKEN_PENDING)
+                pending = MIN (pending, (gsize)(p - str));
+        }
+
+        /* Generic ERROR */
+        if (result->error < 0) {
+            match = match_line_token (line, left, "ERROR", 5);
+            if (match == LINE_TOKEN_MATCH)
+                result->error = p - str;
+            else if (match == LINE_TOKEN_PENDING)
+                pending = MIN (pending, (gsize)(p - str));
+        }
+
+        /* Connection failures */
+        if (result->connect_failed < 0) {
+            for (i = 0; i < G_N_ELEMENTS (connect_failed_tokens); i++) {
+                match = match_line_token (line, left,
+                                          connect_failed_tokens[i].token,
+                                          connect_failed_tokens[i].token_len);
+                if (match == LINE_TOKEN_MATCH) {
+                    result->connect_failed = p - str;
+                    result->connect_failed_code = connect_failed_tokens[i].code;
+                    break;
+                }
+                if (match == LINE_TOKEN_PENDING)
+                    pending = MIN (pending, (gsize)(p - str));
+            }
+        }
+
+        /* Samsung Z810 may reply "NA" to report a not-available error */
+        if (result->na < 0) {
+            match = match_line_token (line, left, "NA\r\n", 4);
+            if (match == LINE_TOKEN_MATCH)
+                result->na = p - str;
+            else if (match == LINE_TOKEN_PENDING)
+                pending = MIN (pending, (gsize)(p - str));
+        }
+
+        p = line;
+    }
+
+    result->resume = pending;
+}
+
+/* Returns the last line of the response if the response ends with <CR><LF>
+ * and the line is preceded by <CR><LF>, excluding both */
+static const gchar *
+get_last_line (const GString *response,
+               gsize         *line_len)
+{
+    gsize line_end;
+    gsize i;
+
+    if (response->len < 4 ||
+        response->str[response->len - 2] != '\r' ||
+        response->str[response->len - 1] != '\n')
+        return NULL;
+
+    line_end = response->len - 2;
+    for (i = line_end; i >= 2; i--) {
+        if (response->str[i - 2] == '\r' && response->str[i - 1] == '\n') {
+            *line_len = line_end - i;
+            return &response->str[i];
+        }
+    }
+    return NULL;
+}
+
 static gboolean
-remove_eval_cb (const GMatchInfo *match_info,
-                GString *result,
-                gpointer user_data)
+str_has_suffix_len (const GString *response,
+                    const gchar   *suffix,
+                    gsize          suffix_len)
+{
+    return (response->len >= suffix_len &&
+            memcmp (response->str + response->len - suffix_len, suffix, suffix_len) == 0);
+}
+
+/* "\r\nOK(\r\n)+$"; returns offset of the match, or -1 */
+static gssize
+find_trailing_ok (const GString *response)
 {
-    int *result_len = (int *) user_data;
-    int start;
-    int end;
+    gsize e = response->len;
+    guint n = 0;
 
-    if (g_match_info_fetch_pos  (match_info, 0, &start, &end))
-        *result_len -= (end - start);
+    while (e >= 2 && response->str[e - 2] == '\r' && response->str[e - 1] == '\n') {
+        e -= 2;
+        n++;
+    }
 
-    return TRUE;
+    if (n > 0 && e >= 4 && memcmp (response->str + e - 4, "\r\nOK", 4) == 0)
+        return e - 4;
+    return -1;
 }
 
-static void
-remove_matches (GRegex *r, GString *string)
+/* "\r\n>\s*$" */
+static gboolean
+has_trailing_sms_prompt (const GString *response)
 {
-    char *str;
-    int result_len = string->len;
+    gsize e = response->len;
 
-    str = g_regex_replace_eval (r, string->str, string->len, 0, 0,
-                                remove_eval_cb, &result_len, NULL);
+    while (e > 0 && g_ascii_isspace (response->str[e - 1]))
+        e--;
 
-    g_string_truncate (string, 0);
-    g_string_append_len (string, str, result_len);
-    g_free (str);
+    return (e >= 3 && memcmp (response->str + e - 3, "\r\n>", 3) == 0);
 }
 
+/* "<prefix>\s*(\d+)" or "<prefix>\s*([^\n\r]+)" in the given line */
+static gboolean
+parse_error_line (const gchar  *line,
+                  gsize         line_len,
+                  const gchar  *prefix,
+                  gsize         prefix_len,
+                  gchar       **str,
+                  gboolean     *numeric)
+{
+    gsize start;
+    gsize i;
+
+    if (line_len <= prefix_len || memcmp (line, prefix, prefix_len) != 0)
+        return FALSE;
+
+    start = prefix_len;
+    while (start < line_len && g_ascii_isspace (line[start]))
+        start++;
+    /* Only whitespace; keep it all as string */
+    if (start == line_len)
+        start = prefix_len;
+
+    *numeric = TRUE;
+    for (i = start; i < line_len; i++) {
+        if (!g_ascii_isdigit (line[i]))
+            *numeric = FALSE;
+        if (line[i] == '\r' || line[i] == '\n')
+            return FALSE;
+    }
+
+    *str = g_strndup (&line[start], line_len - start);
+    return TRUE;
+}
+
+/*****************************************************************************/
+
 typedef struct {
-    /* Regular expressions for successful replies */
-    GRegex *regex_ok;
-    GRegex *regex_connect;
-    GRegex *regex_sms;
+    /* Custom regular expressions for successful and error replies, which
+     * involve a full regex match of the response */
     GRegex *regex_custom_successful;
-    /* Regular expressions for error replies */
-    GRegex *regex_cme_error;
-    GRegex *regex_cms_error;
-    GRegex *regex_cme_error_str;
-    GRegex *regex_cms_error_str;
-    GRegex *regex_ezx_error;
-    GRegex *regex_unknown_error;
-    GRegex *regex_connect_failed;
-    GRegex *regex_na;
     GRegex *regex_custom_error;
     /* User-provided parser filter */
     mm_serial_parser_v1_filter_fn filter_callback;
@@ -104,23 +310,9 @@ gpointer
 mm_serial_parser_v1_new (void)
 {
     MMSerialParserV1 *parser;
-    GRegexCompileFlags flags = G_REGEX_DOLLAR_ENDONLY | G_REGEX_RAW | G_REGEX_OPTIMIZE;
 
     parser = g_slice_new (MMSerialParserV1);
 
-    parser->regex_ok = g_regex_new ("\\r\\nOK(\\r\\n)+$", flags, 0, NULL);
-    parser->regex_connect = g_regex_new ("\\r\\nCONNECT.*\\r\\n", flags, 0, NULL);
-    parser->regex_sms = g_regex_new ("\\r\\n>\\s*$", flags, 0, NULL);
-    parser->regex_cme_error = g_regex_new ("\\r\\n\\+CME ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cms_error = g_regex_new ("\\r\\n\\+CMS ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cme_error_str = g_regex_new ("\\r\\n\\+CME ERROR:\\s*([^\\n\\r]+)\\r\\n$", flags, 0, NULL);
-    parser->regex_cms_error_str = g_regex_new ("\\r\\n\\+CMS ERROR:\\s*([^\\n\\r]+)\\r\\n$", flags, 0, NULL);
-    parser->regex_ezx_error = g_regex_new ("\\r\\n\\MODEM ERROR:\\s*(\\d+)\\r\\n$", flags, 0, NULL);
-    parser->regex_unknown_error = g_regex_new ("\\r\\n(ERROR)|(COMMAND NOT SUPPORT)\\r\\n$", flags, 0, NULL);
-    parser->regex_connect_failed = g_regex_new ("\\r\\n(NO CARRIER)|(BUSY)|(NO ANSWER)|(NO DIALTONE)\\r\\n$", flags, 0, NULL);
-    /* Samsung Z810 may reply "NA" to report a not-available error */
-    parser->regex_na = g_regex_new ("\\r\\nNA\\r\\n", flags, 0, NULL);
-
     parser->regex_custom_successful = NULL;
     parser->regex_custom_error = NULL;
     parser->filter_callback = NULL;
@@ -163,37 +355,58 @@ mm_serial_parser_v1_add_filter (gpointer data,
 gboolean
 mm_serial_parser_v1_parse (gpointer data,
                            GString *response,
+                           gsize *scanned,
                            GError **error)
 {
     MMSerialParserV1 *parser = (MMSerialParserV1 *) data;
     GMatchInfo *match_info;
     GError *local_error = NULL;
     gboolean found = FALSE;
-    char *str = NULL;
+    ScanResult scan;
+    const gchar *last_line;
+    gsize last_line_len = 0;
+    gsize skipped = 0;
+    gsize from = 0;
+    gssize ok_pos;
+    gchar *str = NULL;
+    gboolean numeric = FALSE;
 
     g_return_val_if_fail (parser != NULL, FALSE);
     g_return_val_if_fail (response != NULL, FALSE);
 
     /* Skip NUL bytes if they are found leading the response */
-    while (response->len > 0 && response->str[0] == '\0')
-        g_string_erase (response, 0, 1);
+    while (skipped < response->len && response->str[skipped] == '\0')
+        skipped++;
+    if (skipped > 0)
+        g_string_erase (response, 0, skipped);
 
     if (G_UNLIKELY (!response->len))
         return FALSE;
 
     /* First, apply custom filter if any */
-    if (parser->filter_callback &&
-        !parser->filter_callback (parser,
-                                  parser->filter_user_data,
-                                  response,
-                                  &local_error)) {
-        g_assert (local_error != NULL);
-        mm_dbg ("Got response filtered in serial port: %s", local_error->message);
-        g_propagate_error (error, local_error);
-        response_clean (response);
-        return TRUE;
+    if (parser->filter_callback) {
+        if (!parser->filter_callback (parser,
+                                      parser->filter_user_data,
+                                      response,
+                                      &local_error)) {
+            g_assert (local_error != NULL);
+            mm_dbg ("Got response filtered in serial port: %s", local_error->message);
+            g_propagate_error (error, local_error);
+            response_clean (response);
+            return TRUE;
+        }
+
+        /* The filter may have changed any part of the response, so what was
+         * scanned before can't be trusted any more */
+        if (scanned)
+            *scanned = 0;
     }
 
+    /* Scan lines not yet seen in previous reads */
+    if (scanned && *scanned > skipped + SCAN_BACKOFF)
+        from = *scanned - skipped - SCAN_BACKOFF;
+    scan_lines (response, from, &scan);
+
     /* Then, check for successful responses */
 
     /* Custom successful replies first, if any */
@@ -204,24 +417,18 @@ mm_serial_parser_v1_parse (gpointer data,
     }
 
     if (!found) {
-        found = g_regex_match_full (parser->regex_ok,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-        if (found)
-            remove_matches (parser->regex_ok, response);
+        ok_pos = find_trailing_ok (response);
+        if (ok_pos >= 0) {
+            g_string_truncate (response, ok_pos);
+            found = TRUE;
+        }
     }
 
-    if (!found) {
-        found = g_regex_match_full (parser->regex_connect,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-    }
+    if (!found)
+        found = (scan.connect >= 0);
 
-    if (!found) {
-        found = g_regex_match_full (parser->regex_sms,
-                                    response->str, response->len,
-                                    0, 0, NULL, NULL);
-    }
+    if (!found)
+        found = has_trailing_sms_prompt (response);
 
     if (found) {
         response_clean (response);
@@ -239,124 +446,76 @@ mm_serial_parser_v1_parse (gpointer data,
             str = g_match_info_fetch (match_info, 1);
             g_assert (str);
             local_error = mm_mobile_equipment_error_for_code (atoi (str));
-            goto done;
         }
         g_match_info_free (match_info);
+        if (found)
+            goto done;
     }
 
-    /* Numeric CME errors */
-    found = g_regex_match_full (parser->regex_cme_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_mobile_equipment_error_for_code (atoi (str));
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* Numeric CMS errors */
-    found = g_regex_match_full (parser->regex_cms_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_message_error_for_code (atoi (str));
-        goto done;
-    }
-    g_match_info_free (match_info);
-
-    /* String CME errors */
-    found = g_regex_match_full (parser->regex_cme_error_str,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_mobile_equipment_error_for_string (str);
-        goto done;
-    }
-    g_match_info_free (match_info);
+    last_line = get_last_line (response, &last_line_len);
+    if (last_line) {
+        /* CME errors, numeric first */
+        if (parse_error_line (last_line, last_line_len, "+CME ERROR:", 11, &str, &numeric)) {
+            local_error = (numeric ?
+                           mm_mobile_equipment_error_for_code (atoi (str)) :
+                           mm_mobile_equipment_error_for_string (str));
+            found = TRUE;
+            goto done;
+        }
 
-    /* String CMS errors */
-    found = g_regex_match_full (parser->regex_cms_error_str,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_message_error_for_string (str);
-        goto done;
-    }
-    g_match_info_free (match_info);
+        /* CMS errors, numeric first */
+        if (parse_error_line (last_line, last_line_len, "+CMS ERROR:", 11, &str, &numeric)) {
+            local_error = (numeric ?
+                           mm_message_error_for_code (atoi (str)) :
+                           mm_message_error_for_string (str));
+            found = TRUE;
+            goto done;
+        }
 
-    /* Motorola EZX errors */
-    found = g_regex_match_full (parser->regex_ezx_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-        local_error = mm_mobile_equipment_error_for_code (MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
-        goto done;
+        /* Motorola EZX errors */
+        if (parse_error_line (last_line, last_line_len, "MODEM ERROR:", 12, &str, &numeric) && numeric) {
+            local_error = mm_mobile_equipment_error_for_code (MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+            found = TRUE;
+            goto done;
+        }
+        g_clear_pointer (&str, g_free);
     }
-    g_match_info_free (match_info);
 
     /* Last resort; unknown error */
-    found = g_regex_match_full (parser->regex_unknown_error,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
+    if (scan.error >= 0 || str_has_suffix_len (response, "COMMAND NOT SUPPORT\r\n", 21)) {
         local_error = mm_mobile_equipment_error_for_code (MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+        found = TRUE;
         goto done;
     }
-    g_match_info_free (match_info);
 
     /* Connection failures */
-    found = g_regex_match_full (parser->regex_connect_failed,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
-        MMConnectionError code;
-
-        str = g_match_info_fetch (match_info, 1);
-        g_assert (str);
-
-        if (!strcmp (str, "NO CARRIER"))
-            code = MM_CONNECTION_ERROR_NO_CARRIER;
-        else if (!strcmp (str, "BUSY"))
-            code = MM_CONNECTION_ERROR_BUSY;
-        else if (!strcmp (str, "NO ANSWER"))
-            code = MM_CONNECTION_ERROR_NO_ANSWER;
-        else if (!strcmp (str, "NO DIALTONE"))
-            code = MM_CONNECTION_ERROR_NO_DIALTONE;
-        else {
-            /* uhm... make something up (yes, ok, lie!). */
-            code = MM_CONNECTION_ERROR_NO_CARRIER;
-        }
-
-        local_error = mm_connection_error_for_code (code);
+    if (scan.connect_failed >= 0) {
+        local_error = mm_connection_error_for_code (scan.connect_failed_code);
+        found = TRUE;
+        goto done;
+    }
+    if (str_has_suffix_len (response, "NO DIALTONE\r\n", 13)) {
+        local_error = mm_connection_error_for_code (MM_CONNECTION_ERROR_NO_DIALTONE);
+        found = TRUE;
         goto done;
     }
-    g_match_info_free (match_info);
 
     /* NA error */
-    found = g_regex_match_full (parser->regex_na,
-                                response->str, response->len,
-                                0, 0, &match_info, NULL);
-    if (found) {
+    if (scan.na >= 0) {
         /* Assume NA means 'Not Allowed' :) */
         local_error = g_error_new (MM_MOBILE_EQUIPMENT_ERROR,
                                    MM_MOBILE_EQUIPMENT_ERROR_NOT_ALLOWED,
                                    "Not Allowed");
+        found = TRUE;
         goto done;
     }
 
+    /* Nothing found; next time keep on scanning where we left */
+    if (scanned)
+        *scanned = scan.resume + skipped;
+
 done:
     g_free (str);
-    g_match_info_free (match_info);
     if (found)
         response_clean (response);
 
@@ -385,18 +544,6 @@ mm_serial_parser_v1_destroy (gpointer data)
 
     g_return_if_fail (parser != NULL);
 
-    g_regex_unref (parser->regex_ok);
-    g_regex_unref (parser->regex_connect);
-    g_regex_unref (parser->regex_sms);
-    g_regex_unref (parser->regex_cme_error);
-    g_regex_unref (parser->regex_cms_error);
-    g_regex_unref (parser->regex_cme_error_str);
-    g_regex_unref (parser->regex_cms_error_str);
-    g_regex_unref (parser->regex_ezx_error);
-    g_regex_unref (parser->regex_unknown_error);
-    g_regex_unref (parser->regex_connect_failed);
-    g_regex_unref (parser->regex_na);
-
     if (parser->regex_custom_successful)
         g_regex_unref (parser->regex_custom_successful);
     if (parser->regex_custom_error)
@@ -22,8 +22,11 @@ gpointer mm_serial_parser_v1_new                  (void);
 void     mm_serial_parser_v1_set_custom_regex     (gpointer data,
                                                    GRegex *successful,
                                                    GRegex *error);
+/* If @scanned is given, it's used to resume scanning the response where the
+ * previous call left it, and updated when no final result is found. */
 gboolean mm_serial_parser_v1_parse                (gpointer parser,
                                                    GString *response,
+                                                   gsize *scanned,
                                                    GError **error);
 void     mm_serial_parser_v1_destroy              (gpointer parser);
 gboolean mm_serial_parser_v1_is_known_error       (const GError *error);
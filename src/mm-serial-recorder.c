@@ -0,0 +1,229 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-serial-recorder.h"
+#include "mm-log.h"
+
+#define SENT_TAG     "-->"
+#define RECEIVED_TAG "<--"
+
+static gchar *directory;
+
+void
+mm_serial_recorder_set_directory (const gchar *path)
+{
+    g_free (directory);
+    directory = g_strdup (path);
+}
+
+const gchar *
+mm_serial_recorder_get_directory (void)
+{
+    return directory;
+}
+
+/*****************************************************************************/
+
+struct _MMSerialRecorder {
+    FILE    *file;
+    gint64   start;
+    GString *line;
+};
+
+MMSerialRecorder *
+mm_serial_recorder_new (const gchar *port_name)
+{
+    MMSerialRecorder *self;
+    GDateTime        *now;
+    gchar            *basename;
+    gchar            *safe_name;
+    gchar            *path;
+    gchar            *timestamp;
+    FILE             *file;
+
+    if (!directory)
+        return NULL;
+
+    now = g_date_time_new_now_local ();
+    timestamp = g_date_time_format (now, "%Y%m%d-%H%M%S");
+    /* Port names of non-tty subsystems may have path separators */
+    safe_name = g_strdelimit (g_strdup (port_name), G_DIR_SEPARATOR_S, '_');
+    basename = g_strdup_printf ("%s-%s.trace", safe_name, timestamp);
+    path = g_build_filename (directory, basename, NULL);
+    g_date_time_unref (now);
+    g_free (safe_name);
+    g_free (timestamp);
+    g_free (basename);
+
+    file = fopen (path, "a");
+    if (!file) {
+        mm_warn ("(%s) couldn't create serial capture file '%s': %s",
+                 port_name, path, g_strerror (errno));
+        g_free (path);
+        return NULL;
+    }
+    mm_dbg ("(%s) recording serial traffic in '%s'", port_name, path);
+    g_free (path);
+
+    self = g_slice_new0 (MMSerialRecorder);
+    self->file = file;
+    self->start = g_get_monotonic_time ();
+    self->line = g_string_sized_new (256);
+    fprintf (self->file, "# ModemManager serial capture: %s\n", port_name);
+    fflush (self->file);
+    return self;
+}
+
+void
+mm_serial_recorder_free (MMSerialRecorder *self)
+{
+    if (!self)
+        return;
+
+    fclose (self->file);
+    g_string_free (self->line, TRUE);
+    g_slice_free (MMSerialRecorder, self);
+}
+
+void
+mm_serial_recorder_write (MMSerialRecorder        *self,
+                          MMSerialRecordDirection  direction,
+                          const guint8            *data,
+                          gsize                    len)
+{
+    static const gchar hex[] = "0123456789abcdef";
+    gsize              i;
+
+    if (!len)
+        return;
+
+    g_string_printf (self->line, "%" G_GINT64_FORMAT " %s ",
+                     g_get_monotonic_time () - self->start,
+                     direction == MM_SERIAL_RECORD_DIRECTION_SENT ? SENT_TAG : RECEIVED_TAG);
+    for (i = 0; i < len; i++) {
+        g_string_append_c (self->line, hex[data[i] >> 4]);
+        g_string_append_c (self->line, hex[data[i] & 0x0f]);
+    }
+    g_string_append_c (self->line, '\n');
+
+    fwrite (self->line->str, 1, self->line->len, self->file);
+    fflush (self->file);
+}
+
+/*****************************************************************************/
+
+static void
+record_free (MMSerialRecord *record)
+{
+    g_byte_array_unref (record->data);
+    g_slice_free (MMSerialRecord, record);
+}
+
+static MMSerialRecord *
+record_parse (const gchar  *line,
+              GError      **error)
+{
+    MMSerialRecord *record;
+    gchar          *end = NULL;
+    gint64          timestamp;
+    MMSerialRecordDirection direction;
+    GByteArray     *data;
+
+    timestamp = g_ascii_strtoll (line, &end, 10);
+    if (end == line || *end != ' ') {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS, "Invalid timestamp");
+        return NULL;
+    }
+    line = end + 1;
+
+    if (g_str_has_prefix (line, SENT_TAG " "))
+        direction = MM_SERIAL_RECORD_DIRECTION_SENT;
+    else if (g_str_has_prefix (line, RECEIVED_TAG " "))
+        direction = MM_SERIAL_RECORD_DIRECTION_RECEIVED;
+    else {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS, "Invalid direction");
+        return NULL;
+    }
+    line += strlen (SENT_TAG " ");
+
+    data = g_byte_array_sized_new (strlen (line) / 2);
+    while (line[0] && line[0] != '\r' && line[0] != '\n') {
+        gint high;
+        gint low;
+        guint8 byte;
+
+        high = g_ascii_xdigit_value (line[0]);
+        low = (high >= 0 ? g_ascii_xdigit_value (line[1]) : -1);
+        if (high < 0 || low < 0) {
+            g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS, "Invalid hex data");
+            g_byte_array_unref (data);
+            return NULL;
+        }
+        byte = (guint8) ((high << 4) | low);
+        g_byte_array_append (data, &byte, 1);
+        line += 2;
+    }
+
+    record = g_slice_new (MMSerialRecord);
+    record->timestamp = timestamp;
+    record->direction = direction;
+    record->data = data;
+    return record;
+}
+
+GPtrArray *
+mm_serial_recorder_load (const gchar  *path,
+                         GError      **error)
+{
+    GPtrArray *records;
+    gchar     *contents = NULL;
+    gchar    **lines;
+    guint      i;
+
+    if (!g_file_get_contents (path, &contents, NULL, error))
+        return NULL;
+
+    records = g_ptr_array_new_with_free_func ((GDestroyNotify) record_free);
+    lines = g_strsplit (contents, "\n", -1);
+    g_free (contents);
+
+    for (i = 0; lines[i]; i++) {
+        MMSerialRecord *record;
+        GError         *inner_error = NULL;
+
+        /* Skip comments and empty lines */
+        if (!lines[i][0] || lines[i][0] == '#')
+            continue;
+
+        record = record_parse (lines[i], &inner_error);
+        if (!record) {
+            g_propagate_prefixed_error (error, inner_error, "Line %u: ", i + 1);
+            g_ptr_array_unref (records);
+            records = NULL;
+            break;
+        }
+        g_ptr_array_add (records, record);
+    }
+
+    g_strfreev (lines);
+    return records;
+}
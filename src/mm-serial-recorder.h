@@ -0,0 +1,60 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SERIAL_RECORDER_H
+#define MM_SERIAL_RECORDER_H
+
+#include <glib.h>
+
+/*
+ * Capture of the raw traffic of a serial port.
+ *
+ * Captures are text files, with one record per line: the timestamp in
+ * microseconds since the capture was started, the direction ("-->" for data
+ * sent to the device, "<--" for data received), and the raw bytes in hex.
+ * Lines starting with '#' are comments.
+ */
+
+typedef enum {
+    MM_SERIAL_RECORD_DIRECTION_SENT,
+    MM_SERIAL_RECORD_DIRECTION_RECEIVED,
+} MMSerialRecordDirection;
+
+typedef struct {
+    gint64                  timestamp;
+    MMSerialRecordDirection direction;
+    GByteArray             *data;
+} MMSerialRecord;
+
+/* Directory where ports store their captures; if unset, nothing is recorded */
+void         mm_serial_recorder_set_directory (const gchar *path);
+const gchar *mm_serial_recorder_get_directory (void);
+
+typedef struct _MMSerialRecorder MMSerialRecorder;
+
+/* Returns NULL if no capture directory is set or if the capture file cannot
+ * be created */
+MMSerialRecorder *mm_serial_recorder_new   (const gchar *port_name);
+void              mm_serial_recorder_free  (MMSerialRecorder *self);
+void              mm_serial_recorder_write (MMSerialRecorder        *self,
+                                            MMSerialRecordDirection  direction,
+                                            const guint8            *data,
+                                            gsize                    len);
+
+/* Load all the records of a capture file, as an array of MMSerialRecord */
+GPtrArray *mm_serial_recorder_load (const gchar  *path,
+                                    GError      **error);
+
+#endif /* MM_SERIAL_RECORDER_H */
@@ -0,0 +1,471 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-serial-reply-cache.h"
+#include "mm-clock.h"
+
+typedef struct {
+    gchar    *command_prefix;
+    gsize     command_prefix_len;
+    guint     ttl_ms;
+    gboolean  always_cacheable;
+} CommandClass;
+
+typedef struct {
+    gchar *unsolicited_prefix;
+    gsize  unsolicited_prefix_len;
+    gchar *command_prefix;
+    gsize  command_prefix_len;
+} Invalidation;
+
+typedef struct {
+    GByteArray *command;
+    GByteArray *response;
+    /* Monotonic time when the entry expires, 0 if never */
+    gint64      expires;
+    /* Link in the LRU queue, data points to the entry itself */
+    GList       link;
+} Entry;
+
+struct _MMSerialReplyCache {
+    /* Command -> Entry */
+    GHashTable *entries;
+    /* Most recently used entries at the head */
+    GQueue      lru;
+    guint       max_entries;
+    /* Bytes of commands and replies, 0 if unbounded */
+    gsize       max_size;
+    /* Bytes of commands and replies currently stored */
+    gsize       size;
+    guint       default_ttl_ms;
+    GArray     *classes;
+    GArray     *invalidations;
+    guint64     hits;
+    guint64     misses;
+    MMSerialReplyCacheTimeFn time_fn;
+};
+
+/*****************************************************************************/
+
+static gboolean
+ba_equal (gconstpointer v1,
+          gconstpointer v2)
+{
+    const GByteArray *a = v1;
+    const GByteArray *b = v2;
+
+    return (a->len == b->len && !memcmp (a->data, b->data, a->len));
+}
+
+static guint
+ba_hash (gconstpointer v)
+{
+    /* 31 bit hash function */
+    const GByteArray *array = v;
+    guint32 i, h = 0;
+
+    for (i = 0; i < array->len; i++)
+        h = (h << 5) - h + (const signed char) array->data[i];
+
+    return h;
+}
+
+static gboolean
+ba_has_prefix (const GByteArray *array,
+               const gchar      *prefix,
+               gsize             prefix_len)
+{
+    return (array->len >= prefix_len && !memcmp (array->data, prefix, prefix_len));
+}
+
+static void
+entry_free (Entry *entry)
+{
+    g_byte_array_unref (entry->command);
+    g_byte_array_unref (entry->response);
+    g_slice_free (Entry, entry);
+}
+
+static void
+command_class_clear (CommandClass *command_class)
+{
+    g_free (command_class->command_prefix);
+}
+
+static void
+invalidation_clear (Invalidation *invalidation)
+{
+    g_free (invalidation->unsolicited_prefix);
+    g_free (invalidation->command_prefix);
+}
+
+/*****************************************************************************/
+
+MMSerialReplyCache *
+mm_serial_reply_cache_new (guint max_entries,
+                           guint default_ttl_ms)
+{
+    MMSerialReplyCache *self;
+
+    self = g_slice_new0 (MMSerialReplyCache);
+    self->entries = g_hash_table_new_full (ba_hash, ba_equal, NULL, (GDestroyNotify) entry_free);
+    g_queue_init (&self->lru);
+    self->max_entries = max_entries;
+    self->default_ttl_ms = default_ttl_ms;
+    self->classes = g_array_new (FALSE, FALSE, sizeof (CommandClass));
+    g_array_set_clear_func (self->classes, (GDestroyNotify) command_class_clear);
+    self->invalidations = g_array_new (FALSE, FALSE, sizeof (Invalidation));
+    g_array_set_clear_func (self->invalidations, (GDestroyNotify) invalidation_clear);
+    self->time_fn = mm_clock_get_time;
+    return self;
+}
+
+void
+mm_serial_reply_cache_free (MMSerialReplyCache *self)
+{
+    if (!self)
+        return;
+
+    g_hash_table_destroy (self->entries);
+    g_array_unref (self->classes);
+    g_array_unref (self->invalidations);
+    g_slice_free (MMSerialReplyCache, self);
+}
+
+void
+mm_serial_reply_cache_set_time_func (MMSerialReplyCache       *self,
+                                     MMSerialReplyCacheTimeFn  time_fn)
+{
+    self->time_fn = (time_fn ? time_fn : mm_clock_get_time);
+}
+
+/*****************************************************************************/
+
+static void
+entry_remove (MMSerialReplyCache *self,
+              Entry              *entry)
+{
+    g_queue_unlink (&self->lru, &entry->link);
+    self->size -= entry->command->len + entry->response->len;
+    /* Entry freed */
+    g_hash_table_remove (self->entries, entry->command);
+}
+
+static void
+evict_overflow (MMSerialReplyCache *self)
+{
+    if (self->max_entries) {
+        while (g_queue_get_length (&self->lru) > self->max_entries)
+            entry_remove (self, (Entry *) g_queue_peek_tail (&self->lru));
+    }
+
+    if (self->max_size) {
+        while (!g_queue_is_empty (&self->lru) && self->size > self->max_size)
+            entry_remove (self, (Entry *) g_queue_peek_tail (&self->lru));
+    }
+}
+
+void
+mm_serial_reply_cache_set_max_entries (MMSerialReplyCache *self,
+                                       guint               max_entries)
+{
+    self->max_entries = max_entries;
+    evict_overflow (self);
+}
+
+guint
+mm_serial_reply_cache_get_max_entries (MMSerialReplyCache *self)
+{
+    return self->max_entries;
+}
+
+void
+mm_serial_reply_cache_set_max_size (MMSerialReplyCache *self,
+                                    gsize               max_size)
+{
+    self->max_size = max_size;
+    evict_overflow (self);
+}
+
+gsize
+mm_serial_reply_cache_get_max_size (MMSerialReplyCache *self)
+{
+    return self->max_size;
+}
+
+void
+mm_serial_reply_cache_set_default_ttl (MMSerialReplyCache *self,
+                                       guint               ttl_ms)
+{
+    self->default_ttl_ms = ttl_ms;
+}
+
+guint
+mm_serial_reply_cache_get_default_ttl (MMSerialReplyCache *self)
+{
+    return self->default_ttl_ms;
+}
+
+/*****************************************************************************/
+
+static const CommandClass *
+command_class_lookup (MMSerialReplyCache *self,
+                      const GByteArray   *command)
+{
+    const CommandClass *found = NULL;
+    guint               i;
+
+    /* Longest matching prefix wins */
+    for (i = 0; i < self->classes->len; i++) {
+        const CommandClass *command_class;
+
+        command_class = &g_array_index (self->classes, CommandClass, i);
+        if ((!found || command_class->command_prefix_len > found->command_prefix_len) &&
+            ba_has_prefix (command, command_class->command_prefix, command_class->command_prefix_len))
+            found = command_class;
+    }
+
+    return found;
+}
+
+void
+mm_serial_reply_cache_add_class (MMSerialReplyCache *self,
+                                 const gchar        *command_prefix,
+                                 guint               ttl_ms,
+                                 gboolean            always_cacheable)
+{
+    CommandClass command_class;
+    guint        i;
+
+    g_return_if_fail (command_prefix && command_prefix[0]);
+
+    /* Update if already there */
+    for (i = 0; i < self->classes->len; i++) {
+        CommandClass *existing;
+
+        existing = &g_array_index (self->classes, CommandClass, i);
+        if (g_str_equal (existing->command_prefix, command_prefix)) {
+            existing->ttl_ms = ttl_ms;
+            existing->always_cacheable = always_cacheable;
+            return;
+        }
+    }
+
+    command_class.command_prefix = g_strdup (command_prefix);
+    command_class.command_prefix_len = strlen (command_prefix);
+    command_class.ttl_ms = ttl_ms;
+    command_class.always_cacheable = always_cacheable;
+    g_array_append_val (self->classes, command_class);
+}
+
+gboolean
+mm_serial_reply_cache_is_always_cacheable (MMSerialReplyCache *self,
+                                           const GByteArray   *command)
+{
+    const CommandClass *command_class;
+
+    command_class = command_class_lookup (self, command);
+    return (command_class && command_class->always_cacheable);
+}
+
+/*****************************************************************************/
+
+void
+mm_serial_reply_cache_add_invalidation (MMSerialReplyCache *self,
+                                        const gchar        *unsolicited_prefix,
+                                        const gchar        *command_prefix)
+{
+    Invalidation invalidation;
+
+    g_return_if_fail (unsolicited_prefix && unsolicited_prefix[0]);
+    g_return_if_fail (command_prefix && command_prefix[0]);
+
+    invalidation.unsolicited_prefix = g_strdup (unsolicited_prefix);
+    invalidation.unsolicited_prefix_len = strlen (unsolicited_prefix);
+    invalidation.command_prefix = g_strdup (command_prefix);
+    invalidation.command_prefix_len = strlen (command_prefix);
+    g_array_append_val (self->invalidations, invalidation);
+}
+
+void
+mm_serial_reply_cache_invalidate (MMSerialReplyCache *self,
+                                  const guint8       *unsolicited,
+                                  gsize               len)
+{
+    guint i;
+
+    if (!g_hash_table_size (self->entries))
+        return;
+
+    while (len > 0 && (*unsolicited == '\r' || *unsolicited == '\n')) {
+        unsolicited++;
+        len--;
+    }
+
+    for (i = 0; i < self->invalidations->len; i++) {
+        const Invalidation *invalidation;
+        GList              *l;
+
+        invalidation = &g_array_index (self->invalidations, Invalidation, i);
+        if (len < invalidation->unsolicited_prefix_len ||
+            memcmp (unsolicited, invalidation->unsolicited_prefix, invalidation->unsolicited_prefix_len) != 0)
+            continue;
+
+        for (l = self->lru.head; l; ) {
+            Entry *entry = l->data;
+
+            l = l->next;
+            if (ba_has_prefix (entry->command, invalidation->command_prefix, invalidation->command_prefix_len))
+                entry_remove (self, entry);
+        }
+    }
+}
+
+/*****************************************************************************/
+
+void
+mm_serial_reply_cache_insert (MMSerialReplyCache *self,
+                              const GByteArray   *command,
+                              const GByteArray   *response)
+{
+    const CommandClass *command_class;
+    Entry              *entry;
+    guint               ttl_ms;
+
+    g_return_if_fail (command != NULL);
+    g_return_if_fail (response != NULL);
+
+    /* Would evict everything else, and then itself */
+    if (self->max_size && command->len + response->len > self->max_size) {
+        mm_serial_reply_cache_remove (self, command);
+        return;
+    }
+
+    entry = g_hash_table_lookup (self->entries, command);
+    if (entry) {
+        /* Reuse the entry, just replace the response */
+        self->size -= entry->response->len;
+        g_byte_array_unref (entry->response);
+        g_queue_unlink (&self->lru, &entry->link);
+    } else {
+        entry = g_slice_new0 (Entry);
+        entry->command = g_byte_array_sized_new (command->len);
+        g_byte_array_append (entry->command, command->data, command->len);
+        entry->link.data = entry;
+        g_hash_table_insert (self->entries, entry->command, entry);
+        self->size += entry->command->len;
+    }
+
+    entry->response = g_byte_array_sized_new (response->len);
+    g_byte_array_append (entry->response, response->data, response->len);
+    self->size += entry->response->len;
+
+    command_class = command_class_lookup (self, command);
+    ttl_ms = (command_class ? command_class->ttl_ms : self->default_ttl_ms);
+    entry->expires = (ttl_ms != MM_SERIAL_REPLY_CACHE_TTL_INFINITE ?
+                      self->time_fn () + ((gint64) ttl_ms * 1000) :
+                      0);
+
+    g_queue_push_head_link (&self->lru, &entry->link);
+    evict_overflow (self);
+}
+
+const GByteArray *
+mm_serial_reply_cache_lookup (MMSerialReplyCache *self,
+                              const GByteArray   *command)
+{
+    Entry *entry;
+
+    entry = g_hash_table_lookup (self->entries, command);
+    if (entry && entry->expires && self->time_fn () >= entry->expires) {
+        entry_remove (self, entry);
+        entry = NULL;
+    }
+
+    if (!entry) {
+        self->misses++;
+        return NULL;
+    }
+
+    self->hits++;
+
+    /* Move to the head of the LRU queue */
+    if (self->lru.head != &entry->link) {
+        g_queue_unlink (&self->lru, &entry->link);
+        g_queue_push_head_link (&self->lru, &entry->link);
+    }
+
+    return entry->response;
+}
+
+const GByteArray *
+mm_serial_reply_cache_peek (MMSerialReplyCache *self,
+                            const GByteArray   *command)
+{
+    Entry *entry;
+
+    entry = g_hash_table_lookup (self->entries, command);
+    if (!entry || (entry->expires && self->time_fn () >= entry->expires))
+        return NULL;
+
+    return entry->response;
+}
+
+void
+mm_serial_reply_cache_remove (MMSerialReplyCache *self,
+                              const GByteArray   *command)
+{
+    Entry *entry;
+
+    entry = g_hash_table_lookup (self->entries, command);
+    if (entry)
+        entry_remove (self, entry);
+}
+
+void
+mm_serial_reply_cache_clear (MMSerialReplyCache *self)
+{
+    g_queue_init (&self->lru);
+    g_hash_table_remove_all (self->entries);
+    self->size = 0;
+}
+
+/*****************************************************************************/
+
+guint
+mm_serial_reply_cache_get_length (MMSerialReplyCache *self)
+{
+    return g_hash_table_size (self->entries);
+}
+
+gsize
+mm_serial_reply_cache_get_size (MMSerialReplyCache *self)
+{
+    return self->size;
+}
+
+guint64
+mm_serial_reply_cache_get_hits (MMSerialReplyCache *self)
+{
+    return self->hits;
+}
+
+guint64
+mm_serial_reply_cache_get_misses (MMSerialReplyCache *self)
+{
+    return self->misses;
+}
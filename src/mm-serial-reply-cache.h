@@ -0,0 +1,99 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SERIAL_REPLY_CACHE_H
+#define MM_SERIAL_REPLY_CACHE_H
+
+#include <glib.h>
+
+/*
+ * Cache of command replies used by serial ports.
+ *
+ * Entries are keyed by the full command as sent to the device. The cache is
+ * bounded in entries (and optionally in bytes), and when full the least
+ * recently used entry is evicted.
+ *
+ * Commands may be grouped in classes, given by a command prefix (e.g.
+ * "AT+CGMI"). Each class has its own time to live for the entries, and may
+ * also be flagged as always cacheable, meaning that replies to those commands
+ * are stored and reused even if the caller didn't explicitly allow cached
+ * replies. Commands not in any class use the default time to live.
+ *
+ * Entries may also be invalidated when unsolicited messages are received,
+ * e.g. a "+CREG" indication invalidating any cached "AT+COPS?" reply.
+ */
+typedef struct _MMSerialReplyCache MMSerialReplyCache;
+
+/* TTL value meaning that entries never expire */
+#define MM_SERIAL_REPLY_CACHE_TTL_INFINITE 0
+
+MMSerialReplyCache *mm_serial_reply_cache_new   (guint max_entries,
+                                                 guint default_ttl_ms);
+void                mm_serial_reply_cache_free  (MMSerialReplyCache *self);
+
+void  mm_serial_reply_cache_set_max_entries (MMSerialReplyCache *self,
+                                             guint               max_entries);
+guint mm_serial_reply_cache_get_max_entries (MMSerialReplyCache *self);
+
+/* Bytes of commands and replies; 0 for no limit, the default. Replies larger
+ * than the limit are not cached. */
+void  mm_serial_reply_cache_set_max_size (MMSerialReplyCache *self,
+                                          gsize               max_size);
+gsize mm_serial_reply_cache_get_max_size (MMSerialReplyCache *self);
+
+void  mm_serial_reply_cache_set_default_ttl (MMSerialReplyCache *self,
+                                             guint               ttl_ms);
+guint mm_serial_reply_cache_get_default_ttl (MMSerialReplyCache *self);
+
+void     mm_serial_reply_cache_add_class        (MMSerialReplyCache *self,
+                                                 const gchar        *command_prefix,
+                                                 guint               ttl_ms,
+                                                 gboolean            always_cacheable);
+gboolean mm_serial_reply_cache_is_always_cacheable (MMSerialReplyCache *self,
+                                                    const GByteArray   *command);
+
+void     mm_serial_reply_cache_add_invalidation (MMSerialReplyCache *self,
+                                                 const gchar        *unsolicited_prefix,
+                                                 const gchar        *command_prefix);
+/* Invalidate the entries affected by the given unsolicited message; leading
+ * CR/LF characters in the message are ignored. */
+void     mm_serial_reply_cache_invalidate       (MMSerialReplyCache *self,
+                                                 const guint8       *unsolicited,
+                                                 gsize               len);
+
+void              mm_serial_reply_cache_insert (MMSerialReplyCache *self,
+                                                const GByteArray   *command,
+                                                const GByteArray   *response);
+const GByteArray *mm_serial_reply_cache_lookup (MMSerialReplyCache *self,
+                                                const GByteArray   *command);
+/* Like lookup(), but without updating the LRU order nor the statistics */
+const GByteArray *mm_serial_reply_cache_peek   (MMSerialReplyCache *self,
+                                                const GByteArray   *command);
+void              mm_serial_reply_cache_remove (MMSerialReplyCache *self,
+                                                const GByteArray   *command);
+void              mm_serial_reply_cache_clear  (MMSerialReplyCache *self);
+
+guint   mm_serial_reply_cache_get_length (MMSerialReplyCache *self);
+/* Bytes of the commands and replies stored */
+gsize   mm_serial_reply_cache_get_size   (MMSerialReplyCache *self);
+guint64 mm_serial_reply_cache_get_hits   (MMSerialReplyCache *self);
+guint64 mm_serial_reply_cache_get_misses (MMSerialReplyCache *self);
+
+/* Just for unit tests: override the time source, in microseconds */
+typedef gint64 (* MMSerialReplyCacheTimeFn) (void);
+void mm_serial_reply_cache_set_time_func (MMSerialReplyCache       *self,
+                                          MMSerialReplyCacheTimeFn  time_fn);
+
+#endif /* MM_SERIAL_REPLY_CACHE_H */
@@ -0,0 +1,209 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-serial-stats.h"
+
+/* Upper limits of the histogram buckets, in ms; one more bucket without
+ * upper limit follows */
+static const guint32 bucket_limits[] = { 10, 50, 100, 250, 500, 1000, 2500, 5000, 10000 };
+#define N_BUCKETS (G_N_ELEMENTS (bucket_limits) + 1)
+
+/* Longest command prefix recorded */
+#define MAX_PREFIX_LEN 16
+
+typedef struct {
+    guint32 count;
+    guint32 timeouts;
+    guint32 queue_wait[N_BUCKETS];
+    guint32 first_byte[N_BUCKETS];
+    guint32 response[N_BUCKETS];
+} CommandStats;
+
+struct _MMSerialStats {
+    /* Prefix -> CommandStats */
+    GHashTable *commands;
+};
+
+MMSerialStats *
+mm_serial_stats_new (void)
+{
+    MMSerialStats *self;
+
+    self = g_slice_new0 (MMSerialStats);
+    self->commands = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    return self;
+}
+
+void
+mm_serial_stats_free (MMSerialStats *self)
+{
+    if (!self)
+        return;
+
+    g_hash_table_destroy (self->commands);
+    g_slice_free (MMSerialStats, self);
+}
+
+void
+mm_serial_stats_reset (MMSerialStats *self)
+{
+    g_hash_table_remove_all (self->commands);
+}
+
+/*****************************************************************************/
+
+gchar *
+mm_serial_stats_command_prefix (const GByteArray *command)
+{
+    guint i;
+
+    if (!command->len)
+        return g_strdup ("");
+
+    /* Binary commands (e.g. QCDM) are grouped by their first byte */
+    if (!g_ascii_isprint (command->data[0]))
+        return g_strdup_printf ("0x%02x", command->data[0]);
+
+    /* Text commands up to the first argument or delimiter */
+    for (i = 0; i < command->len && i < MAX_PREFIX_LEN; i++) {
+        guint8 c = command->data[i];
+
+        if (!g_ascii_isprint (c) || c == '=' || c == '?' || c == ';' || c == ' ')
+            break;
+    }
+
+    return g_ascii_strup ((const gchar *) command->data, i);
+}
+
+static void
+histogram_add (guint32 *histogram,
+               gint64   value)
+{
+    guint32 value_ms;
+    guint   i;
+
+    if (value < 0)
+        return;
+
+    value_ms = (guint32) MIN (value / 1000, (gint64) G_MAXUINT32);
+    for (i = 0; i < G_N_ELEMENTS (bucket_limits); i++) {
+        if (value_ms <= bucket_limits[i])
+            break;
+    }
+    histogram[i]++;
+}
+
+void
+mm_serial_stats_record (MMSerialStats    *self,
+                        const GByteArray *command,
+                        gint64            queue_wait,
+                        gint64            first_byte,
+                        gint64            response,
+                        gboolean          timed_out)
+{
+    CommandStats *stats;
+    gchar        *prefix;
+
+    prefix = mm_serial_stats_command_prefix (command);
+    stats = g_hash_table_lookup (self->commands, prefix);
+    if (!stats) {
+        stats = g_new0 (CommandStats, 1);
+        g_hash_table_insert (self->commands, prefix, stats);
+    } else
+        g_free (prefix);
+
+    stats->count++;
+    if (timed_out)
+        stats->timeouts++;
+    histogram_add (stats->queue_wait, queue_wait);
+    histogram_add (stats->first_byte, first_byte);
+    histogram_add (stats->response, response);
+}
+
+gboolean
+mm_serial_stats_get_response_percentile (MMSerialStats    *self,
+                                         const GByteArray *command,
+                                         guint             percentile,
+                                         guint32           min_samples,
+                                         guint32          *value_ms)
+{
+    CommandStats *stats;
+    gchar        *prefix;
+    guint64       total = 0;
+    guint64       accumulated = 0;
+    guint         i;
+
+    g_return_val_if_fail (percentile <= 100, FALSE);
+
+    prefix = mm_serial_stats_command_prefix (command);
+    stats = g_hash_table_lookup (self->commands, prefix);
+    g_free (prefix);
+    if (!stats)
+        return FALSE;
+
+    for (i = 0; i < N_BUCKETS; i++)
+        total += stats->response[i];
+    if (!total || total < min_samples)
+        return FALSE;
+
+    for (i = 0; i < G_N_ELEMENTS (bucket_limits); i++) {
+        accumulated += stats->response[i];
+        if (accumulated * 100 >= total * percentile) {
+            *value_ms = bucket_limits[i];
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+/*****************************************************************************/
+
+static GVariant *
+histogram_build (const guint32 *histogram)
+{
+    return g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32, histogram, N_BUCKETS, sizeof (guint32));
+}
+
+void
+mm_serial_stats_build (MMSerialStats   *self,
+                       const gchar     *port_name,
+                       GVariantBuilder *builder)
+{
+    GHashTableIter iter;
+    gpointer       key;
+    gpointer       value;
+
+    g_hash_table_iter_init (&iter, self->commands);
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        const CommandStats *stats = value;
+        GVariantBuilder     dict;
+
+        g_variant_builder_init (&dict, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&dict, "{sv}", "port", g_variant_new_string (port_name));
+        g_variant_builder_add (&dict, "{sv}", "prefix", g_variant_new_string ((const gchar *) key));
+        g_variant_builder_add (&dict, "{sv}", "count", g_variant_new_uint32 (stats->count));
+        g_variant_builder_add (&dict, "{sv}", "timeouts", g_variant_new_uint32 (stats->timeouts));
+        g_variant_builder_add (&dict, "{sv}", "bucket-limits",
+                               g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                          bucket_limits,
+                                                          G_N_ELEMENTS (bucket_limits),
+                                                          sizeof (guint32)));
+        g_variant_builder_add (&dict, "{sv}", "queue-wait", histogram_build (stats->queue_wait));
+        g_variant_builder_add (&dict, "{sv}", "first-byte", histogram_build (stats->first_byte));
+        g_variant_builder_add (&dict, "{sv}", "response", histogram_build (stats->response));
+        g_variant_builder_add_value (builder, g_variant_builder_end (&dict));
+    }
+}
@@ -0,0 +1,72 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SERIAL_STATS_H
+#define MM_SERIAL_STATS_H
+
+#include <glib.h>
+
+/*
+ * Command statistics of serial ports, grouped by command prefix (e.g.
+ * "AT+CGDCONT" for "AT+CGDCONT=1,\"IP\",\"internet\"").
+ *
+ * For each command prefix, latencies are kept as histograms with fixed
+ * bucket limits (in milliseconds):
+ *  - queue wait: since the command was queued until its write started.
+ *  - first byte: since the write started until the first byte was received.
+ *  - response: since the write started until the final result was received.
+ */
+typedef struct _MMSerialStats MMSerialStats;
+
+MMSerialStats *mm_serial_stats_new   (void);
+void           mm_serial_stats_free  (MMSerialStats *self);
+void           mm_serial_stats_reset (MMSerialStats *self);
+
+/* Latencies in microseconds; negative values are not recorded */
+void mm_serial_stats_record (MMSerialStats    *self,
+                             const GByteArray *command,
+                             gint64            queue_wait,
+                             gint64            first_byte,
+                             gint64            response,
+                             gboolean          timed_out);
+
+/* Estimates the given percentile (0-100) of the response latency of the
+ * commands with the same prefix as @command, in ms, rounded up to the upper
+ * limit of its histogram bucket. Returns FALSE if fewer than @min_samples
+ * were recorded, or if the percentile falls in the last bucket. */
+gboolean mm_serial_stats_get_response_percentile (MMSerialStats    *self,
+                                                  const GByteArray *command,
+                                                  guint             percentile,
+                                                  guint32           min_samples,
+                                                  guint32          *value_ms);
+
+/* Appends one a{sv} dictionary per command prefix to the given aa{sv}
+ * builder, with the following keys:
+ *  - "port" (s): the given port name.
+ *  - "prefix" (s): the command prefix.
+ *  - "count" (u): number of commands sent.
+ *  - "timeouts" (u): number of commands timed out.
+ *  - "bucket-limits" (au): upper limits of the histogram buckets, in ms;
+ *    the last bucket has no upper limit.
+ *  - "queue-wait", "first-byte", "response" (au): histograms.
+ */
+void mm_serial_stats_build (MMSerialStats   *self,
+                            const gchar     *port_name,
+                            GVariantBuilder *builder);
+
+/* Command name under which the stats are accounted, e.g. "AT+CSQ" */
+gchar *mm_serial_stats_command_prefix (const GByteArray *command);
+
+#endif /* MM_SERIAL_STATS_H */
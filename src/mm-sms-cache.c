@@ -0,0 +1,257 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
+
+#include "mm-sms-cache.h"
+#include "mm-modem-helpers.h"
+#include "mm-context.h"
+#include "mm-log.h"
+
+/* Each storage is a group, with the number of parts and one
+ * "<index>=<status>,<pdu>" key per part */
+#define KEY_N_PARTS "parts"
+
+struct _MMSmsCache {
+    gchar    *path;
+    GKeyFile *keyfile;
+};
+
+/*****************************************************************************/
+
+static void
+save_cache (MMSmsCache *self)
+{
+    gchar *data;
+    gsize len;
+    GError *error = NULL;
+
+    data = g_key_file_to_data (self->keyfile, &len, NULL);
+    if (!g_file_set_contents (self->path, data, len, &error)) {
+        mm_warn ("Couldn't write SMS cache '%s': %s", self->path, error->message);
+        g_error_free (error);
+    }
+    g_free (data);
+}
+
+static void
+update_n_parts (MMSmsCache  *self,
+                const gchar *group,
+                gint         delta)
+{
+    gint n_parts;
+
+    n_parts = g_key_file_get_integer (self->keyfile, group, KEY_N_PARTS, NULL);
+    g_key_file_set_integer (self->keyfile, group, KEY_N_PARTS, MAX (n_parts + delta, 0));
+}
+
+static void
+set_part (MMSmsCache  *self,
+          const gchar *group,
+          guint        index,
+          guint        status,
+          const gchar *pdu)
+{
+    gchar key[16];
+    gchar *value;
+
+    g_snprintf (key, sizeof (key), "%u", index);
+    if (!g_key_file_has_key (self->keyfile, group, key, NULL))
+        update_n_parts (self, group, 1);
+
+    value = g_strdup_printf ("%u,%s", status, pdu);
+    g_key_file_set_string (self->keyfile, group, key, value);
+    g_free (value);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_sms_cache_lookup (MMSmsCache    *self,
+                     MMSmsStorage   storage,
+                     guint          n_parts,
+                     GList        **out_info_list)
+{
+    const gchar *group;
+    gchar **keys;
+    gsize n_keys = 0;
+    GList *list = NULL;
+    gint cached;
+    guint i;
+
+    group = mm_sms_storage_get_string (storage);
+    if (!g_key_file_has_group (self->keyfile, group))
+        return FALSE;
+
+    cached = g_key_file_get_integer (self->keyfile, group, KEY_N_PARTS, NULL);
+    keys = g_key_file_get_keys (self->keyfile, group, &n_keys, NULL);
+    if (cached < 0 || (guint) cached != n_parts || n_keys != (gsize) cached + 1) {
+        mm_dbg ("Not using SMS cache for storage '%s': %u parts found, %d cached",
+                group, n_parts, cached);
+        g_strfreev (keys);
+        return FALSE;
+    }
+
+    for (i = 0; i < n_keys; i++) {
+        MM3gppPduInfo *info;
+        gchar *value;
+        gchar *pdu;
+        gchar *end = NULL;
+        guint64 index;
+        guint64 status;
+
+        if (g_str_equal (keys[i], KEY_N_PARTS))
+            continue;
+
+        value = g_key_file_get_string (self->keyfile, group, keys[i], NULL);
+        index = g_ascii_strtoull (keys[i], &end, 10);
+        if (!value || !end || *end || index > G_MAXINT ||
+            !(pdu = strchr (value, ',')) ||
+            (status = g_ascii_strtoull (value, &end, 10)) > G_MAXINT || end != pdu) {
+            mm_warn ("Invalid entry '%s' for storage '%s' in SMS cache '%s'",
+                     keys[i], group, self->path);
+            g_free (value);
+            mm_3gpp_pdu_info_list_free (list);
+            g_strfreev (keys);
+            return FALSE;
+        }
+
+        info = g_new0 (MM3gppPduInfo, 1);
+        info->index = (gint) index;
+        info->status = (gint) status;
+        info->pdu = g_strdup (pdu + 1);
+        list = g_list_prepend (list, info);
+        g_free (value);
+    }
+    g_strfreev (keys);
+
+    *out_info_list = g_list_reverse (list);
+    return TRUE;
+}
+
+void
+mm_sms_cache_store (MMSmsCache   *self,
+                    MMSmsStorage  storage,
+                    GList        *info_list)
+{
+    const gchar *group;
+    GList *l;
+
+    group = mm_sms_storage_get_string (storage);
+    g_key_file_remove_group (self->keyfile, group, NULL);
+
+    /* A group with no parts is still a valid copy of an empty storage */
+    g_key_file_set_integer (self->keyfile, group, KEY_N_PARTS, 0);
+    for (l = info_list; l; l = g_list_next (l)) {
+        MM3gppPduInfo *info = l->data;
+
+        set_part (self, group, (guint) info->index, (guint) info->status, info->pdu);
+    }
+
+    save_cache (self);
+}
+
+void
+mm_sms_cache_add (MMSmsCache   *self,
+                  MMSmsStorage  storage,
+                  guint         index,
+                  guint         status,
+                  const gchar  *pdu)
+{
+    const gchar *group;
+
+    /* Only storages which were fully listed are tracked */
+    group = mm_sms_storage_get_string (storage);
+    if (!g_key_file_has_group (self->keyfile, group))
+        return;
+
+    set_part (self, group, index, status, pdu);
+    save_cache (self);
+}
+
+void
+mm_sms_cache_remove (MMSmsCache   *self,
+                     MMSmsStorage  storage,
+                     guint         index)
+{
+    const gchar *group;
+    gchar key[16];
+
+    group = mm_sms_storage_get_string (storage);
+    g_snprintf (key, sizeof (key), "%u", index);
+    if (g_key_file_remove_key (self->keyfile, group, key, NULL)) {
+        update_n_parts (self, group, -1);
+        save_cache (self);
+    }
+}
+
+void
+mm_sms_cache_invalidate (MMSmsCache   *self,
+                         MMSmsStorage  storage)
+{
+    if (g_key_file_remove_group (self->keyfile, mm_sms_storage_get_string (storage), NULL))
+        save_cache (self);
+}
+
+/*****************************************************************************/
+
+MMSmsCache *
+mm_sms_cache_open (const gchar *equipment_id,
+                   const gchar *iccid)
+{
+    MMSmsCache *self;
+    gchar *basename;
+    GError *error = NULL;
+
+    g_return_val_if_fail (equipment_id != NULL, NULL);
+    g_return_val_if_fail (iccid != NULL, NULL);
+
+    if (!mm_context_get_sms_cache_dir ())
+        return NULL;
+
+    /* The ME storage is in the device, the SM one in the SIM */
+    basename = g_strdup_printf ("%s-%s.sms", equipment_id, iccid);
+    g_strdelimit (basename, G_DIR_SEPARATOR_S, '_');
+
+    self = g_slice_new0 (MMSmsCache);
+    self->path = g_build_filename (mm_context_get_sms_cache_dir (), basename, NULL);
+    self->keyfile = g_key_file_new ();
+    g_free (basename);
+
+    if (!g_key_file_load_from_file (self->keyfile, self->path, G_KEY_FILE_NONE, &error)) {
+        if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+            mm_warn ("Couldn't load SMS cache '%s': %s", self->path, error->message);
+        g_error_free (error);
+    } else
+        mm_dbg ("Loaded SMS cache '%s'", self->path);
+
+    return self;
+}
+
+void
+mm_sms_cache_free (MMSmsCache *self)
+{
+    if (!self)
+        return;
+
+    g_key_file_unref (self->keyfile);
+    g_free (self->path);
+    g_slice_free (MMSmsCache, self);
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SMS_CACHE_H
+#define MM_SMS_CACHE_H
+
+#include <glib.h>
+
+#include <ModemManager.h>
+
+/*
+ * Copies of the PDUs listed from the SMS storages, kept in a key file per SIM
+ * and device in the directory given with --sms-cache-dir, so that storages
+ * don't need to be listed again after a daemon restart. The copy of a storage
+ * is only used while the modem reports the same number of messages in it as
+ * the copy holds; any change not seen by the daemon makes the storage be
+ * listed again. Without the option, nothing is cached.
+ */
+
+typedef struct _MMSmsCache MMSmsCache;
+
+/* Returns NULL if caching is disabled */
+MMSmsCache *mm_sms_cache_open (const gchar *equipment_id,
+                               const gchar *iccid);
+void        mm_sms_cache_free (MMSmsCache *self);
+
+/* Returns TRUE and a list of MM3gppPduInfo if the storage copy holds exactly
+ * 'n_parts' parts */
+gboolean mm_sms_cache_lookup     (MMSmsCache    *self,
+                                  MMSmsStorage   storage,
+                                  guint          n_parts,
+                                  GList        **out_info_list);
+
+/* Replaces the copy of the storage with the given list of MM3gppPduInfo */
+void     mm_sms_cache_store      (MMSmsCache    *self,
+                                  MMSmsStorage   storage,
+                                  GList         *info_list);
+
+void     mm_sms_cache_add        (MMSmsCache    *self,
+                                  MMSmsStorage   storage,
+                                  guint          index,
+                                  guint          status,
+                                  const gchar   *pdu);
+void     mm_sms_cache_remove     (MMSmsCache    *self,
+                                  MMSmsStorage   storage,
+                                  guint          index);
+
+/* Drops the copy of the storage, which is then listed again next time */
+void     mm_sms_cache_invalidate (MMSmsCache    *self,
+                                  MMSmsStorage   storage);
+
+#endif /* MM_SMS_CACHE_H */
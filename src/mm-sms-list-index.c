@@ -0,0 +1,234 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "mm-sms-list-index.h"
+
+struct _MMSmsListIndex {
+    /* Storage and index of each part -> owner */
+    GHashTable *parts;
+    /* Number, reference and max parts -> PendingMultipart */
+    GHashTable *multiparts;
+};
+
+typedef struct {
+    gpointer owner;
+    gint64   last_part_time;
+} PendingMultipart;
+
+static void
+pending_multipart_free (PendingMultipart *pending)
+{
+    g_slice_free (PendingMultipart, pending);
+}
+
+MMSmsListIndex *
+mm_sms_list_index_new (void)
+{
+    MMSmsListIndex *self;
+
+    self = g_slice_new0 (MMSmsListIndex);
+    self->parts = g_hash_table_new_full (g_int64_hash, g_int64_equal, g_free, NULL);
+    self->multiparts = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify)pending_multipart_free);
+    return self;
+}
+
+void
+mm_sms_list_index_free (MMSmsListIndex *self)
+{
+    if (!self)
+        return;
+
+    g_hash_table_destroy (self->parts);
+    g_hash_table_destroy (self->multiparts);
+    g_slice_free (MMSmsListIndex, self);
+}
+
+void
+mm_sms_list_index_clear (MMSmsListIndex *self)
+{
+    g_hash_table_remove_all (self->parts);
+    g_hash_table_remove_all (self->multiparts);
+}
+
+/*****************************************************************************/
+
+static guint64
+part_key (MMSmsStorage storage,
+          guint        index)
+{
+    return ((guint64) storage << 32) | index;
+}
+
+void
+mm_sms_list_index_add_part (MMSmsListIndex *self,
+                            MMSmsStorage    storage,
+                            guint           index,
+                            gpointer        owner)
+{
+    guint64 *key;
+
+    key = g_new (guint64, 1);
+    *key = part_key (storage, index);
+    g_hash_table_replace (self->parts, key, owner);
+}
+
+gpointer
+mm_sms_list_index_lookup_part (MMSmsListIndex *self,
+                               MMSmsStorage    storage,
+                               guint           index)
+{
+    guint64 key;
+
+    key = part_key (storage, index);
+    return g_hash_table_lookup (self->parts, &key);
+}
+
+void
+mm_sms_list_index_remove_part (MMSmsListIndex *self,
+                               MMSmsStorage    storage,
+                               guint           index)
+{
+    guint64 key;
+
+    key = part_key (storage, index);
+    g_hash_table_remove (self->parts, &key);
+}
+
+/*****************************************************************************/
+
+static gchar *
+multipart_key_new (MMSmsPart *part)
+{
+    return g_strdup_printf ("%s/%u/%u",
+                            mm_sms_part_get_number (part) ? mm_sms_part_get_number (part) : "",
+                            mm_sms_part_get_concat_reference (part),
+                            mm_sms_part_get_concat_max (part));
+}
+
+static PendingMultipart *
+multipart_lookup (MMSmsListIndex *self,
+                  MMSmsPart      *part)
+{
+    PendingMultipart *pending;
+    gchar *key;
+
+    key = multipart_key_new (part);
+    pending = g_hash_table_lookup (self->multiparts, key);
+    g_free (key);
+    return pending;
+}
+
+void
+mm_sms_list_index_add_multipart (MMSmsListIndex *self,
+                                 MMSmsPart      *part,
+                                 gpointer        owner,
+                                 gint64          now)
+{
+    PendingMultipart *pending;
+
+    pending = g_slice_new (PendingMultipart);
+    pending->owner = owner;
+    pending->last_part_time = now;
+    g_hash_table_replace (self->multiparts, multipart_key_new (part), pending);
+}
+
+gpointer
+mm_sms_list_index_lookup_multipart (MMSmsListIndex *self,
+                                    MMSmsPart      *part)
+{
+    PendingMultipart *pending;
+
+    pending = multipart_lookup (self, part);
+    return pending ? pending->owner : NULL;
+}
+
+void
+mm_sms_list_index_touch_multipart (MMSmsListIndex *self,
+                                   MMSmsPart      *part,
+                                   gint64          now)
+{
+    PendingMultipart *pending;
+
+    pending = multipart_lookup (self, part);
+    if (pending)
+        pending->last_part_time = now;
+}
+
+void
+mm_sms_list_index_remove_multipart (MMSmsListIndex *self,
+                                    MMSmsPart      *part)
+{
+    gchar *key;
+
+    key = multipart_key_new (part);
+    g_hash_table_remove (self->multiparts, key);
+    g_free (key);
+}
+
+guint
+mm_sms_list_index_get_n_multiparts (MMSmsListIndex *self)
+{
+    return g_hash_table_size (self->multiparts);
+}
+
+GList *
+mm_sms_list_index_expire_multiparts (MMSmsListIndex *self,
+                                     gint64          now,
+                                     gint64          timeout)
+{
+    GHashTableIter iter;
+    PendingMultipart *pending;
+    GList *expired = NULL;
+
+    g_hash_table_iter_init (&iter, self->multiparts);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&pending)) {
+        if (now - pending->last_part_time < timeout)
+            continue;
+        expired = g_list_prepend (expired, pending->owner);
+        g_hash_table_iter_remove (&iter);
+    }
+    return expired;
+}
+
+/*****************************************************************************/
+
+static gboolean
+value_is_owner (gpointer key,
+                gpointer value,
+                gpointer owner)
+{
+    return value == owner;
+}
+
+static gboolean
+pending_multipart_is_owner (gpointer          key,
+                            PendingMultipart *pending,
+                            gpointer          owner)
+{
+    return pending->owner == owner;
+}
+
+void
+mm_sms_list_index_remove_owner (MMSmsListIndex *self,
+                                gpointer        owner,
+                                gboolean        multipart)
+{
+    g_hash_table_foreach_remove (self->parts, (GHRFunc)value_is_owner, owner);
+    if (multipart)
+        g_hash_table_foreach_remove (self->multiparts, (GHRFunc)pending_multipart_is_owner, owner);
+}
@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_SMS_LIST_INDEX_H
+#define MM_SMS_LIST_INDEX_H
+
+#include <glib.h>
+
+#include "mm-sms-part.h"
+
+/*
+ * Lookup tables of the SMS list, so that incoming parts don't need a scan of
+ * the whole list:
+ *  - the owner of each part, by storage and index, for the duplicate checks;
+ *  - the owner of each incomplete multipart message, by number, concat
+ *    reference and maximum number of parts, to reassemble them.
+ *
+ * Owners are opaque and never referenced by the index.
+ */
+typedef struct _MMSmsListIndex MMSmsListIndex;
+
+MMSmsListIndex *mm_sms_list_index_new   (void);
+void            mm_sms_list_index_free  (MMSmsListIndex *self);
+void            mm_sms_list_index_clear (MMSmsListIndex *self);
+
+/* Parts; adding a part already there replaces its owner */
+void     mm_sms_list_index_add_part    (MMSmsListIndex *self,
+                                        MMSmsStorage    storage,
+                                        guint           index,
+                                        gpointer        owner);
+gpointer mm_sms_list_index_lookup_part (MMSmsListIndex *self,
+                                        MMSmsStorage    storage,
+                                        guint           index);
+void     mm_sms_list_index_remove_part (MMSmsListIndex *self,
+                                        MMSmsStorage    storage,
+                                        guint           index);
+
+/* Incomplete multipart messages, looked up with any of their parts. Times are
+ * monotonic, in microseconds. */
+void     mm_sms_list_index_add_multipart     (MMSmsListIndex *self,
+                                              MMSmsPart      *part,
+                                              gpointer        owner,
+                                              gint64          now);
+gpointer mm_sms_list_index_lookup_multipart  (MMSmsListIndex *self,
+                                              MMSmsPart      *part);
+/* Records that a new part was taken, delaying the expiration */
+void     mm_sms_list_index_touch_multipart   (MMSmsListIndex *self,
+                                              MMSmsPart      *part,
+                                              gint64          now);
+/* Once complete; a later part with the same reference starts a new message */
+void     mm_sms_list_index_remove_multipart  (MMSmsListIndex *self,
+                                              MMSmsPart      *part);
+guint    mm_sms_list_index_get_n_multiparts  (MMSmsListIndex *self);
+/* Gives up on the messages without new parts in the given time, and returns
+ * their owners (list to be freed with g_list_free()) */
+GList   *mm_sms_list_index_expire_multiparts (MMSmsListIndex *self,
+                                              gint64          now,
+                                              gint64          timeout);
+
+/* Drops the parts of the owner, and also its incomplete message if requested */
+void     mm_sms_list_index_remove_owner      (MMSmsListIndex *self,
+                                              gpointer        owner,
+                                              gboolean        multipart);
+
+#endif /* MM_SMS_LIST_INDEX_H */
@@ -26,9 +26,18 @@
 
 #include "mm-iface-modem-messaging.h"
 #include "mm-sms-list.h"
+#include "mm-sms-list-index.h"
 #include "mm-base-sms.h"
+#include "mm-modem-helpers.h"
+#include "mm-clock.h"
+#include "mm-memory-budget.h"
 #include "mm-log.h"
 
+/* Multipart messages not getting new parts for this long are no longer
+ * reassembled, so that their reference may be reused by new messages */
+#define MULTIPART_TIMEOUT_SECS       1800
+#define MULTIPART_SWEEP_PERIOD_SECS  300
+
 G_DEFINE_TYPE (MMSmsList, mm_sms_list, G_TYPE_OBJECT);
 
 enum {
@@ -40,6 +49,7 @@ static GParamSpec *properties[PROP_LAST];
 
 enum {
     SIGNAL_ADDED,
+    SIGNAL_BATCH_ADDED,
     SIGNAL_DELETED,
     SIGNAL_LAST
 };
@@ -50,10 +60,255 @@ struct _MMSmsListPrivate {
     MMBaseModem *modem;
     /* List of sms objects */
     GList *list;
+    /* Index of the same objects, in arrival order, for paged queries */
+    GPtrArray *index;
+    /* Parts and incomplete multipart messages -> sms object; not owned */
+    MMSmsListIndex *lookup;
+    guint multiparts_sweep_id;
+    /* Sms objects created while batching, not exported yet */
+    GPtrArray *batch;
 };
 
 /*****************************************************************************/
 
+typedef struct {
+    /* Not owned, the reference is kept in the list */
+    MMBaseSms *sms;
+    /* Seconds since the epoch; multipart messages only get a timestamp once
+     * all parts have been received, so it's parsed on the first query after
+     * that */
+    gboolean   timestamp_valid;
+    guint64    timestamp;
+} IndexEntry;
+
+static void
+index_entry_free (IndexEntry *entry)
+{
+    g_slice_free (IndexEntry, entry);
+}
+
+static void
+index_add (MMSmsList *self,
+           MMBaseSms *sms)
+{
+    IndexEntry *entry;
+
+    entry = g_slice_new0 (IndexEntry);
+    entry->sms = sms;
+    g_ptr_array_add (self->priv->index, entry);
+}
+
+static void
+index_remove (MMSmsList *self,
+              MMBaseSms *sms)
+{
+    guint i;
+
+    for (i = 0; i < self->priv->index->len; i++) {
+        IndexEntry *entry;
+
+        entry = g_ptr_array_index (self->priv->index, i);
+        if (entry->sms == sms) {
+            /* Keep the arrival order */
+            g_ptr_array_remove_index (self->priv->index, i);
+            return;
+        }
+    }
+}
+
+static gboolean
+index_entry_matches (IndexEntry *entry,
+                     MMSmsState state,
+                     MMSmsStorage storage,
+                     guint64 timestamp_from,
+                     guint64 timestamp_to)
+{
+    if (state != MM_SMS_STATE_UNKNOWN &&
+        mm_gdbus_sms_get_state (MM_GDBUS_SMS (entry->sms)) != state)
+        return FALSE;
+
+    if (storage != MM_SMS_STORAGE_UNKNOWN &&
+        mm_base_sms_get_storage (entry->sms) != storage)
+        return FALSE;
+
+    if (!timestamp_from && !timestamp_to)
+        return TRUE;
+
+    if (!entry->timestamp_valid)
+        entry->timestamp_valid = mm_parse_iso8601_time (mm_gdbus_sms_get_timestamp (MM_GDBUS_SMS (entry->sms)),
+                                                        &entry->timestamp);
+
+    /* Messages without timestamp never match a time range */
+    return (entry->timestamp_valid &&
+            (!timestamp_from || entry->timestamp >= timestamp_from) &&
+            (!timestamp_to || entry->timestamp <= timestamp_to));
+}
+
+/*****************************************************************************/
+
+static void
+parts_add (MMSmsList *self,
+           MMBaseSms *sms)
+{
+    MMSmsStorage storage;
+    GList *l;
+
+    storage = mm_base_sms_get_storage (sms);
+    if (storage == MM_SMS_STORAGE_UNKNOWN)
+        return;
+
+    for (l = mm_base_sms_get_parts (sms); l; l = g_list_next (l)) {
+        guint index;
+
+        index = mm_sms_part_get_index ((MMSmsPart *)l->data);
+        if (index != SMS_PART_INVALID_INDEX)
+            mm_sms_list_index_add_part (self->priv->lookup, storage, index, sms);
+    }
+}
+
+static void
+sms_storage_updated (MMBaseSms *sms,
+                     GParamSpec *pspec,
+                     MMSmsList *self)
+{
+    /* Parts of locally created messages only get an index once stored */
+    mm_sms_list_index_remove_owner (self->priv->lookup, sms, FALSE);
+    parts_add (self, sms);
+}
+
+/*****************************************************************************/
+
+static gboolean
+multiparts_sweep_cb (MMSmsList *self)
+{
+    GList *expired;
+    GList *l;
+
+    expired = mm_sms_list_index_expire_multiparts (self->priv->lookup,
+                                                   mm_clock_get_time (),
+                                                   (gint64) MULTIPART_TIMEOUT_SECS * G_USEC_PER_SEC);
+    for (l = expired; l; l = g_list_next (l)) {
+        MMBaseSms *sms = l->data;
+
+        /* The object is kept, so that the parts may still be deleted */
+        mm_dbg ("Giving up on reassembling multipart SMS '%s' (%u parts received)",
+                mm_base_sms_get_path (sms),
+                g_list_length (mm_base_sms_get_parts (sms)));
+    }
+    g_list_free (expired);
+
+    if (mm_sms_list_index_get_n_multiparts (self->priv->lookup) > 0)
+        return G_SOURCE_CONTINUE;
+
+    self->priv->multiparts_sweep_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static void
+multiparts_add (MMSmsList *self,
+                MMSmsPart *part,
+                MMBaseSms *sms)
+{
+    mm_sms_list_index_add_multipart (self->priv->lookup, part, sms, mm_clock_get_time ());
+
+    if (!self->priv->multiparts_sweep_id)
+        self->priv->multiparts_sweep_id = mm_clock_timeout_add_seconds (MULTIPART_SWEEP_PERIOD_SECS,
+                                                                        (GSourceFunc)multiparts_sweep_cb,
+                                                                        self);
+}
+
+/*****************************************************************************/
+
+static void
+list_add (MMSmsList *self,
+          MMBaseSms *sms)
+{
+    self->priv->list = g_list_prepend (self->priv->list, sms);
+    index_add (self, sms);
+    parts_add (self, sms);
+    g_signal_connect (sms,
+                      "notify::storage",
+                      G_CALLBACK (sms_storage_updated),
+                      self);
+}
+
+static void
+list_remove (MMSmsList *self,
+             GList *l)
+{
+    MMBaseSms *sms;
+
+    sms = MM_BASE_SMS (l->data);
+    g_signal_handlers_disconnect_by_func (sms, sms_storage_updated, self);
+    mm_sms_list_index_remove_owner (self->priv->lookup, sms, TRUE);
+    index_remove (self, sms);
+    if (self->priv->batch)
+        g_ptr_array_remove (self->priv->batch, sms);
+    self->priv->list = g_list_delete_link (self->priv->list, l);
+    g_object_unref (sms);
+}
+
+/* New sms objects from parts are exported here, unless batching */
+static void
+list_export_new (MMSmsList *self,
+                 MMBaseSms *sms,
+                 gboolean received)
+{
+    if (self->priv->batch) {
+        g_ptr_array_add (self->priv->batch, g_object_ref (sms));
+        return;
+    }
+
+    mm_base_sms_export (sms);
+    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
+                   mm_base_sms_get_path (sms),
+                   received);
+}
+
+void
+mm_sms_list_begin_batch (MMSmsList *self)
+{
+    g_return_if_fail (self->priv->batch == NULL);
+
+    self->priv->batch = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+guint
+mm_sms_list_end_batch (MMSmsList *self,
+                       MMSmsListExportFilter filter,
+                       gpointer user_data)
+{
+    GPtrArray *batch;
+    guint n_exported = 0;
+    guint i;
+
+    g_return_val_if_fail (self->priv->batch != NULL, 0);
+
+    batch = self->priv->batch;
+    self->priv->batch = NULL;
+
+    /* Evicted or removed objects were already taken out of the batch */
+    for (i = 0; i < batch->len; i++) {
+        MMBaseSms *sms;
+
+        sms = g_ptr_array_index (batch, i);
+        if (filter && !filter (sms, user_data))
+            continue;
+        mm_base_sms_export (sms);
+        n_exported++;
+    }
+
+    mm_dbg ("SMS batch finished: %u exported, %u not exported",
+            n_exported, batch->len - n_exported);
+    g_ptr_array_unref (batch);
+
+    if (n_exported)
+        g_signal_emit (self, signals[SIGNAL_BATCH_ADDED], 0, n_exported);
+    return n_exported;
+}
+
+/*****************************************************************************/
+
 gboolean
 mm_sms_list_has_local_multipart_reference (MMSmsList *self,
                                            const gchar *number,
@@ -89,6 +344,17 @@ mm_sms_list_get_count (MMSmsList *self)
     return g_list_length (self->priv->list);
 }
 
+guint
+mm_sms_list_get_n_parts (MMSmsList *self)
+{
+    GList *l;
+    guint n_parts = 0;
+
+    for (l = self->priv->list; l; l = g_list_next (l))
+        n_parts += g_list_length (mm_base_sms_get_parts (MM_BASE_SMS (l->data)));
+    return n_parts;
+}
+
 GStrv
 mm_sms_list_get_paths (MMSmsList *self)
 {
@@ -111,6 +377,48 @@ mm_sms_list_get_paths (MMSmsList *self)
     return path_list;
 }
 
+GStrv
+mm_sms_list_get_paths_paged (MMSmsList *self,
+                             guint offset,
+                             guint limit,
+                             MMSmsState state,
+                             MMSmsStorage storage,
+                             guint64 timestamp_from,
+                             guint64 timestamp_to,
+                             guint *total)
+{
+    GPtrArray *path_list;
+    guint n_matches = 0;
+    guint i;
+
+    path_list = g_ptr_array_new ();
+
+    for (i = 0; i < self->priv->index->len; i++) {
+        IndexEntry *entry;
+        const gchar *path;
+
+        entry = g_ptr_array_index (self->priv->index, i);
+
+        /* Not yet exported SMS objects are not listed */
+        path = mm_base_sms_get_path (entry->sms);
+        if (!path)
+            continue;
+
+        if (!index_entry_matches (entry, state, storage, timestamp_from, timestamp_to))
+            continue;
+
+        if (n_matches >= offset && (!limit || path_list->len < limit))
+            g_ptr_array_add (path_list, g_strdup (path));
+        n_matches++;
+    }
+
+    g_ptr_array_add (path_list, NULL);
+
+    if (total)
+        *total = n_matches;
+    return (GStrv) g_ptr_array_free (path_list, FALSE);
+}
+
 /*****************************************************************************/
 
 typedef struct {
@@ -163,10 +471,8 @@ delete_ready (MMBaseSms *sms,
     l = g_list_find_custom (ctx->self->priv->list,
                             ctx->path,
                             (GCompareFunc)cmp_sms_by_path);
-    if (l) {
-        g_object_unref (MM_BASE_SMS (l->data));
-        ctx->self->priv->list = g_list_delete_link (ctx->self->priv->list, l);
-    }
+    if (l)
+        list_remove (ctx->self, l);
 
     /* We don't need to unref the SMS any more, but we can use the
      * reference we got in the method, which is the one kept alive
@@ -220,41 +526,142 @@ mm_sms_list_delete_sms (MMSmsList *self,
 
 /*****************************************************************************/
 
-void
-mm_sms_list_add_sms (MMSmsList *self,
-                     MMBaseSms *sms)
+GArray *
+mm_sms_list_get_part_indices (MMSmsList *self,
+                              MMSmsStorage storage)
 {
-    self->priv->list = g_list_prepend (self->priv->list, g_object_ref (sms));
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   FALSE);
+    GArray *indices;
+    GList *l;
+
+    indices = g_array_new (FALSE, FALSE, sizeof (guint));
+    for (l = self->priv->list; l; l = g_list_next (l)) {
+        GList *parts;
+
+        if (mm_base_sms_get_storage (MM_BASE_SMS (l->data)) != storage)
+            continue;
+
+        for (parts = mm_base_sms_get_parts (MM_BASE_SMS (l->data)); parts; parts = g_list_next (parts)) {
+            guint index;
+
+            index = mm_sms_part_get_index ((MMSmsPart *)parts->data);
+            if (index != SMS_PART_INVALID_INDEX)
+                g_array_append_val (indices, index);
+        }
+    }
+
+    return indices;
+}
+
+guint
+mm_sms_list_remove_storage (MMSmsList *self,
+                            MMSmsStorage storage)
+{
+    GPtrArray *removed;
+    GList *l;
+    guint i;
+
+    removed = g_ptr_array_new_with_free_func (g_free);
+
+    l = self->priv->list;
+    while (l) {
+        GList *next;
+        MMBaseSms *sms;
+
+        next = g_list_next (l);
+        sms = MM_BASE_SMS (l->data);
+        if (mm_base_sms_get_storage (sms) == storage) {
+            if (mm_base_sms_get_path (sms))
+                g_ptr_array_add (removed, g_strdup (mm_base_sms_get_path (sms)));
+            mm_base_sms_unexport (sms);
+            list_remove (self, l);
+        }
+        l = next;
+    }
+
+    /* Signals are only emitted once the list is updated, so that listeners
+     * going through the list only see the messages left */
+    for (i = 0; i < removed->len; i++)
+        g_signal_emit (self,
+                       signals[SIGNAL_DELETED], 0,
+                       g_ptr_array_index (removed, i));
+
+    i = removed->len;
+    g_ptr_array_unref (removed);
+    return i;
 }
 
 /*****************************************************************************/
+/* Memory budget */
 
-static guint
-cmp_sms_by_concat_reference (MMBaseSms *sms,
-                             gpointer user_data)
+/* Received messages beyond the budget are dropped from memory, oldest first.
+ * Those stored in the device go first, as they're not lost: they're loaded
+ * again the next time the storages are listed. */
+static void
+enforce_budget (MMSmsList *self)
 {
-    if (!mm_base_sms_is_multipart (sms))
-        return -1;
+    GPtrArray *evicted;
+    guint      max;
+    guint      count;
+    guint      pass;
+    guint      i;
+
+    max = mm_memory_budget_get ()->sms_objects;
+    count = g_list_length (self->priv->list);
+    if (!max || count <= max)
+        return;
 
-    return (GPOINTER_TO_UINT (user_data) - mm_base_sms_get_multipart_reference (sms));
+    evicted = g_ptr_array_new_with_free_func (g_free);
+
+    for (pass = 0; pass < 2 && count > max; pass++) {
+        i = 0;
+        while (i < self->priv->index->len && count > max) {
+            MMBaseSms *sms;
+
+            sms = ((IndexEntry *) g_ptr_array_index (self->priv->index, i))->sms;
+            if (mm_gdbus_sms_get_state (MM_GDBUS_SMS (sms)) != MM_SMS_STATE_RECEIVED ||
+                (pass == 0 && mm_base_sms_get_storage (sms) == MM_SMS_STORAGE_UNKNOWN)) {
+                i++;
+                continue;
+            }
+
+            if (pass == 0)
+                mm_dbg ("SMS '%s' evicted from memory, still in the '%s' storage",
+                        mm_base_sms_get_path (sms),
+                        mm_sms_storage_get_string (mm_base_sms_get_storage (sms)));
+            else
+                mm_warn ("SMS '%s' dropped: not stored in the device and over the memory budget",
+                         mm_base_sms_get_path (sms));
+
+            if (mm_base_sms_get_path (sms))
+                g_ptr_array_add (evicted, g_strdup (mm_base_sms_get_path (sms)));
+            mm_base_sms_unexport (sms);
+            /* Removed from the index as well, so 'i' is already the next one */
+            list_remove (self, g_list_find (self->priv->list, sms));
+            count--;
+        }
+    }
+
+    for (i = 0; i < evicted->len; i++)
+        g_signal_emit (self,
+                       signals[SIGNAL_DELETED], 0,
+                       g_ptr_array_index (evicted, i));
+    g_ptr_array_unref (evicted);
 }
 
-typedef struct {
-    guint part_index;
-    MMSmsStorage storage;
-} PartIndexAndStorage;
+/*****************************************************************************/
 
-static guint
-cmp_sms_by_part_index_and_storage (MMBaseSms *sms,
-                                   PartIndexAndStorage *ctx)
+void
+mm_sms_list_add_sms (MMSmsList *self,
+                     MMBaseSms *sms)
 {
-    return !(mm_base_sms_get_storage (sms) == ctx->storage &&
-             mm_base_sms_has_part_index (sms, ctx->part_index));
+    list_add (self, g_object_ref (sms));
+    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
+                   mm_base_sms_get_path (sms),
+                   FALSE);
 }
 
+/*****************************************************************************/
+
 static gboolean
 take_singlepart (MMSmsList *self,
                  MMSmsPart *part,
@@ -272,10 +679,9 @@ take_singlepart (MMSmsList *self,
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   state == MM_SMS_STATE_RECEIVED);
+    list_add (self, sms);
+    list_export_new (self, sms, state == MM_SMS_STATE_RECEIVED);
+    enforce_budget (self);
     return TRUE;
 }
 
@@ -286,34 +692,41 @@ take_multipart (MMSmsList *self,
                 MMSmsStorage storage,
                 GError **error)
 {
-    GList *l;
     MMBaseSms *sms;
-    guint concat_reference;
 
-    concat_reference = mm_sms_part_get_concat_reference (part);
-    l = g_list_find_custom (self->priv->list,
-                            GUINT_TO_POINTER (concat_reference),
-                            (GCompareFunc)cmp_sms_by_concat_reference);
-    if (l)
+    sms = mm_sms_list_index_lookup_multipart (self->priv->lookup, part);
+    if (sms) {
         /* Try to take the part */
-        return mm_base_sms_multipart_take_part (MM_BASE_SMS (l->data), part, error);
+        if (!mm_base_sms_multipart_take_part (sms, part, error))
+            return FALSE;
+
+        parts_add (self, sms);
+        if (mm_base_sms_multipart_is_complete (sms)) {
+            mm_sms_list_index_remove_multipart (self->priv->lookup, part);
+            enforce_budget (self);
+        } else
+            mm_sms_list_index_touch_multipart (self->priv->lookup, part, mm_clock_get_time ());
+        return TRUE;
+    }
 
     /* Create new Multipart */
     sms = mm_base_sms_multipart_new (self->priv->modem,
                                      state,
                                      storage,
-                                     concat_reference,
+                                     mm_sms_part_get_concat_reference (part),
                                      mm_sms_part_get_concat_max (part),
                                      part,
                                      error);
     if (!sms)
         return FALSE;
 
-    self->priv->list = g_list_prepend (self->priv->list, sms);
-    g_signal_emit (self, signals[SIGNAL_ADDED], 0,
-                   mm_base_sms_get_path (sms),
-                   (state == MM_SMS_STATE_RECEIVED ||
-                    state == MM_SMS_STATE_RECEIVING));
+    list_add (self, sms);
+    if (!mm_base_sms_multipart_is_complete (sms))
+        multiparts_add (self, part, sms);
+    list_export_new (self, sms,
+                     (state == MM_SMS_STATE_RECEIVED ||
+                      state == MM_SMS_STATE_RECEIVING));
+    enforce_budget (self);
 
     return TRUE;
 }
@@ -323,18 +736,23 @@ mm_sms_list_has_part (MMSmsList *self,
                       MMSmsStorage storage,
                       guint index)
 {
-    PartIndexAndStorage ctx;
+    MMBaseSms *sms;
 
     if (storage == MM_SMS_STORAGE_UNKNOWN ||
         index == SMS_PART_INVALID_INDEX)
         return FALSE;
 
-    ctx.part_index = index;
-    ctx.storage = storage;
+    sms = mm_sms_list_index_lookup_part (self->priv->lookup, storage, index);
+    if (!sms)
+        return FALSE;
+
+    if (mm_base_sms_get_storage (sms) == storage &&
+        mm_base_sms_has_part_index (sms, index))
+        return TRUE;
 
-    return !!g_list_find_custom (self->priv->list,
-                                 &ctx,
-                                 (GCompareFunc)cmp_sms_by_part_index_and_storage);
+    /* Stale, e.g. the part was removed from the device */
+    mm_sms_list_index_remove_part (self->priv->lookup, storage, index);
+    return FALSE;
 }
 
 gboolean
@@ -442,19 +860,48 @@ mm_sms_list_init (MMSmsList *self)
     self->priv = G_TYPE_INSTANCE_GET_PRIVATE (self,
                                               MM_TYPE_SMS_LIST,
                                               MMSmsListPrivate);
+    self->priv->index = g_ptr_array_new_with_free_func ((GDestroyNotify)index_entry_free);
+    self->priv->lookup = mm_sms_list_index_new ();
 }
 
 static void
 dispose (GObject *object)
 {
     MMSmsList *self = MM_SMS_LIST (object);
+    GList *l;
 
-    g_clear_object (&self->priv->modem);
+    if (self->priv->multiparts_sweep_id) {
+        g_source_remove (self->priv->multiparts_sweep_id);
+        self->priv->multiparts_sweep_id = 0;
+    }
+
+    for (l = self->priv->list; l; l = g_list_next (l))
+        g_signal_handlers_disconnect_by_func (l->data, sms_storage_updated, self);
+    mm_sms_list_index_clear (self->priv->lookup);
+    g_ptr_array_set_size (self->priv->index, 0);
+    if (self->priv->batch) {
+        g_ptr_array_unref (self->priv->batch);
+        self->priv->batch = NULL;
+    }
     g_list_free_full (self->priv->list, (GDestroyNotify)g_object_unref);
+    self->priv->list = NULL;
+
+    g_clear_object (&self->priv->modem);
 
     G_OBJECT_CLASS (mm_sms_list_parent_class)->dispose (object);
 }
 
+static void
+finalize (GObject *object)
+{
+    MMSmsList *self = MM_SMS_LIST (object);
+
+    g_ptr_array_unref (self->priv->index);
+    mm_sms_list_index_free (self->priv->lookup);
+
+    G_OBJECT_CLASS (mm_sms_list_parent_class)->finalize (object);
+}
+
 static void
 mm_sms_list_class_init (MMSmsListClass *klass)
 {
@@ -466,6 +913,7 @@ mm_sms_list_class_init (MMSmsListClass *klass)
     object_class->get_property = get_property;
     object_class->set_property = set_property;
     object_class->dispose = dispose;
+    object_class->finalize = finalize;
 
     /* Properties */
     properties[PROP_MODEM] =
@@ -486,6 +934,15 @@ mm_sms_list_class_init (MMSmsListClass *klass)
                       g_cclosure_marshal_generic,
                       G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_BOOLEAN);
 
+    signals[SIGNAL_BATCH_ADDED] =
+        g_signal_new (MM_SMS_BATCH_ADDED,
+                      G_OBJECT_CLASS_TYPE (object_class),
+                      G_SIGNAL_RUN_FIRST,
+                      G_STRUCT_OFFSET (MMSmsListClass, sms_batch_added),
+                      NULL, NULL,
+                      g_cclosure_marshal_generic,
+                      G_TYPE_NONE, 1, G_TYPE_UINT);
+
     signals[SIGNAL_DELETED] =
         g_signal_new (MM_SMS_DELETED,
                       G_OBJECT_CLASS_TYPE (object_class),
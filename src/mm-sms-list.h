@@ -35,8 +35,9 @@ typedef struct _MMSmsListPrivate MMSmsListPrivate;
 
 #define MM_SMS_LIST_MODEM "sms-list-modem"
 
-#define MM_SMS_ADDED     "sms-added"
-#define MM_SMS_DELETED   "sms-deleted"
+#define MM_SMS_ADDED       "sms-added"
+#define MM_SMS_BATCH_ADDED "sms-batch-added"
+#define MM_SMS_DELETED     "sms-deleted"
 
 struct _MMSmsList {
     GObject parent;
@@ -52,6 +53,8 @@ struct _MMSmsListClass {
                            gboolean received);
     void (*sms_deleted)   (MMSmsList *self,
                            const gchar *sms_path);
+    void (*sms_batch_added) (MMSmsList *self,
+                             guint n_added);
 };
 
 GType mm_sms_list_get_type (void);
@@ -59,7 +62,19 @@ GType mm_sms_list_get_type (void);
 MMSmsList *mm_sms_list_new (MMBaseModem *modem);
 
 GStrv mm_sms_list_get_paths (MMSmsList *self);
+/* Paths in arrival order. Unknown state or storage and 0 timestamps (seconds
+ * since the epoch) match everything; a limit of 0 means no limit. */
+GStrv mm_sms_list_get_paths_paged (MMSmsList *self,
+                                   guint offset,
+                                   guint limit,
+                                   MMSmsState state,
+                                   MMSmsStorage storage,
+                                   guint64 timestamp_from,
+                                   guint64 timestamp_to,
+                                   guint *total);
 guint mm_sms_list_get_count (MMSmsList *self);
+/* Parts held by all the sms objects, including incomplete multipart ones */
+guint mm_sms_list_get_n_parts (MMSmsList *self);
 
 gboolean mm_sms_list_has_part (MMSmsList *self,
                                MMSmsStorage storage,
@@ -74,6 +89,25 @@ gboolean mm_sms_list_take_part (MMSmsList *self,
 void mm_sms_list_add_sms (MMSmsList *self,
                           MMBaseSms *sms);
 
+/* While batching, new sms objects are neither exported nor reported with
+ * 'sms-added'. When the batch ends they're exported all at once, unless the
+ * filter says otherwise, and a single 'sms-batch-added' is emitted. Objects
+ * not exported are still counted, but not listed. */
+typedef gboolean (* MMSmsListExportFilter) (MMBaseSms *sms,
+                                            gpointer user_data);
+
+void  mm_sms_list_begin_batch (MMSmsList *self);
+guint mm_sms_list_end_batch   (MMSmsList *self,
+                               MMSmsListExportFilter filter,
+                               gpointer user_data);
+
+/* Indices of the parts in the given storage, and removal of all the sms
+ * objects in it once the parts have been deleted from the device */
+GArray *mm_sms_list_get_part_indices (MMSmsList *self,
+                                      MMSmsStorage storage);
+guint   mm_sms_list_remove_storage   (MMSmsList *self,
+                                      MMSmsStorage storage);
+
 void     mm_sms_list_delete_sms        (MMSmsList *self,
                                         const gchar *sms_path,
                                         GAsyncReadyCallback callback,
@@ -29,6 +29,13 @@
 
 #define PDU_SIZE 200
 
+/* Maximum size of the user data, and of the user data that fits next to the
+ * concatenation UDH */
+#define SMS_MAX_USER_DATA_LEN        140
+#define SMS_MAX_CONCAT_USER_DATA_LEN 134
+#define GSM7_MAX_SEPTETS             160
+#define GSM7_MAX_CONCAT_SEPTETS      153
+
 #define SMS_TP_MTI_MASK               0x03
 #define  SMS_TP_MTI_SMS_DELIVER       0x00
 #define  SMS_TP_MTI_SMS_SUBMIT        0x01
@@ -130,12 +137,14 @@ sms_decode_address (const guint8 *address, int len)
     address++;
 
     if (addrtype == SMS_NUMBER_TYPE_ALPHA) {
-        guint8 *unpacked;
+        /* At most (255 * 4) / 7 septets */
+        guint8 unpacked[146];
         guint32 unpacked_len;
-        unpacked = gsm_unpack (address, (len * 4) / 7, 0, &unpacked_len);
+
+        unpacked_len = (len * 4) / 7;
+        gsm_unpack_buffer (address, unpacked_len, 0, unpacked);
         utf8 = (char *)mm_charset_gsm_unpacked_to_utf8 (unpacked,
                                                         unpacked_len);
-        g_free(unpacked);
     } else if (addrtype == SMS_NUMBER_TYPE_INTL &&
                addrplan == SMS_NUMBER_PLAN_TELEPHONE) {
         /* International telphone number, format as "+1234567890" */
@@ -155,14 +164,16 @@ sms_decode_address (const guint8 *address, int len)
     return utf8;
 }
 
-static char *
-sms_decode_timestamp (const guint8 *timestamp)
+#define SMS_TIMESTAMP_LEN 16
+
+static const char *
+sms_decode_timestamp (const guint8 *timestamp,
+                      char timestr[SMS_TIMESTAMP_LEN])
 {
     /* YYMMDDHHMMSS+ZZ */
-    char *timestr;
     int quarters, hours;
 
-    timestr = g_malloc0 (16);
+    memset (timestr, 0, SMS_TIMESTAMP_LEN);
     sms_semi_octets_to_bcd_string (timestr, timestamp, 6);
     quarters = ((timestamp[6] & 0x7) * 10) + ((timestamp[6] >> 4) & 0xf);
     hours = quarters / 4;
@@ -237,15 +248,16 @@ static char *
 sms_decode_text (const guint8 *text, int len, MMSmsEncoding encoding, int bit_offset)
 {
     char *utf8;
-    guint8 *unpacked;
-    guint32 unpacked_len;
 
     if (encoding == MM_SMS_ENCODING_GSM7) {
+        /* User data length is given in one byte */
+        guint8 unpacked[255];
+
+        g_assert (len <= (int) sizeof (unpacked));
         mm_dbg ("Converting SMS part text from GSM7 to UTF8...");
-        unpacked = gsm_unpack ((const guint8 *) text, len, bit_offset, &unpacked_len);
-        utf8 = (char *) mm_charset_gsm_unpacked_to_utf8 (unpacked, unpacked_len);
+        gsm_unpack_buffer ((const guint8 *) text, len, bit_offset, unpacked);
+        utf8 = (char *) mm_charset_gsm_unpacked_to_utf8 (unpacked, len);
         mm_dbg ("   Got UTF-8 text: '%s'", utf8);
-        g_free (unpacked);
     } else if (encoding == MM_SMS_ENCODING_UCS2) {
         mm_dbg ("Converting SMS part text from UCS-2BE to UTF8...");
         utf8 = g_convert ((char *) text, len, "UTF8", "UCS-2BE", NULL, NULL, NULL);
@@ -320,12 +332,13 @@ mm_sms_part_3gpp_new_from_pdu (guint index,
                                const gchar *hexpdu,
                                GError **error)
 {
+    guint8 buf[SMS_PART_MAX_PDU_LEN];
     gsize pdu_len;
     guint8 *pdu;
     MMSmsPart *part;
 
     /* Convert PDU from hex to binary */
-    pdu = (guint8 *) mm_utils_hexstr2bin (hexpdu, &pdu_len);
+    pdu = mm_sms_part_pdu_from_hex (hexpdu, buf, sizeof (buf), &pdu_len);
     if (!pdu) {
         g_set_error_literal (error,
                              MM_CORE_ERROR,
@@ -335,7 +348,8 @@ mm_sms_part_3gpp_new_from_pdu (guint index,
     }
 
     part = mm_sms_part_3gpp_new_from_binary_pdu (index, pdu, pdu_len, error);
-    g_free (pdu);
+    if (pdu != buf)
+        g_free (pdu);
 
     return part;
 }
@@ -360,6 +374,7 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
     guint tp_dcs_offset = 0;
     guint tp_user_data_len_offset = 0;
     MMSmsEncoding user_data_encoding = MM_SMS_ENCODING_UNKNOWN;
+    char timestr[SMS_TIMESTAMP_LEN];
 
     /* Create the new MMSmsPart */
     sms_part = mm_sms_part_new (index, MM_SMS_PDU_TYPE_UNKNOWN);
@@ -485,8 +500,8 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         tp_dcs_offset = offset++;
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        mm_sms_part_set_timestamp (sms_part,
+                                   sms_decode_timestamp (&pdu[offset], timestr));
         offset += 7;
 
         tp_user_data_len_offset = offset;
@@ -537,13 +552,13 @@ mm_sms_part_3gpp_new_from_binary_pdu (guint index,
         PDU_SIZE_CHECK (offset + 15, "cannot read Timestamps/TP-STATUS"); /* 7+7+1=15 */
 
         /* ------ Timestamp (7 bytes) ------ */
-        mm_sms_part_take_timestamp (sms_part,
-                                    sms_decode_timestamp (&pdu[offset]));
+        mm_sms_part_set_timestamp (sms_part,
+                                   sms_decode_timestamp (&pdu[offset], timestr));
         offset += 7;
 
         /* ------ Discharge Timestamp (7 bytes) ------ */
-        mm_sms_part_take_discharge_timestamp (sms_part,
-                                              sms_decode_timestamp (&pdu[offset]));
+        mm_sms_part_set_discharge_timestamp (sms_part,
+                                             sms_decode_timestamp (&pdu[offset], timestr));
         offset += 7;
 
         /* ----- TP-STATUS (1 byte) ------ */
@@ -935,12 +950,31 @@ mm_sms_part_3gpp_get_submit_pdu (MMSmsPart *part,
     }
 
     if (mm_sms_part_get_encoding (part) == MM_SMS_ENCODING_GSM7) {
-        guint8 *unpacked, *packed;
-        guint32 unlen = 0, packlen = 0;
+        guint8 unpacked[GSM7_MAX_SEPTETS];
+        guint32 unlen = 0;
+        guint max_len;
+        const gchar *p;
+
+        /* Encode straight into septets, characters not in the GSM alphabet
+         * are skipped */
+        max_len = mm_sms_part_get_concat_sequence (part) ? GSM7_MAX_CONCAT_SEPTETS : GSM7_MAX_SEPTETS;
+        for (p = mm_sms_part_get_text (part); *p; p = g_utf8_next_char (p)) {
+            guint8 gsm[2];
+            guint n;
+
+            n = mm_charset_utf8_char_to_gsm (p, g_utf8_next_char (p) - p, gsm);
+            if (unlen + n > max_len) {
+                g_set_error_literal (error,
+                                     MM_MESSAGE_ERROR,
+                                     MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
+                                     "Message text too long for a single PDU");
+                goto error;
+            }
+            memcpy (&unpacked[unlen], gsm, n);
+            unlen += n;
+        }
 
-        unpacked = mm_charset_utf8_to_unpacked_gsm (mm_sms_part_get_text (part), &unlen);
-        if (!unpacked || unlen == 0) {
-            g_free (unpacked);
+        if (unlen == 0) {
             g_set_error_literal (error,
                                  MM_MESSAGE_ERROR,
                                  MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
@@ -956,45 +990,46 @@ mm_sms_part_3gpp_get_submit_pdu (MMSmsPart *part,
                 *udl_ptr,
                 mm_sms_part_get_concat_sequence (part) ? "with" : "without");
 
-        packed = gsm_pack (unpacked, unlen, shift, &packlen);
-        g_free (unpacked);
-        if (!packed || packlen == 0) {
-            g_free (packed);
-            g_set_error_literal (error,
-                                 MM_MESSAGE_ERROR,
-                                 MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
-                                 "Failed to pack message text to GSM");
-            goto error;
-        }
-
-        memcpy (&pdu[offset], packed, packlen);
-        g_free (packed);
-        offset += packlen;
+        gsm_pack_buffer (unpacked, unlen, shift, &pdu[offset]);
+        offset += gsm_packed_len (unlen, shift);
     } else if (mm_sms_part_get_encoding (part) == MM_SMS_ENCODING_UCS2) {
-        GByteArray *array;
-
-        /* Try to guess a good value for the array */
-        array = g_byte_array_sized_new (strlen (mm_sms_part_get_text (part)) * 2);
-        if (!mm_modem_charset_byte_array_append (array, mm_sms_part_get_text (part), FALSE, MM_MODEM_CHARSET_UCS2)) {
-            g_byte_array_free (array, TRUE);
-            g_set_error_literal (error,
-                                 MM_MESSAGE_ERROR,
-                                 MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
-                                 "Failed to convert message text to UCS2");
-            goto error;
+        guint max_len;
+        guint ud_len = 0;
+        const gchar *p;
+
+        /* Encode straight into the PDU, UCS-2 is big endian */
+        max_len = mm_sms_part_get_concat_sequence (part) ? SMS_MAX_CONCAT_USER_DATA_LEN : SMS_MAX_USER_DATA_LEN;
+        for (p = mm_sms_part_get_text (part); *p; p = g_utf8_next_char (p)) {
+            gunichar c;
+
+            c = g_utf8_get_char (p);
+            if (c > 0xFFFF) {
+                g_set_error_literal (error,
+                                     MM_MESSAGE_ERROR,
+                                     MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
+                                     "Failed to convert message text to UCS2");
+                goto error;
+            }
+            if (ud_len + 2 > max_len) {
+                g_set_error_literal (error,
+                                     MM_MESSAGE_ERROR,
+                                     MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,
+                                     "Message text too long for a single PDU");
+                goto error;
+            }
+            pdu[offset + ud_len++] = (guint8) (c >> 8);
+            pdu[offset + ud_len++] = (guint8) (c & 0xFF);
         }
 
         /* Set real data length, in octets
          * If we had UDH, add 6 octets
          */
-        *udl_ptr = mm_sms_part_get_concat_sequence (part) ? (6 + array->len) : array->len;
+        *udl_ptr = mm_sms_part_get_concat_sequence (part) ? (6 + ud_len) : ud_len;
         mm_dbg ("  user data length is '%u' octets (%s UDH)",
                 *udl_ptr,
                 mm_sms_part_get_concat_sequence (part) ? "with" : "without");
 
-        memcpy (&pdu[offset], array->data, array->len);
-        offset += array->len;
-        g_byte_array_free (array, TRUE);
+        offset += ud_len;
     } else if (mm_sms_part_get_encoding (part) == MM_SMS_ENCODING_8BIT) {
         const GByteArray *data;
 
@@ -1022,110 +1057,122 @@ error:
     return NULL;
 }
 
+static gchar **
+split_text_at (const gchar *text,
+               gsize text_len,
+               GArray *breaks)
+{
+    gchar **out;
+    guint i;
+
+    out = g_new0 (gchar *, breaks->len + 2);
+    for (i = 0; i <= breaks->len; i++) {
+        gsize start;
+        gsize end;
+
+        start = i > 0 ? g_array_index (breaks, gsize, i - 1) : 0;
+        end = i < breaks->len ? g_array_index (breaks, gsize, i) : text_len;
+        out[i] = g_strndup (&text[start], end - start);
+    }
+    return out;
+}
+
 gchar **
 mm_sms_part_3gpp_util_split_text (const gchar *text,
                                   MMSmsEncoding *encoding)
 {
-    guint gsm_unsupported = 0;
-    gchar **out;
-    guint n_chunks;
-    guint i;
-    guint j;
-    gsize in_len;
+    GArray *gsm_breaks;
+    GArray *ucs2_breaks;
+    gboolean gsm_supported = TRUE;
+    guint gsm_len = 0;
+    guint gsm_chunk_len = 0;
+    guint ucs2_len = 0;
+    guint ucs2_chunk_len = 0;
+    const gchar *p;
+    gchar **out = NULL;
 
     if (!text)
         return NULL;
 
-    in_len = strlen (text);
-
     /* Some info about the rules for splitting.
      *
      * The User Data can be up to 140 bytes in the SMS part:
      *  0) If we only need one chunk, it can be of up to 140 bytes.
      *     If we need more than one chunk, these have to be of 140 - 6 = 134
      *     bytes each, as we need place for the UDH header.
-     *  1) If we're using GSM7 encoding, this gives us up to 160 characters,
+     *  1) If we're using GSM7 encoding, this gives us up to 160 septets,
      *     as we can pack 160 characters of 7bits each into 140 bytes.
      *      160 * 7 = 140 * 8 = 1120.
      *     If we only have 134 bytes allowed, that would mean that we can pack
-     *     up to 153 input characters:
+     *     up to 153 septets:
      *      134 * 8 = 1072; 1072/7=153.14
+     *     Characters of the extension table take 2 septets, and are never
+     *     split across chunks.
      *  2) If we're using UCS2 encoding, we can pack up to 70 characters in
      *     140 bytes (each with 2 bytes), or up to 67 characters in 134 bytes.
+     *     Note that there is no direct relationship between the size of the
+     *     input text in UTF-8 and the size of the text in UCS-2.
      *
      * This method does the split of the input string into N strings, so that
-     * each of the strings can be placed in a SMS part.
+     * each of the strings can be placed in a SMS part. The text is walked
+     * only once, finding where the chunks would start with each encoding
+     * while checking whether GSM7 is possible.
      */
 
-    /* Check if we can do GSM encoding */
-    mm_charset_get_encoded_len (text,
-                                MM_MODEM_CHARSET_GSM,
-                                &gsm_unsupported);
-    if (gsm_unsupported > 0) {
-        /* If cannot do it in GSM encoding, do it in UCS-2 */
-        GByteArray *array;
+    gsm_breaks = g_array_new (FALSE, FALSE, sizeof (gsize));
+    ucs2_breaks = g_array_new (FALSE, FALSE, sizeof (gsize));
 
-        *encoding = MM_SMS_ENCODING_UCS2;
+    for (p = text; *p; p = g_utf8_next_char (p)) {
+        gunichar c;
+        gsize offset;
 
-        /* Guess more or less the size of the output array to avoid multiple
-         * allocations */
-        array = g_byte_array_sized_new (in_len * 2);
-        if (!mm_modem_charset_byte_array_append (array,
-                                                 text,
-                                                 FALSE,
-                                                 MM_MODEM_CHARSET_UCS2)) {
-            g_byte_array_unref (array);
-            return NULL;
-        }
+        c = g_utf8_get_char_validated (p, -1);
+        /* Characters out of the BMP can't be encoded in UCS-2 */
+        if (c == (gunichar) -1 || c == (gunichar) -2 || c > 0xFFFF)
+            goto out;
 
-        /* Our bytearray has it in UCS-2 now.
-         * UCS-2 is a fixed-size encoding, which means that the text has exactly
-         * 2 bytes for each unicode point. We can now split this array into
-         * chunks of 67 UCS-2 characters (134 bytes).
-         *
-         * Note that UCS-2 covers unicode points between U+0000 and U+FFFF, which
-         * means that there is no direct relationship between the size of the
-         * input text in UTF-8 and the size of the text in UCS-2. A 3-byte UTF-8
-         * encoded character will still be represented with 2 bytes in UCS-2.
-         */
-        if (array->len <= 140) {
-            out = g_new (gchar *, 2);
-            out[0] = g_strdup (text);
-            out[1] = NULL;
-        } else {
-            n_chunks = array->len / 134;
-            if (array->len % 134 != 0)
-                n_chunks++;
-
-            out = g_new0 (gchar *, n_chunks + 1);
-            for (i = 0, j = 0; i < n_chunks; i++, j += 134) {
-                out[i] = sms_decode_text (&array->data[j],
-                                          MIN (array->len - j, 134),
-                                          MM_SMS_ENCODING_UCS2,
-                                          0);
+        offset = p - text;
+
+        if (gsm_supported) {
+            guint8 gsm[2];
+            guint n;
+
+            n = mm_charset_utf8_char_to_gsm (p, g_utf8_next_char (p) - p, gsm);
+            if (n == 0)
+                gsm_supported = FALSE;
+            else {
+                if (gsm_chunk_len + n > GSM7_MAX_CONCAT_SEPTETS) {
+                    g_array_append_val (gsm_breaks, offset);
+                    gsm_chunk_len = 0;
+                }
+                gsm_chunk_len += n;
+                gsm_len += n;
             }
         }
-        g_byte_array_unref (array);
-    } else {
-        /* Do it with GSM encoding */
-        *encoding = MM_SMS_ENCODING_GSM7;
 
-        if (in_len <= 160) {
-            out = g_new (gchar *, 2);
-            out[0] = g_strdup (text);
-            out[1] = NULL;
-        } else {
-            n_chunks = in_len / 153;
-            if (in_len % 153 != 0)
-                n_chunks++;
-
-            out = g_new0 (gchar *, n_chunks + 1);
-            for (i = 0, j = 0; i < n_chunks; i++, j += 153) {
-                out[i] = g_strndup (&text[j], 153);
-            }
+        if (ucs2_chunk_len + 2 > SMS_MAX_CONCAT_USER_DATA_LEN) {
+            g_array_append_val (ucs2_breaks, offset);
+            ucs2_chunk_len = 0;
         }
+        ucs2_chunk_len += 2;
+        ucs2_len += 2;
+    }
+
+    if (gsm_supported) {
+        *encoding = MM_SMS_ENCODING_GSM7;
+        if (gsm_len <= GSM7_MAX_SEPTETS)
+            g_array_set_size (gsm_breaks, 0);
+        out = split_text_at (text, p - text, gsm_breaks);
+    } else {
+        *encoding = MM_SMS_ENCODING_UCS2;
+        if (ucs2_len <= SMS_MAX_USER_DATA_LEN)
+            g_array_set_size (ucs2_breaks, 0);
+        out = split_text_at (text, p - text, ucs2_breaks);
     }
 
+out:
+    g_array_unref (gsm_breaks);
+    g_array_unref (ucs2_breaks);
     return out;
 }
 
@@ -229,34 +229,203 @@ encoding_to_string (Encoding encoding)
 }
 
 /*****************************************************************************/
-/* Read bits; o_bits < 8; n_bits <= 8
+/* Bit reader and writer
+ *
+ * Fields are packed most significant bit first, with no padding between
+ * them, so they may span byte boundaries:
  *
  * Byte 0            Byte 1
  * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
  *
- * o_bits+n_bits <= 16
- *
+ * Callers check with bit_reader_has() that the fields are there before
+ * reading them, so readers never go past the end of their data.
  */
-static guint8
-read_bits (const guint8 *bytes,
-           guint8 o_bits,
-           guint8 n_bits)
+
+typedef struct {
+    const guint8 *data;
+    guint len;     /* in bytes */
+    guint offset;  /* in bits */
+} BitReader;
+
+static inline void
+bit_reader_init (BitReader *reader,
+                 const guint8 *data,
+                 guint len)
+{
+    reader->data = data;
+    reader->len = len;
+    reader->offset = 0;
+}
+
+static inline gboolean
+bit_reader_has (const BitReader *reader,
+                guint n_bits)
+{
+    return reader->offset + n_bits <= reader->len * 8;
+}
+
+/* Bytes needed from the start of the data to read n_bits more */
+static inline guint
+bit_reader_required_len (const BitReader *reader,
+                         guint n_bits)
+{
+    return (reader->offset + n_bits + 7) / 8;
+}
+
+/* n_bits <= 16 */
+static inline guint16
+bit_reader_read (BitReader *reader,
+                 guint n_bits)
+{
+    guint byte;
+    guint shift;
+    guint32 window;
+
+    g_assert (n_bits > 0 && n_bits <= 16);
+    g_assert (bit_reader_has (reader, n_bits));
+
+    byte = reader->offset / 8;
+    shift = reader->offset % 8;
+
+    /* The field spans at most 3 bytes */
+    window = (guint32) reader->data[byte] << 16;
+    if (shift + n_bits > 8)
+        window |= (guint32) reader->data[byte + 1] << 8;
+    if (shift + n_bits > 16)
+        window |= (guint32) reader->data[byte + 2];
+
+    reader->offset += n_bits;
+    return (guint16) ((window >> (24 - shift - n_bits)) & ((1 << n_bits) - 1));
+}
+
+/* Reads n fields of n_bits <= 8 each, one per output byte */
+static inline void
+bit_reader_read_array (BitReader *reader,
+                       guint n_bits,
+                       guint n,
+                       guint8 *out)
+{
+    const guint8 *p;
+    guint32 acc;
+    guint acc_bits;
+    guint i;
+
+    g_assert (n_bits > 0 && n_bits <= 8);
+    g_assert (bit_reader_has (reader, n * n_bits));
+
+    if (n == 0)
+        return;
+
+    p = &reader->data[reader->offset / 8];
+
+    if (n_bits == 8 && reader->offset % 8 == 0) {
+        memcpy (out, p, n);
+        reader->offset += n * 8;
+        return;
+    }
+
+    /* Keep the bits not yet consumed in an accumulator, refilled a whole
+     * byte at a time */
+    acc_bits = 8 - reader->offset % 8;
+    acc = *p++ & ((1 << acc_bits) - 1);
+    for (i = 0; i < n; i++) {
+        if (acc_bits < n_bits) {
+            acc = (acc << 8) | *p++;
+            acc_bits += 8;
+        }
+        acc_bits -= n_bits;
+        out[i] = (guint8) (acc >> acc_bits);
+        acc &= (1 << acc_bits) - 1;
+    }
+    reader->offset += n * n_bits;
+}
+
+typedef struct {
+    guint8 *data;  /* must be zero-initialized */
+    guint offset;  /* in bits */
+} BitWriter;
+
+static inline void
+bit_writer_init (BitWriter *writer,
+                 guint8 *data)
+{
+    writer->data = data;
+    writer->offset = 0;
+}
+
+/* Bytes written so far, the last one maybe partially */
+static inline guint
+bit_writer_get_len (const BitWriter *writer)
+{
+    return (writer->offset + 7) / 8;
+}
+
+/* n_bits <= 16 */
+static inline void
+bit_writer_write (BitWriter *writer,
+                  guint n_bits,
+                  guint16 value)
+{
+    guint byte;
+    guint shift;
+    guint32 window;
+
+    g_assert (n_bits > 0 && n_bits <= 16);
+
+    byte = writer->offset / 8;
+    shift = writer->offset % 8;
+
+    window = ((guint32) value & ((1 << n_bits) - 1)) << (24 - shift - n_bits);
+    writer->data[byte] |= (guint8) (window >> 16);
+    if (shift + n_bits > 8)
+        writer->data[byte + 1] |= (guint8) (window >> 8);
+    if (shift + n_bits > 16)
+        writer->data[byte + 2] |= (guint8) window;
+
+    writer->offset += n_bits;
+}
+
+/* Writes n fields of n_bits <= 8 each, taken one per input byte */
+static inline void
+bit_writer_write_array (BitWriter *writer,
+                        guint n_bits,
+                        guint n,
+                        const guint8 *in)
 {
-    guint8 bits_in_first;
-    guint8 bits_in_second;
+    guint8 *p;
+    guint32 acc;
+    guint acc_bits;
+    guint i;
+
+    g_assert (n_bits > 0 && n_bits <= 8);
+
+    if (n == 0)
+        return;
 
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
+    p = &writer->data[writer->offset / 8];
 
-    /* Read only from the first byte */
-    if (o_bits + n_bits <= 8)
-        return (bytes[0] >> (8 - o_bits - n_bits)) & ((1 << n_bits) - 1);
+    if (n_bits == 8 && writer->offset % 8 == 0) {
+        memcpy (p, in, n);
+        writer->offset += n * 8;
+        return;
+    }
 
-    /* Read (8 - o_bits) from the first byte and (n_bits - (8 - o_bits)) from the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-    return (read_bits (&bytes[0], o_bits, bits_in_first) << bits_in_second) | read_bits (&bytes[1], 0, bits_in_second);
+    /* Start with the bits already written in the current byte, and flush
+     * whole bytes as they get filled */
+    acc_bits = writer->offset % 8;
+    acc = *p >> (8 - acc_bits);
+    for (i = 0; i < n; i++) {
+        acc = (acc << n_bits) | (in[i] & ((1 << n_bits) - 1));
+        acc_bits += n_bits;
+        if (acc_bits >= 8) {
+            acc_bits -= 8;
+            *p++ = (guint8) (acc >> acc_bits);
+            acc &= (1 << acc_bits) - 1;
+        }
+    }
+    if (acc_bits)
+        *p = (guint8) (acc << (8 - acc_bits));
+    writer->offset += n * n_bits;
 }
 
 /*****************************************************************************/
@@ -314,12 +483,13 @@ mm_sms_part_cdma_new_from_pdu (guint index,
                                const gchar *hexpdu,
                                GError **error)
 {
+    guint8 buf[SMS_PART_MAX_PDU_LEN];
     gsize pdu_len;
     guint8 *pdu;
     MMSmsPart *part;
 
     /* Convert PDU from hex to binary */
-    pdu = (guint8 *) mm_utils_hexstr2bin (hexpdu, &pdu_len);
+    pdu = mm_sms_part_pdu_from_hex (hexpdu, buf, sizeof (buf), &pdu_len);
     if (!pdu) {
         g_set_error_literal (error,
                              MM_CORE_ERROR,
@@ -329,7 +499,8 @@ mm_sms_part_cdma_new_from_pdu (guint index,
     }
 
     part = mm_sms_part_cdma_new_from_binary_pdu (index, pdu, pdu_len, error);
-    g_free (pdu);
+    if (pdu != buf)
+        g_free (pdu);
 
     return part;
 }
@@ -465,39 +636,32 @@ static void
 read_address (MMSmsPart *sms_part,
               const struct Parameter *parameter)
 {
+    BitReader reader;
     guint8 digit_mode;
     guint8 number_mode;
     guint8 number_type;
     guint8 numbering_plan;
     guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
+    guint8 fields[G_MAXUINT8];
+    /* Large enough for the hex string of a binary address */
+    gchar number[2 * G_MAXUINT8 + 1];
     guint i;
-    gchar *number = NULL;
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
-#define PARAMETER_SIZE_CHECK(required_size)                             \
-    if (parameter->parameter_len < required_size) {                     \
+#define PARAMETER_SIZE_CHECK(n_bits)                                    \
+    if (!bit_reader_has (&reader, n_bits)) {                            \
         mm_dbg ("        cannot read address, need at least %u bytes (got %u)", \
-                required_size,                                          \
+                bit_reader_required_len (&reader, n_bits),              \
                 parameter->parameter_len);                              \
         return;                                                         \
     }
 
+    bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+
     /* Readability of digit mode and number mode (first 2 bits, i.e. first byte) */
-    PARAMETER_SIZE_CHECK (1);
+    PARAMETER_SIZE_CHECK (2);
 
     /* Digit mode */
-    digit_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
-    g_assert (digit_mode <= 1);
+    digit_mode = bit_reader_read (&reader, 1);
     switch (digit_mode) {
     case DIGIT_MODE_DTMF:
         mm_dbg ("        digit mode: dtmf");
@@ -510,8 +674,7 @@ read_address (MMSmsPart *sms_part,
     }
 
     /* Number mode */
-    number_mode = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 1);
-    OFFSETS_UPDATE (1);
+    number_mode = bit_reader_read (&reader, 1);
     switch (number_mode) {
     case NUMBER_MODE_DIGIT:
         mm_dbg ("        number mode: digit");
@@ -526,8 +689,7 @@ read_address (MMSmsPart *sms_part,
     /* Number type */
     if (digit_mode == DIGIT_MODE_ASCII) {
         /* No need for readability check, still in first byte always */
-        number_type = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 3);
-        OFFSETS_UPDATE (3);
+        number_type = bit_reader_read (&reader, 3);
         switch (number_type) {
         case NUMBER_TYPE_UNKNOWN:
             mm_dbg ("        number type: unknown");
@@ -557,9 +719,8 @@ read_address (MMSmsPart *sms_part,
     /* Numbering plan */
     if (digit_mode == DIGIT_MODE_ASCII && number_mode == NUMBER_MODE_DIGIT) {
         /* Readability of numbering plan; may go to second byte */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 4) / 8));
-        numbering_plan = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4);
-        OFFSETS_UPDATE (4);
+        PARAMETER_SIZE_CHECK (4);
+        numbering_plan = bit_reader_read (&reader, 4);
         switch (numbering_plan) {
         case NUMBERING_PLAN_UNKNOWN:
             mm_dbg ("        numbering plan: unknown");
@@ -583,63 +744,49 @@ read_address (MMSmsPart *sms_part,
     } else
         numbering_plan = 0xFF;
 
-    /* Readability of num_fields; will go to third byte (((bit_offset + 8) / 8) == 1) */
-    PARAMETER_SIZE_CHECK (byte_offset + 2);
-    num_fields = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    /* Readability of num_fields */
+    PARAMETER_SIZE_CHECK (8);
+    num_fields = bit_reader_read (&reader, 8);
     mm_dbg ("        num fields: %u", num_fields);
 
     /* Address string */
 
     if (digit_mode == DIGIT_MODE_DTMF) {
         /* DTMF */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 4)) / 8));
-        number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = dtmf_to_ascii (read_bits (&parameter->parameter_value[byte_offset], bit_offset, 4));
-            OFFSETS_UPDATE (4);
-        }
+        PARAMETER_SIZE_CHECK (num_fields * 4);
+        bit_reader_read_array (&reader, 4, num_fields, fields);
+        for (i = 0; i < num_fields; i++)
+            number[i] = dtmf_to_ascii (fields[i]);
         number[i] = '\0';
-    } else if (number_mode == NUMBER_MODE_DIGIT) {
-        /* ASCII
+    } else if (number_mode == NUMBER_MODE_DIGIT ||
+               number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
+        /* ASCII, or Internet e-mail address (ASCII)
          * TODO: should we expose numbering plan and number type? */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
-    } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_EMAIL_ADDRESS) {
-        /* Internet e-mail address (ASCII) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        number = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            number[i] = read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        number[i] = '\0';
+        PARAMETER_SIZE_CHECK (num_fields * 8);
+        bit_reader_read_array (&reader, 8, num_fields, (guint8 *) number);
+        number[num_fields] = '\0';
     } else if (number_type == DATA_NETWORK_ADDRESS_TYPE_INTERNET_PROTOCOL) {
-        GString *str;
+        static const gchar hex[] = "0123456789ABCDEF";
 
         /* Binary data network address (most significant first)
-         * For now, just print the hex string (e.g. FF:01...) */
-        PARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
-        str = g_string_sized_new (num_fields * 2);
+         * For now, just print the hex string (e.g. FF01...) */
+        PARAMETER_SIZE_CHECK (num_fields * 8);
+        bit_reader_read_array (&reader, 8, num_fields, fields);
         for (i = 0; i < num_fields; i++) {
-            g_string_append_printf (str, "%.2X", read_bits (&parameter->parameter_value[byte_offset], bit_offset, 8));
-            OFFSETS_UPDATE (8);
+            number[2 * i] = hex[fields[i] >> 4];
+            number[2 * i + 1] = hex[fields[i] & 0x0F];
         }
-        number = g_string_free (str, FALSE);
-    } else
+        number[2 * i] = '\0';
+    } else {
         mm_dbg ("        data network address number type unknown (%u)", number_type);
+        mm_sms_part_set_number (sms_part, NULL);
+        return;
+    }
 
     mm_dbg ("        address: %s", number);
 
     mm_sms_part_set_number (sms_part, number);
-    g_free (number);
 
-#undef OFFSETS_UPDATE
 #undef PARAMETER_SIZE_CHECK
 }
 
@@ -647,6 +794,7 @@ static void
 read_bearer_reply_option (MMSmsPart *sms_part,
                           const struct Parameter *parameter)
 {
+    BitReader reader;
     guint8 sequence;
 
     g_assert (parameter->parameter_id == PARAMETER_ID_BEARER_REPLY_OPTION);
@@ -657,7 +805,8 @@ read_bearer_reply_option (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+    sequence = bit_reader_read (&reader, 6);
     mm_dbg ("        sequence: %u", sequence);
 
     mm_sms_part_set_message_reference (sms_part, sequence);
@@ -667,6 +816,7 @@ static void
 read_cause_codes (MMSmsPart *sms_part,
                   const struct Parameter *parameter)
 {
+    BitReader reader;
     guint8 sequence;
     guint8 error_class;
     guint8 cause_code;
@@ -680,10 +830,11 @@ read_cause_codes (MMSmsPart *sms_part,
         return;
     }
 
-    sequence = read_bits (&parameter->parameter_value[0], 0, 6);
+    bit_reader_init (&reader, parameter->parameter_value, parameter->parameter_len);
+    sequence = bit_reader_read (&reader, 6);
     mm_dbg ("        sequence: %u", sequence);
 
-    error_class = read_bits (&parameter->parameter_value[0], 6, 2);
+    error_class = bit_reader_read (&reader, 2);
     mm_dbg ("        error class: %u", error_class);
 
     if (error_class != ERROR_CLASS_NO_ERROR) {
@@ -708,6 +859,7 @@ static void
 read_bearer_data_message_identifier (MMSmsPart *sms_part,
                                      const struct Parameter *subparameter)
 {
+    BitReader reader;
     guint8 message_type;
     guint16 message_id;
     guint8 header_ind;
@@ -720,7 +872,8 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
         return;
     }
 
-    message_type = read_bits (&subparameter->parameter_value[0], 0, 4);
+    bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+    message_type = bit_reader_read (&reader, 4);
     switch (message_type) {
     case TELESERVICE_MESSAGE_TYPE_UNKNOWN:
         mm_dbg ("            message type: unknown");
@@ -754,12 +907,10 @@ read_bearer_data_message_identifier (MMSmsPart *sms_part,
         break;
     }
 
-    message_id = ((read_bits (&subparameter->parameter_value[0], 4, 8) << 8) |
-                  (read_bits (&subparameter->parameter_value[1], 4, 8)));
-    message_id = GUINT16_FROM_BE (message_id);
+    message_id = bit_reader_read (&reader, 16);
     mm_dbg ("            message id: %u", (guint) message_id);
 
-    header_ind = read_bits (&subparameter->parameter_value[2], 4, 1);
+    header_ind = bit_reader_read (&reader, 1);
     mm_dbg ("            header indicator: %u", header_ind);
 }
 
@@ -767,64 +918,50 @@ static void
 read_bearer_data_user_data (MMSmsPart *sms_part,
                             const struct Parameter *subparameter)
 {
+    BitReader reader;
     guint8 message_encoding;
     guint8 message_type = 0;
     guint8 num_fields;
-    guint byte_offset = 0;
-    guint bit_offset = 0;
-
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
-#define SUBPARAMETER_SIZE_CHECK(required_size)                             \
-    if (subparameter->parameter_len < required_size) {                  \
+
+#define SUBPARAMETER_SIZE_CHECK(n_bits)                                 \
+    if (!bit_reader_has (&reader, n_bits)) {                            \
         mm_dbg ("        cannot read user data, need at least %u bytes (got %u)", \
-                required_size,                                          \
+                bit_reader_required_len (&reader, n_bits),              \
                 subparameter->parameter_len);                           \
         return;                                                         \
     }
 
     g_assert (subparameter->parameter_id == SUBPARAMETER_ID_USER_DATA);
 
+    bit_reader_init (&reader, subparameter->parameter_value, subparameter->parameter_len);
+
     /* Message encoding */
-    SUBPARAMETER_SIZE_CHECK (1);
-    message_encoding = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 5);
-    OFFSETS_UPDATE (5);
+    SUBPARAMETER_SIZE_CHECK (5);
+    message_encoding = bit_reader_read (&reader, 5);
     mm_dbg ("            message encoding: %s", encoding_to_string (message_encoding));
 
     /* Message type, only if extended protocol message */
     if (message_encoding == ENCODING_EXTENDED_PROTOCOL_MESSAGE) {
-        SUBPARAMETER_SIZE_CHECK (2);
-        message_type = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-        OFFSETS_UPDATE (8);
+        SUBPARAMETER_SIZE_CHECK (8);
+        message_type = bit_reader_read (&reader, 8);
         mm_dbg ("            message type: %u", message_type);
     }
 
     /* Number of fields */
-    SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + 8) / 8));
-    num_fields = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-    OFFSETS_UPDATE (8);
+    SUBPARAMETER_SIZE_CHECK (8);
+    num_fields = bit_reader_read (&reader, 8);
     mm_dbg ("            num fields: %u", num_fields);
 
     /* Now, process actual text or data */
     switch (message_encoding) {
     case ENCODING_OCTET: {
         GByteArray *data;
-        guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        SUBPARAMETER_SIZE_CHECK (num_fields * 8);
 
         data = g_byte_array_sized_new (num_fields);
         g_byte_array_set_size (data, num_fields);
-        for (i = 0; i < num_fields; i++) {
-            data->data[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
+        bit_reader_read_array (&reader, 8, num_fields, data->data);
 
         mm_dbg ("            data: (%u bytes)", num_fields);
         mm_sms_part_take_data (sms_part, data);
@@ -833,16 +970,12 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
 
     case ENCODING_ASCII_7BIT: {
         gchar *text;
-        guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 7)) / 8));
+        SUBPARAMETER_SIZE_CHECK (num_fields * 7);
 
         text = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            text[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 7);
-            OFFSETS_UPDATE (7);
-        }
-        text[i] = '\0';
+        bit_reader_read_array (&reader, 7, num_fields, (guint8 *) text);
+        text[num_fields] = '\0';
 
         mm_dbg ("            text: '%s'", text);
         mm_sms_part_take_text (sms_part, text);
@@ -850,57 +983,43 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
     }
 
     case ENCODING_LATIN: {
-        gchar *latin;
+        guint8 latin[G_MAXUINT8 + 1];
         gchar *text;
-        guint i;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_fields * 8)) / 8));
+        SUBPARAMETER_SIZE_CHECK (num_fields * 8);
 
-        latin = g_malloc (num_fields + 1);
-        for (i = 0; i < num_fields; i++) {
-            latin[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
-        latin[i] = '\0';
+        bit_reader_read_array (&reader, 8, num_fields, latin);
+        latin[num_fields] = '\0';
 
-        text = g_convert (latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
+        text = g_convert ((const gchar *) latin, -1, "UTF-8", "ISO−8859−1", NULL, NULL, NULL);
         if (!text) {
             mm_dbg ("            text/data: ignored (latin to UTF-8 conversion error)");
         } else {
             mm_dbg ("            text: '%s'", text);
             mm_sms_part_take_text (sms_part, text);
         }
-
-        g_free (latin);
         break;
     }
 
     case ENCODING_UNICODE: {
-        gchar *utf16;
+        guint8 utf16[2 * G_MAXUINT8];
         gchar *text;
-        guint i;
         guint num_bytes;
 
         /* 2 bytes per field! */
         num_bytes = num_fields * 2;
 
-        SUBPARAMETER_SIZE_CHECK (byte_offset + 1 + ((bit_offset + (num_bytes * 8)) / 8));
+        SUBPARAMETER_SIZE_CHECK (num_bytes * 8);
 
-        utf16 = g_malloc (num_bytes);
-        for (i = 0; i < num_bytes; i++) {
-            utf16[i] = read_bits (&subparameter->parameter_value[byte_offset], bit_offset, 8);
-            OFFSETS_UPDATE (8);
-        }
+        bit_reader_read_array (&reader, 8, num_bytes, utf16);
 
-        text = g_convert (utf16, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
+        text = g_convert ((const gchar *) utf16, num_bytes, "UTF-8", "UCS-2BE", NULL, NULL, NULL);
         if (!text) {
             mm_dbg ("            text/data: ignored (UTF-16 to UTF-8 conversion error)");
         } else {
             mm_dbg ("            text: '%s'", text);
             mm_sms_part_take_text (sms_part, text);
         }
-
-        g_free (utf16);
         break;
     }
 
@@ -908,7 +1027,6 @@ read_bearer_data_user_data (MMSmsPart *sms_part,
         mm_dbg ("            text/data: ignored (unsupported encoding)");
     }
 
-#undef OFFSETS_UPDATE
 #undef SUBPARAMETER_SIZE_CHECK
 }
 
@@ -1153,43 +1271,6 @@ mm_sms_part_cdma_new_from_binary_pdu (guint index,
     return sms_part;
 }
 
-/*****************************************************************************/
-/* Write bits; o_bits < 8; n_bits <= 8
- *
- * Byte 0            Byte 1
- * [7|6|5|4|3|2|1|0] [7|6|5|4|3|2|1|0]
- *
- * o_bits+n_bits <= 16
- *
- * NOTE! The bits being set should be 0 initially.
- */
-static void
-write_bits (guint8 *bytes,
-            guint8 o_bits,
-            guint8 n_bits,
-            guint8 bits)
-{
-    guint8 bits_in_first;
-    guint8 bits_in_second;
-
-    g_assert (o_bits < 8);
-    g_assert (n_bits <= 8);
-    g_assert (o_bits + n_bits <= 16);
-
-    /* Write only in the first byte */
-    if (o_bits + n_bits <= 8) {
-        bytes[0] |= (bits & ((1 << n_bits) - 1)) << (8 - o_bits - n_bits);
-        return;
-    }
-
-    /* Write (8 - o_bits) in the first byte and (n_bits - (8 - o_bits)) in the second byte */
-    bits_in_first = 8 - o_bits;
-    bits_in_second = n_bits - bits_in_first;
-
-    write_bits (&bytes[0], o_bits, bits_in_first, (bits >> bits_in_second));
-    write_bits (&bytes[1], 0, bits_in_second, bits);
-}
-
 /*****************************************************************************/
 
 static guint8
@@ -1248,63 +1329,51 @@ write_destination_address (MMSmsPart *part,
                            guint *absolute_offset,
                            GError **error)
 {
+    BitWriter writer;
     const gchar *number;
-    guint bit_offset;
-    guint byte_offset;
+    guint8 dtmf[G_MAXUINT8];
     guint n_digits;
+    guint len;
     guint i;
 
     mm_dbg ("    writing destination address...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     number = mm_sms_part_get_number (part);
     n_digits = strlen (number);
 
     pdu[0] = PARAMETER_ID_DESTINATION_ADDRESS;
     /* Write parameter length at the end */
 
-    byte_offset = 2;
-    bit_offset = 0;
+    bit_writer_init (&writer, &pdu[2]);
 
     /* Digit mode: DTMF always */
     mm_dbg ("        digit mode: dtmf");
-    write_bits (&pdu[byte_offset], bit_offset, 1, DIGIT_MODE_DTMF);
-    OFFSETS_UPDATE (1);
+    bit_writer_write (&writer, 1, DIGIT_MODE_DTMF);
 
     /* Number mode: DIGIT always */
     mm_dbg ("        number mode: digit");
-    write_bits (&pdu[byte_offset], bit_offset, 1, NUMBER_MODE_DIGIT);
-    OFFSETS_UPDATE (1);
+    bit_writer_write (&writer, 1, NUMBER_MODE_DIGIT);
 
     /* Number type and numbering plan only needed in ASCII digit mode, so skip */
 
     /* Number of fields */
-    if (n_digits > 256) {
+    if (n_digits > G_MAXUINT8) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Number too long (max 256 digits, %u given)",
+                     "Number too long (max %u digits, %u given)",
+                     G_MAXUINT8,
                      n_digits);
         return FALSE;
     }
     mm_dbg ("        num fields: %u", n_digits);
-    write_bits (&pdu[byte_offset], bit_offset, 8, n_digits);
-    OFFSETS_UPDATE (8);
+    bit_writer_write (&writer, 8, n_digits);
 
     /* Actual DTMF encoded number */
     mm_dbg ("        address: %s", number);
     for (i = 0; i < n_digits; i++) {
-        guint8 dtmf;
-
-        dtmf = dtmf_from_ascii (number[i]);
-        if (!dtmf) {
+        dtmf[i] = dtmf_from_ascii (number[i]);
+        if (!dtmf[i]) {
             g_set_error (error,
                          MM_CORE_ERROR,
                          MM_CORE_ERROR_UNSUPPORTED,
@@ -1312,23 +1381,13 @@ write_destination_address (MMSmsPart *part,
                          number[i]);
             return FALSE;
         }
-        write_bits (&pdu[byte_offset], bit_offset, 4, dtmf);
-        OFFSETS_UPDATE (4);
     }
+    bit_writer_write_array (&writer, 4, n_digits, dtmf);
 
-#undef OFFSETS_UPDATE
-
-    /* Write parameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
-        g_set_error (error,
-                     MM_CORE_ERROR,
-                     MM_CORE_ERROR_UNSUPPORTED,
-                     "Number too long (max 256 bytes, %u given)",
-                     byte_offset);
-        return FALSE;
-    }
-    pdu[1] = byte_offset;
+    /* Write parameter length */
+    len = bit_writer_get_len (&writer);
+    g_assert (len <= G_MAXUINT8);
+    pdu[1] = len;
 
     *absolute_offset += (2 + pdu[1]);
     return TRUE;
@@ -1340,13 +1399,16 @@ write_bearer_data_message_identifier (MMSmsPart *part,
                                       guint *parameter_offset,
                                       GError **error)
 {
+    BitWriter writer;
+
     pdu[0] = SUBPARAMETER_ID_MESSAGE_ID;
     pdu[1] = 3; /* subparameter_len, always 3 */
 
     mm_dbg ("        writing message identifier: submit");
 
     /* Message type */
-    write_bits (&pdu[2], 0, 4, TELESERVICE_MESSAGE_TYPE_SUBMIT);
+    bit_writer_init (&writer, &pdu[2]);
+    bit_writer_write (&writer, 4, TELESERVICE_MESSAGE_TYPE_SUBMIT);
 
     /* Skip adding a message id; assume it's filled in by device */
 
@@ -1421,28 +1483,18 @@ write_bearer_data_user_data (MMSmsPart *part,
                              guint *parameter_offset,
                              GError **error)
 {
+    BitWriter writer;
     const gchar *text;
     const GByteArray *data;
-    guint bit_offset = 0;
-    guint byte_offset = 0;
     guint num_fields;
     guint num_bits_per_field;
-    guint i;
+    guint len;
     Encoding encoding;
     GByteArray *converted = NULL;
     const GByteArray *aux;
-    guint num_bits_per_iter;
 
     mm_dbg ("        writing user data...");
 
-#define OFFSETS_UPDATE(n_bits) do { \
-        bit_offset += n_bits;       \
-        if (bit_offset >= 8) {      \
-            bit_offset-=8;          \
-            byte_offset++;          \
-        }                           \
-    } while (0)
-
     text = mm_sms_part_get_text (part);
     data = mm_sms_part_get_data (part);
     g_assert (text || data);
@@ -1450,8 +1502,7 @@ write_bearer_data_user_data (MMSmsPart *part,
 
     pdu[0] = SUBPARAMETER_ID_USER_DATA;
     /* Write parameter length at the end */
-    byte_offset = 2;
-    bit_offset = 0;
+    bit_writer_init (&writer, &pdu[2]);
 
     /* Text or Data */
     if (text) {
@@ -1468,54 +1519,52 @@ write_bearer_data_user_data (MMSmsPart *part,
         encoding = ENCODING_OCTET;
     }
 
-    /* Message encoding*/
-    mm_dbg ("            message encoding: %s", encoding_to_string (encoding));
-    write_bits (&pdu[byte_offset], bit_offset, 5, encoding);
-    OFFSETS_UPDATE (5);
-
     /* Number of fields */
-    if (num_fields > 256) {
+    if (num_fields > G_MAXUINT8) {
         if (converted)
             g_byte_array_unref (converted);
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Data too long (max 256 fields, %u given)",
+                     "Data too long (max %u fields, %u given)",
+                     G_MAXUINT8,
                      num_fields);
         return FALSE;
     }
+
+    /* Message encoding*/
+    mm_dbg ("            message encoding: %s", encoding_to_string (encoding));
+    bit_writer_write (&writer, 5, encoding);
+
     mm_dbg ("            num fields: %u", num_fields);
-    write_bits (&pdu[byte_offset], bit_offset, 8, num_fields);
-    OFFSETS_UPDATE (8);
+    bit_writer_write (&writer, 8, num_fields);
 
-    /* For ASCII-7, write 7 bits in each iteration; for the remaining ones
-     * go byte per byte */
+    /* For ASCII-7, write 7 bits per field; for the remaining ones go byte
+     * per byte */
     if (text)
         mm_dbg ("            text: '%s'", text);
     else
         mm_dbg ("            data: (%u bytes)", num_fields);
-    num_bits_per_iter = num_bits_per_field < 8 ? num_bits_per_field : 8;
-    for (i = 0; i < aux->len; i++) {
-        write_bits (&pdu[byte_offset], bit_offset, num_bits_per_iter, aux->data[i]);
-        OFFSETS_UPDATE (num_bits_per_iter);
-    }
+    bit_writer_write_array (&writer,
+                            num_bits_per_field < 8 ? num_bits_per_field : 8,
+                            aux->len,
+                            aux->data);
 
     if (converted)
         g_byte_array_unref (converted);
 
-#undef OFFSETS_UPDATE
-
-    /* Write subparameter length (remove header length to offset) */
-    byte_offset += !!bit_offset - 2;
-    if (byte_offset > 256) {
+    /* Write subparameter length */
+    len = bit_writer_get_len (&writer);
+    if (len > G_MAXUINT8) {
         g_set_error (error,
                      MM_CORE_ERROR,
                      MM_CORE_ERROR_UNSUPPORTED,
-                     "Data or Text too long (max 256 bytes, %u given)",
-                     byte_offset);
+                     "Data or Text too long (max %u bytes, %u given)",
+                     G_MAXUINT8,
+                     len);
         return FALSE;
     }
-    pdu[1] = byte_offset;
+    pdu[1] = len;
 
     *parameter_offset += (2 + pdu[1]);
     return TRUE;
@@ -17,6 +17,8 @@
 #include <ctype.h>
 #include <string.h>
 
+#include <string.h>
+
 #include <glib.h>
 
 #include <ModemManager.h>
@@ -27,13 +29,66 @@
 #include "mm-charsets.h"
 #include "mm-log.h"
 
+/* Numbers and timestamps are short enough to be stored in the part itself,
+ * saving one allocation each; longer values are still allocated */
+#define INLINE_STR_SIZE 24
+
+typedef struct {
+    /* Either NULL, 'buf' or an allocated string */
+    gchar *str;
+    gchar  buf[INLINE_STR_SIZE];
+} InlineStr;
+
+static void
+inline_str_clear (InlineStr *istr)
+{
+    if (istr->str != istr->buf)
+        g_free (istr->str);
+    istr->str = NULL;
+}
+
+static void
+inline_str_set (InlineStr *istr,
+                const gchar *value)
+{
+    gsize len;
+
+    if (value && value == istr->str)
+        return;
+
+    inline_str_clear (istr);
+    if (!value)
+        return;
+
+    len = strlen (value);
+    if (len < INLINE_STR_SIZE) {
+        memcpy (istr->buf, value, len + 1);
+        istr->str = istr->buf;
+    } else
+        istr->str = g_strdup (value);
+}
+
+static void
+inline_str_take (InlineStr *istr,
+                 gchar *value)
+{
+    if (value && strlen (value) < INLINE_STR_SIZE) {
+        inline_str_set (istr, value);
+        g_free (value);
+        return;
+    }
+
+    inline_str_clear (istr);
+    istr->str = value;
+}
+
 struct _MMSmsPart {
     guint index;
     MMSmsPduType pdu_type;
-    gchar *smsc;
-    gchar *timestamp;
-    gchar *discharge_timestamp;
-    gchar *number;
+    InlineStr smsc;
+    InlineStr timestamp;
+    InlineStr discharge_timestamp;
+    InlineStr number;
     gchar *text;
     MMSmsEncoding encoding;
     GByteArray *data;
@@ -57,10 +112,10 @@ struct _MMSmsPart {
 void
 mm_sms_part_free (MMSmsPart *self)
 {
-    g_free (self->discharge_timestamp);
-    g_free (self->timestamp);
-    g_free (self->smsc);
-    g_free (self->number);
+    inline_str_clear (&self->discharge_timestamp);
+    inline_str_clear (&self->timestamp);
+    inline_str_clear (&self->smsc);
+    inline_str_clear (&self->number);
     g_free (self->text);
     if (self->data)
         g_byte_array_unref (self->data);
@@ -99,18 +154,35 @@ mm_sms_part_free (MMSmsPart *self)
         self->name = value;                      \
     }
 
+#define PART_INLINE_STR_FUNCS(name)              \
+    const gchar *                                \
+    mm_sms_part_get_##name (MMSmsPart *self)     \
+    {                                            \
+        return self->name.str;                   \
+    }                                            \
+                                                 \
+    void                                         \
+    mm_sms_part_set_##name (MMSmsPart *self,     \
+                            const gchar *value)  \
+    {                                            \
+        inline_str_set (&self->name, value);     \
+    }                                            \
+                                                 \
+    void                                         \
+    mm_sms_part_take_##name (MMSmsPart *self,    \
+                             gchar *value)       \
+    {                                            \
+        inline_str_take (&self->name, value);    \
+    }
+
 PART_GET_FUNC (guint, index)
 PART_SET_FUNC (guint, index)
 PART_GET_FUNC (MMSmsPduType, pdu_type)
 PART_SET_FUNC (MMSmsPduType, pdu_type)
-PART_GET_FUNC (const gchar *, smsc)
-PART_SET_TAKE_STR_FUNC (smsc)
-PART_GET_FUNC (const gchar *, number)
-PART_SET_TAKE_STR_FUNC (number)
-PART_GET_FUNC (const gchar *, timestamp)
-PART_SET_TAKE_STR_FUNC (timestamp)
-PART_GET_FUNC (const gchar *, discharge_timestamp)
-PART_SET_TAKE_STR_FUNC (discharge_timestamp)
+PART_INLINE_STR_FUNCS (smsc)
+PART_INLINE_STR_FUNCS (number)
+PART_INLINE_STR_FUNCS (timestamp)
+PART_INLINE_STR_FUNCS (discharge_timestamp)
 PART_GET_FUNC (guint, concat_max)
 PART_SET_FUNC (guint, concat_max)
 PART_GET_FUNC (guint, concat_sequence)
@@ -171,6 +243,38 @@ PART_SET_FUNC (MMSmsCdmaTeleserviceId, cdma_teleservice_id)
 PART_GET_FUNC (MMSmsCdmaServiceCategory, cdma_service_category)
 PART_SET_FUNC (MMSmsCdmaServiceCategory, cdma_service_category)
 
+guint8 *
+mm_sms_part_pdu_from_hex (const gchar *hexpdu,
+                          guint8 *buf,
+                          gsize buf_size,
+                          gsize *out_len)
+{
+    guint8 *pdu;
+    gsize len;
+    gsize i;
+
+    len = strlen (hexpdu);
+    if (len % 2)
+        return NULL;
+    len /= 2;
+
+    pdu = (len <= buf_size) ? buf : g_malloc (len);
+    for (i = 0; i < len; i++) {
+        gint byte;
+
+        byte = mm_utils_hex2byte (&hexpdu[2 * i]);
+        if (byte < 0) {
+            if (pdu != buf)
+                g_free (pdu);
+            return NULL;
+        }
+        pdu[i] = (guint8) byte;
+    }
+
+    *out_len = len;
+    return pdu;
+}
+
 MMSmsPart *
 mm_sms_part_new (guint index,
                  MMSmsPduType pdu_type)
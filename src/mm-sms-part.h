@@ -43,6 +43,17 @@ MMSmsPart *mm_sms_part_new  (guint index,
                              MMSmsPduType type);
 void       mm_sms_part_free (MMSmsPart *part);
 
+/* Binary PDUs are at most this long; decoding into a buffer of this size
+ * avoids a heap allocation for each one */
+#define SMS_PART_MAX_PDU_LEN 256
+
+/* Decodes the hex PDU into 'buf' if it fits, or into a new buffer otherwise,
+ * which the caller must free if it isn't 'buf'. Returns NULL if not valid hex. */
+guint8 *mm_sms_part_pdu_from_hex (const gchar *hexpdu,
+                                  guint8 *buf,
+                                  gsize buf_size,
+                                  gsize *out_len);
+
 guint             mm_sms_part_get_index              (MMSmsPart *part);
 void              mm_sms_part_set_index              (MMSmsPart *part,
                                                       guint index);
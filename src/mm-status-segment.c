@@ -0,0 +1,356 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <glib/gstdio.h>
+
+#include <ModemManager.h>
+#include <ModemManager-status.h>
+#include <mm-errors-types.h>
+
+#include "mm-status-segment.h"
+#include "mm-iface-modem.h"
+#include "mm-iface-modem-3gpp.h"
+#include "mm-bearer-list.h"
+#include "mm-base-bearer.h"
+#include "mm-log.h"
+
+#define SEGMENT_SIZE(n) (sizeof (MMStatusSegmentHeader) + (n) * sizeof (MMStatusRecord))
+
+static gchar          *segment_path;
+static guint8         *segment;
+static MMStatusRecord *records;
+static guint           n_records;
+/* Modem owning each record, not referenced */
+static MMBaseModem   **owners;
+static gboolean        full_warned;
+
+static gboolean segment_publish (const gchar  *path,
+                                 guint         n,
+                                 GError      **error);
+
+/*****************************************************************************/
+
+/* Number at the end of a DBus object path */
+static guint32
+path_index (const gchar *path)
+{
+    const gchar *str;
+
+    str = strrchr (path, '/');
+    return str ? (guint32) g_ascii_strtoull (str + 1, NULL, 10) : 0;
+}
+
+static void
+record_write (guint                 i,
+              const MMStatusRecord *record)
+{
+    MMStatusRecord *shared;
+
+    shared = &records[i];
+
+    /* Odd sequence while the contents change; the atomic increments are
+     * full barriers, so readers never see the new contents with the old even
+     * sequence */
+    g_atomic_int_inc ((gint *) &shared->sequence);
+    memcpy ((guint8 *) shared + sizeof (shared->sequence),
+            (const guint8 *) record + sizeof (record->sequence),
+            sizeof (MMStatusRecord) - sizeof (record->sequence));
+    g_atomic_int_inc ((gint *) &shared->sequence);
+}
+
+static void
+record_release (guint i)
+{
+    MMStatusRecord record;
+
+    memset (&record, 0, sizeof (record));
+    record.updates = records[i].updates + 1;
+    record_write (i, &record);
+    owners[i] = NULL;
+}
+
+static void
+modem_finalized_cb (gpointer  user_data,
+                    GObject  *where_the_object_was)
+{
+    guint i;
+
+    i = GPOINTER_TO_UINT (user_data);
+    if (records && owners[i] == (MMBaseModem *) where_the_object_was)
+        record_release (i);
+}
+
+/* Record of the modem, allocating a new one if needed; -1 if the segment
+ * is full and couldn't grow */
+static gint
+record_lookup (MMBaseModem *modem)
+{
+    gint free_slot = -1;
+    guint i;
+
+    for (i = 0; i < n_records; i++) {
+        if (owners[i] == modem)
+            return i;
+        if (!owners[i] && free_slot < 0)
+            free_slot = i;
+    }
+
+    if (free_slot < 0) {
+        GError *error = NULL;
+
+        free_slot = n_records;
+        if (!segment_publish (segment_path, 2 * n_records, &error)) {
+            if (!full_warned) {
+                mm_warn ("Status segment full, no record for more than %u modems: %s",
+                         n_records, error->message);
+                full_warned = TRUE;
+            }
+            g_error_free (error);
+            return -1;
+        }
+    }
+
+    owners[free_slot] = modem;
+    g_object_weak_ref (G_OBJECT (modem), modem_finalized_cb, GUINT_TO_POINTER (free_slot));
+    return free_slot;
+}
+
+/*****************************************************************************/
+
+static void
+add_bearer (MMBaseBearer   *bearer,
+            MMStatusRecord *record)
+{
+    const gchar *path;
+    MMStatusBearer *item;
+
+    path = mm_base_bearer_get_path (bearer);
+    if (!path || record->n_bearers == MM_STATUS_RECORD_MAX_BEARERS)
+        return;
+
+    item = &record->bearers[record->n_bearers++];
+    item->bearer_index = path_index (path);
+    item->connected = (mm_base_bearer_get_status (bearer) == MM_BEARER_STATUS_CONNECTED);
+}
+
+void
+mm_status_segment_update_modem (MMBaseModem *modem)
+{
+    MmGdbusModem *skeleton = NULL;
+    MmGdbusModem3gpp *skeleton_3gpp = NULL;
+    MMBearerList *list = NULL;
+    MMStatusRecord record;
+    const gchar *path;
+    GVariant *signal_quality;
+    gint i;
+
+    if (G_LIKELY (!records))
+        return;
+
+    /* Modems not exported yet aren't visible to clients either */
+    path = g_dbus_object_get_object_path (G_DBUS_OBJECT (modem));
+    if (!path)
+        return;
+
+    g_object_get (modem,
+                  MM_IFACE_MODEM_DBUS_SKELETON, &skeleton,
+                  MM_IFACE_MODEM_BEARER_LIST,   &list,
+                  NULL);
+    if (!skeleton)
+        goto out;
+
+    i = record_lookup (modem);
+    if (i < 0)
+        goto out;
+
+    memset (&record, 0, sizeof (record));
+    record.in_use = 1;
+    record.modem_index = path_index (path);
+    record.state = mm_gdbus_modem_get_state (skeleton);
+    record.access_technologies = mm_gdbus_modem_get_access_technologies (skeleton);
+    signal_quality = mm_gdbus_modem_get_signal_quality (skeleton);
+    if (signal_quality) {
+        guint quality = 0;
+        gboolean recent = FALSE;
+
+        g_variant_get (signal_quality, "(ub)", &quality, &recent);
+        record.signal_quality = quality;
+        record.signal_quality_recent = recent;
+    }
+
+    if (MM_IS_IFACE_MODEM_3GPP (modem))
+        g_object_get (modem,
+                      MM_IFACE_MODEM_3GPP_DBUS_SKELETON, &skeleton_3gpp,
+                      NULL);
+    if (skeleton_3gpp) {
+        const gchar *str;
+
+        record.registration_state = mm_gdbus_modem3gpp_get_registration_state (skeleton_3gpp);
+        str = mm_gdbus_modem3gpp_get_operator_code (skeleton_3gpp);
+        if (str)
+            g_strlcpy (record.operator_code, str, sizeof (record.operator_code));
+        str = mm_gdbus_modem3gpp_get_operator_name (skeleton_3gpp);
+        if (str)
+            g_strlcpy (record.operator_name, str, sizeof (record.operator_name));
+        g_object_unref (skeleton_3gpp);
+    }
+
+    if (list)
+        mm_bearer_list_foreach (list, (MMBearerListForeachFunc)add_bearer, &record);
+
+    record.updates = records[i].updates + 1;
+    record_write (i, &record);
+
+out:
+    g_clear_object (&skeleton);
+    g_clear_object (&list);
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_status_segment_is_active (void)
+{
+    return !!records;
+}
+
+void
+mm_status_segment_stop (void)
+{
+    guint i;
+
+    if (!segment)
+        return;
+
+    /* Readers still mapping the file see no modems from now on */
+    for (i = 0; i < n_records; i++) {
+        if (owners[i]) {
+            g_object_weak_unref (G_OBJECT (owners[i]), modem_finalized_cb, GUINT_TO_POINTER (i));
+            record_release (i);
+        }
+    }
+
+    munmap (segment, SEGMENT_SIZE (n_records));
+    segment = NULL;
+    records = NULL;
+    n_records = 0;
+    g_clear_pointer (&owners, g_free);
+    g_clear_pointer (&segment_path, g_free);
+    full_warned = FALSE;
+    mm_info ("Status segment stopped");
+}
+
+/* Writes a new segment with 'n' records, carrying over the current ones, to
+ * a temporary file in the same directory, and renames it over 'path'. The
+ * published file is never truncated, as readers mapping it would get SIGBUS
+ * when touching the pages past the new end. */
+static gboolean
+segment_publish (const gchar  *path,
+                 guint         n,
+                 GError      **error)
+{
+    MMStatusSegmentHeader *header;
+    guint8 *new_segment;
+    gchar *tmp_path;
+    gint fd;
+
+    tmp_path = g_strdup_printf ("%s.XXXXXX", path);
+    fd = g_mkstemp_full (tmp_path, O_RDWR | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't create status segment '%s': %s",
+                     tmp_path, g_strerror (errno));
+        g_free (tmp_path);
+        return FALSE;
+    }
+
+    if (ftruncate (fd, SEGMENT_SIZE (n)) < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't size status segment '%s': %s",
+                     tmp_path, g_strerror (errno));
+        goto failed;
+    }
+
+    new_segment = mmap (NULL, SEGMENT_SIZE (n), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (new_segment == MAP_FAILED) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't map status segment '%s': %s",
+                     tmp_path, g_strerror (errno));
+        goto failed;
+    }
+
+    /* Complete before it becomes visible at the path; the file is new and
+     * zero-filled, so the records not carried over start unused */
+    header = (MMStatusSegmentHeader *) new_segment;
+    header->magic = MM_STATUS_SEGMENT_MAGIC;
+    header->version = MM_STATUS_SEGMENT_VERSION;
+    header->n_records = n;
+    header->record_size = sizeof (MMStatusRecord);
+    if (records)
+        memcpy (new_segment + sizeof (MMStatusSegmentHeader),
+                records,
+                n_records * sizeof (MMStatusRecord));
+
+    if (rename (tmp_path, path) < 0) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't publish status segment '%s': %s",
+                     path, g_strerror (errno));
+        munmap (new_segment, SEGMENT_SIZE (n));
+        goto failed;
+    }
+    close (fd);
+    g_free (tmp_path);
+
+    /* Tell the readers of the previous file to map the new one */
+    if (segment) {
+        header = (MMStatusSegmentHeader *) segment;
+        g_atomic_int_set ((gint *) &header->replaced, 1);
+        munmap (segment, SEGMENT_SIZE (n_records));
+    }
+
+    segment = new_segment;
+    records = (MMStatusRecord *) (segment + sizeof (MMStatusSegmentHeader));
+    owners = g_renew (MMBaseModem *, owners, n);
+    memset (owners + n_records, 0, (n - n_records) * sizeof (MMBaseModem *));
+    n_records = n;
+    return TRUE;
+
+failed:
+    close (fd);
+    g_unlink (tmp_path);
+    g_free (tmp_path);
+    return FALSE;
+}
+
+gboolean
+mm_status_segment_start (const gchar  *path,
+                         GError      **error)
+{
+    mm_status_segment_stop ();
+
+    if (!segment_publish (path, MM_STATUS_SEGMENT_MIN_RECORDS, error))
+        return FALSE;
+
+    segment_path = g_strdup (path);
+    mm_info ("Publishing modem status in '%s'", path);
+    return TRUE;
+}
@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_STATUS_SEGMENT_H
+#define MM_STATUS_SEGMENT_H
+
+#include <glib.h>
+
+#include "mm-base-modem.h"
+
+/*
+ * Status segment: a file mapped in memory with one fixed-layout record per
+ * modem (state, access technologies, signal quality, 3GPP registration and
+ * operator, bearers), rewritten whenever the daemon updates the matching
+ * properties, so that local clients polling at high rates may map it and
+ * read the latest values without any D-Bus traffic.
+ *
+ * The layout and the seqlock protocol readers must follow are described in
+ * the installed ModemManager-status.h header.
+ */
+
+/* Creates the segment at 'path', replacing any segment already published */
+gboolean mm_status_segment_start     (const gchar  *path,
+                                      GError      **error);
+void     mm_status_segment_stop      (void);
+gboolean mm_status_segment_is_active (void);
+
+/* Refreshes the record of the modem; cheap no-op if no segment is published */
+void mm_status_segment_update_modem (MMBaseModem *modem);
+
+#endif /* MM_STATUS_SEGMENT_H */
@@ -0,0 +1,109 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+
+#include "mm-string-pool.h"
+#include "mm-log.h"
+
+/* String (owned) -> reference count */
+static GHashTable *pool;
+G_LOCK_DEFINE_STATIC (pool);
+
+static const gchar *
+pool_ref (const gchar *str,
+          gboolean     take)
+{
+    gpointer pooled;
+    gpointer refcount;
+
+    G_LOCK (pool);
+
+    if (G_UNLIKELY (!pool))
+        pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    if (g_hash_table_lookup_extended (pool, str, &pooled, &refcount)) {
+        g_hash_table_insert (pool, pooled, GUINT_TO_POINTER (GPOINTER_TO_UINT (refcount) + 1));
+        if (take)
+            g_free ((gchar *) str);
+    } else {
+        pooled = (take ? (gchar *) str : g_strdup (str));
+        g_hash_table_insert (pool, pooled, GUINT_TO_POINTER (1));
+    }
+
+    G_UNLOCK (pool);
+
+    return pooled;
+}
+
+const gchar *
+mm_string_pool_ref (const gchar *str)
+{
+    return (str ? pool_ref (str, FALSE) : NULL);
+}
+
+const gchar *
+mm_string_pool_take (gchar *str)
+{
+    return (str ? pool_ref (str, TRUE) : NULL);
+}
+
+void
+mm_string_pool_unref (const gchar *str)
+{
+    gpointer pooled;
+    gpointer refcount;
+
+    if (!str)
+        return;
+
+    G_LOCK (pool);
+
+    if (!pool || !g_hash_table_lookup_extended (pool, str, &pooled, &refcount) || pooled != str)
+        g_warn_if_reached ();
+    else if (GPOINTER_TO_UINT (refcount) == 1)
+        g_hash_table_remove (pool, pooled);
+    else
+        g_hash_table_insert (pool, pooled, GUINT_TO_POINTER (GPOINTER_TO_UINT (refcount) - 1));
+
+    G_UNLOCK (pool);
+}
+
+void
+mm_string_pool_report (void)
+{
+    GHashTableIter iter;
+    gpointer       key;
+    gpointer       refcount;
+    guint          n_strings = 0;
+    guint          n_refs = 0;
+    gsize          size = 0;
+
+    G_LOCK (pool);
+
+    if (pool) {
+        g_hash_table_iter_init (&iter, pool);
+        while (g_hash_table_iter_next (&iter, &key, &refcount)) {
+            n_strings++;
+            n_refs += GPOINTER_TO_UINT (refcount);
+            size += strlen (key) + 1;
+        }
+    }
+
+    mm_dbg ("string pool: %u strings (%" G_GSIZE_FORMAT " bytes) with %u references",
+            n_strings, size, n_refs);
+
+    G_UNLOCK (pool);
+}
@@ -0,0 +1,40 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_STRING_POOL_H
+#define MM_STRING_POOL_H
+
+#include <glib.h>
+
+/*
+ * Process-wide pool of immutable strings, shared by all modems, for the small
+ * values repeated over and over (operator names and codes, mostly). Equal
+ * strings get the same pointer, so pooled strings may be compared with '=='.
+ *
+ * Pooled strings are reference counted and dropped from the pool when the
+ * last reference goes away. All functions accept NULL, returning NULL.
+ */
+
+/* Returns the pooled copy of 'str', with a new reference */
+const gchar *mm_string_pool_ref   (const gchar *str);
+/* Same, taking ownership of 'str', which may be freed right away */
+const gchar *mm_string_pool_take  (gchar *str);
+/* Releases a reference on a string returned by ref() or take() */
+void         mm_string_pool_unref (const gchar *str);
+
+/* Logs the number of strings and references in the pool */
+void         mm_string_pool_report (void);
+
+#endif /* MM_STRING_POOL_H */
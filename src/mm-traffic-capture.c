@@ -0,0 +1,270 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
+#include "mm-traffic-capture.h"
+#include "mm-log.h"
+
+/* pcapng block types */
+#define BLOCK_SECTION_HEADER        0x0A0D0D0A
+#define BLOCK_INTERFACE_DESCRIPTION 0x00000001
+#define BLOCK_ENHANCED_PACKET       0x00000006
+
+#define BYTE_ORDER_MAGIC 0x1A2B3C4D
+
+/* Options */
+#define OPT_END_OF_OPT     0
+#define OPT_SHB_USERAPPL   4
+#define OPT_IF_NAME        2
+#define OPT_IF_DESCRIPTION 3
+#define OPT_IF_TSRESOL     9
+#define OPT_EPB_FLAGS      2
+
+#define EPB_FLAGS_INBOUND  0x1
+#define EPB_FLAGS_OUTBOUND 0x2
+
+/* Link types reserved for private use */
+#define LINKTYPE_USER0 147
+
+typedef struct {
+    const gchar *protocol;
+    guint16      link_type;
+} ProtocolInfo;
+
+static FILE       *file;
+static GByteArray *block;
+/* "<port type>:<port name>" -> interface id + 1 */
+static GHashTable *interfaces;
+
+/*****************************************************************************/
+
+static void
+protocol_info_get (MMPortType    port_type,
+                   ProtocolInfo *info)
+{
+    switch (port_type) {
+    case MM_PORT_TYPE_QCDM:
+        info->protocol = "QCDM";
+        info->link_type = LINKTYPE_USER0 + 1;
+        break;
+    case MM_PORT_TYPE_QMI:
+        info->protocol = "QMI";
+        info->link_type = LINKTYPE_USER0 + 2;
+        break;
+    case MM_PORT_TYPE_MBIM:
+        info->protocol = "MBIM";
+        info->link_type = LINKTYPE_USER0 + 3;
+        break;
+    case MM_PORT_TYPE_GPS:
+        info->protocol = "NMEA";
+        info->link_type = LINKTYPE_USER0;
+        break;
+    default:
+        info->protocol = "AT";
+        info->link_type = LINKTYPE_USER0;
+        break;
+    }
+}
+
+static void
+append_u16 (guint16 value)
+{
+    g_byte_array_append (block, (const guint8 *) &value, sizeof (value));
+}
+
+static void
+append_u32 (guint32 value)
+{
+    g_byte_array_append (block, (const guint8 *) &value, sizeof (value));
+}
+
+/* Pads the block to 32 bits */
+static void
+append_padding (void)
+{
+    static const guint8 zeros[3] = { 0 };
+
+    if (block->len % 4)
+        g_byte_array_append (block, zeros, 4 - (block->len % 4));
+}
+
+static void
+append_option (guint16       code,
+               gconstpointer value,
+               guint16       len)
+{
+    append_u16 (code);
+    append_u16 (len);
+    if (len)
+        g_byte_array_append (block, value, len);
+    append_padding ();
+}
+
+static void
+block_begin (guint32 type)
+{
+    g_byte_array_set_size (block, 0);
+    append_u32 (type);
+    /* Total length, set when finished */
+    append_u32 (0);
+}
+
+static void
+block_end (void)
+{
+    guint32 total;
+
+    total = block->len + 4;
+    memcpy (block->data + 4, &total, sizeof (total));
+    append_u32 (total);
+
+    fwrite (block->data, 1, block->len, file);
+}
+
+/*****************************************************************************/
+
+static guint32
+interface_lookup (const gchar *port_name,
+                  MMPortType   port_type)
+{
+    ProtocolInfo  info;
+    gchar        *key;
+    guint32       id;
+    guint8        tsresol = 9;
+
+    key = g_strdup_printf ("%u:%s", port_type, port_name);
+    id = GPOINTER_TO_UINT (g_hash_table_lookup (interfaces, key));
+    if (id) {
+        g_free (key);
+        return id - 1;
+    }
+
+    /* New interface for this port, described right before its first packet */
+    id = g_hash_table_size (interfaces);
+    g_hash_table_insert (interfaces, key, GUINT_TO_POINTER (id + 1));
+
+    protocol_info_get (port_type, &info);
+    block_begin (BLOCK_INTERFACE_DESCRIPTION);
+    append_u16 (info.link_type);
+    append_u16 (0);
+    /* No snapshot length limit */
+    append_u32 (0);
+    append_option (OPT_IF_NAME, port_name, strlen (port_name));
+    append_option (OPT_IF_DESCRIPTION, info.protocol, strlen (info.protocol));
+    append_option (OPT_IF_TSRESOL, &tsresol, 1);
+    append_option (OPT_END_OF_OPT, NULL, 0);
+    block_end ();
+
+    return id;
+}
+
+void
+mm_traffic_capture_write (const gchar               *port_name,
+                          MMPortType                 port_type,
+                          MMTrafficCaptureDirection  direction,
+                          const guint8              *data,
+                          gsize                      len)
+{
+    struct timespec ts;
+    guint64         ns;
+    guint32         interface_id;
+    guint32         flags;
+
+    if (G_LIKELY (!file) || !len)
+        return;
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    ns = (guint64) ts.tv_sec * 1000000000 + (guint64) ts.tv_nsec;
+
+    interface_id = interface_lookup (port_name, port_type);
+    flags = (direction == MM_TRAFFIC_CAPTURE_DIRECTION_SENT ? EPB_FLAGS_OUTBOUND : EPB_FLAGS_INBOUND);
+
+    block_begin (BLOCK_ENHANCED_PACKET);
+    append_u32 (interface_id);
+    append_u32 ((guint32) (ns >> 32));
+    append_u32 ((guint32) ns);
+    append_u32 ((guint32) len);
+    append_u32 ((guint32) len);
+    g_byte_array_append (block, data, len);
+    append_padding ();
+    append_option (OPT_EPB_FLAGS, &flags, sizeof (flags));
+    append_option (OPT_END_OF_OPT, NULL, 0);
+    block_end ();
+}
+
+/*****************************************************************************/
+
+gboolean
+mm_traffic_capture_is_active (void)
+{
+    return !!file;
+}
+
+void
+mm_traffic_capture_stop (void)
+{
+    if (!file)
+        return;
+
+    fclose (file);
+    file = NULL;
+    g_byte_array_unref (block);
+    block = NULL;
+    g_hash_table_unref (interfaces);
+    interfaces = NULL;
+    mm_info ("Traffic capture stopped");
+}
+
+gboolean
+mm_traffic_capture_start (const gchar  *path,
+                          GError      **error)
+{
+    static const gchar *application = "ModemManager " MM_DIST_VERSION;
+    FILE *new_file;
+
+    new_file = fopen (path, "wb");
+    if (!new_file) {
+        g_set_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED,
+                     "Couldn't create traffic capture file '%s': %s",
+                     path, g_strerror (errno));
+        return FALSE;
+    }
+
+    mm_traffic_capture_stop ();
+    file = new_file;
+    block = g_byte_array_sized_new (4096);
+    interfaces = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    block_begin (BLOCK_SECTION_HEADER);
+    append_u32 (BYTE_ORDER_MAGIC);
+    append_u16 (1);
+    append_u16 (0);
+    /* Section length not known */
+    append_u32 (G_MAXUINT32);
+    append_u32 (G_MAXUINT32);
+    append_option (OPT_SHB_USERAPPL, application, strlen (application));
+    append_option (OPT_END_OF_OPT, NULL, 0);
+    block_end ();
+
+    mm_info ("Capturing traffic in '%s'", path);
+    return TRUE;
+}
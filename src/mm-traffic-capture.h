@@ -0,0 +1,52 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#ifndef MM_TRAFFIC_CAPTURE_H
+#define MM_TRAFFIC_CAPTURE_H
+
+#include <glib.h>
+
+#include "mm-port.h"
+
+/*
+ * Capture of the control traffic of all ports (AT, QCDM, NMEA, QMI and MBIM)
+ * in a single pcapng file, to be inspected with Wireshark or tshark.
+ *
+ * Each port is a separate interface in the capture, named after the port and
+ * described with its protocol, using the LINKTYPE_USER0..3 link types (AT and
+ * NMEA, QCDM, QMI, MBIM). Packets carry nanosecond wall clock timestamps and
+ * the inbound/outbound direction flag.
+ */
+
+typedef enum {
+    MM_TRAFFIC_CAPTURE_DIRECTION_SENT,
+    MM_TRAFFIC_CAPTURE_DIRECTION_RECEIVED,
+} MMTrafficCaptureDirection;
+
+/* Starts capturing into a new file at 'path', replacing any capture already
+ * running */
+gboolean mm_traffic_capture_start     (const gchar  *path,
+                                       GError      **error);
+void     mm_traffic_capture_stop      (void);
+gboolean mm_traffic_capture_is_active (void);
+
+/* Cheap no-op if no capture is running */
+void mm_traffic_capture_write (const gchar               *port_name,
+                               MMPortType                 port_type,
+                               MMTrafficCaptureDirection  direction,
+                               const guint8              *data,
+                               gsize                      len);
+
+#endif /* MM_TRAFFIC_CAPTURE_H */
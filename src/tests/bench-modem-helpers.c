@@ -0,0 +1,317 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+/*
+ * Benchmarks of the response parsers in the modem helpers.
+ *
+ * By default each parser runs once over its corpus, as a smoke test. With
+ * '-m perf' (or 'make perf-report') each one runs for a while and reports the
+ * time and number of heap allocations per call:
+ *   $ ./bench-modem-helpers -m perf
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <libmm-glib.h>
+#include "mm-modem-helpers.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+/* Allocation counting, only with glibc, where malloc() can be interposed */
+
+#if defined __GLIBC__
+
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 n_allocs;
+
+void *
+malloc (size_t size)
+{
+    n_allocs++;
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    n_allocs++;
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    n_allocs++;
+    return __libc_realloc (ptr, size);
+}
+
+# define ALLOCS_SUPPORTED 1
+#else
+static guint64 n_allocs;
+# define ALLOCS_SUPPORTED 0
+#endif
+
+/*****************************************************************************/
+/* Corpora, taken from the unit tests and from captured replies */
+
+static const gchar *cops_corpus[] = {
+    "+COPS: (1,\"T-Mobile US\",\"TMO US\",\"31026\",0),(1,\"Cingular\",\"Cingular\",\"310410\",0),,(0, 1, 3),(0-2)",
+    "+COPS: (2,\"T-Mobile\",\"TMO\",\"31026\",0),(1,\"AT&T\",\"AT&T\",\"310410\",2),(1,\"AT&T\",\"AT&T\",\"310410\",0),,(0,1,2,3,4),)",
+    "+COPS: (2,\"T-Mobile\",\"\",\"310260\"),(0,\"Cingular Wireless\",\"\",\"310410\")",
+    "+COPS: (2,\"\",\"\",\"310410\",2),(1,\"AT&T\",\"AT&T\",\"310410\",0),(1,\"T-Mobile\",\"TMO\",\"31026\",0),,(0,1,2,3,4),(0,1,2)",
+    NULL, /* large operator list, built at startup */
+    NULL
+};
+
+static const gchar *cgdcont_read_corpus[] = {
+    "+CGDCONT: 1,\"IP\",,,0,0",
+    "+CGDCONT: 1,\"IP\",\"nate.sktelecom.com\",\"\",0,0\r\n"
+    "+CGDCONT: 2,\"IP\",\"epc.tmobile.com\",\"\",0,0\r\n"
+    "+CGDCONT: 3,\"IP\",\"MAXROAM.com\",\"\",0,0\r\n"
+    "+CGDCONT: 4,\"IP\",\"\",\"\",0,0\r\n"
+    "+CGDCONT: 5,\"IPV4V6\",\"ims\",\"0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0\",0,0,0,0,0,0\r\n"
+    "+CGDCONT: 6,\"IPV4V6\",\"internet.telekom\",\"0.0.0.0.0.0.0.0.0.0.0.0.0.0.0.0\",0,0,0,0,0,0",
+    NULL
+};
+
+static const gchar *cind_corpus[] = {
+    "+CIND: (\"battchg\",(0-5)),(\"signal\",(0-5)),(\"batterywarning\",(0-1)),(\"chargerconnected\",(0-1)),(\"service\",(0-1)),(\"sounder\",(0-1)),(\"message\",(0-1)),()",
+    "+CIND: (\"Voice Mail\",(0,1)),(\"service\",(0,1)),(\"call\",(0,1)),(\"Roam\",(0-2)),(\"signal\",(0-5)),(\"callsetup\",(0-3)),(\"smsfull\",(0,1))",
+    NULL
+};
+
+static const gchar *cpms_corpus[] = {
+    "+CPMS: (\"ME\",\"MT\"),(\"ME\",\"SM\",\"MT\"),(\"SM\",\"MT\")",
+    "+CPMS: (\"ME\",\"MT\"),\"ME\",(\"SM\")",
+    "+CPMS: (),(),()",
+    NULL
+};
+
+static const gchar *split_corpus[] = {
+    "(\"ME\",\"MT\"),(\"ME\",\"SM\",\"MT\"),(\"SM\",\"MT\")",
+    "(\"ME\",\"MT\",\"SM\",\"SR\"),(\"ME\",\"MT\",\"SM\",\"SR\"),(\"ME\",\"MT\",\"SM\",\"SR\")",
+    NULL
+};
+
+static const gchar *creg_corpus[] = {
+    "+CREG: 1,3",
+    "+CREG: 2,1,\"CE00\",\"01CEAD8F\"",
+    "+CGREG: 2,1,\"8BE3\",\"00002B5D\",3",
+    "+CEREG: 2,1, 1F00, 20 ,79D903 ,7",
+    NULL
+};
+
+static const gchar *cnum_corpus[] = {
+    "+CNUM: \"something\",\"1234567890\",161",
+    "+CNUM: \"\",\"+34600000001\",145\r\n+CNUM: \"Fax\",\"+34600000002\",145",
+    NULL
+};
+
+/* Multi-RAT modems in dense areas report dozens of entries */
+static gchar *
+build_large_cops_reply (void)
+{
+    GString *str;
+    guint    i;
+
+    str = g_string_new ("+COPS: ");
+    for (i = 0; i < 48; i++)
+        g_string_append_printf (str, "(%u,\"Operator %02u Long Name\",\"OP%02u\",\"%u\",%u),",
+                                i == 0 ? 2 : (i % 3 == 0 ? 3 : 1),
+                                i, i,
+                                21401 + (i / 4),
+                                (i % 4 == 0) ? 0 : ((i % 4 == 1) ? 2 : ((i % 4 == 2) ? 7 : 12)));
+    g_string_append (str, ",(0,1,2,3,4),(0,1,2)");
+    return g_string_free (str, FALSE);
+}
+
+/*****************************************************************************/
+/* Parser wrappers, each parsing one reply and releasing the result */
+
+static void
+parse_cops (const gchar *reply)
+{
+    mm_3gpp_network_info_list_free (mm_3gpp_parse_cops_test_response (reply, NULL));
+}
+
+static void
+parse_cgdcont_read (const gchar *reply)
+{
+    mm_3gpp_pdp_context_list_free (mm_3gpp_parse_cgdcont_read_response (reply, NULL));
+}
+
+static void
+parse_cind (const gchar *reply)
+{
+    GHashTable *hash;
+
+    hash = mm_3gpp_parse_cind_test_response (reply, NULL);
+    if (hash)
+        g_hash_table_destroy (hash);
+}
+
+static void
+parse_cpms (const gchar *reply)
+{
+    GArray *mem1 = NULL;
+    GArray *mem2 = NULL;
+    GArray *mem3 = NULL;
+
+    if (mm_3gpp_parse_cpms_test_response (reply, &mem1, &mem2, &mem3)) {
+        g_array_unref (mem1);
+        g_array_unref (mem2);
+        g_array_unref (mem3);
+    }
+}
+
+static void
+split_groups (const gchar *reply)
+{
+    g_strfreev (mm_split_string_groups (reply));
+}
+
+static void
+parse_creg (const gchar *reply)
+{
+    MMModem3gppRegistrationState state;
+    MMModemAccessTechnology act;
+    gulong lac = 0;
+    gulong ci = 0;
+    gboolean cgreg;
+    gboolean cereg;
+
+    mm_3gpp_parse_creg_response (reply, &state, &lac, &ci, &act, &cgreg, &cereg, NULL);
+}
+
+static void
+parse_cnum (const gchar *reply)
+{
+    GStrv numbers;
+
+    numbers = mm_3gpp_parse_cnum_exec_response (reply, NULL);
+    g_strfreev (numbers);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    const gchar  *name;
+    void        (*parse) (const gchar *reply);
+    const gchar **corpus;
+} Benchmark;
+
+static const Benchmark benchmarks[] = {
+    { "cops-test",        parse_cops,         cops_corpus         },
+    { "cgdcont-read",     parse_cgdcont_read, cgdcont_read_corpus },
+    { "cind-test",        parse_cind,         cind_corpus         },
+    { "cpms-test",        parse_cpms,         cpms_corpus         },
+    { "split-groups",     split_groups,       split_corpus        },
+    { "creg",             parse_creg,         creg_corpus         },
+    { "cnum-exec",        parse_cnum,         cnum_corpus         },
+};
+
+/* Minimum time to spend on each reply of a corpus in perf mode */
+#define BENCH_MIN_SECONDS 0.2
+
+static void
+run_benchmark (gconstpointer data)
+{
+    const Benchmark *bench = data;
+    guint            i;
+
+    for (i = 0; bench->corpus[i]; i++) {
+        const gchar *reply = bench->corpus[i];
+        guint64      iterations = 0;
+        guint64      allocs;
+        gdouble      elapsed;
+
+        /* The first call pays for the regex compilation, if any */
+        bench->parse (reply);
+
+        if (!g_test_perf ())
+            continue;
+
+        allocs = n_allocs;
+        g_test_timer_start ();
+        do {
+            guint j;
+
+            for (j = 0; j < 100; j++)
+                bench->parse (reply);
+            iterations += 100;
+            elapsed = g_test_timer_elapsed ();
+        } while (elapsed < BENCH_MIN_SECONDS);
+        allocs = n_allocs - allocs;
+
+        g_test_minimized_result (elapsed * 1e9 / iterations,
+                                 "%s #%u (%u bytes): %.0f ns/call, %s%.1f allocs/call",
+                                 bench->name, i, (guint) strlen (reply),
+                                 elapsed * 1e9 / iterations,
+                                 ALLOCS_SUPPORTED ? "" : "unknown ",
+                                 ALLOCS_SUPPORTED ? (gdouble) allocs / iterations : 0.0);
+    }
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    gchar *large_cops;
+    guint  i;
+    gint   ret;
+
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    large_cops = build_large_cops_reply ();
+    cops_corpus[G_N_ELEMENTS (cops_corpus) - 2] = large_cops;
+
+    for (i = 0; i < G_N_ELEMENTS (benchmarks); i++) {
+        gchar *path;
+
+        path = g_strdup_printf ("/MM/bench/%s", benchmarks[i].name);
+        g_test_add_data_func (path, &benchmarks[i], run_benchmark);
+        g_free (path);
+    }
+
+    ret = g_test_run ();
+
+    g_free (large_cops);
+    return ret;
+}
@@ -0,0 +1,590 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ */
+
+/*
+ * Benchmarks and robustness runs of the 3GPP and CDMA SMS PDU decoders and
+ * encoders.
+ *
+ * The corpus is built in, and may be extended with a file with one PDU per
+ * line, as "3gpp <hex>" or "cdma <hex>", given in MM_BENCH_SMS_CORPUS.
+ *
+ * By default each PDU is decoded and encoded once, and a few hundred mutated
+ * copies of each (bit flips, random bytes, truncations and extensions) are
+ * decoded, as a smoke test. With '-m perf' (or 'make perf-report') each one
+ * runs for a while and reports messages per second and heap allocations per
+ * message, and many more mutations are run:
+ *   $ MM_BENCH_SMS_CORPUS=pdus.txt ./bench-sms-part -m perf
+ *
+ * Mutations are seeded from the test seed, so a failing run can be repeated
+ * with '--seed'.
+ *
+ * When built for libFuzzer (FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION), only
+ * the LLVMFuzzerTestOneInput() entry point is built, running the same
+ * decoders: the first byte of the input selects 3GPP or CDMA.
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <libmm-glib.h>
+#include "mm-sms-part-3gpp.h"
+#include "mm-sms-part-cdma.h"
+#include "mm-log.h"
+
+/*****************************************************************************/
+/* Allocation counting, only with glibc, where malloc() can be interposed,
+ * and not when fuzzing, where the sanitizers interpose it themselves */
+
+#if defined __GLIBC__ && !defined FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 n_allocs;
+
+void *
+malloc (size_t size)
+{
+    n_allocs++;
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    n_allocs++;
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    n_allocs++;
+    return __libc_realloc (ptr, size);
+}
+
+# define ALLOCS_SUPPORTED 1
+#else
+static guint64 n_allocs;
+# define ALLOCS_SUPPORTED 0
+#endif
+
+/*****************************************************************************/
+/* Decoders */
+
+typedef enum {
+    PDU_TYPE_3GPP,
+    PDU_TYPE_CDMA,
+} PduType;
+
+/* Returns whether the PDU was accepted */
+static gboolean
+decode_pdu (PduType       type,
+            const guint8 *pdu,
+            gsize         pdu_len)
+{
+    MMSmsPart *part;
+
+    if (type == PDU_TYPE_3GPP)
+        part = mm_sms_part_3gpp_new_from_binary_pdu (0, pdu, pdu_len, NULL);
+    else
+        part = mm_sms_part_cdma_new_from_binary_pdu (0, pdu, pdu_len, NULL);
+
+    if (!part)
+        return FALSE;
+    mm_sms_part_free (part);
+    return TRUE;
+}
+
+#if defined FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+
+int LLVMFuzzerTestOneInput (const guint8 *data, size_t size);
+
+int
+LLVMFuzzerTestOneInput (const guint8 *data,
+                        size_t        size)
+{
+    if (size < 1)
+        return 0;
+    decode_pdu ((data[0] & 1) ? PDU_TYPE_CDMA : PDU_TYPE_3GPP, data + 1, size - 1);
+    return 0;
+}
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+}
+
+#else /* FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION */
+
+/*****************************************************************************/
+/* Corpus, taken from the unit tests and from captured PDUs */
+
+typedef struct {
+    PduType  type;
+    gchar   *name;
+    guint8  *pdu;
+    gsize    pdu_len;
+} CorpusEntry;
+
+static const struct {
+    PduType      type;
+    const gchar *name;
+    const gchar *hex;
+} builtin_corpus[] = {
+    /* GSM7 deliver */
+    { PDU_TYPE_3GPP, "deliver-gsm7",
+      "07912104442961F4040B916171957291F800001120821105050A6AC8B2BC7C9A83C220F6DB7D2ECB41EDF27C1E3E97411BDE06754FD3D1A0F9BB5D0695F1F4B29B5C2683C6E8B03C3CA697E5F34D6AE303D1D1F2F7DD0D4ABB59A0797D8C0685E7A00028EC26832A960B28EC2683BE6050780EBA97D96C17" },
+    /* UCS2 deliver */
+    { PDU_TYPE_3GPP, "deliver-ucs2",
+      "07919730071111F10414D04937BD2C7797E9D3E614000811309291024061080442043504410442" },
+    /* 8-bit data */
+    { PDU_TYPE_3GPP, "deliver-8bit",
+      "07912143658709F1040B918100551512F20004111010214365000AE8329BFD4697D9EC37DE" },
+    /* Coding group F, full 160 septets */
+    { PDU_TYPE_3GPP, "deliver-dcs-f",
+      "07913306091093F0040485810000F111604231805180A049B7F90D9A1AA5A01668F8769BD3E4B29B9E2EB359A03FC85D06A9C3ED707A0EA2CBC3EE79BB4CA7CBCBA05643617DA7C76990FD4D979741EE77DD5E0ED741ED371D442E83E0E1F9BC0CD281E677D9B84C06C1DF7539E85C9097E520FB9B2E2F83C6EF369C5E064D8D52D0BC2E07DDEF77D7DC2C7799E5A0771D040FCB41F402BB0047BFDD6550B80ECAD966" },
+    /* User data header with port addressing */
+    { PDU_TYPE_3GPP, "deliver-udh",
+      "07911356131313F64004850120390011609232239180A006080400100201D7327BFD6EB340E2321BF46E83EA7790F59D1E97DBE1341B442F83C465763D3DA797E56537C81D0ECB41AB59CC1693C16031D96C064241E5656838AF03A96230982A269BCD462917C8FA4E8FCBED709A0D7ABBE9F6B0FB5C7683D27350984D4FABC9A0B33C4C4FCF5D20EBFB2D079DCB62793DBD06D9C36E50FB2D4E97D9A0B49B5E96BBCB" },
+    /* Both parts of a concatenated message */
+    { PDU_TYPE_3GPP, "deliver-multipart-1",
+      "07912160130320F5440B916171056429F5000021405291650569A00500034C0201A9E8F41C949E83C2207B599E07B1DFEE33885E9ED341E4F23C7D7697C920FA1B54C697E5E3F4BC0C6AD7D9F434081E96D341E3303C2C4EB3D3F4BC0B94A483E6E8779D4D06CDD1EF3BA80E0785E7A0B7BB0C6A97E7F3F0B9CC02B9DF7450780EA2DFDF2C50780EA2A3CBA0BA9B5C96B3F369F71954768FDFE4B4FB0C9297E1F2F2BCECA6CF41" },
+    { PDU_TYPE_3GPP, "deliver-multipart-2",
+      "07912160130320F6440B916171056429F5000021405291651569320500034C0202E9E8301D44479741F0B09C3E0785E56590BCCC0ED3CB6410FD0D7ABBCBA0B0FB4D4797E52E10" },
+    /* Submit stored by us, UCS2 */
+    { PDU_TYPE_3GPP, "submit-ucs2",
+      "002100098136397339F70008224F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60597D4F60" },
+    /* Status reports */
+    { PDU_TYPE_3GPP, "status-report",
+      "07914356060013F1065A098136397339F7219011700463802190117004638030" },
+    { PDU_TYPE_3GPP, "status-report-2",
+      "07911326040000F0060D0B913176880736F4211092310000002110923100000000" },
+    /* Malformed: user data length beyond the PDU */
+    { PDU_TYPE_3GPP, "malformed-udl",
+      "07912143658709F1040B918100551512F20000111010214365000BE8329BFD4697D9EC37" },
+    /* CDMA deliver, ASCII, Latin and Unicode */
+    { PDU_TYPE_CDMA, "cdma-ascii",
+      "00000210020207028CE95DCC65800601FC08150003168D3001061024183060800306101004044847" },
+    { PDU_TYPE_CDMA, "cdma-latin",
+      "00000210020207028CE95DCC65800601FC08390003138D20012741291922E1191AE11A0119A119A1A9B1B9E9534B23AB5323AB232BABAB2B23AB53232BAB53AB200306131023200637080100" },
+    { PDU_TYPE_CDMA, "cdma-unicode",
+      "00000210020207028CE95DCC65800601FC082800031B73F001162052716AB85AA792DBC337C4B7DADA8298B4504294180306131024104528080100" },
+    { PDU_TYPE_CDMA, "cdma-created-by-us",
+      "00000210020407028CE95DCC6580080D00032000000106102418306080" },
+    /* Malformed: bad parameter and address lengths */
+    { PDU_TYPE_CDMA, "cdma-malformed-parameter",
+      "00000210020207028CE95DCC65800601FC08200003168D3001061024183060800306101004044847" },
+    { PDU_TYPE_CDMA, "cdma-malformed-address",
+      "00000210020207038CE95DCC65800601FC08150003168D3001061024183060800306101004044847" },
+};
+
+/* Texts encoded by the submit benchmarks, and whose PDUs are then added to
+ * the decoding corpus */
+static const struct {
+    PduType      type;
+    const gchar *name;
+    const gchar *text;
+} submit_texts[] = {
+    { PDU_TYPE_3GPP, "submit-gsm7",          "Hi there...Tue 17th Jan 2012 05:30.18 pm (GMT+1) ΔΔΔΔΔ" },
+    { PDU_TYPE_3GPP, "submit-gsm7-extended", "Prices: 10€ [promo] {ends} ~soon~ | see \\terms^" },
+    { PDU_TYPE_3GPP, "submit-ucs2",          "Да здравствует король, детка! 你好你好" },
+    { PDU_TYPE_CDMA, "submit-cdma-ascii",    "Hello, this is a CDMA test message" },
+    { PDU_TYPE_CDMA, "submit-cdma-unicode",  "Да здравствует король, детка!" },
+};
+
+static GPtrArray *corpus;
+
+static void
+corpus_entry_free (CorpusEntry *entry)
+{
+    g_free (entry->name);
+    g_free (entry->pdu);
+    g_slice_free (CorpusEntry, entry);
+}
+
+static void
+corpus_add_hex (PduType      type,
+                const gchar *name,
+                const gchar *hex)
+{
+    CorpusEntry *entry;
+    gsize        len = 0;
+    gchar       *bin;
+
+    bin = mm_utils_hexstr2bin (hex, &len);
+    if (!bin) {
+        g_warning ("Invalid hex PDU '%s' in corpus", name);
+        return;
+    }
+
+    entry = g_slice_new0 (CorpusEntry);
+    entry->type = type;
+    entry->name = g_strdup (name);
+    entry->pdu = (guint8 *) bin;
+    entry->pdu_len = len;
+    g_ptr_array_add (corpus, entry);
+}
+
+static void
+corpus_add_bin (PduType       type,
+                const gchar  *name,
+                const guint8 *pdu,
+                gsize         pdu_len)
+{
+    CorpusEntry *entry;
+
+    entry = g_slice_new0 (CorpusEntry);
+    entry->type = type;
+    entry->name = g_strdup (name);
+    entry->pdu = g_memdup (pdu, pdu_len);
+    entry->pdu_len = pdu_len;
+    g_ptr_array_add (corpus, entry);
+}
+
+static void
+corpus_load_file (const gchar *path)
+{
+    GError  *error = NULL;
+    gchar   *contents;
+    gchar  **lines;
+    guint    i;
+    guint    n_loaded = 0;
+
+    if (!g_file_get_contents (path, &contents, NULL, &error))
+        g_error ("Couldn't load corpus file '%s': %s", path, error->message);
+
+    lines = g_strsplit (contents, "\n", -1);
+    for (i = 0; lines[i]; i++) {
+        gchar   *line;
+        gchar   *name;
+        PduType  type;
+
+        line = g_strstrip (lines[i]);
+        if (!line[0] || line[0] == '#')
+            continue;
+
+        if (g_ascii_strncasecmp (line, "3gpp ", 5) == 0)
+            type = PDU_TYPE_3GPP;
+        else if (g_ascii_strncasecmp (line, "cdma ", 5) == 0)
+            type = PDU_TYPE_CDMA;
+        else {
+            g_warning ("Ignoring corpus line %u: unknown PDU type", i + 1);
+            continue;
+        }
+
+        name = g_strdup_printf ("%s:%u", path, i + 1);
+        corpus_add_hex (type, name, g_strstrip (line + 5));
+        g_free (name);
+        n_loaded++;
+    }
+    g_strfreev (lines);
+    g_free (contents);
+
+    g_message ("Loaded %u PDUs from '%s'", n_loaded, path);
+}
+
+/*****************************************************************************/
+/* Encoders */
+
+static guint8 *
+encode_submit (PduType      type,
+               const gchar *text,
+               guint       *pdu_len)
+{
+    MMSmsPart *part;
+    guint8    *pdu;
+
+    if (type == PDU_TYPE_3GPP) {
+        MMSmsEncoding   encoding = MM_SMS_ENCODING_UNKNOWN;
+        gchar         **split;
+        guint           msgstart = 0;
+
+        split = mm_sms_part_3gpp_util_split_text (text, &encoding);
+        g_strfreev (split);
+
+        part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_SUBMIT);
+        mm_sms_part_set_smsc (part, "+19037029920");
+        mm_sms_part_set_number (part, "+15555551234");
+        mm_sms_part_set_text (part, text);
+        mm_sms_part_set_encoding (part, encoding);
+        mm_sms_part_set_validity_relative (part, 5);
+        pdu = mm_sms_part_3gpp_get_submit_pdu (part, pdu_len, &msgstart, NULL);
+    } else {
+        part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+        mm_sms_part_set_cdma_teleservice_id (part, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+        mm_sms_part_set_number (part, "3305773196");
+        mm_sms_part_set_text (part, text);
+        pdu = mm_sms_part_cdma_get_submit_pdu (part, pdu_len, NULL);
+    }
+
+    mm_sms_part_free (part);
+    return pdu;
+}
+
+/*****************************************************************************/
+
+/* Minimum time to spend on each benchmark in perf mode */
+#define BENCH_MIN_SECONDS 0.5
+
+static void
+report (const gchar *name,
+        guint64      messages,
+        guint64      allocs,
+        gdouble      elapsed)
+{
+    g_test_minimized_result (elapsed * 1e9 / messages,
+                             "%s: %.0f messages/s, %s%.1f allocs/message",
+                             name,
+                             messages / elapsed,
+                             ALLOCS_SUPPORTED ? "" : "unknown ",
+                             ALLOCS_SUPPORTED ? (gdouble) allocs / messages : 0.0);
+}
+
+static void
+bench_decode (gconstpointer data)
+{
+    PduType  type = GPOINTER_TO_UINT (data);
+    guint64  messages = 0;
+    guint64  allocs;
+    gdouble  elapsed;
+    guint    i;
+    guint    n_accepted = 0;
+    guint    n_rejected = 0;
+
+    for (i = 0; i < corpus->len; i++) {
+        CorpusEntry *entry = g_ptr_array_index (corpus, i);
+
+        if (entry->type != type)
+            continue;
+        if (decode_pdu (entry->type, entry->pdu, entry->pdu_len))
+            n_accepted++;
+        else
+            n_rejected++;
+    }
+    g_test_message ("%u PDUs accepted, %u rejected", n_accepted, n_rejected);
+    g_assert_cmpuint (n_accepted, >, 0);
+
+    if (!g_test_perf ())
+        return;
+
+    allocs = n_allocs;
+    g_test_timer_start ();
+    do {
+        for (i = 0; i < corpus->len; i++) {
+            CorpusEntry *entry = g_ptr_array_index (corpus, i);
+
+            if (entry->type != type)
+                continue;
+            decode_pdu (entry->type, entry->pdu, entry->pdu_len);
+            messages++;
+        }
+        elapsed = g_test_timer_elapsed ();
+    } while (elapsed < BENCH_MIN_SECONDS);
+    allocs = n_allocs - allocs;
+
+    report (type == PDU_TYPE_3GPP ? "3gpp decode" : "cdma decode", messages, allocs, elapsed);
+}
+
+static void
+bench_encode (gconstpointer data)
+{
+    guint    index = GPOINTER_TO_UINT (data);
+    guint8  *pdu;
+    guint    pdu_len = 0;
+    guint64  messages = 0;
+    guint64  allocs;
+    gdouble  elapsed;
+
+    pdu = encode_submit (submit_texts[index].type, submit_texts[index].text, &pdu_len);
+    g_assert (pdu != NULL);
+    g_free (pdu);
+
+    if (!g_test_perf ())
+        return;
+
+    allocs = n_allocs;
+    g_test_timer_start ();
+    do {
+        guint j;
+
+        for (j = 0; j < 100; j++)
+            g_free (encode_submit (submit_texts[index].type, submit_texts[index].text, &pdu_len));
+        messages += 100;
+        elapsed = g_test_timer_elapsed ();
+    } while (elapsed < BENCH_MIN_SECONDS);
+    allocs = n_allocs - allocs;
+
+    report (submit_texts[index].name, messages, allocs, elapsed);
+}
+
+/*****************************************************************************/
+/* Robustness: mutated PDUs must be either decoded or rejected, never crash
+ * nor read out of bounds (run under valgrind or ASan to catch the latter) */
+
+#define SMOKE_MUTATIONS 200
+#define PERF_MUTATIONS  20000
+
+static void
+mutate (guint8 *pdu,
+        gsize   pdu_len)
+{
+    guint n_changes;
+    guint i;
+
+    n_changes = g_test_rand_int_range (1, 4);
+    for (i = 0; i < n_changes; i++) {
+        guint pos;
+
+        pos = g_test_rand_int_range (0, pdu_len);
+        switch (g_test_rand_int_range (0, 3)) {
+        case 0:
+            pdu[pos] ^= 1 << g_test_rand_int_range (0, 8);
+            break;
+        case 1:
+            pdu[pos] = g_test_rand_int_range (0, 256);
+            break;
+        default:
+            /* Lengths and counts are the most interesting bytes to break */
+            pdu[pos] = g_test_rand_bit () ? 0xFF : 0x00;
+            break;
+        }
+    }
+}
+
+static void
+test_robustness (void)
+{
+    guint   n_mutations;
+    guint64 n_decoded = 0;
+    guint64 n_accepted = 0;
+    guint   i;
+
+    n_mutations = g_test_perf () ? PERF_MUTATIONS : SMOKE_MUTATIONS;
+
+    for (i = 0; i < corpus->len; i++) {
+        CorpusEntry *entry = g_ptr_array_index (corpus, i);
+        guint8      *copy;
+        gsize        len;
+        guint        j;
+
+        if (!entry->pdu_len)
+            continue;
+
+        /* Every truncation, in an exactly sized buffer so that overreads
+         * are caught by the memory checkers */
+        for (len = 0; len < entry->pdu_len; len++) {
+            copy = g_memdup (entry->pdu, len);
+            n_accepted += decode_pdu (entry->type, copy, len);
+            n_decoded++;
+            g_free (copy);
+        }
+
+        /* Extended with trailing garbage */
+        copy = g_malloc (entry->pdu_len + 16);
+        memcpy (copy, entry->pdu, entry->pdu_len);
+        for (j = 0; j < 16; j++)
+            copy[entry->pdu_len + j] = g_test_rand_int_range (0, 256);
+        n_accepted += decode_pdu (entry->type, copy, entry->pdu_len + 16);
+        n_decoded++;
+        g_free (copy);
+
+        /* Random mutations */
+        for (j = 0; j < n_mutations; j++) {
+            copy = g_memdup (entry->pdu, entry->pdu_len);
+            mutate (copy, entry->pdu_len);
+            n_accepted += decode_pdu (entry->type, copy, entry->pdu_len);
+            n_decoded++;
+            g_free (copy);
+        }
+    }
+
+    g_test_message ("%" G_GUINT64_FORMAT " mutated PDUs decoded, %" G_GUINT64_FORMAT " accepted",
+                    n_decoded, n_accepted);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    const gchar *corpus_file;
+    guint        i;
+    gint         ret;
+
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    corpus = g_ptr_array_new_with_free_func ((GDestroyNotify) corpus_entry_free);
+    for (i = 0; i < G_N_ELEMENTS (builtin_corpus); i++)
+        corpus_add_hex (builtin_corpus[i].type, builtin_corpus[i].name, builtin_corpus[i].hex);
+
+    /* Our own submit PDUs must be decodable as well */
+    for (i = 0; i < G_N_ELEMENTS (submit_texts); i++) {
+        guint8 *pdu;
+        guint   pdu_len = 0;
+
+        pdu = encode_submit (submit_texts[i].type, submit_texts[i].text, &pdu_len);
+        if (pdu)
+            corpus_add_bin (submit_texts[i].type, submit_texts[i].name, pdu, pdu_len);
+        g_free (pdu);
+    }
+
+    corpus_file = g_getenv ("MM_BENCH_SMS_CORPUS");
+    if (corpus_file && corpus_file[0])
+        corpus_load_file (corpus_file);
+
+    g_test_add_data_func ("/MM/bench/sms/3gpp-decode", GUINT_TO_POINTER (PDU_TYPE_3GPP), bench_decode);
+    g_test_add_data_func ("/MM/bench/sms/cdma-decode", GUINT_TO_POINTER (PDU_TYPE_CDMA), bench_decode);
+    for (i = 0; i < G_N_ELEMENTS (submit_texts); i++) {
+        gchar *path;
+
+        path = g_strdup_printf ("/MM/bench/sms/%s", submit_texts[i].name);
+        g_test_add_data_func (path, GUINT_TO_POINTER (i), bench_encode);
+        g_free (path);
+    }
+    g_test_add_func ("/MM/bench/sms/robustness", test_robustness);
+
+    ret = g_test_run ();
+
+    g_ptr_array_unref (corpus);
+    return ret;
+}
+
+#endif /* FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION */
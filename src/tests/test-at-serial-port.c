@@ -16,8 +16,16 @@
 #include <config.h>
 #include <string.h>
 #include <glib.h>
+#include <glib/gstdio.h>
+
+#include <ModemManager.h>
+#define _LIBMM_INSIDE_MM
+#include <libmm-glib.h>
 
 #include "mm-port-serial-at.h"
+#include "mm-serial-parsers.h"
+#include "mm-serial-stats.h"
+#include "mm-serial-recorder.h"
 #include "mm-log.h"
 
 typedef struct {
@@ -64,6 +72,543 @@ at_serial_echo_removal (void)
     }
 }
 
+typedef struct {
+    const gchar *response;
+    gboolean     found;
+    const gchar *parsed;
+    GQuark       error_domain;
+    gint         error_code;
+} ParserTest;
+
+static const ParserTest parser_tests[] = {
+    { "\r\nOK\r\n", TRUE, "", 0, 0 },
+    { "\r\n+CGMI: Foo\r\n\r\nOK\r\n", TRUE, "+CGMI: Foo", 0, 0 },
+    { "\r\n+CGMI: Foo\r\n", FALSE, NULL, 0, 0 },
+    { "\r\n+CGMI: Foo\r\n\r\nO", FALSE, NULL, 0, 0 },
+    { "\r\nCONNECT 115200\r\n", TRUE, "CONNECT 115200", 0, 0 },
+    { "\r\nCONNECT 1152", FALSE, NULL, 0, 0 },
+    { "\r\n> ", TRUE, ">", 0, 0 },
+    { "\r\n+CME ERROR: 10\r\n", TRUE, NULL, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_SIM_NOT_INSERTED },
+    { "\r\n+CME ERROR: SIM not inserted\r\n", TRUE, NULL, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_SIM_NOT_INSERTED },
+    { "\r\n+CMS ERROR: 310\r\n", TRUE, NULL, MM_MESSAGE_ERROR, MM_MESSAGE_ERROR_SIM_NOT_INSERTED },
+    { "\r\nERROR\r\n", TRUE, NULL, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN },
+    { "\r\nNO CARRIER\r\n", TRUE, NULL, MM_CONNECTION_ERROR, MM_CONNECTION_ERROR_NO_CARRIER },
+    { "\r\nBUSY\r\n", TRUE, NULL, MM_CONNECTION_ERROR, MM_CONNECTION_ERROR_BUSY },
+    { "\r\nNO DIALTONE\r\n", TRUE, NULL, MM_CONNECTION_ERROR, MM_CONNECTION_ERROR_NO_DIALTONE },
+    { "\r\nNA\r\n", TRUE, NULL, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_NOT_ALLOWED },
+};
+
+static void
+check_parser_test (const ParserTest *test,
+                   gboolean          found,
+                   GString          *response,
+                   GError           *error)
+{
+    g_assert_cmpint (found, ==, test->found);
+    if (!found)
+        return;
+
+    if (test->error_domain) {
+        g_assert_error (error, test->error_domain, test->error_code);
+        return;
+    }
+
+    g_assert_no_error (error);
+    g_assert_cmpstr (response->str, ==, test->parsed);
+}
+
+static void
+at_serial_parser (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (parser_tests); i++) {
+        gpointer  parser;
+        GString  *response;
+        GError   *error = NULL;
+        gboolean  found;
+
+        parser = mm_serial_parser_v1_new ();
+        response = g_string_new (parser_tests[i].response);
+        found = mm_serial_parser_v1_parse (parser, response, NULL, &error);
+        check_parser_test (&parser_tests[i], found, response, error);
+        g_clear_error (&error);
+        g_string_free (response, TRUE);
+        mm_serial_parser_v1_destroy (parser);
+    }
+}
+
+static void
+at_serial_parser_incremental (void)
+{
+    guint i;
+
+    /* Feed each response byte by byte, as if each byte was a new read */
+    for (i = 0; i < G_N_ELEMENTS (parser_tests); i++) {
+        gpointer  parser;
+        GString  *response = NULL;
+        GError   *error = NULL;
+        gboolean  found = FALSE;
+        gsize     scanned = 0;
+        gsize     len;
+        gsize     j;
+
+        parser = mm_serial_parser_v1_new ();
+        len = strlen (parser_tests[i].response);
+        for (j = 1; j <= len && !found; j++) {
+            if (response)
+                g_string_free (response, TRUE);
+            response = g_string_new_len (parser_tests[i].response, j);
+            found = mm_serial_parser_v1_parse (parser, response, &scanned, &error);
+            if (!found)
+                g_assert_cmpuint (scanned, <=, j);
+        }
+        check_parser_test (&parser_tests[i], found, response, error);
+        g_clear_error (&error);
+        g_string_free (response, TRUE);
+        mm_serial_parser_v1_destroy (parser);
+    }
+}
+
+/* Drops everything up to the first '#' */
+static gboolean
+drop_prefix_filter (gpointer   data,
+                    gpointer   user_data,
+                    GString   *response,
+                    GError   **error)
+{
+    const gchar *mark;
+
+    mark = strchr (response->str, '#');
+    if (mark)
+        g_string_erase (response, 0, mark - response->str + 1);
+    return TRUE;
+}
+
+static void
+at_serial_parser_incremental_filter (void)
+{
+    gpointer  parser;
+    GString  *response;
+    GError   *error = NULL;
+    gboolean  found;
+    gsize     scanned = 0;
+    gchar    *junk;
+
+    parser = mm_serial_parser_v1_new ();
+    mm_serial_parser_v1_add_filter (parser, drop_prefix_filter, NULL);
+
+    junk = g_strnfill (64, 'x');
+    response = g_string_new (junk);
+    found = mm_serial_parser_v1_parse (parser, response, &scanned, &error);
+    g_assert (!found);
+    g_assert_no_error (error);
+
+    /* The filter removes what was already scanned; the error must still be
+     * found at the beginning of the new response */
+    g_string_append (response, "#\r\nERROR\r\n");
+    found = mm_serial_parser_v1_parse (parser, response, &scanned, &error);
+    g_assert (found);
+    g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+
+    g_error_free (error);
+    g_string_free (response, TRUE);
+    g_free (junk);
+    mm_serial_parser_v1_destroy (parser);
+}
+
+typedef struct {
+    const gchar *pattern;
+    const gchar *prefix;
+} UnsolicitedMsgPrefixTest;
+
+static const UnsolicitedMsgPrefixTest unsolicited_msg_prefix_tests[] = {
+    { "\\r\\n\\+CREG: (\\d)\\r\\n",            "+CREG: "     },
+    { "\\r\\n\\^HCSQ:(.*)\\r\\n",              "^HCSQ:"      },
+    { "\\r+\\n\\+CIEV: (.*)\\r\\n",            "+CIEV: "     },
+    { "\\r\\n(\\^NDISSTAT:.+)\\r+\\n",         "^NDISSTAT:"  },
+    { "\\r\\n\\+PACSP.*\\r\\n",                "+PACSP"      },
+    { "\\r\\n\\+ZEND\\r\\n",                   "+ZEND"       },
+    { "\\r\\n(\\+CREG: )?(\\d)\\r\\n",         NULL          },
+    { "\\r\\n\\+(CREG|CGREG):(.*)\\r\\n",      NULL          },
+    { "\\+CREG: (\\d)\\r\\n",                  NULL          },
+    { "\\r?\\n\\+CREG: (\\d)\\r\\n",           NULL          },
+    { "\\r\\n\\s*\\+CREG: (\\d)\\r\\n",        NULL          },
+};
+
+static void
+at_serial_unsolicited_msg_prefix (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (unsolicited_msg_prefix_tests); i++) {
+        GRegex *regex;
+        gchar  *prefix;
+
+        regex = g_regex_new (unsolicited_msg_prefix_tests[i].pattern, G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, NULL);
+        g_assert (regex);
+        prefix = mm_port_serial_at_unsolicited_msg_prefix_from_regex (regex);
+        g_assert_cmpstr (prefix, ==, unsolicited_msg_prefix_tests[i].prefix);
+        g_free (prefix);
+        g_regex_unref (regex);
+    }
+}
+
+/*****************************************************************************/
+
+static gint64 fake_time;
+
+static gint64
+fake_time_func (void)
+{
+    return fake_time;
+}
+
+static GByteArray *
+byte_array_new_from_string (const gchar *str)
+{
+    GByteArray *array;
+
+    array = g_byte_array_new ();
+    g_byte_array_append (array, (const guint8 *) str, strlen (str));
+    return array;
+}
+
+static void
+assert_cached (MMSerialReplyCache *cache,
+               const gchar *command,
+               const gchar *expected)
+{
+    GByteArray *array;
+    const GByteArray *cached;
+
+    array = byte_array_new_from_string (command);
+    cached = mm_serial_reply_cache_lookup (cache, array);
+    if (!expected)
+        g_assert (cached == NULL);
+    else {
+        g_assert (cached != NULL);
+        g_assert_cmpuint (cached->len, ==, strlen (expected));
+        g_assert (memcmp (cached->data, expected, cached->len) == 0);
+    }
+    g_byte_array_unref (array);
+}
+
+static void
+insert_cached (MMSerialReplyCache *cache,
+               const gchar *command,
+               const gchar *response)
+{
+    GByteArray *command_array;
+    GByteArray *response_array;
+
+    command_array = byte_array_new_from_string (command);
+    response_array = byte_array_new_from_string (response);
+    mm_serial_reply_cache_insert (cache, command_array, response_array);
+    g_byte_array_unref (command_array);
+    g_byte_array_unref (response_array);
+}
+
+static void
+at_serial_reply_cache (void)
+{
+    MMSerialReplyCache *cache;
+    GByteArray *array;
+
+    fake_time = 0;
+    cache = mm_serial_reply_cache_new (3, 1000);
+    mm_serial_reply_cache_set_time_func (cache, fake_time_func);
+    mm_serial_reply_cache_add_class (cache, "AT+CGMI", MM_SERIAL_REPLY_CACHE_TTL_INFINITE, TRUE);
+    mm_serial_reply_cache_add_invalidation (cache, "+CREG", "AT+COPS?");
+
+    array = byte_array_new_from_string ("AT+CGMI\r");
+    g_assert (mm_serial_reply_cache_is_always_cacheable (cache, array));
+    g_byte_array_unref (array);
+    array = byte_array_new_from_string ("AT+CSQ\r");
+    g_assert (!mm_serial_reply_cache_is_always_cacheable (cache, array));
+    g_byte_array_unref (array);
+
+    /* Insert and replace */
+    insert_cached (cache, "AT+CGMI\r", "Foo");
+    insert_cached (cache, "AT+COPS?\r", "+COPS: 0");
+    insert_cached (cache, "AT+COPS?\r", "+COPS: 1");
+    g_assert_cmpuint (mm_serial_reply_cache_get_length (cache), ==, 2);
+    assert_cached (cache, "AT+CGMI\r", "Foo");
+    assert_cached (cache, "AT+COPS?\r", "+COPS: 1");
+    assert_cached (cache, "AT+CSQ\r", NULL);
+
+    /* TTL: the default one expires, the class one doesn't */
+    fake_time = 1000 * 1000;
+    assert_cached (cache, "AT+COPS?\r", NULL);
+    assert_cached (cache, "AT+CGMI\r", "Foo");
+    g_assert_cmpuint (mm_serial_reply_cache_get_length (cache), ==, 1);
+
+    /* LRU eviction: "AT+CGMI" was the most recently used one */
+    insert_cached (cache, "AT+A\r", "a");
+    insert_cached (cache, "AT+B\r", "b");
+    assert_cached (cache, "AT+CGMI\r", "Foo");
+    insert_cached (cache, "AT+C\r", "c");
+    g_assert_cmpuint (mm_serial_reply_cache_get_length (cache), ==, 3);
+    assert_cached (cache, "AT+A\r", NULL);
+    assert_cached (cache, "AT+B\r", "b");
+    assert_cached (cache, "AT+CGMI\r", "Foo");
+
+    /* Invalidation */
+    insert_cached (cache, "AT+COPS?\r", "+COPS: 1");
+    mm_serial_reply_cache_invalidate (cache, (const guint8 *) "\r\n+CGREG: 1\r\n", 13);
+    assert_cached (cache, "AT+COPS?\r", "+COPS: 1");
+    mm_serial_reply_cache_invalidate (cache, (const guint8 *) "\r\n+CREG: 1\r\n", 12);
+    assert_cached (cache, "AT+COPS?\r", NULL);
+
+    /* Peeking doesn't count */
+    array = byte_array_new_from_string ("AT+CGMI\r");
+    g_assert (mm_serial_reply_cache_peek (cache, array) != NULL);
+    g_byte_array_unref (array);
+    array = byte_array_new_from_string ("AT+COPS?\r");
+    g_assert (mm_serial_reply_cache_peek (cache, array) == NULL);
+    g_byte_array_unref (array);
+
+    g_assert_cmpuint (mm_serial_reply_cache_get_hits (cache), ==, 7);
+    g_assert_cmpuint (mm_serial_reply_cache_get_misses (cache), ==, 4);
+
+    mm_serial_reply_cache_clear (cache);
+    g_assert_cmpuint (mm_serial_reply_cache_get_length (cache), ==, 0);
+    mm_serial_reply_cache_free (cache);
+}
+
+static void
+at_serial_reply_cache_max_size (void)
+{
+    MMSerialReplyCache *cache;
+
+    cache = mm_serial_reply_cache_new (0, MM_SERIAL_REPLY_CACHE_TTL_INFINITE);
+    mm_serial_reply_cache_set_max_size (cache, 24);
+
+    /* 8 bytes each */
+    insert_cached (cache, "AT+A\r", "aaa");
+    insert_cached (cache, "AT+B\r", "bbb");
+    insert_cached (cache, "AT+C\r", "ccc");
+    g_assert_cmpuint (mm_serial_reply_cache_get_size (cache), ==, 24);
+
+    /* Least recently used evicted until it fits */
+    assert_cached (cache, "AT+A\r", "aaa");
+    insert_cached (cache, "AT+D\r", "ddddddd");
+    g_assert_cmpuint (mm_serial_reply_cache_get_size (cache), ==, 20);
+    assert_cached (cache, "AT+B\r", NULL);
+    assert_cached (cache, "AT+C\r", NULL);
+    assert_cached (cache, "AT+A\r", "aaa");
+    assert_cached (cache, "AT+D\r", "ddddddd");
+
+    /* Replies larger than the whole cache are not stored, and drop any
+     * previous reply to the same command */
+    insert_cached (cache, "AT+A\r", "aaaaaaaaaaaaaaaaaaaaaaaa");
+    assert_cached (cache, "AT+A\r", NULL);
+    assert_cached (cache, "AT+D\r", "ddddddd");
+    g_assert_cmpuint (mm_serial_reply_cache_get_size (cache), ==, 12);
+
+    /* Replacing a reply only accounts for the new one */
+    insert_cached (cache, "AT+D\r", "d");
+    g_assert_cmpuint (mm_serial_reply_cache_get_size (cache), ==, 6);
+
+    /* Lowering the limit evicts right away */
+    mm_serial_reply_cache_set_max_size (cache, 4);
+    g_assert_cmpuint (mm_serial_reply_cache_get_length (cache), ==, 0);
+    g_assert_cmpuint (mm_serial_reply_cache_get_size (cache), ==, 0);
+
+    mm_serial_reply_cache_free (cache);
+}
+
+/*****************************************************************************/
+
+static void
+at_serial_command_intern (void)
+{
+    GByteArray *array;
+    GByteArray *other;
+
+    array = mm_port_serial_at_command_intern ("E0 V1", FALSE);
+    g_assert_cmpuint (array->len, ==, 8);
+    g_assert (memcmp (array->data, "ATE0 V1\r", 8) == 0);
+
+    /* Shared between calls */
+    other = mm_port_serial_at_command_intern ("E0 V1", FALSE);
+    g_assert (other == array);
+    g_byte_array_unref (other);
+
+    /* But not between line endings */
+    other = mm_port_serial_at_command_intern ("E0 V1", TRUE);
+    g_assert (other != array);
+    g_assert_cmpuint (other->len, ==, 9);
+    g_assert (memcmp (other->data, "ATE0 V1\r\n", 9) == 0);
+    g_byte_array_unref (other);
+    g_byte_array_unref (array);
+
+    /* Existing prefix and terminator are kept */
+    array = mm_port_serial_at_command_intern ("AT+CGMI\r", FALSE);
+    g_assert_cmpuint (array->len, ==, 8);
+    g_assert (memcmp (array->data, "AT+CGMI\r", 8) == 0);
+    g_byte_array_unref (array);
+}
+
+/*****************************************************************************/
+
+static void
+at_serial_stats (void)
+{
+    static const struct {
+        const gchar *command;
+        const gchar *prefix;
+    } prefix_tests[] = {
+        { "AT+CGDCONT=1,\"IP\",\"internet\"\r", "AT+CGDCONT" },
+        { "AT+CREG?\r",                         "AT+CREG"    },
+        { "at+cpms=?\r",                        "AT+CPMS"    },
+        { "ATZ\r",                              "ATZ"        },
+        { "\x4b\x13\x01\x00",                   "0x4b"       },
+    };
+    MMSerialStats *stats;
+    GVariantBuilder builder;
+    GVariant *variant;
+    GVariant *dict;
+    GVariant *histogram;
+    const guint32 *buckets;
+    gsize n_buckets;
+    GByteArray *command;
+    const gchar *prefix;
+    guint32 count;
+    guint32 timeouts;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (prefix_tests); i++) {
+        gchar *str;
+
+        command = byte_array_new_from_string (prefix_tests[i].command);
+        str = mm_serial_stats_command_prefix (command);
+        g_assert_cmpstr (str, ==, prefix_tests[i].prefix);
+        g_free (str);
+        g_byte_array_unref (command);
+    }
+
+    stats = mm_serial_stats_new ();
+    command = byte_array_new_from_string ("AT+CSQ\r");
+    mm_serial_stats_record (stats, command, 5000, 20000, 120000, FALSE);
+    mm_serial_stats_record (stats, command, 5000, -1, 3000000, TRUE);
+    g_byte_array_unref (command);
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    mm_serial_stats_build (stats, "ttyUSB0", &builder);
+    variant = g_variant_ref_sink (g_variant_builder_end (&builder));
+    g_assert_cmpuint (g_variant_n_children (variant), ==, 1);
+
+    dict = g_variant_get_child_value (variant, 0);
+    g_assert (g_variant_lookup (dict, "prefix", "&s", &prefix));
+    g_assert_cmpstr (prefix, ==, "AT+CSQ");
+    g_assert (g_variant_lookup (dict, "count", "u", &count));
+    g_assert_cmpuint (count, ==, 2);
+    g_assert (g_variant_lookup (dict, "timeouts", "u", &timeouts));
+    g_assert_cmpuint (timeouts, ==, 1);
+
+    /* 20ms in the <=50ms bucket, the missing one not recorded */
+    histogram = g_variant_lookup_value (dict, "first-byte", G_VARIANT_TYPE ("au"));
+    buckets = g_variant_get_fixed_array (histogram, &n_buckets, sizeof (guint32));
+    g_assert_cmpuint (n_buckets, ==, 10);
+    g_assert_cmpuint (buckets[1], ==, 1);
+    for (i = 0, count = 0; i < n_buckets; i++)
+        count += buckets[i];
+    g_assert_cmpuint (count, ==, 1);
+    g_variant_unref (histogram);
+
+    /* 120ms in the <=250ms bucket, 3s in the <=5000ms one */
+    histogram = g_variant_lookup_value (dict, "response", G_VARIANT_TYPE ("au"));
+    buckets = g_variant_get_fixed_array (histogram, &n_buckets, sizeof (guint32));
+    g_assert_cmpuint (buckets[3], ==, 1);
+    g_assert_cmpuint (buckets[7], ==, 1);
+    g_variant_unref (histogram);
+
+    g_variant_unref (dict);
+    g_variant_unref (variant);
+
+    /* Percentiles rounded up to the bucket limits */
+    command = byte_array_new_from_string ("AT+CSQ\r");
+    g_assert (mm_serial_stats_get_response_percentile (stats, command, 50, 2, &count));
+    g_assert_cmpuint (count, ==, 250);
+    g_assert (mm_serial_stats_get_response_percentile (stats, command, 99, 2, &count));
+    g_assert_cmpuint (count, ==, 5000);
+    g_assert (!mm_serial_stats_get_response_percentile (stats, command, 99, 3, &count));
+    mm_serial_stats_record (stats, command, 5000, -1, 30000000, TRUE);
+    g_assert (!mm_serial_stats_get_response_percentile (stats, command, 99, 2, &count));
+    g_byte_array_unref (command);
+    command = byte_array_new_from_string ("AT+COPS?\r");
+    g_assert (!mm_serial_stats_get_response_percentile (stats, command, 50, 0, &count));
+    g_byte_array_unref (command);
+
+    mm_serial_stats_free (stats);
+}
+
+static void
+at_serial_recorder (void)
+{
+    static const guint8 binary[] = { 0x7e, 0x00, 0x0d, 0x0a };
+    MMSerialRecorder *recorder;
+    MMSerialRecord   *record;
+    GPtrArray        *records;
+    GError           *error = NULL;
+    GDir             *dir;
+    gchar            *tmpdir;
+    gchar            *path;
+    const gchar      *name;
+
+    /* Nothing recorded without directory */
+    mm_serial_recorder_set_directory (NULL);
+    g_assert (mm_serial_recorder_new ("ttyUSB0") == NULL);
+
+    tmpdir = g_dir_make_tmp ("mm-serial-recorder-XXXXXX", &error);
+    g_assert_no_error (error);
+    mm_serial_recorder_set_directory (tmpdir);
+
+    recorder = mm_serial_recorder_new ("ttyUSB0");
+    g_assert (recorder != NULL);
+    mm_serial_recorder_write (recorder, MM_SERIAL_RECORD_DIRECTION_SENT, (const guint8 *) "AT+CSQ\r", 7);
+    mm_serial_recorder_write (recorder, MM_SERIAL_RECORD_DIRECTION_RECEIVED, binary, sizeof (binary));
+    mm_serial_recorder_free (recorder);
+    mm_serial_recorder_set_directory (NULL);
+
+    dir = g_dir_open (tmpdir, 0, &error);
+    g_assert_no_error (error);
+    name = g_dir_read_name (dir);
+    g_assert (name != NULL);
+    g_assert (g_str_has_prefix (name, "ttyUSB0-"));
+    path = g_build_filename (tmpdir, name, NULL);
+    g_dir_close (dir);
+
+    records = mm_serial_recorder_load (path, &error);
+    g_assert_no_error (error);
+    g_assert_cmpuint (records->len, ==, 2);
+
+    record = g_ptr_array_index (records, 0);
+    g_assert_cmpint (record->direction, ==, MM_SERIAL_RECORD_DIRECTION_SENT);
+    g_assert_cmpuint (record->data->len, ==, 7);
+    g_assert (memcmp (record->data->data, "AT+CSQ\r", 7) == 0);
+
+    record = g_ptr_array_index (records, 1);
+    g_assert_cmpint (record->direction, ==, MM_SERIAL_RECORD_DIRECTION_RECEIVED);
+    g_assert_cmpuint (record->data->len, ==, sizeof (binary));
+    g_assert (memcmp (record->data->data, binary, sizeof (binary)) == 0);
+    g_assert_cmpint (record->timestamp, >=, ((MMSerialRecord *) g_ptr_array_index (records, 0))->timestamp);
+    g_ptr_array_unref (records);
+
+    /* Broken records are reported */
+    g_assert (g_file_set_contents (path, "# comment\n10 --> 4154\n20 <-> 0d0a\n", -1, NULL));
+    records = mm_serial_recorder_load (path, &error);
+    g_assert (records == NULL);
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_INVALID_ARGS);
+    g_clear_error (&error);
+
+    g_unlink (path);
+    g_rmdir (tmpdir);
+    g_free (path);
+    g_free (tmpdir);
+}
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -84,12 +629,53 @@ _mm_log (const char *loc,
 #endif
 }
 
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
 int main (int argc, char **argv)
 {
     g_type_init ();
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/ModemManager/AT-serial/echo-removal", at_serial_echo_removal);
+    g_test_add_func ("/ModemManager/AT-serial/parser", at_serial_parser);
+    g_test_add_func ("/ModemManager/AT-serial/parser-incremental", at_serial_parser_incremental);
+    g_test_add_func ("/ModemManager/AT-serial/parser-incremental-filter", at_serial_parser_incremental_filter);
+    g_test_add_func ("/ModemManager/AT-serial/unsolicited-msg-prefix", at_serial_unsolicited_msg_prefix);
+    g_test_add_func ("/ModemManager/AT-serial/reply-cache", at_serial_reply_cache);
+    g_test_add_func ("/ModemManager/AT-serial/reply-cache-max-size", at_serial_reply_cache_max_size);
+    g_test_add_func ("/ModemManager/AT-serial/command-intern", at_serial_command_intern);
+    g_test_add_func ("/ModemManager/AT-serial/stats", at_serial_stats);
+    g_test_add_func ("/ModemManager/AT-serial/recorder", at_serial_recorder);
 
     return g_test_run ();
 }
@@ -0,0 +1,237 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "mm-byte-ring.h"
+
+/*****************************************************************************/
+
+/* Reads everything readable, in as many peeks as needed */
+static GString *
+drain (MMByteRing *ring)
+{
+    GString *str;
+    const guint8 *data;
+    gsize len;
+
+    str = g_string_new (NULL);
+    while ((len = mm_byte_ring_peek (ring, &data)) > 0) {
+        g_string_append_len (str, (const gchar *) data, len);
+        mm_byte_ring_release (ring, len);
+    }
+    return str;
+}
+
+static void
+test_push_peek (void)
+{
+    MMByteRing *ring;
+    const guint8 *data;
+    GString *str;
+
+    ring = mm_byte_ring_new (16);
+
+    g_assert_cmpuint (mm_byte_ring_peek (ring, &data), ==, 0);
+    g_assert (!mm_byte_ring_wait (ring, g_get_monotonic_time ()));
+
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "0123456789", 10));
+    g_assert (mm_byte_ring_wait (ring, -1));
+
+    /* Released in parts */
+    g_assert_cmpuint (mm_byte_ring_peek (ring, &data), ==, 10);
+    g_assert (memcmp (data, "0123", 4) == 0);
+    mm_byte_ring_release (ring, 4);
+    str = drain (ring);
+    g_assert_cmpstr (str->str, ==, "456789");
+    g_string_free (str, TRUE);
+
+    /* Around the end of the ring: two peeks */
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "abcdefghij", 10));
+    g_assert_cmpuint (mm_byte_ring_peek (ring, &data), ==, 6);
+    str = drain (ring);
+    g_assert_cmpstr (str->str, ==, "abcdefghij");
+    g_string_free (str, TRUE);
+
+    mm_byte_ring_free (ring);
+}
+
+static void
+test_full (void)
+{
+    MMByteRing *ring;
+    GString *str;
+
+    ring = mm_byte_ring_new (16);
+
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "0123456789", 10));
+    /* Refused as a whole */
+    g_assert (!mm_byte_ring_push (ring, (const guint8 *) "abcdefg", 7));
+    /* Fits exactly */
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "abcdef", 6));
+    g_assert (!mm_byte_ring_push (ring, (const guint8 *) "x", 1));
+    /* Nothing always fits */
+    g_assert (mm_byte_ring_push (ring, NULL, 0));
+
+    str = drain (ring);
+    g_assert_cmpstr (str->str, ==, "0123456789abcdef");
+    g_string_free (str, TRUE);
+
+    /* Room again once released */
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "0123456789abcdef", 16));
+    str = drain (ring);
+    g_assert_cmpstr (str->str, ==, "0123456789abcdef");
+    g_string_free (str, TRUE);
+
+    mm_byte_ring_free (ring);
+}
+
+static void
+test_close (void)
+{
+    MMByteRing *ring;
+    GString *str;
+
+    ring = mm_byte_ring_new (16);
+
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "abc", 3));
+    mm_byte_ring_close (ring);
+    g_assert (mm_byte_ring_is_closed (ring));
+
+    /* What was pushed before is still there */
+    g_assert (mm_byte_ring_wait (ring, -1));
+    str = drain (ring);
+    g_assert_cmpstr (str->str, ==, "abc");
+    g_string_free (str, TRUE);
+
+    /* And then waiting doesn't block */
+    g_assert (!mm_byte_ring_wait (ring, -1));
+
+    mm_byte_ring_free (ring);
+}
+
+/*****************************************************************************/
+
+#define N_BYTES (1 << 20)
+
+typedef struct {
+    MMByteRing *ring;
+    guint       received;
+    gboolean    in_order;
+} Consumer;
+
+/* Sleeps until woken up, so a missed wakeup hangs the test */
+static gpointer
+consumer_thread (Consumer *consumer)
+{
+    consumer->in_order = TRUE;
+
+    for (;;) {
+        const guint8 *data;
+        gboolean closed;
+        gsize len;
+
+        mm_byte_ring_wait (consumer->ring, -1);
+        closed = mm_byte_ring_is_closed (consumer->ring);
+
+        while ((len = mm_byte_ring_peek (consumer->ring, &data)) > 0) {
+            gsize i;
+
+            for (i = 0; i < len; i++) {
+                if (data[i] != (guint8) (consumer->received + i))
+                    consumer->in_order = FALSE;
+            }
+            consumer->received += len;
+            mm_byte_ring_release (consumer->ring, len);
+        }
+
+        if (closed)
+            break;
+    }
+    return NULL;
+}
+
+static void
+test_threads (void)
+{
+    Consumer consumer;
+    GThread *thread;
+    guint8 chunk[97];
+    guint pushed = 0;
+
+    consumer.ring = mm_byte_ring_new (256);
+    consumer.received = 0;
+    thread = g_thread_new ("consumer", (GThreadFunc) consumer_thread, &consumer);
+
+    while (pushed < N_BYTES) {
+        guint len;
+        guint i;
+
+        /* Odd sizes, so that chunks go around the end of the ring; MIN()
+         * evaluates its arguments twice, so pick the size first */
+        len = 1 + g_test_rand_int_range (0, sizeof (chunk));
+        len = MIN (len, N_BYTES - pushed);
+        for (i = 0; i < len; i++)
+            chunk[i] = (guint8) (pushed + i);
+
+        if (mm_byte_ring_push (consumer.ring, chunk, len))
+            pushed += len;
+        else {
+            /* Full; wait for the consumer instead of spinning */
+            g_assert (mm_byte_ring_flush (consumer.ring, g_get_monotonic_time () + 10 * G_USEC_PER_SEC));
+        }
+    }
+
+    mm_byte_ring_close (consumer.ring);
+    g_thread_join (thread);
+
+    g_assert_cmpuint (consumer.received, ==, N_BYTES);
+    g_assert (consumer.in_order);
+
+    mm_byte_ring_free (consumer.ring);
+}
+
+static void
+test_flush_timeout (void)
+{
+    MMByteRing *ring;
+
+    ring = mm_byte_ring_new (16);
+
+    /* Nothing pending */
+    g_assert (mm_byte_ring_flush (ring, g_get_monotonic_time ()));
+
+    /* No consumer */
+    g_assert (mm_byte_ring_push (ring, (const guint8 *) "abc", 3));
+    g_assert (!mm_byte_ring_flush (ring, g_get_monotonic_time () + 10000));
+
+    mm_byte_ring_free (ring);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/ModemManager/byte-ring/push-peek", test_push_peek);
+    g_test_add_func ("/ModemManager/byte-ring/full", test_full);
+    g_test_add_func ("/ModemManager/byte-ring/close", test_close);
+    g_test_add_func ("/ModemManager/byte-ring/threads", test_threads);
+    g_test_add_func ("/ModemManager/byte-ring/flush-timeout", test_flush_timeout);
+
+    return g_test_run ();
+}
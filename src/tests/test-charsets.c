@@ -327,6 +327,138 @@ test_pack_gsm7_7_chars_offset (void *f, gpointer d)
     g_free (packed);
 }
 
+/* Bit-serial reference implementations, to compare the block-based ones with */
+
+static void
+reference_unpack (const guint8 *gsm,
+                  guint32 num_septets,
+                  guint8 start_offset,
+                  guint8 *out)
+{
+    guint32 i;
+
+    for (i = 0; i < num_septets; i++) {
+        guint8 bits_here, bits_in_next, octet, offset, c;
+        guint32 start_bit;
+
+        start_bit = start_offset + (i * 7);
+        offset = start_bit % 8;
+        bits_here = offset ? (8 - offset) : 7;
+        bits_in_next = 7 - bits_here;
+
+        octet = gsm[start_bit / 8];
+        c = (octet >> offset) & (0xFF >> (8 - bits_here));
+        if (bits_in_next) {
+            octet = gsm[(start_bit / 8) + 1];
+            c |= (octet & (0xFF >> (8 - bits_in_next))) << bits_here;
+        }
+        out[i] = c;
+    }
+}
+
+static void
+reference_pack (const guint8 *src,
+                guint32 src_len,
+                guint8 start_offset,
+                guint8 *packed)
+{
+    guint octet = 0, lshift;
+    guint32 i;
+
+    for (i = 0, lshift = start_offset; i < src_len; i++) {
+        packed[octet] |= (src[i] & 0x7F) << lshift;
+        if (lshift > 1)
+            packed[octet + 1] = (src[i] & 0x7F) >> (8 - lshift);
+        if (lshift)
+            octet++;
+        lshift = lshift ? lshift - 1 : 7;
+    }
+}
+
+#define RANDOM_MAX_SEPTETS 200
+
+static void
+test_pack_unpack_gsm7_random (void *f, gpointer d)
+{
+    guint8 septets[RANDOM_MAX_SEPTETS];
+    guint8 packed[RANDOM_MAX_SEPTETS + 1];
+    guint8 expected[RANDOM_MAX_SEPTETS + 1];
+    guint8 unpacked[RANDOM_MAX_SEPTETS];
+    guint32 len;
+    guint8 offset;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (septets); i++)
+        septets[i] = (guint8) g_test_rand_int_range (0, 256);
+
+    for (len = 0; len <= RANDOM_MAX_SEPTETS; len++) {
+        for (offset = 0; offset < 8; offset++) {
+            guint32 plen;
+
+            plen = gsm_packed_len (len, offset);
+            g_assert_cmpuint (plen, <=, sizeof (packed));
+
+            memset (expected, 0, sizeof (expected));
+            reference_pack (septets, len, offset, expected);
+            gsm_pack_buffer (septets, len, offset, packed);
+            g_assert_cmpint (memcmp (packed, expected, plen), ==, 0);
+
+            reference_unpack (packed, len, offset, expected);
+            gsm_unpack_buffer (packed, len, offset, unpacked);
+            g_assert_cmpint (memcmp (unpacked, expected, len), ==, 0);
+            for (i = 0; i < len; i++)
+                g_assert_cmpuint (unpacked[i], ==, septets[i] & 0x7F);
+        }
+    }
+}
+
+#define BENCHMARK_SEPTETS    160
+#define BENCHMARK_ITERATIONS 200000
+
+static void
+test_pack_unpack_gsm7_benchmark (void *f, gpointer d)
+{
+    guint8 septets[BENCHMARK_SEPTETS];
+    guint8 packed[BENCHMARK_SEPTETS];
+    guint8 unpacked[BENCHMARK_SEPTETS];
+    gdouble reference_time, time;
+    guint i;
+
+    if (!g_test_perf ())
+        return;
+
+    for (i = 0; i < G_N_ELEMENTS (septets); i++)
+        septets[i] = (guint8) g_test_rand_int_range (0, 128);
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        memset (packed, 0, sizeof (packed));
+        reference_pack (septets, BENCHMARK_SEPTETS, 0, packed);
+    }
+    reference_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        gsm_pack_buffer (septets, BENCHMARK_SEPTETS, 0, packed);
+    time = g_test_timer_elapsed ();
+    g_test_message ("pack %u septets: %.3fs (reference: %.3fs)",
+                    BENCHMARK_SEPTETS, time, reference_time);
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        reference_unpack (packed, BENCHMARK_SEPTETS, 0, unpacked);
+    reference_time = g_test_timer_elapsed ();
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        gsm_unpack_buffer (packed, BENCHMARK_SEPTETS, 0, unpacked);
+    time = g_test_timer_elapsed ();
+    g_test_message ("unpack %u septets: %.3fs (reference: %.3fs)",
+                    BENCHMARK_SEPTETS, time, reference_time);
+
+    g_assert_cmpint (memcmp (unpacked, septets, BENCHMARK_SEPTETS), ==, 0);
+}
+
 static void
 test_take_convert_ucs2_hex_utf8 (void *f, gpointer d)
 {
@@ -362,6 +494,55 @@ test_take_convert_ucs2_bad_ascii2 (void *f, gpointer d)
     g_assert (converted == NULL);
 }
 
+static void
+test_hex_ucs2 (void *f, gpointer d)
+{
+    gchar *converted;
+
+    converted = mm_modem_charset_hex_to_utf8 ("0054002D004D006F00620069006C006500E920AC", MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (converted, ==, "T-Mobileé€");
+    g_free (converted);
+
+    converted = mm_modem_charset_utf8_to_hex ("T-Mobileé€", MM_MODEM_CHARSET_UCS2);
+    g_assert_cmpstr (converted, ==, "0054002D004D006F00620069006C006500E920AC");
+    g_free (converted);
+
+    /* Not hex */
+    converted = mm_modem_charset_hex_to_utf8 ("0054002G", MM_MODEM_CHARSET_UCS2);
+    g_assert (converted == NULL);
+}
+
+static void
+test_hex_gsm (void *f, gpointer d)
+{
+    gchar *converted;
+
+    /* 'H', 'i', escape + euro sign, 'ñ' */
+    converted = mm_modem_charset_hex_to_utf8 ("48691B657D", MM_MODEM_CHARSET_GSM);
+    g_assert_cmpstr (converted, ==, "Hi€ñ");
+    g_free (converted);
+}
+
+static void
+test_byte_array_append (void *f, gpointer d)
+{
+    static const guint8 expected_ucs2[] = { '"', 0x00, 0x48, 0x20, 0xAC, '"' };
+    static const guint8 expected_gsm[] = { 0x48, 0x1B, 0x65 };
+    GByteArray *array;
+
+    array = g_byte_array_new ();
+    g_assert (mm_modem_charset_byte_array_append (array, "H€", TRUE, MM_MODEM_CHARSET_UCS2));
+    g_assert_cmpuint (array->len, ==, sizeof (expected_ucs2));
+    g_assert_cmpint (memcmp (array->data, expected_ucs2, array->len), ==, 0);
+    g_byte_array_unref (array);
+
+    array = g_byte_array_new ();
+    g_assert (mm_modem_charset_byte_array_append (array, "H€", FALSE, MM_MODEM_CHARSET_GSM));
+    g_assert_cmpuint (array->len, ==, sizeof (expected_gsm));
+    g_assert_cmpint (memcmp (array->data, expected_gsm, array->len), ==, 0);
+    g_byte_array_unref (array);
+}
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -410,11 +591,17 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_pack_gsm7_last_septet_alone, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_pack_gsm7_7_chars_offset, NULL));
+    g_test_suite_add (suite, TESTCASE (test_pack_unpack_gsm7_random, NULL));
+    g_test_suite_add (suite, TESTCASE (test_pack_unpack_gsm7_benchmark, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_take_convert_ucs2_hex_utf8, NULL));
     g_test_suite_add (suite, TESTCASE (test_take_convert_ucs2_bad_ascii, NULL));
     g_test_suite_add (suite, TESTCASE (test_take_convert_ucs2_bad_ascii2, NULL));
 
+    g_test_suite_add (suite, TESTCASE (test_hex_ucs2, NULL));
+    g_test_suite_add (suite, TESTCASE (test_hex_gsm, NULL));
+    g_test_suite_add (suite, TESTCASE (test_byte_array_append, NULL));
+
     result = g_test_run ();
 
     return result;
@@ -0,0 +1,274 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <glib.h>
+#include <glib-object.h>
+#include <string.h>
+
+#include <libmm-glib.h>
+#include "mm-error-helpers.h"
+#include "mm-log.h"
+
+/* Every error in the tables, so that a table or its string index out of order
+ * shows up as a lookup failure */
+
+typedef struct {
+    guint code;
+    const gchar *error;
+} ErrorCase;
+
+static const ErrorCase me_cases[] = {
+    { MM_MOBILE_EQUIPMENT_ERROR_PHONE_FAILURE,                      "phonefailure" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NO_CONNECTION,                      "noconnectiontophone" },
+    { MM_MOBILE_EQUIPMENT_ERROR_LINK_RESERVED,                      "phoneadapterlinkreserved" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NOT_ALLOWED,                        "operationnotallowed" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NOT_SUPPORTED,                      "operationnotsupported" },
+    { MM_MOBILE_EQUIPMENT_ERROR_PH_SIM_PIN,                         "phsimpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_PH_FSIM_PIN,                        "phfsimpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_PH_FSIM_PUK,                        "phfsimpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_NOT_INSERTED,                   "simnotinserted" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_PIN,                            "simpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_PUK,                            "simpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_FAILURE,                        "simfailure" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_BUSY,                           "simbusy" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_WRONG,                          "simwrong" },
+    { MM_MOBILE_EQUIPMENT_ERROR_INCORRECT_PASSWORD,                 "incorrectpassword" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_PIN2,                           "simpin2required" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SIM_PUK2,                           "simpuk2required" },
+    { MM_MOBILE_EQUIPMENT_ERROR_MEMORY_FULL,                        "memoryfull" },
+    { MM_MOBILE_EQUIPMENT_ERROR_INVALID_INDEX,                      "invalidindex" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NOT_FOUND,                          "notfound" },
+    { MM_MOBILE_EQUIPMENT_ERROR_MEMORY_FAILURE,                     "memoryfailure" },
+    { MM_MOBILE_EQUIPMENT_ERROR_TEXT_TOO_LONG,                      "textstringtoolong" },
+    { MM_MOBILE_EQUIPMENT_ERROR_INVALID_CHARS,                      "invalidcharactersintextstring" },
+    { MM_MOBILE_EQUIPMENT_ERROR_DIAL_STRING_TOO_LONG,               "dialstringtoolong" },
+    { MM_MOBILE_EQUIPMENT_ERROR_DIAL_STRING_INVALID,                "invalidcharactersindialstring" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NO_NETWORK,                         "nonetworkservice" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_TIMEOUT,                    "networktimeout" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_NOT_ALLOWED,                "networknotallowedemergencycallsonly" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_PIN,                        "networkpersonalizationpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_PUK,                        "networkpersonalizationpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_SUBSET_PIN,                 "networksubsetpersonalizationpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_NETWORK_SUBSET_PUK,                 "networksubsetpersonalizationpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SERVICE_PIN,                        "serviceproviderpersonalizationpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_SERVICE_PUK,                        "serviceproviderpersonalizationpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_CORP_PIN,                           "corporatepersonalizationpinrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_CORP_PUK,                           "corporatepersonalizationpukrequired" },
+    { MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN,                            "unknownerror" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_ILLEGAL_MS,                    "illegalms" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_ILLEGAL_ME,                    "illegalme" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_SERVICE_NOT_ALLOWED,           "gprsservicesnotallowed" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_PLMN_NOT_ALLOWED,              "plmnnotallowed" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_LOCATION_NOT_ALLOWED,          "locationareanotallowed" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_ROAMING_NOT_ALLOWED,           "roamingnotallowedinthislocationarea" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_SERVICE_OPTION_NOT_SUPPORTED,  "serviceoperationnotsupported" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_SERVICE_OPTION_NOT_SUBSCRIBED, "requestedserviceoptionnotsubscribed" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_SERVICE_OPTION_OUT_OF_ORDER,   "serviceoptiontemporarilyoutoforder" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_UNKNOWN,                       "unspecifiedgprserror" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_PDP_AUTH_FAILURE,              "pdpauthenticationfailure" },
+    { MM_MOBILE_EQUIPMENT_ERROR_GPRS_INVALID_MOBILE_CLASS,          "invalidmobileclass" },
+};
+
+static const ErrorCase msg_cases[] = {
+    { MM_MESSAGE_ERROR_ME_FAILURE,             "mefailure" },
+    { MM_MESSAGE_ERROR_SMS_SERVICE_RESERVED,   "smsservicereserved" },
+    { MM_MESSAGE_ERROR_NOT_ALLOWED,            "operationnotallowed" },
+    { MM_MESSAGE_ERROR_NOT_SUPPORTED,          "operationnotsupported" },
+    { MM_MESSAGE_ERROR_INVALID_PDU_PARAMETER,  "invalidpduparameter" },
+    { MM_MESSAGE_ERROR_INVALID_TEXT_PARAMETER, "invalidtextparameter" },
+    { MM_MESSAGE_ERROR_SIM_NOT_INSERTED,       "simnotinserted" },
+    { MM_MESSAGE_ERROR_SIM_PIN,                "simpinrequired" },
+    { MM_MESSAGE_ERROR_PH_SIM_PIN,             "phsimpinrequired" },
+    { MM_MESSAGE_ERROR_SIM_FAILURE,            "simfailure" },
+    { MM_MESSAGE_ERROR_SIM_BUSY,               "simbusy" },
+    { MM_MESSAGE_ERROR_SIM_WRONG,              "simwrong" },
+    { MM_MESSAGE_ERROR_SIM_PUK,                "simpukrequired" },
+    { MM_MESSAGE_ERROR_SIM_PIN2,               "simpin2required" },
+    { MM_MESSAGE_ERROR_SIM_PUK2,               "simpuk2required" },
+    { MM_MESSAGE_ERROR_MEMORY_FAILURE,         "memoryfailure" },
+    { MM_MESSAGE_ERROR_INVALID_INDEX,          "invalidindex" },
+    { MM_MESSAGE_ERROR_MEMORY_FULL,            "memoryfull" },
+    { MM_MESSAGE_ERROR_SMSC_ADDRESS_UNKNOWN,   "smscaddressunknown" },
+    { MM_MESSAGE_ERROR_NO_NETWORK,             "nonetwork" },
+    { MM_MESSAGE_ERROR_NETWORK_TIMEOUT,        "networktimeout" },
+    { MM_MESSAGE_ERROR_NO_CNMA_ACK_EXPECTED,   "nocnmaackexpected" },
+    { MM_MESSAGE_ERROR_UNKNOWN,                "unknown" },
+};
+
+/* Same words as in the table, with the usual case and spacing of replies */
+static gchar *
+build_reply_string (const gchar *error)
+{
+    GString *str;
+    guint i;
+
+    str = g_string_new (" ");
+    for (i = 0; error[i]; i++) {
+        g_string_append_c (str, (i % 2) ? error[i] : g_ascii_toupper (error[i]));
+        if (i % 5 == 4)
+            g_string_append_c (str, ' ');
+    }
+    g_string_append (str, "\r");
+    return g_string_free (str, FALSE);
+}
+
+/*****************************************************************************/
+
+static void
+test_mobile_equipment_error_for_code (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (me_cases); i++) {
+        GError *error;
+
+        error = mm_mobile_equipment_error_for_code (me_cases[i].code);
+        g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, (gint) me_cases[i].code);
+        g_error_free (error);
+    }
+}
+
+static void
+test_mobile_equipment_error_for_string (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (me_cases); i++) {
+        GError *error;
+        gchar *str;
+
+        error = mm_mobile_equipment_error_for_string (me_cases[i].error);
+        g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, (gint) me_cases[i].code);
+        g_error_free (error);
+
+        str = build_reply_string (me_cases[i].error);
+        error = mm_mobile_equipment_error_for_string (str);
+        g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, (gint) me_cases[i].code);
+        g_error_free (error);
+        g_free (str);
+    }
+}
+
+static void
+test_mobile_equipment_error_unknown (void)
+{
+    GError *error;
+    gchar *str;
+
+    error = mm_mobile_equipment_error_for_code (583);
+    g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+    g_error_free (error);
+
+    error = mm_mobile_equipment_error_for_string ("not an error we know");
+    g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+    g_error_free (error);
+
+    error = mm_mobile_equipment_error_for_string ("");
+    g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+    g_error_free (error);
+
+    /* Longer than anything in the table */
+    str = g_strnfill (1000, 's');
+    error = mm_mobile_equipment_error_for_string (str);
+    g_assert_error (error, MM_MOBILE_EQUIPMENT_ERROR, MM_MOBILE_EQUIPMENT_ERROR_UNKNOWN);
+    g_error_free (error);
+    g_free (str);
+}
+
+static void
+test_message_error_for_code (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (msg_cases); i++) {
+        GError *error;
+
+        error = mm_message_error_for_code (msg_cases[i].code);
+        g_assert_error (error, MM_MESSAGE_ERROR, (gint) msg_cases[i].code);
+        g_error_free (error);
+    }
+}
+
+static void
+test_message_error_for_string (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (msg_cases); i++) {
+        GError *error;
+        gchar *str;
+
+        error = mm_message_error_for_string (msg_cases[i].error);
+        g_assert_error (error, MM_MESSAGE_ERROR, (gint) msg_cases[i].code);
+        g_error_free (error);
+
+        str = build_reply_string (msg_cases[i].error);
+        error = mm_message_error_for_string (str);
+        g_assert_error (error, MM_MESSAGE_ERROR, (gint) msg_cases[i].code);
+        g_error_free (error);
+        g_free (str);
+    }
+}
+
+static void
+test_message_error_unknown (void)
+{
+    GError *error;
+
+    error = mm_message_error_for_code (12);
+    g_assert_error (error, MM_MESSAGE_ERROR, MM_MESSAGE_ERROR_UNKNOWN);
+    g_error_free (error);
+
+    error = mm_message_error_for_string ("zzz");
+    g_assert_error (error, MM_MESSAGE_ERROR, MM_MESSAGE_ERROR_UNKNOWN);
+    g_error_free (error);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_type_init ();
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/MM/error-helpers/mobile-equipment/code",    test_mobile_equipment_error_for_code);
+    g_test_add_func ("/MM/error-helpers/mobile-equipment/string",  test_mobile_equipment_error_for_string);
+    g_test_add_func ("/MM/error-helpers/mobile-equipment/unknown", test_mobile_equipment_error_unknown);
+    g_test_add_func ("/MM/error-helpers/message/code",             test_message_error_for_code);
+    g_test_add_func ("/MM/error-helpers/message/string",           test_message_error_for_string);
+    g_test_add_func ("/MM/error-helpers/message/unknown",          test_message_error_unknown);
+
+    return g_test_run ();
+}
@@ -0,0 +1,349 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+
+#include <ModemManager.h>
+
+#include "mm-port-serial-gps.h"
+#include "mm-serial-buffer.h"
+#include "mm-log.h"
+
+#define GGA "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n"
+#define GSA "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0A\r\n"
+#define RMC "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n"
+
+/*****************************************************************************/
+
+/* A GPS port fed through its response parser, one call per read, as the
+ * serial port does when data arrives */
+typedef struct {
+    MMPortSerialGps *port;
+    MMSerialBuffer  *buffer;
+    /* Traces given to the handler, in order */
+    GPtrArray       *traces;
+    /* Everything given back as not being a trace */
+    GString         *other;
+} GpsTest;
+
+static void
+trace_cb (MMPortSerialGps *port,
+          const gchar     *trace,
+          GpsTest         *test)
+{
+    g_ptr_array_add (test->traces, g_strdup (trace));
+}
+
+static GpsTest *
+gps_test_new (void)
+{
+    GpsTest *test;
+
+    test = g_slice_new0 (GpsTest);
+    test->port = mm_port_serial_gps_new ("gps0");
+    test->buffer = mm_serial_buffer_new (16);
+    test->traces = g_ptr_array_new_with_free_func (g_free);
+    test->other = g_string_new (NULL);
+    mm_port_serial_gps_add_trace_handler (test->port, (MMPortSerialGpsTraceFn) trace_cb, test, NULL);
+    return test;
+}
+
+static void
+gps_test_free (GpsTest *test)
+{
+    g_object_unref (test->port);
+    mm_serial_buffer_free (test->buffer);
+    g_ptr_array_unref (test->traces);
+    g_string_free (test->other, TRUE);
+    g_slice_free (GpsTest, test);
+}
+
+static void
+gps_test_read (GpsTest     *test,
+               const gchar *data,
+               gsize        len)
+{
+    MMPortSerialResponseType  response_type;
+    GByteArray               *parsed = NULL;
+    GError                   *error = NULL;
+
+    mm_serial_buffer_append (test->buffer, (const guint8 *) data, len);
+    response_type = MM_PORT_SERIAL_GET_CLASS (test->port)->parse_response (MM_PORT_SERIAL (test->port),
+                                                                            test->buffer,
+                                                                            &parsed,
+                                                                            &error);
+    g_assert_no_error (error);
+    if (response_type == MM_PORT_SERIAL_RESPONSE_NONE) {
+        g_assert (parsed == NULL);
+        return;
+    }
+
+    g_assert_cmpint (response_type, ==, MM_PORT_SERIAL_RESPONSE_BUFFER);
+    g_assert (parsed != NULL);
+    g_string_append_len (test->other, (const gchar *) parsed->data, parsed->len);
+    g_byte_array_unref (parsed);
+}
+
+static void
+gps_test_assert_traces (GpsTest *test,
+                        ...)
+{
+    const gchar *expected;
+    va_list      args;
+    guint        i = 0;
+
+    va_start (args, test);
+    while ((expected = va_arg (args, const gchar *)) != NULL) {
+        g_assert_cmpuint (i, <, test->traces->len);
+        g_assert_cmpstr (g_ptr_array_index (test->traces, i), ==, expected);
+        i++;
+    }
+    va_end (args);
+    g_assert_cmpuint (i, ==, test->traces->len);
+}
+
+/*****************************************************************************/
+
+static void
+test_single (void)
+{
+    GpsTest *test;
+
+    test = gps_test_new ();
+    gps_test_read (test, GGA, strlen (GGA));
+    gps_test_assert_traces (test, GGA, NULL);
+    g_assert_cmpstr (test->other->str, ==, "");
+    g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, 0);
+    gps_test_free (test);
+}
+
+static void
+test_multiple_per_read (void)
+{
+    GpsTest *test;
+
+    test = gps_test_new ();
+    gps_test_read (test, GGA GSA RMC, strlen (GGA GSA RMC));
+    gps_test_assert_traces (test, GGA, GSA, RMC, NULL);
+    g_assert_cmpstr (test->other->str, ==, "");
+    g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, 0);
+    gps_test_free (test);
+}
+
+static void
+test_partial (void)
+{
+    const gchar *stream = GGA GSA;
+    gsize        len;
+    gsize        split;
+
+    /* Split the stream at every possible position */
+    len = strlen (stream);
+    for (split = 1; split < len; split++) {
+        GpsTest *test;
+
+        test = gps_test_new ();
+
+        gps_test_read (test, stream, split);
+        if (split < strlen (GGA)) {
+            /* Nothing complete yet, and the partial sentence is kept */
+            gps_test_assert_traces (test, NULL);
+            g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, split);
+        } else
+            gps_test_assert_traces (test, GGA, NULL);
+
+        gps_test_read (test, stream + split, len - split);
+        gps_test_assert_traces (test, GGA, GSA, NULL);
+        g_assert_cmpstr (test->other->str, ==, "");
+        g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, 0);
+
+        gps_test_free (test);
+    }
+}
+
+static void
+test_byte_by_byte (void)
+{
+    const gchar *stream = GGA GSA RMC;
+    GpsTest     *test;
+    gsize        i;
+
+    test = gps_test_new ();
+    for (i = 0; i < strlen (stream); i++)
+        gps_test_read (test, &stream[i], 1);
+    gps_test_assert_traces (test, GGA, GSA, RMC, NULL);
+    g_assert_cmpstr (test->other->str, ==, "");
+    gps_test_free (test);
+}
+
+static void
+test_garbage (void)
+{
+    GpsTest *test;
+
+    test = gps_test_new ();
+
+    /* Before, between and after sentences */
+    gps_test_read (test, "\r\nOK\r\n" GGA "xyz" GSA "\r\nERROR\r\n",
+                   strlen ("\r\nOK\r\n" GGA "xyz" GSA "\r\nERROR\r\n"));
+    gps_test_assert_traces (test, GGA, GSA, NULL);
+    g_assert_cmpstr (test->other->str, ==, "\r\nOK\r\nxyz\r\nERROR\r\n");
+    g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, 0);
+
+    gps_test_free (test);
+}
+
+static void
+test_broken_sentences (void)
+{
+    GpsTest *test;
+
+    test = gps_test_new ();
+
+    /* Interrupted by the start of the next one */
+    gps_test_read (test, "$GPGGA,0927" GSA, strlen ("$GPGGA,0927" GSA));
+    gps_test_assert_traces (test, GSA, NULL);
+    g_assert_cmpstr (test->other->str, ==, "$GPGGA,0927");
+    g_string_truncate (test->other, 0);
+
+    /* Missing <CR> */
+    gps_test_read (test, "$GPTXT,01*00\n" RMC, strlen ("$GPTXT,01*00\n" RMC));
+    gps_test_assert_traces (test, GSA, RMC, NULL);
+    g_assert_cmpstr (test->other->str, ==, "$GPTXT,01*00\n");
+
+    gps_test_free (test);
+}
+
+static void
+test_checksum (void)
+{
+    GpsTest *test;
+
+    test = gps_test_new ();
+
+    /* Wrong and malformed checksums are dropped */
+    gps_test_read (test, "$GPGSA,A,3*00\r\n", strlen ("$GPGSA,A,3*00\r\n"));
+    gps_test_read (test, "$GPGSA,A,3*G1\r\n", strlen ("$GPGSA,A,3*G1\r\n"));
+    gps_test_read (test, "$GPGSA,A,3*1\r\n", strlen ("$GPGSA,A,3*1\r\n"));
+    gps_test_assert_traces (test, NULL);
+    g_assert_cmpstr (test->other->str, ==, "");
+
+    /* No checksum at all is fine; lower case digits too */
+    gps_test_read (test, "$GPTXT,hello\r\n", strlen ("$GPTXT,hello\r\n"));
+    gps_test_read (test, "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0a\r\n",
+                   strlen ("$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0a\r\n"));
+    gps_test_assert_traces (test,
+                            "$GPTXT,hello\r\n",
+                            "$GPGSA,A,3,10,07,05,02,29,04,08,13,,,,,1.72,1.03,1.38*0a\r\n",
+                            NULL);
+
+    gps_test_free (test);
+}
+
+static void
+test_too_long (void)
+{
+    GpsTest *test;
+    gchar   *junk;
+
+    test = gps_test_new ();
+
+    /* A sentence which never ends is not waited for forever */
+    junk = g_strnfill (2048, 'A');
+    junk[0] = '$';
+    gps_test_read (test, junk, 2048);
+    gps_test_assert_traces (test, NULL);
+    g_assert_cmpuint (test->other->len, ==, 2048);
+    g_assert_cmpuint (mm_serial_buffer_get_length (test->buffer), ==, 0);
+
+    /* And the next sentence is found */
+    gps_test_read (test, GGA, strlen (GGA));
+    gps_test_assert_traces (test, GGA, NULL);
+
+    g_free (junk);
+    gps_test_free (test);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/ModemManager/GPS-serial/single", test_single);
+    g_test_add_func ("/ModemManager/GPS-serial/multiple-per-read", test_multiple_per_read);
+    g_test_add_func ("/ModemManager/GPS-serial/partial", test_partial);
+    g_test_add_func ("/ModemManager/GPS-serial/byte-by-byte", test_byte_by_byte);
+    g_test_add_func ("/ModemManager/GPS-serial/garbage", test_garbage);
+    g_test_add_func ("/ModemManager/GPS-serial/broken-sentences", test_broken_sentences);
+    g_test_add_func ("/ModemManager/GPS-serial/checksum", test_checksum);
+    g_test_add_func ("/ModemManager/GPS-serial/too-long", test_too_long);
+
+    return g_test_run ();
+}
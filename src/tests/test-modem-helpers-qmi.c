@@ -309,6 +309,111 @@ test_gobi3k_cdma (void)
 
 /*****************************************************************************/
 
+static gboolean
+bands_array_contains (GArray *bands,
+                      MMModemBand band)
+{
+    guint i;
+
+    for (i = 0; i < bands->len; i++) {
+        if (g_array_index (bands, MMModemBand, i) == band)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+test_bands_from_qmi_band_preference (void)
+{
+    GArray *bands;
+
+    /* Both halves of a band map to a single entry */
+    bands = mm_modem_bands_from_qmi_band_preference (
+        (QMI_NAS_BAND_PREFERENCE_BC_0_A_SYSTEM |
+         QMI_NAS_BAND_PREFERENCE_BC_0_B_SYSTEM |
+         QMI_NAS_BAND_PREFERENCE_GSM_900_PRIMARY |
+         QMI_NAS_BAND_PREFERENCE_GSM_900_EXTENDED |
+         QMI_NAS_BAND_PREFERENCE_WCDMA_2100 |
+         QMI_NAS_BAND_PREFERENCE_GSM_450),
+        (QMI_NAS_LTE_BAND_PREFERENCE_EUTRAN_1 |
+         QMI_NAS_LTE_BAND_PREFERENCE_EUTRAN_20 |
+         QMI_NAS_LTE_BAND_PREFERENCE_EUTRAN_43));
+
+    g_assert_cmpuint (bands->len, ==, 6);
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_CDMA_BC0_CELLULAR_800));
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_EGSM));
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_U2100));
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_EUTRAN_I));
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_EUTRAN_XX));
+    g_assert (bands_array_contains (bands, MM_MODEM_BAND_EUTRAN_XLIII));
+    g_array_unref (bands);
+}
+
+static void
+test_bands_to_qmi_band_preference (void)
+{
+    static const MMModemBand mm_bands[] = {
+        MM_MODEM_BAND_CDMA_BC0_CELLULAR_800,
+        MM_MODEM_BAND_EGSM,
+        MM_MODEM_BAND_U850,
+        MM_MODEM_BAND_EUTRAN_III,
+        MM_MODEM_BAND_EUTRAN_XLI,
+        /* Not supported */
+        MM_MODEM_BAND_EUTRAN_XXII,
+    };
+    GArray *bands;
+    QmiNasBandPreference qmi_bands;
+    QmiNasLteBandPreference qmi_lte_bands;
+
+    bands = g_array_new (FALSE, FALSE, sizeof (MMModemBand));
+    g_array_append_vals (bands, mm_bands, G_N_ELEMENTS (mm_bands));
+    mm_modem_bands_to_qmi_band_preference (bands, &qmi_bands, &qmi_lte_bands);
+    g_array_unref (bands);
+
+    g_assert_cmpuint ((guint64) qmi_bands, ==, (guint64) (QMI_NAS_BAND_PREFERENCE_BC_0_A_SYSTEM |
+                                                          QMI_NAS_BAND_PREFERENCE_BC_0_B_SYSTEM |
+                                                          QMI_NAS_BAND_PREFERENCE_GSM_900_PRIMARY |
+                                                          QMI_NAS_BAND_PREFERENCE_GSM_900_EXTENDED |
+                                                          QMI_NAS_BAND_PREFERENCE_WCDMA_850_US));
+    g_assert_cmpuint ((guint64) qmi_lte_bands, ==, (guint64) (QMI_NAS_LTE_BAND_PREFERENCE_EUTRAN_3 |
+                                                              QMI_NAS_LTE_BAND_PREFERENCE_EUTRAN_41));
+}
+
+#define BENCHMARK_ITERATIONS 200000
+
+static void
+test_bands_benchmark (void)
+{
+    GArray *bands;
+    QmiNasBandPreference qmi_bands;
+    QmiNasLteBandPreference qmi_lte_bands;
+    gdouble time;
+    guint i;
+
+    if (!g_test_perf ())
+        return;
+
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        bands = mm_modem_bands_from_qmi_band_preference ((QmiNasBandPreference) G_MAXUINT64,
+                                                         (QmiNasLteBandPreference) G_MAXUINT64);
+        g_array_unref (bands);
+    }
+    time = g_test_timer_elapsed ();
+    g_test_message ("bands from QMI band preference: %.3fs", time);
+
+    bands = mm_modem_bands_from_qmi_band_preference ((QmiNasBandPreference) G_MAXUINT64,
+                                                     (QmiNasLteBandPreference) G_MAXUINT64);
+    g_test_timer_start ();
+    for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+        mm_modem_bands_to_qmi_band_preference (bands, &qmi_bands, &qmi_lte_bands);
+    time = g_test_timer_elapsed ();
+    g_test_message ("bands to QMI band preference (%u bands): %.3fs", bands->len, time);
+    g_array_unref (bands);
+}
+
+/*****************************************************************************/
+
 void
 _mm_log (const char *loc,
          const char *func,
@@ -345,5 +450,9 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/QMI/Current-Capabilities/Gobi3k/GSM",  test_gobi3k_gsm);
     g_test_add_func ("/MM/QMI/Current-Capabilities/Gobi3k/CDMA", test_gobi3k_cdma);
 
+    g_test_add_func ("/MM/QMI/Bands/From-Band-Preference", test_bands_from_qmi_band_preference);
+    g_test_add_func ("/MM/QMI/Bands/To-Band-Preference",   test_bands_to_qmi_band_preference);
+    g_test_add_func ("/MM/QMI/Bands/Benchmark",            test_bands_benchmark);
+
     return g_test_run ();
 }
@@ -20,6 +20,7 @@
 
 #include <libmm-glib.h>
 #include "mm-modem-helpers.h"
+#include "mm-regex-registry.h"
 #include "mm-log.h"
 
 #if defined ENABLE_TEST_MESSAGE_TRACES
@@ -195,6 +196,46 @@ test_cmgl_response_pantech_multiple (void *f, gpointer d)
     test_cmgl_response (str, expected, G_N_ELEMENTS (expected));
 }
 
+static void
+test_cmgl_pdu_regex (void *f, gpointer d)
+{
+    /* Records are only matched once complete */
+    const gchar *str =
+        "\r\n+CMGL: 17,3,35\r\n079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020\r\n"
+        "+CMGL: 15,1,,35\r\n079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020\r\n"
+        "+CMGL: 13,3,35\r\n079100F40D1101000F001000B917118336058F300";
+    const gint expected_index[] = { 17, 15 };
+    const gint expected_status[] = { 3, 1 };
+    GRegex *r;
+    GMatchInfo *match_info = NULL;
+    guint n = 0;
+
+    r = mm_3gpp_cmgl_pdu_regex_get ();
+    g_assert (r != NULL);
+
+    g_regex_match (r, str, 0, &match_info);
+    while (g_match_info_matches (match_info)) {
+        gint index;
+        gint status;
+        gchar *pdu;
+
+        g_assert_cmpuint (n, <, G_N_ELEMENTS (expected_index));
+        g_assert (mm_get_int_from_match_info (match_info, 1, &index));
+        g_assert (mm_get_int_from_match_info (match_info, 2, &status));
+        pdu = mm_get_string_unquoted_from_match_info (match_info, 3);
+        g_assert_cmpint (index, ==, expected_index[n]);
+        g_assert_cmpint (status, ==, expected_status[n]);
+        g_assert_cmpstr (pdu, ==, "079100F40D1101000F001000B917118336058F300001954747A0E4ACF41F27298CDCE83C6EF371B0402814020");
+        g_free (pdu);
+        n++;
+        g_match_info_next (match_info, NULL);
+    }
+    g_match_info_free (match_info);
+    g_regex_unref (r);
+
+    g_assert_cmpuint (n, ==, G_N_ELEMENTS (expected_index));
+}
+
 /*****************************************************************************/
 /* Test CMGR responses */
 
@@ -326,6 +367,39 @@ test_cops_response_tm506 (void *f, gpointer d)
     test_cops_results ("TM-506", reply, &expected[0], G_N_ELEMENTS (expected));
 }
 
+static void
+test_cops_response_pooled_strings (void *f, gpointer d)
+{
+    const gchar *reply = "+COPS: (1,\"AT&T\",\"AT&T\",\"310410\",0),(1,\"AT&T\",\"AT&T\",\"310410\",2)";
+    GList *results;
+    GList *again;
+    MM3gppNetworkInfo *a;
+    MM3gppNetworkInfo *b;
+    MM3gppNetworkInfo *c;
+
+    results = mm_3gpp_parse_cops_test_response (reply, NULL);
+    g_assert_cmpuint (g_list_length (results), ==, 2);
+    a = results->data;
+    b = results->next->data;
+
+    /* Equal strings are shared, within and across results */
+    g_assert_cmpstr (a->operator_long, ==, "AT&T");
+    g_assert (a->operator_long == a->operator_short);
+    g_assert (a->operator_long == b->operator_long);
+    g_assert (a->operator_code == b->operator_code);
+
+    /* And across replies, while still in use */
+    again = mm_3gpp_parse_cops_test_response (reply, NULL);
+    g_assert_cmpuint (g_list_length (again), ==, 2);
+    c = again->data;
+    g_assert (c->operator_long == a->operator_long);
+    g_assert (c->operator_code == a->operator_code);
+
+    mm_3gpp_network_info_list_free (results);
+    g_assert_cmpstr (c->operator_code, ==, "310410");
+    mm_3gpp_network_info_list_free (again);
+}
+
 static void
 test_cops_response_gt3gplus (void *f, gpointer d)
 {
@@ -688,12 +762,52 @@ test_cops_response_umts_invalid (void *f, gpointer d)
     g_assert_no_error (error);
 }
 
+static void
+test_cops_partial_response (void *f, gpointer d)
+{
+    const gchar *reply = "\r\n+COPS: (1,\"T-Mobile US\",\"TMO US\",\"31026\",0),(1,\"Cingular (AT&T)\",\"Cingular\",\"310410\",2),,(0, 1, 3),(0-2)\r\n";
+    const gchar *end;
+    guint n_groups = 0;
+    guint n_found = 0;
+    gsize i;
+
+    /* Feed the reply as it would be received, byte by byte */
+    end = strstr (reply, ",,");
+    for (i = 0; i <= strlen (reply); i++) {
+        gchar *partial;
+        GList *results;
+
+        partial = g_strndup (reply, i);
+        results = mm_3gpp_parse_cops_test_partial_response (partial, &n_groups);
+        g_free (partial);
+
+        if (!results)
+            continue;
+
+        /* Each network is reported once, as soon as its group is complete */
+        g_assert_cmpuint (g_list_length (results), ==, 1);
+        n_found++;
+        if (n_found == 1) {
+            g_assert_cmpuint (i, ==, (gsize) (strstr (reply, "0),") + 2 - reply));
+            g_assert_cmpstr (((MM3gppNetworkInfo *) results->data)->operator_code, ==, "31026");
+        } else {
+            g_assert_cmpuint (i, ==, (gsize) (end - reply));
+            g_assert_cmpstr (((MM3gppNetworkInfo *) results->data)->operator_code, ==, "310410");
+            g_assert_cmpuint (((MM3gppNetworkInfo *) results->data)->access_tech, ==, MM_MODEM_ACCESS_TECHNOLOGY_UMTS);
+        }
+        mm_3gpp_network_info_list_free (results);
+    }
+
+    /* The supported modes and formats are not taken as networks */
+    g_assert_cmpuint (n_found, ==, 2);
+    g_assert_cmpuint (n_groups, ==, 2);
+}
+
 /*****************************************************************************/
 /* Test CREG/CGREG responses and unsolicited messages */
 
 typedef struct {
-    GPtrArray *solicited_creg;
-    GPtrArray *unsolicited_creg;
+    GRegex *unsolicited_creg;
 } RegTestData;
 
 static RegTestData *
@@ -702,16 +816,14 @@ reg_test_data_new (void)
     RegTestData *data;
 
     data = g_malloc0 (sizeof (RegTestData));
-    data->solicited_creg = mm_3gpp_creg_regex_get (TRUE);
-    data->unsolicited_creg = mm_3gpp_creg_regex_get (FALSE);
+    data->unsolicited_creg = mm_3gpp_creg_regex_get ();
     return data;
 }
 
 static void
 reg_test_data_free (RegTestData *data)
 {
-    mm_3gpp_creg_regex_destroy (data->solicited_creg);
-    mm_3gpp_creg_regex_destroy (data->unsolicited_creg);
+    g_regex_unref (data->unsolicited_creg);
     g_free (data);
 }
 
@@ -721,7 +833,6 @@ typedef struct {
     gulong ci;
     MMModemAccessTechnology act;
 
-    guint regex_num;
     gboolean cgreg;
     gboolean cereg;
 } CregResult;
@@ -733,15 +844,13 @@ test_creg_match (const char *test,
                  RegTestData *data,
                  const CregResult *result)
 {
-    int i;
     GMatchInfo *info  = NULL;
     MMModem3gppRegistrationState state = MM_MODEM_3GPP_REGISTRATION_STATE_UNKNOWN;
     MMModemAccessTechnology access_tech = MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN;
     gulong lac = 0, ci = 0;
     GError *error = NULL;
     gboolean success, cgreg = FALSE, cereg = FALSE;
-    guint regex_num = 0;
-    GPtrArray *array;
+    gchar *str;
 
     g_assert (reply);
     g_assert (test);
@@ -753,30 +862,20 @@ test_creg_match (const char *test,
            result->cgreg ? "G" : "",
            solicited ? "solicited" : "unsolicited");
 
-    array = solicited ? data->solicited_creg : data->unsolicited_creg;
-    for (i = 0; i < array->len; i++) {
-        GRegex *r = g_ptr_array_index (array, i);
-
-        if (g_regex_match (r, reply, 0, &info)) {
-            trace ("  matched with %d\n", i);
-            regex_num = i + 1;
-            break;
-        }
+    /* Unsolicited messages must be caught by the single handler regex; the
+     * parser gets the message alone */
+    if (solicited)
+        str = g_strdup (reply);
+    else {
+        g_assert (g_regex_match (data->unsolicited_creg, reply, 0, &info));
+        str = g_match_info_fetch (info, 1);
         g_match_info_free (info);
-        info = NULL;
     }
 
-    trace ("  regex_num (%u) == result->regex_num (%u)\n",
-           regex_num,
-           result->regex_num);
-
-    g_assert (info != NULL);
-    g_assert_cmpuint (regex_num, ==, result->regex_num);
-
-    success = mm_3gpp_parse_creg_response (info, &state, &lac, &ci, &access_tech, &cgreg, &cereg, &error);
-    g_match_info_free (info);
-    g_assert (success);
+    success = mm_3gpp_parse_creg_response (str, &state, &lac, &ci, &access_tech, &cgreg, &cereg, &error);
+    g_free (str);
     g_assert_no_error (error);
+    g_assert (success);
     g_assert_cmpuint (state, ==, result->state);
     g_assert (lac == result->lac);
     g_assert (ci == result->ci);
@@ -793,7 +892,7 @@ test_creg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, FALSE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("CREG=1", TRUE, reply, data, &result);
 }
@@ -803,7 +902,7 @@ test_creg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, FALSE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("CREG=1", FALSE, reply, data, &result);
 }
@@ -813,7 +912,7 @@ test_creg2_mercury_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 0,1,84CD,00D30173";
-    const CregResult result = { 1, 0x84cd, 0xd30173, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x84cd, 0xd30173, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Sierra Mercury CREG=2", TRUE, reply, data, &result);
 }
@@ -823,7 +922,7 @@ test_creg2_mercury_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,84CD,00D30156\r\n";
-    const CregResult result = { 1, 0x84cd, 0xd30156, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 1, 0x84cd, 0xd30156, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Sierra Mercury CREG=2", FALSE, reply, data, &result);
 }
@@ -833,7 +932,7 @@ test_creg2_sek850i_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,\"CE00\",\"01CEAD8F\"";
-    const CregResult result = { 1, 0xce00, 0x01cead8f, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0xce00, 0x01cead8f, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Sony Ericsson K850i CREG=2", TRUE, reply, data, &result);
 }
@@ -843,7 +942,7 @@ test_creg2_sek850i_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,\"CE00\",\"00005449\"\r\n";
-    const CregResult result = { 1, 0xce00, 0x5449, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 1, 0xce00, 0x5449, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Sony Ericsson K850i CREG=2", FALSE, reply, data, &result);
 }
@@ -853,7 +952,7 @@ test_creg2_e160g_solicited_unregistered (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,0,00,0";
-    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Huawei E160G unregistered CREG=2", TRUE, reply, data, &result);
 }
@@ -863,7 +962,7 @@ test_creg2_e160g_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,8BE3,2BAF";
-    const CregResult result = { 1, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Huawei E160G CREG=2", TRUE, reply, data, &result);
 }
@@ -873,7 +972,7 @@ test_creg2_e160g_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,8BE3,2BAF\r\n";
-    const CregResult result = { 2, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 2, 0x8be3, 0x2baf, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Huawei E160G CREG=2", FALSE, reply, data, &result);
 }
@@ -883,7 +982,7 @@ test_creg2_tm506_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG: 2,1,\"8BE3\",\"00002BAF\"";
-    const CregResult result = { 1, 0x8BE3, 0x2BAF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2BAF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     /* Test leading zeros in the CI */
     test_creg_match ("Sony Ericsson TM-506 CREG=2", TRUE, reply, data, &result);
@@ -894,7 +993,7 @@ test_creg2_xu870_unsolicited_unregistered (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,,\r\n";
-    const CregResult result = { 2, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 3, FALSE, FALSE };
+    const CregResult result = { 2, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Novatel XU870 unregistered CREG=2", FALSE, reply, data, &result);
 }
@@ -904,7 +1003,7 @@ test_creg2_iridium_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:002,001,\"18d8\",\"ffff\"";
-    const CregResult result = { 1, 0x18D8, 0xFFFF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 5, FALSE, FALSE };
+    const CregResult result = { 1, 0x18D8, 0xFFFF, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Iridium, CREG=2", TRUE, reply, data, &result);
 }
@@ -914,7 +1013,7 @@ test_creg2_no_leading_zeros_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:2,1,0001,0010";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("solicited CREG=2 with no leading zeros in integer fields", TRUE, reply, data, &result);
 }
@@ -924,7 +1023,7 @@ test_creg2_leading_zeros_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CREG:002,001,\"0001\",\"0010\"";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 5, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("solicited CREG=2 with leading zeros in integer fields", TRUE, reply, data, &result);
 }
@@ -934,7 +1033,7 @@ test_creg2_no_leading_zeros_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 1,0001,0010,0\r\n";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 6, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("unsolicited CREG=2 with no leading zeros in integer fields", FALSE, reply, data, &result);
 }
@@ -944,7 +1043,7 @@ test_creg2_leading_zeros_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 001,\"0001\",\"0010\",000\r\n";
-    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 7, FALSE, FALSE };
+    const CregResult result = { 1, 0x0001, 0x0010, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("unsolicited CREG=2 with leading zeros in integer fields", FALSE, reply, data, &result);
 }
@@ -954,7 +1053,7 @@ test_cgreg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, TRUE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , TRUE, FALSE };
 
     test_creg_match ("CGREG=1", TRUE, reply, data, &result);
 }
@@ -964,7 +1063,7 @@ test_cgreg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, TRUE, FALSE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , TRUE, FALSE };
 
     test_creg_match ("CGREG=1", FALSE, reply, data, &result);
 }
@@ -974,7 +1073,7 @@ test_cgreg2_f3607gw_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 2,1,\"8BE3\",\"00002B5D\",3";
-    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 8, TRUE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("Ericsson F3607gw CGREG=2", TRUE, reply, data, &result);
 }
@@ -984,7 +1083,7 @@ test_cgreg2_f3607gw_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1,\"8BE3\",\"00002B5D\",3\r\n";
-    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 6, TRUE, FALSE };
+    const CregResult result = { 1, 0x8BE3, 0x2B5D, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("Ericsson F3607gw CGREG=2", FALSE, reply, data, &result);
 }
@@ -994,7 +1093,7 @@ test_creg2_md400_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,5,\"0502\",\"0404736D\"\r\n";
-    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 4, FALSE, FALSE };
+    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, FALSE };
 
     test_creg_match ("Sony-Ericsson MD400 CREG=2", FALSE, reply, data, &result);
 }
@@ -1004,7 +1103,7 @@ test_cgreg2_md400_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 5,\"0502\",\"0404736D\",2\r\n";
-    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UMTS, 6, TRUE, FALSE };
+    const CregResult result = { 5, 0x0502, 0x0404736D, MM_MODEM_ACCESS_TECHNOLOGY_UMTS, TRUE, FALSE };
 
     test_creg_match ("Sony-Ericsson MD400 CGREG=2", FALSE, reply, data, &result);
 }
@@ -1014,7 +1113,7 @@ test_creg_cgreg_multi_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 5\r\n\r\n+CGREG: 0\r\n";
-    const CregResult result = { 5, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 1, FALSE, FALSE };
+    const CregResult result = { 5, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Multi CREG/CGREG", FALSE, reply, data, &result);
 }
@@ -1024,7 +1123,7 @@ test_creg_cgreg_multi2_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 0\r\n\r\n+CREG: 5\r\n";
-    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 1, TRUE, FALSE };
+    const CregResult result = { 0, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Multi CREG/CGREG #2", FALSE, reply, data, &result);
 }
@@ -1034,7 +1133,7 @@ test_cgreg2_x220_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 2,1, 81ED, 1A9CEB\r\n";
-    const CregResult result = { 1, 0x81ED, 0x1A9CEB, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, TRUE, FALSE };
+    const CregResult result = { 1, 0x81ED, 0x1A9CEB, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     /* Tests random spaces in response */
     test_creg_match ("Alcatel One-Touch X220D CGREG=2", FALSE, reply, data, &result);
@@ -1045,7 +1144,7 @@ test_creg2_s8500_wave_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,1,000B,2816, B, C2816\r\n";
-    const CregResult result = { 1, 0x000B, 0x2816, MM_MODEM_ACCESS_TECHNOLOGY_GSM, 9, FALSE, FALSE };
+    const CregResult result = { 1, 0x000B, 0x2816, MM_MODEM_ACCESS_TECHNOLOGY_GSM, FALSE, FALSE };
 
     test_creg_match ("Samsung Wave S8500 CREG=2", FALSE, reply, data, &result);
 }
@@ -1055,7 +1154,7 @@ test_creg2_gobi_weird_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CREG: 2,1,  0 5, 2715\r\n";
-    const CregResult result = { 1, 0x0000, 0x2715, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 4, FALSE, FALSE };
+    const CregResult result = { 1, 0x0000, 0x2715, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, FALSE, FALSE };
 
     test_creg_match ("Qualcomm Gobi 1000 CREG=2", TRUE, reply, data, &result);
 }
@@ -1065,7 +1164,7 @@ test_cgreg2_unsolicited_with_rac (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1,\"1422\",\"00000142\",3,\"00\"\r\n";
-    const CregResult result = { 1, 0x1422, 0x0142, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, 10, TRUE, FALSE };
+    const CregResult result = { 1, 0x1422, 0x0142, MM_MODEM_ACCESS_TECHNOLOGY_EDGE, TRUE, FALSE };
 
     test_creg_match ("CGREG=2 with RAC", FALSE, reply, data, &result);
 }
@@ -1075,7 +1174,7 @@ test_cereg1_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CEREG: 1,3";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 2, FALSE, TRUE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, TRUE };
 
     test_creg_match ("CEREG=1", TRUE, reply, data, &result);
 }
@@ -1085,7 +1184,7 @@ test_cereg1_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 3\r\n";
-    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , 1, FALSE, TRUE };
+    const CregResult result = { 3, 0, 0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN , FALSE, TRUE };
 
     test_creg_match ("CEREG=1", FALSE, reply, data, &result);
 }
@@ -1095,7 +1194,7 @@ test_cereg2_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2,1, 1F00, 79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 8, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("CEREG=2", TRUE, reply, data, &result);
 }
@@ -1105,7 +1204,7 @@ test_cereg2_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 1F00, 79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 6, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("CEREG=2", FALSE, reply, data, &result);
 }
@@ -1115,7 +1214,7 @@ test_cereg2_altair_lte_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 2, 0001, 00000100, 7\r\n";
-    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 8, FALSE, TRUE };
+    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Altair LTE CEREG=2", FALSE, reply, data, &result);
 }
@@ -1125,7 +1224,7 @@ test_cereg2_altair_lte_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2, 0001, 00000100, 7\r\n";
-    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 6, FALSE, TRUE };
+    const CregResult result = { 2, 0x0001, 0x00000100, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Altair LTE CEREG=2", FALSE, reply, data, &result);
 }
@@ -1135,7 +1234,7 @@ test_cereg2_novatel_lte_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 2,1, 1F00, 20 ,79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 13, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Novatel LTE E362 CEREG=2", TRUE, reply, data, &result);
 }
@@ -1145,7 +1244,7 @@ test_cereg2_novatel_lte_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CEREG: 1, 1F00, 20 ,79D903 ,7\r\n";
-    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, 12, FALSE, TRUE };
+    const CregResult result = { 1, 0x1F00, 0x79D903, MM_MODEM_ACCESS_TECHNOLOGY_LTE, FALSE, TRUE };
 
     test_creg_match ("Novatel LTE E362 CEREG=2", FALSE, reply, data, &result);
 }
@@ -1155,7 +1254,7 @@ test_cgreg2_thuraya_solicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "+CGREG: 1, \"0426\", \"F0,0F\"";
-    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 11, TRUE, FALSE };
+    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Thuraya solicited CREG=2", TRUE, reply, data, &result);
 }
@@ -1165,11 +1264,50 @@ test_cgreg2_thuraya_unsolicited (void *f, gpointer d)
 {
     RegTestData *data = (RegTestData *) d;
     const char *reply = "\r\n+CGREG: 1, \"0426\", \"F0,0F\"\r\n";
-    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, 11, TRUE, FALSE };
+    const CregResult result = { 1, 0x0426, 0x00F0, MM_MODEM_ACCESS_TECHNOLOGY_UNKNOWN, TRUE, FALSE };
 
     test_creg_match ("Thuraya unsolicited CREG=2", FALSE, reply, data, &result);
 }
 
+static void
+test_creg_test_response_not_unsolicited (void *f, gpointer d)
+{
+    RegTestData *data = (RegTestData *) d;
+
+    /* Replies to +CREG=? must be left for the command */
+    g_assert (!g_regex_match (data->unsolicited_creg, "\r\n+CREG: (0-2)\r\n", 0, NULL));
+}
+
+/*****************************************************************************/
+/* Test the shared regex registry */
+
+static void
+test_regex_registry (void *f, gpointer d)
+{
+    GRegex *a;
+    GRegex *b;
+    GRegex *c;
+
+    a = mm_regex_registry_get ("\\+CSQ:\\s*(\\d+)", G_REGEX_RAW);
+    b = mm_regex_registry_get ("\\+CSQ:\\s*(\\d+)", G_REGEX_RAW);
+    c = mm_regex_registry_get ("\\+CSQ:\\s*(\\d+)", 0);
+
+    /* Same pattern and options share the compiled regex */
+    g_assert (a == b);
+    g_assert (a != c);
+    g_assert (g_regex_get_compile_flags (a) & G_REGEX_OPTIMIZE);
+    g_assert (g_regex_match (a, "+CSQ: 21", 0, NULL));
+
+    g_regex_unref (a);
+    g_regex_unref (b);
+    g_regex_unref (c);
+
+    /* Still alive in the registry */
+    a = mm_regex_registry_get ("\\+CSQ:\\s*(\\d+)", G_REGEX_RAW);
+    g_assert (a == b);
+    g_regex_unref (a);
+}
+
 /*****************************************************************************/
 /* Test CSCS responses */
 
@@ -1916,6 +2054,164 @@ test_cgdcont_read_response_samsung (void *f, gpointer d)
     test_cgdcont_read_results ("Samsung", reply, &expected[0], G_N_ELEMENTS (expected));
 }
 
+/*****************************************************************************/
+/* Test CGACT read responses */
+
+static void
+test_cgact_read_results (const gchar *desc,
+                         const gchar *reply,
+                         MM3gppPdpContextActive *expected_results,
+                         guint32 expected_results_len)
+{
+    GList *l;
+    GError *error = NULL;
+    GList *results;
+
+    trace ("\nTesting %s +CGACT response...\n", desc);
+
+    results = mm_3gpp_parse_cgact_read_response (reply, &error);
+    g_assert_no_error (error);
+    if (expected_results_len) {
+        g_assert (results);
+        g_assert_cmpuint (g_list_length (results), ==, expected_results_len);
+    }
+
+    for (l = results; l; l = g_list_next (l)) {
+        MM3gppPdpContextActive *pdp = l->data;
+        gboolean found = FALSE;
+        guint i;
+
+        for (i = 0; !found && i < expected_results_len; i++) {
+            MM3gppPdpContextActive *expected;
+
+            expected = &expected_results[i];
+            if (pdp->cid == expected->cid) {
+                found = TRUE;
+                g_assert_cmpuint (pdp->active, ==, expected->active);
+            }
+        }
+
+        g_assert (found == TRUE);
+    }
+
+    mm_3gpp_pdp_context_active_list_free (results);
+}
+
+static void
+test_cgact_read_response_none (void *f, gpointer d)
+{
+    test_cgact_read_results ("none", "", NULL, 0);
+}
+
+static void
+test_cgact_read_response_single_inactive (void *f, gpointer d)
+{
+    const gchar *reply = "+CGACT: 1,0\r\n";
+    static MM3gppPdpContextActive expected[] = {
+        { 1, FALSE },
+    };
+
+    test_cgact_read_results ("single inactive", reply, &expected[0], G_N_ELEMENTS (expected));
+}
+
+static void
+test_cgact_read_response_multiple (void *f, gpointer d)
+{
+    const gchar *reply =
+        "+CGACT: 1,0\r\n"
+        "+CGACT: 4,1\r\n"
+        "+CGACT: 5,0\r\n";
+    static MM3gppPdpContextActive expected[] = {
+        { 1, FALSE },
+        { 4, TRUE  },
+        { 5, FALSE },
+    };
+
+    test_cgact_read_results ("multiple", reply, &expected[0], G_N_ELEMENTS (expected));
+}
+
+/*****************************************************************************/
+/* Test CLCC responses */
+
+static void
+test_clcc_results (const gchar *desc,
+                   const gchar *reply,
+                   MMCallInfo *expected_results,
+                   guint32 expected_results_len)
+{
+    GList *l;
+    GError *error = NULL;
+    GList *results = NULL;
+    gboolean ret;
+    guint i;
+
+    trace ("\nTesting %s +CLCC response...\n", desc);
+
+    ret = mm_3gpp_parse_clcc_response (reply, &results, &error);
+    g_assert_no_error (error);
+    g_assert (ret);
+    g_assert_cmpuint (g_list_length (results), ==, expected_results_len);
+
+    /* Sorted by index */
+    for (l = results, i = 0; l; l = g_list_next (l), i++) {
+        MMCallInfo *call_info = l->data;
+
+        g_assert_cmpuint (call_info->index, ==, expected_results[i].index);
+        g_assert_cmpuint (call_info->direction, ==, expected_results[i].direction);
+        g_assert_cmpuint (call_info->state, ==, expected_results[i].state);
+        g_assert_cmpstr (call_info->number, ==, expected_results[i].number);
+    }
+
+    mm_3gpp_call_info_list_free (results);
+}
+
+static void
+test_clcc_response_empty (void *f, gpointer d)
+{
+    test_clcc_results ("empty", "", NULL, 0);
+}
+
+static void
+test_clcc_response_single (void *f, gpointer d)
+{
+    const gchar *reply = "+CLCC: 1,1,4,0,0,\"123456789\",161";
+    static MMCallInfo expected[] = {
+        { 1, MM_CALL_DIRECTION_INCOMING, MM_CALL_STATE_RINGING_IN, "123456789" },
+    };
+
+    test_clcc_results ("single", reply, &expected[0], G_N_ELEMENTS (expected));
+}
+
+static void
+test_clcc_response_multiple (void *f, gpointer d)
+{
+    const gchar *reply =
+        "+CLCC: 3,0,2,0,0,\"+34600000003\",145\r\n"
+        "+CLCC: 1,1,1,0,0,\"+34600000001\",145\r\n"
+        "+CLCC: 2,1,5,0,0\r\n"
+        "+CLCC: 4,0,0,1,0,\"+34600000004\",145\r\n";
+    static MMCallInfo expected[] = {
+        { 1, MM_CALL_DIRECTION_INCOMING, MM_CALL_STATE_HELD,    "+34600000001" },
+        { 2, MM_CALL_DIRECTION_INCOMING, MM_CALL_STATE_WAITING, NULL           },
+        { 3, MM_CALL_DIRECTION_OUTGOING, MM_CALL_STATE_DIALING, "+34600000003" },
+        /* index 4 is a data call, ignored */
+    };
+
+    test_clcc_results ("multiple", reply, &expected[0], G_N_ELEMENTS (expected));
+}
+
+static void
+test_clcc_response_invalid (void *f, gpointer d)
+{
+    GError *error = NULL;
+    GList *results = NULL;
+
+    g_assert (!mm_3gpp_parse_clcc_response ("+CLCC: 1,1,9,0,0", &results, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_assert (results == NULL);
+    g_error_free (error);
+}
+
 /*****************************************************************************/
 /* Test CPMS responses */
 
@@ -2119,6 +2415,24 @@ test_cpms_query_response (void *f, gpointer d) {
     }
 }
 
+static void
+test_cpms_set_response (void *f, gpointer d)
+{
+    guint used = 0;
+    guint total = 0;
+
+    g_assert (mm_3gpp_parse_cpms_set_response ("+CPMS: 3,30,3,30,3,30", &used, &total));
+    g_assert_cmpuint (used, ==, 3);
+    g_assert_cmpuint (total, ==, 30);
+
+    /* Only mem1 set */
+    g_assert (mm_3gpp_parse_cpms_set_response ("+CPMS: 12, 255", &used, &total));
+    g_assert_cmpuint (used, ==, 12);
+    g_assert_cmpuint (total, ==, 255);
+
+    g_assert (!mm_3gpp_parse_cpms_set_response ("+CPMS: \"SM\",3,30", &used, &total));
+}
+
 /*****************************************************************************/
 /* Test CNUM responses */
 
@@ -2331,6 +2645,68 @@ test_parse_cds (void *f, gpointer d)
                       "07914356060013F1065A098136395339F6219011700463802190117004638030");
 }
 
+/*****************************************************************************/
+/* Test +CMT unsolicited message parsing */
+
+static void
+common_parse_cmt (const gchar *str,
+                  guint expected_pdu_len,
+                  const gchar *expected_pdu)
+{
+    GMatchInfo *match_info;
+    GRegex *regex;
+    gchar *pdu_len_str;
+    gchar *pdu;
+
+    regex = mm_3gpp_cmt_regex_get ();
+    g_regex_match (regex, str, 0, &match_info);
+    g_assert (g_match_info_matches (match_info));
+
+    pdu_len_str = g_match_info_fetch (match_info, 1);
+    g_assert (pdu_len_str != NULL);
+    g_assert_cmpuint ((guint) atoi (pdu_len_str), == , expected_pdu_len);
+
+    pdu = g_match_info_fetch (match_info, 2);
+    g_assert (pdu != NULL);
+
+    g_assert_cmpstr (pdu, ==, expected_pdu);
+
+    g_free (pdu);
+    g_free (pdu_len_str);
+
+    g_match_info_free (match_info);
+    g_regex_unref (regex);
+}
+
+static void
+test_parse_cmt (void *f, gpointer d)
+{
+    common_parse_cmt ("\r\n+CMT: ,24\r\n07914356060013F1040A9181395339F60000219011700463800441F45B0D\r\n",
+                      24,
+                      "07914356060013F1040A9181395339F60000219011700463800441F45B0D");
+}
+
+static void
+test_parse_cmt_alpha (void *f, gpointer d)
+{
+    common_parse_cmt ("\r\n+CMT: \"Some, one\",24\r\n07914356060013F1040A9181395339F60000219011700463800441F45B0D\r\n",
+                      24,
+                      "07914356060013F1040A9181395339F60000219011700463800441F45B0D");
+}
+
+static void
+test_parse_cmt_not_cmti (void *f, gpointer d)
+{
+    GMatchInfo *match_info;
+    GRegex *regex;
+
+    regex = mm_3gpp_cmt_regex_get ();
+    g_regex_match (regex, "\r\n+CMTI: \"SM\",3\r\n", 0, &match_info);
+    g_assert (!g_match_info_matches (match_info));
+    g_match_info_free (match_info);
+    g_regex_unref (regex);
+}
+
 typedef struct {
     const char *gsn;
     const char *expected_imei;
@@ -2680,6 +3056,71 @@ test_cclk_response (void)
     }
 }
 
+/*****************************************************************************/
+/* Test ISO8601 time parsing */
+
+static void
+test_iso8601_time (void)
+{
+    guint64 unix_time = 0;
+
+    g_assert (mm_parse_iso8601_time ("2014-08-05T04:00:21+10:00", &unix_time));
+    g_assert_cmpuint (unix_time, ==, 1407175221);
+    g_assert (mm_parse_iso8601_time ("2015-02-28T20:30:40-08:00", &unix_time));
+    g_assert_cmpuint (unix_time, ==, 1425184240);
+    g_assert (mm_parse_iso8601_time ("2015-03-01T04:30:40", &unix_time));
+    g_assert_cmpuint (unix_time, ==, 1425184240);
+
+    g_assert (!mm_parse_iso8601_time ("", &unix_time));
+    g_assert (!mm_parse_iso8601_time ("2015-02-30T20:30:40", &unix_time));
+    g_assert (!mm_parse_iso8601_time ("XX-XX-XXTXX:XX:XX", &unix_time));
+}
+
+/*****************************************************************************/
+/* Test +CTZV/+CTZE unsolicited messages */
+
+typedef struct {
+    const gchar *str;
+    gboolean ret;
+    gint offset;
+    gint dst_offset;
+} CtzTest;
+
+static const CtzTest ctz_tests[] = {
+    { "\r\n+CTZV: +8\r\n", TRUE, 120, MM_NETWORK_TIMEZONE_OFFSET_UNKNOWN },
+    { "\r\n+CTZV: \"-32\"\r\n", TRUE, -480, MM_NETWORK_TIMEZONE_OFFSET_UNKNOWN },
+    { "\r\n+CTZE: \"+8\",1,\"2015/02/28,20:30:40\"\r\n", TRUE, 120, 60 },
+    { "\r\n+CTZE: 4,0\r\n", TRUE, 60, 0 },
+    { "\r\n+CTZV: XX\r\n", FALSE, 0, 0 },
+    { NULL, FALSE, 0, 0 }
+};
+
+static void
+test_ctz_urc (void)
+{
+    GRegex *r;
+    guint i;
+
+    r = mm_3gpp_ctz_regex_get ();
+
+    for (i = 0; ctz_tests[i].str; i++) {
+        GMatchInfo *match_info = NULL;
+        MMNetworkTimezone *tz = NULL;
+
+        if (g_regex_match (r, ctz_tests[i].str, 0, &match_info))
+            tz = mm_3gpp_parse_ctz_match (match_info);
+        g_match_info_free (match_info);
+
+        g_assert (!!tz == ctz_tests[i].ret);
+        if (tz) {
+            g_assert_cmpint (mm_network_timezone_get_offset (tz), ==, ctz_tests[i].offset);
+            g_assert_cmpint (mm_network_timezone_get_dst_offset (tz), ==, ctz_tests[i].dst_offset);
+            g_object_unref (tz);
+        }
+    }
+
+    g_regex_unref (r);
+}
 
 /*****************************************************************************/
 /* Test +CRSM responses */
@@ -2732,6 +3173,203 @@ test_crsm_response (void)
     }
 }
 
+/*****************************************************************************/
+/* Test generic response shapes */
+
+static void
+test_at_response_shape (void)
+{
+    static const MMAtResponseShape shape = {
+        "+TEST:", TRUE, 2,
+        { MM_AT_FIELD_UINT, MM_AT_FIELD_INT, MM_AT_FIELD_STRING, MM_AT_FIELD_HEX }
+    };
+    MMAtResponseFields fields;
+    GError *error = NULL;
+    guint uvalue = 0;
+    gint ivalue = 0;
+    gchar *str;
+
+    /* All fields given */
+    g_assert (mm_at_response_shape_parse (&shape, "\r\n+TEST: 5, -3 ,\"abc\",1F\r\nOK\r\n", &fields, &error));
+    g_assert_no_error (error);
+    g_assert (mm_at_response_fields_get_uint (&fields, 0, &uvalue));
+    g_assert_cmpuint (uvalue, ==, 5);
+    g_assert (mm_at_response_fields_get_int (&fields, 1, &ivalue));
+    g_assert_cmpint (ivalue, ==, -3);
+    str = mm_at_response_fields_dup_string (&fields, 2);
+    g_assert_cmpstr (str, ==, "abc");
+    g_free (str);
+    g_assert (mm_at_response_fields_get_uint (&fields, 3, &uvalue));
+    g_assert_cmpuint (uvalue, ==, 0x1F);
+
+    /* Optional fields empty or not given; empty quoted strings are given */
+    g_assert (mm_at_response_shape_parse (&shape, "+TEST: 1,2,,", &fields, &error));
+    g_assert_no_error (error);
+    g_assert (mm_at_response_fields_dup_string (&fields, 2) == NULL);
+    g_assert (!mm_at_response_fields_get_uint (&fields, 3, &uvalue));
+    g_assert (mm_at_response_shape_parse (&shape, "+TEST: 1,2,\"\"", &fields, &error));
+    g_assert_no_error (error);
+    str = mm_at_response_fields_dup_string (&fields, 2);
+    g_assert_cmpstr (str, ==, "");
+    g_free (str);
+    g_assert (mm_at_response_shape_parse (&shape, "+TEST: 1,2", &fields, &error));
+    g_assert_no_error (error);
+
+    /* Fields beyond the ones in the shape are ignored */
+    g_assert (mm_at_response_shape_parse (&shape, "+TEST: 1,2,\"x\",A,7,\"y\"", &fields, &error));
+    g_assert_no_error (error);
+
+    /* Missing required field */
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: 1", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: ,2", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* Missing required tag */
+    g_assert (!mm_at_response_shape_parse (&shape, "1,2", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* Invalid numbers */
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: -1,2", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: 1,2x", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: 1,2,\"x\",G", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+
+    /* Unterminated string */
+    g_assert (!mm_at_response_shape_parse (&shape, "+TEST: 1,2,\"x", &fields, &error));
+    g_assert_error (error, MM_CORE_ERROR, MM_CORE_ERROR_FAILED);
+    g_clear_error (&error);
+}
+
+/*****************************************************************************/
+/* Test AT command concatenation */
+
+static void
+test_at_concatenation_commands (void)
+{
+    static const gchar *commands[] = { "+CREG?", "AT+CGREG?", "+CGDCONT=?" };
+    gchar *command;
+
+    /* Only reads and tests of extended syntax commands */
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("+CREG?"), ==, 5);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("AT+CGREG?"), ==, 6);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("+CGDCONT=?"), ==, 8);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("^SYSINFO?"), ==, 8);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("+CFUN=1"), ==, 0);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("+CGMI"), ==, 0);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("I"), ==, 0);
+    g_assert_cmpuint (mm_at_command_get_concatenable_name_length ("+?"), ==, 0);
+
+    command = mm_at_commands_concatenate (commands, G_N_ELEMENTS (commands));
+    g_assert_cmpstr (command, ==, "+CREG?;+CGREG?;+CGDCONT=?");
+    g_free (command);
+}
+
+static void
+test_at_concatenation_response (void)
+{
+    static const gchar *commands[] = { "+CREG?", "+CGREG?", "+CSQ?" };
+    gchar **responses;
+
+    /* Replies attributed by their prefix, whatever the order */
+    responses = mm_at_concatenated_response_split ("\r\n+CSQ: 20,99\r\n"
+                                                   "\r\n+CREG: 0,1\r\n"
+                                                   "\r\n+CGREG: 0,5\r\n",
+                                                   commands,
+                                                   G_N_ELEMENTS (commands));
+    g_assert (responses != NULL);
+    g_assert_cmpuint (g_strv_length (responses), ==, 3);
+    g_assert_cmpstr (responses[0], ==, "\r\n+CREG: 0,1\r\n");
+    g_assert_cmpstr (responses[1], ==, "\r\n+CGREG: 0,5\r\n");
+    g_assert_cmpstr (responses[2], ==, "\r\n+CSQ: 20,99\r\n");
+    g_strfreev (responses);
+
+    /* Several lines for the same command, and commands without reply */
+    responses = mm_at_concatenated_response_split ("+CGREG: 0,1\r\n+CGREG: 2,1\r\n",
+                                                   commands,
+                                                   G_N_ELEMENTS (commands));
+    g_assert (responses != NULL);
+    g_assert_cmpstr (responses[0], ==, "");
+    g_assert_cmpstr (responses[1], ==, "\r\n+CGREG: 0,1\r\n\r\n+CGREG: 2,1\r\n");
+    g_assert_cmpstr (responses[2], ==, "");
+    g_strfreev (responses);
+
+    /* A name which is the prefix of another one doesn't take its lines */
+    responses = mm_at_concatenated_response_split ("+CGREG: 0,1\r\n",
+                                                   commands,
+                                                   1);
+    g_assert (responses == NULL);
+
+    /* Lines which can't be attributed */
+    responses = mm_at_concatenated_response_split ("+CREG: 0,1\r\n12345\r\n",
+                                                   commands,
+                                                   G_N_ELEMENTS (commands));
+    g_assert (responses == NULL);
+    responses = mm_at_concatenated_response_split ("+CEREG: 0,1\r\n",
+                                                   commands,
+                                                   G_N_ELEMENTS (commands));
+    g_assert (responses == NULL);
+}
+
+/*****************************************************************************/
+/* Test +IPR=? responses */
+
+static void
+common_test_ipr (const gchar *reply,
+                 const guint *expected,
+                 guint n_expected)
+{
+    GArray *rates;
+    GError *error = NULL;
+    guint i;
+
+    rates = mm_parse_ipr_test_response (reply, &error);
+    g_assert_no_error (error);
+    g_assert (rates != NULL);
+    g_assert_cmpuint (rates->len, ==, n_expected);
+    for (i = 0; i < n_expected; i++)
+        g_assert_cmpuint (g_array_index (rates, guint, i), ==, expected[i]);
+    g_array_unref (rates);
+}
+
+static void
+test_ipr_response_lists (void)
+{
+    const guint expected[] = { 300, 1200, 9600, 57600, 115200, 230400, 460800, 921600 };
+
+    common_test_ipr ("+IPR: (0,300,1200,9600,57600,115200),(230400,921600,460800)",
+                     expected, G_N_ELEMENTS (expected));
+}
+
+static void
+test_ipr_response_range (void)
+{
+    const guint expected[] = { 115200, 230400, 460800, 500000, 576000, 921600 };
+
+    common_test_ipr ("+IPR: (0),(115200-921600)",
+                     expected, G_N_ELEMENTS (expected));
+}
+
+static void
+test_ipr_response_invalid (void)
+{
+    GArray *rates;
+    GError *error = NULL;
+
+    rates = mm_parse_ipr_test_response ("+IPR: (0)", &error);
+    g_assert (rates == NULL);
+    g_assert (error != NULL);
+    g_error_free (error);
+}
+
 /*****************************************************************************/
 
 void
@@ -2770,6 +3408,7 @@ int main (int argc, char **argv)
     reg_data = reg_test_data_new ();
 
     g_test_suite_add (suite, TESTCASE (test_cops_response_tm506, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cops_response_pooled_strings, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_gt3gplus, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_ac881, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_gtmax36, NULL));
@@ -2799,6 +3438,7 @@ int main (int argc, char **argv)
 
     g_test_suite_add (suite, TESTCASE (test_cops_response_gsm_invalid, NULL));
     g_test_suite_add (suite, TESTCASE (test_cops_response_umts_invalid, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cops_partial_response, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_creg1_solicited, reg_data));
     g_test_suite_add (suite, TESTCASE (test_creg1_unsolicited, reg_data));
@@ -2841,6 +3481,9 @@ int main (int argc, char **argv)
 
     g_test_suite_add (suite, TESTCASE (test_creg_cgreg_multi_unsolicited, reg_data));
     g_test_suite_add (suite, TESTCASE (test_creg_cgreg_multi2_unsolicited, reg_data));
+    g_test_suite_add (suite, TESTCASE (test_creg_test_response_not_unsolicited, reg_data));
+
+    g_test_suite_add (suite, TESTCASE (test_regex_registry, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cscs_icon225_support_response, NULL));
     g_test_suite_add (suite, TESTCASE (test_cscs_sierra_mercury_support_response, NULL));
@@ -2871,6 +3514,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cpms_response_mixed_spaces, NULL));
     g_test_suite_add (suite, TESTCASE (test_cpms_response_empty_fields, NULL));
     g_test_suite_add (suite, TESTCASE (test_cpms_query_response,        NULL));
+    g_test_suite_add (suite, TESTCASE (test_cpms_set_response,          NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cgdcont_test_response_single, NULL));
     g_test_suite_add (suite, TESTCASE (test_cgdcont_test_response_multiple, NULL));
@@ -2882,6 +3526,15 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cgdcont_read_response_nokia, NULL));
     g_test_suite_add (suite, TESTCASE (test_cgdcont_read_response_samsung, NULL));
 
+    g_test_suite_add (suite, TESTCASE (test_cgact_read_response_none, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cgact_read_response_single_inactive, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cgact_read_response_multiple, NULL));
+
+    g_test_suite_add (suite, TESTCASE (test_clcc_response_empty, NULL));
+    g_test_suite_add (suite, TESTCASE (test_clcc_response_single, NULL));
+    g_test_suite_add (suite, TESTCASE (test_clcc_response_multiple, NULL));
+    g_test_suite_add (suite, TESTCASE (test_clcc_response_invalid, NULL));
+
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic, NULL));
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic_without_detail, NULL));
     g_test_suite_add (suite, TESTCASE (test_cnum_response_generic_detail_unquoted, NULL));
@@ -2891,6 +3544,9 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_parse_operator_id, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_parse_cds, NULL));
+    g_test_suite_add (suite, TESTCASE (test_parse_cmt, NULL));
+    g_test_suite_add (suite, TESTCASE (test_parse_cmt_alpha, NULL));
+    g_test_suite_add (suite, TESTCASE (test_parse_cmt_not_cmti, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cdma_parse_gsn, NULL));
 
@@ -2898,6 +3554,7 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_generic_multiple, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_pantech, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgl_response_pantech_multiple, NULL));
+    g_test_suite_add (suite, TESTCASE (test_cmgl_pdu_regex, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cmgr_response_generic, NULL));
     g_test_suite_add (suite, TESTCASE (test_cmgr_response_telit, NULL));
@@ -2907,8 +3564,17 @@ int main (int argc, char **argv)
     g_test_suite_add (suite, TESTCASE (test_supported_capability_filter, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_cclk_response, NULL));
+    g_test_suite_add (suite, TESTCASE (test_iso8601_time, NULL));
+    g_test_suite_add (suite, TESTCASE (test_ctz_urc, NULL));
 
     g_test_suite_add (suite, TESTCASE (test_crsm_response, NULL));
+    g_test_suite_add (suite, TESTCASE (test_at_response_shape, NULL));
+    g_test_suite_add (suite, TESTCASE (test_at_concatenation_commands, NULL));
+    g_test_suite_add (suite, TESTCASE (test_at_concatenation_response, NULL));
+
+    g_test_suite_add (suite, TESTCASE (test_ipr_response_lists, NULL));
+    g_test_suite_add (suite, TESTCASE (test_ipr_response_range, NULL));
+    g_test_suite_add (suite, TESTCASE (test_ipr_response_invalid, NULL));
 
     result = g_test_run ();
 
@@ -460,6 +460,38 @@ _mm_log (const char *loc,
 #endif
 }
 
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
 typedef void (*TCFunc) (TestData *, gconstpointer);
 #define TESTCASE_PTY(s, t) g_test_add (s, TestData, NULL, (TCFunc)test_pty_create, (TCFunc)t, (TCFunc)test_pty_cleanup);
 
@@ -0,0 +1,272 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <string.h>
+#include <glib.h>
+
+#include "mm-serial-buffer.h"
+
+#define CONTENTS "0123456789ABCDEFGHIJ"
+
+/*****************************************************************************/
+
+static MMSerialBuffer *
+buffer_new (const gchar *contents,
+            gsize        mark)
+{
+    MMSerialBuffer *buffer;
+
+    /* Small storage, so that appending moves and grows it */
+    buffer = mm_serial_buffer_new (4);
+    mm_serial_buffer_append (buffer, (const guint8 *) contents, strlen (contents));
+    mm_serial_buffer_set_mark (buffer, mark);
+    return buffer;
+}
+
+static void
+assert_contents (MMSerialBuffer *buffer,
+                 const gchar    *expected)
+{
+    gchar *str;
+
+    str = g_strndup ((const gchar *) mm_serial_buffer_get_data (buffer),
+                     mm_serial_buffer_get_length (buffer));
+    g_assert_cmpstr (str, ==, expected);
+    g_free (str);
+}
+
+/*****************************************************************************/
+
+static void
+test_append_consume (void)
+{
+    MMSerialBuffer *buffer;
+    guint8         *room;
+
+    buffer = buffer_new (CONTENTS, 12);
+    assert_contents (buffer, CONTENTS);
+    g_assert_cmpuint (mm_serial_buffer_get_allocated (buffer), >=, strlen (CONTENTS));
+
+    /* Before the mark */
+    mm_serial_buffer_consume (buffer, 2);
+    assert_contents (buffer, "23456789ABCDEFGHIJ");
+    g_assert_cmpuint (mm_serial_buffer_get_mark (buffer), ==, 10);
+
+    /* Across the mark */
+    mm_serial_buffer_consume (buffer, 12);
+    assert_contents (buffer, "EFGHIJ");
+    g_assert_cmpuint (mm_serial_buffer_get_mark (buffer), ==, 0);
+
+    /* Reserve and commit after consuming */
+    room = mm_serial_buffer_reserve (buffer, 3);
+    memcpy (room, "xyz", 3);
+    mm_serial_buffer_commit (buffer, 3);
+    assert_contents (buffer, "EFGHIJxyz");
+
+    /* Everything */
+    mm_serial_buffer_consume (buffer, 9);
+    assert_contents (buffer, "");
+    mm_serial_buffer_append (buffer, (const guint8 *) "ab", 2);
+    assert_contents (buffer, "ab");
+
+    mm_serial_buffer_free (buffer);
+}
+
+static void
+test_copied (void)
+{
+    MMSerialBuffer *buffer;
+
+    buffer = buffer_new (CONTENTS, 0);
+    mm_serial_buffer_set_copied (buffer, 10);
+    g_assert_cmpuint (mm_serial_buffer_get_copied (buffer), ==, 10);
+
+    /* Appending keeps what was copied */
+    mm_serial_buffer_append (buffer, (const guint8 *) "K", 1);
+    g_assert_cmpuint (mm_serial_buffer_get_copied (buffer), ==, 10);
+
+    /* Removing lowers it to the removal point */
+    mm_serial_buffer_remove_range (buffer, 4, 2);
+    g_assert_cmpuint (mm_serial_buffer_get_copied (buffer), ==, 4);
+
+    /* Consuming resets it */
+    mm_serial_buffer_consume (buffer, 1);
+    g_assert_cmpuint (mm_serial_buffer_get_copied (buffer), ==, 0);
+
+    mm_serial_buffer_free (buffer);
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    gsize        offset;
+    gsize        len;
+    gsize        mark;
+    const gchar *expected;
+    gsize        expected_mark;
+} RemoveRangeTest;
+
+static const RemoveRangeTest remove_range_tests[] = {
+    /* At the head, same as consuming */
+    { 0,  3, 10, "3456789ABCDEFGHIJ",  7  },
+    /* Head shorter than the tail */
+    { 2,  3, 10, "0156789ABCDEFGHIJ",  7  },
+    /* Tail shorter than the head */
+    { 15, 3, 10, "0123456789ABCDEIJ",  10 },
+    /* At the tail */
+    { 17, 3, 10, "0123456789ABCDEFG",  10 },
+    /* Before the mark, ending right at it */
+    { 7,  3, 10, "0123456ABCDEFGHIJ",  7  },
+    /* Across the mark */
+    { 8,  4, 10, "01234567CDEFGHIJ",   8  },
+    /* Starting right at the mark */
+    { 10, 2, 10, "0123456789CDEFGHIJ", 10 },
+    /* After the mark */
+    { 12, 2, 10, "0123456789ABEFGHIJ", 10 },
+    /* Everything */
+    { 0,  20, 10, "",                  0  },
+    /* Nothing */
+    { 5,  0, 10, CONTENTS,             10 },
+};
+
+static void
+test_remove_range (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (remove_range_tests); i++) {
+        const RemoveRangeTest *test = &remove_range_tests[i];
+        MMSerialBuffer        *buffer;
+
+        buffer = buffer_new (CONTENTS, test->mark);
+        mm_serial_buffer_remove_range (buffer, test->offset, test->len);
+        assert_contents (buffer, test->expected);
+        g_assert_cmpuint (mm_serial_buffer_get_mark (buffer), ==, test->expected_mark);
+
+        /* Appending afterwards keeps the data contiguous */
+        mm_serial_buffer_append (buffer, (const guint8 *) "xy", 2);
+        g_assert_cmpuint (mm_serial_buffer_get_length (buffer), ==, strlen (test->expected) + 2);
+        g_assert (memcmp (mm_serial_buffer_get_data (buffer) + strlen (test->expected), "xy", 2) == 0);
+
+        mm_serial_buffer_free (buffer);
+    }
+}
+
+/*****************************************************************************/
+
+typedef struct {
+    /* Offset/len pairs */
+    gsize        ranges[8];
+    guint        n_ranges;
+    gsize        mark;
+    const gchar *expected;
+    gsize        expected_mark;
+} RemoveRangesTest;
+
+static const RemoveRangesTest remove_ranges_tests[] = {
+    /* Sorted, disjoint, all before the mark */
+    { { 1, 2, 5, 1 },             2, 10, "0346789ABCDEFGHIJ", 7  },
+    /* Unsorted */
+    { { 5, 1, 1, 2 },             2, 10, "0346789ABCDEFGHIJ", 7  },
+    /* Adjacent */
+    { { 2, 2, 4, 2 },             2, 10, "016789ABCDEFGHIJ",  6  },
+    /* Overlapping */
+    { { 2, 4, 4, 3 },             2, 10, "01789ABCDEFGHIJ",   5  },
+    /* One contained in another, unsorted */
+    { { 4, 1, 2, 6 },             2, 10, "0189ABCDEFGHIJ",    4  },
+    /* Before, across and after the mark */
+    { { 0, 1, 9, 3, 15, 2 },      3, 10, "12345678CDEHIJ",    8  },
+    /* All after the mark */
+    { { 12, 1, 18, 2, 14, 1 },    3, 10, "0123456789ABDFGH",  10 },
+    /* Starting at the mark */
+    { { 10, 2, 3, 1 },            2, 10, "012456789CDEFGHIJ", 9  },
+    /* Covering everything */
+    { { 10, 10, 0, 10 },          2, 10, "",                  0  },
+    /* Empty ranges among others */
+    { { 3, 0, 6, 2, 19, 0 },      3, 10, "01234589ABCDEFGHIJ", 8  },
+};
+
+static void
+test_remove_ranges (void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (remove_ranges_tests); i++) {
+        const RemoveRangesTest *test = &remove_ranges_tests[i];
+        MMSerialBuffer         *buffer;
+        GArray                 *ranges;
+        guint                   j;
+
+        ranges = g_array_new (FALSE, FALSE, sizeof (MMSerialBufferRange));
+        for (j = 0; j < test->n_ranges; j++) {
+            MMSerialBufferRange range;
+
+            range.offset = test->ranges[2 * j];
+            range.len = test->ranges[2 * j + 1];
+            g_array_append_val (ranges, range);
+        }
+
+        buffer = buffer_new (CONTENTS, test->mark);
+        mm_serial_buffer_remove_ranges (buffer, ranges);
+        assert_contents (buffer, test->expected);
+        g_assert_cmpuint (mm_serial_buffer_get_mark (buffer), ==, test->expected_mark);
+
+        mm_serial_buffer_free (buffer);
+        g_array_unref (ranges);
+    }
+}
+
+/* An invalid range anywhere leaves the buffer untouched */
+static void
+test_remove_ranges_invalid (void)
+{
+    MMSerialBuffer      *buffer;
+    GArray              *ranges;
+    MMSerialBufferRange  range;
+
+    buffer = buffer_new (CONTENTS, 10);
+    ranges = g_array_new (FALSE, FALSE, sizeof (MMSerialBufferRange));
+    range.offset = 1;
+    range.len = 2;
+    g_array_append_val (ranges, range);
+    range.offset = 18;
+    range.len = 5;
+    g_array_append_val (ranges, range);
+
+    g_test_expect_message (NULL, G_LOG_LEVEL_CRITICAL, "*assertion*failed*");
+    mm_serial_buffer_remove_ranges (buffer, ranges);
+    g_test_assert_expected_messages ();
+
+    assert_contents (buffer, CONTENTS);
+    g_assert_cmpuint (mm_serial_buffer_get_mark (buffer), ==, 10);
+
+    mm_serial_buffer_free (buffer);
+    g_array_unref (ranges);
+}
+
+/*****************************************************************************/
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/ModemManager/serial-buffer/append-consume", test_append_consume);
+    g_test_add_func ("/ModemManager/serial-buffer/copied", test_copied);
+    g_test_add_func ("/ModemManager/serial-buffer/remove-range", test_remove_range);
+    g_test_add_func ("/ModemManager/serial-buffer/remove-ranges", test_remove_ranges);
+    g_test_add_func ("/ModemManager/serial-buffer/remove-ranges-invalid", test_remove_ranges_invalid);
+
+    return g_test_run ();
+}
@@ -0,0 +1,279 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include <glib.h>
+
+#include "mm-sms-list-index.h"
+#include "mm-log.h"
+
+/* Any distinct pointers do as owners */
+static gchar owners[5];
+#define OWNER_A ((gpointer) &owners[0])
+#define OWNER_B ((gpointer) &owners[1])
+#define OWNER_C ((gpointer) &owners[2])
+#define OWNER_D ((gpointer) &owners[3])
+
+#define SECS(s) ((gint64) (s) * G_USEC_PER_SEC)
+
+static MMSmsPart *
+part_new (const gchar *number,
+          guint        index,
+          guint        reference,
+          guint        max,
+          guint        sequence)
+{
+    MMSmsPart *part;
+
+    part = mm_sms_part_new (index, MM_SMS_PDU_TYPE_DELIVER);
+    mm_sms_part_set_number (part, number);
+    mm_sms_part_set_concat_reference (part, reference);
+    mm_sms_part_set_concat_max (part, max);
+    mm_sms_part_set_concat_sequence (part, sequence);
+    return part;
+}
+
+/*****************************************************************************/
+
+static void
+test_duplicates (void)
+{
+    MMSmsListIndex *index;
+
+    index = mm_sms_list_index_new ();
+
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_SM, 1, OWNER_A);
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_SM, 2, OWNER_A);
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_ME, 1, OWNER_B);
+
+    /* The same index in another storage is another part */
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 1) == OWNER_A);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 2) == OWNER_A);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_ME, 1) == OWNER_B);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_ME, 2) == NULL);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 3) == NULL);
+
+    /* Adding it again replaces the owner */
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_SM, 2, OWNER_C);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 2) == OWNER_C);
+
+    /* Stale parts are removed one by one */
+    mm_sms_list_index_remove_part (index, MM_SMS_STORAGE_SM, 2);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 2) == NULL);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 1) == OWNER_A);
+
+    /* And all together with their owner */
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_MT, 7, OWNER_A);
+    mm_sms_list_index_remove_owner (index, OWNER_A, FALSE);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 1) == NULL);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_MT, 7) == NULL);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_ME, 1) == OWNER_B);
+
+    mm_sms_list_index_free (index);
+}
+
+static void
+test_mixed_references (void)
+{
+    MMSmsListIndex *index;
+    MMSmsPart      *parts[5];
+    MMSmsPart      *other;
+    guint           i;
+
+    index = mm_sms_list_index_new ();
+
+    /* Messages only differing in sender, reference or number of parts */
+    parts[0] = part_new ("+34600000001", 1, 5, 3, 1);
+    parts[1] = part_new ("+34600000001", 2, 6, 3, 1);
+    parts[2] = part_new ("+34600000002", 3, 5, 3, 1);
+    parts[3] = part_new ("+34600000001", 4, 5, 2, 1);
+    parts[4] = part_new (NULL,           5, 5, 3, 1);
+
+    for (i = 0; i < G_N_ELEMENTS (parts); i++) {
+        g_assert (mm_sms_list_index_lookup_multipart (index, parts[i]) == NULL);
+        mm_sms_list_index_add_multipart (index, parts[i], &owners[i], 0);
+    }
+    g_assert_cmpuint (mm_sms_list_index_get_n_multiparts (index), ==, G_N_ELEMENTS (parts));
+
+    for (i = 0; i < G_N_ELEMENTS (parts); i++)
+        g_assert (mm_sms_list_index_lookup_multipart (index, parts[i]) == &owners[i]);
+
+    /* Another part of the message without number goes with it */
+    other = part_new (NULL, 6, 5, 3, 2);
+    g_assert (mm_sms_list_index_lookup_multipart (index, other) == &owners[4]);
+    mm_sms_part_free (other);
+
+    for (i = 0; i < G_N_ELEMENTS (parts); i++)
+        mm_sms_part_free (parts[i]);
+    mm_sms_list_index_free (index);
+}
+
+static void
+test_out_of_order (void)
+{
+    MMSmsListIndex *index;
+    MMSmsPart      *a[3];
+    MMSmsPart      *b[2];
+    MMSmsPart      *reused;
+
+    index = mm_sms_list_index_new ();
+
+    a[0] = part_new ("+34600000001", 1, 9, 3, 1);
+    a[1] = part_new ("+34600000001", 2, 9, 3, 2);
+    a[2] = part_new ("+34600000001", 3, 9, 3, 3);
+    b[0] = part_new ("+34600000001", 4, 10, 2, 1);
+    b[1] = part_new ("+34600000001", 5, 10, 2, 2);
+
+    /* The last part of A comes first, then both messages interleaved */
+    mm_sms_list_index_add_multipart (index, a[2], OWNER_A, 0);
+    g_assert (mm_sms_list_index_lookup_multipart (index, b[1]) == NULL);
+    mm_sms_list_index_add_multipart (index, b[1], OWNER_B, 0);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a[0]) == OWNER_A);
+    g_assert (mm_sms_list_index_lookup_multipart (index, b[0]) == OWNER_B);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a[1]) == OWNER_A);
+
+    /* B is complete */
+    mm_sms_list_index_remove_multipart (index, b[0]);
+    g_assert (mm_sms_list_index_lookup_multipart (index, b[1]) == NULL);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a[1]) == OWNER_A);
+    g_assert_cmpuint (mm_sms_list_index_get_n_multiparts (index), ==, 1);
+
+    /* A is complete, removed with a part other than the one which added it */
+    mm_sms_list_index_remove_multipart (index, a[1]);
+    g_assert_cmpuint (mm_sms_list_index_get_n_multiparts (index), ==, 0);
+
+    /* The sender reuses the reference; that's a new message */
+    reused = part_new ("+34600000001", 6, 9, 3, 2);
+    g_assert (mm_sms_list_index_lookup_multipart (index, reused) == NULL);
+    mm_sms_list_index_add_multipart (index, reused, OWNER_C, 0);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a[0]) == OWNER_C);
+    mm_sms_part_free (reused);
+
+    mm_sms_part_free (a[0]);
+    mm_sms_part_free (a[1]);
+    mm_sms_part_free (a[2]);
+    mm_sms_part_free (b[0]);
+    mm_sms_part_free (b[1]);
+    mm_sms_list_index_free (index);
+}
+
+static void
+test_expire (void)
+{
+    MMSmsListIndex *index;
+    MMSmsPart      *a;
+    MMSmsPart      *b;
+    GList          *expired;
+
+    index = mm_sms_list_index_new ();
+
+    a = part_new ("+34600000001", 1, 1, 2, 1);
+    b = part_new ("+34600000002", 2, 1, 2, 1);
+    mm_sms_list_index_add_multipart (index, a, OWNER_A, SECS (0));
+    mm_sms_list_index_add_multipart (index, b, OWNER_B, SECS (0));
+
+    /* A new part of A delays its expiration */
+    mm_sms_list_index_touch_multipart (index, a, SECS (20));
+
+    expired = mm_sms_list_index_expire_multiparts (index, SECS (9), SECS (10));
+    g_assert (expired == NULL);
+
+    expired = mm_sms_list_index_expire_multiparts (index, SECS (10), SECS (10));
+    g_assert_cmpuint (g_list_length (expired), ==, 1);
+    g_assert (expired->data == OWNER_B);
+    g_list_free (expired);
+    g_assert (mm_sms_list_index_lookup_multipart (index, b) == NULL);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a) == OWNER_A);
+
+    expired = mm_sms_list_index_expire_multiparts (index, SECS (30), SECS (10));
+    g_assert_cmpuint (g_list_length (expired), ==, 1);
+    g_assert (expired->data == OWNER_A);
+    g_list_free (expired);
+    g_assert_cmpuint (mm_sms_list_index_get_n_multiparts (index), ==, 0);
+
+    mm_sms_part_free (a);
+    mm_sms_part_free (b);
+    mm_sms_list_index_free (index);
+}
+
+static void
+test_remove_owner (void)
+{
+    MMSmsListIndex *index;
+    MMSmsPart      *a;
+    MMSmsPart      *b;
+
+    index = mm_sms_list_index_new ();
+
+    a = part_new ("+34600000001", 1, 1, 2, 1);
+    b = part_new ("+34600000001", 2, 2, 2, 1);
+    mm_sms_list_index_add_multipart (index, a, OWNER_A, 0);
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_SM, 1, OWNER_A);
+    mm_sms_list_index_add_multipart (index, b, OWNER_D, 0);
+    mm_sms_list_index_add_part (index, MM_SMS_STORAGE_SM, 2, OWNER_D);
+
+    /* Only the parts, e.g. when the storage changes */
+    mm_sms_list_index_remove_owner (index, OWNER_A, FALSE);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 1) == NULL);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a) == OWNER_A);
+
+    /* Everything, when removed from the list */
+    mm_sms_list_index_remove_owner (index, OWNER_A, TRUE);
+    g_assert (mm_sms_list_index_lookup_multipart (index, a) == NULL);
+    g_assert (mm_sms_list_index_lookup_multipart (index, b) == OWNER_D);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 2) == OWNER_D);
+
+    mm_sms_list_index_clear (index);
+    g_assert_cmpuint (mm_sms_list_index_get_n_multiparts (index), ==, 0);
+    g_assert (mm_sms_list_index_lookup_part (index, MM_SMS_STORAGE_SM, 2) == NULL);
+
+    mm_sms_part_free (a);
+    mm_sms_part_free (b);
+    mm_sms_list_index_free (index);
+}
+
+/*****************************************************************************/
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+#if defined ENABLE_TEST_MESSAGE_TRACES
+    /* Dummy log function */
+    va_list args;
+    gchar *msg;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+#endif
+}
+
+int main (int argc, char **argv)
+{
+    g_test_init (&argc, &argv, NULL);
+
+    g_test_add_func ("/ModemManager/sms-list-index/duplicates", test_duplicates);
+    g_test_add_func ("/ModemManager/sms-list-index/mixed-references", test_mixed_references);
+    g_test_add_func ("/ModemManager/sms-list-index/out-of-order", test_out_of_order);
+    g_test_add_func ("/ModemManager/sms-list-index/expire", test_expire);
+    g_test_add_func ("/ModemManager/sms-list-index/remove-owner", test_remove_owner);
+
+    return g_test_run ();
+}
@@ -503,6 +503,107 @@ test_create_pdu_text_unicode_encoding (void)
                             expected, sizeof (expected));
 }
 
+/****************** ENCODE/DECODE TESTS ********************/
+
+static guint8 *
+create_text_pdu (const gchar *number,
+                 const gchar *text,
+                 guint *out_len)
+{
+    MMSmsPart *part;
+    guint8 *pdu;
+    GError *error = NULL;
+
+    part = mm_sms_part_new (0, MM_SMS_PDU_TYPE_CDMA_SUBMIT);
+    mm_sms_part_set_cdma_teleservice_id (part, MM_SMS_CDMA_TELESERVICE_ID_WMT);
+    mm_sms_part_set_number (part, number);
+    mm_sms_part_set_text (part, text);
+
+    pdu = mm_sms_part_cdma_get_submit_pdu (part, out_len, &error);
+    mm_sms_part_free (part);
+
+    g_assert_no_error (error);
+    g_assert (pdu != NULL);
+    return pdu;
+}
+
+static void
+test_encode_decode_all_lengths (void)
+{
+    static const gchar *texts[] = {
+        /* ASCII-7 */
+        "The quick brown fox jumps over the lazy dog; 0123456789 {}[]~",
+        /* Latin */
+        "Campeón, ¿qué tal? àáâãäåæçèéêë",
+        /* Unicode */
+        "中國哲學書電子化計劃"
+    };
+    guint t;
+
+    /* Every prefix of each text, so that fields end at every bit offset */
+    for (t = 0; t < G_N_ELEMENTS (texts); t++) {
+        const gchar *end;
+
+        for (end = g_utf8_next_char (texts[t]); ; end = g_utf8_next_char (end)) {
+            MMSmsPart *part;
+            gchar *text;
+            guint8 *pdu;
+            guint len = 0;
+            GError *error = NULL;
+
+            text = g_strndup (texts[t], end - texts[t]);
+            pdu = create_text_pdu ("3305773196", text, &len);
+            part = mm_sms_part_cdma_new_from_binary_pdu (0, pdu, len, &error);
+            g_assert_no_error (error);
+            g_assert (part != NULL);
+            g_assert_cmpstr (mm_sms_part_get_number (part), ==, "3305773196");
+            g_assert_cmpstr (mm_sms_part_get_text (part), ==, text);
+            mm_sms_part_free (part);
+            g_free (pdu);
+            g_free (text);
+
+            if (!*end)
+                break;
+        }
+    }
+}
+
+#define BENCHMARK_ITERATIONS 100000
+
+static void
+test_decode_benchmark (void)
+{
+    static const gchar *texts[] = {
+        "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog. "
+        "The quick brown fox jumps over the lazy dog. The quick brown fox jumps.",
+        "Campeón, ¿qué tal? àáâãäåæçèéêë. Campeón, ¿qué tal? àáâãäåæçèéêë. Campeón, ¿qué tal?",
+        "中國哲學書電子化計劃中國哲學書電子化計劃中國哲學書電子化計劃中國哲學書電子化計劃"
+    };
+    guint t;
+
+    if (!g_test_perf ())
+        return;
+
+    for (t = 0; t < G_N_ELEMENTS (texts); t++) {
+        guint8 *pdu;
+        guint len = 0;
+        gdouble elapsed;
+        guint i;
+
+        pdu = create_text_pdu ("3305773196", texts[t], &len);
+
+        g_test_timer_start ();
+        for (i = 0; i < BENCHMARK_ITERATIONS; i++)
+            mm_sms_part_free (mm_sms_part_cdma_new_from_binary_pdu (0, pdu, len, NULL));
+        elapsed = g_test_timer_elapsed ();
+
+        g_test_message ("decode %u-byte PDU: %.3fs for %u iterations (%.1f MB/s)",
+                        len, elapsed, BENCHMARK_ITERATIONS,
+                        ((gdouble) len * BENCHMARK_ITERATIONS) / (elapsed * 1024 * 1024));
+        g_free (pdu);
+    }
+}
+
 /************************************************************/
 
 void
@@ -544,5 +645,8 @@ int main (int argc, char **argv)
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/latin-encoding", test_create_pdu_text_latin_encoding);
     g_test_add_func ("/MM/SMS/CDMA/PDU-Creator/unicode-encoding", test_create_pdu_text_unicode_encoding);
 
+    g_test_add_func ("/MM/SMS/CDMA/Encode-Decode/all-lengths", test_encode_decode_all_lengths);
+    g_test_add_func ("/MM/SMS/CDMA/Encode-Decode/decode-benchmark", test_decode_benchmark);
+
     return g_test_run ();
 }
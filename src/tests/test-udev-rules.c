@@ -44,6 +44,38 @@ test_load_cleanup_core (void)
     g_array_unref (rules);
 }
 
+static void
+test_compiled_core (void)
+{
+    GArray *rules;
+    GError *error = NULL;
+    guint   i;
+
+    rules = mm_kernel_device_generic_rules_load (TESTUDEVRULESDIR, &error);
+    g_assert_no_error (error);
+    g_assert (rules);
+
+    /* All conditions in the core rules must be known when loaded */
+    for (i = 0; i < rules->len; i++) {
+        MMUdevRule *rule;
+        guint       j;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        for (j = 0; rule->conditions && j < rule->conditions->len; j++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, j);
+            g_assert_cmpuint (match->parameter_id, !=, MM_UDEV_RULE_MATCH_PARAMETER_UNKNOWN);
+            g_assert_cmpuint (match->parameter_id, !=, MM_UDEV_RULE_MATCH_PARAMETER_ATTR_UNKNOWN);
+            if (match->parameter_id == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID ||
+                match->parameter_id == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID)
+                g_assert (match->value_uint_valid);
+        }
+    }
+
+    g_array_unref (rules);
+}
+
 /************************************************************/
 
 void
@@ -74,6 +106,7 @@ int main (int argc, char **argv)
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/MM/test-udev-rules/load-cleanup-core", test_load_cleanup_core);
+    g_test_add_func ("/MM/test-udev-rules/compiled-core",     test_compiled_core);
 
     return g_test_run ();
 }
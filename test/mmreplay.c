@@ -0,0 +1,572 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details:
+ *
+ * Copyright (C) 2026 Manetos
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <locale.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include <mm-log.h>
+#include <mm-port-serial.h>
+#include <mm-port-serial-at.h>
+#include <mm-port-serial-qcdm.h>
+#include <mm-port-serial-gps.h>
+#include <mm-serial-parsers.h>
+#include <mm-serial-recorder.h>
+#include <mm-modem-helpers.h>
+
+#define PROGRAM_NAME    "mmreplay"
+#define PROGRAM_VERSION PACKAGE_VERSION
+
+/* Commands without reply in the capture shouldn't stall the replay */
+#define COMMAND_TIMEOUT_SECS 3
+
+/*
+ * The capture is replayed through a pseudo-terminal: the port under test
+ * opens the slave side, and the master side plays the device. The capture is
+ * split in steps, each one with an optional command sent by the port and the
+ * bytes received afterwards. The received bytes of a step are only written
+ * once the port has written the command, and the next step starts once the
+ * command is completed, so that replies aren't mixed with the wrong command.
+ */
+
+typedef struct {
+    GByteArray *command;
+    GByteArray *received;
+} Step;
+
+/* Globals */
+static MMPortSerial *port;
+static GMainLoop    *loop;
+static int           master_fd = -1;
+static int           slave_fd = -1;
+static GIOChannel   *master;
+static guint         master_in_id;
+static guint         master_out_id;
+static guint         done_check_id;
+static GArray       *steps;
+static guint         current_step;
+static gboolean      command_pending;
+static gboolean      command_written;
+static GByteArray   *outgoing;
+
+/* Results */
+static gint64  start_time;
+static gint64  end_time;
+static guint64 bytes_received;
+static guint64 bytes_sent;
+static guint   n_commands;
+static guint   n_command_errors;
+static guint   n_commands_unwritten;
+static guint   n_urcs;
+
+/* Context */
+static gchar    *type_str;
+static gchar    *capture_str;
+static gboolean  no_urc_handlers_flag;
+static gboolean  verbose_flag;
+static gboolean  version_flag;
+
+static GOptionEntry main_entries[] = {
+    { "type", 't', 0, G_OPTION_ARG_STRING, &type_str,
+      "Type of port to replay the capture through: 'at' (default), 'qcdm' or 'gps'",
+      "[TYPE]"
+    },
+    { "capture", 'c', 0, G_OPTION_ARG_FILENAME, &capture_str,
+      "Path to the serial capture file, as recorded with --serial-capture-dir",
+      "[PATH]"
+    },
+    { "no-urc-handlers", 0, 0, G_OPTION_ARG_NONE, &no_urc_handlers_flag,
+      "Don't register unsolicited message handlers, to get a baseline",
+      NULL
+    },
+    { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose_flag,
+      "Run action with verbose logs",
+      NULL
+    },
+    { "version", 'V', 0, G_OPTION_ARG_NONE, &version_flag,
+      "Print version",
+      NULL
+    },
+    { NULL }
+};
+
+void
+_mm_log (const char *loc,
+         const char *func,
+         guint32 level,
+         const char *fmt,
+         ...)
+{
+    va_list args;
+    gchar *msg;
+
+    if (!verbose_flag)
+        return;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+}
+
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+    va_list args;
+    gchar *msg;
+
+    if (!verbose_flag)
+        return;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+}
+
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+    return verbose_flag;
+}
+
+static void
+print_version_and_exit (void)
+{
+    g_print ("\n"
+             PROGRAM_NAME " " PROGRAM_VERSION "\n"
+             "Copyright (2026) Manetos\n"
+             "License GPLv2+: GNU GPL version 2 or later <http://gnu.org/licenses/gpl-2.0.html>\n"
+             "This is free software: you are free to change and redistribute it.\n"
+             "There is NO WARRANTY, to the extent permitted by law.\n"
+             "\n");
+    exit (EXIT_SUCCESS);
+}
+
+/*****************************************************************************/
+/* Capture loading */
+
+static void
+step_clear (Step *step)
+{
+    if (step->command)
+        g_byte_array_unref (step->command);
+    g_byte_array_unref (step->received);
+}
+
+static GArray *
+load_steps (const gchar  *path,
+            GError      **error)
+{
+    GPtrArray *records;
+    GArray    *array;
+    Step      *step = NULL;
+    guint      i;
+
+    records = mm_serial_recorder_load (path, error);
+    if (!records)
+        return NULL;
+
+    array = g_array_new (FALSE, FALSE, sizeof (Step));
+    g_array_set_clear_func (array, (GDestroyNotify) step_clear);
+
+    for (i = 0; i < records->len; i++) {
+        MMSerialRecord *record;
+
+        record = g_ptr_array_index (records, i);
+        if (!step || record->direction == MM_SERIAL_RECORD_DIRECTION_SENT) {
+            Step new_step = { NULL, g_byte_array_new () };
+
+            g_array_append_val (array, new_step);
+            step = &g_array_index (array, Step, array->len - 1);
+        }
+
+        if (record->direction == MM_SERIAL_RECORD_DIRECTION_SENT)
+            step->command = g_byte_array_ref (record->data);
+        else
+            g_byte_array_append (step->received, record->data->data, record->data->len);
+    }
+
+    g_ptr_array_unref (records);
+    return array;
+}
+
+/*****************************************************************************/
+/* Device side */
+
+static void run_step (void);
+
+static gboolean
+master_out_cb (GIOChannel   *channel,
+               GIOCondition  condition)
+{
+    gssize written;
+
+    written = write (master_fd, outgoing->data, outgoing->len);
+    if (written < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return G_SOURCE_CONTINUE;
+        g_printerr ("error: couldn't write to the pseudo-terminal: %s\n", g_strerror (errno));
+        g_main_loop_quit (loop);
+        master_out_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    bytes_received += written;
+    g_byte_array_remove_range (outgoing, 0, written);
+    if (outgoing->len > 0)
+        return G_SOURCE_CONTINUE;
+
+    master_out_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static void
+device_send (const GByteArray *data)
+{
+    if (!data->len)
+        return;
+
+    g_byte_array_append (outgoing, data->data, data->len);
+    if (!master_out_id)
+        master_out_id = g_io_add_watch (master, G_IO_OUT, (GIOFunc) master_out_cb, NULL);
+}
+
+static gboolean
+master_in_cb (GIOChannel   *channel,
+              GIOCondition  condition)
+{
+    guint8 buf[4096];
+    gssize n;
+
+    while ((n = read (master_fd, buf, sizeof (buf))) > 0)
+        bytes_sent += n;
+
+    /* Command written (or at least started), time for the replies */
+    if (command_pending && !command_written) {
+        command_written = TRUE;
+        device_send (g_array_index (steps, Step, current_step).received);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+/* Port side */
+
+static void
+command_ready (MMPortSerial *serial,
+               GAsyncResult *res)
+{
+    GByteArray *response;
+    GError     *error = NULL;
+
+    response = mm_port_serial_command_finish (serial, res, &error);
+    if (response)
+        g_byte_array_unref (response);
+    else {
+        if (verbose_flag)
+            g_printerr ("command error: %s\n", error->message);
+        n_command_errors++;
+        g_error_free (error);
+    }
+
+    /* Replied without writing (e.g. from the reply cache), the recorded
+     * replies are skipped */
+    if (!command_written)
+        n_commands_unwritten++;
+
+    command_pending = FALSE;
+    current_step++;
+    run_step ();
+}
+
+static gboolean
+done_check_cb (void)
+{
+    int pending = 0;
+
+    if (command_pending || current_step < steps->len || outgoing->len > 0)
+        return G_SOURCE_CONTINUE;
+
+    /* Wait until the port has read everything */
+    if (ioctl (slave_fd, FIONREAD, &pending) == 0 && pending > 0)
+        return G_SOURCE_CONTINUE;
+
+    end_time = g_get_monotonic_time ();
+    done_check_id = 0;
+    g_main_loop_quit (loop);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+run_step (void)
+{
+    /* Steps without command are just written right away */
+    while (current_step < steps->len) {
+        Step *step;
+
+        step = &g_array_index (steps, Step, current_step);
+        if (step->command) {
+            command_pending = TRUE;
+            command_written = FALSE;
+            n_commands++;
+            mm_port_serial_command (port,
+                                    step->command,
+                                    COMMAND_TIMEOUT_SECS,
+                                    FALSE,
+                                    NULL,
+                                    (GAsyncReadyCallback) command_ready,
+                                    NULL);
+            return;
+        }
+
+        device_send (step->received);
+        current_step++;
+    }
+}
+
+static void
+at_urc_cb (MMPortSerialAt *serial,
+           GMatchInfo     *match_info,
+           gpointer        user_data)
+{
+    n_urcs++;
+}
+
+static void
+gps_trace_cb (MMPortSerialGps *serial,
+              const gchar     *trace,
+              gpointer         user_data)
+{
+    n_urcs++;
+}
+
+static void
+gps_ubx_pvt_cb (MMPortSerialGps             *serial,
+                const MMPortSerialGpsUbxPvt *pvt,
+                gpointer                     user_data)
+{
+    n_urcs++;
+}
+
+static void
+setup_at_urc_handlers (MMPortSerialAt *serial)
+{
+    GRegex *regexes[5];
+    guint   i;
+
+    regexes[0] = mm_3gpp_creg_regex_get ();
+    regexes[1] = mm_3gpp_ciev_regex_get ();
+    regexes[2] = mm_3gpp_cusd_regex_get ();
+    regexes[3] = mm_3gpp_cmti_regex_get ();
+    regexes[4] = mm_3gpp_cds_regex_get ();
+    for (i = 0; i < G_N_ELEMENTS (regexes); i++) {
+        mm_port_serial_at_add_unsolicited_msg_handler (serial, regexes[i], at_urc_cb, NULL, NULL);
+        g_regex_unref (regexes[i]);
+    }
+}
+
+static MMPortSerial *
+create_port (const gchar *name)
+{
+    if (!type_str || g_str_equal (type_str, "at")) {
+        MMPortSerialAt *serial;
+
+        serial = mm_port_serial_at_new (name, MM_PORT_SUBSYS_TTY);
+        mm_port_serial_at_set_response_parser (serial,
+                                               mm_serial_parser_v1_parse,
+                                               mm_serial_parser_v1_new (),
+                                               mm_serial_parser_v1_destroy);
+        if (!no_urc_handlers_flag)
+            setup_at_urc_handlers (serial);
+        return MM_PORT_SERIAL (serial);
+    }
+
+    if (g_str_equal (type_str, "qcdm"))
+        return MM_PORT_SERIAL (mm_port_serial_qcdm_new (name));
+
+    if (g_str_equal (type_str, "gps")) {
+        MMPortSerialGps *serial;
+
+        serial = mm_port_serial_gps_new (name);
+        if (!no_urc_handlers_flag) {
+            mm_port_serial_gps_add_trace_handler (serial, gps_trace_cb, NULL, NULL);
+            mm_port_serial_gps_add_ubx_pvt_handler (serial, gps_ubx_pvt_cb, NULL, NULL);
+        }
+        return MM_PORT_SERIAL (serial);
+    }
+
+    g_printerr ("error: unknown port type '%s'\n", type_str);
+    exit (EXIT_FAILURE);
+}
+
+static gboolean
+start_cb (void)
+{
+    GError         *error = NULL;
+    struct termios  stbuf;
+    const gchar    *slave_name;
+
+    /* Device side of the pseudo-terminal */
+    master_fd = posix_openpt (O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master_fd < 0 || grantpt (master_fd) < 0 || unlockpt (master_fd) < 0) {
+        g_printerr ("error: cannot create pseudo-terminal: %s\n", g_strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+    slave_name = ptsname (master_fd);
+    g_assert (g_str_has_prefix (slave_name, "/dev/"));
+
+    /* Keep our own reference to the slave side, used to check whether there
+     * is still data pending to be read by the port */
+    slave_fd = open (slave_name, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (slave_fd < 0) {
+        g_printerr ("error: cannot open '%s': %s\n", slave_name, g_strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+
+    port = create_port (slave_name + strlen ("/dev/"));
+    if (!mm_port_serial_open (port, &error)) {
+        g_printerr ("error: cannot open serial port: %s\n", error->message);
+        exit (EXIT_FAILURE);
+    }
+
+    /* The port config leaves some input processing enabled (e.g. ISIG), which
+     * would eat binary data; replay it untouched */
+    if (tcgetattr (slave_fd, &stbuf) == 0) {
+        cfmakeraw (&stbuf);
+        tcsetattr (slave_fd, TCSANOW, &stbuf);
+    }
+
+    master = g_io_channel_unix_new (master_fd);
+    g_io_channel_set_encoding (master, NULL, NULL);
+    g_io_channel_set_buffered (master, FALSE);
+    master_in_id = g_io_add_watch (master, G_IO_IN, (GIOFunc) master_in_cb, NULL);
+
+    outgoing = g_byte_array_new ();
+    start_time = g_get_monotonic_time ();
+    run_step ();
+    done_check_id = g_timeout_add (1, (GSourceFunc) done_check_cb, NULL);
+    return G_SOURCE_REMOVE;
+}
+
+/*****************************************************************************/
+
+static void
+print_results (void)
+{
+    struct rusage usage;
+    gdouble       elapsed_s;
+
+    elapsed_s = (end_time - start_time) / 1e6;
+
+    g_print ("port type:          %s\n", type_str ? type_str : "at");
+    g_print ("elapsed:            %.3f s\n", elapsed_s);
+    g_print ("bytes received:     %" G_GUINT64_FORMAT " (%.0f bytes/s)\n",
+             bytes_received, elapsed_s > 0 ? bytes_received / elapsed_s : 0.0);
+    g_print ("bytes sent:         %" G_GUINT64_FORMAT "\n", bytes_sent);
+    g_print ("commands:           %u (%u errors, %u not written)\n",
+             n_commands, n_command_errors, n_commands_unwritten);
+    if (no_urc_handlers_flag)
+        g_print ("unsolicited:        no handlers\n");
+    else
+        g_print ("unsolicited:        %u (%.2f us each)\n",
+                 n_urcs, n_urcs ? (end_time - start_time) / (gdouble) n_urcs : 0.0);
+    if (getrusage (RUSAGE_SELF, &usage) == 0)
+        g_print ("peak memory:        %ld KiB\n", usage.ru_maxrss);
+}
+
+int main (int argc, char **argv)
+{
+    GOptionContext *context;
+    GError         *error = NULL;
+
+    setlocale (LC_ALL, "");
+
+    g_type_init ();
+
+    /* Setup option context, process it and destroy it */
+    context = g_option_context_new ("- ModemManager serial capture replay");
+    g_option_context_add_main_entries (context, main_entries, NULL);
+    g_option_context_parse (context, &argc, &argv, NULL);
+    g_option_context_free (context);
+
+    if (version_flag)
+        print_version_and_exit ();
+
+    /* No capture given? */
+    if (!capture_str) {
+        g_printerr ("error: no capture file specified\n");
+        exit (EXIT_FAILURE);
+    }
+
+    steps = load_steps (capture_str, &error);
+    if (!steps) {
+        g_printerr ("error: cannot load capture: %s\n", error->message);
+        g_error_free (error);
+        exit (EXIT_FAILURE);
+    }
+
+    /* Setup main loop and shedule start in idle */
+    loop = g_main_loop_new (NULL, FALSE);
+    g_idle_add ((GSourceFunc)start_cb, NULL);
+    g_main_loop_run (loop);
+
+    print_results ();
+
+    /* Cleanup */
+    g_main_loop_unref (loop);
+    if (done_check_id)
+        g_source_remove (done_check_id);
+    if (master_out_id)
+        g_source_remove (master_out_id);
+    if (master_in_id)
+        g_source_remove (master_in_id);
+    if (port) {
+        if (mm_port_serial_is_open (port))
+            mm_port_serial_close (port);
+        g_object_unref (port);
+    }
+    if (master)
+        g_io_channel_unref (master);
+    if (slave_fd >= 0)
+        close (slave_fd);
+    if (master_fd >= 0)
+        close (master_fd);
+    if (outgoing)
+        g_byte_array_unref (outgoing);
+    g_array_unref (steps);
+    return 0;
+}
@@ -24,6 +24,7 @@
 #include <gio/gio.h>
 
 #include <mm-log.h>
+#include <mm-kernel-device-generic.h>
 #include <mm-kernel-device-generic-rules.h>
 
 #define PROGRAM_NAME    "mmrules"
@@ -31,6 +32,10 @@
 
 /* Context */
 static gchar    *path;
+static gchar    *events_str;
+static gint      synthetic_n;
+static gint      iterations = 1;
+static gboolean  trace_flag;
 static gboolean  verbose_flag;
 static gboolean  version_flag;
 
@@ -39,6 +44,22 @@ static GOptionEntry main_entries[] = {
       "Specify path to udev rules directory",
       "[PATH]"
     },
+    { "events", 'e', 0, G_OPTION_ARG_FILENAME, &events_str,
+      "Evaluate the rules for the kernel events listed in the given file",
+      "[PATH]"
+    },
+    { "synthetic", 's', 0, G_OPTION_ARG_INT, &synthetic_n,
+      "Evaluate the rules for N synthetic devices, built from the vendor and product ids in the rules",
+      "[N]"
+    },
+    { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+      "Times each event is evaluated, for timing (default=1)",
+      "[N]"
+    },
+    { "trace", 't', 0, G_OPTION_ARG_NONE, &trace_flag,
+      "Print the rules applied to each event",
+      NULL
+    },
     { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose_flag,
       "Run action with verbose logs",
       NULL
@@ -127,6 +148,337 @@ print_rule (MMUdevRule *rule)
     }
 }
 
+/*****************************************************************************/
+/* Kernel events
+ *
+ * One event per line, as key=value pairs (values may be quoted), e.g.:
+ *   subsystem=tty name=ttyUSB2 driver=option vid=1199 pid=68a2
+ *   sysfs=/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.3/ttyUSB2/tty/ttyUSB2
+ *   interface=/sys/devices/pci0000:00/0000:00:14.0/usb1/1-2/1-2:1.3
+ *   class=ff subclass=ff protocol=ff number=03 manufacturer="Sierra Wireless, Incorporated" product=MC7710
+ * (all in the same line); 'sysfs' and 'interface' default to a made up USB
+ * device path.
+ */
+
+typedef struct {
+    gchar                         *subsystem;
+    gchar                         *name;
+    gchar                         *sysfs_path;
+    gchar                         *interface_sysfs_path;
+    gchar                         *driver;
+    gchar                         *manufacturer;
+    gchar                         *product;
+    MMKernelDeviceGenericContents  contents;
+} Event;
+
+static void
+event_free (Event *event)
+{
+    g_free (event->subsystem);
+    g_free (event->name);
+    g_free (event->sysfs_path);
+    g_free (event->interface_sysfs_path);
+    g_free (event->driver);
+    g_free (event->manufacturer);
+    g_free (event->product);
+    g_slice_free (Event, event);
+}
+
+static guint
+parse_hex (const gchar *str)
+{
+    return (guint) g_ascii_strtoull (str, NULL, 16);
+}
+
+/* Fills in the defaults and the contents, once all values are known */
+static void
+event_complete (Event *event,
+                guint  index)
+{
+    if (!event->interface_sysfs_path)
+        event->interface_sysfs_path = g_strdup_printf ("/sys/devices/mmrules/usb1/1-%u/1-%u:1.%u",
+                                                       index + 1, index + 1, event->contents.interface_number);
+    if (!event->sysfs_path)
+        event->sysfs_path = g_strdup_printf ("%s/%s/%s/%s",
+                                             event->interface_sysfs_path, event->name, event->subsystem, event->name);
+
+    event->contents.sysfs_path           = event->sysfs_path;
+    event->contents.interface_sysfs_path = event->interface_sysfs_path;
+    event->contents.driver               = event->driver;
+    event->contents.manufacturer         = event->manufacturer;
+    event->contents.product              = event->product;
+}
+
+static Event *
+event_parse (const gchar *line,
+             guint        index)
+{
+    GError  *error = NULL;
+    Event   *event;
+    gchar  **argv = NULL;
+    guint    i;
+
+    if (!g_shell_parse_argv (line, NULL, &argv, &error)) {
+        g_printerr ("error: invalid event '%s': %s\n", line, error->message);
+        g_error_free (error);
+        return NULL;
+    }
+
+    event = g_slice_new0 (Event);
+    for (i = 0; argv[i]; i++) {
+        gchar *value;
+
+        value = strchr (argv[i], '=');
+        if (!value) {
+            g_printerr ("warning: ignoring '%s' in event: not key=value\n", argv[i]);
+            continue;
+        }
+        *value++ = '\0';
+
+        if (g_str_equal (argv[i], "subsystem"))
+            event->subsystem = g_strdup (value);
+        else if (g_str_equal (argv[i], "name"))
+            event->name = g_strdup (value);
+        else if (g_str_equal (argv[i], "sysfs"))
+            event->sysfs_path = g_strdup (value);
+        else if (g_str_equal (argv[i], "interface"))
+            event->interface_sysfs_path = g_strdup (value);
+        else if (g_str_equal (argv[i], "driver"))
+            event->driver = g_strdup (value);
+        else if (g_str_equal (argv[i], "manufacturer"))
+            event->manufacturer = g_strdup (value);
+        else if (g_str_equal (argv[i], "product"))
+            event->product = g_strdup (value);
+        else if (g_str_equal (argv[i], "vid"))
+            event->contents.vid = parse_hex (value);
+        else if (g_str_equal (argv[i], "pid"))
+            event->contents.pid = parse_hex (value);
+        else if (g_str_equal (argv[i], "class"))
+            event->contents.interface_class = parse_hex (value);
+        else if (g_str_equal (argv[i], "subclass"))
+            event->contents.interface_subclass = parse_hex (value);
+        else if (g_str_equal (argv[i], "protocol"))
+            event->contents.interface_protocol = parse_hex (value);
+        else if (g_str_equal (argv[i], "number"))
+            event->contents.interface_number = parse_hex (value);
+        else
+            g_printerr ("warning: ignoring unknown key '%s' in event\n", argv[i]);
+    }
+    g_strfreev (argv);
+
+    if (!event->subsystem || !event->name) {
+        g_printerr ("error: event '%s' without subsystem or name\n", line);
+        event_free (event);
+        return NULL;
+    }
+
+    event_complete (event, index);
+    return event;
+}
+
+static GPtrArray *
+events_load (const gchar *events_path)
+{
+    GError     *error = NULL;
+    GPtrArray  *events;
+    gchar      *contents;
+    gchar     **lines;
+    guint       i;
+
+    if (!g_file_get_contents (events_path, &contents, NULL, &error)) {
+        g_printerr ("error: couldn't read events: %s\n", error->message);
+        g_error_free (error);
+        return NULL;
+    }
+
+    events = g_ptr_array_new_with_free_func ((GDestroyNotify) event_free);
+    lines = g_strsplit (contents, "\n", -1);
+    for (i = 0; lines[i]; i++) {
+        Event *event;
+
+        g_strstrip (lines[i]);
+        if (!lines[i][0] || lines[i][0] == '#')
+            continue;
+        event = event_parse (lines[i], events->len);
+        if (!event) {
+            g_ptr_array_unref (events);
+            events = NULL;
+            break;
+        }
+        g_ptr_array_add (events, event);
+    }
+    g_strfreev (lines);
+    g_free (contents);
+    return events;
+}
+
+/* Devices with the vendor and product ids matched by the rules, cycling over
+ * the usual port kinds, so that most vendor sections are walked */
+static GPtrArray *
+events_synthesize (GArray *rules,
+                   guint   n_events)
+{
+    static const struct {
+        const gchar *subsystem;
+        const gchar *name;
+        const gchar *driver;
+        guint8       interface_class;
+    } kinds[] = {
+        { "tty",     "ttyUSB", "option",      0xff },
+        { "tty",     "ttyACM", "cdc_acm",     0x02 },
+        { "usbmisc", "cdc-wdm", "qmi_wwan",   0xff },
+        { "net",     "wwan",   "qmi_wwan",    0xff },
+    };
+    GPtrArray *events;
+    GArray    *ids;
+    guint      i;
+
+    /* Pairs of vendor and product ids in the rules, with 0 for any product */
+    ids = g_array_new (FALSE, FALSE, sizeof (guint32));
+    for (i = 0; i < rules->len; i++) {
+        MMUdevRule *rule;
+        guint       vid = 0;
+        guint       pid = 0;
+        guint       j;
+        guint32     id;
+
+        rule = &g_array_index (rules, MMUdevRule, i);
+        if (!rule->conditions)
+            continue;
+        for (j = 0; j < rule->conditions->len; j++) {
+            MMUdevRuleMatch *match;
+
+            match = &g_array_index (rule->conditions, MMUdevRuleMatch, j);
+            if (match->type != MM_UDEV_RULE_MATCH_TYPE_EQUAL || !match->value_uint_valid)
+                continue;
+            if (match->parameter_id == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_VENDOR_ID)
+                vid = match->value_uint;
+            else if (match->parameter_id == MM_UDEV_RULE_MATCH_PARAMETER_ATTR_PRODUCT_ID)
+                pid = match->value_uint;
+        }
+        if (!vid)
+            continue;
+        id = (vid << 16) | pid;
+        g_array_append_val (ids, id);
+    }
+
+    if (!ids->len) {
+        guint32 id = 0;
+
+        g_array_append_val (ids, id);
+    }
+
+    events = g_ptr_array_new_with_free_func ((GDestroyNotify) event_free);
+    for (i = 0; i < n_events; i++) {
+        Event   *event;
+        guint32  id;
+        guint    kind;
+
+        id = g_array_index (ids, guint32, i % ids->len);
+        kind = (i / ids->len) % G_N_ELEMENTS (kinds);
+
+        event = g_slice_new0 (Event);
+        event->subsystem = g_strdup (kinds[kind].subsystem);
+        event->name = g_strdup_printf ("%s%u", kinds[kind].name, i);
+        event->driver = g_strdup (kinds[kind].driver);
+        event->contents.vid = id >> 16;
+        event->contents.pid = id & 0xffff;
+        event->contents.interface_class = kinds[kind].interface_class;
+        event->contents.interface_number = i % 8;
+        event_complete (event, i);
+        g_ptr_array_add (events, event);
+    }
+
+    g_array_unref (ids);
+    return events;
+}
+
+/*****************************************************************************/
+/* Rule evaluation */
+
+static gboolean
+evaluate_events (GArray    *rules,
+                 GPtrArray *events)
+{
+    gdouble total_elapsed = 0.0;
+    guint64 total_conditions = 0;
+    guint   i;
+
+    mm_kernel_device_generic_set_rule_tracing (trace_flag);
+
+    g_print ("%-10s %-12s %9s %7s %10s %10s\n",
+             "subsystem", "name", "vid:pid", "rules", "conditions", "time (us)");
+
+    for (i = 0; i < events->len; i++) {
+        Event                   *event;
+        MMKernelEventProperties *properties;
+        MMKernelDevice          *device = NULL;
+        GError                  *error = NULL;
+        GTimer                  *timer;
+        gdouble                  elapsed;
+        guint                    n_rules = 0;
+        guint                    n_conditions = 0;
+        gint                     j;
+
+        event = g_ptr_array_index (events, i);
+        properties = mm_kernel_event_properties_new ();
+        mm_kernel_event_properties_set_action (properties, "add");
+        mm_kernel_event_properties_set_subsystem (properties, event->subsystem);
+        mm_kernel_event_properties_set_name (properties, event->name);
+
+        /* Every evaluation creates the device anew, as the daemon does */
+        timer = g_timer_new ();
+        for (j = 0; j < MAX (iterations, 1); j++) {
+            g_clear_object (&device);
+            device = mm_kernel_device_generic_new_with_contents (properties, rules, &event->contents, &error);
+            if (!device)
+                break;
+        }
+        elapsed = g_timer_elapsed (timer, NULL) / MAX (iterations, 1);
+        g_timer_destroy (timer);
+        g_object_unref (properties);
+
+        if (!device) {
+            g_printerr ("error: couldn't create device %s/%s: %s\n",
+                        event->subsystem, event->name, error->message);
+            g_error_free (error);
+            return FALSE;
+        }
+
+        mm_kernel_device_generic_get_rule_stats (MM_KERNEL_DEVICE_GENERIC (device), &n_rules, &n_conditions);
+        g_print ("%-10s %-12s %04x:%04x %7u %10u %10.1f\n",
+                 event->subsystem, event->name,
+                 event->contents.vid, event->contents.pid,
+                 n_rules, n_conditions, elapsed * 1e6);
+        total_elapsed += elapsed;
+        total_conditions += n_conditions;
+
+        if (trace_flag) {
+            const GArray *applied;
+            guint         k;
+
+            applied = mm_kernel_device_generic_peek_applied_rules (MM_KERNEL_DEVICE_GENERIC (device));
+            for (k = 0; applied && k < applied->len; k++) {
+                guint rule_i;
+
+                rule_i = g_array_index (applied, guint, k);
+                g_print ("  applied rule [%u]:\n", rule_i);
+                print_rule (&g_array_index (rules, MMUdevRule, rule_i));
+            }
+            g_print ("  candidate: %s\n", mm_kernel_device_is_candidate (device, FALSE) ? "yes" : "no");
+        }
+
+        g_object_unref (device);
+    }
+
+    g_print ("\n%u events evaluated: %.1f us per event, %.1f conditions per event, %.0f events/s\n",
+             events->len,
+             total_elapsed * 1e6 / MAX (events->len, 1),
+             (gdouble) total_conditions / MAX (events->len, 1),
+             total_elapsed > 0 ? events->len / total_elapsed : 0.0);
+    return TRUE;
+}
+
 int main (int argc, char **argv)
 {
     GOptionContext *context;
@@ -160,6 +512,24 @@ int main (int argc, char **argv)
         exit (EXIT_FAILURE);
     }
 
+    /* Evaluate events, if any */
+    if (events_str || synthetic_n > 0) {
+        GPtrArray *events;
+        gboolean   success;
+
+        events = (events_str ?
+                  events_load (events_str) :
+                  events_synthesize (rules, (guint) synthetic_n));
+        if (!events) {
+            g_array_unref (rules);
+            exit (EXIT_FAILURE);
+        }
+        success = evaluate_events (rules, events);
+        g_ptr_array_unref (events);
+        g_array_unref (rules);
+        return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     /* Print loaded rules */
     for (i = 0; i < rules->len; i++) {
         g_print ("-----------------------------------------\n");
@@ -19,10 +19,17 @@
 #include <stdlib.h>
 #include <locale.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
 
 #include <glib.h>
 #include <gio/gio.h>
 
+#include <ModemManager.h>
+#include <mm-errors-types.h>
+
 #include <mm-log.h>
 #include <mm-port-serial.h>
 #include <mm-port-serial-at.h>
@@ -44,6 +51,12 @@ static gboolean  no_echo_removal_flag;
 static gint64    send_delay = -1;
 static gboolean  verbose_flag;
 static gboolean  version_flag;
+static gchar   **bench_command_strv;
+static gchar    *bench_file_str;
+static gint      bench_iterations = 100;
+static gint      bench_pipeline = 1;
+static gint      bench_timeout = 3;
+static gint      read_seconds;
 
 static GOptionEntry main_entries[] = {
     { "device", 'd', 0, G_OPTION_ARG_STRING, &device_str,
@@ -73,6 +86,34 @@ static GOptionEntry main_entries[] = {
     { NULL }
 };
 
+static GOptionEntry bench_entries[] = {
+    { "bench-command", 0, 0, G_OPTION_ARG_STRING_ARRAY, &bench_command_strv,
+      "Benchmark the given command; may be given multiple times",
+      "[COMMAND]"
+    },
+    { "bench-file", 0, 0, G_OPTION_ARG_FILENAME, &bench_file_str,
+      "Benchmark the commands listed in the given file, one per line",
+      "[PATH]"
+    },
+    { "bench-iterations", 0, 0, G_OPTION_ARG_INT, &bench_iterations,
+      "Times the whole command list is sent (default=100)",
+      "[N]"
+    },
+    { "bench-pipeline", 0, 0, G_OPTION_ARG_INT, &bench_pipeline,
+      "Commands queued in the port at the same time (default=1)",
+      "[N]"
+    },
+    { "bench-timeout", 0, 0, G_OPTION_ARG_INT, &bench_timeout,
+      "Timeout of each command in seconds (default=3)",
+      "[SECS]"
+    },
+    { "read-throughput", 0, 0, G_OPTION_ARG_INT, &read_seconds,
+      "Don't send anything, just measure how fast the port is read for the given seconds (e.g. GPS or diagnostics ports)",
+      "[SECS]"
+    },
+    { NULL }
+};
+
 static void
 signals_handler (int signum)
 {
@@ -103,6 +144,34 @@ _mm_log (const char *loc,
     g_free (msg);
 }
 
+void
+_mm_log_unchecked (const char *loc,
+                   const char *func,
+                   guint32 level,
+                   const char *fmt,
+                   ...)
+{
+    va_list args;
+    gchar *msg;
+
+    if (!verbose_flag)
+        return;
+
+    va_start (args, fmt);
+    msg = g_strdup_vprintf (fmt, args);
+    va_end (args);
+    g_print ("%s\n", msg);
+    g_free (msg);
+}
+
+guint32 mm_log_category_levels[MM_LOG_CATEGORY_LAST];
+
+gboolean
+mm_log_port_debug_enabled (const char *device)
+{
+    return verbose_flag;
+}
+
 static void
 print_version_and_exit (void)
 {
@@ -170,6 +239,310 @@ input_callback (GIOChannel   *channel,
     return FALSE;
 }
 
+/*****************************************************************************/
+/* Command benchmark */
+
+typedef struct {
+    gchar  *command;
+    /* Microseconds from queueing the command until its reply */
+    GArray *latencies;
+    guint   n_timeouts;
+    guint   n_errors;
+} BenchCommand;
+
+typedef struct {
+    BenchCommand *command;
+    gint64        start;
+} BenchRequest;
+
+static GPtrArray *bench_commands;
+static guint      bench_total;
+static guint      bench_sent;
+static guint      bench_completed;
+static gint64     bench_start_time;
+
+static void bench_send (void);
+
+static void
+bench_command_free (BenchCommand *command)
+{
+    g_free (command->command);
+    g_array_unref (command->latencies);
+    g_slice_free (BenchCommand, command);
+}
+
+static void
+bench_add_command (const gchar *command)
+{
+    BenchCommand *bench_command;
+
+    bench_command = g_slice_new0 (BenchCommand);
+    bench_command->command = g_strdup (command);
+    bench_command->latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+    g_ptr_array_add (bench_commands, bench_command);
+}
+
+static gboolean
+bench_load (void)
+{
+    GError *error = NULL;
+    guint   i;
+
+    bench_commands = g_ptr_array_new_with_free_func ((GDestroyNotify) bench_command_free);
+
+    for (i = 0; bench_command_strv && bench_command_strv[i]; i++)
+        bench_add_command (bench_command_strv[i]);
+
+    if (bench_file_str) {
+        gchar  *contents;
+        gchar **lines;
+
+        if (!g_file_get_contents (bench_file_str, &contents, NULL, &error)) {
+            g_printerr ("error: cannot read benchmark file: %s\n", error->message);
+            g_error_free (error);
+            return FALSE;
+        }
+        lines = g_strsplit (contents, "\n", -1);
+        for (i = 0; lines[i]; i++) {
+            g_strstrip (lines[i]);
+            if (lines[i][0] && lines[i][0] != '#')
+                bench_add_command (lines[i]);
+        }
+        g_strfreev (lines);
+        g_free (contents);
+    }
+
+    if (!bench_commands->len) {
+        g_printerr ("error: no commands to benchmark\n");
+        return FALSE;
+    }
+
+    bench_total = bench_commands->len * (guint) MAX (bench_iterations, 1);
+    return TRUE;
+}
+
+static gint
+compare_latency (const gint64 *a,
+                 const gint64 *b)
+{
+    return (*a < *b ? -1 : (*a > *b ? 1 : 0));
+}
+
+static gdouble
+percentile_ms (GArray *sorted,
+               guint   percentile)
+{
+    if (!sorted->len)
+        return 0.0;
+    return (gdouble) g_array_index (sorted, gint64, ((sorted->len - 1) * percentile) / 100) / 1000.0;
+}
+
+static void
+bench_report (void)
+{
+    gdouble elapsed;
+    guint   n_timeouts = 0;
+    guint   n_errors = 0;
+    guint   i;
+
+    elapsed = (gdouble) (g_get_monotonic_time () - bench_start_time) / G_USEC_PER_SEC;
+
+    g_print ("\n%-24s %7s %9s %9s %9s %9s %8s %6s\n",
+             "command", "replies", "p50 (ms)", "p90 (ms)", "p99 (ms)", "max (ms)", "timeouts", "errors");
+    for (i = 0; i < bench_commands->len; i++) {
+        BenchCommand *command;
+
+        command = g_ptr_array_index (bench_commands, i);
+        g_array_sort (command->latencies, (GCompareFunc) compare_latency);
+        g_print ("%-24s %7u %9.1f %9.1f %9.1f %9.1f %8u %6u\n",
+                 command->command,
+                 command->latencies->len,
+                 percentile_ms (command->latencies, 50),
+                 percentile_ms (command->latencies, 90),
+                 percentile_ms (command->latencies, 99),
+                 percentile_ms (command->latencies, 100),
+                 command->n_timeouts,
+                 command->n_errors);
+        n_timeouts += command->n_timeouts;
+        n_errors += command->n_errors;
+    }
+
+    g_print ("\n%u commands in %.2f s (%.1f commands/s) with pipeline depth %d: %u timeouts, %u errors\n",
+             bench_total, elapsed, elapsed > 0 ? bench_total / elapsed : 0.0,
+             MAX (bench_pipeline, 1), n_timeouts, n_errors);
+}
+
+static void
+bench_command_ready (MMPortSerialAt *serial_at,
+                     GAsyncResult   *res,
+                     BenchRequest   *request)
+{
+    GError *error = NULL;
+    gint64  latency;
+
+    mm_port_serial_at_command_finish (serial_at, res, &error);
+    latency = g_get_monotonic_time () - request->start;
+    if (!error)
+        g_array_append_val (request->command->latencies, latency);
+    else if (g_error_matches (error, MM_SERIAL_ERROR, MM_SERIAL_ERROR_RESPONSE_TIMEOUT))
+        request->command->n_timeouts++;
+    else {
+        /* Error replies from the modem are replies too */
+        if (error->domain != MM_SERIAL_ERROR)
+            g_array_append_val (request->command->latencies, latency);
+        request->command->n_errors++;
+    }
+    if (error) {
+        if (verbose_flag)
+            g_printerr ("%s: %s\n", request->command->command, error->message);
+        g_error_free (error);
+    }
+    g_slice_free (BenchRequest, request);
+
+    bench_completed++;
+    if (bench_completed % 100 == 0)
+        g_print ("%u/%u commands completed\n", bench_completed, bench_total);
+
+    if (bench_completed == bench_total) {
+        bench_report ();
+        g_main_loop_quit (loop);
+        return;
+    }
+
+    bench_send ();
+}
+
+static void
+bench_send (void)
+{
+    while (bench_sent < bench_total && bench_sent - bench_completed < (guint) MAX (bench_pipeline, 1)) {
+        BenchRequest *request;
+
+        request = g_slice_new0 (BenchRequest);
+        request->command = g_ptr_array_index (bench_commands, bench_sent % bench_commands->len);
+        request->start = g_get_monotonic_time ();
+        bench_sent++;
+
+        mm_port_serial_at_command (port,
+                                   request->command->command,
+                                   MAX (bench_timeout, 1),
+                                   FALSE, /* is_raw */
+                                   FALSE, /* allow_cached */
+                                   NULL,
+                                   (GAsyncReadyCallback) bench_command_ready,
+                                   request);
+    }
+}
+
+static void
+bench_start (void)
+{
+    g_print ("sending %u commands, %d at a time...\n", bench_total, MAX (bench_pipeline, 1));
+    bench_start_time = g_get_monotonic_time ();
+    bench_send ();
+}
+
+/*****************************************************************************/
+/* Read throughput */
+
+static GIOChannel *read_channel;
+static guint64     read_bytes;
+static guint       read_calls;
+static gint64      read_start_time;
+static gint64      read_first_time;
+static gint64      read_last_time;
+static gint64      read_max_gap;
+
+static gboolean
+read_callback (GIOChannel   *channel,
+               GIOCondition  condition)
+{
+    guint8 buf[4096];
+    gssize n;
+    gint64 now;
+
+    if (condition & (G_IO_ERR | G_IO_HUP)) {
+        g_printerr ("error: port closed\n");
+        g_main_loop_quit (loop);
+        return FALSE;
+    }
+
+    n = read (g_io_channel_unix_get_fd (channel), buf, sizeof (buf));
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EINTR)
+            return TRUE;
+        g_printerr ("error: cannot read: %s\n", g_strerror (errno));
+        g_main_loop_quit (loop);
+        return FALSE;
+    }
+
+    now = g_get_monotonic_time ();
+    if (!read_first_time)
+        read_first_time = now;
+    else
+        read_max_gap = MAX (read_max_gap, now - read_last_time);
+    read_last_time = now;
+    read_bytes += n;
+    read_calls++;
+    return TRUE;
+}
+
+static gboolean
+read_done_cb (void)
+{
+    gdouble elapsed;
+
+    elapsed = (gdouble) (g_get_monotonic_time () - read_start_time) / G_USEC_PER_SEC;
+    g_print ("\n%" G_GUINT64_FORMAT " bytes in %u reads over %.2f s: %.1f bytes/s, %.1f bytes/read\n",
+             read_bytes, read_calls, elapsed,
+             read_bytes / elapsed,
+             read_calls ? (gdouble) read_bytes / read_calls : 0.0);
+    if (read_first_time)
+        g_print ("first data after %.1f ms, largest gap between reads %.1f ms\n",
+                 (gdouble) (read_first_time - read_start_time) / 1000.0,
+                 (gdouble) read_max_gap / 1000.0);
+
+    g_main_loop_quit (loop);
+    return G_SOURCE_REMOVE;
+}
+
+/* Reads the tty directly, without any of the port parsing in between */
+static void
+read_start (void)
+{
+    struct termios  options;
+    gchar          *path;
+    int             fd;
+
+    path = (g_str_has_prefix (device_str, "/dev/") ?
+            g_strdup (device_str) :
+            g_strdup_printf ("/dev/%s", device_str));
+
+    g_print ("opening '%s' for reading...\n", path);
+    fd = open (path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        g_printerr ("error: cannot open '%s': %s\n", path, g_strerror (errno));
+        exit (EXIT_FAILURE);
+    }
+    g_free (path);
+
+    if (tcgetattr (fd, &options) == 0) {
+        cfmakeraw (&options);
+        options.c_cc[VMIN] = 1;
+        options.c_cc[VTIME] = 0;
+        tcsetattr (fd, TCSANOW, &options);
+    }
+
+    g_print ("reading for %d seconds...\n", read_seconds);
+    read_channel = g_io_channel_unix_new (fd);
+    g_io_channel_set_close_on_unref (read_channel, TRUE);
+    g_io_add_watch (read_channel, G_IO_IN | G_IO_ERR | G_IO_HUP, (GIOFunc) read_callback, NULL);
+    read_start_time = g_get_monotonic_time ();
+    g_timeout_add_seconds (read_seconds, (GSourceFunc) read_done_cb, NULL);
+}
+
+/*****************************************************************************/
+
 static void
 flash_ready (MMPortSerial *serial,
              GAsyncResult *res)
@@ -182,6 +555,12 @@ flash_ready (MMPortSerial *serial,
     }
 
     g_print ("ready\n");
+
+    if (bench_commands) {
+        bench_start ();
+        return;
+    }
+
     g_print ("> ");
 
     /* Setup input reading */
@@ -201,6 +580,11 @@ start_cb (void)
     GError *error = NULL;
     const gchar *device_name;
 
+    if (read_seconds > 0) {
+        read_start ();
+        return G_SOURCE_REMOVE;
+    }
+
     device_name = device_str;
     if (g_str_has_prefix (device_name, "/dev/"))
         device_name += strlen ("/dev/");
@@ -256,6 +640,7 @@ start_cb (void)
 int main (int argc, char **argv)
 {
     GOptionContext *context;
+    GOptionGroup   *group;
 
     setlocale (LC_ALL, "");
 
@@ -264,6 +649,13 @@ int main (int argc, char **argv)
     /* Setup option context, process it and destroy it */
     context = g_option_context_new ("- ModemManager TTY testing");
     g_option_context_add_main_entries (context, main_entries, NULL);
+    group = g_option_group_new ("bench",
+                                "Benchmark options",
+                                "Show benchmark options",
+                                NULL,
+                                NULL);
+    g_option_group_add_entries (group, bench_entries);
+    g_option_context_add_group (context, group);
     g_option_context_parse (context, &argc, &argv, NULL);
     g_option_context_free (context);
 
@@ -276,6 +668,10 @@ int main (int argc, char **argv)
         exit (EXIT_FAILURE);
     }
 
+    /* Benchmark requested? */
+    if ((bench_command_strv || bench_file_str) && !bench_load ())
+        exit (EXIT_FAILURE);
+
     /* Setup signals */
     signal (SIGINT, signals_handler);
     signal (SIGHUP, signals_handler);
@@ -295,5 +691,9 @@ int main (int argc, char **argv)
     }
     if (input)
         g_io_channel_unref (input);
+    if (read_channel)
+        g_io_channel_unref (read_channel);
+    if (bench_commands)
+        g_ptr_array_unref (bench_commands);
     return 0;
 }